@@ -25,7 +25,6 @@
 #include "Profiler.h"
 
 #if defined(USE_CHRONO)
-#undef __PROFILER_SMP__
 #include <atomic>
 #endif
 
@@ -1002,6 +1001,35 @@ namespace Profiler {
 	GlobalThreadList threads = { NULL, {0} };
 	threadlocal Caller *root = NULL;
 
+#ifdef __PROFILER_WITH_ZONES__
+	// lanes added with addlane(), guarded by the threads lock
+	std::vector<ThreadZones> extraLanes;
+
+	// turns a lane back into enter/exit zones, with the lane name in place
+	// of the thread root
+	Buffer<Zone> *packLane( const ThreadZones &lane, f64 msPerTick ) {
+		Buffer<Zone> *zones = new Buffer<Zone>( u32( lane.zones.size() * 2 + 1 ) );
+		zones->Push( Zone( ZoneType::ZoneEnter, (void *)lane.name, 0 ) );
+
+		Buffer<const ZoneSpan *> stack;
+		for ( size_t i = 0; i < lane.zones.size(); i++ ) {
+			const ZoneSpan &span = lane.zones[i];
+			while ( stack.Size() > span.depth ) {
+				const ZoneSpan *done = stack.Pop();
+				zones->Push( Zone( ZoneType::ZoneExit, (void *)done->name, u64( done->endMs / msPerTick ) ) );
+			}
+			zones->Push( Zone( ZoneType::ZoneEnter, (void *)span.name, u64( span.startMs / msPerTick ) ) );
+			stack.Push( &span );
+		}
+
+		while ( stack.Size() ) {
+			const ZoneSpan *done = stack.Pop();
+			zones->Push( Zone( ZoneType::ZoneExit, (void *)done->name, u64( done->endMs / msPerTick ) ) );
+		}
+		return zones;
+	}
+#endif
+
 
 	/*
 		Thread Dumping
@@ -1409,9 +1437,12 @@ namespace Profiler {
 #endif
 
 #ifdef __PROFILER_WITH_ZONES__
-			Buffer<Zone> *threadZones = new Buffer<Zone>( thread.threadState->threadZones->Size() );
-			threadZones->Append( *thread.threadState->threadZones );
-			packedZones.Push( threadZones );
+			// the state of a thread that has exited is gone with it
+			if ( active ) {
+				Buffer<Zone> *threadZones = new Buffer<Zone>( thread.threadState->threadZones->Size() );
+				threadZones->Append( *thread.threadState->threadZones );
+				packedZones.Push( threadZones );
+			}
 #endif
 
 			if ( active ) {
@@ -1420,12 +1451,20 @@ namespace Profiler {
 			}
 		}
 
-		// working on local data now, don't need the threads lock any more
-		threads.ReleaseGlobalLock();
-
 		u64 rawDuration = ( Timer::getticks() - globalStart );
 		u64 clockDuration = ( Clock::getticks() - globalClockStart );
 
+#ifdef __PROFILER_WITH_ZONES__
+		if ( rawDuration && clockDuration ) {
+			const f64 msPerTick = Clock::ms( clockDuration ) / f64( rawDuration );
+			for ( size_t i = 0; i < extraLanes.size(); i++ )
+				packedZones.Push( packLane( extraLanes[i], msPerTick ) );
+		}
+#endif
+
+		// working on local data now, don't need the threads lock any more
+		threads.ReleaseGlobalLock();
+
 		dumper.Init(dir);
 		dumper.GlobalInfo( rawDuration, clockDuration );
 
@@ -1506,6 +1545,10 @@ namespace Profiler {
 			}
 		}
 
+#ifdef __PROFILER_WITH_ZONES__
+		extraLanes.clear();
+#endif
+
 		threads.ReleaseGlobalLock();
 #else
 		if ( root )
@@ -1516,6 +1559,9 @@ namespace Profiler {
 	void enterThread( const char *name ) {
 		Caller *tmp = new Caller( name );
 
+		// collectZones() reads the zones of other threads while they run
+		Caller::thisThread.requireThreadLock = true;
+
 		threads.AcquireGlobalLock();
 		threads.list->Push( Root( tmp, &Caller::thisThread ) );
 
@@ -1563,6 +1609,79 @@ namespace Profiler {
 		threads.ReleaseGlobalLock();
 	}
 
+	void collectZones( std::vector<ThreadZones> &out ) {
+		out.clear();
+#ifdef __PROFILER_WITH_ZONES__
+		const u32 rootMarker = ~u32( 0 );
+
+		threads.AcquireGlobalLock();
+
+		const u64 rawDuration = ( Timer::getticks() - globalStart );
+		const u64 clockDuration = ( Clock::getticks() - globalClockStart );
+		const f64 msPerTick = rawDuration ? Clock::ms( clockDuration ) / f64( rawDuration ) : 0.0;
+
+		Buffer<Root> &threadsref = *threads.list;
+		Buffer<u32> stack;
+		for ( u32 i = 0; i < threadsref.Size(); i++ ) {
+			Root &thread = threadsref[i];
+			if ( !thread.root->IsActive() )
+				continue;
+
+			out.push_back( ThreadZones() );
+			ThreadZones &lane = out.back();
+			lane.name = thread.root->GetName();
+
+			thread.threadState->threadLock.Acquire();
+			const Buffer<Zone> &zones = *thread.threadState->threadZones;
+			stack.Clear();
+			for ( u32 z = 0; z < zones.Size(); z++ ) {
+				// a zone entered just before a reset on another thread can
+				// predate the new start time
+				const u64 time = zones[z].time <= rawDuration ? zones[z].time : 0;
+				if ( zones[z].type == ZoneType::ZoneEnter ) {
+					// the outermost zone is the thread itself
+					if ( !stack.Size() ) {
+						stack.Push( rootMarker );
+						continue;
+					}
+					ZoneSpan span = { zones[z].str(), time * msPerTick, rawDuration * msPerTick, stack.Size() - 1 };
+					stack.Push( u32( lane.zones.size() ) );
+					lane.zones.push_back( span );
+				} else if ( stack.Size() ) {
+					const u32 index = stack.Pop();
+					if ( index != rootMarker )
+						lane.zones[index].endMs = time * msPerTick;
+				}
+			}
+			thread.threadState->threadLock.Release();
+		}
+
+		out.insert( out.end(), extraLanes.begin(), extraLanes.end() );
+
+		threads.ReleaseGlobalLock();
+#endif
+	}
+
+	void addLane( const char *name, const std::vector<ZoneSpan> &zones ) {
+#ifdef __PROFILER_WITH_ZONES__
+		threads.AcquireGlobalLock();
+
+		ThreadZones *lane = NULL;
+		for ( size_t i = 0; i < extraLanes.size() && !lane; i++ ) {
+			if ( strcmp( extraLanes[i].name, name ) == 0 )
+				lane = &extraLanes[i];
+		}
+		if ( !lane ) {
+			extraLanes.push_back( ThreadZones() );
+			lane = &extraLanes.back();
+			lane->name = name;
+		}
+		lane->zones = zones;
+
+		threads.ReleaseGlobalLock();
+#endif
+	}
+
 	inline void fastcall enterCaller( const char *name ) {
 		Caller *parent = Caller::thisThread.activeCaller;
 		if ( !parent )
@@ -1656,6 +1775,8 @@ namespace Profiler {
 	void threadenter( const char *name ) { enterThread( name ); }
 	void threadexit() { exitThread(); }
 	void reset() { resetThreads(); }
+	void collectzones( std::vector<ThreadZones> &threads ) { collectZones( threads ); }
+	void addlane( const char *name, const std::vector<ZoneSpan> &zones ) { addLane( name, zones ); }
 #else
 	void detect( int argc, char **argv ) {}
 	//void detect( const char *commandLine ) {}
@@ -1670,6 +1791,8 @@ namespace Profiler {
 	void threadenter( const char *name ) {}
 	void threadexit() {}
 	void reset() {}
+	void collectzones( std::vector<ThreadZones> &threads ) { threads.clear(); }
+	void addlane( const char *name, const std::vector<ZoneSpan> &zones ) {}
 #endif
 
 } // namespace Profiler
@@ -15,6 +15,7 @@
 
 #include <chrono>
 #include <ratio>
+#include <vector>
 
 #if defined(_MSC_VER)
 	#undef __PRETTY_FUNCTION__
@@ -243,6 +244,22 @@ namespace Profiler {
 	};
 	#pragma pack(pop)
 
+	/*
+	=============
+	Zone spans, the recorded zones of one thread as begin/end pairs
+	=============
+	*/
+	struct ZoneSpan {
+		const char *name;
+		f64 startMs, endMs; // relative to the last reset
+		u32 depth;
+	};
+
+	struct ThreadZones {
+		const char *name;
+		std::vector<ZoneSpan> zones;
+	};
+
 	/*
 	=============
 	Interface functions
@@ -262,6 +279,13 @@ namespace Profiler {
 	void threadenter( const char *name );
 	void threadexit();
 	void reset();
+	// copies the zones each running thread recorded since the last reset;
+	// zones that are still open end at the current time
+	void collectzones( std::vector<ThreadZones> &threads );
+	// adds zones that were timed by other means, e.g. on the GPU, as a lane
+	// of their own until the next reset; the dumps and collectzones() show
+	// it after the threads. Adding a lane with the same name replaces it
+	void addlane( const char *name, const std::vector<ZoneSpan> &zones );
 
 	struct Scoped {
 		Scoped( const char *name ) { PROFILE_START_RAW( name ) }
@@ -0,0 +1,220 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "AtmosphereLUT.h"
+
+#include "MathUtil.h"
+#include "galaxy/AtmosphereParameters.h"
+#include "graphics/Material.h"
+#include "graphics/Renderer.h"
+#include "graphics/Texture.h"
+#include "profiler/Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+	// Earth's sea level Rayleigh scattering, averaged over rgb, and Mie
+	// scattering and extinction, per metre
+	constexpr float EARTH_RAYLEIGH = 17.5e-6f;
+	constexpr float EARTH_MIE = 4.0e-6f;
+	constexpr float EARTH_MIE_EXTINCTION = 4.4e-6f;
+	// atmosDensity of an Earth-like atmosphere (surface density, scaled by 1e-5)
+	constexpr float EARTH_ATMOS_DENSITY = 1.225e-5f;
+	// the ratio of Rayleigh and Mie scale heights used by CalcAtmosphereParams
+	constexpr float MIE_SCALE_HEIGHT_RATIO = 6.66f;
+
+	constexpr int TRANSMITTANCE_STEPS = 40;
+	constexpr int SCATTER_STEPS = 32;
+
+	// texel centre coordinate to [0, 1] and back
+	inline float from_texel(Uint32 i, Uint32 n) { return float(i) / float(n - 1); }
+	inline float to_texel(float x, Uint32 n) { return Clamp(x, 0.0f, 1.0f) * float(n - 1); }
+
+	inline Uint8 to_unorm8(float x) { return Uint8(Clamp(x, 0.0f, 1.0f) * 255.0f + 0.5f); }
+} // namespace
+
+AtmosphereLUT::AtmosphereLUT(const AtmosphereParameters &ap)
+{
+	PROFILE_SCOPED()
+	m_topRadius = std::max(ap.atmosRadius, 1.0001f);
+	m_invScaleHeightR = ap.atmosInvScaleHeight;
+	m_invScaleHeightM = ap.atmosInvScaleHeight * MIE_SCALE_HEIGHT_RATIO;
+
+	// scattering follows the body's atmosphere colour, as the sky shaders
+	// do, and scales with its density
+	const float density = ap.atmosDensity / EARTH_ATMOS_DENSITY * ap.planetRadius;
+	const Color4f col = ap.atmosCol.ToColor4f();
+	const float colSum = std::max(col.r + col.g + col.b, 1e-3f);
+	m_betaR = vector3f(col.r, col.g, col.b) * (3.0f / colSum * EARTH_RAYLEIGH * density);
+	m_betaM = vector3f(EARTH_MIE * density);
+	m_betaMExt = vector3f(EARTH_MIE_EXTINCTION * density);
+
+	ComputeTransmittance();
+	ComputeScatter();
+}
+
+AtmosphereLUT::~AtmosphereLUT()
+{
+}
+
+float AtmosphereLUT::GetAltitudeCoord(float r) const
+{
+	return std::sqrt(Clamp((r - 1.0f) / (m_topRadius - 1.0f), 0.0f, 1.0f));
+}
+
+float AtmosphereLUT::GetRadius(float coord) const
+{
+	return 1.0f + coord * coord * (m_topRadius - 1.0f);
+}
+
+float AtmosphereLUT::GetDistanceToTop(float r, float mu) const
+{
+	const float disc = r * r * (mu * mu - 1.0f) + m_topRadius * m_topRadius;
+	return std::max(-r * mu + std::sqrt(std::max(disc, 0.0f)), 0.0f);
+}
+
+bool AtmosphereLUT::HitsGround(float r, float mu) const
+{
+	return mu < 0.0f && r * r * (mu * mu - 1.0f) + 1.0f >= 0.0f;
+}
+
+void AtmosphereLUT::ComputeTransmittance()
+{
+	PROFILE_SCOPED()
+	m_transmittance.resize(TRANSMITTANCE_MU * TRANSMITTANCE_ALT);
+	for (Uint32 y = 0; y < TRANSMITTANCE_ALT; y++) {
+		const float r = GetRadius(from_texel(y, TRANSMITTANCE_ALT));
+		for (Uint32 x = 0; x < TRANSMITTANCE_MU; x++) {
+			const float mu = from_texel(x, TRANSMITTANCE_MU) * 2.0f - 1.0f;
+			vector3f &out = m_transmittance[y * TRANSMITTANCE_MU + x];
+			if (HitsGround(r, mu)) {
+				out = vector3f(0.0f);
+				continue;
+			}
+
+			const float ds = GetDistanceToTop(r, mu) / float(TRANSMITTANCE_STEPS);
+			float depthR = 0.0f, depthM = 0.0f;
+			for (int i = 0; i < TRANSMITTANCE_STEPS; i++) {
+				const float t = (float(i) + 0.5f) * ds;
+				const float h = std::sqrt(r * r + 2.0f * r * mu * t + t * t) - 1.0f;
+				depthR += std::exp(-h * m_invScaleHeightR) * ds;
+				depthM += std::exp(-h * m_invScaleHeightM) * ds;
+			}
+			const vector3f tau = m_betaR * depthR + m_betaMExt * depthM;
+			out = vector3f(std::exp(-tau.x), std::exp(-tau.y), std::exp(-tau.z));
+		}
+	}
+
+	m_transmittanceData.resize(m_transmittance.size());
+	for (size_t i = 0; i < m_transmittance.size(); i++) {
+		const vector3f &t = m_transmittance[i];
+		m_transmittanceData[i] = Color(to_unorm8(t.x), to_unorm8(t.y), to_unorm8(t.z), 255);
+	}
+}
+
+vector3f AtmosphereLUT::GetTransmittance(float r, float mu) const
+{
+	const float fx = to_texel((mu + 1.0f) * 0.5f, TRANSMITTANCE_MU);
+	const float fy = to_texel(GetAltitudeCoord(r), TRANSMITTANCE_ALT);
+	const Uint32 x0 = std::min(Uint32(fx), TRANSMITTANCE_MU - 2);
+	const Uint32 y0 = std::min(Uint32(fy), TRANSMITTANCE_ALT - 2);
+	const float ax = fx - float(x0), ay = fy - float(y0);
+
+	const vector3f *row0 = &m_transmittance[y0 * TRANSMITTANCE_MU + x0];
+	const vector3f *row1 = row0 + TRANSMITTANCE_MU;
+	return MathUtil::mix(MathUtil::mix(row0[0], row0[1], ax), MathUtil::mix(row1[0], row1[1], ax), ay);
+}
+
+void AtmosphereLUT::ComputeScatter()
+{
+	PROFILE_SCOPED()
+	const Uint32 width = SCATTER_MU * SCATTER_MU_S;
+	m_scatterR.resize(width * SCATTER_ALT);
+	m_scatterM.resize(width * SCATTER_ALT);
+	m_scatterData.resize(width * SCATTER_ALT);
+
+	for (Uint32 y = 0; y < SCATTER_ALT; y++) {
+		const float r = GetRadius(from_texel(y, SCATTER_ALT));
+		for (Uint32 s = 0; s < SCATTER_MU_S; s++) {
+			const float mu_s = from_texel(s, SCATTER_MU_S) * 2.0f - 1.0f;
+			// the viewer looks along the y-z plane, the sun is at 90 degrees azimuth
+			const vector3f sun(std::sqrt(std::max(1.0f - mu_s * mu_s, 0.0f)), 0.0f, mu_s);
+			for (Uint32 x = 0; x < SCATTER_MU; x++) {
+				const float mu = from_texel(x, SCATTER_MU) * 2.0f - 1.0f;
+				const vector3f pos(0.0f, 0.0f, r);
+				const vector3f dir(0.0f, std::sqrt(std::max(1.0f - mu * mu, 0.0f)), mu);
+
+				// march to the top of the atmosphere, or to the ground
+				float length = GetDistanceToTop(r, mu);
+				if (HitsGround(r, mu))
+					length = -r * mu - std::sqrt(std::max(r * r * (mu * mu - 1.0f) + 1.0f, 0.0f));
+				const float ds = std::max(length, 0.0f) / float(SCATTER_STEPS);
+
+				vector3f sumR(0.0f), sumM(0.0f);
+				float depthR = 0.0f, depthM = 0.0f;
+				for (int i = 0; i < SCATTER_STEPS; i++) {
+					const vector3f p = pos + dir * ((float(i) + 0.5f) * ds);
+					const float rp = p.Length();
+					const float h = std::max(rp - 1.0f, 0.0f);
+					const float densityR = std::exp(-h * m_invScaleHeightR);
+					const float densityM = std::exp(-h * m_invScaleHeightM);
+
+					// optical depth from the viewer to the middle of this step
+					depthR += densityR * ds * 0.5f;
+					depthM += densityM * ds * 0.5f;
+					const vector3f tau = m_betaR * depthR + m_betaMExt * depthM;
+					const vector3f viewT(std::exp(-tau.x), std::exp(-tau.y), std::exp(-tau.z));
+					depthR += densityR * ds * 0.5f;
+					depthM += densityM * ds * 0.5f;
+
+					const float mu_sp = p.Dot(sun) / rp;
+					if (HitsGround(rp, mu_sp))
+						continue;
+					const vector3f sunT = GetTransmittance(rp, mu_sp);
+					const vector3f t(viewT.x * sunT.x, viewT.y * sunT.y, viewT.z * sunT.z);
+					sumR += vector3f(t.x * m_betaR.x, t.y * m_betaR.y, t.z * m_betaR.z) * (densityR * ds);
+					sumM += vector3f(t.x * m_betaM.x, t.y * m_betaM.y, t.z * m_betaM.z) * (densityM * ds);
+				}
+
+				const Uint32 index = y * width + s * SCATTER_MU + x;
+				m_scatterR[index] = sumR;
+				m_scatterM[index] = sumM;
+				m_scatterData[index] = Color(to_unorm8(std::sqrt(sumR.x)), to_unorm8(std::sqrt(sumR.y)),
+					to_unorm8(std::sqrt(sumR.z)), to_unorm8(std::sqrt(sumM.x)));
+			}
+		}
+	}
+}
+
+void AtmosphereLUT::GetScatter(float r, float mu, float mu_s, vector3f &rayleigh, vector3f &mie) const
+{
+	// nearest texel; this is only for looking at the table
+	const Uint32 x = Uint32(to_texel((mu + 1.0f) * 0.5f, SCATTER_MU) + 0.5f);
+	const Uint32 s = Uint32(to_texel((mu_s + 1.0f) * 0.5f, SCATTER_MU_S) + 0.5f);
+	const Uint32 y = Uint32(to_texel(GetAltitudeCoord(r), SCATTER_ALT) + 0.5f);
+	const Uint32 index = y * SCATTER_MU * SCATTER_MU_S + s * SCATTER_MU + x;
+	rayleigh = m_scatterR[index];
+	mie = m_scatterM[index];
+}
+
+void AtmosphereLUT::Bind(Graphics::Renderer *renderer, Graphics::Material *material)
+{
+	if (!m_transmittanceTexture.Valid()) {
+		const vector3f dataSize(TRANSMITTANCE_MU, TRANSMITTANCE_ALT, 0.0f);
+		const Graphics::TextureDescriptor texDesc(Graphics::TEXTURE_RGBA_8888, dataSize, Graphics::LINEAR_CLAMP,
+			false, false, false, 0, Graphics::TEXTURE_2D);
+		m_transmittanceTexture.Reset(renderer->CreateTexture(texDesc));
+		m_transmittanceTexture->Update(m_transmittanceData.data(), dataSize, Graphics::TEXTURE_RGBA_8888);
+	}
+	if (!m_scatterTexture.Valid()) {
+		const vector3f dataSize(SCATTER_MU * SCATTER_MU_S, SCATTER_ALT, 0.0f);
+		const Graphics::TextureDescriptor texDesc(Graphics::TEXTURE_RGBA_8888, dataSize, Graphics::LINEAR_CLAMP,
+			false, false, false, 0, Graphics::TEXTURE_2D);
+		m_scatterTexture.Reset(renderer->CreateTexture(texDesc));
+		m_scatterTexture->Update(m_scatterData.data(), dataSize, Graphics::TEXTURE_RGBA_8888);
+	}
+
+	material->SetTexture("transmittanceLUT"_hash, m_transmittanceTexture.Get());
+	material->SetTexture("scatterLUT"_hash, m_scatterTexture.Get());
+}
@@ -0,0 +1,86 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _ATMOSPHERELUT_H
+#define _ATMOSPHERELUT_H
+
+#include "Color.h"
+#include "RefCounted.h"
+#include "vector3.h"
+
+#include <vector>
+
+struct AtmosphereParameters;
+
+namespace Graphics {
+	class Material;
+	class Renderer;
+	class Texture;
+} // namespace Graphics
+
+// Precomputed scattering tables for one atmosphere, so the sky and surface
+// shaders can look up what they would otherwise ray-march per pixel.
+//
+// Distances are in planet radii, with the planet at the origin. Both tables
+// are laid out for LINEAR_CLAMP sampling at texel centres:
+//
+// - transmittance: x = view zenith cosine mu, mapped linearly from [-1, 1];
+//   y = altitude, as sqrt((r - 1) / (atmosRadius - 1)). Holds the rgb
+//   transmittance from the point to the top of the atmosphere, 0 for rays
+//   hitting the ground.
+// - scatter: single scattering of unit sunlight towards the viewer, without
+//   the phase function. x = mu_s * SCATTER_MU + mu (sun and view zenith
+//   cosines, mapped as above), y = altitude as above. rgb is Rayleigh, a is
+//   the red channel of Mie, and all are stored square-rooted for precision.
+//
+// The azimuth between view and sun is left out (taken as 90 degrees), which
+// is what keeps the scatter table three dimensional.
+class AtmosphereLUT {
+public:
+	static constexpr Uint32 TRANSMITTANCE_MU = 64;
+	static constexpr Uint32 TRANSMITTANCE_ALT = 32;
+	static constexpr Uint32 SCATTER_MU = 32;
+	static constexpr Uint32 SCATTER_MU_S = 16;
+	static constexpr Uint32 SCATTER_ALT = 16;
+
+	explicit AtmosphereLUT(const AtmosphereParameters &ap);
+	~AtmosphereLUT();
+
+	// r is the distance from the planet centre
+	vector3f GetTransmittance(float r, float mu) const;
+	void GetScatter(float r, float mu, float mu_s, vector3f &rayleigh, vector3f &mie) const;
+
+	const std::vector<Color> &GetTransmittanceData() const { return m_transmittanceData; }
+	const std::vector<Color> &GetScatterData() const { return m_scatterData; }
+
+	// binds the tables to "transmittanceLUT" and "scatterLUT",
+	// creating the textures on first use
+	void Bind(Graphics::Renderer *renderer, Graphics::Material *material);
+
+private:
+	float GetAltitudeCoord(float r) const;
+	float GetRadius(float coord) const;
+	float GetDistanceToTop(float r, float mu) const;
+	bool HitsGround(float r, float mu) const;
+
+	void ComputeTransmittance();
+	void ComputeScatter();
+
+	float m_topRadius;
+	float m_invScaleHeightR;
+	float m_invScaleHeightM;
+	vector3f m_betaR;	 // Rayleigh scattering, per planet radius
+	vector3f m_betaM;	 // Mie scattering, per planet radius
+	vector3f m_betaMExt; // Mie extinction, per planet radius
+
+	std::vector<vector3f> m_transmittance;
+	std::vector<vector3f> m_scatterR;
+	std::vector<vector3f> m_scatterM;
+	std::vector<Color> m_transmittanceData;
+	std::vector<Color> m_scatterData;
+
+	RefCountedPtr<Graphics::Texture> m_transmittanceTexture;
+	RefCountedPtr<Graphics::Texture> m_scatterTexture;
+};
+
+#endif /* _ATMOSPHERELUT_H */
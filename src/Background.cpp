@@ -20,6 +20,7 @@
 #include "graphics/Graphics.h"
 #include "graphics/RenderState.h"
 #include "graphics/TextureBuilder.h"
+#include "graphics/TextureLoader.h"
 #include "graphics/Types.h"
 #include "graphics/VertexArray.h"
 #include "graphics/VertexBuffer.h"
@@ -28,7 +29,9 @@
 #include "utils.h"
 
 #include <SDL_stdinc.h>
+#include <deque>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <numeric>
 
@@ -39,7 +42,11 @@ namespace {
 	constexpr Uint32 BG_STAR_MIN = 1;
 	constexpr Sint32 BG_STAR_RADIUS_MAX = 500;
 	constexpr Uint32 NUM_HYPERSPACE_STARS = 8000;
+	constexpr float CUBEMAP_FADE_SECONDS = 1.0f;
 	static RefCountedPtr<Graphics::Texture> s_defaultCubeMap;
+	// meshes that are the same for every container, kept while one is alive
+	static std::weak_ptr<Graphics::MeshObject> s_universeBoxMesh;
+	static std::weak_ptr<Graphics::MeshObject> s_milkyWayMesh;
 
 	static Uint32 GetNumSkyboxes()
 	{
@@ -84,7 +91,9 @@ namespace Background {
 		m_material->emissive = Color(intensity * 255, intensity * 255, intensity * 255);
 	}
 
-	UniverseBox::UniverseBox(Graphics::Renderer *renderer)
+	UniverseBox::UniverseBox(Graphics::Renderer *renderer) :
+		m_fading(false),
+		m_intensity(1.0f)
 	{
 		m_renderer = renderer;
 		Init();
@@ -102,6 +111,27 @@ namespace Background {
 			s_defaultCubeMap.Reset(texture_builder.GetOrCreateTexture(m_renderer, std::string("cube")));
 		}
 
+		Graphics::MaterialDescriptor desc;
+		Graphics::RenderStateDesc stateDesc;
+		stateDesc.depthTest = false;
+		stateDesc.depthWrite = false;
+
+		m_material.Reset(m_renderer->CreateMaterial("skybox", desc, stateDesc));
+		m_material->diffuse = Color4f(0.8, 0.8, 0.8, 1.0);
+
+		// adds the incoming cubemap to the outgoing one during a cross-fade
+		stateDesc.blendMode = Graphics::BLEND_ADDITIVE;
+		m_fadeMaterial.Reset(m_renderer->CreateMaterial("skybox", desc, stateDesc));
+		m_fadeMaterial->diffuse = m_material->diffuse;
+
+		SetIntensity(1.0f);
+		m_numCubemaps = GetNumSkyboxes();
+
+		m_universeBox = s_universeBoxMesh.lock();
+		if (m_universeBox)
+			return;
+
+
 		// Create skybox geometry
 		std::unique_ptr<Graphics::VertexArray> box(new VertexArray(ATTRIB_POSITION | ATTRIB_UV0, 36));
 		const float vp = 1000.0f;
@@ -148,14 +178,6 @@ namespace Background {
 		box->Add(vector3f(-vp, -vp, vp), vector2f(0.0f, 1.0f));
 		box->Add(vector3f(-vp, -vp, -vp), vector2f(1.0f, 1.0f));
 
-		Graphics::MaterialDescriptor desc;
-		Graphics::RenderStateDesc stateDesc;
-		stateDesc.depthTest = false;
-		stateDesc.depthWrite = false;
-
-		m_material.Reset(m_renderer->CreateMaterial("skybox", desc, stateDesc));
-		m_material->diffuse = Color4f(0.8, 0.8, 0.8, 1.0);
-
 		//create buffer and upload data
 		Graphics::VertexBufferDesc vbd = Graphics::VertexBufferDesc::FromAttribSet(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_UV0);
 		vbd.numVertices = box->GetNumVerts();
@@ -171,37 +193,102 @@ namespace Background {
 		}
 		vertexBuf->Unmap();
 
-		SetIntensity(1.0f);
-
 		m_universeBox.reset(m_renderer->CreateMeshObject(vertexBuf));
-		m_numCubemaps = GetNumSkyboxes();
+		s_universeBoxMesh = m_universeBox;
 	}
 
+
 	void UniverseBox::Draw()
 	{
-		if (m_cubemap.Valid())
+		if (!m_cubemap.Valid())
+			return;
+
+		Graphics::TextureLoader *loader = m_renderer->GetTextureLoader();
+		if (m_fadeFrom.Valid() && !m_fading && !(loader && loader->IsPending(m_cubemap.Get()))) {
+			// the new cubemap is in, start blending it over the old one
+			m_fading = true;
+			m_fadeStart = std::chrono::steady_clock::now();
+		}
+
+		if (!m_fadeFrom.Valid()) {
+			m_renderer->DrawMesh(m_universeBox.get(), m_material.Get());
+			return;
+		}
+
+		float t = 0.0f;
+		if (m_fading)
+			t = std::chrono::duration<float>(std::chrono::steady_clock::now() - m_fadeStart).count() / CUBEMAP_FADE_SECONDS;
+
+		if (t >= 1.0f) {
+			m_fadeFrom.Reset();
+			m_fading = false;
+			m_material->SetTexture("texture0"_hash, m_cubemap.Get());
+			SetIntensity(m_intensity);
 			m_renderer->DrawMesh(m_universeBox.get(), m_material.Get());
+			return;
+		}
+
+		m_material->SetTexture("texture0"_hash, m_fadeFrom.Get());
+		m_material->emissive = Color(m_intensity * (1.0f - t) * 255, m_intensity * (1.0f - t) * 255, m_intensity * (1.0f - t) * 255);
+		m_renderer->DrawMesh(m_universeBox.get(), m_material.Get());
+
+		if (t > 0.0f) {
+			m_fadeMaterial->emissive = Color(m_intensity * t * 255, m_intensity * t * 255, m_intensity * t * 255);
+			m_renderer->DrawMesh(m_universeBox.get(), m_fadeMaterial.Get());
+		}
 	}
 
-	void UniverseBox::LoadCubeMap(Random &rand)
+	void UniverseBox::SetIntensity(float intensity)
 	{
-		if (m_numCubemaps > 0) {
-			const int new_ubox_index = rand.Int32(1, m_numCubemaps);
-			if (new_ubox_index > 0) {
-				// Load new one
-				const std::string os = stringf("textures/skybox/ub%0{d}.dds", (new_ubox_index - 1));
-				TextureBuilder texture_builder = TextureBuilder::Cube(os.c_str());
-				m_cubemap.Reset(texture_builder.GetOrCreateTexture(m_renderer, std::string("cube")));
-			}
+		m_intensity = intensity;
+		BackgroundElement::SetIntensity(intensity);
+	}
+
+	int UniverseBox::PickCubeMap(Random &rand) const
+	{
+		return m_numCubemaps > 0 ? rand.Int32(1, m_numCubemaps) : 0;
+	}
+
+	Graphics::Texture *UniverseBox::GetCubeMap(int index, bool async) const
+	{
+		if (index <= 0)
+			return s_defaultCubeMap.Get();
+
+		const std::string os = stringf("textures/skybox/ub%0{d}.dds", (index - 1));
+		TextureBuilder texture_builder = TextureBuilder::Cube(os.c_str());
+		if (async)
+			return texture_builder.GetOrCreateTextureAsync(m_renderer, std::string("cube"), Color::BLACK);
+		return texture_builder.GetOrCreateTexture(m_renderer, std::string("cube"));
+	}
+
+	void UniverseBox::LoadCubeMap(Random &rand, const UniverseBox *previous)
+	{
+		PROFILE_SCOPED()
+		// there's nothing to show in the meantime without a previous cubemap
+		const bool async = previous && previous->m_cubemap.Valid();
+		m_cubemap.Reset(GetCubeMap(m_numCubemaps > 0 ? PickCubeMap(rand) : 0, async));
+
+		m_fading = false;
+		if (async && previous->m_cubemap != m_cubemap) {
+			m_fadeFrom = previous->m_cubemap;
 		} else {
-			// use default cubemap
-			m_cubemap.Reset(s_defaultCubeMap.Get());
+			m_fadeFrom.Reset();
 		}
 
 		m_material->SetTexture("texture0"_hash, m_cubemap.Get());
+		m_fadeMaterial->SetTexture("texture0"_hash, m_cubemap.Get());
+	}
+
+	void UniverseBox::Prefetch(Random &rand)
+	{
+		const int index = m_numCubemaps > 0 ? PickCubeMap(rand) : 0;
+		// kept in the renderer's texture cache for LoadCubeMap
+		if (index > 0)
+			GetCubeMap(index, true);
 	}
 
-	Starfield::Starfield(Graphics::Renderer *renderer)
+	Starfield::Starfield(Graphics::Renderer *renderer) :
+		m_fillSerial(0)
 	{
 		m_renderer = renderer;
 		Init();
@@ -374,8 +461,8 @@ namespace Background {
 			medianBrightness(medianBrightness)
 		{}
 
-		// Do the brightness sort on worker threads using the worker's subset
-		// of stars rather than on the main thread with all stars.
+		// Do the brightness sort on each slice's subset of stars
+		// rather than on all stars at once.
 		virtual void OnExecute(TaskRange) override
 		{
 			PROFILE_SCOPED()
@@ -433,29 +520,28 @@ namespace Background {
 		return spherical_segment_volume(h, r1_sq, r2_sq);
 	}
 
-	void Starfield::Fill(Random &rand, const SystemPath *const systemPath, RefCountedPtr<Galaxy> galaxy)
-	{
-		PROFILE_SCOPED()
-		const Uint32 NUM_BG_STARS = MathUtil::mix(BG_STAR_MIN, BG_STAR_MAX, Pi::GetAmountBackgroundStars());
-		const float brightnessApparentSizeFactor = Pi::GetStarFieldStarSizeFactor() / 7.0;
-		// dividing by 7 to make sure that 100% star size isn't too big to clash with UI elements
-
-		m_hyperVtx.reset(new vector3f[NUM_HYPERSPACE_STARS * 3]);
-		m_hyperCol.reset(new Color[NUM_HYPERSPACE_STARS * 3]);
-		{
-			Graphics::VertexBufferDesc vbd = VertexBufferDesc::FromAttribSet(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_DIFFUSE);
-			vbd.usage = Graphics::BUFFER_USAGE_DYNAMIC;
-			vbd.numVertices = NUM_HYPERSPACE_STARS * 2;
-			// this vertex buffer will be owned by the animMesh object
-			Graphics::VertexBuffer *vtxBuffer = m_renderer->CreateVertexBuffer(vbd);
-			m_animMesh.reset(m_renderer->CreateMeshObject(vtxBuffer));
-		}
+	struct StarfieldParams {
+		Uint32 numStars;
+		float brightnessFactor;
+		uint32_t numSlices;
+		float rMin, rMax;
+		float gMin, gMax;
+		float bMin, bMax;
+	};
 
-		m_pointSprites.reset(new Graphics::Drawables::PointSprites);
+	struct StarfieldData {
+		StarInfo stars;
+		std::vector<vector3f> hyperVtx; // NUM_HYPERSPACE_STARS
+	};
 
-		assert(sizeof(StarVert) == 16);
+	// Picks the stars around systemPath from the galaxy and fills up the rest
+	// with random ones. Doesn't touch the renderer or Pi, so it can run in a job.
+	static void GenerateStars(StarfieldData &out, Random &rand, const SystemPath *const systemPath, RefCountedPtr<Galaxy> galaxy, const StarfieldParams &params)
+	{
+		PROFILE_SCOPED()
+		const Uint32 NUM_BG_STARS = params.numStars;
 
-		StarInfo stars;
+		StarInfo &stars = out.stars;
 		stars.pos.reserve(NUM_BG_STARS);
 		stars.color.reserve(NUM_BG_STARS);
 		stars.brightness.reserve(NUM_BG_STARS);
@@ -465,11 +551,8 @@ namespace Background {
 		if (systemPath && galaxy.Valid()) {
 			PROFILE_SCOPED_DESC("Pick Stars from Galaxy")
 
-			TaskGraph *graph = Pi::GetApp()->GetTaskGraph();
-
-			// We want the main thread to participate in this work as well,
-			// but don't split the number of stars too much that we have visible brightness "patches"
-			const uint32_t numTasks = std::min(graph->GetNumWorkerThreads() + 1, 8U);
+			// don't split the number of stars too much that we have visible brightness "patches"
+			const uint32_t numSlices = params.numSlices;
 
 			// judging by the current sector generator, maximum average number
 			// of stars in a sector is 6
@@ -484,26 +567,26 @@ namespace Background {
 			info.sectorMin = -(visibleRadius / Sector::SIZE); // lyrs_radius / sector_size_in_lyrs
 			info.sectorMax = visibleRadius / Sector::SIZE;	  // lyrs_radius / sector_size_in_lyrs
 			info.visibleRadiusSqr = (visibleRadius * visibleRadius);
-			info.colorMin = Color((Uint8)(m_rMin * 255), (Uint8)(m_gMin * 255), (Uint8)(m_rMin * 255));
-			info.colorMax = Color((Uint8)(m_rMax * 255), (Uint8)(m_gMax * 255), (Uint8)(m_rMax * 255));
-			info.brightnessFactor = brightnessApparentSizeFactor;
-
-			TaskSet *sampleStarsTaskSet = new TaskSet();
+			info.colorMin = Color((Uint8)(params.rMin * 255), (Uint8)(params.gMin * 255), (Uint8)(params.rMin * 255));
+			info.colorMax = Color((Uint8)(params.rMax * 255), (Uint8)(params.gMax * 255), (Uint8)(params.rMax * 255));
+			info.brightnessFactor = params.brightnessFactor;
 
 			int32_t starsLeft = NUM_BG_STARS;
 			const double realRadius = info.sectorMax + 0.5;
 			const double realDensity = NUM_BG_STARS / (M_PI / 0.75 * realRadius * realRadius * realRadius);
 
-			std::vector<StarInfo> taskStars(numTasks);
-			std::vector<double> taskMedians(numTasks);
+			std::vector<StarInfo> taskStars(numSlices);
+			std::vector<double> taskMedians(numSlices);
 
-			// Split the visible area of the galaxy up into separate tasks
+			// Split the visible area of the galaxy up into separate slices.
+			// We're already off the main thread, so they're sampled one after
+			// another rather than queued on the task graph.
 			uint32_t current = 0;
-			int32_t range_step = (info.sectorMax - info.sectorMin) / numTasks;
-			for (size_t i = 0; i < numTasks; i++) {
+			int32_t range_step = (info.sectorMax - info.sectorMin) / numSlices;
+			for (size_t i = 0; i < numSlices; i++) {
 				int32_t starsLimit;
 				uint32_t end = current + range_step;
-				if (i + 1 == numTasks) {
+				if (i + 1 == numSlices) {
 					end = (info.sectorMax - info.sectorMin);
 					starsLimit = starsLeft;
 				} else {
@@ -511,23 +594,15 @@ namespace Background {
 					starsLeft -= starsLimit;
 				}
 
-				sampleStarsTaskSet->AddTask(new SampleStarsTask(galaxy, info, starsLimit, taskStars[i], taskMedians[i], { current, end }));
+				SampleStarsTask(galaxy, info, starsLimit, taskStars[i], taskMedians[i], { current, end }).OnExecute({ current, end });
 				current = end + 1;
 			}
 
-			// We can't make progress until all stars are gathered, so run the
-			// star collection on the 'main' thread as well.
-			auto sampleHandle = graph->QueueTaskSet(sampleStarsTaskSet);
-			graph->WaitForTaskSet(sampleHandle);
-
 			double medianBrightness = std::reduce(taskMedians.begin(), taskMedians.end()) / taskMedians.size();
 
-			TaskSet *sortStarsTaskSet = new TaskSet();
-			for (size_t i = 0; i < numTasks; i++) {
-				sortStarsTaskSet->AddTask(new SortStarsTask(info, taskStars[i], medianBrightness));
+			for (size_t i = 0; i < numSlices; i++) {
+				SortStarsTask(info, taskStars[i], medianBrightness).OnExecute({});
 			}
-			auto sortHandle = graph->QueueTaskSet(sortStarsTaskSet);
-			graph->WaitForTaskSet(sortHandle);
 
 			for(auto &item : taskStars) {
 				stars.pos.insert(stars.pos.end(), item.pos.begin(), item.pos.end());
@@ -550,9 +625,9 @@ namespace Background {
 			const Uint8 colScale = size * 255;
 
 			const Color col(
-				rand.Double(m_rMin, m_rMax) * colScale,
-				rand.Double(m_gMin, m_gMax) * colScale,
-				rand.Double(m_bMin, m_bMax) * colScale,
+				rand.Double(params.rMin, params.rMax) * colScale,
+				rand.Double(params.gMin, params.gMax) * colScale,
+				rand.Double(params.bMin, params.bMax) * colScale,
 				255);
 
 			// this is proper random distribution on a sphere's surface
@@ -570,22 +645,186 @@ namespace Background {
 		PROFILE_STOP()
 
 		PROFILE_START_DESC("Fill Hyperspace Stars")
+		out.hyperVtx.resize(NUM_HYPERSPACE_STARS);
 		for (uint32_t i = 0; i < NUM_HYPERSPACE_STARS; i++) {
 			// this is proper random distribution on a sphere's surface
 			const float theta = float(rand.Double(0.0, 2.0 * M_PI));
 			const float u = float(rand.Double(-1.0, 1.0));
 
 			// squeeze the starfield a bit to get more density near horizon using matrix3x3f::Scale
-			const auto star = matrix3x3f::Scale(1.0, 0.4, 1.0) * (vector3f(sqrt(1.0f - u * u) * cos(theta), u, sqrt(1.0f - u * u) * sin(theta)).Normalized() * 1000.0f);
-
-			m_hyperVtx[NUM_HYPERSPACE_STARS * 2 + i] = star;
-			m_hyperCol[NUM_HYPERSPACE_STARS * 2 + i] = Color::WHITE * 0.8;
+			out.hyperVtx[i] = matrix3x3f::Scale(1.0, 0.4, 1.0) * (vector3f(sqrt(1.0f - u * u) * cos(theta), u, sqrt(1.0f - u * u) * sin(theta)).Normalized() * 1000.0f);
 		}
 		PROFILE_STOP()
 
 		Output("Final stars number: %d\n", num);
+	}
+
+	// Recently generated starfields, most recent first, so jumping back and
+	// forth between systems doesn't sample the galaxy every time.
+	struct CachedStarfield {
+		SystemPath path;
+		std::string generator;
+		int version;
+		Uint32 numStars;
+		float brightnessFactor;
+		std::shared_ptr<const StarfieldData> data;
+	};
 
-		m_pointSprites->SetData(NUM_BG_STARS, std::move(stars.pos), std::move(stars.color), std::move(stars.brightness));
+	static constexpr size_t STARFIELD_CACHE_SIZE = 4;
+	static std::deque<CachedStarfield> s_starfieldCache;
+
+	static std::shared_ptr<const StarfieldData> find_cached_starfield(const SystemPath &path, const Galaxy *galaxy, const StarfieldParams &params)
+	{
+		for (auto it = s_starfieldCache.begin(); it != s_starfieldCache.end(); ++it) {
+			if (!it->path.IsSameSystem(path) || it->generator != galaxy->GetGeneratorName() || it->version != galaxy->GetGeneratorVersion())
+				continue;
+			// a changed star count or size setting needs a new starfield
+			if (it->numStars != params.numStars || it->brightnessFactor != params.brightnessFactor)
+				continue;
+
+			CachedStarfield entry = std::move(*it);
+			s_starfieldCache.erase(it);
+			s_starfieldCache.push_front(std::move(entry));
+			return s_starfieldCache.front().data;
+		}
+		return nullptr;
+	}
+
+	static void cache_starfield(const SystemPath &path, const Galaxy *galaxy, const StarfieldParams &params, std::shared_ptr<const StarfieldData> data)
+	{
+		if (find_cached_starfield(path, galaxy, params))
+			return;
+		s_starfieldCache.push_front({ path, galaxy->GetGeneratorName(), galaxy->GetGeneratorVersion(), params.numStars, params.brightnessFactor, data });
+		if (s_starfieldCache.size() > STARFIELD_CACHE_SIZE)
+			s_starfieldCache.pop_back();
+	}
+
+	class Starfield::FillJob : public Job {
+	public:
+		FillJob(Starfield *starfield, Uint32 serial, Uint32 seed, const SystemPath *const systemPath, RefCountedPtr<Galaxy> galaxy, const StarfieldParams &params) :
+			m_starfield(starfield),
+			m_serial(serial),
+			m_rand(seed),
+			m_hasPath(systemPath != nullptr),
+			m_path(systemPath ? *systemPath : SystemPath()),
+			m_galaxy(galaxy),
+			m_params(params),
+			m_data(new StarfieldData)
+		{}
+
+		virtual void OnRun() override
+		{
+			GenerateStars(*m_data, m_rand, m_hasPath ? &m_path : nullptr, m_galaxy, m_params);
+		}
+
+		virtual void OnFinish() override
+		{
+			// only stars picked from the galaxy are worth keeping
+			if (m_hasPath && m_galaxy.Valid())
+				cache_starfield(m_path, m_galaxy.Get(), m_params, m_data);
+			if (m_starfield && m_serial == m_starfield->m_fillSerial)
+				m_starfield->SetData(*m_data);
+		}
+
+	private:
+		Starfield *m_starfield;
+		Uint32 m_serial;
+		Random m_rand;
+		bool m_hasPath;
+		SystemPath m_path;
+		RefCountedPtr<Galaxy> m_galaxy;
+		StarfieldParams m_params;
+		std::shared_ptr<StarfieldData> m_data;
+	};
+
+	StarfieldParams Starfield::GetParams() const
+	{
+		StarfieldParams params;
+		params.numStars = MathUtil::mix(BG_STAR_MIN, BG_STAR_MAX, Pi::GetAmountBackgroundStars());
+		// dividing by 7 to make sure that 100% star size isn't too big to clash with UI elements
+		params.brightnessFactor = Pi::GetStarFieldStarSizeFactor() / 7.0;
+		params.numSlices = std::min(Pi::GetApp()->GetTaskGraph()->GetNumWorkerThreads() + 1, 8U);
+		params.rMin = m_rMin;
+		params.rMax = m_rMax;
+		params.gMin = m_gMin;
+		params.gMax = m_gMax;
+		params.bMin = m_bMin;
+		params.bMax = m_bMax;
+		return params;
+	}
+
+	void Starfield::Fill(Random &rand, const SystemPath *const systemPath, RefCountedPtr<Galaxy> galaxy, Starfield *previous)
+	{
+		PROFILE_SCOPED()
+		const StarfieldParams params = GetParams();
+
+		{
+			Graphics::VertexBufferDesc vbd = VertexBufferDesc::FromAttribSet(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_DIFFUSE);
+			vbd.usage = Graphics::BUFFER_USAGE_DYNAMIC;
+			vbd.numVertices = NUM_HYPERSPACE_STARS * 2;
+			// this vertex buffer will be owned by the animMesh object
+			Graphics::VertexBuffer *vtxBuffer = m_renderer->CreateVertexBuffer(vbd);
+			m_animMesh.reset(m_renderer->CreateMeshObject(vtxBuffer));
+		}
+
+		assert(sizeof(StarVert) == 16);
+
+		// keep drawing the old stars until the new ones are ready
+		if (previous && previous != this) {
+			m_pointSprites = std::move(previous->m_pointSprites);
+			m_hyperVtx = std::move(previous->m_hyperVtx);
+			m_hyperCol = std::move(previous->m_hyperCol);
+		}
+
+		const Uint32 serial = ++m_fillSerial;
+
+		if (systemPath && galaxy.Valid()) {
+			std::shared_ptr<const StarfieldData> cached = find_cached_starfield(*systemPath, galaxy.Get(), params);
+			if (cached) {
+				SetData(*cached);
+				return;
+			}
+		}
+
+		if (!m_jobs)
+			m_jobs.reset(new JobSet(Pi::GetAsyncJobQueue()));
+		// the job gets its own generator, seeded from rand so the stars still
+		// only depend on how rand was seeded
+		m_jobs->Order(new FillJob(this, serial, rand.Int32(), systemPath, galaxy, params));
+	}
+
+	void Starfield::Prefetch(Random &rand, const SystemPath &systemPath, RefCountedPtr<Galaxy> galaxy)
+	{
+		PROFILE_SCOPED()
+		const StarfieldParams params = GetParams();
+		if (!galaxy.Valid() || find_cached_starfield(systemPath, galaxy.Get(), params))
+			return;
+
+		if (!m_jobs)
+			m_jobs.reset(new JobSet(Pi::GetAsyncJobQueue()));
+		// without a starfield the job only caches what it generates; it is
+		// dropped if this starfield goes first
+		m_jobs->Order(new FillJob(nullptr, 0, rand.Int32(), &systemPath, galaxy, params));
+	}
+
+	void Starfield::SetData(const StarfieldData &data)
+	{
+		PROFILE_SCOPED()
+		const StarInfo &stars = data.stars;
+
+		// fill a second set of point sprites and swap it in, the cached copy stays as it is
+		std::unique_ptr<Graphics::Drawables::PointSprites> pointSprites(new Graphics::Drawables::PointSprites);
+		pointSprites->SetData(stars.pos.size(), std::vector<vector3f>(stars.pos), std::vector<Color>(stars.color), std::vector<float>(stars.brightness));
+		m_pointSprites = std::move(pointSprites);
+
+		if (!m_hyperVtx) {
+			m_hyperVtx.reset(new vector3f[NUM_HYPERSPACE_STARS * 3]);
+			m_hyperCol.reset(new Color[NUM_HYPERSPACE_STARS * 3]);
+		}
+		for (uint32_t i = 0; i < NUM_HYPERSPACE_STARS; i++) {
+			m_hyperVtx[NUM_HYPERSPACE_STARS * 2 + i] = data.hyperVtx[i];
+			m_hyperCol[NUM_HYPERSPACE_STARS * 2 + i] = Color::WHITE * 0.8;
+		}
 	}
 
 	void Starfield::Draw()
@@ -593,8 +832,10 @@ namespace Background {
 		PROFILE_SCOPED()
 		// XXX would be nice to get rid of the Pi:: stuff here
 		if (!Pi::game || Pi::player->GetFlightState() != Ship::HYPERSPACE) {
-			m_pointSprites->Draw(m_renderer, m_material.Get());
-		} else {
+			// nothing until the first fill job is done
+			if (m_pointSprites)
+				m_pointSprites->Draw(m_renderer, m_material.Get());
+		} else if (m_hyperVtx) {
 			Graphics::VertexBuffer *buffer = m_animMesh->GetVertexBuffer();
 			assert(sizeof(StarVert) == 16);
 			assert(buffer->GetDesc().stride == sizeof(StarVert));
@@ -629,6 +870,18 @@ namespace Background {
 	{
 		m_renderer = renderer;
 
+		Graphics::MaterialDescriptor desc;
+		Graphics::RenderStateDesc stateDesc;
+		stateDesc.depthTest = false;
+		stateDesc.depthWrite = false;
+		stateDesc.primitiveType = Graphics::TRIANGLE_STRIP;
+		m_material.Reset(m_renderer->CreateMaterial("starfield", desc, stateDesc));
+		m_material->emissive = Color::WHITE;
+
+		m_meshObject = s_milkyWayMesh.lock();
+		if (m_meshObject)
+			return;
+
 		//build milky way model in two strips (about 256 verts)
 		std::unique_ptr<Graphics::VertexArray> bottom(new VertexArray(ATTRIB_POSITION | ATTRIB_DIFFUSE));
 		std::unique_ptr<Graphics::VertexArray> top(new VertexArray(ATTRIB_POSITION | ATTRIB_DIFFUSE));
@@ -670,14 +923,6 @@ namespace Background {
 			vector3f(100.0f * sin(theta), float(40.0 + 30.0 * noise(vector3d(sin(theta), -1.0, cos(theta)))), 100.0f * cos(theta)),
 			dark);
 
-		Graphics::MaterialDescriptor desc;
-		Graphics::RenderStateDesc stateDesc;
-		stateDesc.depthTest = false;
-		stateDesc.depthWrite = false;
-		stateDesc.primitiveType = Graphics::TRIANGLE_STRIP;
-		m_material.Reset(m_renderer->CreateMaterial("starfield", desc, stateDesc));
-		m_material->emissive = Color::WHITE;
-
 		Graphics::VertexBufferDesc vbd = VertexBufferDesc::FromAttribSet(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_DIFFUSE);
 		vbd.numVertices = bottom->GetNumVerts() + top->GetNumVerts();
 		vbd.usage = Graphics::BUFFER_USAGE_STATIC;
@@ -699,6 +944,7 @@ namespace Background {
 		vtxBuffer->Unmap();
 
 		m_meshObject.reset(m_renderer->CreateMeshObject(vtxBuffer));
+		s_milkyWayMesh = m_meshObject;
 	}
 
 	void MilkyWay::Draw()
@@ -708,14 +954,20 @@ namespace Background {
 		m_renderer->DrawMesh(m_meshObject.get(), m_material.Get());
 	}
 
-	Container::Container(Graphics::Renderer *renderer, Random &rand) :
+	Container::Container(Graphics::Renderer *renderer, Random &rand, const Container *previous) :
 		m_renderer(renderer),
 		m_milkyWay(renderer),
 		m_starField(renderer),
 		m_universeBox(renderer),
 		m_drawFlags(DRAW_SKYBOX | DRAW_STARS)
 	{
-		m_universeBox.LoadCubeMap(rand);
+		m_universeBox.LoadCubeMap(rand, previous ? &previous->m_universeBox : nullptr);
+	}
+
+	void Container::Prefetch(Random &rand, const SystemPath &systemPath, RefCountedPtr<Galaxy> galaxy)
+	{
+		m_universeBox.Prefetch(rand);
+		m_starField.Prefetch(rand, systemPath, galaxy);
 	}
 
 	void Container::Draw(const matrix4x4d &transform)
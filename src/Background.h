@@ -4,9 +4,13 @@
 #ifndef _BACKGROUND_H
 #define _BACKGROUND_H
 
+#include "JobQueue.h"
 #include "galaxy/SystemPath.h"
 #include "graphics/Drawables.h"
 
+#include <chrono>
+#include <memory>
+
 class Random;
 class Galaxy;
 class Space;
@@ -47,27 +51,58 @@ namespace Background {
 		~UniverseBox();
 
 		void Draw();
-		void LoadCubeMap(Random &rand);
+		void SetIntensity(float intensity);
+		// the cubemap is loaded in the background unless it already has been;
+		// until then the cubemap of previous (if given) is shown, and is then
+		// cross-faded to the new one
+		void LoadCubeMap(Random &rand, const UniverseBox *previous = nullptr);
+		// the cubemap LoadCubeMap would load, 0 for the default one
+		int PickCubeMap(Random &rand) const;
+		// starts loading the cubemap LoadCubeMap would pick with rand
+		void Prefetch(Random &rand);
 
 	private:
 		void Init();
+		Graphics::Texture *GetCubeMap(int index, bool async) const;
 
-		std::unique_ptr<Graphics::MeshObject> m_universeBox;
+		std::shared_ptr<Graphics::MeshObject> m_universeBox;
 		RefCountedPtr<Graphics::Texture> m_cubemap;
 
+		// the cubemap being faded out, drawn by m_material with the new one
+		// added on top by m_fadeMaterial
+		RefCountedPtr<Graphics::Texture> m_fadeFrom;
+		RefCountedPtr<Graphics::Material> m_fadeMaterial;
+		std::chrono::steady_clock::time_point m_fadeStart;
+		bool m_fading;
+		float m_intensity;
+
 		Uint32 m_numCubemaps;
 	};
 
+	struct StarfieldData;
+	struct StarfieldParams;
+
 	class Starfield : public BackgroundElement {
 	public:
 		//does not Fill the starfield
 		Starfield(Graphics::Renderer *r);
 		void Draw();
 		//create or recreate the starfield
-		void Fill(Random &rand, const SystemPath *const systemPath, RefCountedPtr<Galaxy> galaxy);
+		//stars are generated in a background job unless a recent fill for the
+		//same system is still cached; until the job is done the stars of
+		//previous (if given) are drawn instead
+		void Fill(Random &rand, const SystemPath *const systemPath, RefCountedPtr<Galaxy> galaxy, Starfield *previous = nullptr);
+		//generate the stars Fill would for systemPath (with rand seeded the
+		//same) in a background job and cache them, so the Fill only has to
+		//upload them
+		void Prefetch(Random &rand, const SystemPath &systemPath, RefCountedPtr<Galaxy> galaxy);
 
 	private:
+		class FillJob;
+
 		void Init();
+		void SetData(const StarfieldData &data);
+		StarfieldParams GetParams() const;
 
 		std::unique_ptr<Graphics::Drawables::PointSprites> m_pointSprites;
 
@@ -75,6 +110,10 @@ namespace Background {
 		std::unique_ptr<vector3f[]> m_hyperVtx; // BG_STAR_MAX * 3
 		std::unique_ptr<Color[]> m_hyperCol;	// BG_STAR_MAX * 3
 		std::unique_ptr<Graphics::MeshObject> m_animMesh;
+
+		// only the most recent Fill gets to set the stars
+		Uint32 m_fillSerial;
+		std::unique_ptr<JobSet> m_jobs;
 	};
 
 	class MilkyWay : public BackgroundElement {
@@ -83,7 +122,8 @@ namespace Background {
 		void Draw();
 
 	private:
-		std::unique_ptr<Graphics::MeshObject> m_meshObject;
+		// the same for every instance, so shared between them
+		std::shared_ptr<Graphics::MeshObject> m_meshObject;
 	};
 
 	// contains starfield, milkyway, possibly other Background elements
@@ -95,9 +135,14 @@ namespace Background {
 			DRAW_SKYBOX = 1 << 2
 		};
 
-		Container(Graphics::Renderer *, Random &rand);
+		// elements of previous (if given) stay visible while the new ones load
+		Container(Graphics::Renderer *, Random &rand, const Container *previous = nullptr);
 		void Draw(const matrix4x4d &transform);
 
+		// starts generating the stars a Container made with rand would have
+		// for systemPath, see Starfield::Prefetch
+		void Prefetch(Random &rand, const SystemPath &systemPath, RefCountedPtr<Galaxy> galaxy);
+
 		void SetIntensity(float intensity);
 		void SetDrawFlags(const Uint32 flags);
 		Uint32 GetDrawFlags() const { return m_drawFlags; }
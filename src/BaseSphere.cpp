@@ -3,8 +3,11 @@
 
 #include "BaseSphere.h"
 
+#include "AtmosphereLUT.h"
+#include "GameConfig.h"
 #include "GasGiant.h"
 #include "GeoSphere.h"
+#include "Pi.h"
 
 #include "galaxy/AtmosphereParameters.h"
 #include "galaxy/SystemBody.h"
@@ -127,3 +130,54 @@ void BaseSphere::SetMaterialParameters(const matrix4x4d &trans, const float radi
 		m_atmosphereMaterial->SetPushConstant(s_numShadows, int(shadows.size()));
 	}
 }
+
+// builds the tables off the main thread, and hands them to the sphere
+// unless it was destroyed first (which cancels the job)
+class BaseSphere::AtmosphereLUTJob : public Job {
+public:
+	AtmosphereLUTJob(BaseSphere *sphere, Graphics::Renderer *renderer, const AtmosphereParameters &ap) :
+		Job(PRIORITY_LOW),
+		m_sphere(sphere),
+		m_renderer(renderer),
+		m_params(ap)
+	{}
+
+	void OnRun() override
+	{
+		PROFILE_SCOPED()
+		m_lut.reset(new AtmosphereLUT(m_params));
+	}
+
+	void OnFinish() override
+	{
+		m_sphere->m_atmosphereLUT = std::move(m_lut);
+		m_sphere->BindAtmosphereLUT(m_renderer);
+	}
+
+private:
+	BaseSphere *m_sphere;
+	Graphics::Renderer *m_renderer;
+	AtmosphereParameters m_params;
+	std::unique_ptr<AtmosphereLUT> m_lut;
+};
+
+void BaseSphere::SetUpAtmosphereLUT(Graphics::Renderer *renderer, const AtmosphereParameters &ap)
+{
+	if (ap.atmosDensity <= 0.0 || !Pi::config->Int("AtmosphereLUT"))
+		return;
+
+	// the tables only depend on the body, so materials recreated later
+	// (e.g. for a new scattering option) reuse them
+	if (m_atmosphereLUT)
+		BindAtmosphereLUT(renderer);
+	else if (!m_atmosphereLUTJob.HasJob())
+		m_atmosphereLUTJob = Pi::GetAsyncJobQueue()->Queue(new AtmosphereLUTJob(this, renderer, ap));
+}
+
+void BaseSphere::BindAtmosphereLUT(Graphics::Renderer *renderer)
+{
+	if (m_surfaceMaterial.Valid())
+		m_atmosphereLUT->Bind(renderer, m_surfaceMaterial.Get());
+	if (m_atmosphereMaterial.Valid())
+		m_atmosphereLUT->Bind(renderer, m_atmosphereMaterial.Get());
+}
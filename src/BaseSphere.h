@@ -5,11 +5,14 @@
 #define _BASESPHERE_H
 
 #include "Camera.h"
+#include "JobQueue.h"
 #include "galaxy/AtmosphereParameters.h"
 #include "graphics/Material.h"
 #include "terrain/Terrain.h"
 #include "vector3.h"
 
+class AtmosphereLUT;
+
 namespace Graphics {
 	class Renderer;
 	class RenderState;
@@ -27,6 +30,11 @@ public:
 	virtual void Render(Graphics::Renderer *renderer, const matrix4x4d &modelView, vector3d campos, const float radius, const std::vector<Camera::Shadow> &shadows) = 0;
 
 	virtual double GetHeight(const vector3d &p) const { return 0.0; }
+	virtual void GetHeights(const vector3d *p, double *heights, size_t count) const
+	{
+		for (size_t i = 0; i < count; i++)
+			heights[i] = GetHeight(p[i]);
+	}
 
 	static void Init();
 	static void Uninit();
@@ -60,9 +68,21 @@ protected:
 
 	// set up shader data for this geosphere's atmosphere
 	void SetMaterialParameters(const matrix4x4d &t, const float r, const std::vector<Camera::Shadow> &s, const AtmosphereParameters &ap);
+	// binds the precomputed scattering tables to the surface and atmosphere
+	// materials, building them in a job on first use. No shader samples them
+	// yet, so this does nothing unless the AtmosphereLUT option is set.
+	void SetUpAtmosphereLUT(Graphics::Renderer *renderer, const AtmosphereParameters &ap);
+
+	std::unique_ptr<AtmosphereLUT> m_atmosphereLUT;
 
 	// atmosphere geometry
 	std::unique_ptr<Graphics::Drawables::Sphere3D> m_atmos;
+
+private:
+	class AtmosphereLUTJob;
+	void BindAtmosphereLUT(Graphics::Renderer *renderer);
+
+	Job::Handle m_atmosphereLUTJob;
 };
 
 #endif /* _GEOSPHERE_H */
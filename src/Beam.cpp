@@ -26,6 +26,8 @@
 #include "lua/LuaEvent.h"
 #include "lua/LuaUtils.h"
 
+#include <algorithm>
+
 namespace {
 	static float lifetime = 0.1f;
 }
@@ -34,6 +36,12 @@ std::unique_ptr<Graphics::MeshObject> Beam::s_sideMesh;
 std::unique_ptr<Graphics::MeshObject> Beam::s_glowMesh;
 std::unique_ptr<Graphics::Material> Beam::s_sideMat;
 std::unique_ptr<Graphics::Material> Beam::s_glowMat;
+std::vector<Beam *> Beam::s_queued;
+std::vector<vector3d> Beam::s_rayStarts;
+std::vector<vector3d> Beam::s_rayDirs;
+std::vector<double> Beam::s_rayLengths;
+std::vector<const Geom *> Beam::s_rayIgnore;
+std::vector<CollisionContact> Beam::s_contacts;
 
 void Beam::BuildModel()
 {
@@ -190,6 +198,8 @@ void Beam::PostLoadFixup(Space *space)
 {
 	Body::PostLoadFixup(space);
 	m_parent = space->GetBodyByIndex(m_parentIndex);
+	if (m_parent)
+		space->WatchBody(this, m_parent);
 }
 
 void Beam::UpdateInterpTransform(double alpha)
@@ -259,15 +269,60 @@ static void MiningLaserSpawnTastyStuff(FrameId fId, const SystemBody *asteroid,
 
 void Beam::StaticUpdate(const float timeStep)
 {
-	PROFILE_SCOPED()
 	// This is just to stop it from hitting things repeatedly, it's dead in effect but still rendered
 	if (!m_active)
 		return;
 
-	CollisionContact c;
+	s_queued.push_back(this);
+}
+
+void Beam::TraceQueued()
+{
+	PROFILE_SCOPED()
+	if (s_queued.empty())
+		return;
+
+	// a frame's rays are traced in one call; the order within a frame stays
+	std::stable_sort(s_queued.begin(), s_queued.end(), [](const Beam *a, const Beam *b) {
+		return a->GetFrame().id() < b->GetFrame().id();
+	});
+
+	for (size_t first = 0; first < s_queued.size();) {
+		const FrameId frameId = s_queued[first]->GetFrame();
+		size_t last = first + 1;
+		while (last < s_queued.size() && s_queued[last]->GetFrame() == frameId)
+			last++;
+
+		const size_t numRays = last - first;
+		s_rayStarts.resize(numRays);
+		s_rayDirs.resize(numRays);
+		s_rayLengths.resize(numRays);
+		s_rayIgnore.resize(numRays);
+		s_contacts.assign(numRays, CollisionContact());
+		for (size_t i = 0; i < numRays; i++) {
+			const Beam *beam = s_queued[first + i];
+			s_rayStarts[i] = beam->GetPosition();
+			s_rayDirs[i] = beam->m_dir.Normalized();
+			s_rayLengths[i] = beam->m_length;
+			// beams pass through the ship that fired them
+			Body *parent = beam->m_parent;
+			s_rayIgnore[i] = (parent && parent->IsType(ObjectType::MODELBODY)) ? static_cast<ModelBody *>(parent)->GetGeom() : nullptr;
+		}
+
+		Frame::GetFrame(frameId)->GetCollisionSpace()->TraceRays(numRays, s_rayStarts.data(), s_rayDirs.data(), s_rayLengths.data(), s_rayIgnore.data(), s_contacts.data());
+
+		for (size_t i = 0; i < numRays; i++)
+			s_queued[first + i]->ResolveHit(s_contacts[i]);
+
+		first = last;
+	}
+
+	s_queued.clear();
+}
 
+void Beam::ResolveHit(const CollisionContact &c)
+{
 	Frame *frame = Frame::GetFrame(GetFrame());
-	frame->GetCollisionSpace()->TraceRay(GetPosition(), m_dir.Normalized(), m_length, &c, static_cast<ModelBody *>(m_parent)->GetGeom());
 
 	if (c.userData1) {
 		Body *hit = static_cast<Body *>(c.userData1);
@@ -275,7 +330,7 @@ void Beam::StaticUpdate(const float timeStep)
 			hit->OnDamage(m_parent, GetDamage(), c);
 			m_active = false;
 			if (hit->IsType(ObjectType::SHIP))
-				LuaEvent::Queue("onShipHit", dynamic_cast<Ship *>(hit), dynamic_cast<Body *>(m_parent));
+				LuaEvent::QueueCoalesced("onShipHit", { hit, m_parent }, dynamic_cast<Ship *>(hit), dynamic_cast<Body *>(m_parent));
 		}
 	}
 
@@ -365,5 +420,8 @@ void Beam::Render(Graphics::Renderer *renderer, const Camera *camera, const vect
 void Beam::Add(Body *parent, const ProjectileData &prData, const vector3d &pos, const vector3d &baseVel, const vector3d &dir)
 {
 	Beam *p = new Beam(parent, prData, pos, baseVel, dir);
-	Pi::game->GetSpace()->AddBody(p);
+	Space *space = Pi::game->GetSpace();
+	space->AddBody(p);
+	if (parent)
+		space->WatchBody(p, parent);
 }
@@ -11,8 +11,12 @@
 #include "matrix4x4.h"
 #include "vector3.h"
 
+#include <vector>
+
 class Camera;
+class Geom;
 class Space;
+struct CollisionContact;
 
 namespace Graphics {
 	class Material;
@@ -41,12 +45,17 @@ public:
 
 	static void FreeModel();
 
+	// StaticUpdate() only queues a beam's ray; this traces every queued ray,
+	// each frame's together, and applies the hits
+	static void TraceQueued();
+
 protected:
 	virtual void SaveToJson(Json &jsonObj, Space *space) override final;
 
 private:
 	float GetDamage() const;
 	double GetRadius() const;
+	void ResolveHit(const CollisionContact &c);
 	Body *m_parent;
 	vector3d m_baseVel;
 	vector3d m_dir;
@@ -65,6 +74,14 @@ private:
 	static std::unique_ptr<Graphics::MeshObject> s_glowMesh;
 	static std::unique_ptr<Graphics::Material> s_sideMat;
 	static std::unique_ptr<Graphics::Material> s_glowMat;
+
+	static std::vector<Beam *> s_queued;
+	// TraceQueued() scratch space
+	static std::vector<vector3d> s_rayStarts;
+	static std::vector<vector3d> s_rayDirs;
+	static std::vector<double> s_rayLengths;
+	static std::vector<const Geom *> s_rayIgnore;
+	static std::vector<CollisionContact> s_contacts;
 };
 
 #endif /* _BEAM_H */
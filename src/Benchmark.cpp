@@ -0,0 +1,332 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "Benchmark.h"
+
+#include "BaseSphere.h"
+#include "Frame.h"
+#include "Game.h"
+#include "HeadlessGame.h"
+#include "MathUtil.h"
+#include "Pi.h"
+#include "Player.h"
+#include "ShipType.h"
+#include "Space.h"
+#include "SpaceStation.h"
+#include "WorldView.h"
+#include "buildopts.h"
+#include "core/FrameTimeline.h"
+#include "core/Log.h"
+#include "core/MemoryStats.h"
+#include "galaxy/Galaxy.h"
+#include "galaxy/GalaxyGenerator.h"
+#include "galaxy/StarSystem.h"
+#include "graphics/Renderer.h"
+#include "profiler/Profiler.h"
+#include "ship/PathCheckCache.h"
+
+#include "Json.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <numeric>
+
+namespace {
+	// Sol, Mars, Cydonia
+	const SystemPath CYDONIA(0, 0, 0, 0, 18);
+
+	const int BATTLE_SHIPS = 64;
+	// radius of the largest shell of sectors the galaxy scenario generates
+	const int GALAXY_RADIUS = 8;
+
+	// the body the player orbits when starting at the given body's parent
+	SystemPath GetParentBodyPath(const SystemPath &path)
+	{
+		RefCountedPtr<StarSystem> system = GalaxyGenerator::Create()->GetStarSystem(path);
+		const SystemBody *body = system->GetBodyByPath(path);
+		return body && body->GetParent() ? body->GetParent()->GetPath() : path;
+	}
+
+	void SetupBattle(Game *game)
+	{
+		std::vector<ShipType::Id> types = ShipType::player_ships;
+		if (types.empty())
+			return;
+		// the list is in load order, which the file system doesn't promise
+		std::sort(types.begin(), types.end());
+
+		Player *player = game->GetPlayer();
+		std::vector<Ship *> ships;
+		for (int i = 0; i < BATTLE_SHIPS; i++) {
+			Ship *ship = new Ship(types[i % types.size()]);
+			ship->SetFrame(player->GetFrame());
+			ship->SetPosition(player->GetPosition() + MathUtil::RandomPointOnSphere(5000.0, 20000.0));
+			ship->SetVelocity(player->GetVelocity());
+			game->GetSpace()->AddBody(ship);
+			ships.push_back(ship);
+		}
+
+		// each ship attacks the next, so the even ships fight the odd ones
+		for (size_t i = 0; i < ships.size(); i++)
+			ships[i]->AIKill(ships[(i + 1) % ships.size()]);
+	}
+
+	void SetupDescent(Game *game)
+	{
+		Body *station = game->GetSpace()->FindBodyForPath(&CYDONIA);
+		if (station && station->IsType(ObjectType::SPACESTATION))
+			game->GetPlayer()->AIDock(static_cast<SpaceStation *>(station));
+	}
+
+	void SetupTimeAccel(Game *game)
+	{
+		game->RequestTimeAccel(Game::TIMEACCEL_10000X, true);
+		game->SetTimeAccel(Game::TIMEACCEL_10000X);
+	}
+
+	// one shell of sectors further out each tick, as zooming out of the
+	// sector map does, starting over once the largest shell is done
+	void TickGalaxy(Game *game, uint32_t tick)
+	{
+		RefCountedPtr<Galaxy> galaxy = game->GetGalaxy();
+		const int r = int(tick % GALAXY_RADIUS) + 1;
+		for (int x = -r; x <= r; x++) {
+			for (int y = -r; y <= r; y++) {
+				for (int z = -r; z <= r; z++) {
+					if (std::max({ std::abs(x), std::abs(y), std::abs(z) }) == r)
+						galaxy->GetSector(SystemPath(x, y, z));
+				}
+			}
+		}
+	}
+
+	Json SummarizeMs(std::vector<double> values)
+	{
+		Json out = Json::object();
+		if (values.empty())
+			return out;
+
+		std::sort(values.begin(), values.end());
+		const double total = std::accumulate(values.begin(), values.end(), 0.0);
+		const auto percentile = [&](double p) {
+			return values[std::min(values.size() - 1, size_t(p * (values.size() - 1) + 0.5))];
+		};
+
+		out["totalMs"] = total;
+		out["meanMs"] = total / values.size();
+		out["minMs"] = values.front();
+		out["p50Ms"] = percentile(0.5);
+		out["p95Ms"] = percentile(0.95);
+		out["p99Ms"] = percentile(0.99);
+		out["maxMs"] = values.back();
+		return out;
+	}
+} // namespace
+
+struct Benchmark::Scenario {
+	const char *name;
+	const char *description;
+	// the player starts in orbit of this body's parent
+	SystemPath start;
+	std::function<void(Game *)> setup;
+	std::function<void(Game *, uint32_t)> tick;
+};
+
+// per tick, in milliseconds
+struct Benchmark::Timings {
+	struct ZoneSum {
+		double totalMs = 0.0;
+		double selfMs = 0.0;
+		uint64_t calls = 0;
+	};
+
+	double setupMs = 0.0;
+	std::vector<double> tick;
+	std::vector<double> scenario;
+	std::vector<double> physics;
+	std::vector<double> render;
+
+	// profiler zones of all ticks by name; empty without PIONEER_PROFILER
+	FrameTimeline timeline{ 1 };
+	std::map<std::string, ZoneSum> zones;
+};
+
+const std::vector<Benchmark::Scenario> &Benchmark::GetScenarioTable()
+{
+	static const std::vector<Scenario> s_scenarios = {
+		{ "battle", "ships fighting in two groups around the player, in orbit of Mars", CYDONIA, SetupBattle, nullptr },
+		{ "descent", "the player's autopilot flies from orbit of Mars down to Cydonia", CYDONIA, SetupDescent, nullptr },
+		{ "timeaccel", "orbit of Mars at 10000x time acceleration", CYDONIA, SetupTimeAccel, nullptr },
+		{ "galaxy", "generates sectors around Sol, further out each tick", CYDONIA, nullptr, TickGalaxy },
+	};
+	return s_scenarios;
+}
+
+const std::vector<Benchmark::ScenarioInfo> &Benchmark::GetScenarios()
+{
+	static std::vector<ScenarioInfo> s_info;
+	if (s_info.empty()) {
+		for (const Scenario &scenario : GetScenarioTable())
+			s_info.push_back({ scenario.name, scenario.description });
+	}
+	return s_info;
+}
+
+bool Benchmark::IsValidScenario(const std::string &name)
+{
+	if (name.compare(0, 5, "save:") == 0)
+		return name.size() > 5;
+
+	for (const Scenario &scenario : GetScenarioTable()) {
+		if (name == scenario.name)
+			return true;
+	}
+	return false;
+}
+
+Benchmark::Benchmark(const Settings &settings) :
+	m_settings(settings),
+	m_timings(new Timings())
+{
+	for (const Scenario &scenario : GetScenarioTable()) {
+		if (m_settings.scenario == scenario.name)
+			m_scenario = &scenario;
+	}
+}
+
+Benchmark::~Benchmark()
+{
+}
+
+void Benchmark::Start()
+{
+	PROFILE_SCOPED()
+	Profiler::Clock setupTimer;
+	setupTimer.SoftReset();
+
+	Game *game = m_scenario ?
+		HeadlessGame::CreateGame("Benchmark", GetParentBodyPath(m_scenario->start), std::string(), m_settings.seed) :
+		HeadlessGame::CreateGame("Benchmark", SystemPath(), m_settings.scenario.substr(5), m_settings.seed);
+	if (!game) {
+		m_failed = true;
+		return;
+	}
+	HeadlessGame::StartGame(game);
+
+	if (m_scenario && m_scenario->setup)
+		m_scenario->setup(game);
+
+	setupTimer.SoftStop();
+	m_timings->setupMs = setupTimer.milliseconds();
+	PathCheckCache::ResetStats();
+
+	Output("Benchmark: running %s for %u ticks (seed %u)\n", m_settings.scenario.c_str(), m_settings.ticks, m_settings.seed);
+}
+
+void Benchmark::Update(float deltaTime)
+{
+	PROFILE_SCOPED()
+	if (m_failed || m_tick >= m_settings.ticks)
+		return RequestEndLifecycle();
+
+	Game *game = Pi::game;
+	Profiler::Clock tickTimer, timer;
+	tickTimer.SoftReset();
+
+	timer.SoftReset();
+	if (m_scenario && m_scenario->tick)
+		m_scenario->tick(game, m_tick);
+	timer.SoftStop();
+	m_timings->scenario.push_back(timer.milliseconds());
+
+	timer.SoftReset();
+	{
+		PROFILE_SCOPED_RAW("Benchmark Physics")
+		// one fixed step per tick, whatever the frame took
+		game->TimeStep(game->GetTimeStep());
+		BaseSphere::UpdateAllBaseSphereDerivatives();
+	}
+	timer.SoftStop();
+	m_timings->physics.push_back(timer.milliseconds());
+
+	if (m_settings.render && Pi::GetView()) {
+		PROFILE_SCOPED_RAW("Benchmark Render")
+		timer.SoftReset();
+		game->GetSpace()->UpdateInterpTransforms(1.0);
+
+		Pi::GetView()->Update();
+		Pi::GetApp()->BeginScene();
+		Pi::GetView()->Draw3D();
+		Pi::GetApp()->EndScene();
+		Pi::renderer->FlushCommandBuffers();
+		timer.SoftStop();
+		m_timings->render.push_back(timer.milliseconds());
+	}
+
+	tickTimer.SoftStop();
+	m_timings->tick.push_back(tickTimer.milliseconds());
+
+	m_timings->timeline.RecordFrame(tickTimer.milliseconds());
+	for (const FrameTimeline::ZoneTotal &total : FrameTimeline::Aggregate(m_timings->timeline.GetFrame(0))) {
+		Timings::ZoneSum &sum = m_timings->zones[total.name];
+		sum.totalMs += total.totalMs;
+		sum.selfMs += total.selfMs;
+		sum.calls += total.calls;
+	}
+
+	if (++m_tick >= m_settings.ticks)
+		RequestEndLifecycle();
+}
+
+void Benchmark::End()
+{
+	if (!m_failed)
+		WriteReport();
+
+	HeadlessGame::EndGame();
+}
+
+void Benchmark::WriteReport()
+{
+	Json report = Json::object();
+	report["version"] = PIONEER_VERSION;
+	report["scenario"] = m_settings.scenario;
+	report["ticks"] = m_tick;
+	report["seed"] = m_settings.seed;
+	report["renderer"] = Pi::renderer->GetName();
+	report["setupMs"] = m_timings->setupMs;
+	report["gameTime"] = Pi::game->GetTime();
+	report["bodies"] = Pi::game->GetSpace()->GetNumBodies();
+	report["tick"] = SummarizeMs(m_timings->tick);
+
+	Json subsystems = Json::object();
+	subsystems["scenario"] = SummarizeMs(m_timings->scenario);
+	subsystems["physics"] = SummarizeMs(m_timings->physics);
+	if (m_settings.render)
+		subsystems["render"] = SummarizeMs(m_timings->render);
+	report["subsystems"] = std::move(subsystems);
+
+	std::vector<std::pair<std::string, Timings::ZoneSum>> zones(m_timings->zones.begin(), m_timings->zones.end());
+	std::sort(zones.begin(), zones.end(), [](const auto &a, const auto &b) {
+		return a.second.totalMs > b.second.totalMs;
+	});
+
+	Json zoneArray = Json::array();
+	for (const auto &zone : zones) {
+		Json entry = Json::object();
+		entry["name"] = zone.first;
+		entry["totalMs"] = zone.second.totalMs;
+		entry["selfMs"] = zone.second.selfMs;
+		entry["calls"] = zone.second.calls;
+		zoneArray.push_back(std::move(entry));
+	}
+	report["zones"] = std::move(zoneArray);
+	report["memory"] = MemoryStats::ToJson();
+
+	const PathCheckCache::Stats pathChecks = PathCheckCache::GetStats();
+	report["aiPathChecks"] = { { "checks", pathChecks.checks }, { "saved", pathChecks.saved } };
+
+	HeadlessGame::WriteReport("Benchmark", report, m_settings.outputFile);
+}
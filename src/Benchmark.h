@@ -0,0 +1,67 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#pragma once
+
+#include "core/Application.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+ * Runs a scenario for a fixed number of physics ticks and writes how long
+ * each part of a tick took as JSON, for tracking performance between
+ * builds. It takes the place of the main menu once loading is done (see
+ * "pioneer -benchmark") and pioneer exits when it ends.
+ *
+ * Every tick is a single fixed step, whatever the frame time was, and the
+ * game's random number generator is seeded with a fixed seed before the
+ * scenario starts, so the simulated work is the same from run to run.
+ * Work finished by worker threads (terrain patches, for one) can still land
+ * on different ticks.
+ */
+class Benchmark : public Application::Lifecycle {
+public:
+	struct Settings {
+		std::string scenario; // a built-in scenario or "save:<name>"
+		uint32_t ticks = 1000;
+		uint32_t seed = 1; // 0 keeps the time-based seed
+		// draw the views each tick; on the dummy renderer this measures
+		// the CPU side of drawing only
+		bool render = true;
+		std::string outputFile; // "-" for stdout
+	};
+
+	struct ScenarioInfo {
+		const char *name;
+		const char *description;
+	};
+
+	static const std::vector<ScenarioInfo> &GetScenarios();
+	// true if the name is a built-in scenario or names a save
+	static bool IsValidScenario(const std::string &name);
+
+	explicit Benchmark(const Settings &settings);
+	~Benchmark();
+
+protected:
+	void Start() override;
+	void Update(float deltaTime) override;
+	void End() override;
+
+private:
+	struct Scenario;
+	struct Timings;
+
+	static const std::vector<Scenario> &GetScenarioTable();
+
+	void WriteReport();
+
+	Settings m_settings;
+	const Scenario *m_scenario = nullptr;
+	std::unique_ptr<Timings> m_timings;
+	uint32_t m_tick = 0;
+	bool m_failed = false;
+};
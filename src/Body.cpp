@@ -3,6 +3,7 @@
 
 #include "Body.h"
 
+#include "Beam.h"
 #include "BodyComponent.h"
 #include "CargoBody.h"
 #include "Frame.h"
@@ -12,7 +13,6 @@
 #include "Missile.h"
 #include "Planet.h"
 #include "Player.h"
-#include "Projectile.h"
 #include "Ship.h"
 #include "Space.h"
 #include "SpaceStation.h"
@@ -171,7 +171,7 @@ Body *Body::FromJson(const Json &jsonObj, Space *space)
 		body = new Missile(jsonObj, space);
 		break;
 	case ObjectType::PROJECTILE:
-		body = new Projectile(jsonObj, space);
+		body = new Beam(jsonObj, space);
 		break;
 	case ObjectType::CARGOBODY:
 		body = new CargoBody(jsonObj, space);
@@ -200,8 +200,13 @@ Body *Body::FromJson(const Json &jsonObj, Space *space)
 	return body;
 }
 
+// The frames keep their transforms relative to the root frame, so there's
+// no hierarchy to walk, but most queries are between bodies sharing a frame
+// and don't need the transform at all.
+
 vector3d Body::GetPositionRelTo(FrameId relToId) const
 {
+	if (m_frame == relToId) return GetPosition();
 	Frame *frame = Frame::GetFrame(m_frame);
 
 	vector3d fpos = frame->GetPositionRelTo(relToId);
@@ -211,6 +216,7 @@ vector3d Body::GetPositionRelTo(FrameId relToId) const
 
 vector3d Body::GetInterpPositionRelTo(FrameId relToId) const
 {
+	if (m_frame == relToId) return GetInterpPosition();
 	Frame *frame = Frame::GetFrame(m_frame);
 
 	vector3d fpos = frame->GetInterpPositionRelTo(relToId);
@@ -230,6 +236,7 @@ vector3d Body::GetInterpPositionRelTo(const Body *relTo) const
 
 matrix3x3d Body::GetOrientRelTo(FrameId relToId) const
 {
+	if (m_frame == relToId) return GetOrient();
 	Frame *frame = Frame::GetFrame(m_frame);
 
 	matrix3x3d forient = frame->GetOrientRelTo(relToId);
@@ -238,6 +245,7 @@ matrix3x3d Body::GetOrientRelTo(FrameId relToId) const
 
 matrix3x3d Body::GetInterpOrientRelTo(FrameId relToId) const
 {
+	if (m_frame == relToId) return GetInterpOrient();
 	Frame *frame = Frame::GetFrame(m_frame);
 
 	matrix3x3d forient = frame->GetInterpOrientRelTo(relToId);
@@ -246,11 +254,11 @@ matrix3x3d Body::GetInterpOrientRelTo(FrameId relToId) const
 
 vector3d Body::GetVelocityRelTo(FrameId relToId) const
 {
+	if (m_frame == relToId) return GetVelocity();
 	Frame *frame = Frame::GetFrame(m_frame);
 
 	matrix3x3d forient = frame->GetOrientRelTo(relToId);
-	vector3d vel = GetVelocity();
-	if (m_frame != relToId) vel -= frame->GetStasisVelocity(GetPosition());
+	vector3d vel = GetVelocity() - frame->GetStasisVelocity(GetPosition());
 	return forient * vel + frame->GetVelocityRelTo(relToId);
 }
 
@@ -310,7 +318,7 @@ void Body::SwitchToFrame(FrameId newFrameId)
 	SetVelocity(vel + newFrame->GetStasisVelocity(GetPosition()));
 	SetFrame(newFrameId);
 
-	LuaEvent::Queue("onFrameChanged", this);
+	LuaEvent::QueueCoalesced("onFrameChanged", { this }, this);
 }
 
 void Body::UpdateFrame()
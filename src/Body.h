@@ -98,8 +98,17 @@ public:
 	virtual bool OnCollision(Body *o, Uint32 flags, double relVel) { return false; }
 	// Attacker may be null
 	virtual bool OnDamage(Body *attacker, float kgDamage, const CollisionContact &contactData) { return false; }
-	// Override to clear any pointers you hold to the body
+	// Override to clear any pointers you hold to the body. Only called for
+	// bodies registered with Space::WatchBody(), unless WantsAllRemovals()
 	virtual void NotifyRemoved(const Body *const removedBody) {}
+	// Return true to be notified of every body leaving space
+	virtual bool WantsAllRemovals() const { return false; }
+
+	// Called for every body, possibly in parallel, before any has had
+	// TimeStepUpdate(). Only for work which touches nothing but this body
+	// and reads nothing which changes during the step: no adding or removing
+	// bodies, queueing Lua events or drawing random numbers.
+	virtual void IntegrateMotion(const float timeStep) {}
 
 	// before all bodies have had TimeStepUpdate (their moving step),
 	// StaticUpdate() is called. Good for special collision testing (Projectiles)
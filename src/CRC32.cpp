@@ -3,40 +3,242 @@
 
 #include "CRC32.h"
 
-const Uint32 CRC32::s_polynomial = 0x04c11db7;
+#include <cstdint>
+#include <cstring>
 
-bool CRC32::s_lookupTableGenerated;
-Uint32 CRC32::s_lookupTable[256];
+// SSE4.2's crc32 instruction uses the Castagnoli polynomial, so on x86 the
+// IEEE checksum is folded with carry-less multiplies instead
+#if (defined(__GNUC__) || defined(_MSC_VER)) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+#define CRC32_PCLMUL 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define CRC32_TARGET_PCLMUL
+#else
+#define CRC32_TARGET_PCLMUL __attribute__((target("pclmul,sse4.1")))
+#endif
+#elif defined(__ARM_FEATURE_CRC32) || (defined(__aarch64__) && defined(__linux__) && defined(__GNUC__))
+#define CRC32_ARMV8 1
+#include <arm_acle.h>
+#if defined(__ARM_FEATURE_CRC32)
+#define CRC32_TARGET_ARMV8
+#else
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#if defined(__clang__)
+#define CRC32_TARGET_ARMV8 __attribute__((target("crc")))
+#else
+#define CRC32_TARGET_ARMV8 __attribute__((target("+crc")))
+#endif
+#endif
+#endif
 
-static Uint32 crc32_reflect(Uint32 v, const int bits)
-{
-	Uint32 r = 0;
-	for (int i = 1; i <= bits; i++) {
-		if (v & 1)
-			r = r | (1 << (bits - i));
-		v >>= 1;
+namespace {
+	// 0x04c11db7 bit reversed, as the checksum is computed least significant bit first
+	static const Uint32 POLYNOMIAL = 0xedb88320;
+
+	// table[0] advances the checksum by one byte; table[k] by a byte
+	// followed by k zero bytes, so eight bytes can be looked up at once
+	struct Tables {
+		Uint32 table[8][256];
+
+		Tables()
+		{
+			for (Uint32 i = 0; i < 256; i++) {
+				Uint32 crc = i;
+				for (int j = 0; j < 8; j++)
+					crc = (crc >> 1) ^ (crc & 1 ? POLYNOMIAL : 0);
+				table[0][i] = crc;
+			}
+			for (int k = 1; k < 8; k++)
+				for (int i = 0; i < 256; i++)
+					table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xff];
+		}
+	};
+
+	const Tables &GetTables()
+	{
+		static const Tables tables;
+		return tables;
 	}
-	return r;
-}
+
+	inline Uint32 LoadLE32(const unsigned char *p)
+	{
+		return Uint32(p[0]) | Uint32(p[1]) << 8 | Uint32(p[2]) << 16 | Uint32(p[3]) << 24;
+	}
+
+	Uint32 UpdateBytewise(Uint32 crc, const unsigned char *buf, size_t length)
+	{
+		const Tables &t = GetTables();
+		while (length--)
+			crc = (crc >> 8) ^ t.table[0][(crc & 0xff) ^ *buf++];
+		return crc;
+	}
+
+	Uint32 UpdateSliceBy8(Uint32 crc, const unsigned char *buf, size_t length)
+	{
+		const Tables &t = GetTables();
+		for (; length >= 8; length -= 8, buf += 8) {
+			const Uint32 lo = LoadLE32(buf) ^ crc;
+			const Uint32 hi = LoadLE32(buf + 4);
+			crc = t.table[7][lo & 0xff] ^ t.table[6][(lo >> 8) & 0xff] ^
+				t.table[5][(lo >> 16) & 0xff] ^ t.table[4][lo >> 24] ^
+				t.table[3][hi & 0xff] ^ t.table[2][(hi >> 8) & 0xff] ^
+				t.table[1][(hi >> 16) & 0xff] ^ t.table[0][hi >> 24];
+		}
+		return UpdateBytewise(crc, buf, length);
+	}
+
+#if defined(CRC32_PCLMUL)
+	bool HasPCLMUL()
+	{
+#if defined(_MSC_VER) && !defined(__clang__)
+		int info[4];
+		__cpuid(info, 1);
+		return (info[2] & (1 << 1)) && (info[2] & (1 << 19));
+#else
+		return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+#endif
+	}
+
+	// Folds acc forward over the 128 bits of next
+	CRC32_TARGET_PCLMUL inline __m128i Fold128(__m128i acc, __m128i next, __m128i k)
+	{
+		const __m128i lo = _mm_clmulepi64_si128(acc, k, 0x00);
+		return _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(acc, k, 0x11), next), lo);
+	}
+
+	// Folds 64 bytes at a time in four lanes, then folds the lanes and any
+	// remaining 16 byte blocks into one, and finally reduces that to 32 bits.
+	// The constants are powers of x modulo the polynomial, from Intel's "Fast
+	// CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction".
+	CRC32_TARGET_PCLMUL Uint32 FoldPCLMUL(Uint32 crc, const unsigned char *buf, size_t length)
+	{
+		alignas(16) static const uint64_t k1k2[] = { 0x0154442bd4, 0x01c6e41596 };
+		alignas(16) static const uint64_t k3k4[] = { 0x01751997d0, 0x00ccaa009e };
+		alignas(16) static const uint64_t k5k0[] = { 0x0163cd6124, 0x0000000000 };
+		alignas(16) static const uint64_t poly[] = { 0x01db710641, 0x01f7011641 };
+
+		__m128i x1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf));
+		__m128i x2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf + 16));
+		__m128i x3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf + 32));
+		__m128i x4 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf + 48));
+		x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(int(crc)));
+		buf += 64;
+		length -= 64;
+
+		__m128i k = _mm_load_si128(reinterpret_cast<const __m128i *>(k1k2));
+		for (; length >= 64; length -= 64, buf += 64) {
+			const __m128i x5 = _mm_clmulepi64_si128(x1, k, 0x00);
+			const __m128i x6 = _mm_clmulepi64_si128(x2, k, 0x00);
+			const __m128i x7 = _mm_clmulepi64_si128(x3, k, 0x00);
+			const __m128i x8 = _mm_clmulepi64_si128(x4, k, 0x00);
+			x1 = _mm_xor_si128(_mm_clmulepi64_si128(x1, k, 0x11), x5);
+			x2 = _mm_xor_si128(_mm_clmulepi64_si128(x2, k, 0x11), x6);
+			x3 = _mm_xor_si128(_mm_clmulepi64_si128(x3, k, 0x11), x7);
+			x4 = _mm_xor_si128(_mm_clmulepi64_si128(x4, k, 0x11), x8);
+			x1 = _mm_xor_si128(x1, _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf)));
+			x2 = _mm_xor_si128(x2, _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf + 16)));
+			x3 = _mm_xor_si128(x3, _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf + 32)));
+			x4 = _mm_xor_si128(x4, _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf + 48)));
+		}
+
+		k = _mm_load_si128(reinterpret_cast<const __m128i *>(k3k4));
+		x1 = Fold128(x1, x2, k);
+		x1 = Fold128(x1, x3, k);
+		x1 = Fold128(x1, x4, k);
+		for (; length >= 16; length -= 16, buf += 16)
+			x1 = Fold128(x1, _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf)), k);
+
+		// 128 bits to 64
+		const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+		x2 = _mm_clmulepi64_si128(x1, k, 0x10);
+		x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+		k = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(k5k0));
+		x2 = _mm_srli_si128(x1, 4);
+		x1 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), k, 0x00);
+		x1 = _mm_xor_si128(x1, x2);
+
+		// Barrett reduction to 32 bits
+		k = _mm_load_si128(reinterpret_cast<const __m128i *>(poly));
+		x2 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), k, 0x10);
+		x2 = _mm_clmulepi64_si128(_mm_and_si128(x2, mask32), k, 0x00);
+		x1 = _mm_xor_si128(x1, x2);
+		return Uint32(_mm_extract_epi32(x1, 1));
+	}
+
+	Uint32 UpdatePCLMUL(Uint32 crc, const unsigned char *buf, size_t length)
+	{
+		if (length >= 64) {
+			const size_t blocks = length & ~size_t(15);
+			crc = FoldPCLMUL(crc, buf, blocks);
+			buf += blocks;
+			length -= blocks;
+		}
+		return UpdateSliceBy8(crc, buf, length);
+	}
+#endif
+
+#if defined(CRC32_ARMV8)
+	bool HasARMv8CRC()
+	{
+#if defined(__ARM_FEATURE_CRC32)
+		return true;
+#else
+		return getauxval(AT_HWCAP) & HWCAP_CRC32;
+#endif
+	}
+
+	CRC32_TARGET_ARMV8 Uint32 UpdateARMv8(Uint32 crc, const unsigned char *buf, size_t length)
+	{
+		for (; length >= 8; length -= 8, buf += 8) {
+			uint64_t v;
+			memcpy(&v, buf, sizeof(v));
+			crc = __crc32d(crc, v);
+		}
+		while (length--)
+			crc = __crc32b(crc, *buf++);
+		return crc;
+	}
+#endif
+
+	struct Implementation {
+		Uint32 (*update)(Uint32 crc, const unsigned char *buf, size_t length);
+		const char *name;
+	};
+
+	const Implementation &GetImplementation()
+	{
+		static const Implementation impl = []() -> Implementation {
+#if defined(CRC32_PCLMUL)
+			if (HasPCLMUL())
+				return { UpdatePCLMUL, "PCLMUL" };
+#elif defined(CRC32_ARMV8)
+			if (HasARMv8CRC())
+				return { UpdateARMv8, "ARMv8 CRC32" };
+#endif
+			return { UpdateSliceBy8, "slice-by-8" };
+		}();
+		return impl;
+	}
+} // namespace
 
 CRC32::CRC32() :
 	m_checksum(0xffffffff)
 {
-	if (!s_lookupTableGenerated) {
-		for (int i = 0; i <= 0xff; i++) {
-			s_lookupTable[i] = crc32_reflect(i, 8) << 24;
-			for (int j = 0; j < 8; j++)
-				s_lookupTable[i] = (s_lookupTable[i] << 1) ^ (s_lookupTable[i] & (1 << 31) ? s_polynomial : 0);
-			s_lookupTable[i] = crc32_reflect(s_lookupTable[i], 32);
-		}
+}
 
-		s_lookupTableGenerated = true;
-	}
+void CRC32::AddData(const char *data, size_t length)
+{
+	m_checksum = GetImplementation().update(m_checksum, reinterpret_cast<const unsigned char *>(data), length);
+}
+
+void CRC32::AddDataBytewise(const char *data, size_t length)
+{
+	m_checksum = UpdateBytewise(m_checksum, reinterpret_cast<const unsigned char *>(data), length);
 }
 
-void CRC32::AddData(const char *data, int length)
+const char *CRC32::GetImplementationName()
 {
-	const unsigned char *buf = reinterpret_cast<const unsigned char *>(data);
-	while (length--)
-		m_checksum = (m_checksum >> 8) ^ s_lookupTable[(m_checksum & 0xff) ^ *buf++];
+	return GetImplementation().name;
 }
@@ -5,20 +5,29 @@
 #define _CRC32_H
 
 #include <SDL_stdinc.h>
+#include <cstddef>
 
+// CRC-32 with the IEEE 802.3 polynomial. GetChecksum() returns the running
+// register, which starts at 0xffffffff and is not inverted at the end.
+//
+// Where the CPU has them, the carry-less multiply instructions (x86) or the
+// CRC32 instructions (ARMv8) are used, picked once at runtime; otherwise a
+// slice-by-8 table does eight bytes per step. All give the same checksum.
 class CRC32 {
 public:
 	CRC32();
 
-	void AddData(const char *data, int length);
+	void AddData(const char *data, size_t length);
 	Uint32 GetChecksum() const { return m_checksum; }
 
+	// Byte at a time through the table, as a reference for the faster paths
+	void AddDataBytewise(const char *data, size_t length);
+
+	// Name of the implementation AddData() uses, for logging and benchmarks
+	static const char *GetImplementationName();
+
 private:
 	Uint32 m_checksum;
-
-	static const Uint32 s_polynomial;
-	static bool s_lookupTableGenerated;
-	static Uint32 s_lookupTable[256];
 };
 
 #endif
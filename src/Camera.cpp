@@ -6,15 +6,22 @@
 #include "Body.h"
 #include "Frame.h"
 #include "Game.h"
+#include "GameConfig.h"
+#include "ModelBody.h"
+#include "NavLights.h"
 #include "Pi.h"
 #include "Planet.h"
 #include "Player.h"
+#include "Projectile.h"
 #include "Sfx.h"
 #include "Space.h"
+#include "SpaceStation.h"
+#include "core/TaskGraph.h"
 #include "galaxy/StarSystem.h"
 #include "graphics/TextureBuilder.h"
 #include "graphics/Types.h"
 #include "graphics/RenderState.h"
+#include "scenegraph/Model.h"
 
 using namespace Graphics;
 
@@ -24,6 +31,12 @@ static const float OBJECT_HIDDEN_PIXEL_THRESHOLD = 2.0f;
 // if a terrain object would render smaller than this many pixels, draw a billboard instead
 static const float BILLBOARD_PIXEL_THRESHOLD = 8.0f;
 
+// bodies per task when culling and lighting them
+static const uint32_t BODY_VISIBILITY_GRAIN_SIZE = 32;
+
+// visible models per task when interpolating their animations
+static const uint32_t MODEL_ANIMATION_GRAIN_SIZE = 8;
+
 CameraContext::CameraContext(float width, float height, float fovAng, float zNear, float zFar) :
 	m_width(width),
 	m_height(height),
@@ -105,7 +118,8 @@ bool Camera::BodyAttrs::sort_BodyAttrs(const BodyAttrs &a, const BodyAttrs &b)
 
 Camera::Camera(RefCountedPtr<CameraContext> context, Graphics::Renderer *renderer) :
 	m_context(context),
-	m_renderer(renderer)
+	m_renderer(renderer),
+	m_shadowFrame(FrameId::Invalid)
 {
 	Graphics::MaterialDescriptor desc;
 	desc.textures = 1;
@@ -118,6 +132,18 @@ Camera::Camera(RefCountedPtr<CameraContext> context, Graphics::Renderer *rendere
 	m_billboardMaterial.reset(m_renderer->CreateMaterial("billboards", desc, rsd));
 	m_billboardMaterial->SetTexture("texture0"_hash,
 		Graphics::TextureBuilder::Billboard("textures/planet_billboard.dds").GetOrCreateTexture(m_renderer, "billboard"));
+
+	const int numCascades = Pi::config->Int("ShadowCascades");
+	if (numCascades > 0) {
+		Graphics::ShadowCascades::Settings settings;
+		settings.numCascades = numCascades;
+		settings.mapSize = Clamp(Pi::config->Int("ShadowMapSize"), 256, 4096);
+		settings.maxDistance = Pi::config->Float("ShadowDistance");
+		settings.firstStaticCascade = std::max(numCascades - Pi::config->Int("ShadowStaticCascades"), 0);
+		settings.staticRedrawBudget = std::max(Pi::config->Int("ShadowStaticRedraws"), 0);
+		m_shadowCascades.reset(new Graphics::ShadowCascades(settings));
+		m_shadowCascades->CreateTargets(m_renderer);
+	}
 }
 
 static void position_system_lights(Frame *camFrame, Frame *frame, std::vector<Camera::LightSource> &lights)
@@ -144,87 +170,172 @@ static void position_system_lights(Frame *camFrame, Frame *frame, std::vector<Ca
 	}
 }
 
-void Camera::Update()
+// Models don't share animated nodes, so each can be interpolated on its own thread
+static void update_model_animations(const std::vector<SceneGraph::Model *> &models)
 {
-	FrameId camFrame = m_context->GetTempFrame();
+	PROFILE_SCOPED()
+	TaskGraph *taskGraph = Pi::GetApp()->GetTaskGraph();
+	if (!taskGraph || models.size() <= MODEL_ANIMATION_GRAIN_SIZE) {
+		for (SceneGraph::Model *model : models)
+			model->UpdatePendingAnimations();
+		return;
+	}
 
-	// evaluate each body and determine if/where/how to draw it
-	m_sortedBodies.clear();
-	for (Body *b : Pi::game->GetSpace()->GetBodies()) {
-		BodyAttrs attrs;
-		attrs.body = b;
-		attrs.billboard = false; // false by default
+	taskGraph->ParallelFor({ 0, uint32_t(models.size()) }, MODEL_ANIMATION_GRAIN_SIZE, [&](TaskRange range) {
+		for (uint32_t idx = range.begin; idx < range.end; idx++)
+			models[idx]->UpdatePendingAnimations();
+	});
+}
 
-		// If the body wishes to be excluded from the draw, skip it.
-		if (b->GetFlags() & Body::FLAG_DRAW_EXCLUDE)
-			continue;
+// Works out where and how a body would be drawn, and how it is lit. Only
+// reads the bodies, frames and lights, so bodies can be evaluated in parallel
+bool Camera::EvaluateBody(BodyAttrs &attrs, FrameId camFrame) const
+{
+	Body *b = attrs.body;
+	attrs.billboard = false; // false by default
+	attrs.calcAtmosphereLighting = false;
+
+	// determine position and transform for draw
+	//		Frame::GetFrameTransform(b->GetFrame(), camFrame, attrs.viewTransform);		// doesn't use interp coords, so breaks in some cases
+	Frame *f = Frame::GetFrame(b->GetFrame());
+	attrs.viewTransform = f->GetInterpOrientRelTo(camFrame);
+	attrs.viewTransform.SetTranslate(f->GetInterpPositionRelTo(camFrame));
+	attrs.viewCoords = attrs.viewTransform * b->GetInterpPosition();
+
+	// cull off-screen objects
+	double rad = b->GetClipRadius();
+	if (!m_context->GetFrustum().TestPointInfinite(attrs.viewCoords, rad))
+		return false;
 
-		// determine position and transform for draw
-		//		Frame::GetFrameTransform(b->GetFrame(), camFrame, attrs.viewTransform);		// doesn't use interp coords, so breaks in some cases
-		Frame *f = Frame::GetFrame(b->GetFrame());
-		attrs.viewTransform = f->GetInterpOrientRelTo(camFrame);
-		attrs.viewTransform.SetTranslate(f->GetInterpPositionRelTo(camFrame));
-		attrs.viewCoords = attrs.viewTransform * b->GetInterpPosition();
+	attrs.camDist = attrs.viewCoords.Length();
+	attrs.bodyFlags = b->GetFlags();
+
+	// approximate pixel width (disc diameter) of body on screen
+	const float pixSize = Graphics::GetScreenHeight() * 2.0 * rad / (attrs.camDist * Graphics::GetFovFactor());
+
+	// terrain objects are visible from distance but might not have any discernable features
+	if (b->IsType(ObjectType::TERRAINBODY)) {
+		if (pixSize < BILLBOARD_PIXEL_THRESHOLD) {
+			attrs.billboard = true;
+
+			// project the position
+			vector3d pos;
+			m_context->GetFrustum().TranslatePoint(attrs.viewCoords, pos);
+			attrs.billboardPos = vector3f(pos);
+
+			// limit the minimum billboard size for planets so they're always a little visible
+			attrs.billboardSize = std::max(1.0f, pixSize);
+			if (b->IsType(ObjectType::STAR)) {
+				attrs.billboardColor = StarSystem::starRealColors[b->GetSystemBody()->GetType()];
+			} else if (b->IsType(ObjectType::PLANET)) {
+				// XXX this should incorporate some lighting effect
+				// (ie, colour of the illuminating star(s))
+				attrs.billboardColor = b->GetSystemBody()->GetAlbedo();
+			} else {
+				attrs.billboardColor = Color::WHITE;
+			}
 
-		// cull off-screen objects
-		double rad = b->GetClipRadius();
-		if (!m_context->GetFrustum().TestPointInfinite(attrs.viewCoords, rad))
-			continue;
+			// this should always be the main star in the system - except for the star itself!
+			if (!m_lightSources.empty() && !b->IsType(ObjectType::STAR)) {
+				const Graphics::Light &light = m_lightSources[0].GetLight();
+				attrs.billboardColor *= light.GetDiffuse(); // colour the billboard a little with the Starlight
+			}
 
-		attrs.camDist = attrs.viewCoords.Length();
-		attrs.bodyFlags = b->GetFlags();
-
-		// approximate pixel width (disc diameter) of body on screen
-		const float pixSize = Graphics::GetScreenHeight() * 2.0 * rad / (attrs.camDist * Graphics::GetFovFactor());
-
-		// terrain objects are visible from distance but might not have any discernable features
-		if (b->IsType(ObjectType::TERRAINBODY)) {
-			if (pixSize < BILLBOARD_PIXEL_THRESHOLD) {
-				attrs.billboard = true;
-
-				// project the position
-				vector3d pos;
-				m_context->GetFrustum().TranslatePoint(attrs.viewCoords, pos);
-				attrs.billboardPos = vector3f(pos);
-
-				// limit the minimum billboard size for planets so they're always a little visible
-				attrs.billboardSize = std::max(1.0f, pixSize);
-				if (b->IsType(ObjectType::STAR)) {
-					attrs.billboardColor = StarSystem::starRealColors[b->GetSystemBody()->GetType()];
-				} else if (b->IsType(ObjectType::PLANET)) {
-					// XXX this should incorporate some lighting effect
-					// (ie, colour of the illuminating star(s))
-					attrs.billboardColor = b->GetSystemBody()->GetAlbedo();
-				} else {
-					attrs.billboardColor = Color::WHITE;
-				}
+			attrs.billboardColor.a = 255; // no alpha, these things are hard enough to see as it is
+			return true;
+		}
+	} else if (pixSize < OBJECT_HIDDEN_PIXEL_THRESHOLD) {
+		return false;
+	}
 
-				// this should always be the main star in the system - except for the star itself!
-				if (!m_lightSources.empty() && !b->IsType(ObjectType::STAR)) {
-					const Graphics::Light &light = m_lightSources[0].GetLight();
-					attrs.billboardColor *= light.GetDiffuse(); // colour the billboard a little with the Starlight
-				}
+	Body *parentBody = f->GetBody();
+	if (parentBody && parentBody->GetType() == ObjectType::PLANET) {
+		auto *planet = static_cast<Planet *>(parentBody);
 
-				attrs.billboardColor.a = 255; // no alpha, these things are hard enough to see as it is
-			}
-		} else if (pixSize < OBJECT_HIDDEN_PIXEL_THRESHOLD) {
-			continue;
-		}
+		double atmo_rad_sqr = planet->GetAtmosphereRadius() * planet->GetAtmosphereRadius();
+		if (b->IsType(ObjectType::MODELBODY) && b->GetPosition().LengthSqr() <= atmo_rad_sqr)
+			attrs.calcAtmosphereLighting = true;
+	}
 
-		Body *parentBody = f->GetBody();
-		if (parentBody && parentBody->GetType() == ObjectType::PLANET) {
-			auto *planet = static_cast<Planet *>(parentBody);
+	double ambient = 0.05, direct = 1.0;
+	if (attrs.calcAtmosphereLighting)
+		CalcLighting(b, ambient, direct);
 
-			double atmo_rad_sqr = planet->GetAtmosphereRadius() * planet->GetAtmosphereRadius();
-			if (b->IsType(ObjectType::MODELBODY) && b->GetPosition().LengthSqr() <= atmo_rad_sqr)
-				attrs.calcAtmosphereLighting = true;
-		}
+	attrs.ambientColor = Color(ambient * 255, ambient * 255, ambient * 255);
+	attrs.lightIntensities.fill(1.f);
+	for (size_t i = 0; i < m_lightSources.size(); i++)
+		attrs.lightIntensities[i] = direct * ShadowedIntensity(i, b);
+
+	return true;
+}
+
+void Camera::UpdateLightSources()
+{
+	FrameId camFrameId = m_context->GetTempFrame();
+	FrameId rootFrameId = Pi::game->GetSpace()->GetRootFrame();
+
+	// Pick up to four suitable system light sources (stars)
+	m_lightSources.clear();
+	m_lightSources.reserve(4);
+	position_system_lights(Frame::GetFrame(camFrameId), Frame::GetFrame(rootFrameId), m_lightSources);
 
+	if (m_lightSources.empty()) {
+		// no lights means we're somewhere weird (eg hyperspace). fake one
+		Graphics::Light light(Graphics::Light::LIGHT_DIRECTIONAL, vector3f(0.f), Color::WHITE, Color::WHITE);
+		m_lightSources.push_back(LightSource(0, light));
+	}
+}
+
+void Camera::Update()
+{
+	PROFILE_SCOPED()
+	FrameId camFrame = m_context->GetTempFrame();
+
+	// the bodies are lit (and billboards coloured) by these
+	UpdateLightSources();
+
+	m_sortedBodies.clear();
+	for (Body *b : Pi::game->GetSpace()->GetBodies()) {
+		// If the body wishes to be excluded from the draw, skip it.
+		if (b->GetFlags() & Body::FLAG_DRAW_EXCLUDE)
+			continue;
+
+		BodyAttrs attrs;
+		attrs.body = b;
 		m_sortedBodies.push_back(attrs);
 	}
 
+	// evaluate each body and determine if/where/how to draw it. Shadowing
+	// walks every eclipse caster for every light, so spread it over the workers
+	std::vector<char> visible(m_sortedBodies.size());
+	TaskGraph *taskGraph = Pi::GetApp()->GetTaskGraph();
+	if (!taskGraph || m_sortedBodies.size() <= BODY_VISIBILITY_GRAIN_SIZE) {
+		for (size_t idx = 0; idx < m_sortedBodies.size(); idx++)
+			visible[idx] = EvaluateBody(m_sortedBodies[idx], camFrame);
+	} else {
+		taskGraph->ParallelFor({ 0, uint32_t(m_sortedBodies.size()) }, BODY_VISIBILITY_GRAIN_SIZE, [&](TaskRange range) {
+			for (uint32_t idx = range.begin; idx < range.end; idx++)
+				visible[idx] = EvaluateBody(m_sortedBodies[idx], camFrame);
+		});
+	}
+
+	size_t numVisible = 0;
+	for (size_t idx = 0; idx < m_sortedBodies.size(); idx++) {
+		if (visible[idx])
+			m_sortedBodies[numVisible++] = m_sortedBodies[idx];
+	}
+	m_sortedBodies.resize(numVisible);
+
 	// depth sort
-	m_sortedBodies.sort();
+	std::stable_sort(m_sortedBodies.begin(), m_sortedBodies.end());
+
+	// interpolate the animations of the visible models ahead of drawing them
+	std::vector<SceneGraph::Model *> models;
+	for (const BodyAttrs &attrs : m_sortedBodies) {
+		if (attrs.body->IsType(ObjectType::MODELBODY))
+			models.push_back(static_cast<ModelBody *>(attrs.body)->GetModel());
+	}
+	update_model_animations(models);
 }
 
 void Camera::Draw(const Body *excludeBody)
@@ -235,7 +346,6 @@ void Camera::Draw(const Body *excludeBody)
 	FrameId rootFrameId = Pi::game->GetSpace()->GetRootFrame();
 
 	Frame *camFrame = Frame::GetFrame(camFrameId);
-	Frame *rootFrame = Frame::GetFrame(rootFrameId);
 
 	m_renderer->ClearScreen();
 
@@ -243,17 +353,6 @@ void Camera::Draw(const Body *excludeBody)
 	Frame::GetFrameTransform(rootFrameId, camFrameId, trans2bg);
 	trans2bg.ClearToRotOnly();
 
-	// Pick up to four suitable system light sources (stars)
-	m_lightSources.clear();
-	m_lightSources.reserve(4);
-	position_system_lights(camFrame, rootFrame, m_lightSources);
-
-	if (m_lightSources.empty()) {
-		// no lights means we're somewhere weird (eg hyperspace). fake one
-		Graphics::Light light(Graphics::Light::LIGHT_DIRECTIONAL, vector3f(0.f), Color::WHITE, Color::WHITE);
-		m_lightSources.push_back(LightSource(0, light));
-	}
-
 	//fade space background based on atmosphere thickness and light angle
 	float bgIntensity = 1.f;
 	Frame *camParent = Frame::GetFrame(camFrame->GetParent());
@@ -284,8 +383,11 @@ void Camera::Draw(const Body *excludeBody)
 		}
 	}
 
-	Pi::game->GetSpace()->GetBackground()->SetIntensity(bgIntensity);
-	Pi::game->GetSpace()->GetBackground()->Draw(trans2bg);
+	{
+		Graphics::Renderer::GPUZoneTicket zone(m_renderer, "Background");
+		Pi::game->GetSpace()->GetBackground()->SetIntensity(bgIntensity);
+		Pi::game->GetSpace()->GetBackground()->Draw(trans2bg);
+	}
 
 	{
 		std::vector<Graphics::Light> rendererLights;
@@ -295,17 +397,29 @@ void Camera::Draw(const Body *excludeBody)
 		m_renderer->SetLights(rendererLights.size(), &rendererLights[0]);
 	}
 
+	if (m_shadowCascades) {
+		Graphics::Renderer::GPUZoneTicket zone(m_renderer, "Shadows");
+		DrawShadowCascades(excludeBody);
+	}
+
 	std::vector<float> oldIntensities;
-	std::vector<float> lightIntensities;
-	for (size_t i = 0; i < m_lightSources.size(); i++) {
-		lightIntensities.push_back(1.0);
+	for (size_t i = 0; i < m_lightSources.size(); i++)
 		oldIntensities.push_back(m_renderer->GetLight(i).GetIntensity());
-	}
 
 	Graphics::VertexArray billboards(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_NORMAL);
 
-	for (std::list<BodyAttrs>::iterator i = m_sortedBodies.begin(); i != m_sortedBodies.end(); ++i) {
-		BodyAttrs *attrs = &(*i);
+	// bodies that only draw their model are collected by model and lighting,
+	// and each batch is drawn instanced once every other body has been drawn
+	struct InstanceBatch {
+		Color ambient;
+		std::array<float, Graphics::TOTAL_NUM_LIGHTS> lightIntensities;
+		std::vector<BodyAttrs *> bodies;
+	};
+	std::vector<InstanceBatch> instanceBatches;
+
+	m_renderer->PushGPUZone("Bodies");
+	for (BodyAttrs &i : m_sortedBodies) {
+		BodyAttrs *attrs = &i;
 
 		// explicitly exclude a single body if specified (eg player)
 		if (attrs->body == excludeBody)
@@ -317,32 +431,127 @@ void Camera::Draw(const Body *excludeBody)
 			continue;
 		}
 
-		double ambient = 0.05, direct = 1.0;
-		if (attrs->calcAtmosphereLighting)
-			CalcLighting(attrs->body, ambient, direct);
-
-		for (size_t i = 0; i < m_lightSources.size(); i++)
-			lightIntensities[i] = direct * ShadowedIntensity(i, attrs->body);
+		// lit by Update()
+		const Color &ambientColor = attrs->ambientColor;
+		const auto &lightIntensities = attrs->lightIntensities;
+
+		if (attrs->body->IsType(ObjectType::MODELBODY) && static_cast<ModelBody *>(attrs->body)->CanRenderInstanced()) {
+			const SceneGraph::Model *model = static_cast<ModelBody *>(attrs->body)->GetModel();
+			auto batch = std::find_if(instanceBatches.begin(), instanceBatches.end(), [&](const InstanceBatch &b) {
+				return b.ambient == ambientColor && b.lightIntensities == lightIntensities &&
+					static_cast<ModelBody *>(b.bodies.front()->body)->GetModel()->CanRenderInstancedWith(*model);
+			});
+			if (batch == instanceBatches.end())
+				batch = instanceBatches.insert(batch, { ambientColor, lightIntensities, {} });
+			batch->bodies.push_back(attrs);
+			continue;
+		}
 
 		// Setup dynamic lighting parameters
-		m_renderer->SetAmbientColor(Color(ambient * 255, ambient * 255, ambient * 255));
+		m_renderer->SetAmbientColor(ambientColor);
 		m_renderer->SetLightIntensity(m_lightSources.size(), lightIntensities.data());
 
 		attrs->body->Render(m_renderer, this, attrs->viewCoords, attrs->viewTransform);
 	}
+	m_renderer->PopGPUZone();
+
+	m_renderer->PushGPUZone("Models");
+	std::vector<matrix4x4f> instanceTransforms;
+	for (const InstanceBatch &batch : instanceBatches) {
+		m_renderer->SetAmbientColor(batch.ambient);
+		m_renderer->SetLightIntensity(m_lightSources.size(), batch.lightIntensities.data());
+
+		BodyAttrs *first = batch.bodies.front();
+		if (batch.bodies.size() == 1) {
+			first->body->Render(m_renderer, this, first->viewCoords, first->viewTransform);
+			continue;
+		}
+
+		instanceTransforms.clear();
+		for (const BodyAttrs *attrs : batch.bodies)
+			instanceTransforms.push_back(static_cast<ModelBody *>(attrs->body)->GetModelViewTransform(attrs->viewTransform));
+		static_cast<ModelBody *>(first->body)->GetModel()->Render(instanceTransforms);
+	}
+
+	// the nav lights of all the bodies above, in one draw
+	NavLights::RenderAll(m_renderer);
+	m_renderer->PopGPUZone();
 
 	// Restore default ambient color and direct light intensities
 	m_renderer->SetAmbientColor(Color(255, 255, 255));
 	m_renderer->SetLightIntensity(m_lightSources.size(), oldIntensities.data());
 
+	Graphics::Renderer::GPUZoneTicket zone(m_renderer, "Particles");
 	if (!billboards.IsEmpty()) {
 		Graphics::Renderer::MatrixTicket mt(m_renderer, matrix4x4f::Identity());
 		m_renderer->DrawBuffer(&billboards, m_billboardMaterial.get());
 	}
 
+	ProjectileManager::RenderAll(m_renderer, m_context->GetFrustum(), rootFrameId, camFrameId);
 	SfxManager::RenderAll(m_renderer, rootFrameId, camFrameId);
 }
 
+// Draws the depth of the sun's shadow casters into the cascades that need it.
+// Models are drawn without their transparent parts, which don't cast shadows
+// (and would add nav lights to the frame's batch). Ground stations, which
+// never move in their frame, go to the cached far cascades and everything
+// else to the near ones.
+void Camera::DrawShadowCascades(const Body *excludeBody)
+{
+	PROFILE_SCOPED()
+	const LightSource &sun = m_lightSources.front();
+	if (!sun.GetBody())
+		return;
+
+	// the cascades live in the camera's parent frame, where stations keep still
+	if (m_context->GetCameraFrame() != m_shadowFrame) {
+		m_shadowCascades->Invalidate();
+		m_shadowFrame = m_context->GetCameraFrame();
+	}
+
+	const matrix3x3d &orient = m_context->GetCameraOrient();
+	matrix4x4d camToFrame(orient);
+	camToFrame.SetTranslate(m_context->GetCameraPos());
+	const vector3d lightDir = orient * vector3d(sun.GetLight().GetPosition()).Normalized();
+	m_shadowCascades->Update(m_context->GetCameraPos(), orient, DEG2RAD(double(m_context->GetFovAng())),
+		m_context->GetWidth() / m_context->GetHeight(), m_context->GetZNear(), lightDir);
+
+	Graphics::Renderer::StateTicket ticket(m_renderer);
+	SceneGraph::RenderData rd;
+	rd.nodemask = SceneGraph::NODE_SOLID | SceneGraph::MASK_IGNORE;
+	const Uint32 mapSize = m_shadowCascades->GetSettings().mapSize;
+
+	for (Uint32 i = 0; i < m_shadowCascades->GetNumCascades(); i++) {
+		if (!m_shadowCascades->NeedsRedraw(i))
+			continue;
+
+		const Graphics::ShadowCascades::Cascade &c = m_shadowCascades->GetCascade(i);
+		m_renderer->SetRenderTarget(m_shadowCascades->GetTarget(i));
+		m_renderer->SetViewport({ 0, 0, int32_t(mapSize), int32_t(mapSize) });
+		m_renderer->ClearDepthBuffer();
+		m_renderer->SetOrthographicProjection(-c.radius, c.radius, -c.radius, c.radius, c.depthNear, c.depthFar);
+
+		const matrix4x4f lightFromCamera(c.lightView * camToFrame);
+		for (const BodyAttrs &attrs : m_sortedBodies) {
+			if (attrs.billboard || attrs.body == excludeBody || !attrs.body->IsType(ObjectType::MODELBODY))
+				continue;
+			const bool isStatic = attrs.body->IsType(ObjectType::SPACESTATION) && static_cast<SpaceStation *>(attrs.body)->IsGroundStation();
+			if (isStatic != c.isStatic)
+				continue;
+
+			ModelBody *body = static_cast<ModelBody *>(attrs.body);
+			const matrix4x4f modelView = body->GetModelViewTransform(attrs.viewTransform);
+			const vector3d pos = camToFrame * vector3d(modelView.GetTranslate());
+			if ((pos - c.centre).Length() > c.radius + body->GetClipRadius())
+				continue;
+
+			body->GetModel()->Render(lightFromCamera * modelView, &rd);
+		}
+
+		m_shadowCascades->MarkDrawn(i, m_renderer->GetProjection());
+	}
+}
+
 // Calculates the ambiently and directly lit portions of the lighting model taking into account the atmosphere and sun positions at a given location
 // 1. Calculates the amount of direct illumination available taking into account
 //    * multiple suns
@@ -524,7 +733,8 @@ float discCovered(const float dist, const float rad)
 	return Clamp((th + radsq * th2 - dist * d) / float(M_PI), 0.f, 1.f);
 }
 
-static std::vector<Camera::Shadow> shadows;
+// per thread, as Camera::Update() shadows bodies on the workers
+static thread_local std::vector<Camera::Shadow> shadows;
 
 float Camera::ShadowedIntensity(const int lightNum, const Body *b) const
 {
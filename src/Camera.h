@@ -9,10 +9,11 @@
 #include "RefCounted.h"
 #include "graphics/Frustum.h"
 #include "graphics/Light.h"
+#include "graphics/ShadowCascades.h"
 #include "matrix4x4.h"
 #include "vector3.h"
 
-#include <list>
+#include <array>
 #include <memory>
 #include <vector>
 
@@ -88,7 +89,9 @@ public:
 
 	const CameraContext *GetContext() const { return m_context.Get(); }
 
+	// positions the lights, then culls, lights and depth sorts the bodies
 	void Update();
+	// draws the bodies found by the last Update()
 	void Draw(const Body *excludeBody = nullptr);
 
 	// camera-specific light with attached source body
@@ -123,7 +126,17 @@ public:
 	const std::vector<LightSource> &GetLightSources() const { return m_lightSources; }
 	int GetNumLightSources() const { return static_cast<Uint32>(m_lightSources.size()); }
 
+	// the sun's shadow maps from the last Draw, or null if they're disabled
+	const Graphics::ShadowCascades *GetShadowCascades() const { return m_shadowCascades.get(); }
+
 private:
+	struct BodyAttrs;
+
+	void UpdateLightSources();
+	// fills in attrs for attrs.body, returns false if it shouldn't be drawn
+	bool EvaluateBody(BodyAttrs &attrs, FrameId camFrame) const;
+	void DrawShadowCascades(const Body *excludeBody);
+
 	RefCountedPtr<CameraContext> m_context;
 	Graphics::Renderer *m_renderer;
 
@@ -146,6 +159,10 @@ private:
 		// if true, calculate atmosphere-attenuated light intensity for the body
 		bool calcAtmosphereLighting;
 
+		// lighting of the body, unless it's drawn as a billboard
+		Color ambientColor;
+		std::array<float, Graphics::TOTAL_NUM_LIGHTS> lightIntensities;
+
 		// if true, draw object as billboard of billboardSize at billboardPos
 		bool billboard;
 		vector3f billboardPos;
@@ -162,8 +179,12 @@ private:
 		};
 	};
 
-	std::list<BodyAttrs> m_sortedBodies;
+	std::vector<BodyAttrs> m_sortedBodies;
 	std::vector<LightSource> m_lightSources;
+
+	std::unique_ptr<Graphics::ShadowCascades> m_shadowCascades;
+	// the frame the cached shadow cascades were drawn in
+	FrameId m_shadowFrame;
 };
 
 #endif
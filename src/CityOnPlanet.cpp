@@ -10,6 +10,7 @@
 #include "ModelCache.h"
 #include "Pi.h"
 #include "Planet.h"
+#include "Random.h"
 #include "SpaceStation.h"
 #include "collider/Geom.h"
 #include "core/Log.h"
@@ -23,12 +24,15 @@
 #include "scenegraph/Animation.h"
 #include "scenegraph/ModelSkin.h"
 #include "scenegraph/SceneGraph.h"
+#include "terrain/Terrain.h"
 #include "utils.h"
 
 #include "utils.h"
 
 std::vector<CityOnPlanet::CityFlavourType> CityOnPlanet::s_cityFlavours;
 std::unique_ptr<Graphics::Material> CityOnPlanet::s_debugMat;
+std::map<SystemPath, std::shared_ptr<const CityOnPlanet::Layout>> CityOnPlanet::s_layoutCache;
+std::deque<SystemPath> CityOnPlanet::s_layoutCacheOrder;
 
 void CityOnPlanet::AddStaticGeomsToCollisionSpace()
 {
@@ -74,13 +78,46 @@ void CityOnPlanet::AddStaticGeomsToCollisionSpace()
 		}
 	}
 
+	BuildBlocks();
+
 	// reset the reset flag
 	m_detailLevel = Pi::detail.cities;
 }
 
+void CityOnPlanet::BuildBlocks()
+{
+	PROFILE_SCOPED()
+
+	m_blocks.clear();
+
+	// keep the buildings of each block together; the stable sort leaves them in
+	// generation order within it
+	std::stable_sort(m_enabledBuildings.begin(), m_enabledBuildings.end(),
+		[](const BuildingInstance &a, const BuildingInstance &b) { return a.block < b.block; });
+
+	for (Uint32 i = 0; i < m_enabledBuildings.size();) {
+		const Uint32 block = m_enabledBuildings[i].block;
+		Uint32 end = i;
+
+		Aabb aabb;
+		aabb.min = aabb.max = m_enabledBuildings[i].pos;
+		for (; end < m_enabledBuildings.size() && m_enabledBuildings[end].block == block; end++)
+			aabb.Update(m_enabledBuildings[end].pos);
+
+		const vector3d centre = (aabb.min + aabb.max) * 0.5;
+		double radius = 0.0;
+		for (Uint32 j = i; j < end; j++)
+			radius = std::max(radius, (m_enabledBuildings[j].pos - centre).Length() + m_enabledBuildings[j].clipRadius);
+
+		m_blocks.push_back({ centre, radius, i, end - i });
+		i = end;
+	}
+}
+
 void CityOnPlanet::RemoveStaticGeomsFromCollisionSpace()
 {
 	m_enabledBuildings.clear();
+	m_blocks.clear();
 	for (unsigned int i = 0; i < m_buildings.size(); i++) {
 		Frame *f = Frame::GetFrame(m_frame);
 		f->RemoveStaticGeom(m_buildings[i].geom);
@@ -262,6 +299,8 @@ void CityOnPlanet::Init()
 
 void CityOnPlanet::Uninit()
 {
+	s_layoutCache.clear();
+	s_layoutCacheOrder.clear();
 	s_cityFlavours.clear();
 	s_debugMat.reset();
 }
@@ -294,41 +333,118 @@ void CityOnPlanet::SetCityModelPatterns(const SystemPath &path)
 	}
 }
 
-CityOnPlanet::~CityOnPlanet()
+#ifdef __BIG_ENDIAN__
+#error "CityOnPlanet does not (yet) support big-endian architectures"
+#endif
+
+// Supports up to 32-cell wide buildings to ensure 8-byte aligned addressing in a single operation
+static inline uint64_t CalcBitmaskForGrid(uint32_t x, uint32_t xsize)
 {
-	// frame may be null (already removed from
-	for (unsigned int i = 0; i < m_buildings.size(); i++) {
-		Frame *f = Frame::GetFrame(m_frame);
-		f->RemoveStaticGeom(m_buildings[i].geom);
-		delete m_buildings[i].geom;
-	}
+	uint32_t maskOffset = x & CityOnPlanet::CELLMASK;
+	uint64_t bitmask = uint64_t((1 << xsize) - 1) << maskOffset;
+	// note: need crossplatform bswap_64 here for big-endian compat
+	// we should be able to swap the bitmask rather than the in-memory bytes and have the same effect
+
+	return bitmask;
 }
 
-CityOnPlanet::CityOnPlanet(Planet *planet, SpaceStation *station, const Uint32 seed)
-{
-	// beware, these are not used in this function, but are used in subroutines!
-	m_body = planet->GetSystemBody();
-	m_planet = planet;
-	m_frame = planet->GetFrame();
+// Lays out the city on a worker thread. Everything it reads from the station
+// and the planet is copied here on the main thread; the planet's terrain is
+// shared, as it is only ever read.
+class CityOnPlanet::GenerateJob : public Job {
+public:
+	GenerateJob(CityOnPlanet *city, Planet *planet, SpaceStation *station, const Uint32 seed) :
+		Job(PRIORITY_HIGH), // the player is about to see it
+		m_city(city),
+		m_path(station->GetSystemBody()->GetPath()),
+		m_terrain(planet->GetTerrain()),
+		m_bodyRadius(planet->GetSystemBody()->GetRadius()),
+		m_population(planet->GetSystemBody()->GetPopulation()),
+		m_volatileLiquid(planet->GetSystemBody()->GetVolatileLiquid()),
+		m_hasAtmo(planet->GetSystemBody()->HasAtmosphere()),
+		m_stationName(station->GetSystemBody()->GetName()),
+		m_stationModelName(station->GetModel()->GetName()),
+		m_stationPos(station->GetPosition()),
+		m_stationOrient(station->GetOrient()),
+		m_rand(seed),
+		m_layout(new Layout())
+	{
+		GetModelSize(station->GetAabb(), m_stationSize);
+
+		// TODO: allow specifying city flavors based on various parameters (faction, world type, set from custom system def, etc.)
+		m_layout->cityType = m_rand.Int32(s_cityFlavours.size());
+		m_buildingTypes = s_cityFlavours[m_layout->cityType].buildingTypes;
+
+		CalcCityRadius(s_cityFlavours[m_layout->cityType].sizeDefs, planet->GetSystemBody()->GetAtmosOxidizing());
+	}
 
-	m_rand.seed(seed);
+	virtual void OnRun() override
+	{
+		Generate();
+	}
 
-	if (s_cityFlavours.empty()) {
-		return; // no buildings available to generate, we already logged an error about this during startup
+	virtual void OnFinish() override
+	{
+		if (s_layoutCacheOrder.size() >= LAYOUT_CACHE_SIZE) {
+			s_layoutCache.erase(s_layoutCacheOrder.front());
+			s_layoutCacheOrder.pop_front();
+		}
+		if (s_layoutCache.emplace(m_path, m_layout).second)
+			s_layoutCacheOrder.push_back(m_path);
+
+		m_city->SetLayout(std::move(m_layout));
 	}
 
-	// TODO: allow specifying city flavors based on various parameters (faction, world type, set from custom system def, etc.)
-	m_cityType = &s_cityFlavours[m_rand.Int32(s_cityFlavours.size())];
+	static constexpr size_t LAYOUT_CACHE_SIZE = 16;
 
-	CalcCityRadius(m_body);
+private:
+	void Generate();
+	void CalcCityRadius(std::vector<CityRadiusDef> &sizeDefs, double atmo);
 
-	// TODO: run in a task thread
-	Generate(station);
+	void SetGridOccupancy(uint32_t x, uint32_t y, const uint8_t size[2]);
+	bool TestGridOccupancy(uint32_t x, uint32_t y, const uint8_t size[2]);
 
-	AddStaticGeomsToCollisionSpace();
-}
+	// Quickly check if the given single grid cell is set.
+	// It is expected as a precondition that the position is valid and within
+	// the extents of the grid.
+	inline bool TestGridQuick(uint32_t x, uint32_t y) const
+	{
+		// bitset is stored in lsb order with 8 cells per byte
+		return m_gridBitset[y * m_gridPitch + x / 8] & (1 << (x & 7));
+	}
+
+	CityOnPlanet *m_city;
+	SystemPath m_path;
+
+	RefCountedPtr<Terrain> m_terrain;
+	double m_bodyRadius;
+	double m_population;
+	double m_volatileLiquid;
+	bool m_hasAtmo;
+
+	std::string m_stationName;
+	std::string m_stationModelName;
+	uint8_t m_stationSize[2];
+	vector3d m_stationPos;
+	matrix3x3d m_stationOrient;
 
-void CityOnPlanet::Generate(SpaceStation *station)
+	Random m_rand;
+	std::vector<BuildingType> m_buildingTypes;
+
+	double m_cityRadius;
+	double m_cityDensity;
+	uint32_t m_citySize;
+
+	// bitmask occupancy grid for quick population of the city
+	std::unique_ptr<uint8_t[]> m_gridBitset;
+	// width of a single grid row in bytes
+	uint32_t m_gridPitch;
+	uint32_t m_gridLen;
+
+	std::shared_ptr<Layout> m_layout;
+};
+
+void CityOnPlanet::GenerateJob::Generate()
 {
 	PROFILE_SCOPED()
 	Profiler::Clock _genTimer;
@@ -337,11 +453,7 @@ void CityOnPlanet::Generate(SpaceStation *station)
 	// Create the acceleration grid structure
 	// ==========================================
 
-	// Retrieve the station parameters
-	uint8_t stationSize[2] = {};
-	GetModelSize(station->GetAabb(), stationSize);
-
-	uint32_t stationSizeMax = std::max<uint32_t>(stationSize[0] / 2, stationSize[1] / 2);
+	uint32_t stationSizeMax = std::max<uint32_t>(m_stationSize[0] / 2, m_stationSize[1] / 2);
 
 	// update the allowed radius to ensure the spaceport isn't larger than the entire city
 	m_cityRadius += stationSizeMax * CELLSIZE;
@@ -351,9 +463,9 @@ void CityOnPlanet::Generate(SpaceStation *station)
 	m_citySize = cityExtents * 2;
 	m_gridPitch = std::ceil(m_citySize / 8.0);
 
-	Log::Verbose("Generating City for spacestation {}", station->GetSystemBody()->GetName());
+	Log::Verbose("Generating City for spacestation {}", m_stationName);
 	Log::Verbose("\tpopulation: {0} size {1}x{1}c (radius {2})",
-		m_body->GetPopulation(), m_citySize, m_cityRadius);
+		m_population, m_citySize, m_cityRadius);
 
 
 	// reserve space off the 'edge' of the grid for fast 64-bit lookup
@@ -369,43 +481,32 @@ void CityOnPlanet::Generate(SpaceStation *station)
 	// ==========================================
 
 	// get the increment vectors to multiply X/Z grid coordinates by
-	vector3d incX = station->GetOrient().VectorX() * CELLSIZE;
-	vector3d incZ = station->GetOrient().VectorZ() * CELLSIZE;
+	vector3d incX = m_stationOrient.VectorX() * CELLSIZE;
+	vector3d incZ = m_stationOrient.VectorZ() * CELLSIZE;
 
 	// top-left corner of the grid is -X, -Z relative to station position at center
 	// offset origin by half-grid to ensure grid centers are aligned with the station model
-	m_gridOrigin = station->GetPosition() - incX * (cityExtents + 0.5) - incZ * (cityExtents + 0.5);
+	const vector3d gridOrigin = m_stationPos - incX * (cityExtents + 0.5) - incZ * (cityExtents + 0.5);
 
 	// Setup the station somewhere in the city (defaults to center for now)
 	const uint32_t stationPos[2] = {
-		cityExtents - stationSize[0] / 2,
-		cityExtents - stationSize[1] / 2
+		cityExtents - m_stationSize[0] / 2,
+		cityExtents - m_stationSize[1] / 2
 	};
 
 	// Reserve space for the spacestation
-	SetGridOccupancy(stationPos[0], stationPos[1], stationSize);
+	SetGridOccupancy(stationPos[0], stationPos[1], m_stationSize);
 
 	Log::Verbose("\tCityOnPlanet: Station {} placed at grid {}:{} with extents {}x{}",
-		station->GetModel()->GetName(), stationPos[0], stationPos[1], stationSize[0], stationSize[1]);
+		m_stationModelName, stationPos[0], stationPos[1], m_stationSize[0], m_stationSize[1]);
 
 
 	// Begin generating buildings for the city
 	// ==========================================
 
-	// precalc orientation transforms (to rotate buildings to face north/south/east/west)
-	const matrix4x4d &m = station->GetOrient();
-
-	matrix4x4d orientcalc[4];
-	orientcalc[0] = m * matrix4x4d::RotateYMatrix(M_PI * 0.5 * 0);
-	orientcalc[1] = m * matrix4x4d::RotateYMatrix(M_PI * 0.5 * 1);
-	orientcalc[2] = m * matrix4x4d::RotateYMatrix(M_PI * 0.5 * 2);
-	orientcalc[3] = m * matrix4x4d::RotateYMatrix(M_PI * 0.5 * 3);
-
 	// Reserve space for all buildings we expect to generate
-	m_buildings.clear();
-	m_buildings.reserve(cityExtents * cityExtents); // estimate 25% occupancy
-
-	bool hasAtmo = m_body->HasAtmosphere();
+	std::vector<Layout::Building> &buildings = m_layout->buildings;
+	buildings.reserve(cityExtents * cityExtents); // estimate 25% occupancy
 
 	uint32_t discardedCells = 0;
 	uint32_t skippedCells = 0;
@@ -455,8 +556,8 @@ void CityOnPlanet::Generate(SpaceStation *station)
 			for (uint32_t retry = 0; retry < 8; retry++) {
 
 				// pick a random building type
-				typeIndex = m_rand.Int32(m_cityType->buildingTypes.size());
-				buildingType = &m_cityType->buildingTypes[typeIndex];
+				typeIndex = m_rand.Int32(m_buildingTypes.size());
+				buildingType = &m_buildingTypes[typeIndex];
 
 				// skip it if it won't fit here
 				// FIXME: this does not correctly handle the rotation case for non-square buildings.
@@ -466,7 +567,7 @@ void CityOnPlanet::Generate(SpaceStation *station)
 					continue;
 				}
 
-				float rarity = hasAtmo ? buildingType->rarityAtmo : buildingType->rarityAirless;
+				float rarity = m_hasAtmo ? buildingType->rarityAtmo : buildingType->rarityAirless;
 				float distribution = radiusNorm; // 0.0 .. 1.0 at edge of city
 
 				if (buildingType->buildingKind == SectorKind::Storage) {
@@ -512,14 +613,14 @@ void CityOnPlanet::Generate(SpaceStation *station)
 				double(y) + buildingType->cellSize[1] / 2.0,
 			};
 
-			vector3d pos = m_gridOrigin + incX * buildingPos.x + incZ * buildingPos.y;
+			vector3d pos = gridOrigin + incX * buildingPos.x + incZ * buildingPos.y;
 			vector3d posNorm = pos.Normalized();
-			double height = m_planet->GetTerrainHeight(posNorm);
+			double height = m_bodyRadius * (1.0 + m_terrain->GetHeight(posNorm));
 
 			// don't place under planetary sea-level if the body has >10% water
 			// TODO: need a better way to sample both height and biome data to determine if the cell is actually water
 			// This will not properly handle elevated lakes or dry inland depressions below sea-level
-			if (m_body->GetVolatileLiquid() > 0.1 && height < m_body->GetRadius()) {
+			if (m_volatileLiquid > 0.1 && height < m_bodyRadius) {
 				underwaterCells++;
 				continue;
 			}
@@ -528,15 +629,9 @@ void CityOnPlanet::Generate(SpaceStation *station)
 			// This may introduce horizontal inaccuracy errors with sufficiently small planetary radii
 			pos = posNorm * height;
 
-			const CollMesh *cmesh = buildingType->model->GetCollisionMesh().Get();
-
-			// FIXME: geoms need a userdata to tell gameplay code what we actually hit.
-			// We don't want to create a separate Body for each instance of the buildings, so we
-			// scam the code by pretending we're part of the host planet.
-			Geom *geom = new Geom(cmesh->GetGeomTree(), orientcalc[orient], pos, GetPlanet());
-
 			// add it to the list of buildings to render
-			m_buildings.push_back({ typeIndex, float(cmesh->GetRadius()), orient, pos, geom });
+			const Uint32 block = (y / BLOCKSIZE) * ((m_citySize + BLOCKSIZE - 1) / BLOCKSIZE) + x / BLOCKSIZE;
+			buildings.push_back({ pos, typeIndex, block, Uint8(orient) });
 
 		}
 	}
@@ -544,24 +639,16 @@ void CityOnPlanet::Generate(SpaceStation *station)
 	_genTimer.Stop();
 
 	Log::Verbose("\tCityOnPlanet: generated {} buildings in {}ms ( {} skipped, {} discarded, {} occupied, {} underwater, {} avg rolls / building )",
-		m_buildings.size(), _genTimer.milliseconds(), skippedCells, discardedCells, occupiedCells, underwaterCells, rarityRolls / double(m_buildings.size()));
-
-	_genTimer.SoftReset();
+		buildings.size(), _genTimer.milliseconds(), skippedCells, discardedCells, occupiedCells, underwaterCells, rarityRolls / double(buildings.size()));
 
 	// Compute the total AABB of this city
 	Aabb totalAABB;
-	const vector3d &stationOrigin = station->GetPosition();
-
-	for (const auto &buildingInst : m_buildings) {
-		totalAABB.Update(buildingInst.pos - stationOrigin);
+	for (const auto &building : buildings) {
+		totalAABB.Update(building.pos - m_stationPos);
 	}
 
-	m_realCentre = totalAABB.min + ((totalAABB.max - totalAABB.min) * 0.5);
-	m_clipRadius = totalAABB.GetRadius();
-
-	_genTimer.Stop();
-
-	Log::Verbose("\tCityOnPlanet: generated AABB for city in {}ms", _genTimer.milliseconds());
+	m_layout->realCentre = totalAABB.min + ((totalAABB.max - totalAABB.min) * 0.5);
+	m_layout->clipRadius = totalAABB.GetRadius();
 
 	// Release the memory once we're done generating and reset
 	m_gridBitset.reset();
@@ -570,15 +657,12 @@ void CityOnPlanet::Generate(SpaceStation *station)
 }
 
 // Calculate the radius for this city based on the SystemBody's parameters
-void CityOnPlanet::CalcCityRadius(const SystemBody *body)
+void CityOnPlanet::GenerateJob::CalcCityRadius(std::vector<CityRadiusDef> &sizeDefs, double atmo)
 {
-	double population = body->GetPopulation();
-	double atmo = body->GetAtmosOxidizing();
+	for (const CityRadiusDef &radii : reverse_container(sizeDefs)) {
+		bool isLast = (&radii == &sizeDefs.front());
 
-	for (const CityRadiusDef &radii : reverse_container(m_cityType->sizeDefs)) {
-		bool isLast = (&radii == &m_cityType->sizeDefs.front());
-
-		if (population > radii.population && !isLast)
+		if (m_population > radii.population && !isLast)
 			continue;
 
 		m_cityRadius = radii.baseSize + (atmo * radii.atmoSize) + (m_rand.Double() * radii.randomSize);
@@ -587,22 +671,7 @@ void CityOnPlanet::CalcCityRadius(const SystemBody *body)
 	}
 }
 
-#ifdef __BIG_ENDIAN__
-#error "CityOnPlanet does not (yet) support big-endian architectures"
-#endif
-
-// Supports up to 32-cell wide buildings to ensure 8-byte aligned addressing in a single operation
-static inline uint64_t CalcBitmaskForGrid(uint32_t x, uint32_t xsize)
-{
-	uint32_t maskOffset = x & CityOnPlanet::CELLMASK;
-	uint64_t bitmask = uint64_t((1 << xsize) - 1) << maskOffset;
-	// note: need crossplatform bswap_64 here for big-endian compat
-	// we should be able to swap the bitmask rather than the in-memory bytes and have the same effect
-
-	return bitmask;
-}
-
-void CityOnPlanet::SetGridOccupancy(uint32_t x, uint32_t y, const uint8_t size[2])
+void CityOnPlanet::GenerateJob::SetGridOccupancy(uint32_t x, uint32_t y, const uint8_t size[2])
 {
 	if (x + size[0] > m_citySize || y + size[1] > m_citySize)
 		return; // footprint would be off-grid, prevent writing outside the bitset
@@ -619,7 +688,7 @@ void CityOnPlanet::SetGridOccupancy(uint32_t x, uint32_t y, const uint8_t size[2
 	}
 }
 
-bool CityOnPlanet::TestGridOccupancy(uint32_t x, uint32_t y, const uint8_t size[2])
+bool CityOnPlanet::GenerateJob::TestGridOccupancy(uint32_t x, uint32_t y, const uint8_t size[2])
 {
 	if (x + size[0] > m_citySize || y + size[1] > m_citySize)
 		return true; // always occupied if footprint would be off-grid
@@ -640,6 +709,68 @@ bool CityOnPlanet::TestGridOccupancy(uint32_t x, uint32_t y, const uint8_t size[
 	return test != 0;
 }
 
+CityOnPlanet::~CityOnPlanet()
+{
+	// frame may be null (already removed from
+	for (unsigned int i = 0; i < m_buildings.size(); i++) {
+		Frame *f = Frame::GetFrame(m_frame);
+		f->RemoveStaticGeom(m_buildings[i].geom);
+		delete m_buildings[i].geom;
+	}
+}
+
+CityOnPlanet::CityOnPlanet(Planet *planet, SpaceStation *station, const Uint32 seed) :
+	m_planet(planet),
+	m_frame(planet->GetFrame()),
+	m_orient(station->GetOrient()),
+	m_detailLevel(Pi::detail.cities),
+	m_clipRadius(RADIUS),
+	m_cityType(nullptr)
+{
+	if (s_cityFlavours.empty()) {
+		return; // no buildings available to generate, we already logged an error about this during startup
+	}
+
+	// nothing is drawn or collided with until the layout is ready
+	auto cached = s_layoutCache.find(station->GetSystemBody()->GetPath());
+	if (cached != s_layoutCache.end())
+		SetLayout(cached->second);
+	else
+		m_generateJob = Pi::GetAsyncJobQueue()->Queue(new GenerateJob(this, planet, station, seed));
+}
+
+void CityOnPlanet::SetLayout(std::shared_ptr<const Layout> layout)
+{
+	PROFILE_SCOPED()
+
+	m_layout = std::move(layout);
+	m_cityType = &s_cityFlavours[m_layout->cityType];
+	m_realCentre = m_layout->realCentre;
+	m_clipRadius = m_layout->clipRadius;
+
+	// precalc orientation transforms (to rotate buildings to face north/south/east/west)
+	matrix4x4d orientcalc[4];
+	orientcalc[0] = m_orient * matrix4x4d::RotateYMatrix(M_PI * 0.5 * 0);
+	orientcalc[1] = m_orient * matrix4x4d::RotateYMatrix(M_PI * 0.5 * 1);
+	orientcalc[2] = m_orient * matrix4x4d::RotateYMatrix(M_PI * 0.5 * 2);
+	orientcalc[3] = m_orient * matrix4x4d::RotateYMatrix(M_PI * 0.5 * 3);
+
+	m_buildings.clear();
+	m_buildings.reserve(m_layout->buildings.size());
+	for (const Layout::Building &building : m_layout->buildings) {
+		const CollMesh *cmesh = m_cityType->buildingTypes[building.instIndex].model->GetCollisionMesh().Get();
+
+		// FIXME: geoms need a userdata to tell gameplay code what we actually hit.
+		// We don't want to create a separate Body for each instance of the buildings, so we
+		// scam the code by pretending we're part of the host planet.
+		Geom *geom = new Geom(cmesh->GetGeomTree(), orientcalc[building.rotation], building.pos, GetPlanet());
+
+		m_buildings.push_back({ building.instIndex, float(cmesh->GetRadius()), building.rotation, building.pos, geom, building.block });
+	}
+
+	AddStaticGeomsToCollisionSpace();
+}
+
 void CityOnPlanet::Render(Graphics::Renderer *r, const Graphics::Frustum &frustum, const SpaceStation *station, const vector3d &viewCoords, const matrix4x4d &viewTransform)
 {
 	PROFILE_SCOPED()
@@ -700,17 +831,28 @@ void CityOnPlanet::Render(Graphics::Renderer *r, const Graphics::Frustum &frustu
 		transform[i].reserve(m_buildingCounts[i]);
 	}
 
-	for (const auto &building : m_enabledBuildings) {
-		const vector3d pos = viewTransform * building.pos;
-
-		if (!frustum.TestPoint(pos, building.clipRadius))
+	// cull whole blocks of the grid first; only blocks straddling the edge of
+	// the frustum need their buildings tested one by one
+	for (const BuildingBlock &block : m_blocks) {
+		const vector3d blockPos = viewTransform * block.centre;
+		if (!frustum.TestPoint(blockPos, block.radius))
 			continue;
 
-		matrix4x4f instanceRot = matrix4x4f(rotf[building.rotation]);
-		instanceRot.SetTranslate(vector3f(pos));
+		const bool contained = frustum.TestPointContained(blockPos, block.radius);
+		const BuildingInstance *buildings = m_enabledBuildings.data() + block.first;
+		for (Uint32 i = 0; i < block.count; i++) {
+			const BuildingInstance &building = buildings[i];
+			const vector3d pos = viewTransform * building.pos;
 
-		transform[building.instIndex].push_back(instanceRot);
-		++uCount;
+			if (!contained && !frustum.TestPoint(pos, building.clipRadius))
+				continue;
+
+			matrix4x4f instanceRot = matrix4x4f(rotf[building.rotation]);
+			instanceRot.SetTranslate(vector3f(pos));
+
+			transform[building.instIndex].push_back(instanceRot);
+			++uCount;
+		}
 	}
 
 	// render the building models using instancing
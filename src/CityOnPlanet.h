@@ -6,10 +6,14 @@
 
 #include "CollMesh.h"
 #include "FrameId.h"
-#include "Random.h"
+#include "JobQueue.h"
 #include "JsonFwd.h"
+#include "galaxy/SystemPath.h"
 #include "matrix4x4.h"
 
+#include <deque>
+#include <map>
+#include <memory>
 #include <set>
 
 class Geom;
@@ -55,6 +59,8 @@ public:
 	// maximum number of cells a single building may take up
 	static constexpr uint32_t CELLMAX = 32;
 	static constexpr uint32_t CELLMASK = CELLMAX - 1;
+	// number of cells along each side of a culling block
+	static constexpr uint32_t BLOCKSIZE = 8;
 
 private:
 
@@ -95,22 +101,29 @@ private:
 		std::vector<BuildingType> buildingTypes;
 	};
 
-private:
-
-	void Generate(SpaceStation *station);
-	void CalcCityRadius(const SystemBody *body);
+	// Where the buildings of a generated city go. Positions are in the
+	// planet's frame, which a ground station never moves in, so a layout
+	// stays valid for every later visit to the same station.
+	struct Layout {
+		struct Building {
+			vector3d pos;
+			Uint32 instIndex;
+			Uint32 block; // index of the culling block the building's cell lies in
+			Uint8 rotation; // 0-3
+		};
+
+		Uint32 cityType; // index into s_cityFlavours
+		vector3d realCentre;
+		float clipRadius;
+		std::vector<Building> buildings;
+	};
 
-	void SetGridOccupancy(uint32_t x, uint32_t y, const uint8_t size[2]);
-	bool TestGridOccupancy(uint32_t x, uint32_t y, const uint8_t size[2]);
+private:
+	// places the buildings on a worker thread
+	class GenerateJob;
 
-	// Quickly check if the given single grid cell is set.
-	// It is expected as a precondition that the position is valid and within
-	// the extents of the grid.
-	inline bool TestGridQuick(uint32_t x, uint32_t y) const
-	{
-		// bitset is stored in lsb order with 8 cells per byte
-		return m_gridBitset[y * m_gridPitch + x / 8] & (1 << (x & 7));
-	}
+	// creates the building instances and geoms for a layout
+	void SetLayout(std::shared_ptr<const Layout> layout);
 
 	void AddStaticGeomsToCollisionSpace();
 	void RemoveStaticGeomsFromCollisionSpace();
@@ -121,32 +134,35 @@ private:
 		int rotation; // 0-3
 		vector3d pos;
 		Geom *geom;
+		Uint32 block; // index of the culling block the building's cell lies in
 	};
 
-	const SystemBody *m_body;
-	Planet *m_planet;
+	// A square of BLOCKSIZE x BLOCKSIZE grid cells, bounding a contiguous
+	// range of m_enabledBuildings so Render() can cull them together.
+	struct BuildingBlock {
+		vector3d centre;
+		double radius;
+		Uint32 first;
+		Uint32 count;
+	};
 
-	double m_cityRadius;
-	double m_cityDensity;
-	uint32_t m_citySize;
+	void BuildBlocks();
 
+	Planet *m_planet;
 	FrameId m_frame;
-	Random m_rand;
+	matrix4x4d m_orient; // of the station
+
+	std::shared_ptr<const Layout> m_layout;
+	Job::Handle m_generateJob;
 
 	std::vector<BuildingInstance> m_buildings;
 	std::vector<BuildingInstance> m_enabledBuildings;
+	std::vector<BuildingBlock> m_blocks;
 	std::vector<Uint32> m_buildingCounts;
 
-	// bitmask occupancy grid for quick population of the city
-	std::unique_ptr<uint8_t[]> m_gridBitset;
-	// width of a single grid row in bytes
-	uint32_t m_gridPitch;
-	uint32_t m_gridLen;
-
 	int m_detailLevel;
 	float m_clipRadius;
 	vector3d m_realCentre;
-	vector3d m_gridOrigin;
 
 	CityFlavourType *m_cityType;
 
@@ -158,6 +174,11 @@ private:
 
 	static std::unique_ptr<Graphics::Material> s_debugMat;
 
+	// generated layouts by station, so approaching a city again doesn't
+	// generate it again; the oldest entry goes first once full
+	static std::map<SystemPath, std::shared_ptr<const Layout>> s_layoutCache;
+	static std::deque<SystemPath> s_layoutCacheOrder;
+
 	static void LoadCityFlavour(const FileSystem::FileInfo &file);
 	static void LoadBuildingType(std::string_view key, const Json &buildingDef, BuildingType &out);
 	static void GetModelSize(const Aabb &aabb, uint8_t size[2]);
@@ -10,9 +10,13 @@
 #include "Planet.h"
 #include "Space.h"
 #include "collider/CollisionContact.h"
+#include "collider/CollisionSpace.h"
 #include "ship/Propulsion.h"
 
 static const float KINETIC_ENERGY_MULT = 0.00001f;
+// bodies moving further than this fraction of their radius in one step are
+// swept along their path, as the discrete collision check could miss geometry
+static const double CONTINUOUS_COLLISION_RADIUS_FRACTION = 0.5;
 const double DynamicBody::DEFAULT_DRAG_COEFF = 0.1; // 'smooth sphere'
 
 DynamicBody::DynamicBody() :
@@ -22,6 +26,11 @@ DynamicBody::DynamicBody() :
 	m_flags = Body::FLAG_CAN_MOVE_FRAME;
 	m_oldPos = GetPosition();
 	m_oldAngDisplacement = vector3d(0.0);
+	m_motionIntegrated = false;
+	m_hasPendingMotion = false;
+	m_hasPrescribedMotion = false;
+	m_pendingRotation = matrix3x3d::Identity();
+	m_pendingMove = vector3d(0.0);
 	m_force = vector3d(0.0);
 	m_torque = vector3d(0.0);
 	m_vel = vector3d(0.0);
@@ -30,6 +39,7 @@ DynamicBody::DynamicBody() :
 	m_angInertia = 1;
 	m_massRadius = 1;
 	m_isMoving = true;
+	m_isCoasting = false;
 	m_atmosForce = vector3d(0.0);
 	m_gravityForce = vector3d(0.0);
 	m_externalForce = vector3d(0.0); // do external forces calc instead?
@@ -51,6 +61,12 @@ DynamicBody::DynamicBody(const Json &jsonObj, Space *space) :
 	m_flags = Body::FLAG_CAN_MOVE_FRAME;
 	m_oldPos = GetPosition();
 	m_oldAngDisplacement = vector3d(0.0);
+	m_isCoasting = false;
+	m_motionIntegrated = false;
+	m_hasPendingMotion = false;
+	m_hasPrescribedMotion = false;
+	m_pendingRotation = matrix3x3d::Identity();
+	m_pendingMove = vector3d(0.0);
 
 	try {
 		Json dynamicBodyObj = jsonObj["dynamic_body"];
@@ -74,6 +90,7 @@ DynamicBody::DynamicBody(const Json &jsonObj, Space *space) :
 void DynamicBody::SetMoving(bool isMoving)
 {
 	m_isMoving = isMoving;
+	m_isCoasting = false;
 
 	if (!m_isMoving) {
 		m_vel = vector3d(0.0);
@@ -227,30 +244,74 @@ void DynamicBody::CalcExternalForce()
 	}
 }
 
-void DynamicBody::TimeStepUpdate(const float timeStep)
+void DynamicBody::IntegrateMotion(const float timeStep)
 {
-	m_oldPos = GetPosition();
-	if (m_isMoving) {
-		m_force += m_externalForce;
+	m_motionIntegrated = true;
+	if (m_isMoving)
+		IntegrateVelocity(timeStep);
+}
 
-		m_vel += double(timeStep) * m_force * (1.0 / m_mass);
-		m_angVel += double(timeStep) * m_torque * (1.0 / m_angInertia);
+void DynamicBody::SetPrescribedMotion(const vector3d &endPos, const vector3d &endVel)
+{
+	m_motionIntegrated = true;
+	m_hasPrescribedMotion = true;
+	m_force = vector3d(0.0);
+	m_torque = vector3d(0.0);
+	m_vel = endVel;
+	m_angVel = vector3d(0.0);
+	m_pendingRotation = matrix3x3d::Identity();
+	m_oldAngDisplacement = vector3d(0.0);
+	m_pendingMove = endPos - GetPosition();
+	m_hasPendingMotion = true;
+}
+
+void DynamicBody::IntegrateVelocity(const float timeStep)
+{
+	m_hasPrescribedMotion = false;
+	m_force += m_externalForce;
+
+	m_vel += double(timeStep) * m_force * (1.0 / m_mass);
+	m_angVel += double(timeStep) * m_torque * (1.0 / m_angInertia);
 
-		double len = m_angVel.Length();
-		if (len > 1e-16) {
-			vector3d axis = m_angVel * (1.0 / len);
-			matrix3x3d r = matrix3x3d::Rotate(len * timeStep, axis);
-			SetOrient(r * GetOrient());
-		}
-		m_oldAngDisplacement = m_angVel * timeStep;
+	double len = m_angVel.Length();
+	if (len > 1e-16) {
+		vector3d axis = m_angVel * (1.0 / len);
+		m_pendingRotation = matrix3x3d::Rotate(len * timeStep, axis);
+	} else {
+		m_pendingRotation = matrix3x3d::Identity();
+	}
+	m_oldAngDisplacement = m_angVel * timeStep;
 
-		SetPosition(GetPosition() + m_vel * double(timeStep));
+	m_pendingMove = m_vel * double(timeStep);
+	ClipMotion(m_pendingMove);
+	m_hasPendingMotion = true;
+}
+
+void DynamicBody::TimeStepUpdate(const float timeStep)
+{
+	// bodies added during the step haven't been through the integration pass
+	if (!m_motionIntegrated)
+		IntegrateMotion(timeStep);
+	else if (m_isMoving && !m_hasPendingMotion)
+		IntegrateVelocity(timeStep);
+	m_motionIntegrated = false;
+
+	m_oldPos = GetPosition();
+	if (m_isMoving) {
+		m_hasPendingMotion = false;
+		if (m_angVel.LengthSqr() > 1e-32)
+			SetOrient(m_pendingRotation * GetOrient());
+		SetPosition(GetPosition() + m_pendingMove);
 
 		//if (this->IsType(ObjectType::PLAYER))
 		//Output("pos = %.1f,%.1f,%.1f, vel = %.1f,%.1f,%.1f, force = %.1f,%.1f,%.1f, external = %.1f,%.1f,%.1f\n",
 		//	pos.x, pos.y, pos.z, m_vel.x, m_vel.y, m_vel.z, m_force.x, m_force.y, m_force.z,
 		//	m_externalForce.x, m_externalForce.y, m_externalForce.z);
 
+		// anything over a micro-g besides gravity, such as thrust or drag
+		const double coastForce = 1e-6 * m_mass;
+		m_isCoasting = (m_force - m_gravityForce).LengthSqr() < coastForce * coastForce;
+
 		m_lastForce = m_force;
 		m_lastTorque = m_torque;
 		m_force = vector3d(0.0);
@@ -263,6 +324,26 @@ void DynamicBody::TimeStepUpdate(const float timeStep)
 	ModelBody::TimeStepUpdate(timeStep);
 }
 
+void DynamicBody::ClipMotion(vector3d &move) const
+{
+	const double moveLen = move.Length();
+	if (moveLen <= GetPhysRadius() * CONTINUOUS_COLLISION_RADIUS_FRACTION)
+		return;
+
+	Frame *frame = Frame::GetFrame(GetFrame());
+	if (!frame || !frame->GetCollisionSpace())
+		return;
+
+	CollisionContact c;
+	frame->GetCollisionSpace()->TraceRay(GetPosition(), move * (1.0 / moveLen), moveLen, &c, GetGeom());
+	if (!c.userData1 || c.userData1 == this)
+		return;
+
+	// stop where the centre meets the surface. The body is left overlapping
+	// it, so the regular contact response and damage apply on the next step.
+	move *= c.distance / moveLen;
+}
+
 void DynamicBody::UpdateInterpTransform(double alpha)
 {
 	m_interpPos = alpha * GetPosition() + (1.0 - alpha) * m_oldPos;
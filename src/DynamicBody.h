@@ -34,7 +34,14 @@ public:
 	void SetMassDistributionFromModel();
 	void SetMoving(bool isMoving);
 	bool IsMoving() const { return m_isMoving; }
+	// true if gravity was the only force on the body over the last step
+	bool IsCoasting() const { return m_isCoasting; }
+	// true if the last step's motion was set by SetPrescribedMotion()
+	bool HasPrescribedMotion() const { return m_hasPrescribedMotion; }
 	virtual double GetMass() const override { return m_mass; } // XXX don't override this
+	// integrates forces into velocity and a pending move, which
+	// TimeStepUpdate() then applies
+	virtual void IntegrateMotion(const float timeStep) override;
 	virtual void TimeStepUpdate(const float timeStep) override;
 	double CalcAtmosphericDrag(double velSqr, double area, double coeff) const;
 	void CalcExternalForce();
@@ -86,6 +93,10 @@ protected:
 
 	virtual vector3d CalcAtmosphericForce() const;
 
+	// from IntegrateMotion(), moves the body to endPos with velocity endVel
+	// over this step in place of integrating its forces
+	void SetPrescribedMotion(const vector3d &endPos, const vector3d &endVel);
+
 	static const double DEFAULT_DRAG_COEFF;
 
 	double m_dragCoeff;
@@ -94,6 +105,10 @@ protected:
 	AIError m_aiMessage;
 
 private:
+	void IntegrateVelocity(const float timeStep);
+	// shorten a move which would pass through collision geometry
+	void ClipMotion(vector3d &move) const;
+
 	vector3d m_oldPos;
 	vector3d m_oldAngDisplacement;
 
@@ -105,6 +120,14 @@ private:
 	double m_massRadius; // set in a mickey-mouse fashion from the collision mesh and used to calculate m_angInertia
 	double m_angInertia; // always sphere mass distribution
 	bool m_isMoving;
+	bool m_isCoasting;
+
+	// result of IntegrateMotion(), waiting for TimeStepUpdate()
+	bool m_motionIntegrated;
+	bool m_hasPendingMotion;
+	bool m_hasPrescribedMotion;
+	matrix3x3d m_pendingRotation;
+	vector3d m_pendingMove;
 
 	vector3d m_externalForce;
 	vector3d m_atmosForce;
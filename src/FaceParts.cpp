@@ -8,6 +8,8 @@
 #include "SDLWrappers.h"
 #include "utils.h"
 
+#include <mutex>
+
 namespace {
 	static const int MAX_GENDERS = 6;
 	static const int MAX_RACES = 16;
@@ -167,6 +169,9 @@ namespace {
 	}
 
 	static PartDb *s_partdb;
+	// SDL caches a blit mapping from each part surface to its last target,
+	// so face images can only be built one at a time
+	static std::mutex s_buildLock;
 } // anonymous namespace
 
 namespace fs = FileSystem;
@@ -305,6 +310,7 @@ void FaceParts::Init()
 
 void FaceParts::Uninit()
 {
+	std::lock_guard<std::mutex> lock(s_buildLock);
 	delete s_partdb;
 	s_partdb = nullptr;
 }
@@ -411,6 +417,10 @@ void FaceParts::PickFaceParts(FaceDescriptor &inout_face, const Uint32 seed)
 void FaceParts::BuildFaceImage(SDL_Surface *faceIm, const FaceDescriptor &face)
 {
 	PROFILE_SCOPED()
+	std::lock_guard<std::mutex> lock(s_buildLock);
+	if (!s_partdb)
+		return;
+
 	const Uint32 selector = _make_selector(face.species, face.race, face.gender);
 
 	_blit_image(faceIm, s_partdb->background_general.Get(), 0, 0);
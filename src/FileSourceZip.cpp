@@ -4,7 +4,6 @@
 #include "FileSourceZip.h"
 #include "utils.h"
 #include <algorithm>
-#include <cstdio>
 #include <cstdlib>
 
 extern "C" {
@@ -17,11 +16,14 @@ namespace FileSystem {
 		FileSource(zipPath),
 		m_archive(0)
 	{
+		// reading from memory rather than a FILE stream keeps the archive
+		// state read-only while extracting, so readers don't need a lock
+		m_zipData = fs.MapFile(zipPath);
 		mz_zip_archive *zip = static_cast<mz_zip_archive *>(std::calloc(1, sizeof(mz_zip_archive)));
-		FILE *file = fs.OpenReadStream(zipPath);
-		if (!mz_zip_reader_init_file_stream(zip, file, 0)) {
+		if (!m_zipData || !mz_zip_reader_init_mem(zip, m_zipData->GetData(), m_zipData->GetSize(), 0)) {
 			Output("FileSourceZip: unable to open '%s'\n", zipPath.c_str());
 			std::free(zip);
+			m_zipData.Reset();
 			return;
 		}
 
@@ -49,6 +51,47 @@ namespace FileSystem {
 		if (!m_archive) return;
 		mz_zip_archive *zip = static_cast<mz_zip_archive *>(m_archive);
 		mz_zip_reader_end(zip);
+		std::free(zip);
+	}
+
+	void FileSourceZip::SetCacheBudget(size_t bytes)
+	{
+		std::lock_guard<std::mutex> lock(m_cache.lock);
+		m_cache.budget = bytes;
+		TrimCache();
+	}
+
+	RefCountedPtr<FileData> FileSourceZip::FindCached(Uint32 index)
+	{
+		std::lock_guard<std::mutex> lock(m_cache.lock);
+		auto it = m_cache.index.find(index);
+		if (it == m_cache.index.end())
+			return RefCountedPtr<FileData>();
+		m_cache.entries.splice(m_cache.entries.begin(), m_cache.entries, it->second);
+		return it->second->second;
+	}
+
+	void FileSourceZip::AddCached(Uint32 index, const RefCountedPtr<FileData> &data)
+	{
+		std::lock_guard<std::mutex> lock(m_cache.lock);
+		// another thread may have inflated the same entry meanwhile
+		if (m_cache.index.count(index))
+			return;
+		m_cache.entries.emplace_front(index, data);
+		m_cache.index[index] = m_cache.entries.begin();
+		m_cache.size += data->GetSize();
+		TrimCache();
+	}
+
+	// m_cache.lock must be held
+	void FileSourceZip::TrimCache()
+	{
+		while (m_cache.size > m_cache.budget) {
+			const auto &oldest = m_cache.entries.back();
+			m_cache.size -= oldest.second->GetSize();
+			m_cache.index.erase(oldest.first);
+			m_cache.entries.pop_back();
+		}
 	}
 
 	static void SplitPath(const std::string &path, std::vector<std::string> &output)
@@ -123,14 +166,27 @@ namespace FileSystem {
 			return RefCountedPtr<FileData>();
 
 		const FileStat &st = (*i).second;
+		if (!st.info.IsFile())
+			return RefCountedPtr<FileData>();
+
+		const bool cacheable = st.size <= CACHE_MAX_ENTRY_SIZE;
+		if (cacheable) {
+			RefCountedPtr<FileData> cached = FindCached(st.index);
+			if (cached)
+				return cached;
+		}
 
 		char *data = static_cast<char *>(std::malloc(st.size));
 		if (!mz_zip_reader_extract_to_mem(zip, st.index, data, st.size, 0)) {
 			Output("FileSourceZip::ReadFile: couldn't extract '%s'\n", path.c_str());
+			std::free(data);
 			return RefCountedPtr<FileData>();
 		}
 
-		return RefCountedPtr<FileData>(new FileDataMalloc(st.info, st.size, data));
+		RefCountedPtr<FileData> fileData(new FileDataMalloc(st.info, st.size, data));
+		if (cacheable)
+			AddCached(st.index, fileData);
+		return fileData;
 	}
 
 	bool FileSourceZip::ReadDirectory(const std::string &path, std::vector<FileInfo> &output)
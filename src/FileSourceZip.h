@@ -6,8 +6,11 @@
 
 #include "FileSystem.h"
 #include <SDL_stdinc.h>
+#include <list>
 #include <map>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 
 namespace FileSystem {
 
@@ -18,13 +21,38 @@ namespace FileSystem {
 		FileSourceZip(FileSourceFS &fs, const std::string &zipPath);
 		virtual ~FileSourceZip();
 
+		// ReadFile() may be called from several threads at once: the archive
+		// is mapped into memory and entries are inflated on the calling
+		// thread without a lock.
 		virtual FileInfo Lookup(const std::string &path);
 		virtual RefCountedPtr<FileData> ReadFile(const std::string &path);
 		virtual bool ReadDirectory(const std::string &path, std::vector<FileInfo> &output);
 
+		// Inflated entries up to CACHE_MAX_ENTRY_SIZE are kept, least recently
+		// used first out, until they total more than the cache budget, so
+		// small files read repeatedly are only inflated once. 0 disables it.
+		static constexpr size_t CACHE_MAX_ENTRY_SIZE = 64 * 1024;
+		static constexpr size_t DEFAULT_CACHE_BUDGET = 4 * 1024 * 1024;
+		void SetCacheBudget(size_t bytes);
+
 	private:
+		RefCountedPtr<FileData> m_zipData; // keeps the mapping alive
 		void *m_archive;
 
+		struct EntryCache {
+			std::mutex lock;
+			size_t budget = DEFAULT_CACHE_BUDGET;
+			size_t size = 0;
+			// most recently used at the front
+			std::list<std::pair<Uint32, RefCountedPtr<FileData>>> entries;
+			std::unordered_map<Uint32, decltype(entries)::iterator> index;
+		};
+		EntryCache m_cache;
+
+		RefCountedPtr<FileData> FindCached(Uint32 index);
+		void AddCached(Uint32 index, const RefCountedPtr<FileData> &data);
+		void TrimCache();
+
 		struct FileStat {
 			FileStat(Uint32 _index, Uint64 _size, const FileInfo &_info) :
 				index(_index),
@@ -3,11 +3,15 @@
 
 #include "FileSystem.h"
 #include "StringRange.h"
+#include "core/FlatHashMap.h"
+#include "profiler/Profiler.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <iterator>
 #include <map>
+#include <mutex>
 #include <sstream>
 #include <stdexcept>
 
@@ -226,8 +230,22 @@ namespace FileSystem {
 		return MakeFileInfo(path, fileType, Time::DateTime());
 	}
 
+	struct FileSourceUnion::PathIndex {
+		struct Entry {
+			FileInfo info; // the entry from the first source that has the path
+			FileSource *source = nullptr;
+			FileSource *fileSource = nullptr; // the first source with a file at the path
+		};
+
+		// keyed by normalised path
+		FlatHashMap<std::string, Entry> entries;
+		std::atomic<bool> valid{ false };
+		std::mutex buildLock;
+	};
+
 	FileSourceUnion::FileSourceUnion() :
-		FileSource(":union:") {}
+		FileSource(":union:"),
+		m_index(new PathIndex) {}
 	FileSourceUnion::~FileSourceUnion() {}
 
 	void FileSourceUnion::PrependSource(FileSource *fs)
@@ -235,6 +253,7 @@ namespace FileSystem {
 		assert(fs);
 		RemoveSource(fs);
 		m_sources.insert(m_sources.begin(), fs);
+		InvalidateIndex();
 	}
 
 	void FileSourceUnion::AppendSource(FileSource *fs)
@@ -242,16 +261,62 @@ namespace FileSystem {
 		assert(fs);
 		RemoveSource(fs);
 		m_sources.push_back(fs);
+		InvalidateIndex();
 	}
 
 	void FileSourceUnion::RemoveSource(FileSource *fs)
 	{
 		std::vector<FileSource *>::iterator nend = std::remove(m_sources.begin(), m_sources.end(), fs);
 		m_sources.erase(nend, m_sources.end());
+		InvalidateIndex();
+	}
+
+	void FileSourceUnion::InvalidateIndex()
+	{
+		std::lock_guard<std::mutex> lock(m_index->buildLock);
+		m_index->valid.store(false, std::memory_order_release);
+	}
+
+	const FileSourceUnion::PathIndex &FileSourceUnion::GetIndex()
+	{
+		if (m_index->valid.load(std::memory_order_acquire))
+			return *m_index;
+
+		std::lock_guard<std::mutex> lock(m_index->buildLock);
+		if (m_index->valid.load(std::memory_order_relaxed))
+			return *m_index;
+
+		PROFILE_SCOPED()
+		m_index->entries.clear();
+		// sources are in priority order, so the first entry for a path wins
+		for (FileSource *fs : m_sources) {
+			const int flags = FileEnumerator::Recurse | FileEnumerator::IncludeDirs | FileEnumerator::IncludeSpecials;
+			for (const FileInfo &info : fs->Enumerate("", flags)) {
+				PathIndex::Entry &entry = m_index->entries.emplace(info.GetPath(), PathIndex::Entry{ info, fs }).first->second;
+				if (info.IsFile() && !entry.fileSource)
+					entry.fileSource = fs;
+			}
+		}
+
+		m_index->valid.store(true, std::memory_order_release);
+		return *m_index;
 	}
 
 	FileInfo FileSourceUnion::Lookup(const std::string &path)
 	{
+		const std::string key = NormalisePath(path);
+		// the root isn't an enumerated entry
+		if (!key.empty()) {
+			const PathIndex &index = GetIndex();
+			auto it = index.entries.find(key);
+			if (it == index.entries.end())
+				return MakeFileInfo(path, FileInfo::FT_NON_EXISTENT);
+			// keep the caller's spelling of the path
+			if (key == path)
+				return it->second.info;
+			return it->second.source->Lookup(path);
+		}
+
 		for (std::vector<FileSource *>::const_iterator
 				 it = m_sources.begin();
 			 it != m_sources.end(); ++it) {
@@ -277,15 +342,11 @@ namespace FileSystem {
 
 	RefCountedPtr<FileData> FileSourceUnion::ReadFile(const std::string &path)
 	{
-		for (std::vector<FileSource *>::const_iterator
-				 it = m_sources.begin();
-			 it != m_sources.end(); ++it) {
-			RefCountedPtr<FileData> data = (*it)->ReadFile(path);
-			if (data) {
-				return data;
-			}
-		}
-		return RefCountedPtr<FileData>();
+		const PathIndex &index = GetIndex();
+		auto it = index.entries.find(NormalisePath(path));
+		if (it == index.entries.end() || !it->second.fileSource)
+			return RefCountedPtr<FileData>();
+		return it->second.fileSource->ReadFile(path);
 	}
 
 	// Merge two sets of FileInfo's, by path.
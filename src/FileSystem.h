@@ -294,6 +294,18 @@ namespace FileSystem {
 		virtual RefCountedPtr<FileData> ReadFile(const std::string &path);
 		virtual bool ReadDirectory(const std::string &path, std::vector<FileInfo> &output);
 
+		// like ReadFile(), but maps the file into memory read-only rather than
+		// copying it, so only the pages touched are ever read from disk
+		RefCountedPtr<FileData> MapFile(const std::string &path);
+
+		// ReadFile() maps files at least this large instead of copying them.
+		// Trusted sources default to MAP_READ_THRESHOLD; other sources (the
+		// user directory) default to 0, which never maps, because their files
+		// may be rewritten while a mapping is still alive.
+		static constexpr size_t MAP_READ_THRESHOLD = 256 * 1024;
+		void SetMapThreshold(size_t size) { m_mapThreshold = size; }
+		size_t GetMapThreshold() const { return m_mapThreshold; }
+
 		bool MakeDirectory(const std::string &path);
 
 		enum WriteFlags {
@@ -306,6 +318,9 @@ namespace FileSystem {
 		FILE *OpenWriteStream(const std::string &path, int flags = 0);
 		bool RemoveFile(const std::string &relativePath);
 		bool IsChildOfRoot(const std::string &path);
+
+	private:
+		size_t m_mapThreshold;
 	};
 
 	class FileSourceUnion : public FileSource {
@@ -320,13 +335,25 @@ namespace FileSystem {
 		void AppendSource(FileSource *fs);
 		void RemoveSource(FileSource *fs);
 
+		// Lookup() and ReadFile() resolve paths through an index of every
+		// entry in every source, built on first use after the set of sources
+		// changes. Files added to or removed from a source afterwards are not
+		// seen until the index is invalidated. Once built, the index is only
+		// read, so lookups from several threads don't contend; invalidating it
+		// while another thread is looking up a path is not allowed.
+		void InvalidateIndex();
+
 		virtual FileInfo Lookup(const std::string &path);
 		std::vector<FileInfo> LookupAll(const std::string &path);
 		virtual RefCountedPtr<FileData> ReadFile(const std::string &path);
 		virtual bool ReadDirectory(const std::string &path, std::vector<FileInfo> &output);
 
 	private:
+		struct PathIndex;
+		const PathIndex &GetIndex();
+
 		std::vector<FileSource *> m_sources;
+		std::unique_ptr<PathIndex> m_index;
 	};
 
 } // namespace FileSystem
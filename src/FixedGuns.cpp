@@ -206,7 +206,7 @@ bool FixedGuns::Fire(int num, Body *b)
 			Beam::Add(b, m_gun[num].projData, pos, b->GetVelocity(), dir);
 		} else {
 			const vector3d dirVel = m_gun[num].projData.speed * dir;
-			Projectile::Add(b, m_gun[num].projData, pos, b->GetVelocity(), dirVel);
+			ProjectileManager::Add(b, m_gun[num].projData, pos, b->GetVelocity(), dirVel);
 		}
 	}
 
@@ -6,25 +6,46 @@
 #include "GameSaveError.h"
 #include "Json.h"
 #include "JsonUtils.h"
+#include "ModelBody.h"
+#include "OrbitPropagator.h"
+#include "Projectile.h"
 #include "Sfx.h"
 #include "Space.h"
+#include "collider/CollisionContact.h"
 #include "collider/CollisionSpace.h"
+#include "core/TaskGraph.h"
 #include "utils.h"
 
 std::vector<Frame> Frame::s_frames;
 std::vector<CollisionSpace *> Frame::s_collisionSpaces;
 
+// frames on orbital rails, propagated together
+static struct {
+	OrbitPropagator propagator;
+	std::vector<size_t> frames;
+	std::vector<const SystemBody *> bodies;
+	std::vector<vector3d> positions;
+	std::vector<vector3d> velocities;
+
+	void Clear()
+	{
+		propagator.Clear();
+		frames.clear();
+		bodies.clear();
+	}
+} s_orbitRails;
+
 Frame::Frame(const Dummy &d, FrameId parent, const char *label, unsigned int flags, double radius) :
-	m_parent(parent),
-	m_sbody(nullptr),
-	m_astroBody(nullptr),
 	m_pos(vector3d(0.0)),
 	m_initialOrient(matrix3x3d::Identity()),
 	m_orient(matrix3x3d::Identity()),
 	m_vel(vector3d(0.0)),
 	m_angSpeed(0.0),
-	m_radius(radius),
-	m_flags(flags)
+	m_parent(parent),
+	m_flags(flags),
+	m_sbody(nullptr),
+	m_astroBody(nullptr),
+	m_radius(radius)
 {
 	if (!d.madeWithFactory)
 		Error("Frame ctor called directly!\n");
@@ -47,17 +68,17 @@ Frame::Frame(const Dummy &d, FrameId parent, const char *label, unsigned int fla
 }
 
 Frame::Frame(const Dummy &d, FrameId parent) :
-	m_parent(parent),
-	m_sbody(nullptr),
-	m_astroBody(nullptr),
 	m_pos(vector3d(0.0)),
 	m_initialOrient(matrix3x3d::Identity()),
 	m_orient(matrix3x3d::Identity()),
 	m_vel(vector3d(0.0)),
 	m_angSpeed(0.0),
+	m_parent(parent),
+	m_flags(FLAG_ROTATING),
+	m_sbody(nullptr),
+	m_astroBody(nullptr),
 	m_label("camera"),
 	m_radius(0.0),
-	m_flags(FLAG_ROTATING),
 	m_collisionSpace(nullptr)
 {
 	if (!d.madeWithFactory)
@@ -72,28 +93,30 @@ Frame::Frame(const Dummy &d, FrameId parent) :
 
 Frame::Frame(Frame &&other) noexcept :
 	m_sfx(std::move(other.m_sfx)),
-	m_thisId(other.m_thisId),
-	m_parent(other.m_parent),
-	m_children(std::move(other.m_children)),
-	m_sbody(other.m_sbody),
-	m_astroBody(other.m_astroBody),
+	m_projectiles(std::move(other.m_projectiles)),
 	m_pos(other.m_pos),
 	m_oldPos(other.m_oldPos),
 	m_interpPos(other.m_interpPos),
 	m_initialOrient(other.m_initialOrient),
 	m_orient(other.m_orient),
+	m_interpOrient(other.m_interpOrient),
 	m_vel(other.m_vel),
 	m_angSpeed(other.m_angSpeed),
 	m_oldAngDisplacement(other.m_oldAngDisplacement),
-	m_label(std::move(other.m_label)),
-	m_radius(other.m_radius),
-	m_flags(other.m_flags),
-	m_collisionSpace(other.m_collisionSpace.release()),
 	m_rootVel(other.m_rootVel),
 	m_rootPos(other.m_rootPos),
 	m_rootOrient(other.m_rootOrient),
 	m_rootInterpPos(other.m_rootInterpPos),
 	m_rootInterpOrient(other.m_rootInterpOrient),
+	m_parent(other.m_parent),
+	m_thisId(other.m_thisId),
+	m_flags(other.m_flags),
+	m_children(std::move(other.m_children)),
+	m_sbody(other.m_sbody),
+	m_astroBody(other.m_astroBody),
+	m_label(std::move(other.m_label)),
+	m_radius(other.m_radius),
+	m_collisionSpace(other.m_collisionSpace.release()),
 	m_astroBodyIndex(other.m_astroBodyIndex),
 	d(other.d)
 {
@@ -103,6 +126,7 @@ Frame::Frame(Frame &&other) noexcept :
 Frame &Frame::operator=(Frame &&other)
 {
 	m_sfx = std::move(other.m_sfx);
+	m_projectiles = std::move(other.m_projectiles);
 	m_thisId = other.m_thisId;
 	m_parent = other.m_parent;
 	m_children = std::move(other.m_children);
@@ -113,6 +137,7 @@ Frame &Frame::operator=(Frame &&other)
 	m_interpPos = other.m_interpPos;
 	m_initialOrient = other.m_initialOrient;
 	m_orient = other.m_orient;
+	m_interpOrient = other.m_interpOrient;
 	m_vel = other.m_vel;
 	m_angSpeed = other.m_angSpeed;
 	m_oldAngDisplacement = other.m_oldAngDisplacement;
@@ -157,6 +182,7 @@ void Frame::ToJson(Json &frameObj, FrameId fId, Space *space)
 
 	// Add sfx array to supplied object.
 	SfxManager::ToJson(frameObj, f->m_thisId);
+	ProjectileManager::ToJson(frameObj, f->m_thisId, space);
 }
 
 Frame::~Frame()
@@ -227,6 +253,7 @@ FrameId Frame::FromJson(const Json &frameObj, Space *space, FrameId parent, doub
 	}
 
 	SfxManager::FromJson(frameObj, f->m_thisId);
+	ProjectileManager::FromJson(frameObj, f->m_thisId);
 
 	f->ClearMovement();
 	return f->GetId();
@@ -243,6 +270,8 @@ void Frame::DeleteFrames()
 
 	// remember to delete CollisionSpaces
 	s_collisionSpaces.clear();
+
+	s_orbitRails.Clear();
 }
 
 Frame *Frame::GetFrame(FrameId fId)
@@ -291,22 +320,63 @@ void Frame::PostUnserializeFixup(FrameId fId, Space *space)
 	Frame *f = Frame::GetFrame(fId);
 	f->UpdateRootRelativeVars();
 	f->m_astroBody = space->GetBodyByIndex(f->m_astroBodyIndex);
+	ProjectileManager::PostLoadFixup(fId, space);
 	// build the object trees once after loading so they're initialized while paused.
 	f->GetCollisionSpace()->RebuildObjectTrees();
 	for (FrameId kid : f->GetChildren())
 		PostUnserializeFixup(kid, space);
 }
 
-void Frame::CollideFrames(void (*callback)(CollisionContact *))
+// whether a buffered contact's body can still be collided with: not
+// killed, and with its geoms enabled
+static bool IsContactBodyCollidable(const void *userData)
+{
+	const Body *body = static_cast<const Body *>(userData);
+	if (!body)
+		return true;
+	if (body->IsDead())
+		return false;
+	return !body->IsType(ObjectType::MODELBODY) || static_cast<const ModelBody *>(body)->IsColliding();
+}
+
+void Frame::CollideFrames(void (*callback)(CollisionContact *), TaskGraph *taskGraph)
 {
 	PROFILE_SCOPED()
 
+	std::vector<Frame *> frames;
+	frames.reserve(s_frames.size());
 	for (auto &frame : s_frames) {
-		if (!frame.m_collisionSpace)
-			continue;
+		if (frame.m_collisionSpace)
+			frames.push_back(&frame);
+	}
+
+	if (!taskGraph || frames.size() < 2) {
+		for (Frame *frame : frames) {
+			PROFILE_SCOPED_DESC(frame->m_label.c_str())
+			frame->m_collisionSpace->Collide(callback);
+		}
+		return;
+	}
+
+	// Each collision space only touches its own geoms, so they can be
+	// collided independently. The callback modifies bodies, so contacts are
+	// buffered per frame and handled here afterwards in a fixed order.
+	// Contacts with a body that an earlier contact killed or stopped
+	// colliding (by docking it) are dropped, as colliding serially skips
+	// disabled geoms.
+	std::vector<std::vector<CollisionContact>> contacts(frames.size());
+	taskGraph->ParallelFor({ 0, uint32_t(frames.size()) }, 1, [&](TaskRange range) {
+		for (uint32_t idx = range.begin; idx < range.end; idx++) {
+			PROFILE_SCOPED_DESC(frames[idx]->m_label.c_str())
+			frames[idx]->m_collisionSpace->Collide(contacts[idx]);
+		}
+	});
 
-		PROFILE_SCOPED_DESC(frame.m_label.c_str())
-		frame.m_collisionSpace->Collide(callback);
+	for (std::vector<CollisionContact> &frameContacts : contacts) {
+		for (CollisionContact &contact : frameContacts) {
+			if (IsContactBodyCollidable(contact.userData1) && IsContactBodyCollidable(contact.userData2))
+				callback(&contact);
+		}
 	}
 }
 
@@ -436,6 +506,25 @@ matrix4x4d Frame::GetInterpTransformRelTo(FrameId relToId) const
 void Frame::UpdateInterpTransform(double alpha)
 {
 	PROFILE_SCOPED()
+	UpdateOwnInterpTransform(alpha);
+
+	for (FrameId kid : m_children) {
+		Frame *kidFrame = Frame::GetFrame(kid);
+		kidFrame->UpdateInterpTransform(alpha);
+	}
+}
+
+void Frame::UpdateInterpTransforms(double alpha)
+{
+	PROFILE_SCOPED()
+	// frames are only ever created after their parent, so walking the pool
+	// in order visits parents first, as UpdateOrbitRails() relies on too
+	for (Frame &frame : s_frames)
+		frame.UpdateOwnInterpTransform(alpha);
+}
+
+void Frame::UpdateOwnInterpTransform(double alpha)
+{
 	m_interpPos = alpha * m_pos + (1.0 - alpha) * m_oldPos;
 
 	double len = m_oldAngDisplacement * (1.0 - alpha);
@@ -452,11 +541,6 @@ void Frame::UpdateInterpTransform(double alpha)
 		m_rootInterpPos = parent->m_rootInterpOrient * m_interpPos + parent->m_rootInterpPos;
 		m_rootInterpOrient = parent->m_rootInterpOrient * m_interpOrient;
 	}
-
-	for (FrameId kid : m_children) {
-		Frame *kidFrame = Frame::GetFrame(kid);
-		kidFrame->UpdateInterpTransform(alpha);
-	}
 }
 
 void Frame::GetFrameTransform(const FrameId fFromId, const FrameId fToId, matrix4x4d &m)
@@ -480,15 +564,39 @@ void Frame::ClearMovement()
 void Frame::UpdateOrbitRails(double time, double timestep)
 {
 	PROFILE_SCOPED()
-	std::for_each(begin(s_frames), end(s_frames), [&time, &timestep](Frame &frame) {
+
+	// rebuild the propagator when the frames on rails change
+	size_t numRails = 0;
+	bool railsChanged = false;
+	for (const Frame &frame : s_frames) {
+		if (frame.m_parent.valid() && frame.m_sbody && !frame.IsRotFrame()) {
+			railsChanged = railsChanged || numRails >= s_orbitRails.frames.size() ||
+				s_orbitRails.frames[numRails] != frame.m_thisId.id() || s_orbitRails.bodies[numRails] != frame.m_sbody;
+			numRails++;
+		}
+	}
+	if (railsChanged || numRails != s_orbitRails.frames.size()) {
+		s_orbitRails.Clear();
+		for (const Frame &frame : s_frames) {
+			if (frame.m_parent.valid() && frame.m_sbody && !frame.IsRotFrame()) {
+				s_orbitRails.frames.push_back(frame.m_thisId.id());
+				s_orbitRails.bodies.push_back(frame.m_sbody);
+				s_orbitRails.propagator.Add(frame.m_sbody->GetOrbit());
+			}
+		}
+	}
+	s_orbitRails.propagator.PropagateStep(time, timestep, s_orbitRails.positions, s_orbitRails.velocities);
+
+	size_t rail = 0;
+	std::for_each(begin(s_frames), end(s_frames), [&time, &timestep, &rail](Frame &frame) {
 		frame.m_oldPos = frame.m_pos;
 		frame.m_oldAngDisplacement = frame.m_angSpeed * timestep;
 
 		// update frame position and velocity
 		if (frame.m_parent.valid() && frame.m_sbody && !frame.IsRotFrame()) {
-			frame.m_pos = frame.m_sbody->GetOrbit().OrbitalPosAtTime(time);
-			vector3d pos2 = frame.m_sbody->GetOrbit().OrbitalPosAtTime(time + timestep);
-			frame.m_vel = (pos2 - frame.m_pos) / timestep;
+			frame.m_pos = s_orbitRails.positions[rail];
+			frame.m_vel = s_orbitRails.velocities[rail];
+			rail++;
 		}
 		// temporary test thing
 		else
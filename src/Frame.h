@@ -18,8 +18,10 @@ class Body;
 class CollisionSpace;
 class Geom;
 class SystemBody;
+class ProjectileManager;
 class SfxManager;
 class Space;
+class TaskGraph;
 
 struct CollisionContact;
 
@@ -109,8 +111,14 @@ public:
 	CollisionSpace *GetCollisionSpace() const;
 
 	static void UpdateOrbitRails(double time, double timestep);
-	static void CollideFrames(void (*callback)(CollisionContact *));
+	// If a task graph is given, frames' collision spaces are collided in
+	// parallel and the contacts dispatched to the callback afterwards, in
+	// frame order, on the calling thread.
+	static void CollideFrames(void (*callback)(CollisionContact *), TaskGraph *taskGraph = nullptr);
+	// interpolates this frame and the frames below it
 	void UpdateInterpTransform(double alpha);
+	// interpolates every frame in one pass, parents before children
+	static void UpdateInterpTransforms(double alpha);
 	void ClearMovement();
 
 	// For an object in a rotating frame, relative to non-rotating frames it
@@ -131,17 +139,15 @@ public:
 	static void GetFrameTransform(FrameId fFrom, FrameId fTo, matrix4x4d &m);
 
 	std::unique_ptr<SfxManager> m_sfx; // the last survivor. actually m_children is pretty grim too.
+	std::unique_ptr<ProjectileManager> m_projectiles;
 
 private:
-	FrameId m_thisId;
-
 	void UpdateRootRelativeVars();
+	// interpolates this frame only, its parent must already be done
+	void UpdateOwnInterpTransform(double alpha);
 
-	FrameId m_parent;				 // if parent is null then frame position is absolute
-	std::vector<FrameId> m_children; // child frames, first may be rotating
-	SystemBody *m_sbody;			 // points to SBodies in Pi::current_system
-	Body *m_astroBody;				 // if frame contains a star or planet or something
-
+	// The transform state comes first and together, since the per-tick and
+	// per-frame passes over every frame touch nothing else.
 	vector3d m_pos;
 	vector3d m_oldPos;
 	vector3d m_interpPos;
@@ -152,10 +158,6 @@ private:
 					   // orbital rails determine velocity.
 	double m_angSpeed; // this however *is* directly applied (for rotating frames)
 	double m_oldAngDisplacement;
-	std::string m_label;
-	double m_radius;
-	int m_flags;
-	std::unique_ptr<CollisionSpace> m_collisionSpace;
 
 	vector3d m_rootVel; // velocity, position and orient relative to root frame
 	vector3d m_rootPos; // updated by UpdateOrbitRails
@@ -163,6 +165,17 @@ private:
 	vector3d m_rootInterpPos;	   // interp position and orient relative to root frame
 	matrix3x3d m_rootInterpOrient; // updated by UpdateInterpTransform
 
+	FrameId m_parent; // if parent is null then frame position is absolute
+	FrameId m_thisId;
+	int m_flags;
+
+	std::vector<FrameId> m_children; // child frames, first may be rotating
+	SystemBody *m_sbody;			 // points to SBodies in Pi::current_system
+	Body *m_astroBody;				 // if frame contains a star or planet or something
+	std::string m_label;
+	double m_radius;
+	std::unique_ptr<CollisionSpace> m_collisionSpace;
+
 	int m_astroBodyIndex; // deserialisation
 
 	static std::vector<Frame> s_frames;
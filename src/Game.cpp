@@ -8,14 +8,20 @@
 #include "Body.h"
 #include "DeathView.h"
 #include "FileSystem.h"
+#include "GameConfig.h"
 #include "GameLog.h"
 #include "GameSaveError.h"
 #include "HyperspaceCloud.h"
+#include "JobQueue.h"
 #include "JsonUtils.h"
 #include "MathUtil.h"
+#include "ModelCache.h"
 #include "collider/CollisionSpace.h"
 #include "core/GZipFormat.h"
+#include "core/LZ4Format.h"
+#include "core/MemoryStats.h"
 #include "galaxy/Economy.h"
+#include "galaxy/Sector.h"
 #include "lua/LuaEvent.h"
 #include "lua/LuaSerializer.h"
 #include "pigui/LuaPiGui.h"
@@ -24,6 +30,7 @@
 #endif
 #include "Pi.h"
 #include "Player.h"
+#include "SaveDelta.h"
 #include "SectorView.h"
 #include "Sfx.h"
 #include "Space.h"
@@ -34,7 +41,19 @@
 #include "pigui/PiGuiView.h"
 #include "ship/PlayerShipController.h"
 
-static const int s_saveVersion = 90;
+#include <SDL_timer.h>
+#include <algorithm>
+
+static const int s_saveVersion = 93;
+
+// full saves that delta saves are written against live in this subdirectory
+// of the save directory
+static const char s_deltaBaseDir[] = "delta_base";
+
+static std::string DeltaBasePath(const std::string &filename)
+{
+	return FileSystem::JoinPathBelow(FileSystem::JoinPath(Pi::SAVE_DIR_NAME, s_deltaBaseDir), filename);
+}
 
 Game::Game(const SystemPath &path, const double startDateTime, const char *shipType) :
 	m_galaxy(GalaxyGenerator::Create()),
@@ -137,10 +156,12 @@ Game::~Game()
 	m_space->RemoveBody(m_player.get());
 	m_space.reset();
 	m_player.reset();
+	m_routeSectorCache.Reset();
+	m_routeStarSystemCache.Reset();
 	m_galaxy->FlushCaches();
 }
 
-Game::Game(const Json &jsonObj) :
+Game::Game(Json &jsonObj) :
 	m_timeAccel(TIMEACCEL_PAUSED),
 	m_requestedTimeAccel(TIMEACCEL_PAUSED),
 	m_forceTimeAccel(false)
@@ -184,7 +205,8 @@ Game::Game(const Json &jsonObj) :
 		assert(!m_player->IsDead()); // Pioneer does not support necromancy
 
 		// hyperspace clouds being brought over from the previous system
-		Json hyperspaceCloudArray = jsonObj["hyperspace_clouds"].get<Json::array_t>();
+		const Json &hyperspaceCloudArray = jsonObj["hyperspace_clouds"];
+		if (!hyperspaceCloudArray.is_array()) throw SavedGameCorruptException();
 		for (Uint32 i = 0; i < hyperspaceCloudArray.size(); i++) {
 			m_hyperspaceClouds.push_back(static_cast<HyperspaceCloud *>(Body::FromJson(hyperspaceCloudArray[i], 0)));
 		}
@@ -199,6 +221,11 @@ Game::Game(const Json &jsonObj) :
 	// the contents of m_space->m_bodies must not change until after this call
 	Pi::luaSerializer->LoadComponents(jsonObj, m_space.get());
 
+	// the body and frame trees are the bulk of the save; free them before
+	// the lua modules are loaded
+	jsonObj.erase("space");
+	jsonObj.erase("hyperspace_clouds");
+
 	// lua
 	Pi::luaSerializer->FromJson(jsonObj);
 
@@ -242,9 +269,9 @@ void Game::ToJson(Json &jsonObj)
 
 	// hyperspace clouds being brought over from the previous system
 	Json hyperspaceCloudArray = Json::array(); // Create JSON array to contain hyperspace cloud data.
-	for (std::list<HyperspaceCloud *>::const_iterator i = m_hyperspaceClouds.begin(); i != m_hyperspaceClouds.end(); ++i) {
+	for (HyperspaceCloud *cloud : m_hyperspaceClouds) {
 		Json hyperspaceCloudArrayEl = Json::object(); // Create JSON object to contain hyperspace cloud.
-		(*i)->ToJson(hyperspaceCloudArrayEl, m_space.get());
+		cloud->ToJson(hyperspaceCloudArrayEl, m_space.get());
 		hyperspaceCloudArray.push_back(hyperspaceCloudArrayEl); // Append hyperspace cloud object to array.
 	}
 	jsonObj["hyperspace_clouds"] = hyperspaceCloudArray; // Add hyperspace cloud array to supplied object.
@@ -437,7 +464,7 @@ double Game::GetHyperspaceArrivalProbability() const
 
 void Game::RemoveHyperspaceCloud(HyperspaceCloud *cloud)
 {
-	m_hyperspaceClouds.remove(cloud);
+	m_hyperspaceClouds.erase(std::remove(m_hyperspaceClouds.begin(), m_hyperspaceClouds.end(), cloud), m_hyperspaceClouds.end());
 }
 
 void Game::SwitchToHyperspace()
@@ -513,9 +540,99 @@ void Game::SwitchToHyperspace()
 	m_state = State::HYPERSPACE;
 	m_wantHyperspace = false;
 
+	PrefetchRoute();
+
 	Output("Started hyperspacing...\n");
 }
 
+// how many jumps of the plotted route past the destination to prefetch
+static const size_t ROUTE_PREFETCH_JUMPS = 4;
+// the cube of sectors prefetched around each system along the way
+static const int ROUTE_PREFETCH_SECTOR_RADIUS = 2;
+
+void Game::PrefetchRoute()
+{
+	PROFILE_SCOPED()
+
+	// the destination first, then the rest of the route if we're on it
+	std::vector<SystemPath> waypoints = { m_hyperspaceDest };
+	if (m_gameViews && GetSectorView()) {
+		const std::vector<SystemPath> route = GetSectorView()->GetRoute();
+		auto it = std::find_if(route.begin(), route.end(),
+			[this](const SystemPath &path) { return path.IsSameSystem(m_hyperspaceDest); });
+		if (it != route.end())
+			for (++it; it != route.end() && waypoints.size() <= ROUTE_PREFETCH_JUMPS; ++it)
+				waypoints.push_back(*it);
+	}
+
+	// each waypoint's sectors nearest first, so the destination is ready soonest
+	FlatHashMap<SystemPath, bool, SystemPath::HashSectorOnly, SystemPath::EqualSectorOnly> seen;
+	SectorCache::PathVector sectors;
+	const int r = ROUTE_PREFETCH_SECTOR_RADIUS;
+	for (const SystemPath &waypoint : waypoints) {
+		const size_t first = sectors.size();
+		for (int x = waypoint.sectorX - r; x <= waypoint.sectorX + r; x++) {
+			for (int y = waypoint.sectorY - r; y <= waypoint.sectorY + r; y++) {
+				for (int z = waypoint.sectorZ - r; z <= waypoint.sectorZ + r; z++) {
+					const SystemPath path(x, y, z);
+					if (seen.find(path) != seen.end())
+						continue;
+					seen[path] = true;
+					sectors.push_back(path);
+				}
+			}
+		}
+		auto distSqr = [&waypoint](const SystemPath &a) {
+			return vector3f(a.sectorX - waypoint.sectorX, a.sectorY - waypoint.sectorY, a.sectorZ - waypoint.sectorZ).LengthSqr();
+		};
+		std::sort(sectors.begin() + first, sectors.end(),
+			[&distSqr](const SystemPath &a, const SystemPath &b) { return distSqr(a) < distSqr(b); });
+	}
+
+	// replacing the caches cancels whatever the last jump hadn't got to
+	m_routeSectorCache = m_galaxy->NewSectorSlaveCache();
+	m_routeStarSystemCache = m_galaxy->NewStarSystemSlaveCache();
+
+	// the destination itself is generated in full, then the arrival is
+	// prepared from it before we get there
+	m_routeStarSystemCache->FillCache({ m_hyperspaceDest.SystemOnly() }, [this]() { PrepareArrival(); });
+
+	m_routeSectorCache->FillCache(sectors, [this, sectors]() {
+		// as far as the sector map and route planning look
+		StarSystemCache::PathVector systems;
+		for (const SystemPath &sectorPath : sectors) {
+			RefCountedPtr<Sector> sec = m_routeSectorCache->GetIfCached(sectorPath);
+			if (!sec)
+				continue;
+			for (const Sector::System &ss : sec->m_systems)
+				systems.push_back(ss.GetPath());
+		}
+		m_routeStarSystemCache->FillCache(systems, StarSystemCache::CacheFilledCallback(), StarSystem::GENERATED_POPULATION);
+	});
+}
+
+void Game::PrepareArrival()
+{
+	PROFILE_SCOPED()
+	// the jump may have ended, or a new one started, while the system was generated
+	if (m_state != State::HYPERSPACE || !m_routeStarSystemCache)
+		return;
+	RefCountedPtr<StarSystem> system = m_routeStarSystemCache->GetIfCached(m_hyperspaceDest);
+	if (!system)
+		return;
+
+	// the Space itself has to be built on arrival, its frames and bodies
+	// can't be made while the hyperspace ones exist, but the stars of the
+	// new background and the station models can be ready by then
+	m_space->PrefetchBackground(system->GetPath());
+	for (const SystemBody *sbody : system->GetSpaceStations()) {
+		Random rand(sbody->GetSeed());
+		const SpaceStationType *type = SpaceStationType::ForSystemBody(sbody, rand);
+		if (type)
+			Pi::modelCache->FindModelAsync(type->ModelName());
+	}
+}
+
 void Game::SwitchToNormalSpace()
 {
 	PROFILE_SCOPED()
@@ -551,8 +668,8 @@ void Game::SwitchToNormalSpace()
 	cloud->SetPosition(m_player->GetPosition());
 	m_space->AddBody(cloud);
 
-	for (std::list<HyperspaceCloud *>::iterator i = m_hyperspaceClouds.begin(); i != m_hyperspaceClouds.end(); ++i) {
-		cloud = *i;
+	for (HyperspaceCloud *arrival : m_hyperspaceClouds) {
+		cloud = arrival;
 
 		cloud->SetFrame(m_space->GetRootFrame());
 		cloud->SetPosition(m_space->GetHyperspaceExitPoint(m_hyperspaceSource, m_hyperspaceDest));
@@ -894,7 +1011,10 @@ void Game::EmitPauseState(bool paused)
 
 Json Game::LoadGameToJson(const std::string &filename)
 {
-	Json rootNode = JsonUtils::LoadJsonSaveFile(FileSystem::JoinPathBelow(Pi::SAVE_DIR_NAME, filename), FileSystem::userFiles);
+	// the file may still be being written
+	FinishPendingSave();
+
+	Json rootNode = JsonUtils::LoadJsonSaveFile(FileSystem::JoinPathBelow(Pi::SAVE_DIR_NAME, filename), FileSystem::userFiles, Pi::GetApp()->GetTaskGraph());
 	if (!rootNode.is_object()) {
 		Output("Loading saved game '%s' failed.\n", filename.c_str());
 		throw SavedGameCorruptException();
@@ -903,6 +1023,19 @@ Json Game::LoadGameToJson(const std::string &filename)
 		Output("Loading saved game '%s' failed: wrong save file version.\n", filename.c_str());
 		throw SavedGameCorruptException();
 	}
+
+	// delta saves are a journal on top of a full base save
+	if (rootNode.count("delta")) {
+		Json baseNode = JsonUtils::LoadJsonSaveFile(DeltaBasePath(filename), FileSystem::userFiles, Pi::GetApp()->GetTaskGraph());
+		if (!baseNode.is_object() || baseNode["delta_id"] != rootNode["delta_base_id"]) {
+			Output("Loading saved game '%s' failed: missing or mismatched base save.\n", filename.c_str());
+			throw SavedGameCorruptException();
+		}
+		baseNode.erase("delta_id");
+		SaveDelta::ApplyDelta(baseNode, rootNode["delta"]);
+		return baseNode;
+	}
+
 	return rootNode;
 }
 
@@ -921,6 +1054,18 @@ Game *Game::LoadGame(const std::string &filename)
 	}
 }
 
+Json Game::LoadGameInfo(const std::string &filename)
+{
+	// the file may still be being written
+	FinishPendingSave();
+
+	try {
+		return JsonUtils::LoadSaveFileHeader(FileSystem::JoinPathBelow(Pi::SAVE_DIR_NAME, filename), FileSystem::userFiles);
+	} catch (const std::invalid_argument &) {
+		return nullptr;
+	}
+}
+
 bool Game::CanLoadGame(const std::string &filename)
 {
 	FILE *f;
@@ -944,57 +1089,254 @@ bool Game::DeleteSave(const std::string &filename)
 	} catch (const std::invalid_argument &) {
 		return false;
 	}
+	// remove the full save a delta save was written against, if there is one
+	FileSystem::userFiles.RemoveFile(DeltaBasePath(filename));
 	return FileSystem::userFiles.RemoveFile(filePath);
 }
 
-void Game::SaveGame(const std::string &filename, Game *game)
-{
-	PROFILE_SCOPED()
-	assert(game);
+namespace {
+	// checks that the game can be saved and opens the save file for writing
+	FILE *OpenSaveFile(const std::string &filename, Game *game)
+	{
+		if (game->IsHyperspace())
+			throw CannotSaveInHyperspace();
+
+		if (game->GetPlayer()->IsDead())
+			throw CannotSaveDeadPlayer();
+
+		if (!FileSystem::userFiles.MakeDirectory(Pi::SAVE_DIR_NAME))
+			throw CouldNotOpenFileException();
+
+		if (!FileSystem::IsValidFilename(filename))
+			throw std::invalid_argument(filename);
+		FILE *f;
+		try {
+			f = FileSystem::userFiles.OpenWriteStream(FileSystem::JoinPathBelow(Pi::SAVE_DIR_NAME, filename));
+		} catch (const std::invalid_argument &) {
+			throw CouldNotOpenFileException();
+		}
+		if (!f)
+			throw CouldNotOpenFileException();
+		return f;
+	}
 
-	if (game->IsHyperspace())
-		throw CannotSaveInHyperspace();
+	// LZ4 compresses several times faster than gzip, for somewhat larger files
+	bool UseLZ4Compression()
+	{
+		return Pi::config->Int("SaveGameLZ4") != 0;
+	}
 
-	if (game->GetPlayer()->IsDead())
-		throw CannotSaveDeadPlayer();
+	// encodes, compresses and writes the save data, closing the file.
+	// Only touches its arguments, so it is safe to call from a worker thread;
+	// the compression is spread over the task graph from there as well.
+	void WriteSaveFile(const Json &rootNode, const std::string &filename, FILE *f, bool useLZ4)
+	{
+		// the load screen only reads this header, see Game::LoadGameInfo
+		Json metadata = Json::object();
+		metadata["version"] = rootNode["version"];
+		metadata["time"] = rootNode["time"];
+		metadata["game_info"] = rootNode["game_info"];
+		const std::string header = JsonUtils::EncodeSaveFileHeader(metadata);
+
+		try {
+			// Encode the JSON data as CBOR and compress it, in separately
+			// compressed chunks that can be decoded in parallel on load
+			const std::string comressed_data = JsonUtils::EncodeSaveFileData(rootNode, useLZ4, filename + ".json", Pi::GetApp()->GetTaskGraph());
+			size_t nwritten = fwrite(header.data(), header.size(), 1, f);
+			nwritten += fwrite(comressed_data.data(), comressed_data.size(), 1, f);
+			fclose(f);
+			if (nwritten != 2) throw CouldNotWriteToFileException();
+		} catch (gzip::CompressionFailedException) {
+			fclose(f);
+			throw CouldNotWriteToFileException();
+		} catch (const lz4::CompressionFailedException &) {
+			fclose(f);
+			throw CouldNotWriteToFileException();
+		}
+	}
 
-	if (!FileSystem::userFiles.MakeDirectory(Pi::SAVE_DIR_NAME))
-		throw CouldNotOpenFileException();
+	// Delta saves write a journal holding only the sections that changed
+	// since a full base save. The section hashes of the base only live in
+	// memory, so the first delta save of a session always writes a new base.
+	struct DeltaSaveState {
+		std::string filename; // the save the current base belongs to
+		uint64_t baseId = 0;
+		SaveDelta::SectionHashes hashes;
+		int numDeltas = 0;
+	};
+	DeltaSaveState s_deltaState;
+
+	// everything needed to write a save once the game state is captured
+	struct SaveRequest {
+		Json rootNode;
+		std::string filename;
+		FILE *file = nullptr;
+		FILE *baseFile = nullptr; // set when a delta save writes a new base
+		bool delta = false;
+		bool useLZ4 = false;
+		size_t jsonBytes = 0; // accounted in MemoryStats while the request lives
+
+		~SaveRequest()
+		{
+			MemoryStats::Sub(MemoryStats::TAG_SAVE_JSON, jsonBytes);
+			// only left open if the save was abandoned before it was written
+			if (file)
+				fclose(file);
+			if (baseFile)
+				fclose(baseFile);
+		}
+	};
 
-	if (!FileSystem::IsValidFilename(filename))
-		throw std::invalid_argument(filename);
-	FILE *f;
-	try {
-		f = FileSystem::userFiles.OpenWriteStream(FileSystem::JoinPathBelow(Pi::SAVE_DIR_NAME, filename));
-	} catch (const std::invalid_argument &) {
-		throw CouldNotOpenFileException();
-	}
-	if (!f)
-		throw CouldNotOpenFileException();
-	Json rootNode;
-	game->ToJson(rootNode); // Encode the game data as JSON and give to the root value.
-	std::vector<uint8_t> jsonData;
+	// Captures the game state and opens the files for a save. Delta saves
+	// open a new base file when compacting: when there is no base for this
+	// save yet, or once enough journals have been written against it.
+	void PrepareSave(SaveRequest &req, const std::string &filename, Game *game, bool delta)
 	{
-		PROFILE_SCOPED_DESC("json.to_cbor");
-		jsonData = Json::to_cbor(rootNode); // Convert the JSON data to CBOR.
+		req.file = OpenSaveFile(filename, game);
+		req.filename = filename;
+		req.delta = delta;
+		req.useLZ4 = UseLZ4Compression();
+
+		if (!delta) {
+			// the journal for this save has been overwritten
+			if (s_deltaState.filename == filename)
+				s_deltaState = DeltaSaveState();
+		} else if (s_deltaState.filename != filename || s_deltaState.numDeltas >= Pi::config->Int("DeltaSaveCompactInterval")) {
+			s_deltaState = DeltaSaveState();
+			const std::string baseDir = FileSystem::JoinPath(Pi::SAVE_DIR_NAME, s_deltaBaseDir);
+			if (FileSystem::userFiles.MakeDirectory(baseDir))
+				req.baseFile = FileSystem::userFiles.OpenWriteStream(DeltaBasePath(filename));
+			if (!req.baseFile)
+				throw CouldNotOpenFileException();
+		}
+
+		game->ToJson(req.rootNode); // Encode the game data as JSON and give to the root value.
 	}
 
-	try {
-		// Compress the CBOR data.
-		const std::string comressed_data = gzip::CompressGZip(
-			std::string(reinterpret_cast<const char *>(jsonData.data()), jsonData.size()),
-			filename + ".json");
-		size_t nwritten = fwrite(comressed_data.data(), comressed_data.size(), 1, f);
-		fclose(f);
-		if (nwritten != 1) throw CouldNotWriteToFileException();
-	} catch (gzip::CompressionFailedException) {
-		fclose(f);
-		throw CouldNotWriteToFileException();
+	// Writes a prepared save. Delta saves touch s_deltaState, which is safe
+	// from a worker as saves are never written concurrently.
+	void WriteSave(SaveRequest &req)
+	{
+		// measured here rather than in PrepareSave, as this may run on a worker
+		req.jsonBytes = MemoryStats::EstimateJsonBytes(req.rootNode);
+		MemoryStats::Add(MemoryStats::TAG_SAVE_JSON, req.jsonBytes);
+
+		FILE *f = req.file;
+		req.file = nullptr;
+		if (!req.delta) {
+			WriteSaveFile(req.rootNode, req.filename, f, req.useLZ4);
+			return;
+		}
+
+		if (req.baseFile) {
+			FILE *baseFile = req.baseFile;
+			req.baseFile = nullptr;
+			const uint64_t baseId = SDL_GetPerformanceCounter();
+			req.rootNode["delta_id"] = baseId;
+			try {
+				WriteSaveFile(req.rootNode, req.filename, baseFile, req.useLZ4);
+			} catch (const CouldNotWriteToFileException &) {
+				fclose(f);
+				throw;
+			}
+			req.rootNode.erase("delta_id");
+
+			SaveDelta::HashSections(req.rootNode, s_deltaState.hashes);
+			s_deltaState.filename = req.filename;
+			s_deltaState.baseId = baseId;
+		}
+
+		Json journal = Json::object();
+		journal["version"] = req.rootNode["version"];
+		journal["time"] = req.rootNode["time"];
+		journal["game_info"] = req.rootNode["game_info"];
+		journal["delta_base_id"] = s_deltaState.baseId;
+		journal["delta"] = SaveDelta::MakeDelta(req.rootNode, s_deltaState.hashes);
+		WriteSaveFile(journal, req.filename, f, req.useLZ4);
+		s_deltaState.numDeltas++;
 	}
 
+	// Does the encoding, compression and file write of a save on a worker.
+	// The game state is captured in the Json tree before the job is queued.
+	class SaveGameJob : public Job {
+	public:
+		SaveGameJob(std::unique_ptr<SaveRequest> req) :
+			m_req(std::move(req)),
+			m_success(false)
+		{}
+
+		void OnRun() override
+		{
+			PROFILE_SCOPED()
+			try {
+				WriteSave(*m_req);
+				m_success = true;
+			} catch (const CouldNotWriteToFileException &) {
+				m_success = false;
+			}
+			m_req->rootNode = Json();
+		}
+
+		void OnFinish() override
+		{
+			if (!m_success)
+				Output("Failed to write saved game '%s'\n", m_req->filename.c_str());
+			LuaEvent::Queue("onGameSaved", m_req->filename, m_success);
+		}
+
+	private:
+		std::unique_ptr<SaveRequest> m_req;
+		bool m_success;
+	};
+
+	// the background save currently being written, if any
+	Job::Handle s_pendingSave;
+} // namespace
+
+void Game::SaveGame(const std::string &filename, Game *game, bool delta)
+{
+	PROFILE_SCOPED()
+	assert(game);
+
+	// don't let an older background save overwrite this one
+	FinishPendingSave();
+
+	SaveRequest req;
+	PrepareSave(req, filename, game, delta);
+	WriteSave(req);
+
 	Pi::GetApp()->RequestProfileFrame("SaveGame");
 }
 
+void Game::SaveGameAsync(const std::string &filename, Game *game, bool delta)
+{
+	PROFILE_SCOPED()
+	assert(game);
+
+	// saves are written in the order they were requested
+	FinishPendingSave();
+
+	std::unique_ptr<SaveRequest> req(new SaveRequest());
+	PrepareSave(*req, filename, game, delta);
+
+	s_pendingSave = Pi::GetAsyncJobQueue()->Queue(new SaveGameJob(std::move(req)));
+}
+
+bool Game::IsSavePending()
+{
+	return s_pendingSave.HasJob();
+}
+
+void Game::FinishPendingSave()
+{
+	PROFILE_SCOPED()
+	while (s_pendingSave.HasJob()) {
+		Pi::GetAsyncJobQueue()->FinishJobs();
+		if (s_pendingSave.HasJob())
+			SDL_Delay(1);
+	}
+}
+
 int Game::CurrentSaveVersion()
 {
 	return s_saveVersion;
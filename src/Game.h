@@ -9,6 +9,7 @@
 #include "galaxy/SystemPath.h"
 #include "gameconsts.h"
 #include <string>
+#include <vector>
 
 class GameLog;
 class HyperspaceCloud;
@@ -38,20 +39,35 @@ class ObjectViewerView;
 class Game {
 public:
 	static Json LoadGameToJson(const std::string &filename);
+	// Reads just the metadata (version, time, game_info) stored at the start
+	// of a save, without decompressing the rest. Returns null for saves
+	// written before the metadata header was added.
+	static Json LoadGameInfo(const std::string &filename);
 	// LoadGame and SaveGame throw exceptions on failure
 	static Game *LoadGame(const std::string &filename);
 	static bool CanLoadGame(const std::string &filename);
 	// XXX game arg should be const, and this should probably be a member function
 	// (or LoadGame/SaveGame should be somewhere else entirely)
-	static void SaveGame(const std::string &filename, Game *game);
+	// Delta saves only write the parts of the game that changed since the
+	// last full save under the same name, which is rewritten periodically
+	// (see DeltaSaveCompactInterval). They load like any other save.
+	static void SaveGame(const std::string &filename, Game *game, bool delta = false);
+	// Captures the game state on the calling (main) thread, then encodes,
+	// compresses and writes it on a worker. Errors in checking the game or
+	// opening the file are thrown immediately; completion is reported by the
+	// onGameSaved Lua event.
+	static void SaveGameAsync(const std::string &filename, Game *game, bool delta = false);
+	static bool IsSavePending();
+	// blocks until a background save has been written
+	static void FinishPendingSave();
 	static bool DeleteSave(const std::string &filename);
 	static int CurrentSaveVersion();
 
 	// start docked in station referenced by path or nearby to body if it is no station
 	Game(const SystemPath &path, const double startDateTime, const char *shipType = "kanara");
 
-	// load game
-	Game(const Json &jsonObj);
+	// load game. Sections of jsonObj are freed once they have been consumed.
+	Game(Json &jsonObj);
 
 	~Game();
 
@@ -156,6 +172,12 @@ private:
 
 	void SwitchToHyperspace();
 	void SwitchToNormalSpace();
+	// warms the galaxy caches around the hyperspace destination and the
+	// rest of the plotted route while the jump is under way
+	void PrefetchRoute();
+	// starts the arrival work that can run off the main thread once the
+	// destination system has been generated
+	void PrepareArrival();
 
 	std::unique_ptr<Player> m_player;
 
@@ -172,13 +194,18 @@ private:
 
 	bool m_wantHyperspace;
 
-	std::list<HyperspaceCloud *> m_hyperspaceClouds;
+	std::vector<HyperspaceCloud *> m_hyperspaceClouds;
 	SystemPath m_hyperspaceSource;
 	SystemPath m_hyperspaceDest;
 	double m_hyperspaceProgress;
 	double m_hyperspaceDuration;
 	double m_hyperspaceEndTime;
 
+	// held from one jump to the next, so what they fetched is still there
+	// after Space has replaced its own caches on arrival
+	RefCountedPtr<SectorCache::Slave> m_routeSectorCache;
+	RefCountedPtr<StarSystemCache::Slave> m_routeStarSystemCache;
+
 	TimeAccel m_timeAccel;
 	TimeAccel m_requestedTimeAccel;
 	bool m_forceTimeAccel;
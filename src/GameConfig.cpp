@@ -18,6 +18,13 @@ GameConfig::GameConfig(const map_string &override_)
 	map["UIScaleFactor"] = "1";
 	map["DetailCities"] = "1";
 	map["DetailPlanets"] = "1";
+	map["TerrainDiskCache"] = "0";
+	map["JsonDataCache"] = "1";
+	map["LuaBytecodeCache"] = "1";
+	map["GasGiantTextureCache"] = "1";
+	map["SVGImageCache"] = "1";
+	map["SectorCacheBudgetMB"] = "64";
+	map["StarSystemCacheBudgetMB"] = "64";
 	map["SfxVolume"] = "0.8";
 	map["EnableJoystick"] = "1";
 	map["InvertMouseY"] = "0";
@@ -39,11 +46,17 @@ GameConfig::GameConfig(const map_string &override_)
 	map["DefaultLowThrustPower"] = "0.25";
 	map["VSync"] = "1";
 	map["UseTextureCompression"] = "1";
+	map["TextureStreamingBudgetMB"] = "512";
 	map["WorkerThreads"] = "0";
+	map["WorkStealingScheduler"] = "0";
+	map["PinWorkerThreads"] = "0";
+	map["ReservedCores"] = "1";
+	map["MaxJobFinishMicros"] = "4000";
 	map["SpeedLines"] = "0";
 	map["EnableCockpit"] = "0";
 	map["HudTrails"] = "0";
 	map["EnableServerAgent"] = "0";
+	map["ServerAgentMaxRequests"] = "8";
 	map["AmountOfBackgroundStars"] = "0.25";
 	map["StarFieldStarSizeFactor"] = "0.7";
 	map["UseAnisotropicFiltering"] = "0";
@@ -51,8 +64,30 @@ GameConfig::GameConfig(const map_string &override_)
 	map["EnableGLDebug"] = "0";
 	map["EnableGPUJobs"] = "1";
 	map["GL3ForwardCompatible"] = "1";
+	map["SortDrawCommands"] = "0";
+	map["ShaderProgramCache"] = "1";
+	map["DynamicResolution"] = "0";
+	map["DynamicResolutionTargetMs"] = "14.0";
+	map["DynamicResolutionMinScale"] = "0.5";
+	map["LuaFrameBudgetedGC"] = "1";
+	map["LuaGCTargetFrameMs"] = "16.0";
+	map["LuaGCMinStepMs"] = "0.1";
+	map["LuaGCMaxStepMs"] = "2.0";
+	map["ShadowCascades"] = "0";
+	map["ShadowMapSize"] = "1024";
+	map["ShadowDistance"] = "2000.0";
+	map["ShadowStaticCascades"] = "1";
+	map["ShadowStaticRedraws"] = "1";
+	map["AtmosphereLUT"] = "0";
+	map["PreloadShipModels"] = "1";
+	map["RadarSweepRate"] = "4";
+	map["SaveGameLZ4"] = "0";
+	map["DeltaSaveCompactInterval"] = "10";
+	map["LogFile"] = "output.txt";
 	map["LogVerbose"] = "1";
+	map["AsyncLogging"] = "1";
 	map["ProfileSlowFrames"] = "0";
+	map["HitchThresholdMs"] = "100.0";
 	map["ProfilerZoneOutput"] = "0";
 	map["CameraSmoothing"] = "0";
 	map["AimingSensitivity"] = "1.0";
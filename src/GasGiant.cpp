@@ -4,6 +4,7 @@
 #include "GasGiant.h"
 
 #include "FileSystem.h"
+#include "GasGiantCache.h"
 #include "Game.h"
 #include "GameConfig.h"
 #include "Pi.h"
@@ -30,6 +31,7 @@ namespace {
 	static Uint32 s_noiseOctaves[5];
 	static float s_initialCPUDelayTime = 60.0f; // (perhaps) 60 seconds seems like a reasonable default
 	static float s_initialGPUDelayTime = 5.0f;	// (perhaps) 5 seconds seems like a reasonable default
+	static float s_gpuFrameBudget = 2.0f;		// milliseconds of face rendering per frame
 	static std::vector<GasGiant *> s_allGasGiants;
 
 	static const std::string GGJupiter("GGJupiter");
@@ -335,6 +337,15 @@ void GasGiant::Reset()
 				m_job[i].GetJob()->OnCancel();
 			m_hasJobRequest[i] = false;
 		}
+		// the GPU job can span several frames, drop it and its half-built texture
+		m_gpuJob = Job::Handle();
+		m_hasGpuJobRequest = false;
+		m_builtTexture.Reset();
+
+		for (int i = 0; i < NUM_PATCHES; i++) {
+			m_jobColorBuffers[i].reset();
+			m_jobCompressedFaces[i].clear();
+		}
 	}
 
 	for (int p = 0; p < NUM_PATCHES; p++) {
@@ -391,6 +402,7 @@ bool GasGiant::AddTextureFaceResult(GasGiantJobs::STextureFaceResult *res)
 	assert(res);
 	assert(res->face() >= 0 && res->face() < NUM_PATCHES);
 	m_jobColorBuffers[res->face()].reset(res->data().colors);
+	m_jobCompressedFaces[res->face()].swap(res->compressed());
 	m_hasJobRequest[res->face()] = false;
 	const Sint32 uvDims = res->data().uvDims;
 	assert(uvDims > 0 && uvDims <= 4096);
@@ -428,6 +440,9 @@ bool GasGiant::AddTextureFaceResult(GasGiantJobs::STextureFaceResult *res)
 			m_jobColorBuffers[i].reset();
 		}
 
+		// so the next visit can load rather than generate the texture
+		GasGiantCache::Save(GetSystemBody()->GetPath(), GetTerrain()->GetSeed(), uvDims, m_jobCompressedFaces);
+
 		// change the planet texture for the new higher resolution texture
 		if (m_surfaceMaterial.Get()) {
 			m_surfaceMaterial->SetTexture("texture0"_hash,
@@ -487,6 +502,15 @@ void GasGiant::GenerateTexture()
 
 	const bool bEnableGPUJobs = (Pi::config->Int("EnableGPUJobs") == 1);
 
+	// a texture generated on an earlier visit needs no placeholder
+	const Uint32 uvDims = bEnableGPUJobs ? s_texture_size_gpu[Pi::detail.planets] : s_texture_size_cpu[Pi::detail.planets];
+	m_surfaceTexture.Reset(GasGiantCache::Load(GetSystemBody()->GetPath(), GetTerrain()->GetSeed(), uvDims));
+	if (m_surfaceTexture.Valid()) {
+		if (m_surfaceMaterial.Get())
+			m_surfaceMaterial->SetTexture("texture0"_hash, m_surfaceTexture.Get());
+		return;
+	}
+
 	// scope the small texture generation
 	{
 		const vector2f texSize(1.0f, 1.0f);
@@ -583,7 +607,7 @@ void GasGiant::GenerateTexture()
 
 		GasGiantJobs::GenFaceQuad *pQuad = new GasGiantJobs::GenFaceQuad(Pi::renderer, vector2f(s_texture_size_gpu[Pi::detail.planets], s_texture_size_gpu[Pi::detail.planets]), GasGiantType);
 
-		GasGiantJobs::SGPUGenRequest *pGPUReq = new GasGiantJobs::SGPUGenRequest(GetSystemBody()->GetPath(), s_texture_size_gpu[Pi::detail.planets], GetTerrain(), GetSystemBody()->GetRadius(), hueShift, pQuad, m_builtTexture.Get());
+		GasGiantJobs::SGPUGenRequest *pGPUReq = new GasGiantJobs::SGPUGenRequest(GetSystemBody()->GetPath(), s_texture_size_gpu[Pi::detail.planets], GetTerrain(), GetSystemBody()->GetRadius(), hueShift, pQuad, m_builtTexture.Get(), s_gpuFrameBudget);
 		m_gpuJob = Pi::GetSyncJobQueue()->Queue(new GasGiantJobs::SingleGPUGenJob(pGPUReq));
 		m_hasGpuJobRequest = true;
 	}
@@ -721,6 +745,8 @@ void GasGiant::SetUpMaterials()
 			break;
 		}
 	}
+
+	SetUpAtmosphereLUT(Pi::renderer, ap);
 }
 
 void GasGiant::BuildFirstPatches()
@@ -757,6 +783,9 @@ void GasGiant::Init()
 
 	s_initialCPUDelayTime = Clamp(cfg.Float("cpu_delay_time", 60.0f), 0.0f, 120.0f);
 	s_initialGPUDelayTime = Clamp(cfg.Float("gpu_delay_time", 5.0f), 0.0f, 120.0f);
+	s_gpuFrameBudget = Clamp(cfg.Float("gpu_frame_budget", 2.0f), 0.0f, 100.0f);
+
+	GasGiantCache::Init(Pi::config->Int("GasGiantTextureCache") != 0);
 
 	if (s_patchContext.Get() == nullptr) {
 		s_patchContext.Reset(new GasPatchContext(127));
@@ -766,6 +795,7 @@ void GasGiant::Init()
 
 void GasGiant::Uninit()
 {
+	GasGiantCache::Uninit();
 	s_patchContext.Reset();
 }
 
@@ -39,6 +39,11 @@ public:
 	virtual void Render(Graphics::Renderer *renderer, const matrix4x4d &modelView, vector3d campos, const float radius, const std::vector<Camera::Shadow> &shadows) override;
 
 	virtual double GetHeight(const vector3d &p) const override final { return 0.0; }
+	virtual void GetHeights(const vector3d *p, double *heights, size_t count) const override final
+	{
+		for (size_t i = 0; i < count; i++)
+			heights[i] = 0.0;
+	}
 
 	// in sbody radii
 	virtual double GetMaxFeatureHeight() const override { return 0.0; }
@@ -79,6 +84,7 @@ private:
 	RefCountedPtr<Graphics::Texture> m_builtTexture;
 
 	std::unique_ptr<Color[]> m_jobColorBuffers[NUM_PATCHES];
+	std::vector<Uint8> m_jobCompressedFaces[NUM_PATCHES];
 	Job::Handle m_job[NUM_PATCHES];
 	bool m_hasJobRequest[NUM_PATCHES];
 
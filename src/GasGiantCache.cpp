@@ -0,0 +1,240 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "GasGiantCache.h"
+
+#include "FileSystem.h"
+#include "JobQueue.h"
+#include "Pi.h"
+#include "core/Log.h"
+#include "galaxy/SystemPath.h"
+#include "graphics/Renderer.h"
+#include "graphics/Texture.h"
+#include "graphics/TextureCompress.h"
+#include "profiler/Profiler.h"
+
+#include "PicoDDS/PicoDDS.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+namespace {
+	static const char CACHE_DIR_NAME[] = "gasgiant_cache";
+	// bump whenever the generated textures change
+	static const Uint32 CACHE_VERSION = 1;
+	static const int NUM_FACES = 6;
+	static const size_t DDS_HEADER_SIZE = 128;
+
+	std::atomic<bool> s_enabled(false);
+	std::unique_ptr<JobSet> s_saveJobs;
+
+	std::string GetFileName(const SystemPath &path, Uint32 seed, int uvDims)
+	{
+		return FileSystem::JoinPathBelow(CACHE_DIR_NAME,
+			fmt::format("{}_{}_{}_{}_{}_{}_{:08x}_v{}.dds", path.sectorX, path.sectorY, path.sectorZ, path.systemIndex, path.bodyIndex,
+				uvDims, seed, CACHE_VERSION));
+	}
+
+	int GetNumMips(int uvDims)
+	{
+		int numMips = 1;
+		while (uvDims > 1) {
+			uvDims >>= 1;
+			numMips++;
+		}
+		return numMips;
+	}
+
+	size_t GetFaceSize(int uvDims)
+	{
+		size_t size = 0;
+		for (int dims = uvDims; dims > 1; dims >>= 1)
+			size += Graphics::GetBC1Size(dims, dims);
+		return size + Graphics::GetBC1Size(1, 1);
+	}
+
+	std::string MakeDDSHeader(int uvDims)
+	{
+		using namespace PicoDDS;
+		DDS::DDSStruct header;
+		memset(&header, 0, sizeof(header));
+		header.size = 124;
+		header.flags = DDS::DDSD_CAPS | DDS::DDSD_HEIGHT | DDS::DDSD_WIDTH | DDS::DDSD_PIXELFORMAT | DDS::DDSD_MIPMAPCOUNT | DDS::DDSD_LINEARSIZE;
+		header.height = uvDims;
+		header.width = uvDims;
+		header.sizeorpitch = Graphics::GetBC1Size(uvDims, uvDims);
+		header.mipmapcount = GetNumMips(uvDims);
+		header.pixelformat.size = 32;
+		header.pixelformat.flags = DDS::DDPF_FOURCC;
+		header.pixelformat.fourCC = FOURCC('D', 'X', 'T', '1');
+		header.ddscaps.caps1 = DDS::DDSCAPS_TEXTURE | DDS::DDSCAPS_COMPLEX | DDS::DDSCAPS_MIPMAP;
+		header.ddscaps.caps2 = DDS::DDSCAPS2_CUBEMAP | DDS::DDSCAPS2_CUBEMAP_POSITIVEX | DDS::DDSCAPS2_CUBEMAP_NEGATIVEX |
+			DDS::DDSCAPS2_CUBEMAP_POSITIVEY | DDS::DDSCAPS2_CUBEMAP_NEGATIVEY | DDS::DDSCAPS2_CUBEMAP_POSITIVEZ | DDS::DDSCAPS2_CUBEMAP_NEGATIVEZ;
+		static_assert(sizeof(header) == DDS_HEADER_SIZE - 4, "DDS header is padded");
+
+		std::string out("DDS ");
+		out.append(reinterpret_cast<const char *>(&header), sizeof(header));
+		return out;
+	}
+
+	// writes a finished cubemap on a worker thread
+	class SaveJob : public Job {
+	public:
+		SaveJob(const std::string &fileName, std::string &&data) :
+			Job(PRIORITY_LOW),
+			m_fileName(fileName),
+			m_data(std::move(data))
+		{}
+
+		virtual void OnRun() override
+		{
+			PROFILE_SCOPED()
+			// write to a file of this thread's own, then move it into place, so
+			// a load never reads a partly written file
+			const std::string tempName = fmt::format("{}.{}.tmp", m_fileName, std::hash<std::thread::id>()(std::this_thread::get_id()));
+			FILE *f = FileSystem::userFiles.OpenWriteStream(tempName);
+			if (!f)
+				return;
+			const bool written = fwrite(m_data.data(), m_data.size(), 1, f) == 1;
+			fclose(f);
+
+			const std::string root = FileSystem::userFiles.GetRoot();
+			const std::string tempPath = FileSystem::JoinPathBelow(root, tempName);
+			const std::string filePath = FileSystem::JoinPathBelow(root, m_fileName);
+			bool moved = written && std::rename(tempPath.c_str(), filePath.c_str()) == 0;
+			if (written && !moved) {
+				// rename() doesn't replace an existing file everywhere
+				std::remove(filePath.c_str());
+				moved = std::rename(tempPath.c_str(), filePath.c_str()) == 0;
+			}
+			if (!moved)
+				std::remove(tempPath.c_str());
+		}
+
+		virtual void OnFinish() override {}
+
+	private:
+		std::string m_fileName;
+		std::string m_data;
+	};
+} // namespace
+
+namespace GasGiantCache {
+
+	void Init(bool enabled)
+	{
+		s_enabled = enabled;
+		if (enabled && !FileSystem::userFiles.MakeDirectory(CACHE_DIR_NAME)) {
+			Log::Warning("Could not create the gas giant texture cache directory, disabling it.\n");
+			s_enabled = false;
+		}
+		if (s_enabled && !s_saveJobs)
+			s_saveJobs.reset(new JobSet(Pi::GetAsyncJobQueue()));
+	}
+
+	void Uninit()
+	{
+		s_saveJobs.reset();
+		s_enabled = false;
+	}
+
+	bool IsEnabled()
+	{
+		return s_enabled;
+	}
+
+	void CompressFace(const Color *colors, int uvDims, std::vector<Uint8> &out)
+	{
+		PROFILE_SCOPED()
+		out.resize(GetFaceSize(uvDims));
+		Uint8 *dst = out.data();
+
+		// box filter each level from the one above
+		std::vector<Color> mip;
+		std::vector<Color> nextMip;
+		const Color *src = colors;
+		for (int dims = uvDims;; dims >>= 1) {
+			Graphics::CompressBC1(src, dims, dims, dst);
+			dst += Graphics::GetBC1Size(dims, dims);
+			if (dims == 1)
+				break;
+
+			const int half = dims >> 1;
+			nextMip.resize(half * half);
+			for (int y = 0; y < half; y++) {
+				for (int x = 0; x < half; x++) {
+					const Color *c = src + (y * 2) * dims + x * 2;
+					nextMip[y * half + x] = Color(
+						(c[0].r + c[1].r + c[dims].r + c[dims + 1].r + 2) / 4,
+						(c[0].g + c[1].g + c[dims].g + c[dims + 1].g + 2) / 4,
+						(c[0].b + c[1].b + c[dims].b + c[dims + 1].b + 2) / 4,
+						255);
+				}
+			}
+			mip.swap(nextMip);
+			src = mip.data();
+		}
+		assert(dst == out.data() + out.size());
+	}
+
+	Graphics::Texture *Load(const SystemPath &path, Uint32 seed, int uvDims)
+	{
+		if (!s_enabled)
+			return nullptr;
+
+		PROFILE_SCOPED()
+		RefCountedPtr<FileSystem::FileData> file = FileSystem::userFiles.ReadFile(GetFileName(path, seed, uvDims));
+		// also rejects partly written files
+		const size_t faceSize = GetFaceSize(uvDims);
+		if (!file || file->GetSize() != DDS_HEADER_SIZE + faceSize * NUM_FACES)
+			return nullptr;
+
+		PicoDDS::DDSImage dds;
+		if (!dds.Read(file->GetData(), file->GetSize()))
+			return nullptr;
+		const PicoDDS::LoaderImgData &img = dds.imgdata_;
+		if (img.format != PicoDDS::FORMAT_DXT1 || img.width != uvDims || img.height != uvDims ||
+			img.numImages != NUM_FACES || img.numMipMaps != GetNumMips(uvDims))
+			return nullptr;
+
+		const vector3f dataSize(uvDims, uvDims, 0.0f);
+		const Graphics::TextureDescriptor texDesc(
+			Graphics::TEXTURE_DXT1,
+			dataSize, vector2f(1.0f, 1.0f), Graphics::LINEAR_CLAMP,
+			true, false, false, img.numMipMaps, Graphics::TEXTURE_CUBE_MAP);
+		Graphics::Texture *texture = Pi::renderer->CreateTexture(texDesc);
+
+		// faces are stored one after another, each with its own mip chain
+		Graphics::TextureCubeData tcd;
+		tcd.posX = img.imgData + 0 * faceSize;
+		tcd.negX = img.imgData + 1 * faceSize;
+		tcd.posY = img.imgData + 2 * faceSize;
+		tcd.negY = img.imgData + 3 * faceSize;
+		tcd.posZ = img.imgData + 4 * faceSize;
+		tcd.negZ = img.imgData + 5 * faceSize;
+		texture->Update(tcd, dataSize, Graphics::TEXTURE_DXT1, img.numMipMaps);
+		return texture;
+	}
+
+	void Save(const SystemPath &path, Uint32 seed, int uvDims, std::vector<Uint8> *faces)
+	{
+		if (!s_enabled)
+			return;
+
+		const size_t faceSize = GetFaceSize(uvDims);
+		std::string data = MakeDDSHeader(uvDims);
+		data.reserve(DDS_HEADER_SIZE + faceSize * NUM_FACES);
+		for (int i = 0; i < NUM_FACES; i++) {
+			if (faces[i].size() != faceSize)
+				return;
+			data.append(reinterpret_cast<const char *>(faces[i].data()), faces[i].size());
+			std::vector<Uint8>().swap(faces[i]);
+		}
+
+		s_saveJobs->Order(new SaveJob(GetFileName(path, seed, uvDims), std::move(data)));
+	}
+
+} // namespace GasGiantCache
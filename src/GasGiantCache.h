@@ -0,0 +1,44 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _GASGIANTCACHE_H
+#define _GASGIANTCACHE_H
+
+#include "Color.h"
+
+#include <cstddef>
+#include <vector>
+
+class SystemPath;
+
+namespace Graphics {
+	class Texture;
+} // namespace Graphics
+
+// On-disk cache of generated gas giant cubemaps.
+//
+// A gas giant's texture is fully determined by its body and the texture
+// size, so revisiting one can read its cubemap back rather than generate it
+// again. Each cubemap is stored as a BC1 (DXT1) compressed DDS file with a
+// full mip chain under the user directory, keyed by the body's SystemPath,
+// the texture size and the terrain seed.
+//
+// Faces are compressed with CompressFace() on the worker threads generating
+// them; the cache only ever writes files from worker threads, and Load() is
+// called from the main thread as it creates the texture.
+namespace GasGiantCache {
+	void Init(bool enabled);
+	void Uninit();
+	bool IsEnabled();
+
+	// Compresses one generated face and its mip chain for Save().
+	void CompressFace(const Color *colors, int uvDims, std::vector<Uint8> &out);
+
+	// Returns the cached cubemap, or nullptr if there isn't a usable one.
+	Graphics::Texture *Load(const SystemPath &path, Uint32 seed, int uvDims);
+	// Queues writing the six faces from CompressFace() to the cache,
+	// in cubemap face order; the faces are moved from.
+	void Save(const SystemPath &path, Uint32 seed, int uvDims, std::vector<Uint8> *faces);
+} // namespace GasGiantCache
+
+#endif /* _GASGIANTCACHE_H */
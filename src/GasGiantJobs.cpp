@@ -4,6 +4,7 @@
 #include "GasGiantJobs.h"
 
 #include "GasGiant.h"
+#include "GasGiantCache.h"
 #include "Pi.h"
 #include "RefCounted.h"
 #include "graphics/Frustum.h"
@@ -45,13 +46,17 @@ namespace GasGiantJobs {
 
 	// RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
 	// Use only data local to this object
-	void STextureFaceRequest::OnRun()
+	bool STextureFaceRequest::OnRun(const Job &job)
 	{
 		PROFILE_SCOPED()
 
 		assert(corners != nullptr);
 		double fracStep = 1.0 / double(UVDims() - 1);
 		for (Sint32 v = 0; v < UVDims(); v++) {
+			// stop early if the gas giant no longer wants this face
+			if (job.IsCancelled())
+				return false;
+
 			for (Sint32 u = 0; u < UVDims(); u++) {
 				// where in this row & column are we now.
 				const double ustep = double(u) * fracStep;
@@ -70,6 +75,7 @@ namespace GasGiantJobs {
 				col[0].a = 255;
 			}
 		}
+		return true;
 	}
 
 	// ********************************************************************************
@@ -88,11 +94,14 @@ namespace GasGiantJobs {
 	void SingleTextureFaceJob::OnRun() // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
 	{
 		PROFILE_SCOPED()
-		mData->OnRun();
+		if (!mData->OnRun(*this))
+			return;
 
 		// add this patches data
 		STextureFaceResult *sr = new STextureFaceResult(mData->Face());
 		sr->addResult(mData->Colors(), mData->UVDims());
+		if (GasGiantCache::IsEnabled())
+			GasGiantCache::CompressFace(mData->Colors(), mData->UVDims(), sr->compressed());
 
 		// store the result
 		mpResults = sr;
@@ -188,14 +197,15 @@ namespace GasGiantJobs {
 	}
 
 	// ********************************************************************************
-	SGPUGenRequest::SGPUGenRequest(const SystemPath &sysPath_, const Sint32 uvDIMs_, Terrain *pTerrain_, const float planetRadius_, const float hueAdjust_, GenFaceQuad *pQuad_, Graphics::Texture *pTex_) :
+	SGPUGenRequest::SGPUGenRequest(const SystemPath &sysPath_, const Sint32 uvDIMs_, Terrain *pTerrain_, const float planetRadius_, const float hueAdjust_, GenFaceQuad *pQuad_, Graphics::Texture *pTex_, const float frameBudget_) :
 		m_texture(pTex_),
 		sysPath(sysPath_),
 		uvDIMs(uvDIMs_),
 		pTerrain(pTerrain_),
 		planetRadius(planetRadius_),
 		hueAdjust(hueAdjust_),
-		pQuad(pQuad_)
+		pQuad(pQuad_),
+		frameBudget(frameBudget_)
 	{
 		PROFILE_SCOPED()
 		assert(m_texture.Valid());
@@ -239,7 +249,8 @@ namespace GasGiantJobs {
 	// ********************************************************************************
 	SingleGPUGenJob::SingleGPUGenJob(SGPUGenRequest *data) :
 		mData(data),
-		mpResults(nullptr)
+		mpResults(nullptr),
+		m_nextFace(0)
 	{ /* empty */
 	}
 	SingleGPUGenJob::~SingleGPUGenJob()
@@ -256,28 +267,48 @@ namespace GasGiantJobs {
 	{
 		PROFILE_SCOPED()
 
-		Graphics::Renderer::StateTicket ticket(Pi::renderer);
+		if (IsCancelled())
+			return;
+
+		// render as many faces as fit in this frame's budget, and the rest
+		// in later stages so a gas giant never stalls the frame
+		Profiler::Clock clock;
+		clock.Start();
+
+		{
+			Graphics::Renderer::StateTicket ticket(Pi::renderer);
+
+			// enter ortho
+			Pi::renderer->SetOrthographicProjection(0, mData->UVDims(), mData->UVDims(), 0, -1, 1);
+			Pi::renderer->SetTransform(matrix4x4f::Identity());
 
-		// enter ortho
-		Pi::renderer->SetOrthographicProjection(0, mData->UVDims(), mData->UVDims(), 0, -1, 1);
-		Pi::renderer->SetTransform(matrix4x4f::Identity());
+			// render to offscreen rt
+			Pi::renderer->SetRenderTarget(GasGiant::GetRenderTarget());
 
-		// render to offscreen rt
-		Pi::renderer->SetRenderTarget(GasGiant::GetRenderTarget());
+			do {
+				// render the scene
+				GasGiant::SetRenderTargetCubemap(m_nextFace, mData->Texture());
+				Pi::renderer->SetViewport({ 0, 0, mData->UVDims(), mData->UVDims() });
+				Pi::renderer->ClearScreen();
 
-		for (Uint32 iFace = 0; iFace < NUM_PATCHES; iFace++) {
-			// render the scene
-			GasGiant::SetRenderTargetCubemap(iFace, mData->Texture());
-			Pi::renderer->SetViewport({ 0, 0, mData->UVDims(), mData->UVDims() });
-			Pi::renderer->ClearScreen();
+				// draw to the texture here
+				mData->SetupMaterialParams(m_nextFace);
+				mData->Quad()->Draw(Pi::renderer);
 
-			// draw to the texture here
-			mData->SetupMaterialParams(iFace);
-			mData->Quad()->Draw(Pi::renderer);
+				// force the texture to be rendered before we modify the render target
+				// FIXME: use different render targets for each cubemap face
+				Pi::renderer->FlushCommandBuffers();
 
-			// force the texture to be rendered before we modify the render target
-			// FIXME: use different render targets for each cubemap face
-			Pi::renderer->FlushCommandBuffers();
+				++m_nextFace;
+				clock.SoftStop();
+			} while (m_nextFace < NUM_PATCHES && clock.milliseconds() < mData->FrameBudget());
+
+			// leave ortho when ticket is destroyed
+		}
+
+		if (m_nextFace < NUM_PATCHES) {
+			ContinueWithNextStage();
+			return;
 		}
 
 		// add this patches data
@@ -286,8 +317,6 @@ namespace GasGiantJobs {
 
 		// store the result
 		mpResults = sr;
-
-		// leave ortho when ticket is destroyed
 	}
 
 	void SingleGPUGenJob::OnFinish() // runs in primary thread of the context
@@ -15,6 +15,7 @@
 #include "vector3.h"
 
 #include <deque>
+#include <vector>
 
 namespace Graphics {
 	class Renderer;
@@ -51,7 +52,8 @@ namespace GasGiantJobs {
 
 		// RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
 		// Use only data local to this object
-		void OnRun();
+		// Returns false if the job was cancelled before the face was complete
+		bool OnRun(const Job &job);
 
 		Sint32 Face() const { return face; }
 		inline Sint32 UVDims() const { return uvDIMs; }
@@ -102,6 +104,8 @@ namespace GasGiantJobs {
 
 		inline const STextureFaceData &data() const { return mData; }
 		inline int32_t face() const { return mFace; }
+		// the face compressed for the texture cache, if it's enabled
+		std::vector<Uint8> &compressed() { return mCompressed; }
 
 		void OnCancel()
 		{
@@ -117,6 +121,7 @@ namespace GasGiantJobs {
 
 		const int32_t mFace;
 		STextureFaceData mData;
+		std::vector<Uint8> mCompressed;
 	};
 
 	// ********************************************************************************
@@ -165,12 +170,14 @@ namespace GasGiantJobs {
 	// ********************************************************************************
 	class SGPUGenRequest {
 	public:
-		SGPUGenRequest(const SystemPath &sysPath_, const Sint32 uvDIMs_, Terrain *pTerrain_, const float planetRadius_, const float hueAdjust_, GenFaceQuad *pQuad_, Graphics::Texture *pTex_);
+		SGPUGenRequest(const SystemPath &sysPath_, const Sint32 uvDIMs_, Terrain *pTerrain_, const float planetRadius_, const float hueAdjust_, GenFaceQuad *pQuad_, Graphics::Texture *pTex_, const float frameBudget_);
 
 		inline Sint32 UVDims() const { return uvDIMs; }
 		Graphics::Texture *Texture() const { return m_texture.Get(); }
 		GenFaceQuad *Quad() const { return pQuad.get(); }
 		const SystemPath &SysPath() const { return sysPath; }
+		// milliseconds of rendering allowed per frame before the remaining faces are deferred
+		float FrameBudget() const { return frameBudget; }
 		void SetupMaterialParams(const int face);
 
 	protected:
@@ -188,6 +195,7 @@ namespace GasGiantJobs {
 		const float planetRadius;
 		const float hueAdjust;
 		std::unique_ptr<GenFaceQuad> pQuad;
+		const float frameBudget;
 	};
 
 	// ********************************************************************************
@@ -219,6 +227,8 @@ namespace GasGiantJobs {
 
 	// ********************************************************************************
 	// Overloaded JobGPU class to handle generating the mesh for each patch
+	// Faces are rendered over as many stages (one per frame) as the request's
+	// frame budget needs, rather than all six at once.
 	// ********************************************************************************
 	class SingleGPUGenJob : public Job {
 	public:
@@ -236,6 +246,7 @@ namespace GasGiantJobs {
 
 		std::unique_ptr<SGPUGenRequest> mData;
 		SGPUGenResult *mpResults;
+		Uint32 m_nextFace;
 	};
 } // namespace GasGiantJobs
 
@@ -35,6 +35,8 @@
 
 // tri edge lengths
 static const double GEOPATCH_SUBDIVIDE_AT_CAMDIST = 5.0;
+// seconds for newly split patches to morph from their parent's shape
+static const float GEOPATCH_MORPH_TIME = 0.5f;
 
 GeoPatch::GeoPatch(const RefCountedPtr<GeoPatchContext> &ctx_, GeoSphere *gs,
 	const vector3d &v0_, const vector3d &v1_, const vector3d &v2_, const vector3d &v3_,
@@ -45,11 +47,15 @@ GeoPatch::GeoPatch(const RefCountedPtr<GeoPatchContext> &ctx_, GeoSphere *gs,
 	m_v2(v2_),
 	m_v3(v3_),
 	m_heights(nullptr),
+	m_baseHeight(0.0),
 	m_normals(nullptr),
 	m_colors(nullptr),
 	m_parent(nullptr),
 	m_geosphere(gs),
 	m_depth(depth),
+	m_morph(1.0f),
+	m_vertexSlot(-1),
+	m_vertexExtent(1.0f),
 	m_PatchID(ID_),
 	m_HasJobRequest(false)
 {
@@ -80,27 +86,31 @@ GeoPatch::~GeoPatch()
 	m_heights.reset();
 	m_normals.reset();
 	m_colors.reset();
+	if (m_vertexSlot >= 0)
+		m_ctx->FreeVertexSlot(m_vertexSlot);
 }
 
 void GeoPatch::UpdateVBOs(Graphics::Renderer *renderer)
 {
 	PROFILE_SCOPED()
-	if (m_needUpdateVBOs) {
+	if (m_needUpdateVBOs || IsMorphing()) {
 		assert(renderer);
+		// the first upload is at the parent's shape
+		if (!m_needUpdateVBOs)
+			m_morph = std::min(m_morph + Pi::GetFrameTime() / GEOPATCH_MORPH_TIME, 1.0f);
 		m_needUpdateVBOs = false;
+		const double morph = double(m_morph * m_morph * (3.0f - 2.0f * m_morph));
 
-		//create buffer and upload data
-		auto vbd = Graphics::VertexBufferDesc::FromAttribSet(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_NORMAL | Graphics::ATTRIB_DIFFUSE | Graphics::ATTRIB_UV0);
-		vbd.numVertices = m_ctx->NUMVERTICES();
-		vbd.usage = Graphics::BUFFER_USAGE_STATIC;
-		Graphics::VertexBuffer *vtxBuffer = renderer->CreateVertexBuffer(vbd);
-
-		GeoPatchContext::VBOVertex *VBOVtxPtr = vtxBuffer->Map<GeoPatchContext::VBOVertex>(Graphics::BUFFER_MAP_WRITE);
-		assert(vtxBuffer->GetDesc().stride == sizeof(GeoPatchContext::VBOVertex));
+		// vertices are built here, then packed into this patch's slot of
+		// the context's shared vertex buffers
+		static std::vector<GeoPatchContext::Vertex> s_vertices;
+		static std::vector<GeoPatchContext::VBOVertex> s_packedVertices;
+		s_vertices.resize(m_ctx->NUMVERTICES());
+		GeoPatchContext::Vertex *VBOVtxPtr = s_vertices.data();
 
 		const Sint32 edgeLen = m_ctx->GetEdgeLen();
 		const double frac = m_ctx->GetFrac();
-		const double *pHts = m_heights.get();
+		const PatchHeight *pHts = m_heights.get();
 		const vector3f *pNorm = m_normals.get();
 		const Color3ub *pColr = m_colors.get();
 
@@ -110,14 +120,16 @@ void GeoPatch::UpdateVBOs(Graphics::Renderer *renderer)
 		// inner loops
 		for (Sint32 y = 1; y < edgeLen - 1; y++) {
 			for (Sint32 x = 1; x < edgeLen - 1; x++) {
-				const double height = *pHts;
+				double height = PatchHeights::Decode(*pHts, m_baseHeight);
+				if (morph < 1.0)
+					height = GetParentHeight(x - 1, y - 1) + (height - GetParentHeight(x - 1, y - 1)) * morph;
 				minh = std::min(height, minh);
 				const double xFrac = double(x - 1) * frac;
 				const double yFrac = double(y - 1) * frac;
 				const vector3d p((GetSpherePoint(xFrac, yFrac) * (height + 1.0)) - m_clipCentroid);
 				m_clipRadius = std::max(m_clipRadius, p.Length());
 
-				GeoPatchContext::VBOVertex *vtxPtr = &VBOVtxPtr[x + (y * edgeLen)];
+				GeoPatchContext::Vertex *vtxPtr = &VBOVtxPtr[x + (y * edgeLen)];
 				vtxPtr->pos = vector3f(p);
 				++pHts; // next height
 
@@ -152,8 +164,8 @@ void GeoPatch::UpdateVBOs(Graphics::Renderer *renderer)
 			const double yFrac = double(y - 1) * frac;
 			const vector3d p((GetSpherePoint(xFrac, yFrac) * minhScale) - m_clipCentroid);
 
-			GeoPatchContext::VBOVertex *vtxPtr = &VBOVtxPtr[outerLeft + (y * edgeLen)];
-			GeoPatchContext::VBOVertex *vtxInr = &VBOVtxPtr[innerLeft + (y * edgeLen)];
+			GeoPatchContext::Vertex *vtxPtr = &VBOVtxPtr[outerLeft + (y * edgeLen)];
+			GeoPatchContext::Vertex *vtxInr = &VBOVtxPtr[innerLeft + (y * edgeLen)];
 			vtxPtr->pos = vector3f(p);
 			vtxPtr->norm = vtxInr->norm;
 			vtxPtr->col = vtxInr->col;
@@ -166,8 +178,8 @@ void GeoPatch::UpdateVBOs(Graphics::Renderer *renderer)
 			const double yFrac = double(y - 1) * frac;
 			const vector3d p((GetSpherePoint(xFrac, yFrac) * minhScale) - m_clipCentroid);
 
-			GeoPatchContext::VBOVertex *vtxPtr = &VBOVtxPtr[outerRight + (y * edgeLen)];
-			GeoPatchContext::VBOVertex *vtxInr = &VBOVtxPtr[innerRight + (y * edgeLen)];
+			GeoPatchContext::Vertex *vtxPtr = &VBOVtxPtr[outerRight + (y * edgeLen)];
+			GeoPatchContext::Vertex *vtxInr = &VBOVtxPtr[innerRight + (y * edgeLen)];
 			vtxPtr->pos = vector3f(p);
 			vtxPtr->norm = vtxInr->norm;
 			vtxPtr->col = vtxInr->col;
@@ -186,8 +198,8 @@ void GeoPatch::UpdateVBOs(Graphics::Renderer *renderer)
 			const double yFrac = double(y - 1) * frac;
 			const vector3d p((GetSpherePoint(xFrac, yFrac) * minhScale) - m_clipCentroid);
 
-			GeoPatchContext::VBOVertex *vtxPtr = &VBOVtxPtr[x + (outerTop * edgeLen)];
-			GeoPatchContext::VBOVertex *vtxInr = &VBOVtxPtr[x + (innerTop * edgeLen)];
+			GeoPatchContext::Vertex *vtxPtr = &VBOVtxPtr[x + (outerTop * edgeLen)];
+			GeoPatchContext::Vertex *vtxInr = &VBOVtxPtr[x + (innerTop * edgeLen)];
 			vtxPtr->pos = vector3f(p);
 			vtxPtr->norm = vtxInr->norm;
 			vtxPtr->col = vtxInr->col;
@@ -200,8 +212,8 @@ void GeoPatch::UpdateVBOs(Graphics::Renderer *renderer)
 			const double yFrac = double(y - 1) * frac;
 			const vector3d p((GetSpherePoint(xFrac, yFrac) * minhScale) - m_clipCentroid);
 
-			GeoPatchContext::VBOVertex *vtxPtr = &VBOVtxPtr[x + (outerBottom * edgeLen)];
-			GeoPatchContext::VBOVertex *vtxInr = &VBOVtxPtr[x + (innerBottom * edgeLen)];
+			GeoPatchContext::Vertex *vtxPtr = &VBOVtxPtr[x + (outerBottom * edgeLen)];
+			GeoPatchContext::Vertex *vtxInr = &VBOVtxPtr[x + (innerBottom * edgeLen)];
 			vtxPtr->pos = vector3f(p);
 			vtxPtr->norm = vtxInr->norm;
 			vtxPtr->col = vtxInr->col;
@@ -211,39 +223,51 @@ void GeoPatch::UpdateVBOs(Graphics::Renderer *renderer)
 		// corners
 		{
 			// top left
-			GeoPatchContext::VBOVertex *tarPtr = &VBOVtxPtr[0];
-			GeoPatchContext::VBOVertex *srcPtr = &VBOVtxPtr[1];
+			GeoPatchContext::Vertex *tarPtr = &VBOVtxPtr[0];
+			GeoPatchContext::Vertex *srcPtr = &VBOVtxPtr[1];
 			(*tarPtr) = (*srcPtr);
 		}
 		{
 			// top right
-			GeoPatchContext::VBOVertex *tarPtr = &VBOVtxPtr[(edgeLen - 1)];
-			GeoPatchContext::VBOVertex *srcPtr = &VBOVtxPtr[(edgeLen - 2)];
+			GeoPatchContext::Vertex *tarPtr = &VBOVtxPtr[(edgeLen - 1)];
+			GeoPatchContext::Vertex *srcPtr = &VBOVtxPtr[(edgeLen - 2)];
 			(*tarPtr) = (*srcPtr);
 		}
 		{
 			// bottom left
-			GeoPatchContext::VBOVertex *tarPtr = &VBOVtxPtr[(edgeLen - 1) * edgeLen];
-			GeoPatchContext::VBOVertex *srcPtr = &VBOVtxPtr[(edgeLen - 2) * edgeLen];
+			GeoPatchContext::Vertex *tarPtr = &VBOVtxPtr[(edgeLen - 1) * edgeLen];
+			GeoPatchContext::Vertex *srcPtr = &VBOVtxPtr[(edgeLen - 2) * edgeLen];
 			(*tarPtr) = (*srcPtr);
 		}
 		{
 			// bottom right
-			GeoPatchContext::VBOVertex *tarPtr = &VBOVtxPtr[(edgeLen - 1) + ((edgeLen - 1) * edgeLen)];
-			GeoPatchContext::VBOVertex *srcPtr = &VBOVtxPtr[(edgeLen - 1) + ((edgeLen - 2) * edgeLen)];
+			GeoPatchContext::Vertex *tarPtr = &VBOVtxPtr[(edgeLen - 1) + ((edgeLen - 1) * edgeLen)];
+			GeoPatchContext::Vertex *srcPtr = &VBOVtxPtr[(edgeLen - 1) + ((edgeLen - 2) * edgeLen)];
 			(*tarPtr) = (*srcPtr);
 		}
 
 		// ----------------------------------------------------
-		// end of mapping
-		vtxBuffer->Unmap();
-
-		// use the new vertex buffer and the shared index buffer
-		m_patchMesh.reset(renderer->CreateMeshObject(vtxBuffer, m_ctx->GetIndexBuffer()));
+		// pack relative to the patch's extent
+		float extent = 0.0f;
+		for (const GeoPatchContext::Vertex &v : s_vertices)
+			extent = std::max({ extent, fabsf(v.pos.x), fabsf(v.pos.y), fabsf(v.pos.z) });
+		m_vertexExtent = extent > 0.0f ? extent : 1.0f;
+		const float invExtent = 1.0f / m_vertexExtent;
+		s_packedVertices.resize(s_vertices.size());
+		for (size_t i = 0; i < s_vertices.size(); i++)
+			s_packedVertices[i] = GeoPatchContext::PackVertex(s_vertices[i], invExtent);
+
+		// upload, morphing patches rewriting the same slot each frame
+		if (m_vertexSlot < 0)
+			m_vertexSlot = m_ctx->AllocVertexSlot();
+		m_ctx->GetSlotBuffer(m_vertexSlot)->BufferSubData(m_ctx->GetSlotOffset(m_vertexSlot) * sizeof(GeoPatchContext::VBOVertex),
+			s_packedVertices.size() * sizeof(GeoPatchContext::VBOVertex), s_packedVertices.data());
 
 		// Don't need this anymore so throw it away
-		m_normals.reset();
-		m_colors.reset();
+		if (!IsMorphing()) {
+			m_normals.reset();
+			m_colors.reset();
+		}
 
 #ifdef DEBUG_BOUNDING_SPHERES
 		RefCountedPtr<Graphics::Material> mat(Pi::renderer->CreateMaterial("unlit", Graphics::MaterialDescriptor(), Graphics::RenderStateDesc()));
@@ -259,6 +283,25 @@ void GeoPatch::UpdateVBOs(Graphics::Renderer *renderer)
 	}
 }
 
+// Height of the parent patch's surface at an (inner) vertex of this patch.
+// Even vertices are the parent's own, odd ones lie on the edges and
+// diagonals of the parent's triangles.
+double GeoPatch::GetParentHeight(const int x, const int y) const
+{
+	const int edgeLen = m_ctx->GetEdgeLen() - 2;
+	auto height = [&](const int hx, const int hy) {
+		return PatchHeights::Decode(m_heights[hx + hy * edgeLen], m_baseHeight);
+	};
+	if (!(x & 1) && !(y & 1))
+		return height(x, y);
+	if (!(y & 1))
+		return (height(x - 1, y) + height(x + 1, y)) * 0.5;
+	if (!(x & 1))
+		return (height(x, y - 1) + height(x, y + 1)) * 0.5;
+	// GeoPatchContext splits each quad between its top-right and bottom-left
+	return (height(x + 1, y - 1) + height(x - 1, y + 1)) * 0.5;
+}
+
 // the default sphere we do the horizon culling against
 static const SSphere s_sph;
 void GeoPatch::Render(Graphics::Renderer *renderer, const vector3d &campos, const matrix4x4d &modelView, const Graphics::Frustum &frustum)
@@ -289,9 +332,10 @@ void GeoPatch::Render(Graphics::Renderer *renderer, const vector3d &campos, cons
 	if (m_kids[0]) {
 		for (int i = 0; i < NUM_KIDS; i++)
 			m_kids[i]->Render(renderer, campos, modelView, frustum);
-	} else if (m_heights) {
+	} else if (m_heights && m_vertexSlot >= 0) {
 		const vector3d relpos = m_clipCentroid - campos;
-		renderer->SetTransform(matrix4x4f(modelView * matrix4x4d::Translation(relpos)));
+		// vertex positions are stored as a fraction of the patch's extent
+		renderer->SetTransform(matrix4x4f(modelView * matrix4x4d::Translation(relpos) * matrix4x4d::ScaleMatrix(m_vertexExtent)));
 
 		Pi::statSceneTris += (m_ctx->GetNumTris());
 		++Pi::statNumPatches;
@@ -300,7 +344,8 @@ void GeoPatch::Render(Graphics::Renderer *renderer, const vector3d &campos, cons
 		const float fDetailFrequency = pow(2.0f, float(m_geosphere->GetMaxDepth()) - float(m_depth));
 
 		m_geosphere->GetSurfaceMaterial()->SetPushConstant("PatchDetailFrequency"_hash, fDetailFrequency);
-		renderer->DrawMesh(m_patchMesh.get(), m_geosphere->GetSurfaceMaterial().Get());
+		renderer->DrawBufferDynamic(m_ctx->GetSlotBuffer(m_vertexSlot), m_ctx->GetSlotOffset(m_vertexSlot),
+			m_ctx->GetIndexBuffer(), 0, m_ctx->GetIndexBuffer()->GetIndexCount(), m_geosphere->GetSurfaceMaterial().Get());
 
 #if DEBUG_CENTROIDS
 		renderer->SetTransform(matrix4x4f(modelView * matrix4x4d::Translation(m_centroid - campos) * matrix4x4d::ScaleMatrix(0.2 / pow(2.0f, m_depth))));
@@ -339,11 +384,8 @@ void GeoPatch::LODUpdate(const vector3d &campos, const Graphics::Frustum &frustu
 
 	if (canSplit) {
 		if (!m_kids[0]) {
-			// Test if this patch is visible
-			if (!frustum.TestPoint(m_clipCentroid, m_clipRadius))
-				return; // nothing below this patch is visible
-
-			// only want to horizon cull patches that can actually be over the horizon!
+			// patches over the horizon can't be seen from here whichever way
+			// the camera turns, so aren't split at all
 			const vector3d camDir(campos - m_clipCentroid);
 			const vector3d camDirNorm(camDir.Normalized());
 			const vector3d cenDir(m_clipCentroid.Normalized());
@@ -359,16 +401,12 @@ void GeoPatch::LODUpdate(const vector3d &campos, const Graphics::Frustum &frustu
 				}
 			}
 
-			// we can see this patch so submit the jobs!
-			assert(!m_HasJobRequest);
-			m_HasJobRequest = true;
-
-			SQuadSplitRequest *ssrd = new SQuadSplitRequest(m_v0, m_v1, m_v2, m_v3, m_centroid.Normalized(), m_depth,
-				m_geosphere->GetSystemBody()->GetPath(), m_PatchID, m_ctx->GetEdgeLen() - 2,
-				m_ctx->GetFrac(), m_geosphere->GetTerrain());
+			// patches outside the view are split after the visible ones, in
+			// case the camera turns towards them
+			const bool inFrustum = frustum.TestPoint(m_clipCentroid, m_clipRadius);
 
 			// add to the GeoSphere to be processed at end of all LODUpdate requests
-			m_geosphere->AddQuadSplitRequest(centroidDist, ssrd, this);
+			m_geosphere->AddQuadSplitRequest(centroidDist, inFrustum, this);
 		} else {
 			for (int i = 0; i < NUM_KIDS; i++) {
 				m_kids[i]->LODUpdate(campos, frustum);
@@ -425,6 +463,8 @@ void GeoPatch::ReceiveHeightmaps(SQuadSplitResult *psr)
 
 		for (int i = 0; i < NUM_KIDS; i++) {
 			m_kids[i]->ReceiveHeightResult(psr->data(i));
+			// hide the change in detail by morphing up from this patch's shape
+			m_kids[i]->m_morph = 0.0f;
 		}
 		m_HasJobRequest = false;
 	}
@@ -443,17 +483,18 @@ void GeoPatch::ReceiveHeightmap(const SSingleSplitResult *psr)
 
 void GeoPatch::ReceiveHeightResult(const SSplitResultData &data)
 {
-	m_heights.reset(data.heights);
-	m_normals.reset(data.normals);
-	m_colors.reset(data.colors);
+	m_heights = PatchDataPool::Ptr<PatchHeight>(data.heights, { data.numVerts });
+	m_baseHeight = data.baseHeight;
+	m_normals = PatchDataPool::Ptr<vector3f>(data.normals, { data.numVerts });
+	m_colors = PatchDataPool::Ptr<Color3ub>(data.colors, { data.numVerts });
 
 	// skirt vertices are not present in the heights array
 	const int edgeLen = m_ctx->GetEdgeLen() - 2;
 
-	const double h0 = m_heights[0];
-	const double h1 = m_heights[edgeLen - 1];
-	const double h2 = m_heights[edgeLen * (edgeLen - 1)];
-	const double h3 = m_heights[edgeLen * edgeLen - 1];
+	const double h0 = PatchHeights::Decode(m_heights[0], m_baseHeight);
+	const double h1 = PatchHeights::Decode(m_heights[edgeLen - 1], m_baseHeight);
+	const double h2 = PatchHeights::Decode(m_heights[edgeLen * (edgeLen - 1)], m_baseHeight);
+	const double h3 = PatchHeights::Decode(m_heights[edgeLen * edgeLen - 1], m_baseHeight);
 
 	const double height = (h0 + h1 + h2 + h3) * 0.25;
 	m_centroid *= (1.0 + height);
@@ -461,6 +502,15 @@ void GeoPatch::ReceiveHeightResult(const SSplitResultData &data)
 	NeedToUpdateVBOs();
 }
 
+SQuadSplitRequest *GeoPatch::CreateSplitRequest()
+{
+	assert(!m_HasJobRequest);
+	m_HasJobRequest = true;
+	return new SQuadSplitRequest(m_v0, m_v1, m_v2, m_v3, m_centroid.Normalized(), m_depth,
+		m_geosphere->GetSystemBody()->GetPath(), m_PatchID, m_ctx->GetEdgeLen() - 2,
+		m_ctx->GetFrac(), m_geosphere->GetTerrain());
+}
+
 void GeoPatch::ReceiveJobHandle(Job::Handle job)
 {
 	assert(!m_job.HasJob());
@@ -8,6 +8,7 @@
 
 #include "Color.h"
 #include "GeoPatchID.h"
+#include "GeoPatchJobs.h"
 #include "JobQueue.h"
 #include "RefCounted.h"
 #include "matrix4x4.h"
@@ -88,18 +89,23 @@ public:
 	void ReceiveHeightmap(const SSingleSplitResult *psr);
 	void ReceiveHeightResult(const SSplitResultData &data);
 	void ReceiveJobHandle(Job::Handle job);
+	// called by the GeoSphere for the splits it accepts from LODUpdate()
+	SQuadSplitRequest *CreateSplitRequest();
 
 	inline bool HasHeightData() const { return (m_heights.get() != nullptr); }
+	inline bool IsMorphing() const { return m_morph < 1.0f; }
 
 private:
 	static const int NUM_KIDS = 4;
 
+	double GetParentHeight(const int x, const int y) const;
+
 	RefCountedPtr<GeoPatchContext> m_ctx;
 	const vector3d m_v0, m_v1, m_v2, m_v3;
-	std::unique_ptr<double[]> m_heights;
-	std::unique_ptr<vector3f[]> m_normals;
-	std::unique_ptr<Color3ub[]> m_colors;
-	std::unique_ptr<Graphics::MeshObject> m_patchMesh;
+	PatchDataPool::Ptr<PatchHeight> m_heights;
+	double m_baseHeight; // see PatchHeights
+	PatchDataPool::Ptr<vector3f> m_normals;
+	PatchDataPool::Ptr<Color3ub> m_colors;
 	std::unique_ptr<GeoPatch> m_kids[NUM_KIDS];
 	GeoPatch *m_parent;
 	GeoSphere *m_geosphere;
@@ -108,6 +114,12 @@ private:
 	double m_clipRadius;
 	Sint32 m_depth;
 	bool m_needUpdateVBOs;
+	// progress from the parent's shape to this patch's, after a split
+	float m_morph;
+	// in the GeoPatchContext's shared vertex buffers, or -1
+	int m_vertexSlot;
+	// scale of the packed vertex positions, see GeoPatchContext::VBOVertex
+	float m_vertexExtent;
 
 	const GeoPatchID m_PatchID;
 	Job::Handle m_job;
@@ -0,0 +1,196 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "GeoPatchCache.h"
+
+#include "FileSystem.h"
+#include "GeoPatchJobs.h"
+#include "core/FastHash.h"
+#include "core/LZ4Format.h"
+#include "core/Log.h"
+#include "profiler/Profiler.h"
+#include "terrain/Terrain.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <set>
+#include <thread>
+
+namespace {
+	static const char CACHE_DIR_NAME[] = "terrain_cache";
+	static const Uint32 CACHE_MAGIC = 0x48435047; // "GPCH"
+	// bump whenever the generated patch data changes
+	static const Uint32 CACHE_VERSION = 1;
+	// lz4 preset; heights are cached once and read many times
+	static const int CACHE_LZ4_PRESET = 3;
+
+	struct CacheHeader {
+		Uint32 magic;
+		Uint32 version;
+		Uint32 seed;
+		Uint32 heightSize;
+		Uint64 fractalHash;
+		Uint64 patchID;
+		Sint32 edgeLen;
+		Sint32 numPatches;
+		double baseHeight;
+	};
+
+	std::atomic<bool> s_enabled(false);
+
+	// body directories already created this session
+	std::mutex s_dirLock;
+	std::set<SystemPath> s_bodyDirs;
+
+	Uint64 GetFractalHash(const Terrain *terrain)
+	{
+		Uint64 hash = FastHash64(terrain->GetHeightFractalName(), strlen(terrain->GetHeightFractalName()));
+		return FastHash64(terrain->GetColorFractalName(), strlen(terrain->GetColorFractalName()), hash);
+	}
+
+	std::string GetBodyDir(const SystemPath &path)
+	{
+		return FileSystem::JoinPathBelow(CACHE_DIR_NAME,
+			fmt::format("{}_{}_{}_{}_{}", path.sectorX, path.sectorY, path.sectorZ, path.systemIndex, path.bodyIndex));
+	}
+
+	std::string GetFileName(const SBaseRequest &req, int numPatches)
+	{
+		return FileSystem::JoinPathBelow(GetBodyDir(req.sysPath),
+			fmt::format("{}{:016x}_{}.lz4", numPatches == 1 ? 's' : 'q', req.patchID.GetID(), req.edgeLen));
+	}
+
+	size_t GetPatchSize(int edgeLen)
+	{
+		return size_t(edgeLen * edgeLen) * (sizeof(PatchHeight) + sizeof(vector3f) + sizeof(Color3ub));
+	}
+} // namespace
+
+namespace GeoPatchCache {
+
+	void Init(bool enabled)
+	{
+		s_enabled = enabled;
+		if (enabled && !FileSystem::userFiles.MakeDirectory(CACHE_DIR_NAME)) {
+			Log::Warning("Could not create the terrain cache directory, disabling it.\n");
+			s_enabled = false;
+		}
+	}
+
+	bool IsEnabled()
+	{
+		return s_enabled;
+	}
+
+	bool Load(const SBaseRequest &req, int numPatches, PatchHeight *const *heights, double &baseHeight,
+		vector3f *const *normals, Color3ub *const *colors)
+	{
+		if (!s_enabled)
+			return false;
+
+		PROFILE_SCOPED()
+		RefCountedPtr<FileSystem::FileData> file = FileSystem::userFiles.ReadFile(GetFileName(req, numPatches));
+		if (!file || !lz4::IsLZ4Format(file->GetData(), file->GetSize()))
+			return false;
+
+		std::string data;
+		try {
+			data = lz4::DecompressLZ4({ file->GetData(), file->GetSize() });
+		} catch (std::runtime_error &e) {
+			// a partly written file, will be replaced once regenerated
+			return false;
+		}
+
+		CacheHeader header;
+		if (data.size() != sizeof(header) + GetPatchSize(req.edgeLen) * numPatches)
+			return false;
+		memcpy(&header, data.data(), sizeof(header));
+		if (header.magic != CACHE_MAGIC || header.version != CACHE_VERSION ||
+			header.heightSize != sizeof(PatchHeight) || header.seed != req.pTerrain->GetSeed() ||
+			header.fractalHash != GetFractalHash(req.pTerrain.Get()) || header.patchID != req.patchID.GetID() ||
+			header.edgeLen != req.edgeLen || header.numPatches != numPatches)
+			return false;
+
+		const size_t numVerts = size_t(req.edgeLen * req.edgeLen);
+		const char *src = data.data() + sizeof(header);
+		for (int i = 0; i < numPatches; i++) {
+			memcpy(heights[i], src, numVerts * sizeof(PatchHeight));
+			src += numVerts * sizeof(PatchHeight);
+			memcpy(normals[i], src, numVerts * sizeof(vector3f));
+			src += numVerts * sizeof(vector3f);
+			memcpy(colors[i], src, numVerts * sizeof(Color3ub));
+			src += numVerts * sizeof(Color3ub);
+		}
+		baseHeight = header.baseHeight;
+		return true;
+	}
+
+	void Save(const SBaseRequest &req, int numPatches, const PatchHeight *const *heights, double baseHeight,
+		const vector3f *const *normals, const Color3ub *const *colors)
+	{
+		if (!s_enabled)
+			return;
+
+		PROFILE_SCOPED()
+		{
+			std::lock_guard<std::mutex> lock(s_dirLock);
+			if (s_bodyDirs.insert(req.sysPath).second)
+				FileSystem::userFiles.MakeDirectory(GetBodyDir(req.sysPath));
+		}
+
+		CacheHeader header;
+		memset(&header, 0, sizeof(header));
+		header.magic = CACHE_MAGIC;
+		header.version = CACHE_VERSION;
+		header.seed = req.pTerrain->GetSeed();
+		header.heightSize = sizeof(PatchHeight);
+		header.fractalHash = GetFractalHash(req.pTerrain.Get());
+		header.patchID = req.patchID.GetID();
+		header.edgeLen = req.edgeLen;
+		header.numPatches = numPatches;
+		header.baseHeight = baseHeight;
+
+		const size_t numVerts = size_t(req.edgeLen * req.edgeLen);
+		std::string data;
+		data.reserve(sizeof(header) + GetPatchSize(req.edgeLen) * numPatches);
+		data.append(reinterpret_cast<const char *>(&header), sizeof(header));
+		for (int i = 0; i < numPatches; i++) {
+			data.append(reinterpret_cast<const char *>(heights[i]), numVerts * sizeof(PatchHeight));
+			data.append(reinterpret_cast<const char *>(normals[i]), numVerts * sizeof(vector3f));
+			data.append(reinterpret_cast<const char *>(colors[i]), numVerts * sizeof(Color3ub));
+		}
+
+		std::string compressed;
+		try {
+			compressed = lz4::CompressLZ4(data, CACHE_LZ4_PRESET);
+		} catch (std::runtime_error &e) {
+			Log::Warning("Error compressing terrain cache data: {}\n", e.what());
+			return;
+		}
+
+		// write to a file of this thread's own, then move it into place, so
+		// another job never reads a partly written file
+		const std::string fileName = GetFileName(req, numPatches);
+		const std::string tempName = fmt::format("{}.{}.tmp", fileName, std::hash<std::thread::id>()(std::this_thread::get_id()));
+		FILE *f = FileSystem::userFiles.OpenWriteStream(tempName);
+		if (!f)
+			return;
+		const bool written = fwrite(compressed.data(), compressed.size(), 1, f) == 1;
+		fclose(f);
+
+		const std::string root = FileSystem::userFiles.GetRoot();
+		const std::string tempPath = FileSystem::JoinPathBelow(root, tempName);
+		const std::string filePath = FileSystem::JoinPathBelow(root, fileName);
+		bool moved = written && std::rename(tempPath.c_str(), filePath.c_str()) == 0;
+		if (written && !moved) {
+			// rename() doesn't replace an existing file everywhere
+			std::remove(filePath.c_str());
+			moved = std::rename(tempPath.c_str(), filePath.c_str()) == 0;
+		}
+		if (!moved)
+			std::remove(tempPath.c_str());
+	}
+
+} // namespace GeoPatchCache
@@ -0,0 +1,36 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _GEOPATCHCACHE_H
+#define _GEOPATCHCACHE_H
+
+#include "Color.h"
+#include "GeoPatchHeights.h"
+#include "vector3.h"
+
+class SBaseRequest;
+
+// Optional on-disk cache of the data generated by the patch jobs.
+//
+// Patch data is fully determined by the body, the patch and the terrain
+// detail settings, so revisiting a planet can read it back rather than
+// regenerate it from the fractals. Each split request is stored as one lz4
+// file under the user directory, keyed by the body's SystemPath, the patch
+// ID, the request kind and the patch edge length; the terrain's seed and
+// fractals are checked on load, so a changed body misses rather than loads
+// the wrong terrain.
+//
+// Load() and Save() are called from the patch jobs, so are thread safe.
+namespace GeoPatchCache {
+	void Init(bool enabled);
+	bool IsEnabled();
+
+	// Fills the numPatches arrays of a request's patches from the cache,
+	// returning false if they aren't cached or the stored data is stale.
+	bool Load(const SBaseRequest &req, int numPatches, PatchHeight *const *heights, double &baseHeight,
+		vector3f *const *normals, Color3ub *const *colors);
+	void Save(const SBaseRequest &req, int numPatches, const PatchHeight *const *heights, double baseHeight,
+		const vector3f *const *normals, const Color3ub *const *colors);
+} // namespace GeoPatchCache
+
+#endif /* _GEOPATCHCACHE_H */
@@ -11,8 +11,11 @@
 #include "perlin.h"
 #include "vcacheopt/vcacheopt.h"
 #include <algorithm>
+#include <cstddef>
 #include <deque>
 
+static_assert(sizeof(GeoPatchContext::VBOVertex) == 24, "GeoPatchContext::VBOVertex is padded");
+
 // static instances
 int GeoPatchContext::m_edgeLen = 0;
 int GeoPatchContext::m_numTris = 0;
@@ -86,3 +89,61 @@ void GeoPatchContext::Init()
 
 	GenerateIndices();
 }
+
+//static
+Graphics::VertexBufferDesc GeoPatchContext::GetVertexBufferDesc()
+{
+	Graphics::VertexBufferDesc vbd;
+	vbd.attrib[0] = { Graphics::ATTRIB_POSITION, Graphics::ATTRIB_FORMAT_SHORT4N, offsetof(VBOVertex, pos) };
+	vbd.attrib[1] = { Graphics::ATTRIB_NORMAL, Graphics::ATTRIB_FORMAT_BYTE4N, offsetof(VBOVertex, norm) };
+	vbd.attrib[2] = { Graphics::ATTRIB_DIFFUSE, Graphics::ATTRIB_FORMAT_UBYTE4, offsetof(VBOVertex, col) };
+	vbd.attrib[3] = { Graphics::ATTRIB_UV0, Graphics::ATTRIB_FORMAT_FLOAT2, offsetof(VBOVertex, uv) };
+	vbd.stride = sizeof(VBOVertex);
+	return vbd;
+}
+
+//static
+GeoPatchContext::VBOVertex GeoPatchContext::PackVertex(const Vertex &v, const float invExtent)
+{
+	auto snorm16 = [](float f) { return Sint16(lrintf(Clamp(f, -1.0f, 1.0f) * 32767.0f)); };
+	auto snorm8 = [](float f) { return Sint8(lrintf(Clamp(f, -1.0f, 1.0f) * 127.0f)); };
+
+	VBOVertex out;
+	out.pos[0] = snorm16(v.pos.x * invExtent);
+	out.pos[1] = snorm16(v.pos.y * invExtent);
+	out.pos[2] = snorm16(v.pos.z * invExtent);
+	out.pos[3] = 32767; // w = 1
+	out.norm[0] = snorm8(v.norm.x);
+	out.norm[1] = snorm8(v.norm.y);
+	out.norm[2] = snorm8(v.norm.z);
+	out.norm[3] = 0;
+	out.col = v.col;
+	out.uv = v.uv;
+	return out;
+}
+
+int GeoPatchContext::AllocVertexSlot()
+{
+	if (m_freeVertexSlots.empty()) {
+		Graphics::VertexBufferDesc vbd = GetVertexBufferDesc();
+		vbd.numVertices = m_slotVertices * VERTEX_SLOTS_PER_BUFFER;
+		vbd.usage = Graphics::BUFFER_USAGE_STATIC;
+		m_vertexBuffers.emplace_back(Pi::renderer->CreateVertexBuffer(vbd));
+		assert(m_vertexBuffers.back()->GetDesc().stride == sizeof(VBOVertex));
+
+		// hand out the lowest slots first
+		const int firstSlot = int(m_vertexBuffers.size() - 1) * VERTEX_SLOTS_PER_BUFFER;
+		for (int i = VERTEX_SLOTS_PER_BUFFER - 1; i >= 0; i--)
+			m_freeVertexSlots.push_back(firstSlot + i);
+	}
+
+	const int slot = m_freeVertexSlots.back();
+	m_freeVertexSlots.pop_back();
+	return slot;
+}
+
+void GeoPatchContext::FreeVertexSlot(const int slot)
+{
+	assert(slot >= 0 && slot < int(m_vertexBuffers.size()) * VERTEX_SLOTS_PER_BUFFER);
+	m_freeVertexSlots.push_back(slot);
+}
@@ -11,22 +11,41 @@
 #include "vector3.h"
 
 #include <deque>
+#include <vector>
 
 // maximumpatch depth
 #define GEOPATCH_MAX_DEPTH 15
 
 class GeoPatchContext : public RefCounted {
 public:
-	struct VBOVertex {
+	// a patch vertex at full precision, as built by GeoPatch::UpdateVBOs()
+	struct Vertex {
 		vector3f pos;
 		vector3f norm;
 		Color4ub col;
 		vector2f uv;
 	};
 
+	// A patch vertex as stored on the GPU, in two thirds of the size. The
+	// position is a fraction of the patch's extent around its centroid,
+	// which GeoPatch::Render() scales back up in the model transform, and
+	// the normal is a normalised integer, which the vertex fetch converts
+	// back to floats. The uvs stay full precision as the detail textures
+	// repeat across them up to 2^GEOPATCH_MAX_DEPTH times.
+	struct VBOVertex {
+		Sint16 pos[4];
+		Sint8 norm[4];
+		Color4ub col;
+		vector2f uv;
+	};
+
+	static Graphics::VertexBufferDesc GetVertexBufferDesc();
+	static VBOVertex PackVertex(const Vertex &v, const float invExtent);
+
 	GeoPatchContext(const int _edgeLen)
 	{
 		m_edgeLen = _edgeLen + 2; // +2 for the skirt
+		m_slotVertices = NUMVERTICES();
 		Init();
 	}
 
@@ -45,7 +64,22 @@ public:
 	static inline int GetNumTris() { return m_numTris; }
 	static inline double GetFrac() { return m_frac; }
 
+	// Patch vertices are sub-allocated in slots of a few large vertex
+	// buffers shared by all patches of this context, rather than a buffer
+	// each, and drawn with the shared index buffer at the slot's offset.
+	int AllocVertexSlot();
+	void FreeVertexSlot(const int slot);
+	Graphics::VertexBuffer *GetSlotBuffer(const int slot) const { return m_vertexBuffers[slot / VERTEX_SLOTS_PER_BUFFER].Get(); }
+	Uint32 GetSlotOffset(const int slot) const { return Uint32(slot % VERTEX_SLOTS_PER_BUFFER) * m_slotVertices; }
+
 private:
+	static const int VERTEX_SLOTS_PER_BUFFER = 64;
+
+	// NUMVERTICES() when this context was created
+	int m_slotVertices;
+	std::vector<RefCountedPtr<Graphics::VertexBuffer>> m_vertexBuffers;
+	std::vector<int> m_freeVertexSlots;
+
 	static int m_edgeLen;
 	static int m_numTris;
 
@@ -0,0 +1,45 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _GEOPATCHHEIGHTS_H
+#define _GEOPATCHHEIGHTS_H
+
+#include <algorithm>
+#include <cfloat>
+#include <cstddef>
+
+// Patch heightmaps, in sphere radii above the surface, are stored as float
+// offsets from a double base height for each patch. Heights within a patch
+// span a small part of the terrain's range, so the offsets keep well under
+// a millimetre of precision at planet radii for half the memory (and twice
+// the SIMD width) of doubles. Generation itself stays in double, since the
+// noise lattice coordinates at surface frequencies need it.
+//
+// Define GEOPATCH_DOUBLE_HEIGHTS to store the generated doubles unchanged.
+#ifdef GEOPATCH_DOUBLE_HEIGHTS
+typedef double PatchHeight;
+#else
+typedef float PatchHeight;
+#endif
+
+namespace PatchHeights {
+
+	// base height for a patch generated with these heights
+	inline double GetBase(const double *heights, size_t count)
+	{
+#ifdef GEOPATCH_DOUBLE_HEIGHTS
+		return 0.0;
+#else
+		double base = DBL_MAX;
+		for (size_t i = 0; i < count; i++)
+			base = std::min(base, heights[i]);
+		return count ? base : 0.0;
+#endif
+	}
+
+	inline PatchHeight Encode(double height, double base) { return PatchHeight(height - base); }
+	inline double Decode(PatchHeight height, double base) { return base + double(height); }
+
+} // namespace PatchHeights
+
+#endif /* _GEOPATCHHEIGHTS_H */
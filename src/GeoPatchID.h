@@ -16,6 +16,8 @@ public:
 
 	static const uint64_t MAX_SHIFT_DEPTH = 61;
 
+	uint64_t GetID() const { return mPatchID; }
+
 	uint64_t NextPatchID(const int depth, const int idx) const;
 	int GetPatchIdx(const int depth) const;
 	int GetPatchFaceIdx() const;
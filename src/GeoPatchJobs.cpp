@@ -3,11 +3,20 @@
 
 #include "GeoPatchJobs.h"
 
+#include "GeoPatchCache.h"
 #include "GeoSphere.h"
 #include "MathUtil.h"
+#include "PerfStats.h"
+#include "core/BlockPool.h"
+#include "core/MemoryStats.h"
 #include "perlin.h"
 #include "profiler/Profiler.h"
 
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <vector>
+
 inline void setColour(Color3ub &r, const vector3d &v)
 {
 	r.r = static_cast<unsigned char>(Clamp(v.x * 255.0, 0.0, 255.0));
@@ -25,8 +34,16 @@ inline vector3d GetSpherePoint(const vector3d &v0, const vector3d &v1, const vec
 // Overloaded PureJob class to handle generating the mesh for each patch
 // ********************************************************************************
 
+SSingleSplitRequest::~SSingleSplitRequest()
+{
+	const int numVerts = NUMVERTICES(edgeLen);
+	PatchDataPool::Free(heights, numVerts);
+	PatchDataPool::Free(normals, numVerts);
+	PatchDataPool::Free(colors, numVerts);
+}
+
 // Generates full-detail vertices, and also non-edge normals and colors
-void SSingleSplitRequest::GenerateMesh() const
+bool SSingleSplitRequest::GenerateMesh(const Job &job)
 {
 	PROFILE_SCOPED()
 	const int borderedEdgeLen = edgeLen + (BORDER_SIZE * 2);
@@ -38,29 +55,43 @@ void SSingleSplitRequest::GenerateMesh() const
 	double *bhts = borderHeights.get();
 	vector3d *vrts = borderVertexs.get();
 	for (int y = -BORDER_SIZE; y < borderedEdgeLen - BORDER_SIZE; y++) {
+		// cancellation checkpoint, once per row
+		if (job.IsCancelled())
+			return false;
+
+		// a row of points, then their heights in one batch
 		const double yfrac = double(y) * fracStep;
 		for (int x = -BORDER_SIZE; x < borderedEdgeLen - BORDER_SIZE; x++) {
 			const double xfrac = double(x) * fracStep;
-			const vector3d p = GetSpherePoint(v0, v1, v2, v3, xfrac, yfrac);
-			const double height = pTerrain->GetHeight(p);
+			vrts[x + BORDER_SIZE] = GetSpherePoint(v0, v1, v2, v3, xfrac, yfrac);
+		}
+		pTerrain->GetHeights(vrts, bhts, borderedEdgeLen);
+		for (int x = 0; x < borderedEdgeLen; x++) {
+			const double height = *(bhts++);
 			assert(height >= 0.0f && height <= 1.0f);
-			*(bhts++) = height;
-			*(vrts++) = p * (height + 1.0);
+			*(vrts++) *= (height + 1.0);
 		}
 	}
 	assert(bhts == &borderHeights.get()[numBorderedVerts]);
+	baseHeight = PatchHeights::GetBase(borderHeights.get(), borderedEdgeLen * borderedEdgeLen);
 
 	// Generate normals & colors for non-edge vertices since they never change
 	Color3ub *col = colors;
 	vector3f *nrm = normals;
-	double *hts = heights;
+	PatchHeight *hts = heights;
 	vrts = borderVertexs.get();
+	// a row's points are coloured in one batch
+	std::vector<vector3d> rowPoints(edgeLen), rowNormals(edgeLen), rowColors(edgeLen);
+	std::vector<double> rowHeights(edgeLen);
 	for (int y = BORDER_SIZE; y < borderedEdgeLen - BORDER_SIZE; y++) {
+		if (job.IsCancelled())
+			return false;
+
 		for (int x = BORDER_SIZE; x < borderedEdgeLen - BORDER_SIZE; x++) {
 			// height
 			const double height = borderHeights[x + y * borderedEdgeLen];
 			assert(hts != &heights[edgeLen * edgeLen]);
-			*(hts++) = height;
+			*(hts++) = PatchHeights::Encode(height, baseHeight);
 
 			// normal
 			const vector3d &x1 = vrts[(x - 1) + y * borderedEdgeLen];
@@ -71,16 +102,32 @@ void SSingleSplitRequest::GenerateMesh() const
 			assert(nrm != &normals[edgeLen * edgeLen]);
 			*(nrm++) = vector3f(n);
 
-			// color
-			const vector3d p = GetSpherePoint(v0, v1, v2, v3, (x - BORDER_SIZE) * fracStep, (y - BORDER_SIZE) * fracStep);
-			setColour(*col, pTerrain->GetColor(p, height, n));
+			// color inputs
+			rowPoints[x - BORDER_SIZE] = GetSpherePoint(v0, v1, v2, v3, (x - BORDER_SIZE) * fracStep, (y - BORDER_SIZE) * fracStep);
+			rowHeights[x - BORDER_SIZE] = height;
+			rowNormals[x - BORDER_SIZE] = n;
+		}
+
+		pTerrain->GetColors(rowPoints.data(), rowHeights.data(), rowNormals.data(), rowColors.data(), edgeLen);
+		for (int x = 0; x < edgeLen; x++) {
 			assert(col != &colors[edgeLen * edgeLen]);
-			++col;
+			setColour(*(col++), rowColors[x]);
 		}
 	}
 	assert(hts == &heights[edgeLen * edgeLen]);
 	assert(nrm == &normals[edgeLen * edgeLen]);
 	assert(col == &colors[edgeLen * edgeLen]);
+	return true;
+}
+
+bool SSingleSplitRequest::LoadFromCache()
+{
+	return GeoPatchCache::Load(*this, 1, &heights, baseHeight, &normals, &colors);
+}
+
+void SSingleSplitRequest::SaveToCache() const
+{
+	GeoPatchCache::Save(*this, 1, &heights, baseHeight, &normals, &colors);
 }
 
 // ********************************************************************************
@@ -100,14 +147,22 @@ void SinglePatchJob::OnRun() // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
 
 	const SSingleSplitRequest &srd = *mData;
 
-	// fill out the data
-	mData->GenerateMesh();
+	// fill out the data from the cache, or generate it unless the patch is no longer wanted
+	if (!mData->LoadFromCache()) {
+		if (!mData->GenerateMesh(*this))
+			return;
+		mData->SaveToCache();
+	}
 
 	// add this patches data
 	SSingleSplitResult *sr = new SSingleSplitResult(srd.patchID.GetPatchFaceIdx(), srd.depth);
-	sr->addResult(srd.heights, srd.normals, srd.colors,
+	sr->addResult(srd.heights, srd.baseHeight, srd.normals, srd.colors, srd.NUMVERTICES(srd.edgeLen),
 		srd.v0, srd.v1, srd.v2, srd.v3,
 		srd.patchID.NextPatchID(srd.depth + 1, 0));
+	// the result now owns the arrays
+	mData->heights = nullptr;
+	mData->normals = nullptr;
+	mData->colors = nullptr;
 	// store the result
 	mpResults = sr;
 }
@@ -136,44 +191,17 @@ void QuadPatchJob::OnRun() // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
 	PROFILE_SCOPED()
 	BasePatchJob::OnRun();
 
-	const SQuadSplitRequest &srd = *mData;
-
-	mData->GenerateBorderedData();
-
-	const vector3d v01 = (srd.v0 + srd.v1).Normalized();
-	const vector3d v12 = (srd.v1 + srd.v2).Normalized();
-	const vector3d v23 = (srd.v2 + srd.v3).Normalized();
-	const vector3d v30 = (srd.v3 + srd.v0).Normalized();
-	const vector3d cn = (srd.centroid).Normalized();
-	const vector3d vecs[4][4] = {
-		{ srd.v0, v01, cn, v30 },
-		{ v01, srd.v1, v12, cn },
-		{ cn, v12, srd.v2, v23 },
-		{ v30, cn, v23, srd.v3 }
-	};
-
-	const int borderedEdgeLen = (srd.edgeLen * 2) + (BORDER_SIZE * 2) - 1;
-	const int offxy[4][2] = {
-		{ 0, 0 },
-		{ srd.edgeLen - 1, 0 },
-		{ srd.edgeLen - 1, srd.edgeLen - 1 },
-		{ 0, srd.edgeLen - 1 }
-	};
-
-	SQuadSplitResult *sr = new SQuadSplitResult(srd.patchID.GetPatchFaceIdx(), srd.depth);
-	for (int i = 0; i < 4; i++) {
-		// fill out the data
-		mData->GenerateSubPatchData(i,
-			vecs[i][0], vecs[i][1], vecs[i][2], vecs[i][3],
-			srd.edgeLen, offxy[i][0], offxy[i][1],
-			borderedEdgeLen);
-
-		// add this patches data
-		sr->addResult(i, srd.heights[i], srd.normals[i], srd.colors[i],
-			vecs[i][0], vecs[i][1], vecs[i][2], vecs[i][3],
-			srd.patchID.NextPatchID(srd.depth + 1, i));
+	// The bordered heightmap is generated as a separate stage, so a patch
+	// cancelled in the meantime can skip generating its normals and colors.
+	if (GetStage() == 0) {
+		mpResults = mData->LoadFromCache();
+		if (!mpResults && mData->GenerateBorderedData(*this))
+			ContinueWithNextStage();
+		return;
 	}
-	mpResults = sr;
+
+	// fill out the data, unless the patch is no longer wanted
+	mpResults = mData->GenerateSubPatches(*this);
 }
 
 QuadPatchJob::~QuadPatchJob()
@@ -185,8 +213,18 @@ QuadPatchJob::~QuadPatchJob()
 	}
 }
 
+SQuadSplitRequest::~SQuadSplitRequest()
+{
+	const int numVerts = NUMVERTICES(edgeLen);
+	for (int i = 0; i < 4; ++i) {
+		PatchDataPool::Free(heights[i], numVerts);
+		PatchDataPool::Free(normals[i], numVerts);
+		PatchDataPool::Free(colors[i], numVerts);
+	}
+}
+
 // Generates full-detail vertices, and also non-edge normals and colors
-void SQuadSplitRequest::GenerateBorderedData() const
+bool SQuadSplitRequest::GenerateBorderedData(const Job &job)
 {
 	PROFILE_SCOPED()
 	const int borderedEdgeLen = (edgeLen * 2) + (BORDER_SIZE * 2) - 1;
@@ -198,20 +236,30 @@ void SQuadSplitRequest::GenerateBorderedData() const
 	double *bhts = borderHeights.get();
 	vector3d *vrts = borderVertexs.get();
 	for (int y = -BORDER_SIZE; y < (borderedEdgeLen - BORDER_SIZE); y++) {
+		// cancellation checkpoint, once per row
+		if (job.IsCancelled())
+			return false;
+
+		// a row of points, then their heights in one batch
 		const double yfrac = double(y) * (fracStep * 0.5);
 		for (int x = -BORDER_SIZE; x < (borderedEdgeLen - BORDER_SIZE); x++) {
 			const double xfrac = double(x) * (fracStep * 0.5);
-			const vector3d p = GetSpherePoint(v0, v1, v2, v3, xfrac, yfrac);
-			const double height = pTerrain->GetHeight(p);
+			vrts[x + BORDER_SIZE] = GetSpherePoint(v0, v1, v2, v3, xfrac, yfrac);
+		}
+		pTerrain->GetHeights(vrts, bhts, borderedEdgeLen);
+		for (int x = 0; x < borderedEdgeLen; x++) {
+			const double height = *(bhts++);
 			assert(height >= 0.0f && height <= 1.0f);
-			*(bhts++) = height;
-			*(vrts++) = p * (height + 1.0);
+			*(vrts++) *= (height + 1.0);
 		}
 	}
 	assert(bhts == &borderHeights[numBorderedVerts]);
+	baseHeight = PatchHeights::GetBase(borderHeights.get(), borderedEdgeLen * borderedEdgeLen);
+	return true;
 }
 
-void SQuadSplitRequest::GenerateSubPatchData(
+bool SQuadSplitRequest::GenerateSubPatchData(
+	const Job &job,
 	const int quadrantIndex,
 	const vector3d &v0,
 	const vector3d &v1,
@@ -227,10 +275,16 @@ void SQuadSplitRequest::GenerateSubPatchData(
 	vector3d *vrts = borderVertexs.get();
 	Color3ub *col = colors[quadrantIndex];
 	vector3f *nrm = normals[quadrantIndex];
-	double *hts = heights[quadrantIndex];
+	PatchHeight *hts = heights[quadrantIndex];
+	// a row's points are coloured in one batch
+	std::vector<vector3d> rowPoints(edgeLen), rowNormals(edgeLen), rowColors(edgeLen);
+	std::vector<double> rowHeights(edgeLen);
 
 	// step over the small square
 	for (int y = 0; y < edgeLen; y++) {
+		if (job.IsCancelled())
+			return false;
+
 		const int by = (y + BORDER_SIZE) + yoff;
 		for (int x = 0; x < edgeLen; x++) {
 			const int bx = (x + BORDER_SIZE) + xoff;
@@ -238,7 +292,7 @@ void SQuadSplitRequest::GenerateSubPatchData(
 			// height
 			const double height = borderHeights[bx + (by * borderedEdgeLen)];
 			assert(hts != &heights[quadrantIndex][edgeLen * edgeLen]);
-			*(hts++) = height;
+			*(hts++) = PatchHeights::Encode(height, baseHeight);
 
 			// normal
 			const vector3d &x1 = vrts[(bx - 1) + (by * borderedEdgeLen)];
@@ -249,14 +303,238 @@ void SQuadSplitRequest::GenerateSubPatchData(
 			assert(nrm != &normals[quadrantIndex][edgeLen * edgeLen]);
 			*(nrm++) = vector3f(n);
 
-			// color
-			const vector3d p = GetSpherePoint(v0, v1, v2, v3, x * fracStep, y * fracStep);
-			setColour(*col, pTerrain->GetColor(p, height, n));
+			// color inputs
+			rowPoints[x] = GetSpherePoint(v0, v1, v2, v3, x * fracStep, y * fracStep);
+			rowHeights[x] = height;
+			rowNormals[x] = n;
+		}
+
+		pTerrain->GetColors(rowPoints.data(), rowHeights.data(), rowNormals.data(), rowColors.data(), edgeLen);
+		for (int x = 0; x < edgeLen; x++) {
 			assert(col != &colors[quadrantIndex][edgeLen * edgeLen]);
-			++col;
+			setColour(*(col++), rowColors[x]);
 		}
 	}
 	assert(hts == &heights[quadrantIndex][edgeLen * edgeLen]);
 	assert(nrm == &normals[quadrantIndex][edgeLen * edgeLen]);
 	assert(col == &colors[quadrantIndex][edgeLen * edgeLen]);
+	return true;
+}
+
+SQuadSplitResult *SQuadSplitRequest::GenerateSubPatches(const Job &job)
+{
+	PROFILE_SCOPED()
+	const vector3d v01 = (v0 + v1).Normalized();
+	const vector3d v12 = (v1 + v2).Normalized();
+	const vector3d v23 = (v2 + v3).Normalized();
+	const vector3d v30 = (v3 + v0).Normalized();
+	const vector3d cn = centroid.Normalized();
+	const vector3d vecs[4][4] = {
+		{ v0, v01, cn, v30 },
+		{ v01, v1, v12, cn },
+		{ cn, v12, v2, v23 },
+		{ v30, cn, v23, v3 }
+	};
+
+	const int borderedEdgeLen = (edgeLen * 2) + (BORDER_SIZE * 2) - 1;
+	const int offxy[4][2] = {
+		{ 0, 0 },
+		{ edgeLen - 1, 0 },
+		{ edgeLen - 1, edgeLen - 1 },
+		{ 0, edgeLen - 1 }
+	};
+
+	for (int i = 0; i < 4; i++) {
+		if (!GenerateSubPatchData(job, i,
+				vecs[i][0], vecs[i][1], vecs[i][2], vecs[i][3],
+				edgeLen, offxy[i][0], offxy[i][1],
+				borderedEdgeLen))
+			return nullptr;
+	}
+
+	SaveToCache();
+	return CreateResult();
+}
+
+SQuadSplitResult *SQuadSplitRequest::LoadFromCache()
+{
+	if (!GeoPatchCache::Load(*this, 4, heights, baseHeight, normals, colors))
+		return nullptr;
+	return CreateResult();
+}
+
+void SQuadSplitRequest::SaveToCache() const
+{
+	GeoPatchCache::Save(*this, 4, heights, baseHeight, normals, colors);
+}
+
+SQuadSplitResult *SQuadSplitRequest::CreateResult()
+{
+	const vector3d v01 = (v0 + v1).Normalized();
+	const vector3d v12 = (v1 + v2).Normalized();
+	const vector3d v23 = (v2 + v3).Normalized();
+	const vector3d v30 = (v3 + v0).Normalized();
+	const vector3d cn = centroid.Normalized();
+	const vector3d vecs[4][4] = {
+		{ v0, v01, cn, v30 },
+		{ v01, v1, v12, cn },
+		{ cn, v12, v2, v23 },
+		{ v30, cn, v23, v3 }
+	};
+
+	SQuadSplitResult *sr = new SQuadSplitResult(patchID.GetPatchFaceIdx(), depth);
+	for (int i = 0; i < 4; i++) {
+		// add this patches data, the result now owns the arrays
+		sr->addResult(i, heights[i], baseHeight, normals[i], colors[i], NUMVERTICES(edgeLen),
+			vecs[i][0], vecs[i][1], vecs[i][2], vecs[i][3],
+			patchID.NextPatchID(depth + 1, i));
+		heights[i] = nullptr;
+		normals[i] = nullptr;
+		colors[i] = nullptr;
+	}
+	return sr;
+}
+
+// ********************************************************************************
+// Pooled storage for split requests and results
+// ********************************************************************************
+namespace {
+	// one pool for each distinct buffer size; there are only ever a handful
+	std::mutex s_patchDataLock;
+	std::map<size_t, std::unique_ptr<BlockPool>> s_patchDataPools;
+
+	Perf::Stats *s_patchDataStats = nullptr;
+	Perf::Stats::CounterRef s_patchDataAllocated(nullptr);
+	Perf::Stats::CounterRef s_patchDataReused(nullptr);
+	Perf::Stats::CounterRef s_patchDataHeapBytes(nullptr);
+
+	BlockPool &GetPatchDataPool(size_t size)
+	{
+		std::lock_guard<std::mutex> lock(s_patchDataLock);
+		std::unique_ptr<BlockPool> &pool = s_patchDataPools[size];
+		if (!pool)
+			pool.reset(new BlockPool(size));
+		return *pool;
+	}
+} // namespace
+
+// static
+void PatchDataPool::Init(Perf::Stats *stats)
+{
+	s_patchDataStats = stats;
+	s_patchDataAllocated = stats->GetOrCreateCounter("Terrain Buffers Allocated");
+	s_patchDataReused = stats->GetOrCreateCounter("Terrain Buffers Reused");
+	s_patchDataHeapBytes = stats->GetOrCreateCounter("Terrain Buffer Bytes Allocated");
+}
+
+// static
+void PatchDataPool::Clear()
+{
+	std::lock_guard<std::mutex> lock(s_patchDataLock);
+	for (auto &pool : s_patchDataPools)
+		pool.second->Clear();
+}
+
+// static
+void *PatchDataPool::AllocateBytes(size_t size)
+{
+	bool reused = false;
+	void *data = GetPatchDataPool(size).Allocate(&reused);
+	// only buffers in use are accounted, not those cached by the pools
+	MemoryStats::Add(MemoryStats::TAG_GEOPATCH, size);
+
+	if (s_patchDataStats) {
+		if (reused) {
+			s_patchDataStats->CounterAdd(s_patchDataReused);
+		} else {
+			s_patchDataStats->CounterAdd(s_patchDataAllocated);
+			s_patchDataStats->CounterAdd(s_patchDataHeapBytes, uint32_t(size));
+		}
+	}
+
+	return data;
+}
+
+// static
+void PatchDataPool::FreeBytes(void *data, size_t size)
+{
+	if (data) {
+		MemoryStats::Sub(MemoryStats::TAG_GEOPATCH, size);
+		GetPatchDataPool(size).Free(data);
+	}
+}
+
+static BlockPool s_quadSplitRequestPool(sizeof(SQuadSplitRequest));
+static BlockPool s_quadSplitResultPool(sizeof(SQuadSplitResult));
+
+void *SQuadSplitRequest::operator new(size_t size)
+{
+	assert(size == s_quadSplitRequestPool.GetBlockSize());
+	return s_quadSplitRequestPool.Allocate();
+}
+
+void SQuadSplitRequest::operator delete(void *ptr)
+{
+	s_quadSplitRequestPool.Free(ptr);
+}
+
+void *SQuadSplitResult::operator new(size_t size)
+{
+	assert(size == s_quadSplitResultPool.GetBlockSize());
+	return s_quadSplitResultPool.Allocate();
+}
+
+void SQuadSplitResult::operator delete(void *ptr)
+{
+	s_quadSplitResultPool.Free(ptr);
+}
+
+// ********************************************************************************
+// Batches several small quad split requests into a single job
+// ********************************************************************************
+// static
+size_t QuadPatchBatchJob::GetBatchSize(const int edgeLen)
+{
+	// aim for roughly the same amount of work as a single highest-detail patch
+	static const int TARGET_BATCH_VERTICES = 33 * 33;
+	const int numVerts = std::max(edgeLen * edgeLen, 1);
+	return Clamp<size_t>(TARGET_BATCH_VERTICES / numVerts, 1, MAX_BATCH_SIZE);
+}
+
+QuadPatchBatchJob::~QuadPatchBatchJob()
+{
+	for (SQuadSplitResult *result : mpResults) {
+		result->OnCancel();
+		delete result;
+	}
+}
+
+void QuadPatchBatchJob::OnRun() // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
+{
+	PROFILE_SCOPED()
+	BasePatchJob::OnRun();
+
+	// requests are sorted nearest first, so generate them in order and stop
+	// as soon as the batch is no longer wanted
+	for (auto &request : mData) {
+		SQuadSplitResult *result = request->LoadFromCache();
+		if (!result) {
+			if (!request->GenerateBorderedData(*this))
+				return;
+
+			result = request->GenerateSubPatches(*this);
+			if (!result)
+				return;
+		}
+
+		mpResults.push_back(result);
+	}
+}
+
+void QuadPatchBatchJob::OnFinish() // runs in primary thread of the context
+{
+	for (size_t i = 0; i < mpResults.size(); i++)
+		GeoSphere::OnAddQuadSplitResult(mData[i]->sysPath, mpResults[i]);
+	mpResults.clear();
+	BasePatchJob::OnFinish();
 }
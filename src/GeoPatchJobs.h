@@ -7,15 +7,63 @@
 #include <SDL_stdinc.h>
 
 #include "Color.h"
+#include "GeoPatchHeights.h"
 #include "GeoPatchID.h"
 #include "JobQueue.h"
 #include "vector3.h"
 #include "terrain/Terrain.h"
 
+#include <memory>
+#include <type_traits>
+
 class GeoSphere;
+class SQuadSplitResult;
+
+namespace Perf {
+	class Stats;
+}
 
 #define BORDER_SIZE 1
 
+// ********************************************************************************
+// Slab pools for the height, normal and colour arrays generated by the split
+// jobs and owned by GeoPatches until they merge. Buffers are recycled by size,
+// so are only returned to the heap when the detail level changes.
+// ********************************************************************************
+class PatchDataPool {
+public:
+	// register allocation counters with the given stats
+	static void Init(Perf::Stats *stats);
+	// release all cached buffers back to the heap
+	static void Clear();
+
+	template <typename T>
+	static T *Allocate(const int numVerts)
+	{
+		static_assert(std::is_trivially_destructible<T>::value, "pooled patch data must be trivially destructible");
+		T *data = static_cast<T *>(AllocateBytes(sizeof(T) * numVerts));
+		std::uninitialized_default_construct_n(data, numVerts);
+		return data;
+	}
+
+	template <typename T>
+	static void Free(T *data, const int numVerts) { FreeBytes(data, sizeof(T) * numVerts); }
+
+	// deleter for pooled patch data owned by a std::unique_ptr
+	template <typename T>
+	struct Deleter {
+		int numVerts = 0;
+		void operator()(T *data) const { Free(data, numVerts); }
+	};
+
+	template <typename T>
+	using Ptr = std::unique_ptr<T[], Deleter<T>>;
+
+private:
+	static void *AllocateBytes(size_t size);
+	static void FreeBytes(void *data, size_t size);
+};
+
 class SBaseRequest {
 public:
 	SBaseRequest(const vector3d &v0_, const vector3d &v1_, const vector3d &v2_, const vector3d &v3_, const vector3d &cn,
@@ -60,26 +108,45 @@ public:
 	{
 		const int numVerts = NUMVERTICES(edgeLen_);
 		for (int i = 0; i < 4; ++i) {
-			heights[i] = new double[numVerts];
-			normals[i] = new vector3f[numVerts];
-			colors[i] = new Color3ub[numVerts];
+			heights[i] = PatchDataPool::Allocate<PatchHeight>(numVerts);
+			normals[i] = PatchDataPool::Allocate<vector3f>(numVerts);
+			colors[i] = PatchDataPool::Allocate<Color3ub>(numVerts);
 		}
 		const int numBorderedVerts = NUMVERTICES((edgeLen_ * 2) + (BORDER_SIZE * 2) - 1);
 		borderHeights.reset(new double[numBorderedVerts]);
 		borderVertexs.reset(new vector3d[numBorderedVerts]);
 	}
 
-	// Generates full-detail vertices, and also non-edge normals and colors
-	void GenerateBorderedData() const;
+	// frees any arrays which were not handed over to a result
+	~SQuadSplitRequest();
 
-	void GenerateSubPatchData(const int quadrantIndex,
+	// Generates full-detail vertices, and also non-edge normals and colors.
+	// Both return false if the job was cancelled before the data was complete.
+	bool GenerateBorderedData(const Job &job);
+
+	bool GenerateSubPatchData(const Job &job, const int quadrantIndex,
 		const vector3d &v0, const vector3d &v1, const vector3d &v2, const vector3d &v3,
 		const int edgeLen, const int xoff, const int yoff, const int borderedEdgeLen) const;
 
+	// Generates the data for all four sub-patches from the bordered heightmap,
+	// and hands the sub-patch arrays over to the returned result.
+	// Returns nullptr if the job was cancelled before the data was complete.
+	SQuadSplitResult *GenerateSubPatches(const Job &job);
+
+	// Reads the sub-patch data from the GeoPatchCache instead of generating
+	// it, returning the result or nullptr if it isn't cached.
+	SQuadSplitResult *LoadFromCache();
+	void SaveToCache() const;
+
+	// requests are allocated and freed at a high rate, so are pooled
+	static void *operator new(size_t size);
+	static void operator delete(void *ptr);
+
 	// these are created with the request and are given to the resulting patches
 	vector3f *normals[4];
 	Color3ub *colors[4];
-	double *heights[4];
+	PatchHeight *heights[4];
+	double baseHeight = 0.0; // of all four heights arrays
 
 	// these are created with the request but are destroyed when the request is finished
 	std::unique_ptr<double[]> borderHeights;
@@ -88,6 +155,9 @@ public:
 protected:
 	// deliberately prevent copy constructor access
 	SQuadSplitRequest(const SQuadSplitRequest &r) = delete;
+
+	// hands the sub-patch arrays over to a new result
+	SQuadSplitResult *CreateResult();
 };
 
 class SSingleSplitRequest : public SBaseRequest {
@@ -98,22 +168,32 @@ public:
 		SBaseRequest(v0_, v1_, v2_, v3_, cn, depth_, sysPath_, patchID_, edgeLen_, fracStep_, pTerrain_)
 	{
 		const int numVerts = NUMVERTICES(edgeLen_);
-		heights = new double[numVerts];
-		normals = new vector3f[numVerts];
-		colors = new Color3ub[numVerts];
+		heights = PatchDataPool::Allocate<PatchHeight>(numVerts);
+		normals = PatchDataPool::Allocate<vector3f>(numVerts);
+		colors = PatchDataPool::Allocate<Color3ub>(numVerts);
 
 		const int numBorderedVerts = NUMVERTICES(edgeLen_ + (BORDER_SIZE * 2));
 		borderHeights.reset(new double[numBorderedVerts]);
 		borderVertexs.reset(new vector3d[numBorderedVerts]);
 	}
 
-	// Generates full-detail vertices, and also non-edge normals and colors
-	void GenerateMesh() const;
+	// frees any arrays which were not handed over to a result
+	~SSingleSplitRequest();
+
+	// Generates full-detail vertices, and also non-edge normals and colors.
+	// Returns false if the job was cancelled before the mesh was complete.
+	bool GenerateMesh(const Job &job);
+
+	// Reads the mesh from the GeoPatchCache instead of generating it,
+	// returning false if it isn't cached.
+	bool LoadFromCache();
+	void SaveToCache() const;
 
 	// these are created with the request and are given to the resulting patches
 	vector3f *normals;
 	Color3ub *colors;
-	double *heights;
+	PatchHeight *heights;
+	double baseHeight = 0.0;
 
 	// these are created with the request but are destroyed when the request is finished
 	std::unique_ptr<double[]> borderHeights;
@@ -126,11 +206,18 @@ protected:
 
 struct SSplitResultData {
 	SSplitResultData() :
+		heights(nullptr),
+		baseHeight(0.0),
+		normals(nullptr),
+		colors(nullptr),
+		numVerts(0),
 		patchID(0) {}
-	SSplitResultData(double *heights_, vector3f *n_, Color3ub *c_, const vector3d &v0_, const vector3d &v1_, const vector3d &v2_, const vector3d &v3_, const GeoPatchID &patchID_) :
+	SSplitResultData(PatchHeight *heights_, double baseHeight_, vector3f *n_, Color3ub *c_, const int numVerts_, const vector3d &v0_, const vector3d &v1_, const vector3d &v2_, const vector3d &v3_, const GeoPatchID &patchID_) :
 		heights(heights_),
+		baseHeight(baseHeight_),
 		normals(n_),
 		colors(c_),
+		numVerts(numVerts_),
 		v0(v0_),
 		v1(v1_),
 		v2(v2_),
@@ -138,9 +225,23 @@ struct SSplitResultData {
 		patchID(patchID_)
 	{}
 
-	double *heights;
+	// returns the arrays to the PatchDataPool
+	void OnCancel()
+	{
+		PatchDataPool::Free(heights, numVerts);
+		PatchDataPool::Free(normals, numVerts);
+		PatchDataPool::Free(colors, numVerts);
+		heights = nullptr;
+		normals = nullptr;
+		colors = nullptr;
+	}
+
+	// pooled arrays allocated by the PatchDataPool
+	PatchHeight *heights;
+	double baseHeight; // see PatchHeights
 	vector3f *normals;
 	Color3ub *colors;
+	int numVerts;
 	vector3d v0, v1, v2, v3;
 	GeoPatchID patchID;
 };
@@ -176,29 +277,21 @@ public:
 	{
 	}
 
-	void addResult(const int kidIdx, double *h_, vector3f *n_, Color3ub *c_, const vector3d &v0_, const vector3d &v1_, const vector3d &v2_, const vector3d &v3_, const GeoPatchID &patchID_)
+	void addResult(const int kidIdx, PatchHeight *h_, double baseHeight_, vector3f *n_, Color3ub *c_, const int numVerts_, const vector3d &v0_, const vector3d &v1_, const vector3d &v2_, const vector3d &v3_, const GeoPatchID &patchID_)
 	{
 		assert(kidIdx >= 0 && kidIdx < NUM_RESULT_DATA);
-		mData[kidIdx] = (SSplitResultData(h_, n_, c_, v0_, v1_, v2_, v3_, patchID_));
+		mData[kidIdx] = (SSplitResultData(h_, baseHeight_, n_, c_, numVerts_, v0_, v1_, v2_, v3_, patchID_));
 	}
 
 	inline const SSplitResultData &data(const int32_t idx) const { return mData[idx]; }
 
+	static void *operator new(size_t size);
+	static void operator delete(void *ptr);
+
 	virtual void OnCancel()
 	{
 		for (int i = 0; i < NUM_RESULT_DATA; ++i) {
-			if (mData[i].heights) {
-				delete[] mData[i].heights;
-				mData[i].heights = NULL;
-			}
-			if (mData[i].normals) {
-				delete[] mData[i].normals;
-				mData[i].normals = NULL;
-			}
-			if (mData[i].colors) {
-				delete[] mData[i].colors;
-				mData[i].colors = NULL;
-			}
+			mData[i].OnCancel();
 		}
 	}
 
@@ -217,29 +310,16 @@ public:
 	{
 	}
 
-	void addResult(double *h_, vector3f *n_, Color3ub *c_, const vector3d &v0_, const vector3d &v1_, const vector3d &v2_, const vector3d &v3_, const GeoPatchID &patchID_)
+	void addResult(PatchHeight *h_, double baseHeight_, vector3f *n_, Color3ub *c_, const int numVerts_, const vector3d &v0_, const vector3d &v1_, const vector3d &v2_, const vector3d &v3_, const GeoPatchID &patchID_)
 	{
-		mData = (SSplitResultData(h_, n_, c_, v0_, v1_, v2_, v3_, patchID_));
+		mData = (SSplitResultData(h_, baseHeight_, n_, c_, numVerts_, v0_, v1_, v2_, v3_, patchID_));
 	}
 
 	inline const SSplitResultData &data() const { return mData; }
 
 	virtual void OnCancel()
 	{
-		{
-			if (mData.heights) {
-				delete[] mData.heights;
-				mData.heights = NULL;
-			}
-			if (mData.normals) {
-				delete[] mData.normals;
-				mData.normals = NULL;
-			}
-			if (mData.colors) {
-				delete[] mData.colors;
-				mData.colors = NULL;
-			}
-		}
+		mData.OnCancel();
 	}
 
 protected:
@@ -257,7 +337,9 @@ class GeoPatch;
 // ********************************************************************************
 class BasePatchJob : public Job {
 public:
-	BasePatchJob() {}
+	// terrain patches are generated for the area the player is looking at
+	BasePatchJob(Priority priority = PRIORITY_HIGH) :
+		Job(priority) {}
 	virtual void OnRun() {} // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
 	virtual void OnFinish() {}
 	virtual void OnCancel() {}
@@ -288,13 +370,15 @@ private:
 // ********************************************************************************
 class QuadPatchJob : public BasePatchJob {
 public:
-	QuadPatchJob(SQuadSplitRequest *data) :
+	QuadPatchJob(SQuadSplitRequest *data, Priority priority = PRIORITY_HIGH) :
+		BasePatchJob(priority),
 		mData(data),
 		mpResults(NULL)
 	{ /* empty */
 	}
 	~QuadPatchJob();
 
+	// Runs in two stages: bordered heightmap generation, then sub-patch data
 	virtual void OnRun(); // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
 	virtual void OnFinish(); // runs in primary thread of the context
 
@@ -303,4 +387,32 @@ private:
 	SQuadSplitResult *mpResults;
 };
 
+// ********************************************************************************
+// Generates the data for several small quad splits in a single job, to cut
+// down on queue traffic when patches are cheap to generate
+// ********************************************************************************
+class QuadPatchBatchJob : public BasePatchJob {
+public:
+	// upper bound on the number of requests in a single batch
+	static constexpr size_t MAX_BATCH_SIZE = 8;
+
+	// Number of requests worth batching together for the given patch edge
+	// length; 1 when patches are large enough to be worth a job each.
+	static size_t GetBatchSize(const int edgeLen);
+
+	QuadPatchBatchJob(Priority priority = PRIORITY_HIGH) :
+		BasePatchJob(priority) {}
+	~QuadPatchBatchJob();
+
+	void AddRequest(SQuadSplitRequest *data) { mData.emplace_back(data); }
+	size_t GetNumRequests() const { return mData.size(); }
+
+	virtual void OnRun(); // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
+	virtual void OnFinish(); // runs in primary thread of the context
+
+private:
+	std::vector<std::unique_ptr<SQuadSplitRequest>> mData;
+	std::vector<SQuadSplitResult *> mpResults;
+};
+
 #endif /* _GEOPATCHJOBS_H */
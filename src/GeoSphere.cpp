@@ -5,10 +5,12 @@
 
 #include "GameConfig.h"
 #include "GeoPatch.h"
+#include "GeoPatchCache.h"
 #include "GeoPatchContext.h"
 #include "GeoPatchJobs.h"
 #include "Pi.h"
 #include "RefCounted.h"
+#include "core/TaskGraph.h"
 #include "galaxy/AtmosphereParameters.h"
 #include "galaxy/StarSystem.h"
 #include "graphics/Frustum.h"
@@ -39,16 +41,21 @@ static const int detail_edgeLen[5] = {
 
 static const double gs_targetPatchTriLength(100.0);
 static std::vector<GeoSphere *> s_allGeospheres;
+// split requests queued as jobs since the last TakeSplitQueueStats()
+static uint32_t s_numSplitRequests = 0;
 
 void GeoSphere::Init()
 {
 	s_patchContext.Reset(new GeoPatchContext(detail_edgeLen[Pi::detail.planets > 4 ? 4 : Pi::detail.planets]));
+	PatchDataPool::Init(&Pi::GetApp()->GetTaskGraph()->GetStats());
+	GeoPatchCache::Init(Pi::config->Int("TerrainDiskCache") != 0);
 }
 
 void GeoSphere::Uninit()
 {
 	assert(s_patchContext.Unique());
 	s_patchContext.Reset();
+	PatchDataPool::Clear();
 }
 
 static void print_info(const SystemBody *sbody, const Terrain *terrain)
@@ -70,6 +77,17 @@ void GeoSphere::UpdateAllGeoSpheres()
 	}
 }
 
+// static
+void GeoSphere::TakeSplitQueueStats(uint32_t &requested, uint32_t &pendingResults)
+{
+	requested = s_numSplitRequests;
+	s_numSplitRequests = 0;
+
+	pendingResults = 0;
+	for (const GeoSphere *geoSphere : s_allGeospheres)
+		pendingResults += uint32_t(geoSphere->mQuadSplitResults.size() + geoSphere->mSingleSplitResults.size());
+}
+
 // static
 void GeoSphere::OnChangeDetailLevel()
 {
@@ -89,6 +107,9 @@ void GeoSphere::OnChangeDetailLevel()
 			(*i)->CreateAtmosphereMaterial();
 		}
 	}
+
+	// buffers cached for the old patch size won't be requested again
+	PatchDataPool::Clear();
 }
 
 //static
@@ -165,6 +186,9 @@ void GeoSphere::Reset()
 		mQuadSplitResults.clear();
 	}
 
+	// cancel any batched split jobs still in flight
+	m_batchJobs = JobSet(Pi::GetAsyncJobQueue());
+
 	for (int p = 0; p < NUM_PATCHES; p++) {
 		// delete patches
 		if (m_patches[p]) {
@@ -179,6 +203,7 @@ void GeoSphere::Reset()
 
 GeoSphere::GeoSphere(const SystemBody *body) :
 	BaseSphere(body),
+	m_batchJobs(Pi::GetAsyncJobQueue()),
 	m_hasTempCampos(false),
 	m_tempCampos(0.0),
 	m_tempFrustum(800, 600, 0.5, 1.0, 1000.0),
@@ -358,19 +383,62 @@ void GeoSphere::Update()
 	}
 }
 
-void GeoSphere::AddQuadSplitRequest(double dist, SQuadSplitRequest *pReq, GeoPatch *pPatch)
+void GeoSphere::AddQuadSplitRequest(double dist, bool visible, GeoPatch *pPatch)
 {
-	mQuadSplitRequests.push_back(TDistanceRequest(dist, pReq, pPatch));
+	mQuadSplitRequests.push_back(TDistanceRequest(dist, visible, pPatch));
 }
 
+// Visible patches are split nearest first. Patches outside the view are
+// queued after them at a lower priority, and only a few per update, so
+// they don't hold up what's on screen; the rest are left for the next
+// LOD update to ask for again.
 void GeoSphere::ProcessQuadSplitRequests()
 {
-	std::sort(mQuadSplitRequests.begin(), mQuadSplitRequests.end(), [](TDistanceRequest &a, TDistanceRequest &b) { return a.mDistance < b.mDistance; });
+	std::sort(mQuadSplitRequests.begin(), mQuadSplitRequests.end(), [](const TDistanceRequest &a, const TDistanceRequest &b) {
+		if (a.mVisible != b.mVisible)
+			return a.mVisible;
+		return a.mDistance < b.mDistance;
+	});
+
+	// visible requests sort first, so this drops the furthest hidden ones
+	const size_t numHidden = std::count_if(mQuadSplitRequests.begin(), mQuadSplitRequests.end(),
+		[](const TDistanceRequest &request) { return !request.mVisible; });
+	if (numHidden > MAX_HIDDEN_SPLIT_REQUESTS)
+		mQuadSplitRequests.erase(mQuadSplitRequests.end() - (numHidden - MAX_HIDDEN_SPLIT_REQUESTS), mQuadSplitRequests.end());
+
+	const size_t batchSize = QuadPatchBatchJob::GetBatchSize(s_patchContext->GetEdgeLen() - 2);
+	if (batchSize <= 1) {
+		for (auto iter : mQuadSplitRequests) {
+			SQuadSplitRequest *ssrd = iter.mpRequester->CreateSplitRequest();
+			const Job::Priority priority = iter.mVisible ? Job::PRIORITY_HIGH : Job::PRIORITY_NORMAL;
+			iter.mpRequester->ReceiveJobHandle(Pi::GetAsyncJobQueue()->Queue(new QuadPatchJob(ssrd, priority)));
+		}
+	} else {
+		// small patches are cheap to generate, so group neighbouring requests
+		// to save on per-job overhead
+		QuadPatchBatchJob *batch = nullptr;
+		bool batchVisible = true;
+		for (auto iter : mQuadSplitRequests) {
+			// batches don't mix visible and hidden patches
+			if (batch && batchVisible != iter.mVisible) {
+				m_batchJobs.Order(batch);
+				batch = nullptr;
+			}
+			if (!batch) {
+				batchVisible = iter.mVisible;
+				batch = new QuadPatchBatchJob(batchVisible ? Job::PRIORITY_HIGH : Job::PRIORITY_NORMAL);
+			}
 
-	for (auto iter : mQuadSplitRequests) {
-		SQuadSplitRequest *ssrd = iter.mpRequest;
-		iter.mpRequester->ReceiveJobHandle(Pi::GetAsyncJobQueue()->Queue(new QuadPatchJob(ssrd)));
+			batch->AddRequest(iter.mpRequester->CreateSplitRequest());
+			if (batch->GetNumRequests() == batchSize) {
+				m_batchJobs.Order(batch);
+				batch = nullptr;
+			}
+		}
+		if (batch)
+			m_batchJobs.Order(batch);
 	}
+	s_numSplitRequests += uint32_t(mQuadSplitRequests.size());
 	mQuadSplitRequests.clear();
 }
 
@@ -408,6 +476,7 @@ void GeoSphere::Render(Graphics::Renderer *renderer, const matrix4x4d &modelView
 		// make atmosphere sphere slightly bigger than required so
 		// that the edges of the pixel shader atmosphere jizz doesn't
 		// show ugly polygonal angles
+		Graphics::Renderer::GPUZoneTicket zone(renderer, "Atmosphere");
 		DrawAtmosphereSurface(renderer, trans, campos,
 			ap.atmosRadius * 1.02,
 			m_atmosphereMaterial);
@@ -441,9 +510,11 @@ void GeoSphere::Render(Graphics::Renderer *renderer, const matrix4x4d &modelView
 
 	renderer->SetTransform(matrix4x4f(modelView));
 
+	renderer->PushGPUZone("GeoSphere");
 	for (int i = 0; i < NUM_PATCHES; i++) {
 		m_patches[i]->Render(renderer, campos, modelView, frustum);
 	}
+	renderer->PopGPUZone();
 
 	renderer->SetAmbientColor(oldAmbient);
 
@@ -524,4 +595,6 @@ void GeoSphere::CreateAtmosphereMaterial()
 		m_atmosphereMaterial.Reset(Pi::renderer->CreateMaterial("geosphere_sky", skyDesc, rsd));
 		break;
 	}
+
+	SetUpAtmosphereLUT(Pi::renderer, GetSystemBody()->CalcAtmosphereParams());
 }
@@ -8,6 +8,7 @@
 
 #include "BaseSphere.h"
 #include "Camera.h"
+#include "JobQueue.h"
 #include "vector3.h"
 
 #include <deque>
@@ -50,9 +51,26 @@ public:
 		return h;
 	}
 
+	virtual void GetHeights(const vector3d *p, double *heights, size_t count) const override final
+	{
+		m_terrain->GetHeights(p, heights, count);
+#ifdef DEBUG
+		for (size_t i = 0; i < count; i++) {
+			if (heights[i] < 0.0) {
+				Output("GetHeights({ %f, %f, %f }) returned %f\n", p[i].x, p[i].y, p[i].z, heights[i]);
+				m_terrain->DebugDump();
+				assert(heights[i] >= 0.0);
+			}
+		}
+#endif /* DEBUG */
+	}
+
 	static void Init();
 	static void Uninit();
 	static void UpdateAllGeoSpheres();
+	// Split requests queued since the last call, and finished splits
+	// waiting to be applied, over all geospheres
+	static void TakeSplitQueueStats(uint32_t &requested, uint32_t &pendingResults);
 	static void OnChangeDetailLevel();
 	static bool OnAddQuadSplitResult(const SystemPath &path, SQuadSplitResult *res);
 	static bool OnAddSingleSplitResult(const SystemPath &path, SSingleSplitResult *res);
@@ -67,7 +85,8 @@ public:
 
 	inline Sint32 GetMaxDepth() const { return m_maxDepth; }
 
-	void AddQuadSplitRequest(double, SQuadSplitRequest *, GeoPatch *);
+	// visible requests are processed first; see ProcessQuadSplitRequests()
+	void AddQuadSplitRequest(double dist, bool visible, GeoPatch *);
 
 private:
 	void BuildFirstPatches();
@@ -80,17 +99,22 @@ private:
 
 	std::unique_ptr<GeoPatch> m_patches[6];
 	struct TDistanceRequest {
-		TDistanceRequest(double dist, SQuadSplitRequest *pRequest, GeoPatch *pRequester) :
+		TDistanceRequest(double dist, bool visible, GeoPatch *pRequester) :
 			mDistance(dist),
-			mpRequest(pRequest),
+			mVisible(visible),
 			mpRequester(pRequester) {}
 		double mDistance;
-		SQuadSplitRequest *mpRequest;
+		bool mVisible;
 		GeoPatch *mpRequester;
 	};
 	std::deque<TDistanceRequest> mQuadSplitRequests;
+	// Batched split jobs are owned by the GeoSphere rather than the patches
+	// which requested them, and are cancelled when the patches are reset
+	JobSet m_batchJobs;
 
 	static const uint32_t MAX_SPLIT_OPERATIONS = 128;
+	// split requests for patches outside the view queued per update
+	static const uint32_t MAX_HIDDEN_SPLIT_REQUESTS = 8;
 	std::deque<SQuadSplitResult *> mQuadSplitResults;
 	std::deque<SSingleSplitResult *> mSingleSplitResults;
 
@@ -0,0 +1,88 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "HeadlessGame.h"
+
+#include "Game.h"
+#include "GameSaveError.h"
+#include "Pi.h"
+#include "WorldView.h"
+#include "core/Log.h"
+#include "galaxy/SystemPath.h"
+#include "lua/Lua.h"
+#include "lua/LuaEvent.h"
+#include "lua/LuaTimer.h"
+#include "lua/LuaUtils.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+Game *HeadlessGame::CreateGame(const char *owner, const SystemPath &path, const std::string &saveName, uint32_t seed)
+{
+	if (seed)
+		Pi::rng.seed(seed);
+
+	if (saveName.empty())
+		return new Game(path, 0.0);
+
+	try {
+		return Game::LoadGame(saveName);
+	} catch (const SavedGameCorruptException &) {
+		Output("%s: save %s is corrupt\n", owner, saveName.c_str());
+	} catch (const SavedGameWrongVersionException &) {
+		Output("%s: save %s is from another version\n", owner, saveName.c_str());
+	} catch (const CouldNotOpenFileException &) {
+		Output("%s: can't open save %s\n", owner, saveName.c_str());
+	}
+	return nullptr;
+}
+
+void HeadlessGame::StartGame(Game *game, const std::string &script)
+{
+	// XXX views expect Pi::game and Pi::player to exist; creating the game
+	// set them already
+	Pi::SetView(game->GetWorldView());
+	Pi::SetGameTickAlpha(1.0);
+
+	LuaEvent::Clear();
+	if (!script.empty())
+		pi_lua_dofile(Lua::manager->GetLuaState(), script);
+	LuaEvent::Queue("onGameStart");
+	LuaEvent::Emit();
+}
+
+void HeadlessGame::EndGame()
+{
+	if (!Pi::game)
+		return;
+
+	Pi::SetView(nullptr);
+
+	LuaEvent::Queue("onGameEnd");
+	LuaEvent::Emit();
+	Pi::luaTimer->RemoveAll();
+
+	delete Pi::game;
+	Pi::game = nullptr;
+	Pi::player = nullptr;
+}
+
+void HeadlessGame::WriteReport(const char *owner, const Json &report, const std::string &file)
+{
+	const std::string text = report.dump(2) + "\n";
+	if (file == "-") {
+		fputs(text.c_str(), stdout);
+		fflush(stdout);
+		return;
+	}
+
+	FILE *out = fopen(file.c_str(), "w");
+	if (!out || fputs(text.c_str(), out) < 0) {
+		Output("%s: could not write %s: %s\n", owner, file.c_str(), strerror(errno));
+	} else {
+		Output("%s: wrote %s\n", owner, file.c_str());
+	}
+	if (out)
+		fclose(out);
+}
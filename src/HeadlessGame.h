@@ -0,0 +1,35 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#pragma once
+
+#include "Json.h"
+
+#include <cstdint>
+#include <string>
+
+class Game;
+class SystemPath;
+
+/*
+ * The parts the lifecycles that run a game without the game loop
+ * (Benchmark and Simulation) have in common: setting up and tearing down
+ * the game around them, and writing their JSON reports. Messages are
+ * prefixed with the name of the lifecycle.
+ */
+namespace HeadlessGame {
+	// Seeds the game's random number generator unless seed is 0, then
+	// starts a new game at path or, if saveName is set, loads that save.
+	// Returns null, having said why, if the save can't be loaded.
+	Game *CreateGame(const char *owner, const SystemPath &path, const std::string &saveName, uint32_t seed);
+
+	// Makes game current and emits onGameStart, running the Lua script from
+	// the game data first if one is given
+	void StartGame(Game *game, const std::string &script = std::string());
+
+	// Emits onGameEnd and deletes the current game, if there is one
+	void EndGame();
+
+	// Writes report to file, or to stdout if file is "-"
+	void WriteReport(const char *owner, const Json &report, const std::string &file);
+} // namespace HeadlessGame
@@ -20,14 +20,6 @@ HudTrail::HudTrail(Body *b, const Color &c) :
 	m_color(c)
 {
 	m_currentFrame = b->GetFrame();
-
-	Graphics::MaterialDescriptor desc;
-
-	Graphics::RenderStateDesc rsd;
-	rsd.blendMode = Graphics::BLEND_ALPHA_ONE;
-	rsd.depthWrite = false;
-	rsd.primitiveType = Graphics::LINE_STRIP;
-	m_lineMat.reset(Pi::renderer->CreateMaterial("vtxColor", desc, rsd));
 }
 
 void HudTrail::Update(float time)
@@ -52,40 +44,39 @@ void HudTrail::Update(float time)
 		m_trailPoints.pop_front();
 }
 
-void HudTrail::Render(Graphics::Renderer *r)
+void HudTrail::AddSegments(std::vector<vector3f> &vertices, std::vector<Color> &colors) const
 {
 	PROFILE_SCOPED();
-	//render trail
-	if (m_trailPoints.size() > 1) {
-		const vector3d vpos = m_transform * m_body->GetInterpPosition();
-		m_transform[12] = vpos.x;
-		m_transform[13] = vpos.y;
-		m_transform[14] = vpos.z;
-		m_transform[15] = 1.0;
-
-		static std::vector<vector3f> tvts;
-		static std::vector<Color> colors;
-		tvts.clear();
-		colors.clear();
-		const vector3d curpos = m_body->GetInterpPosition();
-		tvts.reserve(MAX_POINTS);
-		colors.reserve(MAX_POINTS);
-
-		tvts.push_back(vector3f(0.f));
-		colors.push_back(Color::BLANK);
-		float alpha = 1.f;
-		const float decrement = 1.f / m_trailPoints.size();
-		const Color tcolor = m_color;
-		for (size_t i = m_trailPoints.size() - 1; i > 0; i--) {
-			tvts.push_back(-vector3f(curpos - m_trailPoints[i]));
-			alpha -= decrement;
-			colors.push_back(tcolor);
-			colors.back().a = Uint8(alpha * 255);
-		}
+	if (m_trailPoints.size() < 2)
+		return;
+
+	// the trail is drawn relative to where the body is now
+	matrix4x4d trans = m_transform;
+	const vector3d curpos = m_body->GetInterpPosition();
+	const vector3d vpos = m_transform * curpos;
+	trans[12] = vpos.x;
+	trans[13] = vpos.y;
+	trans[14] = vpos.z;
+	trans[15] = 1.0;
+
+	// a strip from the body back along the trail, fading out, as separate
+	// segments so trails can share a draw
+	vector3f prevPos(vpos);
+	Color prevColor = Color::BLANK;
+	float alpha = 1.f;
+	const float decrement = 1.f / m_trailPoints.size();
+	for (size_t i = m_trailPoints.size() - 1; i > 0; i--) {
+		const vector3f pos(trans * (m_trailPoints[i] - curpos));
+		alpha -= decrement;
+		Color color = m_color;
+		color.a = Uint8(alpha * 255);
 
-		r->SetTransform(matrix4x4f(m_transform));
-		m_lines.SetData(tvts.size(), &tvts[0], &colors[0]);
-		m_lines.Draw(r, m_lineMat.get());
+		vertices.push_back(prevPos);
+		colors.push_back(prevColor);
+		vertices.push_back(pos);
+		colors.push_back(color);
+		prevPos = pos;
+		prevColor = color;
 	}
 }
 
@@ -94,3 +85,28 @@ void HudTrail::Reset(FrameId newFrame)
 	m_currentFrame = newFrame;
 	m_trailPoints.clear();
 }
+
+HudTrailBatch::HudTrailBatch(Graphics::Renderer *r)
+{
+	Graphics::MaterialDescriptor desc;
+
+	Graphics::RenderStateDesc rsd;
+	rsd.blendMode = Graphics::BLEND_ALPHA_ONE;
+	rsd.depthWrite = false;
+	rsd.primitiveType = Graphics::LINE_SINGLE;
+	m_lineMat.reset(r->CreateMaterial("vtxColor", desc, rsd));
+}
+
+void HudTrailBatch::Draw(Graphics::Renderer *r)
+{
+	PROFILE_SCOPED();
+	if (m_vertices.empty())
+		return;
+
+	r->SetTransform(matrix4x4f::Identity());
+	m_lines.SetData(m_vertices.size(), m_vertices.data(), m_colors.data());
+	m_lines.Draw(r, m_lineMat.get());
+
+	m_vertices.clear();
+	m_colors.clear();
+}
@@ -10,6 +10,7 @@
 #include "matrix4x4.h"
 
 #include <deque>
+#include <vector>
 // trail drawn after an object to track motion
 
 namespace Graphics {
@@ -23,12 +24,14 @@ class HudTrail {
 public:
 	HudTrail(Body *b, const Color &);
 	void Update(float time);
-	void Render(Graphics::Renderer *r);
 	void Reset(const FrameId newFrame);
 
 	void SetColor(const Color &c) { m_color = c; }
 	void SetTransform(const matrix4x4d &t) { m_transform = t; }
 
+	// Appends the trail as camera-space line segments
+	void AddSegments(std::vector<vector3f> &vertices, std::vector<Color> &colors) const;
+
 private:
 	Body *m_body;
 	FrameId m_currentFrame;
@@ -36,6 +39,21 @@ private:
 	Color m_color;
 	matrix4x4d m_transform;
 	std::deque<vector3d> m_trailPoints;
+};
+
+// Collects the trails drawn in a frame so they go to the renderer as a
+// single draw, rather than one per contact
+class HudTrailBatch {
+public:
+	HudTrailBatch(Graphics::Renderer *r);
+
+	void Add(const HudTrail &trail) { trail.AddSegments(m_vertices, m_colors); }
+	// Draws and empties the batch
+	void Draw(Graphics::Renderer *r);
+
+private:
+	std::vector<vector3f> m_vertices;
+	std::vector<Color> m_colors;
 	std::unique_ptr<Graphics::Material> m_lineMat;
 	Graphics::Drawables::Lines m_lines;
 };
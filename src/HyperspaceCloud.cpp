@@ -16,6 +16,8 @@
 #include "graphics/Renderer.h"
 #include "perlin.h"
 
+#include <algorithm>
+
 using namespace Graphics;
 
 /** How long does a hyperspace cloud last for? 2 Days? */
@@ -104,6 +106,19 @@ void HyperspaceCloud::TimeStepUpdate(const float timeStep)
 		return;
 
 	SetPosition(GetPosition() + m_vel * timeStep);
+}
+
+double HyperspaceCloud::GetNextEventTime() const
+{
+	if (m_isArrival && m_ship)
+		return std::min(m_due, m_birthdate + HYPERCLOUD_DURATION);
+	return m_birthdate + HYPERCLOUD_DURATION;
+}
+
+void HyperspaceCloud::ProcessEvents()
+{
+	if (m_isBeingKilled)
+		return;
 
 	if (m_isArrival && m_ship && (m_due < Pi::game->GetTime())) {
 		// spawn ship
@@ -27,6 +27,10 @@ public:
 	virtual void Render(Graphics::Renderer *r, const Camera *camera, const vector3d &viewCoords, const matrix4x4d &viewTransform) override;
 	virtual void PostLoadFixup(Space *space) override;
 	virtual void TimeStepUpdate(const float timeStep) override;
+	// game time of the next arrival or expiry, which Space waits for
+	// rather than each cloud checking every step
+	double GetNextEventTime() const;
+	void ProcessEvents();
 	Ship *GetShip() { return m_ship; }
 	Ship *EvictShip();
 	double GetDueDate() const { return m_due; }
@@ -613,6 +613,14 @@ void Manager::RebuildInputFrames()
 			m_modifiers.emplace(chord->modifier2, GetBindingState(chord->modifier2));
 	}
 
+	m_modifierTable.clear();
+	for (auto &pair : m_modifiers)
+		m_modifierTable[pair.first.GetSourceKey()].emplace_back(&pair.first, &pair.second);
+
+	m_chordTable.clear();
+	for (auto *chord : m_chords)
+		m_chordTable[chord->activator.GetSourceKey()].push_back(chord);
+
 	m_frameListChanged = false;
 }
 
@@ -733,17 +741,29 @@ void Manager::HandleSDLEvent(SDL_Event &event)
 	if (!m_enableBindings)
 		return;
 
+	// Mouse and axis motion can't match a binding
+	const uint64_t sourceKey = KeyBinding::SourceKeyFromEvent(event);
+	if (!sourceKey)
+		return;
+
 	// Update the modifier status from this event
-	for (auto &pair : m_modifiers) {
-		auto r = pair.first.Matches(event);
-		if (r != Response::Ignored) {
-			pair.second = r == Response::Pressed ? true : false;
+	auto modifiers = m_modifierTable.find(sourceKey);
+	if (modifiers != m_modifierTable.end()) {
+		for (auto &pair : modifiers->second) {
+			auto r = pair.first->Matches(event);
+			if (r != Response::Ignored) {
+				*pair.second = r == Response::Pressed ? true : false;
+			}
 		}
 	}
 
+	auto chords = m_chordTable.find(sourceKey);
+	if (chords == m_chordTable.end())
+		return;
+
 	// If the event matches one of the key chords we care about, update that chord
 	int num_keys_in_chord = 0;
-	for (auto *chord : m_chords) {
+	for (auto *chord : chords->second) {
 		Response activator = chord->activator.Matches(event);
 		if (activator == Response::Ignored)
 			continue;
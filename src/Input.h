@@ -5,6 +5,7 @@
 #define INPUT_H
 
 #include "InputBindings.h"
+#include "core/FlatHashMap.h"
 
 #include "SDL_joystick.h"
 
@@ -262,6 +263,12 @@ private:
 
 	std::map<InputBindings::KeyBinding, bool> m_modifiers;
 	std::vector<InputBindings::KeyChord *> m_chords;
+
+	// The modifiers and chords above by the source key of their binding, so
+	// an event only visits the bindings it can match. Chords keep the order
+	// of m_chords. Rebuilt along with them.
+	FlatHashMap<uint64_t, std::vector<std::pair<const InputBindings::KeyBinding *, bool *>>> m_modifierTable;
+	FlatHashMap<uint64_t, std::vector<InputBindings::KeyChord *>> m_chordTable;
 };
 
 #endif
@@ -72,6 +72,46 @@ Response KeyBinding::Matches(const SDL_Event &ev) const
 	return Response::Ignored;
 }
 
+static uint64_t MakeSourceKey(KeyBinding::Type type, uint16_t device, uint32_t code)
+{
+	return (uint64_t(type) << 48) | (uint64_t(device) << 32) | code;
+}
+
+uint64_t KeyBinding::GetSourceKey() const
+{
+	switch (type) {
+	case Type::KeyboardKey:
+		return MakeSourceKey(type, 0, uint32_t(keycode));
+	case Type::JoystickButton:
+		return MakeSourceKey(type, joystick.id, joystick.button);
+	case Type::JoystickHat:
+		return MakeSourceKey(type, joystick.id, joystick.hat);
+	case Type::MouseButton:
+		return MakeSourceKey(type, 0, mouse.button);
+	default:
+		return 0;
+	}
+}
+
+uint64_t KeyBinding::SourceKeyFromEvent(const SDL_Event &ev)
+{
+	switch (ev.type) {
+	case SDL_KEYDOWN:
+	case SDL_KEYUP:
+		return MakeSourceKey(Type::KeyboardKey, 0, uint32_t(ev.key.keysym.sym));
+	case SDL_JOYBUTTONDOWN:
+	case SDL_JOYBUTTONUP:
+		return MakeSourceKey(Type::JoystickButton, Input::JoystickFromID(ev.jbutton.which), ev.jbutton.button);
+	case SDL_JOYHATMOTION:
+		return MakeSourceKey(Type::JoystickHat, Input::JoystickFromID(ev.jhat.which), ev.jhat.hat);
+	case SDL_MOUSEBUTTONDOWN:
+	case SDL_MOUSEBUTTONUP:
+		return MakeSourceKey(Type::MouseButton, 0, ev.button.button);
+	default:
+		return 0;
+	}
+}
+
 bool KeyBinding::operator==(const KeyBinding &rhs) const
 {
 	if (type != rhs.type)
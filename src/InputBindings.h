@@ -78,6 +78,13 @@ namespace InputBindings {
 		bool Enabled() const { return type != Type::Disabled; }
 		Response Matches(const SDL_Event &ev) const;
 
+		// The key, button or hat this binding listens to, packed into one
+		// value so bindings can be looked up by the events they may match.
+		// Hat bindings share the key of their hat whatever the direction.
+		uint64_t GetSourceKey() const;
+		// Source key of the bindings an event may match, 0 if it can't match any
+		static uint64_t SourceKeyFromEvent(const SDL_Event &ev);
+
 		bool operator==(const KeyBinding &rhs) const;
 		bool operator<(const KeyBinding &rhs) const;
 
@@ -5,6 +5,8 @@
 #include "StringF.h"
 #include "profiler/Profiler.h"
 
+#include "SDL_timer.h"
+
 void Job::UnlinkHandle()
 {
 	Handle *handle = m_handle.load(std::memory_order_acquire);
@@ -108,12 +110,18 @@ Job::Handle SyncJobQueue::Queue(Job *job, JobClient *client)
 }
 
 // call OnFinish methods for completed jobs, and clean up
-Uint32 SyncJobQueue::FinishJobs()
+Uint32 SyncJobQueue::FinishJobs(Uint32 maxMicros)
 {
 	PROFILE_SCOPED()
 	Uint32 finished = 0;
 
+	const Uint64 startTicks = SDL_GetPerformanceCounter();
+	const Uint64 maxTicks = maxMicros * SDL_GetPerformanceFrequency() / 1000000;
+
 	while (!m_finished.empty()) {
+		if (maxTicks && finished && SDL_GetPerformanceCounter() - startTicks > maxTicks)
+			break;
+
 		Job *job = m_finished.front();
 		m_finished.pop_front();
 
@@ -169,7 +177,12 @@ Uint32 SyncJobQueue::RunJobs(Uint32 count)
 		m_queue.pop_front();
 		job->OnRun();
 		executed++;
-		m_finished.push_back(job);
+
+		// run the next stage of a multi-stage job before anything else
+		if (job->AdvanceStage())
+			m_queue.push_front(job);
+		else
+			m_finished.push_back(job);
 	}
 	return executed;
 }
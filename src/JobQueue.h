@@ -30,8 +30,26 @@ class JobQueue;
 // OnCancel: optional. called from the main thread to tell the job that its
 //           results are not wanted. it should arrange for OnRun to return
 //           as quickly as possible. OnFinish will not be called for the job
+//
+// Jobs are dispatched in priority order; within a priority level they run in
+// the order in which they were queued.
+//
+// Multi-stage jobs can call ContinueWithNextStage() from OnRun to have the job
+// queued again for its next stage on a worker thread, so dependent CPU stages
+// run back-to-back without a round trip through the main thread. OnFinish is
+// only called once the final stage has run.
 class Job {
 public:
+	enum Priority {
+		// latency-sensitive work the player is waiting on (e.g. visible terrain)
+		PRIORITY_HIGH = 0,
+		// default priority for most jobs (e.g. gas giant textures)
+		PRIORITY_NORMAL,
+		// background work that can wait for the system to go idle (e.g. galaxy generation)
+		PRIORITY_LOW,
+		PRIORITY_MAX
+	};
+
 	// This is the RAII handle for a queued Job. A job is cancelled when the
 	// Job::Handle is destroyed. There is at most one Job::Handle for each Job
 	// (non-queued Jobs have no handle). Job::Handle is not copyable only
@@ -73,9 +91,12 @@ public:
 	};
 
 public:
-	Job() :
+	Job(Priority priority = PRIORITY_NORMAL) :
 		cancelled(false),
-		m_handle(nullptr) {}
+		m_handle(nullptr),
+		m_priority(priority),
+		m_stage(0),
+		m_continue(false) {}
 	virtual ~Job();
 
 	Job(const Job &) = delete;
@@ -85,6 +106,22 @@ public:
 	virtual void OnFinish() = 0;
 	virtual void OnCancel() {}
 
+	// Returns true once the job has been cancelled. Long-running OnRun
+	// implementations should check this periodically and return early, as
+	// the results of a cancelled job will be discarded.
+	bool IsCancelled() const { return cancelled.load(std::memory_order_relaxed); }
+
+	// Priority may only be changed before the job is queued.
+	Priority GetPriority() const { return m_priority; }
+	void SetPriority(Priority priority) { m_priority = priority; }
+
+protected:
+	// Call from OnRun to request another OnRun call for the next stage of
+	// this job. Cancelled jobs do not continue to their next stage.
+	void ContinueWithNextStage() { m_continue = true; }
+	// Index of the stage currently being run, starting from zero.
+	uint32_t GetStage() const { return m_stage; }
+
 private:
 	friend class AsyncJobQueue;
 	friend class SyncJobQueue;
@@ -99,8 +136,22 @@ private:
 	void SetHandle(Handle *handle) { m_handle.store(handle, std::memory_order_release); }
 	void ClearHandle() { m_handle = nullptr; }
 
+	// Returns true if the job has requested another stage, advancing to it
+	bool AdvanceStage()
+	{
+		if (!m_continue || cancelled.load(std::memory_order_acquire))
+			return false;
+
+		m_continue = false;
+		m_stage++;
+		return true;
+	}
+
 	std::atomic<bool> cancelled;
 	std::atomic<Handle *> m_handle;
+	Priority m_priority;
+	uint32_t m_stage;
+	bool m_continue;
 };
 
 // the queue management class. create one from the main thread, and feed your
@@ -125,7 +176,10 @@ public:
 	// call from the main loop. this will call OnFinish for any finished jobs,
 	// and then delete all finished and cancelled jobs. returns the number of
 	// finished jobs (not cancelled)
-	virtual Uint32 FinishJobs() = 0;
+	// If maxMicros is non-zero, stop processing once that much time has been
+	// spent; remaining jobs are processed on the next call. At least one job
+	// is always processed so the queue continues to make progress.
+	virtual Uint32 FinishJobs(Uint32 maxMicros = 0) = 0;
 };
 
 class SyncJobQueue : public JobQueue {
@@ -135,7 +189,7 @@ public:
 
 	virtual Job::Handle Queue(Job *job, JobClient *client = nullptr) override;
 	virtual void Cancel(Job *job) override;
-	virtual Uint32 FinishJobs() override;
+	virtual Uint32 FinishJobs(Uint32 maxMicros = 0) override;
 
 	Uint32 RunJobs(Uint32 count = 1);
 
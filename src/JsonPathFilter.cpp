@@ -0,0 +1,252 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "JsonPathFilter.h"
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+namespace {
+	using Segment = JsonPathFilter::Segment;
+	using Path = JsonPathFilter::Path;
+
+	Path ParsePath(const std::string &text)
+	{
+		Path path;
+		size_t pos = 0;
+		while (pos < text.size()) {
+			if (text[pos] == '[') {
+				const size_t close = text.find(']', pos);
+				if (close == std::string::npos || close == pos + 1)
+					throw std::invalid_argument("unterminated index in JSON path " + text);
+				const std::string index = text.substr(pos + 1, close - pos - 1);
+				if (index == "*") {
+					path.push_back({ Segment::ANY_INDEX, std::string(), 0 });
+				} else {
+					if (index.find_first_not_of("0123456789") != std::string::npos)
+						throw std::invalid_argument("bad index in JSON path " + text);
+					path.push_back({ Segment::INDEX, std::string(), size_t(std::stoull(index)) });
+				}
+				pos = close + 1;
+			} else {
+				if (text[pos] == '.') {
+					if (path.empty())
+						throw std::invalid_argument("JSON path starts with a dot: " + text);
+					pos++;
+				}
+				const size_t end = text.find_first_of(".[", pos);
+				const std::string key = text.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+				if (key.empty())
+					throw std::invalid_argument("empty key in JSON path " + text);
+				path.push_back({ key == "*" ? Segment::ANY_KEY : Segment::KEY, key, 0 });
+				pos = end == std::string::npos ? text.size() : end;
+			}
+		}
+		if (path.empty())
+			throw std::invalid_argument("empty JSON path");
+		return path;
+	}
+
+	bool MatchesKey(const Segment &segment, const std::string &key)
+	{
+		return segment.type == Segment::ANY_KEY || (segment.type == Segment::KEY && segment.key == key);
+	}
+
+	bool MatchesIndex(const Segment &segment, size_t index)
+	{
+		return segment.type == Segment::ANY_INDEX || (segment.type == Segment::INDEX && segment.index == index);
+	}
+
+	// Tracks where in the document each SAX event is, and hands the events
+	// for a matched value to a DOM builder until that value is complete.
+	// Everything else is parsed and dropped.
+	class FilterSax {
+	public:
+		using number_integer_t = Json::number_integer_t;
+		using number_unsigned_t = Json::number_unsigned_t;
+		using number_float_t = Json::number_float_t;
+		using string_t = Json::string_t;
+
+		FilterSax(const std::vector<Path> &paths, const std::string &rootKey, JsonPathFilter::Matches &out) :
+			m_paths(paths),
+			m_out(out)
+		{
+			const uint64_t all = paths.size() == 64 ? ~uint64_t(0) : (uint64_t(1) << paths.size()) - 1;
+			// a section's root is the value of its key in the top-level object
+			if (!rootKey.empty())
+				m_frames.push_back({ false, 0, rootKey, all, 0, std::string() });
+			else
+				m_rootMask = all;
+		}
+
+		bool null() { return Scalar([](Builder &b) { return b.null(); }); }
+		bool boolean(bool val) { return Scalar([&](Builder &b) { return b.boolean(val); }); }
+		bool number_integer(number_integer_t val) { return Scalar([&](Builder &b) { return b.number_integer(val); }); }
+		bool number_unsigned(number_unsigned_t val) { return Scalar([&](Builder &b) { return b.number_unsigned(val); }); }
+		bool number_float(number_float_t val, const string_t &s) { return Scalar([&](Builder &b) { return b.number_float(val, s); }); }
+		bool string(string_t &val) { return Scalar([&](Builder &b) { return b.string(val); }); }
+
+		bool start_object(std::size_t elements) { return StartContainer(false, elements); }
+		bool end_object() { return EndContainer(false); }
+		bool start_array(std::size_t elements) { return StartContainer(true, elements); }
+		bool end_array() { return EndContainer(true); }
+
+		bool key(string_t &val)
+		{
+			if (m_builder)
+				return m_builder->key(val);
+			m_frames.back().key = val;
+			return true;
+		}
+
+		template <class Exception>
+		bool parse_error(std::size_t, const std::string &, const Exception &ex)
+		{
+			throw ex;
+		}
+
+	private:
+		using Builder = nlohmann::detail::json_sax_dom_parser<Json>;
+
+		struct Frame {
+			bool isArray;
+			size_t nextIndex;
+			std::string key;   // of the next value, in objects
+			uint64_t mask;     // paths this container is on
+			size_t childDepth; // path segment its values are matched against
+			std::string path;
+		};
+
+		struct Value {
+			uint64_t mask = 0;
+			bool matched = false;
+			size_t childDepth = 0;
+			std::string path;
+		};
+
+		// Works out which paths the value starting now is on
+		Value Begin()
+		{
+			Value v;
+			if (m_frames.empty()) {
+				// the document itself, which no path names
+				v.mask = m_rootMask;
+				return v;
+			}
+
+			Frame &f = m_frames.back();
+			const size_t index = f.nextIndex++;
+			// most of a document is on no path, so skip building its paths
+			if (!f.mask)
+				return v;
+
+			v.childDepth = f.childDepth + 1;
+			if (f.isArray)
+				v.path = f.path + "[" + std::to_string(index) + "]";
+			else
+				v.path = f.path.empty() ? f.key : f.path + "." + f.key;
+
+			for (size_t i = 0; i < m_paths.size(); i++) {
+				if (!(f.mask & (uint64_t(1) << i)))
+					continue;
+				const Segment &segment = m_paths[i][f.childDepth];
+				if (f.isArray ? !MatchesIndex(segment, index) : !MatchesKey(segment, f.key))
+					continue;
+				if (m_paths[i].size() == v.childDepth)
+					v.matched = true;
+				else
+					v.mask |= uint64_t(1) << i;
+			}
+			return v;
+		}
+
+		void StartCapture(std::string path)
+		{
+			m_capturePath = std::move(path);
+			m_captured = Json();
+			m_builder.reset(new Builder(m_captured));
+		}
+
+		void FinishCapture()
+		{
+			m_builder.reset();
+			m_out.emplace_back(std::move(m_capturePath), std::move(m_captured));
+		}
+
+		template <typename Emit>
+		bool Scalar(Emit emit)
+		{
+			if (m_builder)
+				return emit(*m_builder);
+			Value v = Begin();
+			if (v.matched) {
+				StartCapture(std::move(v.path));
+				emit(*m_builder);
+				FinishCapture();
+			}
+			return true;
+		}
+
+		bool StartContainer(bool isArray, std::size_t elements)
+		{
+			if (m_builder) {
+				m_captureDepth++;
+				return isArray ? m_builder->start_array(elements) : m_builder->start_object(elements);
+			}
+			Value v = Begin();
+			if (v.matched) {
+				// a matched container is taken whole
+				StartCapture(std::move(v.path));
+				m_captureDepth = 1;
+				return isArray ? m_builder->start_array(elements) : m_builder->start_object(elements);
+			}
+			m_frames.push_back({ isArray, 0, std::string(), v.mask, v.childDepth, std::move(v.path) });
+			return true;
+		}
+
+		bool EndContainer(bool isArray)
+		{
+			if (m_builder) {
+				const bool ok = isArray ? m_builder->end_array() : m_builder->end_object();
+				if (--m_captureDepth == 0)
+					FinishCapture();
+				return ok;
+			}
+			m_frames.pop_back();
+			return true;
+		}
+
+		const std::vector<Path> &m_paths;
+		JsonPathFilter::Matches &m_out;
+		std::vector<Frame> m_frames;
+		uint64_t m_rootMask = 0;
+
+		std::unique_ptr<Builder> m_builder;
+		Json m_captured;
+		std::string m_capturePath;
+		size_t m_captureDepth = 0;
+	};
+} // namespace
+
+JsonPathFilter::JsonPathFilter(const std::vector<std::string> &paths)
+{
+	if (paths.empty() || paths.size() > 64)
+		throw std::invalid_argument("between 1 and 64 JSON paths are needed");
+	for (const std::string &path : paths)
+		m_paths.push_back(ParsePath(path));
+}
+
+bool JsonPathFilter::MatchesTopLevelKey(const std::string &key) const
+{
+	for (const Path &path : m_paths)
+		if (MatchesKey(path.front(), key))
+			return true;
+	return false;
+}
+
+void JsonPathFilter::Extract(const std::string &document, Json::input_format_t format, const std::string &rootKey, Matches &out) const
+{
+	FilterSax sax(m_paths, rootKey, out);
+	Json::sax_parse(document, &sax, format);
+}
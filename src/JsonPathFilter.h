@@ -0,0 +1,53 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _JSON_PATH_FILTER_H
+#define _JSON_PATH_FILTER_H
+
+#include "Json.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// Picks the values at a set of paths out of a JSON or CBOR document while it
+// is being parsed, so only the matched values are ever built.
+//
+// Paths are object keys separated by dots, with array indices in brackets,
+// e.g. "space.bodies[*].type" or "lua_modules.Missions". A "*" matches any
+// key or, in brackets, any index. Up to 64 paths can be given.
+class JsonPathFilter {
+public:
+	// Throws std::invalid_argument if a path can't be parsed
+	explicit JsonPathFilter(const std::vector<std::string> &paths);
+
+	// matched values with their full paths, in document order
+	using Matches = std::vector<std::pair<std::string, Json>>;
+
+	// true if any path could match a value under the given top-level key
+	bool MatchesTopLevelKey(const std::string &key) const;
+
+	// Parses a document and appends the values it holds at any of the
+	// paths to out. If rootKey isn't empty, the document is the value of
+	// that top-level key rather than the whole tree, as with the sections
+	// of a chunked save. Throws Json::parse_error on malformed input.
+	void Extract(const std::string &document, Json::input_format_t format, const std::string &rootKey, Matches &out) const;
+
+	struct Segment {
+		enum Type {
+			KEY,
+			INDEX,
+			ANY_KEY,
+			ANY_INDEX
+		};
+		Type type;
+		std::string key;
+		size_t index;
+	};
+	using Path = std::vector<Segment>;
+
+private:
+	std::vector<Path> m_paths;
+};
+
+#endif
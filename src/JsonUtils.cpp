@@ -9,10 +9,19 @@
 #include "FileSystem.h"
 #include "base64/base64.hpp"
 #include "core/GZipFormat.h"
+#include "core/LZ4Format.h"
+#include "core/FastHash.h"
+#include "core/TaskGraph.h"
+#include "profiler/Profiler.h"
 #include "utils.h"
 
+#include <atomic>
 #include <cinttypes>
 #include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <thread>
 
 extern "C" {
 #include "miniz/miniz.h"
@@ -64,48 +73,363 @@ namespace JsonUtils {
 		return LoadJson(source.ReadFile(filename));
 	}
 
+	static const char DATA_CACHE_DIR_NAME[] = "json_cache";
+	static const uint32_t DATA_CACHE_MAGIC = 0x43444A50; // "PJDC"
+	// bump whenever the way data files are parsed changes
+	static const uint32_t DATA_CACHE_VERSION = 1;
+	// reading a cache entry costs about as much as parsing a small file
+	static const size_t DATA_CACHE_MIN_SIZE = 4096;
+	static std::atomic<bool> s_dataCacheEnabled(false);
+
+	struct DataCacheHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint64_t textHash;
+		uint64_t textSize;
+	};
+
+	void InitDataFileCache(bool enabled)
+	{
+		s_dataCacheEnabled = enabled;
+		if (enabled && !FileSystem::userFiles.MakeDirectory(DATA_CACHE_DIR_NAME)) {
+			Output("Could not create the JSON data cache directory, disabling it.\n");
+			s_dataCacheEnabled = false;
+		}
+	}
+
+	static void SaveCachedJson(const std::string &cacheName, const DataCacheHeader &header, const Json &value)
+	{
+		PROFILE_SCOPED()
+		const std::vector<uint8_t> cbor = Json::to_cbor(value);
+
+		// write to a file of this thread's own, then move it into place, so
+		// another thread never reads a partly written file
+		const std::string tempName = fmt::format("{}.{}.tmp", cacheName, std::hash<std::thread::id>()(std::this_thread::get_id()));
+		FILE *f = FileSystem::userFiles.OpenWriteStream(tempName);
+		if (!f)
+			return;
+		bool written = fwrite(&header, sizeof(header), 1, f) == 1;
+		written = written && fwrite(cbor.data(), cbor.size(), 1, f) == 1;
+		fclose(f);
+
+		const std::string root = FileSystem::userFiles.GetRoot();
+		const std::string tempPath = FileSystem::JoinPathBelow(root, tempName);
+		const std::string filePath = FileSystem::JoinPathBelow(root, cacheName);
+		bool moved = written && std::rename(tempPath.c_str(), filePath.c_str()) == 0;
+		if (written && !moved) {
+			// rename() doesn't replace an existing file everywhere
+			std::remove(filePath.c_str());
+			moved = std::rename(tempPath.c_str(), filePath.c_str()) == 0;
+		}
+		if (!moved)
+			std::remove(tempPath.c_str());
+	}
+
+	// LoadJson(), going through the data file cache when it is enabled
+	static Json LoadCachedJson(RefCountedPtr<FileSystem::FileData> fd)
+	{
+		if (!fd || !s_dataCacheEnabled || fd->GetSize() < DATA_CACHE_MIN_SIZE)
+			return LoadJson(fd);
+
+		PROFILE_SCOPED()
+		const uint64_t hash = FastHash64(fd->GetData(), fd->GetSize());
+		const std::string cacheName = FileSystem::JoinPath(DATA_CACHE_DIR_NAME, fmt::format("{:016x}.cbor", hash));
+
+		RefCountedPtr<FileSystem::FileData> cached = FileSystem::userFiles.ReadFile(cacheName);
+		if (cached && cached->GetSize() > sizeof(DataCacheHeader)) {
+			DataCacheHeader header;
+			memcpy(&header, cached->GetData(), sizeof(header));
+			if (header.magic == DATA_CACHE_MAGIC && header.version == DATA_CACHE_VERSION &&
+				header.textHash == hash && header.textSize == fd->GetSize()) {
+				const uint8_t *cbor = reinterpret_cast<const uint8_t *>(cached->GetData()) + sizeof(header);
+				try {
+					return Json::from_cbor(cbor, cbor + (cached->GetSize() - sizeof(header)));
+				} catch (Json::exception &) {
+					// fall through and rewrite the entry
+				}
+			}
+		}
+
+		Json out = LoadJson(fd);
+		if (!out.is_null())
+			SaveCachedJson(cacheName, DataCacheHeader{ DATA_CACHE_MAGIC, DATA_CACHE_VERSION, hash, fd->GetSize() }, out);
+		return out;
+	}
+
 	Json LoadJsonDataFile(const std::string &filename, bool with_merge)
 	{
-		Json out = LoadJsonFile(filename, FileSystem::gameDataFiles);
+		Json out = LoadCachedJson(FileSystem::gameDataFiles.ReadFile(filename));
 		if (out.is_null() || !with_merge) return out;
 
 		for (auto info : FileSystem::gameDataFiles.LookupAll(filename + ".patch")) {
-			ApplyJsonPatch(out, LoadJson(info.Read()), info.GetPath());
+			ApplyJsonPatch(out, LoadCachedJson(info.Read()), info.GetPath());
 		}
 
 		return out;
 	}
 
-	Json LoadJsonSaveFile(const std::string &filename, FileSystem::FileSource &source)
+	// chunk container layout: magic, little-endian uint32 chunk count, then
+	// for each chunk a uint32 key length, the key, a uint32 data length and
+	// the data (a compressed CBOR value)
+	static const char SAVE_CHUNKS_MAGIC[4] = { 'P', 'C', 'H', 'K' };
+	// top-level values smaller than this (as CBOR) share one chunk, stored
+	// with an empty key as an object of those values
+	static const size_t SAVE_CHUNK_MIN_SIZE = 16 * 1024;
+
+	static void AppendUint32(std::string &out, uint32_t v)
 	{
-		auto file = source.ReadFile(filename);
-		if (!file) return nullptr;
-		const auto file_data = std::string(file->GetData(), file->GetSize());
-		const unsigned char *dataPtr = reinterpret_cast<const unsigned char *>(&file_data[0]);
-		try {
-			std::string plain_data;
-			if (gzip::IsGZipFormat(dataPtr, file_data.size())) {
-				plain_data = gzip::DecompressDeflateOrGZip(dataPtr, file_data.size());
-			} else {
-				plain_data = file_data;
+		for (int i = 0; i < 4; i++)
+			out.push_back(char((v >> (i * 8)) & 0xff));
+	}
+
+	static uint32_t ReadUint32(const char *&pos, const char *end)
+	{
+		if (end - pos < 4)
+			throw Json::parse_error::create(110, size_t(0), "truncated save chunk");
+		const unsigned char *p = reinterpret_cast<const unsigned char *>(pos);
+		pos += 4;
+		return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+	}
+
+	static std::string CompressChunk(const std::vector<uint8_t> &cbor, bool useLZ4, const std::string &name, TaskGraph *taskGraph)
+	{
+		const char *data = reinterpret_cast<const char *>(cbor.data());
+		if (useLZ4)
+			return lz4::CompressLZ4(std::string_view(data, cbor.size()), 0, taskGraph);
+		return gzip::CompressGZip(std::string(data, cbor.size()), name, taskGraph);
+	}
+
+	// decompresses one optionally-compressed CBOR or JSON document
+	static std::string DecompressDocument(const char *data, size_t size)
+	{
+		const unsigned char *dataPtr = reinterpret_cast<const unsigned char *>(data);
+		if (gzip::IsGZipFormat(dataPtr, size))
+			return gzip::DecompressDeflateOrGZip(dataPtr, size);
+		if (lz4::IsLZ4Format(data, size))
+			return lz4::DecompressLZ4(std::string_view(data, size));
+		return std::string(data, size);
+	}
+
+	// decompresses and parses one optionally-compressed CBOR or JSON document
+	static Json DecodeDocument(const char *data, size_t size)
+	{
+		const std::string plain_data = DecompressDocument(data, size);
+		if (plain_data.empty())
+			return nullptr;
+
+		// Allow loading files in JSON format as well as CBOR
+		if (plain_data[0] == '{')
+			return Json::parse(plain_data);
+		else
+			return Json::from_cbor(plain_data);
+	}
+
+	std::string EncodeSaveFileData(const Json &root, bool useLZ4, const std::string &name, TaskGraph *taskGraph)
+	{
+		PROFILE_SCOPED()
+		struct Chunk {
+			std::string key;
+			std::vector<uint8_t> cbor;
+			std::string data = {};
+			std::exception_ptr error = nullptr;
+		};
+
+		std::vector<Chunk> chunks;
+		Json small = Json::object();
+		for (auto it = root.begin(); it != root.end(); ++it) {
+			std::vector<uint8_t> cbor = Json::to_cbor(it.value());
+			if (cbor.size() < SAVE_CHUNK_MIN_SIZE || it.key().empty())
+				small[it.key()] = it.value();
+			else
+				chunks.push_back({ it.key(), std::move(cbor) });
+		}
+		chunks.push_back({ std::string(), Json::to_cbor(small) });
+
+		// the chunks are independent, so compress them in parallel; large
+		// ones are split into blocks that are spread over the workers too
+		const uint32_t numChunks = uint32_t(chunks.size());
+		auto compress = [&](TaskRange range) {
+			for (uint32_t i = range.begin; i < range.end; i++) {
+				try {
+					chunks[i].data = CompressChunk(chunks[i].cbor, useLZ4, name, taskGraph);
+				} catch (...) {
+					chunks[i].error = std::current_exception();
+				}
+				chunks[i].cbor = std::vector<uint8_t>();
 			}
+		};
+		if (taskGraph && numChunks > 1)
+			taskGraph->ParallelFor({ 0, numChunks }, 1, compress);
+		else
+			compress({ 0, numChunks });
+
+		std::string out(SAVE_CHUNKS_MAGIC, sizeof(SAVE_CHUNKS_MAGIC));
+		AppendUint32(out, numChunks);
+		for (const Chunk &chunk : chunks) {
+			if (chunk.error)
+				std::rethrow_exception(chunk.error);
+			AppendUint32(out, uint32_t(chunk.key.size()));
+			out.append(chunk.key);
+			AppendUint32(out, uint32_t(chunk.data.size()));
+			out.append(chunk.data);
+		}
+		return out;
+	}
+
+	std::vector<SaveFileSection> GetSaveFileSections(const char *data, size_t size)
+	{
+		if (size < sizeof(SAVE_CHUNKS_MAGIC) || memcmp(data, SAVE_CHUNKS_MAGIC, sizeof(SAVE_CHUNKS_MAGIC)) != 0)
+			return { SaveFileSection{ std::string(), data, size } };
+
+		const char *pos = data + sizeof(SAVE_CHUNKS_MAGIC);
+		const char *end = data + size;
+		const uint32_t numChunks = ReadUint32(pos, end);
+		if (numChunks > size)
+			throw Json::parse_error::create(110, size_t(0), "invalid save chunk count");
+
+		std::vector<SaveFileSection> sections(numChunks);
+		for (SaveFileSection &section : sections) {
+			const uint32_t keyLen = ReadUint32(pos, end);
+			if (uint32_t(end - pos) < keyLen)
+				throw Json::parse_error::create(110, size_t(0), "truncated save chunk");
+			section.key.assign(pos, keyLen);
+			pos += keyLen;
+			section.size = ReadUint32(pos, end);
+			if (size_t(end - pos) < section.size)
+				throw Json::parse_error::create(110, size_t(0), "truncated save chunk");
+			section.data = pos;
+			pos += section.size;
+		}
+		return sections;
+	}
+
+	std::string DecompressSaveFileSection(const SaveFileSection &section)
+	{
+		return DecompressDocument(section.data, section.size);
+	}
 
-			Json rootNode;
-			try {
-				// Allow loading files in JSON format as well as CBOR
-				if (plain_data[0] == '{')
-					return Json::parse(plain_data);
-				else
-					return Json::from_cbor(plain_data);
-			} catch (Json::parse_error &e) {
-				Output("error in JSON file '%s': %s\n", file->GetInfo().GetPath().c_str(), e.what());
-				return nullptr;
+	Json DecodeSaveFileData(const char *data, size_t size, TaskGraph *taskGraph)
+	{
+		PROFILE_SCOPED()
+		if (size < sizeof(SAVE_CHUNKS_MAGIC) || memcmp(data, SAVE_CHUNKS_MAGIC, sizeof(SAVE_CHUNKS_MAGIC)) != 0)
+			return DecodeDocument(data, size);
+
+		struct Chunk {
+			std::string key;
+			const char *data = nullptr;
+			size_t size = 0;
+			Json value = {};
+			std::exception_ptr error = nullptr;
+		};
+
+		std::vector<Chunk> chunks;
+		for (SaveFileSection &section : GetSaveFileSections(data, size))
+			chunks.push_back({ std::move(section.key), section.data, section.size });
+		const uint32_t numChunks = uint32_t(chunks.size());
+
+		// the chunks are independent, so decompress and parse them in parallel
+		auto decode = [&](TaskRange range) {
+			for (uint32_t i = range.begin; i < range.end; i++) {
+				try {
+					chunks[i].value = DecodeDocument(chunks[i].data, chunks[i].size);
+				} catch (...) {
+					chunks[i].error = std::current_exception();
+				}
+			}
+		};
+		if (taskGraph && numChunks > 1)
+			taskGraph->ParallelFor({ 0, numChunks }, 1, decode);
+		else
+			decode({ 0, numChunks });
+
+		Json root = Json::object();
+		for (Chunk &chunk : chunks) {
+			if (chunk.error)
+				std::rethrow_exception(chunk.error);
+			if (chunk.key.empty()) {
+				if (!chunk.value.is_object())
+					throw Json::parse_error::create(110, size_t(0), "invalid save chunk");
+				for (auto it = chunk.value.begin(); it != chunk.value.end(); ++it)
+					root[it.key()] = std::move(it.value());
+			} else {
+				root[chunk.key] = std::move(chunk.value);
 			}
+		}
+		return root;
+	}
+
+	Json LoadJsonSaveFile(const std::string &filename, FileSystem::FileSource &source, TaskGraph *taskGraph)
+	{
+		PROFILE_SCOPED()
+		auto file = source.ReadFile(filename);
+		if (!file) return nullptr;
+		const size_t headerSize = GetSaveFileHeaderSize(file->GetData(), file->GetSize());
+		try {
+			return DecodeSaveFileData(file->GetData() + headerSize, file->GetSize() - headerSize, taskGraph);
+		} catch (Json::parse_error &e) {
+			Output("error in JSON file '%s': %s\n", file->GetInfo().GetPath().c_str(), e.what());
+			return nullptr;
 		} catch (gzip::DecompressionFailedException) {
 			return nullptr;
+		} catch (const lz4::DecompressionFailedException &) {
+			return nullptr;
 		}
 	}
 
+	// header layout: magic, little-endian uint32 metadata length, CBOR metadata
+	static const char SAVE_HEADER_MAGIC[4] = { 'P', 'S', 'A', 'V' };
+	static const size_t SAVE_HEADER_PREFIX = sizeof(SAVE_HEADER_MAGIC) + sizeof(uint32_t);
+	static const size_t SAVE_HEADER_MAX_METADATA = 64 * 1024;
+
+	static uint32_t ReadHeaderLength(const char *prefix)
+	{
+		const unsigned char *p = reinterpret_cast<const unsigned char *>(prefix) + sizeof(SAVE_HEADER_MAGIC);
+		return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+	}
+
+	std::string EncodeSaveFileHeader(const Json &metadata)
+	{
+		const std::vector<uint8_t> cbor = Json::to_cbor(metadata);
+		const uint32_t len = uint32_t(cbor.size());
+
+		std::string header(SAVE_HEADER_MAGIC, sizeof(SAVE_HEADER_MAGIC));
+		for (int i = 0; i < 4; i++)
+			header.push_back(char((len >> (i * 8)) & 0xff));
+		header.append(reinterpret_cast<const char *>(cbor.data()), cbor.size());
+		return header;
+	}
+
+	size_t GetSaveFileHeaderSize(const char *data, size_t length)
+	{
+		if (length < SAVE_HEADER_PREFIX || memcmp(data, SAVE_HEADER_MAGIC, sizeof(SAVE_HEADER_MAGIC)) != 0)
+			return 0;
+		const size_t size = SAVE_HEADER_PREFIX + ReadHeaderLength(data);
+		return size <= length ? size : 0;
+	}
+
+	Json LoadSaveFileHeader(const std::string &filename, FileSystem::FileSourceFS &source)
+	{
+		PROFILE_SCOPED()
+		FILE *f = source.OpenReadStream(filename);
+		if (!f) return nullptr;
+
+		Json metadata;
+		char prefix[SAVE_HEADER_PREFIX];
+		if (fread(prefix, sizeof(prefix), 1, f) == 1 && memcmp(prefix, SAVE_HEADER_MAGIC, sizeof(SAVE_HEADER_MAGIC)) == 0) {
+			const uint32_t len = ReadHeaderLength(prefix);
+			std::vector<uint8_t> cbor(len);
+			if (len <= SAVE_HEADER_MAX_METADATA && fread(cbor.data(), len, 1, f) == 1) {
+				try {
+					metadata = Json::from_cbor(cbor);
+				} catch (Json::parse_error &) {
+					metadata = nullptr;
+				}
+			}
+		}
+		fclose(f);
+		return metadata;
+	}
+
 	bool ApplyJsonPatch(Json &inObject, const Json &patchObject, const std::string &filename)
 	{
 		if (!inObject.is_object() || !patchObject.is_object())
@@ -126,7 +450,28 @@ namespace JsonUtils {
 	}
 } // namespace JsonUtils
 
-#define USE_STRING_VERSIONS
+// Vectors and matrices are stored as arrays of numbers, which the CBOR save
+// encoding writes as raw IEEE754 values; no text formatting or parsing is
+// needed and the values round-trip exactly.
+namespace {
+	template <typename T>
+	void NumbersToJson(Json &jsonObj, const T *vals, size_t count)
+	{
+		jsonObj = Json::array();
+		for (size_t i = 0; i < count; i++)
+			jsonObj.push_back(vals[i]);
+	}
+
+	template <typename T>
+	bool JsonToNumbers(T *vals, size_t count, const Json &jsonObj)
+	{
+		if (!jsonObj.is_array() || jsonObj.size() != count)
+			return false;
+		for (size_t i = 0; i < count; i++)
+			vals[i] = jsonObj[i].get<T>();
+		return true;
+	}
+} // namespace
 
 void VectorToJson(Json &jsonObj, const vector2f &vec)
 {
@@ -143,32 +488,17 @@ void VectorToJson(Json &jsonObj, const vector2d &vec)
 void VectorToJson(Json &jsonObj, const vector3f &vec)
 {
 	PROFILE_SCOPED()
-#ifdef USE_STRING_VERSIONS
 	if (vec == zeroVector3f)
 		return; // don't store zero vector
-
-	char str[128];
-	Vector3fToStr(vec, str, 128);
-	jsonObj = str; // Add vector array to supplied object.
-#else
-	// Create JSON array to contain vector data.
-	jsonObj = Json::array({ vec.x, vec.y, vec.z });
-#endif
+	NumbersToJson(jsonObj, &vec.x, 3);
 }
 
 void VectorToJson(Json &jsonObj, const vector3d &vec)
 {
 	PROFILE_SCOPED()
-#ifdef USE_STRING_VERSIONS
 	if (vec == zeroVector3d)
 		return; // don't store zero vector
-	char str[128];
-	Vector3dToStr(vec, str, 128);
-	jsonObj = str; // Add vector array to supplied object.
-#else
-	// Create JSON array to contain vector data.
-	jsonObj = Json::array({ vec.x, vec.y, vec.z });
-#endif
+	NumbersToJson(jsonObj, &vec.x, 3);
 }
 
 void QuaternionToJson(Json &jsonObj, const Quaternionf &quat)
@@ -192,91 +522,33 @@ void QuaternionToJson(Json &jsonObj, const Quaterniond &quat)
 void MatrixToJson(Json &jsonObj, const matrix3x3f &mat)
 {
 	PROFILE_SCOPED()
-#ifdef USE_STRING_VERSIONS
-	if (!memcmp(&matrix3x3fIdentity, &mat, sizeof(matrix3x3f))) return;
-	char str[512];
-	Matrix3x3fToStr(mat, str, 512);
-	jsonObj = str;
-#else
-	jsonObj = Json::array({ mat[0], mat[1], mat[2],
-		mat[3], mat[4], mat[5],
-		mat[6], mat[7], mat[8] });
-#endif
+	if (!memcmp(&matrix3x3fIdentity, &mat, sizeof(matrix3x3f)))
+		return; // don't store identity matrix
+	NumbersToJson(jsonObj, &mat[0], 9);
 }
 
 void MatrixToJson(Json &jsonObj, const matrix3x3d &mat)
 {
 	PROFILE_SCOPED()
-#ifdef USE_STRING_VERSIONS
-	if (!memcmp(&matrix3x3dIdentity, &mat, sizeof(matrix3x3d))) return;
-	char str[512];
-	Matrix3x3dToStr(mat, str, 512);
-	jsonObj = str;
-#else
-	jsonObj = Json::array({ mat[0], mat[1], mat[2],
-		mat[3], mat[4], mat[5],
-		mat[6], mat[7], mat[8] });
-#endif
+	if (!memcmp(&matrix3x3dIdentity, &mat, sizeof(matrix3x3d)))
+		return; // don't store identity matrix
+	NumbersToJson(jsonObj, &mat[0], 9);
 }
 
 void MatrixToJson(Json &jsonObj, const matrix4x4f &mat)
 {
 	PROFILE_SCOPED()
-#ifdef USE_STRING_VERSIONS
-	if (!memcmp(&matrix4x4fIdentity, &mat, sizeof(matrix4x4f))) return;
-	char str[512];
-	Matrix4x4fToStr(mat, str, 512);
-	jsonObj = str;
-#else
-	jsonObj = Json::array({
-		mat[0],
-		mat[1],
-		mat[2],
-		mat[3],
-		mat[4],
-		mat[5],
-		mat[6],
-		mat[7],
-		mat[8],
-		mat[9],
-		mat[10],
-		mat[11],
-		mat[12],
-		mat[13],
-		mat[14],
-		mat[15],
-	});
-#endif
+	if (!memcmp(&matrix4x4fIdentity, &mat, sizeof(matrix4x4f)))
+		return; // don't store identity matrix
+	NumbersToJson(jsonObj, &mat[0], 16);
 }
 
 void MatrixToJson(Json &jsonObj, const matrix4x4d &mat)
 {
 	PROFILE_SCOPED()
-#ifdef USE_STRING_VERSIONS
-	if (!memcmp(&matrix4x4dIdentity, &mat, sizeof(matrix4x4d))) return;
-	char str[512];
-	Matrix4x4dToStr(mat, str, 512);
-	jsonObj = str;
-#else
-	jsonObj = Json::array({
-		mat[0],
-		mat[1],
-		mat[2],
-		mat[3],
-		mat[4],
-		mat[5],
-		mat[6],
-		mat[7],
-		mat[8],
-		mat[9],
-		mat[10],
-		mat[11],
-		mat[12],
-		mat[13],
-		mat[14],
-		mat[15],
-	});
-#endif
+	if (!memcmp(&matrix4x4dIdentity, &mat, sizeof(matrix4x4d)))
+		return; // don't store identity matrix
+	NumbersToJson(jsonObj, &mat[0], 16);
 }
 
 void ColorToJson(Json &jsonObj, const Color3ub &col)
@@ -335,35 +607,29 @@ void JsonToVector(vector2d *pVec, const Json &jsonObj)
 void JsonToVector(vector3f *pVec, const Json &jsonObj)
 {
 	PROFILE_SCOPED()
-#ifdef USE_STRING_VERSIONS
+	if (JsonToNumbers(&pVec->x, 3, jsonObj))
+		return;
 	if (!jsonObj.is_string()) {
 		*pVec = vector3f(0.0f);
 		return;
 	}
-	std::string vecStr = jsonObj;
-	StrToVector3f(vecStr.c_str(), *pVec);
-#else
-	pVec->x = jsonObj[0];
-	pVec->y = jsonObj[1];
-	pVec->z = jsonObj[2];
-#endif
+	// saves from before version 92 stored the bit patterns as text
+	std::string str = jsonObj;
+	StrToVector3f(str.c_str(), *pVec);
 }
 
 void JsonToVector(vector3d *pVec, const Json &jsonObj)
 {
 	PROFILE_SCOPED()
-#ifdef USE_STRING_VERSIONS
+	if (JsonToNumbers(&pVec->x, 3, jsonObj))
+		return;
 	if (!jsonObj.is_string()) {
 		*pVec = vector3d(0.0);
 		return;
 	}
-	std::string vecStr = jsonObj;
-	StrToVector3d(vecStr.c_str(), *pVec);
-#else
-	pVec->x = jsonObj[0];
-	pVec->y = jsonObj[1];
-	pVec->z = jsonObj[2];
-#endif
+	// saves from before version 92 stored the bit patterns as text
+	std::string str = jsonObj;
+	StrToVector3d(str.c_str(), *pVec);
 }
 
 void JsonToQuaternion(Quaternionf *pQuat, const Json &jsonObj)
@@ -397,107 +663,57 @@ void JsonToQuaternion(Quaterniond *pQuat, const Json &jsonObj)
 void JsonToMatrix(matrix3x3f *pMat, const Json &jsonObj)
 {
 	PROFILE_SCOPED()
-#ifdef USE_STRING_VERSIONS
+	if (JsonToNumbers(&(*pMat)[0], 9, jsonObj))
+		return;
 	if (!jsonObj.is_string()) {
 		*pMat = matrix3x3fIdentity;
 		return;
 	}
-	std::string matStr = jsonObj;
-	StrToMatrix3x3f(matStr.c_str(), *pMat);
-#else
-	(*pMat)[0] = jsonObj[0];
-	(*pMat)[1] = jsonObj[1];
-	(*pMat)[2] = jsonObj[2];
-	(*pMat)[3] = jsonObj[3];
-	(*pMat)[4] = jsonObj[4];
-	(*pMat)[5] = jsonObj[5];
-	(*pMat)[6] = jsonObj[6];
-	(*pMat)[7] = jsonObj[7];
-	(*pMat)[8] = jsonObj[8];
-#endif
+	// saves from before version 92 stored the bit patterns as text
+	std::string str = jsonObj;
+	StrToMatrix3x3f(str.c_str(), *pMat);
 }
 
 void JsonToMatrix(matrix3x3d *pMat, const Json &jsonObj)
 {
 	PROFILE_SCOPED()
-#ifdef USE_STRING_VERSIONS
+	if (JsonToNumbers(&(*pMat)[0], 9, jsonObj))
+		return;
 	if (!jsonObj.is_string()) {
 		*pMat = matrix3x3dIdentity;
 		return;
 	}
-	std::string matStr = jsonObj;
-	StrToMatrix3x3d(matStr.c_str(), *pMat);
-#else
-	(*pMat)[0] = jsonObj[0];
-	(*pMat)[1] = jsonObj[1];
-	(*pMat)[2] = jsonObj[2];
-	(*pMat)[3] = jsonObj[3];
-	(*pMat)[4] = jsonObj[4];
-	(*pMat)[5] = jsonObj[5];
-	(*pMat)[6] = jsonObj[6];
-	(*pMat)[7] = jsonObj[7];
-	(*pMat)[8] = jsonObj[8];
-#endif
+	// saves from before version 92 stored the bit patterns as text
+	std::string str = jsonObj;
+	StrToMatrix3x3d(str.c_str(), *pMat);
 }
 
 void JsonToMatrix(matrix4x4f *pMat, const Json &jsonObj)
 {
 	PROFILE_SCOPED()
-#ifdef USE_STRING_VERSIONS
+	if (JsonToNumbers(&(*pMat)[0], 16, jsonObj))
+		return;
 	if (!jsonObj.is_string()) {
 		*pMat = matrix4x4fIdentity;
 		return;
 	}
-	std::string matStr = jsonObj;
-	StrToMatrix4x4f(matStr.c_str(), *pMat);
-#else
-	(*pMat)[0] = jsonObj[0];
-	(*pMat)[1] = jsonObj[1];
-	(*pMat)[2] = jsonObj[2];
-	(*pMat)[3] = jsonObj[3];
-	(*pMat)[4] = jsonObj[4];
-	(*pMat)[5] = jsonObj[5];
-	(*pMat)[6] = jsonObj[6];
-	(*pMat)[7] = jsonObj[7];
-	(*pMat)[8] = jsonObj[8];
-	(*pMat)[9] = jsonObj[9];
-	(*pMat)[10] = jsonObj[10];
-	(*pMat)[11] = jsonObj[11];
-	(*pMat)[12] = jsonObj[12];
-	(*pMat)[13] = jsonObj[13];
-	(*pMat)[14] = jsonObj[14];
-	(*pMat)[15] = jsonObj[15];
-#endif
+	// saves from before version 92 stored the bit patterns as text
+	std::string str = jsonObj;
+	StrToMatrix4x4f(str.c_str(), *pMat);
 }
 
 void JsonToMatrix(matrix4x4d *pMat, const Json &jsonObj)
 {
 	PROFILE_SCOPED()
-#ifdef USE_STRING_VERSIONS
+	if (JsonToNumbers(&(*pMat)[0], 16, jsonObj))
+		return;
 	if (!jsonObj.is_string()) {
 		*pMat = matrix4x4dIdentity;
 		return;
 	}
-	std::string matStr = jsonObj;
-	StrToMatrix4x4d(matStr.c_str(), *pMat);
-#else
-	(*pMat)[0] = jsonObj[0];
-	(*pMat)[1] = jsonObj[1];
-	(*pMat)[2] = jsonObj[2];
-	(*pMat)[3] = jsonObj[3];
-	(*pMat)[4] = jsonObj[4];
-	(*pMat)[5] = jsonObj[5];
-	(*pMat)[6] = jsonObj[6];
-	(*pMat)[7] = jsonObj[7];
-	(*pMat)[8] = jsonObj[8];
-	(*pMat)[9] = jsonObj[9];
-	(*pMat)[10] = jsonObj[10];
-	(*pMat)[11] = jsonObj[11];
-	(*pMat)[12] = jsonObj[12];
-	(*pMat)[13] = jsonObj[13];
-	(*pMat)[14] = jsonObj[14];
-	(*pMat)[15] = jsonObj[15];
-#endif
+	// saves from before version 92 stored the bit patterns as text
+	std::string str = jsonObj;
+	StrToMatrix4x4d(str.c_str(), *pMat);
 }
 
 void JsonToColor(Color3ub *pCol, const Json &jsonObj)
@@ -18,8 +18,11 @@
 #include "matrix4x4.h"
 #include "vector3.h"
 
+class TaskGraph;
+
 namespace FileSystem {
 	class FileSource;
+	class FileSourceFS;
 	class FileData;
 } // namespace FileSystem
 
@@ -31,10 +34,48 @@ namespace JsonUtils {
 	// Load a JSON file from the game's data sources, optionally applying all
 	// files with the the name <filename>.patch as Json Merge Patch (RFC 7386) files
 	Json LoadJsonDataFile(const std::string &filename, bool with_merge = true);
-	// Loads an optionally-gzipped, optionally-CBOR encoded JSON file from the specified source.
-	Json LoadJsonSaveFile(const std::string &filename, FileSystem::FileSource &source);
+	// Data files loaded by LoadJsonDataFile (and their patches) can be cached
+	// in the user directory as CBOR, keyed by a hash of their text, so files
+	// that haven't changed since the last launch skip the text parser. The
+	// cache is off until enabled; it is safe to use from several threads.
+	void InitDataFileCache(bool enabled);
+	// Loads an optionally gzip or LZ4 compressed, optionally-CBOR encoded JSON file from the specified source.
+	// Chunked saves are decompressed and parsed in parallel if a task graph is given.
+	Json LoadJsonSaveFile(const std::string &filename, FileSystem::FileSource &source, TaskGraph *taskGraph = nullptr);
 	// Patches a Json object with an extended Merge-Patch object
 	bool ApplyJsonPatch(Json &inObject, const Json &patch, const std::string &filename);
+
+	// Saved games start with a small uncompressed header holding CBOR-encoded
+	// metadata (save version, game time, location...), so that it can be read
+	// without decompressing the whole file.
+	// Encodes the header for the given metadata.
+	std::string EncodeSaveFileHeader(const Json &metadata);
+	// Returns the size of the header at the start of the data, or 0 if there is none.
+	size_t GetSaveFileHeaderSize(const char *data, size_t length);
+	// The data after the header is a container of separately compressed
+	// chunks, each holding one large top-level value of the save (or all of
+	// the small ones), so that they can be decoded in parallel. If a task
+	// graph is given, the chunks (and the blocks of large ones) are
+	// compressed in parallel as well.
+	std::string EncodeSaveFileData(const Json &root, bool useLZ4, const std::string &name, TaskGraph *taskGraph = nullptr);
+	// Decodes save data (without its header), either chunked or a single
+	// compressed document. Throws on decompression or parse errors.
+	Json DecodeSaveFileData(const char *data, size_t length, TaskGraph *taskGraph = nullptr);
+	// A still compressed part of the save data (without its header): a chunk
+	// holding the top-level value named by key, or the small values under an
+	// empty key. Saves from before chunking are one section with an empty key.
+	struct SaveFileSection {
+		std::string key;
+		const char *data;
+		size_t size;
+	};
+	// Lists the sections without decompressing any. Throws on a bad chunk table.
+	std::vector<SaveFileSection> GetSaveFileSections(const char *data, size_t length);
+	// Decompresses a section, giving CBOR, or JSON text if it starts with '{'
+	std::string DecompressSaveFileSection(const SaveFileSection &section);
+	// Reads only the metadata header of a save file. Returns null if the file
+	// can't be opened or has no header.
+	Json LoadSaveFileHeader(const std::string &filename, FileSystem::FileSourceFS &source);
 } // namespace JsonUtils
 
 // To-JSON functions. These are called explicitly, and are passed a reference to the object to fill.
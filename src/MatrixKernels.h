@@ -0,0 +1,199 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _MATRIXKERNELS_H
+#define _MATRIXKERNELS_H
+
+#include <cstddef>
+
+// Kernels behind the hot matrix4x4 operations, on column-major 4x4 matrices.
+//
+// As with the ray and mixing kernels, SSE2 and NEON are selected at compile
+// time. Double precision NEON needs AArch64; other targets use the scalar
+// code, which does the same multiplies and adds in the same order per lane
+// so every path gives the same results.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MATRIXKERNELS_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define MATRIXKERNELS_NEON 1
+#include <arm_neon.h>
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define MATRIXKERNELS_NEON_F64 1
+#endif
+#endif
+
+namespace MatrixKernels {
+
+	// Name of the instruction set used by the kernels, for logging and benchmarks
+	inline const char *GetImplementationName()
+	{
+#if defined(MATRIXKERNELS_SSE2)
+		return "SSE2";
+#elif defined(MATRIXKERNELS_NEON)
+		return "NEON";
+#else
+		return "scalar";
+#endif
+	}
+
+	// out = a * b; out may not alias a or b
+	template <typename T>
+	inline void MulScalar(const T *a, const T *b, T *out)
+	{
+		for (int j = 0; j < 16; j += 4)
+			for (int i = 0; i < 4; i++)
+				out[j + i] = a[i] * b[j] + a[4 + i] * b[j + 1] + a[8 + i] * b[j + 2] + a[12 + i] * b[j + 3];
+	}
+
+	template <typename T>
+	inline void Mul(const T *a, const T *b, T *out)
+	{
+		MulScalar(a, b, out);
+	}
+
+	template <>
+	inline void Mul(const float *a, const float *b, float *out)
+	{
+#if defined(MATRIXKERNELS_SSE2)
+		const __m128 c0 = _mm_loadu_ps(a), c1 = _mm_loadu_ps(a + 4), c2 = _mm_loadu_ps(a + 8), c3 = _mm_loadu_ps(a + 12);
+		for (int j = 0; j < 16; j += 4) {
+			__m128 col = _mm_mul_ps(c0, _mm_set1_ps(b[j]));
+			col = _mm_add_ps(col, _mm_mul_ps(c1, _mm_set1_ps(b[j + 1])));
+			col = _mm_add_ps(col, _mm_mul_ps(c2, _mm_set1_ps(b[j + 2])));
+			col = _mm_add_ps(col, _mm_mul_ps(c3, _mm_set1_ps(b[j + 3])));
+			_mm_storeu_ps(out + j, col);
+		}
+#elif defined(MATRIXKERNELS_NEON)
+		const float32x4_t c0 = vld1q_f32(a), c1 = vld1q_f32(a + 4), c2 = vld1q_f32(a + 8), c3 = vld1q_f32(a + 12);
+		for (int j = 0; j < 16; j += 4) {
+			// separate multiplies and adds, rounding as the scalar code does
+			float32x4_t col = vmulq_n_f32(c0, b[j]);
+			col = vaddq_f32(col, vmulq_n_f32(c1, b[j + 1]));
+			col = vaddq_f32(col, vmulq_n_f32(c2, b[j + 2]));
+			col = vaddq_f32(col, vmulq_n_f32(c3, b[j + 3]));
+			vst1q_f32(out + j, col);
+		}
+#else
+		MulScalar(a, b, out);
+#endif
+	}
+
+	template <>
+	inline void Mul(const double *a, const double *b, double *out)
+	{
+#if defined(MATRIXKERNELS_SSE2)
+		// each column of a as two pairs of rows, all held in registers
+		const __m128d c0l = _mm_loadu_pd(a), c0h = _mm_loadu_pd(a + 2), c1l = _mm_loadu_pd(a + 4), c1h = _mm_loadu_pd(a + 6);
+		const __m128d c2l = _mm_loadu_pd(a + 8), c2h = _mm_loadu_pd(a + 10), c3l = _mm_loadu_pd(a + 12), c3h = _mm_loadu_pd(a + 14);
+		for (int j = 0; j < 16; j += 4) {
+			const __m128d b0 = _mm_set1_pd(b[j]), b1 = _mm_set1_pd(b[j + 1]), b2 = _mm_set1_pd(b[j + 2]), b3 = _mm_set1_pd(b[j + 3]);
+			__m128d lo = _mm_mul_pd(c0l, b0), hi = _mm_mul_pd(c0h, b0);
+			lo = _mm_add_pd(lo, _mm_mul_pd(c1l, b1)), hi = _mm_add_pd(hi, _mm_mul_pd(c1h, b1));
+			lo = _mm_add_pd(lo, _mm_mul_pd(c2l, b2)), hi = _mm_add_pd(hi, _mm_mul_pd(c2h, b2));
+			lo = _mm_add_pd(lo, _mm_mul_pd(c3l, b3)), hi = _mm_add_pd(hi, _mm_mul_pd(c3h, b3));
+			_mm_storeu_pd(out + j, lo);
+			_mm_storeu_pd(out + j + 2, hi);
+		}
+#elif defined(MATRIXKERNELS_NEON_F64)
+		const float64x2_t c0l = vld1q_f64(a), c0h = vld1q_f64(a + 2), c1l = vld1q_f64(a + 4), c1h = vld1q_f64(a + 6);
+		const float64x2_t c2l = vld1q_f64(a + 8), c2h = vld1q_f64(a + 10), c3l = vld1q_f64(a + 12), c3h = vld1q_f64(a + 14);
+		for (int j = 0; j < 16; j += 4) {
+			float64x2_t lo = vmulq_n_f64(c0l, b[j]), hi = vmulq_n_f64(c0h, b[j]);
+			lo = vaddq_f64(lo, vmulq_n_f64(c1l, b[j + 1])), hi = vaddq_f64(hi, vmulq_n_f64(c1h, b[j + 1]));
+			lo = vaddq_f64(lo, vmulq_n_f64(c2l, b[j + 2])), hi = vaddq_f64(hi, vmulq_n_f64(c2h, b[j + 2]));
+			lo = vaddq_f64(lo, vmulq_n_f64(c3l, b[j + 3])), hi = vaddq_f64(hi, vmulq_n_f64(c3h, b[j + 3]));
+			vst1q_f64(out + j, lo);
+			vst1q_f64(out + j + 2, hi);
+		}
+#else
+		MulScalar(a, b, out);
+#endif
+	}
+
+	// Transforms count points, stored as x, y, z triples, by the affine
+	// matrix m. out may alias in.
+	template <typename T>
+	inline void TransformPointsScalar(const T *m, const T *in, T *out, size_t count)
+	{
+		for (size_t i = 0; i < count; i++, in += 3, out += 3) {
+			const T x = in[0], y = in[1], z = in[2];
+			out[0] = m[0] * x + m[4] * y + m[8] * z + m[12];
+			out[1] = m[1] * x + m[5] * y + m[9] * z + m[13];
+			out[2] = m[2] * x + m[6] * y + m[10] * z + m[14];
+		}
+	}
+
+	template <typename T>
+	inline void TransformPoints(const T *m, const T *in, T *out, size_t count)
+	{
+		TransformPointsScalar(m, in, out, count);
+	}
+
+	template <>
+	inline void TransformPoints(const float *m, const float *in, float *out, size_t count)
+	{
+		size_t i = 0;
+#if defined(MATRIXKERNELS_SSE2) || defined(MATRIXKERNELS_NEON)
+		// four lanes are written per point, so the last point is left for
+		// the scalar code rather than writing past the end of out
+		alignas(16) float lanes[4];
+#if defined(MATRIXKERNELS_SSE2)
+		const __m128 c0 = _mm_loadu_ps(m), c1 = _mm_loadu_ps(m + 4), c2 = _mm_loadu_ps(m + 8), c3 = _mm_loadu_ps(m + 12);
+		for (; i + 1 < count; i++, in += 3, out += 3) {
+			__m128 p = _mm_mul_ps(c0, _mm_set1_ps(in[0]));
+			p = _mm_add_ps(p, _mm_mul_ps(c1, _mm_set1_ps(in[1])));
+			p = _mm_add_ps(p, _mm_mul_ps(c2, _mm_set1_ps(in[2])));
+			p = _mm_add_ps(p, c3);
+			_mm_store_ps(lanes, p);
+			out[0] = lanes[0], out[1] = lanes[1], out[2] = lanes[2];
+		}
+#else
+		const float32x4_t c0 = vld1q_f32(m), c1 = vld1q_f32(m + 4), c2 = vld1q_f32(m + 8), c3 = vld1q_f32(m + 12);
+		for (; i + 1 < count; i++, in += 3, out += 3) {
+			float32x4_t p = vmulq_n_f32(c0, in[0]);
+			p = vaddq_f32(p, vmulq_n_f32(c1, in[1]));
+			p = vaddq_f32(p, vmulq_n_f32(c2, in[2]));
+			p = vaddq_f32(p, c3);
+			vst1q_f32(lanes, p);
+			out[0] = lanes[0], out[1] = lanes[1], out[2] = lanes[2];
+		}
+#endif
+#endif
+		TransformPointsScalar(m, in, out, count - i);
+	}
+
+	template <>
+	inline void TransformPoints(const double *m, const double *in, double *out, size_t count)
+	{
+#if defined(MATRIXKERNELS_SSE2)
+		// x and y as a pair, z on its own
+		const __m128d c0 = _mm_loadu_pd(m), c1 = _mm_loadu_pd(m + 4), c2 = _mm_loadu_pd(m + 8), c3 = _mm_loadu_pd(m + 12);
+		for (size_t i = 0; i < count; i++, in += 3, out += 3) {
+			const double x = in[0], y = in[1], z = in[2];
+			__m128d p = _mm_mul_pd(c0, _mm_set1_pd(x));
+			p = _mm_add_pd(p, _mm_mul_pd(c1, _mm_set1_pd(y)));
+			p = _mm_add_pd(p, _mm_mul_pd(c2, _mm_set1_pd(z)));
+			p = _mm_add_pd(p, c3);
+			out[2] = m[2] * x + m[6] * y + m[10] * z + m[14];
+			_mm_storeu_pd(out, p);
+		}
+#elif defined(MATRIXKERNELS_NEON_F64)
+		const float64x2_t c0 = vld1q_f64(m), c1 = vld1q_f64(m + 4), c2 = vld1q_f64(m + 8), c3 = vld1q_f64(m + 12);
+		for (size_t i = 0; i < count; i++, in += 3, out += 3) {
+			const double x = in[0], y = in[1], z = in[2];
+			float64x2_t p = vmulq_n_f64(c0, x);
+			p = vaddq_f64(p, vmulq_n_f64(c1, y));
+			p = vaddq_f64(p, vmulq_n_f64(c2, z));
+			p = vaddq_f64(p, c3);
+			out[2] = m[2] * x + m[6] * y + m[10] * z + m[14];
+			vst1q_f64(out, p);
+		}
+#else
+		TransformPointsScalar(m, in, out, count);
+#endif
+	}
+
+} // namespace MatrixKernels
+
+#endif
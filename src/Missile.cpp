@@ -29,7 +29,8 @@ Missile::Missile(const ShipType::Id &shipId, Body *owner, int power)
 		m_power = power;
 
 	m_owner = owner;
-	m_type = &ShipType::types[shipId];
+	m_type = ShipType::Get(shipId);
+	assert(m_type);
 
 	SetMass(m_type->hullMass * 1000);
 
@@ -58,7 +59,9 @@ Missile::Missile(const Json &jsonObj, Space *space) :
 	Json missileObj = jsonObj["missile"];
 
 	try {
-		m_type = &ShipType::types[missileObj["ship_type_id"]];
+		m_type = ShipType::Get(missileObj["ship_type_id"].get<std::string>());
+		if (!m_type)
+			throw SavedGameCorruptException();
 		SetModel(m_type->modelName.c_str());
 
 		m_curAICmd = 0;
@@ -150,13 +153,17 @@ bool Missile::IsValidTarget(const Body *body)
 	}
 }
 
-void Missile::TimeStepUpdate(const float timeStep)
+void Missile::IntegrateMotion(const float timeStep)
 {
-
 	const vector3d thrust = m_propulsion->GetActualLinThrust();
 	AddRelForce(thrust);
 	AddRelTorque(m_propulsion->GetActualAngThrust());
 
+	DynamicBody::IntegrateMotion(timeStep);
+}
+
+void Missile::TimeStepUpdate(const float timeStep)
+{
 	DynamicBody::TimeStepUpdate(timeStep);
 	m_propulsion->UpdateFuel(timeStep);
 
@@ -69,4 +69,7 @@ void ModManager::ReorderMods(IniConfig *config)
 		else
 			config->SetString("ModLoader", modInfo.name, "disabled");
 	}
+
+	// the winning source for a path may have changed
+	FileSystem::gameDataFiles.InvalidateIndex();
 }
@@ -298,11 +298,15 @@ void ModelBody::MoveGeoms(const matrix4x4d &m, const vector3d &p)
 }
 
 void ModelBody::RenderModel(Graphics::Renderer *r, const Camera *camera, const vector3d &viewCoords, const matrix4x4d &viewTransform)
+{
+	m_model->Render(GetModelViewTransform(viewTransform));
+}
+
+matrix4x4f ModelBody::GetModelViewTransform(const matrix4x4d &viewTransform) const
 {
 	matrix4x4d m2 = GetInterpOrient();
 	m2.SetTranslate(GetInterpPosition());
-
-	m_model->Render(matrix4x4f(viewTransform * m2));
+	return matrix4x4f(viewTransform * m2);
 }
 
 void ModelBody::TimeStepUpdate(const float timestep)
@@ -46,6 +46,11 @@ public:
 	void SetModel(const char *modelName);
 
 	void RenderModel(Graphics::Renderer *r, const Camera *camera, const vector3d &viewCoords, const matrix4x4d &viewTransform);
+	// the model view matrix RenderModel() draws the model with
+	matrix4x4f GetModelViewTransform(const matrix4x4d &viewTransform) const;
+	// Whether Render() does nothing but RenderModel(), so the camera can
+	// draw the body as one instance of a model shared with other bodies
+	virtual bool CanRenderInstanced() const { return false; }
 
 	virtual void TimeStepUpdate(const float timeStep) override;
 
@@ -3,36 +3,142 @@
 
 #include "ModelCache.h"
 #include "Shields.h"
+#include "scenegraph/BinaryConverter.h"
 #include "scenegraph/SceneGraph.h"
 
-ModelCache::ModelCache(Graphics::Renderer *r) :
+class ModelCache::LoadJob : public Job {
+public:
+	LoadJob(ModelCache *cache, Graphics::Renderer *renderer, const std::string &name) :
+		m_cache(cache),
+		m_renderer(renderer),
+		m_name(name)
+	{}
+
+	virtual void OnRun() override
+	{
+		try {
+			m_prepared = SceneGraph::BinaryConverter::Prepare(m_name);
+		} catch (SceneGraph::LoadingError &) {
+			// no .sgm, the .model gets loaded on the main thread
+		}
+	}
+
+	virtual void OnFinish() override
+	{
+		// FindModel may have loaded it in the meantime
+		if (!m_cache->IsLoading(m_name))
+			return;
+
+		SceneGraph::Model *m = nullptr;
+		if (m_prepared) {
+			SceneGraph::BinaryConverter bc(m_renderer);
+			m = bc.Load(*m_prepared);
+		}
+		if (m) {
+			Shields::ReparentShieldNodes(m);
+		} else {
+			// the job couldn't prepare it, so try the slow way
+			try {
+				m = m_cache->LoadModel(m_name);
+			} catch (ModelNotFoundException &) {
+			}
+		}
+		m_cache->FinishLoad(m_name, m);
+	}
+
+private:
+	ModelCache *m_cache;
+	Graphics::Renderer *m_renderer;
+	std::string m_name;
+	std::unique_ptr<SceneGraph::BinaryConverter::PreparedModel> m_prepared;
+};
+
+ModelCache::ModelCache(Graphics::Renderer *r, JobQueue *jobQueue) :
 	m_renderer(r)
 {
+	if (jobQueue)
+		m_jobs.reset(new JobSet(jobQueue));
 }
 
 ModelCache::~ModelCache()
 {
+	m_jobs.reset();
 	Flush();
 }
 
+SceneGraph::Model *ModelCache::LoadModel(const std::string &name)
+{
+	try {
+		SceneGraph::Loader loader(m_renderer);
+		SceneGraph::Model *m = loader.LoadModel(name);
+		Shields::ReparentShieldNodes(m);
+		return m;
+	} catch (SceneGraph::LoadingError &) {
+		throw ModelNotFoundException();
+	}
+}
+
 SceneGraph::Model *ModelCache::FindModel(const std::string &name)
 {
 	ModelMap::iterator it = m_models.find(name);
 
 	if (it == m_models.end()) {
+		SceneGraph::Model *m = nullptr;
 		try {
-			SceneGraph::Loader loader(m_renderer);
-			SceneGraph::Model *m = loader.LoadModel(name);
-			Shields::ReparentShieldNodes(m);
-			m_models[name] = m;
-			return m;
-		} catch (SceneGraph::LoadingError &) {
-			throw ModelNotFoundException();
+			m = LoadModel(name);
+		} catch (ModelNotFoundException &) {
+			FinishLoad(name, nullptr);
+			throw;
 		}
+		FinishLoad(name, m);
+		return m;
 	}
 	return it->second;
 }
 
+void ModelCache::FindModelAsync(const std::string &name, LoadCallback callback)
+{
+	ModelMap::iterator it = m_models.find(name);
+	if (it != m_models.end()) {
+		if (callback)
+			callback(it->second);
+		return;
+	}
+
+	if (!m_jobs) {
+		SceneGraph::Model *m = nullptr;
+		try {
+			m = FindModel(name);
+		} catch (ModelNotFoundException &) {
+		}
+		if (callback)
+			callback(m);
+		return;
+	}
+
+	auto pending = m_pending.find(name);
+	if (pending == m_pending.end()) {
+		pending = m_pending.emplace(name, std::vector<LoadCallback>()).first;
+		m_jobs->Order(new LoadJob(this, m_renderer, name));
+	}
+	if (callback)
+		pending->second.push_back(callback);
+}
+
+void ModelCache::FinishLoad(const std::string &name, SceneGraph::Model *model)
+{
+	if (model)
+		m_models[name] = model;
+
+	auto pending = m_pending.find(name);
+	if (pending == m_pending.end())
+		return;
+	std::vector<LoadCallback> callbacks = std::move(pending->second);
+	m_pending.erase(pending);
+	for (auto &callback : callbacks)
+		callback(model);
+}
+
 void ModelCache::Flush()
 {
 	for (ModelMap::iterator it = m_models.begin(); it != m_models.end(); ++it) {
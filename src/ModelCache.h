@@ -6,10 +6,18 @@
 /*
  * This class is a quick thoughtless hack
  * Also it only deals in New Models
+ *
+ * Models can be requested ahead of time with FindModelAsync. Reading and
+ * decompressing the .sgm happens in a job, creating the model's GPU
+ * resources happens on the main thread when the job finishes.
  */
 
+#include "JobQueue.h"
+
+#include <functional>
 #include <map>
 #include <stdexcept>
+#include <vector>
 
 namespace Graphics {
 	class Renderer;
@@ -24,15 +32,31 @@ public:
 		ModelNotFoundException() :
 			std::runtime_error("Could not find model") {}
 	};
-	ModelCache(Graphics::Renderer *);
+	typedef std::function<void(SceneGraph::Model *)> LoadCallback;
+
+	// without a job queue FindModelAsync loads immediately
+	ModelCache(Graphics::Renderer *, JobQueue *jobQueue = nullptr);
 	~ModelCache();
+	// loads the model now if it isn't cached, even if it's being loaded in the background
 	SceneGraph::Model *FindModel(const std::string &);
+	// callback is called on the main thread with the model, or nullptr if
+	// it can't be loaded. Straight away if the model is already cached.
+	void FindModelAsync(const std::string &, LoadCallback callback = LoadCallback());
+	bool IsLoading(const std::string &name) const { return m_pending.count(name) > 0; }
 	void Flush();
 
 private:
+	class LoadJob;
+
+	SceneGraph::Model *LoadModel(const std::string &);
+	void FinishLoad(const std::string &name, SceneGraph::Model *model);
+
 	typedef std::map<std::string, SceneGraph::Model *> ModelMap;
 	ModelMap m_models;
 	Graphics::Renderer *m_renderer;
+	// callbacks waiting on each model being loaded in the background
+	std::map<std::string, std::vector<LoadCallback>> m_pending;
+	std::unique_ptr<JobSet> m_jobs;
 };
 
 #endif
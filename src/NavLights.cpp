@@ -17,6 +17,10 @@ const float BILLBOARD_SIZE = 2.5f;
 
 static RefCountedPtr<Graphics::Texture> texHalos4x4;
 static RefCountedPtr<Graphics::Material> matHalos4x4;
+// the billboards of every set of nav lights, collected as they're rendered
+// and drawn together by RenderAll()
+// NB - we're (ab)using the normal type to hold (uv coordinate offset value + point size)
+static std::unique_ptr<Graphics::VertexArray> s_billboardTris;
 
 static bool g_initted = false;
 static vector2f m_lightColorsUVoffsets[(NavLights::NAVLIGHT_YELLOW + 1)] = {
@@ -87,6 +91,8 @@ void NavLights::Init(Graphics::Renderer *renderer)
 	matHalos4x4->SetTexture("texture0"_hash, texHalos4x4.Get());
 	matHalos4x4->SetPushConstant("coordDownScale"_hash, 0.5f);
 
+	s_billboardTris.reset(new Graphics::VertexArray(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_NORMAL));
+
 	g_initted = true;
 }
 
@@ -96,6 +102,7 @@ void NavLights::Uninit()
 
 	matHalos4x4.Reset();
 	texHalos4x4.Reset();
+	s_billboardTris.reset();
 
 	g_initted = false;
 }
@@ -103,9 +110,7 @@ void NavLights::Uninit()
 NavLights::NavLights(SceneGraph::Model *model, float period) :
 	m_time(0.f),
 	m_period(period),
-	m_enabled(false),
-	// NB - we're (ab)using the normal type to hold (uv coordinate offset value + point size)
-	m_billboardTris(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_NORMAL)
+	m_enabled(false)
 {
 	PROFILE_SCOPED();
 	assert(g_initted);
@@ -125,7 +130,7 @@ NavLights::NavLights(SceneGraph::Model *model, float period) :
 	for (unsigned int i = 0; i < results.size(); i++) {
 		MatrixTransform *mt = dynamic_cast<MatrixTransform *>(results.at(i));
 		assert(mt);
-		Billboard *bblight = new Billboard(m_billboardTris, renderer, BILLBOARD_SIZE);
+		Billboard *bblight = new Billboard(*s_billboardTris, renderer, BILLBOARD_SIZE);
 		Uint32 group = 0;
 		Uint8 mask = 0xff; //always on
 		Uint8 color = NAVLIGHT_BLUE;
@@ -203,14 +208,15 @@ void NavLights::Update(float time)
 	}
 }
 
-void NavLights::Render(Graphics::Renderer *renderer)
+void NavLights::RenderAll(Graphics::Renderer *renderer)
 {
-	if (!m_billboardTris.IsEmpty()) {
+	PROFILE_SCOPED();
+	if (!s_billboardTris->IsEmpty()) {
 		renderer->SetTransform(matrix4x4f::Identity());
-		renderer->DrawBuffer(&m_billboardTris, matHalos4x4.Get());
-		renderer->GetStats().AddToStatCount(Graphics::Stats::STAT_BILLBOARD, m_billboardTris.GetNumVerts());
+		renderer->DrawBuffer(s_billboardTris.get(), matHalos4x4.Get());
+		renderer->GetStats().AddToStatCount(Graphics::Stats::STAT_BILLBOARD, s_billboardTris->GetNumVerts());
 
-		m_billboardTris.Clear();
+		s_billboardTris->Clear();
 	}
 }
 
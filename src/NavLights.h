@@ -43,20 +43,21 @@ public:
 
 	void SetEnabled(bool on) { m_enabled = on; }
 	void Update(float time);
-	void Render(Graphics::Renderer *renderer);
 	void SetColor(unsigned int group, LightColor);
 	void SetMask(unsigned int group, uint8_t mask);
 
 	static void Init(Graphics::Renderer *);
 	static void Uninit();
 
+	// Draws the lights of every model rendered since the last call, all in
+	// one go; their positions are already in camera space
+	static void RenderAll(Graphics::Renderer *renderer);
+
 protected:
 	std::map<Uint32, std::vector<LightBulb>> m_groupLights;
 	float m_time;
 	float m_period;
 	bool m_enabled;
-
-	Graphics::VertexArray m_billboardTris;
 };
 
 #endif
@@ -4,8 +4,11 @@
 #include "Orbit.h"
 
 #include "MathUtil.h"
+#include "OrbitPropagator.h"
 #include "gameconsts.h"
 
+#include <algorithm>
+
 #ifdef _MSC_VER
 #include "win32/WinMath.h"
 #endif
@@ -56,6 +59,40 @@ static double calc_velocity_area_per_sec_gravpoint(double semiMajorAxis, double
 	return M_PI * a2 * sqrt((eccentricity < 1.0) ? (1 - e2) : (e2 - 1.0)) / Orbit::OrbitalPeriodTwoBody(semiMajorAxis, totalMass, bodyMass);
 }
 
+static double solve_kepler_elliptic(const double M, const double e)
+{
+	// eccentric anomaly
+	// NR method to solve for E: M = E-e*sin(E)  {Kepler's equation}
+	double E = M;
+	int iter;
+	for (iter = 0; iter < 10; iter++) {
+		double dE = (E - e * (sin(E)) - M) / (1.0 - e * cos(E));
+		E = E - dE;
+		if (fabs(dE) < 0.0001) break;
+	}
+	// method above sometimes can't find the solution
+	// especially when e approaches 1
+	if (iter == 10) { // most likely no solution found
+		//failsafe to bisection method
+		//max(E - M) == 1, so safe interval is M+-1.1
+		double Emin = M - 1.1;
+		double Emax = M + 1.1;
+		double Ymin = Emin - e * sin(Emin) - M;
+		double Y;
+		for (int i = 0; i < 14; i++) { // 14 iterations for precision 0.00006
+			E = (Emin + Emax) / 2;
+			Y = E - e * sin(E) - M;
+			if ((Ymin * Y) < 0) {
+				Emax = E;
+			} else {
+				Ymin = Y;
+				Emin = E;
+			}
+		}
+	}
+	return E;
+}
+
 static void calc_position_from_mean_anomaly(const double M, const double e, const double a, double &cos_v, double &sin_v, double *r)
 {
 	// M is mean anomaly
@@ -70,34 +107,7 @@ static void calc_position_from_mean_anomaly(const double M, const double e, cons
 
 	if (e < 1.0) { // elliptic orbit
 		// eccentric anomaly
-		// NR method to solve for E: M = E-e*sin(E)  {Kepler's equation}
-		double E = M;
-		int iter;
-		for (iter = 0; iter < 10; iter++) {
-			double dE = (E - e * (sin(E)) - M) / (1.0 - e * cos(E));
-			E = E - dE;
-			if (fabs(dE) < 0.0001) break;
-		}
-		// method above sometimes can't find the solution
-		// especially when e approaches 1
-		if (iter == 10) { // most likely no solution found
-			//failsafe to bisection method
-			//max(E - M) == 1, so safe interval is M+-1.1
-			double Emin = M - 1.1;
-			double Emax = M + 1.1;
-			double Ymin = Emin - e * sin(Emin) - M;
-			double Y;
-			for (int i = 0; i < 14; i++) { // 14 iterations for precision 0.00006
-				E = (Emin + Emax) / 2;
-				Y = E - e * sin(E) - M;
-				if ((Ymin * Y) < 0) {
-					Emax = E;
-				} else {
-					Ymin = Y;
-					Emin = E;
-				}
-			}
-		}
+		const double E = solve_kepler_elliptic(M, e);
 
 		// true anomaly (angle of orbit position)
 		cos_v = (cos(E) - e) / (1.0 - e * cos(E));
@@ -165,6 +175,12 @@ double Orbit::MeanAnomalyAtTime(double time) const
 	}
 }
 
+double Orbit::SolveKeplerElliptic(double meanAnomaly, double eccentricity)
+{
+	assert(eccentricity < 1.0);
+	return solve_kepler_elliptic(meanAnomaly, eccentricity);
+}
+
 vector3d Orbit::OrbitalPosAtTime(double t) const
 {
 	if (is_zero_general(m_semiMajorAxis)) return m_positionForStaticBody;
@@ -173,6 +189,41 @@ vector3d Orbit::OrbitalPosAtTime(double t) const
 	return m_orient * vector3d(-cos_v * r, sin_v * r, 0);
 }
 
+void Orbit::OrbitalPosAtTimes(const double *times, size_t count, vector3d *positions) const
+{
+	const double e = m_eccentricity;
+	if (is_zero_general(m_semiMajorAxis) || e >= 1.0) {
+		for (size_t i = 0; i < count; i++)
+			positions[i] = OrbitalPosAtTime(times[i]);
+		return;
+	}
+
+	// position = m_orient * (a * (e - cos(E)), b * sin(E), 0)
+	const double a = m_semiMajorAxis;
+	const double b = a * sqrt(1.0 - e * e);
+	const vector3d axisX = m_orient * vector3d(-a, 0, 0);
+	const vector3d axisY = m_orient * vector3d(0, b, 0);
+	const double meanMotion = 2.0 * M_PI / Period();
+
+	// E - M only depends on where on the orbit the body is, so it carries
+	// over between nearby times
+	const size_t lanes = OrbitPropagator::NUM_LANES;
+	double offset = 0.0;
+	for (size_t i = 0; i < count; i += lanes) {
+		const size_t n = std::min(lanes, count - i);
+		double M[lanes], ecc[lanes], E[lanes], sinE[lanes], cosE[lanes];
+		for (size_t j = 0; j < n; j++) {
+			M[j] = meanMotion * times[i + j] + m_orbitalPhaseAtStart;
+			ecc[j] = e;
+			E[j] = M[j] + offset;
+		}
+		OrbitPropagator::SolveKepler(n, M, ecc, E, sinE, cosE);
+		for (size_t j = 0; j < n; j++)
+			positions[i + j] = axisX * (cosE[j] - e) + axisY * sinE[j];
+		offset = E[n - 1] - M[n - 1];
+	}
+}
+
 double Orbit::OrbitalTimeAtPos(const vector3d &pos, double centralMass) const
 {
 	double c = m_eccentricity * m_semiMajorAxis;
@@ -232,10 +283,20 @@ vector3d Orbit::OrbitalVelocityAtTime(double totalMass, double t) const
 // used for stepping through the orbit in small fractions
 // mean anomaly <-> true anomaly conversion doesn't have
 // to be taken into account
+double Orbit::TrueAnomalyAtTime(double time) const
+{
+	return TrueAnomalyFromMeanAnomaly(MeanAnomalyAtTime(time));
+}
+
 vector3d Orbit::EvenSpacedPosTrajectory(double t, double timeOffset) const
+{
+	return EvenSpacedPosTrajectoryFromAnomaly(t, TrueAnomalyAtTime(timeOffset));
+}
+
+vector3d Orbit::EvenSpacedPosTrajectoryFromAnomaly(double t, double trueAnomalyOffset) const
 {
 	const double e = m_eccentricity;
-	double v = 2 * M_PI * t + TrueAnomalyFromMeanAnomaly(MeanAnomalyAtTime(timeOffset));
+	double v = 2 * M_PI * t + trueAnomalyOffset;
 	double r;
 
 	if (e < 1.0) {
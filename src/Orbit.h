@@ -9,6 +9,7 @@
 
 #include <cassert>
 #include <cmath>
+#include <cstddef>
 
 class Orbit {
 public:
@@ -40,11 +41,23 @@ public:
 	void SetPhase(double orbitalPhaseAtStart) { m_orbitalPhaseAtStart = orbitalPhaseAtStart; }
 
 	vector3d OrbitalPosAtTime(double t) const;
+	// OrbitalPosAtTime() for many times at once, with OrbitPropagator's
+	// batch Kepler solver. Each pair of times is warm-started from the
+	// solution for the pair before, so runs of nearby times, as when
+	// sampling a trajectory, mostly avoid the full solver. For many orbits
+	// at one time, see OrbitPropagator.
+	void OrbitalPosAtTimes(const double *times, size_t count, vector3d *positions) const;
+	// eccentric anomaly from the mean anomaly, elliptic orbits only
+	static double SolveKeplerElliptic(double meanAnomaly, double eccentricity);
 	double OrbitalTimeAtPos(const vector3d &pos, double centralMass) const;
 	vector3d OrbitalVelocityAtTime(double totalMass, double t) const;
 
 	// 0.0 <= t <= 1.0. Not for finding orbital pos
 	vector3d EvenSpacedPosTrajectory(double t, double timeOffset = 0) const;
+	// as above, but starting from a true anomaly obtained with TrueAnomalyAtTime,
+	// so that sampling a whole trajectory solves Kepler's equation only once
+	vector3d EvenSpacedPosTrajectoryFromAnomaly(double t, double trueAnomalyOffset) const;
+	double TrueAnomalyAtTime(double time) const;
 
 	double Period() const;
 	vector3d Apogeum() const;
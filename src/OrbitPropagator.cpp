@@ -0,0 +1,242 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "OrbitPropagator.h"
+
+#include "FloatComparison.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ORBITPROPAGATOR_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define ORBITPROPAGATOR_NEON 1
+#include <arm_neon.h>
+#endif
+
+// warm starts further than this from the solution fall back to the full
+// solver, which keeps the sin/cos series below accurate to double precision
+static const double MAX_FIRST_STEP = 0.05;
+static const double MAX_LAST_STEP = 1e-9;
+static const int NUM_NEWTON_STEPS = 4;
+
+namespace {
+	// two-lane double vector over the selected instruction set
+	struct double2 {
+#if defined(ORBITPROPAGATOR_SSE2)
+		__m128d v;
+		static double2 load(const double *p) { return { _mm_loadu_pd(p) }; }
+		static double2 set1(double d) { return { _mm_set1_pd(d) }; }
+		void store(double *p) const { _mm_storeu_pd(p, v); }
+		friend double2 operator+(double2 a, double2 b) { return { _mm_add_pd(a.v, b.v) }; }
+		friend double2 operator-(double2 a, double2 b) { return { _mm_sub_pd(a.v, b.v) }; }
+		friend double2 operator*(double2 a, double2 b) { return { _mm_mul_pd(a.v, b.v) }; }
+		friend double2 operator/(double2 a, double2 b) { return { _mm_div_pd(a.v, b.v) }; }
+#elif defined(ORBITPROPAGATOR_NEON)
+		float64x2_t v;
+		static double2 load(const double *p) { return { vld1q_f64(p) }; }
+		static double2 set1(double d) { return { vdupq_n_f64(d) }; }
+		void store(double *p) const { vst1q_f64(p, v); }
+		friend double2 operator+(double2 a, double2 b) { return { vaddq_f64(a.v, b.v) }; }
+		friend double2 operator-(double2 a, double2 b) { return { vsubq_f64(a.v, b.v) }; }
+		friend double2 operator*(double2 a, double2 b) { return { vmulq_f64(a.v, b.v) }; }
+		friend double2 operator/(double2 a, double2 b) { return { vdivq_f64(a.v, b.v) }; }
+#else
+		double v[2];
+		static double2 load(const double *p) { return { { p[0], p[1] } }; }
+		static double2 set1(double d) { return { { d, d } }; }
+		void store(double *p) const { p[0] = v[0], p[1] = v[1]; }
+		friend double2 operator+(double2 a, double2 b) { return { { a.v[0] + b.v[0], a.v[1] + b.v[1] } }; }
+		friend double2 operator-(double2 a, double2 b) { return { { a.v[0] - b.v[0], a.v[1] - b.v[1] } }; }
+		friend double2 operator*(double2 a, double2 b) { return { { a.v[0] * b.v[0], a.v[1] * b.v[1] } }; }
+		friend double2 operator/(double2 a, double2 b) { return { { a.v[0] / b.v[0], a.v[1] / b.v[1] } }; }
+#endif
+	};
+} // namespace
+
+void OrbitPropagator::Clear()
+{
+	m_orbits.clear();
+	m_hyperbolic.clear();
+	for (std::vector<double> *v : { &m_meanMotion, &m_phase, &m_eccentricity, &m_offsetX, &m_offsetY, &m_offsetZ,
+			 &m_axisXx, &m_axisXy, &m_axisXz, &m_axisYx, &m_axisYy, &m_axisYz, &m_anomalyOffset })
+		v->clear();
+	m_haveStepEnd = false;
+}
+
+size_t OrbitPropagator::Add(const Orbit &orbit)
+{
+	const size_t index = m_orbits.size();
+	m_orbits.push_back(orbit);
+	m_haveStepEnd = false;
+
+	// drop the padding lanes, if any
+	for (std::vector<double> *v : { &m_meanMotion, &m_phase, &m_eccentricity, &m_offsetX, &m_offsetY, &m_offsetZ,
+			 &m_axisXx, &m_axisXy, &m_axisXz, &m_axisYx, &m_axisYy, &m_axisYz, &m_anomalyOffset })
+		v->resize(index);
+
+	// static and hyperbolic orbits get constant elements, which the batch
+	// solver converges on immediately
+	double meanMotion = 0.0, phase = 0.0, e = 0.0;
+	vector3d offset(0.0), axisX(0.0), axisY(0.0);
+	if (is_zero_general(orbit.GetSemiMajorAxis())) {
+		offset = orbit.OrbitalPosAtTime(0.0);
+	} else if (orbit.GetEccentricity() >= 1.0) {
+		m_hyperbolic.push_back(index);
+	} else {
+		e = orbit.GetEccentricity();
+		const double a = orbit.GetSemiMajorAxis();
+		const double b = a * sqrt(1.0 - e * e);
+		meanMotion = 2.0 * M_PI / orbit.Period();
+		phase = orbit.GetOrbitalPhaseAtStart();
+		axisX = orbit.GetPlane().VectorX() * a;
+		axisY = orbit.GetPlane().VectorY() * b;
+		offset = axisX * e;
+	}
+
+	m_meanMotion.push_back(meanMotion);
+	m_phase.push_back(phase);
+	m_eccentricity.push_back(e);
+	m_offsetX.push_back(offset.x), m_offsetY.push_back(offset.y), m_offsetZ.push_back(offset.z);
+	m_axisXx.push_back(axisX.x), m_axisXy.push_back(axisX.y), m_axisXz.push_back(axisX.z);
+	m_axisYx.push_back(axisY.x), m_axisYy.push_back(axisY.y), m_axisYz.push_back(axisY.z);
+	m_anomalyOffset.push_back(0.0);
+
+	// pad to whole lanes with static elements
+	if (m_meanMotion.size() % NUM_LANES) {
+		for (std::vector<double> *v : { &m_meanMotion, &m_phase, &m_eccentricity, &m_offsetX, &m_offsetY, &m_offsetZ,
+				 &m_axisXx, &m_axisXy, &m_axisXz, &m_axisYx, &m_axisYy, &m_axisYz, &m_anomalyOffset })
+			v->resize(v->size() + NUM_LANES - v->size() % NUM_LANES, 0.0);
+	}
+
+	return index;
+}
+
+size_t OrbitPropagator::SolveKepler(size_t count, const double *M, const double *e, double *E, double *sinE, double *cosE)
+{
+	// one sin/cos per lane, at the warm start
+	for (size_t i = 0; i < count; i++) {
+		sinE[i] = sin(E[i]);
+		cosE[i] = cos(E[i]);
+	}
+
+	// Newton's method on M = E - e sin(E), rotating sin(E) and cos(E) by
+	// each step with its Taylor series instead of recomputing them
+	const double2 one = double2::set1(1.0);
+	const double2 sin3 = double2::set1(1.0 / 6.0), sin5 = double2::set1(1.0 / 120.0), sin7 = double2::set1(1.0 / 5040.0);
+	const double2 cos2 = double2::set1(1.0 / 2.0), cos4 = double2::set1(1.0 / 24.0), cos6 = double2::set1(1.0 / 720.0),
+				  cos8 = double2::set1(1.0 / 40320.0);
+	size_t numColdSolves = 0;
+	for (size_t i = 0; i < count; i += NUM_LANES) {
+		// a trailing odd lane is solved alongside a copy of itself
+		const size_t lanes = std::min(NUM_LANES, count - i);
+		double laneM[NUM_LANES], laneE[NUM_LANES], laneEcc[NUM_LANES], laneSin[NUM_LANES], laneCos[NUM_LANES];
+		for (size_t j = 0; j < NUM_LANES; j++) {
+			const size_t k = i + std::min(j, lanes - 1);
+			laneM[j] = M[k], laneE[j] = E[k], laneEcc[j] = e[k], laneSin[j] = sinE[k], laneCos[j] = cosE[k];
+		}
+
+		const double2 m = double2::load(laneM);
+		const double2 ecc = double2::load(laneEcc);
+		double2 ea = double2::load(laneE);
+		double2 s = double2::load(laneSin);
+		double2 c = double2::load(laneCos);
+		double2 d = double2::set1(0.0);
+		double firstStep[NUM_LANES], lastStep[NUM_LANES];
+		for (int step = 0; step < NUM_NEWTON_STEPS; step++) {
+			d = (m - ea + ecc * s) / (one - ecc * c);
+			ea = ea + d;
+
+			const double2 d2 = d * d;
+			const double2 sinD = d * (one - d2 * (sin3 - d2 * (sin5 - d2 * sin7)));
+			const double2 cosD = one - d2 * (cos2 - d2 * (cos4 - d2 * (cos6 - d2 * cos8)));
+			const double2 newS = s * cosD + c * sinD;
+			c = c * cosD - s * sinD;
+			s = newS;
+
+			if (step == 0)
+				d.store(firstStep);
+		}
+		ea.store(laneE);
+		s.store(laneSin);
+		c.store(laneCos);
+		d.store(lastStep);
+
+		for (size_t j = 0; j < lanes; j++) {
+			double &solution = E[i + j];
+			// also catches NaNs
+			if (fabs(firstStep[j]) < MAX_FIRST_STEP && fabs(lastStep[j]) < MAX_LAST_STEP) {
+				solution = laneE[j];
+				sinE[i + j] = laneSin[j];
+				cosE[i + j] = laneCos[j];
+			} else {
+				const double lm = laneM[j], le = laneEcc[j];
+				solution = Orbit::SolveKeplerElliptic(lm, le);
+				// refine to the precision of the batch solution
+				for (int step = 0; step < 2; step++)
+					solution += (lm - solution + le * sin(solution)) / (1.0 - le * cos(solution));
+				sinE[i + j] = sin(solution);
+				cosE[i + j] = cos(solution);
+				numColdSolves++;
+			}
+		}
+	}
+	return numColdSolves;
+}
+
+void OrbitPropagator::SolveKepler(double t)
+{
+	const size_t numLanes = m_meanMotion.size();
+	m_meanAnomaly.resize(numLanes);
+	m_eccAnomaly.resize(numLanes);
+	m_sinE.resize(numLanes);
+	m_cosE.resize(numLanes);
+
+	for (size_t i = 0; i < numLanes; i++) {
+		m_meanAnomaly[i] = m_meanMotion[i] * t + m_phase[i];
+		m_eccAnomaly[i] = m_meanAnomaly[i] + m_anomalyOffset[i];
+	}
+
+	// padding, static and hyperbolic lanes are at e = 0 and M = 0, and
+	// never need the full solver
+	m_numColdSolves = SolveKepler(numLanes, m_meanAnomaly.data(), m_eccentricity.data(), m_eccAnomaly.data(), m_sinE.data(), m_cosE.data());
+
+	for (size_t i = 0; i < numLanes; i++)
+		m_anomalyOffset[i] = m_eccAnomaly[i] - m_meanAnomaly[i];
+}
+
+void OrbitPropagator::Propagate(double t, std::vector<vector3d> &positions)
+{
+	SolveKepler(t);
+
+	positions.resize(m_orbits.size());
+	for (size_t i = 0; i < positions.size(); i++) {
+		const double s = m_sinE[i], c = m_cosE[i];
+		positions[i] = vector3d(
+			m_offsetX[i] - m_axisXx[i] * c + m_axisYx[i] * s,
+			m_offsetY[i] - m_axisXy[i] * c + m_axisYy[i] * s,
+			m_offsetZ[i] - m_axisXz[i] * c + m_axisYz[i] * s);
+	}
+
+	for (size_t i : m_hyperbolic)
+		positions[i] = m_orbits[i].OrbitalPosAtTime(t);
+}
+
+void OrbitPropagator::PropagateStep(double t, double timestep, std::vector<vector3d> &positions, std::vector<vector3d> &velocities)
+{
+	if (m_haveStepEnd && t == m_stepEndTime)
+		std::swap(positions, m_stepEndPositions);
+	else
+		Propagate(t, positions);
+
+	Propagate(t + timestep, m_stepEndPositions);
+	m_stepEndTime = t + timestep;
+	m_haveStepEnd = true;
+
+	velocities.resize(positions.size());
+	for (size_t i = 0; i < positions.size(); i++)
+		velocities[i] = (m_stepEndPositions[i] - positions[i]) / timestep;
+}
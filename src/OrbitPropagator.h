@@ -0,0 +1,78 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _ORBITPROPAGATOR_H
+#define _ORBITPROPAGATOR_H
+
+#include "Orbit.h"
+#include "vector3.h"
+
+#include <vector>
+
+// Batch evaluation of many orbits at the same time, as used for the
+// frames on orbital rails.
+//
+// Orbits are held as arrays of their precomputed elements, and each
+// orbit's Kepler solve is warm-started from its eccentric anomaly in the
+// previous call. Usually the previous solution is close enough that a few
+// Newton steps using only arithmetic converge, so the orbits are refined
+// two at a time with SIMD and need just one sin/cos each. Orbits whose
+// warm start is too far off (the first call, or a time jump) fall back to
+// Orbit's own solver, as do hyperbolic orbits.
+class OrbitPropagator {
+public:
+	// orbits refined together by one SIMD step
+	static constexpr size_t NUM_LANES = 2;
+
+	// The batch Kepler solver: solves M = E - e sin(E) for count elliptic
+	// orbits, refining the guesses in E in place and returning sin(E) and
+	// cos(E) too. Returns the number of lanes which fell back to the full
+	// solver because their guess was too far off.
+	static size_t SolveKepler(size_t count, const double *M, const double *e, double *E, double *sinE, double *cosE);
+
+	void Clear();
+	// returns the index of the orbit's results
+	size_t Add(const Orbit &orbit);
+	size_t GetNumOrbits() const { return m_orbits.size(); }
+
+	// positions of all orbits at time t
+	void Propagate(double t, std::vector<vector3d> &positions);
+
+	// positions at time t, and mean velocities over [t, t + timestep].
+	// Successive steps reuse the previous step's end positions, so a
+	// series of steps costs one propagation each.
+	void PropagateStep(double t, double timestep, std::vector<vector3d> &positions, std::vector<vector3d> &velocities);
+
+	// number of orbits which fell back to the full solver in the last Propagate()
+	size_t GetNumColdSolves() const { return m_numColdSolves; }
+
+private:
+	void SolveKepler(double t);
+
+	std::vector<Orbit> m_orbits;
+	// scalar indices of orbits not handled by the batch solver
+	std::vector<size_t> m_hyperbolic;
+
+	// orbital elements, padded to a whole number of SIMD lanes
+	std::vector<double> m_meanMotion;
+	std::vector<double> m_phase;
+	std::vector<double> m_eccentricity;
+	// position = offset - axisX * cos(E) + axisY * sin(E)
+	std::vector<double> m_offsetX, m_offsetY, m_offsetZ;
+	std::vector<double> m_axisXx, m_axisXy, m_axisXz;
+	std::vector<double> m_axisYx, m_axisYy, m_axisYz;
+
+	// warm start: eccentric anomaly minus mean anomaly at the last solve
+	std::vector<double> m_anomalyOffset;
+
+	// per-call scratch space
+	std::vector<double> m_meanAnomaly, m_eccAnomaly, m_sinE, m_cosE;
+	size_t m_numColdSolves = 0;
+
+	// end of the last PropagateStep()
+	bool m_haveStepEnd = false;
+	double m_stepEndTime = 0.0;
+	std::vector<vector3d> m_stepEndPositions;
+};
+
+#endif /* _ORBITPROPAGATOR_H */
@@ -2,50 +2,110 @@
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
 #include "PerfStats.h"
-#include "utils.h"
 #include <mutex>
 #include <stdexcept>
-#include <tuple>
 #include <utility>
 
 using namespace Perf;
 
+Stats::CounterArray::~CounterArray()
+{
+	for (auto &block : blocks)
+		delete block.load();
+}
+
+Stats::CounterArray::Block *Stats::CounterArray::AllocBlock(uint32_t index) const
+{
+	// another thread may allocate the same block at the same time; the
+	// first one to publish it wins
+	Block *block = new Block();
+	Block *expected = nullptr;
+	if (!blocks[index].compare_exchange_strong(expected, block, std::memory_order_acq_rel)) {
+		delete block;
+		return expected;
+	}
+	return block;
+}
+
+Stats::~Stats()
+{
+	for (auto &shard : m_shards)
+		delete shard.load();
+}
+
+uint32_t Stats::GetThreadShardIndex()
+{
+	static std::atomic<uint32_t> s_nextThread(0);
+	thread_local const uint32_t tl_shardIndex = s_nextThread.fetch_add(1, std::memory_order_relaxed) % MAX_SHARDS;
+	return tl_shardIndex;
+}
+
+Stats::CounterArray *Stats::AllocShard(uint32_t index) const
+{
+	CounterArray *shard = new CounterArray();
+	CounterArray *expected = nullptr;
+	if (!m_shards[index].compare_exchange_strong(expected, shard, std::memory_order_acq_rel)) {
+		delete shard;
+		return expected;
+	}
+	return shard;
+}
+
+int64_t Stats::SumShards(uint32_t slot) const
+{
+	int64_t sum = 0;
+	for (const auto &shard : m_shards) {
+		const CounterArray *array = shard.load(std::memory_order_acquire);
+		if (array)
+			sum += array->Read(slot);
+	}
+	return sum;
+}
+
 Stats::CounterRef Stats::GetOrCreateCounter(std::string str, bool resetOnNewFrame)
 {
-	size_t hash = m_strHashFn(str);
+	size_t hash = CounterId(str);
 	if (hash == 0)
 		throw std::runtime_error("Hash of string " + str + " equals zero. This should never happen.");
 
-	m_counterMutex.lock();
-	m_definedCounters.emplace(hash, str);
+	std::lock_guard<std::mutex> lock(m_counterMutex);
+
+	auto iter = m_counterSlots.find(hash);
+	if (iter != m_counterSlots.end())
+		return CounterRef(hash, iter->second);
 
-	// Use std::piecewise_construct, as it's the only overload for non-copyable,
-	// non-movable objects like std::atomic
-	m_counters.emplace(std::piecewise_construct,
-		std::forward_as_tuple(hash),
-		std::forward_as_tuple(resetOnNewFrame));
-	m_counterMutex.unlock();
+	if (m_definedCounters.size() >= MAX_COUNTERS)
+		throw std::runtime_error("Too many performance counters, can't create " + str);
 
-	return CounterRef(hash);
+	const uint32_t slot = uint32_t(m_definedCounters.size());
+	m_definedCounters.push_back({ std::move(str), resetOnNewFrame });
+	m_counterSlots.emplace(hash, slot);
+
+	return CounterRef(hash, slot);
 }
 
-void Stats::FlushFrame()
+Stats::CounterRef Stats::FindCounter(size_t id)
 {
-	m_counterMutex.lock();
+	std::lock_guard<std::mutex> lock(m_counterMutex);
 
-	FrameInfo lastFrame;
+	auto iter = m_counterSlots.find(id);
+	return iter != m_counterSlots.end() ? CounterRef(id, iter->second) : CounterRef(nullptr);
+}
 
-	try {
-		for (auto iter = m_counters.begin(); iter != m_counters.end(); iter++) {
-			lastFrame.emplace(m_definedCounters[iter->first], iter->second.ctr.load());
-			if (iter->second.resetOnNewFrame && !m_neverReset)
-				iter->second.ctr.store(0);
-		}
+void Stats::FlushFrame()
+{
+	std::lock_guard<std::mutex> lock(m_counterMutex);
 
-		m_frameCache = lastFrame;
-	} catch (std::runtime_error &e) {
-		Output("Error updating stats for frame: %s\n", e.what());
-	}
+	m_frameValues.resize(m_definedCounters.size());
+	for (uint32_t slot = 0; slot < m_definedCounters.size(); slot++) {
+		const CounterInfo &info = m_definedCounters[slot];
+		const int64_t value = m_base.Read(slot) + SumShards(slot);
+		m_frameValues[slot] = uint32_t(value);
+		m_frameCache[info.name] = uint32_t(value);
 
-	m_counterMutex.unlock();
+		// subtract what was read rather than storing zero, so counts added
+		// by other threads during the flush carry over to the next frame
+		if (info.resetOnNewFrame && !m_neverReset && value != 0)
+			m_base.Get(slot).fetch_sub(value, std::memory_order_relaxed);
+	}
 }
@@ -3,13 +3,17 @@
 
 #pragma once
 
+#include "core/FNV1a.h"
+
 #include <atomic>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <map>
 #include <mutex>
-#include <set>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 namespace Perf {
@@ -20,83 +24,147 @@ namespace Perf {
 	* Once you have a counter reference, you can call stats->CounterAdd(ref, 12) to update the counter.
 	* The Counter* functions are thread-safe so long as they are called with a proper CounterRef.
 	* Call FlushFrame() to collate all stats from the current frame and write them to the frame cache.
+	*
+	* CounterAdd and CounterDec are lock-free and write to a shard of the
+	* calling thread, so worker threads counting into the same counter never
+	* share a cache line. FlushFrame sums the shards. Only creating a counter
+	* and flushing take the counter mutex.
 	*/
 	class Stats {
 	public:
 		using FrameInfo = std::map<std::string, uint32_t>;
 
+		// The id of a counter is the FNV-1a hash of its name, the same as "name"_hash
+		static constexpr size_t CounterId(std::string_view name) { return hash_64_fnv1a(name.data(), name.size()); }
+
 		// Simple opaque struct to make it more difficult to accidentally clobber memory or threading constraints
 		struct CounterRef {
 			CounterRef() = delete;
 			explicit CounterRef(std::nullptr_t) :
-				id(0) {}
+				id(0), slot(0) {}
 			size_t id;
 
 		private:
 			friend class Stats;
-			CounterRef(std::size_t t) :
-				id(t) {}
+			CounterRef(std::size_t t, uint32_t s) :
+				id(t), slot(s) {}
+			uint32_t slot;
 		};
 
+		Stats() = default;
+		~Stats();
+
+		Stats(const Stats &) = delete;
+		Stats &operator=(const Stats &) = delete;
+
 		CounterRef GetOrCreateCounter(std::string name, bool resetOnNewFrame = true);
+		// Looks up a counter created earlier by its id; returns a null ref if there is none
+		CounterRef FindCounter(size_t id);
 
 		void CounterAdd(CounterRef ref, uint32_t amount = 1) const
 		{
 			assert(ref.id != 0);
-			m_counters.at(ref.id).ctr.fetch_add(amount);
+			GetThreadShard().Get(ref.slot).fetch_add(amount, std::memory_order_relaxed);
 		}
 
 		void CounterDec(CounterRef ref, uint32_t amount = 1) const
 		{
 			assert(ref.id != 0);
-			m_counters.at(ref.id).ctr.fetch_sub(amount);
+			GetThreadShard().Get(ref.slot).fetch_sub(amount, std::memory_order_relaxed);
 		}
 
+		// Sets the value counted so far; counts from other threads racing
+		// with the call may or may not be included
 		void CounterSet(CounterRef ref, uint32_t value) const
 		{
 			assert(ref.id != 0);
-			m_counters.at(ref.id).ctr.store(value);
+			m_base.Get(ref.slot).store(int64_t(value) - SumShards(ref.slot), std::memory_order_relaxed);
 		}
 
 		void CounterReset(CounterRef ref) const
 		{
-			assert(ref.id != 0);
-			m_counters.at(ref.id).ctr.store(0);
+			CounterSet(ref, 0);
 		}
 
 		void EnableReset(bool enabled) { m_neverReset = !enabled; }
 
 		const FrameInfo &GetFrameStats() const { return m_frameCache; }
+		// The value of a counter in the last flushed frame
+		uint32_t GetFrameValue(CounterRef ref) const { return ref.slot < m_frameValues.size() ? m_frameValues[ref.slot] : 0; }
 
-		std::string GetNameForCounter(CounterRef ref) const { return m_definedCounters.at(ref.id); }
+		std::string GetNameForCounter(CounterRef ref) const { return m_definedCounters.at(ref.slot).name; }
 
 		// Terminate the current frame and make performance counters available with GetFrameStats().
 		void FlushFrame();
 
 	private:
-		struct Counter {
-			Counter(bool reset) :
-				ctr(0), resetOnNewFrame(reset){};
-			// mutable because the only thing we're modifying via non-const references is the atomic counters
-			mutable std::atomic<uint32_t> ctr;
+		static constexpr uint32_t COUNTERS_PER_BLOCK = 64;
+		static constexpr uint32_t MAX_COUNTER_BLOCKS = 64;
+		static constexpr uint32_t MAX_COUNTERS = COUNTERS_PER_BLOCK * MAX_COUNTER_BLOCKS;
+		// threads past this many share shards, which stays correct as the
+		// shards are updated atomically
+		static constexpr uint32_t MAX_SHARDS = 32;
+
+		// one value per counter, in blocks allocated on first use so the
+		// values never move while other threads update them
+		struct CounterArray {
+			struct alignas(64) Block {
+				std::atomic<int64_t> values[COUNTERS_PER_BLOCK] = {};
+			};
+
+			~CounterArray();
+
+			std::atomic<int64_t> &Get(uint32_t slot) const
+			{
+				Block *block = blocks[slot / COUNTERS_PER_BLOCK].load(std::memory_order_acquire);
+				if (!block)
+					block = AllocBlock(slot / COUNTERS_PER_BLOCK);
+				return block->values[slot % COUNTERS_PER_BLOCK];
+			}
+
+			int64_t Read(uint32_t slot) const
+			{
+				const Block *block = blocks[slot / COUNTERS_PER_BLOCK].load(std::memory_order_acquire);
+				return block ? block->values[slot % COUNTERS_PER_BLOCK].load(std::memory_order_relaxed) : 0;
+			}
+
+			Block *AllocBlock(uint32_t index) const;
+
+			mutable std::atomic<Block *> blocks[MAX_COUNTER_BLOCKS] = {};
+		};
+
+		struct CounterInfo {
+			std::string name;
 			bool resetOnNewFrame;
 		};
 
-		// hashmap of counter ID to counter value
-		std::map<std::size_t, Counter> m_counters;
+		CounterArray &GetThreadShard() const
+		{
+			CounterArray *shard = m_shards[GetThreadShardIndex()].load(std::memory_order_acquire);
+			return shard ? *shard : *AllocShard(GetThreadShardIndex());
+		}
+
+		static uint32_t GetThreadShardIndex();
+		CounterArray *AllocShard(uint32_t index) const;
+		int64_t SumShards(uint32_t slot) const;
+
+		// the counted values are m_base plus the sum of all shards; setting
+		// or resetting a counter adjusts m_base
+		CounterArray m_base;
+		mutable std::atomic<CounterArray *> m_shards[MAX_SHARDS] = {};
 
 		// Cache the previous frame
 		FrameInfo m_frameCache;
+		std::vector<uint32_t> m_frameValues;
 
 		bool m_neverReset = false;
 
-		// hashmap of counter IDs to counter names
-		std::map<std::size_t, std::string> m_definedCounters;
+		// counters by slot, and slots by counter id
+		std::vector<CounterInfo> m_definedCounters;
+		std::unordered_map<size_t, uint32_t> m_counterSlots;
 
 		// mutex used to synchronize updates to definedCounters
 		std::mutex m_counterMutex;
-		// store a std::hash instance so we don't have to recreate it every time we want to hash a string.
-		std::hash<std::string> m_strHashFn;
 	};
 
 } // namespace Perf
@@ -20,8 +20,10 @@
 #include "GameConfig.h"
 #include "GameLog.h"
 #include "GameSaveError.h"
+#include "GeoSphere.h"
 #include "Input.h"
 #include "Intro.h"
+#include "JsonUtils.h"
 #include "Lang.h"
 #include "Missile.h"
 #include "ModManager.h"
@@ -34,6 +36,7 @@
 #include "Sfx.h"
 #include "Shields.h"
 #include "ShipType.h"
+#include "Simulation.h"
 #include "Space.h"
 #include "SpaceStation.h"
 #include "Star.h"
@@ -51,17 +54,24 @@
 #include "graphics/Material.h"
 #include "graphics/RenderState.h"
 #include "graphics/Renderer.h"
+#include "graphics/TextureLoader.h"
+#include "graphics/TextureStreamer.h"
+#include "graphics/dummy/RendererDummy.h"
 #include "graphics/opengl/RendererGL.h"
 
 #include "core/GuiApplication.h"
+#include "core/HitchDetector.h"
 #include "core/Log.h"
 #include "core/OS.h"
+#include "core/TaskGraph.h"
 
 #include "lua/Lua.h"
 #include "lua/LuaConsole.h"
 #include "lua/LuaEvent.h"
+#include "lua/LuaJson.h"
 #include "lua/LuaTimer.h"
 
+#include "pigui/Face.h"
 #include "pigui/LuaPiGui.h"
 #include "pigui/PerfInfo.h"
 #include "pigui/PiGui.h"
@@ -74,6 +84,7 @@
 #include "versioningInfo.h"
 
 #include <SDL.h>
+#include <chrono>
 
 #ifdef PROFILE_LUA_TIME
 #include <time.h>
@@ -150,29 +161,61 @@ protected:
 	struct LoadStep {
 		// TODO: use a lighter-weight wrapper over lambdas instead of std::function
 		std::function<void()> fn;
-		std::string name;
+		const char *name;
+		// worker steps that must finish before this step runs
+		std::vector<const char *> after;
+		double startMs = 0.0;
+		double endMs = 0.0;
+	};
+
+	// a step run on a TaskGraph worker, concurrently with the main-thread steps
+	struct WorkerStep {
+		struct Timing {
+			double startMs = 0.0;
+			double endMs = 0.0;
+		};
+
+		const char *name;
+		TaskSet::Handle handle;
+		// written by the worker, read once the step has finished
+		std::unique_ptr<Timing> timing;
+		bool finished = false;
 	};
 
 	std::vector<LoadStep> m_loaders;
+	std::vector<WorkerStep> m_workerSteps;
 	size_t m_currentLoader = 0;
+	size_t m_finishedWorkerSteps = 0;
 	bool m_hasQueuedJobs = 0;
 
+	// Runs fn on the main thread, in the order steps were added, once all of
+	// the worker steps named in after have finished.
 	template <typename T>
-	void AddStep(std::string name, T fn)
+	void AddStep(const char *name, T fn, std::vector<const char *> after = {})
 	{
-		m_loaders.push_back(LoadStep{ fn, name });
+		m_loaders.push_back(LoadStep{ fn, name, std::move(after) });
 	}
 
+	// Starts fn on a worker thread immediately. It must not touch the
+	// renderer or the main Lua state.
+	template <typename T>
+	void AddWorkerStep(const char *name, T fn);
+
 	Profiler::Clock m_loadTimer;
 	Profiler::Clock m_stepTimer;
+	std::chrono::steady_clock::time_point m_loadStart;
 
 	void Start() override;
 	void Update(float) override;
 	void End() override;
 
+	double GetLoadTimeMs() const;
+	bool WorkerStepsFinished(const std::vector<const char *> &names) const;
+	void PollWorkerSteps();
 	void RunNewLoader();
 	void FinishLoadStep();
-	float GetProgress() { return (m_currentLoader) / float(m_loaders.size()); }
+	void OutputTimeline();
+	float GetProgress() { return (m_currentLoader + m_finishedWorkerSteps) / float(m_loaders.size() + m_workerSteps.size()); }
 };
 
 // FIXME: this is a hack, this class should have its lifecycle managed elsewhere
@@ -180,6 +223,9 @@ protected:
 // but for now this is the best we have.
 std::unique_ptr<PiGui::PerfInfo> perfInfoDisplay;
 
+// time since the start of the frame, used to size the Lua GC step
+static Profiler::Clock s_frameClock;
+
 class MainMenu : public Application::Lifecycle {
 public:
 	void SetStartPath(const SystemPath &path)
@@ -199,6 +245,10 @@ protected:
 	SystemPath m_startPath;
 };
 
+// longest catch-up step, in normal steps, once a frame runs out of physics
+// ticks; Space::GetSafeStepScale() decides how much of it can be taken
+static const int MAX_PHYSICS_STEP_SCALE = 4096;
+
 class GameLoop : public Application::Lifecycle {
 protected:
 	void Start() override;
@@ -251,10 +301,11 @@ protected:
 // We don't use options for anything but the config object,
 // and instead of passing no_gui, we should instead use a different application
 // object devoted to whatever headless work we intend to do
-void Pi::Init(const std::map<std::string, std::string> &options, bool no_gui)
+void Pi::Init(const std::map<std::string, std::string> &options, bool no_gui, bool saveConfig)
 {
 	PROFILE_SCOPED();
 	Pi::config = new GameConfig(options);
+	Pi::config->SetReadOnly(!saveConfig);
 	m_instance = new Pi::App();
 
 	GetApp()->m_loader.Reset(new StartupScreen());
@@ -278,6 +329,12 @@ void TestGPUJobsSupport()
 	if (!Pi::config->Int("EnableGPUJobs"))
 		return;
 
+	// nothing is rendered, so there are no results to read back
+	if (Pi::renderer->GetRendererType() == Graphics::RENDERER_DUMMY) {
+		Pi::config->SetInt("EnableGPUJobs", 0);
+		return;
+	}
+
 	Uint32 octaves = 8;
 	Graphics::MaterialDescriptor desc;
 	desc.quality = Graphics::MaterialQuality::HAS_OCTAVES | (octaves << 16);
@@ -318,7 +375,8 @@ void Pi::App::OnStartup()
 
 	SetupProfiler(Pi::config);
 
-	Log::GetLog()->SetLogFile("output.txt");
+	// simulations running side by side each need their own
+	Log::GetLog()->SetLogFile(config->String("LogFile"));
 
 	if (config->Int("LogVerbose", 0))
 		Log::GetLog()->SetFileSeverity(Log::Severity::Verbose);
@@ -326,6 +384,9 @@ void Pi::App::OnStartup()
 	if (config->Int("LogVerbose", 0) > 1)
 		Log::GetLog()->SetSeverity(Log::Severity::Verbose);
 
+	if (config->Int("AsyncLogging"))
+		Log::GetLog()->SetAsync(true);
+
 	std::string version(PIONEER_VERSION);
 	if (strlen(PIONEER_EXTRAVERSION)) version += " (" PIONEER_EXTRAVERSION ")";
 	const char *platformName = SDL_GetPlatform();
@@ -350,6 +411,7 @@ void Pi::App::OnStartup()
 	Pi::detail.cities = config->Int("DetailCities");
 
 	Graphics::RendererOGL::RegisterRenderer();
+	Graphics::RendererDummy::RegisterRenderer();
 	Pi::renderer = StartupRenderer(Pi::config);
 
 	Pi::rng.IncRefCount(); // so nothing tries to free it
@@ -384,13 +446,36 @@ void Pi::App::OnStartup()
 	threadTimer.Start();
 
 	// get threads up
+	const Uint32 numCores = OS::GetNumCores();
+	const Uint32 reservedCores = std::min(Uint32(std::max(config->Int("ReservedCores"), 0)), numCores - 1);
 	Uint32 numThreads = config->Int("WorkerThreads");
-	numThreads = numThreads ? numThreads : std::max(OS::GetNumCores() - 1, 1U);
+	numThreads = numThreads ? numThreads : std::max(numCores - reservedCores, 1U);
+	if (config->Int("WorkStealingScheduler"))
+		GetTaskGraph()->SetSchedulerMode(TaskGraph::SCHEDULER_WORK_STEALING);
+	if (config->Int("PinWorkerThreads")) {
+		// keep the main thread on the first core and spread workers over the
+		// cores which aren't reserved for the main, render and audio threads
+		if (reservedCores > 0)
+			OS::SetCurrentThreadAffinity(0);
+		GetTaskGraph()->SetWorkerAffinity(reservedCores, numCores - reservedCores);
+	}
 	GetTaskGraph()->SetWorkerThreads(numThreads);
+	SetJobFinishBudget(config->Int("MaxJobFinishMicros"));
 
 	threadTimer.Stop();
 	Output("started %d worker threads in %.2fms\n", numThreads, threadTimer.milliseconds());
 
+	// textures requested with GetOrCreateTextureAsync are decoded on the workers
+	m_textureLoader.reset(new Graphics::TextureLoader(Pi::renderer, GetAsyncJobQueue()));
+	Pi::renderer->SetTextureLoader(m_textureLoader.get());
+
+	// model textures load their larger mips as they're drawn close enough to need them
+	const int textureBudgetMB = config->Int("TextureStreamingBudgetMB");
+	if (textureBudgetMB > 0) {
+		m_textureStreamer.reset(new Graphics::TextureStreamer(GetAsyncJobQueue(), size_t(textureBudgetMB) * 1024 * 1024));
+		Pi::renderer->SetTextureStreamer(m_textureStreamer.get());
+	}
+
 	QueueLifecycle(m_loader);
 
 	// Don't start the main menu if we don't have a GUI
@@ -424,7 +509,7 @@ void Pi::App::OnShutdown()
 	// TODO: connect initializers and deinitializers in a single Module interface
 	// Will need to think about dependency injection for e.g. modules which need a
 	// reference to the renderer
-	Projectile::FreeModel();
+	ProjectileManager::FreeModel();
 	Beam::FreeModel();
 	delete Pi::intro;
 	Pi::luaConsole.reset();
@@ -434,6 +519,7 @@ void Pi::App::OnShutdown()
 	Sound::Uninit();
 	CityOnPlanet::Uninit();
 	BaseSphere::Uninit();
+	PiGui::Face::ClearCache();
 	FaceParts::Uninit();
 	Graphics::Uninit();
 
@@ -451,6 +537,13 @@ void Pi::App::OnShutdown()
 
 	ModManager::Uninit();
 
+	Pi::renderer->SetTextureLoader(nullptr);
+	m_textureLoader.reset();
+	if (m_textureStreamer) {
+		Pi::renderer->SetTextureStreamer(nullptr);
+		m_textureStreamer.reset();
+	}
+
 	ShutdownRenderer();
 	Pi::renderer = nullptr;
 
@@ -497,6 +590,11 @@ void StartupScreen::Start()
 	Output("StartupScreen::Start()\n");
 	m_loadTimer.Reset();
 	m_loadTimer.Start();
+	m_loadStart = std::chrono::steady_clock::now();
+
+	JsonUtils::InitDataFileCache(Pi::config->Int("JsonDataCache") != 0);
+	pi_lua_init_bytecode_cache(Pi::config->Int("LuaBytecodeCache") != 0);
+	PiGui::InitSVGCache(Pi::config->Int("SVGImageCache") != 0);
 
 	Output("ShipType::Init()\n");
 	// XXX early, Lua init needs it
@@ -507,6 +605,9 @@ void StartupScreen::Start()
 	Output("Lua::Init()\n");
 	Lua::Init();
 
+	if (Pi::config->Int("LuaFrameBudgetedGC"))
+		Lua::manager->SetFrameBudgetedGC(true);
+
 	// TODO: Get the lua state responsible for drawing the init progress up as fast as possible
 	// Investigate using a pigui-only Lua state that we can initialize without depending on
 	// normal init flow, or drawing the init screen in C++ instead?
@@ -543,7 +644,7 @@ void StartupScreen::Start()
 			const std::string endpoint(Pi::config->String("ServerEndpoint"));
 			if (endpoint.size() > 0) {
 				Output("Server agent enabled, endpoint: %s\n", endpoint.c_str());
-				Pi::serverAgent = new HTTPServerAgent(endpoint);
+				Pi::serverAgent = new HTTPServerAgent(endpoint, Pi::config->Int("ServerAgentMaxRequests"));
 			}
 		}
 		if (!Pi::serverAgent) {
@@ -553,10 +654,9 @@ void StartupScreen::Start()
 	});
 #endif
 
-	// TODO: expose the AddStep interface so Lua::InitModules can granularize its registration
-	AddStep("Lua::InitModules()", &Lua::InitModules);
-
-	AddStep("GalaxyGenerator::Init()", []() {
+	// The galaxy loads the custom systems and factions in Lua states of its
+	// own, so it can be built while the main Lua state loads its modules
+	AddWorkerStep("GalaxyGenerator::Init()", []() {
 		if (Pi::config->HasEntry("GalaxyGenerator"))
 			GalaxyGenerator::Init(Pi::config->String("GalaxyGenerator"),
 				Pi::config->Int("GalaxyGeneratorVersion", GalaxyGenerator::LAST_VERSION));
@@ -564,10 +664,20 @@ void StartupScreen::Start()
 			GalaxyGenerator::Init();
 	});
 
+	// TODO: expose the AddStep interface so Lua::InitModules can granularize its registration
+	AddStep("Lua::InitModules()", &Lua::InitModules);
+
 	AddStep("FaceParts::Init()", &FaceParts::Init);
 
 	AddStep("new ModelCache", []() {
-		Pi::modelCache = new ModelCache(Pi::renderer);
+		Pi::modelCache = new ModelCache(Pi::renderer, Pi::GetAsyncJobQueue());
+
+		// ship models get loaded in the background while the rest of the game starts up
+		if (Pi::config->Int("PreloadShipModels")) {
+			for (const auto &type : ShipType::types)
+				if (!type.second.modelName.empty())
+					Pi::modelCache->FindModelAsync(type.second.modelName);
+		}
 	});
 
 	AddStep("Shields::Init", []() {
@@ -598,19 +708,70 @@ void StartupScreen::Start()
 	});
 }
 
+template <typename T>
+void StartupScreen::AddWorkerStep(const char *name, T fn)
+{
+	WorkerStep::Timing *timing = new WorkerStep::Timing();
+
+	TaskSet *set = new TaskSet();
+	set->AddTaskLambda({ 0, 1 }, [this, timing, name, fn](TaskRange) {
+		PROFILE_SCOPED_RAW(name)
+		timing->startMs = GetLoadTimeMs();
+		fn();
+		timing->endMs = GetLoadTimeMs();
+	});
+
+	Output("Loading: %s started on a worker thread\n", name);
+	m_workerSteps.push_back(WorkerStep{ name, Pi::GetApp()->GetTaskGraph()->QueueTaskSet(set), std::unique_ptr<WorkerStep::Timing>(timing) });
+}
+
+double StartupScreen::GetLoadTimeMs() const
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_loadStart).count();
+}
+
+bool StartupScreen::WorkerStepsFinished(const std::vector<const char *> &names) const
+{
+	for (const WorkerStep &step : m_workerSteps) {
+		if (step.finished)
+			continue;
+		for (const char *name : names)
+			if (strcmp(step.name, name) == 0)
+				return false;
+	}
+	return true;
+}
+
+void StartupScreen::PollWorkerSteps()
+{
+	for (WorkerStep &step : m_workerSteps) {
+		if (step.finished || !step.handle.IsComplete())
+			continue;
+		Pi::GetApp()->GetTaskGraph()->CompleteTaskSet(step.handle);
+		step.finished = true;
+		m_finishedWorkerSteps++;
+		Output("Loading: %s took %.2fms on a worker thread\n", step.name, step.timing->endMs - step.timing->startMs);
+	}
+}
+
 void StartupScreen::Update(float deltaTime)
 {
 	PROFILE_SCOPED()
 
+	PollWorkerSteps();
+
 	// if we have queued jobs from the current loader step and they're all done, finish up
 	if (m_hasQueuedJobs && currentStepQueue->IsEmpty())
 		FinishLoadStep();
 
 	if (!m_hasQueuedJobs) {
-		if (m_currentLoader < m_loaders.size())
-			RunNewLoader();
+		if (m_currentLoader < m_loaders.size()) {
+			// keep drawing the loading screen while a step waits for a worker
+			if (WorkerStepsFinished(m_loaders[m_currentLoader].after))
+				RunNewLoader();
+		}
 		// finish loading once all steps are complete and there's nothing left in the queue.
-		else if (asyncStartupQueue->IsEmpty())
+		else if (m_finishedWorkerSteps == m_workerSteps.size() && asyncStartupQueue->IsEmpty())
 			return RequestEndLifecycle();
 	}
 
@@ -624,10 +785,14 @@ void StartupScreen::RunNewLoader()
 {
 	// don't increment the current loader count and run the loader if async jobs haven't finished yet
 	LoadStep &loader = m_loaders[m_currentLoader];
-	Output("Loading [%02.f%%]: %s started\n", GetProgress() * 100., loader.name.c_str());
+	Output("Loading [%02.f%%]: %s started\n", GetProgress() * 100., loader.name);
 
 	m_stepTimer.SoftReset();
-	loader.fn();
+	loader.startMs = GetLoadTimeMs();
+	{
+		PROFILE_SCOPED_RAW(loader.name)
+		loader.fn();
+	}
 
 	// if we haven't queued any jobs, just finish this step and skip to the next one
 	m_hasQueuedJobs = !currentStepQueue->IsEmpty();
@@ -639,17 +804,30 @@ void StartupScreen::FinishLoadStep()
 {
 	m_hasQueuedJobs = false;
 	m_stepTimer.Stop();
+	m_loaders[m_currentLoader].endMs = GetLoadTimeMs();
 	Output("Loading [%02.f%%]: %s took %.2fms\n", GetProgress() * 100.,
-		m_loaders[m_currentLoader].name.c_str(), m_stepTimer.milliseconds());
+		m_loaders[m_currentLoader].name, m_stepTimer.milliseconds());
 	m_currentLoader++;
 }
 
+// Logs when each step ran, so overlapping steps and the critical path are
+// visible. The same steps appear as named zones in the startup profile.
+void StartupScreen::OutputTimeline()
+{
+	Output("\nStartup timeline (ms since start):\n");
+	for (const WorkerStep &step : m_workerSteps)
+		Output("  %8.2f - %8.2f  worker  %s\n", step.timing->startMs, step.timing->endMs, step.name);
+	for (const LoadStep &step : m_loaders)
+		Output("  %8.2f - %8.2f  main    %s\n", step.startMs, step.endMs, step.name);
+}
+
 void StartupScreen::End()
 {
 	OS::NotifyLoadEnd();
 	Pi::GetApp()->RequestProfileFrame();
 
 	m_loadTimer.Stop();
+	OutputTimeline();
 	Output("\n\nPioneer loading took %.2fms\n", m_loadTimer.milliseconds());
 }
 
@@ -828,7 +1006,11 @@ void Pi::App::HandleRequests()
 			if (!Pi::game)
 				break;
 
-			m_gameLoop->RequestEndLifecycle();
+			// a simulation runs the game itself, and ends with it
+			if (dynamic_cast<Simulation *>(GetActiveLifecycle()))
+				GetActiveLifecycle()->RequestEndLifecycle();
+			else
+				m_gameLoop->RequestEndLifecycle();
 		} break;
 		case InternalRequests::QUIT_GAME: {
 			GetActiveLifecycle()->RequestEndLifecycle();
@@ -854,17 +1036,44 @@ void Pi::App::HandleRequests()
 ===============================================================================
 */
 
+Pi::App::App() :
+	GuiApplication("Pioneer")
+{
+}
+
+Pi::App::~App()
+{
+}
+
 void Pi::App::PreUpdate()
 {
 	PROFILE_SCOPED()
 	Pi::frameTime = DeltaTime();
+
+	s_frameClock.Reset();
+	s_frameClock.Start();
 }
 
 void Pi::App::PostUpdate()
 {
 	PROFILE_SCOPED()
 
+	if (m_textureStreamer)
+		m_textureStreamer->Update();
+
+	if (Lua::manager)
+		LuaJson::Update();
+
 	HandleRequests();
+
+	// collect Lua garbage in whatever is left of the frame, so collection
+	// doesn't land in the middle of Lua code
+	if (Lua::manager && Lua::manager->IsFrameBudgetedGC()) {
+		s_frameClock.SoftStop();
+		const double remainingMs = Pi::config->Float("LuaGCTargetFrameMs") - s_frameClock.milliseconds();
+		const double budgetMs = Clamp(remainingMs, double(Pi::config->Float("LuaGCMinStepMs")), double(Pi::config->Float("LuaGCMaxStepMs")));
+		Lua::manager->StepGarbageCollectorForFrame(budgetMs);
+	}
 }
 
 // FIXME: delete/move this function out of Pi.cpp
@@ -887,6 +1096,9 @@ void GameLoop::Start()
 
 	LuaEvent::Clear();
 
+	// only report hitches while playing, not while loading
+	Pi::GetApp()->GetHitchDetector()->SetThreshold(Pi::config->Float("HitchThresholdMs"));
+
 	Pi::player->onDock.connect(sigc::ptr_fun(&OnPlayerDockOrUndock));
 	Pi::player->onUndock.connect(sigc::ptr_fun(&OnPlayerDockOrUndock));
 	Pi::player->onLanded.connect(sigc::ptr_fun(&OnPlayerDockOrUndock));
@@ -940,13 +1152,31 @@ void GameLoop::Update(float deltaTime)
 
 	accumulator += deltaTime * Pi::game->GetTimeAccelRate();
 
+	HitchDetector *hitchDetector = Pi::GetApp()->GetHitchDetector();
+	HitchDetector::ScopedPhase physicsPhase(hitchDetector, HitchDetector::PHASE_PHYSICS);
+
 	const float step = Pi::game->GetTimeStep();
 	if (step > 0.0f) {
 		PROFILE_SCOPED_RAW("Physics Update [unpaused]")
 		int phys_ticks = 0;
 		while (accumulator >= step) {
 			if (++phys_ticks >= MAX_PHYSICS_TICKS) {
-				accumulator = 0.0;
+				// out of ticks for this frame: catch up with one longer step
+				// if nothing moving is near anything it could hit, and only
+				// drop the time which is still left over
+				int maxScale = std::min(int(accumulator / step), MAX_PHYSICS_STEP_SCALE);
+				// and end no later than a normal step would past the next Lua timer
+				const double untilTimer = Pi::luaTimer->GetNextDeadline() - Pi::game->GetTime();
+				if (untilTimer < maxScale * double(step))
+					maxScale = std::max(int(ceil(untilTimer / step)), 1);
+				const int scale = Pi::game->GetSpace()->GetSafeStepScale(step, maxScale);
+				if (scale > 1) {
+					Pi::game->TimeStep(step * scale);
+					BaseSphere::UpdateAllBaseSphereDerivatives();
+					accumulator -= step * scale;
+				}
+				if (accumulator >= step)
+					accumulator = 0.0;
 				break;
 			}
 
@@ -965,12 +1195,15 @@ void GameLoop::Update(float deltaTime)
 			Pi::SetGameTickAlpha(accumulator / step);
 
 		phys_stat += phys_ticks;
+		hitchDetector->AddPhysicsTicks(phys_ticks);
 	} else {
 		// paused
 		PROFILE_SCOPED_RAW("Physics Update [paused]")
 		BaseSphere::UpdateAllBaseSphereDerivatives();
 	}
 
+	physicsPhase.End();
+
 	// Record physics timestep but keep information about current frame timing.
 	perfTimer.SoftStop();
 	// store the physics time until the end of the frame
@@ -995,19 +1228,19 @@ void GameLoop::Update(float deltaTime)
 	Pi::renderer->SetTransform(matrix4x4f::Identity());
 
 	/* Calculate position for this rendered frame (interpolated between two physics ticks */
-	// XXX should this be here? what is this anyway?
-	for (Body *b : Pi::game->GetSpace()->GetBodies()) {
-		b->UpdateInterpTransform(Pi::GetGameTickAlpha());
-	}
-	Frame::GetFrame(Pi::game->GetSpace()->GetRootFrame())->UpdateInterpTransform(Pi::GetGameTickAlpha());
+	Pi::game->GetSpace()->UpdateInterpTransforms(Pi::GetGameTickAlpha());
 
+	HitchDetector::ScopedPhase scenePhase(hitchDetector, HitchDetector::PHASE_RENDER);
 	Pi::GetView()->Update();
+	Pi::GetApp()->BeginScene();
 	Pi::GetView()->Draw3D();
+	Pi::GetApp()->EndScene();
 
 	// Kick rendering in the background to avoid write->delete->read issues with UI command processing
 	// This may cause future issues if graphic resources are deleted while in-flight, but OpenGL is
 	// capable of handling that eventuality and it prevents application-scope crashes
 	Pi::renderer->FlushCommandBuffers();
+	scenePhase.End();
 
 	// FIXME: Handling events at the moment must be after view->Draw3D and before
 	// Gui::Draw so that labels drawn to screen can have mouse events correctly
@@ -1032,6 +1265,7 @@ void GameLoop::Update(float deltaTime)
 	// Move HandleEvents to either the end of the loop or the very start of the loop
 	// The goal is to be able to call imgui functions for debugging inside C++ code
 	perfTimer.SoftReset();
+	HitchDetector::ScopedPhase uiPhase(hitchDetector, HitchDetector::PHASE_RENDER);
 	Pi::pigui->NewFrame();
 
 	if (Pi::game && !Pi::player->IsDead()) {
@@ -1057,6 +1291,7 @@ void GameLoop::Update(float deltaTime)
 	// Reset the depth buffer so our UI can get drawn right overtop
 	Pi::renderer->ClearDepthBuffer();
 	Pi::pigui->Render();
+	uiPhase.End();
 
 	perfTimer.SoftStop();
 	pigui_time = perfTimer.milliseconds() / 1.e3;
@@ -1072,6 +1307,11 @@ void GameLoop::Update(float deltaTime)
 
 	Pi::GetMusicPlayer().Update();
 
+	uint32_t splitRequests, splitResults;
+	GeoSphere::TakeSplitQueueStats(splitRequests, splitResults);
+	hitchDetector->SetSplitQueue(splitRequests, splitResults);
+
+	LuaEvent::GetStats().FlushFrame();
 	perfInfoDisplay->Update(deltaTime);
 	perfInfoDisplay->UpdateCounter(PiGui::PerfInfo::COUNTER_PHYS, phys_time);
 	perfInfoDisplay->UpdateCounter(PiGui::PerfInfo::COUNTER_PIGUI, pigui_time);
@@ -1110,6 +1350,8 @@ void GameLoop::Update(float deltaTime)
 
 void GameLoop::End()
 {
+	Pi::GetApp()->GetHitchDetector()->SetThreshold(0.0);
+
 	// Process any pending UI events
 	PiGui::EmitEvents();
 
@@ -1127,6 +1369,9 @@ void GameLoop::End()
 	LuaEvent::Queue("onAutoSaveBeforeGameEnds");
 	LuaEvent::Emit();
 
+	// the autosave may have been written in the background
+	Game::FinishPendingSave();
+
 	// final event
 	LuaEvent::Queue("onGameEnd");
 	LuaEvent::Emit();
@@ -43,6 +43,8 @@ class ServerAgent;
 
 namespace Graphics {
 	class Renderer;
+	class TextureLoader;
+	class TextureStreamer;
 } // namespace Graphics
 
 namespace SceneGraph {
@@ -92,8 +94,8 @@ public:
 		friend class GameLoop;
 		friend class TombstoneLoop;
 
-		App() :
-			GuiApplication("Pioneer") {}
+		App();
+		~App();
 
 		void OnStartup() override;
 		void OnShutdown() override;
@@ -120,10 +122,15 @@ public:
 		RefCountedPtr<Lifecycle> m_loader;
 		RefCountedPtr<Lifecycle> m_mainMenu;
 		RefCountedPtr<Lifecycle> m_gameLoop;
+
+		std::unique_ptr<Graphics::TextureLoader> m_textureLoader;
+		std::unique_ptr<Graphics::TextureStreamer> m_textureStreamer;
 	};
 
 public:
-	static void Init(const std::map<std::string, std::string> &options, bool no_gui = false);
+	// saveConfig = false keeps the options (and anything else changed at
+	// runtime) out of config.ini
+	static void Init(const std::map<std::string, std::string> &options, bool no_gui = false, bool saveConfig = true);
 	static void Uninit();
 
 	static void StartGame(Game *game);
@@ -5,6 +5,7 @@
 
 #include "Color.h"
 #include "GeoSphere.h"
+#include "Pi.h"
 #include "galaxy/SystemBody.h"
 #include "graphics/Graphics.h"
 #include "graphics/Material.h"
@@ -17,6 +18,9 @@
 #include "perlin.h"
 #include "profiler/Profiler.h"
 
+#include <deque>
+#include <map>
+
 #ifdef _MSC_VER
 #include "win32/WinMath.h"
 #endif // _MSC_VER
@@ -25,6 +29,87 @@ using namespace Graphics;
 
 static const Graphics::AttributeSet RING_VERTEX_ATTRIBS = Graphics::ATTRIB_POSITION | Graphics::ATTRIB_UV0;
 
+// NOTE: texture width must be > 1 to avoid graphical glitches with Intel GMA 900 systems
+//       this is something to do with mipmapping (probably mipmap generation going wrong)
+//       (if the texture is generated without mipmaps then a 1xN texture works)
+static const int RING_TEXTURE_WIDTH = 4;
+static const int RING_TEXTURE_LENGTH = 256;
+static const size_t RING_TEXTURE_CACHE_SIZE = 32;
+
+// generated ring textures by body, so revisiting a system doesn't generate
+// them again; the oldest entry goes first once full
+static std::map<SystemPath, std::vector<Color>> s_ringTextureCache;
+static std::deque<SystemPath> s_ringTextureCacheOrder;
+
+static void FillRingTexture(std::vector<Color> &buf, float ringScale, Uint32 seed, const Color &baseCol)
+{
+	PROFILE_SCOPED()
+	buf.resize(RING_TEXTURE_WIDTH * RING_TEXTURE_LENGTH);
+
+	Random rng(seed + 4609837);
+	double noiseOffset = 2048.0 * rng.Double();
+	for (int i = 0; i < RING_TEXTURE_LENGTH; ++i) {
+		const float alpha = (float(i) / float(RING_TEXTURE_LENGTH)) * ringScale;
+		const float n = 0.25 +
+			0.60 * noise(vector3d(5.0 * alpha, noiseOffset, 0.0)) +
+			0.15 * noise(vector3d(10.0 * alpha, noiseOffset, 0.0));
+
+		const float LOG_SCALE = 1.0f / sqrtf(sqrtf(log1p(1.0f)));
+		const float v = LOG_SCALE * sqrtf(sqrtf(log1p(n)));
+
+		Color color;
+		color.r = v * baseCol.r;
+		color.g = v * baseCol.g;
+		color.b = v * baseCol.b;
+		color.a = ((v * 0.25f) + 0.75f) * baseCol.a;
+
+		std::fill_n(buf.data() + i * RING_TEXTURE_WIDTH, RING_TEXTURE_WIDTH, color);
+	}
+
+	// first and last pixel are forced to zero, to give a slightly smoother ring edge
+	std::fill_n(buf.data(), RING_TEXTURE_WIDTH, Color::BLANK);
+	std::fill_n(buf.data() + (RING_TEXTURE_LENGTH - 1) * RING_TEXTURE_WIDTH, RING_TEXTURE_WIDTH, Color::BLANK);
+}
+
+// generates the ring texture on a worker, and swaps it in for the placeholder
+class Planet::RingTextureJob : public Job {
+public:
+	RingTextureJob(Planet *planet, float ringScale) :
+		m_planet(planet),
+		m_path(planet->GetSystemBody()->GetPath()),
+		m_ringScale(ringScale),
+		m_seed(planet->GetSystemBody()->GetSeed()),
+		m_baseCol(planet->GetSystemBody()->GetRings().baseColor)
+	{
+	}
+
+	virtual void OnRun() override
+	{
+		FillRingTexture(m_buf, m_ringScale, m_seed, m_baseCol);
+	}
+
+	virtual void OnFinish() override
+	{
+		m_planet->m_ringTexture->Update(static_cast<void *>(m_buf.data()),
+			vector3f(RING_TEXTURE_WIDTH, RING_TEXTURE_LENGTH, 0.0f), Graphics::TEXTURE_RGBA_8888);
+
+		if (s_ringTextureCacheOrder.size() >= RING_TEXTURE_CACHE_SIZE) {
+			s_ringTextureCache.erase(s_ringTextureCacheOrder.front());
+			s_ringTextureCacheOrder.pop_front();
+		}
+		if (s_ringTextureCache.emplace(m_path, std::move(m_buf)).second)
+			s_ringTextureCacheOrder.push_back(m_path);
+	}
+
+private:
+	Planet *m_planet;
+	SystemPath m_path;
+	float m_ringScale;
+	Uint32 m_seed;
+	Color m_baseCol;
+	std::vector<Color> m_buf;
+};
+
 Planet::Planet(SystemBody *sbody) :
 	TerrainBody(sbody)
 {
@@ -117,58 +202,24 @@ void Planet::GenerateRings(Graphics::Renderer *renderer)
 	// Upload vertex data to GPU
 	m_ringMesh.reset(renderer->CreateMeshObjectFromArray(&ringVertices));
 
-	// generate the ring texture
-	// NOTE: texture width must be > 1 to avoid graphical glitches with Intel GMA 900 systems
-	//       this is something to do with mipmapping (probably mipmap generation going wrong)
-	//       (if the texture is generated without mipmaps then a 1xN texture works)
-	const int RING_TEXTURE_WIDTH = 4;
-	const int RING_TEXTURE_LENGTH = 256;
-	std::unique_ptr<Color, FreeDeleter> buf(
-		static_cast<Color *>(malloc(RING_TEXTURE_WIDTH * RING_TEXTURE_LENGTH * 4)));
-
-	const float ringScale = (outer - inner) * sbody->GetRadius() / 1.5e7f;
-
-	Random rng(GetSystemBody()->GetSeed() + 4609837);
-	Color baseCol = sbody->GetRings().baseColor;
-	double noiseOffset = 2048.0 * rng.Double();
-	for (int i = 0; i < RING_TEXTURE_LENGTH; ++i) {
-		const float alpha = (float(i) / float(RING_TEXTURE_LENGTH)) * ringScale;
-		const float n = 0.25 +
-			0.60 * noise(vector3d(5.0 * alpha, noiseOffset, 0.0)) +
-			0.15 * noise(vector3d(10.0 * alpha, noiseOffset, 0.0));
-
-		const float LOG_SCALE = 1.0f / sqrtf(sqrtf(log1p(1.0f)));
-		const float v = LOG_SCALE * sqrtf(sqrtf(log1p(n)));
-
-		Color color;
-		color.r = v * baseCol.r;
-		color.g = v * baseCol.g;
-		color.b = v * baseCol.b;
-		color.a = ((v * 0.25f) + 0.75f) * baseCol.a;
-
-		Color *row = buf.get() + i * RING_TEXTURE_WIDTH;
-		for (int j = 0; j < RING_TEXTURE_WIDTH; ++j) {
-			row[j] = color;
-		}
-	}
-
-	// first and last pixel are forced to zero, to give a slightly smoother ring edge
-	{
-		Color *row;
-		row = buf.get();
-		std::fill_n(row, RING_TEXTURE_WIDTH, Color::BLANK);
-		row = buf.get() + (RING_TEXTURE_LENGTH - 1) * RING_TEXTURE_WIDTH;
-		std::fill_n(row, RING_TEXTURE_WIDTH, Color::BLANK);
-	}
-
 	const vector3f texSize(RING_TEXTURE_WIDTH, RING_TEXTURE_LENGTH, 0.0f);
 	const Graphics::TextureDescriptor texDesc(
 		Graphics::TEXTURE_RGBA_8888, texSize, Graphics::LINEAR_REPEAT, true, true, true, 0, Graphics::TEXTURE_2D);
-
 	m_ringTexture.Reset(renderer->CreateTexture(texDesc));
-	m_ringTexture->Update(
-		static_cast<void *>(buf.get()), texSize,
-		Graphics::TEXTURE_RGBA_8888);
+
+	auto cached = s_ringTextureCache.find(sbody->GetPath());
+	if (cached != s_ringTextureCache.end()) {
+		m_ringTexture->Update(static_cast<void *>(cached->second.data()), texSize, Graphics::TEXTURE_RGBA_8888);
+	} else {
+		// the rings are drawn in their base colour until the job is done
+		std::vector<Color> placeholder(RING_TEXTURE_WIDTH * RING_TEXTURE_LENGTH, sbody->GetRings().baseColor);
+		std::fill_n(placeholder.data(), RING_TEXTURE_WIDTH, Color::BLANK);
+		std::fill_n(placeholder.data() + (RING_TEXTURE_LENGTH - 1) * RING_TEXTURE_WIDTH, RING_TEXTURE_WIDTH, Color::BLANK);
+		m_ringTexture->Update(static_cast<void *>(placeholder.data()), texSize, Graphics::TEXTURE_RGBA_8888);
+
+		const float ringScale = (outer - inner) * sbody->GetRadius() / 1.5e7f;
+		m_ringJob = Pi::GetAsyncJobQueue()->Queue(new RingTextureJob(this, ringScale));
+	}
 
 	Graphics::MaterialDescriptor desc;
 	desc.lighting = true;
@@ -4,6 +4,7 @@
 #ifndef _PLANET_H
 #define _PLANET_H
 
+#include "JobQueue.h"
 #include "RefCounted.h"
 #include "TerrainBody.h"
 #include "graphics/VertexArray.h"
@@ -31,6 +32,8 @@ public:
 
 protected:
 private:
+	class RingTextureJob;
+
 	void InitParams(const SystemBody *);
 	void GenerateRings(Graphics::Renderer *renderer);
 	void DrawGasGiantRings(Graphics::Renderer *r, const matrix4x4d &modelView);
@@ -40,6 +43,8 @@ private:
 	RefCountedPtr<Graphics::Texture> m_ringTexture;
 	std::unique_ptr<Graphics::Material> m_ringMaterial;
 	std::unique_ptr<Graphics::MeshObject> m_ringMesh;
+	// fills in m_ringTexture, which holds a placeholder until then
+	Job::Handle m_ringJob;
 };
 
 #endif /* _PLANET_H */
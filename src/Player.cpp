@@ -333,8 +333,8 @@ void Player::StaticUpdate(const float timeStep)
 	}
 	m_atmosAccel = current_atmosAccel;
 
-	// XXX even when not on screen. hacky, but really cockpit shouldn't be here
-	// anyway so this will do for now
+	// XXX the cockpit suspends itself when not on screen. hacky, but really
+	// cockpit shouldn't be here anyway so this will do for now
 	if (m_cockpit)
 		m_cockpit->Update(this, timeStep);
 }
@@ -7,7 +7,9 @@
 #include "Frame.h"
 #include "Game.h"
 #include "GameSaveError.h"
+#include "Json.h"
 #include "JsonUtils.h"
+#include "ModelBody.h"
 #include "Pi.h"
 #include "Planet.h"
 #include "Player.h"
@@ -17,25 +19,46 @@
 #include "collider/CollisionContact.h"
 #include "collider/CollisionSpace.h"
 #include "galaxy/StarSystem.h"
+#include "graphics/Frustum.h"
 #include "graphics/Graphics.h"
 #include "graphics/Material.h"
 #include "graphics/RenderState.h"
 #include "graphics/Renderer.h"
 #include "graphics/TextureBuilder.h"
 #include "graphics/VertexArray.h"
+#include "graphics/VertexBuffer.h"
 #include "lua/LuaEvent.h"
 #include "lua/LuaUtils.h"
 
-std::unique_ptr<Graphics::MeshObject> Projectile::s_sideMesh;
-std::unique_ptr<Graphics::MeshObject> Projectile::s_glowMesh;
-std::unique_ptr<Graphics::Material> Projectile::s_sideMat;
-std::unique_ptr<Graphics::Material> Projectile::s_glowMat;
-
-void Projectile::BuildModel()
+// bolts are batched by colour, so their fade is quantised to steps of this much alpha
+static const int ALPHA_STEP = 16;
+// smallest instance buffer to allocate, so that buffers aren't regrown
+// every time a fight gets a little bigger
+static const Uint32 MIN_INSTANCE_BUFFER_SIZE = 64;
+
+std::vector<vector3d> ProjectileManager::s_rayDirs;
+std::vector<double> ProjectileManager::s_rayLengths;
+std::vector<const Geom *> ProjectileManager::s_rayIgnore;
+std::vector<CollisionContact> ProjectileManager::s_contacts;
+std::vector<size_t> ProjectileManager::s_dead;
+
+std::vector<ProjectileManager::RenderBatch> ProjectileManager::s_sideBatches;
+std::vector<ProjectileManager::RenderBatch> ProjectileManager::s_glowBatches;
+size_t ProjectileManager::s_numSideBatches = 0;
+size_t ProjectileManager::s_numGlowBatches = 0;
+std::vector<RefCountedPtr<Graphics::InstanceBuffer>> ProjectileManager::s_instanceBuffers;
+
+std::unique_ptr<Graphics::MeshObject> ProjectileManager::s_sideMesh;
+std::unique_ptr<Graphics::MeshObject> ProjectileManager::s_glowMesh;
+std::unique_ptr<Graphics::Material> ProjectileManager::s_sideMat;
+std::unique_ptr<Graphics::Material> ProjectileManager::s_glowMat;
+
+void ProjectileManager::BuildModel()
 {
-	//set up materials
+	//set up materials, instanced as bolts are positioned in the vertex shader
 	Graphics::MaterialDescriptor desc;
 	desc.textures = 1;
+	desc.instanced = true;
 
 	Graphics::RenderStateDesc rsd;
 	rsd.blendMode = Graphics::BLEND_ALPHA_ONE;
@@ -106,125 +129,16 @@ void Projectile::BuildModel()
 	s_glowMesh.reset(Pi::renderer->CreateMeshObjectFromArray(&glowVerts));
 }
 
-void Projectile::FreeModel()
+void ProjectileManager::FreeModel()
 {
 	s_sideMat.reset();
 	s_glowMat.reset();
 	s_sideMesh.reset();
 	s_glowMesh.reset();
+	s_instanceBuffers.clear();
 }
 
-Projectile::Projectile(Body *parent, const ProjectileData &prData, const vector3d &pos, const vector3d &baseVel, const vector3d &dirVel) :
-	Body()
-{
-	if (!s_sideMat) BuildModel();
-	m_flags |= FLAG_DRAW_LAST;
-
-	m_parent = parent;
-	m_lifespan = prData.lifespan;
-	m_baseDam = prData.damage;
-	m_length = prData.length;
-	m_width = prData.width;
-	m_mining = prData.mining;
-	m_color = prData.color;
-	m_age = 0;
-
-	SetFrame(parent->GetFrame());
-
-	SetOrient(parent->GetOrient());
-	SetPosition(pos);
-	m_baseVel = baseVel;
-	m_dirVel = dirVel;
-	SetClipRadius(GetRadius());
-	SetPhysRadius(GetRadius());
-}
-
-Projectile::Projectile(const Json &jsonObj, Space *space) :
-	Body(jsonObj, space)
-{
-	if (!s_sideMat) BuildModel();
-
-	try {
-		Json projectileObj = jsonObj["projectile"];
-
-		m_baseVel = projectileObj["base_vel"];
-		m_dirVel = projectileObj["dir_vel"];
-		m_age = projectileObj["age"];
-		m_lifespan = projectileObj["life_span"];
-		m_baseDam = projectileObj["base_dam"];
-		m_length = projectileObj["length"];
-		m_width = projectileObj["width"];
-		m_mining = projectileObj["mining"];
-		m_color = projectileObj["color"];
-		m_parentIndex = projectileObj["index_for_body"];
-	} catch (Json::type_error &) {
-		throw SavedGameCorruptException();
-	}
-}
-
-Projectile::~Projectile()
-{
-}
-
-void Projectile::SaveToJson(Json &jsonObj, Space *space)
-{
-	Body::SaveToJson(jsonObj, space);
-
-	Json projectileObj({}); // Create JSON object to contain projectile data.
-
-	projectileObj["base_vel"] = m_baseVel;
-	projectileObj["dir_vel"] = m_dirVel;
-	projectileObj["age"] = m_age;
-	projectileObj["life_span"] = m_lifespan;
-	projectileObj["base_dam"] = m_baseDam;
-	projectileObj["length"] = m_length;
-	projectileObj["width"] = m_width;
-	projectileObj["mining"] = m_mining;
-	projectileObj["color"] = m_color;
-	projectileObj["index_for_body"] = space->GetIndexForBody(m_parent);
-
-	jsonObj["projectile"] = projectileObj; // Add projectile object to supplied object.
-}
-
-void Projectile::PostLoadFixup(Space *space)
-{
-	Body::PostLoadFixup(space);
-	m_parent = space->GetBodyByIndex(m_parentIndex);
-}
-
-void Projectile::UpdateInterpTransform(double alpha)
-{
-	m_interpOrient = GetOrient();
-	const vector3d oldPos = GetPosition() - (m_baseVel + m_dirVel) * Pi::game->GetTimeStep();
-	m_interpPos = alpha * GetPosition() + (1.0 - alpha) * oldPos;
-}
-
-void Projectile::NotifyRemoved(const Body *const removedBody)
-{
-	if (m_parent == removedBody) m_parent = 0;
-}
-
-void Projectile::TimeStepUpdate(const float timeStep)
-{
-	m_age += timeStep;
-	SetPosition(GetPosition() + (m_baseVel + m_dirVel) * double(timeStep));
-	if (m_age > m_lifespan) Pi::game->GetSpace()->KillBody(this);
-}
-
-/* In hull kg */
-float Projectile::GetDamage() const
-{
-	return m_baseDam * sqrt((m_lifespan - m_age) / m_lifespan);
-	// TEST
-	//	return 0.01f;
-}
-
-double Projectile::GetRadius() const
-{
-	return sqrt(m_length * m_length + m_width * m_width);
-}
-
-void MiningLaserSpawnTastyStuff(FrameId fId, const SystemBody *asteroid, const vector3d &pos)
+static void MiningLaserSpawnTastyStuff(FrameId fId, const SystemBody *asteroid, const vector3d &pos)
 {
 	lua_State *l = Lua::manager->GetLuaState();
 
@@ -257,122 +171,393 @@ void MiningLaserSpawnTastyStuff(FrameId fId, const SystemBody *asteroid, const v
 	Pi::game->GetSpace()->AddBody(cargo);
 }
 
-void Projectile::StaticUpdate(const float timeStep)
+ProjectileManager *ProjectileManager::AllocInFrame(FrameId fId)
+{
+	Frame *f = Frame::GetFrame(fId);
+
+	if (!f->m_projectiles) {
+		f->m_projectiles.reset(new ProjectileManager);
+	}
+
+	return f->m_projectiles.get();
+}
+
+void ProjectileManager::Add(Body *parent, const ProjectileData &prData, const vector3d &pos, const vector3d &baseVel, const vector3d &dirVel)
+{
+	if (!s_sideMat) BuildModel();
+	AllocInFrame(parent->GetFrame())->Push(parent, prData, pos, baseVel, dirVel, 0.f);
+}
+
+void ProjectileManager::Push(Body *parent, const ProjectileData &prData, const vector3d &pos, const vector3d &baseVel, const vector3d &dirVel, float age)
+{
+	m_pos.push_back(pos);
+	m_baseVel.push_back(baseVel);
+	m_dirVel.push_back(dirVel);
+	m_parent.push_back(parent);
+	m_age.push_back(age);
+	m_lifespan.push_back(prData.lifespan);
+	m_baseDam.push_back(prData.damage);
+	m_length.push_back(prData.length);
+	m_width.push_back(prData.width);
+	m_color.push_back(prData.color);
+	m_mining.push_back(prData.mining);
+}
+
+void ProjectileManager::Remove(size_t i)
+{
+	// swap the last bolt into the freed slot
+	auto remove = [i](auto &array) {
+		array[i] = array.back();
+		array.pop_back();
+	};
+	remove(m_pos);
+	remove(m_baseVel);
+	remove(m_dirVel);
+	remove(m_parent);
+	remove(m_age);
+	remove(m_lifespan);
+	remove(m_baseDam);
+	remove(m_length);
+	remove(m_width);
+	remove(m_color);
+	remove(m_mining);
+}
+
+void ProjectileManager::StaticUpdateAll(const float timeStep, FrameId fId)
 {
 	PROFILE_SCOPED()
-	CollisionContact c;
-	// Collision spaces don't store velocity, so dirvel-only is still wrong but less awful than dirvel+basevel
-	vector3d vel = m_dirVel * timeStep;
-	Frame *frame = Frame::GetFrame(GetFrame());
-	frame->GetCollisionSpace()->TraceRay(GetPosition(), vel.Normalized(), vel.Length(), &c);
-
-	if (c.userData1) {
-		Body *hit = static_cast<Body *>(c.userData1);
-		if (hit != m_parent) {
-			hit->OnDamage(m_parent, GetDamage(), c);
-			Pi::game->GetSpace()->KillBody(this);
-			if (hit->IsType(ObjectType::SHIP))
-				LuaEvent::Queue("onShipHit", dynamic_cast<Ship *>(hit), dynamic_cast<Body *>(m_parent));
-		}
+
+	Frame *f = Frame::GetFrame(fId);
+
+	if (f->m_projectiles && f->m_projectiles->GetNumProjectiles())
+		f->m_projectiles->Collide(timeStep, f);
+
+	for (FrameId kid : f->GetChildren()) {
+		StaticUpdateAll(timeStep, kid);
+	}
+}
+
+void ProjectileManager::TimeStepAll(const float timeStep, FrameId fId)
+{
+	PROFILE_SCOPED()
+
+	Frame *f = Frame::GetFrame(fId);
+
+	if (f->m_projectiles)
+		f->m_projectiles->TimeStep(timeStep);
+
+	for (FrameId kid : f->GetChildren()) {
+		TimeStepAll(timeStep, kid);
+	}
+}
+
+void ProjectileManager::NotifyRemovedAll(const Body *removedBody, FrameId fId)
+{
+	Frame *f = Frame::GetFrame(fId);
+
+	if (f->m_projectiles) {
+		for (Body *&parent : f->m_projectiles->m_parent)
+			if (parent == removedBody) parent = nullptr;
+	}
+
+	for (FrameId kid : f->GetChildren()) {
+		NotifyRemovedAll(removedBody, kid);
+	}
+}
+
+void ProjectileManager::TimeStep(const float timeStep)
+{
+	// walk backwards so that bolts swapped into a removed slot have
+	// already been updated
+	for (size_t i = m_pos.size(); i-- > 0;) {
+		m_age[i] += timeStep;
+		m_pos[i] += (m_baseVel[i] + m_dirVel[i]) * double(timeStep);
+		if (m_age[i] > m_lifespan[i])
+			Remove(i);
 	}
-	if (m_mining) // mining lasers can break off chunks of terrain
-	{
-		// need to test for terrain hit
-		Planet *const planet = static_cast<Planet *>(frame->GetBody()); // cache the value even for the if statement
-		if (planet && planet->IsType(ObjectType::PLANET)) {
-			vector3d pos = GetPosition();
-			double terrainHeight = planet->GetTerrainHeight(pos.Normalized());
+}
+
+void ProjectileManager::Collide(const float timeStep, Frame *frame)
+{
+	PROFILE_SCOPED()
+
+	const size_t numBolts = m_pos.size();
+	s_rayDirs.resize(numBolts);
+	s_rayLengths.resize(numBolts);
+	s_rayIgnore.resize(numBolts);
+	s_contacts.assign(numBolts, CollisionContact());
+
+	for (size_t i = 0; i < numBolts; i++) {
+		// Collision spaces don't store velocity, so dirvel-only is still wrong but less awful than dirvel+basevel
+		const vector3d vel = m_dirVel[i] * double(timeStep);
+		s_rayLengths[i] = vel.Length();
+		s_rayDirs[i] = vel.Normalized();
+
+		// bolts pass through the ship that fired them
+		Body *parent = m_parent[i];
+		s_rayIgnore[i] = (parent && parent->IsType(ObjectType::MODELBODY)) ? static_cast<ModelBody *>(parent)->GetGeom() : nullptr;
+	}
+
+	frame->GetCollisionSpace()->TraceRays(numBolts, m_pos.data(), s_rayDirs.data(), s_rayLengths.data(), s_rayIgnore.data(), s_contacts.data());
+
+	// mining lasers can break off chunks of terrain
+	Body *frameBody = frame->GetBody();
+	Planet *const planet = (frameBody && frameBody->IsType(ObjectType::PLANET)) ? static_cast<Planet *>(frameBody) : nullptr;
+
+	s_dead.clear();
+	for (size_t i = 0; i < numBolts; i++) {
+		const CollisionContact &c = s_contacts[i];
+		if (c.userData1) {
+			Body *hit = static_cast<Body *>(c.userData1);
+			Body *parent = m_parent[i];
+			if (hit != parent) {
+				hit->OnDamage(parent, GetDamage(i), c);
+				s_dead.push_back(i);
+				if (hit->IsType(ObjectType::SHIP))
+					LuaEvent::QueueCoalesced("onShipHit", { hit, parent }, dynamic_cast<Ship *>(hit), parent);
+				continue;
+			}
+		}
+
+		if (m_mining[i] && planet) {
+			const vector3d &pos = m_pos[i];
+			const double terrainHeight = planet->GetTerrainHeight(pos.Normalized());
 			if (terrainHeight > pos.Length()) {
 				const SystemBody *b = planet->GetSystemBody();
 				// hit the fucker
 				if (b->GetType() == SystemBody::TYPE_PLANET_ASTEROID) {
-					vector3d n = GetPosition().Normalized();
+					const vector3d n = pos.Normalized();
 					MiningLaserSpawnTastyStuff(planet->GetFrame(), b, n * terrainHeight + 5.0 * n);
-					SfxManager::Add(this, TYPE_EXPLOSION);
+					SfxManager::Add(frame->GetId(), pos, vector3d(0.0), TYPE_EXPLOSION);
 				}
-				Pi::game->GetSpace()->KillBody(this);
+				s_dead.push_back(i);
 			}
 		}
 	}
+
+	// back to front, so that the bolts being swapped in are never dead ones
+	for (auto iter = s_dead.rbegin(); iter != s_dead.rend(); ++iter)
+		Remove(*iter);
 }
 
-void Projectile::Render(Graphics::Renderer *renderer, const Camera *camera, const vector3d &viewCoords, const matrix4x4d &viewTransform)
+void ProjectileManager::RenderAll(Graphics::Renderer *renderer, const Graphics::Frustum &frustum, FrameId fId, const FrameId camFrameId)
 {
 	PROFILE_SCOPED()
-	vector3d _from = viewTransform * GetInterpPosition();
-	vector3d _to = viewTransform * (GetInterpPosition() + m_dirVel);
-	vector3d _dir = _to - _from;
-	vector3f from(&_from.x);
-	vector3f dir = vector3f(_dir).Normalized();
-
-	vector3f v1, v2;
-	matrix4x4f m = matrix4x4f::Identity();
-	v1.x = dir.y;
-	v1.y = dir.z;
-	v1.z = dir.x;
-	v2 = v1.Cross(dir).Normalized();
-	v1 = v2.Cross(dir);
-	m[0] = v1.x;
-	m[4] = v2.x;
-	m[8] = dir.x;
-	m[1] = v1.y;
-	m[5] = v2.y;
-	m[9] = dir.y;
-	m[2] = v1.z;
-	m[6] = v2.z;
-	m[10] = dir.z;
-
-	m[12] = from.x;
-	m[13] = from.y;
-	m[14] = from.z;
-
-	// increase visible size based on distance from camera, z is always negative
-	// allows them to be smaller while maintaining visibility for game play
-	const float dist_scale = float(viewCoords.z / -500);
-	const float length = m_length + dist_scale;
-	const float width = m_width + dist_scale;
-
-	renderer->SetTransform(m * matrix4x4f::ScaleMatrix(width, width, length));
-
-	Color color = m_color;
-	// fade them out as they age so they don't suddenly disappear
-	// this matches the damage fall-off calculation
-	const float base_alpha = sqrt(1.0f - m_age / m_lifespan);
-	// fade out side quads when viewing nearly edge on
-	vector3f view_dir = vector3f(viewCoords).Normalized();
-	color.a = (base_alpha * (1.f - powf(fabs(dir.Dot(view_dir)), length))) * 255;
-
-	if (color.a > 3) {
-		s_sideMat->diffuse = color;
-		renderer->DrawMesh(s_sideMesh.get(), s_sideMat.get());
+
+	s_numSideBatches = 0;
+	s_numGlowBatches = 0;
+	GatherFrame(frustum, fId, camFrameId);
+
+	if (!s_numSideBatches && !s_numGlowBatches)
+		return;
+
+	// bolt transforms are camera-relative and applied in the vertex shader
+	Graphics::Renderer::MatrixTicket mt(renderer, matrix4x4f::Identity());
+
+	size_t numBuffersUsed = 0;
+	DrawBatches(renderer, s_sideBatches, s_numSideBatches, s_sideMesh.get(), s_sideMat.get(), numBuffersUsed);
+	DrawBatches(renderer, s_glowBatches, s_numGlowBatches, s_glowMesh.get(), s_glowMat.get(), numBuffersUsed);
+}
+
+void ProjectileManager::GatherFrame(const Graphics::Frustum &frustum, FrameId fId, const FrameId camFrameId)
+{
+	const Frame *f = Frame::GetFrame(fId);
+	const ProjectileManager *pm = f->m_projectiles.get();
+
+	if (pm && pm->GetNumProjectiles()) {
+		matrix4x4d viewTransform = f->GetInterpOrientRelTo(camFrameId);
+		viewTransform.SetTranslate(f->GetInterpPositionRelTo(camFrameId));
+
+		// bolts move in a straight line, so interpolate back along it
+		const double interpBack = (1.0 - Pi::GetGameTickAlpha()) * Pi::game->GetTimeStep();
+
+		for (size_t i = 0; i < pm->GetNumProjectiles(); i++) {
+			const vector3d interpPos = pm->m_pos[i] - (pm->m_baseVel[i] + pm->m_dirVel[i]) * interpBack;
+			const vector3d viewCoords = viewTransform * interpPos;
+			if (!frustum.TestPointInfinite(viewCoords, pm->GetRadius(i)))
+				continue;
+
+			const vector3d _to = viewTransform * (interpPos + pm->m_dirVel[i]);
+			const vector3f from(viewCoords);
+			const vector3f dir = vector3f(_to - viewCoords).Normalized();
+
+			vector3f v1, v2;
+			matrix4x4f m = matrix4x4f::Identity();
+			v1.x = dir.y;
+			v1.y = dir.z;
+			v1.z = dir.x;
+			v2 = v1.Cross(dir).Normalized();
+			v1 = v2.Cross(dir);
+			m[0] = v1.x;
+			m[4] = v2.x;
+			m[8] = dir.x;
+			m[1] = v1.y;
+			m[5] = v2.y;
+			m[9] = dir.y;
+			m[2] = v1.z;
+			m[6] = v2.z;
+			m[10] = dir.z;
+
+			m[12] = from.x;
+			m[13] = from.y;
+			m[14] = from.z;
+
+			// increase visible size based on distance from camera, z is always negative
+			// allows them to be smaller while maintaining visibility for game play
+			const float dist_scale = float(viewCoords.z / -500);
+			const float length = pm->m_length[i] + dist_scale;
+			const float width = pm->m_width[i] + dist_scale;
+			const matrix4x4f transform = m * matrix4x4f::ScaleMatrix(width, width, length);
+
+			Color color = pm->m_color[i];
+			// fade them out as they age so they don't suddenly disappear
+			// this matches the damage fall-off calculation
+			const float base_alpha = sqrt(1.0f - pm->m_age[i] / pm->m_lifespan[i]);
+			const vector3f view_dir = from.Normalized();
+			const float facing = fabs(dir.Dot(view_dir));
+
+			// fade out side quads when viewing nearly edge on
+			color.a = (base_alpha * (1.f - powf(facing, length))) * 255;
+			if (color.a > 3)
+				AddToBatch(s_sideBatches, s_numSideBatches, color, transform);
+
+			// fade out glow quads when viewing nearly edge on
+			// these and the side quads fade at different rates
+			// so that they aren't both at the same alpha as that looks strange
+			color.a = (base_alpha * powf(facing, width)) * 255;
+			if (color.a > 3)
+				AddToBatch(s_glowBatches, s_numGlowBatches, color, transform);
+		}
 	}
 
-	// fade out glow quads when viewing nearly edge on
-	// these and the side quads fade at different rates
-	// so that they aren't both at the same alpha as that looks strange
-	color.a = (base_alpha * powf(fabs(dir.Dot(view_dir)), width)) * 255;
+	for (FrameId kid : f->GetChildren()) {
+		GatherFrame(frustum, kid, camFrameId);
+	}
+}
 
-	if (color.a > 3) {
-		s_glowMat->diffuse = color;
-		renderer->DrawMesh(s_glowMesh.get(), s_glowMat.get());
+void ProjectileManager::AddToBatch(std::vector<RenderBatch> &batches, size_t &numBatches, Color color, const matrix4x4f &transform)
+{
+	color.a = (color.a / ALPHA_STEP) * ALPHA_STEP + ALPHA_STEP / 2;
+	const Uint32 key = (Uint32(color.r) << 24) | (Uint32(color.g) << 16) | (Uint32(color.b) << 8) | Uint32(color.a);
+
+	// there are only ever a handful of gun colours in use
+	for (size_t i = 0; i < numBatches; i++) {
+		if (batches[i].key == key) {
+			batches[i].transforms.push_back(transform);
+			return;
+		}
 	}
+
+	// batches are reused between frames to keep their allocations
+	if (numBatches == batches.size())
+		batches.emplace_back();
+
+	RenderBatch &batch = batches[numBatches++];
+	batch.key = key;
+	batch.color = color;
+	batch.transforms.clear();
+	batch.transforms.push_back(transform);
 }
 
-void Projectile::Add(Body *parent, float lifespan, float dam, float length, float width, bool mining, const Color &color, const vector3d &pos, const vector3d &baseVel, const vector3d &dirVel)
+void ProjectileManager::DrawBatches(Graphics::Renderer *r, std::vector<RenderBatch> &batches, size_t numBatches,
+	Graphics::MeshObject *mesh, Graphics::Material *mat, size_t &numBuffersUsed)
 {
-	ProjectileData prData;
-	prData.lifespan = lifespan;
-	prData.damage = dam;
-	prData.length = length;
-	prData.width = width;
-	prData.mining = mining;
-	prData.color = color;
-	Projectile *p = new Projectile(parent, prData, pos, baseVel, dirVel);
-	Pi::game->GetSpace()->AddBody(p);
+	for (size_t i = 0; i < numBatches; i++) {
+		const std::vector<matrix4x4f> &transforms = batches[i].transforms;
+
+		// instance data is uploaded now but drawn when the command list is
+		// flushed, so every batch needs a buffer of its own
+		if (numBuffersUsed == s_instanceBuffers.size())
+			s_instanceBuffers.emplace_back();
+
+		RefCountedPtr<Graphics::InstanceBuffer> &ib = s_instanceBuffers[numBuffersUsed++];
+		if (!ib.Valid() || transforms.size() > ib->GetSize()) {
+			const Uint32 size = std::max(MIN_INSTANCE_BUFFER_SIZE, Uint32(transforms.size() * 2));
+			ib.Reset(r->CreateInstanceBuffer(size, Graphics::BUFFER_USAGE_DYNAMIC));
+		}
+
+		matrix4x4f *pBuffer = ib->Map(Graphics::BUFFER_MAP_WRITE);
+		if (!pBuffer)
+			continue;
+
+		std::copy(transforms.begin(), transforms.end(), pBuffer);
+		ib->Unmap();
+		ib->SetInstanceCount(transforms.size());
+
+		mat->diffuse = batches[i].color;
+		r->DrawMeshInstanced(mesh, mat, ib.Get());
+	}
 }
 
-void Projectile::Add(Body *parent, const ProjectileData &prData, const vector3d &pos, const vector3d &baseVel, const vector3d &dirVel)
+void ProjectileManager::ToJson(Json &jsonObj, const FrameId fId, Space *space)
 {
-	Projectile *p = new Projectile(parent, prData, pos, baseVel, dirVel);
-	Pi::game->GetSpace()->AddBody(p);
+	const Frame *f = Frame::GetFrame(fId);
+	const ProjectileManager *pm = f->m_projectiles.get();
+
+	if (!pm || !pm->GetNumProjectiles())
+		return;
+
+	Json projectileArray = Json::array(); // Create JSON array to contain projectile data.
+
+	for (size_t i = 0; i < pm->GetNumProjectiles(); i++) {
+		Json projectileObj({}); // Create JSON object to contain projectile data.
+
+		projectileObj["pos"] = pm->m_pos[i];
+		projectileObj["base_vel"] = pm->m_baseVel[i];
+		projectileObj["dir_vel"] = pm->m_dirVel[i];
+		projectileObj["age"] = pm->m_age[i];
+		projectileObj["life_span"] = pm->m_lifespan[i];
+		projectileObj["base_dam"] = pm->m_baseDam[i];
+		projectileObj["length"] = pm->m_length[i];
+		projectileObj["width"] = pm->m_width[i];
+		projectileObj["mining"] = bool(pm->m_mining[i]);
+		projectileObj["color"] = pm->m_color[i];
+		projectileObj["index_for_body"] = space->GetIndexForBody(pm->m_parent[i]);
+
+		projectileArray.push_back(projectileObj); // Append projectile object to array.
+	}
+
+	jsonObj["projectile_array"] = projectileArray; // Add projectile array to supplied object.
+}
+
+void ProjectileManager::FromJson(const Json &jsonObj, FrameId fId)
+{
+	if (!jsonObj.count("projectile_array"))
+		return;
+
+	if (!s_sideMat) BuildModel();
+
+	try {
+		const Json &projectileArray = jsonObj["projectile_array"];
+		ProjectileManager *pm = AllocInFrame(fId);
+
+		for (const Json &projectileObj : projectileArray) {
+			ProjectileData prData;
+			prData.lifespan = projectileObj["life_span"];
+			prData.damage = projectileObj["base_dam"];
+			prData.length = projectileObj["length"];
+			prData.width = projectileObj["width"];
+			prData.mining = projectileObj["mining"];
+			prData.color = projectileObj["color"];
+
+			const vector3d pos = projectileObj["pos"];
+			const vector3d baseVel = projectileObj["base_vel"];
+			const vector3d dirVel = projectileObj["dir_vel"];
+			pm->Push(nullptr, prData, pos, baseVel, dirVel, projectileObj["age"]);
+			pm->m_parentIndex.push_back(projectileObj["index_for_body"]);
+		}
+	} catch (Json::type_error &) {
+		throw SavedGameCorruptException();
+	}
+}
+
+void ProjectileManager::PostLoadFixup(FrameId fId, Space *space)
+{
+	ProjectileManager *pm = Frame::GetFrame(fId)->m_projectiles.get();
+	if (!pm)
+		return;
+
+	for (size_t i = 0; i < pm->m_parentIndex.size(); i++)
+		pm->m_parent[i] = space->GetBodyByIndex(pm->m_parentIndex[i]);
+	pm->m_parentIndex.clear();
 }
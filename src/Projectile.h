@@ -4,8 +4,15 @@
 #ifndef _PROJECTILE_H
 #define _PROJECTILE_H
 
-#include "Body.h"
 #include "Color.h"
+#include "FrameId.h"
+#include "JsonFwd.h"
+#include "RefCounted.h"
+#include "matrix4x4.h"
+#include "vector3.h"
+
+#include <memory>
+#include <vector>
 
 struct ProjectileData {
 	ProjectileData() :
@@ -27,54 +34,94 @@ struct ProjectileData {
 	bool beam;
 };
 
+class Body;
 class Frame;
+class Geom;
+class Space;
+struct CollisionContact;
 
 namespace Graphics {
+	class Frustum;
+	class InstanceBuffer;
 	class Material;
 	class Renderer;
 	class MeshObject;
 } // namespace Graphics
 
-class Projectile : public Body {
+// Laser bolts, stored per frame as arrays rather than as individual bodies.
+//
+// Bolts never change frame, collide only by tracing their path through the
+// frame's collision space once per step, and are drawn with one instanced
+// draw per colour and fade level instead of a draw per bolt.
+class ProjectileManager {
 public:
-	OBJDEF(Projectile, Body, PROJECTILE);
-
-	static void Add(Body *parent, float lifespan, float dam, float length, float width, bool mining, const Color &color, const vector3d &pos, const vector3d &baseVel, const vector3d &dirVel);
 	static void Add(Body *parent, const ProjectileData &prData, const vector3d &pos, const vector3d &baseVel, const vector3d &dirVel);
 
-	Projectile() = delete;
-	Projectile(Body *parent, const ProjectileData &prData, const vector3d &pos, const vector3d &baseVel, const vector3d &dirVel);
-	Projectile(const Json &jsonObj, Space *space);
-	virtual ~Projectile();
-	virtual void Render(Graphics::Renderer *r, const Camera *camera, const vector3d &viewCoords, const matrix4x4d &viewTransform) override final;
-	void TimeStepUpdate(const float timeStep) override final;
-	void StaticUpdate(const float timeStep) override final;
-	virtual void NotifyRemoved(const Body *const removedBody) override final;
-	virtual void UpdateInterpTransform(double alpha) override final;
-	virtual void PostLoadFixup(Space *space) override final;
+	// hit-test the path of every bolt over the next step, before bodies move
+	static void StaticUpdateAll(const float timeStep, FrameId f);
+	// move and age every bolt
+	static void TimeStepAll(const float timeStep, FrameId f);
+	static void RenderAll(Graphics::Renderer *r, const Graphics::Frustum &frustum, FrameId f, const FrameId camFrame);
+	// clear any bolts' pointers to a body leaving space
+	static void NotifyRemovedAll(const Body *removedBody, FrameId f);
+
+	static void ToJson(Json &jsonObj, const FrameId f, Space *space);
+	static void FromJson(const Json &jsonObj, FrameId f);
+	static void PostLoadFixup(FrameId f, Space *space);
 
 	static void FreeModel();
 
-protected:
-	virtual void SaveToJson(Json &jsonObj, Space *space) override final;
+	size_t GetNumProjectiles() const { return m_pos.size(); }
 
 private:
-	float GetDamage() const;
-	double GetRadius() const;
-	Body *m_parent;
-	vector3d m_baseVel;
-	vector3d m_dirVel;
-	float m_age;
-	float m_lifespan;
-	float m_baseDam;
-	float m_length;
-	float m_width;
-	bool m_mining;
-	Color m_color;
-
-	int m_parentIndex; // deserialisation
+	struct RenderBatch {
+		Uint32 key;
+		Color color;
+		std::vector<matrix4x4f> transforms;
+	};
 
+	static ProjectileManager *AllocInFrame(FrameId f);
 	static void BuildModel();
+	static void GatherFrame(const Graphics::Frustum &frustum, FrameId f, const FrameId camFrame);
+	static void AddToBatch(std::vector<RenderBatch> &batches, size_t &numBatches, Color color, const matrix4x4f &transform);
+	static void DrawBatches(Graphics::Renderer *r, std::vector<RenderBatch> &batches, size_t numBatches,
+		Graphics::MeshObject *mesh, Graphics::Material *mat, size_t &numBuffersUsed);
+
+	void Push(Body *parent, const ProjectileData &prData, const vector3d &pos, const vector3d &baseVel, const vector3d &dirVel, float age);
+	void Remove(size_t i);
+	void Collide(const float timeStep, Frame *frame);
+	void TimeStep(const float timeStep);
+
+	float GetDamage(size_t i) const { return m_baseDam[i] * sqrt((m_lifespan[i] - m_age[i]) / m_lifespan[i]); }
+	double GetRadius(size_t i) const { return sqrt(m_length[i] * m_length[i] + m_width[i] * m_width[i]); }
+
+	// per-bolt state
+	std::vector<vector3d> m_pos;
+	std::vector<vector3d> m_baseVel;
+	std::vector<vector3d> m_dirVel;
+	std::vector<Body *> m_parent;
+	std::vector<float> m_age;
+	std::vector<float> m_lifespan;
+	std::vector<float> m_baseDam;
+	std::vector<float> m_length;
+	std::vector<float> m_width;
+	std::vector<Color> m_color;
+	std::vector<Uint8> m_mining;
+
+	std::vector<Uint32> m_parentIndex; // deserialisation
+
+	// shared ray-cast scratch space
+	static std::vector<vector3d> s_rayDirs;
+	static std::vector<double> s_rayLengths;
+	static std::vector<const Geom *> s_rayIgnore;
+	static std::vector<CollisionContact> s_contacts;
+	static std::vector<size_t> s_dead;
+
+	static std::vector<RenderBatch> s_sideBatches;
+	static std::vector<RenderBatch> s_glowBatches;
+	static size_t s_numSideBatches;
+	static size_t s_numGlowBatches;
+	static std::vector<RefCountedPtr<Graphics::InstanceBuffer>> s_instanceBuffers;
 
 	static std::unique_ptr<Graphics::MeshObject> s_sideMesh;
 	static std::unique_ptr<Graphics::MeshObject> s_glowMesh;
@@ -0,0 +1,104 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "SaveDelta.h"
+
+#include "Json.h"
+#include "core/FNV1a.h"
+#include "profiler/Profiler.h"
+
+#include <functional>
+
+namespace {
+	// escape a key for use as a JSON pointer reference token (RFC 6901)
+	std::string EscapeKey(const std::string &key)
+	{
+		std::string out;
+		out.reserve(key.size() + 1);
+		out.push_back('/');
+		for (char c : key) {
+			if (c == '~')
+				out += "~0";
+			else if (c == '/')
+				out += "~1";
+			else
+				out.push_back(c);
+		}
+		return out;
+	}
+
+	uint64_t HashValue(const Json &value)
+	{
+		const std::vector<uint8_t> cbor = Json::to_cbor(value);
+		return hash_64_fnv1a(reinterpret_cast<const char *>(cbor.data()), cbor.size());
+	}
+
+	// calls fn(pointer, value) for every section of the save
+	void ForEachSection(const Json &root, const std::function<void(const std::string &, const Json &)> &fn)
+	{
+		for (auto it = root.begin(); it != root.end(); ++it) {
+			const std::string ptr = EscapeKey(it.key());
+			const Json &value = it.value();
+			if (value.is_object() && !value.empty()) {
+				for (auto child = value.begin(); child != value.end(); ++child)
+					fn(ptr + EscapeKey(child.key()), child.value());
+			} else {
+				fn(ptr, value);
+			}
+		}
+	}
+} // namespace
+
+void SaveDelta::HashSections(const Json &root, SectionHashes &hashes)
+{
+	PROFILE_SCOPED()
+	hashes.clear();
+	ForEachSection(root, [&](const std::string &ptr, const Json &value) {
+		hashes[ptr] = HashValue(value);
+	});
+}
+
+Json SaveDelta::MakeDelta(const Json &root, const SectionHashes &base)
+{
+	PROFILE_SCOPED()
+	Json sections = Json::object();
+	std::map<std::string, bool> seen;
+
+	ForEachSection(root, [&](const std::string &ptr, const Json &value) {
+		seen[ptr] = true;
+		auto it = base.find(ptr);
+		if (it == base.end() || it->second != HashValue(value))
+			sections[ptr] = value;
+	});
+
+	Json removed = Json::array();
+	for (const auto &section : base) {
+		if (!seen.count(section.first))
+			removed.push_back(section.first);
+	}
+
+	Json delta = Json::object();
+	delta["sections"] = std::move(sections);
+	delta["removed"] = std::move(removed);
+	return delta;
+}
+
+void SaveDelta::ApplyDelta(Json &base, const Json &delta)
+{
+	PROFILE_SCOPED()
+	for (const Json &ptr : delta["removed"]) {
+		const std::string path = ptr.get<std::string>();
+		const size_t split = path.rfind('/');
+		Json &parent = split == 0 ? base : base[Json::json_pointer(path.substr(0, split))];
+		std::string key = path.substr(split + 1);
+		// unescape the reference token
+		for (size_t pos = 0; (pos = key.find('~', pos)) != std::string::npos; ++pos)
+			key.replace(pos, 2, key[pos + 1] == '1' ? "/" : "~");
+		if (parent.is_object())
+			parent.erase(key);
+	}
+
+	const Json &sections = delta["sections"];
+	for (auto it = sections.begin(); it != sections.end(); ++it)
+		base[Json::json_pointer(it.key())] = it.value();
+}
@@ -0,0 +1,30 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#pragma once
+
+#include "JsonFwd.h"
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+// Delta saves store only the sections of a saved game that differ from a
+// full "base" save written earlier. A section is a top-level value of the
+// save, or a child of a top-level object, addressed by its JSON pointer.
+namespace SaveDelta {
+
+	// content hashes of the sections of a full save, keyed by JSON pointer
+	using SectionHashes = std::map<std::string, uint64_t>;
+
+	void HashSections(const Json &root, SectionHashes &hashes);
+
+	// Builds a delta holding every section of root whose hash differs from
+	// (or is missing in) the base, plus a list of base sections root no
+	// longer has.
+	Json MakeDelta(const Json &root, const SectionHashes &base);
+
+	// Applies a delta made by MakeDelta to the base save it was made against.
+	void ApplyDelta(Json &base, const Json &delta);
+
+} // namespace SaveDelta
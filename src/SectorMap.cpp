@@ -21,6 +21,7 @@
 #include "pigui/PiGui.h"
 
 #include <float.h>
+#include <algorithm>
 #include <array>
 #include <cmath>
 #include <sstream>
@@ -522,6 +523,7 @@ void SectorMap::InitDefaults()
 	m_cacheYMax = 0;
 
 	m_sectorCache = m_context.galaxy->NewSectorSlaveCache();
+	m_systemCache = m_context.galaxy->NewStarSystemSlaveCache();
 	InputBindings.RegisterBindings();
 	m_size.x = Graphics::GetScreenWidth();
 	m_size.y = Graphics::GetScreenHeight();
@@ -826,27 +828,57 @@ void SectorMap::OnClickLabel(const SystemPath &path)
 	m_context.callbacks->OnClickLabel(path);
 }
 
-void SectorMap::PutSystemLabel(const Sector::System &sys, bool shadow)
+void SectorMap::PutSystemLabel(const Sector::System &sys, const matrix4x4f &systrans, bool shadow, bool always)
 {
 	PROFILE_SCOPED()
 
+	if (!(sys.GetPopulation() > 0 || m_drawUninhabitedLabels))
+		return;
+
 	// place the label
-	//vector3d systemPos = vector3d((*sys).GetFullPosition() - origin);
-	vector3d screenPos = Graphics::ProjectToScreen(m_context.renderer, vector3d(0.0));
+	const vector3f screenPos = Graphics::ProjectToScreen(systrans * vector3f(0.f), m_labelProjection, m_labelViewport);
 	// reject back-projected labels (negative Z in clipspace is in front of the view plane)
-	if (screenPos.z < 0.0f && (sys.GetPopulation() > 0 || m_drawUninhabitedLabels)) {
-		vector3d screenStarEdge = Graphics::ProjectToScreen(m_context.renderer, vector3d(0.25, 0.0, 0.0));
-		float screenStarRadius = screenStarEdge.x - screenPos.x;
-		// work out the colour
-		Color labelColor = sys.GetFaction()->AdjustedColour(sys.GetPopulation(), shadow);
-		// get a system path to pass to the event handler when the label is clicked
-		SystemPath sysPath = sys.GetPath();
-		// label text
-		std::string text = sys.GetName();
-		const float x = screenPos.x;
-		const float y = m_size.y - screenPos.y;
-		const float z = screenPos.z;
-		m_labels.array.emplace_back(std::make_unique<StarLabel>(m_labels, vector3f(x, y, z), labelColor, text, screenStarRadius, sysPath));
+	if (screenPos.z >= 0.0f)
+		return;
+
+	const float x = screenPos.x;
+	const float y = m_size.y - screenPos.y;
+	const float z = screenPos.z;
+
+	// the text extends to the right of the star, so allow some slack on the left
+	const float margin = m_labelGridCellSize;
+	if (x < -20.f * margin || x > m_size.x + margin || y < -margin || y > m_size.y + margin)
+		return;
+
+	// only the nearest of several labels anchored in the same cell is kept;
+	// more negative z is closer to the camera
+	int *cell = nullptr;
+	if (!always && x >= 0.f && y >= 0.f) {
+		const int cx = int(x / m_labelGridCellSize);
+		const int cy = int(y / m_labelGridCellSize);
+		if (cx < m_labelGridWidth && cy < m_labelGridHeight) {
+			cell = &m_labelGrid[cy * m_labelGridWidth + cx];
+			if (*cell >= 0 && m_labels.array[*cell]->Depth() <= z)
+				return;
+		}
+	}
+
+	const vector3f screenStarEdge = Graphics::ProjectToScreen(systrans * vector3f(0.25f, 0.f, 0.f), m_labelProjection, m_labelViewport);
+	float screenStarRadius = screenStarEdge.x - screenPos.x;
+	// work out the colour
+	Color labelColor = sys.GetFaction()->AdjustedColour(sys.GetPopulation(), shadow);
+	// get a system path to pass to the event handler when the label is clicked
+	SystemPath sysPath = sys.GetPath();
+	// label text
+	std::string text(sys.GetName());
+	auto label = std::make_unique<StarLabel>(m_labels, vector3f(x, y, z), labelColor, text, screenStarRadius, sysPath);
+
+	if (cell && *cell >= 0) {
+		m_labels.array[*cell] = std::move(label);
+	} else {
+		if (cell)
+			*cell = int(m_labels.array.size());
+		m_labels.array.emplace_back(std::move(label));
 	}
 }
 
@@ -862,7 +894,7 @@ void SectorMap::PutFactionLabels(const vector3f &origin)
 			if (pos.z < 0.0f) { // reject back-projected stars
 				pos.y = m_size.y - pos.y;
 
-				std::string factionHome = sys.GetName();
+				std::string factionHome(sys.GetName());
 				std::string factionName = (*it)->name;
 				Color labelColor = (*it)->colour;
 
@@ -912,6 +944,14 @@ void SectorMap::DrawNearSectors(const matrix4x4f &modelview)
 	PROFILE_SCOPED()
 	m_visibleFactions.clear();
 
+	m_labelProjection = m_context.renderer->GetProjection();
+	m_labelViewport = m_context.renderer->GetViewport();
+
+	m_labelGridCellSize = std::max(float(m_labels.fontSize), 4.f);
+	m_labelGridWidth = int(m_size.x / m_labelGridCellSize) + 1;
+	m_labelGridHeight = int(m_size.y / m_labelGridCellSize) + 1;
+	m_labelGrid.assign(m_labelGridWidth * m_labelGridHeight, -1);
+
 	for (int sx = -DRAW_RAD; sx <= DRAW_RAD; sx++) {
 		for (int sy = -DRAW_RAD; sy <= DRAW_RAD; sy++) {
 			for (int sz = -DRAW_RAD; sz <= DRAW_RAD; sz++) {
@@ -920,12 +960,32 @@ void SectorMap::DrawNearSectors(const matrix4x4f &modelview)
 			}
 		}
 	}
+
+	RequestPopulations();
+}
+
+void SectorMap::RequestPopulations()
+{
+	if (m_wantedSystems.empty())
+		return;
+
+	// nearest the centre of the view first, so the systems being looked at
+	// are filled in before those at the edges
+	std::sort(m_wantedSystems.begin(), m_wantedSystems.end(),
+		[](const std::pair<float, SystemPath> &a, const std::pair<float, SystemPath> &b) { return a.first < b.first; });
+	StarSystemCache::PathVector paths;
+	paths.reserve(m_wantedSystems.size());
+	for (const auto &wanted : m_wantedSystems) {
+		paths.push_back(wanted.second);
+		m_requestedSystems[wanted.second] = true;
+	}
+	m_wantedSystems.clear();
+	m_systemCache->FillCache(paths, StarSystemCache::CacheFilledCallback(), StarSystem::GENERATED_POPULATION);
 }
 
 void SectorMap::DrawNearSector(const int sx, const int sy, const int sz, const matrix4x4f &trans)
 {
 	PROFILE_SCOPED()
-	m_context.renderer->SetTransform(trans);
 	RefCountedPtr<Sector> ps = GetCached(SystemPath(sx, sy, sz));
 
 	const int cz = int(floor(m_pos.z + 0.5f));
@@ -987,16 +1047,19 @@ void SectorMap::DrawNearSector(const int sx, const int sy, const int sz, const m
 				fabs(m_posMovingTo.y - m_pos.y),
 				fabs(m_posMovingTo.z - m_pos.z));
 
-			// Ideally, since this takes so f'ing long, it wants to be done as a threaded job but haven't written that yet.
-			if ((diff.x < 0.001f && diff.y < 0.001f && diff.z < 0.001f)) {
-				SystemPath current = SystemPath(sx, sy, sz, sysIdx);
-				RefCountedPtr<StarSystem> pSS = m_context.galaxy->GetStarSystem(current);
+			// the systems are generated in the background, and their populations
+			// picked up here once they're ready
+			const SystemPath current = SystemPath(sx, sy, sz, sysIdx);
+			if (RefCountedPtr<StarSystem> pSS = m_systemCache->GetIfCached(current)) {
 				i->SetPopulation(pSS->GetTotalPop());
+				m_systemCache->Erase(current);
+				m_requestedSystems.erase(current);
+			} else if ((diff.x < 0.001f && diff.y < 0.001f && diff.z < 0.001f) && m_requestedSystems.find(current) == m_requestedSystems.end()) {
+				m_wantedSystems.emplace_back(toCentreOfView.LengthSqr(), current);
 			}
 		}
 
 		matrix4x4f systrans = trans * matrix4x4f::Translation(i->GetPosition().x, i->GetPosition().y, i->GetPosition().z);
-		m_context.renderer->SetTransform(systrans);
 
 		if ((m_drawVerticalLines && (i->GetPopulation() > 0 || m_drawUninhabitedLabels)) || !can_skip) {
 
@@ -1025,13 +1088,12 @@ void SectorMap::DrawNearSector(const int sx, const int sy, const int sz, const m
 		systrans.Rotate(DEG2RAD(-m_rotZ), 0, 0, 1);
 		systrans.Rotate(DEG2RAD(-m_rotX), 1, 0, 0);
 		systrans.Scale((StarSystem::starScale[(*i).GetStarType(0)]));
-		m_context.renderer->SetTransform(systrans);
 
 		const Uint8 *col = StarSystem::starColors[(*i).GetStarType(0)];
 		AddStarBillboard(systrans, vector3f(0.f), Color(col[0], col[1], col[2], 255), 0.5f);
 
 		// add label
-		if (!(showMode & m_context.HIDE_LABEL)) PutSystemLabel(*i, showMode & m_context.SHADOW_LABEL);
+		if (!(showMode & m_context.HIDE_LABEL)) PutSystemLabel(*i, systrans, showMode & m_context.SHADOW_LABEL, !can_skip);
 	}
 }
 
@@ -1239,6 +1301,19 @@ void SectorMap::ShrinkCache()
 			}
 		}
 
+		// and the systems generated for them, which would otherwise only be
+		// let go of when they're drawn
+		auto sysIter = m_systemCache->Begin();
+		while (sysIter != m_systemCache->End()) {
+			const SystemPath path = sysIter->first;
+			if (path.sectorX < xmin || path.sectorX > xmax || path.sectorY < ymin || path.sectorY > ymax || path.sectorZ < zmin || path.sectorZ > zmax) {
+				m_systemCache->Erase(sysIter++);
+				m_requestedSystems.erase(path);
+			} else {
+				sysIter++;
+			}
+		}
+
 		m_cacheXMin = xmin;
 		m_cacheXMax = xmax;
 		m_cacheYMin = ymin;
@@ -1261,9 +1336,9 @@ std::vector<SystemPath> SectorMap::GetNearbyStarSystemsByName(std::string patter
 			const Sector::System *ss = &((*i).second->m_systems[systemIndex]);
 
 			// compare with the start of the current system
-			if (strncasecmp(pattern.c_str(), ss->GetName().c_str(), pattern.size()) == 0
+			if (strncasecmp(pattern.c_str(), ss->GetName().data(), pattern.size()) == 0
 				// look for the pattern term somewhere within the current system
-				|| pi_strcasestr(ss->GetName().c_str(), pattern.c_str())) {
+				|| pi_strcasestr(ss->GetName().data(), pattern.c_str())) {
 				SystemPath match((*i).first);
 				match.systemIndex = systemIndex;
 				result.push_back(match);
@@ -1280,6 +1355,8 @@ std::vector<SystemPath> SectorMap::GetNearbyStarSystemsByName(std::string patter
 			}
 		}
 	}
+	// the cache is unordered, keep the results in a stable order
+	std::stable_sort(result.begin(), result.end(), SystemPath::LessSystemOnly());
 	return result;
 }
 
@@ -8,10 +8,12 @@
 #include "DeleteEmitter.h"
 #include "Input.h"
 #include "RefCounted.h"
+#include "core/FlatHashMap.h"
 #include "galaxy/Factions.h"
 #include "galaxy/Sector.h"
 #include "galaxy/SystemPath.h"
 #include "graphics/Drawables.h"
+#include "graphics/Graphics.h"
 #include "imgui/imgui.h"
 #include "imgui/imgui_internal.h"
 #include "SectorMapContext.h"
@@ -96,7 +98,7 @@ private:
 	void DrawNearSector(const int sx, const int sy, const int sz, const matrix4x4f &trans);
 	void DrawLabelsInternal(bool interactive, const ImVec2 &imagePos = { 0.0, 0.0 });
 	void PutSystemLabels(RefCountedPtr<Sector> sec, const vector3f &origin, int drawRadius);
-	void PutSystemLabel(const Sector::System &sys, bool shadow);
+	void PutSystemLabel(const Sector::System &sys, const matrix4x4f &systrans, bool shadow, bool always);
 
 	void DrawFarSectors(const matrix4x4f &modelview);
 	void BuildFarSector(RefCountedPtr<Sector> sec, const vector3f &origin, std::vector<vector3f> &points, std::vector<Color> &colors);
@@ -105,6 +107,8 @@ private:
 	void OnClickLabel(const SystemPath &path);
 
 	void ShrinkCache();
+	// asks for the populations of the systems drawn without one
+	void RequestPopulations();
 	void SetSelected(const SystemPath &path);
 
 	void MouseWheel(bool up);
@@ -141,6 +145,9 @@ private:
 	sigc::connection m_onViewReset;
 
 	RefCountedPtr<SectorCache::Slave> m_sectorCache;
+	RefCountedPtr<StarSystemCache::Slave> m_systemCache;
+	std::vector<std::pair<float, SystemPath>> m_wantedSystems; // with their distance squared from the view
+	FlatHashMap<SystemPath, bool, SystemPath::HashSystemOnly, SystemPath::EqualSystemOnly> m_requestedSystems;
 
 	std::vector<vector3f> m_farstars;
 	std::vector<Color> m_farstarsColor;
@@ -156,6 +163,17 @@ private:
 	int m_cacheZMin;
 	int m_cacheZMax;
 
+	// projection state captured once per near-sector pass, so labels can be
+	// placed without pushing a renderer transform for every system
+	matrix4x4f m_labelProjection;
+	Graphics::ViewportExtents m_labelViewport;
+	// screen-space grid of label anchors, each cell holding the index of the
+	// nearest star label in it (or -1) so coincident labels aren't all built
+	std::vector<int> m_labelGrid;
+	int m_labelGridWidth = 0;
+	int m_labelGridHeight = 0;
+	float m_labelGridCellSize = 1.f;
+
 	std::unique_ptr<ImDrawList> m_drawList;
 	std::unique_ptr<Graphics::RenderTarget> m_renderTarget;
 	ImVec2 m_size;
@@ -9,6 +9,7 @@
 #include "Input.h"
 #include "JsonFwd.h"
 
+#include "galaxy/RoutePlanner.h"
 #include "galaxy/SystemPath.h"
 #include "pigui/PiGuiView.h"
 
@@ -57,7 +58,10 @@ public:
 	bool RemoveRouteItem(const std::vector<SystemPath>::size_type element);
 	void ClearRoute();
 	std::vector<SystemPath> GetRoute();
-	const std::string AutoRoute(const SystemPath &start, const SystemPath &target, std::vector<SystemPath> &outRoute) const;
+	// Starts planning the quickest route from start to target in the
+	// background; the route replaces the current one once it's found.
+	std::string AutoRoute(const SystemPath &start, const SystemPath &target);
+	std::string GetAutoRouteStatus() const;
 	void SetDrawRouteLines(bool value);
 
 	sigc::signal<void> onHyperspaceTargetChanged;
@@ -85,6 +89,7 @@ private:
 	void SetSelected(const SystemPath &path);
 	void SetupLines(const vector3f &playerAbsPos, const matrix4x4f &trans);
 	void GetPlayerPosAndStarSize(vector3f &playerPosOut, float &currentStarSizeOut);
+	void OnAutoRouteFinished(RoutePlanner::Status status);
 
 	class SectorMapCallbacks;
 	SectorMapContext CreateMapContext();
@@ -105,10 +110,13 @@ private:
 	ConnectionTicket m_onWarpToCurrent;
 	ConnectionTicket m_onWarpToSelected;
 	ConnectionTicket m_onViewReset;
+	ConnectionTicket m_onAutoRouteFinished;
 
 	Game &m_game;
 	std::unique_ptr<SectorMap> m_map;
 	std::vector<SystemPath> m_route;
+	std::unique_ptr<RoutePlanner> m_routePlanner;
+	SystemPath m_autoRouteTarget;
 
 };
 
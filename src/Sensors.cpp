@@ -4,15 +4,21 @@
 #include "Sensors.h"
 #include "Body.h"
 #include "Game.h"
+#include "GameConfig.h"
 #include "HudTrail.h"
 #include "Pi.h"
 #include "Player.h"
 #include "Ship.h"
 #include "Space.h"
 
+#include <algorithm>
+#include <unordered_map>
+
+// sweeps per second when RadarSweepRate isn't usable
+static const float DEFAULT_SWEEP_RATE = 4.f;
+
 Sensors::RadarContact::RadarContact() :
 	body(0),
-	trail(0),
 	distance(0.0),
 	iff(IFF_UNKNOWN),
 	fresh(true)
@@ -21,17 +27,18 @@ Sensors::RadarContact::RadarContact() :
 
 Sensors::RadarContact::RadarContact(Body *b) :
 	body(b),
-	trail(0),
 	distance(0.0),
 	iff(IFF_UNKNOWN),
 	fresh(true)
 {
 }
 
+Sensors::RadarContact::RadarContact(RadarContact &&) = default;
+Sensors::RadarContact &Sensors::RadarContact::operator=(RadarContact &&) = default;
+
 Sensors::RadarContact::~RadarContact()
 {
 	body = 0;
-	delete trail;
 }
 
 Color Sensors::IFFColor(IFF iff)
@@ -51,9 +58,11 @@ bool Sensors::ContactDistanceSort(const RadarContact &a, const RadarContact &b)
 	return a.distance < b.distance;
 }
 
-Sensors::Sensors(Ship *owner)
+Sensors::Sensors(Ship *owner) :
+	m_owner(owner),
+	m_sweepTimer(0.f),
+	m_sweepSpace(nullptr)
 {
-	m_owner = owner;
 }
 
 Body* Sensors::ChooseTarget(TargetingCriteria crit, const Body* oldTarget )
@@ -62,33 +71,30 @@ Body* Sensors::ChooseTarget(TargetingCriteria crit, const Body* oldTarget )
 
 	if(!m_owner->IsType(ObjectType::PLAYER))
 		return nullptr;
-		
-	const Body* currTarget = oldTarget;
 
-	m_radarContacts.sort(ContactDistanceSort);
-
-	for (auto it = m_radarContacts.begin(); it != m_radarContacts.end(); ++it) {
-		//match object type
-		//match iff
-		if (it->body->IsType(ObjectType::SHIP)) {
-
-			if(crit == CYCLE_HOSTILE && currTarget) {
-				if(currTarget == it->body) {
-					currTarget = nullptr;
-					//next hostile will be selected
-				}
-				continue;
-			}
-
-			if (it->iff != IFF_HOSTILE) continue;
-			//should move the target to ship after all (from PlayerShipController)
-			//targeting inputs stay in PSC
-
-			return it->body;
+	// cycling picks the nearest hostile further away than the old target,
+	// so nothing is chosen if the old target isn't a contact any more
+	double minDistance = -1.0;
+	const RadarContact *oldContact = nullptr;
+	if (crit == CYCLE_HOSTILE && oldTarget) {
+		for (const RadarContact &rc : m_radarContacts) {
+			if (rc.body == oldTarget) oldContact = &rc;
 		}
+		if (!oldContact || !oldContact->body->IsType(ObjectType::SHIP))
+			return nullptr;
+		minDistance = oldContact->distance;
 	}
 
-	return nullptr;
+	// one pass for the nearest candidate instead of sorting every contact
+	const RadarContact *best = nullptr;
+	for (const RadarContact &rc : m_radarContacts) {
+		if (&rc == oldContact || !rc.body->IsType(ObjectType::SHIP) || rc.iff != IFF_HOSTILE) continue;
+		if (rc.distance < minDistance) continue;
+		if (!best || ContactDistanceSort(rc, *best))
+			best = &rc;
+	}
+
+	return best ? best->body : nullptr;
 }
 
 Sensors::IFF Sensors::CheckIFF(Body *other)
@@ -115,7 +121,71 @@ void Sensors::Update(float time)
 	PROFILE_SCOPED();
 	if (m_owner != Pi::player) return;
 
-	PopulateStaticContacts(); //no need to do all the time
+	const Space *space = Pi::game->GetSpace();
+
+	// a new space (e.g. after a hyperjump) invalidates everything we know
+	m_sweepTimer -= time;
+	const bool sweep = m_sweepTimer <= 0.f || space != m_sweepSpace;
+	if (sweep) {
+		const float rate = Pi::config->Float("RadarSweepRate");
+		m_sweepTimer = 1.f / (rate > 0.f ? rate : DEFAULT_SWEEP_RATE);
+		m_sweepSpace = space;
+		Sweep();
+	}
+
+	//update contacts and delete stale ones; between sweeps only contacts
+	//whose bodies have left space are dropped
+	auto stale = [&](const RadarContact &rc) {
+		return sweep ? !rc.fresh : !space->HasBody(rc.body) || rc.body->IsDead();
+	};
+	m_radarContacts.erase(std::remove_if(m_radarContacts.begin(), m_radarContacts.end(), stale), m_radarContacts.end());
+
+	// contacts share a handful of frames, so place the owner in each frame
+	// once rather than once per contact
+	m_ownerPositions.clear();
+	auto ownerPosIn = [&](FrameId frame) -> const vector3d & {
+		for (const auto &entry : m_ownerPositions) {
+			if (entry.first == frame) return entry.second;
+		}
+		m_ownerPositions.emplace_back(frame, m_owner->GetPositionRelTo(frame));
+		return m_ownerPositions.back().second;
+	};
+
+	// IFF is kept up to date by UpdateIFF() as relations and attacks change
+	for (RadarContact &rc : m_radarContacts) {
+		const Ship *ship = rc.body->IsType(ObjectType::SHIP) ? static_cast<Ship *>(rc.body) : nullptr;
+		if (ship && Ship::FLYING == ship->GetFlightState()) {
+			rc.distance = (ownerPosIn(rc.body->GetFrame()) - rc.body->GetPosition()).Length();
+			rc.trail->Update(time);
+		} else {
+			rc.trail->Reset(FrameId::Invalid);
+		}
+		if (sweep)
+			rc.fresh = false;
+	}
+
+	if (!sweep) {
+		m_staticContacts.erase(std::remove_if(m_staticContacts.begin(), m_staticContacts.end(),
+								   [&](const RadarContact &rc) { return !space->HasBody(rc.body); }),
+			m_staticContacts.end());
+	}
+}
+
+void Sensors::Sweep()
+{
+	PROFILE_SCOPED();
+	PopulateStaticContacts();
+
+	// contacts whose bodies are gone can't be dereferenced, drop them first
+	const Space *space = Pi::game->GetSpace();
+	m_radarContacts.erase(std::remove_if(m_radarContacts.begin(), m_radarContacts.end(),
+							  [&](const RadarContact &rc) { return !space->HasBody(rc.body); }),
+		m_radarContacts.end());
+
+	std::unordered_map<const Body *, size_t> known;
+	known.reserve(m_radarContacts.size());
+	for (size_t i = 0; i < m_radarContacts.size(); i++)
+		known[m_radarContacts[i].body] = i;
 
 	//Find nearby contacts, same range as radar scanner. It should use these
 	//contacts, worldview labels too.
@@ -124,41 +194,16 @@ void Sensors::Update(float time)
 		if (body == m_owner || !body->IsType(ObjectType::SHIP)) continue;
 		if (body->IsDead()) continue;
 
-		auto cit = m_radarContacts.begin();
-		while (cit != m_radarContacts.end()) {
-			if (cit->body == body) break;
-			++cit;
-		}
-
 		//create new contact or refresh old
-		if (cit == m_radarContacts.end()) {
-			m_radarContacts.push_back(RadarContact());
+		auto known_it = known.find(body);
+		if (known_it == known.end()) {
+			m_radarContacts.emplace_back();
 			RadarContact &rc = m_radarContacts.back();
 			rc.body = body;
 			rc.iff = CheckIFF(rc.body);
-			rc.trail = new HudTrail(rc.body, IFFColor(rc.iff));
-		} else {
-			cit->fresh = true;
-		}
-	}
-
-	//update contacts and delete stale ones
-	auto it = m_radarContacts.begin();
-	while (it != m_radarContacts.end()) {
-		if (!it->fresh) {
-			m_radarContacts.erase(it++);
+			rc.trail.reset(new HudTrail(rc.body, IFFColor(rc.iff)));
 		} else {
-			const Ship *ship = it->body->IsType(ObjectType::SHIP) ? static_cast<Ship *>(it->body) : nullptr;
-			if (ship && Ship::FLYING == ship->GetFlightState()) {
-				it->distance = m_owner->GetPositionRelTo(it->body).Length();
-				it->iff = CheckIFF(it->body);
-				it->trail->SetColor(IFFColor(it->iff));
-				it->trail->Update(time);
-			} else {
-				it->trail->Reset(FrameId::Invalid);
-			}
-			it->fresh = false;
-			++it;
+			m_radarContacts[known_it->second].fresh = true;
 		}
 	}
 }
@@ -168,8 +213,11 @@ void Sensors::UpdateIFF(Body *b)
 	PROFILE_SCOPED();
 	for (auto it = m_radarContacts.begin(); it != m_radarContacts.end(); ++it) {
 		if (it->body == b) {
-			it->iff = CheckIFF(b);
-			it->trail->SetColor(IFFColor(it->iff));
+			const IFF iff = CheckIFF(b);
+			if (iff != it->iff) {
+				it->iff = iff;
+				it->trail->SetColor(IFFColor(iff));
+			}
 		}
 	}
 }
@@ -195,7 +243,7 @@ void Sensors::PopulateStaticContacts()
 		default:
 			continue;
 		}
-		m_staticContacts.push_back(RadarContact(b));
+		m_staticContacts.emplace_back(b);
 		RadarContact &rc = m_staticContacts.back();
 		rc.fresh = true;
 	}
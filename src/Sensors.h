@@ -8,16 +8,20 @@
  * and handles IFF
  * Some ideas:
  *  - targeting should be lost when going out of range
- *  - don't run radar sweep every frame (more of an optimization than simulation)
+ *  - the radar sweep runs at RadarSweepRate (Hz); contact distances and trails
+ *    are still refreshed every frame in between
  *  - allow "pinned" radar contacts (visible at all ranges, for missions)
  */
 #include "Body.h"
 
-#include <list>
+#include <memory>
+#include <utility>
+#include <vector>
 
 class Body;
 class HudTrail;
 class Ship;
+class Space;
 
 class Sensors {
 public:
@@ -36,15 +40,17 @@ public:
 	struct RadarContact {
 		RadarContact();
 		RadarContact(Body *);
+		RadarContact(RadarContact &&);
+		RadarContact &operator=(RadarContact &&);
 		~RadarContact();
 		Body *body;
-		HudTrail *trail;
+		std::unique_ptr<HudTrail> trail;
 		double distance;
 		IFF iff;
 		bool fresh;
 	};
 
-	typedef std::list<RadarContact> ContactList;
+	typedef std::vector<RadarContact> ContactList;
 
 	static Color IFFColor(IFF);
 	static bool ContactDistanceSort(const RadarContact &a, const RadarContact &b);
@@ -52,6 +58,7 @@ public:
 	Sensors(Ship *owner);
 	Body* ChooseTarget(TargetingCriteria, const Body* oldTarget);
 	IFF CheckIFF(Body *other);
+	// the contact lists are in no particular order
 	const ContactList &GetContacts() { return m_radarContacts; }
 	const ContactList &GetStaticContacts() { return m_staticContacts; }
 	void Update(float time);
@@ -63,6 +70,11 @@ private:
 	ContactList m_radarContacts;
 	ContactList m_staticContacts; //things we know of regardless of range
 
+	float m_sweepTimer;
+	const Space *m_sweepSpace;
+	std::vector<std::pair<FrameId, vector3d>> m_ownerPositions; // scratch for Update()
+
+	void Sweep();
 	void PopulateStaticContacts();
 };
 
@@ -14,6 +14,7 @@
 #include "ServerAgent.h"
 #include "StringF.h"
 #include <curl/curl.h>
+#include <algorithm>
 
 void NullServerAgent::Call(const std::string &method, const Json &data, SuccessCallback onSuccess, FailCallback onFail, void *userdata)
 {
@@ -31,28 +32,29 @@ void NullServerAgent::ProcessResponses()
 
 bool HTTPServerAgent::s_initialised = false;
 
-HTTPServerAgent::HTTPServerAgent(const std::string &endpoint) :
-	m_endpoint(endpoint)
+HTTPServerAgent::HTTPServerAgent(const std::string &endpoint, int maxInFlight) :
+	m_endpoint(endpoint),
+	m_maxInFlight(std::max(maxInFlight, 1)),
+	m_quit(false),
+	m_completed(0),
+	m_failed(0),
+	m_totalLatencyMs(0.0),
+	m_maxLatencyMs(0.0),
+	m_statsInFlight(0)
 {
 	if (!s_initialised)
 		curl_global_init(CURL_GLOBAL_ALL);
 
-	m_curl = curl_easy_init();
-	//curl_easy_setopt(m_curl, CURLOPT_VERBOSE, 1);
-
-	curl_easy_setopt(m_curl, CURLOPT_POST, 1);
-
-	curl_easy_setopt(m_curl, CURLOPT_READFUNCTION, HTTPServerAgent::FillRequestBuffer);
-	curl_easy_setopt(m_curl, CURLOPT_WRITEFUNCTION, HTTPServerAgent::FillResponseBuffer);
+	m_curlMulti = curl_multi_init();
+	// share connections between requests, over HTTP/2 where the server has it
+	curl_multi_setopt(m_curlMulti, CURLMOPT_PIPELINING, long(CURLPIPE_MULTIPLEX));
+	curl_multi_setopt(m_curlMulti, CURLMOPT_MAX_HOST_CONNECTIONS, long(m_maxInFlight));
 
 	m_curlHeaders = 0;
 	m_curlHeaders = curl_slist_append(m_curlHeaders, ("User-agent: " + UserAgent()).c_str());
 	m_curlHeaders = curl_slist_append(m_curlHeaders, "Content-type: application/json");
-	curl_easy_setopt(m_curl, CURLOPT_HTTPHEADER, m_curlHeaders);
 
 	m_requestQueueLock = SDL_CreateMutex();
-	m_requestQueueCond = SDL_CreateCond();
-
 	m_responseQueueLock = SDL_CreateMutex();
 
 	m_thread = SDL_CreateThread(&HTTPServerAgent::ThreadEntry, "HTTPServerAgent", this);
@@ -60,29 +62,29 @@ HTTPServerAgent::HTTPServerAgent(const std::string &endpoint) :
 
 HTTPServerAgent::~HTTPServerAgent()
 {
-	// flush the queue
+	// stop the thread; requests still queued are dropped
 	SDL_LockMutex(m_requestQueueLock);
-	while (m_requestQueue.size() > 0)
-		m_requestQueue.pop();
+	m_quit = true;
 	SDL_UnlockMutex(m_requestQueueLock);
+	curl_multi_wakeup(m_curlMulti);
+	SDL_WaitThread(m_thread, 0);
+
+	// abandon the requests still on their way
+	for (CURL *curl : m_activeHandles) {
+		char *transfer;
+		curl_easy_getinfo(curl, CURLINFO_PRIVATE, &transfer);
+		delete reinterpret_cast<Transfer *>(transfer);
+		curl_multi_remove_handle(m_curlMulti, curl);
+		curl_easy_cleanup(curl);
+	}
+	for (CURL *curl : m_idleHandles)
+		curl_easy_cleanup(curl);
+	curl_multi_cleanup(m_curlMulti);
 
-	// signal the thread. empty queue will cause it to exit
-	SDL_CondBroadcast(m_requestQueueCond);
-
-	// first thing the queue does is check the queue, so we must
-	// not shut down until its done that. it will release the queue
-	// lock before it dies, so try to take it
-	SDL_LockMutex(m_requestQueueLock);
-
-	// we have the lock, so we know the thread won't doing anything
-	// else. we can clean up now
 	SDL_DestroyMutex(m_responseQueueLock);
 	SDL_DestroyMutex(m_requestQueueLock);
-	SDL_DestroyCond(m_requestQueueCond);
 
 	curl_slist_free_all(m_curlHeaders);
-
-	curl_easy_cleanup(m_curl);
 }
 
 void HTTPServerAgent::Call(const std::string &method, const Json &data, SuccessCallback onSuccess, FailCallback onFail, void *userdata)
@@ -91,7 +93,8 @@ void HTTPServerAgent::Call(const std::string &method, const Json &data, SuccessC
 	m_requestQueue.push(Request(method, data, onSuccess, onFail, userdata));
 	SDL_UnlockMutex(m_requestQueueLock);
 
-	SDL_CondBroadcast(m_requestQueueCond);
+	// the thread may be waiting on its transfers
+	curl_multi_wakeup(m_curlMulti);
 }
 
 void HTTPServerAgent::ProcessResponses()
@@ -118,6 +121,25 @@ void HTTPServerAgent::ProcessResponses()
 	}
 }
 
+HTTPServerAgent::Stats HTTPServerAgent::GetStats() const
+{
+	Stats stats;
+
+	SDL_LockMutex(m_requestQueueLock);
+	stats.queued = Uint32(m_requestQueue.size());
+	SDL_UnlockMutex(m_requestQueueLock);
+
+	SDL_LockMutex(m_responseQueueLock);
+	stats.inFlight = m_statsInFlight;
+	stats.completed = m_completed;
+	stats.failed = m_failed;
+	stats.meanLatencyMs = m_completed ? m_totalLatencyMs / double(m_completed) : 0.0;
+	stats.maxLatencyMs = m_maxLatencyMs;
+	SDL_UnlockMutex(m_responseQueueLock);
+
+	return stats;
+}
+
 int HTTPServerAgent::ThreadEntry(void *data)
 {
 	reinterpret_cast<HTTPServerAgent *>(data)->ThreadMain();
@@ -127,76 +149,119 @@ int HTTPServerAgent::ThreadEntry(void *data)
 void HTTPServerAgent::ThreadMain()
 {
 	while (1) {
-
-		// look for requests
 		SDL_LockMutex(m_requestQueueLock);
+		const bool quit = m_quit;
+		SDL_UnlockMutex(m_requestQueueLock);
+		if (quit)
+			return;
 
-		// if there's no requests, wait until the main thread wakes us
-		if (m_requestQueue.empty())
-			SDL_CondWait(m_requestQueueCond, m_requestQueueLock);
+		StartTransfers();
 
-		// woken up but nothing on the queue means we're being destroyed
-		if (m_requestQueue.empty()) {
-			// main thread is waiting for this lock, and will start
-			// cleanup as soon as it has it
-			SDL_UnlockMutex(m_requestQueueLock);
+		int running;
+		curl_multi_perform(m_curlMulti, &running);
 
-			// might be cleaned up already, so don't do anything else,
-			// just get out of here
-			return;
+		int pending;
+		while (CURLMsg *msg = curl_multi_info_read(m_curlMulti, &pending)) {
+			if (msg->msg == CURLMSG_DONE)
+				FinishTransfer(msg->easy_handle, msg->data.result);
 		}
 
-		// grab a request
-		Request req = m_requestQueue.front();
-		m_requestQueue.pop();
+		// sleep until a transfer has something to do or Call() wakes us
+		curl_multi_poll(m_curlMulti, 0, 0, 1000, 0);
+	}
+}
 
-		// done with the queue
+void HTTPServerAgent::StartTransfers()
+{
+	while (int(m_activeHandles.size()) < m_maxInFlight) {
+		SDL_LockMutex(m_requestQueueLock);
+		if (m_requestQueue.empty()) {
+			SDL_UnlockMutex(m_requestQueueLock);
+			break;
+		}
+		Transfer *transfer = new Transfer(m_requestQueue.front());
+		m_requestQueue.pop();
 		SDL_UnlockMutex(m_requestQueueLock);
 
 		Json::FastWriter writer;
-		req.buffer = writer.write(req.data);
+		transfer->req.buffer = writer.write(transfer->req.data);
+		transfer->url = m_endpoint + "/" + transfer->req.method;
+
+		CURL *curl;
+		if (!m_idleHandles.empty()) {
+			curl = m_idleHandles.back();
+			m_idleHandles.pop_back();
+		} else {
+			curl = curl_easy_init();
+			//curl_easy_setopt(curl, CURLOPT_VERBOSE, 1);
+			curl_easy_setopt(curl, CURLOPT_POST, 1);
+			curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, HTTPServerAgent::FillResponseBuffer);
+			curl_easy_setopt(curl, CURLOPT_HTTPHEADER, m_curlHeaders);
+			curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+			// wait for a connection that can be multiplexed rather than opening another
+			curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+		}
 
-		Response resp(req.onSuccess, req.onFail, req.userdata);
+		curl_easy_setopt(curl, CURLOPT_URL, transfer->url.c_str());
+		curl_easy_setopt(curl, CURLOPT_POSTFIELDS, transfer->req.buffer.data());
+		curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, long(transfer->req.buffer.size()));
+		curl_easy_setopt(curl, CURLOPT_WRITEDATA, &transfer->resp);
+		curl_easy_setopt(curl, CURLOPT_PRIVATE, transfer);
 
-		curl_easy_setopt(m_curl, CURLOPT_URL, std::string(m_endpoint + "/" + req.method).c_str());
-		curl_easy_setopt(m_curl, CURLOPT_POSTFIELDSIZE, req.buffer.size());
-		curl_easy_setopt(m_curl, CURLOPT_READDATA, &req);
-		curl_easy_setopt(m_curl, CURLOPT_WRITEDATA, &resp);
+		curl_multi_add_handle(m_curlMulti, curl);
+		m_activeHandles.push_back(curl);
+	}
 
-		CURLcode rc = curl_easy_perform(m_curl);
-		resp.success = rc == CURLE_OK;
-		if (!resp.success)
-			resp.buffer = std::string("call failed: " + std::string(curl_easy_strerror(rc)));
-
-		if (resp.success) {
-			uint32_t code;
-			curl_easy_getinfo(m_curl, CURLINFO_RESPONSE_CODE, &code);
-			if (code != 200) {
-				resp.success = false;
-				resp.buffer = stringf("call returned HTTP status: %0{d}", code);
-			}
-		}
+	SDL_LockMutex(m_responseQueueLock);
+	m_statsInFlight = Uint32(m_activeHandles.size());
+	SDL_UnlockMutex(m_responseQueueLock);
+}
 
-		if (resp.success) {
-			Json::Reader reader;
-			resp.success = reader.parse(resp.buffer, resp.data, false);
-			if (!resp.success)
-				resp.buffer = std::string("JSON parse error: " + reader.getFormattedErrorMessages());
+void HTTPServerAgent::FinishTransfer(CURL *curl, CURLcode rc)
+{
+	char *privateData;
+	curl_easy_getinfo(curl, CURLINFO_PRIVATE, &privateData);
+	Transfer *transfer = reinterpret_cast<Transfer *>(privateData);
+	Response &resp = transfer->resp;
+
+	resp.success = rc == CURLE_OK;
+	if (!resp.success)
+		resp.buffer = std::string("call failed: " + std::string(curl_easy_strerror(rc)));
+
+	if (resp.success) {
+		long code;
+		curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
+		if (code != 200) {
+			resp.success = false;
+			resp.buffer = stringf("call returned HTTP status: %0{d}", int(code));
 		}
+	}
 
-		SDL_LockMutex(m_responseQueueLock);
-		m_responseQueue.push(resp);
-		SDL_UnlockMutex(m_responseQueueLock);
+	if (resp.success) {
+		Json::Reader reader;
+		resp.success = reader.parse(resp.buffer, resp.data, false);
+		if (!resp.success)
+			resp.buffer = std::string("JSON parse error: " + reader.getFormattedErrorMessages());
 	}
-}
 
-size_t HTTPServerAgent::FillRequestBuffer(char *ptr, size_t size, size_t nmemb, void *userdata)
-{
-	HTTPServerAgent::Request *req = reinterpret_cast<HTTPServerAgent::Request *>(userdata);
-	size_t amount = std::max(size * nmemb, req->buffer.size());
-	memcpy(ptr, req->buffer.data(), amount);
-	req->buffer.erase(0, amount);
-	return amount;
+	// keep the handle, and with it the connection, for the next request
+	curl_multi_remove_handle(m_curlMulti, curl);
+	m_activeHandles.erase(std::find(m_activeHandles.begin(), m_activeHandles.end(), curl));
+	m_idleHandles.push_back(curl);
+
+	const double latencyMs = double(SDL_GetPerformanceCounter() - transfer->req.queuedTime) * 1000.0 / double(SDL_GetPerformanceFrequency());
+
+	SDL_LockMutex(m_responseQueueLock);
+	m_responseQueue.push(resp);
+	m_completed++;
+	if (!resp.success)
+		m_failed++;
+	m_totalLatencyMs += latencyMs;
+	m_maxLatencyMs = std::max(m_maxLatencyMs, latencyMs);
+	m_statsInFlight = Uint32(m_activeHandles.size());
+	SDL_UnlockMutex(m_responseQueueLock);
+
+	delete transfer;
 }
 
 size_t HTTPServerAgent::FillResponseBuffer(char *ptr, size_t size, size_t nmemb, void *userdata)
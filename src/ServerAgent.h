@@ -10,6 +10,7 @@
 #include <json/json.h>
 #include <map>
 #include <queue>
+#include <vector>
 
 class ServerAgent {
 public:
@@ -47,15 +48,34 @@ private:
 	std::queue<Response> m_queue;
 };
 
+// Sends calls from a worker thread through a curl multi handle, so up to
+// maxInFlight requests are in progress at once and a slow call doesn't hold
+// up the ones queued behind it. Easy handles are kept for reuse, which keeps
+// their connections to the server open between calls, and HTTP/2 servers get
+// all the requests multiplexed over one connection.
 class HTTPServerAgent : public ServerAgent {
 public:
-	HTTPServerAgent(const std::string &endpoint);
+	static const int DEFAULT_MAX_IN_FLIGHT = 8;
+
+	struct Stats {
+		Uint32 queued; // waiting for a free slot
+		Uint32 inFlight;
+		Uint64 completed;
+		Uint64 failed;
+		// from Call() to the response arriving, over all completed calls
+		double meanLatencyMs;
+		double maxLatencyMs;
+	};
+
+	HTTPServerAgent(const std::string &endpoint, int maxInFlight = DEFAULT_MAX_IN_FLIGHT);
 	virtual ~HTTPServerAgent();
 
 	virtual void Call(const std::string &method, const Json &data, SuccessCallback onSuccess = sigc::ptr_fun(&ServerAgent::IgnoreSuccessCallback), FailCallback onFail = sigc::ptr_fun(&ServerAgent::IgnoreFailCallback), void *userdata = 0);
 
 	virtual void ProcessResponses();
 
+	Stats GetStats() const;
+
 private:
 	struct Request {
 		Request(const std::string &_method, const Json &_data, SuccessCallback _onSuccess, FailCallback _onFail, void *_userdata) :
@@ -63,7 +83,8 @@ private:
 			data(_data),
 			onSuccess(_onSuccess),
 			onFail(_onFail),
-			userdata(_userdata) {}
+			userdata(_userdata),
+			queuedTime(SDL_GetPerformanceCounter()) {}
 
 		const std::string method;
 		const Json data;
@@ -74,6 +95,8 @@ private:
 		FailCallback onFail;
 
 		void *userdata;
+
+		Uint64 queuedTime;
 	};
 
 	struct Response {
@@ -95,29 +118,53 @@ private:
 		void *userdata;
 	};
 
+	// a request on its way, found from its easy handle through CURLOPT_PRIVATE
+	struct Transfer {
+		Transfer(const Request &_req) :
+			req(_req),
+			resp(_req.onSuccess, _req.onFail, _req.userdata) {}
+
+		Request req;
+		Response resp;
+		std::string url;
+	};
+
 	static int ThreadEntry(void *data);
 	void ThreadMain();
 
+	void StartTransfers();
+	void FinishTransfer(CURL *curl, CURLcode rc);
+
 	static const std::string &UserAgent();
 
-	static size_t FillRequestBuffer(char *ptr, size_t size, size_t nmemb, void *userdata);
 	static size_t FillResponseBuffer(char *ptr, size_t size, size_t nmemb, void *userdata);
 
 	static bool s_initialised;
 
 	const std::string m_endpoint;
+	const int m_maxInFlight;
 
 	SDL_Thread *m_thread;
+	bool m_quit; // under m_requestQueueLock
 
-	CURL *m_curl;
+	// only touched by the worker once it's started
+	CURLM *m_curlMulti;
 	curl_slist *m_curlHeaders;
+	std::vector<CURL *> m_activeHandles;
+	std::vector<CURL *> m_idleHandles;
 
 	std::queue<Request> m_requestQueue;
 	SDL_mutex *m_requestQueueLock;
-	SDL_cond *m_requestQueueCond;
 
 	std::queue<Response> m_responseQueue;
 	SDL_mutex *m_responseQueueLock;
+
+	// under m_responseQueueLock
+	Uint64 m_completed;
+	Uint64 m_failed;
+	double m_totalLatencyMs;
+	double m_maxLatencyMs;
+	Uint32 m_statsInFlight;
 };
 
 #endif
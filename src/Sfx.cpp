@@ -23,6 +23,9 @@
 #include "graphics/VertexArray.h"
 #include "matrix4x4.h"
 
+#include <algorithm>
+#include <vector>
+
 using namespace Graphics;
 
 namespace {
@@ -34,7 +37,7 @@ namespace {
 		return (size * Graphics::GetFovFactor()) * pixrad;
 	}
 
-	float GetParticleSpeed(SFX_TYPE t, const vector3f &pos, const Sfx &inst)
+	float GetParticleSpeed(SFX_TYPE t, const vector3f &pos, const Sfx &inst, const float age)
 	{
 		switch (t) {
 		case TYPE_NONE: assert(false);
@@ -43,7 +46,7 @@ namespace {
 		case TYPE_DAMAGE:
 			return SizeToPixels(pos, 20.f);
 		case TYPE_SMOKE:
-			return Clamp(SizeToPixels(pos, (inst.m_speed * inst.m_age)), 0.1f, 50.0f);
+			return Clamp(SizeToPixels(pos, (inst.m_speed * age)), 0.1f, 50.0f);
 		default:
 			return 0.f;
 		}
@@ -56,78 +59,64 @@ std::unique_ptr<Graphics::Material> SfxManager::smokeParticle;
 std::unique_ptr<Graphics::Material> SfxManager::explosionParticle;
 SfxManager::MaterialData SfxManager::m_materialData[TYPE_NONE];
 
-Sfx::Sfx(const vector3d &pos, const vector3d &vel, const float speed, const SFX_TYPE type) :
+Sfx::Sfx(const vector3d &pos, const vector3d &vel, const float speed, const SFX_TYPE type, const double time) :
 	m_pos(pos),
 	m_vel(vel),
-	m_age(0.0f),
+	m_birth(time),
 	m_speed(speed),
 	m_type(type)
 {
 }
 
-Sfx::Sfx(const Json &jsonObj)
+Sfx::Sfx(const Json &jsonObj, const double time) :
+	m_speed(200.0f)
 {
 	try {
 		Json sfxObj = jsonObj["sfx"];
 
-		m_pos = sfxObj["pos"];
+		// saved as where it is now and how old it is
+		const vector3d pos = sfxObj["pos"];
+		const float age = sfxObj["age"];
 		m_vel = sfxObj["vel"];
-		m_age = sfxObj["age"];
 		m_type = sfxObj["type"];
+		m_birth = time - age;
+		m_pos = pos - m_vel * double(age);
 	} catch (Json::type_error &) {
 		throw SavedGameCorruptException();
 	}
 }
 
-void Sfx::SaveToJson(Json &jsonObj)
+void Sfx::SaveToJson(Json &jsonObj, const double time) const
 {
 	Json sfxObj({}); // Create JSON object to contain sfx data.
 
-	sfxObj["pos"] = m_pos;
+	sfxObj["pos"] = GetPosition(time);
 	sfxObj["vel"] = m_vel;
-	sfxObj["age"] = m_age;
+	sfxObj["age"] = GetAge(time);
 	sfxObj["type"] = m_type;
 
 	jsonObj["sfx"] = sfxObj; // Add sfx object to supplied object.
 }
 
-void Sfx::SetPosition(const vector3d &p)
-{
-	m_pos = p;
-}
-
-void Sfx::TimeStepUpdate(const float timeStep)
+float Sfx::GetLifetime(const SFX_TYPE type)
 {
-	PROFILE_SCOPED()
-	m_age += timeStep;
-	m_pos += m_vel * double(timeStep);
-
-	switch (m_type) {
-	case TYPE_EXPLOSION:
-		if (m_age > 3.2) m_type = TYPE_NONE;
-		break;
-	case TYPE_DAMAGE:
-		if (m_age > 2.0) m_type = TYPE_NONE;
-		break;
-	case TYPE_SMOKE:
-		if (m_age > 8.0) m_type = TYPE_NONE;
-		break;
-	case TYPE_NONE: break;
+	switch (type) {
+	case TYPE_EXPLOSION: return 3.2f;
+	case TYPE_DAMAGE: return 2.0f;
+	case TYPE_SMOKE: return 8.0f;
+	case TYPE_NONE: return 0.0f;
 	}
+	return 0.0f;
 }
 
-float Sfx::AgeBlend() const
+float Sfx::AgeBlend(const float age) const
 {
-	switch (m_type) {
-	case TYPE_EXPLOSION: return (3.2 - m_age) / 3.2;
-	case TYPE_DAMAGE: return (2.0 - m_age) / 2.0;
-	case TYPE_SMOKE: return (8.0 - m_age) / 8.0;
-	case TYPE_NONE: return 0.0f;
-	}
-	return 0.0f;
+	const float lifetime = GetLifetime(m_type);
+	return lifetime > 0.0f ? (lifetime - age) / lifetime : 0.0f;
 }
 
-SfxManager::SfxManager()
+SfxManager::SfxManager() :
+	m_time(0.0)
 {
 	for (size_t t = 0; t < TYPE_NONE; t++) {
 		m_instances[t].clear();
@@ -142,12 +131,10 @@ void SfxManager::ToJson(Json &jsonObj, const FrameId fId)
 	if (f->m_sfx) {
 		for (size_t t = TYPE_EXPLOSION; t < TYPE_NONE; t++) {
 			for (size_t i = 0; i < f->m_sfx->GetNumberInstances(SFX_TYPE(t)); i++) {
-				Sfx &inst(f->m_sfx->GetInstanceByIndex(SFX_TYPE(t), i));
-				if (inst.m_type != TYPE_NONE) {
-					Json sfxArrayEl({}); // Create JSON object to contain sfx element.
-					inst.SaveToJson(sfxArrayEl);
-					sfxArray.push_back(sfxArrayEl); // Append sfx object to array.
-				}
+				const Sfx &inst(f->m_sfx->GetInstanceByIndex(SFX_TYPE(t), i));
+				Json sfxArrayEl({}); // Create JSON object to contain sfx element.
+				inst.SaveToJson(sfxArrayEl, f->m_sfx->GetTime());
+				sfxArray.push_back(sfxArrayEl); // Append sfx object to array.
 			}
 		}
 	}
@@ -161,11 +148,25 @@ void SfxManager::FromJson(const Json &jsonObj, FrameId fId)
 
 	Frame *f = Frame::GetFrame(fId);
 
-	if (sfxArray.size()) f->m_sfx.reset(new SfxManager);
+	if (!sfxArray.size())
+		return;
+
+	f->m_sfx.reset(new SfxManager);
+	std::vector<Sfx> instances;
 	for (unsigned int i = 0; i < sfxArray.size(); ++i) {
-		Sfx inst(sfxArray[i]);
-		f->m_sfx->AddInstance(inst);
+		Sfx inst(sfxArray[i], f->m_sfx->GetTime());
+		if (inst.m_type > TYPE_NONE || inst.m_type < TYPE_EXPLOSION)
+			throw SavedGameCorruptException();
+		instances.push_back(inst);
 	}
+
+	// the queues must be in spawning order
+	std::stable_sort(instances.begin(), instances.end(), [](const Sfx &a, const Sfx &b) {
+		return a.m_birth < b.m_birth;
+	});
+	for (const Sfx &inst : instances)
+		if (inst.m_type != TYPE_NONE)
+			f->m_sfx->AddInstance(inst);
 }
 
 SfxManager *SfxManager::AllocSfxInFrame(FrameId fId)
@@ -180,12 +181,17 @@ SfxManager *SfxManager::AllocSfxInFrame(FrameId fId)
 }
 
 void SfxManager::Add(const Body *b, SFX_TYPE t)
+{
+	Add(b->GetFrame(), b->GetPosition(), b->GetVelocity(), t);
+}
+
+void SfxManager::Add(FrameId fId, const vector3d &pos, const vector3d &vel, SFX_TYPE t)
 {
 	assert(t != TYPE_NONE);
-	SfxManager *sfxman = AllocSfxInFrame(b->GetFrame());
+	SfxManager *sfxman = AllocSfxInFrame(fId);
 	if (!sfxman) return;
-	vector3d vel(b->GetVelocity() + 200.0 * vector3d(Pi::rng.Double() - 0.5, Pi::rng.Double() - 0.5, Pi::rng.Double() - 0.5));
-	Sfx sfx(b->GetPosition(), vel, 200, t);
+	vector3d sfxVel(vel + 200.0 * vector3d(Pi::rng.Double() - 0.5, Pi::rng.Double() - 0.5, Pi::rng.Double() - 0.5));
+	Sfx sfx(pos, sfxVel, 200, t, sfxman->GetTime());
 	sfxman->AddInstance(sfx);
 }
 
@@ -199,7 +205,7 @@ void SfxManager::AddExplosion(Body *b)
 		ModelBody *mb = static_cast<ModelBody *>(b);
 		speed = mb->GetAabb().radius * 8.0;
 	}
-	Sfx sfx(b->GetPosition(), b->GetVelocity(), speed, TYPE_EXPLOSION);
+	Sfx sfx(b->GetPosition(), b->GetVelocity(), speed, TYPE_EXPLOSION, sfxman->GetTime());
 	sfxman->AddInstance(sfx);
 }
 
@@ -208,7 +214,7 @@ void SfxManager::AddThrustSmoke(const Body *b, const float speed, const vector3d
 	SfxManager *sfxman = AllocSfxInFrame(b->GetFrame());
 	if (!sfxman) return;
 
-	Sfx sfx(b->GetPosition() + adjustpos, vector3d(0, 0, 0), speed, TYPE_SMOKE);
+	Sfx sfx(b->GetPosition() + adjustpos, vector3d(0, 0, 0), speed, TYPE_SMOKE, sfxman->GetTime());
 	sfxman->AddInstance(sfx);
 }
 
@@ -218,13 +224,9 @@ void SfxManager::TimeStepAll(const float timeStep, FrameId fId)
 
 	Frame *f = Frame::GetFrame(fId);
 
+	// particles only need their clock moved on; where they are follows from that
 	if (f->m_sfx) {
-		for (size_t t = TYPE_EXPLOSION; t < TYPE_NONE; t++) {
-			for (size_t i = 0; i < f->m_sfx->GetNumberInstances(SFX_TYPE(t)); i++) {
-				Sfx &inst(f->m_sfx->GetInstanceByIndex(SFX_TYPE(t), i));
-				inst.TimeStepUpdate(timeStep);
-			}
-		}
+		f->m_sfx->m_time += timeStep;
 		f->m_sfx->Cleanup();
 	}
 
@@ -236,16 +238,11 @@ void SfxManager::TimeStepAll(const float timeStep, FrameId fId)
 void SfxManager::Cleanup()
 {
 	for (size_t t = TYPE_EXPLOSION; t < TYPE_NONE; t++) {
-		const size_t numInstances = GetNumberInstances(SFX_TYPE(t));
-		if (!numInstances)
-			continue;
-
-		for (Sint64 i = Sint64(numInstances - 1); i >= 0; i--) {
-			Sfx &inst(GetInstanceByIndex(SFX_TYPE(t), i));
-			if (inst.m_type == TYPE_NONE) {
-				m_instances[t].erase(m_instances[t].begin() + i);
-			}
-		}
+		// the oldest are at the front
+		const float lifetime = Sfx::GetLifetime(SFX_TYPE(t));
+		std::deque<Sfx> &instances = m_instances[t];
+		while (!instances.empty() && instances.front().GetAge(m_time) > lifetime)
+			instances.pop_front();
 	}
 }
 
@@ -255,6 +252,7 @@ void SfxManager::RenderAll(Renderer *renderer, FrameId fId, FrameId camFrameId)
 
 	PROFILE_SCOPED()
 	if (f->m_sfx) {
+		const double time = f->m_sfx->GetTime();
 		matrix4x4d ftran;
 		Frame::GetFrameTransform(fId, camFrameId, ftran);
 
@@ -286,10 +284,11 @@ void SfxManager::RenderAll(Renderer *renderer, FrameId fId, FrameId camFrameId)
 				assert(inst.m_type == t);
 
 				// make the particle position relative to the camera frame
-				const vector3f pos(ftran * inst.m_pos);
+				const vector3f pos(ftran * inst.GetPosition(time));
 				// pack UV offset and particle size in normal attribute
-				const vector2f offset = CalculateOffset(SFX_TYPE(t), inst);
-				const float speed = GetParticleSpeed(SFX_TYPE(t), pos, inst);
+				const float age = inst.GetAge(time);
+				const vector2f offset = CalculateOffset(SFX_TYPE(t), inst, age);
+				const float speed = GetParticleSpeed(SFX_TYPE(t), pos, inst, age);
 
 				pointArray.Add(pos, vector3f(offset, Clamp(speed, 0.1f, FLT_MAX)));
 			}
@@ -304,10 +303,10 @@ void SfxManager::RenderAll(Renderer *renderer, FrameId fId, FrameId camFrameId)
 	}
 }
 
-vector2f SfxManager::CalculateOffset(const enum SFX_TYPE type, const Sfx &inst)
+vector2f SfxManager::CalculateOffset(const enum SFX_TYPE type, const Sfx &inst, const float age)
 {
 	if (m_materialData[type].effect == Graphics::EFFECT_BILLBOARD_ATLAS) {
-		const int spriteframe = inst.AgeBlend() * (m_materialData[type].num_textures - 1);
+		const int spriteframe = inst.AgeBlend(age) * (m_materialData[type].num_textures - 1);
 		const Sint32 numImgsWide = m_materialData[type].num_imgs_wide;
 		const int u = (spriteframe % numImgsWide); // % is the "modulo operator", the remainder of i / width;
 		const int v = (spriteframe / numImgsWide); // where "/" is an integer division
@@ -24,22 +24,26 @@ enum SFX_TYPE {
 	TYPE_NONE
 };
 
+// Particles move in a straight line from where they were spawned, so their
+// state at any time follows from the time they were spawned at and nothing
+// needs stepping each frame; see SfxManager::TimeStepAll.
 struct Sfx {
 	Sfx() = delete;
-	Sfx(const vector3d &pos, const vector3d &vel, const float speed, const SFX_TYPE type);
-	Sfx(const Json &jsonObj);
+	Sfx(const vector3d &pos, const vector3d &vel, const float speed, const SFX_TYPE type, const double time);
+	Sfx(const Json &jsonObj, const double time);
 
-	const vector3d &GetPosition() const { return m_pos; }
+	// seconds a particle of the type lasts
+	static float GetLifetime(const SFX_TYPE type);
 
-	float AgeBlend() const;
-	void SetPosition(const vector3d &p);
+	float GetAge(const double time) const { return float(time - m_birth); }
+	vector3d GetPosition(const double time) const { return m_pos + m_vel * (time - m_birth); }
+	float AgeBlend(const float age) const;
 
-	void TimeStepUpdate(const float timeStep);
-	void SaveToJson(Json &jsonObj);
+	void SaveToJson(Json &jsonObj, const double time) const;
 
-	vector3d m_pos;
+	vector3d m_pos; // where it was spawned
 	vector3d m_vel;
-	float m_age;
+	double m_birth; // SfxManager time it was spawned at
 	float m_speed;
 	enum SFX_TYPE m_type;
 };
@@ -49,6 +53,7 @@ public:
 	friend struct Sfx;
 
 	static void Add(const Body *, SFX_TYPE);
+	static void Add(FrameId f, const vector3d &pos, const vector3d &vel, SFX_TYPE);
 	static void AddExplosion(Body *);
 	static void AddThrustSmoke(const Body *b, float speed, const vector3d &adjustpos);
 	static void TimeStepAll(const float timeStep, FrameId f);
@@ -67,6 +72,8 @@ public:
 	SfxManager();
 
 	size_t GetNumberInstances(const SFX_TYPE t) const { return m_instances[t].size(); }
+	double GetTime() const { return m_time; }
+	// drops the particles that have lived out their lifetime
 	void Cleanup();
 
 private:
@@ -84,19 +91,22 @@ private:
 	};
 
 	Sfx &GetInstanceByIndex(const SFX_TYPE t, const size_t i) { return m_instances[t][i]; }
-	void AddInstance(Sfx &inst) { return m_instances[inst.m_type].push_back(inst); }
+	void AddInstance(const Sfx &inst) { return m_instances[inst.m_type].push_back(inst); }
 
 	// methods
 	static SfxManager *AllocSfxInFrame(FrameId f);
-	static vector2f CalculateOffset(const enum SFX_TYPE, const Sfx &);
+	static vector2f CalculateOffset(const enum SFX_TYPE, const Sfx &, const float age);
 	static bool SplitMaterialData(const std::string &spec, MaterialData &output);
 
 	// static members
 	static MaterialData m_materialData[TYPE_NONE];
 
 	// members
-	// per-frame
+	// per-frame; every particle of a type lives as long, so each queue is
+	// in order of both spawning and expiry, and is used as a ring buffer:
+	// spawned at the back, expired from the front
 	std::deque<Sfx> m_instances[TYPE_NONE];
+	double m_time;
 };
 
 #endif /* _SFX_H */
@@ -15,16 +15,16 @@
 #include "scenegraph/FindNodeVisitor.h"
 #include "scenegraph/Node.h"
 #include "scenegraph/SceneGraph.h"
+#include <algorithm>
 #include <sstream>
 #include <SDL_timer.h>
 
 namespace {
-	static constexpr size_t MAX_SHIELD_HITS = 8;
 	struct ShieldData {
 		struct ShieldHitInfo {
 			vector3f hitPos;
 			float radii;
-		} hits[MAX_SHIELD_HITS];
+		} hits[8];
 
 		alignas(16) float shieldStrength;
 		float shieldCooldown;
@@ -187,8 +187,11 @@ void Shields::Uninit()
 }
 
 Shields::Shields(SceneGraph::Model *model) :
+	m_numHits(0),
 	m_enabled(false)
 {
+	static_assert(sizeof(ShieldData::hits) / sizeof(ShieldData::hits[0]) == MAX_HITS, "shield hit count must match the shader");
+
 	using namespace SceneGraph;
 	assert(s_initialised);
 
@@ -278,14 +281,12 @@ void Shields::Update(const float coolDown, const float shieldStrength)
 	// FIXME: this should use a game-specific clock...
 	const Uint32 tickTime = SDL_GetTicks();
 	{
-		auto it = m_hits.begin();
-		while (it != m_hits.end()) {
-			if (tickTime > it->end) {
-				it = m_hits.erase(it);
-			} else {
-				++it;
-			}
+		Uint32 kept = 0;
+		for (Uint32 i = 0; i < m_numHits; ++i) {
+			if (tickTime <= m_hits[i].end)
+				m_hits[kept++] = m_hits[i];
 		}
+		m_numHits = kept;
 	}
 
 	if (!m_enabled) {
@@ -295,13 +296,11 @@ void Shields::Update(const float coolDown, const float shieldStrength)
 		return;
 	}
 
-	ShieldData renderData{};
-
 	// setup the render params
-	// FIXME: don't use a static variable to hold all of this
 	if (shieldStrength > 0.0f) {
-		Uint32 numHits = std::min(m_hits.size(), MAX_SHIELD_HITS);
-		for (Uint32 i = 0; i < numHits; ++i) {
+		ShieldData renderData{};
+
+		for (Uint32 i = 0; i < m_numHits; ++i) {
 			const Hits &hit = m_hits[i];
 
 			//Calculate the impact's radius dependant on time
@@ -318,12 +317,19 @@ void Shields::Update(const float coolDown, const float shieldStrength)
 		renderData.shieldCooldown = coolDown;
 
 		m_shieldMaterial->SetBufferDynamic(s_shieldDataName, &renderData);
-		m_shieldMaterial->SetPushConstant(s_numHitsName, int(numHits));
+		m_shieldMaterial->SetPushConstant(s_numHitsName, int(m_numHits));
 	}
 
-	// update the shield visibility
+	// update the shield visibility. The shield geometry is shared by every
+	// instance of the model, so this has to be done just before rendering,
+	// along with pointing the meshes back at this instance's material.
 	for (const auto &shield : m_shields) {
 		shield.m_mesh->SetNodeMask(shieldStrength > 0.0f ? SceneGraph::NODE_TRANSPARENT : 0x0);
+		for (Uint32 iMesh = 0; iMesh < shield.m_mesh->GetNumMeshes(); ++iMesh) {
+			SceneGraph::StaticGeometry::Mesh &rMesh = shield.m_mesh->GetMeshAt(iMesh);
+			if (rMesh.material != m_shieldMaterial)
+				rMesh.material = m_shieldMaterial;
+		}
 	}
 }
 
@@ -338,7 +344,14 @@ void Shields::AddHit(const vector3d &hitPos)
 {
 	// FIXME: should use the game time
 	Uint32 tickTime = SDL_GetTicks();
-	m_hits.push_back(Hits(hitPos, tickTime, tickTime + 1000));
+	const Hits hit(hitPos, tickTime, tickTime + 1000);
+	if (m_numHits < MAX_HITS) {
+		m_hits[m_numHits++] = hit;
+	} else {
+		// hits are kept in order of age, drop the oldest
+		std::move(m_hits.begin() + 1, m_hits.end(), m_hits.begin());
+		m_hits[MAX_HITS - 1] = hit;
+	}
 }
 
 SceneGraph::StaticGeometry *Shields::GetFirstShieldMesh()
@@ -13,7 +13,7 @@
 #include "matrix4x4.h"
 #include "vector3.h"
 
-#include <deque>
+#include <array>
 
 namespace Graphics {
 	class Renderer;
@@ -51,13 +51,18 @@ public:
 
 protected:
 	struct Hits {
+		Hits() = default;
 		Hits(const vector3d &_pos, const Uint32 _start, const Uint32 _end);
 		vector3d pos;
 		Uint32 start;
 		Uint32 end;
 	};
 
-	std::deque<Hits> m_hits;
+	// only as many hits as the shader can show are kept; a new hit replaces
+	// the oldest one, so the per-frame cost is bounded by the visible hits
+	static constexpr size_t MAX_HITS = 8;
+	std::array<Hits, MAX_HITS> m_hits;
+	Uint32 m_numHits;
 	std::vector<Shield> m_shields;
 	RefCountedPtr<Graphics::Material> m_shieldMaterial;
 
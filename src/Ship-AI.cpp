@@ -3,10 +3,12 @@
 
 #include "EnumStrings.h"
 #include "Frame.h"
+#include "Game.h"
 #include "Pi.h"
 #include "Planet.h"
 #include "Player.h"
 #include "Ship.h"
+#include "Sensors.h"
 #include "ShipAICmd.h"
 #include "Space.h"
 #include "SpaceStation.h"
@@ -14,6 +16,7 @@
 #include "lua/LuaEvent.h"
 #include "perlin.h"
 #include "ship/Propulsion.h"
+#include "ship/RouteRail.h"
 
 // returns true if command is complete
 bool Ship::AITimeStep(float timeStep)
@@ -42,13 +45,122 @@ bool Ship::AITimeStep(float timeStep)
 		return false;
 }
 
+// AI ships away from the player decide their course this often, in game
+// seconds; steering and thrust still run every step
+static const double AI_DECISION_INTERVAL = 0.5;
+// ships this close to the player decide every step
+static const double AI_FULL_RATE_DIST = 1e7;
+
+double Ship::GetAIDecisionInterval() const
+{
+	if (this == Pi::player || !Pi::player) return 0.0;
+	if (m_alertState == ALERT_SHIP_FIRING || m_alertState == ALERT_MISSILE_DETECTED) return 0.0;
+	if (m_curAICmd && (m_curAICmd->GetType() == AICommand::CMD_KILL || m_curAICmd->GetType() == AICommand::CMD_KAMIKAZE))
+		return 0.0;
+	if (GetPositionRelTo(Pi::player).LengthSqr() < AI_FULL_RATE_DIST * AI_FULL_RATE_DIST) return 0.0;
+	return AI_DECISION_INTERVAL;
+}
+
+// the player's sensors only recheck a contact's IFF when told it may have changed
+static void UpdatePlayerIFF(Ship *ship)
+{
+	if (Pi::player && ship != Pi::player && Pi::player->GetSensors())
+		Pi::player->GetSensors()->UpdateIFF(ship);
+}
+
 void Ship::AIClearInstructions()
 {
+	if (m_routeRail) LeaveRouteRail();
 	if (!m_curAICmd) return;
 
+	const bool wasAttackingPlayer = IsAIAttacking(Pi::player);
 	delete m_curAICmd; // rely on destructor to kill children
 	m_curAICmd = 0;
 	m_decelerating = false; // don't adjust unless AI is running
+	if (wasAttackingPlayer) UpdatePlayerIFF(this);
+}
+
+// route rails are dropped once the player is this close
+static const double ROUTE_RAIL_OBSERVER_DIST = 1e9;
+// and only started further away, so ships don't flip between the two
+static const double ROUTE_RAIL_START_OBSERVER_DIST = 1.25 * ROUTE_RAIL_OBSERVER_DIST;
+// other ships and missiles this close keep both on full physics
+static const double ROUTE_RAIL_TRAFFIC_DIST = 1e7;
+// game seconds between checks for starting or leaving a rail
+static const double ROUTE_RAIL_CHECK_INTERVAL = 1.0;
+
+// what the autopilot is flying straight at, if the flight could be handed
+// over to a route rail: a body, or a waypoint such as a ground station
+static bool GetRouteRailTarget(const AICommand *cmd, RouteRail::Target &target)
+{
+	if (!cmd) return false;
+	cmd = cmd->GetActiveCommand();
+	if (cmd->GetType() != AICommand::CMD_FLYTO) return false;
+
+	const AICmdFlyTo *flyTo = static_cast<const AICmdFlyTo *>(cmd);
+	if (!flyTo->IsOnDirectCourse()) return false;
+
+	target.body = flyTo->GetTarget();
+	if (target.body) return !target.body->IsType(ObjectType::SHIP);
+
+	target.frame = flyTo->GetTargetFrame();
+	target.offset = flyTo->GetTargetOffset();
+	return target.frame.valid();
+}
+
+bool Ship::IsClearForRouteRail(double observerDist) const
+{
+	if (this == Pi::player || m_flightState != FLYING) return false;
+	if (Frame::GetFrame(GetFrame())->IsRotFrame()) return false;
+	if (Pi::player && GetPositionRelTo(Pi::player).LengthSqr() < observerDist * observerDist) return false;
+
+	for (Body *b : Pi::game->GetSpace()->GetBodiesMaybeNear(this, ROUTE_RAIL_TRAFFIC_DIST)) {
+		if (b == this || GetPositionRelTo(b).LengthSqr() > ROUTE_RAIL_TRAFFIC_DIST * ROUTE_RAIL_TRAFFIC_DIST) continue;
+		if (b->IsType(ObjectType::MISSILE)) return false;
+		if (b->IsType(ObjectType::SHIP) && !static_cast<Ship *>(b)->IsOnRouteRail()) return false;
+	}
+	return true;
+}
+
+void Ship::UpdateRouteRail()
+{
+	const double now = Pi::game->GetTime();
+	const bool checkDue = now - m_lastRouteRailCheck >= ROUTE_RAIL_CHECK_INTERVAL || now < m_lastRouteRailCheck;
+	if (checkDue) m_lastRouteRailCheck = now;
+
+	if (m_routeRail) {
+		// the autopilot may have been given a new command since the last step
+		const bool sameCommand = m_curAICmd && m_curAICmd->GetActiveCommand() == m_routeRailCmd;
+		if (m_routeRailEnded || !sameCommand || (checkDue && !IsClearForRouteRail(ROUTE_RAIL_OBSERVER_DIST)))
+			LeaveRouteRail();
+		else if (checkDue)
+			SetFuel(m_routeRail->GetFuel());
+		return;
+	}
+
+	if (!checkDue) return;
+	RouteRail::Target target;
+	if (!GetRouteRailTarget(m_curAICmd, target) || !IsClearForRouteRail(ROUTE_RAIL_START_OBSERVER_DIST) || !RouteRail::CanStart(this, target))
+		return;
+
+	m_routeRail.reset(new RouteRail(this, target, now));
+	m_routeRailCmd = m_curAICmd->GetActiveCommand();
+	m_routeRailEnded = false;
+	ClearThrusterState();
+}
+
+double Ship::GetRouteRailEndTime() const
+{
+	assert(m_routeRail);
+	return m_routeRail->GetEndTime();
+}
+
+void Ship::LeaveRouteRail()
+{
+	SetFuel(m_routeRail->GetFuel());
+	m_routeRail.reset();
+	m_routeRailCmd = nullptr;
+	m_routeRailEnded = false;
 }
 
 void Ship::AIGetStatusText(char *str)
@@ -63,6 +175,7 @@ void Ship::AIKamikaze(Body *target)
 {
 	AIClearInstructions();
 	m_curAICmd = new AICmdKamikaze(this, target);
+	if (target == Pi::player) UpdatePlayerIFF(this);
 }
 
 void Ship::AIKill(Ship *target)
@@ -71,6 +184,7 @@ void Ship::AIKill(Ship *target)
 	SetFuelReserve((GetFuel() < 0.5) ? GetFuel() / 2 : 0.25);
 
 	m_curAICmd = new AICmdKill(this, target);
+	if (target == Pi::player) UpdatePlayerIFF(this);
 }
 
 
@@ -37,6 +37,7 @@
 #include "scenegraph/Tag.h"
 #include "scenegraph/CollisionGeometry.h"
 #include "ship/PlayerShipController.h"
+#include "ship/RouteRail.h"
 
 static const float TONS_HULL_PER_SHIELD = 10.f;
 const float Ship::DEFAULT_SHIELD_COOLDOWN_TIME = 1.0f;
@@ -130,7 +131,10 @@ Ship::Ship(const Json &jsonObj, Space *space) :
 
 		m_propulsion->LoadFromJson(shipObj, space);
 
-		SetShipId(shipObj["ship_type_id"]); // XXX handle missing thirdparty ship
+		const ShipType::Id shipId = shipObj["ship_type_id"];
+		if (!ShipType::Get(shipId))
+			throw SavedGameCorruptException(); // e.g. a third party ship that is no longer installed
+		SetShipId(shipId);
 		m_propulsion->SetFuelTankMass(GetShipType()->fuelTankMass);
 		m_stats.fuel_tank_mass_left = m_propulsion->FuelTankMassLeft();
 
@@ -163,7 +167,6 @@ Ship::Ship(const Json &jsonObj, Space *space) :
 		m_fixedGuns->LoadFromJson(shipObj, space);
 
 		m_ecmRecharge = shipObj["ecm_recharge"];
-		SetShipId(shipObj["ship_type_id"]); // XXX handle missing thirdparty ship
 		m_dockedWithPort = shipObj["docked_with_port"];
 		m_dockedWithIndex = shipObj["index_for_body_docked_with"];
 		Init();
@@ -475,6 +478,9 @@ bool Ship::OnDamage(Body *attacker, float kgDamage, const CollisionContact &cont
 		return true;
 	}
 
+	// anything that can hit the ship is worth simulating properly
+	if (m_routeRail) LeaveRouteRail();
+
 	if (!IsDead()) {
 		float dam = kgDamage * 0.001f;
 		if (m_stats.shield_mass_left > 0.0f) {
@@ -673,8 +679,9 @@ void Ship::UpdateLuaStats()
 	// object to Ship forever, even though it could very well be a Player.
 	// Updates at Gen 2019: Indeed, this function has been removed from
 	// loading because loading is now a ctor: see Body.cpp
-	UpdateEquipStats();
 	PropertyMap &p = Properties();
+	PropertyMap::Batch batch(p);
+	UpdateEquipStats();
 	m_stats.hyperspace_range = m_stats.hyperspace_range_max = 0;
 	int hyperclass = p.Get("hyperclass_cap");
 	if (hyperclass) {
@@ -825,6 +832,7 @@ void Ship::SetFlightState(Ship::FlightState newState)
 	if (m_flightState == newState) return;
 	if (IsHyperspaceActive() && (newState != FLYING))
 		AbortHyperjump();
+	if (m_routeRail) LeaveRouteRail();
 
 	if (newState == FLYING) {
 		m_testLanded = false;
@@ -981,12 +989,21 @@ void Ship::SetFrame(FrameId fId)
 	m_sensors->ResetTrails();
 }
 
-void Ship::TimeStepUpdate(const float timeStep)
+void Ship::IntegrateMotion(const float timeStep)
 {
-	PROFILE_SCOPED()
 	// If docked, station is responsible for updating position/orient of ship
 	// but we call this crap anyway and hope it doesn't do anything bad
 
+	if (m_routeRail) {
+		vector3d pos, vel;
+		if (m_routeRail->GetState(Pi::game->GetTime(), GetFrame(), pos, vel)) {
+			SetPrescribedMotion(pos, vel);
+			return;
+		}
+		// the autopilot takes over from the next StaticUpdate()
+		m_routeRailEnded = true;
+	}
+
 	const vector3d thrust = m_propulsion->GetActualLinThrust();
 	AddRelForce(thrust);
 	AddRelTorque(m_propulsion->GetActualAngThrust());
@@ -994,6 +1011,13 @@ void Ship::TimeStepUpdate(const float timeStep)
 	//apply extra atmospheric flight forces
 	AddTorque(CalcAtmoTorque());
 
+	DynamicBody::IntegrateMotion(timeStep);
+}
+
+void Ship::TimeStepUpdate(const float timeStep)
+{
+	PROFILE_SCOPED()
+
 	if (m_landingGearAnimation) {
 		m_landingGearAnimation->SetProgress(m_wheelState);
 		if (m_forceWheelUpdate) {
@@ -1202,7 +1226,7 @@ void Ship::UpdateAlertState()
 	}
 
 	if (changed)
-		LuaEvent::Queue("onShipAlertChanged", this, EnumStrings::GetString("ShipAlertStatus", GetAlertState()));
+		LuaEvent::QueueCoalesced("onShipAlertChanged", { this }, this, EnumStrings::GetString("ShipAlertStatus", GetAlertState()));
 }
 
 void Ship::UpdateFuel(const float timeStep)
@@ -1212,7 +1236,7 @@ void Ship::UpdateFuel(const float timeStep)
 	Properties().Set("fuel", GetFuel() * 100); // XXX to match SetFuelPercent
 
 	if (m_propulsion->IsFuelStateChanged())
-		LuaEvent::Queue("onShipFuelChanged", this, EnumStrings::GetString("PropulsionFuelStatus", m_propulsion->GetFuelState()));
+		LuaEvent::QueueCoalesced("onShipFuelChanged", { this }, this, EnumStrings::GetString("PropulsionFuelStatus", m_propulsion->GetFuelState()));
 }
 
 void Ship::StaticUpdate(const float timeStep)
@@ -1223,7 +1247,8 @@ void Ship::StaticUpdate(const float timeStep)
 
 	if (IsDead()) return;
 
-	if (m_controller) m_controller->StaticUpdate(timeStep);
+	UpdateRouteRail();
+	if (m_controller && !m_routeRail) m_controller->StaticUpdate(timeStep);
 
 	const double hullTemp = GetHullTemperature();
 	if (hullTemp > 1.0) {
@@ -1407,6 +1432,7 @@ void Ship::StaticUpdate(const float timeStep)
 
 void Ship::NotifyRemoved(const Body *const removedBody)
 {
+	if (m_routeRail && m_routeRail->GetTarget() == removedBody) LeaveRouteRail();
 	if (m_curAICmd) m_curAICmd->OnDeleted(removedBody);
 }
 
@@ -1472,8 +1498,8 @@ void Ship::Render(Graphics::Renderer *renderer, const Camera *camera, const vect
 	GetShields()->Update(m_shieldCooldown, 0.01f * GetPercentShields());
 
 	//strncpy(params.pText[0], GetLabel().c_str(), sizeof(params.pText));
+	// the nav lights are drawn with every other body's by the camera
 	RenderModel(renderer, camera, viewCoords, viewTransform);
-	m_navLights->Render(renderer);
 	renderer->GetStats().AddToStatCount(Graphics::Stats::STAT_SHIPS, 1);
 
 	if (m_ecmRecharge > 0.0f) {
@@ -1566,7 +1592,8 @@ void Ship::OnEnterSystem()
 
 void Ship::SetShipId(const ShipType::Id &shipId)
 {
-	m_type = &ShipType::types[shipId];
+	m_type = ShipType::Get(shipId);
+	assert(m_type);
 
 	Properties().Set("shipId", shipId);
 }
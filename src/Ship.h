@@ -24,6 +24,7 @@ class HyperspaceCloud;
 class Missile;
 class NavLights;
 class Planet;
+class RouteRail;
 class Sensors;
 class ShipController;
 class Space;
@@ -107,6 +108,7 @@ public:
 	virtual bool ManualDocking() const { return false; }
 	void Blastoff();
 	bool Undock();
+	virtual void IntegrateMotion(const float timeStep) override;
 	virtual void TimeStepUpdate(const float timeStep) override;
 	virtual void StaticUpdate(const float timeStep) override;
 
@@ -115,6 +117,7 @@ public:
 	bool IsDecelerating() const { return m_decelerating; }
 
 	virtual void NotifyRemoved(const Body *const removedBody) override;
+	virtual bool WantsAllRemovals() const override { return true; }
 	virtual bool OnCollision(Body *o, Uint32 flags, double relVel) override;
 	virtual bool OnDamage(Body *attacker, float kgDamage, const CollisionContact &contactData) override;
 
@@ -200,6 +203,13 @@ public:
 
 	const AICommand *GetAICommand() const { return m_curAICmd; }
 	bool IsAIAttacking(const Ship *target) const;
+	// game seconds the autopilot may keep a course decision; zero while near
+	// the player or in combat, where decisions are remade as soon as they change
+	double GetAIDecisionInterval() const; // Note: defined in Ship-AI.cpp
+	// true while the autopilot's flight is simulated analytically, far from the player
+	bool IsOnRouteRail() const { return bool(m_routeRail); } // Note: see Ship-AI.cpp
+	// game time the route rail ends at, only valid while IsOnRouteRail()
+	double GetRouteRailEndTime() const; // Note: defined in Ship-AI.cpp
 
 	virtual void PostLoadFixup(Space *space) override;
 
@@ -288,6 +298,9 @@ private:
 	void EnterHyperspace();
 	void InitMaterials();
 	void InitEquipSet();
+	void UpdateRouteRail();								 // Note: defined in Ship-AI.cpp
+	void LeaveRouteRail();								 // Note: defined in Ship-AI.cpp
+	bool IsClearForRouteRail(double observerDist) const; // Note: defined in Ship-AI.cpp
 
 	bool m_invulnerable;
 
@@ -333,6 +346,12 @@ private:
 
 	double m_hydrogenScoopedAccumulator = 0;
 
+	// not saved; the autopilot takes over again on load
+	std::unique_ptr<RouteRail> m_routeRail;
+	const AICommand *m_routeRailCmd = nullptr;
+	double m_lastRouteRailCheck = 0;
+	bool m_routeRailEnded = false;
+
 public:
 	// FIXME: these methods are deprecated; all calls should use the propulsion object directly.
 	void ClearAngThrusterState() { m_propulsion->ClearAngThrusterState(); }
@@ -263,6 +263,37 @@ void AICmdKamikaze::PostLoadFixup(Space *space)
 	assert(m_prop != nullptr);
 }
 
+// A salvo of missiles shares a target and usually a frame, so the target's
+// state in each frame is worked out once per tick for all of them. Bodies
+// don't move between StaticUpdate() calls, so it holds for the whole pass.
+struct KamikazeTargetState {
+	const Body *target;
+	FrameId frame;
+	vector3d pos;
+	vector3d vel;
+};
+
+static const KamikazeTargetState &GetKamikazeTargetState(const Body *target, FrameId frame)
+{
+	static const Space *s_space = nullptr;
+	static double s_time = 0.0;
+	static std::vector<KamikazeTargetState> s_states;
+
+	const Space *space = Pi::game->GetSpace();
+	const double time = Pi::game->GetTime();
+	if (space != s_space || time != s_time) {
+		s_space = space;
+		s_time = time;
+		s_states.clear();
+	}
+
+	for (const KamikazeTargetState &state : s_states)
+		if (state.target == target && state.frame == frame)
+			return state;
+	s_states.push_back({ target, frame, target->GetPositionRelTo(frame), target->GetVelocityRelTo(frame) });
+	return s_states.back();
+}
+
 bool AICmdKamikaze::TimeStepUpdate()
 {
 	if (!m_target || m_target->IsDead()) return true;
@@ -285,7 +316,8 @@ bool AICmdKamikaze::TimeStepUpdate()
 		// Missile, for now ;-)
 	}
 
-	const vector3d targetPos = m_target->GetPositionRelTo(m_dBody);
+	const KamikazeTargetState &targetState = GetKamikazeTargetState(m_target, m_dBody->GetFrame());
+	const vector3d targetPos = targetState.pos - m_dBody->GetPosition();
 	const vector3d targetDir = targetPos.NormalizedSafe();
 	const double dist = targetPos.Length();
 
@@ -302,7 +334,7 @@ bool AICmdKamikaze::TimeStepUpdate()
 	const double aimRelSpeed =
 		sqrt(aimCollisionSpeed * aimCollisionSpeed + 2 * dist * brake);
 
-	const vector3d aimVel = aimRelSpeed * targetDir + m_target->GetVelocityRelTo(m_dBody->GetFrame());
+	const vector3d aimVel = aimRelSpeed * targetDir + targetState.vel;
 	const vector3d accelDir = (aimVel - m_dBody->GetVelocity()).NormalizedSafe();
 
 	m_prop->ClearLinThrusterState();
@@ -886,6 +918,16 @@ static bool CheckSuicide(DynamicBody *dBody, const vector3d &obspos, double obsM
 
 extern double calc_ivel(double dist, double vel, double acc);
 
+// even at full rate, a path check is reused this long while the path holds
+static const double PATH_CHECK_MIN_AGE = 0.1;
+
+// spreads the course decisions of ships that were given commands on the same step
+static double NextDecisionJitter()
+{
+	static unsigned int s_counter = 0;
+	return 0.75 + 0.0625 * (s_counter++ % 8);
+}
+
 void AICmdFlyTo::OnDeleted(const Body *body)
 {
 	AICommand::OnDeleted(body);
@@ -926,6 +968,7 @@ AICmdFlyTo::AICmdFlyTo(DynamicBody *dBody, Body *target) :
 	m_tangent = false;
 	m_is_flyto = true;
 	m_suicideRecovery = false;
+	m_decisionJitter = NextDecisionJitter();
 
 	if (!target->IsType(ObjectType::TERRAINBODY))
 		m_dist = VICINITY_MIN;
@@ -955,14 +998,16 @@ AICmdFlyTo::AICmdFlyTo(DynamicBody *dBody, FrameId targframe, const vector3d &po
 	m_tangent(tangent),
 	m_state(-6),
 	m_frameId(FrameId::Invalid),
-	m_suicideRecovery(false)
+	m_suicideRecovery(false),
+	m_decisionJitter(NextDecisionJitter())
 {
 	m_prop = dBody->GetComponent<Propulsion>();
 	assert(m_prop != nullptr);
 }
 
 AICmdFlyTo::AICmdFlyTo(const Json &jsonObj) :
-	AICommand(jsonObj, CMD_FLYTO)
+	AICommand(jsonObj, CMD_FLYTO),
+	m_decisionJitter(NextDecisionJitter())
 {
 	try {
 		m_targetIndex = jsonObj["index_for_target"];
@@ -1096,6 +1141,7 @@ bool AICmdFlyTo::TimeStepUpdate()
 		if (m_tangent && m_frameId.valid()) return true; // regen tangent on frame switch
 		m_reldir = reldir;								 // for +vel termination condition
 		m_frameId = m_dBody->GetFrame();
+		m_pathCheck.Invalidate();
 	}
 
 	// TODO: collision needs to be processed according to vdiff, not reldir?
@@ -1104,7 +1150,17 @@ bool AICmdFlyTo::TimeStepUpdate()
 	double erad = MaxEffectRad(body, m_prop);
 	Frame *targframe = Frame::GetFrame(targframeId);
 	if ((m_target && body != m_target) || (targframe && (!m_tangent || body != targframe->GetBody()))) {
-		int coll = CheckCollision(m_dBody, reldir, targdist, targetAlt, m_endvel, erad);
+		// the last check stands while the path barely changes; far from the
+		// player it may stand for longer
+		const double now = Pi::game->GetTime();
+		int coll;
+		if (!m_pathCheck.Lookup(body, m_dBody->GetPosition(), reldir, targdist, erad, now, coll)) {
+			coll = CheckCollision(m_dBody, reldir, targdist, targetAlt, m_endvel, erad);
+			const bool intercept = m_target && m_target->IsType(ObjectType::SHIP);
+			const double interval = intercept ? 0.0 : static_cast<Ship *>(m_dBody)->GetAIDecisionInterval();
+			const double maxAge = std::max(interval * m_decisionJitter, PATH_CHECK_MIN_AGE);
+			m_pathCheck.Store(body, m_dBody->GetPosition(), reldir, targdist, erad, now, maxAge, coll);
+		}
 		if (coll == 0) { // no collision
 			if (m_child) {
 				m_child.reset();
@@ -10,6 +10,7 @@
 #include "DynamicBody.h"
 #include "FixedGuns.h"
 #include "FrameId.h"
+#include "ship/PathCheckCache.h"
 #include "ship/Propulsion.h"
 
 class Ship;
@@ -61,6 +62,8 @@ public:
 	}
 
 	CmdName GetType() const { return m_cmdName; }
+	// the innermost command in the chain of children, which is the one flying the ship
+	const AICommand *GetActiveCommand() const { return m_child ? m_child->GetActiveCommand() : this; }
 
 protected:
 	DynamicBody *m_dBody;
@@ -128,6 +131,13 @@ public:
 
 	virtual void OnDeleted(const Body *body);
 
+	Body *GetTarget() const { return m_target; }
+	// the waypoint when there is no target body
+	FrameId GetTargetFrame() const { return m_targframeId; }
+	const vector3d &GetTargetOffset() const { return m_posoff; }
+	// true while flying straight at the target, with nothing to avoid on the way
+	bool IsOnDirectCourse() const { return !m_child && !m_tangent && !m_suicideRecovery && m_state >= 0; }
+
 private:
 	Body *m_target;		   // target for vicinity. Either this or targframe is 0
 	double m_dist;		   // vicinity distance
@@ -141,6 +151,11 @@ private:
 	vector3d m_reldir; // target direction relative to ship at last frame change
 	FrameId m_frameId; // last frame of ship
 	bool m_suicideRecovery;
+
+	// obstruction checks are reused while the path holds, for at most
+	// Ship::GetAIDecisionInterval() scaled by the jitter
+	PathCheckCache m_pathCheck;
+	double m_decisionJitter; // spreads the checks of different ships over steps
 };
 
 class AICmdFlyAround : public AICommand {
@@ -23,7 +23,8 @@ ShipCockpit::ShipCockpit(const std::string &modelName, Body *ship) :
 	m_offset(0.f),
 	m_shipVel(0.f),
 	m_translate(0.0),
-	m_transform(matrix4x4d::Identity())
+	m_transform(matrix4x4d::Identity()),
+	m_suspended(true)
 {
 	assert(!modelName.empty());
 	SetModel(modelName.c_str());
@@ -64,12 +65,22 @@ inline void ShipCockpit::resetInternalCameraController()
 
 void ShipCockpit::Update(const Player *player, float timeStep)
 {
-	//Check if current view is exterior since we don't need to update cockpit
-	//because player can't see it
-	if (Pi::game->GetWorldView()->shipView->IsExteriorView())
-	{
+	// the lag, shake and thruster animation only matter while the player can
+	// see the cockpit, so stop simulating it whenever it's off screen
+	if (!Pi::game->GetWorldView()->shipView->IsCockpitVisible()) {
+		m_suspended = true;
 		return;
 	}
+	if (m_suspended) {
+		// rather than replaying the time we missed, start again from rest
+		OnActivated(player);
+		m_rotInterp = 0.f;
+		m_transInterp = 0.f;
+		m_gForce = 0.f;
+		m_offset = 0.f;
+		m_translate = vector3d(0.0);
+		m_suspended = false;
+	}
 	if (m_icc == nullptr) {
 		// I don't know where to put this
 		resetInternalCameraController();
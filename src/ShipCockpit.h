@@ -48,6 +48,7 @@ private:
 	float m_shipVel; // current ship velocity
 	vector3d m_translate; // cockpit translation
 	matrix4x4d m_transform; // cockpit transformation
+	bool m_suspended; // not updated while off screen
 	InternalCameraController *m_icc;
 };
 #endif
@@ -23,6 +23,7 @@ std::map<ShipType::Id, const ShipType> ShipType::types;
 std::vector<ShipType::Id> ShipType::player_ships;
 std::vector<ShipType::Id> ShipType::static_ships;
 std::vector<ShipType::Id> ShipType::missile_ships;
+FlatHashMap<std::string_view, const ShipType *> ShipType::s_typesById;
 
 const std::string ShipType::POLICE = "kanara";
 const std::string ShipType::MISSILE_GUIDED = "missile_guided";
@@ -45,8 +46,7 @@ static double GetEffectiveExhaustVelocity(double fuelTankMass, double thrusterFu
 
 static bool ShipIsUnbuyable(const std::string &id)
 {
-	const ShipType &t = ShipType::types[id];
-	return is_zero_exact(t.baseprice);
+	return is_zero_exact(ShipType::Get(id)->baseprice);
 }
 
 ShipType::ShipType(const Id &_id, const std::string &path)
@@ -363,6 +363,8 @@ int _define_ship(lua_State *L, ShipType::Tag tag, std::vector<ShipType::Id> *lis
 	}
 	fwrite(saveMe.data(), saveMe.length(), 1, f);
 	fclose(f);
+	// the file may be new to the data directory
+	FileSystem::gameDataFiles.InvalidateIndex();
 
 	lua_pop(L, 1);
 	LUA_DEBUG_END(L, 0);
@@ -491,6 +493,9 @@ void ShipType::Init()
 	lua_close(l);
 #endif
 
+	for (const auto &type : types)
+		s_typesById.emplace(type.first, &type.second);
+
 	//remove unbuyable ships from player ship list
 	ShipType::player_ships.erase(
 		std::remove_if(ShipType::player_ships.begin(), ShipType::player_ships.end(), ShipIsUnbuyable),
@@ -4,9 +4,11 @@
 #ifndef _SHIPTYPE_H
 #define _SHIPTYPE_H
 
+#include "core/FlatHashMap.h"
 #include "ship/Propulsion.h"
 #include <map>
 #include <string>
+#include <string_view>
 #include <vector>
 
 struct ShipType {
@@ -84,14 +86,17 @@ struct ShipType {
 	static std::vector<Id> missile_ships;
 
 	static void Init();
-	static const ShipType *Get(const char *name)
+	// nullptr if there's no such type
+	static const ShipType *Get(std::string_view id)
 	{
-		std::map<Id, const ShipType>::iterator t = types.find(name);
-		if (t == types.end())
-			return 0;
-		else
-			return &(*t).second;
+		auto t = s_typesById.find(id);
+		return t == s_typesById.end() ? nullptr : t->second;
 	}
+
+private:
+	// hashed index over types, keyed by views of their ids; built once
+	// every type has been loaded
+	static FlatHashMap<std::string_view, const ShipType *> s_typesById;
 };
 
 #endif /* _SHIPTYPE_H */
@@ -0,0 +1,139 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "Simulation.h"
+
+#include "BaseSphere.h"
+#include "Game.h"
+#include "HeadlessGame.h"
+#include "Pi.h"
+#include "Player.h"
+#include "Space.h"
+#include "buildopts.h"
+#include "core/Log.h"
+#include "core/OS.h"
+#include "profiler/Profiler.h"
+
+#ifdef ENABLE_SERVER_AGENT
+#include "ServerAgent.h"
+#endif
+
+#include "Json.h"
+
+namespace {
+	// ticks run back to back until this much of a frame is spent, then
+	// control returns so finished jobs and server responses are handled
+	const double UPDATE_BUDGET_MS = 20.0;
+} // namespace
+
+Simulation::Simulation(const Settings &settings) :
+	m_settings(settings)
+{
+}
+
+Simulation::~Simulation()
+{
+}
+
+void Simulation::Start()
+{
+	PROFILE_SCOPED()
+
+	// as GameLoop::Start does, for the physics code
+	OS::DisableFPE();
+
+	Game *game = HeadlessGame::CreateGame("Simulation", m_settings.start, m_settings.saveName, m_settings.seed);
+	if (!game) {
+		m_failed = true;
+		return;
+	}
+	// the view is set, but never updated or drawn
+	HeadlessGame::StartGame(game, m_settings.script);
+
+	if (m_settings.ticks)
+		Output("Simulation: running for %u ticks\n", m_settings.ticks);
+	else
+		Output("Simulation: running until the game is ended\n");
+}
+
+void Simulation::Update(float deltaTime)
+{
+	PROFILE_SCOPED()
+
+#ifdef ENABLE_SERVER_AGENT
+	Pi::serverAgent->ProcessResponses();
+#endif
+
+	if (m_failed)
+		return RequestEndLifecycle();
+
+	Game *game = Pi::game;
+	Profiler::Clock timer;
+	timer.SoftReset();
+
+	do {
+		if (m_settings.ticks && m_tick >= m_settings.ticks) {
+			m_endReason = "ticks";
+			RequestEndLifecycle();
+			break;
+		}
+		if (game->GetPlayer()->IsDead()) {
+			m_endReason = "playerDied";
+			RequestEndLifecycle();
+			break;
+		}
+
+		// paused, until a script or the server agent changes that
+		const float step = game->GetTimeStep();
+		if (step <= 0.0f)
+			break;
+
+		game->TimeStep(step);
+		BaseSphere::UpdateAllBaseSphereDerivatives();
+		++m_tick;
+
+		timer.SoftStop();
+	} while (timer.milliseconds() < UPDATE_BUDGET_MS);
+
+	// Lua reads interpolated positions as well
+	game->GetSpace()->UpdateInterpTransforms(1.0);
+
+	timer.SoftStop();
+	m_wallSeconds += timer.seconds();
+}
+
+void Simulation::End()
+{
+	if (!m_failed)
+		WriteReport();
+
+	HeadlessGame::EndGame();
+}
+
+void Simulation::WriteReport()
+{
+	const double ticksPerSecond = m_wallSeconds > 0.0 ? m_tick / m_wallSeconds : 0.0;
+	Output("Simulation: %s after %u ticks, %.0f s of game time in %.2f s (%.0f ticks/s)\n",
+		m_endReason, m_tick, Pi::game->GetTime(), m_wallSeconds, ticksPerSecond);
+
+	if (m_settings.reportFile.empty())
+		return;
+
+	Json report = Json::object();
+	report["version"] = PIONEER_VERSION;
+	if (m_settings.saveName.empty())
+		report["start"] = to_string(m_settings.start);
+	else
+		report["start"] = "save:" + m_settings.saveName;
+	report["seed"] = m_settings.seed;
+	report["script"] = m_settings.script;
+	report["endReason"] = m_endReason;
+	report["ticks"] = m_tick;
+	report["gameTime"] = Pi::game->GetTime();
+	report["wallSeconds"] = m_wallSeconds;
+	report["ticksPerSecond"] = ticksPerSecond;
+	report["bodies"] = Pi::game->GetSpace()->GetNumBodies();
+	report["playerDead"] = Pi::game->GetPlayer()->IsDead();
+
+	HeadlessGame::WriteReport("Simulation", report, m_settings.reportFile);
+}
@@ -0,0 +1,52 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#pragma once
+
+#include "core/Application.h"
+#include "galaxy/SystemPath.h"
+
+#include <cstdint>
+#include <string>
+
+/*
+ * Runs a game with nothing drawn and no input, as fast as the physics
+ * allows, for automated playtesting and balance simulations. It takes the
+ * place of the main menu once loading is done (see "pioneer -simulate"),
+ * on the dummy renderer with sound disabled, and pioneer exits when it
+ * ends.
+ *
+ * The game is driven by a Lua script from the game data, run with the game
+ * already created and just before onGameStart is emitted, so it can
+ * register for events and timers or act on the game straight away; or by
+ * a server agent. The simulation ends after a number of ticks, when the
+ * player dies, or when the script calls Game.EndGame().
+ */
+class Simulation : public Application::Lifecycle {
+public:
+	struct Settings {
+		SystemPath start = SystemPath(0, 0, 0, 0, 18);
+		std::string saveName; // start from this save instead, if set
+		uint32_t ticks = 0;	  // 0 to run until the game is ended
+		uint32_t seed = 0;	  // 0 keeps the time-based seed
+		std::string script;
+		std::string reportFile; // "-" for stdout, empty for no report
+	};
+
+	explicit Simulation(const Settings &settings);
+	~Simulation();
+
+protected:
+	void Start() override;
+	void Update(float deltaTime) override;
+	void End() override;
+
+private:
+	void WriteReport();
+
+	Settings m_settings;
+	uint32_t m_tick = 0;
+	double m_wallSeconds = 0.0;
+	const char *m_endReason = "ended";
+	bool m_failed = false;
+};
@@ -3,8 +3,10 @@
 
 #include "Space.h"
 
+#include "Beam.h"
 #include "Body.h"
 #include "CityOnPlanet.h"
+#include "DynamicBody.h"
 #include "Frame.h"
 #include "Game.h"
 #include "GameSaveError.h"
@@ -15,21 +17,41 @@
 #include "Pi.h"
 #include "Planet.h"
 #include "Player.h"
+#include "Projectile.h"
+#include "Ship.h"
 #include "SpaceStation.h"
 #include "Star.h"
 #include "SystemView.h"
 #include "collider/CollisionContact.h"
 #include "collider/CollisionSpace.h"
+#include "core/HitchDetector.h"
 #include "core/Log.h"
+#include "core/TaskGraph.h"
 #include "galaxy/Galaxy.h"
 #include "graphics/Graphics.h"
 #include "lua/LuaEvent.h"
 #include "lua/LuaTimer.h"
 #include <algorithm>
+#include <cfloat>
 #include <functional>
 
 //#define DEBUG_CACHE
 
+// bodies integrated per task; integration is cheap except for fast bodies
+// which trace their path through the collision space
+static const uint32_t BODY_INTEGRATION_GRAIN_SIZE = 32;
+// interpolating a body's transform is a lot less work than integrating it
+static const uint32_t BODY_INTERPOLATION_GRAIN_SIZE = 256;
+
+// longer steps may take bodies at most this fraction of the way to the
+// nearest thing they could hit
+static const double STEP_CLEARANCE_FRACTION = 0.25;
+// searched beyond a body's reach for others, enough for the largest stations
+static const double STEP_NEAR_BODY_MARGIN = 100000.0;
+// most steps merged while anything integrates its motion or docks; beyond
+// this only analytic motion, which is exact at any step, is fast-forwarded
+static const int STEP_MERGE_MAX_SCALE = 16;
+
 static void RelocateStarportIfNecessary(SystemBody *sbody, Planet *planet, vector3d &pos, matrix3x3d &rot, const std::vector<vector3d> &prevPositions)
 {
 	const double radius = planet->GetSystemBody()->GetRadius();
@@ -158,12 +180,12 @@ static void RelocateStarportIfNecessary(SystemBody *sbody, Planet *planet, vecto
 void Space::BodyNearFinder::Prepare()
 {
 	PROFILE_SCOPED()
-	m_bodyDist.clear();
+	m_bodyHash.BeginUpdate();
 
 	for (Body *b : m_space->GetBodies())
-		m_bodyDist.emplace_back(b, b->GetPositionRelTo(m_space->GetRootFrame()).Length());
+		m_bodyHash.Update(b, b->GetPositionRelTo(m_space->GetRootFrame()));
 
-	std::sort(m_bodyDist.begin(), m_bodyDist.end());
+	m_bodyHash.EndUpdate();
 }
 
 Space::BodyNearList Space::BodyNearFinder::GetBodiesMaybeNear(const Body *b, double dist)
@@ -173,20 +195,8 @@ Space::BodyNearList Space::BodyNearFinder::GetBodiesMaybeNear(const Body *b, dou
 
 Space::BodyNearList Space::BodyNearFinder::GetBodiesMaybeNear(const vector3d &pos, double dist)
 {
-	if (m_bodyDist.empty()) {
-		m_nearBodies.clear();
-		return std::move(m_nearBodies);
-	}
-
-	const double len = pos.Length();
-
-	std::vector<BodyDist>::const_iterator min = std::lower_bound(m_bodyDist.begin(), m_bodyDist.end(), len - dist);
-	std::vector<BodyDist>::const_iterator max = std::upper_bound(min, m_bodyDist.cend(), len + dist);
-
 	m_nearBodies.clear();
-	m_nearBodies.reserve(max - min);
-
-	std::for_each(min, max, [&](BodyDist const &bd) { m_nearBodies.push_back(bd.body); });
+	m_bodyHash.Query(pos, dist, m_nearBodies);
 
 	return std::move(m_nearBodies);
 }
@@ -247,7 +257,7 @@ Space::Space(Game *game, RefCountedPtr<Galaxy> galaxy, const Json &jsonObj, doub
 #endif
 {
 	PROFILE_SCOPED()
-	Json spaceObj = jsonObj["space"];
+	const Json &spaceObj = jsonObj["space"];
 
 	m_starSystem = StarSystem::FromJson(galaxy, spaceObj);
 
@@ -261,11 +271,12 @@ Space::Space(Game *game, RefCountedPtr<Galaxy> galaxy, const Json &jsonObj, doub
 	m_rootFrameId = Frame::FromJson(spaceObj["frame"], this, FrameId::Invalid, at_time);
 
 	try {
-		Json bodyArray = spaceObj["bodies"].get<Json::array_t>();
+		const Json &bodyArray = spaceObj["bodies"];
+		if (!bodyArray.is_array()) throw SavedGameCorruptException();
 		for (Uint32 i = 0; i < bodyArray.size(); i++) {
 			if (bodyArray[i].count("is_not_in_space") > 0)
 				continue;
-			m_bodies.push_back(Body::FromJson(bodyArray[i], this));
+			LinkBody(Body::FromJson(bodyArray[i], this));
 		}
 	} catch (Json::type_error &) {
 		throw SavedGameCorruptException();
@@ -321,21 +332,38 @@ Space::~Space()
 	Frame::DeleteFrames();
 }
 
+// the background of a system only depends on its path
+static Random BackgroundRandom(const SystemPath &path)
+{
+	Uint32 _init[5] = { path.systemIndex, Uint32(path.sectorX), Uint32(path.sectorY), Uint32(path.sectorZ), UNIVERSE_SEED };
+	return Random(_init, 5);
+}
+
 void Space::RefreshBackground()
 {
 	PROFILE_SCOPED()
+	// the old stars and skybox stay up until the new ones are ready
+	std::unique_ptr<Background::Container> previous = std::move(m_background);
+	Background::Starfield *previousStars = previous ? previous->GetStarfield() : nullptr;
 	if (m_starSystem.Valid()) {
-		const SystemPath &path = m_starSystem->GetPath();
-		Uint32 _init[5] = { path.systemIndex, Uint32(path.sectorX), Uint32(path.sectorY), Uint32(path.sectorZ), UNIVERSE_SEED };
-		Random rand(_init, 5);
-		m_background.reset(new Background::Container(Pi::renderer, rand));
-		m_background->GetStarfield()->Fill(rand, &this->GetStarSystem()->GetPath(), m_game->GetGalaxy());
+		Random rand = BackgroundRandom(m_starSystem->GetPath());
+		m_background.reset(new Background::Container(Pi::renderer, rand, previous.get()));
+		m_background->GetStarfield()->Fill(rand, &this->GetStarSystem()->GetPath(), m_game->GetGalaxy(), previousStars);
 	} else {
-		m_background.reset(new Background::Container(Pi::renderer, Pi::rng));
-		m_background->GetStarfield()->Fill(Pi::rng, nullptr, m_game->GetGalaxy());
+		m_background.reset(new Background::Container(Pi::renderer, Pi::rng, previous.get()));
+		m_background->GetStarfield()->Fill(Pi::rng, nullptr, m_game->GetGalaxy(), previousStars);
 	}
 }
 
+void Space::PrefetchBackground(const SystemPath &path)
+{
+	PROFILE_SCOPED()
+	if (!m_background)
+		return;
+	Random rand = BackgroundRandom(path);
+	m_background->Prefetch(rand, path, m_game->GetGalaxy());
+}
+
 void Space::ToJson(Json &jsonObj)
 {
 	PROFILE_SCOPED()
@@ -456,7 +484,7 @@ void Space::RebuildSystemBodyIndex()
 
 void Space::AddBody(Body *b)
 {
-	m_bodies.push_back(b);
+	LinkBody(b);
 }
 
 void Space::RemoveBody(Body *b)
@@ -467,6 +495,71 @@ void Space::RemoveBody(Body *b)
 	m_assignedBodies.emplace_back(b, BodyAssignation::REMOVE);
 }
 
+void Space::WatchBody(Body *watcher, Body *watched)
+{
+	std::vector<Body *> &watchers = m_watchers[watched];
+	if (std::find(watchers.begin(), watchers.end(), watcher) != watchers.end())
+		return;
+
+	watchers.push_back(watcher);
+	m_watching[watcher].push_back(watched);
+}
+
+void Space::LinkBody(Body *b)
+{
+	BodySlot slot = { m_bodies.size(), NO_SLOT };
+	m_bodies.push_back(b);
+
+	if (b->WantsAllRemovals()) {
+		slot.listenerIndex = m_removalListeners.size();
+		m_removalListeners.push_back(b);
+	}
+
+	m_bodySlots[b] = slot;
+
+	if (b->IsType(ObjectType::HYPERSPACECLOUD))
+		m_cloudEvents.push({ static_cast<HyperspaceCloud *>(b)->GetNextEventTime(), b });
+}
+
+void Space::UnlinkBody(Body *b)
+{
+	auto iter = m_bodySlots.find(b);
+	const BodySlot slot = iter->second;
+	m_bodySlots.erase(iter);
+
+	// swap the last body into the freed slot
+	m_bodies[slot.index] = m_bodies.back();
+	m_bodies.pop_back();
+	if (slot.index < m_bodies.size())
+		m_bodySlots[m_bodies[slot.index]].index = slot.index;
+
+	if (slot.listenerIndex != NO_SLOT) {
+		m_removalListeners[slot.listenerIndex] = m_removalListeners.back();
+		m_removalListeners.pop_back();
+		if (slot.listenerIndex < m_removalListeners.size())
+			m_bodySlots[m_removalListeners[slot.listenerIndex]].listenerIndex = slot.listenerIndex;
+	}
+
+	// drop watches in both directions
+	auto watchers = m_watchers.find(b);
+	if (watchers != m_watchers.end()) {
+		for (Body *watcher : watchers->second) {
+			std::vector<Body *> &watching = m_watching[watcher];
+			watching.erase(std::find(watching.begin(), watching.end(), b));
+		}
+		m_watchers.erase(watchers);
+	}
+
+	auto watching = m_watching.find(b);
+	if (watching != m_watching.end()) {
+		for (Body *watched : watching->second) {
+			std::vector<Body *> &watchersOf = m_watchers[watched];
+			watchersOf.erase(std::find(watchersOf.begin(), watchersOf.end(), b));
+		}
+		m_watching.erase(watching);
+	}
+}
+
 void Space::KillBody(Body *b)
 {
 #ifndef NDEBUG
@@ -1022,34 +1115,59 @@ static void hitCallback(CollisionContact *c)
 	}
 }
 
-// temporary one-point version
-static void CollideWithTerrain(Body *body, float timeStep)
+// temporary one-point version, with the height queries batched per terrain
+void Space::CollideWithTerrain(float timeStep)
 {
 	PROFILE_SCOPED()
-	if (!body->IsType(ObjectType::DYNAMICBODY))
-		return;
-	DynamicBody *dynBody = static_cast<DynamicBody *>(body);
-	if (!dynBody->IsMoving())
-		return;
+	m_terrainQueries.clear();
+	m_queriedTerrains.clear();
+	for (Body *body : m_bodies) {
+		if (!body->IsType(ObjectType::DYNAMICBODY))
+			continue;
+		DynamicBody *dynBody = static_cast<DynamicBody *>(body);
+		if (!dynBody->IsMoving())
+			continue;
 
-	Frame *f = Frame::GetFrame(body->GetFrame());
-	if (!f || !f->GetBody() || f->GetId() != f->GetBody()->GetFrame())
-		return;
-	if (!f->GetBody()->IsType(ObjectType::TERRAINBODY))
-		return;
-	TerrainBody *terrain = static_cast<TerrainBody *>(f->GetBody());
+		Frame *f = Frame::GetFrame(body->GetFrame());
+		if (!f || !f->GetBody() || f->GetId() != f->GetBody()->GetFrame())
+			continue;
+		if (!f->GetBody()->IsType(ObjectType::TERRAINBODY))
+			continue;
+		TerrainBody *terrain = static_cast<TerrainBody *>(f->GetBody());
 
-	const Aabb &aabb = dynBody->GetAabb();
-	double altitude = body->GetPosition().Length() + aabb.min.y;
-	if (altitude >= (terrain->GetMaxFeatureRadius() * 2.0))
-		return;
+		const Aabb &aabb = dynBody->GetAabb();
+		double altitude = body->GetPosition().Length() + aabb.min.y;
+		if (altitude >= (terrain->GetMaxFeatureRadius() * 2.0))
+			continue;
 
-	double terrHeight = terrain->GetTerrainHeight(body->GetPosition().Normalized());
-	if (altitude >= terrHeight)
-		return;
+		if (std::find(m_queriedTerrains.begin(), m_queriedTerrains.end(), terrain) == m_queriedTerrains.end())
+			m_queriedTerrains.push_back(terrain);
+		m_terrainQueries.push_back({ body, terrain, body->GetPosition().Normalized(), altitude });
+	}
+
+	for (TerrainBody *terrain : m_queriedTerrains) {
+		m_terrainBatch.clear();
+		m_terrainDirs.clear();
+		for (const TerrainQuery &query : m_terrainQueries) {
+			if (query.terrain == terrain) {
+				m_terrainBatch.push_back(&query);
+				m_terrainDirs.push_back(query.dir);
+			}
+		}
+		m_terrainHeights.resize(m_terrainDirs.size());
+		terrain->GetTerrainHeights(m_terrainDirs.data(), m_terrainHeights.data(), m_terrainDirs.size());
+
+		for (size_t i = 0; i < m_terrainBatch.size(); i++) {
+			const TerrainQuery &query = *m_terrainBatch[i];
+			const double terrHeight = m_terrainHeights[i];
+			if (query.altitude >= terrHeight)
+				continue;
 
-	CollisionContact c(body->GetPosition(), body->GetPosition().Normalized(), terrHeight - altitude, timeStep, static_cast<void *>(body), static_cast<void *>(f->GetBody()));
-	hitCallback(&c);
+			CollisionContact c(query.body->GetPosition(), query.dir, terrHeight - query.altitude, timeStep,
+				static_cast<void *>(query.body), static_cast<void *>(terrain));
+			hitCallback(&c);
+		}
+	}
 }
 
 void Space::TimeStep(float step)
@@ -1061,10 +1179,9 @@ void Space::TimeStep(float step)
 
 	m_bodyIndexValid = m_sbodyIndexValid = false;
 
-	Frame::CollideFrames(&hitCallback);
+	Frame::CollideFrames(&hitCallback, Pi::GetApp()->GetTaskGraph());
 
-	for (Body *b : m_bodies)
-		CollideWithTerrain(b, step);
+	CollideWithTerrain(step);
 
 	// update frames of reference
 	for (Body *b : m_bodies)
@@ -1083,19 +1200,152 @@ void Space::TimeStep(float step)
 		auto b = m_bodies[i];
 		b->StaticUpdate(step);
 	}
-	Frame::UpdateOrbitRails(m_game->GetTime(), m_game->GetTimeStep());
+	Beam::TraceQueued();
+	ProjectileManager::StaticUpdateAll(step, m_rootFrameId);
+	Frame::UpdateOrbitRails(m_game->GetTime(), step);
 
+	IntegrateBodies(step);
 	for (Body *b : m_bodies)
 		b->TimeStepUpdate(step);
+	UpdateHyperspaceClouds();
+	ProjectileManager::TimeStepAll(step, m_rootFrameId);
 
-	LuaEvent::Emit();
-	Pi::luaTimer->Tick();
+	{
+		HitchDetector::ScopedPhase phase(Pi::GetApp()->GetHitchDetector(), HitchDetector::PHASE_LUA_EVENTS);
+		LuaEvent::Emit();
+		Pi::luaTimer->Tick();
+	}
 
 	UpdateBodies();
 
 	m_bodyNearFinder.Prepare();
 }
 
+int Space::GetSafeStepScale(float step, int maxScale)
+{
+	PROFILE_SCOPED()
+	int scale = maxScale;
+	for (Body *b : m_bodies) {
+		if (scale <= 1)
+			break;
+		// docking animations are stepped, not analytic
+		if (b->IsType(ObjectType::SPACESTATION) && static_cast<SpaceStation *>(b)->HasBusyBays()) {
+			scale = std::min(scale, STEP_MERGE_MAX_SCALE);
+			continue;
+		}
+		if (!b->IsType(ObjectType::DYNAMICBODY))
+			continue;
+
+		const DynamicBody *db = static_cast<DynamicBody *>(b);
+		if (!db->IsMoving())
+			continue;
+		// bodies on analytic paths are exact at any step, up to where the
+		// path ends and integration takes over again
+		if (db->HasPrescribedMotion()) {
+			if (b->IsType(ObjectType::SHIP) && static_cast<const Ship *>(b)->IsOnRouteRail()) {
+				const double untilEnd = static_cast<const Ship *>(b)->GetRouteRailEndTime() - m_game->GetTime();
+				scale = std::min(scale, int(Clamp(floor(untilEnd / step), 1.0, double(maxScale))));
+			}
+			continue;
+		}
+		// anything under thrust or in atmosphere keeps the normal step
+		if (!db->IsCoasting())
+			return 1;
+		scale = std::min(scale, STEP_MERGE_MAX_SCALE);
+
+		const double stepDist = db->GetVelocity().Length() * step;
+		if (is_zero_exact(stepDist))
+			continue;
+
+		// nearest thing it could hit: the body its frame is around, and any
+		// other body within reach
+		double clearance = DBL_MAX;
+		const Body *frameBody = Frame::GetFrame(b->GetFrame())->GetBody();
+		if (frameBody && frameBody != b)
+			clearance = b->GetPositionRelTo(frameBody).Length() - frameBody->GetPhysRadius();
+
+		const double reach = stepDist * scale;
+		for (Body *other : GetBodiesMaybeNear(b, reach + STEP_NEAR_BODY_MARGIN)) {
+			if (other != b && other != frameBody)
+				clearance = std::min(clearance, other->GetPositionRelTo(b).Length() - other->GetPhysRadius());
+		}
+		clearance -= b->GetPhysRadius();
+
+		const double bodyScale = floor(STEP_CLEARANCE_FRACTION * clearance / stepDist);
+		scale = std::min(scale, int(Clamp(bodyScale, 1.0, double(maxScale))));
+	}
+	return std::max(scale, 1);
+}
+
+void Space::IntegrateBodies(float step)
+{
+	PROFILE_SCOPED()
+
+	// Bodies only integrate their own motion, against collision geometry
+	// which doesn't move until TimeStepUpdate(), so the result is the same
+	// whichever thread each body runs on. The serial path is the same
+	// separate pass, so results don't depend on the thread count either.
+	TaskGraph *taskGraph = Pi::GetApp()->GetTaskGraph();
+	if (!taskGraph || m_bodies.size() <= BODY_INTEGRATION_GRAIN_SIZE) {
+		for (Body *b : m_bodies)
+			b->IntegrateMotion(step);
+		return;
+	}
+
+	taskGraph->ParallelFor({ 0, uint32_t(m_bodies.size()) }, BODY_INTEGRATION_GRAIN_SIZE, [&](TaskRange range) {
+		for (uint32_t idx = range.begin; idx < range.end; idx++)
+			m_bodies[idx]->IntegrateMotion(step);
+	});
+}
+
+void Space::UpdateInterpTransforms(double alpha)
+{
+	PROFILE_SCOPED()
+
+	// each body only interpolates its own state
+	TaskGraph *taskGraph = Pi::GetApp()->GetTaskGraph();
+	if (!taskGraph || m_bodies.size() <= BODY_INTERPOLATION_GRAIN_SIZE) {
+		for (Body *b : m_bodies)
+			b->UpdateInterpTransform(alpha);
+	} else {
+		taskGraph->ParallelFor({ 0, uint32_t(m_bodies.size()) }, BODY_INTERPOLATION_GRAIN_SIZE, [&](TaskRange range) {
+			for (uint32_t idx = range.begin; idx < range.end; idx++)
+				m_bodies[idx]->UpdateInterpTransform(alpha);
+		});
+	}
+
+	Frame::UpdateInterpTransforms(alpha);
+}
+
+// Ships arrive from and clouds expire at known times, so rather than every
+// cloud checking each step only the clouds that are due are looked at
+void Space::UpdateHyperspaceClouds()
+{
+	const double time = m_game->GetTime();
+	while (!m_cloudEvents.empty() && m_cloudEvents.top().time <= time) {
+		Body *b = m_cloudEvents.top().cloud;
+		m_cloudEvents.pop();
+
+		// the cloud may have been removed, and its address reused, since
+		// the event was queued
+		if (!m_bodySlots.count(b) || b->IsDead() || !b->IsType(ObjectType::HYPERSPACECLOUD))
+			continue;
+
+		// the event may be stale too (the ship was evicted, say), so the
+		// cloud checks what is actually due and says when to look again
+		HyperspaceCloud *cloud = static_cast<HyperspaceCloud *>(b);
+		cloud->ProcessEvents();
+		if (!cloud->IsDead())
+			m_rescheduledCloudEvents.push_back({ cloud->GetNextEventTime(), cloud });
+	}
+
+	// requeued after the loop, as an arrival due exactly now only happens
+	// next step
+	for (const CloudEvent &event : m_rescheduledCloudEvents)
+		m_cloudEvents.push(event);
+	m_rescheduledCloudEvents.clear();
+}
+
 void Space::UpdateBodies()
 {
 	PROFILE_SCOPED()
@@ -1105,21 +1355,28 @@ void Space::UpdateBodies()
 
 	// removing or deleting bodies from space
 	for (const auto &b : m_assignedBodies) {
-		auto remove_iterator = m_bodies.end();
-		for (auto it = m_bodies.begin(); it != m_bodies.end(); ++it) {
-			if (*it != b.first)
-				(*it)->NotifyRemoved(b.first);
-			else
-				remove_iterator = it;
-		}
-		if (remove_iterator != m_bodies.end()) {
-			*remove_iterator = m_bodies.back();
-			m_bodies.pop_back();
-			if (b.second == BodyAssignation::KILL)
-				delete b.first;
-			else
-				b.first->SetFrame(FrameId::Invalid);
+		Body *removed = b.first;
+		if (!m_bodySlots.count(removed))
+			continue;
+
+		for (Body *listener : m_removalListeners)
+			if (listener != removed)
+				listener->NotifyRemoved(removed);
+
+		auto watchers = m_watchers.find(removed);
+		if (watchers != m_watchers.end()) {
+			for (Body *watcher : watchers->second)
+				if (!watcher->WantsAllRemovals())
+					watcher->NotifyRemoved(removed);
 		}
+
+		ProjectileManager::NotifyRemovedAll(removed, m_rootFrameId);
+
+		UnlinkBody(removed);
+		if (b.second == BodyAssignation::KILL)
+			delete removed;
+		else
+			removed->SetFrame(FrameId::Invalid);
 	}
 
 	m_assignedBodies.clear();
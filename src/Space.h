@@ -8,12 +8,17 @@
 #include "FrameId.h"
 #include "IterationProxy.h"
 #include "RefCounted.h"
+#include "core/SpatialHash.h"
 #include "galaxy/StarSystem.h"
 #include "vector3.h"
 
+#include <queue>
+#include <unordered_map>
+
 class Body;
 class Frame;
 class Game;
+class TerrainBody;
 enum class ObjectType;
 
 class Space {
@@ -47,8 +52,24 @@ public:
 	void RemoveBody(Body *);
 	void KillBody(Body *);
 
+	// Have watcher->NotifyRemoved() called when watched leaves space. Bodies
+	// which return true from WantsAllRemovals() don't need this.
+	void WatchBody(Body *watcher, Body *watched);
+
 	void TimeStep(float step);
 
+	// Sets every body's and frame's render transform, interpolated by alpha
+	// between the last two physics ticks
+	void UpdateInterpTransforms(double alpha);
+
+	// Largest multiple, up to maxScale, of the given step which every moving
+	// body can take at once. Bodies only coasting under gravity may take
+	// somewhat longer steps while clear of anything they could hit; anything
+	// else moving keeps the normal step. With nothing but bodies at rest or
+	// on analytic paths (orbit and route rails), the whole maxScale can be
+	// taken as one step, short of where a route rail ends.
+	int GetSafeStepScale(float step, int maxScale);
+
 	void GetHyperspaceExitParams(const SystemPath &source, const SystemPath &dest,
 		vector3d &pos, vector3d &vel) const;
 	vector3d GetHyperspaceExitPoint(const SystemPath &source, const SystemPath &dest) const
@@ -66,11 +87,16 @@ public:
 	Body *FindBodyForPath(const SystemPath *path) const;
 
 	Uint32 GetNumBodies() const { return static_cast<Uint32>(m_bodies.size()); }
+	// true while b is in this space; never dereferences b
+	bool HasBody(const Body *b) const { return m_bodySlots.count(b) != 0; }
 	IterationProxy<std::vector<Body *>> GetBodies() { return MakeIterationProxy(m_bodies); }
 	const IterationProxy<const std::vector<Body *>> GetBodies() const { return MakeIterationProxy(m_bodies); }
 
 	Background::Container *GetBackground() { return m_background.get(); }
 	void RefreshBackground();
+	// starts generating the background of a Space for path, so a jump there
+	// doesn't have to wait for it
+	void PrefetchBackground(const SystemPath &path);
 
 	// body finder delegates
 	typedef const std::vector<Body *> BodyNearList;
@@ -111,9 +137,12 @@ private:
 	// make sure SystemBody* is in Pi::currentSystem
 	FrameId GetFrameWithSystemBody(const SystemBody *b) const;
 
+	void IntegrateBodies(float step);
+	void UpdateHyperspaceClouds();
 	void UpdateBodies();
 
 	void CollideFrame(FrameId fId);
+	void CollideWithTerrain(float step);
 
 	FrameId m_rootFrameId;
 
@@ -135,6 +164,46 @@ private:
 
 	std::vector<std::pair<Body *, BodyAssignation>> m_assignedBodies;
 
+	// where a body is in m_bodies and m_removalListeners, for O(1) removal
+	struct BodySlot {
+		size_t index;
+		size_t listenerIndex;
+	};
+	static constexpr size_t NO_SLOT = ~size_t(0);
+	std::unordered_map<const Body *, BodySlot> m_bodySlots;
+
+	// bodies told about every removal
+	std::vector<Body *> m_removalListeners;
+
+	// hyperspace cloud arrivals and expiries, soonest first. entries for
+	// clouds that have since left space are skipped when they come up
+	struct CloudEvent {
+		double time;
+		Body *cloud;
+		bool operator>(const CloudEvent &other) const { return time > other.time; }
+	};
+	std::priority_queue<CloudEvent, std::vector<CloudEvent>, std::greater<CloudEvent>> m_cloudEvents;
+	std::vector<CloudEvent> m_rescheduledCloudEvents;
+
+	// CollideWithTerrain() scratch space
+	struct TerrainQuery {
+		Body *body;
+		TerrainBody *terrain;
+		vector3d dir;
+		double altitude;
+	};
+	std::vector<TerrainQuery> m_terrainQueries;
+	std::vector<TerrainBody *> m_queriedTerrains;
+	std::vector<vector3d> m_terrainDirs;
+	std::vector<double> m_terrainHeights;
+	std::vector<const TerrainQuery *> m_terrainBatch;
+	// bodies told about the removal of specific other bodies, and the reverse
+	std::unordered_map<const Body *, std::vector<Body *>> m_watchers;
+	std::unordered_map<const Body *, std::vector<Body *>> m_watching;
+
+	void LinkBody(Body *b);
+	void UnlinkBody(Body *b);
+
 	void RebuildBodyIndex();
 	void RebuildSystemBodyIndex();
 
@@ -150,8 +219,13 @@ private:
 
 	class BodyNearFinder {
 	public:
+		// finest cells fit ECM-range queries, coarser levels serve sensor
+		// and radar ranges
+		static constexpr double CELL_SIZE = 10000.0;
+
 		BodyNearFinder(const Space *space) :
-			m_space(space) {}
+			m_space(space),
+			m_bodyHash(CELL_SIZE, SpatialHash<Body *>::MAX_LEVELS) {}
 		void Prepare();
 
 		BodyNearList GetBodiesMaybeNear(const Body *b, double dist);
@@ -159,7 +233,8 @@ private:
 
 	private:
 		const Space *m_space;
-		std::vector<BodyDist> m_bodyDist;
+		// body positions relative to the root frame as of the last Prepare()
+		SpatialHash<Body *> m_bodyHash;
 		std::vector<Body *> m_nearBodies;
 	};
 
@@ -160,6 +160,7 @@ void SpaceStation::PostLoadFixup(Space *space)
 	for (Uint32 i = 0; i < m_shipDocking.size(); i++) {
 		auto &sd = m_shipDocking[i];
 		sd.ship = static_cast<Ship *>(space->GetBodyByIndex(m_shipDocking[i].shipIndex));
+		UpdateBayState(i);
 
 		if (!sd.ship) continue;
 
@@ -178,14 +179,7 @@ void SpaceStation::InitStation()
 		m_staticSlot[i] = false;
 	Random rand(m_sbody->GetSeed());
 	const bool ground = m_sbody->GetType() == SystemBody::TYPE_STARPORT_ORBITAL ? false : true;
-	const std::string &space_station_type = m_sbody->GetSpaceStationType();
-	if (space_station_type != "") {
-		m_type = SpaceStationType::FindByName(space_station_type);
-		if (m_type == nullptr)
-			Output("WARNING: SpaceStation::InitStation wants to initialize a custom station of type %s, but no station type with that id has been found.\n", space_station_type.c_str());
-	}
-	if (m_type == nullptr)
-		m_type = SpaceStationType::RandomStationType(rand, ground);
+	m_type = SpaceStationType::ForSystemBody(m_sbody, rand);
 
 	if (m_shipDocking.empty()) {
 		m_shipDocking.reserve(m_type->NumDockingPorts());
@@ -223,6 +217,8 @@ void SpaceStation::InitStation()
 
 	m_navLights.reset(new NavLights(model, 2.2f));
 	m_navLights->SetEnabled(true);
+	for (Uint32 i = 0; i < m_shipDocking.size(); i++)
+		UpdateBayState(i);
 
 	if (ground) SetClipRadius(CityOnPlanet::RADIUS); // overrides setmodel
 
@@ -248,6 +244,7 @@ void SpaceStation::NotifyRemoved(const Body *const removedBody)
 	for (Uint32 i = 0; i < m_shipDocking.size(); i++) {
 		if (m_shipDocking[i].ship == removedBody) {
 			m_shipDocking[i].ship = 0;
+			UpdateBayState(i);
 		}
 	}
 }
@@ -374,6 +371,10 @@ bool SpaceStation::GetDockingClearance(Ship *s)
 	const Aabb &bbox = s->GetAabb();
 	const float bboxRad = vector2f(float(bbox.max.x), float(bbox.max.z)).Length();
 
+	// distance-to-station check, which only refuses once a free bay is found
+	const double requestDist = 100000.0; //100km
+	const bool tooFar = s->IsType(ObjectType::PLAYER) && s->GetPositionRelTo(this).LengthSqr() > requestDist * requestDist;
+
 	for (Uint32 i = 0; i < m_shipDocking.size(); i++) {
 		// initial unoccupied check
 		if (m_shipDocking[i].ship != 0) continue;
@@ -382,10 +383,7 @@ bool SpaceStation::GetDockingClearance(Ship *s)
 		const SpaceStationType::SPort *const pPort = m_type->FindPortByBay(i);
 		if (!pPort) continue;
 
-		// distance-to-station check
-		const double shipDist = s->GetPositionRelTo(this).Length();
-		double requestDist = 100000.0; //100km
-		if (s->IsType(ObjectType::PLAYER) && shipDist > requestDist) {
+		if (tooFar) {
 			LuaEvent::Queue("onDockingClearanceDenied", this, s,
 				EnumStrings::GetString("DockingRefusedReason", int(DockingRefusedReason::TooFarFromStation)));
 			return false;
@@ -553,13 +551,48 @@ void SpaceStation::SwitchToStage(Uint32 bay, DockStage stage)
 		dt.stage = stage;
 		break;
 	}
+
+	UpdateBayState(bay);
+}
+
+void SpaceStation::UpdateBayState(Uint32 bay)
+{
+	shipDocking_t &dt = m_shipDocking[bay];
+
+	// docked ships only need moving along with the station
+	const bool busy = dt.ship && dt.stage != DockStage::DOCKED;
+	if (busy != dt.busy) {
+		dt.busy = busy;
+		if (busy)
+			m_numBusyBays++;
+		else
+			m_numBusyBays--;
+	}
+
+	if (!m_navLights) return;
+	if (!dt.ship) { //free
+		m_navLights->SetColor(bay + 1, NavLights::NAVLIGHT_OFF);
+		return;
+	}
+	if (SpaceStationType::IsDockStage(dt.stage)) {
+		m_navLights->SetColor(bay + 1, NavLights::NAVLIGHT_GREEN);
+		m_navLights->SetMask(bay + 1, 0x33); // 00110011 on two off two
+	}
+	if (SpaceStationType::IsUndockStage(dt.stage)) { // undocking anim
+		m_navLights->SetColor(bay + 1, NavLights::NAVLIGHT_YELLOW);
+	}
+	if (dt.stage == DockStage::JUST_DOCK) { // just docked
+		m_navLights->SetColor(bay + 1, NavLights::NAVLIGHT_BLUE);
+		m_navLights->SetMask(bay + 1, 0xf6); // 11110110
+	}
 }
 
 void SpaceStation::DockingUpdate(const double timeStep)
 {
-	for (Uint32 i = 0; i < m_shipDocking.size(); i++) {
+	// most of the time every bay is free or holds a docked ship
+	for (Uint32 i = 0; m_numBusyBays > 0 && i < m_shipDocking.size(); i++) {
 		shipDocking_t &dt = m_shipDocking[i];
-		if (!dt.ship) continue;
+		if (!dt.busy) continue;
 
 		switch (dt.stage) {
 
@@ -731,24 +764,11 @@ void SpaceStation::TimeStepUpdate(const float timeStep)
 	}
 	m_oldAngDisplacement = len;
 
-	// reposition the ships that are docked or docking here
+	// reposition the ships that are docked or docking here; the nav lights
+	// follow the stages in UpdateBayState()
 	for (unsigned int i = 0; i < m_type->NumDockingPorts(); i++) {
 		const shipDocking_t &dt = m_shipDocking[i];
-		if (!dt.ship) { //free
-			m_navLights->SetColor(i + 1, NavLights::NAVLIGHT_OFF);
-			continue;
-		}
-		if (SpaceStationType::IsDockStage(dt.stage)) {
-			m_navLights->SetColor(i + 1, NavLights::NAVLIGHT_GREEN);
-			m_navLights->SetMask(i + 1, 0x33); // 00110011 on two off two
-		}
-		if (SpaceStationType::IsUndockStage(dt.stage)) { // undocking anim
-			m_navLights->SetColor(i + 1, NavLights::NAVLIGHT_YELLOW);
-		}
-		if (dt.stage == DockStage::JUST_DOCK) { // just docked
-			m_navLights->SetColor(i + 1, NavLights::NAVLIGHT_BLUE);
-			m_navLights->SetMask(i + 1, 0xf6); // 11110110
-		}
+		if (!dt.ship) continue;
 		if (dt.ship->GetFlightState() == Ship::DOCKED) { //docked
 			PositionDockedShip(dt.ship, i);
 		} else if (dt.ship->GetFlightState() == Ship::DOCKING || dt.ship->GetFlightState() == Ship::UNDOCKING) {
@@ -786,7 +806,6 @@ void SpaceStation::Render(Graphics::Renderer *r, const Camera *camera, const vec
 	if (!b->IsType(ObjectType::PLANET)) {
 		// orbital spaceport -- don't make city turds or change lighting based on atmosphere
 		RenderModel(r, camera, viewCoords, viewTransform);
-		m_navLights->Render(r);
 		r->GetStats().AddToStatCount(Graphics::Stats::STAT_SPACESTATIONS, 1);
 	} else {
 		// don't render city if too far away
@@ -794,16 +813,14 @@ void SpaceStation::Render(Graphics::Renderer *r, const Camera *camera, const vec
 			return;
 		}
 
-		if (!m_adjacentCity) {
+		if (!m_adjacentCity)
 			m_adjacentCity = new CityOnPlanet(static_cast<Planet *>(b), this, m_sbody->GetSeed());
-			// Update clipping radius
-			SetClipRadius(m_adjacentCity->GetClipRadius());
-		}
+		// Update clipping radius, which is only known once the city's layout is ready
+		SetClipRadius(m_adjacentCity->GetClipRadius());
 
 		m_adjacentCity->Render(r, camera->GetContext()->GetFrustum(), this, viewCoords, viewTransform);
 
 		RenderModel(r, camera, viewCoords, viewTransform);
-		m_navLights->Render(r);
 
 		r->GetStats().AddToStatCount(Graphics::Stats::STAT_GROUNDSTATIONS, 1);
 	}
@@ -54,6 +54,7 @@ public:
 	virtual const SystemBody *GetSystemBody() const override { return m_sbody; }
 	virtual void PostLoadFixup(Space *space) override;
 	virtual void NotifyRemoved(const Body *const removedBody) override;
+	virtual bool WantsAllRemovals() const override { return true; }
 
 	virtual void SetLabel(const std::string &label) override;
 
@@ -70,6 +71,8 @@ public:
 	int GetFreeDockingPort(const Ship *s) const; // returns -1 if none free
 	int GetMyDockingPort(const Ship *s) const;
 	int NumShipsDocked() const;
+	// true while any ship is docking or undocking
+	bool HasBusyBays() const { return m_numBusyBays > 0; }
 
 	const SpaceStationType *GetStationType() const { return m_type; }
 	bool IsGroundStation() const;
@@ -104,7 +107,8 @@ private:
 			stagePos(0),
 			fromPos(0.0),
 			fromRot(1.0, 0.0, 0.0, 0.0),
-			maxOffset(0)
+			maxOffset(0),
+			busy(false)
 		{}
 
 		Ship *ship;
@@ -114,6 +118,7 @@ private:
 		vector3d fromPos; // in station model coords
 		Quaterniond fromRot;
 		double maxOffset;
+		bool busy; // stepped by DockingUpdate(), see UpdateBayState()
 	};
 	typedef std::vector<shipDocking_t>::const_iterator constShipDockingIter;
 	typedef std::vector<shipDocking_t>::iterator shipDockingIter;
@@ -124,6 +129,9 @@ private:
 	double m_oldAngDisplacement;
 
 	void SwitchToStage(Uint32 bay, DockStage stage);
+	// keeps the bay's nav lights and busy flag in step with its ship and stage
+	void UpdateBayState(Uint32 bay);
+	Uint32 m_numBusyBays = 0;
 	matrix4x4d GetBayTransform(Uint32 bay) const;
 
 	void InitStation();
@@ -8,6 +8,7 @@
 #include "Pi.h"
 #include "Ship.h"
 #include "StringF.h"
+#include "galaxy/SystemBody.h"
 #include "scenegraph/Tag.h"
 #include "scenegraph/Model.h"
 #include "utils.h"
@@ -20,6 +21,7 @@ struct StationTypeLoadError {};
 
 std::vector<SpaceStationType> SpaceStationType::surfaceTypes;
 std::vector<SpaceStationType> SpaceStationType::orbitalTypes;
+FlatHashMap<std::string_view, const SpaceStationType *> SpaceStationType::typesById;
 
 SpaceStationType::SpaceStationType(const std::string &id_, const std::string &path_) :
 	id(id_),
@@ -287,6 +289,12 @@ void SpaceStationType::Init()
 			}
 		}
 	}
+
+	// the vectors are complete, so pointers into them stay valid
+	for (const SpaceStationType &st : surfaceTypes)
+		typesById.emplace(st.id, &st);
+	for (const SpaceStationType &st : orbitalTypes)
+		typesById.emplace(st.id, &st);
 }
 
 /*static*/
@@ -302,13 +310,25 @@ const SpaceStationType *SpaceStationType::RandomStationType(Random &random, cons
 /*static*/
 const SpaceStationType *SpaceStationType::FindByName(const std::string &name)
 {
-	for (auto &sst : surfaceTypes)
-		if (sst.id == name)
-			return &sst;
-	for (auto &sst : orbitalTypes)
-		if (sst.id == name)
-			return &sst;
-	return nullptr;
+	auto type = typesById.find(name);
+	return type == typesById.end() ? nullptr : type->second;
+}
+
+/*static*/
+const SpaceStationType *SpaceStationType::ForSystemBody(const SystemBody *sbody, Random &rand)
+{
+	const SpaceStationType *type = nullptr;
+	const std::string &space_station_type = sbody->GetSpaceStationType();
+	if (space_station_type != "") {
+		type = FindByName(space_station_type);
+		if (type == nullptr)
+			Output("WARNING: SpaceStationType::ForSystemBody wants a custom station of type %s, but no station type with that id has been found.\n", space_station_type.c_str());
+	}
+	if (type == nullptr) {
+		const bool ground = sbody->GetType() == SystemBody::TYPE_STARPORT_ORBITAL ? false : true;
+		type = RandomStationType(rand, ground);
+	}
+	return type;
 }
 
 DockStage SpaceStationType::PivotStage(DockStage s) const {
@@ -5,16 +5,19 @@
 #define _SPACESTATIONTYPE_H
 
 #include "Random.h"
+#include "core/FlatHashMap.h"
 #include "matrix4x4.h"
 #include "vector3.h"
 
 #include <map>
 #include <vector>
 #include <string>
+#include <string_view>
 
 //Space station definition, loaded from data/stations
 
 class Ship;
+class SystemBody;
 namespace SceneGraph {
 	class Model;
 }
@@ -117,6 +120,8 @@ private:
 
 	static std::vector<SpaceStationType> surfaceTypes;
 	static std::vector<SpaceStationType> orbitalTypes;
+	// both of the above by id, built once they have been loaded
+	static FlatHashMap<std::string_view, const SpaceStationType *> typesById;
 
 public:
 	SpaceStationType(const std::string &id, const std::string &path);
@@ -165,6 +170,9 @@ public:
 
 	static const SpaceStationType *RandomStationType(Random &random, const bool bIsGround);
 	static const SpaceStationType *FindByName(const std::string &name);
+	// the type a station for sbody gets: its custom type if it has one,
+	// otherwise one picked with rand, which should be seeded from sbody
+	static const SpaceStationType *ForSystemBody(const SystemBody *sbody, Random &rand);
 };
 
 #endif
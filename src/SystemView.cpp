@@ -34,6 +34,9 @@
 using namespace Graphics;
 
 static constexpr Uint16 N_VERTICES_MAX = 100;
+static constexpr Uint16 N_VERTICES_MIN = 24;
+// fraction of a segment the body may move along its orbit before the line is rebuilt
+static constexpr double ORBIT_ANOMALY_TOLERANCE = 0.1;
 static const float MIN_ZOOM = 1e-30f; // Just to avoid having 0
 static const float MAX_ZOOM = 1e30f;
 static const float MIN_ATLAS_ZOOM = 0.5f; // Just to avoid having 0
@@ -230,9 +233,7 @@ void SystemView::Update()
 
 			const double plannerStartTime = m_planner->GetStartTime();
 			if (!m_planner->GetPosition().ExactlyEqual(vector3d(0, 0, 0))) {
-				Orbit plannedOrbit = Orbit::FromBodyState(m_planner->GetPosition(),
-					m_planner->GetVel(),
-					playerAround->GetMass());
+				const Orbit &plannedOrbit = m_planner->GetPlannedOrbit(playerAround->GetMass());
 
 				m_map->AddOrbitTrack({ Projectable::ORBIT, Projectable::PLANNER, PlayerBody, offset }, &plannedOrbit, m_map->svColor[Col::PLANNER_ORBIT], planetRadius);
 				if (std::fabs(time - m_game->GetTime()) > 1. && (time - plannerStartTime) > 0.)
@@ -377,69 +378,118 @@ void SystemMapViewport::SetCurrentSystem(RefCountedPtr<StarSystem> system)
 	ClearSelectedObject();
 
 	m_system = system;
+	m_orbitLines.clear();
+
+	m_bodyOrbits.Clear();
+	m_bodyPositions.clear();
 
 	if (m_system) {
 		SystemBody *body = m_system->GetRootBody().Get();
 		m_atlasLayout = {};
 		m_atlasLayout.isVertical = body->GetType() == SystemBody::TYPE_GRAVPOINT;
 		LayoutSystemBody(body, m_atlasLayout);
+
+		for (const RefCountedPtr<SystemBody> &b : m_system->GetBodies())
+			m_bodyOrbits.Add(b->GetOrbit());
 	}
 
 	ResetViewpoint();
 }
 
-void SystemMapViewport::RenderOrbit(Projectable p, const ProjectedOrbit *orbitData, const vector3d &offset)
+static bool same_orbit_shape(const Orbit &a, const Orbit &b)
 {
-	PROFILE_SCOPED()
-
-	double ecc = orbitData->orbit.GetEccentricity();
-	double timeshift = ecc > 0.6 ? 0.0 : 0.5;
-	double maxT = 1.;
-	unsigned short num_vertices = 0;
-	for (unsigned short i = 0; i < N_VERTICES_MAX; ++i) {
-		const double t = (double(i) + timeshift) / double(N_VERTICES_MAX);
-		const vector3d pos = orbitData->orbit.EvenSpacedPosTrajectory(t);
-		if (pos.Length() < orbitData->planetRadius) {
-			maxT = t;
-			break;
-		}
-	}
+	return a.GetEccentricity() == b.GetEccentricity() &&
+		a.GetSemiMajorAxis() == b.GetSemiMajorAxis() &&
+		a.GetOrbitalPhaseAtStart() == b.GetOrbitalPhaseAtStart() &&
+		0 == memcmp(&a.GetPlane(), &b.GetPlane(), sizeof(matrix3x3d));
+}
 
-	static const float startTrailPercent = 0.85;
-	static const float fadedColorParameter = 0.8;
+void SystemMapViewport::RenderOrbit(Projectable p, const ProjectedOrbit *orbitData, const vector3d &offset, double projectedSize)
+{
+	PROFILE_SCOPED()
 
-	Uint16 fadingColors = 0;
+	const Orbit &orbit = orbitData->orbit;
+	double ecc = orbit.GetEccentricity();
 	const double tMinust0 = p.base == Projectable::SYSTEMBODY ? m_time : m_time - m_refTime;
-	for (unsigned short i = 0; i < N_VERTICES_MAX; ++i) {
-		const double t = (double(i) + timeshift) / double(N_VERTICES_MAX) * maxT;
-		if (fadingColors == 0 && t >= startTrailPercent * maxT)
-			fadingColors = i;
-		const vector3d pos = orbitData->orbit.EvenSpacedPosTrajectory(t, tMinust0);
-		m_orbitVts[i] = vector3f(offset + pos);
-		++num_vertices;
-		if (pos.Length() < orbitData->planetRadius)
-			break;
-	}
+	const double trueAnomaly = orbit.TrueAnomalyAtTime(tMinust0);
+
+	// orbits that are small on screen get fewer segments; very eccentric ones
+	// keep the full count so the periapsis stays smooth
+	const Uint16 numSegments = ecc > 0.6 ? N_VERTICES_MAX :
+		Uint16(Clamp(int(std::ceil(projectedSize * N_VERTICES_MAX)), int(N_VERTICES_MIN), int(N_VERTICES_MAX)));
+
+	OrbitLine &line = m_orbitLines[{ int(p.base), p.getRef() }];
+	line.used = true;
+
+	const bool rebuild = line.numSegments != numSegments ||
+		!same_orbit_shape(line.orbit, orbit) ||
+		!(line.color == orbitData->color) ||
+		line.planetRadius != orbitData->planetRadius ||
+		std::abs(trueAnomaly - line.trueAnomaly) > ORBIT_ANOMALY_TOLERANCE * 2.0 * M_PI / numSegments;
+
+	if (rebuild) {
+		PROFILE_SCOPED_DESC("Rebuild Orbit Line")
+		double timeshift = ecc > 0.6 ? 0.0 : 0.5;
+		double maxT = 1.;
+		const double startAnomaly = orbit.TrueAnomalyAtTime(0.0);
+		for (unsigned short i = 0; i < numSegments; ++i) {
+			const double t = (double(i) + timeshift) / double(numSegments);
+			const vector3d pos = orbit.EvenSpacedPosTrajectoryFromAnomaly(t, startAnomaly);
+			if (pos.Length() < orbitData->planetRadius) {
+				maxT = t;
+				break;
+			}
+		}
 
-	if (num_vertices > 1) {
-		//close the loop for thin ellipses
-		if (!(maxT < 1. || ecc > 1.0 || ecc < 0.6)) {
-			m_orbitVts[num_vertices] = m_orbitVts[0];
-			m_orbitColors[num_vertices] = m_orbitColors[0];
+		static const float startTrailPercent = 0.85;
+		static const float fadedColorParameter = 0.8;
+
+		Uint16 fadingColors = 0;
+		unsigned short num_vertices = 0;
+		for (unsigned short i = 0; i < numSegments; ++i) {
+			const double t = (double(i) + timeshift) / double(numSegments) * maxT;
+			if (fadingColors == 0 && t >= startTrailPercent * maxT)
+				fadingColors = i;
+			const vector3d pos = orbit.EvenSpacedPosTrajectoryFromAnomaly(t, trueAnomaly);
+			// vertices are relative to the orbit's focus; the offset is applied as a transform
+			m_orbitVts[i] = vector3f(pos);
 			++num_vertices;
+			if (pos.Length() < orbitData->planetRadius)
+				break;
 		}
 
-		// fade trail
-		const Color fadedColor = orbitData->color * fadedColorParameter;
-		std::fill_n(m_orbitColors.get(), num_vertices, fadedColor);
-		const Uint16 trailLength = num_vertices - fadingColors;
-		for (Uint16 currentColor = 0; currentColor < trailLength; ++currentColor) {
-			float scalingParameter = (1.f - static_cast<float>(currentColor) / (trailLength - 1));
-			m_orbitColors[currentColor + fadingColors] = fadedColor * scalingParameter;
+		if (num_vertices > 1) {
+			//close the loop for thin ellipses
+			if (!(maxT < 1. || ecc > 1.0 || ecc < 0.6)) {
+				m_orbitVts[num_vertices] = m_orbitVts[0];
+				m_orbitColors[num_vertices] = m_orbitColors[0];
+				++num_vertices;
+			}
+
+			// fade trail
+			const Color fadedColor = orbitData->color * fadedColorParameter;
+			std::fill_n(m_orbitColors.get(), num_vertices, fadedColor);
+			const Uint16 trailLength = num_vertices - fadingColors;
+			for (Uint16 currentColor = 0; currentColor < trailLength; ++currentColor) {
+				float scalingParameter = (1.f - static_cast<float>(currentColor) / (trailLength - 1));
+				m_orbitColors[currentColor + fadingColors] = fadedColor * scalingParameter;
+			}
+
+			line.lines.SetData(num_vertices, m_orbitVts.get(), m_orbitColors.get());
 		}
 
-		m_orbits.SetData(num_vertices, m_orbitVts.get(), m_orbitColors.get());
-		m_orbits.Draw(m_renderer, m_lineMat.get());
+		line.orbit = orbit;
+		line.color = orbitData->color;
+		line.planetRadius = orbitData->planetRadius;
+		line.trueAnomaly = trueAnomaly;
+		line.numSegments = numSegments;
+		line.numVertices = num_vertices;
+	}
+
+	if (line.numVertices > 1) {
+		m_renderer->SetTransform(m_cameraSpace * matrix4x4f::Translation(vector3f(offset)));
+		line.lines.Draw(m_renderer, m_lineMat.get());
+		m_renderer->SetTransform(m_cameraSpace);
 	}
 
 	AddProjected(p, Projectable::PERIAPSIS, offset + orbitData->orbit.Perigeum());
@@ -452,10 +502,10 @@ void SystemMapViewport::RenderOrbit(Projectable p, const ProjectedOrbit *orbitDa
 	const bool showLagrange = (bst == SystemBody::SUPERTYPE_ROCKY_PLANET || bst == SystemBody::SUPERTYPE_GAS_GIANT);
 
 	if (showLagrange && m_showL4L5 != LAG_OFF) {
-		const vector3d posL4 = orbitData->orbit.EvenSpacedPosTrajectory((1.0 / 360.0) * 60.0, tMinust0);
+		const vector3d posL4 = orbitData->orbit.EvenSpacedPosTrajectoryFromAnomaly((1.0 / 360.0) * 60.0, trueAnomaly);
 		AddProjected(p, Projectable::L4, offset + posL4);
 
-		const vector3d posL5 = orbitData->orbit.EvenSpacedPosTrajectory((1.0 / 360.0) * 300.0, tMinust0);
+		const vector3d posL5 = orbitData->orbit.EvenSpacedPosTrajectoryFromAnomaly((1.0 / 360.0) * 300.0, trueAnomaly);
 		AddProjected(p, Projectable::L5, offset + posL5);
 	}
 }
@@ -502,7 +552,7 @@ void SystemMapViewport::AddBodyTrack(const SystemBody *b, const vector3d &offset
 			}
 
 			// not using current time yet
-			AddBodyTrack(kid, offset + kid->GetOrbit().OrbitalPosAtTime(m_time));
+			AddBodyTrack(kid, offset + m_bodyPositions[kid->GetPath().bodyIndex]);
 		}
 	}
 }
@@ -647,8 +697,9 @@ void SystemMapViewport::DrawOrreryView()
 
 			//semimajor axis radius should be at least 1% of screen width to show the orbit
 			//FIXME: this has never worked, the returned size is not in screen %
-			if (ProjectedSize(axisZoom, viewpos) > 0.01) {
-				RenderOrbit(track, orbitData, viewpos);
+			const double projectedSize = ProjectedSize(axisZoom, viewpos);
+			if (projectedSize > 0.01) {
+				RenderOrbit(track, orbitData, viewpos, projectedSize);
 			}
 		} else {
 			AddProjected(track, track.type, viewpos);
@@ -659,6 +710,16 @@ void SystemMapViewport::DrawOrreryView()
 		}
 	}
 
+	// forget orbit lines that weren't drawn this frame
+	for (auto it = m_orbitLines.begin(); it != m_orbitLines.end();) {
+		if (!it->second.used) {
+			it = m_orbitLines.erase(it);
+		} else {
+			it->second.used = false;
+			++it;
+		}
+	}
+
 	m_renderer->SetTransform(m_cameraSpace);
 
 	if (m_gridDrawing != GridDrawing::OFF) {
@@ -924,6 +985,7 @@ void SystemMapViewport::Update(float ft)
 	if (m_displayMode == SystemView::Mode::Orrery) {
 		if (m_system && !m_system->GetUnexplored() && m_system->GetRootBody()) {
 			// all systembodies draws here
+			m_bodyOrbits.Propagate(m_time, m_bodyPositions);
 			AddBodyTrack(m_system->GetRootBody().Get(), vector3d(0, 0, 0));
 		}
 	}
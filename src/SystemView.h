@@ -11,6 +11,7 @@
 #include "Frame.h"
 #include "Input.h"
 #include "Orbit.h"
+#include "OrbitPropagator.h"
 #include "TransferPlanner.h"
 #include "enum_table.h"
 #include "graphics/Drawables.h"
@@ -19,6 +20,7 @@
 #include "pigui/PiGuiView.h"
 #include "vector3.h"
 
+#include <map>
 #include <sigc++/signal.h>
 
 class GuiApplication;
@@ -324,7 +326,7 @@ private:
 	// Project a track to screenspace with the current renderer state and add it to the list of projected objects
 	void AddProjected(Projectable p, Projectable::types type, const vector3d &transformedPos, float screensize = 0.f);
 	void RenderBody(const SystemBody *b, const vector3d &pos, const matrix4x4f &trans);
-	void RenderOrbit(Projectable p, const ProjectedOrbit *orbitData, const vector3d &transformedPos);
+	void RenderOrbit(Projectable p, const ProjectedOrbit *orbitData, const vector3d &transformedPos, double projectedSize);
 
 	// draw a grid with `radius` * 2 gridlines on an evenly spaced 1-AU grid
 	void DrawGrid(uint32_t radius);
@@ -374,12 +376,31 @@ private:
 	bool m_realtime;
 	double m_timeStep;
 
+	// orbits of the system's bodies, by body index, propagated together
+	// for the orrery each frame
+	OrbitPropagator m_bodyOrbits;
+	std::vector<vector3d> m_bodyPositions;
+
 	std::unique_ptr<Graphics::Drawables::Disk> m_bodyIcon;
 	std::unique_ptr<Graphics::Material> m_bodyMat;
 	std::unique_ptr<Graphics::Material> m_atlasMat;
 	std::unique_ptr<Graphics::Material> m_lineMat;
 	std::unique_ptr<Graphics::Material> m_gridMat;
-	Graphics::Drawables::Lines m_orbits;
+
+	// Orbit lines kept between frames, keyed by the track's base and referent.
+	// A line is rebuilt only when its orbit, colour or segment count changes,
+	// or the body has moved along it by more than a fraction of a segment.
+	struct OrbitLine {
+		Graphics::Drawables::Lines lines;
+		Orbit orbit;
+		Color color;
+		double planetRadius = 0.0;
+		double trueAnomaly = 0.0;
+		Uint16 numSegments = 0;
+		Uint16 numVertices = 0;
+		bool used = false;
+	};
+	std::map<std::pair<int, const void *>, OrbitLine> m_orbitLines;
 
 	std::unique_ptr<vector3f[]> m_orbitVts;
 	std::unique_ptr<Color[]> m_orbitColors;
@@ -12,6 +12,8 @@
 #include "galaxy/SystemBody.h"
 #include "graphics/Renderer.h"
 
+#include <algorithm>
+
 TerrainBody::TerrainBody(SystemBody *sbody) :
 	Body(),
 	m_sbody(sbody),
@@ -150,6 +152,63 @@ double TerrainBody::GetTerrainHeight(const vector3d &pos_) const
 	}
 }
 
+Terrain *TerrainBody::GetTerrain() const
+{
+	return m_baseSphere ? m_baseSphere->GetTerrain() : nullptr;
+}
+
+// enough for every body resting on or skimming a planet
+static const size_t HEIGHT_CACHE_SIZE = 64;
+// in metres along the surface
+static const double HEIGHT_CACHE_TOLERANCE = 0.02;
+
+void TerrainBody::GetTerrainHeights(const vector3d *dirs, double *heights, size_t count) const
+{
+	PROFILE_SCOPED()
+	assert(m_baseSphere);
+	const double radius = m_sbody->GetRadius();
+	const double tolerance = HEIGHT_CACHE_TOLERANCE / radius;
+	m_heightCacheTick++;
+
+	m_missDirs.clear();
+	m_missIndices.clear();
+	for (size_t i = 0; i < count; i++) {
+		bool found = false;
+		for (HeightCacheEntry &entry : m_heightCache) {
+			if ((entry.dir - dirs[i]).LengthSqr() < tolerance * tolerance) {
+				heights[i] = entry.height;
+				entry.lastUsed = m_heightCacheTick;
+				found = true;
+				break;
+			}
+		}
+		if (!found) {
+			m_missDirs.push_back(dirs[i]);
+			m_missIndices.push_back(i);
+		}
+	}
+	if (m_missDirs.empty())
+		return;
+
+	m_missHeights.resize(m_missDirs.size());
+	m_baseSphere->GetHeights(m_missDirs.data(), m_missHeights.data(), m_missDirs.size());
+
+	for (size_t j = 0; j < m_missDirs.size(); j++) {
+		const double height = radius * (1.0 + m_missHeights[j]);
+		heights[m_missIndices[j]] = height;
+
+		// replace the least recently used entry once full
+		const HeightCacheEntry entry = { m_missDirs[j], height, m_heightCacheTick };
+		if (m_heightCache.size() < HEIGHT_CACHE_SIZE) {
+			m_heightCache.push_back(entry);
+		} else {
+			auto oldest = std::min_element(m_heightCache.begin(), m_heightCache.end(),
+				[](const HeightCacheEntry &a, const HeightCacheEntry &b) { return a.lastUsed < b.lastUsed; });
+			*oldest = entry;
+		}
+	}
+}
+
 //static
 void TerrainBody::OnChangeDetailLevel()
 {
@@ -8,7 +8,10 @@
 #include "JsonFwd.h"
 #include "matrix4x4.h"
 
+#include <vector>
+
 class BaseSphere;
+class Terrain;
 class Camera;
 class Frame;
 class Space;
@@ -28,6 +31,12 @@ public:
 	virtual bool OnCollision(Body *b, Uint32 flags, double relVel) override { return true; }
 	virtual double GetMass() const override { return m_mass; }
 	double GetTerrainHeight(const vector3d &pos) const;
+	// GetTerrainHeight() for count unit directions at once, reusing recent
+	// results for directions within a few centimetres of an earlier query.
+	// For the physics update; not thread-safe.
+	void GetTerrainHeights(const vector3d *dirs, double *heights, size_t count) const;
+	// the height and colour generator; safe to read from worker threads
+	Terrain *GetTerrain() const;
 	virtual const SystemBody *GetSystemBody() const override { return m_sbody; }
 
 	// returns value in metres
@@ -51,6 +60,18 @@ private:
 	double m_mass;
 	std::unique_ptr<BaseSphere> m_baseSphere;
 	double m_maxFeatureHeight;
+
+	struct HeightCacheEntry {
+		vector3d dir;
+		double height;
+		Uint32 lastUsed;
+	};
+	mutable std::vector<HeightCacheEntry> m_heightCache;
+	mutable Uint32 m_heightCacheTick = 0;
+	// GetTerrainHeights() scratch space
+	mutable std::vector<vector3d> m_missDirs;
+	mutable std::vector<double> m_missHeights;
+	mutable std::vector<size_t> m_missIndices;
 };
 
 #endif
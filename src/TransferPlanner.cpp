@@ -13,7 +13,9 @@
 
 TransferPlanner::TransferPlanner() :
 	m_position(0., 0., 0.),
-	m_velocity(0., 0., 0.)
+	m_velocity(0., 0., 0.),
+	m_plannedPosition(0., 0., 0.),
+	m_plannedVelocity(0., 0., 0.)
 {
 	m_dvPrograde = 0.0;
 	m_dvNormal = 0.0;
@@ -141,6 +143,18 @@ void TransferPlanner::DecreaseFactor(void)
 	m_factor /= m_factorFactor;
 }
 
+const Orbit &TransferPlanner::GetPlannedOrbit(double centralMass)
+{
+	const vector3d velocity = GetVel();
+	if (!m_position.ExactlyEqual(m_plannedPosition) || !velocity.ExactlyEqual(m_plannedVelocity) || centralMass != m_plannedMass) {
+		m_plannedOrbit = Orbit::FromBodyState(m_position, velocity, centralMass);
+		m_plannedPosition = m_position;
+		m_plannedVelocity = velocity;
+		m_plannedMass = centralMass;
+	}
+	return m_plannedOrbit;
+}
+
 vector3d TransferPlanner::GetPosition() const { return m_position; }
 
 void TransferPlanner::SetPosition(const vector3d &position) { m_position = position; }
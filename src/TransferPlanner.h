@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include "Orbit.h"
 #include "vector3.h"
 
 class TransferPlanner {
@@ -28,6 +29,11 @@ public:
 	void ResetDv(BurnDirection d);
 	void ResetDv();
 
+	// the orbit after the burn, with t = 0 at the start time. Only
+	// meaningful while GetPosition() is non-zero; kept until the plan or
+	// the central mass changes, so views can ask for it every frame.
+	const Orbit &GetPlannedOrbit(double centralMass);
+
 private:
 	double m_dvPrograde;
 	double m_dvNormal;
@@ -37,4 +43,10 @@ private:
 	vector3d m_position;
 	vector3d m_velocity;
 	double m_startTime;
+
+	// inputs of m_plannedOrbit
+	vector3d m_plannedPosition;
+	vector3d m_plannedVelocity;
+	double m_plannedMass = 0.0;
+	Orbit m_plannedOrbit;
 };
@@ -17,6 +17,7 @@
 #include "SDL_keycode.h"
 #include "SectorView.h"
 #include "Sensors.h"
+#include "Space.h"
 #include "SpeedLines.h"
 #include "StringF.h"
 #include "graphics/Frustum.h"
@@ -29,6 +30,8 @@
 #include "ship/ShipViewController.h"
 #include "sound/Sound.h"
 
+#include <algorithm>
+
 WorldView::~WorldView() {}
 
 namespace {
@@ -88,6 +91,7 @@ WorldView::WorldView(const Json &jsonObj, Game *game) :
 void WorldView::InitObject()
 {
 	m_labelsOn = true;
+	m_projectedBodiesValid = false;
 
 	Graphics::MaterialDescriptor desc;
 
@@ -103,6 +107,7 @@ void WorldView::InitObject()
 	*/
 
 	m_speedLines.reset(new SpeedLines(Pi::player));
+	m_trailBatch.reset(new HudTrailBatch(Pi::renderer));
 
 	//get near & far clipping distances
 	//XXX m_renderer not set yet
@@ -175,7 +180,8 @@ void WorldView::Draw3D()
 	// Contact trails
 	if (Pi::AreHudTrailsDisplayed()) {
 		for (auto it = Pi::player->GetSensors()->GetContacts().begin(); it != Pi::player->GetSensors()->GetContacts().end(); ++it)
-			it->trail->Render(m_renderer);
+			m_trailBatch->Add(*it->trail);
+		m_trailBatch->Draw(m_renderer);
 	}
 
 	m_cameraContext->EndFrame();
@@ -219,6 +225,7 @@ void WorldView::Update()
 	m_camera->Update();
 
 	UpdateProjectedObjects();
+	m_projectedBodiesValid = false;
 
 	FrameId playerFrameId = Pi::player->GetFrame();
 	FrameId camFrameId = m_cameraContext->GetTempFrame();
@@ -605,12 +612,79 @@ static vector3d projectToScreenSpace(const vector3d &pos, RefCountedPtr<CameraCo
 	return proj;
 }
 
+// Projects every body to screen space as WorldSpaceToScreenSpace does, but
+// in one batch: bodies in the same frame share that frame's transform to
+// the camera frame, and the frustum projects all the points in one pass
+void WorldView::UpdateProjectedBodies() const
+{
+	PROFILE_SCOPED()
+	m_projectedBodiesValid = true;
+	m_projectedBodies.clear();
+	m_projectionIn.clear();
+
+	const FrameId camFrameId = m_cameraContext->GetCameraFrame();
+	const vector3d camPos = m_cameraContext->GetCameraPos();
+	const matrix3x3d &camOrient = m_cameraContext->GetCameraOrient();
+
+	struct FrameTransform {
+		FrameId frame;
+		matrix3x3d orient;
+		vector3d pos;
+	};
+	std::vector<FrameTransform> frames;
+
+	for (const Body *body : m_game->GetSpace()->GetBodies()) {
+		vector3d pos = body->GetInterpPosition();
+		if (body->GetFrame() != camFrameId) {
+			auto frame = std::find_if(frames.begin(), frames.end(), [&](const FrameTransform &f) { return f.frame == body->GetFrame(); });
+			if (frame == frames.end()) {
+				const Frame *f = Frame::GetFrame(body->GetFrame());
+				frames.push_back({ body->GetFrame(), f->GetInterpOrientRelTo(camFrameId), f->GetInterpPositionRelTo(camFrameId) });
+				frame = frames.end() - 1;
+			}
+			pos = frame->orient * pos + frame->pos;
+		}
+		m_projectedBodies.push_back({ body, vector3d(0.0) });
+		m_projectionIn.push_back((pos - camPos) * camOrient);
+	}
+
+	const size_t count = m_projectionIn.size();
+	m_projectionOut.resize(count);
+	m_projectionValid.resize(count);
+	m_cameraContext->GetFrustum().ProjectPoints(m_projectionIn.data(), m_projectionOut.data(), m_projectionValid.data(), count);
+
+	// as projectToScreenSpace()
+	const float h = Graphics::GetScreenHeight();
+	const float w = Graphics::GetScreenWidth();
+	for (size_t i = 0; i < count; i++) {
+		vector3d &screenPos = m_projectedBodies[i].screenPos;
+		if (!m_projectionValid[i]) {
+			screenPos = vector3d(w / 2, h / 2, 0);
+			continue;
+		}
+		const vector3d &proj = m_projectionOut[i];
+		screenPos = vector3d(proj.x * w, h - proj.y * h, m_projectionIn[i].z < 0 ? -1 : 1);
+	}
+
+	std::sort(m_projectedBodies.begin(), m_projectedBodies.end());
+}
+
 // project a body in world-space to a screen-space location
 vector3d WorldView::WorldSpaceToScreenSpace(const Body *body) const
 {
 	if (body->IsType(ObjectType::PLAYER) && !shipView->IsExteriorView())
 		return vector3d(0, 0, 0);
 
+	// only this view's Update() invalidates the batch
+	if (Pi::GetView() == this) {
+		if (!m_projectedBodiesValid)
+			UpdateProjectedBodies();
+		auto it = std::lower_bound(m_projectedBodies.begin(), m_projectedBodies.end(), ProjectedBody{ body, vector3d(0.0) });
+		if (it != m_projectedBodies.end() && it->body == body)
+			return it->screenPos;
+	}
+
+	// bodies added since the batch was projected
 	vector3d pos = body->GetInterpPositionRelTo(m_cameraContext->GetCameraFrame());
 	return WorldSpaceToScreenSpace(pos);
 }
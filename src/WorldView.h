@@ -9,9 +9,13 @@
 #include "pigui/PiGuiView.h"
 #include "ship/ShipViewController.h"
 
+#include <cstdint>
+#include <vector>
+
 class Body;
 class Camera;
 class SpeedLines;
+class HudTrailBatch;
 class NavTunnelWidget;
 class Game;
 
@@ -90,6 +94,7 @@ private:
 	};
 
 	void UpdateProjectedObjects();
+	void UpdateProjectedBodies() const;
 	void UpdateIndicator(Indicator &indicator, const vector3d &direction);
 	void HideIndicator(Indicator &indicator);
 
@@ -108,6 +113,7 @@ private:
 	ViewController *m_viewController;
 
 	std::unique_ptr<SpeedLines> m_speedLines;
+	std::unique_ptr<HudTrailBatch> m_trailBatch;
 
 	bool m_labelsOn;
 
@@ -121,6 +127,20 @@ private:
 	Indicator m_combatTargetIndicator;
 	Indicator m_targetLeadIndicator;
 
+	// screen space positions of every body, projected together the first
+	// time one is asked for after each Update() and then looked up, as the
+	// HUD asks for most bodies several times a frame
+	struct ProjectedBody {
+		const Body *body;
+		vector3d screenPos;
+		bool operator<(const ProjectedBody &other) const { return body < other.body; }
+	};
+	mutable std::vector<ProjectedBody> m_projectedBodies;
+	mutable std::vector<vector3d> m_projectionIn;
+	mutable std::vector<vector3d> m_projectionOut;
+	mutable std::vector<uint8_t> m_projectionValid;
+	mutable bool m_projectedBodiesValid;
+
 	std::unique_ptr<Graphics::Material> m_indicatorMat;
 	Graphics::Drawables::Lines m_indicator;
 
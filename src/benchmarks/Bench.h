@@ -0,0 +1,106 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#pragma once
+
+#include "profiler/Profiler.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+/*
+ * A small microbenchmark harness for the benchmarks target.
+ *
+ * Each file defines one or more suites with BENCHMARK_SUITE. Suites run
+ * after the game data has been loaded and add their benchmarks with
+ * Bench::Add(), so any setup (generating star systems, building meshes)
+ * happens once and isn't timed:
+ *
+ *   BENCHMARK_SUITE(Noise)
+ *   {
+ *       auto points = std::make_shared<std::vector<vector3d>>(...);
+ *       Bench::Add("noise/perlin", [=](Bench::State &state) {
+ *           while (state.Next())
+ *               for (const vector3d &p : *points)
+ *                   Bench::DoNotOptimize(noise(p));
+ *           state.SetItemsPerIteration(points->size());
+ *       });
+ *   }
+ *
+ * The harness calls a benchmark several times with a growing iteration
+ * count until one call takes long enough to time, then reports the best
+ * and median time per iteration over a number of samples.
+ */
+namespace Bench {
+
+	class State {
+	public:
+		explicit State(uint64_t iterations) :
+			m_iterations(iterations) {}
+
+		// Returns true while there are iterations left to run. The clock
+		// starts on the first call and stops when it returns false.
+		bool Next()
+		{
+			if (m_done == 0 && !m_running) {
+				m_running = true;
+				m_clock.Start();
+			}
+			if (m_done < m_iterations) {
+				++m_done;
+				return true;
+			}
+			m_clock.Stop();
+			m_running = false;
+			return false;
+		}
+
+		// Excludes work between Pause() and Resume() from the time, e.g.
+		// resetting state that a kernel consumes
+		void Pause() { m_clock.Stop(); }
+		void Resume() { m_clock.Start(); }
+
+		// Number of items (points, rays, bodies) one iteration processes,
+		// for reporting the time per item
+		void SetItemsPerIteration(uint64_t items) { m_itemsPerIteration = items; }
+
+		uint64_t GetIterations() const { return m_iterations; }
+		uint64_t GetItemsPerIteration() const { return m_itemsPerIteration; }
+		double GetMilliseconds() { return m_clock.milliseconds(); }
+
+	private:
+		Profiler::Clock m_clock;
+		uint64_t m_iterations;
+		uint64_t m_done = 0;
+		uint64_t m_itemsPerIteration = 1;
+		bool m_running = false;
+	};
+
+	using Function = std::function<void(State &)>;
+
+	// Adds a benchmark; only valid while suites are running
+	void Add(const std::string &name, Function fn);
+
+	// Keeps the compiler from discarding a value that's computed only to be timed
+	template <typename T>
+	inline void DoNotOptimize(const T &value)
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		asm volatile("" : : "r,m"(value) : "memory");
+#else
+		static const void *volatile s_sink;
+		s_sink = &value;
+#endif
+	}
+
+	struct SuiteRegistrar {
+		SuiteRegistrar(const char *name, void (*fn)());
+	};
+
+} // namespace Bench
+
+#define BENCHMARK_SUITE(name)                                                      \
+	static void BenchmarkSuite_##name();                                           \
+	static const Bench::SuiteRegistrar s_benchmarkSuite_##name(#name, &BenchmarkSuite_##name); \
+	static void BenchmarkSuite_##name()
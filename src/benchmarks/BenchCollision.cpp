@@ -0,0 +1,86 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "Bench.h"
+
+#include "collider/BVHTree.h"
+#include "collider/GeomTree.h"
+
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+BENCHMARK_SUITE(Collision)
+{
+	// a dense triangulated sphere, roughly the triangle count of the
+	// largest station collision meshes
+	const float radius = 100.f;
+	const int rings = 128, segments = 256;
+	std::vector<vector3f> vertices;
+	std::vector<Uint32> indices, triFlags;
+	for (int ring = 0; ring <= rings; ring++) {
+		const float theta = float(M_PI) * ring / rings;
+		for (int seg = 0; seg <= segments; seg++) {
+			const float phi = 2.f * float(M_PI) * seg / segments;
+			vertices.push_back(vector3f(sin(theta) * cos(phi), cos(theta), sin(theta) * sin(phi)) * radius);
+		}
+	}
+	for (int ring = 0; ring < rings; ring++) {
+		for (int seg = 0; seg < segments; seg++) {
+			const Uint32 i0 = ring * (segments + 1) + seg;
+			const Uint32 i1 = i0 + segments + 1;
+			indices.insert(indices.end(), { i0, i1, i0 + 1, i0 + 1, i1, i1 + 1 });
+			triFlags.insert(triFlags.end(), { 0, 0 });
+		}
+	}
+
+	auto tree = std::make_shared<GeomTree>(int(vertices.size()), int(indices.size() / 3), vertices, indices, triFlags);
+
+	// rays from outside the sphere aimed somewhere near it, so that some miss
+	std::mt19937 rng(3);
+	std::uniform_real_distribution<float> coord(-1.f, 1.f);
+	auto rays = std::make_shared<std::vector<std::pair<vector3f, vector3f>>>();
+	for (int ray = 0; ray < 1024; ray++) {
+		const vector3f origin = vector3f(coord(rng), coord(rng), coord(rng)).NormalizedSafe() * radius * 2.f;
+		const vector3f target = vector3f(coord(rng), coord(rng), coord(rng)) * radius * 1.2f;
+		rays->push_back({ origin, (target - origin).Normalized() });
+	}
+
+	Bench::Add("collision/GeomTree::TraceRay", [=](Bench::State &state) {
+		while (state.Next()) {
+			for (const auto &ray : *rays) {
+				isect_t isect = { -1, radius * 4.f };
+				tree->TraceRay(ray.first, ray.second, &isect);
+				Bench::DoNotOptimize(isect);
+			}
+		}
+		state.SetItemsPerIteration(rays->size());
+	});
+
+	// the boxes of a few thousand bodies spread through a frame
+	std::uniform_real_distribution<double> pos(-1e6, 1e6);
+	std::uniform_real_distribution<double> size(1.0, 500.0);
+	auto aabbs = std::make_shared<std::vector<AABBd>>();
+	AABBd bounds = AABBd::Invalid();
+	for (int obj = 0; obj < 4096; obj++) {
+		const vector3d centre(pos(rng), pos(rng), pos(rng));
+		const vector3d extent(size(rng));
+		aabbs->push_back(AABBd{ centre - extent, centre + extent });
+		bounds.Update(aabbs->back());
+	}
+
+	Bench::Add("collision/SingleBVHTree::Build", [=](Bench::State &state) {
+		SingleBVHTree bvh;
+		std::vector<AABBd> objAabbs(aabbs->size());
+		while (state.Next()) {
+			// Build() may reorder the boxes it is given
+			state.Pause();
+			objAabbs = *aabbs;
+			state.Resume();
+			bvh.Build(bounds, objAabbs.data(), uint32_t(objAabbs.size()));
+			Bench::DoNotOptimize(bvh.GetNumNodes());
+		}
+		state.SetItemsPerIteration(aabbs->size());
+	});
+}
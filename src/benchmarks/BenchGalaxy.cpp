@@ -0,0 +1,140 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "Bench.h"
+
+#include "Orbit.h"
+#include "OrbitPropagator.h"
+#include "galaxy/Galaxy.h"
+#include "galaxy/GalaxyGenerator.h"
+#include "galaxy/NameGenerator.h"
+#include "galaxy/Sector.h"
+#include "galaxy/StarSystem.h"
+
+#include <memory>
+#include <random>
+#include <vector>
+
+BENCHMARK_SUITE(Orbit)
+{
+	// planet-like orbits around a Sun-mass primary, some of them eccentric
+	std::mt19937 rng(5);
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+	auto orbits = std::make_shared<std::vector<Orbit>>();
+	for (int i = 0; i < 1024; i++) {
+		Orbit orbit;
+		orbit.SetShapeAroundPrimary(1.5e11 * (0.1 + unit(rng) * 10.0), 2e30, unit(rng) * 0.9);
+		orbit.SetPlane(matrix3x3d::RotateY(unit(rng) * 2.0 * M_PI) * matrix3x3d::RotateX(unit(rng) * 0.5));
+		orbit.SetPhase(unit(rng) * 2.0 * M_PI);
+		orbits->push_back(orbit);
+	}
+
+	Bench::Add("orbit/OrbitalPosAtTime", [=](Bench::State &state) {
+		double time = 0.0;
+		while (state.Next()) {
+			for (const Orbit &orbit : *orbits)
+				Bench::DoNotOptimize(orbit.OrbitalPosAtTime(time));
+			time += 3600.0;
+		}
+		state.SetItemsPerIteration(orbits->size());
+	});
+
+	// a trajectory preview, 256 points an hour apart on each orbit
+	auto times = std::make_shared<std::vector<double>>();
+	for (int i = 0; i < 256; i++)
+		times->push_back(1e9 + i * 3600.0);
+
+	Bench::Add("orbit/trajectory scalar", [=](Bench::State &state) {
+		while (state.Next()) {
+			for (const Orbit &orbit : *orbits)
+				for (double time : *times)
+					Bench::DoNotOptimize(orbit.OrbitalPosAtTime(time));
+		}
+		state.SetItemsPerIteration(orbits->size() * times->size());
+	});
+
+	Bench::Add("orbit/trajectory OrbitalPosAtTimes", [=](Bench::State &state) {
+		std::vector<vector3d> positions(times->size());
+		while (state.Next()) {
+			for (const Orbit &orbit : *orbits) {
+				orbit.OrbitalPosAtTimes(times->data(), times->size(), positions.data());
+				Bench::DoNotOptimize(positions.data());
+			}
+		}
+		state.SetItemsPerIteration(orbits->size() * times->size());
+	});
+
+	Bench::Add("orbit/OrbitPropagator", [=](Bench::State &state) {
+		OrbitPropagator propagator;
+		for (const Orbit &orbit : *orbits)
+			propagator.Add(orbit);
+		std::vector<vector3d> positions;
+		double time = 0.0;
+		while (state.Next()) {
+			propagator.Propagate(time, positions);
+			Bench::DoNotOptimize(positions.data());
+			time += 3600.0;
+		}
+		state.SetItemsPerIteration(orbits->size());
+	});
+}
+
+BENCHMARK_SUITE(NameGenerator)
+{
+	// about as many names as a large sector fill asks for
+	static const size_t NUM_NAMES = 4096;
+
+	Bench::Add("galaxy/GetSystemName", [=](Bench::State &state) {
+		Random rng(1234);
+		while (state.Next()) {
+			for (size_t i = 0; i < NUM_NAMES; i++) {
+				std::string name;
+				NameGenerator::GetSystemName(name, rng);
+				Bench::DoNotOptimize(name.data());
+			}
+		}
+		state.SetItemsPerIteration(NUM_NAMES);
+	});
+
+	Bench::Add("galaxy/GetSystemNames", [=](Bench::State &state) {
+		Random rng(1234);
+		std::vector<std::string> names;
+		while (state.Next()) {
+			names.clear();
+			NameGenerator::GetSystemNames(names, NUM_NAMES, rng);
+			Bench::DoNotOptimize(names.data());
+		}
+		state.SetItemsPerIteration(NUM_NAMES);
+	});
+}
+
+BENCHMARK_SUITE(StarSystem)
+{
+	RefCountedPtr<Galaxy> galaxy = GalaxyGenerator::Create();
+
+	// the first few systems of the sectors next to Sol, which are
+	// generated rather than custom
+	auto paths = std::make_shared<std::vector<SystemPath>>();
+	for (int sx = 1; sx <= 2 && paths->size() < 16; sx++) {
+		RefCountedPtr<const Sector> sector = galaxy->GetSector(SystemPath(sx, 0, 0));
+		for (unsigned idx = 0; idx < sector->m_systems.size() && paths->size() < 16; idx++)
+			paths->push_back(SystemPath(sx, 0, 0, idx));
+	}
+
+	// generate everything without the cache, so each iteration does the full work
+	auto generate = [galaxy](const SystemPath &path) {
+		return galaxy->GetGenerator()->GenerateStarSystem(galaxy, path, nullptr, StarSystem::GENERATED_ALL);
+	};
+
+	Bench::Add("galaxy/StarSystem Sol", [=](Bench::State &state) {
+		while (state.Next())
+			Bench::DoNotOptimize(generate(SystemPath(0, 0, 0, 0)));
+	});
+
+	Bench::Add("galaxy/StarSystem generated", [=](Bench::State &state) {
+		while (state.Next())
+			for (const SystemPath &path : *paths)
+				Bench::DoNotOptimize(generate(path));
+		state.SetItemsPerIteration(paths->size());
+	});
+}
@@ -0,0 +1,52 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "Bench.h"
+
+#include "CRC32.h"
+#include "core/FNV1a.h"
+#include "core/FastHash.h"
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// Checksums and hashes over a file-sized buffer; items are bytes
+BENCHMARK_SUITE(Hash)
+{
+	auto data = std::make_shared<std::vector<char>>(1 << 20);
+	std::mt19937 rng(11);
+	for (char &c : *data)
+		c = char(rng());
+
+	Bench::Add("hash/CRC32 (bytewise)", [=](Bench::State &state) {
+		while (state.Next()) {
+			CRC32 crc;
+			crc.AddDataBytewise(data->data(), data->size());
+			Bench::DoNotOptimize(crc.GetChecksum());
+		}
+		state.SetItemsPerIteration(data->size());
+	});
+
+	Bench::Add(std::string("hash/CRC32 (") + CRC32::GetImplementationName() + ")", [=](Bench::State &state) {
+		while (state.Next()) {
+			CRC32 crc;
+			crc.AddData(data->data(), data->size());
+			Bench::DoNotOptimize(crc.GetChecksum());
+		}
+		state.SetItemsPerIteration(data->size());
+	});
+
+	Bench::Add("hash/FNV-1a 64", [=](Bench::State &state) {
+		while (state.Next())
+			Bench::DoNotOptimize(hash_64_fnv1a(data->data(), data->size()));
+		state.SetItemsPerIteration(data->size());
+	});
+
+	Bench::Add("hash/FastHash64", [=](Bench::State &state) {
+		while (state.Next())
+			Bench::DoNotOptimize(FastHash64(data->data(), data->size()));
+		state.SetItemsPerIteration(data->size());
+	});
+}
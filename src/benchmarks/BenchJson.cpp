@@ -0,0 +1,70 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "Bench.h"
+
+#include "Json.h"
+#include "JsonUtils.h"
+#include "matrix4x4.h"
+#include "vector3.h"
+
+#include <memory>
+#include <random>
+#include <string>
+
+// A document shaped like a save: a large array of bodies with vectors,
+// matrices and nested objects, a few other large values and some small
+// ones, so that it is split into several chunks when encoded.
+static Json MakeSaveDocument(int numBodies)
+{
+	std::mt19937 rng(4);
+	std::uniform_real_distribution<double> value(-1e9, 1e9);
+
+	Json bodies = Json::array();
+	for (int i = 0; i < numBodies; i++) {
+		Json body = Json::object();
+		body["index"] = i;
+		body["label"] = "Body " + std::to_string(i);
+		body["pos"] = vector3d(value(rng), value(rng), value(rng));
+		body["vel"] = vector3d(value(rng), value(rng), value(rng));
+		body["orient"] = matrix4x4d::RotateYMatrix(value(rng));
+		body["mass"] = value(rng);
+		body["frame"] = i % 16;
+		Json props = Json::object();
+		props["hull_percent"] = 100.0;
+		props["fuel"] = 0.75;
+		props["equipment"] = Json::array({ "laser_front", "hyperdrive", "radar" });
+		body["properties"] = props;
+		bodies.push_back(body);
+	}
+
+	Json root = Json::object();
+	root["version"] = 90;
+	root["time"] = 1234567.0;
+	root["space"] = Json::object();
+	root["space"]["bodies"] = bodies;
+	root["lua_modules_json"] = Json::array();
+	for (int i = 0; i < numBodies / 4; i++)
+		root["lua_modules_json"].push_back({ { "key", "mission_" + std::to_string(i) }, { "reward", value(rng) } });
+	return root;
+}
+
+BENCHMARK_SUITE(SaveJson)
+{
+	auto document = std::make_shared<const Json>(MakeSaveDocument(5000));
+
+	for (const bool useLZ4 : { true, false }) {
+		const std::string compression = useLZ4 ? "lz4" : "gzip";
+		auto encoded = std::make_shared<const std::string>(JsonUtils::EncodeSaveFileData(*document, useLZ4, "benchmark"));
+
+		Bench::Add("json/save encode " + compression, [=](Bench::State &state) {
+			while (state.Next())
+				Bench::DoNotOptimize(JsonUtils::EncodeSaveFileData(*document, useLZ4, "benchmark"));
+		});
+
+		Bench::Add("json/save decode " + compression, [=](Bench::State &state) {
+			while (state.Next())
+				Bench::DoNotOptimize(JsonUtils::DecodeSaveFileData(encoded->data(), encoded->size()));
+		});
+	}
+}
@@ -0,0 +1,48 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "Bench.h"
+
+#include "lua/Lua.h"
+#include "lua/LuaPushPull.h"
+#include "lua/LuaVector.h"
+
+#include <string>
+#include <tuple>
+
+BENCHMARK_SUITE(LuaPushPull)
+{
+	// each benchmark gets its own state, so that they don't share garbage
+	Bench::Add("lua/push-pull scalars", [](Bench::State &state) {
+		lua_State *l = luaL_newstate();
+		while (state.Next()) {
+			pi_lua_multiple_push<bool, int, double>(l, true, 42, 3.5);
+			Bench::DoNotOptimize(pi_lua_multiple_pull<bool, int, double>(l, 1));
+			lua_settop(l, 0);
+		}
+		lua_close(l);
+	});
+
+	Bench::Add("lua/push-pull string", [](Bench::State &state) {
+		lua_State *l = luaL_newstate();
+		const std::string value = "Cydonia, Mars";
+		while (state.Next()) {
+			LuaPush<std::string>(l, value);
+			Bench::DoNotOptimize(LuaPull<std::string>(l, 1));
+			lua_settop(l, 0);
+		}
+		lua_close(l);
+	});
+
+	Bench::Add("lua/push-pull vector3d", [](Bench::State &state) {
+		lua_State *l = luaL_newstate();
+		luaL_openlibs(l);
+		LuaVector::Register(l);
+		while (state.Next()) {
+			LuaPush<vector3d>(l, vector3d(1.0, 2.0, 3.0));
+			Bench::DoNotOptimize(LuaPull<vector3d>(l, 1));
+			lua_settop(l, 0);
+		}
+		lua_close(l);
+	});
+}
@@ -0,0 +1,81 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "Bench.h"
+
+#include "MatrixKernels.h"
+#include "matrix4x4.h"
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// Each kernel against its scalar version, on the same data
+template <typename T>
+static void AddMatrixBenchmarks(const std::string &type)
+{
+	const std::string simd = MatrixKernels::GetImplementationName();
+
+	std::mt19937 rng(5);
+	std::uniform_real_distribution<T> dist(-1000, 1000);
+
+	// a chain of transforms, as when concatenating frame and model matrices
+	auto matrices = std::make_shared<std::vector<matrix4x4<T>>>(256);
+	for (auto &m : *matrices) {
+		m = matrix4x4<T>::RotateMatrix(dist(rng) * T(0.001), dist(rng), dist(rng), dist(rng));
+		m.SetTranslate(vector3<T>(dist(rng), dist(rng), dist(rng)));
+	}
+
+	Bench::Add("math/matrix4x4" + type + " multiply (scalar)", [=](Bench::State &state) {
+		matrix4x4<T> out;
+		while (state.Next()) {
+			for (size_t i = 1; i < matrices->size(); i++) {
+				MatrixKernels::MulScalar((*matrices)[i - 1].Data(), (*matrices)[i].Data(), out.Data());
+				Bench::DoNotOptimize(out);
+			}
+		}
+		state.SetItemsPerIteration(matrices->size() - 1);
+	});
+
+	Bench::Add("math/matrix4x4" + type + " multiply (" + simd + ")", [=](Bench::State &state) {
+		matrix4x4<T> out;
+		while (state.Next()) {
+			for (size_t i = 1; i < matrices->size(); i++) {
+				MatrixKernels::Mul((*matrices)[i - 1].Data(), (*matrices)[i].Data(), out.Data());
+				Bench::DoNotOptimize(out);
+			}
+		}
+		state.SetItemsPerIteration(matrices->size() - 1);
+	});
+
+	// the vertices of a mid-sized mesh
+	auto points = std::make_shared<std::vector<vector3<T>>>(4096);
+	for (auto &p : *points)
+		p = vector3<T>(dist(rng), dist(rng), dist(rng));
+	const matrix4x4<T> transform = matrices->front();
+
+	Bench::Add("math/matrix4x4" + type + " TransformPoints (scalar)", [=](Bench::State &state) {
+		std::vector<vector3<T>> out(points->size());
+		while (state.Next()) {
+			MatrixKernels::TransformPointsScalar(transform.Data(), &points->front().x, &out.front().x, points->size());
+			Bench::DoNotOptimize(out.back());
+		}
+		state.SetItemsPerIteration(points->size());
+	});
+
+	Bench::Add("math/matrix4x4" + type + " TransformPoints (" + simd + ")", [=](Bench::State &state) {
+		std::vector<vector3<T>> out(points->size());
+		while (state.Next()) {
+			transform.TransformPoints(points->data(), out.data(), points->size());
+			Bench::DoNotOptimize(out.back());
+		}
+		state.SetItemsPerIteration(points->size());
+	});
+}
+
+BENCHMARK_SUITE(Math)
+{
+	AddMatrixBenchmarks<float>("f");
+	AddMatrixBenchmarks<double>("d");
+}
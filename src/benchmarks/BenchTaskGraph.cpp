@@ -0,0 +1,45 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "Bench.h"
+
+#include "core/OS.h"
+#include "core/TaskGraph.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// Measures the cost of dispatching work rather than the work itself, so the
+// tasks do almost nothing.
+BENCHMARK_SUITE(TaskGraph)
+{
+	auto graph = std::make_shared<TaskGraph>();
+	graph->SetWorkerThreads(std::max(OS::GetNumCores() - 1, 1U));
+
+	Bench::Add("taskgraph/TaskSet 256 tasks", [=](Bench::State &state) {
+		std::atomic<uint32_t> counter(0);
+		while (state.Next()) {
+			TaskSet *set = new TaskSet();
+			for (uint32_t idx = 0; idx < 256; idx++)
+				set->AddTaskLambda({ idx, idx + 1 }, [&](TaskRange) { counter.fetch_add(1, std::memory_order_relaxed); });
+			TaskSet::Handle handle = graph->QueueTaskSet(set);
+			graph->WaitForTaskSet(handle);
+		}
+		Bench::DoNotOptimize(counter.load());
+		state.SetItemsPerIteration(256);
+	});
+
+	Bench::Add("taskgraph/ParallelFor 64k grain 256", [=](Bench::State &state) {
+		std::vector<uint32_t> values(65536, 0);
+		while (state.Next()) {
+			graph->ParallelFor({ 0, uint32_t(values.size()) }, 256, [&](TaskRange r) {
+				for (uint32_t idx = r.begin; idx < r.end; idx++)
+					values[idx] += idx;
+			});
+		}
+		Bench::DoNotOptimize(values.data());
+		state.SetItemsPerIteration(values.size() / 256);
+	});
+}
@@ -0,0 +1,110 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "Bench.h"
+
+#include "galaxy/Galaxy.h"
+#include "galaxy/GalaxyGenerator.h"
+#include "galaxy/Sector.h"
+#include "galaxy/StarSystem.h"
+#include "perlin.h"
+#include "terrain/Terrain.h"
+#include "terrain/TerrainNoise.h"
+
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace TerrainNoise;
+
+static const size_t NUM_POINTS = 4096;
+
+// random points on the unit sphere, as a terrain samples them
+static std::shared_ptr<std::vector<vector3d>> MakeSpherePoints(uint32_t seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<double> coord(-1.0, 1.0);
+	auto points = std::make_shared<std::vector<vector3d>>();
+	while (points->size() < NUM_POINTS)
+		points->push_back(vector3d(coord(rng), coord(rng), coord(rng)).NormalizedSafe());
+	return points;
+}
+
+BENCHMARK_SUITE(Noise)
+{
+	auto points = MakeSpherePoints(1);
+
+	// terrain frequencies on an Earth-sized planet
+	std::vector<vector3d> scaled;
+	for (const vector3d &p : *points)
+		scaled.push_back(p * 1e4);
+	auto scaledPoints = std::make_shared<std::vector<vector3d>>(std::move(scaled));
+
+	Bench::Add("noise/perlin", [=](Bench::State &state) {
+		while (state.Next())
+			for (const vector3d &p : *scaledPoints)
+				Bench::DoNotOptimize(noise(p));
+		state.SetItemsPerIteration(scaledPoints->size());
+	});
+
+	Bench::Add("noise/perlin batched", [=](Bench::State &state) {
+		std::vector<double> out(scaledPoints->size());
+		while (state.Next()) {
+			noise(scaledPoints->data(), out.data(), scaledPoints->size());
+			Bench::DoNotOptimize(out.data());
+		}
+		state.SetItemsPerIteration(scaledPoints->size());
+	});
+
+	Bench::Add("noise/octavenoise 12 octaves", [=](Bench::State &state) {
+		fracdef_t def;
+		def.amplitude = 1.0;
+		def.frequency = 1e3;
+		def.lacunarity = 2.0;
+		def.octaves = 12;
+		while (state.Next())
+			for (const vector3d &p : *points)
+				Bench::DoNotOptimize(octavenoise(def, 0.5, p));
+		state.SetItemsPerIteration(points->size());
+	});
+}
+
+BENCHMARK_SUITE(Terrain)
+{
+	RefCountedPtr<Galaxy> galaxy = GalaxyGenerator::Create();
+
+	// collect one body for each height fractal from the systems around Sol
+	struct Sample {
+		RefCountedPtr<StarSystem> system;
+		RefCountedPtr<Terrain> terrain;
+	};
+	std::map<std::string, Sample> byFractal;
+	for (int sx = -1; sx <= 1; sx++) {
+		for (int sy = -1; sy <= 1; sy++) {
+			for (int sz = -1; sz <= 1; sz++) {
+				RefCountedPtr<const Sector> sector = galaxy->GetSector(SystemPath(sx, sy, sz));
+				for (unsigned idx = 0; idx < sector->m_systems.size(); idx++) {
+					RefCountedPtr<StarSystem> system = galaxy->GetStarSystem(SystemPath(sx, sy, sz, idx));
+					for (RefCountedPtr<SystemBody> body : system->GetBodies()) {
+						RefCountedPtr<Terrain> terrain(Terrain::InstanceTerrain(body.Get()));
+						if (!byFractal.count(terrain->GetHeightFractalName()))
+							byFractal[terrain->GetHeightFractalName()] = { system, terrain };
+					}
+				}
+			}
+		}
+	}
+
+	auto points = MakeSpherePoints(2);
+	for (const auto &entry : byFractal) {
+		const Sample sample = entry.second;
+		Bench::Add("terrain/GetHeight/" + entry.first, [=](Bench::State &state) {
+			const Terrain *terrain = sample.terrain.Get();
+			while (state.Next())
+				for (const vector3d &p : *points)
+					Bench::DoNotOptimize(terrain->GetHeight(p));
+			state.SetItemsPerIteration(points->size());
+		});
+	}
+}
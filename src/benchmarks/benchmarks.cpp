@@ -0,0 +1,235 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "Bench.h"
+
+#include "EnumStrings.h"
+#include "FileSystem.h"
+#include "GameConfig.h"
+#include "Json.h"
+#include "ModManager.h"
+#include "Pi.h"
+#include "core/Log.h"
+#include "galaxy/Economy.h"
+#include "galaxy/Galaxy.h"
+#include "galaxy/GalaxyGenerator.h"
+#include "lua/Lua.h"
+#include "lua/LuaNameGen.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace {
+	struct Suite {
+		const char *name;
+		void (*fn)();
+	};
+
+	struct Benchmark {
+		std::string name;
+		Bench::Function fn;
+	};
+
+	// suites are registered by static initializers, so the list must be
+	// constructed on first use
+	std::vector<Suite> &GetSuites()
+	{
+		static std::vector<Suite> s_suites;
+		return s_suites;
+	}
+
+	std::vector<Benchmark> s_benchmarks;
+	bool s_addingBenchmarks = false;
+
+	// one iteration count must take at least this long to be timed
+	const double MIN_CALIBRATION_MS = 5.0;
+	// each sample runs for about this long
+	const double SAMPLE_MS = 25.0;
+	const uint64_t MAX_ITERATIONS = uint64_t(1) << 40;
+
+	struct Result {
+		std::string name;
+		uint64_t iterations;
+		uint64_t items;
+		double bestMs;
+		double medianMs;
+	};
+
+	double RunOnce(const Bench::Function &fn, uint64_t iterations, uint64_t &items)
+	{
+		Bench::State state(iterations);
+		fn(state);
+		items = state.GetItemsPerIteration();
+		return state.GetMilliseconds();
+	}
+
+	Result RunBenchmark(const Benchmark &bench, int numSamples)
+	{
+		uint64_t items = 1;
+		uint64_t iterations = 1;
+		double ms = RunOnce(bench.fn, iterations, items);
+		while (ms < MIN_CALIBRATION_MS && iterations < MAX_ITERATIONS) {
+			// grow by at most 100x in case the first call was an outlier
+			const double scale = ms > 0.0 ? std::min(100.0, std::max(2.0, MIN_CALIBRATION_MS * 1.5 / ms)) : 100.0;
+			iterations = uint64_t(double(iterations) * scale);
+			ms = RunOnce(bench.fn, iterations, items);
+		}
+
+		const double perIteration = ms / double(iterations);
+		const uint64_t sampleIterations = std::max<uint64_t>(1, uint64_t(SAMPLE_MS / perIteration));
+
+		std::vector<double> samples;
+		for (int sample = 0; sample < numSamples; sample++)
+			samples.push_back(RunOnce(bench.fn, sampleIterations, items) / double(sampleIterations));
+		std::sort(samples.begin(), samples.end());
+
+		return { bench.name, sampleIterations, items, samples.front(), samples[samples.size() / 2] };
+	}
+
+	std::string FormatTime(double ms)
+	{
+		char buf[32];
+		if (ms < 1e-3)
+			snprintf(buf, sizeof(buf), "%.1f ns", ms * 1e6);
+		else if (ms < 1.0)
+			snprintf(buf, sizeof(buf), "%.2f us", ms * 1e3);
+		else
+			snprintf(buf, sizeof(buf), "%.2f ms", ms);
+		return buf;
+	}
+
+	bool WriteJson(const std::string &filename, const std::vector<Result> &results)
+	{
+		Json report = Json::array();
+		for (const Result &result : results) {
+			Json entry = Json::object();
+			entry["name"] = result.name;
+			entry["iterations"] = result.iterations;
+			entry["itemsPerIteration"] = result.items;
+			entry["bestNs"] = result.bestMs * 1e6;
+			entry["medianNs"] = result.medianMs * 1e6;
+			report.push_back(entry);
+		}
+
+		FILE *file = fopen(filename.c_str(), "w");
+		if (!file)
+			return false;
+		const std::string text = report.dump(2) + "\n";
+		const bool written = fputs(text.c_str(), file) >= 0;
+		return fclose(file) == 0 && written;
+	}
+
+	int info()
+	{
+		printf(
+			"benchmarks - Time the engine's hot kernels.\n"
+			"USAGE: benchmarks [-list] [-samples <n>] [-json <file>] [filter...]\n"
+			"Only benchmarks whose names contain one of the filters are run.\n");
+		return 1;
+	}
+} // namespace
+
+Bench::SuiteRegistrar::SuiteRegistrar(const char *name, void (*fn)())
+{
+	GetSuites().push_back({ name, fn });
+}
+
+void Bench::Add(const std::string &name, Function fn)
+{
+	assert(s_addingBenchmarks);
+	s_benchmarks.push_back({ name, std::move(fn) });
+}
+
+extern "C" int main(int argc, char **argv)
+{
+	bool listOnly = false;
+	int numSamples = 5;
+	std::string jsonFile;
+	std::vector<std::string> filters;
+
+	for (int arg = 1; arg < argc; arg++) {
+		if (strcmp(argv[arg], "-list") == 0) {
+			listOnly = true;
+		} else if (strcmp(argv[arg], "-samples") == 0 && arg + 1 < argc) {
+			char *end;
+			numSamples = strtol(argv[++arg], &end, 10);
+			if (*end != '\0' || numSamples < 1) return info();
+		} else if (strcmp(argv[arg], "-json") == 0 && arg + 1 < argc) {
+			jsonFile = argv[++arg];
+		} else if (argv[arg][0] == '-') {
+			return info();
+		} else {
+			filters.push_back(argv[arg]);
+		}
+	}
+
+	// the same startup as the galaxy dump, enough to generate star systems
+	// and run Lua without a window
+	FileSystem::Init();
+	FileSystem::userFiles.MakeDirectory("");
+	Log::GetLog()->SetLogFile("benchmarks.log");
+
+	std::unique_ptr<GameConfig> config(new GameConfig);
+	ModManager::Init();
+	ModManager::LoadMods(config.get());
+
+	EnumStrings::Init();
+	GalacticEconomy::Init();
+	GalaxyGenerator::Init();
+
+	Lua::Init();
+	Pi::luaNameGen = new LuaNameGen(Lua::manager);
+
+	s_addingBenchmarks = true;
+	for (const Suite &suite : GetSuites())
+		suite.fn();
+	s_addingBenchmarks = false;
+
+	std::sort(s_benchmarks.begin(), s_benchmarks.end(), [](const Benchmark &a, const Benchmark &b) {
+		return a.name < b.name;
+	});
+
+	if (!listOnly)
+		printf("%-40s %12s %12s\n", "benchmark", "best", "median");
+
+	std::vector<Result> results;
+	for (const Benchmark &bench : s_benchmarks) {
+		const bool selected = filters.empty() || std::any_of(filters.begin(), filters.end(), [&](const std::string &filter) {
+			return bench.name.find(filter) != std::string::npos;
+		});
+		if (!selected)
+			continue;
+
+		if (listOnly) {
+			printf("%s\n", bench.name.c_str());
+			continue;
+		}
+
+		const Result result = RunBenchmark(bench, numSamples);
+		printf("%-40s %12s %12s", result.name.c_str(), FormatTime(result.bestMs).c_str(), FormatTime(result.medianMs).c_str());
+		if (result.items > 1)
+			printf("  (%s per item)", FormatTime(result.medianMs / double(result.items)).c_str());
+		printf("\n");
+		fflush(stdout);
+		results.push_back(result);
+	}
+
+	int ret = 0;
+	if (!jsonFile.empty() && !WriteJson(jsonFile, results)) {
+		printf("Could not write output file %s.\n", jsonFile.c_str());
+		ret = 1;
+	}
+
+	s_benchmarks.clear();
+	delete Pi::luaNameGen;
+	Pi::luaNameGen = nullptr;
+	Lua::Uninit();
+	GalaxyGenerator::Uninit();
+	ModManager::Uninit();
+	return ret;
+}
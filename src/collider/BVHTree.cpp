@@ -8,6 +8,9 @@
 #include "core/Log.h"
 #include "core/macros.h"
 #include "profiler/Profiler.h"
+#include "scenegraph/Serializer.h"
+
+#include <cmath>
 
 const int MAX_SPLITPOS_RETRIES = 15;
 
@@ -30,7 +33,7 @@ BVHTree::BVHTree(int numObjs, const objPtr_t *objPtrs, const Aabb *objAabbs)
 	m_nodeAllocMax = numObjs * 2 + 1;
 
 	m_root = AllocNode();
-	BuildNode(m_root, objPtrs, objAabbs, activeObjIdxs);
+	BuildNode(m_root, objPtrs, objAabbs, activeObjIdxs, 0);
 
 	timer.Stop();
 	//Log::Debug(" - - - BVHTree::BVHTree took: {} milliseconds\n", timer.millicycles());
@@ -59,7 +62,8 @@ void BVHTree::MakeLeaf(BVHNode *node, const objPtr_t *objPtrs, std::vector<objPt
 void BVHTree::BuildNode(BVHNode *node,
 	const objPtr_t *objPtrs,
 	const Aabb *objAabbs,
-	std::vector<objPtr_t> &activeObjIdx)
+	std::vector<objPtr_t> &activeObjIdx,
+	int depth)
 {
 	const int numTris = activeObjIdx.size();
 	if (numTris <= 0)
@@ -79,7 +83,7 @@ void BVHTree::BuildNode(BVHNode *node,
 	node->numTris = numTris;
 	node->aabb = aabb;
 
-	if (numTris == 1) {
+	if (numTris == 1 || depth >= MAX_DEPTH) {
 		MakeLeaf(node, objPtrs, activeObjIdx);
 		return;
 	}
@@ -151,8 +155,8 @@ void BVHTree::BuildNode(BVHNode *node,
 	node->kids[0] = AllocNode();
 	node->kids[1] = AllocNode();
 
-	BuildNode(node->kids[0], objPtrs, objAabbs, side[0]);
-	BuildNode(node->kids[1], objPtrs, objAabbs, side[1]);
+	BuildNode(node->kids[0], objPtrs, objAabbs, side[0], depth + 1);
+	BuildNode(node->kids[1], objPtrs, objAabbs, side[1], depth + 1);
 }
 
 BVHNode *BVHTree::AllocNode()
@@ -203,6 +207,8 @@ double BVHTree::CalculateSAH() const
 // ===================================================================
 
 SingleBVHTree::SingleBVHTree() :
+	m_numLeaves(0),
+	m_buildCost(0.0),
 	m_treeHeight(0),
 	m_boundsCenter(0.0, 0.0, 0.0),
 	m_inv_scale_factor(1.0)
@@ -213,6 +219,8 @@ SingleBVHTree::SingleBVHTree() :
 void SingleBVHTree::Clear()
 {
 	m_nodes.clear();
+	m_numLeaves = 0;
+	m_buildCost = 0.0;
 
 	// Build a default / invalid node for this BVHTree
 	AABBd aabb = AABBd::Invalid();
@@ -245,6 +253,59 @@ void SingleBVHTree::Build(const AABBd &bounds, AABBd *objAabbs, uint32_t numObjs
 	}
 
 	BuildNode(&m_nodes.emplace_back(), sortKeys.data(), numObjs, objAabbs, 0);
+
+	m_numLeaves = numObjs;
+	m_buildCost = CalculateRefitCost();
+}
+
+static double SurfaceArea(const AABBd &aabb)
+{
+	const vector3d size = aabb.max - aabb.min;
+	return 2.0 * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+bool SingleBVHTree::Refit(const AABBd *objAabbs, uint32_t numObjs)
+{
+	PROFILE_SCOPED()
+
+	if (numObjs == 0 || numObjs != m_numLeaves)
+		return false;
+
+	// Nodes are allocated in pre-order, so children always have a higher index
+	// than their parent; a reverse sweep visits every child before its parent.
+	// Interior node surface areas are summed in the same sweep
+	double cost = 0.0;
+	for (size_t idx = m_nodes.size(); idx-- > 0;) {
+		Node &node = m_nodes[idx];
+		if (node.kids[0] == 0) {
+			node.aabb = objAabbs[node.leafIndex];
+		} else {
+			node.aabb = m_nodes[node.kids[0]].aabb;
+			node.aabb.Update(m_nodes[node.kids[1]].aabb);
+			if (idx > 0)
+				cost += SurfaceArea(node.aabb);
+		}
+	}
+
+	// Objects that have moved far enough leave the tree with large,
+	// overlapping interior nodes; prefer a rebuild at that point.
+	const double rootArea = SurfaceArea(m_nodes[0].aabb);
+	return rootArea <= 0.0 || cost / rootArea <= m_buildCost * REFIT_QUALITY_THRESHOLD;
+}
+
+double SingleBVHTree::CalculateRefitCost() const
+{
+	const double rootArea = SurfaceArea(m_nodes[0].aabb);
+	if (rootArea <= 0.0)
+		return 0.0;
+
+	double cost = 0.0;
+	for (size_t idx = 1; idx < m_nodes.size(); idx++) {
+		if (m_nodes[idx].kids[0] != 0)
+			cost += SurfaceArea(m_nodes[idx].aabb);
+	}
+
+	return cost / rootArea;
 }
 
 void SingleBVHTree::BuildNode(Node *node, SortKey *keys, uint32_t numKeys, AABBd *objAabbs, uint32_t height)
@@ -410,3 +471,141 @@ double SingleBVHTree::CalculateSAH() const
 
 	return outSAH;
 }
+
+// ===================================================================
+
+static double SurfaceArea(const Aabb &aabb)
+{
+	const vector3d size = aabb.max - aabb.min;
+	return 2.0 * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+WideBVHTree::WideBVHTree(const BVHNode *root)
+{
+	PROFILE_SCOPED()
+	BuildNode(root);
+}
+
+WideBVHTree::WideBVHTree(Serializer::Reader &rd)
+{
+	PROFILE_SCOPED()
+	const ByteRange nodes = rd.Blob();
+	m_nodes.resize(nodes.Size() / sizeof(Node));
+	memcpy(m_nodes.data(), nodes.begin, m_nodes.size() * sizeof(Node));
+
+	const ByteRange leafObjs = rd.Blob();
+	m_leafObjs.resize(leafObjs.Size() / sizeof(BVHTree::objPtr_t));
+	memcpy(m_leafObjs.data(), leafObjs.begin, m_leafObjs.size() * sizeof(BVHTree::objPtr_t));
+}
+
+void WideBVHTree::Save(Serializer::Writer &wr) const
+{
+	// nodes are plain data and written as-is, matching the host-endian layout
+	// the rest of the collision mesh data uses
+	wr.Blob(ByteRange(reinterpret_cast<const char *>(m_nodes.data()), m_nodes.size() * sizeof(Node)));
+	wr.Blob(ByteRange(reinterpret_cast<const char *>(m_leafObjs.data()), m_leafObjs.size() * sizeof(BVHTree::objPtr_t)));
+}
+
+void WideBVHTree::GetChildBounds(const Node &node, AabbSoA4 &bounds)
+{
+	for (int i = 0; i < WIDTH; i++) {
+		bounds.minX[i] = node.origin.x + node.qmin[0][i] * node.scale.x;
+		bounds.minY[i] = node.origin.y + node.qmin[1][i] * node.scale.y;
+		bounds.minZ[i] = node.origin.z + node.qmin[2][i] * node.scale.z;
+		bounds.maxX[i] = node.origin.x + node.qmax[0][i] * node.scale.x;
+		bounds.maxY[i] = node.origin.y + node.qmax[1][i] * node.scale.y;
+		bounds.maxZ[i] = node.origin.z + node.qmax[2][i] * node.scale.z;
+	}
+}
+
+Uint32 WideBVHTree::BuildNode(const BVHNode *bnode)
+{
+	const Uint32 nodeIdx = m_nodes.size();
+	m_nodes.emplace_back();
+
+	// collapse binary levels into this node, always opening up the interior
+	// child with the largest surface area
+	std::vector<const BVHNode *> kids;
+	if (bnode->IsLeaf())
+		kids.push_back(bnode);
+	else
+		kids = { bnode->kids[0], bnode->kids[1] };
+
+	while (kids.size() < WIDTH) {
+		int best = -1;
+		double bestArea = -1.0;
+		for (size_t i = 0; i < kids.size(); i++) {
+			const double area = SurfaceArea(kids[i]->aabb);
+			if (!kids[i]->IsLeaf() && area > bestArea) {
+				best = i;
+				bestArea = area;
+			}
+		}
+		if (best < 0)
+			break;
+
+		const BVHNode *opened = kids[best];
+		kids[best] = opened->kids[0];
+		kids.push_back(opened->kids[1]);
+	}
+
+	Node node;
+	memset(&node, 0, sizeof(Node));
+
+	// quantization frame covering this node's bounds, rounded outwards so
+	// the last step still reaches the max corner
+	for (int axis = 0; axis < 3; axis++) {
+		float origin = float(bnode->aabb.min[axis]);
+		if (origin > bnode->aabb.min[axis])
+			origin = std::nextafter(origin, -FLT_MAX);
+		float scale = float((bnode->aabb.max[axis] - origin) / 255.0);
+		while (origin + 255 * scale < bnode->aabb.max[axis])
+			scale = std::nextafter(scale, FLT_MAX);
+		node.origin[axis] = origin;
+		node.scale[axis] = scale;
+	}
+
+	for (int i = 0; i < WIDTH; i++) {
+		if (i >= int(kids.size())) {
+			node.child[i] = EMPTY_CHILD;
+			continue;
+		}
+
+		const Aabb &aabb = kids[i]->aabb;
+		for (int axis = 0; axis < 3; axis++) {
+			const float origin = node.origin[axis];
+			const float scale = node.scale[axis];
+			int qmin = 0, qmax = 255;
+			if (scale > 0.f) {
+				qmin = Clamp(int(std::floor((aabb.min[axis] - origin) / scale)), 0, 255);
+				qmax = Clamp(int(std::ceil((aabb.max[axis] - origin) / scale)), 0, 255);
+			}
+			// correct for rounding in the division, the decoded box must contain the child
+			while (qmin > 0 && origin + qmin * scale > aabb.min[axis])
+				qmin--;
+			while (qmax < 255 && origin + qmax * scale < aabb.max[axis])
+				qmax++;
+			node.qmin[axis][i] = qmin;
+			node.qmax[axis][i] = qmax;
+		}
+
+		if (kids[i]->IsLeaf()) {
+			assert(kids[i]->numTris > 0 && kids[i]->numTris <= 0xffff);
+			node.child[i] = m_leafObjs.size();
+			node.numObjs[i] = kids[i]->numTris;
+			m_leafObjs.insert(m_leafObjs.end(), kids[i]->triIndicesStart, kids[i]->triIndicesStart + kids[i]->numTris);
+		}
+	}
+
+	// children are built after this node is filled in, as they may
+	// reallocate m_nodes
+	m_nodes[nodeIdx] = node;
+	for (int i = 0; i < int(kids.size()); i++) {
+		if (!kids[i]->IsLeaf()) {
+			const Uint32 childIdx = BuildNode(kids[i]);
+			m_nodes[nodeIdx].child[i] = childIdx;
+		}
+	}
+
+	return nodeIdx;
+}
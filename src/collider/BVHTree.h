@@ -6,8 +6,14 @@
 
 #include "../Aabb.h"
 #include "../vector3.h"
+#include "RayKernels.h"
 #include <vector>
 
+namespace Serializer {
+	class Reader;
+	class Writer;
+} // namespace Serializer
+
 struct BVHNode {
 	Aabb aabb;
 
@@ -34,6 +40,11 @@ struct BVHNode {
 class BVHTree {
 public:
 	typedef int objPtr_t;
+
+	// Nodes at this depth are made into leaves whatever their size, so that
+	// the fixed-size traversal stacks in GeomTree and Geom can't overflow
+	static constexpr int MAX_DEPTH = 30;
+
 	BVHTree(const int numObjs, const objPtr_t *objPtrs, const Aabb *objAabbs);
 	~BVHTree()
 	{
@@ -48,7 +59,8 @@ private:
 	void BuildNode(BVHNode *node,
 		const objPtr_t *objPtrs,
 		const Aabb *objAabbs,
-		std::vector<objPtr_t> &activeObjIdxs);
+		std::vector<objPtr_t> &activeObjIdxs,
+		int depth);
 	void MakeLeaf(BVHNode *node, const objPtr_t *objPtrs, std::vector<objPtr_t> &objs);
 	BVHNode *AllocNode();
 	BVHNode *m_root;
@@ -83,6 +95,12 @@ public:
 	// Individual nodes will have leaf indices into this array
 	void Build(const AABBd &bounds, AABBd *objAabbs, uint32_t numObjs);
 
+	// Update node AABBs bottom-up from a new list of AABBs for the same number
+	// of objects, keeping the existing tree topology. Returns false if the tree
+	// can't be refit, or if the refit tree's quality has degraded too far
+	// compared to a fresh build; Build() must be called in that case.
+	bool Refit(const AABBd *objAabbs, uint32_t numObjs);
+
 	// Return a pointer to the node at the given index
 	const Node *GetNode(uint32_t index) const { return m_nodes.data() + index; }
 
@@ -95,6 +113,11 @@ public:
 	uint32_t GetHeight() const { return m_treeHeight; }
 	double CalculateSAH() const;
 
+	// Refit is rejected once the summed surface area of interior nodes
+	// relative to the root (a cheap SAH estimate) grows past this multiple
+	// of its value on the last full build.
+	static constexpr double REFIT_QUALITY_THRESHOLD = 1.5;
+
 private:
 	struct SortKey {
 		vector3f center;
@@ -103,11 +126,106 @@ private:
 
 	void BuildNode(Node *node, SortKey *keys, uint32_t numKeys, AABBd *objAabbs, uint32_t height);
 	uint32_t Partition(SortKey *keys, uint32_t numKeys, const AABBd &aabb, AABBd *objAabbs);
+	// Sum of interior-node surface areas relative to the root node
+	double CalculateRefitCost() const;
 
 	std::vector<Node> m_nodes;
+	uint32_t m_numLeaves;
+	double m_buildCost;
 	uint32_t m_treeHeight;
 	vector3d m_boundsCenter;
 	double m_inv_scale_factor;
 };
 
+/*
+ * Flattened four-wide Bounding Volume Hierarchy, collapsed from a binary
+ * BVHTree for faster ray traversal of static collision meshes.
+ *
+ * Nodes are stored contiguously in depth-first order. Child bounds are
+ * quantized to 8 bits per axis relative to the parent's bounds, rounded
+ * outwards so that they always contain the original child bounds.
+ */
+class WideBVHTree {
+public:
+	static constexpr int WIDTH = 4;
+	static constexpr Uint32 EMPTY_CHILD = ~0U;
+	// each node visited pushes at most WIDTH - 1 more nodes than it pops,
+	// and the tree is no deeper than the binary tree it was built from
+	static constexpr int STACK_SIZE = (WIDTH - 1) * BVHTree::MAX_DEPTH + WIDTH;
+
+	struct Node {
+		// child bounds are origin + q * scale
+		vector3f origin;
+		vector3f scale;
+		Uint8 qmin[3][WIDTH];
+		Uint8 qmax[3][WIDTH];
+		// node index for interior children, index of the first leaf object
+		// for leaf children, or EMPTY_CHILD
+		Uint32 child[WIDTH];
+		// number of objects in leaf children, zero for interior children
+		Uint16 numObjs[WIDTH];
+	};
+
+	explicit WideBVHTree(const BVHNode *root);
+	explicit WideBVHTree(Serializer::Reader &rd);
+	void Save(Serializer::Writer &wr) const;
+
+	const Node *GetNode(Uint32 index) const { return &m_nodes[index]; }
+	size_t GetNumNodes() const { return m_nodes.size(); }
+	const BVHTree::objPtr_t *GetLeafObjs(Uint32 first) const { return &m_leafObjs[first]; }
+
+	static void GetChildBounds(const Node &node, AabbSoA4 &bounds);
+
+	// Visit the leaves hit by a ray, nearest child first. invDir components
+	// should be zero where the ray direction is zero. leafFn is called with
+	// (const objPtr_t *objs, int numObjs) and may shorten dist.
+	template <typename LeafFn>
+	void TraceRay(const vector3f &origin, const vector3f &invDir, float &dist, LeafFn &&leafFn) const;
+
+private:
+	Uint32 BuildNode(const BVHNode *bnode);
+
+	std::vector<Node> m_nodes;
+	std::vector<BVHTree::objPtr_t> m_leafObjs;
+};
+
+template <typename LeafFn>
+void WideBVHTree::TraceRay(const vector3f &origin, const vector3f &invDir, float &dist, LeafFn &&leafFn) const
+{
+	Uint32 stack[STACK_SIZE];
+	int stackpos = 0;
+	stack[0] = 0;
+
+	while (stackpos >= 0) {
+		const Node &node = m_nodes[stack[stackpos--]];
+
+		AabbSoA4 bounds;
+		GetChildBounds(node, bounds);
+		alignas(16) float tNear[WIDTH];
+		int hits = RayKernels::RayAabb4(origin, invDir, bounds, dist, tNear);
+
+		// leaves are tested straight away, interior children are pushed
+		// furthest first so the nearest is popped next
+		int interior[WIDTH];
+		int numInterior = 0;
+		for (int i = 0; i < WIDTH; i++) {
+			if (!(hits & (1 << i)) || node.child[i] == EMPTY_CHILD)
+				continue;
+
+			if (node.numObjs[i]) {
+				leafFn(&m_leafObjs[node.child[i]], int(node.numObjs[i]));
+				continue;
+			}
+
+			int pos = numInterior++;
+			for (; pos > 0 && tNear[interior[pos - 1]] < tNear[i]; pos--)
+				interior[pos] = interior[pos - 1];
+			interior[pos] = i;
+		}
+
+		for (int i = 0; i < numInterior; i++)
+			stack[++stackpos] = node.child[interior[i]];
+	}
+}
+
 #endif /* _BVHTREE_H */
@@ -13,6 +13,14 @@
 
 int CollisionSpace::s_nextHandle = 1;
 
+// contact buffer for the collision running on this thread, if buffering
+static thread_local std::vector<CollisionContact> *tl_contactBuffer = nullptr;
+
+static void BufferContact(CollisionContact *contact)
+{
+	tl_contactBuffer->push_back(*contact);
+}
+
 CollisionSpace::CollisionSpace() :
 	m_staticObjectTree(new SingleBVHTree()),
 	m_dynamicObjectTree(new SingleBVHTree()),
@@ -109,12 +117,29 @@ void CollisionSpace::CollideRaySphere(const vector3d &start, const vector3d &dir
 void CollisionSpace::TraceRay(const vector3d &start, const vector3d &dir, double len, CollisionContact *c, const Geom *ignore /*= nullptr*/)
 {
 	PROFILE_SCOPED()
-	vector3d invDir(1.0 / dir.x, 1.0 / dir.y, 1.0 / dir.z);
-	c->distance = len;
+	std::vector<uint32_t> isect_result;
+	isect_result.reserve(8);
+
+	TraceRayInternal(start, dir, len, c, ignore, isect_result);
+}
 
+void CollisionSpace::TraceRays(size_t numRays, const vector3d *starts, const vector3d *dirs, const double *lens, const Geom *const *ignore, CollisionContact *contacts)
+{
+	PROFILE_SCOPED()
 	std::vector<uint32_t> isect_result;
 	isect_result.reserve(8);
 
+	for (size_t i = 0; i < numRays; i++) {
+		TraceRayInternal(starts[i], dirs[i], lens[i], &contacts[i], ignore ? ignore[i] : nullptr, isect_result);
+		isect_result.clear();
+	}
+}
+
+void CollisionSpace::TraceRayInternal(const vector3d &start, const vector3d &dir, double len, CollisionContact *c, const Geom *ignore, std::vector<uint32_t> &isect_result)
+{
+	vector3d invDir(1.0 / dir.x, 1.0 / dir.y, 1.0 / dir.z);
+	c->distance = len;
+
 	if (m_enabledStaticGeoms > 0) {
 		m_staticObjectTree->TraceRay(start, invDir, len, isect_result);
 
@@ -215,15 +240,17 @@ void CollisionSpace::RebuildObjectTrees()
 		std::vector<AABBd> staticAabbs;
 
 		m_enabledStaticGeoms = SortEnabledGeoms(m_staticGeoms);
-		RebuildBVHTree(m_staticObjectTree.get(), m_enabledStaticGeoms, m_staticGeoms, staticAabbs);
+		RebuildBVHTree(m_staticObjectTree.get(), m_enabledStaticGeoms, m_staticGeoms, staticAabbs, false);
 		m_needStaticGeomRebuild = false;
 	}
 
 	// NOTE: we store AABBs in m_geomAabbs for fast O(1) lookup during Collide()
 	// This doubles the memory cost but allows SingleBVHTree to store leaf nodes
 	// in a cache-friendly order.
+	// Most dynamic geoms barely move between steps, so the existing tree is
+	// refit where possible rather than rebuilt from scratch.
 	m_enabledDynGeoms = SortEnabledGeoms(m_geoms);
-	RebuildBVHTree(m_dynamicObjectTree.get(), m_enabledDynGeoms, m_geoms, m_geomAabbs);
+	RebuildBVHTree(m_dynamicObjectTree.get(), m_enabledDynGeoms, m_geoms, m_geomAabbs, true);
 }
 
 uint32_t CollisionSpace::SortEnabledGeoms(std::vector<Geom *> &geoms)
@@ -250,7 +277,7 @@ uint32_t CollisionSpace::SortEnabledGeoms(std::vector<Geom *> &geoms)
 	return startIdx;
 }
 
-void CollisionSpace::RebuildBVHTree(SingleBVHTree *tree, uint32_t numGeoms, const std::vector<Geom *> &geoms, std::vector<AABBd> &aabbs)
+void CollisionSpace::RebuildBVHTree(SingleBVHTree *tree, uint32_t numGeoms, const std::vector<Geom *> &geoms, std::vector<AABBd> &aabbs, bool allowRefit)
 {
 	PROFILE_SCOPED()
 	assert(numGeoms < INT32_MAX);
@@ -278,6 +305,11 @@ void CollisionSpace::RebuildBVHTree(SingleBVHTree *tree, uint32_t numGeoms, cons
 		bounds.Update(aabb);
 	}
 
+	// The tree's leaves index into aabbs, so a tree with the same number of
+	// leaves stays valid whichever geoms now occupy each slot.
+	if (allowRefit && tree->Refit(aabbs.data(), aabbs.size()))
+		return;
+
 	tree->Build(bounds, aabbs.data(), aabbs.size());
 }
 
@@ -328,6 +360,14 @@ void CollisionSpace::Collide(void (*callback)(CollisionContact *))
 	m_duringCollision = false;
 }
 
+void CollisionSpace::Collide(std::vector<CollisionContact> &contacts)
+{
+	assert(!tl_contactBuffer);
+	tl_contactBuffer = &contacts;
+	Collide(&BufferContact);
+	tl_contactBuffer = nullptr;
+}
+
 void CollisionSpace::CollidePlanet(void (*callback)(CollisionContact *))
 {
 	PROFILE_SCOPED()
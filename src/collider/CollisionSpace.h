@@ -34,7 +34,13 @@ public:
 	void AddStaticGeom(Geom *);
 	void RemoveStaticGeom(Geom *);
 	void TraceRay(const vector3d &start, const vector3d &dir, double len, CollisionContact *c, const Geom *ignore = nullptr);
+	// Trace numRays rays at once, sharing per-call setup between them.
+	// ignore may be null, otherwise it holds a geom to skip for each ray.
+	void TraceRays(size_t numRays, const vector3d *starts, const vector3d *dirs, const double *lens, const Geom *const *ignore, CollisionContact *contacts);
 	void Collide(void (*callback)(CollisionContact *));
+	// Collide this space, appending contacts to the buffer rather than
+	// handling them immediately. Safe to call concurrently for different spaces.
+	void Collide(std::vector<CollisionContact> &contacts);
 	void SetSphere(const vector3d &pos, double radius, void *user_data)
 	{
 		sphere.pos = pos;
@@ -61,8 +67,9 @@ private:
 	using Intersection = std::pair<uint32_t, uint32_t>;
 
 	void CollideRaySphere(const vector3d &start, const vector3d &dir, isect_t *isect);
+	void TraceRayInternal(const vector3d &start, const vector3d &dir, double len, CollisionContact *c, const Geom *ignore, std::vector<uint32_t> &isect_result);
 	uint32_t SortEnabledGeoms(std::vector<Geom *> &geoms);
-	void RebuildBVHTree(SingleBVHTree *tree, uint32_t numEnabled, const std::vector<Geom *> &geoms, std::vector<AABBd> &aabbs);
+	void RebuildBVHTree(SingleBVHTree *tree, uint32_t numEnabled, const std::vector<Geom *> &geoms, std::vector<AABBd> &aabbs, bool allowRefit);
 
 	void CollideGeom(Geom *a, Geom *b, void (*callback)(CollisionContact *));
 	void CollidePlanet(void (*callback)(CollisionContact *));
@@ -4,6 +4,7 @@
 #include "GeomTree.h"
 
 #include "BVHTree.h"
+#include "RayKernels.h"
 #include "Weld.h"
 #include "scenegraph/Serializer.h"
 #include "../utils.h"
@@ -106,6 +107,7 @@ GeomTree::GeomTree(const int numVerts, const int numTris, const std::vector<vect
 		m_triTree.reset(new BVHTree(activeTris.size(), &activeTris[0], aabbs));
 		delete[] aabbs;
 	}
+	m_wideTriTree.reset(new WideBVHTree(m_triTree->GetRoot()));
 	//Output("Tri tree of %d tris build in %dms\n", activeTris.size(), SDL_GetTicks() - t);
 
 	m_numEdges = edges.size();
@@ -189,6 +191,8 @@ GeomTree::GeomTree(Serializer::Reader &rd)
 		m_triFlags[iTri] = rd.Int32();
 	}
 
+	m_wideTriTree.reset(new WideBVHTree(rd));
+
 	// activeTris = tris we are still trying to put into leaves
 	std::vector<int> activeTris;
 	activeTris.reserve(m_numTris);
@@ -206,6 +210,7 @@ GeomTree::GeomTree(Serializer::Reader &rd)
 		aabbs[i].Update(v2);
 		aabbs[i].Update(v3);
 	}
+	// the binary tree is still needed for edge collisions in Geom
 	m_triTree.reset(new BVHTree(activeTris.size(), &activeTris[0], aabbs));
 	delete[] aabbs;
 
@@ -244,7 +249,15 @@ static bool SlabsRayAabbTest(const BVHNode *n, const vector3f &start, const vect
 
 void GeomTree::TraceRay(const vector3f &start, const vector3f &dir, isect_t *isect) const
 {
-	TraceRay(m_triTree->GetRoot(), start, dir, isect);
+	// PROFILE_SCOPED()
+	const vector3f invDir( // avoid division by zero please
+		is_zero_exact(dir.x) ? 0.0f : (1.0f / dir.x),
+		is_zero_exact(dir.y) ? 0.0f : (1.0f / dir.y),
+		is_zero_exact(dir.z) ? 0.0f : (1.0f / dir.z));
+
+	m_wideTriTree->TraceRay(start, invDir, isect->dist, [&](const int *triIdxs, int numTris) {
+		RayLeafIntersect(start, dir, triIdxs, numTris, isect);
+	});
 }
 
 void GeomTree::TraceRay(const BVHNode *currnode, const vector3f &a_origin, const vector3f &a_dir, isect_t *isect) const
@@ -266,9 +279,7 @@ void GeomTree::TraceRay(const BVHNode *currnode, const vector3f &a_origin, const
 			currnode = currnode->kids[0];
 		}
 		// triangle intersection jizz
-		for (int i = 0; i < currnode->numTris; i++) {
-			RayTriIntersect(1, a_origin, &a_dir, currnode->triIndicesStart[i], isect);
-		}
+		RayLeafIntersect(a_origin, a_dir, currnode->triIndicesStart, currnode->numTris, isect);
 	pop_bstack:
 		if (stackpos < 0) break;
 		currnode = stack[stackpos];
@@ -306,6 +317,38 @@ void GeomTree::RayTriIntersect(int numRays, const vector3f &origin, const vector
 	}
 }
 
+void GeomTree::RayTriIntersect4(const vector3f &origin, const vector3f &dir, const int *triIdxs, int numTris, isect_t *isect) const
+{
+	// PROFILE_SCOPED()
+	TriSoA4 tris;
+	for (int lane = 0; lane < 4; lane++) {
+		// unused lanes repeat the first triangle and are masked off by the kernel
+		const int triIdx = triIdxs[lane < numTris ? lane : 0];
+		const vector3f &a = m_vertices[m_indices[triIdx + 0]];
+		const vector3f &b = m_vertices[m_indices[triIdx + 1]];
+		const vector3f &c = m_vertices[m_indices[triIdx + 2]];
+		tris.ax[lane] = a.x, tris.ay[lane] = a.y, tris.az[lane] = a.z;
+		tris.bx[lane] = b.x, tris.by[lane] = b.y, tris.bz[lane] = b.z;
+		tris.cx[lane] = c.x, tris.cy[lane] = c.y, tris.cz[lane] = c.z;
+	}
+
+	const int lane = RayKernels::RayTri4(origin, dir, tris, numTris, isect->dist);
+	if (lane >= 0)
+		isect->triIdx = triIdxs[lane] / 3;
+}
+
+void GeomTree::RayLeafIntersect(const vector3f &origin, const vector3f &dir, const int *triIdxs, int numTris, isect_t *isect) const
+{
+	if (numTris == 1) {
+		RayTriIntersect(1, origin, &dir, triIdxs[0], isect);
+		return;
+	}
+
+	// leaves which couldn't be split further are tested four at a time
+	for (int i = 0; i < numTris; i += 4)
+		RayTriIntersect4(origin, dir, &triIdxs[i], std::min(numTris - i, 4), isect);
+}
+
 vector3f GeomTree::GetTriNormal(int triIdx) const
 {
 	PROFILE_SCOPED()
@@ -349,4 +392,6 @@ void GeomTree::Save(Serializer::Writer &wr) const
 	for (Sint32 iTri = 0; iTri < m_numTris; ++iTri) {
 		wr.Int32(m_triFlags[iTri]);
 	}
+
+	m_wideTriTree->Save(wr);
 }
@@ -21,6 +21,7 @@ struct isect_t {
 };
 
 class BVHTree;
+class WideBVHTree;
 struct BVHNode;
 
 class GeomTree {
@@ -59,6 +60,7 @@ public:
 	int GetNumEdges() const { return m_numEdges; }
 
 	BVHTree *GetTriTree() const { return m_triTree.get(); }
+	const WideBVHTree *GetWideTriTree() const { return m_wideTriTree.get(); }
 	BVHTree *GetEdgeTree() const { return m_edgeTree.get(); }
 
 	const std::vector<vector3f> &GetVertices() const { return m_vertices; }
@@ -69,6 +71,10 @@ public:
 
 private:
 	void RayTriIntersect(int numRays, const vector3f &origin, const vector3f *dirs, int triIdx, isect_t *isects) const;
+	// intersect one ray with up to four triangles at once
+	void RayTriIntersect4(const vector3f &origin, const vector3f &dir, const int *triIdxs, int numTris, isect_t *isect) const;
+	// intersect one ray with all the triangles of a BVH leaf
+	void RayLeafIntersect(const vector3f &origin, const vector3f &dir, const int *triIdxs, int numTris, isect_t *isect) const;
 
 	int m_numVertices;
 	int m_numEdges;
@@ -79,6 +85,8 @@ private:
 	std::vector<Aabb> m_aabbs;
 
 	std::unique_ptr<BVHTree> m_triTree;
+	// flattened copy of m_triTree for ray traces, stored in the .sgm file
+	std::unique_ptr<WideBVHTree> m_wideTriTree;
 	std::unique_ptr<BVHTree> m_edgeTree;
 
 	std::vector<Edge> m_edges;
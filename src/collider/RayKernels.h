@@ -0,0 +1,202 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _RAYKERNELS_H
+#define _RAYKERNELS_H
+
+#include "vector3.h"
+
+// Four-wide ray intersection kernels used by the collision BVH.
+//
+// SSE2 and NEON are part of the baseline instruction set on every x86-64
+// and AArch64 target we build for, so the implementation is selected at
+// compile time. Other targets use the scalar fallback, which computes
+// exactly the same per-lane results.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RAYKERNELS_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define RAYKERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Structure-of-arrays layout of four AABBs
+struct alignas(16) AabbSoA4 {
+	float minX[4], minY[4], minZ[4];
+	float maxX[4], maxY[4], maxZ[4];
+};
+
+// Structure-of-arrays layout of the vertices of four triangles
+struct alignas(16) TriSoA4 {
+	float ax[4], ay[4], az[4];
+	float bx[4], by[4], bz[4];
+	float cx[4], cy[4], cz[4];
+};
+
+namespace RayKernels {
+
+	// Name of the instruction set used by the kernels, for logging and benchmarks
+	inline const char *GetImplementationName()
+	{
+#if defined(RAYKERNELS_SSE2)
+		return "SSE2";
+#elif defined(RAYKERNELS_NEON)
+		return "NEON";
+#else
+		return "scalar";
+#endif
+	}
+
+	// Minimal four-lane float vector wrapper over the selected instruction set
+	struct float4 {
+#if defined(RAYKERNELS_SSE2)
+		__m128 v;
+		static float4 load(const float *p) { return { _mm_load_ps(p) }; }
+		static float4 set1(float f) { return { _mm_set1_ps(f) }; }
+		friend float4 operator+(float4 a, float4 b) { return { _mm_add_ps(a.v, b.v) }; }
+		friend float4 operator-(float4 a, float4 b) { return { _mm_sub_ps(a.v, b.v) }; }
+		friend float4 operator*(float4 a, float4 b) { return { _mm_mul_ps(a.v, b.v) }; }
+		friend float4 operator/(float4 a, float4 b) { return { _mm_div_ps(a.v, b.v) }; }
+		friend float4 vmin(float4 a, float4 b) { return { _mm_min_ps(a.v, b.v) }; }
+		friend float4 vmax(float4 a, float4 b) { return { _mm_max_ps(a.v, b.v) }; }
+		// comparisons return a lane bitmask, bit N set for lane N
+		friend int operator>(float4 a, float4 b) { return _mm_movemask_ps(_mm_cmpgt_ps(a.v, b.v)); }
+		friend int operator<(float4 a, float4 b) { return _mm_movemask_ps(_mm_cmplt_ps(a.v, b.v)); }
+		friend int operator>=(float4 a, float4 b) { return _mm_movemask_ps(_mm_cmpge_ps(a.v, b.v)); }
+		void store(float *p) const { _mm_store_ps(p, v); }
+#elif defined(RAYKERNELS_NEON)
+		float32x4_t v;
+		static float4 load(const float *p) { return { vld1q_f32(p) }; }
+		static float4 set1(float f) { return { vdupq_n_f32(f) }; }
+		friend float4 operator+(float4 a, float4 b) { return { vaddq_f32(a.v, b.v) }; }
+		friend float4 operator-(float4 a, float4 b) { return { vsubq_f32(a.v, b.v) }; }
+		friend float4 operator*(float4 a, float4 b) { return { vmulq_f32(a.v, b.v) }; }
+		friend float4 operator/(float4 a, float4 b)
+		{
+			float ra[4], rb[4];
+			vst1q_f32(ra, a.v);
+			vst1q_f32(rb, b.v);
+			for (int i = 0; i < 4; i++)
+				ra[i] /= rb[i];
+			return { vld1q_f32(ra) };
+		}
+		friend float4 vmin(float4 a, float4 b) { return { vminq_f32(a.v, b.v) }; }
+		friend float4 vmax(float4 a, float4 b) { return { vmaxq_f32(a.v, b.v) }; }
+		static int movemask(uint32x4_t m)
+		{
+			return (vgetq_lane_u32(m, 0) & 1) | (vgetq_lane_u32(m, 1) & 2) |
+				(vgetq_lane_u32(m, 2) & 4) | (vgetq_lane_u32(m, 3) & 8);
+		}
+		friend int operator>(float4 a, float4 b) { return movemask(vcgtq_f32(a.v, b.v)); }
+		friend int operator<(float4 a, float4 b) { return movemask(vcltq_f32(a.v, b.v)); }
+		friend int operator>=(float4 a, float4 b) { return movemask(vcgeq_f32(a.v, b.v)); }
+		void store(float *p) const { vst1q_f32(p, v); }
+#else
+		float v[4];
+		static float4 load(const float *p) { return { { p[0], p[1], p[2], p[3] } }; }
+		static float4 set1(float f) { return { { f, f, f, f } }; }
+		template <typename Op>
+		static float4 apply(float4 a, float4 b, Op op) { return { { op(a.v[0], b.v[0]), op(a.v[1], b.v[1]), op(a.v[2], b.v[2]), op(a.v[3], b.v[3]) } }; }
+		template <typename Op>
+		static int compare(float4 a, float4 b, Op op) { return op(a.v[0], b.v[0]) | (op(a.v[1], b.v[1]) << 1) | (op(a.v[2], b.v[2]) << 2) | (op(a.v[3], b.v[3]) << 3); }
+		friend float4 operator+(float4 a, float4 b) { return apply(a, b, [](float x, float y) { return x + y; }); }
+		friend float4 operator-(float4 a, float4 b) { return apply(a, b, [](float x, float y) { return x - y; }); }
+		friend float4 operator*(float4 a, float4 b) { return apply(a, b, [](float x, float y) { return x * y; }); }
+		friend float4 operator/(float4 a, float4 b) { return apply(a, b, [](float x, float y) { return x / y; }); }
+		friend float4 vmin(float4 a, float4 b) { return apply(a, b, [](float x, float y) { return x < y ? x : y; }); }
+		friend float4 vmax(float4 a, float4 b) { return apply(a, b, [](float x, float y) { return x > y ? x : y; }); }
+		friend int operator>(float4 a, float4 b) { return compare(a, b, [](float x, float y) { return int(x > y); }); }
+		friend int operator<(float4 a, float4 b) { return compare(a, b, [](float x, float y) { return int(x < y); }); }
+		friend int operator>=(float4 a, float4 b) { return compare(a, b, [](float x, float y) { return int(x >= y); }); }
+		void store(float *p) const { p[0] = v[0], p[1] = v[1], p[2] = v[2], p[3] = v[3]; }
+#endif
+	};
+
+	// Slab test of a ray against four AABBs. invDir components should be zero
+	// where the ray direction is zero. Returns a bitmask of the boxes hit
+	// closer than maxDist; if tNear is non-null it receives the entry
+	// distance for each lane.
+	inline int RayAabb4(const vector3f &origin, const vector3f &invDir, const AabbSoA4 &boxes, float maxDist, float *tNear = nullptr)
+	{
+		const float4 ox = float4::set1(origin.x), oy = float4::set1(origin.y), oz = float4::set1(origin.z);
+		const float4 ix = float4::set1(invDir.x), iy = float4::set1(invDir.y), iz = float4::set1(invDir.z);
+
+		float4 l1 = (float4::load(boxes.minX) - ox) * ix;
+		float4 l2 = (float4::load(boxes.maxX) - ox) * ix;
+		float4 lmin = vmin(l1, l2);
+		float4 lmax = vmax(l1, l2);
+
+		l1 = (float4::load(boxes.minY) - oy) * iy;
+		l2 = (float4::load(boxes.maxY) - oy) * iy;
+		lmin = vmax(vmin(l1, l2), lmin);
+		lmax = vmin(vmax(l1, l2), lmax);
+
+		l1 = (float4::load(boxes.minZ) - oz) * iz;
+		l2 = (float4::load(boxes.maxZ) - oz) * iz;
+		lmin = vmax(vmin(l1, l2), lmin);
+		lmax = vmin(vmax(l1, l2), lmax);
+
+		if (tNear)
+			lmin.store(tNear);
+
+		const float4 zero = float4::set1(0.f);
+		return (lmax >= zero) & (lmax >= lmin) & (lmin < float4::set1(maxDist));
+	}
+
+	// Intersect a ray with the first numTris (at most four) triangles, using
+	// the same test as GeomTree::RayTriIntersect. Returns the lane of the
+	// nearest hit closer than dist and updates dist, or returns -1.
+	inline int RayTri4(const vector3f &origin, const vector3f &dir, const TriSoA4 &tris, int numTris, float &dist)
+	{
+		const float4 ox = float4::set1(origin.x), oy = float4::set1(origin.y), oz = float4::set1(origin.z);
+		const float4 dx = float4::set1(dir.x), dy = float4::set1(dir.y), dz = float4::set1(dir.z);
+
+		// triangle vertices relative to the ray origin
+		const float4 ax = float4::load(tris.ax) - ox, ay = float4::load(tris.ay) - oy, az = float4::load(tris.az) - oz;
+		const float4 bx = float4::load(tris.bx) - ox, by = float4::load(tris.by) - oy, bz = float4::load(tris.bz) - oz;
+		const float4 cx = float4::load(tris.cx) - ox, cy = float4::load(tris.cy) - oy, cz = float4::load(tris.cz) - oz;
+
+		// signed volumes of the ray against each edge: ((c x b), (b x a), (a x c)) . dir
+		const float4 v0d = (cy * bz - cz * by) * dx + (cz * bx - cx * bz) * dy + (cx * by - cy * bx) * dz;
+		const float4 v1d = (by * az - bz * ay) * dx + (bz * ax - bx * az) * dy + (bx * ay - by * ax) * dz;
+		const float4 v2d = (ay * cz - az * cy) * dx + (az * cx - ax * cz) * dy + (ax * cy - ay * cx) * dz;
+
+		const float4 zero = float4::set1(0.f);
+		const int inside = ((v0d > zero) & (v1d > zero) & (v2d > zero)) |
+			((v0d < zero) & (v1d < zero) & (v2d < zero));
+
+		// nearly every group is rejected here, so only pay for the plane
+		// distance when some lane is inside all three edges
+		const int laneMask = (1 << numTris) - 1;
+		if (!(inside & laneMask))
+			return -1;
+
+		// n = (c - a) x (b - a)
+		const float4 e1x = cx - ax, e1y = cy - ay, e1z = cz - az;
+		const float4 e2x = bx - ax, e2y = by - ay, e2z = bz - az;
+		const float4 nx = e1y * e2z - e1z * e2y;
+		const float4 ny = e1z * e2x - e1x * e2z;
+		const float4 nz = e1x * e2y - e1y * e2x;
+		const float4 nominator = nx * ax + ny * ay + nz * az;
+
+		const float4 t = nominator / (nx * dx + ny * dy + nz * dz);
+		int hits = inside & laneMask & (t > zero) & (t < float4::set1(dist));
+		if (!hits)
+			return -1;
+
+		alignas(16) float tLanes[4];
+		t.store(tLanes);
+
+		int nearest = -1;
+		for (int lane = 0; lane < 4; lane++) {
+			if ((hits & (1 << lane)) && tLanes[lane] < dist) {
+				dist = tLanes[lane];
+				nearest = lane;
+			}
+		}
+		return nearest;
+	}
+
+} // namespace RayKernels
+
+#endif /* _RAYKERNELS_H */
@@ -3,11 +3,15 @@
 
 #include "Application.h"
 #include "FileSystem.h"
+#include "FrameTimeline.h"
+#include "HitchDetector.h"
 #include "JobQueue.h"
+#include "Log.h"
 #include "OS.h"
 #include "SDL.h"
 #include "StringName.h"
 #include "TaskGraph.h"
+#include "Json.h"
 #include "profiler/Profiler.h"
 
 #include "SDL_timer.h"
@@ -15,8 +19,15 @@
 #include <stdexcept>
 
 static constexpr Uint32 SYNC_JOBS_PER_LOOP = 1;
+// hitch reports are numbered in turn and overwrite the oldest ones
+static constexpr Uint32 MAX_HITCH_REPORTS = 10;
+
+Application::Application() :
+	m_frameTimeline(std::make_unique<FrameTimeline>()),
+	m_hitchDetector(std::make_unique<HitchDetector>())
+{
+}
 
-Application::Application() {}
 Application::~Application() {}
 
 void Application::QueueLifecycle(RefCountedPtr<Lifecycle> cycle)
@@ -57,6 +68,9 @@ void Application::Shutdown()
 	m_taskGraph.reset();
 	m_syncJobQueue.reset();
 
+	// write out everything queued before the log is left to static destruction
+	Log::GetLog()->SetAsync(false);
+
 	FileSystem::Uninit();
 	SDL_Quit();
 }
@@ -147,15 +161,42 @@ void Application::ClearQueuedLifecycles()
 		m_queuedLifecycles.pop();
 }
 
+void Application::WriteHitchReport()
+{
+	const Json report = m_hitchDetector->TakeReport();
+
+	FileSystem::userFiles.MakeDirectory("hitches");
+	const std::string path = FileSystem::JoinPathBelow("hitches", "hitch-" + std::to_string(m_numHitchReports++ % MAX_HITCH_REPORTS) + ".json");
+	FILE *file = FileSystem::userFiles.OpenWriteStream(path, FileSystem::FileSourceFS::WRITE_TEXT);
+	if (!file) {
+		Output("Could not write hitch report %s\n", path.c_str());
+		return;
+	}
+
+	const std::string text = report.dump(1, '\t') + "\n";
+	fputs(text.c_str(), file);
+	fclose(file);
+	Output("Frame %s took longer than %.0f ms, wrote %s\n", report["hitchFrame"].dump().c_str(), m_hitchDetector->GetThreshold(), path.c_str());
+}
+
 void Application::HandleJobs()
 {
 	m_taskGraph->RunPinnedTasks();
 	m_syncJobQueue->RunJobs(SYNC_JOBS_PER_LOOP);
-	m_syncJobQueue->FinishJobs();
-	m_taskGraph->GetJobQueue()->FinishJobs();
+	{
+		HitchDetector::ScopedPhase phase(m_hitchDetector.get(), HitchDetector::PHASE_FINISH_JOBS);
+		m_syncJobQueue->FinishJobs();
+		m_taskGraph->GetJobQueue()->FinishJobs(m_jobFinishBudget);
+	}
+	m_taskGraph->GetStats().FlushFrame();
+	m_taskGraph->UpdateUtilisation();
+	m_hitchDetector->SetQueuedJobs(m_taskGraph->GetQueuedJobCount());
 
-	// Reclaim StringTable memory periodically
-	StringTable::Get()->Reclaim();
+	// deliver log messages from worker threads to the console and UI
+	Log::GetLog()->DispatchCallbacks();
+
+	// Reclaim StringName memory periodically
+	StringPool::Get()->Reclaim();
 }
 
 void Application::Run()
@@ -207,11 +248,14 @@ void Application::Run()
 			EndLifecycle();
 		}
 
-#ifdef PIONEER_PROFILER
-		// TODO: potential pigui frame profile inspector
 		m_runtime.SoftStop();
 		thisTime = m_runtime.seconds();
 
+		if (m_hitchDetector->EndFrame((thisTime - m_totalTime) * 1e3))
+			WriteHitchReport();
+
+#ifdef PIONEER_PROFILER
+
 		// profile frames taking longer than 100ms
 		bool isSlowProfile = (m_doSlowProfile && thisTime - m_totalTime > 0.100);
 		if (m_doTempProfile || isSlowProfile) {
@@ -229,6 +273,11 @@ void Application::Run()
 			}
 		}
 
+		// keep the zones of the frame for the timeline view before the
+		// reset discards them
+		if (profileReset && m_frameTimeline->IsEnabled())
+			m_frameTimeline->RecordFrame((thisTime - m_totalTime) * 1e3);
+
 		// reset the profiler at the end of the frame
 		if (profileReset)
 			Profiler::reset();
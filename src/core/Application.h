@@ -9,6 +9,8 @@
 #include <queue>
 #include <string>
 
+class FrameTimeline;
+class HitchDetector;
 class JobQueue;
 class SyncJobQueue;
 class TaskGraph;
@@ -90,6 +92,12 @@ public:
 
 	void RequestProfileFrame(const std::string &path = "");
 
+	// Per-frame profiler zones for the in-game timeline view
+	FrameTimeline *GetFrameTimeline() { return m_frameTimeline.get(); }
+
+	// Per-frame phase timings, written out when a frame hitches
+	HitchDetector *GetHitchDetector() { return m_hitchDetector.get(); }
+
 protected:
 	// Hooks for inheriting classes to add their own behaviors to.
 
@@ -124,15 +132,22 @@ protected:
 	void SetProfileZones(bool enabled) { m_profileZones = enabled; }
 	void SetProfileTrace(bool enabled) { m_profileTrace = enabled; }
 
+	// Limit the time spent per frame handing finished background jobs to the
+	// main thread, in microseconds. Zero processes every finished job.
+	void SetJobFinishBudget(uint32_t maxMicros) { m_jobFinishBudget = maxMicros; }
+
 private:
 	bool StartLifecycle();
 	void EndLifecycle();
+	void WriteHitchReport();
 
 	bool m_applicationRunning = false;
 	bool m_doTempProfile = false;
 	bool m_doSlowProfile = false;
 	bool m_profileZones = false;
 	bool m_profileTrace = false;
+	uint32_t m_jobFinishBudget = 0;
+	uint32_t m_numHitchReports = 0;
 	float m_deltaTime = 0.f;
 	double m_totalTime = 0.f;
 
@@ -150,4 +165,6 @@ private:
 
 	std::unique_ptr<SyncJobQueue> m_syncJobQueue;
 	std::unique_ptr<TaskGraph> m_taskGraph;
+	std::unique_ptr<FrameTimeline> m_frameTimeline;
+	std::unique_ptr<HitchDetector> m_hitchDetector;
 };
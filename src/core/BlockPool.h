@@ -0,0 +1,97 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <vector>
+
+// Thread-safe free-list allocator for blocks of a single fixed size.
+//
+// Freed blocks are kept for reuse instead of being returned to the heap, up
+// to a maximum number of cached blocks. Intended for objects which are
+// allocated and released at a high rate on different threads, such as the
+// requests and results passed between terrain jobs and the main thread.
+class BlockPool {
+public:
+	BlockPool(size_t blockSize, size_t maxFree = 256) :
+		m_blockSize(blockSize),
+		m_maxFree(maxFree),
+		m_numAllocated(0)
+	{
+		m_free.reserve(maxFree);
+	}
+
+	~BlockPool() { Clear(); }
+
+	BlockPool(const BlockPool &) = delete;
+	BlockPool &operator=(const BlockPool &) = delete;
+
+	// If reused is non-null, it is set to whether the block came from the
+	// free list rather than a fresh heap allocation.
+	void *Allocate(bool *reused = nullptr)
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_numAllocated++;
+		if (reused)
+			*reused = !m_free.empty();
+
+		if (!m_free.empty()) {
+			void *block = m_free.back();
+			m_free.pop_back();
+			return block;
+		}
+
+		return ::operator new(m_blockSize);
+	}
+
+	void Free(void *block)
+	{
+		if (!block)
+			return;
+
+		std::lock_guard<std::mutex> lock(m_lock);
+		assert(m_numAllocated > 0);
+		m_numAllocated--;
+		if (m_free.size() < m_maxFree)
+			m_free.push_back(block);
+		else
+			::operator delete(block);
+	}
+
+	// release all cached blocks back to the heap
+	void Clear()
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		for (void *block : m_free)
+			::operator delete(block);
+		m_free.clear();
+	}
+
+	size_t GetBlockSize() const { return m_blockSize; }
+
+	// number of blocks currently handed out by the pool
+	size_t GetNumAllocated() const
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		return m_numAllocated;
+	}
+
+	// number of blocks currently cached for reuse
+	size_t GetNumFree() const
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		return m_free.size();
+	}
+
+private:
+	const size_t m_blockSize;
+	const size_t m_maxFree;
+
+	mutable std::mutex m_lock;
+	std::vector<void *> m_free;
+	size_t m_numAllocated;
+};
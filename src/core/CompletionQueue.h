@@ -0,0 +1,74 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#pragma once
+
+#include <atomic_queue/atomic_queue.h>
+#include <atomic>
+#include <deque>
+#include <mutex>
+
+// Bounded multi-producer, single-consumer queue used to hand completed work
+// back to the thread that owns it.
+//
+// Producers push into a lock-free ring buffer. If the consumer falls behind
+// and the ring fills up, items spill into a mutex-protected overflow list
+// instead of stalling the producer until a ring slot frees up. Items in the
+// ring are consumed before those in the overflow list, so ordering between
+// the two paths is not preserved.
+template <typename T, unsigned Size>
+class CompletionQueue {
+public:
+	CompletionQueue() :
+		m_overflowSize(0),
+		m_numOverflowed(0)
+	{}
+
+	// Thread-safe, may be called from any number of producer threads
+	void push(T item)
+	{
+		if (m_ring.try_push(item))
+			return;
+
+		std::lock_guard<std::mutex> lock(m_overflowLock);
+		m_overflow.push_back(item);
+		m_overflowSize.fetch_add(1, std::memory_order_release);
+		m_numOverflowed.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// Must only be called from the consumer thread
+	bool try_pop(T &item)
+	{
+		if (m_ring.try_pop(item))
+			return true;
+
+		if (!m_overflowSize.load(std::memory_order_acquire))
+			return false;
+
+		std::lock_guard<std::mutex> lock(m_overflowLock);
+		if (m_overflow.empty())
+			return false;
+
+		item = m_overflow.front();
+		m_overflow.pop_front();
+		m_overflowSize.fetch_sub(1, std::memory_order_release);
+		return true;
+	}
+
+	// approximate number of items waiting in the queue
+	size_t was_size() const
+	{
+		return m_ring.was_size() + m_overflowSize.load(std::memory_order_relaxed);
+	}
+
+	// number of items which took the overflow path since creation
+	size_t num_overflowed() const { return m_numOverflowed.load(std::memory_order_relaxed); }
+
+private:
+	atomic_queue::AtomicQueue2<T, Size> m_ring;
+
+	std::mutex m_overflowLock;
+	std::deque<T> m_overflow;
+	std::atomic<size_t> m_overflowSize;
+	std::atomic<size_t> m_numOverflowed;
+};
@@ -0,0 +1,90 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <utility>
+#include <vector>
+
+// Implicit D-ary min-heap stored in a flat vector.
+//
+// Compared to a binary heap, a wider node halves the tree depth (for D = 4),
+// so push does fewer moves and pop touches fewer cache lines. Pushing keys
+// that arrive in roughly increasing order, like timer deadlines, is O(1) on
+// average since the new element rarely moves up more than a level.
+//
+// Elements that compare equal are not popped in any particular order; add a
+// sequence number to the key if that matters.
+template <typename T, typename Less = std::less<T>, size_t D = 4>
+class DAryHeap {
+	static_assert(D >= 2, "heap arity must be at least 2");
+
+public:
+	bool empty() const { return m_items.empty(); }
+	size_t size() const { return m_items.size(); }
+	void clear() { m_items.clear(); }
+	void reserve(size_t n) { m_items.reserve(n); }
+
+	// the smallest element
+	const T &top() const
+	{
+		assert(!m_items.empty());
+		return m_items.front();
+	}
+
+	void push(T item)
+	{
+		size_t idx = m_items.size();
+		m_items.push_back(std::move(item));
+
+		// sift up, moving parents down into the hole
+		T value = std::move(m_items[idx]);
+		while (idx > 0) {
+			const size_t parent = (idx - 1) / D;
+			if (!m_less(value, m_items[parent]))
+				break;
+			m_items[idx] = std::move(m_items[parent]);
+			idx = parent;
+		}
+		m_items[idx] = std::move(value);
+	}
+
+	// removes the smallest element
+	void pop()
+	{
+		assert(!m_items.empty());
+		T value = std::move(m_items.back());
+		m_items.pop_back();
+		if (m_items.empty())
+			return;
+
+		// sift down from the root, moving the smallest child up into the hole
+		const size_t count = m_items.size();
+		size_t idx = 0;
+		while (true) {
+			const size_t first = idx * D + 1;
+			if (first >= count)
+				break;
+
+			const size_t last = std::min(first + D, count);
+			size_t best = first;
+			for (size_t child = first + 1; child < last; child++) {
+				if (m_less(m_items[child], m_items[best]))
+					best = child;
+			}
+
+			if (!m_less(m_items[best], value))
+				break;
+			m_items[idx] = std::move(m_items[best]);
+			idx = best;
+		}
+		m_items[idx] = std::move(value);
+	}
+
+private:
+	std::vector<T> m_items;
+	Less m_less;
+};
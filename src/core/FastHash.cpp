@@ -0,0 +1,13 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "FastHash.h"
+
+// compiled here with our own flags rather than called into the lz4 library
+#define XXH_INLINE_ALL
+#include "lz4/xxhash.h"
+
+uint64_t FastHash64(const void *data, size_t length, uint64_t seed)
+{
+	return XXH64(data, length, seed);
+}
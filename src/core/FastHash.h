@@ -0,0 +1,15 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// 64-bit xxHash of a block of data. It runs at several gigabytes a second,
+// so it's the one to use to key caches on the contents of whole files;
+// FNV-1a remains for the short, compile-time hashed names.
+//
+// Hashes are stable between runs and platforms, so they can be stored.
+// A hash can be chained by passing it as the seed of the next.
+uint64_t FastHash64(const void *data, size_t length, uint64_t seed = 0);
@@ -0,0 +1,242 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Open addressing hash map with linear probing, holding its entries in one
+// flat array so a lookup is a hash and a short scan of neighbouring slots.
+//
+// Erasing leaves a tombstone rather than moving other entries, so erasing
+// never invalidates iterators to other entries and the map can be pruned
+// while iterating over it, as with std::map:
+//   for (auto it = map.begin(); it != map.end();)
+//       if (...) map.erase(it++); else ++it;
+// Inserting may rehash and invalidate all iterators, references and
+// pointers to entries. Iteration order is unspecified.
+template <typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>>
+class FlatHashMap {
+	struct Slot {
+		std::optional<std::pair<const K, V>> entry;
+		bool erased = false; // tombstone, keeps probe sequences through here intact
+	};
+
+	template <bool Const>
+	class Iterator {
+		friend class FlatHashMap;
+		template <bool>
+		friend class Iterator;
+		using SlotPtr = std::conditional_t<Const, const Slot *, Slot *>;
+
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = std::pair<const K, V>;
+		using difference_type = std::ptrdiff_t;
+		using pointer = std::conditional_t<Const, const value_type *, value_type *>;
+		using reference = std::conditional_t<Const, const value_type &, value_type &>;
+
+		Iterator() :
+			m_slot(nullptr),
+			m_end(nullptr) {}
+		// iterator to const_iterator
+		template <bool C = Const, typename = std::enable_if_t<C>>
+		Iterator(const Iterator<false> &other) :
+			m_slot(other.m_slot),
+			m_end(other.m_end)
+		{}
+
+		reference operator*() const { return *m_slot->entry; }
+		pointer operator->() const { return &*m_slot->entry; }
+
+		Iterator &operator++()
+		{
+			++m_slot;
+			SkipEmpty();
+			return *this;
+		}
+		Iterator operator++(int)
+		{
+			Iterator it = *this;
+			++*this;
+			return it;
+		}
+
+		bool operator==(const Iterator &other) const { return m_slot == other.m_slot; }
+		bool operator!=(const Iterator &other) const { return m_slot != other.m_slot; }
+
+	private:
+		Iterator(SlotPtr slot, SlotPtr end) :
+			m_slot(slot),
+			m_end(end)
+		{
+			SkipEmpty();
+		}
+
+		void SkipEmpty()
+		{
+			while (m_slot != m_end && !m_slot->entry)
+				++m_slot;
+		}
+
+		SlotPtr m_slot;
+		SlotPtr m_end;
+	};
+
+public:
+	using key_type = K;
+	using mapped_type = V;
+	using value_type = std::pair<const K, V>;
+	using size_type = size_t;
+	using iterator = Iterator<false>;
+	using const_iterator = Iterator<true>;
+
+	FlatHashMap() :
+		m_size(0),
+		m_used(0) {}
+
+	iterator begin() { return iterator(m_slots.data(), m_slots.data() + m_slots.size()); }
+	iterator end() { return iterator(m_slots.data() + m_slots.size(), m_slots.data() + m_slots.size()); }
+	const_iterator begin() const { return const_iterator(m_slots.data(), m_slots.data() + m_slots.size()); }
+	const_iterator end() const { return const_iterator(m_slots.data() + m_slots.size(), m_slots.data() + m_slots.size()); }
+
+	size_t size() const { return m_size; }
+	bool empty() const { return m_size == 0; }
+
+	void clear()
+	{
+		std::vector<Slot>().swap(m_slots);
+		m_size = m_used = 0;
+	}
+
+	iterator find(const K &key)
+	{
+		const size_t index = FindIndex(key);
+		return index == NOT_FOUND ? end() : IteratorAt(index);
+	}
+	const_iterator find(const K &key) const
+	{
+		const size_t index = FindIndex(key);
+		return index == NOT_FOUND ? end() : const_iterator(m_slots.data() + index, m_slots.data() + m_slots.size());
+	}
+	size_t count(const K &key) const { return FindIndex(key) == NOT_FOUND ? 0 : 1; }
+
+	std::pair<iterator, bool> insert(const value_type &value) { return emplace(value.first, value.second); }
+	std::pair<iterator, bool> insert(value_type &&value) { return emplace(value.first, std::move(value.second)); }
+
+	template <typename... Args>
+	std::pair<iterator, bool> emplace(const K &key, Args &&...args)
+	{
+		// keep at least a quarter of the slots empty, tombstones included,
+		// so probe sequences stay short and always terminate
+		if ((m_used + 1) * 4 > m_slots.size() * 3)
+			// grow when at least half full of entries, otherwise just sweep
+			// out the tombstones
+			Rehash(std::max(MIN_CAPACITY, (m_size + 1) * 2 > m_slots.size() ? m_slots.size() * 2 : m_slots.size()));
+
+		const size_t mask = m_slots.size() - 1;
+		size_t tombstone = NOT_FOUND;
+		for (size_t index = Hash()(key) & mask;; index = (index + 1) & mask) {
+			Slot &slot = m_slots[index];
+			if (slot.entry) {
+				if (KeyEqual()(slot.entry->first, key))
+					return std::make_pair(IteratorAt(index), false);
+			} else if (slot.erased) {
+				if (tombstone == NOT_FOUND)
+					tombstone = index;
+			} else {
+				if (tombstone != NOT_FOUND) {
+					index = tombstone;
+					m_slots[index].erased = false;
+				} else {
+					m_used++;
+				}
+				m_slots[index].entry.emplace(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+				m_size++;
+				return std::make_pair(IteratorAt(index), true);
+			}
+		}
+	}
+
+	V &operator[](const K &key) { return emplace(key).first->second; }
+
+	size_t erase(const K &key)
+	{
+		const size_t index = FindIndex(key);
+		if (index == NOT_FOUND)
+			return 0;
+		EraseAt(index);
+		return 1;
+	}
+	iterator erase(const_iterator it)
+	{
+		const size_t index = it.m_slot - m_slots.data();
+		assert(index < m_slots.size() && m_slots[index].entry);
+		EraseAt(index);
+		return IteratorAt(index);
+	}
+
+	// number of slots, for statistics
+	size_t capacity() const { return m_slots.size(); }
+
+private:
+	static constexpr size_t NOT_FOUND = size_t(-1);
+	static constexpr size_t MIN_CAPACITY = 16;
+
+	iterator IteratorAt(size_t index) { return iterator(m_slots.data() + index, m_slots.data() + m_slots.size()); }
+
+	size_t FindIndex(const K &key) const
+	{
+		if (m_slots.empty())
+			return NOT_FOUND;
+		const size_t mask = m_slots.size() - 1;
+		for (size_t index = Hash()(key) & mask;; index = (index + 1) & mask) {
+			const Slot &slot = m_slots[index];
+			if (slot.entry) {
+				if (KeyEqual()(slot.entry->first, key))
+					return index;
+			} else if (!slot.erased) {
+				return NOT_FOUND;
+			}
+		}
+	}
+
+	void EraseAt(size_t index)
+	{
+		m_slots[index].entry.reset();
+		m_slots[index].erased = true;
+		m_size--;
+	}
+
+	// capacity must be a power of two
+	void Rehash(size_t capacity)
+	{
+		assert((capacity & (capacity - 1)) == 0);
+		std::vector<Slot> old(capacity);
+		old.swap(m_slots);
+		const size_t mask = capacity - 1;
+		for (Slot &slot : old) {
+			if (!slot.entry)
+				continue;
+			size_t index = Hash()(slot.entry->first) & mask;
+			while (m_slots[index].entry)
+				index = (index + 1) & mask;
+			m_slots[index].entry.emplace(std::move(*slot.entry));
+		}
+		m_used = m_size;
+	}
+
+	std::vector<Slot> m_slots;
+	size_t m_size; // entries
+	size_t m_used; // entries and tombstones
+};
@@ -0,0 +1,100 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "FrameTimeline.h"
+
+#include "profiler/Profiler.h"
+
+#include <algorithm>
+#include <string_view>
+#include <unordered_map>
+
+FrameTimeline::FrameTimeline(size_t maxFrames) :
+	m_maxFrames(std::max<size_t>(maxFrames, 1))
+{
+}
+
+void FrameTimeline::RecordFrame(double durationMs)
+{
+	std::vector<Profiler::ThreadZones> threads;
+	Profiler::collectzones(threads);
+
+	Frame frame;
+	frame.durationMs = durationMs;
+	frame.lanes.reserve(threads.size());
+	for (const Profiler::ThreadZones &thread : threads) {
+		Lane lane;
+		lane.name = thread.name;
+		lane.zones.reserve(thread.zones.size());
+		for (const Profiler::ZoneSpan &span : thread.zones)
+			lane.zones.push_back({ span.name, span.startMs, span.endMs, span.depth });
+		frame.lanes.push_back(std::move(lane));
+	}
+
+	AddFrame(std::move(frame));
+}
+
+void FrameTimeline::AddFrame(Frame frame)
+{
+	frame.number = m_nextFrameNumber++;
+
+	if (!m_pinned && m_autoPinMs > 0.0 && frame.durationMs > m_autoPinMs)
+		m_pinned = std::make_unique<Frame>(frame);
+
+	if (m_frames.size() >= m_maxFrames)
+		m_frames.pop_front();
+	m_frames.push_back(std::move(frame));
+}
+
+void FrameTimeline::Clear()
+{
+	m_frames.clear();
+	m_pinned.reset();
+}
+
+void FrameTimeline::PinFrame(size_t index)
+{
+	if (index < m_frames.size())
+		m_pinned = std::make_unique<Frame>(m_frames[index]);
+}
+
+std::vector<FrameTimeline::ZoneTotal> FrameTimeline::Aggregate(const Frame &frame)
+{
+	std::vector<ZoneTotal> totals;
+	std::unordered_map<std::string_view, size_t> byName;
+	std::vector<size_t> stack;
+	std::vector<double> childMs;
+
+	for (const Lane &lane : frame.lanes) {
+		// time spent in the direct children of each zone of the lane
+		childMs.assign(lane.zones.size(), 0.0);
+		stack.clear();
+
+		for (size_t i = 0; i < lane.zones.size(); i++) {
+			const Zone &zone = lane.zones[i];
+			while (stack.size() > zone.depth)
+				stack.pop_back();
+			if (!stack.empty())
+				childMs[stack.back()] += zone.endMs - zone.startMs;
+			stack.push_back(i);
+		}
+
+		for (size_t i = 0; i < lane.zones.size(); i++) {
+			const Zone &zone = lane.zones[i];
+			auto result = byName.emplace(zone.name, totals.size());
+			if (result.second)
+				totals.push_back({ zone.name, 0.0, 0.0, 0 });
+
+			ZoneTotal &total = totals[result.first->second];
+			const double ms = zone.endMs - zone.startMs;
+			total.totalMs += ms;
+			total.selfMs += std::max(ms - childMs[i], 0.0);
+			total.calls++;
+		}
+	}
+
+	std::sort(totals.begin(), totals.end(), [](const ZoneTotal &a, const ZoneTotal &b) {
+		return a.totalMs > b.totalMs;
+	});
+	return totals;
+}
@@ -0,0 +1,88 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+/*
+ * Keeps the profiler zones of the last few frames, one lane per profiled
+ * thread, for the timeline view in the performance window.
+ *
+ * Application records a frame at the end of each loop iteration while the
+ * timeline is enabled and the profiler is reset every frame. Recording
+ * costs a copy of every zone of the frame, so it is off by default. Without
+ * PIONEER_PROFILER the recorded frames have no lanes.
+ *
+ * One frame can be pinned, which keeps a copy of it while recording
+ * continues. With an auto-pin threshold set, the first frame slower than
+ * the threshold is pinned automatically.
+ */
+class FrameTimeline {
+public:
+	struct Zone {
+		const char *name; // points at the string the zone was profiled with
+		double startMs;
+		double endMs;
+		uint32_t depth;
+	};
+
+	struct Lane {
+		const char *name;
+		std::vector<Zone> zones; // in order of their start
+	};
+
+	struct Frame {
+		uint64_t number = 0;
+		double durationMs = 0.0;
+		std::vector<Lane> lanes;
+	};
+
+	// total and self time of all zones with the same name in a frame
+	struct ZoneTotal {
+		const char *name;
+		double totalMs;
+		double selfMs;
+		uint32_t calls;
+	};
+
+	explicit FrameTimeline(size_t maxFrames = 120);
+
+	void SetEnabled(bool enabled) { m_enabled = enabled; }
+	bool IsEnabled() const { return m_enabled; }
+
+	// Copies the zones recorded since the last profiler reset as a new frame
+	void RecordFrame(double durationMs);
+	// Adds a frame that was built by other means, dropping the oldest one
+	// if the history is full
+	void AddFrame(Frame frame);
+	void Clear();
+
+	size_t GetNumFrames() const { return m_frames.size(); }
+	size_t GetMaxFrames() const { return m_maxFrames; }
+	// frames are indexed from the oldest
+	const Frame &GetFrame(size_t index) const { return m_frames[index]; }
+
+	void PinFrame(size_t index);
+	void Unpin() { m_pinned.reset(); }
+	const Frame *GetPinnedFrame() const { return m_pinned.get(); }
+
+	// pin the first frame that takes longer than this; zero disables
+	void SetAutoPinThreshold(double ms) { m_autoPinMs = ms; }
+	double GetAutoPinThreshold() const { return m_autoPinMs; }
+
+	// Sums the zones of every lane by name, slowest total first
+	static std::vector<ZoneTotal> Aggregate(const Frame &frame);
+
+private:
+	std::deque<Frame> m_frames;
+	std::unique_ptr<Frame> m_pinned;
+	size_t m_maxFrames;
+	uint64_t m_nextFrameNumber = 0;
+	double m_autoPinMs = 0.0;
+	bool m_enabled = false;
+};
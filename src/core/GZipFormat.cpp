@@ -1,7 +1,12 @@
 #include "GZipFormat.h"
+#include "TaskGraph.h"
+#include "profiler/Profiler.h"
+#include <algorithm>
 #include <cstdint>
 #include <cstring>
+#include <memory>
 #include <string>
+#include <vector>
 
 extern "C" {
 #include <miniz/miniz.h>
@@ -22,6 +27,10 @@ namespace {
 		CM_DEFLATE = 8, // The only one defined in the RFC (and the one we need).
 	};
 
+	// Blocks deflated in parallel don't share a dictionary, so they're kept
+	// large for the matches lost at their starts not to matter
+	static const size_t PARALLEL_BLOCK_SIZE = 512 * 1024;
+
 	enum GZipHeaderSizes {
 		BASE_HEADER_SIZE = 10,
 		BASE_FOOTER_SIZE = 8,
@@ -50,6 +59,93 @@ namespace {
 		out[2] = (value >> 16) & 0xffu;
 		out[3] = (value >> 24) & 0xffu;
 	}
+
+	// The CRC of two blocks joined together from the CRCs of each, by
+	// applying len2 zero bytes to crc1 as powers of a GF(2) matrix (from zlib)
+	static uint32_t Gf2MatrixTimes(const uint32_t *mat, uint32_t vec)
+	{
+		uint32_t sum = 0;
+		for (; vec; vec >>= 1, mat++)
+			if (vec & 1)
+				sum ^= *mat;
+		return sum;
+	}
+
+	static void Gf2MatrixSquare(uint32_t *square, const uint32_t *mat)
+	{
+		for (int n = 0; n < 32; n++)
+			square[n] = Gf2MatrixTimes(mat, mat[n]);
+	}
+
+	static uint32_t CombineCRC32(uint32_t crc1, uint32_t crc2, size_t len2)
+	{
+		if (len2 == 0)
+			return crc1;
+
+		// odd is the operator for one zero bit
+		uint32_t even[32], odd[32];
+		odd[0] = 0xedb88320u;
+		for (int n = 1; n < 32; n++)
+			odd[n] = 1u << (n - 1);
+		Gf2MatrixSquare(even, odd); // two zero bits
+		Gf2MatrixSquare(odd, even); // four zero bits
+
+		// each square doubles the zero bits, starting at one byte
+		do {
+			Gf2MatrixSquare(even, odd);
+			if (len2 & 1)
+				crc1 = Gf2MatrixTimes(even, crc1);
+			len2 >>= 1;
+			if (len2 == 0)
+				break;
+			Gf2MatrixSquare(odd, even);
+			if (len2 & 1)
+				crc1 = Gf2MatrixTimes(odd, crc1);
+			len2 >>= 1;
+		} while (len2 != 0);
+
+		return crc1 ^ crc2;
+	}
+
+	// Deflates data into out, in independent blocks spread over the task
+	// graph. All but the last block end with a sync flush, which leaves them
+	// unterminated and byte aligned, so the blocks join into one stream.
+	// Returns the CRC of data.
+	static uint32_t DeflateParallel(const std::string &data, std::string &out, TaskGraph *taskGraph)
+	{
+		PROFILE_SCOPED()
+		struct Block {
+			std::string deflated;
+			uint32_t crc;
+			bool success;
+		};
+
+		const uint32_t numBlocks = uint32_t((data.size() + PARALLEL_BLOCK_SIZE - 1) / PARALLEL_BLOCK_SIZE);
+		std::vector<Block> blocks(numBlocks);
+		taskGraph->ParallelFor({ 0, numBlocks }, 1, [&](TaskRange range) {
+			// the compressor state is too large for a worker's stack
+			std::unique_ptr<tdefl_compressor> deflator(new tdefl_compressor);
+			for (uint32_t i = range.begin; i < range.end; i++) {
+				const size_t offset = size_t(i) * PARALLEL_BLOCK_SIZE;
+				const size_t size = std::min(PARALLEL_BLOCK_SIZE, data.size() - offset);
+				Block &block = blocks[i];
+				const bool last = i + 1 == numBlocks;
+				block.crc = mz_crc32(MZ_CRC32_INIT, reinterpret_cast<const mz_uint8 *>(data.data() + offset), size);
+				block.success = tdefl_init(deflator.get(), &PutBytesToString, &block.deflated, TDEFL_DEFAULT_MAX_PROBES) == TDEFL_STATUS_OKAY &&
+					tdefl_compress_buffer(deflator.get(), data.data() + offset, size, last ? TDEFL_FINISH : TDEFL_SYNC_FLUSH) == (last ? TDEFL_STATUS_DONE : TDEFL_STATUS_OKAY);
+			}
+		});
+
+		uint32_t crc = MZ_CRC32_INIT;
+		for (uint32_t i = 0; i < numBlocks; i++) {
+			if (!blocks[i].success)
+				throw gzip::CompressionFailedException();
+			out += blocks[i].deflated;
+			const size_t size = std::min(PARALLEL_BLOCK_SIZE, data.size() - size_t(i) * PARALLEL_BLOCK_SIZE);
+			crc = CombineCRC32(crc, blocks[i].crc, size);
+		}
+		return crc;
+	}
 } // namespace
 
 bool gzip::IsGZipFormat(const unsigned char *data, size_t length)
@@ -180,8 +276,9 @@ std::string gzip::DecompressRawDeflate(const unsigned char *data, size_t length)
 	return out;
 }
 
-std::string gzip::CompressGZip(const std::string &data, const std::string &inner_file_name)
+std::string gzip::CompressGZip(const std::string &data, const std::string &inner_file_name, TaskGraph *taskGraph)
 {
+	PROFILE_SCOPED()
 	std::string out;
 
 	// The base GZip header.
@@ -199,13 +296,18 @@ std::string gzip::CompressGZip(const std::string &data, const std::string &inner
 	};
 	out.append(reinterpret_cast<const char *>(crc_buf), sizeof(crc_buf));
 
-	bool success = tdefl_compress_mem_to_output(data.data(), data.size(), &PutBytesToString, static_cast<void *>(&out), TDEFL_DEFAULT_MAX_PROBES);
-	if (!success) {
-		throw gzip::CompressionFailedException();
+	uint32_t data_crc;
+	if (taskGraph && data.size() > PARALLEL_BLOCK_SIZE) {
+		data_crc = DeflateParallel(data, out, taskGraph);
+	} else {
+		bool success = tdefl_compress_mem_to_output(data.data(), data.size(), &PutBytesToString, static_cast<void *>(&out), TDEFL_DEFAULT_MAX_PROBES);
+		if (!success) {
+			throw gzip::CompressionFailedException();
+		}
+		data_crc = mz_crc32(MZ_CRC32_INIT, reinterpret_cast<const mz_uint8 *>(data.data()), data.size());
 	}
 
 	unsigned char footer_bytes[8];
-	uint32_t data_crc = mz_crc32(MZ_CRC32_INIT, reinterpret_cast<const mz_uint8 *>(data.data()), data.size());
 	WriteLE32(footer_bytes + 0, data_crc);
 	// GZip specifies that size is written little-endian, modulo 2^32
 	// (ie, if size is really > 2^32 we just chop off the high bits).
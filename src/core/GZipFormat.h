@@ -6,6 +6,8 @@
 
 #include <string>
 
+class TaskGraph;
+
 namespace gzip {
 	struct GZipException {};
 	struct DecompressionFailedException : public GZipException {};
@@ -33,7 +35,9 @@ namespace gzip {
 	// This tries to follow RFC 1952 (GZip format).
 	// If compression fails it throws an exception.
 	// Parameter 'inner_file_name' is the name written in the GZip header as the file name of the compressed block.
-	std::string CompressGZip(const std::string &data, const std::string &inner_file_name);
+	// If a task graph is given, large inputs are cut into blocks that are deflated independently on its
+	// workers and joined into one DEFLATE stream (as pigz does), so any GZip reader can still read it.
+	std::string CompressGZip(const std::string &data, const std::string &inner_file_name, TaskGraph *taskGraph = nullptr);
 } // namespace gzip
 
 #endif
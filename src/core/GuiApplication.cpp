@@ -2,12 +2,14 @@
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
 #include "GuiApplication.h"
+#include "HitchDetector.h"
 #include "IniConfig.h"
 #include "Input.h"
 #include "OS.h"
 
 #include "SDL.h"
 #include "graphics/Drawables.h"
+#include "graphics/DynamicResolution.h"
 #include "graphics/Graphics.h"
 #include "graphics/RenderState.h"
 #include "graphics/RenderTarget.h"
@@ -34,24 +36,87 @@ void GuiApplication::BeginFrame()
 	m_renderer->ClearScreen();
 
 	m_renderer->BeginFrame();
+
+#ifdef PIONEER_PROFILER
+	// the GPU zones resolved this frame, drawn a few frames ago
+	const auto &gpuZones = m_renderer->GetGPUZoneTimes();
+	if (!gpuZones.empty()) {
+		std::vector<Profiler::ZoneSpan> spans;
+		spans.reserve(gpuZones.size());
+		for (const auto &zone : gpuZones)
+			spans.push_back({ zone.name, zone.startMs, zone.startMs + zone.durationMs, zone.depth });
+		Profiler::addlane("GPU", spans);
+	}
+#endif
 }
 
 void GuiApplication::EndFrame()
 {
 	PROFILE_SCOPED()
 
-	m_renderer->FlushCommandBuffers();
-	m_renderer->EndFrame();
+	{
+		HitchDetector::ScopedPhase phase(GetHitchDetector(), HitchDetector::PHASE_GPU_WAIT);
+		m_renderer->FlushCommandBuffers();
+		m_renderer->EndFrame();
+	}
+
+	HitchDetector::ScopedPhase phase(GetHitchDetector(), HitchDetector::PHASE_SWAP);
 	m_renderer->SwapBuffers();
 }
 
-Graphics::RenderTarget *GuiApplication::CreateRenderTarget(const Graphics::Settings &settings)
+void GuiApplication::BeginScene()
+{
+	if (!m_dynamicResolution)
+		return;
+
+	PROFILE_SCOPED()
+	m_renderer->BeginGPUTimer();
+
+	// the scene target is full size, the scale only picks how much of it is used
+	m_renderer->SetRenderTarget(m_sceneTarget.get());
+	m_renderer->SetViewport({ 0, 0,
+		m_dynamicResolution->GetScaledSize(Graphics::GetScreenWidth()),
+		m_dynamicResolution->GetScaledSize(Graphics::GetScreenHeight()) });
+	m_renderer->ClearScreen();
+}
+
+void GuiApplication::EndScene()
+{
+	if (!m_dynamicResolution)
+		return;
+
+	PROFILE_SCOPED()
+	const Graphics::ViewportExtents scene = {
+		0, 0,
+		m_dynamicResolution->GetScaledSize(Graphics::GetScreenWidth()),
+		m_dynamicResolution->GetScaledSize(Graphics::GetScreenHeight())
+	};
+	const Graphics::ViewportExtents screen = { 0, 0, Graphics::GetScreenWidth(), Graphics::GetScreenHeight() };
+
+	// MSAA resolve can't scale, so that takes two steps
+	if (m_sceneResolveTarget) {
+		m_renderer->ResolveRenderTarget(m_sceneTarget.get(), m_sceneResolveTarget.get(), scene);
+		m_renderer->CopyRenderTarget(m_sceneResolveTarget.get(), m_renderTarget.get(), scene, screen, true);
+	} else {
+		m_renderer->CopyRenderTarget(m_sceneTarget.get(), m_renderTarget.get(), scene, screen, true);
+	}
+
+	m_renderer->SetRenderTarget(m_renderTarget.get());
+	m_renderer->SetViewport(screen);
+	m_renderer->EndGPUTimer();
+
+	float gpuMs;
+	if (m_renderer->PollGPUTimer(gpuMs))
+		m_dynamicResolution->Update(gpuMs);
+}
+
+Graphics::RenderTarget *GuiApplication::CreateRenderTarget(const Graphics::Settings &settings, int samples)
 {
 	Graphics::RenderTargetDesc rtDesc = {
 		uint16_t(settings.width), uint16_t(settings.height),
 		Graphics::TEXTURE_RGBA_8888,
 		Graphics::TEXTURE_DEPTH, true,
-		uint16_t(settings.requestedSamples)
+		uint16_t(samples)
 	};
 
 	return m_renderer->CreateRenderTarget(rtDesc);
@@ -60,6 +125,7 @@ Graphics::RenderTarget *GuiApplication::CreateRenderTarget(const Graphics::Setti
 void GuiApplication::PollEvents()
 {
 	PROFILE_SCOPED()
+	HitchDetector::ScopedPhase phase(GetHitchDetector(), HitchDetector::PHASE_INPUT);
 	SDL_Event event;
 
 	// FIXME: input state is right before handling updates because
@@ -103,6 +169,7 @@ void GuiApplication::PollEvents()
 
 void GuiApplication::DispatchEvents()
 {
+	HitchDetector::ScopedPhase phase(GetHitchDetector(), HitchDetector::PHASE_INPUT);
 	m_input->DispatchEvents();
 }
 
@@ -129,6 +196,17 @@ Graphics::Renderer *GuiApplication::StartupRenderer(IniConfig *config, bool hidd
 {
 	PROFILE_SCOPED()
 
+	// determine what renderer we should use, default to Opengl 3.x
+	const std::string rendererName = config->String("RendererName", Graphics::RendererNameFromType(Graphics::RENDERER_OPENGL_3x));
+	// if we add new renderer types, make sure to update this logic
+	Graphics::RendererType rType = Graphics::RENDERER_OPENGL_3x;
+	if (rendererName == Graphics::RendererNameFromType(Graphics::RENDERER_DUMMY))
+		rType = Graphics::RENDERER_DUMMY;
+
+	// the dummy renderer draws nothing, so it doesn't need a display either
+	if (rType == Graphics::RENDERER_DUMMY)
+		SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+
 	// Initialize SDL
 	PROFILE_START_DESC("SDL_Init")
 	Uint32 sdlInitFlags = SDL_INIT_VIDEO | SDL_INIT_JOYSTICK;
@@ -139,11 +217,6 @@ Graphics::Renderer *GuiApplication::StartupRenderer(IniConfig *config, bool hidd
 
 	OutputVersioningInfo();
 
-	// determine what renderer we should use, default to Opengl 3.x
-	const std::string rendererName = config->String("RendererName", Graphics::RendererNameFromType(Graphics::RENDERER_OPENGL_3x));
-	// if we add new renderer types, make sure to update this logic
-	Graphics::RendererType rType = Graphics::RENDERER_OPENGL_3x;
-
 	Graphics::Settings videoSettings = {};
 	videoSettings.rendererType = rType;
 	videoSettings.width = config->Int("ScrWidth");
@@ -156,11 +229,28 @@ Graphics::Renderer *GuiApplication::StartupRenderer(IniConfig *config, bool hidd
 	videoSettings.useAnisotropicFiltering = (config->Int("UseAnisotropicFiltering") != 0);
 	videoSettings.enableDebugMessages = (config->Int("EnableGLDebug") != 0);
 	videoSettings.gl3ForwardCompatible = (config->Int("GL3ForwardCompatible") != 0);
+	videoSettings.sortDrawCommands = (config->Int("SortDrawCommands") != 0);
+	videoSettings.useProgramCache = (config->Int("ShaderProgramCache") != 0);
+	videoSettings.dynamicResolution = (config->Int("DynamicResolution") != 0);
 	videoSettings.iconFile = OS::GetIconFilename();
 	videoSettings.title = m_applicationTitle.c_str();
 
 	m_renderer.reset(Graphics::Init(videoSettings));
-	m_renderTarget.reset(CreateRenderTarget(videoSettings));
+
+	if (videoSettings.dynamicResolution) {
+		// multisampling moves to the scene; what goes on top of it doesn't need
+		// it, and a multisampled target can't be scaled into
+		m_renderTarget.reset(CreateRenderTarget(videoSettings, 0));
+		m_sceneTarget.reset(CreateRenderTarget(videoSettings, videoSettings.requestedSamples));
+		if (videoSettings.requestedSamples > 0)
+			m_sceneResolveTarget.reset(CreateRenderTarget(videoSettings, 0));
+
+		m_dynamicResolution.reset(new Graphics::DynamicResolution(
+			config->Float("DynamicResolutionTargetMs", 14.0f),
+			config->Float("DynamicResolutionMinScale", 0.5f)));
+	} else {
+		m_renderTarget.reset(CreateRenderTarget(videoSettings, videoSettings.requestedSamples));
+	}
 
 	m_settings = videoSettings;
 
@@ -170,6 +260,9 @@ Graphics::Renderer *GuiApplication::StartupRenderer(IniConfig *config, bool hidd
 void GuiApplication::ShutdownRenderer()
 {
 	PROFILE_SCOPED()
+	m_dynamicResolution.reset();
+	m_sceneResolveTarget.reset();
+	m_sceneTarget.reset();
 	m_renderTarget.reset();
 	m_renderer.reset();
 
@@ -20,6 +20,7 @@ namespace PiGui {
 }
 
 namespace Graphics {
+	class DynamicResolution;
 	class Renderer;
 	class RenderTarget;
 }
@@ -35,6 +36,16 @@ public:
 
 	Graphics::RenderTarget *GetRenderTarget() { return m_renderTarget.get(); }
 
+	// The 3D scene is drawn between these two. With dynamic resolution
+	// enabled it goes to a separate render target at a scale following its
+	// GPU time, and is upscaled to the main render target in EndScene, so
+	// anything drawn after it is at native resolution.
+	void BeginScene();
+	void EndScene();
+
+	// nullptr unless dynamic resolution is enabled
+	const Graphics::DynamicResolution *GetDynamicResolution() const { return m_dynamicResolution.get(); }
+
 	const Graphics::Settings &GetGraphicsSettings() { return m_settings; }
 
 protected:
@@ -79,7 +90,7 @@ protected:
 	virtual void HandleQuit(SDL_QuitEvent &ev) { RequestQuit(); }
 
 private:
-	Graphics::RenderTarget *CreateRenderTarget(const Graphics::Settings &settings);
+	Graphics::RenderTarget *CreateRenderTarget(const Graphics::Settings &settings, int samples);
 
 	RefCountedPtr<PiGui::Instance> m_pigui;
 	std::unique_ptr<Input::Manager> m_input;
@@ -89,4 +100,9 @@ private:
 	std::unique_ptr<Graphics::Renderer> m_renderer;
 	std::unique_ptr<Graphics::RenderTarget> m_renderTarget;
 	Graphics::Settings m_settings;
+
+	std::unique_ptr<Graphics::DynamicResolution> m_dynamicResolution;
+	// the scaled scene, and where it's resolved to if multisampled
+	std::unique_ptr<Graphics::RenderTarget> m_sceneTarget;
+	std::unique_ptr<Graphics::RenderTarget> m_sceneResolveTarget;
 };
@@ -0,0 +1,144 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "HitchDetector.h"
+
+#include "Json.h"
+#include "SDL_timer.h"
+
+#include <algorithm>
+#include <cmath>
+
+static const char *s_phaseNames[HitchDetector::PHASE_MAX] = {
+	"input",
+	"physics",
+	"finishJobs",
+	"luaEvents",
+	"render",
+	"gpuWait",
+	"swap",
+};
+
+const char *HitchDetector::GetPhaseName(Phase phase)
+{
+	return s_phaseNames[phase];
+}
+
+HitchDetector::ScopedPhase::ScopedPhase(HitchDetector *detector, Phase phase) :
+	m_detector(detector),
+	m_outer(detector ? detector->BeginPhase(phase) : -1)
+{
+}
+
+void HitchDetector::ScopedPhase::End()
+{
+	if (m_detector)
+		m_detector->EndPhase(m_outer);
+	m_detector = nullptr;
+}
+
+HitchDetector::HitchDetector(size_t historyFrames, size_t framesAfter) :
+	m_historyFrames(std::max<size_t>(historyFrames, 1)),
+	m_framesAfter(framesAfter)
+{
+}
+
+int HitchDetector::BeginPhase(Phase phase)
+{
+	const uint64_t now = SDL_GetPerformanceCounter();
+	const int outer = m_activePhase;
+	if (outer >= 0)
+		AddPhaseTime(Phase(outer), double(now - m_phaseStart) * 1e3 / double(SDL_GetPerformanceFrequency()));
+
+	m_activePhase = phase;
+	m_phaseStart = now;
+	return outer;
+}
+
+void HitchDetector::EndPhase(int outer)
+{
+	const uint64_t now = SDL_GetPerformanceCounter();
+	if (m_activePhase >= 0)
+		AddPhaseTime(Phase(m_activePhase), double(now - m_phaseStart) * 1e3 / double(SDL_GetPerformanceFrequency()));
+
+	// resume the phase this one interrupted
+	m_activePhase = outer;
+	m_phaseStart = now;
+}
+
+bool HitchDetector::EndFrame(double durationMs)
+{
+	m_current.number = m_nextFrameNumber++;
+	m_current.durationMs = durationMs;
+
+	if (m_history.size() >= m_historyFrames)
+		m_history.pop_front();
+	m_history.push_back(m_current);
+	m_current = FrameRecord();
+
+	const FrameRecord &frame = m_history.back();
+	if (m_framesToCapture > 0) {
+		m_reportFrames.push_back(frame);
+		if (--m_framesToCapture == 0)
+			m_reportReady = true;
+	} else if (!m_reportReady && m_thresholdMs > 0.0 && durationMs > m_thresholdMs &&
+		(!m_hasReported || frame.number - m_lastReportFrame >= m_reportInterval)) {
+		m_hasReported = true;
+		m_lastReportFrame = frame.number;
+		m_hitchFrame = frame.number;
+		m_reportFrames.assign(m_history.begin(), m_history.end());
+		m_framesToCapture = m_framesAfter;
+		m_reportReady = (m_framesAfter == 0);
+	}
+
+	return m_reportReady;
+}
+
+Json HitchDetector::TakeReport()
+{
+	if (!m_reportReady)
+		return Json();
+
+	Json report = Json::object();
+	report["thresholdMs"] = m_thresholdMs;
+	report["hitchFrame"] = m_hitchFrame;
+
+	Json phases = Json::array();
+	for (int phase = 0; phase < PHASE_MAX; phase++)
+		phases.push_back(s_phaseNames[phase]);
+	report["phases"] = phases;
+
+	// one row per frame keeps the report small and easy to read side by side
+	Json frames = Json::array();
+	for (const FrameRecord &frame : m_reportFrames)
+		frames.push_back(FrameToJson(frame));
+	report["frames"] = frames;
+
+	m_reportFrames.clear();
+	m_reportReady = false;
+	return report;
+}
+
+Json HitchDetector::FrameToJson(const FrameRecord &frame)
+{
+	// times are rounded to microseconds
+	auto round = [](double ms) { return std::round(ms * 1e3) / 1e3; };
+
+	Json out = Json::object();
+	out["frame"] = frame.number;
+	out["ms"] = round(frame.durationMs);
+
+	double phaseTotal = 0.0;
+	Json phases = Json::array();
+	for (int phase = 0; phase < PHASE_MAX; phase++) {
+		phases.push_back(round(frame.phaseMs[phase]));
+		phaseTotal += frame.phaseMs[phase];
+	}
+	out["phaseMs"] = phases;
+	out["otherMs"] = round(std::max(frame.durationMs - phaseTotal, 0.0));
+	out["ticks"] = frame.physicsTicks;
+	out["queuedJobs"] = frame.queuedJobs;
+	out["splitRequests"] = frame.splitRequests;
+	out["splitResults"] = frame.splitResults;
+	return out;
+}
@@ -0,0 +1,117 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#pragma once
+
+#include "JsonFwd.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+/*
+ * Always-on frame pacing telemetry. Every frame records how long a few
+ * coarse phases took, plus some queue depths, into a short history. When a
+ * frame takes longer than the threshold, the history up to it and a few
+ * frames after it become a report, which Application writes to the
+ * "hitches" folder of the user directory.
+ *
+ * Unlike the slow frame profiles this works without PIONEER_PROFILER and
+ * costs a few clock reads per frame. Phases can nest: a phase started
+ * while another is running pauses the outer one, so each frame's phase
+ * times don't overlap. Time outside every phase is counted as "other".
+ */
+class HitchDetector {
+public:
+	enum Phase {
+		PHASE_INPUT,
+		PHASE_PHYSICS,
+		PHASE_FINISH_JOBS,
+		PHASE_LUA_EVENTS,
+		PHASE_RENDER,
+		PHASE_GPU_WAIT,
+		PHASE_SWAP,
+		PHASE_MAX
+	};
+
+	static const char *GetPhaseName(Phase phase);
+
+	struct FrameRecord {
+		uint64_t number = 0;
+		double durationMs = 0.0;
+		float phaseMs[PHASE_MAX] = {};
+		uint32_t physicsTicks = 0;
+		// jobs waiting for a worker thread at the end of the frame
+		uint32_t queuedJobs = 0;
+		// terrain patch splits requested this frame, and finished ones
+		// waiting to be applied
+		uint32_t splitRequests = 0;
+		uint32_t splitResults = 0;
+	};
+
+	// Times a phase for as long as it is in scope, or until End()
+	class ScopedPhase {
+	public:
+		ScopedPhase(HitchDetector *detector, Phase phase);
+		~ScopedPhase() { End(); }
+
+		void End();
+
+	private:
+		HitchDetector *m_detector;
+		int m_outer;
+	};
+
+	explicit HitchDetector(size_t historyFrames = 60, size_t framesAfter = 10);
+
+	// Frames longer than this start a report; zero disables reports but
+	// frames are still recorded
+	void SetThreshold(double ms) { m_thresholdMs = ms; }
+	double GetThreshold() const { return m_thresholdMs; }
+	// After a report starts, hitches within this many frames don't start another
+	void SetReportInterval(uint32_t frames) { m_reportInterval = frames; }
+
+	void AddPhaseTime(Phase phase, double ms) { m_current.phaseMs[phase] += float(ms); }
+	void AddPhysicsTicks(uint32_t ticks) { m_current.physicsTicks += ticks; }
+	void SetQueuedJobs(uint32_t jobs) { m_current.queuedJobs = jobs; }
+	void SetSplitQueue(uint32_t requests, uint32_t results)
+	{
+		m_current.splitRequests = requests;
+		m_current.splitResults = results;
+	}
+
+	// Ends the current frame. Returns true when a report is complete and
+	// can be taken with TakeReport().
+	bool EndFrame(double durationMs);
+	// Returns the finished report and clears it
+	Json TakeReport();
+
+	const std::deque<FrameRecord> &GetHistory() const { return m_history; }
+
+private:
+	int BeginPhase(Phase phase);
+	void EndPhase(int outer);
+
+	static Json FrameToJson(const FrameRecord &frame);
+
+	std::deque<FrameRecord> m_history;
+	size_t m_historyFrames;
+	size_t m_framesAfter;
+	FrameRecord m_current;
+	uint64_t m_nextFrameNumber = 0;
+
+	int m_activePhase = -1;
+	uint64_t m_phaseStart = 0;
+
+	double m_thresholdMs = 0.0;
+	uint32_t m_reportInterval = 600;
+	uint64_t m_lastReportFrame = 0;
+	bool m_hasReported = false;
+
+	// frames of the report being captured, from the oldest
+	std::vector<FrameRecord> m_reportFrames;
+	uint64_t m_hitchFrame = 0;
+	size_t m_framesToCapture = 0;
+	bool m_reportReady = false;
+};
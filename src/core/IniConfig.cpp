@@ -162,5 +162,8 @@ bool IniConfig::Save()
 		return false;
 	}
 
+	if (m_readOnly)
+		return true;
+
 	return Write(*m_fs, m_path);
 }
@@ -30,6 +30,10 @@ public:
 	// save the IniConfig in-place to that file.
 	bool Save();
 
+	// While read-only, Save() leaves the file on disk untouched, e.g. so
+	// values overridden for a single run aren't written back.
+	void SetReadOnly(bool readOnly) { m_readOnly = readOnly; }
+
 	void SetInt(const std::string &section, const std::string &key, int val);
 	void SetFloat(const std::string &section, const std::string &key, float val);
 	void SetString(const std::string &section, const std::string &key, const std::string &val);
@@ -67,6 +71,7 @@ protected:
 
 	FileSystem::FileSourceFS *m_fs = nullptr;
 	std::string m_path;
+	bool m_readOnly = false;
 };
 
 #endif /* _INICONFIG_H */
@@ -2,11 +2,32 @@
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
 #include "LZ4Format.h"
+#include "TaskGraph.h"
+#include "lz4/lz4.h"
 #include "lz4/lz4frame.h"
+#include "lz4/lz4hc.h"
 #include "profiler/Profiler.h"
 #include <SDL_endian.h>
+#include <algorithm>
 #include <functional>
 #include <memory>
+#include <vector>
+
+namespace {
+	// the largest block size a frame can declare short of 4MB, which would
+	// leave few blocks to share out
+	static const size_t PARALLEL_BLOCK_SIZE = 1024 * 1024;
+	static const LZ4F_blockSizeID_t PARALLEL_BLOCK_SIZE_ID = LZ4F_max1MB;
+
+	// set in a block's size when it's stored uncompressed
+	static const uint32_t BLOCK_UNCOMPRESSED_FLAG = 0x80000000u;
+
+	void AppendLE32(std::string &out, uint32_t value)
+	{
+		for (int i = 0; i < 4; i++)
+			out.push_back(char((value >> (i * 8)) & 0xff));
+	}
+} // namespace
 
 bool lz4::IsLZ4Format(const char *data, size_t length)
 {
@@ -68,11 +89,71 @@ std::string lz4::DecompressLZ4(const std::string_view data)
 	return out;
 }
 
-std::string lz4::CompressLZ4(const std::string_view data, const int lz4_preset)
+// Builds the frame by hand: the header from lz4frame, then each block as
+// its size and data, then the end mark. No checksums are enabled, as with
+// the default preferences, so nothing depends on the data as a whole.
+static std::string CompressLZ4Parallel(const std::string_view data, const int lz4_preset, TaskGraph *taskGraph)
 {
 	PROFILE_SCOPED()
 	LZ4F_preferences_t pref = LZ4F_INIT_PREFERENCES;
 	pref.compressionLevel = lz4_preset;
+	pref.frameInfo.blockMode = LZ4F_blockIndependent;
+	pref.frameInfo.blockSizeID = PARALLEL_BLOCK_SIZE_ID;
+
+	LZ4F_cctx *_tmp;
+	LZ4F_errorCode_t err = LZ4F_createCompressionContext(&_tmp, LZ4F_VERSION);
+	checkError<lz4::CompressionFailedException>(err);
+	std::unique_ptr<LZ4F_cctx, std::function<size_t(LZ4F_cctx *)>> cctx(_tmp, LZ4F_freeCompressionContext);
+
+	char header[LZ4F_HEADER_SIZE_MAX];
+	const std::size_t headerSize = LZ4F_compressBegin(cctx.get(), header, sizeof(header), &pref);
+	checkError<lz4::CompressionFailedException>(headerSize);
+	cctx.reset();
+
+	const uint32_t numBlocks = uint32_t((data.size() + PARALLEL_BLOCK_SIZE - 1) / PARALLEL_BLOCK_SIZE);
+	std::vector<std::string> blocks(numBlocks);
+	taskGraph->ParallelFor({ 0, numBlocks }, 1, [&](TaskRange range) {
+		std::unique_ptr<char[]> compressed(new char[LZ4_compressBound(int(PARALLEL_BLOCK_SIZE))]);
+		for (uint32_t i = range.begin; i < range.end; i++) {
+			const char *src = data.data() + size_t(i) * PARALLEL_BLOCK_SIZE;
+			const int srcSize = int(std::min(PARALLEL_BLOCK_SIZE, data.size() - size_t(i) * PARALLEL_BLOCK_SIZE));
+			const int bound = LZ4_compressBound(srcSize);
+			const int size = lz4_preset < LZ4HC_CLEVEL_MIN ?
+				LZ4_compress_default(src, compressed.get(), srcSize, bound) :
+				LZ4_compress_HC(src, compressed.get(), srcSize, bound, lz4_preset);
+
+			// blocks that don't shrink are stored as they are
+			std::string &block = blocks[i];
+			if (size > 0 && size < srcSize) {
+				AppendLE32(block, uint32_t(size));
+				block.append(compressed.get(), size);
+			} else {
+				AppendLE32(block, uint32_t(srcSize) | BLOCK_UNCOMPRESSED_FLAG);
+				block.append(src, srcSize);
+			}
+		}
+	});
+
+	std::size_t outSize = headerSize + 4;
+	for (const std::string &block : blocks)
+		outSize += block.size();
+	std::string out;
+	out.reserve(outSize);
+	out.append(header, headerSize);
+	for (const std::string &block : blocks)
+		out += block;
+	AppendLE32(out, 0); // end mark
+	return out;
+}
+
+std::string lz4::CompressLZ4(const std::string_view data, const int lz4_preset, TaskGraph *taskGraph)
+{
+	if (taskGraph && data.size() > PARALLEL_BLOCK_SIZE)
+		return CompressLZ4Parallel(data, lz4_preset, taskGraph);
+
+	PROFILE_SCOPED()
+	LZ4F_preferences_t pref = LZ4F_INIT_PREFERENCES;
+	pref.compressionLevel = lz4_preset;
 
 	std::size_t compressBound = LZ4F_compressFrameBound(data.size(), &pref);
 	// null-initialize the string to the specified length
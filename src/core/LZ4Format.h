@@ -8,6 +8,8 @@
 #include <string>
 #include <string_view>
 
+class TaskGraph;
+
 namespace lz4 {
 
 	struct DecompressionFailedException : public std::runtime_error {
@@ -28,5 +30,7 @@ namespace lz4 {
 	// Compresses a block of data according to the lz4 framing format.
 	// If compression fails it throws an exception.
 	// lz4_speed is the compression preset; 0 = default compression, 3-12 = HC compression
-	std::string CompressLZ4(const std::string_view data, const int lz4_preset);
+	// If a task graph is given, large inputs are written as a frame of independent blocks which are
+	// compressed in parallel on its workers; the frame decompresses as any other.
+	std::string CompressLZ4(const std::string_view data, const int lz4_preset, TaskGraph *taskGraph = nullptr);
 } // namespace lz4
@@ -6,18 +6,25 @@
 #include "FileSystem.h"
 #include "SDL_messagebox.h"
 #include <SDL.h>
+#include <atomic_queue/atomic_queue.h>
+#include <atomic>
+#include <cassert>
 #include <chrono>
+#include <condition_variable>
 #include <cstdio>
 #include <map>
+#include <mutex>
 #include <string_view>
+#include <thread>
+#include <vector>
 
 #include <fmt/core.h>
 #include <fmt/format.h>
 #include <fmt/printf.h>
 
 namespace Log {
-	Logger s_defaultLog;
-
+	// defined before the default log, which may still write while it is
+	// destroyed
 	std::map<Severity, std::string> s_severityNames = {
 		{ Severity::Fatal, "Fatal:" },
 		{ Severity::Error, "Error:" },
@@ -27,14 +34,140 @@ namespace Log {
 		{ Severity::Verbose, "Verbose:" }
 	};
 
+	Logger s_defaultLog;
+
+	struct Message {
+		Time::DateTime time;
+		Severity sv;
+		std::string text;
+	};
+
 } // namespace Log
 
+struct Log::Logger::AsyncWriter {
+	// Producers only block when this many messages are waiting
+	static constexpr unsigned QUEUE_SIZE = 4096;
+
+	explicit AsyncWriter(Logger *log) :
+		logger(log),
+		mainThread(std::this_thread::get_id()),
+		running(true),
+		numPushed(0),
+		numWritten(0),
+		thread(&AsyncWriter::Run, this)
+	{
+	}
+
+	~AsyncWriter()
+	{
+		running.store(false, std::memory_order_release);
+		wake.notify_one();
+		thread.join();
+	}
+
+	void Push(Time::DateTime time, Severity sv, std::string_view text)
+	{
+		numPushed.fetch_add(1, std::memory_order_relaxed);
+		// spins if the queue is full, rather than reordering or dropping messages
+		queue.push(new Message{ time, sv, std::string(text) });
+		wake.notify_one();
+	}
+
+	void Flush()
+	{
+		const uint64_t target = numPushed.load(std::memory_order_relaxed);
+		wake.notify_one();
+		while (numWritten.load(std::memory_order_acquire) < target)
+			std::this_thread::yield();
+	}
+
+	void Run()
+	{
+		while (true) {
+			Message *msg;
+			if (queue.try_pop(msg)) {
+				logger->WriteOutput(msg->time, msg->sv, msg->text);
+				delete msg;
+				numWritten.fetch_add(1, std::memory_order_release);
+				continue;
+			}
+
+			// the queue is drained; flush once per batch rather than per message
+			if (logger->file)
+				fflush(logger->file);
+			if (!running.load(std::memory_order_acquire))
+				break;
+
+			// producers don't take the lock to notify, so a wakeup can be
+			// missed; the timeout bounds how long that delays a message
+			std::unique_lock<std::mutex> lock(wakeLock);
+			wake.wait_for(lock, std::chrono::milliseconds(5));
+		}
+	}
+
+	Logger *logger;
+	std::thread::id mainThread;
+
+	atomic_queue::AtomicQueue<Message *, QUEUE_SIZE> queue;
+	std::atomic<bool> running;
+	std::atomic<uint64_t> numPushed;
+	std::atomic<uint64_t> numWritten;
+	std::mutex wakeLock;
+	std::condition_variable wake;
+
+	// printCallback calls for messages logged off the main thread
+	std::mutex callbackLock;
+	std::vector<Message> callbacks;
+
+	std::thread thread;
+};
+
+Log::Logger::Logger() = default;
+Log::Logger::Logger(Logger &&) = default;
+Log::Logger &Log::Logger::operator=(Logger &&) = default;
+
 Log::Logger::~Logger()
 {
+	m_async.reset();
 	if (file)
 		fclose(file);
 }
 
+void Log::Logger::SetAsync(bool async)
+{
+	if (async == IsAsync())
+		return;
+
+	if (async) {
+		m_async.reset(new AsyncWriter(this));
+	} else {
+		DispatchCallbacks();
+		m_async.reset();
+	}
+}
+
+void Log::Logger::Flush()
+{
+	if (m_async)
+		m_async->Flush();
+}
+
+void Log::Logger::DispatchCallbacks()
+{
+	if (!m_async)
+		return;
+
+	assert(std::this_thread::get_id() == m_async->mainThread);
+	std::vector<Message> pending;
+	{
+		std::lock_guard<std::mutex> lock(m_async->callbackLock);
+		pending.swap(m_async->callbacks);
+	}
+
+	for (const Message &msg : pending)
+		printCallback(msg.time, msg.sv, msg.text);
+}
+
 bool Log::Logger::SetLogFile(std::string filename)
 {
 	FILE *stream = FileSystem::userFiles.OpenWriteStream(filename, FileSystem::FileSourceFS::WRITE_TEXT);
@@ -43,6 +176,8 @@ bool Log::Logger::SetLogFile(std::string filename)
 		return false;
 	}
 
+	// the writer thread mustn't be using the old file
+	Flush();
 	if (file)
 		fclose(file);
 
@@ -79,10 +214,52 @@ void Log::Logger::LogLevel(Severity sv, std::string_view message)
 		message.remove_suffix(1);
 	}
 
+	if (m_async && sv > Severity::Warning && sv > m_maxMsgSeverity) {
+		if (sv <= m_maxSeverity || (file && sv <= m_maxFileSeverity))
+			m_async->Push(time, sv, message);
+		DeliverCallback(time, sv, message);
+		return;
+	}
+
+	// keep the order of anything still queued
+	Flush();
 	WriteLog(time, sv, message);
 }
 
 void Log::Logger::WriteLog(Time::DateTime time, Severity sv, std::string_view msg)
+{
+	WriteOutput(time, sv, msg);
+	DeliverCallback(time, sv, msg);
+
+	if (sv <= m_maxMsgSeverity) {
+		uint32_t flags;
+		if (sv <= Severity::Error)
+			flags = SDL_MESSAGEBOX_ERROR;
+		else if (sv <= Severity::Warning)
+			flags = SDL_MESSAGEBOX_WARNING;
+		else
+			flags = SDL_MESSAGEBOX_INFORMATION;
+
+		// convert to std::string since we're going to be pausing the program here for the message box anyways
+		SDL_ShowSimpleMessageBox(flags, "Pioneer Warning", std::string(msg).c_str(), 0);
+	}
+}
+
+void Log::Logger::DeliverCallback(Time::DateTime time, Severity sv, std::string_view msg)
+{
+	if (printCallback.empty())
+		return;
+
+	if (m_async && std::this_thread::get_id() != m_async->mainThread) {
+		std::lock_guard<std::mutex> lock(m_async->callbackLock);
+		m_async->callbacks.push_back({ time, sv, std::string(msg) });
+		return;
+	}
+
+	printCallback(time, sv, msg);
+}
+
+void Log::Logger::WriteOutput(Time::DateTime time, Severity sv, std::string_view msg)
 {
 	std::string &svName = s_severityNames.at(sv);
 
@@ -103,30 +280,15 @@ void Log::Logger::WriteLog(Time::DateTime time, Severity sv, std::string_view ms
 	}
 #endif
 
-	if (!printCallback.empty()) {
-		printCallback(time, sv, msg);
-	}
-
 	if (file && sv <= m_maxFileSeverity) {
 		if (!msg.empty() && msg.back() == '\n')
 			fmt::print(file, "[{0}] {1:<8}  {2}", time.ToTimeString(), svName, msg);
 		else
 			fmt::print(file, "[{0}] {1:<8}  {2}\n", time.ToTimeString(), svName, msg);
-		// flush log file to ensure we have complete data in case of a crash
-		fflush(file);
-	}
-
-	if (sv <= m_maxMsgSeverity) {
-		uint32_t flags;
-		if (sv <= Severity::Error)
-			flags = SDL_MESSAGEBOX_ERROR;
-		else if (sv <= Severity::Warning)
-			flags = SDL_MESSAGEBOX_WARNING;
-		else
-			flags = SDL_MESSAGEBOX_INFORMATION;
-
-		// convert to std::string since we're going to be pausing the program here for the message box anyways
-		SDL_ShowSimpleMessageBox(flags, "Pioneer Warning", std::string(msg).c_str(), 0);
+		// flush log file to ensure we have complete data in case of a crash;
+		// the writer thread flushes once its queue is empty instead
+		if (!m_async || std::this_thread::get_id() != m_async->thread.get_id())
+			fflush(file);
 	}
 }
 
@@ -137,6 +299,8 @@ Log::Logger *Log::GetLog()
 
 void Log::SetLog(Logger &log)
 {
+	// the writer thread holds on to its logger
+	assert(!log.IsAsync() && !s_defaultLog.IsAsync());
 	s_defaultLog = std::move(log);
 }
 
@@ -7,6 +7,7 @@
 #include <fmt/core.h>
 #include <fmt/printf.h>
 #include <sigc++/signal.h>
+#include <memory>
 #include <string_view>
 
 namespace Log {
@@ -20,6 +21,9 @@ namespace Log {
 	};
 
 	struct Logger {
+		Logger();
+		Logger(Logger &&);
+		Logger &operator=(Logger &&);
 		~Logger();
 
 		// Handle formatting, indentation, etc.
@@ -47,17 +51,38 @@ namespace Log {
 			if (current_indent) current_indent -= 1;
 		}
 
+		// In async mode, Info and less severe messages are handed to a
+		// background thread which writes them to the console and log file,
+		// so logging costs the caller little more than formatting the
+		// message. Warnings and errors still flush the queue and are written
+		// before LogLevel returns. Must be enabled and disabled from the
+		// main thread, which then receives every printCallback; callbacks
+		// for messages from other threads wait for DispatchCallbacks().
+		void SetAsync(bool async);
+		bool IsAsync() const { return bool(m_async); }
+		// Waits until every queued message has been written
+		void Flush();
+		// Calls printCallback for messages logged from other threads since
+		// the last call. Must be called from the main thread.
+		void DispatchCallbacks();
+
 		sigc::signal<void, Time::DateTime, Severity, std::string_view> printCallback;
 
 	private:
+		struct AsyncWriter;
+
 		void WriteLog(Time::DateTime t, Severity sv, std::string_view msg);
+		// console and log file output only
+		void WriteOutput(Time::DateTime t, Severity sv, std::string_view msg);
+		void DeliverCallback(Time::DateTime t, Severity sv, std::string_view msg);
 
-		FILE *file;
+		FILE *file = nullptr;
 		Severity m_maxSeverity = Severity::Info;
 		Severity m_maxFileSeverity = Severity::Debug;
 		Severity m_maxMsgSeverity = Severity::Error;
-		uint8_t current_indent;
+		uint8_t current_indent = 0;
 		std::string m_logName;
+		std::unique_ptr<AsyncWriter> m_async;
 	};
 
 	void SetLog(Logger &log);
@@ -0,0 +1,106 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "MemoryStats.h"
+
+#include "Json.h"
+
+#include <atomic>
+
+namespace {
+	const char *s_tagNames[MemoryStats::TAG_MAX] = {
+		"geopatch",
+		"galaxy",
+		"models",
+		"textures",
+		"lua",
+		"saveJson",
+		"audio",
+	};
+
+	std::atomic<size_t> s_current[MemoryStats::TAG_MAX];
+	std::atomic<size_t> s_peak[MemoryStats::TAG_MAX];
+	std::function<size_t()> s_reporters[MemoryStats::TAG_MAX];
+
+	void UpdatePeak(MemoryStats::Tag tag, size_t current)
+	{
+		size_t peak = s_peak[tag].load(std::memory_order_relaxed);
+		while (current > peak && !s_peak[tag].compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+		}
+	}
+} // namespace
+
+const char *MemoryStats::GetTagName(Tag tag)
+{
+	return s_tagNames[tag];
+}
+
+void MemoryStats::Add(Tag tag, size_t bytes)
+{
+	const size_t current = s_current[tag].fetch_add(bytes, std::memory_order_relaxed) + bytes;
+	UpdatePeak(tag, current);
+}
+
+void MemoryStats::Sub(Tag tag, size_t bytes)
+{
+	s_current[tag].fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+void MemoryStats::SetReporter(Tag tag, std::function<size_t()> reporter)
+{
+	s_reporters[tag] = std::move(reporter);
+}
+
+MemoryStats::Usage MemoryStats::Get(Tag tag)
+{
+	if (s_reporters[tag]) {
+		s_current[tag].store(s_reporters[tag](), std::memory_order_relaxed);
+		UpdatePeak(tag, s_current[tag].load(std::memory_order_relaxed));
+	}
+
+	return { s_current[tag].load(std::memory_order_relaxed), s_peak[tag].load(std::memory_order_relaxed) };
+}
+
+void MemoryStats::ResetPeaks()
+{
+	for (int tag = 0; tag < TAG_MAX; tag++)
+		s_peak[tag].store(s_current[tag].load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+Json MemoryStats::ToJson()
+{
+	Json out = Json::object();
+	for (int tag = 0; tag < TAG_MAX; tag++) {
+		const Usage usage = Get(Tag(tag));
+		Json entry = Json::object();
+		entry["currentBytes"] = usage.current;
+		entry["peakBytes"] = usage.peak;
+		out[s_tagNames[tag]] = entry;
+	}
+	return out;
+}
+
+size_t MemoryStats::EstimateJsonBytes(const Json &node)
+{
+	// every value is a node; containers and strings also own heap storage
+	size_t bytes = sizeof(Json);
+	switch (node.type()) {
+	case Json::value_t::object:
+		for (auto it = node.begin(); it != node.end(); ++it) {
+			// map node overhead, roughly three pointers and a colour
+			bytes += it.key().capacity() + sizeof(std::string) + 4 * sizeof(void *);
+			bytes += EstimateJsonBytes(it.value());
+		}
+		break;
+	case Json::value_t::array:
+		for (const Json &value : node)
+			bytes += EstimateJsonBytes(value);
+		break;
+	case Json::value_t::string:
+		bytes += sizeof(std::string) + node.get_ref<const std::string &>().capacity();
+		break;
+	default:
+		break;
+	}
+	return bytes;
+}
@@ -0,0 +1,59 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#pragma once
+
+#include "JsonFwd.h"
+
+#include <cstddef>
+#include <functional>
+
+/*
+ * Memory accounting per subsystem. Hot allocators that own large buffers
+ * (terrain patch data, textures, model instances, save game JSON, decoded
+ * sounds) add and subtract what they hold as it changes; subsystems that
+ * can already measure themselves (the Lua heap, the galaxy caches) register
+ * a reporter which is polled instead.
+ *
+ * The numbers are what each subsystem accounts for, not everything it
+ * allocates, and some are estimates. They are meant to show where memory
+ * goes and how it trends, next to the process total.
+ */
+namespace MemoryStats {
+	enum Tag {
+		TAG_GEOPATCH,
+		TAG_GALAXY,
+		TAG_MODELS,
+		TAG_TEXTURES,
+		TAG_LUA,
+		TAG_SAVE_JSON,
+		TAG_AUDIO,
+		TAG_MAX
+	};
+
+	struct Usage {
+		size_t current;
+		size_t peak;
+	};
+
+	const char *GetTagName(Tag tag);
+
+	// Thread-safe; allocators may call these from worker threads
+	void Add(Tag tag, size_t bytes);
+	void Sub(Tag tag, size_t bytes);
+
+	// The reporter is polled by Get() in place of the tag's counter. Only
+	// set or clear reporters from the main thread, while nothing is polling.
+	void SetReporter(Tag tag, std::function<size_t()> reporter);
+
+	// Polls the tag's reporter if it has one, and updates its peak
+	Usage Get(Tag tag);
+	// Resets every peak to the current usage
+	void ResetPeaks();
+
+	// Current and peak bytes of every tag, keyed by tag name
+	Json ToJson();
+
+	// Rough size of a JSON tree in memory, including its strings
+	size_t EstimateJsonBytes(const Json &node);
+} // namespace MemoryStats
@@ -24,6 +24,10 @@ namespace OS {
 	// http://stackoverflow.com/questions/150355/programmatically-find-the-number-of-cores-on-a-machine
 	uint32_t GetNumCores();
 
+	// Restrict the calling thread to run only on the given logical core.
+	// Returns false if thread pinning is not supported on this platform.
+	bool SetCurrentThreadAffinity(uint32_t core);
+
 	// return a string describing the operating system that the game is running on, useful!
 	const std::string GetOSInfoString();
 
@@ -203,6 +203,7 @@ void PropertyMap::SetRef(uint32_t hash, value_type &&value)
 
 			m_keys[idx] = hash;
 			m_values[idx] = std::move(value);
+			MarkChanged();
 			return;
 		}
 	}
@@ -218,6 +219,8 @@ void PropertyMap::Clear()
 
 	if (m_keys.size())
 		std::fill(m_keys.begin(), m_keys.end(), 0);
+	if (m_entries)
+		MarkChanged();
 	m_entries = 0;
 }
 
@@ -167,6 +167,11 @@ void to_json(Json &obj, const Property &n);
  * Internally, a power-of-two based Robin-Hood hash map is used to associate
  * StringName keys with Property values with extremely low hashing and lookup
  * overhead.
+ *
+ * Every change to the map increments its version, which readers can use to
+ * cache values; setting a key to the value it already holds is not a change.
+ * Changes made inside a Batch increment the version once, when the
+ * outermost batch ends.
  */
 class PropertyMap : public RefCounted {
 public:
@@ -198,6 +203,26 @@ public:
 		uint32_t idx;
 	};
 
+	// Coalesces the changes made while it is in scope
+	class Batch {
+	public:
+		explicit Batch(PropertyMap &map) :
+			m_map(map) { m_map.m_batchDepth++; }
+		~Batch()
+		{
+			if (--m_map.m_batchDepth == 0 && m_map.m_batchChanged) {
+				m_map.m_batchChanged = false;
+				m_map.m_version++;
+			}
+		}
+
+		Batch(const Batch &) = delete;
+		Batch &operator=(const Batch &) = delete;
+
+	private:
+		PropertyMap &m_map;
+	};
+
 public:
 	PropertyMap();
 	~PropertyMap();
@@ -220,8 +245,18 @@ public:
 	const Property &Get(const StringName &str) const { return GetRef(str.hash()).second; }
 	const Property &Get(std::string_view str) const { return GetRef(hash_32_fnv1a(str.data(), str.size())).second; }
 
-	void Set(const StringName &key, Property &&prop) { SetRef(key.hash(), { key, std::move(prop) }); }
-	void Set(std::string_view str, Property &&prop) { Set(StringName(str), std::move(prop)); }
+	void Set(const StringName &key, Property &&prop)
+	{
+		if (!(GetRef(key.hash()).second == prop))
+			SetRef(key.hash(), { key, std::move(prop) });
+	}
+	// The key is only made into a StringName if the value changes
+	void Set(std::string_view str, Property &&prop)
+	{
+		const uint32_t hash = hash_32_fnv1a(str.data(), str.size());
+		if (!(GetRef(hash).second == prop))
+			SetRef(hash, { StringName(str, hash), std::move(prop) });
+	}
 
 	// Use template-based forwarding for older compilers which cannot convert e.g. int to Property&&
 	template<typename T>
@@ -231,6 +266,9 @@ public:
 
 	void Clear();
 
+	// Incremented by every change to the map
+	uint32_t GetVersion() const { return m_version; }
+
 	iterator begin() { return iterator{ this, 0 }; }
 	iterator end() { return iterator{ this, uint32_t(m_keys.size()) }; }
 	iterator cbegin() const { return iterator{ this, 0 }; }
@@ -244,10 +282,20 @@ private:
 
 	PropertyMap(uint32_t size);
 	void Grow();
+	void MarkChanged()
+	{
+		if (m_batchDepth)
+			m_batchChanged = true;
+		else
+			m_version++;
+	}
 
 	std::vector<uint32_t> m_keys;
 	std::vector<value_type> m_values;
 	uint32_t m_entries;
+	uint32_t m_version = 0;
+	uint32_t m_batchDepth = 0;
+	bool m_batchChanged = false;
 };
 
 inline auto PropertyMapWrapper::begin() { return m_map->begin(); }
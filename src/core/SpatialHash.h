@@ -0,0 +1,222 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#pragma once
+
+#include "vector3.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Sparse hierarchical grid of items by position, for neighbourhood queries.
+//
+// Items are bucketed into cubic cells held in a hash map, so only occupied
+// cells take up memory. Each level of the hierarchy has cells levelScale
+// times larger than the one below, and queries use the finest level on
+// which they only touch a few cells per axis.
+//
+// Updates are incremental: an item only moves between cells when it
+// crosses a cell boundary, and items which weren't updated during a
+// BeginUpdate() / EndUpdate() pass are dropped.
+template <typename T, typename Hash = std::hash<T>>
+class SpatialHash {
+public:
+	static constexpr int MAX_LEVELS = 6;
+
+	explicit SpatialHash(double cellSize, int numLevels = 1, double levelScale = 16.0) :
+		m_numLevels(numLevels),
+		m_generation(0)
+	{
+		assert(numLevels > 0 && numLevels <= MAX_LEVELS);
+		for (int level = 0; level < m_numLevels; level++) {
+			m_levels[level].cellSize = cellSize;
+			m_levels[level].invCellSize = 1.0 / cellSize;
+			cellSize *= levelScale;
+		}
+	}
+
+	SpatialHash(const SpatialHash &) = delete;
+	SpatialHash &operator=(const SpatialHash &) = delete;
+
+	void BeginUpdate() { m_generation++; }
+
+	// insert an item, or move it to a new position
+	void Update(const T &item, const vector3d &pos)
+	{
+		auto result = m_items.emplace(item, Entry{});
+		Item *node = &*result.first;
+		Entry &entry = node->second;
+		entry.generation = m_generation;
+
+		for (int level = 0; level < m_numLevels; level++) {
+			const CellKey key = GetCellKey(m_levels[level], pos);
+			if (!result.second) {
+				if (entry.cell[level] == key) {
+					(*entry.cellList[level])[entry.index[level]].pos = pos;
+					continue;
+				}
+				RemoveFromCell(level, entry);
+			}
+
+			std::vector<CellItem> &cell = m_levels[level].cells[key];
+			entry.cell[level] = key;
+			entry.cellList[level] = &cell;
+			entry.index[level] = cell.size();
+			cell.push_back(CellItem{ pos, node });
+		}
+	}
+
+	// remove all items which weren't updated since BeginUpdate()
+	void EndUpdate()
+	{
+		for (auto iter = m_items.begin(); iter != m_items.end();) {
+			if (iter->second.generation != m_generation) {
+				for (int level = 0; level < m_numLevels; level++)
+					RemoveFromCell(level, iter->second);
+				iter = m_items.erase(iter);
+			} else {
+				++iter;
+			}
+		}
+	}
+
+	void Remove(const T &item)
+	{
+		auto iter = m_items.find(item);
+		if (iter == m_items.end())
+			return;
+
+		for (int level = 0; level < m_numLevels; level++)
+			RemoveFromCell(level, iter->second);
+		m_items.erase(iter);
+	}
+
+	void Clear()
+	{
+		for (int level = 0; level < m_numLevels; level++)
+			m_levels[level].cells.clear();
+		m_items.clear();
+	}
+
+	// Append all items within radius of pos, as of their last Update()
+	void Query(const vector3d &pos, double radius, std::vector<T> &out) const
+	{
+		// finest level on which the query spans at most two cells per axis
+		int level = 0;
+		while (level + 1 < m_numLevels && 2.0 * radius > m_levels[level].cellSize)
+			level++;
+
+		const Level &lvl = m_levels[level];
+		const CellKey min = GetCellKey(lvl, pos - vector3d(radius));
+		const CellKey max = GetCellKey(lvl, pos + vector3d(radius));
+		const double radiusSqr = radius * radius;
+
+		auto addCell = [&](const std::vector<CellItem> &cell) {
+			for (const CellItem &item : cell) {
+				if ((item.pos - pos).LengthSqr() <= radiusSqr)
+					out.push_back(item.item->first);
+			}
+		};
+
+		// queries larger than the coarsest cells walk the occupied cells instead
+		const double numQueryCells = double(max.x - min.x + 1) * double(max.y - min.y + 1) * double(max.z - min.z + 1);
+		if (numQueryCells > double(lvl.cells.size())) {
+			for (const auto &cell : lvl.cells) {
+				const CellKey &key = cell.first;
+				if (key.x >= min.x && key.x <= max.x && key.y >= min.y && key.y <= max.y && key.z >= min.z && key.z <= max.z)
+					addCell(cell.second);
+			}
+			return;
+		}
+
+		for (int64_t x = min.x; x <= max.x; x++) {
+			for (int64_t y = min.y; y <= max.y; y++) {
+				for (int64_t z = min.z; z <= max.z; z++) {
+					auto iter = lvl.cells.find(CellKey{ x, y, z });
+					if (iter != lvl.cells.end())
+						addCell(iter->second);
+				}
+			}
+		}
+	}
+
+	size_t GetNumItems() const { return m_items.size(); }
+	size_t GetNumCells(int level = 0) const { return m_levels[level].cells.size(); }
+
+private:
+	struct CellKey {
+		int64_t x, y, z;
+		bool operator==(const CellKey &other) const { return x == other.x && y == other.y && z == other.z; }
+	};
+
+	struct CellKeyHash {
+		size_t operator()(const CellKey &key) const
+		{
+			// large primes from "Optimized Spatial Hashing for Collision Detection of Deformable Objects"
+			return size_t((uint64_t(key.x) * 73856093) ^ (uint64_t(key.y) * 19349663) ^ (uint64_t(key.z) * 83492791));
+		}
+	};
+
+	struct Entry;
+	// unordered_map nodes are stable, so cells and entries can point
+	// straight at each other
+	using Item = std::pair<const T, Entry>;
+
+	struct CellItem {
+		vector3d pos;
+		Item *item;
+	};
+
+	struct Entry {
+		uint32_t generation;
+		// cell of the item on each level, and its position in that cell's list
+		CellKey cell[MAX_LEVELS];
+		std::vector<CellItem> *cellList[MAX_LEVELS];
+		uint32_t index[MAX_LEVELS];
+	};
+
+	struct Level {
+		double cellSize;
+		double invCellSize;
+		std::unordered_map<CellKey, std::vector<CellItem>, CellKeyHash> cells;
+	};
+
+	static CellKey GetCellKey(const Level &level, const vector3d &pos)
+	{
+		// clamp so that far-away, infinite or NaN positions still land in a valid cell
+		const double limit = double(INT64_C(1) << 52);
+		auto axis = [&](double v) {
+			const double cell = std::floor(v * level.invCellSize);
+			if (std::isnan(cell))
+				return int64_t(0);
+			return int64_t(cell < -limit ? -limit : (cell > limit ? limit : cell));
+		};
+		return CellKey{ axis(pos.x), axis(pos.y), axis(pos.z) };
+	}
+
+	void RemoveFromCell(int level, const Entry &entry)
+	{
+		std::vector<CellItem> &cell = *entry.cellList[level];
+
+		// swap the last item into the freed slot
+		const uint32_t index = entry.index[level];
+		if (index + 1 != cell.size()) {
+			cell[index] = cell.back();
+			cell[index].item->second.index[level] = index;
+		}
+		cell.pop_back();
+
+		if (cell.empty())
+			m_levels[level].cells.erase(entry.cell[level]);
+	}
+
+	Level m_levels[MAX_LEVELS];
+	int m_numLevels;
+	uint32_t m_generation;
+
+	std::unordered_map<T, Entry, Hash> m_items;
+};
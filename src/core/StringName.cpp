@@ -7,6 +7,7 @@
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <thread>
 #include <vector>
 
 StringName::StringName(std::string_view s, uint32_t hash) :
@@ -55,151 +56,192 @@ StringName &StringName::operator=(StringName &&rhs)
 
 StringName::StringData *StringName::make_data(const char *c, uint32_t s, uint32_t h)
 {
-	auto &entry = StringTable::Get()->FindOrCreate(h);
-	if (!entry) {
-		entry = new (std::malloc(sizeof(StringData) + s + 1)) StringData();
-		std::memcpy(entry->get(), c, s);
-		entry->get()[s] = '\0';
-	}
-
-	entry->ref();
-	return entry;
+	return StringPool::Get()->Intern(std::string_view(c, s), h);
 }
 
 // =============================================================================
 
-StringTable::Data *StringTable::Find(uint32_t key)
+namespace {
+	// marks a slot whose string was reclaimed, so probing carries on past it
+	StringPool::Data *const TOMBSTONE = reinterpret_cast<StringPool::Data *>(uintptr_t(1));
+} // namespace
+
+StringPool::StringPool(uint32_t capacity) :
+	m_ownedTable(new Table(capacity)),
+	m_entries(0),
+	m_tombstones(0),
+	m_epoch(0),
+	m_lookups{ { 0 }, { 0 } }
 {
-	if (!key)
-		return nullptr;
+	assert(capacity && !(capacity & (capacity - 1)));
+	m_table.store(m_ownedTable.get());
+}
 
-	uint8_t slot_dist = 0;
-	for (uint32_t idx = key;; idx++, slot_dist++) {
-		idx &= keys.size() - 1;
+StringPool::~StringPool()
+{
+	Table *table = m_table.load();
+	for (uint32_t idx = 0; idx <= table->mask; idx++) {
+		Data *data = table->slots[idx].load();
+		if (data && data != TOMBSTONE)
+			std::free(data);
+	}
+}
 
-		uint32_t probed_key = keys[idx];
-		if (probed_key == key)
-			return &values[idx];
+// The main thread's StringNames outlive any static destructor order, so the
+// pool is never destroyed
+StringPool *StringPool::Get()
+{
+	static StringPool *pool = new StringPool(1 << 14);
+	return pool;
+}
 
-		if (!probed_key || dist[idx] < slot_dist)
+StringPool::Data *StringPool::Lookup(const Table *table, std::string_view s, uint32_t hash)
+{
+	// the table always has empty slots, which end the probe
+	for (uint32_t idx = hash;; idx++) {
+		idx &= table->mask;
+
+		Data *data = table->slots[idx].load(std::memory_order_acquire);
+		if (!data)
 			return nullptr;
+
+		if (data != TOMBSTONE && data->hash == hash && data->size == s.size() && !std::memcmp(data->get(), s.data(), s.size()))
+			return data;
 	}
 }
 
-StringTable::Data *StringTable::Create(uint32_t key)
+bool StringPool::Insert(Table *table, Data *data)
 {
-	if (entries > uint32_t(keys.size() * 0.9))
-		Grow();
+	for (uint32_t idx = data->hash;; idx++) {
+		idx &= table->mask;
 
-	uint8_t slot_dist = 0;
-	uint32_t ret = 0;
-	for (uint32_t idx = key;; idx++, slot_dist++) {
-		idx &= keys.size() - 1;
-
-		uint32_t probed_key = keys[idx];
-		if (probed_key == key)
-			return &values[idx];
-
-		if (!probed_key || dist[idx] < slot_dist) {
-			ret = idx;
-			break;
+		Data *probed = table->slots[idx].load(std::memory_order_relaxed);
+		if (!probed || probed == TOMBSTONE) {
+			table->slots[idx].store(data, std::memory_order_release);
+			return probed == TOMBSTONE;
 		}
 	}
+}
 
-	StringTable::Data cached_value = {};
-	for (uint32_t idx = ret;; idx++, slot_dist++) {
-		idx &= keys.size() - 1;
-
-		uint32_t probed_key = keys[idx];
-		if (!probed_key || dist[idx] < slot_dist) {
-			std::swap(keys[idx], key);
-			std::swap(dist[idx], slot_dist);
-			std::swap(values[idx], cached_value);
-			if (!probed_key)
-				break;
-		}
+uint32_t StringPool::EnterLookup()
+{
+	// if Reclaim() moved on between reading the epoch and counting in, it
+	// may not wait for this lookup, so count in for the new epoch instead
+	for (;;) {
+		const uint32_t epoch = m_epoch.load();
+		m_lookups[epoch].fetch_add(1);
+		if (m_epoch.load() == epoch)
+			return epoch;
+		m_lookups[epoch].fetch_sub(1);
 	}
+}
 
-	entries++;
-	return &values[ret];
-}
-
-void StringTable::Erase(uint32_t key)
-{
-	uint8_t slot_dist = 0;
-	for (uint32_t idx = key;; idx++, slot_dist++) {
-		idx &= keys.size() - 1;
-
-		uint32_t probed_key = keys[idx];
-		if (probed_key == key) {
-			entries--;
-
-			// backshift all following entries
-			for (uint32_t jdx = idx + 1;; idx++, jdx++) {
-				idx &= keys.size() - 1;
-				jdx &= keys.size() - 1;
-
-				// stopcode, no need to continue swapping
-				if (!keys[jdx] || !dist[jdx]) {
-					keys[idx] = 0;
-					dist[idx] = 0;
-					values[idx] = nullptr;
-					return;
-				} else {
-					keys[idx] = keys[jdx];
-					dist[idx] = dist[jdx] - 1;
-					values[idx] = values[jdx];
-				}
-			}
-		}
+void StringPool::WaitForLookups()
+{
+	// lookups in the last epoch may have found anything unlinked before
+	// now; those starting from here on see the table as it is
+	const uint32_t epoch = m_epoch.load();
+	m_epoch.store(epoch ^ 1);
+	while (m_lookups[epoch].load())
+		std::this_thread::yield();
+}
+
+StringPool::Data *StringPool::Intern(std::string_view s, uint32_t hash)
+{
+	const uint32_t epoch = EnterLookup();
+	Data *found = Lookup(m_table.load(std::memory_order_acquire), s, hash);
+	if (found && !found->try_ref())
+		found = nullptr;
+	m_lookups[epoch].fetch_sub(1);
+	if (found)
+		return found;
+
+	std::lock_guard<std::mutex> lock(m_lock);
+	Table *table = m_table.load(std::memory_order_relaxed);
+	if (Data *data = Lookup(table, s, hash)) {
+		// may revive an unreferenced string; Reclaim() can't be unlinking it
+		// while we hold the lock
+		data->ref();
+		return data;
+	}
 
-		if (!probed_key || dist[idx] < slot_dist)
-			return;
+	// keep at most three quarters of the slots in use, counting tombstones
+	const uint32_t capacity = table->mask + 1;
+	if ((m_entries + m_tombstones + 1) * 4 > capacity * 3) {
+		table = Rehash((m_entries + 1) * 2 > capacity ? capacity * 2 : capacity);
 	}
+
+	Data *data = new (std::malloc(sizeof(Data) + s.size() + 1)) Data();
+	data->refcount.store(1, std::memory_order_relaxed);
+	data->hash = hash;
+	data->size = uint32_t(s.size());
+	std::memcpy(data->get(), s.data(), s.size());
+	data->get()[s.size()] = '\0';
+
+	if (Insert(table, data))
+		m_tombstones--;
+	m_entries++;
+	return data;
 }
 
-void StringTable::Reclaim(bool force)
+StringPool::Table *StringPool::Rehash(uint32_t capacity)
 {
-	m_reclaimClock.SoftStop();
-	if (m_reclaimClock.seconds() < 15.0 && !force)
-		return;
-
-	m_reclaimClock.SoftReset();
-	for (uint32_t idx = 0; idx < keys.size(); idx++) {
-		uint32_t probed_key = keys[idx];
-
-		// the refcount can be decremented to zero from another thread,
-		// and it can be incremented on another thread as long as it is >0
-		// but only this thread can increment it from zero
-		if (probed_key && !values[idx]->get_ref()) {
-			Erase(probed_key);
-		}
+	std::unique_ptr<Table> table(new Table(capacity));
+	Table *old = m_table.load(std::memory_order_relaxed);
+	for (uint32_t idx = 0; idx <= old->mask; idx++) {
+		Data *data = old->slots[idx].load(std::memory_order_relaxed);
+		if (data && data != TOMBSTONE)
+			Insert(table.get(), data);
 	}
+	m_tombstones = 0;
+
+	// lookups may still be probing the old table
+	m_table.store(table.get(), std::memory_order_release);
+	m_retiredTables.emplace_back(std::move(m_ownedTable));
+	m_ownedTable = std::move(table);
+	return m_ownedTable.get();
+}
+
+size_t StringPool::Size() const
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	return m_entries;
 }
 
-void StringTable::Grow()
+size_t StringPool::Capacity() const
 {
-	size_t new_size = keys.size() * 2;
-	dist = std::vector<uint8_t>(new_size);
+	return m_table.load(std::memory_order_acquire)->mask + 1;
+}
 
-	std::vector<uint32_t> old_keys(new_size);
-	std::swap(keys, old_keys);
+void StringPool::Reclaim(bool force)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
 
-	std::vector<Data> old_values(new_size);
-	std::swap(values, old_values);
+	m_reclaimClock.SoftStop();
+	if (m_reclaimClock.seconds() < 15.0 && !force)
+		return;
 
-	for (uint32_t idx = 0; idx < old_keys.size(); idx++) {
-		uint32_t hash = old_keys[idx];
+	m_reclaimClock.SoftReset();
 
-		if (hash)
-			*Create(hash) = old_values[idx];
+	// the refcount can be decremented to zero on any thread, but only
+	// Intern() can increment it from zero, and it holds the lock to do so
+	std::vector<Data *> unlinked;
+	Table *table = m_table.load(std::memory_order_relaxed);
+	for (uint32_t idx = 0; idx <= table->mask; idx++) {
+		Data *data = table->slots[idx].load(std::memory_order_relaxed);
+		if (data && data != TOMBSTONE && !data->get_ref()) {
+			table->slots[idx].store(TOMBSTONE, std::memory_order_release);
+			unlinked.push_back(data);
+			m_entries--;
+			m_tombstones++;
+		}
 	}
-}
 
-// Lookup is extremely cheap when the string table has low to medium occupancy,
-// and resize/rehash is extremely expensive. We trade some static memory
-// allocated once for each thread to make reallocations very unlikely.
+	if (unlinked.empty() && m_retiredTables.empty())
+		return;
 
-// 16k slots == 208kb per thread
-thread_local StringTable tl_stringTable = StringTable(1 << 14);
-StringTable *StringTable::Get() { return &tl_stringTable; }
+	WaitForLookups();
+	for (Data *data : unlinked)
+		std::free(data);
+	m_retiredTables.clear();
+}
@@ -7,13 +7,15 @@
 #include "profiler/Profiler.h"
 
 #include <atomic>
+#include <memory>
+#include <mutex>
 #include <string_view>
 #include <type_traits>
 #include <vector>
 
 /*
  * Lightweight immutable refcounted string class. Internally stores string data
- * in the string object or in a thread-local hashtable for storage efficiency.
+ * in the string object or in a process-wide intern pool for storage efficiency.
  */
 class StringName {
 	static constexpr uint32_t MAX_SSO_SIZE = 15;
@@ -57,15 +59,27 @@ public:
 	bool operator<(const StringName &rhs) const { return sv() < rhs.sv(); }
 
 private:
-	friend class StringTable;
+	friend class StringPool;
 
 	struct StringData {
 		mutable std::atomic<uint32_t> refcount;
+		uint32_t hash;
+		uint32_t size;
 		char *get() { return reinterpret_cast<char *>(&this[1]); }
 
 		uint32_t ref() const { return refcount.fetch_add(1) + 1; }
 		uint32_t unref() const { return refcount.fetch_sub(1) - 1; }
 		uint32_t get_ref() const { return refcount.load(); }
+
+		// Only takes a reference while the string is still referenced; the
+		// pool is the only thing allowed to revive an unreferenced string
+		bool try_ref() const
+		{
+			uint32_t count = refcount.load(std::memory_order_relaxed);
+			while (count && !refcount.compare_exchange_weak(count, count + 1)) {
+			}
+			return count != 0;
+		}
 	};
 
 	// handle interning and de-duplicating the string memory
@@ -80,50 +94,72 @@ private:
 };
 
 /*
- * Thread-local hash table for efficient storage of immutable strings.
- * StringTable uses a power-of-two based robin-hood hash table to keep
- * indexing overhead as small as possible.
+ * Process-wide intern pool behind StringName, so a string is stored once
+ * whichever thread names it.
+ *
+ * Lookups probe an open addressing table of atomic pointers without taking a
+ * lock, comparing the string itself rather than only its hash. Creating an
+ * entry, growing the table and reclaiming unreferenced strings are serialized
+ * by a mutex. Each lookup counts itself in for the current epoch; Reclaim()
+ * moves on to the next epoch and waits for the lookups counted in for the
+ * last one before freeing strings and tables taken out of use, which no
+ * later lookup can reach.
  */
-class StringTable {
+class StringPool {
 public:
-	using Data = StringName::StringData *;
-
-	StringTable(uint32_t size) :
-		keys(size),
-		dist(size),
-		values(size),
-		entries(0) {}
+	using Data = StringName::StringData;
 
-	static StringTable *Get();
+	explicit StringPool(uint32_t capacity);
+	~StringPool();
 
-	size_t Size() const { return entries; }
-	size_t Capacity() const { return keys.size(); }
+	static StringPool *Get();
 
-	Data *Find(uint32_t key);
-	Data *Create(uint32_t key);
+	// Returns the interned copy of s with a reference taken, creating it if needed
+	Data *Intern(std::string_view s, uint32_t hash);
 
-	Data &FindOrCreate(uint32_t key)
-	{
-		if (auto *ptr = Find(key))
-			return *ptr;
-
-		return *Create(key);
-	}
-
-	void Erase(uint32_t key);
+	size_t Size() const;
+	size_t Capacity() const;
 
 	// Quiescent memory reclamation - call this function every 30s or so
-	// from the owning thread
+	// from the main thread. It waits for lookups already in progress on
+	// other threads before freeing anything.
 	void Reclaim(bool force = false);
 
 private:
-	void Grow();
+	struct Table {
+		explicit Table(uint32_t capacity) :
+			mask(capacity - 1),
+			slots(new std::atomic<Data *>[capacity]()) {}
+
+		uint32_t mask;
+		std::unique_ptr<std::atomic<Data *>[]> slots;
+	};
 
-	std::vector<uint32_t> keys;
-	std::vector<uint8_t> dist;
-	std::vector<Data> values;
-	uint32_t entries;
+	static Data *Lookup(const Table *table, std::string_view s, uint32_t hash);
+	// returns the epoch the lookup was counted in for, to leave it again
+	uint32_t EnterLookup();
+	void WaitForLookups();
+	// returns true if data took the place of a tombstone
+	static bool Insert(Table *table, Data *data);
+	Table *Rehash(uint32_t capacity);
+
+	mutable std::mutex m_lock;
+	std::atomic<Table *> m_table;
+	std::unique_ptr<Table> m_ownedTable;
+	uint32_t m_entries;
+	uint32_t m_tombstones;
+
+	// lock-free lookups in progress, by the epoch they started in
+	std::atomic<uint32_t> m_epoch;
+	std::atomic<uint32_t> m_lookups[2];
+
+	// tables replaced since the last Reclaim(), which lookups may still be
+	// probing
+	std::vector<std::unique_ptr<Table>> m_retiredTables;
 	Profiler::Clock m_reclaimClock;
 };
 
-inline StringName operator""_name(const char *c, size_t l) { return StringName(std::string_view(c, l)); }
+inline StringName operator""_name(const char *c, size_t l) { return StringName(std::string_view(c, l), hash_32_fnv1a(c, l)); }
+
+// Names a string literal, hashing it at compile time
+#define STRING_NAME(str) StringName(std::string_view(str, sizeof(str) - 1), std::integral_constant<uint32_t, hash_32_fnv1a(str, sizeof(str) - 1)>::value)
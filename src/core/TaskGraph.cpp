@@ -5,11 +5,15 @@
 
 #include "JobQueue.h"
 #include "SDL_timer.h"
-#include "core/StringName.h"
+#include "core/CompletionQueue.h"
+#include "core/OS.h"
 #include "fmt/format.h"
 #include "profiler/Profiler.h"
 #include <atomic_queue/atomic_queue.h>
+#include <algorithm>
 #include <atomic>
+#include <deque>
+#include <mutex>
 
 static constexpr size_t MAX_TASK_QUEUE_SIZE = 1024;
 static constexpr size_t MAX_JOB_QUEUE_SIZE = 1024;
@@ -18,7 +22,165 @@ static constexpr size_t MAX_PINNED_TASKS_STEP = 8;
 static constexpr size_t MAX_SPIN_COUNT = 10000;
 
 class AsyncTaskQueueImpl : public atomic_queue::AtomicQueue2<Task *, MAX_TASK_QUEUE_SIZE> {};
-class AsyncJobQueueImpl : public atomic_queue::AtomicQueue2<Job *, MAX_JOB_QUEUE_SIZE> {};
+
+// Jobs are bucketed by priority; a higher-priority bucket is always drained
+// before any job is taken from a lower-priority one.
+class AsyncJobQueueImpl {
+public:
+	void push(Job *job) { m_queues[job->GetPriority()].push(job); }
+
+	bool try_pop(Job *&job)
+	{
+		for (auto &queue : m_queues) {
+			if (queue.try_pop(job))
+				return true;
+		}
+
+		return false;
+	}
+
+	size_t was_size() const
+	{
+		size_t size = 0;
+		for (auto &queue : m_queues)
+			size += queue.was_size();
+
+		return size;
+	}
+
+private:
+	atomic_queue::AtomicQueue2<Job *, MAX_JOB_QUEUE_SIZE> m_queues[Job::PRIORITY_MAX];
+};
+
+// Per-thread double-ended work queue used by the work-stealing scheduler.
+// The owning thread takes recently-pushed work from the back (keeping the
+// working set warm in its cache) while idle threads steal the oldest work
+// from the front. Each queue has its own lock, so threads only contend when
+// a steal races the owner on the same queue.
+template <typename T>
+class LocalWorkQueue {
+public:
+	LocalWorkQueue() :
+		m_size(0) {}
+
+	void push(T item)
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_items.push_back(item);
+		m_size.fetch_add(1, std::memory_order_release);
+	}
+
+	bool try_pop_back(T &item)
+	{
+		if (!was_size())
+			return false;
+
+		std::lock_guard<std::mutex> lock(m_lock);
+		if (m_items.empty())
+			return false;
+
+		item = m_items.back();
+		m_items.pop_back();
+		m_size.fetch_sub(1, std::memory_order_release);
+		return true;
+	}
+
+	bool try_pop_front(T &item)
+	{
+		if (!was_size())
+			return false;
+
+		std::lock_guard<std::mutex> lock(m_lock);
+		if (m_items.empty())
+			return false;
+
+		item = m_items.front();
+		m_items.pop_front();
+		m_size.fetch_sub(1, std::memory_order_release);
+		return true;
+	}
+
+	// approximate size, does not take the lock
+	size_t was_size() const { return m_size.load(std::memory_order_acquire); }
+
+private:
+	std::mutex m_lock;
+	std::deque<T> m_items;
+	std::atomic<size_t> m_size;
+};
+
+class LocalTaskQueueImpl : public LocalWorkQueue<Task *> {};
+
+class LocalJobQueueImpl {
+public:
+	void push(Job *job) { m_queues[job->GetPriority()].push(job); }
+
+	bool try_pop_front(Job *&job, Job::Priority priority) { return m_queues[priority].try_pop_front(job); }
+
+	bool try_pop_front(Job *&job)
+	{
+		for (auto &queue : m_queues) {
+			if (queue.try_pop_front(job))
+				return true;
+		}
+
+		return false;
+	}
+
+	size_t was_size() const
+	{
+		size_t size = 0;
+		for (auto &queue : m_queues)
+			size += queue.was_size();
+
+		return size;
+	}
+
+private:
+	LocalWorkQueue<Job *> m_queues[Job::PRIORITY_MAX];
+};
+
+// Finished jobs are handed back to the main thread through lock-free rings,
+// bucketed by priority so results the player is waiting on are delivered first.
+class JobCompletionQueueImpl {
+public:
+	void push(Job *job) { m_queues[job->GetPriority()].push(job); }
+
+	bool try_pop(Job *&job)
+	{
+		for (auto &queue : m_queues) {
+			if (queue.try_pop(job))
+				return true;
+		}
+
+		return false;
+	}
+
+	size_t was_size() const
+	{
+		size_t size = 0;
+		for (auto &queue : m_queues)
+			size += queue.was_size();
+
+		return size;
+	}
+
+	size_t num_overflowed() const
+	{
+		size_t count = 0;
+		for (auto &queue : m_queues)
+			count += queue.num_overflowed();
+
+		return count;
+	}
+
+private:
+	CompletionQueue<Job *, MAX_JOB_QUEUE_SIZE> m_queues[Job::PRIORITY_MAX];
+};
+
+static const char *s_jobPriorityNames[Job::PRIORITY_MAX] = {
+	"High", "Normal", "Low"
+};
 
 // =============================================================================
 
@@ -30,7 +192,7 @@ public:
 
 	virtual Job::Handle Queue(Job *job, JobClient *client) override;
 	virtual void Cancel(Job *job) override;
-	virtual Uint32 FinishJobs() override;
+	virtual Uint32 FinishJobs(Uint32 maxMicros = 0) override;
 
 	TaskGraph *m_graph;
 };
@@ -39,7 +201,7 @@ Job::Handle TaskGraphJobQueueImpl::Queue(Job *job, JobClient *client)
 {
 	Job::Handle handle(job, this, client);
 
-	m_graph->m_jobQueue->push(job);
+	m_graph->PushJob(job);
 
 	std::atomic_thread_fence(std::memory_order_release);
 	m_graph->WakeForNewTasks();
@@ -53,12 +215,24 @@ void TaskGraphJobQueueImpl::Cancel(Job *job)
 	job->m_handle.store(nullptr, std::memory_order_release);
 }
 
-Uint32 TaskGraphJobQueueImpl::FinishJobs()
+Uint32 TaskGraphJobQueueImpl::FinishJobs(Uint32 maxMicros)
 {
 	uint32_t numFinished = 0;
+	uint32_t numProcessed = 0;
 	Job *job = nullptr;
 
-	while (m_graph->m_jobFinishedQueue->try_pop(job)) {
+	const Uint64 startTicks = SDL_GetPerformanceCounter();
+	const Uint64 maxTicks = Uint64(maxMicros) * SDL_GetPerformanceFrequency() / 1000000;
+
+	while (true) {
+		// once the time budget is spent, leave remaining jobs for the next call
+		if (maxTicks && numProcessed && SDL_GetPerformanceCounter() - startTicks > maxTicks)
+			break;
+
+		if (!m_graph->m_jobFinishedQueue->try_pop(job))
+			break;
+
+		numProcessed++;
 		job->UnlinkHandle();
 		if (job->cancelled.load(std::memory_order_relaxed)) {
 			job->OnCancel();
@@ -70,6 +244,11 @@ Uint32 TaskGraphJobQueueImpl::FinishJobs()
 		delete job;
 	}
 
+	const Perf::Stats &stats = m_graph->m_stats;
+	stats.CounterAdd(m_graph->m_finishedJobsProcessed, numProcessed);
+	stats.CounterSet(m_graph->m_finishedJobsBacklog, m_graph->m_jobFinishedQueue->was_size());
+	stats.CounterSet(m_graph->m_finishedJobsOverflowed, m_graph->m_jobFinishedQueue->num_overflowed());
+
 	return numFinished;
 }
 
@@ -99,14 +278,36 @@ bool TaskSet::AddTask(Task *task)
 
 TaskGraph::TaskGraph() :
 	m_threads(),
+	m_numThreads(0),
+	m_nextSubmitThread(0),
+	m_schedulerMode(SCHEDULER_SHARED_QUEUE),
+	m_affinityFirstCore(0),
+	m_affinityNumCores(0),
+	m_lastUtilisationSample(SDL_GetPerformanceCounter()),
 	m_taskQueue(new AsyncTaskQueueImpl()),
 	m_pinnedTasks(new AsyncTaskQueueImpl()),
 	m_jobHandlerImpl(new TaskGraphJobQueueImpl(this)),
 	m_jobQueue(new AsyncJobQueueImpl()),
-	m_jobFinishedQueue(new AsyncJobQueueImpl()),
+	m_jobFinishedQueue(new JobCompletionQueueImpl()),
 	m_isRunning(true),
-	m_numAliveThreads(0)
+	m_numAliveThreads(0),
+	m_finishedJobsProcessed(m_stats.GetOrCreateCounter("Finished Jobs Processed")),
+	m_finishedJobsBacklog(m_stats.GetOrCreateCounter("Finished Jobs Carried Over", false)),
+	m_finishedJobsOverflowed(m_stats.GetOrCreateCounter("Finished Jobs Overflowed", false)),
+	m_jobsSkipped(m_stats.GetOrCreateCounter("Jobs Skipped (Cancelled)")),
+	m_jobsAborted(m_stats.GetOrCreateCounter("Jobs Aborted Early")),
+	m_jobTimeSaved(m_stats.GetOrCreateCounter("Job Time Saved (us)")),
+	m_avgJobMicros(Job::PRIORITY_MAX)
 {
+	for (uint32_t priority = 0; priority < Job::PRIORITY_MAX; priority++) {
+		std::string name = fmt::format("Jobs Queued ({})", s_jobPriorityNames[priority]);
+		m_jobQueueDepth.push_back(m_stats.GetOrCreateCounter(name, false));
+	}
+
+	// Stealing threads walk m_threads concurrently with SetWorkerThreads;
+	// reserve up-front so the storage is never reallocated underneath them.
+	m_threads.reserve(MAX_THREADS + 1);
+
 	// initialize the main thread data
 	SetWorkerThreads(0);
 }
@@ -123,17 +324,32 @@ TaskGraph::~TaskGraph()
 	}
 
 	// once all threads have finished, join them and clean up their allocations
+	Task *task = nullptr;
+	Job *job = nullptr;
 	for (size_t idx = 0; idx < m_threads.size(); idx++) {
-		if (m_threads[idx]->threadHandle) {
-			m_threads[idx]->threadHandle->join();
-			delete m_threads[idx]->threadHandle;
+		ThreadData *thread = m_threads[idx];
+		if (thread->threadHandle) {
+			thread->threadHandle->join();
+			delete thread->threadHandle;
 		}
 
-		delete m_threads[idx];
+		// cleanup work left in this thread's local queues
+		while (thread->localTasks->try_pop_front(task)) {
+			delete task;
+		}
+
+		while (thread->localJobs->try_pop_front(job)) {
+			job->UnlinkHandle();
+			job->OnCancel();
+			delete job;
+		}
+
+		delete thread->localTasks;
+		delete thread->localJobs;
+		delete thread;
 	}
 
 	// Cleanup leftover task objects
-	Task *task = nullptr;
 	while (m_taskQueue->try_pop(task)) {
 		delete task;
 	}
@@ -144,7 +360,6 @@ TaskGraph::~TaskGraph()
 	}
 
 	// cleanup leftover job objects
-	Job *job = nullptr;
 	while (m_jobQueue->try_pop(job)) {
 		job->UnlinkHandle();
 		job->OnCancel();
@@ -165,14 +380,33 @@ TaskGraph::~TaskGraph()
 	delete m_jobFinishedQueue;
 }
 
+uint32_t TaskGraph::GetQueuedJobCount() const
+{
+	uint32_t count = 0;
+	for (const Perf::Stats::CounterRef &depth : m_jobQueueDepth)
+		count += m_stats.GetFrameValue(depth);
+	return count;
+}
+
 uint32_t TaskGraph::GetNumWorkerThreads() const
 {
 	// m_threads[0] is the thread entry for the main thread
 	return m_threads.size() - 1;
 }
 
+bool TaskGraph::SetSchedulerMode(SchedulerMode mode)
+{
+	if (GetNumWorkerThreads() > 0)
+		return m_schedulerMode == mode;
+
+	m_schedulerMode = mode;
+	return true;
+}
+
 void TaskGraph::SetWorkerThreads(uint32_t numThreads)
 {
+	numThreads = std::min(numThreads, MAX_THREADS);
+
 	// numThreads + 1 because we have an implicit thread entry for the "main" thread
 	if (numThreads + 1 <= m_threads.size())
 		return;
@@ -187,6 +421,15 @@ void TaskGraph::SetWorkerThreads(uint32_t numThreads)
 		thr->threadNum = idx;
 		thr->graph = this;
 		thr->isJobThread = idx > 0;
+		thr->localTasks = new LocalTaskQueueImpl();
+		thr->localJobs = new LocalJobQueueImpl();
+		thr->affinityCore = -1;
+		thr->busyTicks = 0;
+		thr->lastBusyTicks = 0;
+		thr->utilisation = 0.f;
+		if (idx > 0 && m_affinityNumCores > 0)
+			thr->affinityCore = m_affinityFirstCore + (idx - 1) % m_affinityNumCores;
+		m_numThreads.store(idx + 1, std::memory_order_release);
 		m_numAliveThreads.fetch_add(1, std::memory_order_release);
 		if (idx > 0)
 			thr->threadHandle = new std::thread(&ThreadData::RunThread, thr);
@@ -197,11 +440,42 @@ void TaskGraph::SetWorkerThreads(uint32_t numThreads)
 	assert(m_numAliveThreads == numThreads + 1);
 }
 
+void TaskGraph::SetWorkerAffinity(uint32_t firstCore, uint32_t numCores)
+{
+	assert(GetNumWorkerThreads() == 0);
+	m_affinityFirstCore = firstCore;
+	m_affinityNumCores = numCores;
+}
+
+void TaskGraph::UpdateUtilisation()
+{
+	// Sample over a reasonably long window to keep the values readable
+	const uint64_t now = SDL_GetPerformanceCounter();
+	const uint64_t elapsed = now - m_lastUtilisationSample;
+	if (elapsed < SDL_GetPerformanceFrequency() / 2)
+		return;
+
+	m_lastUtilisationSample = now;
+	for (ThreadData *thread : m_threads) {
+		uint64_t busy = thread->busyTicks.load(std::memory_order_relaxed);
+		thread->utilisation = std::min(float(double(busy - thread->lastBusyTicks) / double(elapsed)), 1.f);
+		thread->lastBusyTicks = busy;
+	}
+}
+
+float TaskGraph::GetWorkerUtilisation(uint32_t workerNum) const
+{
+	if (workerNum == 0 || workerNum >= m_threads.size())
+		return 0.f;
+
+	return m_threads[workerNum]->utilisation;
+}
+
 TaskSet::Handle TaskGraph::QueueTaskSet(TaskSet *taskSet)
 {
 	taskSet->m_executing = true;
 	for (auto task : taskSet->m_tasks) {
-		m_taskQueue->push(task);
+		PushTask(task);
 	}
 
 	std::atomic_thread_fence(std::memory_order_release);
@@ -211,7 +485,7 @@ TaskSet::Handle TaskGraph::QueueTaskSet(TaskSet *taskSet)
 
 void TaskGraph::QueueTask(Task *task)
 {
-	m_taskQueue->push(task);
+	PushTask(task);
 
 	// wake all threads that can run this task
 	WakeForNewTasks();
@@ -256,14 +530,27 @@ void TaskGraph::WaitForTaskSet(TaskSet::Handle &setHandle)
 	if (!setHandle.m_set)
 		return;
 
+	WaitForCompletion(setHandle.m_set);
+
+	if (setHandle.IsComplete())
+		CompleteTaskSet(setHandle);
+}
+
+void TaskGraph::WaitForCompletion(CompleteNotifier *notifier)
+{
+	// Waiting from a worker thread must not pick up tasks pinned to the main thread.
+	ThreadData *thread = GetThreadData();
+	if (!thread || thread->graph != this)
+		thread = m_threads[0];
+
 	// if the currently running thread can't accomplish anything until the
-	// TaskSet has finished executing, this thread is implicitly free to assist
-	// in executing the TaskSet to minimize overall latency.
+	// work has finished executing, this thread is implicitly free to assist
+	// in executing it to minimize overall latency.
 	uint32_t spinCount = 0;
-	while (m_isRunning && !setHandle.IsComplete()) {
+	while (m_isRunning && !notifier->IsComplete()) {
 		// We don't want to run any background Jobs during this loop as they
-		// cannot contribute towards the goal of completing the TaskSet
-		if (!TryRunTask(m_threads[0], false)) {
+		// cannot contribute towards the goal of completing the work
+		if (!TryRunTask(thread, false)) {
 			if (++spinCount > MAX_SPIN_COUNT) {
 				WaitForFinishedTask();
 			} else {
@@ -273,9 +560,6 @@ void TaskGraph::WaitForTaskSet(TaskSet::Handle &setHandle)
 			spinCount = 0;
 		}
 	}
-
-	if (setHandle.IsComplete())
-		CompleteTaskSet(setHandle);
 }
 
 bool TaskGraph::CompleteTaskSet(TaskSet::Handle &setHandle)
@@ -332,6 +616,9 @@ void TaskGraph::ThreadData::RunThread()
 	tl_threadName = fmt::format("Thread {}", threadNum);
 	Profiler::threadenter(tl_threadName.c_str());
 
+	if (affinityCore >= 0)
+		OS::SetCurrentThreadAffinity(affinityCore);
+
 	// Worker threads pull Tasks / Jobs off of a central queue that all
 	// threads can push to - this requires the use of a bulletproof atomic
 	// queue implementation for speed and reliability.
@@ -342,6 +629,7 @@ void TaskGraph::ThreadData::RunThread()
 
 	uint32_t spinCount = 0;
 	while (graph->m_isRunning.load(std::memory_order_relaxed)) {
+		const uint64_t startTicks = SDL_GetPerformanceCounter();
 		if (!graph->TryRunTask(this)) {
 			if (++spinCount > MAX_SPIN_COUNT) {
 				WaitForTasks();
@@ -350,9 +638,7 @@ void TaskGraph::ThreadData::RunThread()
 			}
 		} else {
 			spinCount = 0;
-
-			// reclaim used space in this thread's StringTable periodically
-			StringTable::Get()->Reclaim();
+			busyTicks.fetch_add(SDL_GetPerformanceCounter() - startTicks, std::memory_order_relaxed);
 		}
 	}
 
@@ -381,6 +667,19 @@ bool TaskGraph::HasTasks(ThreadData *thread)
 	if (thread->threadNum == 0 && m_pinnedTasks->was_size())
 		return true;
 
+	if (m_schedulerMode == SCHEDULER_WORK_STEALING) {
+		const uint32_t numThreads = m_numThreads.load(std::memory_order_acquire);
+		for (uint32_t idx = 0; idx < numThreads; idx++) {
+			if (m_threads[idx]->localTasks->was_size())
+				return true;
+
+			if (thread->isJobThread && m_threads[idx]->localJobs->was_size())
+				return true;
+		}
+
+		return false;
+	}
+
 	if (m_taskQueue->was_size())
 		return true;
 
@@ -390,16 +689,80 @@ bool TaskGraph::HasTasks(ThreadData *thread)
 	return false;
 }
 
+void TaskGraph::PushTask(Task *task)
+{
+	if (m_schedulerMode == SCHEDULER_WORK_STEALING)
+		GetSubmitThread()->localTasks->push(task);
+	else
+		m_taskQueue->push(task);
+}
+
+void TaskGraph::PushJob(Job *job)
+{
+	m_stats.CounterAdd(m_jobQueueDepth[job->GetPriority()]);
+
+	if (m_schedulerMode == SCHEDULER_WORK_STEALING)
+		GetSubmitThread()->localJobs->push(job);
+	else
+		m_jobQueue->push(job);
+}
+
+// Returns the thread whose local queue should receive newly submitted work.
+TaskGraph::ThreadData *TaskGraph::GetSubmitThread()
+{
+	// Work spawned by a worker stays on that worker; it will most likely
+	// touch the same data as the task that produced it.
+	ThreadData *current = GetThreadData();
+	if (current && current->graph == this && current->isJobThread)
+		return current;
+
+	const uint32_t numThreads = m_numThreads.load(std::memory_order_acquire);
+	if (numThreads <= 1)
+		return m_threads[0];
+
+	// Spread work from the main thread (and foreign threads) across all
+	// workers so they start busy without having to steal first.
+	uint32_t idx = m_nextSubmitThread.fetch_add(1, std::memory_order_relaxed);
+	return m_threads[1 + idx % (numThreads - 1)];
+}
+
+bool TaskGraph::StealTask(ThreadData *thread, Task *&task)
+{
+	const uint32_t numThreads = m_numThreads.load(std::memory_order_acquire);
+	for (uint32_t offset = 1; offset < numThreads; offset++) {
+		ThreadData *victim = m_threads[(thread->threadNum + offset) % numThreads];
+		if (victim->localTasks->try_pop_front(task))
+			return true;
+	}
+
+	return false;
+}
+
+bool TaskGraph::StealJob(ThreadData *thread, Job *&job, int priority)
+{
+	const uint32_t numThreads = m_numThreads.load(std::memory_order_acquire);
+	for (uint32_t offset = 1; offset < numThreads; offset++) {
+		ThreadData *victim = m_threads[(thread->threadNum + offset) % numThreads];
+		if (victim->localJobs->try_pop_front(job, Job::Priority(priority)))
+			return true;
+	}
+
+	return false;
+}
+
 // Try to run a task on this thread. Can be called from any thread
 bool TaskGraph::TryRunTask(ThreadData *thread, bool allowJobs)
 {
 	Task *taskToRun = nullptr;
 	bool hasTask = false;
+	const bool workStealing = m_schedulerMode == SCHEDULER_WORK_STEALING;
 
 	if (thread->threadNum == 0)
 		hasTask = m_pinnedTasks->try_pop(taskToRun);
 
-	if (!hasTask)
+	if (!hasTask && workStealing)
+		hasTask = thread->localTasks->try_pop_back(taskToRun) || StealTask(thread, taskToRun);
+	else if (!hasTask)
 		hasTask = m_taskQueue->try_pop(taskToRun);
 
 	if (hasTask) {
@@ -407,11 +770,31 @@ bool TaskGraph::TryRunTask(ThreadData *thread, bool allowJobs)
 		return true;
 	}
 
+	if (!allowJobs || !thread->isJobThread)
+		return false;
+
 	Job *job = nullptr;
-	if (allowJobs && thread->isJobThread && m_jobQueue->try_pop(job)) {
-		if (!job->cancelled.load(std::memory_order_acquire))
-			job->OnRun();
-		m_jobFinishedQueue->push(job);
+	bool hasJob = false;
+
+	// Jobs are long-running background work; service them in submission
+	// order, preferring any queued higher-priority job over our own.
+	if (workStealing) {
+		for (int priority = 0; !hasJob && priority < Job::PRIORITY_MAX; priority++)
+			hasJob = thread->localJobs->try_pop_front(job, Job::Priority(priority)) || StealJob(thread, job, priority);
+	} else {
+		hasJob = m_jobQueue->try_pop(job);
+	}
+
+	if (hasJob) {
+		m_stats.CounterDec(m_jobQueueDepth[job->GetPriority()]);
+		RunJob(job);
+
+		// Queue the next stage of a multi-stage job straight back onto the
+		// workers; only completed jobs are handed to the main thread.
+		if (job->AdvanceStage())
+			PushJob(job);
+		else
+			m_jobFinishedQueue->push(job);
 
 		return true;
 	}
@@ -419,6 +802,37 @@ bool TaskGraph::TryRunTask(ThreadData *thread, bool allowJobs)
 	return false;
 }
 
+void TaskGraph::RunJob(Job *job)
+{
+	std::atomic<uint32_t> &avgMicros = m_avgJobMicros[job->GetPriority()];
+
+	// A job cancelled before it started saves roughly the time an average
+	// job of the same priority takes to run.
+	if (job->cancelled.load(std::memory_order_acquire)) {
+		m_stats.CounterAdd(m_jobsSkipped);
+		m_stats.CounterAdd(m_jobTimeSaved, avgMicros.load(std::memory_order_relaxed));
+		return;
+	}
+
+	const uint64_t startTicks = SDL_GetPerformanceCounter();
+	job->OnRun();
+	const uint32_t elapsed = uint32_t((SDL_GetPerformanceCounter() - startTicks) * 1000000 / SDL_GetPerformanceFrequency());
+
+	// Jobs which noticed a cancellation part-way through stopped short of
+	// their usual runtime; don't let them drag the average down.
+	const uint32_t avg = avgMicros.load(std::memory_order_relaxed);
+	if (job->cancelled.load(std::memory_order_acquire)) {
+		m_stats.CounterAdd(m_jobsAborted);
+		if (avg > elapsed)
+			m_stats.CounterAdd(m_jobTimeSaved, avg - elapsed);
+		return;
+	}
+
+	// Racy read-modify-write, but the average is only an estimate and a lost
+	// sample here or there doesn't matter.
+	avgMicros.store(avg ? avg - avg / 8 + elapsed / 8 : elapsed, std::memory_order_relaxed);
+}
+
 void TaskGraph::ExecTask(Task *task)
 {
 	task->OnExecute(task->m_range);
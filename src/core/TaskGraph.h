@@ -3,10 +3,12 @@
 
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <thread>
 #include <vector>
 
+#include "PerfStats.h"
 #include "core/Semaphore.h"
 
 struct TaskRange {
@@ -16,7 +18,11 @@ struct TaskRange {
 
 class AsyncTaskQueueImpl;
 class AsyncJobQueueImpl;
+class LocalTaskQueueImpl;
+class LocalJobQueueImpl;
+class JobCompletionQueueImpl;
 
+class Job;
 class JobQueue;
 class TaskGraphJobQueueImpl;
 class TaskGraph;
@@ -138,13 +144,40 @@ private:
 // Responsible for managing threads and executing tasks
 class TaskGraph {
 public:
+	// Strategy used to distribute queued tasks and jobs between threads.
+	enum SchedulerMode {
+		// All threads pull work from a single shared queue.
+		SCHEDULER_SHARED_QUEUE,
+		// Each thread owns a local queue; work queued from a worker stays on
+		// that worker, and idle threads steal work from the other queues.
+		SCHEDULER_WORK_STEALING
+	};
+
 	TaskGraph();
 	~TaskGraph();
 
+	// Select the scheduling backend. This must be called before any worker
+	// threads are started; returns false if the mode could not be changed.
+	bool SetSchedulerMode(SchedulerMode mode);
+	SchedulerMode GetSchedulerMode() const { return m_schedulerMode; }
+
 	// Set the total number of worker threads
 	void SetWorkerThreads(uint32_t numThreads);
 	uint32_t GetNumWorkerThreads() const;
 
+	// Pin worker threads to the logical cores [firstCore, firstCore + numCores),
+	// assigned round-robin. Must be called before the worker threads are
+	// started; cores below firstCore are left free for the main, render and
+	// audio threads. A numCores of zero leaves thread placement to the OS.
+	void SetWorkerAffinity(uint32_t firstCore, uint32_t numCores);
+
+	// Sample the time each thread has spent executing work since the last
+	// call. Call periodically (e.g. once per frame) from the main thread.
+	void UpdateUtilisation();
+	// Fraction of time in [0, 1] the given worker thread (1-based) spent
+	// executing work during the last sampling window.
+	float GetWorkerUtilisation(uint32_t workerNum) const;
+
 	// Queues all tasks in a TaskSet for execution. The TaskGraph now owns
 	// the underlying TaskSet and is responsible for deletion.
 	TaskSet::Handle QueueTaskSet(TaskSet *set);
@@ -169,11 +202,24 @@ public:
 	// Run currently available tasks pinned to the main thread
 	void RunPinnedTasks();
 
+	// Execute fn(TaskRange) over the given range in parallel. The range is
+	// split recursively into subranges of at most grainSize elements, which
+	// are distributed over the worker threads. The calling thread takes part
+	// in executing subranges and returns once the entire range is complete.
+	template <typename Function>
+	void ParallelFor(TaskRange range, uint32_t grainSize, Function &&fn);
+
 	// Return the JobQueue interface object for this task graph.
 	JobQueue *GetJobQueue();
 
 	static uint32_t GetThreadNum();
 
+	// Performance counters for the task graph, including the number of
+	// queued jobs at each priority level.
+	Perf::Stats &GetStats() { return m_stats; }
+	// Jobs of every priority waiting for a worker, as of the last FlushFrame()
+	uint32_t GetQueuedJobCount() const;
+
 private:
 	friend class TaskGraphJobQueueImpl;
 	struct ThreadData {
@@ -182,23 +228,58 @@ private:
 		TaskGraph *graph;
 		bool isJobThread;
 
+		// work queues owned by this thread (work-stealing scheduler only)
+		LocalTaskQueueImpl *localTasks;
+		LocalJobQueueImpl *localJobs;
+
+		// logical core this thread is pinned to, or -1 if unpinned
+		int32_t affinityCore;
+
+		// performance counter ticks spent executing work (written by the worker)
+		std::atomic<uint64_t> busyTicks;
+		// utilisation bookkeeping, only accessed from the main thread
+		uint64_t lastBusyTicks;
+		float utilisation;
+
 		void RunThread();
 		void WaitForTasks();
 	};
 
 	static thread_local ThreadData *tl_threadData;
 
+	// Run tasks on the calling thread until the notifier has no outstanding dependants
+	void WaitForCompletion(CompleteNotifier *notifier);
+
 	bool TryRunTask(ThreadData *thread, bool allowJobs = true);
 	void ExecTask(Task *task);
+	// run a job's OnRun unless it has been cancelled, and track its duration
+	void RunJob(Job *job);
 	bool HasTasks(ThreadData *thread);
 	static ThreadData *GetThreadData();
 
+	// Work-stealing scheduler helpers
+	void PushTask(Task *task);
+	void PushJob(Job *job);
+	ThreadData *GetSubmitThread();
+	bool StealTask(ThreadData *thread, Task *&task);
+	bool StealJob(ThreadData *thread, Job *&job, int priority);
+
 	void WakeForNewTasks();
 	void WakeForFinishedTasks();
 
 	void WaitForFinishedTask();
 
 	std::vector<ThreadData *> m_threads;
+	// number of fully-initialized entries in m_threads, read by stealing threads
+	std::atomic<uint32_t> m_numThreads;
+	// round-robin index used to distribute work submitted from non-worker threads
+	std::atomic<uint32_t> m_nextSubmitThread;
+
+	SchedulerMode m_schedulerMode;
+
+	uint32_t m_affinityFirstCore;
+	uint32_t m_affinityNumCores;
+	uint64_t m_lastUtilisationSample;
 
 	// queue for short-lived high-priority tasks
 	AsyncTaskQueueImpl *m_taskQueue;
@@ -211,11 +292,83 @@ private:
 
 	// queue for long-lived low-priority background jobs
 	AsyncJobQueueImpl *m_jobQueue;
-	AsyncJobQueueImpl *m_jobFinishedQueue;
+	// jobs waiting for the main thread to call OnFinish
+	JobCompletionQueueImpl *m_jobFinishedQueue;
 
 	std::atomic<bool> m_isRunning;
 	std::atomic<uint32_t> m_numAliveThreads;
 
 	Semaphore m_newTasksSemaphore;
 	Semaphore m_finishedTasksSemaphore;
+
+	Perf::Stats m_stats;
+	// queue depth counter for each job priority level
+	std::vector<Perf::Stats::CounterRef> m_jobQueueDepth;
+	// finished jobs handled by FinishJobs this frame, and those left over
+	// when FinishJobs ran out of time
+	Perf::Stats::CounterRef m_finishedJobsProcessed;
+	Perf::Stats::CounterRef m_finishedJobsBacklog;
+	// total finished jobs which spilled out of the lock-free completion ring
+	Perf::Stats::CounterRef m_finishedJobsOverflowed;
+	// jobs cancelled before they started, jobs which noticed a cancellation
+	// and returned early from OnRun, and the estimated worker time saved
+	Perf::Stats::CounterRef m_jobsSkipped;
+	Perf::Stats::CounterRef m_jobsAborted;
+	Perf::Stats::CounterRef m_jobTimeSaved;
+	// moving average of completed OnRun durations in microseconds, for each
+	// job priority level; used to estimate the time saved by cancellation
+	std::vector<std::atomic<uint32_t>> m_avgJobMicros;
 };
+
+// Task used to implement TaskGraph::ParallelFor. While its range is larger
+// than the grain size, it hands the upper half to a new task and continues
+// splitting the lower half, so work fans out across threads in O(log n) steps.
+template <typename Function>
+class ParallelForTask : public Task {
+public:
+	ParallelForTask(TaskRange range, uint32_t grainSize, Function &fn, TaskGraph *graph, CompleteNotifier *notifier) :
+		Task(range),
+		m_grainSize(grainSize),
+		m_fn(fn),
+		m_graph(graph),
+		m_notifier(notifier)
+	{}
+
+	void OnExecute(TaskRange range) override
+	{
+		while (range.end - range.begin > m_grainSize) {
+			uint32_t split = range.begin + (range.end - range.begin) / 2;
+
+			m_notifier->m_dependants.fetch_add(1, std::memory_order_relaxed);
+			m_graph->QueueTask(new ParallelForTask({ split, range.end }, m_grainSize, m_fn, m_graph, m_notifier));
+
+			range.end = split;
+		}
+
+		m_fn(range);
+		m_notifier->m_dependants.fetch_sub(1, std::memory_order_release);
+	}
+
+private:
+	uint32_t m_grainSize;
+	Function &m_fn;
+	TaskGraph *m_graph;
+	CompleteNotifier *m_notifier;
+};
+
+template <typename Function>
+void TaskGraph::ParallelFor(TaskRange range, uint32_t grainSize, Function &&fn)
+{
+	if (range.end <= range.begin)
+		return;
+
+	CompleteNotifier notifier;
+	notifier.m_dependants.store(1, std::memory_order_relaxed);
+
+	// the calling thread starts the recursive split and executes the first subrange itself
+	ParallelForTask<Function> root(range, std::max(grainSize, 1U), fn, this, &notifier);
+	root.OnExecute(range);
+
+	WaitForCompletion(&notifier);
+	std::atomic_thread_fence(std::memory_order_acquire);
+}
@@ -111,6 +111,8 @@ void EditorApp::OnStartup()
 	// get threads up
 	Uint32 numThreads = m_editorCfg->Int("WorkerThreads");
 	numThreads = numThreads ? numThreads : std::max(OS::GetNumCores() - 1, 1U);
+	if (m_editorCfg->Int("WorkStealingScheduler"))
+		GetTaskGraph()->SetSchedulerMode(TaskGraph::SCHEDULER_WORK_STEALING);
 	GetTaskGraph()->SetWorkerThreads(numThreads);
 
 	Lang::Resource &res(Lang::GetResource("core", m_editorCfg->String("Lang", "en")));
@@ -12,10 +12,14 @@
 
 #include "core/Log.h"
 
+#include "core/StringUtils.h"
+
 #include "editor/EditorApp.h"
 #include "editor/ModelViewerWidget.h"
 #include "editor/EditorDraw.h"
 
+#include "graphics/dummy/RendererDummy.h"
+
 #include "scenegraph/BinaryConverter.h"
 #include "scenegraph/DumpVisitor.h"
 #include "scenegraph/FindNodeVisitor.h"
@@ -55,6 +59,70 @@ ModelViewer::~ModelViewer()
 {
 }
 
+// The renderer can only be used on the main thread, so a .model is loaded
+// with a dummy renderer on a worker and serialized as modelcompiler would
+// save it. The main thread then only has to create the binary model.
+class ModelViewer::LoadJob : public Job {
+public:
+	LoadJob(ModelViewer *viewer, const std::string &name) :
+		m_viewer(viewer),
+		m_name(name)
+	{}
+
+	void OnRun() override
+	{
+		try {
+			if (ends_with_ci(m_name, ".sgm")) {
+				//binary loader expects extension-less name
+				m_prepared = SceneGraph::BinaryConverter::Prepare(m_name.substr(0, m_name.size() - 4));
+			} else {
+				Graphics::RendererDummy renderer;
+				SceneGraph::Loader loader(&renderer, true, false);
+				std::unique_ptr<SceneGraph::Model> model(loader.LoadModel(m_name));
+				m_log = loader.GetLogMessages();
+
+				SceneGraph::BinaryConverter bc(&renderer);
+				if (model)
+					m_prepared = bc.Prepare(model.get());
+			}
+		} catch (SceneGraph::LoadingError &err) {
+			m_error = err.what();
+		}
+	}
+
+	void OnFinish() override
+	{
+		m_viewer->m_loadingModelName.clear();
+
+		//dump warnings
+		for (const std::string &line : m_log)
+			Log::Warning("{}", line);
+
+		if (!m_prepared) {
+			// keep showing the current model
+			Log::Warning("Could not load model {}: {}", m_name, m_error);
+			return;
+		}
+
+		//this is necessary to reload textures
+		m_viewer->m_renderer->RemoveAllCachedTextures();
+		m_viewer->ClearModel();
+
+		SceneGraph::BinaryConverter bc(m_viewer->m_renderer);
+		if (m_viewer->m_modelWindow->SetModel(bc.Load(*m_prepared))) {
+			m_viewer->m_modelName = m_name;
+			m_viewer->OnModelLoaded();
+		}
+	}
+
+private:
+	ModelViewer *m_viewer;
+	std::string m_name;
+	std::vector<std::string> m_log;
+	std::string m_error = "not found";
+	std::unique_ptr<SceneGraph::BinaryConverter::PreparedModel> m_prepared;
+};
+
 void ModelViewer::Start()
 {
 	NavLights::Init(m_renderer);
@@ -70,6 +138,8 @@ void ModelViewer::Start()
 
 void ModelViewer::End()
 {
+	m_loadJob = {};
+	m_loadingModelName.clear();
 	ClearModel();
 
 	Shields::Uninit();
@@ -366,15 +436,9 @@ void ModelViewer::SetModel(const std::string &filename)
 {
 	Log::Info("Loading model {}...", filename);
 
-	//this is necessary to reload textures
-	m_renderer->RemoveAllCachedTextures();
-
-	ClearModel();
-
-	if (m_modelWindow->LoadModel(filename)) {
-		m_modelName = filename;
-		OnModelLoaded();
-	}
+	// cancels any model still loading
+	m_loadJob = m_app->GetAsyncJobQueue()->Queue(new LoadJob(this, filename));
+	m_loadingModelName = filename;
 }
 
 void ModelViewer::OnModelLoaded()
@@ -411,6 +475,9 @@ void ModelViewer::DrawModelSelector()
 			ReloadModel();
 	}
 
+	if (!m_loadingModelName.empty())
+		ImGui::TextDisabled("Loading %s...", m_loadingModelName.c_str());
+
 	if (ImGui::BeginChild("FileList")) {
 		for (const auto &name : m_fileNames) {
 			if (ImGui::Selectable(name.c_str())) {
@@ -7,6 +7,7 @@
 #include "Shields.h"
 #include "core/GuiApplication.h"
 #include "graphics/Renderer.h"
+#include "JobQueue.h"
 #include "graphics/Texture.h"
 #include "pigui/PiGui.h"
 
@@ -80,6 +81,8 @@ private:
 	void DrawPiGui();
 
 private:
+	class LoadJob;
+
 	EditorApp *m_app;
 	Input::Manager *m_input;
 	PiGui::Instance *m_pigui;
@@ -97,6 +100,11 @@ private:
 	std::string m_modelName;
 	std::string m_requestedModelName;
 
+	// the model being loaded in the background, which replaces the one
+	// shown once it's ready
+	Job::Handle m_loadJob;
+	std::string m_loadingModelName;
+
 	SceneGraph::Tag *m_selectedTag = nullptr;
 
 	bool m_modelSupportsDecals = false;
@@ -91,16 +91,17 @@ bool ModelViewerWidget::LoadModel(std::string_view path)
 {
 	ClearModel();
 
+	SceneGraph::Model *model = nullptr;
 	try {
 		if (ends_with_ci(path, ".sgm")) {
 			//binary loader expects extension-less name. Might want to change this.
 			std::string modelName = std::string(path.substr(0, path.size() - 4));
 			SceneGraph::BinaryConverter bc(m_renderer);
-			m_model.reset(bc.Load(modelName));
+			model = bc.Load(modelName);
 		} else {
 			std::string modelName = std::string(path);
 			SceneGraph::Loader loader(m_renderer, true, false);
-			m_model.reset(loader.LoadModel(modelName));
+			model = loader.LoadModel(modelName);
 
 			//dump warnings
 			for (std::vector<std::string>::const_iterator it = loader.GetLogMessages().begin();
@@ -108,12 +109,28 @@ bool ModelViewerWidget::LoadModel(std::string_view path)
 				Log::Warning("{}", *it);
 			}
 		}
+	} catch (SceneGraph::LoadingError &err) {
+		// report the error and show model picker.
+		Log::Warning("Could not load model {}: {}", path, err.what());
+		return false;
+	}
 
-		if (!m_model) {
-			Log::Warning("Could not load model {}", path);
-			return false;
-		}
+	if (!model) {
+		Log::Warning("Could not load model {}", path);
+		return false;
+	}
 
+	return SetModel(model);
+}
+
+bool ModelViewerWidget::SetModel(SceneGraph::Model *model)
+{
+	ClearModel();
+	if (!model)
+		return false;
+
+	m_model.reset(model);
+	try {
 		Shields::ReparentShieldNodes(m_model.get());
 
 		// set model colorsm_model->SetColors(m_colors);
@@ -139,9 +156,8 @@ bool ModelViewerWidget::LoadModel(std::string_view path)
 		m_navLights.reset(new NavLights(m_model.get()));
 		m_navLights->SetEnabled(true);
 	} catch (SceneGraph::LoadingError &err) {
-		// report the error and show model picker.
 		m_model.reset();
-		Log::Warning("Could not load model {}: {}", path, err.what());
+		Log::Warning("Could not set up model: {}", err.what());
 		return false;
 	}
 
@@ -579,7 +595,7 @@ void ModelViewerWidget::DrawModel(matrix4x4f trans)
 		(m_options.wireframe ? SceneGraph::Model::DEBUG_WIREFRAME : 0x0));
 
 	m_model->Render(m_modelViewMat);
-	m_navLights->Render(m_renderer);
+	NavLights::RenderAll(m_renderer);
 }
 
 void ModelViewerWidget::DrawGrid(Graphics::Renderer *r, float clipRadius)
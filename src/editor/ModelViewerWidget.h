@@ -73,6 +73,8 @@ namespace Editor
 		~ModelViewerWidget();
 
 		bool LoadModel(std::string_view path);
+		// Takes ownership of an already loaded model and shows it
+		bool SetModel(SceneGraph::Model *model);
 		void ClearModel();
 
 		void OnAppearing() override;
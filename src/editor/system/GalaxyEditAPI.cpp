@@ -461,6 +461,18 @@ size_t SystemBody::EditorAPI::GetIndexInParent(SystemBody *body)
 	return std::distance(parent->GetChildren().begin(), iter);
 }
 
+void SystemBody::EditorAPI::UpdateMassDependents(SystemBody *body)
+{
+	// Only this body and its direct children need new orbits: grandchildren
+	// orbit bodies whose mass hasn't changed, and the map reads each orbit
+	// relative to its parent, so the rest of the system is left untouched.
+	body->SetAtmFromParameters();
+	body->SetOrbitFromParameters();
+
+	for (SystemBody *child : body->GetChildren())
+		child->SetOrbitFromParameters();
+}
+
 void SystemBody::EditorAPI::EditOrbitalParameters(SystemBody *body, UndoSystem *undo)
 {
 	ImGui::SeparatorText("Orbital Parameters");
@@ -626,6 +638,9 @@ void SystemBody::EditorAPI::EditProperties(SystemBody *body, Random &rng, UndoSy
 	auto updateBodyDerived = [=]() {
 		body->SetAtmFromParameters();
 	};
+	auto updateBodyMass = [=]() {
+		UpdateMassDependents(body);
+	};
 
 	Draw::EditEnum("Edit Body Type", "Body Type", "BodyType", reinterpret_cast<int *>(&body->m_type), BodyType::TYPE_MAX, undo);
 
@@ -644,9 +659,13 @@ void SystemBody::EditorAPI::EditProperties(SystemBody *body, Random &rng, UndoSy
 
 		ImGui::SeparatorText("Body Parameters");
 
-		bodyChanged |= Draw::InputFixedMass("Mass", &body->m_mass, isStar);
+		// a drag is a single undo entry, but the orbits follow it every frame
+		if (Draw::InputFixedMass("Mass", &body->m_mass, isStar)) {
+			UpdateMassDependents(body);
+			bodyChanged = true;
+		}
 		if (Draw::UndoHelper("Edit Mass", undo))
-			AddUndoSingleValueClosure(undo, &body->m_mass, updateBodyDerived);
+			AddUndoSingleValueClosure(undo, &body->m_mass, updateBodyMass);
 
 		bodyChanged |= Draw::InputFixedRadius("Radius",  &body->m_radius, isStar);
 		if (Draw::UndoHelper("Edit Radius", undo))
@@ -791,7 +810,7 @@ void SystemBody::EditorAPI::GenerateDerivedStats(SystemBody *body, Random &rng,
 	undo->BeginEntry("Generate Body Parameters");
 
 	// Back up all potentially-modified body variables
-	AddUndoSingleValue(undo, &body->m_mass);
+	AddUndoSingleValueClosure(undo, &body->m_mass, [=](){ UpdateMassDependents(body); });
 	AddUndoSingleValue(undo, &body->m_type);
 	AddUndoSingleValue(undo, &body->m_radius);
 	AddUndoSingleValue(undo, &body->m_averageTemp);
@@ -809,6 +828,7 @@ void SystemBody::EditorAPI::GenerateDerivedStats(SystemBody *body, Random &rng,
 	AddUndoSingleValue(undo, &body->m_life);
 
 	StarSystemRandomGenerator().PickPlanetType(body, rng);
+	UpdateMassDependents(body);
 
 	undo->EndEntry();
 }
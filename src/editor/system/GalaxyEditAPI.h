@@ -59,6 +59,9 @@ public:
 	static SystemBody *RemoveChild(SystemBody *parent, size_t idx = -1);
 	static size_t GetIndexInParent(SystemBody *body);
 
+	// Recompute the values derived from a body's mass after it is edited
+	static void UpdateMassDependents(SystemBody *body);
+
 	static void EditOrbitalParameters(SystemBody *body, Editor::UndoSystem *undo);
 	static void EditEconomicProperties(SystemBody *body, Editor::UndoSystem *undo);
 	static void EditStarportProperties(SystemBody *body, Editor::UndoSystem *undo);
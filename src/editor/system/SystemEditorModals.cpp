@@ -151,7 +151,8 @@ void NewSystemModal::DrawInternal()
 		ImGui::PushFont(m_app->GetPiGui()->GetFont("pionillium", 16));
 
 		ImGui::AlignTextToFramePadding();
-		ImGui::TextUnformatted(system.GetName().c_str());
+		const std::string_view name = system.GetName();
+		ImGui::TextUnformatted(name.data(), name.data() + name.size());
 
 		ImGui::PopFont();
 
@@ -0,0 +1,82 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "CommodityMarket.h"
+
+#include "profiler/Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+
+// however much is in stock, nothing sells for less than this of its price
+static const float MIN_PRICE_FACTOR = 0.1f;
+
+CommodityMarket::CommodityMarket(size_t numCommodities) :
+	m_numCommodities(numCommodities),
+	m_numMarkets(0),
+	m_recoveryTime(7.0 * 24 * 60 * 60),
+	m_elasticity(0.5f)
+{
+}
+
+size_t CommodityMarket::AddMarket()
+{
+	const size_t size = (m_numMarkets + 1) * m_numCommodities;
+	m_stock.resize(size, 0.0f);
+	m_equilibrium.resize(size, 0.0f);
+	m_basePrice.resize(size, 0.0f);
+	m_price.resize(size, 0.0f);
+	return m_numMarkets++;
+}
+
+void CommodityMarket::Clear()
+{
+	m_numMarkets = 0;
+	m_stock.clear();
+	m_equilibrium.clear();
+	m_basePrice.clear();
+	m_price.clear();
+}
+
+void CommodityMarket::SetEquilibrium(size_t market, GalacticEconomy::CommodityId id, float stock, float price)
+{
+	const size_t i = Index(market, id);
+	m_equilibrium[i] = std::max(stock, 0.0f);
+	m_basePrice[i] = price;
+	UpdatePrices(i, i + 1);
+}
+
+void CommodityMarket::SetStock(size_t market, GalacticEconomy::CommodityId id, float stock)
+{
+	const size_t i = Index(market, id);
+	m_stock[i] = std::max(stock, 0.0f);
+	UpdatePrices(i, i + 1);
+}
+
+void CommodityMarket::Update(double dt)
+{
+	PROFILE_SCOPED()
+	// the same fraction of the way back for every cell, so the whole matrix
+	// is one straight loop over contiguous floats
+	const float recovery = m_recoveryTime > 0.0 ? float(1.0 - std::exp(-dt / m_recoveryTime)) : 1.0f;
+	float *stock = m_stock.data();
+	const float *equilibrium = m_equilibrium.data();
+	const size_t size = m_stock.size();
+	for (size_t i = 0; i < size; i++)
+		stock[i] += (equilibrium[i] - stock[i]) * recovery;
+
+	UpdatePrices(0, size);
+}
+
+void CommodityMarket::UpdatePrices(size_t first, size_t last)
+{
+	const float *stock = m_stock.data();
+	const float *equilibrium = m_equilibrium.data();
+	const float *basePrice = m_basePrice.data();
+	float *price = m_price.data();
+	const float elasticity = m_elasticity;
+	for (size_t i = first; i < last; i++) {
+		const float shortfall = (equilibrium[i] - stock[i]) / std::max(equilibrium[i], 1.0f);
+		price[i] = basePrice[i] * std::max(1.0f + elasticity * shortfall, MIN_PRICE_FACTOR);
+	}
+}
@@ -0,0 +1,72 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _COMMODITYMARKET_H
+#define _COMMODITYMARKET_H
+
+#include "RefCounted.h"
+#include "galaxy/Economy.h"
+
+#include <vector>
+
+// The stock and prices of every commodity at a number of markets, usually
+// the stations of the current system, so the market logic can step all of
+// them with one call a tick instead of one per commodity per station.
+//
+// Each quantity is a dense markets x commodities matrix, laid out a market's
+// row at a time and indexed by CommodityId. Stock drifts back towards the
+// market's equilibrium and the price follows how far it is from it.
+//
+// The market holds no state of its own worth saving: whoever sets it up
+// keeps the equilibria and restores the stock with SetStock() on load.
+class CommodityMarket : public RefCounted {
+public:
+	explicit CommodityMarket(size_t numCommodities);
+
+	// Adds a market with nothing in stock and no demand; returns its index.
+	size_t AddMarket();
+	void Clear();
+
+	size_t GetNumMarkets() const { return m_numMarkets; }
+	size_t GetNumCommodities() const { return m_numCommodities; }
+	bool IsValid(size_t market, GalacticEconomy::CommodityId id) const
+	{
+		return market < m_numMarkets && id != GalacticEconomy::InvalidCommodityId && id <= m_numCommodities;
+	}
+
+	// The stock the market settles at, and its price there.
+	void SetEquilibrium(size_t market, GalacticEconomy::CommodityId id, float stock, float price);
+	void SetStock(size_t market, GalacticEconomy::CommodityId id, float stock);
+
+	float GetStock(size_t market, GalacticEconomy::CommodityId id) const { return m_stock[Index(market, id)]; }
+	float GetPrice(size_t market, GalacticEconomy::CommodityId id) const { return m_price[Index(market, id)]; }
+	float GetEquilibriumStock(size_t market, GalacticEconomy::CommodityId id) const { return m_equilibrium[Index(market, id)]; }
+
+	// How long stock takes to get two thirds of the way back to equilibrium.
+	void SetRecoveryTime(double seconds) { m_recoveryTime = seconds; }
+	// How much the price changes as the stock runs out, or doubles.
+	void SetPriceElasticity(float elasticity) { m_elasticity = elasticity; }
+
+	// Moves every stock towards its equilibrium and reprices it.
+	void Update(double dt);
+
+private:
+	size_t Index(size_t market, GalacticEconomy::CommodityId id) const
+	{
+		assert(IsValid(market, id));
+		return market * m_numCommodities + (id - 1);
+	}
+	void UpdatePrices(size_t first, size_t last);
+
+	size_t m_numCommodities;
+	size_t m_numMarkets;
+	double m_recoveryTime;
+	float m_elasticity;
+
+	std::vector<float> m_stock;
+	std::vector<float> m_equilibrium;
+	std::vector<float> m_basePrice;
+	std::vector<float> m_price;
+};
+
+#endif /* _COMMODITYMARKET_H */
@@ -25,7 +25,9 @@
 
 #include "profiler/Profiler.h"
 
+#include <algorithm>
 #include <map>
+#include <memory>
 
 const CustomSystemsDatabase::SystemList CustomSystemsDatabase::s_emptySystemList; // see: Null Object pattern
 
@@ -432,6 +434,7 @@ static int l_csys_faction(lua_State *L)
 	CustomSystem *cs = l_csys_check(L, 1);
 
 	std::string factionName = luaL_checkstring(L, 2);
+	cs->factionName = factionName;
 	if (!s_activeCustomSystemsDatabase->GetGalaxy()->GetFactions()->IsInitialized()) {
 		s_activeCustomSystemsDatabase->GetGalaxy()->GetFactions()->RegisterCustomSystem(cs, factionName);
 		lua_settop(L, 1);
@@ -800,6 +803,12 @@ void CustomSystemsDatabase::LoadAllLuaSystems()
 {
 	PROFILE_SCOPED()
 
+	// the cache can only stand in for a pass over an empty database
+	const bool useCache = m_sectorMap.empty();
+	const std::string fingerprint = useCache ? GetLuaSourcesFingerprint() : std::string();
+	if (useCache && LoadLuaSystemsCache(fingerprint))
+		return;
+
 	assert(!s_activeCustomSystemsDatabase);
 	s_activeCustomSystemsDatabase = this;
 	lua_State *L = CreateLoaderState();
@@ -810,6 +819,205 @@ void CustomSystemsDatabase::LoadAllLuaSystems()
 	LUA_DEBUG_END(L, 0);
 	lua_close(L);
 	s_activeCustomSystemsDatabase = nullptr;
+
+	if (useCache)
+		SaveLuaSystemsCache(fingerprint);
+}
+
+// ------ Lua custom systems cache ------
+
+// bump whenever the cached fields change
+static const int LUA_SYSTEMS_CACHE_VERSION = 1;
+
+static std::string GetLuaSystemsCacheName(const std::string &customSysDir)
+{
+	return fmt::format("custom_systems_{:08x}.cache", hash_32_fnv1a(customSysDir.data(), customSysDir.size()));
+}
+
+// Every Lua file the pass would run, where it's loaded from and when it
+// was last changed, so a file which is edited, added, removed or overridden
+// by a mod invalidates the cache.
+std::string CustomSystemsDatabase::GetLuaSourcesFingerprint() const
+{
+	PROFILE_SCOPED()
+	std::string fingerprint = fmt::format("{}\n", LUA_SYSTEMS_CACHE_VERSION);
+	for (const FileSystem::FileInfo &info : FileSystem::gameDataFiles.Recurse(m_customSysDirectory)) {
+		if (!info.IsFile() || !ends_with_ci(info.GetPath(), ".lua"))
+			continue;
+		fingerprint += fmt::format("{}\t{}\t{}\n", info.GetSource().GetRoot(), info.GetPath(), info.GetModificationTime().GetTimestamp());
+	}
+	return fingerprint;
+}
+
+static void SaveCachedBody(const CustomSystem *cs, CustomSystemBody *body, Json &out)
+{
+	body->bodyData.SaveToJson(out);
+
+	Json &children = out["children"] = Json::array();
+	for (const CustomSystemBody *child : body->children) {
+		const auto it = std::find(cs->bodies.begin(), cs->bodies.end(), child);
+		children.push_back(uint32_t(it - cs->bodies.begin()));
+	}
+
+	out["wantRandOffset"] = body->want_rand_offset;
+	out["wantRandPhase"] = body->want_rand_phase;
+	out["wantRandArgPeriapsis"] = body->want_rand_arg_periapsis;
+	out["wantRandSeed"] = body->want_rand_seed;
+	out["ringStatus"] = int(body->ringStatus);
+}
+
+static void SaveCachedSystem(const CustomSystem *cs, Json &out)
+{
+	out["name"] = cs->name;
+	out["otherNames"] = cs->other_names;
+	out["numStars"] = cs->numStars;
+	out["stars"] = Json::array({ cs->primaryType[0], cs->primaryType[1], cs->primaryType[2], cs->primaryType[3] });
+	out["sector"] = Json::array({ cs->sectorX, cs->sectorY, cs->sectorZ });
+	out["pos"] = Json::array({ cs->pos.x, cs->pos.y, cs->pos.z });
+	out["seed"] = cs->seed;
+	out["wantRandSeed"] = cs->want_rand_seed;
+	out["explored"] = cs->explored;
+	out["wantRandExplored"] = cs->want_rand_explored;
+	out["faction"] = cs->factionName;
+	out["govType"] = int(cs->govType);
+	out["lawlessness"] = cs->lawlessness;
+	out["wantRandLawlessness"] = cs->want_rand_lawlessness;
+	out["shortDesc"] = cs->shortDesc;
+	out["longDesc"] = cs->longDesc;
+
+	// in the order the bodies were loaded; the primary comes first
+	Json &bodies = out["bodies"] = Json::array();
+	for (CustomSystemBody *body : cs->bodies) {
+		Json bodyObj = Json::object();
+		SaveCachedBody(cs, body, bodyObj);
+		bodies.emplace_back(std::move(bodyObj));
+	}
+}
+
+// throws for malformed entries
+static CustomSystem *LoadCachedSystem(const Json &obj)
+{
+	std::unique_ptr<CustomSystem> cs(new CustomSystem());
+	cs->name = obj["name"].get<std::string>();
+	cs->nameHash = hash_64_fnv1a(cs->name.data(), cs->name.size());
+	cs->other_names = obj["otherNames"].get<std::vector<std::string>>();
+	cs->numStars = std::min(obj["numStars"].get<unsigned>(), unsigned(COUNTOF(cs->primaryType)));
+	for (size_t i = 0; i < COUNTOF(cs->primaryType); i++)
+		cs->primaryType[i] = SystemBody::BodyType(obj["stars"].at(i).get<int>());
+	const Json &sector = obj["sector"];
+	cs->sectorX = sector.at(0).get<int>();
+	cs->sectorY = sector.at(1).get<int>();
+	cs->sectorZ = sector.at(2).get<int>();
+	const Json &pos = obj["pos"];
+	cs->pos = vector3f(pos.at(0).get<float>(), pos.at(1).get<float>(), pos.at(2).get<float>());
+	cs->seed = obj["seed"].get<uint32_t>();
+	cs->want_rand_seed = obj["wantRandSeed"].get<bool>();
+	cs->explored = obj["explored"].get<bool>();
+	cs->want_rand_explored = obj["wantRandExplored"].get<bool>();
+	cs->factionName = obj["faction"].get<std::string>();
+	cs->govType = Polit::GovType(obj["govType"].get<int>());
+	cs->lawlessness = obj["lawlessness"].get<fixed>();
+	cs->want_rand_lawlessness = obj["wantRandLawlessness"].get<bool>();
+	cs->shortDesc = obj["shortDesc"].get<std::string>();
+	cs->longDesc = obj["longDesc"].get<std::string>();
+
+	const Json &bodies = obj["bodies"];
+	if (bodies.empty())
+		return cs.release();
+
+	// the bodies are owned by their parents, and the rest by the primary
+	std::vector<std::unique_ptr<CustomSystemBody>> owned;
+	for (const Json &bodyObj : bodies) {
+		owned.emplace_back(new CustomSystemBody());
+		CustomSystemBody *body = owned.back().get();
+		body->bodyData.LoadFromJson(bodyObj);
+		body->want_rand_offset = bodyObj["wantRandOffset"].get<bool>();
+		body->want_rand_phase = bodyObj["wantRandPhase"].get<bool>();
+		body->want_rand_arg_periapsis = bodyObj["wantRandArgPeriapsis"].get<bool>();
+		body->want_rand_seed = bodyObj["wantRandSeed"].get<bool>();
+		body->ringStatus = CustomSystemBody::RingStatus(bodyObj["ringStatus"].get<int>());
+		cs->bodies.push_back(body);
+	}
+	for (size_t i = 0; i < bodies.size(); i++) {
+		for (const Json &childIndex : bodies[i]["children"]) {
+			const uint32_t child = childIndex.get<uint32_t>();
+			// bodies are in depth first order, and every body but the
+			// primary has exactly one parent
+			if (child <= i || child >= owned.size() || !owned[child])
+				throw std::runtime_error("bad child index");
+			cs->bodies[i]->children.push_back(owned[child].release());
+		}
+	}
+	cs->sBody = owned[0].release();
+	for (const std::unique_ptr<CustomSystemBody> &orphan : owned)
+		if (orphan)
+			throw std::runtime_error("orphaned body");
+	return cs.release();
+}
+
+bool CustomSystemsDatabase::LoadLuaSystemsCache(const std::string &fingerprint)
+{
+	PROFILE_SCOPED()
+	RefCountedPtr<FileSystem::FileData> file = FileSystem::userFiles.ReadFile(GetLuaSystemsCacheName(m_customSysDirectory));
+	if (!file)
+		return false;
+
+	std::vector<CustomSystem *> systems;
+	try {
+		const Json cache = Json::from_cbor(lz4::DecompressLZ4(file->AsStringView()));
+		if (cache["fingerprint"].get<std::string>() != fingerprint)
+			return false;
+
+		for (const Json &systemObj : cache["systems"])
+			systems.push_back(LoadCachedSystem(systemObj));
+	} catch (const std::exception &e) {
+		Log::Warning("Ignoring the custom systems cache: {}\n", e.what());
+		for (CustomSystem *cs : systems)
+			delete cs;
+		return false;
+	}
+
+	Output("Loaded %zu custom systems from the cache\n", systems.size());
+	for (CustomSystem *cs : systems) {
+		if (!cs->factionName.empty())
+			GetGalaxy()->GetFactions()->RegisterCustomSystem(cs, cs->factionName);
+		AddCustomSystem(SystemPath(cs->sectorX, cs->sectorY, cs->sectorZ), cs);
+	}
+	return true;
+}
+
+void CustomSystemsDatabase::SaveLuaSystemsCache(const std::string &fingerprint)
+{
+	PROFILE_SCOPED()
+	Json cache = Json::object();
+	cache["fingerprint"] = fingerprint;
+	// each sector's systems in order, so they get the same indices back
+	Json &systems = cache["systems"] = Json::array();
+	for (const auto &sector : m_sectorMap) {
+		for (const CustomSystem *cs : sector.second) {
+			Json systemObj = Json::object();
+			SaveCachedSystem(cs, systemObj);
+			systems.emplace_back(std::move(systemObj));
+		}
+	}
+
+	std::string data;
+	try {
+		const std::vector<uint8_t> cbor = Json::to_cbor(cache);
+		data = lz4::CompressLZ4(std::string_view(reinterpret_cast<const char *>(cbor.data()), cbor.size()), 0);
+	} catch (const lz4::CompressionFailedException &e) {
+		Log::Warning("Could not compress the custom systems cache: {}\n", e.what());
+		return;
+	}
+
+	const std::string fileName = GetLuaSystemsCacheName(m_customSysDirectory);
+	FILE *f = FileSystem::userFiles.OpenWriteStream(fileName);
+	if (!f)
+		return;
+	const bool written = fwrite(data.data(), data.size(), 1, f) == 1;
+	fclose(f);
+	if (!written)
+		FileSystem::userFiles.RemoveFile(fileName);
 }
 
 const CustomSystem *CustomSystemsDatabase::LoadSystem(std::string_view filepath)
@@ -854,6 +1062,7 @@ CustomSystem *CustomSystemsDatabase::LoadSystemFromJSON(std::string_view filenam
 
 		// Set system faction pointer
 		auto factionName = systemdef.value<std::string>("faction", "");
+		sys->factionName = factionName;
 		if (!factionName.empty()) {
 			if (!GetGalaxy()->GetFactions()->IsInitialized()) {
 				GetGalaxy()->GetFactions()->RegisterCustomSystem(sys, factionName);
@@ -74,6 +74,7 @@ public:
 	bool want_rand_explored;
 	bool explored;
 	const Faction *faction;
+	std::string factionName; // faction is only resolved once factions are loaded
 	Polit::GovType govType;
 	bool want_rand_lawlessness;
 	fixed lawlessness; // 0.0 = lawful, 1.0 = totally lawless
@@ -112,6 +113,12 @@ public:
 	void RunLuaSystemSanityChecks(CustomSystem *csys);
 
 private:
+	// The systems from the Lua pass are cached in the user directory, and
+	// the pass is skipped while none of the Lua files have changed.
+	std::string GetLuaSourcesFingerprint() const;
+	bool LoadLuaSystemsCache(const std::string &fingerprint);
+	void SaveLuaSystemsCache(const std::string &fingerprint);
+
 	typedef std::map<SystemPath, SystemList> SectorMap;
 	typedef std::pair<SystemPath, size_t> SystemIndex;
 
@@ -517,6 +517,7 @@ void FactionsDatabase::SetHomeSectors()
 	for (auto it = m_factions.begin(); it != m_factions.end(); ++it)
 		if ((*it)->hasHomeworld)
 			(*it)->m_homesector = m_galaxy->GetSector((*it)->homeworld);
+	m_claimGrid.Build(m_factions, &m_no_faction);
 	m_may_assign_factions = true;
 }
 
@@ -543,7 +544,7 @@ void FactionsDatabase::AddFaction(Faction *faction)
 		}
 		m_missingFactionsMap.erase(it);
 	}
-	m_spatial_index.Add(faction);
+	m_claimGrid.Clear();
 
 	if (faction->hasHomeworld) m_homesystems.insert(faction->homeworld.SystemOnly());
 	faction->idx = m_factions.size() - 1;
@@ -588,15 +589,17 @@ const Faction *FactionsDatabase::GetNearestClaimant(const Sector::System *sys) c
 	}
 
 	// if it didn't, or it wasn't a custom StarStystem, then we go ahead and assign it a faction allegiance like normal below...
+	if (m_claimGrid.IsBuilt())
+		return m_claimGrid.GetFaction(sys);
+
+	// until the homeworlds are known every faction has to be checked
 	const Faction *result = &m_no_faction;
 	double closestFactionDist = HUGE_VAL;
-	ConstFactionList &candidates = m_spatial_index.CandidateFactions(sys);
-
-	for (ConstFactionIterator it = candidates.begin(); it != candidates.end(); ++it) {
-		if ((*it)->IsClaimed(sys->GetPath()))
-			return *it; // this is a very specific claim, no further checks for distance from another factions homeworld is needed.
-		if ((*it)->IsCloserAndContains(closestFactionDist, sys))
-			result = *it;
+	for (const Faction *faction : m_factions) {
+		if (faction->IsClaimed(sys->GetPath()))
+			return faction; // this is a very specific claim, no further checks for distance from another factions homeworld is needed.
+		if (faction->IsCloserAndContains(closestFactionDist, sys))
+			result = faction;
 	}
 	return result;
 }
@@ -794,92 +797,177 @@ Faction::Faction(Galaxy *galaxy) :
 
 // ------ Factions Spatial Indexing ------
 
-void FactionsDatabase::Octsapling::Add(const Faction *faction)
-{
-	/*  The general principle here is to put the faction in every octbox cell that a system
-	    that is a member of that faction could be in. This should let us cut the number
-		of factions that have to be checked by GetNearestFaction, by eliminating right off
-		all the those Factions that aren't in the same cell.
+// systems may sit a little outside their sector's box, and distances are
+// measured in floats, so the tests for whole sectors leave some room
+static const float CLAIM_GRID_MARGIN = 1.0f;
+// more sectors than this and GetNearestClaimant() checks every faction instead
+static const size_t MAX_CLAIM_GRID_CELLS = 1 << 22;
 
-		As I'm just going for the quick performance win, I'm being very sloppy and
-		treating a Faction as if it was a cube rather than a sphere. I'm also not even
-		attempting to work out real faction boundaries for this.
+void FactionsDatabase::ClaimGrid::Clear()
+{
+	m_built = false;
+	m_unclaimedFaction = nullptr;
+	m_cells.clear();
+	m_candidates.clear();
+	m_claims.clear();
+}
 
-		Obviously this all could be improved even without this Octsapling growing into
-		a full Octree.
+void FactionsDatabase::ClaimGrid::Build(const std::vector<Faction *> &factions, const Faction *noFaction)
+{
+	PROFILE_SCOPED()
+	Clear();
+	m_unclaimedFaction = noFaction;
+
+	std::vector<Candidate> homed;
+	Sint32 max[3];
+	for (int i = 0; i < 3; i++) {
+		m_min[i] = INT32_MAX;
+		max[i] = INT32_MIN;
+	}
 
-		This part happens at faction generation time so shouldn't be too performance
-		critical
-	*/
-	RefCountedPtr<const Sector> sec = faction->GetHomeSector();
+	for (const Faction *faction : factions) {
+		for (const SystemPath &claim : faction->m_ownedsystemlist)
+			m_claims[claim.SectorOnly()].emplace_back(claim.systemIndex, faction);
+
+		RefCountedPtr<const Sector> sec;
+		if (faction->hasHomeworld)
+			sec = faction->GetHomeSector();
+		if (!sec || faction->homeworld.systemIndex >= sec->m_systems.size()) {
+			/* these are of effectively infinite radius but infinitely far away,
+			   so the last of them gets whatever no other faction does */
+			m_unclaimedFaction = faction;
+			continue;
+		}
 
-	/* only factions with homeworlds that are available at faction generation time can
-	   be added to specific cells...
-	*/
-	if (faction->hasHomeworld && (faction->homeworld.systemIndex < sec->m_systems.size())) {
-		/* calculate potential indexes for the octbox cells the faction needs to go into
-		*/
-		Sector::System sys = sec->m_systems[faction->homeworld.systemIndex];
+		const Sector::System &home = sec->m_systems[faction->homeworld.systemIndex];
+		homed.push_back({ faction, home.sx, home.sy, home.sz, home.GetPosition(), faction->Radius() });
 
-		int xmin = BoxIndex(Sint32(sys.GetFullPosition().x - float((faction->Radius()))));
-		int xmax = BoxIndex(Sint32(sys.GetFullPosition().x + float((faction->Radius()))));
-		int ymin = BoxIndex(Sint32(sys.GetFullPosition().y - float((faction->Radius()))));
-		int ymax = BoxIndex(Sint32(sys.GetFullPosition().y + float((faction->Radius()))));
-		int zmin = BoxIndex(Sint32(sys.GetFullPosition().z - float((faction->Radius()))));
-		int zmax = BoxIndex(Sint32(sys.GetFullPosition().z + float((faction->Radius()))));
+		const vector3f full = home.GetFullPosition();
+		const float reach = float(faction->Radius()) + CLAIM_GRID_MARGIN;
+		for (int i = 0; i < 3; i++) {
+			m_min[i] = std::min(m_min[i], Sint32(std::floor((full[i] - reach) / Sector::SIZE)));
+			max[i] = std::max(max[i], Sint32(std::floor((full[i] + reach) / Sector::SIZE)));
+		}
+	}
 
-		/* put the faction in all the octbox cells needed in a hideously inexact way that
-		   will generate duplicates in each cell in many cases
-		*/
-		octbox[xmin][ymin][zmin].push_back(faction); // 0,0,0
-		octbox[xmax][ymin][zmin].push_back(faction); // 1,0,0
-		octbox[xmax][ymax][zmin].push_back(faction); // 1,1,0
-		octbox[xmax][ymax][zmax].push_back(faction); // 1,1,1
+	m_built = true;
+	if (homed.empty()) {
+		m_size[0] = m_size[1] = m_size[2] = 0;
+		return;
+	}
 
-		octbox[xmin][ymax][zmin].push_back(faction); // 0,1,0
-		octbox[xmin][ymax][zmax].push_back(faction); // 0,1,1
-		octbox[xmin][ymin][zmax].push_back(faction); // 0,0,1
-		octbox[xmax][ymin][zmax].push_back(faction); // 1,0,1
+	size_t numCells = 1;
+	for (int i = 0; i < 3; i++) {
+		m_size[i] = max[i] - m_min[i] + 1;
+		numCells *= size_t(m_size[i]);
+	}
+	if (numCells > MAX_CLAIM_GRID_CELLS) {
+		Log::Warning("Faction territory covers {} sectors, too many to index\n", numCells);
+		Clear();
+		return;
+	}
 
-		/* prune any duplicates from the octbox cells making things slightly saner
-		*/
-		PruneDuplicates(0, 0, 0);
-		PruneDuplicates(1, 0, 0);
-		PruneDuplicates(1, 1, 0);
-		PruneDuplicates(1, 1, 1);
+	m_cells.resize(numCells);
+	struct Extent {
+		float nearest, furthest;
+	};
+	std::vector<Extent> extents(homed.size());
+	std::vector<Uint32> crossing;
+	crossing.reserve(homed.size());
+
+	Cell *cell = m_cells.data();
+	for (Sint32 sz = m_min[2]; sz <= max[2]; sz++) {
+		for (Sint32 sy = m_min[1]; sy <= max[1]; sy++) {
+			for (Sint32 sx = m_min[0]; sx <= max[0]; sx++, cell++) {
+				const vector3f boxMin = Sector::SIZE * vector3f(float(sx), float(sy), float(sz)) - vector3f(CLAIM_GRID_MARGIN);
+				const vector3f boxMax = boxMin + vector3f(Sector::SIZE + 2.0f * CLAIM_GRID_MARGIN);
+
+				cell->owner = nullptr;
+				crossing.clear();
+				for (Uint32 c = 0; c < homed.size(); c++) {
+					const Candidate &cand = homed[c];
+					// every system in a homeworld's sector is the faction's
+					if (cand.sx == sx && cand.sy == sy && cand.sz == sz) {
+						cell->owner = cand.faction;
+						continue;
+					}
 
-		PruneDuplicates(0, 1, 0);
-		PruneDuplicates(0, 1, 1);
-		PruneDuplicates(0, 0, 1);
-		PruneDuplicates(1, 0, 1);
+					const vector3f home = Sector::SIZE * vector3f(float(cand.sx), float(cand.sy), float(cand.sz)) + cand.pos;
+					vector3f nearest, furthest;
+					for (int i = 0; i < 3; i++) {
+						nearest[i] = std::max(std::max(boxMin[i] - home[i], 0.0f), home[i] - boxMax[i]);
+						furthest[i] = std::max(std::abs(boxMin[i] - home[i]), std::abs(boxMax[i] - home[i]));
+					}
+					extents[c] = { nearest.Length(), furthest.Length() };
+					if (extents[c].nearest < cand.radius)
+						crossing.push_back(c);
+				}
+				// the last faction with its homeworld here wins the ties at zero
+				if (cell->owner)
+					continue;
+				if (crossing.empty()) {
+					cell->owner = m_unclaimedFaction;
+					continue;
+				}
 
-	} else {
-		/* ...other factions, such as ones with no homeworlds, and more annoyingly ones
-	   whose homeworlds don't exist yet because they're custom systems have to go in
-	   *every* octbox cell
-	*/
-		octbox[0][0][0].push_back(faction);
-		octbox[1][0][0].push_back(faction);
-		octbox[1][1][0].push_back(faction);
-		octbox[1][1][1].push_back(faction);
+				/* a faction which takes in the whole sector, and whose homeworld is
+				   nearer to all of it than any other's border reaches, owns it */
+				Uint32 best = crossing[0];
+				for (Uint32 c : crossing)
+					if (extents[c].furthest < extents[best].furthest)
+						best = c;
+				bool owned = extents[best].furthest < homed[best].radius;
+				for (Uint32 c : crossing)
+					if (c != best && extents[c].nearest <= extents[best].furthest)
+						owned = false;
+				if (owned) {
+					cell->owner = homed[best].faction;
+					continue;
+				}
 
-		octbox[0][1][0].push_back(faction);
-		octbox[0][1][1].push_back(faction);
-		octbox[0][0][1].push_back(faction);
-		octbox[1][0][1].push_back(faction);
+				cell->firstCandidate = m_candidates.size();
+				cell->numCandidates = crossing.size();
+				for (Uint32 c : crossing)
+					m_candidates.push_back(homed[c]);
+			}
+		}
 	}
+	Output("Faction claim grid: %zu sectors, %zu candidates\n", m_cells.size(), m_candidates.size());
 }
 
-void FactionsDatabase::Octsapling::PruneDuplicates(const int bx, const int by, const int bz)
+const Faction *FactionsDatabase::ClaimGrid::GetFaction(const Sector::System *sys) const
 {
-	octbox[bx][by][bz].erase(std::unique(octbox[bx][by][bz].begin(), octbox[bx][by][bz].end()), octbox[bx][by][bz].end());
-}
+	assert(m_built);
+	if (!m_claims.empty()) {
+		auto it = m_claims.find(SystemPath(sys->sx, sys->sy, sys->sz));
+		if (it != m_claims.end()) {
+			const Sint32 systemIndex = Sint32(sys->idx);
+			for (const auto &claim : it->second)
+				if (claim.first == -99 || claim.first == systemIndex)
+					return claim.second; // this is a very specific claim, no further checks for distance from another factions homeworld is needed.
+		}
+	}
 
-const std::vector<const Faction *> &FactionsDatabase::Octsapling::CandidateFactions(const Sector::System *sys) const
-{
-	/* answer the factions that we've put in the same octobox cell as the one the
-	   system would go in. This part happens every time we do GetNearest faction
-	   so *is* performance criticale.e
-	*/
-	return octbox[BoxIndex(sys->sx)][BoxIndex(sys->sy)][BoxIndex(sys->sz)];
+	const Sint32 x = sys->sx - m_min[0], y = sys->sy - m_min[1], z = sys->sz - m_min[2];
+	if (x < 0 || y < 0 || z < 0 || x >= m_size[0] || y >= m_size[1] || z >= m_size[2])
+		return m_unclaimedFaction;
+
+	const Cell &cell = m_cells[(size_t(z) * m_size[1] + y) * m_size[0] + x];
+	if (cell.owner)
+		return cell.owner;
+
+	// the system is near a border, so it goes to the nearest homeworld it's inside
+	const Faction *result = m_unclaimedFaction;
+	float closestFactionDist = HUGE_VAL;
+	const Candidate *cand = &m_candidates[cell.firstCandidate];
+	for (Uint32 i = 0; i < cell.numCandidates; i++, cand++) {
+		vector3f dv = cand->pos - sys->GetPosition();
+		dv += Sector::SIZE * vector3f(float(cand->sx - sys->sx), float(cand->sy - sys->sy), float(cand->sz - sys->sz));
+		const float distance = dv.Length();
+		if (distance < cand->radius && distance <= closestFactionDist) {
+			closestFactionDist = distance;
+			result = cand->faction;
+		}
+	}
+	return result;
 }
@@ -6,6 +6,7 @@
 
 #include "DeleteEmitter.h"
 #include "Polit.h"
+#include "core/FlatHashMap.h"
 #include "fixed.h"
 #include "galaxy/Economy.h"
 #include "galaxy/Sector.h"
@@ -79,11 +80,6 @@ private:
 	bool IsCloserAndContains(double &closestFactionDist, const Sector::System *sys) const;
 };
 
-/* One day it might grow up to become a full tree, on the  other hand it might be
-   cut down before it's full growth to be replaced by
-   a proper spatial data structure.
-*/
-
 class FactionsDatabase {
 public:
 	FactionsDatabase(Galaxy *galaxy, const std::string &factionDir) :
@@ -112,15 +108,43 @@ public:
 	bool MayAssignFactions() const;
 
 private:
-	class Octsapling {
+	/* Which faction each sector belongs to, worked out once the homeworlds are
+	   known. Most sectors lie wholly inside one faction's borders, or outside
+	   all of them, and answer straight away; the rest keep the few factions
+	   whose borders cross them, so only those are measured for each system.
+	*/
+	class ClaimGrid {
 	public:
-		void Add(const Faction *faction);
-		const std::vector<const Faction *> &CandidateFactions(const Sector::System *sys) const;
+		void Build(const std::vector<Faction *> &factions, const Faction *noFaction);
+		void Clear();
+		bool IsBuilt() const { return m_built; }
+
+		const Faction *GetFaction(const Sector::System *sys) const;
 
 	private:
-		std::vector<const Faction *> octbox[2][2][2];
-		static int BoxIndex(Sint32 sectorIndex) { return sectorIndex < 0 ? 0 : 1; };
-		void PruneDuplicates(const int bx, const int by, const int bz);
+		struct Candidate {
+			const Faction *faction;
+			Sint32 sx, sy, sz; // homeworld sector
+			vector3f pos;	   // homeworld position within the sector
+			double radius;
+		};
+
+		struct Cell {
+			const Faction *owner; // of every system in the sector, or null to check candidates
+			Uint32 firstCandidate;
+			Uint32 numCandidates;
+		};
+
+		typedef std::vector<std::pair<Sint32, const Faction *>> ClaimList;
+
+		bool m_built = false;
+		// factions with no homeworld get whatever nobody else claims
+		const Faction *m_unclaimedFaction = nullptr;
+		Sint32 m_min[3], m_size[3];
+		std::vector<Cell> m_cells;
+		std::vector<Candidate> m_candidates;
+		// explicit claims by sector, in faction order; -99 for the whole sector
+		FlatHashMap<SystemPath, ClaimList, SystemPath::HashSectorOnly, SystemPath::EqualSectorOnly> m_claims;
 	};
 
 	typedef std::vector<Faction *> FactionList;
@@ -140,7 +164,7 @@ private:
 	FactionList m_factions;
 	FactionMap m_factions_byName;
 	HomeSystemSet m_homesystems;
-	Octsapling m_spatial_index;
+	ClaimGrid m_claimGrid;
 	bool m_may_assign_factions;
 	bool m_initialized = false;
 	MissingFactionsMap m_missingFactionsMap;
@@ -23,6 +23,7 @@ Galaxy::Galaxy(RefCountedPtr<GalaxyGenerator> galaxyGenerator, float radius, flo
 	m_galaxyGenerator(galaxyGenerator),
 	m_sectorCache(this),
 	m_starSystemCache(this),
+	m_spatialIndex(this),
 	m_factions(this, factionsDir),
 	m_customSystems(this, customSysDir)
 {
@@ -82,6 +83,7 @@ void Galaxy::Init()
 void Galaxy::FlushCaches()
 {
 	m_factions.ClearCache();
+	m_spatialIndex.Clear();
 	m_starSystemCache.OutputCacheStatistics();
 	m_starSystemCache.ClearCache();
 	m_sectorCache.OutputCacheStatistics();
@@ -7,9 +7,11 @@
 #include "CustomSystem.h"
 #include "Factions.h"
 #include "GalaxyCache.h"
+#include "GalaxySpatialIndex.h"
 #include "JsonFwd.h"
 #include "PerfStats.h"
 #include "RefCounted.h"
+#include "StarSystem.h"
 #include <cstdio>
 
 struct SDL_Surface;
@@ -45,8 +47,17 @@ public:
 	RefCountedPtr<SectorCache::Slave> NewSectorSlaveCache() { return m_sectorCache.NewSlaveCache(); }
 
 	RefCountedPtr<StarSystem> GetStarSystem(const SystemPath &path) { return m_starSystemCache.GetCached(path); }
+	// For callers only needing part of the system, e.g. its stars; the rest
+	// of it is generated if it's asked for later.
+	RefCountedPtr<StarSystem> GetStarSystem(const SystemPath &path, StarSystem::GenerationLevel level) { return m_starSystemCache.GetCached(path, level); }
 	RefCountedPtr<StarSystemCache::Slave> NewStarSystemSlaveCache() { return m_starSystemCache.NewSlaveCache(); }
 
+	const SectorCache &GetSectorCache() const { return m_sectorCache; }
+	const StarSystemCache &GetStarSystemCache() const { return m_starSystemCache; }
+
+	// for range and nearest system queries
+	GalaxySpatialIndex &GetSpatialIndex() { return m_spatialIndex; }
+
 	void FlushCaches();
 	void Dump(FILE *file, Sint32 centerX, Sint32 centerY, Sint32 centerZ, Sint32 radius);
 
@@ -63,6 +74,7 @@ private:
 	RefCountedPtr<GalaxyGenerator> m_galaxyGenerator;
 	SectorCache m_sectorCache;
 	StarSystemCache m_starSystemCache;
+	GalaxySpatialIndex m_spatialIndex;
 	FactionsDatabase m_factions;
 	CustomSystemsDatabase m_customSystems;
 };
@@ -4,48 +4,76 @@
 #include "galaxy/GalaxyCache.h"
 
 #include "Game.h"
+#include "GameConfig.h"
 #include "Pi.h"
 #include "galaxy/Galaxy.h"
 #include "galaxy/GalaxyGenerator.h"
 #include "galaxy/Sector.h"
 #include "galaxy/StarSystem.h"
 #include "core/Log.h"
+#include "core/StringUtils.h"
+#include "core/TaskGraph.h"
 #include "profiler/Profiler.h"
+#include <algorithm>
 #include <utility>
 
 //#define DEBUG_CACHE
 
+// sectors generated by each subtask of a SectorCache fill
+static const uint32_t SECTOR_GENERATION_GRAIN_SIZE = 8;
+// and star systems by each subtask of a StarSystemCache fill
+static const uint32_t STAR_SYSTEM_GENERATION_GRAIN_SIZE = 4;
+
+// default retained memory budget of each cache, in MB
+static const int DEFAULT_CACHE_BUDGET_MB = 64;
+
+template <typename T, typename CompareT>
+GalaxyObjectCache<T, CompareT>::GalaxyObjectCache(Galaxy *galaxy) :
+	m_galaxy(galaxy),
+	m_lruBytes(0),
+	m_cacheHits(0),
+	m_cacheHitsSlave(0),
+	m_cacheMisses(0),
+	m_cacheEvictions(0)
+{
+	const int budgetMB = Pi::config ? Pi::config->Int(CACHE_NAME + "BudgetMB", DEFAULT_CACHE_BUDGET_MB) : DEFAULT_CACHE_BUDGET_MB;
+	m_budgetBytes = size_t(std::max(budgetMB, 0)) * 1024 * 1024;
+}
+
 //virtual
 
 template <typename T, typename CompareT>
 GalaxyObjectCache<T, CompareT>::~GalaxyObjectCache()
 {
+	ClearRetained();
 	for (Slave *s : m_slaves)
 		s->MasterDeleted();
 	assert(m_attic.empty()); // otherwise the objects will deregister at a cache that no longer exists
 }
 
 template <typename T, typename CompareT>
-void GalaxyObjectCache<T, CompareT>::AddToCache(std::vector<RefCountedPtr<T>> &objects)
+void GalaxyObjectCache<T, CompareT>::AddToCache(std::vector<RefCountedPtr<T>> &objects, int level)
 {
 	PROFILE_SCOPED()
 	for (auto it = objects.begin(), itEnd = objects.end(); it != itEnd; ++it) {
 		auto inserted = m_attic.insert(std::make_pair(it->Get()->GetPath(), it->Get()));
-		if (!inserted.second) {
+		if (!inserted.second)
 			it->Reset(inserted.first->second);
-		} else {
+		else
 			(*it)->SetCache(this);
-		}
+		Realise(it->Get(), level);
+		Touch(it->Get());
 	}
 }
 
 template <typename T, typename CompareT>
-RefCountedPtr<T> GalaxyObjectCache<T, CompareT>::GetIfCached(const SystemPath &path)
+RefCountedPtr<T> GalaxyObjectCache<T, CompareT>::GetIfCached(const SystemPath &path, int level)
 {
 	RefCountedPtr<T> s;
 	typename AtticMap::iterator i = m_attic.find(path);
 	if (i != m_attic.end()) {
 		s.Reset(i->second);
+		Realise(s.Get(), level);
 	}
 
 	return s;
@@ -54,17 +82,39 @@ RefCountedPtr<T> GalaxyObjectCache<T, CompareT>::GetIfCached(const SystemPath &p
 template <typename T, typename CompareT>
 RefCountedPtr<T> GalaxyObjectCache<T, CompareT>::GetCached(const SystemPath &path)
 {
-	RefCountedPtr<T> s = this->GetIfCached(path);
-	if (!s) {
+	return GetCached(path, LEVEL_COMPLETE);
+}
+
+template <typename T, typename CompareT>
+RefCountedPtr<T> GalaxyObjectCache<T, CompareT>::GetCached(const SystemPath &path, int level)
+{
+	RefCountedPtr<T> s;
+	typename AtticMap::iterator i = m_attic.find(path);
+	if (i == m_attic.end()) {
 		++m_cacheMisses;
-		s = m_galaxy->GetGenerator()->Generate<T, GalaxyObjectCache<T, CompareT>>(RefCountedPtr<Galaxy>(m_galaxy), path, this);
+		s = Generate(path, level);
 		m_attic.insert(std::make_pair(path, s.Get()));
 	} else {
 		++m_cacheHits;
+		s.Reset(i->second);
+		Realise(s.Get(), level);
 	}
+	Touch(s.Get());
 	return s;
 }
 
+// Objects generated all at once; StarSystemCache specialises these
+template <typename T, typename CompareT>
+RefCountedPtr<T> GalaxyObjectCache<T, CompareT>::Generate(const SystemPath &path, int level)
+{
+	return m_galaxy->GetGenerator()->Generate<T, GalaxyObjectCache<T, CompareT>>(RefCountedPtr<Galaxy>(m_galaxy), path, this);
+}
+
+template <typename T, typename CompareT>
+void GalaxyObjectCache<T, CompareT>::Realise(T *object, int level)
+{
+}
+
 template <typename T, typename CompareT>
 bool GalaxyObjectCache<T, CompareT>::HasCached(const SystemPath &path) const
 {
@@ -79,19 +129,84 @@ void GalaxyObjectCache<T, CompareT>::RemoveFromAttic(const SystemPath &path)
 	m_attic.erase(path);
 }
 
+template <typename T, typename CompareT>
+void GalaxyObjectCache<T, CompareT>::Touch(T *object)
+{
+	const SystemPath path = object->GetPath();
+	auto found = m_lruIndex.find(path);
+	if (found != m_lruIndex.end()) {
+		m_lru.splice(m_lru.begin(), m_lru, found->second);
+		return;
+	}
+
+	const size_t size = object->GetMemoryUsage();
+	m_lru.emplace_front(RefCountedPtr<T>(object), size);
+	m_lruIndex.insert(std::make_pair(path, m_lru.begin()));
+	m_lruBytes += size;
+
+	// always keep the object just asked for
+	while (m_lruBytes > m_budgetBytes && m_lru.size() > 1) {
+		auto &last = m_lru.back();
+		m_lruIndex.erase(last.first->GetPath());
+		m_lruBytes -= last.second;
+		++m_cacheEvictions;
+		// the object stays in the attic for as long as anything else uses it
+		m_lru.pop_back();
+	}
+}
+
+template <typename T, typename CompareT>
+void GalaxyObjectCache<T, CompareT>::UpdateRetainedSize(T *object)
+{
+	auto found = m_lruIndex.find(object->GetPath());
+	if (found == m_lruIndex.end())
+		return;
+	const size_t size = object->GetMemoryUsage();
+	m_lruBytes = m_lruBytes - found->second->second + size;
+	found->second->second = size;
+}
+
+template <typename T, typename CompareT>
+void GalaxyObjectCache<T, CompareT>::ClearRetained()
+{
+	// objects removing themselves from the attic mustn't see a half cleared list
+	LruList retained;
+	retained.swap(m_lru);
+	m_lruIndex.clear();
+	m_lruBytes = 0;
+}
+
 template <typename T, typename CompareT>
 void GalaxyObjectCache<T, CompareT>::ClearCache()
 {
+	ClearRetained();
 	for (auto it = m_slaves.begin(), itEnd = m_slaves.end(); it != itEnd; ++it)
 		(*it)->ClearCache();
 }
 
+template <typename T, typename CompareT>
+typename GalaxyObjectCache<T, CompareT>::Statistics GalaxyObjectCache<T, CompareT>::GetStatistics() const
+{
+	Statistics stats;
+	stats.hits = m_cacheHits;
+	stats.slaveHits = m_cacheHitsSlave;
+	stats.misses = m_cacheMisses;
+	stats.evictions = m_cacheEvictions;
+	stats.numObjects = m_attic.size();
+	stats.numRetained = m_lru.size();
+	stats.retainedBytes = m_lruBytes;
+	stats.budgetBytes = m_budgetBytes;
+	return stats;
+}
+
 template <typename T, typename CompareT>
 void GalaxyObjectCache<T, CompareT>::OutputCacheStatistics(bool reset)
 {
-	Output("%s: misses: %llu, slave hits: %llu, master hits: %llu\n", CACHE_NAME.c_str(), m_cacheMisses, m_cacheHitsSlave, m_cacheHits);
+	Output("%s: misses: %llu, slave hits: %llu, master hits: %llu, evictions: %llu, retained: " SIZET_FMT " of " SIZET_FMT " objects (%.1f of %.1f MB)\n",
+		CACHE_NAME.c_str(), m_cacheMisses, m_cacheHitsSlave, m_cacheHits, m_cacheEvictions, m_lru.size(), m_attic.size(),
+		m_lruBytes / (1024.0 * 1024.0), m_budgetBytes / (1024.0 * 1024.0));
 	if (reset)
-		m_cacheMisses = m_cacheHitsSlave = m_cacheHits = 0;
+		m_cacheMisses = m_cacheHitsSlave = m_cacheHits = m_cacheEvictions = 0;
 }
 
 template <typename T, typename CompareT>
@@ -131,8 +246,10 @@ RefCountedPtr<T> GalaxyObjectCache<T, CompareT>::Slave::GetCached(const SystemPa
 
 	typename CacheMap::iterator i = m_cache.find(path);
 	if (i != m_cache.end()) {
-		if (m_master)
+		if (m_master) {
 			++m_master->m_cacheHitsSlave;
+			m_master->Touch(i->second.Get());
+		}
 		return (*i).second;
 	}
 
@@ -168,10 +285,10 @@ GalaxyObjectCache<T, CompareT>::Slave::~Slave()
 }
 
 template <typename T, typename CompareT>
-void GalaxyObjectCache<T, CompareT>::Slave::AddToCache(std::vector<RefCountedPtr<T>> &objects)
+void GalaxyObjectCache<T, CompareT>::Slave::AddToCache(std::vector<RefCountedPtr<T>> &objects, int level)
 {
 	if (m_master) {
-		m_master->AddToCache(objects); // This modifies the vector to the sectors already in the master cache
+		m_master->AddToCache(objects, level); // This modifies the vector to the sectors already in the master cache
 		for (auto it = objects.begin(), itEnd = objects.end(); it != itEnd; ++it) {
 			m_cache.insert(std::make_pair(it->Get()->GetPath(), *it));
 		}
@@ -180,7 +297,7 @@ void GalaxyObjectCache<T, CompareT>::Slave::AddToCache(std::vector<RefCountedPtr
 
 template <typename T, typename CompareT>
 void GalaxyObjectCache<T, CompareT>::Slave::FillCache(const typename GalaxyObjectCache<T, CompareT>::PathVector &paths,
-	typename GalaxyObjectCache<T, CompareT>::CacheFilledCallback callback)
+	typename GalaxyObjectCache<T, CompareT>::CacheFilledCallback callback, int level)
 {
 	// allocate some space for what we're about to chunk up
 	std::vector<std::unique_ptr<PathVector>> vec_paths;
@@ -194,7 +311,7 @@ void GalaxyObjectCache<T, CompareT>::Slave::FillCache(const typename GalaxyObjec
 
 	// chop the paths into groups of CACHE_JOB_SIZE
 	for (auto it = paths.begin(), itEnd = paths.end(); it != itEnd; ++it) {
-		RefCountedPtr<T> s = m_master->GetIfCached(*it);
+		RefCountedPtr<T> s = m_master->GetIfCached(*it, level);
 		if (s) {
 			m_cache[*it] = s;
 #ifdef DEBUG_CACHE
@@ -231,16 +348,17 @@ void GalaxyObjectCache<T, CompareT>::Slave::FillCache(const typename GalaxyObjec
 	} else {
 		// now add the batched jobs
 		for (auto it = vec_paths.begin(), itEnd = vec_paths.end(); it != itEnd; ++it)
-			m_jobs.Order(new GalaxyObjectCache<T, CompareT>::CacheJob(std::move(*it), this, m_galaxy, callback));
+			m_jobs.Order(new GalaxyObjectCache<T, CompareT>::CacheJob(std::move(*it), this, m_galaxy, level, callback));
 	}
 }
 
 template <typename T, typename CompareT>
 GalaxyObjectCache<T, CompareT>::CacheJob::CacheJob(std::unique_ptr<std::vector<SystemPath>> path,
-	typename GalaxyObjectCache<T, CompareT>::Slave *slaveCache, RefCountedPtr<Galaxy> galaxy,
+	typename GalaxyObjectCache<T, CompareT>::Slave *slaveCache, RefCountedPtr<Galaxy> galaxy, int level,
 	typename GalaxyObjectCache<T, CompareT>::CacheFilledCallback callback) :
-	Job(),
+	Job(PRIORITY_LOW),
 	m_paths(std::move(path)),
+	m_level(level),
 	m_slaveCache(slaveCache),
 	m_galaxy(galaxy),
 	m_galaxyGenerator(galaxy->GetGenerator()),
@@ -263,7 +381,7 @@ template <typename T, typename CompareT>
 void GalaxyObjectCache<T, CompareT>::CacheJob::OnFinish() // runs in primary thread of the context
 {
 	PROFILE_SCOPED()
-	m_slaveCache->AddToCache(m_objects);
+	m_slaveCache->AddToCache(m_objects, m_level);
 	if (m_slaveCache->m_jobs.IsEmpty() && m_callback)
 		m_callback();
 }
@@ -273,20 +391,91 @@ void GalaxyObjectCache<T, CompareT>::CacheJob::OnFinish() // runs in primary thr
 template <>
 const std::string GalaxyObjectCache<Sector, SystemPath::LessSectorOnly>::CACHE_NAME("SectorCache");
 
+// The sector generator stages are safe to run concurrently, so a fill's
+// sectors are split between the task graph's workers. Zoomed out sector
+// maps ask for thousands at once.
+template <>
+void GalaxyObjectCache<Sector, SystemPath::LessSectorOnly>::CacheJob::OnRun() // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
+{
+	PROFILE_SCOPED()
+	m_objects.resize(m_paths->size());
+	auto generate = [&](TaskRange range) {
+		for (uint32_t i = range.begin; i < range.end; i++)
+			m_objects[i] = m_galaxyGenerator->Generate<Sector, SectorCache>(m_galaxy, (*m_paths)[i], nullptr);
+	};
+
+	TaskGraph *taskGraph = Pi::GetApp()->GetTaskGraph();
+	if (!taskGraph || m_paths->size() <= SECTOR_GENERATION_GRAIN_SIZE)
+		generate({ 0, uint32_t(m_paths->size()) });
+	else
+		taskGraph->ParallelFor({ 0, uint32_t(m_paths->size()) }, SECTOR_GENERATION_GRAIN_SIZE, generate);
+}
+
 template class GalaxyObjectCache<Sector, SystemPath::LessSectorOnly>;
 
 /****** StarSystemCache ******/
 
 template <>
-GalaxyObjectCache<StarSystem, SystemPath::LessSystemOnly>::Slave::Slave(GalaxyObjectCache<StarSystem, SystemPath::LessSystemOnly> *master, RefCountedPtr<Galaxy> galaxy, JobQueue *jobQueue) :
-	m_master(master),
+const std::string GalaxyObjectCache<StarSystem, SystemPath::LessSystemOnly>::CACHE_NAME("StarSystemCache");
+
+static StarSystem::GenerationLevel ToGenerationLevel(int level)
+{
+	return level < 0 ? StarSystem::GENERATED_ALL : StarSystem::GenerationLevel(level);
+}
+
+template <>
+GalaxyObjectCache<StarSystem, SystemPath::LessSystemOnly>::CacheJob::CacheJob(std::unique_ptr<std::vector<SystemPath>> path,
+	Slave *slaveCache, RefCountedPtr<Galaxy> galaxy, int level, CacheFilledCallback callback) :
+	Job(PRIORITY_LOW),
+	m_paths(std::move(path)),
+	m_level(level),
+	m_slaveCache(slaveCache),
 	m_galaxy(galaxy),
-	m_jobs(Pi::GetSyncJobQueue())
+	m_galaxyGenerator(galaxy->GetGenerator()),
+	m_callback(callback)
 {
-	m_master->m_slaves.insert(this);
+	// the sector cache can only be used from here
+	m_sectors.reserve(m_paths->size());
+	for (const SystemPath &path : *m_paths)
+		m_sectors.push_back(galaxy->GetSector(path));
 }
 
+// The stages up to GENERATED_BODIES are safe to run concurrently, so a
+// fill's systems are split between the task graph's workers as far as that.
+// The rest name bodies from Lua, so they're left for the main thread.
 template <>
-const std::string GalaxyObjectCache<StarSystem, SystemPath::LessSystemOnly>::CACHE_NAME("StarSystemCache");
+void GalaxyObjectCache<StarSystem, SystemPath::LessSystemOnly>::CacheJob::OnRun() // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
+{
+	PROFILE_SCOPED()
+	const StarSystem::GenerationLevel level = std::min(ToGenerationLevel(m_level), StarSystem::GENERATED_BODIES);
+	m_objects.resize(m_paths->size());
+	auto generate = [&](TaskRange range) {
+		// each system seeds its own Random from its path, so the results
+		// don't depend on which worker generates it
+		for (uint32_t i = range.begin; i < range.end; i++)
+			m_objects[i] = m_galaxyGenerator->GenerateStarSystem(m_galaxy, (*m_paths)[i], nullptr, level, m_sectors[i]);
+	};
+
+	TaskGraph *taskGraph = Pi::GetApp()->GetTaskGraph();
+	if (!taskGraph || m_paths->size() <= STAR_SYSTEM_GENERATION_GRAIN_SIZE)
+		generate({ 0, uint32_t(m_paths->size()) });
+	else
+		taskGraph->ParallelFor({ 0, uint32_t(m_paths->size()) }, STAR_SYSTEM_GENERATION_GRAIN_SIZE, generate);
+}
+
+template <>
+RefCountedPtr<StarSystem> GalaxyObjectCache<StarSystem, SystemPath::LessSystemOnly>::Generate(const SystemPath &path, int level)
+{
+	return m_galaxy->GetGenerator()->GenerateStarSystem(RefCountedPtr<Galaxy>(m_galaxy), path, this, ToGenerationLevel(level));
+}
+
+template <>
+void GalaxyObjectCache<StarSystem, SystemPath::LessSystemOnly>::Realise(StarSystem *object, int level)
+{
+	const StarSystem::GenerationLevel before = object->GetGenerationLevel();
+	m_galaxy->GetGenerator()->RealiseStarSystem(RefCountedPtr<Galaxy>(m_galaxy), object, ToGenerationLevel(level));
+	if (object->GetGenerationLevel() != before)
+		UpdateRetainedSize(object);
+}
 
 template class GalaxyObjectCache<StarSystem, SystemPath::LessSystemOnly>;
@@ -6,8 +6,10 @@
 
 #include "JobQueue.h"
 #include "RefCounted.h"
+#include "core/FlatHashMap.h"
 #include "galaxy/SystemPath.h"
 #include <functional>
+#include <list>
 #include <map>
 #include <memory>
 #include <set>
@@ -15,6 +17,21 @@
 
 class GalaxyGenerator;
 class Galaxy;
+class Sector;
+
+// The hash and equality matching each cache's path ordering
+template <typename CompareT>
+struct GalaxyCacheKey;
+template <>
+struct GalaxyCacheKey<SystemPath::LessSectorOnly> {
+	typedef SystemPath::HashSectorOnly Hash;
+	typedef SystemPath::EqualSectorOnly Equal;
+};
+template <>
+struct GalaxyCacheKey<SystemPath::LessSystemOnly> {
+	typedef SystemPath::HashSystemOnly Hash;
+	typedef SystemPath::EqualSystemOnly Equal;
+};
 
 template <typename T, typename CompareT>
 class GalaxyObjectCache {
@@ -23,24 +40,41 @@ class GalaxyObjectCache {
 public:
 	static const std::string CACHE_NAME;
 
-	GalaxyObjectCache(Galaxy *galaxy) :
-		m_galaxy(galaxy),
-		m_cacheHits(0),
-		m_cacheHitsSlave(0),
-		m_cacheMisses(0) {}
+	GalaxyObjectCache(Galaxy *galaxy);
 	~GalaxyObjectCache();
 
 	RefCountedPtr<T> GetCached(const SystemPath &path);
-	RefCountedPtr<T> GetIfCached(const SystemPath &path);
+	// For objects generated in stages, i.e. StarSystem::GenerationLevel:
+	// the object generated at least as far as level. Without a level the
+	// accessors return complete objects.
+	RefCountedPtr<T> GetCached(const SystemPath &path, int level);
+	RefCountedPtr<T> GetIfCached(const SystemPath &path, int level = LEVEL_COMPLETE);
 
 	void ClearCache(); // Completely clear slave caches
 	bool IsEmpty() { return m_attic.empty(); }
 
 	void OutputCacheStatistics(bool reset = true);
 
+	struct Statistics {
+		unsigned long long hits;
+		unsigned long long slaveHits;
+		unsigned long long misses;
+		unsigned long long evictions;
+		size_t numObjects; // alive, whether retained by the cache or not
+		size_t numRetained; // kept alive by the cache itself
+		size_t retainedBytes;
+		size_t budgetBytes;
+	};
+	Statistics GetStatistics() const;
+
 	typedef std::vector<SystemPath> PathVector;
-	typedef std::map<SystemPath, RefCountedPtr<T>, CompareT> CacheMap;
-	typedef std::map<SystemPath, T *, CompareT> AtticMap;
+	typedef typename GalaxyCacheKey<CompareT>::Hash PathHash;
+	typedef typename GalaxyCacheKey<CompareT>::Equal PathEqual;
+	// unordered; iterating over a slave visits its objects in no particular order
+	typedef FlatHashMap<SystemPath, RefCountedPtr<T>, PathHash, PathEqual> CacheMap;
+	typedef FlatHashMap<SystemPath, T *, PathHash, PathEqual> AtticMap;
+	typedef std::list<std::pair<RefCountedPtr<T>, size_t>> LruList; // with each object's size
+	typedef FlatHashMap<SystemPath, typename LruList::iterator, PathHash, PathEqual> LruIndex;
 	typedef std::function<void()> CacheFilledCallback;
 
 	class Slave : public RefCounted {
@@ -52,7 +86,10 @@ public:
 		typename CacheMap::const_iterator Begin() const { return m_cache.begin(); }
 		typename CacheMap::const_iterator End() const { return m_cache.end(); }
 
-		void FillCache(const PathVector &paths, CacheFilledCallback callback = CacheFilledCallback());
+		// Generates the objects on the job queue, each object's job in the
+		// order given. Objects generated in stages are filled in as far as
+		// level.
+		void FillCache(const PathVector &paths, CacheFilledCallback callback = CacheFilledCallback(), int level = LEVEL_COMPLETE);
 		void Erase(const SystemPath &path);
 		void Erase(const typename CacheMap::const_iterator &it);
 		void ClearCache();
@@ -67,7 +104,7 @@ public:
 
 		Slave(GalaxyObjectCache *master, RefCountedPtr<Galaxy> galaxy, JobQueue *jobQueue);
 		void MasterDeleted();
-		void AddToCache(std::vector<RefCountedPtr<T>> &objects);
+		void AddToCache(std::vector<RefCountedPtr<T>> &objects, int level);
 	};
 
 	RefCountedPtr<Slave> NewSlaveCache();
@@ -75,16 +112,25 @@ public:
 private:
 	static const unsigned CACHE_JOB_SIZE = 100;
 
-	void AddToCache(std::vector<RefCountedPtr<T>> &objects);
+	static const int LEVEL_COMPLETE = -1;
+
+	void AddToCache(std::vector<RefCountedPtr<T>> &objects, int level);
 	bool HasCached(const SystemPath &path) const;
+	RefCountedPtr<T> Generate(const SystemPath &path, int level);
+	void Realise(T *object, int level);
 	void RemoveFromAttic(const SystemPath &path);
+	// Marks the object as most recently used, retaining it if it wasn't,
+	// then evicts the least recently used objects over the budget
+	void Touch(T *object);
+	void UpdateRetainedSize(T *object); // after it's grown, evicting on the next Touch()
+	void ClearRetained();
 
 	// ********************************************************************************
 	// Overloaded Job class to handle generating a collection of sectors
 	// ********************************************************************************
 	class CacheJob : public Job {
 	public:
-		CacheJob(std::unique_ptr<std::vector<SystemPath>> path, Slave *slaveCache, RefCountedPtr<Galaxy> galaxy, CacheFilledCallback callback = CacheFilledCallback());
+		CacheJob(std::unique_ptr<std::vector<SystemPath>> path, Slave *slaveCache, RefCountedPtr<Galaxy> galaxy, int level, CacheFilledCallback callback = CacheFilledCallback());
 
 		virtual void OnRun(); // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
 		virtual void OnFinish(); // runs in primary thread of the context
@@ -93,6 +139,9 @@ private:
 	protected:
 		std::unique_ptr<std::vector<SystemPath>> m_paths;
 		std::vector<RefCountedPtr<T>> m_objects;
+		// fetched on the main thread, for stages which look up the sector
+		std::vector<RefCountedPtr<const Sector>> m_sectors;
+		int m_level;
 		Slave *m_slaveCache;
 		RefCountedPtr<Galaxy> m_galaxy;
 		RefCountedPtr<GalaxyGenerator> m_galaxyGenerator;
@@ -105,9 +154,21 @@ private:
 		// or elsewhere. The Sector destructor ensures that it is removed from here.
 		// This ensures, that there is only ever one object for each Sector.
 
+	// Recently used objects are also retained here, most recent first, so
+	// that moving back and forth across the galaxy doesn't regenerate them.
+	// Their estimated GetMemoryUsage() is kept within m_budgetBytes; the
+	// estimates are taken once, as objects are retained. Retained objects
+	// hold their galaxy, so Galaxy::FlushCaches() has to release them
+	// before the galaxy itself can be released.
+	LruList m_lru;
+	LruIndex m_lruIndex;
+	size_t m_lruBytes;
+	size_t m_budgetBytes;
+
 	unsigned long long m_cacheHits;
 	unsigned long long m_cacheHitsSlave;
 	unsigned long long m_cacheMisses;
+	unsigned long long m_cacheEvictions;
 };
 
 class Sector;
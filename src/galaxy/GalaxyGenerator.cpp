@@ -5,7 +5,9 @@
 
 #include "GameSaveError.h"
 #include "Json.h"
+#include "SectorDatabase.h"
 #include "SectorGenerator.h"
+#include "core/MemoryStats.h"
 #include "galaxy/Galaxy.h"
 #include "galaxy/StarSystemGenerator.h"
 #include "utils.h"
@@ -23,11 +25,21 @@ void GalaxyGenerator::Init(const std::string &name, Version version)
 	s_defaultGenerator = name;
 	s_defaultVersion = (version == LAST_VERSION) ? GetLastVersion(name) : version;
 	GalaxyGenerator::Create(); // This will set s_galaxy
+
+	// only what the caches retain themselves; objects kept alive elsewhere
+	// are not counted
+	MemoryStats::SetReporter(MemoryStats::TAG_GALAXY, []() -> size_t {
+		if (!s_galaxy)
+			return 0;
+		return s_galaxy->GetSectorCache().GetStatistics().retainedBytes +
+			s_galaxy->GetStarSystemCache().GetStatistics().retainedBytes;
+	});
 }
 
 //static
 void GalaxyGenerator::Uninit()
 {
+	MemoryStats::SetReporter(MemoryStats::TAG_GALAXY, nullptr);
 	s_galaxy->FlushCaches();
 	s_galaxy.Reset();
 }
@@ -59,7 +71,9 @@ RefCountedPtr<Galaxy> GalaxyGenerator::Create(const std::string &name, Version v
 							 ->AddStarSystemStage(new StarSystemFromSectorGenerator)
 							 ->AddStarSystemStage(new StarSystemCustomGenerator)
 							 ->AddStarSystemStage(new StarSystemRandomGenerator)
-							 ->AddStarSystemStage(new PopulateStarSystemGenerator));
+							 ->AddStarSystemStage(new PopulateStarSystemGenerator)
+							 ->AddStarSystemStage(new PopulateStationsGenerator));
+			galgen->SetSectorDatabase(SectorDatabase::Load(name, version));
 		}
 	}
 
@@ -146,6 +160,12 @@ void GalaxyGenerator::FromJson(const Json &jsonObj, RefCountedPtr<Galaxy> galaxy
 	}
 }
 
+GalaxyGenerator::GalaxyGenerator(const std::string &name, Version version) :
+	m_name(name),
+	m_version(version)
+{
+}
+
 GalaxyGenerator::~GalaxyGenerator()
 {
 	for (SectorGeneratorStage *secgen : m_sectorStage)
@@ -163,6 +183,7 @@ GalaxyGenerator *GalaxyGenerator::AddSectorStage(SectorGeneratorStage *sectorGen
 
 GalaxyGenerator *GalaxyGenerator::AddStarSystemStage(StarSystemGeneratorStage *starSystemGenerator)
 {
+	assert(m_starSystemStage.empty() || m_starSystemStage.back()->GetLevel() <= starSystemGenerator->GetLevel());
 	auto it = m_starSystemStage.insert(m_starSystemStage.end(), starSystemGenerator);
 	(*it)->AssignToGalaxyGenerator(this);
 	return this;
@@ -174,25 +195,89 @@ RefCountedPtr<Sector> GalaxyGenerator::GenerateSector(RefCountedPtr<Galaxy> gala
 	Random rng(_init, 4);
 	SectorConfig config;
 	RefCountedPtr<Sector> sector(new Sector(galaxy, path, cache));
-	for (SectorGeneratorStage *secgen : m_sectorStage)
+	const bool baked = m_sectorDatabase && m_sectorDatabase->FillSector(galaxy.Get(), sector.Get());
+	for (SectorGeneratorStage *secgen : m_sectorStage) {
+		if (baked && secgen->IsBakeable())
+			continue;
 		if (!secgen->Apply(rng, galaxy, sector, &config))
 			break;
+	}
 	return sector;
 }
 
-RefCountedPtr<StarSystem> GalaxyGenerator::GenerateStarSystem(RefCountedPtr<Galaxy> galaxy, const SystemPath &path, StarSystemCache *cache)
+RefCountedPtr<Sector> GalaxyGenerator::GenerateBakedSector(RefCountedPtr<Galaxy> galaxy, const SystemPath &path)
 {
-	PROFILE_SCOPED()
-	RefCountedPtr<const Sector> sec = galaxy->GetSector(path);
-	assert(path.systemIndex < sec->m_systems.size());
-	Uint32 seed = sec->m_systems[path.systemIndex].GetSeed();
-	std::string name = sec->m_systems[path.systemIndex].GetName();
+	const Uint32 _init[4] = { Uint32(path.sectorX), Uint32(path.sectorY), Uint32(path.sectorZ), UNIVERSE_SEED };
+	Random rng(_init, 4);
+	SectorConfig config;
+	RefCountedPtr<Sector> sector(new Sector(galaxy, path, nullptr));
+	for (SectorGeneratorStage *secgen : m_sectorStage) {
+		if (!secgen->IsBakeable())
+			continue;
+		if (!secgen->Apply(rng, galaxy, sector, &config))
+			break;
+	}
+	return sector;
+}
+
+void GalaxyGenerator::SetSectorDatabase(RefCountedPtr<SectorDatabase> db)
+{
+	m_sectorDatabase = db;
+}
+
+static void SeedStarSystemRandom(const Sector &sec, const SystemPath &path, Random &rng)
+{
+	assert(path.systemIndex < sec.m_systems.size());
+	Uint32 seed = sec.m_systems[path.systemIndex].GetSeed();
 	Uint32 _init[5] = { Uint32(seed), Uint32(path.sectorX), Uint32(path.sectorY), Uint32(path.sectorZ), UNIVERSE_SEED };
-	Random rng(_init, 5);
-	StarSystemConfig config;
+	rng.seed(_init, 5);
+}
+
+RefCountedPtr<StarSystem> GalaxyGenerator::GenerateStarSystem(RefCountedPtr<Galaxy> galaxy, const SystemPath &path, StarSystemCache *cache,
+	StarSystem::GenerationLevel level, RefCountedPtr<const Sector> sector)
+{
+	PROFILE_SCOPED()
+	if (!sector)
+		sector = galaxy->GetSector(path);
+	Random rng;
+	SeedStarSystemRandom(*sector, path, rng);
 	RefCountedPtr<StarSystem::GeneratorAPI> system(new StarSystem::GeneratorAPI(path, galaxy, cache, rng));
-	for (StarSystemGeneratorStage *sysgen : m_starSystemStage)
-		if (!sysgen->Apply(rng, galaxy, system, &config))
-			break;
+	ApplyStarSystemStages(rng, galaxy, system, sector, -1, level);
 	return system;
 }
+
+void GalaxyGenerator::RealiseStarSystem(RefCountedPtr<Galaxy> galaxy, StarSystem *system, StarSystem::GenerationLevel level)
+{
+	if (system->GetGenerationLevel() >= level)
+		return;
+
+	PROFILE_SCOPED()
+	RefCountedPtr<const Sector> sector = galaxy->GetSector(system->GetPath());
+	Random rng;
+	SeedStarSystemRandom(*sector, system->GetPath(), rng);
+	// every generated system is a GeneratorAPI
+	RefCountedPtr<StarSystem::GeneratorAPI> generatorSystem(static_cast<StarSystem::GeneratorAPI *>(system));
+	ApplyStarSystemStages(rng, galaxy, generatorSystem, sector, system->GetGenerationLevel(), level);
+}
+
+void GalaxyGenerator::ApplyStarSystemStages(Random &rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<StarSystem::GeneratorAPI> system,
+	RefCountedPtr<const Sector> sector, int doneLevel, StarSystem::GenerationLevel level)
+{
+	StarSystemConfig config;
+	config.isCustomOnly = system->m_isCustomOnly;
+	config.sector = sector;
+	StarSystem::GenerationLevel reached = level;
+	for (StarSystemGeneratorStage *sysgen : m_starSystemStage) {
+		if (sysgen->GetLevel() <= doneLevel)
+			continue;
+		if (sysgen->GetLevel() > level)
+			break;
+		if (!sysgen->Apply(rng, galaxy, system, &config)) {
+			// the stage has finished the system by itself
+			reached = StarSystem::GENERATED_ALL;
+			break;
+		}
+	}
+	system->m_isCustomOnly = config.isCustomOnly;
+	system->SetGenerationLevel(reached);
+}
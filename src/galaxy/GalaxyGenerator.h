@@ -11,6 +11,7 @@
 #include <list>
 #include <string>
 
+class SectorDatabase;
 class SectorGeneratorStage;
 class StarSystemGeneratorStage;
 
@@ -47,6 +48,21 @@ public:
 	template <typename T, typename Cache>
 	RefCountedPtr<T> Generate(RefCountedPtr<Galaxy> galaxy, const SystemPath &path, Cache *cache);
 
+	// Generates a star system only as far as the given level; the stages
+	// after it are left for RealiseStarSystem(). Given the system's sector,
+	// the stages up to GENERATED_BODIES don't touch the galaxy's caches,
+	// so they may run on any thread.
+	RefCountedPtr<StarSystem> GenerateStarSystem(RefCountedPtr<Galaxy> galaxy, const SystemPath &path, StarSystemCache *cache, StarSystem::GenerationLevel level,
+		RefCountedPtr<const Sector> sector = RefCountedPtr<const Sector>());
+	// Runs whichever stages up to the given level haven't been run on the system yet.
+	void RealiseStarSystem(RefCountedPtr<Galaxy> galaxy, StarSystem *system, StarSystem::GenerationLevel level);
+
+	// Runs only the bakeable sector stages, for writing to a SectorDatabase;
+	// the sector isn't cached.
+	RefCountedPtr<Sector> GenerateBakedSector(RefCountedPtr<Galaxy> galaxy, const SystemPath &path);
+	// Sectors found in the database are read from it rather than generated.
+	void SetSectorDatabase(RefCountedPtr<SectorDatabase> db);
+
 	GalaxyGenerator *AddSectorStage(SectorGeneratorStage *sectorGenerator);
 	GalaxyGenerator *AddStarSystemStage(StarSystemGeneratorStage *starSystemGenerator);
 
@@ -59,24 +75,26 @@ public:
 
 	struct StarSystemConfig {
 		bool isCustomOnly;
+		RefCountedPtr<const Sector> sector; // the system's
 
 		StarSystemConfig() :
 			isCustomOnly(false) {}
 	};
 
 private:
-	GalaxyGenerator(const std::string &name, Version version = LAST_VERSION) :
-		m_name(name),
-		m_version(version) {}
+	GalaxyGenerator(const std::string &name, Version version = LAST_VERSION);
 
 	virtual RefCountedPtr<Sector> GenerateSector(RefCountedPtr<Galaxy> galaxy, const SystemPath &path, SectorCache *cache);
-	virtual RefCountedPtr<StarSystem> GenerateStarSystem(RefCountedPtr<Galaxy> galaxy, const SystemPath &path, StarSystemCache *cache);
+	// runs the stages above doneLevel, up to level
+	void ApplyStarSystemStages(Random &rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<StarSystem::GeneratorAPI> system, RefCountedPtr<const Sector> sector,
+		int doneLevel, StarSystem::GenerationLevel level);
 
 	const std::string m_name;
 	const Version m_version;
 
 	std::list<SectorGeneratorStage *> m_sectorStage;
 	std::list<StarSystemGeneratorStage *> m_starSystemStage;
+	RefCountedPtr<SectorDatabase> m_sectorDatabase;
 
 	static RefCountedPtr<Galaxy> s_galaxy;
 	static std::string s_defaultGenerator;
@@ -92,7 +110,7 @@ inline RefCountedPtr<Sector> GalaxyGenerator::Generate<Sector, SectorCache>(RefC
 template <>
 inline RefCountedPtr<StarSystem> GalaxyGenerator::Generate<StarSystem, StarSystemCache>(RefCountedPtr<Galaxy> galaxy, const SystemPath &path, StarSystemCache *cache)
 {
-	return GenerateStarSystem(galaxy, path, cache);
+	return GenerateStarSystem(galaxy, path, cache, StarSystem::GENERATED_ALL);
 }
 
 class GalaxyGeneratorStage {
@@ -112,17 +130,31 @@ protected:
 	GalaxyGenerator *m_galaxyGenerator;
 };
 
+// Apply() is called from worker threads for many sectors at once, so stages
+// must only read state shared between sectors, or lock it.
 class SectorGeneratorStage : public GalaxyGeneratorStage {
 public:
 	virtual ~SectorGeneratorStage() {}
 
+	// Whether the stage's results depend only on the galaxy, not the game,
+	// so can be baked into a SectorDatabase; the stages which aren't still
+	// run on sectors read from one.
+	virtual bool IsBakeable() const { return true; }
+
 	virtual bool Apply(Random &rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<Sector> sector, GalaxyGenerator::SectorConfig *config) = 0;
 };
 
+// Stages are run in order of their level, and the stages above the level a
+// system is asked for are run later, when it's asked for in more detail. The
+// rng passed to Apply() is then freshly seeded, so stages may only depend on
+// draws from it made by stages of their own level.
 class StarSystemGeneratorStage : public GalaxyGeneratorStage {
 public:
 	virtual ~StarSystemGeneratorStage() {}
 
+	// the level of detail this stage generates
+	virtual StarSystem::GenerationLevel GetLevel() const = 0;
+
 	virtual bool Apply(Random &rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<StarSystem::GeneratorAPI> system, GalaxyGenerator::StarSystemConfig *config) = 0;
 };
 
@@ -0,0 +1,177 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "GalaxySpatialIndex.h"
+
+#include "Factions.h"
+#include "Galaxy.h"
+#include "Sector.h"
+#include "profiler/Profiler.h"
+
+#include <cmath>
+
+GalaxySpatialIndex::GalaxySpatialIndex(Galaxy *galaxy) :
+	m_galaxy(galaxy)
+{
+}
+
+GalaxySpatialIndex::Cell &GalaxySpatialIndex::GetCell(int sx, int sy, int sz)
+{
+	const SystemPath sectorPath(sx, sy, sz);
+	auto it = m_cells.find(sectorPath);
+	if (it != m_cells.end())
+		return it->second;
+
+	PROFILE_SCOPED()
+	Cell &cell = m_cells[sectorPath];
+	RefCountedPtr<const Sector> sector = m_galaxy->GetSector(sectorPath);
+	cell.entries.reserve(sector->m_systems.size());
+	for (const Sector::System &sys : sector->m_systems) {
+		Entry entry;
+		entry.pos = sys.GetFullPosition();
+		entry.path = sys.GetPath();
+		// the sector map may already have worked it out
+		entry.population = sys.GetPopulation() >= 0 ? float(sys.GetPopulation().ToDouble()) : -1.0f;
+		entry.faction = Faction::BAD_FACTION_IDX;
+		entry.explored = sys.GetExplored();
+		entry.numStars = sys.GetNumStars();
+		cell.entries.push_back(entry);
+	}
+	return cell;
+}
+
+void GalaxySpatialIndex::PrepareCell(Cell &cell, const Filter &filter)
+{
+	if (filter.inhabitedOnly && !cell.hasPopulation) {
+		PROFILE_SCOPED_DESC("GalaxySpatialIndex population")
+		for (Entry &entry : cell.entries) {
+			if (entry.population < 0.0f)
+				entry.population = float(m_galaxy->GetStarSystem(entry.path, StarSystem::GENERATED_POPULATION)->GetTotalPop().ToDouble());
+		}
+		cell.hasPopulation = true;
+	}
+
+	if (filter.faction != Filter::ANY_FACTION && !cell.hasFaction) {
+		RefCountedPtr<const Sector> sector;
+		for (Entry &entry : cell.entries) {
+			if (!sector)
+				sector = m_galaxy->GetSector(entry.path);
+			entry.faction = sector->m_systems[entry.path.systemIndex].GetFaction()->idx;
+		}
+		cell.hasFaction = true;
+	}
+}
+
+bool GalaxySpatialIndex::Matches(const Entry &entry, const Filter &filter)
+{
+	if (filter.inhabitedOnly && entry.population <= 0.0f)
+		return false;
+	if (filter.exploredOnly && entry.explored == StarSystem::eUNEXPLORED)
+		return false;
+	if (filter.unexploredOnly && entry.explored != StarSystem::eUNEXPLORED)
+		return false;
+	if (filter.faction != Filter::ANY_FACTION && entry.faction != filter.faction)
+		return false;
+	return true;
+}
+
+void GalaxySpatialIndex::FindInRadius(const vector3f &pos, float radius, const Filter &filter, std::vector<const Entry *> &out, std::vector<float> *distances)
+{
+	PROFILE_SCOPED()
+	const float radiusSqr = radius * radius;
+	const int minX = int(std::floor((pos.x - radius) / Sector::SIZE)), maxX = int(std::floor((pos.x + radius) / Sector::SIZE));
+	const int minY = int(std::floor((pos.y - radius) / Sector::SIZE)), maxY = int(std::floor((pos.y + radius) / Sector::SIZE));
+	const int minZ = int(std::floor((pos.z - radius) / Sector::SIZE)), maxZ = int(std::floor((pos.z + radius) / Sector::SIZE));
+
+	for (int sx = minX; sx <= maxX; sx++) {
+		for (int sy = minY; sy <= maxY; sy++) {
+			for (int sz = minZ; sz <= maxZ; sz++) {
+				Cell &cell = GetCell(sx, sy, sz);
+				bool prepared = false;
+				for (const Entry &entry : cell.entries) {
+					const float distSqr = (entry.pos - pos).LengthSqr();
+					if (distSqr > radiusSqr)
+						continue;
+					// only generate what the filter needs for cells with
+					// systems in range
+					if (!prepared) {
+						PrepareCell(cell, filter);
+						prepared = true;
+					}
+					if (!Matches(entry, filter))
+						continue;
+					out.push_back(&entry);
+					if (distances)
+						distances->push_back(std::sqrt(distSqr));
+				}
+			}
+		}
+	}
+}
+
+const GalaxySpatialIndex::Entry *GalaxySpatialIndex::FindNearest(const vector3f &pos, float maxRadius, const Filter &filter, const SystemPath &exclude)
+{
+	PROFILE_SCOPED()
+	const int cx = int(std::floor(pos.x / Sector::SIZE));
+	const int cy = int(std::floor(pos.y / Sector::SIZE));
+	const int cz = int(std::floor(pos.z / Sector::SIZE));
+	const int maxShell = int(std::ceil(maxRadius / Sector::SIZE));
+
+	const Entry *best = nullptr;
+	float bestDistSqr = maxRadius * maxRadius;
+	for (int shell = 0; shell <= maxShell; shell++) {
+		// everything outside this shell is at least this far away
+		const float shellDist = (shell - 1) * Sector::SIZE;
+		if (best && shellDist > 0.0f && shellDist * shellDist > bestDistSqr)
+			break;
+
+		// the cells on the surface of the cube of cells shell away
+		for (int sx = cx - shell; sx <= cx + shell; sx++) {
+			for (int sy = cy - shell; sy <= cy + shell; sy++) {
+				const bool edge = sx == cx - shell || sx == cx + shell || sy == cy - shell || sy == cy + shell;
+				for (int sz = cz - shell; sz <= cz + shell; sz += (edge || shell == 0) ? 1 : 2 * shell) {
+					Cell &cell = GetCell(sx, sy, sz);
+					bool prepared = false;
+					for (const Entry &entry : cell.entries) {
+						const float distSqr = (entry.pos - pos).LengthSqr();
+						if (distSqr > bestDistSqr || SystemPath::EqualSystemOnly()(entry.path, exclude))
+							continue;
+						if (!prepared) {
+							PrepareCell(cell, filter);
+							prepared = true;
+						}
+						if (!Matches(entry, filter))
+							continue;
+						best = &entry;
+						bestDistSqr = distSqr;
+					}
+				}
+			}
+		}
+	}
+	return best;
+}
+
+const std::vector<GalaxySpatialIndex::Entry> &GalaxySpatialIndex::GetSectorEntries(int sx, int sy, int sz)
+{
+	return GetCell(sx, sy, sz).entries;
+}
+
+const GalaxySpatialIndex::Entry &GalaxySpatialIndex::GetEntry(const SystemPath &path)
+{
+	const Cell &cell = GetCell(path.sectorX, path.sectorY, path.sectorZ);
+	assert(path.systemIndex < cell.entries.size());
+	return cell.entries[path.systemIndex];
+}
+
+void GalaxySpatialIndex::UpdateExplored(const SystemPath &path, StarSystem::ExplorationState explored)
+{
+	auto it = m_cells.find(path);
+	if (it != m_cells.end() && path.systemIndex < it->second.entries.size())
+		it->second.entries[path.systemIndex].explored = explored;
+}
+
+void GalaxySpatialIndex::Clear()
+{
+	m_cells.clear();
+}
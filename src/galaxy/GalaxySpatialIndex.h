@@ -0,0 +1,79 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _GALAXYSPATIALINDEX_H
+#define _GALAXYSPATIALINDEX_H
+
+#include "core/FlatHashMap.h"
+#include "galaxy/StarSystem.h"
+#include "galaxy/SystemPath.h"
+#include "vector3.h"
+
+#include <vector>
+
+class Galaxy;
+
+// A grid of the systems generated so far, one cell per sector, holding just
+// what range queries filter on. Unlike the sector cache it is never
+// trimmed, so once a region has been indexed asking about it again doesn't
+// touch the sector or star system caches at all.
+//
+// Populations are only known once a system is generated to its population,
+// so cells fill them in the first time a query filters on them. The index
+// is used from the main thread only, and is emptied with the galaxy caches.
+class GalaxySpatialIndex {
+public:
+	struct Entry {
+		vector3f pos; // in light years from the galaxy origin
+		SystemPath path;
+		float population; // in billions, negative if not yet known
+		Uint32 faction;	  // faction index, or Faction::BAD_FACTION_IDX
+		StarSystem::ExplorationState explored;
+		Uint8 numStars;
+	};
+
+	struct Filter {
+		bool inhabitedOnly = false;
+		bool unexploredOnly = false;
+		bool exploredOnly = false;
+		Uint32 faction = ANY_FACTION;
+		static constexpr Uint32 ANY_FACTION = ~Uint32(0);
+	};
+
+	GalaxySpatialIndex(Galaxy *galaxy);
+
+	// Appends the systems within radius of pos to out, in sector then system
+	// order, along with their distance from pos. Entries stay valid until
+	// the index is cleared.
+	void FindInRadius(const vector3f &pos, float radius, const Filter &filter, std::vector<const Entry *> &out, std::vector<float> *distances = nullptr);
+	// The matching system nearest pos other than exclude, within maxRadius;
+	// nullptr if there isn't one.
+	const Entry *FindNearest(const vector3f &pos, float maxRadius, const Filter &filter, const SystemPath &exclude = SystemPath());
+
+	// The entries of one sector, indexing it if it hasn't been yet.
+	const std::vector<Entry> &GetSectorEntries(int sx, int sy, int sz);
+	const Entry &GetEntry(const SystemPath &path);
+
+	// Keeps the index in step with Sector::System::SetExplored().
+	void UpdateExplored(const SystemPath &path, StarSystem::ExplorationState explored);
+	void Clear();
+
+	size_t GetNumSectors() const { return m_cells.size(); }
+
+private:
+	struct Cell {
+		std::vector<Entry> entries;
+		bool hasPopulation = false;
+		bool hasFaction = false;
+	};
+
+	Cell &GetCell(int sx, int sy, int sz);
+	// fills in what the filter needs and the cell doesn't have yet
+	void PrepareCell(Cell &cell, const Filter &filter);
+	static bool Matches(const Entry &entry, const Filter &filter);
+
+	Galaxy *m_galaxy;
+	FlatHashMap<SystemPath, Cell, SystemPath::HashSectorOnly, SystemPath::EqualSectorOnly> m_cells;
+};
+
+#endif /* _GALAXYSPATIALINDEX_H */
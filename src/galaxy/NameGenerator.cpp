@@ -4,6 +4,33 @@
 #include "NameGenerator.h"
 #include "utils.h"
 
+#include <string_view>
+
+namespace {
+	// One part of a name: fragments picked from a table, between minCount
+	// and maxCount of them. The count is only rolled when the two differ,
+	// so the generators draw from the Random in the same order as ever and
+	// a seed always gives the same name.
+	struct NamePart {
+		const std::string_view *fragments;
+		Uint32 numFragments;
+		int minCount;
+		int maxCount;
+	};
+
+	template <size_t N>
+	void AppendName(std::string &name, Random &rng, const NamePart (&parts)[N])
+	{
+		for (const NamePart &part : parts) {
+			const int count = part.minCount == part.maxCount ? part.minCount : rng.Int32(part.minCount, part.maxCount);
+			for (int i = 0; i < count; i++)
+				name += part.fragments[rng.Int32(0, part.numFragments - 1)];
+		}
+
+		name[0] = toupper(name[0]);
+	}
+} // namespace
+
 void NameGenerator::GetSystemName(std::string &name, Random &rng)
 {
 	int nameGen = rng.Int32(0, 3);
@@ -18,8 +45,17 @@ void NameGenerator::GetSystemName(std::string &name, Random &rng)
 	}
 }
 
+void NameGenerator::GetSystemNames(std::vector<std::string> &names, size_t count, Random &rng)
+{
+	names.reserve(names.size() + count);
+	for (size_t i = 0; i < count; i++) {
+		names.emplace_back();
+		GetSystemName(names.back(), rng);
+	}
+}
+
 namespace FrontierNames {
-	static const char *sys_names[] = {
+	static constexpr std::string_view sys_names[] = {
 		"en", "la", "can", "be",
 		"and", "phi", "eth", "ol",
 		"ve", "ho", "a", "lia",
@@ -30,22 +66,20 @@ namespace FrontierNames {
 		"wa", "de", "ack", "gre",
 		"le", "du", "do", "ne"
 	};
-	static const unsigned int SYS_NAME_FRAGS = ((unsigned int)(sizeof(sys_names) / sizeof(char *)));
+
+	// add fragments to build a name
+	static const NamePart Parts[] = {
+		{ sys_names, COUNTOF(sys_names), 2, 3 }
+	};
 
 	void GetName(std::string &name, Random &rng)
 	{
-		// add fragments to build a name
-		int len = rng.Int32(2, 3);
-		for (int i = 0; i < len; i++) {
-			name += sys_names[rng.Int32(0, SYS_NAME_FRAGS - 1)];
-		}
-
-		name[0] = toupper(name[0]);
+		AppendName(name, rng, Parts);
 	}
 } // namespace FrontierNames
 
 namespace HybridNames {
-	static const char *sys_names[] = {
+	static constexpr std::string_view sys_names[] = {
 		"en", "la", "can", "be",
 		"and", "phi", "eth", "ol",
 		"ve", "ho", "a", "lia",
@@ -76,51 +110,48 @@ namespace HybridNames {
 		"hir", "gaz", "sun", "gat",
 		"pi", "cis", "ele", "ova"
 	};
-	static const unsigned int SYS_NAME_FRAGS = ((unsigned int)(sizeof(sys_names) / sizeof(char *)));
+
+	// add fragments to build a name
+	static const NamePart Parts[] = {
+		{ sys_names, COUNTOF(sys_names), 2, 3 }
+	};
 
 	void GetName(std::string &name, Random &rng)
 	{
-		// add fragments to build a name
-		int len = rng.Int32(2, 3);
-		for (int i = 0; i < len; i++) {
-			name += sys_names[rng.Int32(0, SYS_NAME_FRAGS - 1)];
-		}
-
-		name[0] = toupper(name[0]);
+		AppendName(name, rng, Parts);
 	}
 } // namespace HybridNames
 
 namespace Doomdark {
-	static const char *Prefixes[] = {
+	static constexpr std::string_view Prefixes[] = {
 		"img", "dol", "lor", "ush", "mor", "tal", "car", "ulf", "as", "tor", "ob", "f", "gl",
 		"s", "th", "gan", "mal", "im", "var", "hag", "zar", "anv", "ber", "kah", "ash", "du"
 	};
-	static const unsigned int PREFIX_FRAGS = ((unsigned int)(sizeof(Prefixes) / sizeof(char *)));
 
-	static const char *Midwords[] = {
+	static constexpr std::string_view Midwords[] = {
 		"ar", "or", "ir", "en", "orth", "angr", "igr", "ash", "el", "in", "ul", "atr", "orm", "udr", "is", "ildr"
 	};
-	static const unsigned int MIDWORD_FRAGS = ((unsigned int)(sizeof(Midwords) / sizeof(char *)));
 
-	static const char *Suffixes[] = {
+	static constexpr std::string_view Suffixes[] = {
 		"orn", "il", "iel", "im", "uk", "ium", "ia", "eon", "ay", "ak", "arg", "and", "ane", "esh", "ad", "un", "ne"
 	};
-	static const unsigned int SUFFIX_FRAGS = ((unsigned int)(sizeof(Suffixes) / sizeof(char *)));
+
+	// Doodarken a name
+	static const NamePart Parts[] = {
+		{ Prefixes, COUNTOF(Prefixes), 1, 1 },
+		{ Midwords, COUNTOF(Midwords), 1, 1 },
+		{ Suffixes, COUNTOF(Suffixes), 1, 1 }
+	};
 
 	void GetName(std::string &name, Random &rng)
 	{
-		// Doodarken a name
-		name += Prefixes[rng.Int32(0, PREFIX_FRAGS - 1)];
-		name += Midwords[rng.Int32(0, MIDWORD_FRAGS - 1)];
-		name += Suffixes[rng.Int32(0, SUFFIX_FRAGS - 1)];
-
-		name[0] = toupper(name[0]);
+		AppendName(name, rng, Parts);
 	}
 } // namespace Doomdark
 
 namespace Katakana {
 	// clang-format off
-	static const char *StartFragments[] = {
+	static constexpr std::string_view StartFragments[] = {
 		"kyo","gyo","shu","sho","chu","cho","hyu","myo",
 		"ryu","chi","tsu","shi","ka","ki","ku","ke",
 		"ko","ga","gi","gu","ge","go","sa","su",
@@ -131,7 +162,7 @@ namespace Katakana {
 		"ru","wa","jo","a","i","u","e","o",
 
 	};
-	static const char *MiddleFragments[] = {
+	static constexpr std::string_view MiddleFragments[] = {
 		"sshi","ppo","tto","mbo","kka","kyu","sho","chu",
 		"chi","tsu","shi","ka","ki","ku","ke","ko",
 		"ga","gi","gu","ge","go","sa","su","se",
@@ -142,7 +173,7 @@ namespace Katakana {
 		"ra","ri","ru","re","ro","wa","ju","jo",
 		"a","i","u","e","o","n",
 	};
-	static const char *EndFragments[] = {
+	static constexpr std::string_view EndFragments[] = {
 		"ttsu","ppu","ssa","tto","tte","noh","mba","kko",
 		"kyo","shu","chu","nyu","nyo","ryu","chi","tsu",
 		"shi","ka","ki","ku","ke","ko","ga","gi",
@@ -156,25 +187,16 @@ namespace Katakana {
 	};
 	// clang-format on
 
-	static const unsigned int NUM_START_FRAGS = COUNTOF(StartFragments);
-	static const unsigned int NUM_MIDDLE_FRAGS = COUNTOF(MiddleFragments);
-	static const unsigned int NUM_END_FRAGS = COUNTOF(EndFragments);
+
+	// beginning, up to two middle fragments, and end
+	static const NamePart Parts[] = {
+		{ StartFragments, COUNTOF(StartFragments), 1, 1 },
+		{ MiddleFragments, COUNTOF(MiddleFragments), 0, 2 },
+		{ EndFragments, COUNTOF(EndFragments), 1, 1 }
+	};
 
 	void GetName(std::string &name, Random &rng)
 	{
-		// beginning
-		name += StartFragments[rng.Int32(0, NUM_START_FRAGS - 1)];
-
-		// middle
-		size_t count = rng.Int32(0, 2);
-		for (size_t i = 0; i < count; i++) {
-			name += MiddleFragments[rng.Int32(0, NUM_MIDDLE_FRAGS - 1)];
-		}
-
-		// end
-		name += EndFragments[rng.Int32(0, NUM_END_FRAGS - 1)];
-
-		// Capitalisation
-		name[0] = toupper(name[0]);
+		AppendName(name, rng, Parts);
 	}
 } // namespace Katakana
@@ -5,9 +5,12 @@
 
 #include "Random.h"
 #include <string>
+#include <vector>
 
 namespace NameGenerator {
 	void GetSystemName(std::string &name, Random &rng);
+	// appends count names, the same ones count calls to GetSystemName() give
+	void GetSystemNames(std::vector<std::string> &names, size_t count, Random &rng);
 }
 
 namespace FrontierNames {
@@ -0,0 +1,298 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "RoutePlanner.h"
+
+#include "MathUtil.h"
+#include "Sector.h"
+#include "profiler/Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+
+// past this many systems the graph is started again
+static const size_t MAX_GRAPH_NODES = 1 << 18;
+
+float RoutePlanner::JumpCost::GetDuration(float dist) const
+{
+	if (durations.size() < 2 || dist > range)
+		return INFINITY;
+
+	const float t = dist / range * float(durations.size() - 1);
+	const size_t i = std::min(size_t(t), durations.size() - 2);
+	const float frac = t - float(i);
+	return durations[i] + (durations[i + 1] - durations[i]) * frac;
+}
+
+float RoutePlanner::JumpCost::GetMinDurationPerLy() const
+{
+	// interpolating linearly between the samples, the time per light year is
+	// at its least at one of them
+	float perLy = INFINITY;
+	for (size_t i = 1; i < durations.size(); i++)
+		perLy = std::min(perLy, durations[i] / (range * float(i) / float(durations.size() - 1)));
+	return std::max(perLy, 0.0f);
+}
+
+int RoutePlanner::JumpGraph::GetSectorReach() const
+{
+	return int(std::ceil(edgeRange / Sector::SIZE));
+}
+
+void RoutePlanner::JumpGraph::MergeIncoming()
+{
+	std::vector<std::pair<SystemPath, std::vector<Node>>> added;
+	{
+		std::lock_guard<std::mutex> guard(incomingLock);
+		added.swap(incoming);
+	}
+
+	const int reach = GetSectorReach();
+	for (auto &sector : added) {
+		if (sectors.find(sector.first) != sectors.end())
+			continue;
+
+		std::vector<Uint32> &ids = sectors[sector.first];
+		for (Node &node : sector.second) {
+			ids.push_back(nodes.size());
+			nodeIds[node.path] = nodes.size();
+			nodes.push_back(node);
+			edges.emplace_back();
+			edgesValid.push_back(false);
+		}
+
+		// the systems in range of the new ones can jump to them now
+		const SystemPath &sp = sector.first;
+		for (int sx = sp.sectorX - reach; sx <= sp.sectorX + reach; sx++) {
+			for (int sy = sp.sectorY - reach; sy <= sp.sectorY + reach; sy++) {
+				for (int sz = sp.sectorZ - reach; sz <= sp.sectorZ + reach; sz++) {
+					auto it = sectors.find(SystemPath(sx, sy, sz));
+					if (it == sectors.end())
+						continue;
+					for (Uint32 id : it->second)
+						edgesValid[id] = false;
+				}
+			}
+		}
+	}
+}
+
+void RoutePlanner::JumpGraph::SetRange(float range)
+{
+	// shorter ranges just stop part way along the sorted edges
+	if (range <= edgeRange)
+		return;
+	edgeRange = range;
+	std::fill(edgesValid.begin(), edgesValid.end(), false);
+}
+
+const std::vector<RoutePlanner::Edge> &RoutePlanner::JumpGraph::GetEdges(Uint32 node)
+{
+	std::vector<Edge> &out = edges[node];
+	if (edgesValid[node])
+		return out;
+
+	out.clear();
+	const Node &from = nodes[node];
+	const float rangeSqr = edgeRange * edgeRange;
+	const int reach = GetSectorReach();
+	for (int sx = from.path.sectorX - reach; sx <= from.path.sectorX + reach; sx++) {
+		for (int sy = from.path.sectorY - reach; sy <= from.path.sectorY + reach; sy++) {
+			for (int sz = from.path.sectorZ - reach; sz <= from.path.sectorZ + reach; sz++) {
+				auto it = sectors.find(SystemPath(sx, sy, sz));
+				if (it == sectors.end())
+					continue;
+				for (Uint32 id : it->second) {
+					const float distSqr = (nodes[id].pos - from.pos).LengthSqr();
+					if (id != node && distSqr <= rangeSqr)
+						out.push_back({ id, std::sqrt(distSqr) });
+				}
+			}
+		}
+	}
+	std::sort(out.begin(), out.end(), [](const Edge &a, const Edge &b) { return a.length < b.length; });
+	edgesValid[node] = true;
+	return out;
+}
+
+class RoutePlanner::RouteJob : public Job {
+public:
+	RouteJob(RoutePlanner *planner, std::shared_ptr<JumpGraph> graph, const Node &start, const Node &target, const JumpCost &cost, float maxDistFromLine) :
+		Job(PRIORITY_HIGH),
+		m_planner(planner),
+		m_graph(graph),
+		m_start(start),
+		m_target(target),
+		m_cost(cost),
+		m_maxDistFromLine(maxDistFromLine),
+		m_status(ROUTE_NO_VALID_ROUTE)
+	{}
+
+	void OnRun() override // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
+	{
+		PROFILE_SCOPED()
+		std::lock_guard<std::mutex> guard(m_graph->lock);
+		m_graph->MergeIncoming();
+		m_graph->SetRange(m_cost.range);
+		Search();
+	}
+
+	void OnFinish() override
+	{
+		m_planner->OnJobFinished(m_status, std::move(m_route));
+	}
+
+private:
+	void Search()
+	{
+		JumpGraph &graph = *m_graph;
+		auto startIt = graph.nodeIds.find(m_start.path);
+		auto targetIt = graph.nodeIds.find(m_target.path);
+		if (startIt == graph.nodeIds.end() || targetIt == graph.nodeIds.end())
+			return;
+		const Uint32 start = startIt->second;
+		const Uint32 target = targetIt->second;
+
+		const size_t numNodes = graph.nodes.size();
+		std::vector<float> cost(numNodes, INFINITY);
+		std::vector<Uint32> prev(numNodes, start);
+		std::vector<bool> closed(numNodes, false);
+		// 0 not yet tested, 1 can be part of the route, 2 can't
+		std::vector<Uint8> allowed(numNodes, 0);
+
+		// the systems the search is limited to: close to the line, and no
+		// further from either end than 110% of the distance between them
+		const float limitSqr = (m_target.pos - m_start.pos).LengthSqr() * 1.10f;
+		auto isAllowed = [&](Uint32 id) {
+			if (!allowed[id]) {
+				const vector3f &pos = graph.nodes[id].pos;
+				const bool inside = (pos - m_start.pos).LengthSqr() <= limitSqr &&
+					(pos - m_target.pos).LengthSqr() <= limitSqr &&
+					MathUtil::DistanceFromLine(m_start.pos, m_target.pos, pos) < m_maxDistFromLine;
+				allowed[id] = inside ? 1 : 2;
+			}
+			return allowed[id] == 1;
+		};
+
+		// no jump is quicker than this per light year, so it never
+		// overestimates the time left to the target
+		const float minPerLy = m_cost.GetMinDurationPerLy();
+		auto estimate = [&](Uint32 id) {
+			return (graph.nodes[id].pos - m_target.pos).Length() * minPerLy;
+		};
+
+		typedef std::pair<float, Uint32> OpenNode;
+		std::priority_queue<OpenNode, std::vector<OpenNode>, std::greater<OpenNode>> open;
+		cost[start] = 0.0f;
+		open.push({ estimate(start), start });
+
+		size_t expanded = 0;
+		while (!open.empty()) {
+			if ((++expanded & 0x3ff) == 0 && IsCancelled())
+				return;
+
+			const Uint32 u = open.top().second;
+			open.pop();
+			if (closed[u])
+				continue;
+			closed[u] = true;
+
+			if (u == target) {
+				for (Uint32 v = target; v != start; v = prev[v])
+					m_route.push_back(graph.nodes[v].path);
+				std::reverse(m_route.begin(), m_route.end());
+				m_status = ROUTE_OKAY;
+				return;
+			}
+
+			for (const Edge &edge : graph.GetEdges(u)) {
+				if (edge.length > m_cost.range)
+					break;
+				if (closed[edge.to] || !isAllowed(edge.to))
+					continue;
+
+				const float newCost = cost[u] + m_cost.GetDuration(edge.length);
+				if (newCost < cost[edge.to]) {
+					cost[edge.to] = newCost;
+					prev[edge.to] = u;
+					open.push({ newCost + estimate(edge.to), edge.to });
+				}
+			}
+		}
+	}
+
+	RoutePlanner *m_planner;
+	std::shared_ptr<JumpGraph> m_graph;
+	Node m_start;
+	Node m_target;
+	JumpCost m_cost;
+	float m_maxDistFromLine;
+
+	Status m_status;
+	std::vector<SystemPath> m_route;
+};
+
+RoutePlanner::RoutePlanner(JobQueue *queue) :
+	m_queue(queue),
+	m_graph(std::make_shared<JumpGraph>()),
+	m_numNodes(0),
+	m_status(ROUTE_NONE)
+{
+}
+
+RoutePlanner::~RoutePlanner()
+{
+}
+
+bool RoutePlanner::HasSector(const SystemPath &sectorPath) const
+{
+	return m_knownSectors.find(sectorPath) != m_knownSectors.end();
+}
+
+void RoutePlanner::AddSector(const SystemPath &sectorPath, std::vector<Node> systems)
+{
+	if (HasSector(sectorPath))
+		return;
+	m_knownSectors[sectorPath] = true;
+	m_numNodes += systems.size();
+
+	std::lock_guard<std::mutex> guard(m_graph->incomingLock);
+	m_graph->incoming.emplace_back(sectorPath, std::move(systems));
+}
+
+void RoutePlanner::RequestRoute(const Node &start, const Node &target, const JumpCost &cost, float maxDistFromLine)
+{
+	m_route.clear();
+	m_status = ROUTE_PENDING;
+	m_job = m_queue->Queue(new RouteJob(this, m_graph, start, target, cost, maxDistFromLine));
+}
+
+void RoutePlanner::CancelRoute()
+{
+	m_job = Job::Handle();
+	if (m_status == ROUTE_PENDING)
+		m_status = ROUTE_NONE;
+}
+
+void RoutePlanner::Clear()
+{
+	CancelRoute();
+	// a search still running keeps the old graph alive until it stops
+	m_graph = std::make_shared<JumpGraph>();
+	m_knownSectors.clear();
+	m_numNodes = 0;
+}
+
+void RoutePlanner::OnJobFinished(Status status, std::vector<SystemPath> &&route)
+{
+	m_job = Job::Handle();
+	m_status = status;
+	m_route = std::move(route);
+
+	if (m_numNodes > MAX_GRAPH_NODES)
+		Clear();
+
+	onRouteFinished.emit(m_status);
+}
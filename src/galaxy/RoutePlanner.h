@@ -0,0 +1,119 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _ROUTEPLANNER_H
+#define _ROUTEPLANNER_H
+
+#include "JobQueue.h"
+#include "core/FlatHashMap.h"
+#include "galaxy/SystemPath.h"
+#include "vector3.h"
+
+#include <sigc++/sigc++.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Plans multi-jump hyperspace routes with an A* search over a graph of the
+// systems within jump range of each other.
+//
+// The graph is kept between requests: systems are added to it a sector at a
+// time as routes need them, and the jumps out of each system are worked out
+// the first time a search reaches it. They're found for the longest range
+// asked for so far, so a shorter drive searches the same graph, and only a
+// longer one throws the jumps away to be found again.
+//
+// Searches run on a worker thread of the given queue. Everything else, and
+// onRouteFinished, happens on the main thread.
+class RoutePlanner {
+public:
+	struct Node {
+		SystemPath path;
+		vector3f pos; // in light years from the galaxy origin
+	};
+
+	// The duration of a jump, sampled from the hyperdrive at evenly spaced
+	// distances from zero up to its range so it can be evaluated off the main
+	// thread. Durations in between are interpolated.
+	struct JumpCost {
+		float range = 0.0f;
+		std::vector<float> durations;
+
+		float GetDuration(float dist) const;
+		// the least time a light year can take, for the search's heuristic
+		float GetMinDurationPerLy() const;
+	};
+
+	enum Status {
+		ROUTE_NONE,
+		ROUTE_PENDING,
+		ROUTE_OKAY,
+		ROUTE_NO_VALID_ROUTE
+	};
+
+	RoutePlanner(JobQueue *queue);
+	~RoutePlanner();
+
+	bool HasSector(const SystemPath &sectorPath) const;
+	// Adds the systems of a sector so routes can pass through it.
+	void AddSector(const SystemPath &sectorPath, std::vector<Node> systems);
+
+	// Starts looking for the quickest route from start to target, cancelling
+	// any search still running. Only systems no further than maxDistFromLine
+	// from the straight line between them are considered.
+	void RequestRoute(const Node &start, const Node &target, const JumpCost &cost, float maxDistFromLine);
+	void CancelRoute();
+
+	Status GetStatus() const { return m_status; }
+	// The systems jumped to after start, ending with the target.
+	const std::vector<SystemPath> &GetRoute() const { return m_route; }
+
+	// Forgets the graph, such as when the galaxy changes.
+	void Clear();
+
+	sigc::signal<void, Status> onRouteFinished;
+
+private:
+	struct Edge {
+		Uint32 to;
+		float length;
+	};
+
+	// The jump graph, shared with the search using it.
+	struct JumpGraph {
+		// held by the search for as long as it runs
+		std::mutex lock;
+		std::vector<Node> nodes;
+		// sorted by length, and only meaningful where edgesValid is set
+		std::vector<std::vector<Edge>> edges;
+		std::vector<bool> edgesValid;
+		float edgeRange = 0.0f;
+		FlatHashMap<SystemPath, std::vector<Uint32>, SystemPath::HashSectorOnly, SystemPath::EqualSectorOnly> sectors;
+		FlatHashMap<SystemPath, Uint32, SystemPath::HashSystemOnly, SystemPath::EqualSystemOnly> nodeIds;
+
+		// sectors added on the main thread, merged in by the next search
+		std::mutex incomingLock;
+		std::vector<std::pair<SystemPath, std::vector<Node>>> incoming;
+
+		void MergeIncoming();
+		void SetRange(float range);
+		const std::vector<Edge> &GetEdges(Uint32 node);
+		int GetSectorReach() const;
+	};
+
+	class RouteJob;
+	friend class RouteJob;
+
+	void OnJobFinished(Status status, std::vector<SystemPath> &&route);
+
+	JobQueue *m_queue;
+	std::shared_ptr<JumpGraph> m_graph;
+	FlatHashMap<SystemPath, bool, SystemPath::HashSectorOnly, SystemPath::EqualSectorOnly> m_knownSectors;
+	size_t m_numNodes;
+
+	Job::Handle m_job;
+	Status m_status;
+	std::vector<SystemPath> m_route;
+};
+
+#endif /* _ROUTEPLANNER_H */
@@ -45,6 +45,11 @@ float Sector::DistanceBetweenSqr(const RefCountedPtr<const Sector> a, const int
 	return dv.LengthSqr();
 }
 
+size_t Sector::GetMemoryUsage() const
+{
+	return sizeof(Sector) + m_systems.capacity() * sizeof(System) + m_names.capacity();
+}
+
 bool Sector::WithinBox(const int Xmin, const int Xmax, const int Ymin, const int Ymax, const int Zmin, const int Zmax) const
 {
 	PROFILE_SCOPED()
@@ -69,10 +74,36 @@ bool Sector::Contains(const SystemPath &sysPath) const
 	return true;
 }
 
+void Sector::System::SetNames(std::string_view name, const std::vector<std::string> &otherNames)
+{
+	std::string &names = m_sector->m_names;
+	m_nameOffset = names.size();
+	m_nameLength = std::min<size_t>(name.size(), 0xffff);
+	names.append(name.data(), m_nameLength);
+	names.push_back('\0');
+
+	m_numOtherNames = std::min<size_t>(otherNames.size(), 0xffff);
+	for (Uint16 n = 0; n < m_numOtherNames; n++)
+		names.append(otherNames[n].c_str(), otherNames[n].size() + 1);
+}
+
+std::vector<std::string> Sector::System::GetOtherNames() const
+{
+	std::vector<std::string> otherNames;
+	otherNames.reserve(m_numOtherNames);
+	const char *name = m_sector->m_names.c_str() + m_nameOffset + m_nameLength + 1;
+	for (Uint16 n = 0; n < m_numOtherNames; n++) {
+		otherNames.emplace_back(name);
+		name += otherNames.back().size() + 1;
+	}
+	return otherNames;
+}
+
 void Sector::System::SetExplored(StarSystem::ExplorationState e, double time)
 {
 	if (e != m_explored) {
 		m_sector->onSetExplorationState.emit(this, e, time);
+		m_sector->m_galaxy->GetSpatialIndex().UpdateExplored(GetPath(), e);
 		m_explored = e;
 		m_exploredTime = time;
 	}
@@ -85,7 +116,7 @@ void Sector::Dump(FILE *file, const char *indent) const
 	for (const Sector::System &sys : m_systems) {
 		assert(sx == sys.sx && sy == sys.sy && sz == sys.sz);
 		fprintf(file, "\tSystem(%d,%d,%d,%u) {\n", sys.sx, sys.sy, sys.sz, sys.idx);
-		fprintf(file, "\t\t\"%s\"\n", sys.GetName().c_str());
+		fprintf(file, "\t\t\"%s\"\n", std::string(sys.GetName()).c_str());
 		fprintf(file, "\t\t%sEXPLORED%s\n", sys.IsExplored() ? "" : "UN", sys.GetCustomSystem() != nullptr ? ", CUSTOM" : "");
 		fprintf(file, "\t\tfaction %s%s%s\n", sys.GetFaction() ? "\"" : "NONE", sys.GetFaction() ? sys.GetFaction()->name.c_str() : "", sys.GetFaction() ? "\"" : "");
 		fprintf(file, "\t\tpos (%f, %f, %f)\n", double(sys.GetPosition().x), double(sys.GetPosition().y), double(sys.GetPosition().z));
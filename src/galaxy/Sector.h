@@ -12,6 +12,7 @@
 
 #include <sigc++/signal.h>
 #include <string>
+#include <string_view>
 #include <vector>
 
 class Faction;
@@ -44,27 +45,34 @@ public:
 			sz(z),
 			idx(si),
 			m_sector(sector),
-			m_numStars(0),
+			m_nameOffset(0),
+			m_nameLength(0),
+			m_numOtherNames(0),
 			m_seed(0),
+			m_numStars(0),
+			m_starType{},
+			m_explored(StarSystem::eUNEXPLORED),
 			m_customSys(nullptr),
 			m_faction(nullptr),
 			m_population(-1),
-			m_explored(StarSystem::eUNEXPLORED),
 			m_exploredTime(0.0) {}
 
 		static float DistanceBetween(const System *a, const System *b);
 
 		// Check that we've had our habitation status set
 
-		const std::string &GetName() const { return m_name; }
-		const std::vector<std::string> &GetOtherNames() const { return m_other_names; }
+		// Names live in the sector's name pool, so the view is only valid
+		// for as long as the sector is (and not across generating others).
+		// It's null terminated, so data() is a C string.
+		std::string_view GetName() const { return std::string_view(m_sector->m_names.data() + m_nameOffset, m_nameLength); }
+		std::vector<std::string> GetOtherNames() const;
 		const vector3f &GetPosition() const { return m_pos; }
 		vector3f GetFullPosition() const { return Sector::SIZE * vector3f(float(sx), float(sy), float(sz)) + m_pos; };
 		unsigned GetNumStars() const { return m_numStars; }
 		SystemBody::BodyType GetStarType(unsigned i) const
 		{
 			assert(i < m_numStars);
-			return m_starType[i];
+			return SystemBody::BodyType(m_starType[i]);
 		}
 		Uint32 GetSeed() const { return m_seed; }
 		const CustomSystem *GetCustomSystem() const { return m_customSys; }
@@ -75,7 +83,7 @@ public:
 		}
 		fixed GetPopulation() const { return m_population; }
 		void SetPopulation(fixed pop) { m_population = pop; }
-		StarSystem::ExplorationState GetExplored() const { return m_explored; }
+		StarSystem::ExplorationState GetExplored() const { return StarSystem::ExplorationState(m_explored); }
 		double GetExploredTime() const { return m_exploredTime; }
 		bool IsExplored() const { return m_explored != StarSystem::eUNEXPLORED; }
 		void SetExplored(StarSystem::ExplorationState e, double time);
@@ -98,20 +106,26 @@ public:
 		friend class SectorCustomSystemsGenerator;
 		friend class SectorRandomSystemsGenerator;
 		friend class SectorPersistenceGenerator;
+		friend class SectorDatabase;
 
 		void AssignFaction() const;
+		// appends the names to the sector's pool; once per system
+		void SetNames(std::string_view name, const std::vector<std::string> &otherNames = {});
 
+		// ordered to pack the small fields together, as sectors are
+		// cached by the thousand
 		Sector *m_sector;
-		std::string m_name;
-		std::vector<std::string> m_other_names;
+		Uint32 m_nameOffset; // into m_sector->m_names; other names follow
+		Uint16 m_nameLength;
+		Uint16 m_numOtherNames;
 		vector3f m_pos;
-		unsigned m_numStars;
-		SystemBody::BodyType m_starType[4];
 		Uint32 m_seed;
+		Uint8 m_numStars;
+		Uint8 m_starType[4]; // SystemBody::BodyType
+		Uint8 m_explored; // StarSystem::ExplorationState
 		const CustomSystem *m_customSys;
 		mutable const Faction *m_faction; // mutable because we only calculate on demand
 		fixed m_population;
-		StarSystem::ExplorationState m_explored;
 		double m_exploredTime;
 	};
 	std::vector<System> m_systems;
@@ -119,6 +133,9 @@ public:
 
 	void Dump(FILE *file, const char *indent = "") const;
 
+	// Estimated heap footprint in bytes, for the SectorCache budget
+	size_t GetMemoryUsage() const;
+
 	sigc::signal<void, Sector::System *, StarSystem::ExplorationState, double> onSetExplorationState;
 
 private:
@@ -127,6 +144,8 @@ private:
 
 	RefCountedPtr<Galaxy> m_galaxy;
 	SectorCache *m_cache;
+	// every system's names, each null terminated, all in one allocation
+	std::string m_names;
 
 	// Only SectorCache(Job) are allowed to create sectors
 	Sector(RefCountedPtr<Galaxy> galaxy, const SystemPath &path, SectorCache *cache);
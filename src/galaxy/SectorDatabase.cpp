@@ -0,0 +1,282 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "SectorDatabase.h"
+
+#include "CustomSystem.h"
+#include "Galaxy.h"
+#include "Sector.h"
+#include "core/Log.h"
+#include "profiler/Profiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <tuple>
+
+namespace {
+	static const char MAGIC[8] = { 'P', 'I', 'O', 'N', 'S', 'E', 'C', 'S' };
+	// bump whenever the layout of the records changes
+	static const Uint32 FORMAT_VERSION = 1;
+
+	struct FileHeader {
+		char magic[8];
+		Uint32 formatVersion;
+		Sint32 generatorVersion;
+		char generatorName[16];
+		Uint32 numSectors;
+		Uint32 numSystems;
+		Uint32 stringsSize;
+		Uint32 padding;
+	};
+
+	struct SectorRecord {
+		Sint32 x, y, z;
+		Uint32 firstSystem;
+		Uint32 numSystems;
+		// the custom systems come first in the sector
+		Uint32 numCustomSystems;
+	};
+
+	struct SystemRecord {
+		float pos[3];
+		Uint32 seed;
+		Uint32 name;
+		Uint32 otherNames; // numOtherNames names one after another
+		Uint16 numOtherNames;
+		Uint8 numStars;
+		Uint8 explored;
+		Uint8 starType[4];
+	};
+
+	static_assert(sizeof(FileHeader) == 48, "FileHeader is padded");
+	static_assert(sizeof(SectorRecord) == 24, "SectorRecord is padded");
+	static_assert(sizeof(SystemRecord) == 32, "SystemRecord is padded");
+
+	bool SectorLess(const SectorRecord &a, const SectorRecord &b)
+	{
+		return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z);
+	}
+
+	const FileHeader *GetHeader(const FileSystem::FileData &file)
+	{
+		return reinterpret_cast<const FileHeader *>(file.GetData());
+	}
+
+	const SectorRecord *GetSectors(const FileSystem::FileData &file)
+	{
+		return reinterpret_cast<const SectorRecord *>(file.GetData() + sizeof(FileHeader));
+	}
+
+	const SystemRecord *GetSystems(const FileSystem::FileData &file)
+	{
+		return reinterpret_cast<const SystemRecord *>(GetSectors(file) + GetHeader(file)->numSectors);
+	}
+
+	const char *GetStrings(const FileSystem::FileData &file)
+	{
+		return reinterpret_cast<const char *>(GetSystems(file) + GetHeader(file)->numSystems);
+	}
+} // namespace
+
+//static
+std::string SectorDatabase::GetFileName(const std::string &generatorName, int generatorVersion)
+{
+	return "sectors_" + generatorName + "_v" + std::to_string(generatorVersion) + ".db";
+}
+
+//static
+RefCountedPtr<SectorDatabase> SectorDatabase::Load(const std::string &generatorName, int generatorVersion)
+{
+	PROFILE_SCOPED()
+	const std::string fileName = GetFileName(generatorName, generatorVersion);
+	RefCountedPtr<FileSystem::FileData> file = FileSystem::userFiles.MapFile(fileName);
+	if (!file)
+		return RefCountedPtr<SectorDatabase>();
+
+	RefCountedPtr<SectorDatabase> db(new SectorDatabase(file));
+	if (!db->IsValid(generatorName, generatorVersion)) {
+		Log::Warning("Ignoring sector database {}: it's corrupt or for a different version of the game.\n", fileName);
+		return RefCountedPtr<SectorDatabase>();
+	}
+	Output("Using sector database %s with %zu sectors\n", fileName.c_str(), db->GetNumSectors());
+	return db;
+}
+
+SectorDatabase::SectorDatabase(RefCountedPtr<FileSystem::FileData> file) :
+	m_file(file)
+{
+}
+
+bool SectorDatabase::IsValid(const std::string &generatorName, int generatorVersion) const
+{
+	if (m_file->GetSize() < sizeof(FileHeader))
+		return false;
+
+	const FileHeader *header = GetHeader(*m_file);
+	if (memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->formatVersion != FORMAT_VERSION ||
+		header->generatorVersion != generatorVersion ||
+		strncmp(header->generatorName, generatorName.c_str(), sizeof(header->generatorName)) != 0)
+		return false;
+
+	// also rejects truncated files
+	const size_t expectedSize = sizeof(FileHeader) + size_t(header->numSectors) * sizeof(SectorRecord) +
+		size_t(header->numSystems) * sizeof(SystemRecord) + header->stringsSize;
+	if (m_file->GetSize() != expectedSize)
+		return false;
+
+	// so every in range offset reads a terminated string
+	if (header->stringsSize == 0 || GetStrings(*m_file)[header->stringsSize - 1] != '\0')
+		return false;
+
+	const SectorRecord *sectors = GetSectors(*m_file);
+	for (Uint32 i = 0; i < header->numSectors; i++) {
+		if (Uint64(sectors[i].firstSystem) + sectors[i].numSystems > header->numSystems ||
+			sectors[i].numCustomSystems > sectors[i].numSystems)
+			return false;
+		if (i > 0 && !SectorLess(sectors[i - 1], sectors[i]))
+			return false;
+	}
+	return true;
+}
+
+size_t SectorDatabase::GetNumSectors() const
+{
+	return GetHeader(*m_file)->numSectors;
+}
+
+const char *SectorDatabase::GetString(Uint32 offset) const
+{
+	return offset < GetHeader(*m_file)->stringsSize ? GetStrings(*m_file) + offset : nullptr;
+}
+
+bool SectorDatabase::FillSector(Galaxy *galaxy, Sector *sector) const
+{
+	PROFILE_SCOPED()
+	assert(sector->m_systems.empty());
+	const FileHeader *header = GetHeader(*m_file);
+	const SectorRecord *sectors = GetSectors(*m_file);
+	const SectorRecord *sectorsEnd = sectors + header->numSectors;
+
+	SectorRecord key = {};
+	key.x = sector->sx;
+	key.y = sector->sy;
+	key.z = sector->sz;
+	const SectorRecord *rec = std::lower_bound(sectors, sectorsEnd, key, SectorLess);
+	if (rec == sectorsEnd || SectorLess(key, *rec))
+		return false;
+
+	const SystemRecord *systems = GetSystems(*m_file) + rec->firstSystem;
+
+	// the custom systems must be the ones the sector was baked with
+	const std::vector<const CustomSystem *> &customSystems = galaxy->GetCustomSystems()->GetCustomSystemsForSector(sector->sx, sector->sy, sector->sz);
+	if (customSystems.size() != rec->numCustomSystems)
+		return false;
+	for (Uint32 i = 0; i < rec->numCustomSystems; i++) {
+		const char *name = GetString(systems[i].name);
+		if (systems[i].seed != customSystems[i]->seed || !name || customSystems[i]->name != name)
+			return false;
+	}
+
+	sector->m_systems.reserve(rec->numSystems);
+	for (Uint32 i = 0; i < rec->numSystems; i++) {
+		const SystemRecord &sysrec = systems[i];
+		const char *name = GetString(sysrec.name);
+		if (!name || sysrec.numStars > 4) {
+			sector->m_systems.clear();
+			return false;
+		}
+
+		Sector::System s(sector, sector->sx, sector->sy, sector->sz, i);
+		s.m_pos = vector3f(sysrec.pos[0], sysrec.pos[1], sysrec.pos[2]);
+		s.m_seed = sysrec.seed;
+		s.m_numStars = sysrec.numStars;
+		for (unsigned star = 0; star < s.m_numStars; star++)
+			s.m_starType[star] = SystemBody::BodyType(sysrec.starType[star]);
+		s.m_explored = StarSystem::ExplorationState(sysrec.explored);
+		if (i < rec->numCustomSystems)
+			s.m_customSys = customSystems[i];
+
+		std::vector<std::string> otherNames;
+		Uint32 otherName = sysrec.otherNames;
+		for (Uint16 n = 0; n < sysrec.numOtherNames; n++) {
+			const char *str = GetString(otherName);
+			if (!str)
+				break;
+			otherNames.emplace_back(str);
+			otherName += otherNames.back().size() + 1;
+		}
+		s.SetNames(name, otherNames);
+		sector->m_systems.push_back(std::move(s));
+	}
+	return true;
+}
+
+Uint32 SectorDatabase::Writer::AddString(std::string_view str)
+{
+	const Uint32 offset = m_strings.size();
+	m_strings.insert(m_strings.end(), str.begin(), str.end());
+	m_strings.push_back('\0');
+	return offset;
+}
+
+void SectorDatabase::Writer::AddSector(const Sector &sector)
+{
+	SectorRecord rec = {};
+	rec.x = sector.sx;
+	rec.y = sector.sy;
+	rec.z = sector.sz;
+	rec.firstSystem = m_numSystems;
+	rec.numSystems = sector.m_systems.size();
+
+	for (const Sector::System &s : sector.m_systems) {
+		SystemRecord sysrec = {};
+		const vector3f &pos = s.GetPosition();
+		sysrec.pos[0] = pos.x;
+		sysrec.pos[1] = pos.y;
+		sysrec.pos[2] = pos.z;
+		sysrec.seed = s.GetSeed();
+		sysrec.name = AddString(s.GetName());
+		const std::vector<std::string> otherNames = s.GetOtherNames();
+		sysrec.numOtherNames = std::min<size_t>(otherNames.size(), 0xffff);
+		sysrec.otherNames = m_strings.size();
+		for (Uint16 n = 0; n < sysrec.numOtherNames; n++)
+			AddString(otherNames[n]);
+		sysrec.numStars = s.GetNumStars();
+		for (unsigned star = 0; star < s.GetNumStars(); star++)
+			sysrec.starType[star] = Uint8(s.GetStarType(star));
+		sysrec.explored = Uint8(s.GetExplored());
+		if (s.GetCustomSystem())
+			rec.numCustomSystems++;
+
+		const char *bytes = reinterpret_cast<const char *>(&sysrec);
+		m_systems.insert(m_systems.end(), bytes, bytes + sizeof(sysrec));
+		m_numSystems++;
+	}
+
+	const char *bytes = reinterpret_cast<const char *>(&rec);
+	m_sectors.insert(m_sectors.end(), bytes, bytes + sizeof(rec));
+	m_numSectors++;
+}
+
+bool SectorDatabase::Writer::Write(FILE *f, const std::string &generatorName, int generatorVersion)
+{
+	FileHeader header = {};
+	memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.formatVersion = FORMAT_VERSION;
+	header.generatorVersion = generatorVersion;
+	strncpy(header.generatorName, generatorName.c_str(), sizeof(header.generatorName) - 1);
+	header.numSectors = m_numSectors;
+	header.numSystems = m_numSystems;
+	// never empty, so a reader can check the table is terminated
+	if (m_strings.empty())
+		m_strings.push_back('\0');
+	header.stringsSize = m_strings.size();
+
+	SectorRecord *sectors = reinterpret_cast<SectorRecord *>(m_sectors.data());
+	std::sort(sectors, sectors + m_numSectors, SectorLess);
+
+	return fwrite(&header, sizeof(header), 1, f) == 1 &&
+		(m_sectors.empty() || fwrite(m_sectors.data(), m_sectors.size(), 1, f) == 1) &&
+		(m_systems.empty() || fwrite(m_systems.data(), m_systems.size(), 1, f) == 1) &&
+		fwrite(m_strings.data(), m_strings.size(), 1, f) == 1;
+}
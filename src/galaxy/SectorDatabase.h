@@ -0,0 +1,69 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _SECTORDATABASE_H
+#define _SECTORDATABASE_H
+
+#include "FileSystem.h"
+#include "RefCounted.h"
+
+#include <SDL_stdinc.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+class Galaxy;
+class Sector;
+
+// Precomputed sectors, baked offline by the galaxycompiler tool.
+//
+// The file is laid out to be used in place from a read-only memory mapping:
+// a header, then fixed size sector records sorted by position, the system
+// records of all sectors one after another, and a table of nul terminated
+// names. Looking a sector up is a binary search of the mapped records, and
+// only the pages of the sectors asked for are ever read from disk.
+//
+// Only the stages of the sector generator which depend on nothing but the
+// galaxy are baked (see SectorGeneratorStage::IsBakeable()); the rest still
+// run on each sector read from the database. Records are in the host's byte
+// order, and a database which doesn't match the generator or the custom
+// systems loaded is ignored.
+class SectorDatabase : public RefCounted {
+public:
+	// Maps the database for the given generator from the user directory, or
+	// returns nothing if there isn't a usable one.
+	static RefCountedPtr<SectorDatabase> Load(const std::string &generatorName, int generatorVersion);
+	static std::string GetFileName(const std::string &generatorName, int generatorVersion);
+
+	size_t GetNumSectors() const;
+
+	// Fills an empty sector with its baked systems. Returns false, leaving
+	// the sector untouched, if the sector isn't in the database or its custom
+	// systems have changed since it was baked.
+	bool FillSector(Galaxy *galaxy, Sector *sector) const;
+
+	class Writer {
+	public:
+		void AddSector(const Sector &sector);
+		size_t GetNumSectors() const { return m_numSectors; }
+		bool Write(FILE *f, const std::string &generatorName, int generatorVersion);
+
+	private:
+		Uint32 AddString(std::string_view str);
+
+		std::vector<char> m_sectors;
+		std::vector<char> m_systems;
+		std::vector<char> m_strings;
+		size_t m_numSectors = 0;
+		size_t m_numSystems = 0;
+	};
+
+private:
+	SectorDatabase(RefCountedPtr<FileSystem::FileData> file);
+	bool IsValid(const std::string &generatorName, int generatorVersion) const;
+	const char *GetString(Uint32 offset) const;
+
+	RefCountedPtr<FileSystem::FileData> m_file;
+};
+
+#endif /* _SECTORDATABASE_H */
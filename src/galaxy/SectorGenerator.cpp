@@ -34,8 +34,7 @@ bool SectorCustomSystemsGenerator::Apply(Random &rng, RefCountedPtr<Galaxy> gala
 		const CustomSystem *cs = *it;
 		Sector::System s(sector.Get(), sx, sy, sz, sysIdx);
 		s.m_pos = cs->pos;
-		s.m_name = cs->name;
-		s.m_other_names = cs->other_names;
+		s.SetNames(cs->name, cs->other_names);
 		for (s.m_numStars = 0; s.m_numStars < cs->numStars; s.m_numStars++) {
 			if (cs->primaryType[s.m_numStars] == 0) break;
 			s.m_starType[s.m_numStars] = cs->primaryType[s.m_numStars];
@@ -319,8 +318,7 @@ bool SectorRandomSystemsGenerator::Apply(Random &rng, RefCountedPtr<Galaxy> gala
 			//Output("%d: %d%\n", sx, sy);
 		}
 
-		s.m_name = GenName(galaxy, *sector, s, customCount + i, rng);
-		//Output("%s: \n", s.m_name.c_str());
+		s.SetNames(GenName(galaxy, *sector, s, customCount + i, rng));
 
 		s.m_seed = rng.Int32();
 
@@ -331,6 +329,7 @@ bool SectorRandomSystemsGenerator::Apply(Random &rng, RefCountedPtr<Galaxy> gala
 
 void SectorPersistenceGenerator::SetExplored(Sector::System *sys, StarSystem::ExplorationState e, double time)
 {
+	std::lock_guard<std::mutex> lock(m_exploredLock);
 	if (e == StarSystem::eUNEXPLORED) {
 		m_exploredSystems.erase(sys->GetPath());
 	} else if (e == StarSystem::eEXPLORED_AT_START) {
@@ -348,6 +347,7 @@ void SectorPersistenceGenerator::SetExplored(Sector::System *sys, StarSystem::Ex
 bool SectorPersistenceGenerator::Apply(Random &rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<Sector> sector, GalaxyGenerator::SectorConfig *config)
 {
 	if (galaxy->IsInitialized()) {
+		std::lock_guard<std::mutex> lock(m_exploredLock);
 		for (Sector::System &secsys : sector->m_systems) {
 			const auto iter = m_exploredSystems.find(SystemPath(secsys.sx, secsys.sy, secsys.sz, secsys.idx));
 			if (iter != m_exploredSystems.end()) {
@@ -372,6 +372,7 @@ bool SectorPersistenceGenerator::Apply(Random &rng, RefCountedPtr<Galaxy> galaxy
 
 void SectorPersistenceGenerator::FromJson(const Json &jsonObj, RefCountedPtr<Galaxy> galaxy)
 {
+	std::lock_guard<std::mutex> lock(m_exploredLock);
 	m_exploredSystems.clear();
 	if (m_version < 1) {
 		return;
@@ -398,6 +399,7 @@ void SectorPersistenceGenerator::ToJson(Json &jsonObj, RefCountedPtr<Galaxy> gal
 	// It used to be stored by a general System-information container type called PersistSystemData<>.
 
 	Json dictArray = Json::array(); // Create JSON array to contain dict data.
+	std::lock_guard<std::mutex> lock(m_exploredLock);
 	for (const auto &element : m_exploredSystems) {
 		Json dictArrayEl({}); // Create JSON object to contain dict element.
 		element.first.ToJson(dictArrayEl);
@@ -10,6 +10,8 @@
 #include "Sector.h"
 #include "StarSystem.h"
 
+#include <mutex>
+
 class SectorCustomSystemsGenerator : public SectorGeneratorStage {
 public:
 	SectorCustomSystemsGenerator(int customOnlyRadius) :
@@ -32,6 +34,8 @@ class SectorPersistenceGenerator : public SectorGeneratorStage {
 public:
 	SectorPersistenceGenerator(GalaxyGenerator::Version version) :
 		m_version(version) {}
+	// explored state is part of the game, not the galaxy
+	virtual bool IsBakeable() const { return false; }
 	virtual bool Apply(Random &rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<Sector> sector, GalaxyGenerator::SectorConfig *config);
 	virtual void FromJson(const Json &jsonObj, RefCountedPtr<Galaxy> galaxy);
 	virtual void ToJson(Json &jsonObj, RefCountedPtr<Galaxy> galaxy);
@@ -52,6 +56,8 @@ private:
 	// Middle 4 bits (bits 5..8) -> Month.
 	// High bits (bits 9..) -> Year.
 	std::map<SystemPath, Sint32> m_exploredSystems;
+	// the map is read by sector generation on worker threads
+	std::mutex m_exploredLock;
 };
 
 #endif
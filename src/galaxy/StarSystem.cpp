@@ -221,6 +221,7 @@ SystemPath StarSystem::GetPathOf(const SystemBody *sbody) const
  */
 StarSystem::StarSystem(const SystemPath &path, RefCountedPtr<Galaxy> galaxy, StarSystemCache *cache, Random &rand) :
 	m_galaxy(galaxy),
+	m_generationLevel(GENERATED_ALL),
 	m_path(path.SystemOnly()),
 	m_numStars(0),
 	m_isCustom(false),
@@ -520,6 +521,22 @@ void StarSystem::ExportToLua(const char *filename)
 	fclose(f);
 }
 
+size_t StarSystem::GetMemoryUsage() const
+{
+	size_t size = sizeof(StarSystem) + m_name.capacity() + m_shortDesc.capacity() + m_longDesc.capacity();
+	size += m_other_names.capacity() * sizeof(std::string);
+	for (const std::string &name : m_other_names)
+		size += name.capacity();
+	size += m_bodies.capacity() * sizeof(RefCountedPtr<SystemBody>);
+	size += (m_spaceStations.capacity() + m_stars.capacity()) * sizeof(SystemBody *);
+	size += m_tradeLevel.capacity() * sizeof(int) + m_commodityLegal.capacity() / 8;
+	for (const RefCountedPtr<SystemBody> &body : m_bodies) {
+		size += sizeof(SystemBody) + body->m_children.capacity() * sizeof(SystemBody *);
+		size += body->m_name.capacity() + body->m_heightMapFilename.capacity() + body->m_spaceStationType.capacity();
+	}
+	return size;
+}
+
 void StarSystem::Dump(FILE *file, const char *indent, bool suppressSectorData) const
 {
 	if (suppressSectorData) {
@@ -38,6 +38,19 @@ public:
 		eEXPLORED_AT_START = 2
 	};
 
+	// How far a system has been generated, each level including the ones
+	// before it. Systems from the caches are complete unless asked for at a
+	// lower level with Galaxy::GetStarSystem(path, level), and the rest is
+	// only generated as it's asked for.
+	enum GenerationLevel {
+		GENERATED_SYSTEM = 0, // name, faction and exploration state, as in the sector
+		GENERATED_BODIES = 1, // stars, planets and moons
+		GENERATED_POPULATION = 2, // population, economy, government and trade
+		GENERATED_STATIONS = 3, // space stations
+		GENERATED_ALL = GENERATED_STATIONS
+	};
+	GenerationLevel GetGenerationLevel() const { return m_generationLevel; }
+
 	void ExportToLua(const char *filename);
 
 	const std::string &GetName() const { return m_name; }
@@ -97,6 +110,9 @@ public:
 
 	void Dump(FILE *file, const char *indent = "", bool suppressSectorData = false) const;
 
+	// Estimated heap footprint in bytes, for the StarSystemCache budget
+	size_t GetMemoryUsage() const;
+
 	// Dump all information about this system to JSON format suitable for
 	// loading as a custom system
 	void DumpToJson(Json &obj);
@@ -117,6 +133,8 @@ protected:
 	void MakeShortDescription();
 	void SetShortDesc(const std::string &desc) { m_shortDesc = desc; }
 
+	GenerationLevel m_generationLevel;
+
 private:
 	void SetCache(StarSystemCache *cache)
 	{
@@ -167,6 +185,11 @@ class StarSystem::GeneratorAPI : public StarSystem {
 private:
 	friend class GalaxyGenerator;
 
+	void SetGenerationLevel(GenerationLevel level) { m_generationLevel = level; }
+
+	// kept from the generation config for the stages left to run
+	bool m_isCustomOnly = false;
+
 public:
 	GeneratorAPI(const SystemPath &path, RefCountedPtr<Galaxy> galaxy, StarSystemCache *cache, Random &rand);
 
@@ -191,13 +191,13 @@ const StarSystemLegacyGeneratorBase::StarTypeInfo StarSystemLegacyGeneratorBase:
 bool StarSystemFromSectorGenerator::Apply(Random &rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<StarSystem::GeneratorAPI> system, GalaxyGenerator::StarSystemConfig *config)
 {
 	PROFILE_SCOPED()
-	RefCountedPtr<const Sector> sec = galaxy->GetSector(system->GetPath());
+	RefCountedPtr<const Sector> sec = config->sector;
 	assert(system->GetPath().systemIndex < sec->m_systems.size());
 	const Sector::System &secSys = sec->m_systems[system->GetPath().systemIndex];
 
 	system->SetFaction(galaxy->GetFactions()->GetNearestClaimant(&secSys));
 	system->SetSeed(secSys.GetSeed());
-	system->SetName(secSys.GetName());
+	system->SetName(std::string(secSys.GetName()));
 	system->SetOtherNames(secSys.GetOtherNames());
 	system->SetExplored(secSys.GetExplored(), secSys.GetExploredTime());
 	return true;
@@ -488,7 +488,7 @@ bool StarSystemCustomGenerator::ApplyToSystem(Random &rng, RefCountedPtr<StarSys
 bool StarSystemCustomGenerator::Apply(Random &rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<StarSystem::GeneratorAPI> system, GalaxyGenerator::StarSystemConfig *config)
 {
 	PROFILE_SCOPED()
-	RefCountedPtr<const Sector> sec = galaxy->GetSector(system->GetPath());
+	RefCountedPtr<const Sector> sec = config->sector;
 	system->SetCustom(false, false);
 
 	if (const CustomSystem *customSys = sec->m_systems[system->GetPath().systemIndex].GetCustomSystem())
@@ -1262,7 +1262,7 @@ void StarSystemRandomGenerator::MakeBinaryPair(SystemBody *a, SystemBody *b, fix
 bool StarSystemRandomGenerator::Apply(Random &rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<StarSystem::GeneratorAPI> system, GalaxyGenerator::StarSystemConfig *config)
 {
 	PROFILE_SCOPED()
-	RefCountedPtr<const Sector> sec = galaxy->GetSector(system->GetPath());
+	RefCountedPtr<const Sector> sec = config->sector;
 	const Sector::System &secSys = sec->m_systems[system->GetPath().systemIndex];
 
 	if (config->isCustomOnly)
@@ -1273,11 +1273,12 @@ bool StarSystemRandomGenerator::Apply(Random &rng, RefCountedPtr<Galaxy> galaxy,
 
 	const int numStars = secSys.GetNumStars();
 	assert((numStars >= 1) && (numStars <= 4));
+	const std::string sysName(secSys.GetName());
 	if (numStars == 1) {
 		SystemBody::BodyType type = sec->m_systems[system->GetPath().systemIndex].GetStarType(0);
 		star[0] = system->NewBody();
 		star[0]->m_parent = 0;
-		star[0]->m_name = sec->m_systems[system->GetPath().systemIndex].GetName();
+		star[0]->m_name = sysName;
 		star[0]->m_orbMin = fixed();
 		star[0]->m_orbMax = fixed();
 
@@ -1288,17 +1289,17 @@ bool StarSystemRandomGenerator::Apply(Random &rng, RefCountedPtr<Galaxy> galaxy,
 		centGrav1 = system->NewBody();
 		centGrav1->m_type = SystemBody::TYPE_GRAVPOINT;
 		centGrav1->m_parent = 0;
-		centGrav1->m_name = sec->m_systems[system->GetPath().systemIndex].GetName() + " A,B";
+		centGrav1->m_name = sysName + " A,B";
 		system->SetRootBody(centGrav1);
 
 		SystemBody::BodyType type = sec->m_systems[system->GetPath().systemIndex].GetStarType(0);
 		star[0] = system->NewBody();
-		star[0]->m_name = sec->m_systems[system->GetPath().systemIndex].GetName() + " A";
+		star[0]->m_name = sysName + " A";
 		star[0]->m_parent = centGrav1;
 		MakeStarOfType(star[0], type, rng);
 
 		star[1] = system->NewBody();
-		star[1]->m_name = sec->m_systems[system->GetPath().systemIndex].GetName() + " B";
+		star[1]->m_name = sysName + " B";
 		star[1]->m_parent = centGrav1;
 		MakeStarOfTypeLighterThan(star[1], sec->m_systems[system->GetPath().systemIndex].GetStarType(1), star[0]->GetMassAsFixed(), rng);
 
@@ -1320,7 +1321,7 @@ bool StarSystemRandomGenerator::Apply(Random &rng, RefCountedPtr<Galaxy> galaxy,
 			// 3rd and maybe 4th star
 			if (numStars == 3) {
 				star[2] = system->NewBody();
-				star[2]->m_name = sec->m_systems[system->GetPath().systemIndex].GetName() + " C";
+				star[2]->m_name = sysName + " C";
 				star[2]->m_orbMin = 0;
 				star[2]->m_orbMax = 0;
 				MakeStarOfTypeLighterThan(star[2], sec->m_systems[system->GetPath().systemIndex].GetStarType(2), star[0]->GetMassAsFixed(), rng);
@@ -1329,16 +1330,16 @@ bool StarSystemRandomGenerator::Apply(Random &rng, RefCountedPtr<Galaxy> galaxy,
 			} else {
 				centGrav2 = system->NewBody();
 				centGrav2->m_type = SystemBody::TYPE_GRAVPOINT;
-				centGrav2->m_name = sec->m_systems[system->GetPath().systemIndex].GetName() + " C,D";
+				centGrav2->m_name = sysName + " C,D";
 				centGrav2->m_orbMax = 0;
 
 				star[2] = system->NewBody();
-				star[2]->m_name = sec->m_systems[system->GetPath().systemIndex].GetName() + " C";
+				star[2]->m_name = sysName + " C";
 				star[2]->m_parent = centGrav2;
 				MakeStarOfTypeLighterThan(star[2], sec->m_systems[system->GetPath().systemIndex].GetStarType(2), star[0]->GetMassAsFixed(), rng);
 
 				star[3] = system->NewBody();
-				star[3]->m_name = sec->m_systems[system->GetPath().systemIndex].GetName() + " D";
+				star[3]->m_name = sysName + " D";
 				star[3]->m_parent = centGrav2;
 				MakeStarOfTypeLighterThan(star[3], sec->m_systems[system->GetPath().systemIndex].GetStarType(3), star[2]->GetMassAsFixed(), rng);
 
@@ -1353,7 +1354,7 @@ bool StarSystemRandomGenerator::Apply(Random &rng, RefCountedPtr<Galaxy> galaxy,
 			SystemBody *superCentGrav = system->NewBody();
 			superCentGrav->m_type = SystemBody::TYPE_GRAVPOINT;
 			superCentGrav->m_parent = 0;
-			superCentGrav->m_name = sec->m_systems[system->GetPath().systemIndex].GetName();
+			superCentGrav->m_name = sysName;
 			centGrav1->m_parent = superCentGrav;
 			centGrav2->m_parent = superCentGrav;
 			system->SetRootBody(superCentGrav);
@@ -1854,7 +1855,6 @@ bool PopulateStarSystemGenerator::Apply(Random &rng, RefCountedPtr<Galaxy> galax
 	GalaxyGenerator::StarSystemConfig *config)
 {
 	PROFILE_SCOPED()
-	const bool addSpaceStations = !config->isCustomOnly;
 	Uint32 _init[5] = { Uint32(system->GetSeed()), Uint32(system->GetPath().sectorX), Uint32(system->GetPath().sectorY), Uint32(system->GetPath().sectorZ), UNIVERSE_SEED };
 	Random rand;
 	rand.seed(_init, 5);
@@ -1895,10 +1895,7 @@ bool PopulateStarSystemGenerator::Apply(Random &rng, RefCountedPtr<Galaxy> galax
 	SetSysPolit(galaxy, system, system->GetTotalPop());
 	SetCommodityLegality(system);
 
-	if (addSpaceStations) {
-		PopulateAddStations(system->GetRootBody().Get(), system.Get());
-	}
-
+	// doesn't depend on the stations, which are added separately
 	if (!system->GetShortDescription().size()) {
 		SetEconType(system);
 		system->MakeShortDescription();
@@ -1906,3 +1903,12 @@ bool PopulateStarSystemGenerator::Apply(Random &rng, RefCountedPtr<Galaxy> galax
 
 	return true;
 }
+
+bool PopulateStationsGenerator::Apply(Random &rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<StarSystem::GeneratorAPI> system,
+	GalaxyGenerator::StarSystemConfig *config)
+{
+	PROFILE_SCOPED()
+	if (!config->isCustomOnly)
+		PopulateAddStations(system->GetRootBody().Get(), system.Get());
+	return true;
+}
@@ -9,6 +9,7 @@
 
 class StarSystemFromSectorGenerator : public StarSystemGeneratorStage {
 public:
+	virtual StarSystem::GenerationLevel GetLevel() const override { return StarSystem::GENERATED_SYSTEM; }
 	virtual bool Apply(Random &rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<StarSystem::GeneratorAPI> system, GalaxyGenerator::StarSystemConfig *config);
 };
 
@@ -31,6 +32,7 @@ protected:
 
 class StarSystemCustomGenerator : public StarSystemLegacyGeneratorBase {
 public:
+	virtual StarSystem::GenerationLevel GetLevel() const override { return StarSystem::GENERATED_BODIES; }
 	virtual bool Apply(Random &rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<StarSystem::GeneratorAPI> system, GalaxyGenerator::StarSystemConfig *config);
 
 	// returns true if the system is custom, false if the contents should be randomly generated
@@ -44,6 +46,7 @@ class StarSystemRandomGenerator : public StarSystemLegacyGeneratorBase {
 public:
 	static constexpr uint32_t BODY_SATELLITE_SALT = 0xf5123a90;
 
+	virtual StarSystem::GenerationLevel GetLevel() const override { return StarSystem::GENERATED_BODIES; }
 	virtual bool Apply(Random &rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<StarSystem::GeneratorAPI> system, GalaxyGenerator::StarSystemConfig *config);
 
 	// Calculate the min, max distances from the primary where satellites should be generated
@@ -65,16 +68,27 @@ private:
 
 class PopulateStarSystemGenerator : public StarSystemLegacyGeneratorBase {
 public:
+	virtual StarSystem::GenerationLevel GetLevel() const override { return StarSystem::GENERATED_POPULATION; }
 	virtual bool Apply(Random &rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<StarSystem::GeneratorAPI> system, GalaxyGenerator::StarSystemConfig *config);
 
+protected:
+	// stations are placed by PopulateStationsGenerator, but it needs the
+	// access to SystemBody that this class has
+	void PopulateAddStations(SystemBody *sbody, StarSystem::GeneratorAPI *system);
+
 private:
 	void SetSysPolit(RefCountedPtr<Galaxy> galaxy, RefCountedPtr<StarSystem::GeneratorAPI> system, const fixed &human_infestedness);
 	void SetCommodityLegality(RefCountedPtr<StarSystem::GeneratorAPI> system);
 	void SetEconType(RefCountedPtr<StarSystem::GeneratorAPI> system);
 
-	void PopulateAddStations(SystemBody *sbody, StarSystem::GeneratorAPI *system);
 	void PositionSettlementOnPlanet(SystemBody *sbody, std::vector<fixed> &prevOrbits);
 	void PopulateStage1(SystemBody *sbody, StarSystem::GeneratorAPI *system, fixed &outTotalPop);
 };
 
+class PopulateStationsGenerator : public PopulateStarSystemGenerator {
+public:
+	virtual StarSystem::GenerationLevel GetLevel() const override { return StarSystem::GENERATED_STATIONS; }
+	virtual bool Apply(Random &rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<StarSystem::GeneratorAPI> system, GalaxyGenerator::StarSystemConfig *config) override;
+};
+
 #endif
@@ -118,6 +118,42 @@ public:
 		}
 	};
 
+	// Hashes and equality for unordered containers, matching LessSectorOnly
+	// and LessSystemOnly. The coordinates are packed into 64 bits, 16 bits
+	// each (which covers the whole galaxy), and mixed.
+	static size_t HashPacked(Uint64 packed)
+	{
+		// splitmix64 finaliser
+		packed = (packed ^ (packed >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		packed = (packed ^ (packed >> 27)) * 0x94d049bb133111ebULL;
+		return size_t(packed ^ (packed >> 31));
+	}
+	Uint64 PackSector() const
+	{
+		return (Uint64(Uint16(sectorX)) << 48) | (Uint64(Uint16(sectorY)) << 32) | (Uint64(Uint16(sectorZ)) << 16);
+	}
+
+	class HashSectorOnly {
+	public:
+		size_t operator()(const SystemPath &a) const { return HashPacked(a.PackSector()); }
+	};
+	class EqualSectorOnly {
+	public:
+		bool operator()(const SystemPath &a, const SystemPath &b) const { return a.IsSameSector(b); }
+	};
+
+	class HashSystemOnly {
+	public:
+		size_t operator()(const SystemPath &a) const { return HashPacked(a.PackSector() | Uint16(a.systemIndex)); }
+	};
+	class EqualSystemOnly {
+	public:
+		bool operator()(const SystemPath &a, const SystemPath &b) const
+		{
+			return a.IsSameSector(b) && a.systemIndex == b.systemIndex;
+		}
+	};
+
 	bool IsSectorPath() const
 	{
 		return (systemIndex == Uint32(-1) && bodyIndex == Uint32(-1));
@@ -0,0 +1,96 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "EnumStrings.h"
+#include "FileSystem.h"
+#include "GameConfig.h"
+#include "ModManager.h"
+#include "core/Log.h"
+#include "galaxy/Economy.h"
+#include "galaxy/Galaxy.h"
+#include "galaxy/GalaxyGenerator.h"
+#include "galaxy/Sector.h"
+#include "galaxy/SectorDatabase.h"
+#include "profiler/Profiler.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <SDL.h>
+
+int info()
+{
+	printf(
+		"galaxycompiler - Bake the sectors around Sol into a sector database.\n"
+		"Sectors in the database are read from it by the game rather than generated.\n"
+		"The database is written to the pioneer user folder.\n"
+		"USAGE: galaxycompiler [radius]\n");
+	return 1;
+}
+
+extern "C" int main(int argc, char **argv)
+{
+	if (argc > 2) return info();
+
+	int radius = 8;
+	if (argc > 1) {
+		char *end;
+		radius = strtol(argv[1], &end, 10);
+		if (*end != '\0' || radius < 0) return info();
+	}
+
+	FileSystem::Init();
+	FileSystem::userFiles.MakeDirectory(""); // ensure the config directory exists
+	Log::GetLog()->SetLogFile("galaxycompiler.log");
+
+	std::unique_ptr<GameConfig> config(new GameConfig);
+	ModManager::Init();
+	ModManager::LoadMods(config.get());
+
+	EnumStrings::Init();
+	GalacticEconomy::Init();
+
+	if (config->HasEntry("GalaxyGenerator"))
+		GalaxyGenerator::Init(config->String("GalaxyGenerator"),
+			config->Int("GalaxyGeneratorVersion", GalaxyGenerator::LAST_VERSION));
+	else
+		GalaxyGenerator::Init();
+
+	RefCountedPtr<Galaxy> galaxy = GalaxyGenerator::Create();
+	RefCountedPtr<GalaxyGenerator> generator = galaxy->GetGenerator();
+	const std::string fileName = SectorDatabase::GetFileName(generator->GetName(), generator->GetVersion());
+
+	Profiler::Clock timer;
+	timer.Start();
+	SectorDatabase::Writer writer;
+	size_t numSystems = 0;
+	for (int sx = -radius; sx <= radius; sx++) {
+		for (int sy = -radius; sy <= radius; sy++) {
+			for (int sz = -radius; sz <= radius; sz++) {
+				RefCountedPtr<Sector> sector = generator->GenerateBakedSector(galaxy, SystemPath(sx, sy, sz));
+				writer.AddSector(*sector);
+				numSystems += sector->m_systems.size();
+			}
+		}
+	}
+	timer.Stop();
+
+	FILE *f = FileSystem::userFiles.OpenWriteStream(fileName);
+	if (!f) {
+		printf("Could not open output file %s.\n", fileName.c_str());
+		return 1;
+	}
+	const bool written = writer.Write(f, generator->GetName(), generator->GetVersion());
+	fclose(f);
+	if (!written) {
+		printf("Could not write output file %s.\n", fileName.c_str());
+		FileSystem::userFiles.RemoveFile(fileName);
+		return 1;
+	}
+
+	printf("Baked %zu sectors with %zu systems into %s in %.1f ms\n", writer.GetNumSectors(), numSystems, fileName.c_str(), timer.milliseconds());
+
+	galaxy.Reset();
+	GalaxyGenerator::Uninit();
+	ModManager::Uninit();
+	return 0;
+}
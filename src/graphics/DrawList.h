@@ -0,0 +1,40 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#pragma once
+
+#include "matrix4x4.h"
+
+namespace Graphics {
+
+	class InstanceBuffer;
+	class Material;
+	class MeshObject;
+
+	/*
+	 * A list of mesh draws that can be recorded away from the main thread,
+	 * e.g. one TaskGraph task per view or per batch of bodies, and is then
+	 * submitted to the renderer with Renderer::SubmitDrawList. Lists are
+	 * executed in the order they're submitted, interleaved with the draws
+	 * made directly on the renderer, and all GL calls are still made by
+	 * FlushCommandBuffers.
+	 *
+	 * Renderer::BeginDrawList captures the projection, lights and ambient
+	 * color the list draws with; they should not change until the list has
+	 * been submitted. Materials can be shared between lists recorded at the
+	 * same time, but must not be modified while any of those lists are
+	 * being recorded.
+	 */
+	class DrawList {
+	public:
+		virtual ~DrawList() {}
+
+		// the model view matrix for the following draws
+		virtual void SetTransform(const matrix4x4f &m) = 0;
+		virtual const matrix4x4f &GetTransform() const = 0;
+
+		virtual void DrawMesh(MeshObject *, Material *) = 0;
+		virtual void DrawMeshInstanced(MeshObject *, Material *, InstanceBuffer *) = 0;
+	};
+
+} // namespace Graphics
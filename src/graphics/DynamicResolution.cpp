@@ -0,0 +1,66 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Graphics {
+
+	// weight of a new measurement in the smoothed time
+	static constexpr float SMOOTHING = 0.15f;
+	// scale down above this fraction of the budget, up below the other
+	static constexpr float DOWN_THRESHOLD = 0.95f;
+	static constexpr float UP_THRESHOLD = 0.75f;
+	// the most the scale moves in one change
+	static constexpr float MAX_CHANGE = 0.1f;
+
+	DynamicResolution::DynamicResolution(float targetMs, float minScale, float maxScale) :
+		m_targetMs(std::max(targetMs, 0.1f)),
+		m_minScale(std::clamp(minScale, SCALE_STEP, 1.0f)),
+		m_maxScale(std::clamp(maxScale, m_minScale, 1.0f)),
+		m_scale(m_maxScale),
+		m_lastMs(0.0f),
+		m_smoothedMs(0.0f),
+		m_settleFrames(SETTLE_FRAMES)
+	{
+	}
+
+	void DynamicResolution::Update(float gpuMs)
+	{
+		m_lastMs = gpuMs;
+		if (m_settleFrames > 0) {
+			// still timing frames drawn at the old scale
+			if (--m_settleFrames == 0)
+				m_smoothedMs = gpuMs;
+			return;
+		}
+
+		m_smoothedMs += (gpuMs - m_smoothedMs) * SMOOTHING;
+		if (m_smoothedMs <= 0.0f)
+			return;
+
+		const float load = m_smoothedMs / m_targetMs;
+		if (load < DOWN_THRESHOLD && (load > UP_THRESHOLD || m_scale >= m_maxScale))
+			return;
+
+		// GPU time goes with the pixel count, the square of the scale;
+		// aim a little under the budget to leave room for noise
+		float wanted = m_scale * std::sqrt(UP_THRESHOLD / load * 1.1f);
+		wanted = std::clamp(wanted, m_scale - MAX_CHANGE, m_scale + MAX_CHANGE);
+		wanted = std::round(wanted / SCALE_STEP) * SCALE_STEP;
+		wanted = std::clamp(wanted, m_minScale, m_maxScale);
+
+		if (wanted != m_scale) {
+			m_scale = wanted;
+			m_settleFrames = SETTLE_FRAMES;
+		}
+	}
+
+	int DynamicResolution::GetScaledSize(int size) const
+	{
+		return std::max(1, int(std::lround(float(size) * m_scale)));
+	}
+
+} // namespace Graphics
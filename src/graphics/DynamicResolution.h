@@ -0,0 +1,52 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _DYNAMICRESOLUTION_H
+#define _DYNAMICRESOLUTION_H
+
+#include <cstdint>
+
+namespace Graphics {
+
+	// Picks the resolution scale of the 3D scene from its measured GPU time,
+	// so the scene keeps within a time budget on slower hardware.
+	//
+	// The scale applies to both axes, so the pixel count (and roughly the
+	// GPU time) goes with its square. The measured time is smoothed, and the
+	// scale only changes in steps of SCALE_STEP after a few measurements at
+	// the previous scale, so it doesn't hunt with every noisy frame. It goes
+	// down as soon as the budget is exceeded and back up only once there is
+	// clear headroom.
+	class DynamicResolution {
+	public:
+		static constexpr float SCALE_STEP = 1.0f / 32.0f;
+		// measurements ignored after a change, for the GPU to catch up
+		static constexpr uint32_t SETTLE_FRAMES = 8;
+
+		DynamicResolution(float targetMs, float minScale, float maxScale = 1.0f);
+
+		// feed one GPU time measurement, in milliseconds
+		void Update(float gpuMs);
+
+		float GetScale() const { return m_scale; }
+		float GetTargetTime() const { return m_targetMs; }
+		// the last measurement, and the smoothed one driving the scale
+		float GetGPUTime() const { return m_lastMs; }
+		float GetSmoothedGPUTime() const { return m_smoothedMs; }
+
+		// the size of the scaled scene in pixels, at least 1x1
+		int GetScaledSize(int size) const;
+
+	private:
+		float m_targetMs;
+		float m_minScale;
+		float m_maxScale;
+		float m_scale;
+		float m_lastMs;
+		float m_smoothedMs;
+		uint32_t m_settleFrames;
+	};
+
+} // namespace Graphics
+
+#endif /* _DYNAMICRESOLUTION_H */
@@ -5,6 +5,8 @@
 #include "Graphics.h"
 #include "MathUtil.h"
 
+#include <algorithm>
+
 namespace Graphics {
 
 	// min/max FOV in degrees
@@ -93,6 +95,14 @@ namespace Graphics {
 		return true;
 	}
 
+	bool Frustum::TestPointContained(const vector3d &p, double radius) const
+	{
+		for (int i = 0; i < 6; i++)
+			if (m_planes[i].DistanceToPoint(p) - radius < 0)
+				return false;
+		return true;
+	}
+
 	// Returns a vector3d in the range { 0..1, 0..1, 1..0 }
 	bool Frustum::ProjectPoint(const vector3d &in, vector3d &out) const
 	{
@@ -128,6 +138,32 @@ namespace Graphics {
 		return true;
 	}
 
+	void Frustum::ProjectPoints(const vector3d *in, vector3d *out, uint8_t *valid, size_t count) const
+	{
+		// the matrices are copied out so they stay in registers and the
+		// loop body, free of calls and aliasing, can be vectorised
+		double M[16], P[16];
+		std::copy(m_modelMatrix.Data(), m_modelMatrix.Data() + 16, M);
+		std::copy(m_projMatrix.Data(), m_projMatrix.Data() + 16, P);
+
+		for (size_t i = 0; i < count; i++) {
+			const vector3d &p = in[i];
+			const double vcam0 = p.x * M[0] + p.y * M[4] + p.z * M[8] + M[12];
+			const double vcam1 = p.x * M[1] + p.y * M[5] + p.z * M[9] + M[13];
+			const double vcam2 = p.x * M[2] + p.y * M[6] + p.z * M[10] + M[14];
+			const double vcam3 = p.x * M[3] + p.y * M[7] + p.z * M[11] + M[15];
+
+			const double x = vcam0 * P[0] + vcam1 * P[4] + vcam2 * P[8] + vcam3 * P[12];
+			const double y = vcam0 * P[1] + vcam1 * P[5] + vcam2 * P[9] + vcam3 * P[13];
+			const double z = vcam0 * P[2] + vcam1 * P[6] + vcam2 * P[10] + vcam3 * P[14];
+			const double clipW = vcam0 * P[3] + vcam1 * P[7] + vcam2 * P[11] + vcam3 * P[15];
+
+			valid[i] = !is_zero_exact(clipW);
+			const double w = valid[i] ? clipW : 1.0;
+			out[i] = vector3d((x / w) * 0.5 + 0.5, (y / w) * 0.5 + 0.5, z / w);
+		}
+	}
+
 	void Frustum::TranslatePoint(const vector3d &in, vector3d &out) const
 	{
 		out = in;
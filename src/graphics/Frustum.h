@@ -8,6 +8,8 @@
 #include "matrix4x4.h"
 #include "vector3.h"
 
+#include <cstdint>
+
 namespace Graphics {
 
 	// Frustum can be used for projecting points (3D to 2D) and testing
@@ -24,9 +26,14 @@ namespace Graphics {
 		bool TestPoint(const vector3d &p, double radius) const;
 		// test if point (sphere) is in the frustum, ignoring the far plane
 		bool TestPointInfinite(const vector3d &p, double radius) const;
+		// test if point (sphere) lies entirely inside the frustum
+		bool TestPointContained(const vector3d &p, double radius) const;
 
 		// project a point onto the near plane (typically the screen)
 		bool ProjectPoint(const vector3d &in, vector3d &out) const;
+		// project count points as ProjectPoint does, in one pass; valid[i]
+		// is zero where ProjectPoint would have returned false
+		void ProjectPoints(const vector3d *in, vector3d *out, uint8_t *valid, size_t count) const;
 
 		// translate the given point outside the frustum to a point inside
 		// returns scale factor to make object at that point appear correctly
@@ -32,6 +32,9 @@ namespace Graphics {
 		bool useAnisotropicFiltering;
 		bool enableDebugMessages;
 		bool gl3ForwardCompatible;
+		bool sortDrawCommands;
+		bool useProgramCache;
+		bool dynamicResolution;
 		int vsync;
 		int requestedSamples;
 		int height;
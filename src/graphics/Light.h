@@ -41,6 +41,14 @@ namespace Graphics {
 		Color m_specular;
 	};
 
+	// A local light with a limited range, for the clustered lighting path
+	// (see LightClusters). Any number of them may be set on the renderer.
+	struct PointLight {
+		vector3f position; // view space
+		float radius;	   // no light reaches beyond this
+		Color4f colour;	   // intensity already applied
+	};
+
 } // namespace Graphics
 
 #endif
@@ -0,0 +1,116 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "LightClusters.h"
+#include "profiler/Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Graphics {
+
+	LightClusters::LightClusters() :
+		m_clusters(NUM_CLUSTERS, 0),
+		m_sliceScale(0.0f),
+		m_sliceBias(0.0f),
+		m_numDropped(0)
+	{
+	}
+
+	// Finds the first and last tile a sphere overlaps along one screen axis.
+	// Tile boundaries are planes through the eye; for the boundary at NDC
+	// coordinate a, points beyond it satisfy scale * p + (offset + a) * z > 0.
+	static void tile_range(float p, float z, float radius, float scale, float offset, uint32_t tiles, uint32_t &first, uint32_t &last)
+	{
+		first = tiles;
+		last = 0;
+		float prev = 0.0f;
+		for (uint32_t i = 0; i <= tiles; i++) {
+			const float a = -1.0f + 2.0f * float(i) / float(tiles);
+			const float off = offset + a;
+			const float dist = (scale * p + off * z) / std::sqrt(scale * scale + off * off);
+			// tile i-1 lies between boundaries i-1 and i
+			if (i > 0 && prev >= -radius && dist <= radius) {
+				first = std::min(first, i - 1);
+				last = i - 1;
+			}
+			prev = dist;
+		}
+	}
+
+	LightClusters::Range LightClusters::GetRange(const matrix4x4f &projection, float znear, const PointLight &light) const
+	{
+		Range r;
+		const vector3f &p = light.position;
+		tile_range(p.x, p.z, light.radius, projection[0], projection[8], GRID_X, r.x0, r.x1);
+		tile_range(p.y, p.z, light.radius, projection[5], projection[9], GRID_Y, r.y0, r.y1);
+
+		const auto slice = [&](float depth) {
+			const float s = std::floor(std::log(std::max(depth, znear)) * m_sliceScale + m_sliceBias);
+			return uint32_t(std::min(std::max(s, 0.0f), float(GRID_Z - 1)));
+		};
+		r.z0 = slice(-p.z - light.radius);
+		r.z1 = slice(-p.z + light.radius);
+		return r;
+	}
+
+	void LightClusters::Build(const matrix4x4f &projection, float znear, float zfar, const PointLight *lights, uint32_t numLights)
+	{
+		PROFILE_SCOPED()
+		m_sliceScale = float(GRID_Z) / std::log(zfar / znear);
+		m_sliceBias = -std::log(znear) * m_sliceScale;
+		m_numDropped = 0;
+
+		// only lights reaching into the view's depth range matter
+		m_lights.clear();
+		for (uint32_t i = 0; i < numLights; i++) {
+			const PointLight &l = lights[i];
+			if (-l.position.z + l.radius >= znear && -l.position.z - l.radius <= zfar)
+				m_lights.push_back(l);
+		}
+
+		// the nearest lights go first: they're kept when there are too many,
+		// and get their cluster slots before the ones further away
+		std::sort(m_lights.begin(), m_lights.end(), [](const PointLight &a, const PointLight &b) {
+			return a.position.Length() - a.radius < b.position.Length() - b.radius;
+		});
+		if (m_lights.size() > MAX_LIGHTS)
+			m_lights.resize(MAX_LIGHTS);
+
+		m_ranges.clear();
+		std::fill(m_clusters.begin(), m_clusters.end(), 0);
+		for (const PointLight &l : m_lights) {
+			const Range r = GetRange(projection, znear, l);
+			m_ranges.push_back(r);
+			for (uint32_t z = r.z0; z <= r.z1; z++)
+				for (uint32_t y = r.y0; y <= r.y1; y++)
+					for (uint32_t x = r.x0; x <= r.x1; x++)
+						m_clusters[GetClusterIndex(x, y, z)]++;
+		}
+
+		// turn the counts into offsets, trimming the clusters that don't fit
+		m_fill.assign(NUM_CLUSTERS, 0);
+		uint32_t offset = 0;
+		for (uint32_t i = 0; i < NUM_CLUSTERS; i++) {
+			const uint32_t count = std::min(m_clusters[i], MAX_INDICES - offset);
+			m_numDropped += m_clusters[i] - count;
+			m_fill[i] = offset;
+			m_clusters[i] = offset | (count << 16);
+			offset += count;
+		}
+
+		m_indices.resize(offset);
+		for (uint32_t light = 0; light < m_ranges.size(); light++) {
+			const Range &r = m_ranges[light];
+			for (uint32_t z = r.z0; z <= r.z1; z++)
+				for (uint32_t y = r.y0; y <= r.y1; y++)
+					for (uint32_t x = r.x0; x <= r.x1; x++) {
+						const uint32_t c = GetClusterIndex(x, y, z);
+						const uint32_t end = (m_clusters[c] & 0xffff) + (m_clusters[c] >> 16);
+						if (m_fill[c] < end)
+							m_indices[m_fill[c]++] = uint16_t(light);
+					}
+		}
+	}
+
+} // namespace Graphics
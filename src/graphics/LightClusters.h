@@ -0,0 +1,74 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _LIGHTCLUSTERS_H
+#define _LIGHTCLUSTERS_H
+
+#include "Light.h"
+#include "matrix4x4.h"
+
+#include <vector>
+
+namespace Graphics {
+
+	// Sorts point lights into a grid of view-space clusters for clustered
+	// forward lighting.
+	//
+	// The view frustum is split into GRID_X x GRID_Y tiles on screen and
+	// GRID_Z slices in depth, spaced exponentially between the near and far
+	// distances. Each cluster gets a list of the lights whose range reaches
+	// it, so a shader shades a fragment with only the lights of its cluster
+	// whatever the number of lights in the scene.
+	class LightClusters {
+	public:
+		static constexpr uint32_t GRID_X = 16;
+		static constexpr uint32_t GRID_Y = 8;
+		static constexpr uint32_t GRID_Z = 8;
+		static constexpr uint32_t NUM_CLUSTERS = GRID_X * GRID_Y * GRID_Z;
+		// sized so all of it fits a minimum-size (16KB) uniform block
+		static constexpr uint32_t MAX_LIGHTS = 128;
+		static constexpr uint32_t MAX_INDICES = 3072;
+
+		LightClusters();
+
+		// Assigns the lights to clusters for a view with the given projection
+		// matrix, looking down -Z between znear and zfar. The nearest lights
+		// are kept if there are more than MAX_LIGHTS.
+		void Build(const matrix4x4f &projection, float znear, float zfar, const PointLight *lights, uint32_t numLights);
+
+		static uint32_t GetClusterIndex(uint32_t x, uint32_t y, uint32_t z) { return (z * GRID_Y + y) * GRID_X + x; }
+
+		// For each cluster, the offset of its first light index in the low
+		// 16 bits and the number of its lights in the high 16 bits
+		const std::vector<uint32_t> &GetClusters() const { return m_clusters; }
+		const std::vector<uint16_t> &GetIndices() const { return m_indices; }
+		const std::vector<PointLight> &GetLights() const { return m_lights; }
+
+		// The depth slice of a view-space distance d is
+		// floor(log(d) * sliceScale + sliceBias)
+		float GetSliceScale() const { return m_sliceScale; }
+		float GetSliceBias() const { return m_sliceBias; }
+
+		// Light and cluster pairings left out to stay within MAX_INDICES
+		uint32_t GetNumDropped() const { return m_numDropped; }
+
+	private:
+		struct Range {
+			uint32_t x0, x1, y0, y1, z0, z1;
+		};
+
+		Range GetRange(const matrix4x4f &projection, float znear, const PointLight &light) const;
+
+		std::vector<PointLight> m_lights;
+		std::vector<Range> m_ranges;
+		std::vector<uint32_t> m_clusters;
+		std::vector<uint16_t> m_indices;
+		std::vector<uint32_t> m_fill;
+		float m_sliceScale;
+		float m_sliceBias;
+		uint32_t m_numDropped;
+	};
+
+} // namespace Graphics
+
+#endif
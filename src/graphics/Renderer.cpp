@@ -13,7 +13,9 @@ namespace Graphics {
 		m_width(w),
 		m_height(h),
 		m_ambient(Color::BLACK),
-		m_window(window)
+		m_window(window),
+		m_textureStreamer(nullptr),
+		m_textureLoader(nullptr)
 	{
 	}
 
@@ -13,6 +13,7 @@
 #include "matrix4x4.h"
 #include <map>
 #include <memory>
+#include <vector>
 
 struct SDL_Window;
 
@@ -23,6 +24,7 @@ namespace Graphics {
 	 * It is also used to create render states, materials and vertex/index buffers.
 	 */
 
+	class DrawList;
 	class IndexBuffer;
 	class InstanceBuffer;
 	class Material;
@@ -32,6 +34,8 @@ namespace Graphics {
 	class RenderTarget;
 	class Texture;
 	class TextureDescriptor;
+	class TextureLoader;
+	class TextureStreamer;
 	class UniformBuffer;
 	class VertexArray;
 	class VertexBuffer;
@@ -117,6 +121,10 @@ namespace Graphics {
 
 		virtual bool SetLightIntensity(Uint32 numlights, const float *intensity) = 0;
 		virtual bool SetLights(Uint32 numlights, const Light *l) = 0;
+		// Sets the local lights shaded through the clustered lighting path
+		// (positions in view space, with the current projection), assigning them
+		// to clusters between znear and zfar
+		virtual bool SetPointLights(Uint32 numLights, const PointLight *lights, float znear, float zfar) = 0;
 		const Light &GetLight(const Uint32 idx) const
 		{
 			assert(idx < 4);
@@ -131,6 +139,32 @@ namespace Graphics {
 		// and all code can safely deal with async drawing
 		virtual bool FlushCommandBuffers() = 0;
 
+		// Measures the GPU time of the work drawn between BeginGPUTimer and
+		// EndGPUTimer (once per frame). Results arrive a few frames late;
+		// PollGPUTimer returns true and the time in milliseconds when a new
+		// one is in, and always false if the renderer can't time the GPU.
+		virtual void BeginGPUTimer() = 0;
+		virtual void EndGPUTimer() = 0;
+		virtual bool PollGPUTimer(float &milliseconds) = 0;
+
+		// GPU time of a zone drawn between PushGPUZone and PopGPUZone
+		struct GPUZoneTime {
+			const char *name;
+			float startMs; // from the start of the first zone of the frame
+			float durationMs;
+			uint32_t depth;
+		};
+
+		// Zones mark render passes and draw groups for timing on the GPU.
+		// They are timed in the order their draws execute and nest like
+		// profiler zones; names must outlive the renderer (use literals).
+		// GetGPUZoneTimes returns the zones of the last frame whose results
+		// are in, a few frames behind, and nothing if the renderer can't
+		// time the GPU.
+		virtual void PushGPUZone(const char *name) = 0;
+		virtual void PopGPUZone() = 0;
+		virtual const std::vector<GPUZoneTime> &GetGPUZoneTimes() const = 0;
+
 		// All drawing commands are assumed to defer execution of the command
 		// until the next commandlist flush. This is to batch GPU data updates
 		// and ensure state changes are minimal and internally consistent.
@@ -150,6 +184,13 @@ namespace Graphics {
 		// Draw multiple instances of a mesh object using the given material.
 		virtual bool DrawMeshInstanced(MeshObject *, Material *, InstanceBuffer *) = 0;
 
+		// Create a list that mesh draws can be recorded into from another thread. The caller owns it.
+		virtual DrawList *CreateDrawList() = 0;
+		// Clear the list and capture the current view state for it; recording can be handed off afterwards.
+		virtual void BeginDrawList(DrawList *list) = 0;
+		// Append the draws recorded into the list to the renderer's commands. Must be called on the main thread.
+		virtual void SubmitDrawList(DrawList *list) = 0;
+
 		//creates a unique material based on the descriptor. It will not be deleted automatically.
 		virtual Material *CreateMaterial(const std::string &shader, const MaterialDescriptor &descriptor, const RenderStateDesc &stateDescriptor) = 0;
 		// Make a copy of the given material with a possibly new descriptor or render state.
@@ -179,6 +220,13 @@ namespace Graphics {
 
 		const TextureCache &GetTextureCache() { return m_textureCache; }
 
+		// Streams the larger mips of model textures, if set; not owned by the renderer
+		void SetTextureStreamer(TextureStreamer *streamer) { m_textureStreamer = streamer; }
+		TextureStreamer *GetTextureStreamer() const { return m_textureStreamer; }
+		// Loads textures in the background, if set; not owned by the renderer
+		void SetTextureLoader(TextureLoader *loader) { m_textureLoader = loader; }
+		TextureLoader *GetTextureLoader() const { return m_textureLoader; }
+
 		virtual bool ReloadShaders() = 0;
 
 		// take a ticket representing the current renderer state. when the ticket
@@ -244,6 +292,26 @@ namespace Graphics {
 			matrix4x4f m_storedMat;
 		};
 
+		class GPUZoneTicket {
+		public:
+			GPUZoneTicket(Renderer *r, const char *name) :
+				m_renderer(r)
+			{
+				m_renderer->PushGPUZone(name);
+			}
+
+			~GPUZoneTicket()
+			{
+				m_renderer->PopGPUZone();
+			}
+
+			GPUZoneTicket(const GPUZoneTicket &) = delete;
+			GPUZoneTicket &operator=(const GPUZoneTicket &) = delete;
+
+		private:
+			Renderer *m_renderer;
+		};
+
 		virtual bool Screendump(ScreendumpState &sd) { return false; }
 
 		Stats &GetStats() { return m_stats; }
@@ -264,6 +332,8 @@ namespace Graphics {
 
 	private:
 		TextureCacheMap m_textureCache;
+		TextureStreamer *m_textureStreamer;
+		TextureLoader *m_textureLoader;
 	};
 
 } // namespace Graphics
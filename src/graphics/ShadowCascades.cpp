@@ -0,0 +1,152 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "ShadowCascades.h"
+#include "MathUtil.h"
+#include "RenderTarget.h"
+#include "Renderer.h"
+#include "profiler/Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Graphics {
+
+	ShadowCascades::ShadowCascades(const Settings &settings) :
+		m_settings(settings),
+		m_numStaticRedraws(0),
+		m_nextStatic(0)
+	{
+		const uint32_t num = std::min(m_settings.numCascades, MAX_CASCADES);
+		m_settings.numCascades = num;
+		m_settings.mapSize = std::max(m_settings.mapSize, 16U);
+		m_cascades.resize(num);
+		m_projections.resize(num, matrix4x4f::Identity());
+		m_drawn.resize(num, false);
+		m_redraw.resize(num, false);
+		m_staticLightDir.resize(num, vector3d(0.0));
+		for (uint32_t i = 0; i < num; i++)
+			m_cascades[i].isStatic = i >= m_settings.firstStaticCascade;
+	}
+
+	ShadowCascades::~ShadowCascades()
+	{
+	}
+
+	void ShadowCascades::CreateTargets(Renderer *r)
+	{
+		PROFILE_SCOPED()
+		m_targets.clear();
+		for (uint32_t i = 0; i < GetNumCascades(); i++) {
+			const RenderTargetDesc desc(m_settings.mapSize, m_settings.mapSize, TEXTURE_NONE, TEXTURE_DEPTH, true);
+			m_targets.emplace_back(r->CreateRenderTarget(desc));
+		}
+		Invalidate();
+	}
+
+	void ShadowCascades::Invalidate()
+	{
+		std::fill(m_drawn.begin(), m_drawn.end(), false);
+	}
+
+	void ShadowCascades::MarkDrawn(uint32_t i, const matrix4x4f &projection)
+	{
+		m_projections[i] = projection;
+		m_drawn[i] = true;
+		m_redraw[i] = false;
+		if (m_cascades[i].isStatic)
+			m_numStaticRedraws++;
+	}
+
+	void ShadowCascades::PlaceCascade(Cascade &c, const vector3d &centre, double radius, const vector3d &lightDir) const
+	{
+		// light space axes; z points towards the light
+		const vector3d z = lightDir;
+		const vector3d up = std::abs(z.y) < 0.99 ? vector3d(0.0, 1.0, 0.0) : vector3d(1.0, 0.0, 0.0);
+		const vector3d x = up.Cross(z).Normalized();
+		const vector3d y = z.Cross(x);
+
+		// move the centre to whole texels across the map, so the same
+		// geometry always lands on the same texels
+		const double texel = 2.0 * radius / double(m_settings.mapSize);
+		const double cx = x.Dot(centre), cy = y.Dot(centre);
+		c.centre = centre + x * (std::floor(cx / texel) * texel - cx) + y * (std::floor(cy / texel) * texel - cy);
+		c.radius = radius;
+
+		// casters up to a radius in front of the sphere still throw shadows
+		// into it
+		const vector3d eye = c.centre + z * (2.0 * radius);
+		c.depthNear = 0.0;
+		c.depthFar = 3.0 * radius;
+
+		double *m = &c.lightView[0];
+		m[0] = x.x, m[4] = x.y, m[8] = x.z, m[12] = -x.Dot(eye);
+		m[1] = y.x, m[5] = y.y, m[9] = y.z, m[13] = -y.Dot(eye);
+		m[2] = z.x, m[6] = z.y, m[10] = z.z, m[14] = -z.Dot(eye);
+		m[3] = 0.0, m[7] = 0.0, m[11] = 0.0, m[15] = 1.0;
+	}
+
+	void ShadowCascades::Update(const vector3d &camPos, const matrix3x3d &camOrient, double fovY, double aspect, double znear, const vector3d &lightDir)
+	{
+		PROFILE_SCOPED()
+		const uint32_t num = GetNumCascades();
+		m_numStaticRedraws = 0;
+		if (num == 0)
+			return;
+
+		const vector3d dir = lightDir.Normalized();
+		const double nearDist = std::max(znear, 0.01);
+		const double farDist = std::max(double(m_settings.maxDistance), nearDist * 2.0);
+		const double lambda = Clamp(double(m_settings.splitLambda), 0.0, 1.0);
+		const double tanY = std::tan(fovY * 0.5);
+		// squared tangent of the angle between the view axis and a frustum corner
+		const double k2 = tanY * tanY * (1.0 + aspect * aspect);
+		const double cosUpdate = std::cos(DEG2RAD(double(m_settings.staticUpdateAngle)));
+
+		uint32_t budget = m_settings.staticRedrawBudget;
+		uint32_t lastRedrawn = num;
+		for (uint32_t n = 0; n < num; n++) {
+			// visit static cascades starting after the last one redrawn, so
+			// a tight budget doesn't starve the far ones
+			const uint32_t i = m_cascades[n].isStatic ? m_settings.firstStaticCascade + (n - m_settings.firstStaticCascade + m_nextStatic) % (num - m_settings.firstStaticCascade) : n;
+			Cascade &c = m_cascades[i];
+
+			const auto split = [&](uint32_t s) {
+				const double t = double(s) / double(num);
+				return lambda * nearDist * std::pow(farDist / nearDist, t) + (1.0 - lambda) * (nearDist + (farDist - nearDist) * t);
+			};
+			c.splitNear = split(i);
+			c.splitFar = split(i + 1);
+
+			// the smallest sphere along the view axis holding the slice's corners
+			const double sn = c.splitNear, sf = c.splitFar;
+			const double d = std::min(sf, 0.5 * (sn + sf) * (1.0 + k2));
+			const double radius = std::max(std::sqrt((d - sn) * (d - sn) + sn * sn * k2), std::sqrt((sf - d) * (sf - d) + sf * sf * k2));
+			const vector3d centre = camPos + camOrient * vector3d(0.0, 0.0, -d);
+
+			if (!c.isStatic) {
+				PlaceCascade(c, centre, radius, dir);
+				m_redraw[i] = true;
+				continue;
+			}
+
+			const bool valid = m_drawn[i] &&
+				(centre - c.centre).Length() + radius <= c.radius &&
+				dir.Dot(m_staticLightDir[i]) >= cosUpdate;
+			if (valid || budget == 0) {
+				m_redraw[i] = false;
+				continue;
+			}
+
+			budget--;
+			PlaceCascade(c, centre, radius * STATIC_MARGIN, dir);
+			m_staticLightDir[i] = dir;
+			m_redraw[i] = true;
+			lastRedrawn = i;
+		}
+
+		if (lastRedrawn < num)
+			m_nextStatic = lastRedrawn + 1 - m_settings.firstStaticCascade;
+	}
+
+} // namespace Graphics
@@ -0,0 +1,118 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _SHADOWCASCADES_H
+#define _SHADOWCASCADES_H
+
+#include "matrix3x3.h"
+#include "matrix4x4.h"
+#include "vector3.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Graphics {
+
+	class RenderTarget;
+	class Renderer;
+
+	// Places the cascades of a directional light's shadow maps around a
+	// view, and decides which of them need drawing each frame.
+	//
+	// The view distance up to maxDistance is split into numCascades slices,
+	// each covered by an orthographic map fitted to the slice's bounding
+	// sphere. The sphere doesn't change with the view direction and its
+	// centre is snapped to whole texels, so shadow edges don't crawl as the
+	// camera turns and moves.
+	//
+	// Cascades from firstStaticCascade on only hold static casters (such as
+	// stations) and are sized with some margin. They keep their map as long
+	// as the slice stays inside it and the light doesn't move by more than
+	// staticUpdateAngle, and at most staticRedrawBudget of them are redrawn
+	// in a frame. Closer cascades are redrawn every frame with everything.
+	//
+	// Positions and directions are given in a frame static geometry doesn't
+	// move in, usually the camera's parent frame. Call Invalidate() when
+	// that frame changes.
+	class ShadowCascades {
+	public:
+		static constexpr uint32_t MAX_CASCADES = 4;
+		// static cascades cover this much more than their slice
+		static constexpr double STATIC_MARGIN = 1.25;
+
+		struct Settings {
+			uint32_t numCascades = 3;
+			uint32_t mapSize = 1024;
+			float maxDistance = 2000.0f;
+			uint32_t firstStaticCascade = 2;
+			float staticUpdateAngle = 0.5f; // degrees
+			uint32_t staticRedrawBudget = 1;
+			// blend between logarithmic (1) and even (0) slice distances
+			float splitLambda = 0.75f;
+		};
+
+		struct Cascade {
+			// the part of the view this cascade covers
+			double splitNear = 0.0;
+			double splitFar = 0.0;
+			// the covered sphere
+			vector3d centre = vector3d(0.0);
+			double radius = 0.0;
+			// maps positions into light space, looking down -Z towards the
+			// light direction...
+			matrix4x4d lightView = matrix4x4d::Identity();
+			// ...where casters between depthNear and depthFar are drawn
+			double depthNear = 0.0;
+			double depthFar = 0.0;
+			bool isStatic = false;
+		};
+
+		explicit ShadowCascades(const Settings &settings);
+		~ShadowCascades();
+
+		// Places the cascades for a camera at camPos looking down -Z of
+		// camOrient, with vertical field of view fovY (radians), at the
+		// aspect ratio and near distance given. lightDir points towards the light.
+		void Update(const vector3d &camPos, const matrix3x3d &camOrient, double fovY, double aspect, double znear, const vector3d &lightDir);
+
+		// drop every cached map, eg after a change of reference frame
+		void Invalidate();
+
+		uint32_t GetNumCascades() const { return uint32_t(m_cascades.size()); }
+		const Cascade &GetCascade(uint32_t i) const { return m_cascades[i]; }
+		const Settings &GetSettings() const { return m_settings; }
+
+		// true if the cascade's map needs drawing this frame
+		bool NeedsRedraw(uint32_t i) const { return m_redraw[i]; }
+		// the cascade was drawn with this projection; shaders need it
+		// (times lightView) to look up the map
+		void MarkDrawn(uint32_t i, const matrix4x4f &projection);
+		const matrix4x4f &GetProjection(uint32_t i) const { return m_projections[i]; }
+
+		// static cascades redrawn since the last Update
+		uint32_t GetNumStaticRedraws() const { return m_numStaticRedraws; }
+
+		// one depth-only target per cascade, mapSize squared
+		void CreateTargets(Renderer *r);
+		RenderTarget *GetTarget(uint32_t i) const { return m_targets.empty() ? nullptr : m_targets[i].get(); }
+
+	private:
+		void PlaceCascade(Cascade &c, const vector3d &centre, double radius, const vector3d &lightDir) const;
+
+		Settings m_settings;
+		std::vector<Cascade> m_cascades;
+		std::vector<matrix4x4f> m_projections;
+		std::vector<bool> m_drawn;
+		std::vector<bool> m_redraw;
+		// the light direction each static cascade was last placed with
+		std::vector<vector3d> m_staticLightDir;
+		uint32_t m_numStaticRedraws;
+		// rotates static cascades through the redraw budget
+		uint32_t m_nextStatic;
+		std::vector<std::unique_ptr<RenderTarget>> m_targets;
+	};
+
+} // namespace Graphics
+
+#endif /* _SHADOWCASCADES_H */
@@ -38,6 +38,8 @@ namespace Graphics {
 			STAT_NUM_RENDER_STATES,
 			STAT_NUM_SHADER_PROGRAMS,
 			STAT_NUM_CMDLIST_FLUSHES,
+			STAT_PROGRAM_BINDS_SAVED,
+			STAT_TEXTURE_BINDS_SAVED,
 
 			// objects
 			STAT_BUILDINGS,
@@ -48,6 +48,7 @@ namespace Graphics {
 	};
 
 	// WARNING: TextureDescriptor is intended to be immutable. Internal values should not be changed!
+	// (A texture's descriptor is only ever replaced whole, by Texture::Respecify.)
 	class TextureDescriptor {
 	public:
 		TextureDescriptor() :
@@ -112,6 +113,15 @@ namespace Graphics {
 		virtual void Update(const TextureCubeData &data, const vector3f &dataSize, TextureFormat format, const unsigned int numMips = 0) = 0;
 		typedef std::vector<void *> vecDataPtr;
 		virtual void Update(const vecDataPtr &data, const vector3f &dataSize, const TextureFormat format, const unsigned int numMips = 0) = 0;
+		// Mip streaming for pre-compressed 2D textures (see TextureStreamer).
+		// UpdateMips uploads numMips levels from firstMip on, packed back to back in data;
+		// dataSize is the size of the top level. SetBaseMip restricts sampling to the
+		// levels from baseMip down and releases the storage of any larger levels.
+		virtual void UpdateMips(const void *data, const vector3f &dataSize, TextureFormat format, uint32_t firstMip, uint32_t numMips) = 0;
+		virtual void SetBaseMip(uint32_t baseMip) = 0;
+		// Replaces the texture's storage with storage for another descriptor, such as when
+		// the image for a placeholder has loaded. Contents are undefined until next updated.
+		virtual void Respecify(const TextureDescriptor &descriptor) = 0;
 		virtual void SetSampleMode(TextureSampleMode) = 0;
 		// Call this function to update the texture's mipmaps.
 		// validMips is the number of mipmaps which already have valid data uploaded, and is mostly for internal use.
@@ -128,6 +138,8 @@ namespace Graphics {
 		Texture(const TextureDescriptor &descriptor) :
 			m_descriptor(descriptor) {}
 
+		void SetDescriptor(const TextureDescriptor &descriptor) { m_descriptor = descriptor; }
+
 	private:
 		TextureDescriptor m_descriptor;
 	};
@@ -3,6 +3,8 @@
 
 #include "TextureBuilder.h"
 #include "FileSystem.h"
+#include "TextureLoader.h"
+#include "TextureStreamer.h"
 #include "MathUtil.h"
 #include "profiler/Profiler.h"
 #include "utils.h"
@@ -312,6 +314,65 @@ namespace Graphics {
 		// XXX if we can't load the fallback texture, then what?
 	}
 
+	Texture *TextureBuilder::CreateStreamedTexture(Renderer *r)
+	{
+		Texture *t = r->CreateTexture(GetDescriptor());
+		if (!UploadStreamedTexture(r, t))
+			UpdateTexture(t);
+		return t;
+	}
+
+	bool TextureBuilder::UploadStreamedTexture(Renderer *r, Texture *texture)
+	{
+		const TextureDescriptor &descriptor = GetDescriptor();
+		TextureStreamer *streamer = r->GetTextureStreamer();
+		const uint32_t residentMip = m_dds.headerdone_ ? TextureStreamer::GetResidentMip(descriptor) : 0;
+		if (!streamer || !residentMip)
+			return false;
+
+		// release the larger levels before anything is uploaded to them
+		texture->SetBaseMip(residentMip);
+		texture->UpdateMips(m_dds.imgdata_.imgData + TextureStreamer::GetMipOffset(descriptor, residentMip),
+			descriptor.dataSize, descriptor.format, residentMip, descriptor.numberOfMipMaps - residentMip);
+		streamer->AddTexture(texture, m_filenames.front(), residentMip);
+		return true;
+	}
+
+	Texture *TextureBuilder::GetOrCreateTextureAsync(Renderer *r, const std::string &type, const Color &placeholder, bool streamed)
+	{
+		if (m_filenames.empty() || m_textureType == TEXTURE_2D_ARRAY || !r->GetTextureLoader())
+			return streamed ? GetOrCreateStreamedTexture(r, type) : GetOrCreateTexture(r, type);
+
+		SDL_LockMutex(m_textureLock);
+		Texture *t = r->GetCachedTexture(type, m_filenames.front());
+		if (t) {
+			SDL_UnlockMutex(m_textureLock);
+			return t;
+		}
+
+		const TextureDescriptor descriptor(TEXTURE_RGBA_8888, vector3f(1.0f), m_sampleMode, false, false, false, 0, m_textureType);
+		t = r->CreateTexture(descriptor);
+		if (m_textureType == TEXTURE_CUBE_MAP) {
+			void *face = const_cast<Color *>(&placeholder);
+			t->Update(TextureCubeData{ face, face, face, face, face, face }, descriptor.dataSize, descriptor.format);
+		} else {
+			t->Update(&placeholder, descriptor.dataSize, descriptor.format);
+		}
+		// cached straight away so later requests share the pending load
+		r->AddCachedTexture(type, m_filenames.front(), t);
+		SDL_UnlockMutex(m_textureLock);
+
+		r->GetTextureLoader()->Load(t, *this, streamed && m_textureType == TEXTURE_2D);
+		return t;
+	}
+
+	void TextureBuilder::UploadTexture(Renderer *r, Texture *texture, bool streamed)
+	{
+		texture->Respecify(GetDescriptor());
+		if (!streamed || !UploadStreamedTexture(r, texture))
+			UpdateTexture(texture);
+	}
+
 	void TextureBuilder::UpdateTexture(Texture *texture)
 	{
 		if (m_surface) {
@@ -4,6 +4,7 @@
 #ifndef _TEXTUREBUILDER_H
 #define _TEXTUREBUILDER_H
 
+#include "Color.h"
 #include "Renderer.h"
 #include "SDLWrappers.h"
 #include "SDL_mutex.h"
@@ -89,6 +90,32 @@ namespace Graphics {
 			return t;
 		}
 
+		// As GetOrCreateTexture, but compressed 2D textures are created with only
+		// their small mips loaded, the rest left to the renderer's TextureStreamer
+		Texture *GetOrCreateStreamedTexture(Renderer *r, const std::string &type)
+		{
+			if (m_filenames.empty() || !r->GetTextureStreamer()) {
+				return GetOrCreateTexture(r, type);
+			}
+			SDL_LockMutex(m_textureLock);
+			Texture *t = r->GetCachedTexture(type, m_filenames.front());
+			if (t) {
+				SDL_UnlockMutex(m_textureLock);
+				return t;
+			}
+			t = CreateStreamedTexture(r);
+			r->AddCachedTexture(type, m_filenames.front(), t);
+			SDL_UnlockMutex(m_textureLock);
+			return t;
+		}
+
+		// As GetOrCreateTexture, but the image is loaded by the renderer's
+		// TextureLoader in the background; until then the texture is a single
+		// pixel of the placeholder colour. Falls back to loading it now if
+		// there's no loader or the texture is an array. Only 2D textures are
+		// streamed.
+		Texture *GetOrCreateTextureAsync(Renderer *r, const std::string &type, const Color &placeholder, bool streamed = false);
+
 		//commonly used dummy textures
 		static Texture *GetWhiteTexture(Renderer *);
 		static Texture *GetTransparentTexture(Renderer *);
@@ -119,6 +146,13 @@ namespace Graphics {
 			return t;
 		}
 
+		Texture *CreateStreamedTexture(Renderer *r);
+		bool UploadStreamedTexture(Renderer *r, Texture *texture);
+
+		// replaces a placeholder's storage with the prepared image
+		friend class TextureLoader;
+		void UploadTexture(Renderer *r, Texture *texture, bool streamed);
+
 		void UpdateTexture(Texture *texture); // XXX pass src/dest rectangles
 		void PrepareSurface();
 		bool m_prepared;
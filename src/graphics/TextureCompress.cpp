@@ -0,0 +1,131 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "TextureCompress.h"
+
+#include "MathUtil.h"
+#include "vector3.h"
+
+#include <algorithm>
+
+namespace {
+	const int BLOCK_SIZE = 8;
+	const int POWER_ITERATIONS = 4;
+
+	Uint16 PackRGB565(const vector3f &c)
+	{
+		const int r = Clamp(int(c.x * (31.0f / 255.0f) + 0.5f), 0, 31);
+		const int g = Clamp(int(c.y * (63.0f / 255.0f) + 0.5f), 0, 63);
+		const int b = Clamp(int(c.z * (31.0f / 255.0f) + 0.5f), 0, 31);
+		return Uint16((r << 11) | (g << 5) | b);
+	}
+
+	vector3f UnpackRGB565(const Uint16 c)
+	{
+		const int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+		return vector3f((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2));
+	}
+
+	void CompressBlock(const vector3f *texels, Uint8 *out)
+	{
+		vector3f mean(0.0f);
+		for (int i = 0; i < 16; i++)
+			mean += texels[i];
+		mean *= 1.0f / 16.0f;
+
+		// covariance of the block's colours
+		float cov[6] = {};
+		for (int i = 0; i < 16; i++) {
+			const vector3f d = texels[i] - mean;
+			cov[0] += d.x * d.x, cov[1] += d.x * d.y, cov[2] += d.x * d.z;
+			cov[3] += d.y * d.y, cov[4] += d.y * d.z, cov[5] += d.z * d.z;
+		}
+
+		// principal axis by power iteration, from the covariance matrix's
+		// column for the channel varying the most
+		vector3f axis(cov[0], cov[1], cov[2]);
+		if (cov[3] > cov[0] && cov[3] >= cov[5])
+			axis = vector3f(cov[1], cov[3], cov[4]);
+		else if (cov[5] > cov[0] && cov[5] > cov[3])
+			axis = vector3f(cov[2], cov[4], cov[5]);
+		for (int i = 0; i < POWER_ITERATIONS; i++) {
+			const vector3f next(
+				cov[0] * axis.x + cov[1] * axis.y + cov[2] * axis.z,
+				cov[1] * axis.x + cov[3] * axis.y + cov[4] * axis.z,
+				cov[2] * axis.x + cov[4] * axis.y + cov[5] * axis.z);
+			const float len = next.Length();
+			if (len < 1e-6f)
+				break;
+			axis = next / len;
+		}
+		axis = axis.NormalizedSafe();
+
+		float minT = 0.0f, maxT = 0.0f;
+		for (int i = 0; i < 16; i++) {
+			const float t = (texels[i] - mean).Dot(axis);
+			minT = std::min(minT, t);
+			maxT = std::max(maxT, t);
+		}
+
+		Uint16 c0 = PackRGB565(mean + axis * maxT);
+		Uint16 c1 = PackRGB565(mean + axis * minT);
+		// c0 > c1 selects the four colour mode; equal endpoints give a solid block
+		if (c0 < c1)
+			std::swap(c0, c1);
+
+		vector3f palette[4];
+		palette[0] = UnpackRGB565(c0);
+		palette[1] = UnpackRGB565(c1);
+		palette[2] = (palette[0] * 2.0f + palette[1]) * (1.0f / 3.0f);
+		palette[3] = (palette[0] + palette[1] * 2.0f) * (1.0f / 3.0f);
+
+		Uint32 indices = 0;
+		if (c0 != c1) {
+			for (int i = 0; i < 16; i++) {
+				int best = 0;
+				float bestDist = (texels[i] - palette[0]).LengthSqr();
+				for (int p = 1; p < 4; p++) {
+					const float dist = (texels[i] - palette[p]).LengthSqr();
+					if (dist < bestDist) {
+						best = p;
+						bestDist = dist;
+					}
+				}
+				indices |= Uint32(best) << (i * 2);
+			}
+		}
+
+		// little-endian endpoints, then 2 bits per texel from the top left
+		out[0] = Uint8(c0), out[1] = Uint8(c0 >> 8);
+		out[2] = Uint8(c1), out[3] = Uint8(c1 >> 8);
+		out[4] = Uint8(indices), out[5] = Uint8(indices >> 8);
+		out[6] = Uint8(indices >> 16), out[7] = Uint8(indices >> 24);
+	}
+} // namespace
+
+namespace Graphics {
+
+	size_t GetBC1Size(int width, int height)
+	{
+		return size_t((width + 3) / 4) * size_t((height + 3) / 4) * BLOCK_SIZE;
+	}
+
+	void CompressBC1(const Color *pixels, int width, int height, Uint8 *out)
+	{
+		vector3f texels[16];
+		for (int by = 0; by < height; by += 4) {
+			for (int bx = 0; bx < width; bx += 4) {
+				for (int y = 0; y < 4; y++) {
+					const Color *row = pixels + std::min(by + y, height - 1) * width;
+					for (int x = 0; x < 4; x++) {
+						const Color &c = row[std::min(bx + x, width - 1)];
+						texels[y * 4 + x] = vector3f(c.r, c.g, c.b);
+					}
+				}
+				CompressBlock(texels, out);
+				out += BLOCK_SIZE;
+			}
+		}
+	}
+
+} // namespace Graphics
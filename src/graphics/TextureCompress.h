@@ -0,0 +1,27 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _GRAPHICS_TEXTURECOMPRESS_H
+#define _GRAPHICS_TEXTURECOMPRESS_H
+
+#include "Color.h"
+
+#include <cstddef>
+
+namespace Graphics {
+
+	// Bytes needed to store a width x height image as BC1 (DXT1).
+	size_t GetBC1Size(int width, int height);
+
+	// Compresses an opaque RGBA image to BC1 (DXT1), into GetBC1Size() bytes
+	// at out. Images that aren't a multiple of 4 texels in size have their
+	// edge texels repeated to fill the last blocks.
+	//
+	// Each block's endpoints are fitted along the principal axis of its
+	// colours, which is fast and good enough for smoothly varying generated
+	// textures; alpha is ignored.
+	void CompressBC1(const Color *pixels, int width, int height, Uint8 *out);
+
+} // namespace Graphics
+
+#endif /* _GRAPHICS_TEXTURECOMPRESS_H */
@@ -0,0 +1,57 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "TextureLoader.h"
+#include "Texture.h"
+#include "profiler/Profiler.h"
+
+namespace Graphics {
+
+	class TextureLoader::LoadJob : public Job {
+	public:
+		LoadJob(TextureLoader *loader, Texture *texture, const TextureBuilder &builder, bool streamed) :
+			m_loader(loader),
+			m_texture(texture),
+			m_builder(builder),
+			m_streamed(streamed)
+		{}
+
+		virtual void OnRun() override
+		{
+			PROFILE_SCOPED()
+			// reads, decodes and converts the image
+			m_builder.GetDescriptor();
+		}
+
+		virtual void OnFinish() override
+		{
+			m_loader->OnLoadFinished(m_texture.Get(), m_builder, m_streamed);
+		}
+
+	private:
+		TextureLoader *m_loader;
+		RefCountedPtr<Texture> m_texture;
+		TextureBuilder m_builder;
+		bool m_streamed;
+	};
+
+	TextureLoader::TextureLoader(Renderer *renderer, JobQueue *queue) :
+		m_renderer(renderer),
+		m_jobs(queue)
+	{
+	}
+
+	void TextureLoader::Load(Texture *texture, const TextureBuilder &builder, bool streamed)
+	{
+		m_pending.insert(texture);
+		m_jobs.Order(new LoadJob(this, texture, builder, streamed));
+	}
+
+	void TextureLoader::OnLoadFinished(Texture *texture, TextureBuilder &builder, bool streamed)
+	{
+		PROFILE_SCOPED()
+		builder.UploadTexture(m_renderer, texture, streamed);
+		m_pending.erase(m_pending.find(texture));
+	}
+
+} // namespace Graphics
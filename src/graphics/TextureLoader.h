@@ -0,0 +1,51 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _TEXTURELOADER_H
+#define _TEXTURELOADER_H
+
+#include "JobQueue.h"
+#include "TextureBuilder.h"
+
+#include <set>
+
+namespace Graphics {
+
+	class Renderer;
+	class Texture;
+
+	// Loads textures in the background for TextureBuilder::GetOrCreateTextureAsync.
+	//
+	// The file is read, decoded and converted in a job; only the upload into
+	// the texture, which stands in as a placeholder until then, happens on
+	// the main thread once the job finishes.
+	class TextureLoader {
+	public:
+		TextureLoader(Renderer *renderer, JobQueue *queue);
+
+		TextureLoader(const TextureLoader &) = delete;
+		TextureLoader &operator=(const TextureLoader &) = delete;
+
+		// Loads the builder's image into the texture, with its larger mips left
+		// to the renderer's TextureStreamer if streamed is set
+		void Load(Texture *texture, const TextureBuilder &builder, bool streamed);
+
+		uint32_t GetNumPending() const { return m_pending.size(); }
+		// true while the texture still holds its placeholder
+		bool IsPending(const Texture *texture) const { return m_pending.count(texture) != 0; }
+
+	private:
+		class LoadJob;
+
+		void OnLoadFinished(Texture *texture, TextureBuilder &builder, bool streamed);
+
+		Renderer *m_renderer;
+		std::multiset<const Texture *> m_pending;
+
+		// declared last so outstanding loads are cancelled first
+		JobSet m_jobs;
+	};
+
+} // namespace Graphics
+
+#endif
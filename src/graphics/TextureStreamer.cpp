@@ -0,0 +1,229 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "TextureStreamer.h"
+#include "FileSystem.h"
+#include "PicoDDS/PicoDDS.h"
+#include "profiler/Profiler.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Graphics {
+
+	// reads the levels a texture is missing from its DDS file
+	class TextureStreamer::LoadJob : public Job {
+	public:
+		LoadJob(TextureStreamer *streamer, uint32_t index, const std::string &filename, const TextureDescriptor &descriptor, uint32_t firstMip, uint32_t lastMip) :
+			Job(PRIORITY_LOW),
+			m_streamer(streamer),
+			m_index(index),
+			m_filename(filename),
+			m_descriptor(descriptor),
+			m_firstMip(firstMip),
+			m_lastMip(lastMip),
+			m_loaded(false)
+		{}
+
+		virtual void OnRun() override
+		{
+			PROFILE_SCOPED()
+			RefCountedPtr<FileSystem::FileData> filedata = FileSystem::gameDataFiles.ReadFile(m_filename);
+			if (!filedata)
+				return;
+
+			PicoDDS::DDSImage dds;
+			dds.Read(filedata->GetData(), filedata->GetSize());
+			// the file may have changed under a mod since the texture was created
+			if (!dds.headerdone_ || uint32_t(dds.imgdata_.width) != uint32_t(m_descriptor.dataSize.x) ||
+				uint32_t(dds.imgdata_.height) != uint32_t(m_descriptor.dataSize.y) ||
+				uint32_t(dds.imgdata_.numMipMaps) != m_descriptor.numberOfMipMaps)
+				return;
+
+			const size_t begin = GetMipOffset(m_descriptor, m_firstMip);
+			const size_t end = GetMipOffset(m_descriptor, m_lastMip);
+			m_data.assign(dds.imgdata_.imgData + begin, dds.imgdata_.imgData + end);
+			m_loaded = true;
+		}
+
+		virtual void OnFinish() override
+		{
+			if (m_loaded)
+				m_streamer->OnLoadFinished(m_index, m_firstMip, m_data);
+			else
+				m_streamer->OnLoadFailed(m_index, m_firstMip);
+		}
+
+	private:
+		TextureStreamer *m_streamer;
+		uint32_t m_index;
+		std::string m_filename;
+		TextureDescriptor m_descriptor;
+		uint32_t m_firstMip;
+		uint32_t m_lastMip;
+		bool m_loaded;
+		std::vector<uint8_t> m_data;
+	};
+
+	TextureStreamer::TextureStreamer(JobQueue *queue, size_t budget) :
+		m_budget(budget),
+		m_streamedSize(0),
+		m_frame(0),
+		m_numLoading(0),
+		m_numEvicted(0),
+		m_jobs(queue)
+	{
+	}
+
+	TextureStreamer::~TextureStreamer()
+	{
+	}
+
+	uint32_t TextureStreamer::GetResidentMip(const TextureDescriptor &descriptor)
+	{
+		if (descriptor.type != TEXTURE_2D || (descriptor.format != TEXTURE_DXT1 && descriptor.format != TEXTURE_DXT5))
+			return 0;
+
+		const uint32_t extent = std::max(uint32_t(descriptor.dataSize.x), uint32_t(descriptor.dataSize.y));
+		uint32_t mip = 0;
+		while (mip + 1 < descriptor.numberOfMipMaps && (extent >> mip) > RESIDENT_SIZE)
+			mip++;
+		return mip;
+	}
+
+	size_t TextureStreamer::GetMipSize(const TextureDescriptor &descriptor, uint32_t mip)
+	{
+		const size_t width = std::max<size_t>(size_t(descriptor.dataSize.x) >> mip, 1);
+		const size_t height = std::max<size_t>(size_t(descriptor.dataSize.y) >> mip, 1);
+		return ((width + 3) / 4) * ((height + 3) / 4) * (descriptor.format == TEXTURE_DXT1 ? 8 : 16);
+	}
+
+	size_t TextureStreamer::GetMipOffset(const TextureDescriptor &descriptor, uint32_t mip)
+	{
+		size_t offset = 0;
+		for (uint32_t i = 0; i < mip; i++)
+			offset += GetMipSize(descriptor, i);
+		return offset;
+	}
+
+	void TextureStreamer::AddTexture(Texture *texture, const std::string &filename, uint32_t residentMip)
+	{
+		assert(!IsStreamed(texture));
+		m_index[texture] = uint32_t(m_entries.size());
+		m_entries.push_back({ RefCountedPtr<Texture>(texture), filename, residentMip, 0, residentMip, residentMip, m_frame, false });
+	}
+
+	uint32_t TextureStreamer::GetLoadedMip(const Texture *texture) const
+	{
+		auto it = m_index.find(texture);
+		return it != m_index.end() ? m_entries[it->second].loadedMip : 0;
+	}
+
+	void TextureStreamer::RequestSize(const Texture *texture, float pixelSize)
+	{
+		auto it = m_index.find(texture);
+		if (it == m_index.end())
+			return;
+
+		Entry &entry = m_entries[it->second];
+		const TextureDescriptor &descriptor = entry.texture->GetDescriptor();
+		const float extent = std::max(descriptor.dataSize.x, descriptor.dataSize.y);
+		const float texels = std::max(pixelSize * TEXELS_PER_PIXEL, 1.0f);
+		const uint32_t mip = extent > texels ? uint32_t(std::log2(extent / texels)) : 0;
+
+		entry.requestedMip = std::min(entry.requestedMip, std::max(mip, entry.topMip));
+		entry.lastUsedFrame = m_frame;
+	}
+
+	size_t TextureStreamer::GetStreamedSize(const Entry &entry, uint32_t mip) const
+	{
+		const TextureDescriptor &descriptor = entry.texture->GetDescriptor();
+		return GetMipOffset(descriptor, entry.residentMip) - GetMipOffset(descriptor, mip);
+	}
+
+	void TextureStreamer::ReleaseMips(Entry &entry, uint32_t mip)
+	{
+		m_streamedSize -= GetStreamedSize(entry, entry.loadedMip) - GetStreamedSize(entry, mip);
+		entry.texture->SetBaseMip(mip);
+		entry.loadedMip = mip;
+		m_numEvicted++;
+	}
+
+	void TextureStreamer::Update()
+	{
+		PROFILE_SCOPED()
+
+		// textures furthest from the detail they're drawn at load first
+		std::vector<uint32_t> loads;
+		for (uint32_t i = 0; i < m_entries.size(); i++) {
+			const Entry &entry = m_entries[i];
+			if (!entry.loading && entry.requestedMip < entry.loadedMip)
+				loads.push_back(i);
+		}
+		std::sort(loads.begin(), loads.end(), [this](uint32_t a, uint32_t b) {
+			return m_entries[a].loadedMip - m_entries[a].requestedMip > m_entries[b].loadedMip - m_entries[b].requestedMip;
+		});
+
+		// release from textures drawn with less detail than they have, the
+		// ones not drawn for longest first; those drawn recently but not this
+		// frame are left alone, so they don't reload as soon as they're back
+		std::vector<uint32_t> evictions;
+		for (uint32_t i = 0; i < m_entries.size(); i++) {
+			const Entry &entry = m_entries[i];
+			const uint32_t unused = m_frame - entry.lastUsedFrame;
+			if (!entry.loading && entry.loadedMip < entry.requestedMip && (unused == 0 || unused >= EVICT_FRAMES))
+				evictions.push_back(i);
+		}
+		std::sort(evictions.begin(), evictions.end(), [this](uint32_t a, uint32_t b) {
+			return m_entries[a].lastUsedFrame < m_entries[b].lastUsedFrame;
+		});
+		auto nextEviction = evictions.begin();
+
+		for (uint32_t index : loads) {
+			if (m_numLoading >= MAX_LOADS_IN_FLIGHT)
+				break;
+
+			Entry &entry = m_entries[index];
+			const size_t size = GetStreamedSize(entry, entry.requestedMip) - GetStreamedSize(entry, entry.loadedMip);
+			for (; m_streamedSize + size > m_budget && nextEviction != evictions.end(); ++nextEviction)
+				ReleaseMips(m_entries[*nextEviction], m_entries[*nextEviction].requestedMip);
+			if (m_streamedSize + size > m_budget)
+				continue;
+
+			// the size is reserved now so loads in flight can't overrun the budget
+			m_streamedSize += size;
+			entry.loading = true;
+			m_numLoading++;
+			m_jobs.Order(new LoadJob(this, index, entry.filename, entry.texture->GetDescriptor(), entry.requestedMip, entry.loadedMip));
+		}
+
+		for (Entry &entry : m_entries)
+			entry.requestedMip = entry.residentMip;
+		m_frame++;
+	}
+
+	void TextureStreamer::OnLoadFinished(uint32_t index, uint32_t firstMip, const std::vector<uint8_t> &data)
+	{
+		Entry &entry = m_entries[index];
+		const TextureDescriptor &descriptor = entry.texture->GetDescriptor();
+		entry.texture->UpdateMips(data.data(), descriptor.dataSize, descriptor.format, firstMip, entry.loadedMip - firstMip);
+		entry.texture->SetBaseMip(firstMip);
+		entry.loadedMip = firstMip;
+		entry.loading = false;
+		m_numLoading--;
+	}
+
+	void TextureStreamer::OnLoadFailed(uint32_t index, uint32_t firstMip)
+	{
+		Entry &entry = m_entries[index];
+		Output("TextureStreamer: couldn't load the mips of '%s'\n", entry.filename.c_str());
+
+		// hand back the reserved size, and don't try again
+		m_streamedSize -= GetStreamedSize(entry, firstMip) - GetStreamedSize(entry, entry.loadedMip);
+		entry.topMip = entry.loadedMip;
+		entry.loading = false;
+		m_numLoading--;
+	}
+
+} // namespace Graphics
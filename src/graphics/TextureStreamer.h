@@ -0,0 +1,103 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _TEXTURESTREAMER_H
+#define _TEXTURESTREAMER_H
+
+#include "JobQueue.h"
+#include "RefCounted.h"
+#include "Texture.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Graphics {
+
+	// Streams the larger mip levels of model textures in and out of GPU memory.
+	//
+	// Streamed textures are created with only their small mips resident (see
+	// TextureBuilder::GetOrCreateStreamedTexture). Whatever draws them reports
+	// how large they appear on screen with RequestSize(), and once a frame
+	// Update() loads the levels that needs in background jobs, releasing the
+	// levels of the least recently drawn textures to stay within the budget.
+	class TextureStreamer {
+	public:
+		// Levels no larger than this are always resident
+		static constexpr uint32_t RESIDENT_SIZE = 256;
+		// Texels wanted for each pixel the texture covers on screen
+		static constexpr float TEXELS_PER_PIXEL = 2.0f;
+		// Frames a texture must go undrawn before its mips may be released
+		static constexpr uint32_t EVICT_FRAMES = 60;
+		static constexpr uint32_t MAX_LOADS_IN_FLIGHT = 4;
+
+		TextureStreamer(JobQueue *queue, size_t budget);
+		~TextureStreamer();
+
+		TextureStreamer(const TextureStreamer &) = delete;
+		TextureStreamer &operator=(const TextureStreamer &) = delete;
+
+		// The first mip level a texture would be created with, or zero if it's
+		// small enough (or not of a kind) to be worth streaming
+		static uint32_t GetResidentMip(const TextureDescriptor &descriptor);
+		// Size in bytes of a mip level of a compressed texture, and the offset
+		// of the level in a DDS image's packed mip chain
+		static size_t GetMipSize(const TextureDescriptor &descriptor, uint32_t mip);
+		static size_t GetMipOffset(const TextureDescriptor &descriptor, uint32_t mip);
+
+		// Starts streaming a texture whose levels from residentMip down are loaded
+		void AddTexture(Texture *texture, const std::string &filename, uint32_t residentMip);
+		bool IsStreamed(const Texture *texture) const { return m_index.count(texture); }
+		// Largest mip level of the texture currently loaded
+		uint32_t GetLoadedMip(const Texture *texture) const;
+
+		// Asks for enough detail to draw the texture pixelSize pixels across.
+		// Textures which aren't streamed are ignored.
+		void RequestSize(const Texture *texture, float pixelSize);
+
+		// Starts and finishes loads and releases mips over budget.
+		// Call once a frame from the main thread, after drawing.
+		void Update();
+
+		size_t GetBudget() const { return m_budget; }
+		// Bytes of streamed (non-resident) mip levels currently loaded
+		size_t GetStreamedSize() const { return m_streamedSize; }
+		uint32_t GetNumTextures() const { return uint32_t(m_entries.size()); }
+		uint32_t GetNumLoading() const { return m_numLoading; }
+		uint32_t GetNumEvicted() const { return m_numEvicted; }
+
+	private:
+		class LoadJob;
+
+		struct Entry {
+			RefCountedPtr<Texture> texture;
+			std::string filename;
+			uint32_t residentMip; // never released
+			uint32_t topMip;	  // best level that can be loaded
+			uint32_t loadedMip;
+			uint32_t requestedMip; // gathered over the current frame
+			uint32_t lastUsedFrame;
+			bool loading;
+		};
+
+		size_t GetStreamedSize(const Entry &entry, uint32_t mip) const;
+		void ReleaseMips(Entry &entry, uint32_t mip);
+		void OnLoadFinished(uint32_t index, uint32_t firstMip, const std::vector<uint8_t> &data);
+		void OnLoadFailed(uint32_t index, uint32_t firstMip);
+
+		size_t m_budget;
+		size_t m_streamedSize;
+		uint32_t m_frame;
+		uint32_t m_numLoading;
+		uint32_t m_numEvicted;
+
+		std::vector<Entry> m_entries;
+		std::unordered_map<const Texture *, uint32_t> m_index;
+
+		// declared last so outstanding loads are cancelled first
+		JobSet m_jobs;
+	};
+
+} // namespace Graphics
+
+#endif
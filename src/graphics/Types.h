@@ -49,7 +49,10 @@ namespace Graphics {
 		ATTRIB_FORMAT_FLOAT2,
 		ATTRIB_FORMAT_FLOAT3,
 		ATTRIB_FORMAT_FLOAT4,
-		ATTRIB_FORMAT_UBYTE4
+		ATTRIB_FORMAT_UBYTE4,
+		// normalised integers, read by shaders as floats in [-1,1]
+		ATTRIB_FORMAT_SHORT4N,
+		ATTRIB_FORMAT_BYTE4N
 	};
 
 	enum ConstantDataFormat : uint8_t {
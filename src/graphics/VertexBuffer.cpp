@@ -20,6 +20,10 @@ namespace Graphics {
 			return 16;
 		case ATTRIB_FORMAT_UBYTE4:
 			return 4;
+		case ATTRIB_FORMAT_SHORT4N:
+			return 8;
+		case ATTRIB_FORMAT_BYTE4N:
+			return 4;
 		default:
 			return 0;
 		}
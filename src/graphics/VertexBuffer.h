@@ -87,6 +87,10 @@ namespace Graphics {
 		// change the buffer data without mapping
 		virtual void BufferData(const size_t, void *) = 0;
 
+		// change size bytes of the buffer data from offset, without mapping
+		// or touching the rest of the buffer
+		virtual void BufferSubData(const size_t offset, const size_t size, const void *data) = 0;
+
 		// Bind the vertex buffer for use in rendering
 		virtual void Bind() = 0;
 
@@ -7,6 +7,7 @@
 #ifndef _RENDERER_DUMMY_H
 #define _RENDERER_DUMMY_H
 
+#include "graphics/DrawList.h"
 #include "graphics/RenderState.h"
 #include "graphics/Renderer.h"
 #include "graphics/VertexArray.h"
@@ -19,6 +20,22 @@
 
 namespace Graphics {
 
+	namespace Dummy {
+		class DrawList : public Graphics::DrawList {
+		public:
+			DrawList() :
+				m_transform(matrix4x4f::Identity())
+			{}
+			virtual void SetTransform(const matrix4x4f &m) override final { m_transform = m; }
+			virtual const matrix4x4f &GetTransform() const override final { return m_transform; }
+			virtual void DrawMesh(Graphics::MeshObject *, Graphics::Material *) override final {}
+			virtual void DrawMeshInstanced(Graphics::MeshObject *, Graphics::Material *, Graphics::InstanceBuffer *) override final {}
+
+		private:
+			matrix4x4f m_transform;
+		};
+	} // namespace Dummy
+
 	class RendererDummy : public Renderer {
 	public:
 		static void RegisterRenderer();
@@ -64,16 +81,28 @@ namespace Graphics {
 
 		virtual bool SetLightIntensity(Uint32, const float *) override final { return true; }
 		virtual bool SetLights(Uint32 numlights, const Light *l) override final { return true; }
+		virtual bool SetPointLights(Uint32 numLights, const PointLight *lights, float znear, float zfar) override final { return true; }
 		virtual Uint32 GetNumLights() const override final { return 1; }
 		virtual bool SetAmbientColor(const Color &c) override final { return true; }
 
 		virtual bool FlushCommandBuffers() override final { return true; }
 
+		virtual void BeginGPUTimer() override final {}
+		virtual void EndGPUTimer() override final {}
+		virtual bool PollGPUTimer(float &) override final { return false; }
+		virtual void PushGPUZone(const char *) override final {}
+		virtual void PopGPUZone() override final {}
+		virtual const std::vector<GPUZoneTime> &GetGPUZoneTimes() const override final { return m_gpuZoneTimes; }
+
 		virtual bool DrawBuffer(const VertexArray *, Material *) override final { return true; }
 		virtual bool DrawBufferDynamic(VertexBuffer *, uint32_t, IndexBuffer *, uint32_t, uint32_t, Material *) override final { return true; }
 		virtual bool DrawMesh(MeshObject *, Material *) override final { return true; }
 		virtual bool DrawMeshInstanced(MeshObject *, Material *, InstanceBuffer *) override final { return true; }
 
+		virtual DrawList *CreateDrawList() override final { return new Graphics::Dummy::DrawList(); }
+		virtual void BeginDrawList(DrawList *) override final {}
+		virtual void SubmitDrawList(DrawList *) override final {}
+
 		virtual Material *CreateMaterial(const std::string &s, const MaterialDescriptor &d, const RenderStateDesc &rsd) override final { return new Graphics::Dummy::Material(rsd); }
 		virtual Material *CloneMaterial(const Material *m, const MaterialDescriptor &d, const RenderStateDesc &rsd) override final { return new Graphics::Dummy::Material(rsd); }
 		virtual Texture *CreateTexture(const TextureDescriptor &d) override final { return new Graphics::TextureDummy(d); }
@@ -101,6 +130,7 @@ namespace Graphics {
 	private:
 		const matrix4x4f m_identity;
 		Graphics::RenderTarget *m_rt;
+		std::vector<GPUZoneTime> m_gpuZoneTimes;
 	};
 
 } // namespace Graphics
@@ -14,6 +14,10 @@ namespace Graphics {
 		virtual void Update(const TextureCubeData &data, const vector3f &dataSize, TextureFormat format, const unsigned int numMips) override final {}
 		virtual void Update(const vecDataPtr &data, const vector3f &dataSize, const TextureFormat format, const unsigned int numMips) override final {}
 
+		virtual void UpdateMips(const void *data, const vector3f &dataSize, TextureFormat format, uint32_t firstMip, uint32_t numMips) override final {}
+		virtual void SetBaseMip(uint32_t baseMip) override final {}
+		virtual void Respecify(const TextureDescriptor &descriptor) override final { SetDescriptor(descriptor); }
+
 		void Bind() override {}
 		void Unbind() override {}
 
@@ -25,6 +25,7 @@ namespace Graphics {
 
 			// change the buffer data without mapping
 			virtual void BufferData(const size_t, void *) override final {}
+			virtual void BufferSubData(const size_t, const size_t, const void *) override final {}
 
 			virtual void Bind() override final {}
 			virtual void Release() override final {}
@@ -0,0 +1,70 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "BufferRing.h"
+
+#include "profiler/Profiler.h"
+
+using namespace Graphics::OGL;
+
+// regions start on the strictest offset alignment a buffer binding can need
+static constexpr uint32_t REGION_ALIGNMENT_MASK = 256 - 1;
+
+static constexpr GLbitfield MAP_FLAGS = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+bool BufferRing::IsSupported()
+{
+	static const bool supported = glewIsSupported("GL_ARB_buffer_storage");
+	return supported;
+}
+
+BufferRing::BufferRing() :
+	m_data(nullptr),
+	m_regionSize(0),
+	m_region(0),
+	m_fences{}
+{
+}
+
+BufferRing::~BufferRing()
+{
+	// the mapping goes away with the buffer itself
+	for (GLsync fence : m_fences)
+		if (fence)
+			glDeleteSync(fence);
+}
+
+void BufferRing::Init(GLenum target, uint32_t regionSize)
+{
+	assert(IsSupported() && !IsMapped());
+	m_regionSize = (regionSize + REGION_ALIGNMENT_MASK) & ~REGION_ALIGNMENT_MASK;
+
+	const GLsizeiptr size = GLsizeiptr(m_regionSize) * NUM_REGIONS;
+	glBufferStorage(target, size, nullptr, MAP_FLAGS);
+	m_data = reinterpret_cast<uint8_t *>(glMapBufferRange(target, 0, size, MAP_FLAGS));
+	assert(m_data != nullptr);
+}
+
+void BufferRing::Advance()
+{
+	PROFILE_SCOPED()
+	m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_region = (m_region + 1) % NUM_REGIONS;
+
+	GLsync &fence = m_fences[m_region];
+	if (!fence)
+		return;
+
+	// the GPU is normally long done with a frame this old; if not, flush
+	// once and wait for it rather than overwrite data still being read
+	GLbitfield flags = 0;
+	for (;;) {
+		GLenum result = glClientWaitSync(fence, flags, 1000000);
+		if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED)
+			break;
+		flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+	}
+
+	glDeleteSync(fence);
+	fence = nullptr;
+}
@@ -0,0 +1,63 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#pragma once
+
+#include "OpenGLLibs.h"
+
+#include <cassert>
+#include <cstdint>
+
+namespace Graphics {
+
+	namespace OGL {
+
+		/*
+			Persistently and coherently maps a buffer's storage as NUM_REGIONS
+			equal regions, so per-frame dynamic data can be written straight
+			into memory the GPU reads from without a copy or a Map/Unmap call.
+
+			Each frame writes into one region. Advance() fences the region at
+			the end of the frame and moves on to the next, waiting only if the
+			GPU is still reading the frame that last used it.
+
+			Needs GL_ARB_buffer_storage (core in GL 4.4); owners keep their
+			old streaming path for when IsSupported() is false.
+		*/
+		class BufferRing {
+		public:
+			static constexpr uint32_t NUM_REGIONS = 3;
+
+			static bool IsSupported();
+
+			BufferRing();
+			~BufferRing();
+
+			BufferRing(const BufferRing &) = delete;
+			BufferRing &operator=(const BufferRing &) = delete;
+
+			// Give the buffer bound to target immutable storage for NUM_REGIONS
+			// regions of at least regionSize bytes each, and map it.
+			void Init(GLenum target, uint32_t regionSize);
+
+			bool IsMapped() const { return m_data != nullptr; }
+
+			// The region this frame's data is written into
+			uint8_t *GetRegionData() const { return m_data + GetRegionOffset(); }
+			uint32_t GetRegionOffset() const { return m_region * m_regionSize; }
+			uint32_t GetRegionSize() const { return m_regionSize; }
+
+			// Fence the current region once the GPU has been sent the frame's
+			// commands, and move on to the next one
+			void Advance();
+
+		private:
+			uint8_t *m_data;
+			uint32_t m_regionSize;
+			uint32_t m_region;
+			GLsync m_fences[NUM_REGIONS];
+		};
+
+	} // namespace OGL
+
+} // namespace Graphics
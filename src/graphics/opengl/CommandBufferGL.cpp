@@ -12,9 +12,13 @@
 #include "UniformBuffer.h"
 #include "VertexBufferGL.h"
 
+#include "graphics/Stats.h"
 #include "graphics/VertexBuffer.h"
 #include "profiler/Profiler.h"
 
+#include <algorithm>
+#include <tuple>
+
 using namespace Graphics::OGL;
 
 void CommandList::AddDrawCmd(Graphics::MeshObject *mesh, Graphics::Material *material, Graphics::InstanceBuffer *inst)
@@ -153,6 +157,13 @@ void CommandList::AddBlitRenderTargetCmd(
 	m_drawCmds.emplace_back(std::move(cmd));
 }
 
+void CommandList::AddTimestampCmd(GLuint query)
+{
+	assert(!m_executing && "Attempt to append to a command list while it's being executed!");
+
+	m_drawCmds.emplace_back(TimestampCmd{ query });
+}
+
 void CommandList::Reset()
 {
 	assert(!m_executing && "Attempt to reset a command list while it's being executed!");
@@ -169,12 +180,17 @@ size_t align(size_t t)
 	return (t + (I - 1)) & ~(I - 1);
 }
 
-char *CommandList::AllocDrawData(const Shader *shader)
+size_t CommandList::GetDrawDataSize(const Shader *shader)
 {
 	size_t constantSize = align<8>(shader->GetConstantStorageSize());
 	size_t bufferSize = align<8>(shader->GetNumBufferBindings() * sizeof(BufferBinding<UniformBuffer>));
 	size_t textureSize = align<8>(shader->GetNumTextureBindings() * sizeof(Texture *));
-	size_t totalSize = constantSize + bufferSize + textureSize;
+	return constantSize + bufferSize + textureSize;
+}
+
+char *CommandList::AllocDrawData(const Shader *shader)
+{
+	size_t totalSize = GetDrawDataSize(shader);
 
 	char *alloc = nullptr;
 	for (auto &bucket : m_dataBuckets) {
@@ -354,5 +370,128 @@ void CommandList::ExecuteBlitRenderTargetCmd(const BlitRenderTargetCmd &cmd)
 		cmd.dstTarget->Unbind(RenderTarget::DRAW);
 
 	CHECKERRORS();
+}
+
+void CommandList::ExecuteTimestampCmd(const TimestampCmd &cmd)
+{
+	glQueryCounter(cmd.query, GL_TIMESTAMP);
+	CHECKERRORS();
+}
+
+namespace {
+	// what a draw command binds, whichever kind it is
+	struct DrawState {
+		const Shader *shader;
+		Program *program;
+		char *drawData;
+		size_t renderStateHash;
+		const void *mesh;
+	};
+
+	template <typename CmdT>
+	bool GetDrawState(const CmdT &cmd, DrawState &out)
+	{
+		if (auto *drawCmd = std::get_if<CommandList::DrawCmd>(&cmd)) {
+			out = { drawCmd->shader, drawCmd->program, drawCmd->drawData, drawCmd->renderStateHash, drawCmd->mesh };
+			return true;
+		}
+		if (auto *dynDrawCmd = std::get_if<CommandList::DynamicDrawCmd>(&cmd)) {
+			out = { dynDrawCmd->shader, dynDrawCmd->program, dynDrawCmd->drawData, dynDrawCmd->renderStateHash, dynDrawCmd->vtxBind.buffer };
+			return true;
+		}
+		return false;
+	}
+} // namespace
+
+bool CommandList::SortKey::operator<(const SortKey &rhs) const
+{
+	return std::tie(program, texture, mesh, renderStateHash, index) <
+		std::tie(rhs.program, rhs.texture, rhs.mesh, rhs.renderStateHash, rhs.index);
+}
+
+bool CommandList::IsSortable(const Cmd &cmd, std::pair<size_t, bool> &lastState) const
+{
+	DrawState draw;
+	if (!GetDrawState(cmd, draw))
+		return false;
+
+	// consecutive draws mostly share their render state
+	if (draw.renderStateHash != lastState.first) {
+		const RenderStateDesc &rsd = m_renderer->GetStateCache()->GetRenderState(draw.renderStateHash);
+		lastState.first = draw.renderStateHash;
+		lastState.second = rsd.blendMode == BLEND_SOLID && rsd.depthTest && rsd.depthWrite;
+	}
+	return lastState.second;
+}
+
+void CommandList::SortRun(size_t first, size_t last)
+{
+	m_sortKeys.clear();
+	for (size_t idx = first; idx < last; idx++) {
+		DrawState draw;
+		GetDrawState(m_drawCmds[idx], draw);
+
+		const TextureGL *texture = nullptr;
+		if (draw.shader->GetNumTextureBindings())
+			texture = getTextureBindings(draw.shader, draw.drawData)[draw.shader->GetTextureBindings()[0].index];
+		m_sortKeys.push_back({ draw.program, texture, draw.mesh, draw.renderStateHash, uint32_t(idx) });
+	}
+	std::sort(m_sortKeys.begin(), m_sortKeys.end());
+
+	m_sortedCmds.clear();
+	for (const SortKey &key : m_sortKeys)
+		m_sortedCmds.push_back(std::move(m_drawCmds[key.index]));
+	std::move(m_sortedCmds.begin(), m_sortedCmds.end(), m_drawCmds.begin() + first);
+}
+
+void CommandList::CountBinds(const Cmd *first, const Cmd *last, uint32_t &programs, uint32_t &textures)
+{
+	const Program *boundProgram = nullptr;
+	m_boundTextures.clear();
+	for (const Cmd *cmd = first; cmd != last; cmd++) {
+		DrawState draw;
+		if (!GetDrawState(*cmd, draw))
+			continue;
+
+		if (draw.program != boundProgram) {
+			boundProgram = draw.program;
+			programs++;
+		}
+
+		TextureGL **bindings = getTextureBindings(draw.shader, draw.drawData);
+		for (auto &info : draw.shader->GetTextureBindings()) {
+			if (info.binding >= m_boundTextures.size())
+				m_boundTextures.resize(info.binding + 1, nullptr);
+			if (m_boundTextures[info.binding] != bindings[info.index]) {
+				m_boundTextures[info.binding] = bindings[info.index];
+				textures++;
+			}
+		}
+	}
+}
+
+void CommandList::SortDrawCmds()
+{
+	PROFILE_SCOPED()
+	uint32_t programsBefore = 0, texturesBefore = 0;
+	CountBinds(m_drawCmds.data(), m_drawCmds.data() + m_drawCmds.size(), programsBefore, texturesBefore);
+
+	std::pair<size_t, bool> lastState = { 0, false };
+	size_t first = 0;
+	for (size_t idx = 0; idx <= m_drawCmds.size(); idx++) {
+		if (idx < m_drawCmds.size() && IsSortable(m_drawCmds[idx], lastState))
+			continue;
+		if (idx - first > 1)
+			SortRun(first, idx);
+		first = idx + 1;
+	}
+
+	uint32_t programsAfter = 0, texturesAfter = 0;
+	CountBinds(m_drawCmds.data(), m_drawCmds.data() + m_drawCmds.size(), programsAfter, texturesAfter);
 
+	Stats &stats = m_renderer->GetStats();
+	if (programsAfter < programsBefore)
+		stats.AddToStatCount(Stats::STAT_PROGRAM_BINDS_SAVED, programsBefore - programsAfter);
+	if (texturesAfter < texturesBefore)
+		stats.AddToStatCount(Stats::STAT_TEXTURE_BINDS_SAVED, texturesBefore - texturesAfter);
 }
@@ -33,6 +33,8 @@ namespace Graphics {
 		class UniformBuffer;
 		class VertexBuffer;
 
+		class DrawList;
+
 		class CommandList {
 		public:
 			struct DrawCmd {
@@ -74,6 +76,10 @@ namespace Graphics {
 				bool linearFilter;
 			};
 
+			struct TimestampCmd {
+				GLuint query;
+			};
+
 			// development asserts to ensure sizes are kept reasonable.
 			// if you need to go beyond these sizes, add a new command instead.
 			static_assert(sizeof(DrawCmd) <= 64);
@@ -95,21 +101,35 @@ namespace Graphics {
 				const ViewportExtents &dstExtents,
 				bool resolveMSAA = false, bool blitDepthBuffer = false, bool linearFilter = true);
 
+			// Records the GPU time when the commands before it are done
+			void AddTimestampCmd(GLuint query);
+
 		protected:
-			using Cmd = std::variant<DrawCmd, DynamicDrawCmd, RenderPassCmd, BlitRenderTargetCmd>;
+			using Cmd = std::variant<DrawCmd, DynamicDrawCmd, RenderPassCmd, BlitRenderTargetCmd, TimestampCmd>;
 			const std::vector<Cmd> &GetDrawCmds() const { return m_drawCmds; }
 
 			bool IsEmpty() const { return m_drawCmds.empty(); }
 			void Reset();
 
+			// Reorders each run of opaque, depth-tested draws between render
+			// pass and blending changes so that draws sharing a program,
+			// textures and mesh follow each other. Draws whose result depends
+			// on their order keep it, and act as the run's boundaries.
+			// Adds the program and texture binds saved to the renderer's stats.
+			void SortDrawCmds();
+
 		private:
 			friend class Graphics::RendererOGL;
+			friend class OGL::DrawList;
 			CommandList(Graphics::RendererOGL *r) :
 				m_renderer(r)
 			{
 				m_drawCmds.reserve(32);
 			}
 
+			// The size of the shader data cached forward for each command;
+			// laid out as push constants, then buffer and texture bindings
+			static size_t GetDrawDataSize(const Shader *shader);
 			// Allocate space for all shader data that needs to be cached forward
 			char *AllocDrawData(const Shader *shader);
 			// Create and cache all material data needed for later execution of a draw command
@@ -122,6 +142,23 @@ namespace Graphics {
 			void ExecuteDynamicDrawCmd(const DynamicDrawCmd &);
 			void ExecuteRenderPassCmd(const RenderPassCmd &);
 			void ExecuteBlitRenderTargetCmd(const BlitRenderTargetCmd &);
+			void ExecuteTimestampCmd(const TimestampCmd &);
+
+			struct SortKey {
+				const Program *program;
+				const TextureGL *texture;
+				const void *mesh;
+				size_t renderStateHash;
+				uint32_t index; // in submission order, so equal keys keep it
+
+				bool operator<(const SortKey &rhs) const;
+			};
+
+			bool IsSortable(const Cmd &cmd, std::pair<size_t, bool> &lastState) const;
+			void SortRun(size_t first, size_t last);
+			// the program and texture binds executing the commands would make,
+			// assuming nothing is bound beforehand
+			void CountBinds(const Cmd *first, const Cmd *last, uint32_t &programs, uint32_t &textures);
 
 			static BufferBinding<UniformBuffer> *getBufferBindings(const Shader *shader, char *data);
 			static TextureGL **getTextureBindings(const Shader *shader, char *data);
@@ -147,6 +184,10 @@ namespace Graphics {
 
 			Graphics::RendererOGL *m_renderer;
 			std::vector<Cmd> m_drawCmds;
+			// scratch space for SortDrawCmds()
+			std::vector<SortKey> m_sortKeys;
+			std::vector<Cmd> m_sortedCmds;
+			std::vector<const TextureGL *> m_boundTextures;
 			std::vector<DataBucket> m_dataBuckets;
 			bool m_executing = false;
 		};
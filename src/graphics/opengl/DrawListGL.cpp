@@ -0,0 +1,134 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "DrawListGL.h"
+#include "CommandBufferGL.h"
+#include "RendererGL.h"
+#include "Shader.h"
+#include "TextureGL.h"
+#include "UniformBuffer.h"
+#include "VertexBufferGL.h"
+
+#include "profiler/Profiler.h"
+
+#include <cstring>
+
+using namespace Graphics::OGL;
+
+static size_t s_lightDataName = "LightData"_hash;
+static size_t s_lightClusterDataName = "LightClusterData"_hash;
+static size_t s_drawDataName = "DrawData"_hash;
+static size_t s_lightIntensityName = "lightIntensity"_hash;
+
+DrawList::DrawList(RendererOGL *r) :
+	m_renderer(r),
+	m_transform(matrix4x4f::Identity()),
+	m_projection(matrix4x4f::Identity()),
+	m_lightIntensity(0.f, 0.f, 0.f, 0.f),
+	m_lightBinding({ nullptr, 0, 0 }),
+	m_lightClusterBinding({ nullptr, 0, 0 })
+{
+}
+
+void DrawList::Begin()
+{
+	m_entries.clear();
+	m_drawData.clear();
+	m_drawDataBlocks.clear();
+
+	m_transform = m_renderer->GetTransform();
+	m_projection = m_renderer->GetProjection();
+	m_ambient = m_renderer->GetAmbientColor();
+
+	float intensity[4] = { 0.f, 0.f, 0.f, 0.f };
+	for (uint32_t i = 0; i < m_renderer->GetNumLights(); i++)
+		intensity[i] = m_renderer->GetLight(i).GetIntensity();
+	m_lightIntensity = Color4f(intensity[0], intensity[1], intensity[2], intensity[3]);
+
+	UniformBuffer *lightBuffer = m_renderer->GetLightUniformBuffer();
+	m_lightBinding = { lightBuffer, 0, lightBuffer->GetSize() };
+
+	UniformBuffer *clusterBuffer = m_renderer->GetLightClusterBuffer();
+	m_lightClusterBinding = { clusterBuffer, 0, clusterBuffer->GetSize() };
+}
+
+void DrawList::Record(Graphics::MeshObject *mesh, Graphics::Material *material, Graphics::InstanceBuffer *inst)
+{
+	OGL::Material *mat = static_cast<OGL::Material *>(material);
+	const Shader *s = mat->GetShader();
+
+	Entry entry{};
+	entry.mesh = static_cast<OGL::MeshObject *>(mesh);
+	entry.inst = static_cast<OGL::InstanceBuffer *>(inst);
+	entry.material = mat;
+	entry.dataOffset = m_drawData.size();
+	entry.drawDataIndex = Shader::InvalidBinding;
+
+	m_drawData.resize(entry.dataOffset + CommandList::GetDrawDataSize(s), '\0');
+	char *data = m_drawData.data() + entry.dataOffset;
+
+	if (mat->m_pushConstants)
+		memcpy(data, mat->m_pushConstants.get(), s->GetConstantStorageSize());
+
+	BufferBinding<UniformBuffer> *buffers = CommandList::getBufferBindings(s, data);
+	for (size_t index = 0; index < s->GetNumBufferBindings(); index++)
+		buffers[index] = mat->m_bufferBindings[index];
+
+	TextureGL **textures = CommandList::getTextureBindings(s, data);
+	for (size_t index = 0; index < s->GetNumTextureBindings(); index++)
+		textures[index] = static_cast<TextureGL *>(mat->m_textureBindings[index]);
+
+	// what Material::UpdateDrawData() would have set on the material, written
+	// into the copy instead
+	if (mat->GetDescriptor().lighting) {
+		BufferBindingData lightData = s->GetBufferBindingInfo(s_lightDataName);
+		if (lightData.binding != Shader::InvalidBinding)
+			buffers[lightData.index] = m_lightBinding;
+
+		BufferBindingData clusterData = s->GetBufferBindingInfo(s_lightClusterDataName);
+		if (clusterData.binding != Shader::InvalidBinding)
+			buffers[clusterData.index] = m_lightClusterBinding;
+
+		PushConstantData intensity = s->GetPushConstantInfo(s_lightIntensityName);
+		if (intensity.binding != Shader::InvalidBinding && intensity.format == ConstantDataFormat::DATA_FORMAT_FLOAT4)
+			*reinterpret_cast<Color4f *>(data + intensity.offset) = m_lightIntensity;
+	}
+
+	if (mat->m_perDrawBinding != Shader::InvalidBinding) {
+		entry.drawDataIndex = s->GetBufferBindingInfo(s_drawDataName).index;
+		entry.drawDataBlock = m_drawDataBlocks.size();
+		mat->FillDrawData(m_drawDataBlocks.emplace_back(), m_transform, m_projection, m_ambient);
+	}
+
+	m_entries.push_back(entry);
+}
+
+void DrawList::Submit(CommandList *cmdList)
+{
+	PROFILE_SCOPED()
+	assert(!cmdList->m_executing && "Attempt to append to a command list while it's being executed!");
+
+	for (const Entry &entry : m_entries) {
+		OGL::Material *mat = entry.material;
+
+		CommandList::DrawCmd cmd{};
+		cmd.mesh = entry.mesh;
+		cmd.inst = entry.inst;
+		cmd.program = mat->EvaluateVariant();
+		cmd.shader = mat->GetShader();
+		cmd.renderStateHash = mat->m_renderStateHash;
+
+		cmd.drawData = cmdList->AllocDrawData(cmd.shader);
+		memcpy(cmd.drawData, m_drawData.data() + entry.dataOffset, CommandList::GetDrawDataSize(cmd.shader));
+
+		if (entry.drawDataIndex != Shader::InvalidBinding) {
+			DrawDataBlock &block = m_drawDataBlocks[entry.drawDataBlock];
+			UniformLinearBuffer *buffer = m_renderer->GetDrawUniformBuffer(sizeof(DrawDataBlock));
+			CommandList::getBufferBindings(cmd.shader, cmd.drawData)[entry.drawDataIndex] = buffer->Allocate(&block, sizeof(DrawDataBlock));
+		}
+
+		cmdList->m_drawCmds.emplace_back(std::move(cmd));
+	}
+
+	m_entries.clear();
+}
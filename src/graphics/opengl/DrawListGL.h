@@ -0,0 +1,73 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#pragma once
+
+#include "Color.h"
+#include "graphics/DrawList.h"
+#include "graphics/Types.h"
+#include "MaterialGL.h"
+
+#include <vector>
+
+namespace Graphics {
+
+	class RendererOGL;
+
+	namespace OGL {
+
+		class CommandList;
+		class InstanceBuffer;
+		class MeshObject;
+
+		// Records draws the way CommandList::AddDrawCmd does, but without
+		// touching the material or the renderer: the material's bindings and
+		// its per-draw uniform block are copied into storage owned by the list.
+		// Everything that needs the main thread - evaluating the program
+		// variant and allocating uniform buffer space - waits for Submit().
+		class DrawList final : public Graphics::DrawList {
+		public:
+			virtual void SetTransform(const matrix4x4f &m) override final { m_transform = m; }
+			virtual const matrix4x4f &GetTransform() const override final { return m_transform; }
+
+			virtual void DrawMesh(Graphics::MeshObject *mesh, Graphics::Material *mat) override final { Record(mesh, mat, nullptr); }
+			virtual void DrawMeshInstanced(Graphics::MeshObject *mesh, Graphics::Material *mat, Graphics::InstanceBuffer *inst) override final { Record(mesh, mat, inst); }
+
+		private:
+			friend class Graphics::RendererOGL;
+			DrawList(RendererOGL *r);
+
+			// Clear the list and capture the renderer's view state for recording
+			void Begin();
+			// Append the recorded draws to the given command list
+			void Submit(CommandList *cmdList);
+
+			void Record(Graphics::MeshObject *mesh, Graphics::Material *mat, Graphics::InstanceBuffer *inst);
+
+			struct Entry {
+				MeshObject *mesh;
+				InstanceBuffer *inst;
+				Material *material;
+				size_t dataOffset;		// into m_drawData
+				uint32_t drawDataIndex; // the DrawData buffer binding, if the shader has one
+				uint32_t drawDataBlock; // into m_drawDataBlocks
+			};
+
+			RendererOGL *m_renderer;
+			matrix4x4f m_transform;
+
+			// view state captured by Begin()
+			matrix4x4f m_projection;
+			Color m_ambient;
+			Color4f m_lightIntensity;
+			BufferBinding<UniformBuffer> m_lightBinding;
+			BufferBinding<UniformBuffer> m_lightClusterBinding;
+
+			std::vector<Entry> m_entries;
+			// copies of each draw's material data, laid out as CommandList draw data
+			std::vector<char> m_drawData;
+			std::vector<DrawDataBlock> m_drawDataBlocks;
+		};
+
+	} // namespace OGL
+} // namespace Graphics
@@ -17,23 +17,8 @@
 namespace Graphics {
 	namespace OGL {
 
-		struct DrawDataBlock {
-			// matrix data
-			matrix4x4f uViewMatrix;
-			matrix4x4f uViewMatrixInverse;
-			matrix4x4f uViewProjectionMatrix;
-
-			// Material Struct
-			Color4f diffuse;
-			Color4f specular;
-			Color4f emission;
-
-			// Scene struct
-			Color4f ambient;
-		};
-		static_assert(sizeof(DrawDataBlock) == 256, "");
-
 		static size_t s_lightDataName = "LightData"_hash;
+		static size_t s_lightClusterDataName = "LightClusterData"_hash;
 		static size_t s_drawDataName = "DrawData"_hash;
 		static size_t s_lightIntensityName = "lightIntensity"_hash;
 
@@ -101,6 +86,10 @@ namespace Graphics {
 				UniformBuffer *lightBuffer = m_renderer->GetLightUniformBuffer();
 				SetBuffer(s_lightDataName, { lightBuffer, 0, lightBuffer->GetSize() });
 
+				// only shaders taking the clustered point lights declare this
+				UniformBuffer *clusterBuffer = m_renderer->GetLightClusterBuffer();
+				SetBuffer(s_lightClusterDataName, { clusterBuffer, 0, clusterBuffer->GetSize() });
+
 				float intensity[4] = { 0.f, 0.f, 0.f, 0.f };
 				for (uint32_t i = 0; i < m_renderer->GetNumLights(); i++)
 					intensity[i] = m_renderer->GetLight(i).GetIntensity();
@@ -114,23 +103,26 @@ namespace Graphics {
 				BufferBinding<UniformBuffer> binding;
 
 				auto dataBlock = buffer->Allocate<DrawDataBlock>(binding);
-				dataBlock->diffuse = this->diffuse.ToColor4f();
-				dataBlock->specular = this->specular.ToColor4f();
-				dataBlock->specular.a = this->shininess;
-				dataBlock->emission = this->emissive.ToColor4f();
-				dataBlock->ambient = m_renderer->GetAmbientColor().ToColor4f();
-
-				// We handle the normal matrix by transposing the orientation part of the inverse view matrix in the shader
-				const matrix4x4f &mv = m_renderer->GetTransform();
-				const matrix4x4f &proj = m_renderer->GetProjection();
-				dataBlock->uViewMatrix = mv;
-				dataBlock->uViewMatrixInverse = mv.Inverse();
-				dataBlock->uViewProjectionMatrix = proj * mv;
+				FillDrawData(*dataBlock.data(), m_renderer->GetTransform(), m_renderer->GetProjection(), m_renderer->GetAmbientColor());
 
 				SetBuffer(s_drawDataName, { binding.buffer, binding.offset, binding.size });
 			}
 		}
 
+		void Material::FillDrawData(DrawDataBlock &block, const matrix4x4f &mv, const matrix4x4f &proj, const Color &ambient) const
+		{
+			block.diffuse = diffuse.ToColor4f();
+			block.specular = specular.ToColor4f();
+			block.specular.a = shininess;
+			block.emission = emissive.ToColor4f();
+			block.ambient = ambient.ToColor4f();
+
+			// We handle the normal matrix by transposing the orientation part of the inverse view matrix in the shader
+			block.uViewMatrix = mv;
+			block.uViewMatrixInverse = mv.Inverse();
+			block.uViewProjectionMatrix = proj * mv;
+		}
+
 		bool Material::IsProgramLoaded() const
 		{
 			return m_activeVariant && m_activeVariant->Loaded();
@@ -16,6 +16,7 @@
 #include "graphics/Material.h"
 #include "graphics/Types.h"
 #include "graphics/opengl/UniformBuffer.h"
+#include "matrix4x4.h"
 
 #include <memory>
 #include <string>
@@ -28,10 +29,28 @@ namespace Graphics {
 	namespace OGL {
 
 		class CommandList;
+		class DrawList;
 		class Shader;
 		class Program;
 		class UniformBuffer;
 
+		// The per-draw uniform block every shader reads as DrawData
+		struct DrawDataBlock {
+			// matrix data
+			matrix4x4f uViewMatrix;
+			matrix4x4f uViewMatrixInverse;
+			matrix4x4f uViewProjectionMatrix;
+
+			// Material Struct
+			Color4f diffuse;
+			Color4f specular;
+			Color4f emission;
+
+			// Scene struct
+			Color4f ambient;
+		};
+		static_assert(sizeof(DrawDataBlock) == 256, "");
+
 		class Material : public Graphics::Material {
 		public:
 			Material() {}
@@ -56,9 +75,13 @@ namespace Graphics {
 		protected:
 			friend class Graphics::RendererOGL;
 			friend class OGL::CommandList;
+			friend class OGL::DrawList;
 			void Copy(OGL::Material *to) const;
 			Program *EvaluateVariant();
 			void UpdateDrawData();
+			// Fills in the material's draw data for the given view without
+			// touching the material, so it can be called from any thread
+			void FillDrawData(DrawDataBlock &block, const matrix4x4f &mv, const matrix4x4f &proj, const Color &ambient) const;
 
 			Shader *m_shader;
 			Program *m_activeVariant;
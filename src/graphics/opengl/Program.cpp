@@ -3,6 +3,7 @@
 
 #include "Program.h"
 #include "FileSystem.h"
+#include "ProgramCache.h"
 #include "Shader.h"
 #include "StringF.h"
 #include "StringRange.h"
@@ -78,64 +79,60 @@ namespace Graphics {
 			return true;
 		}
 
-		// ShaderProgram is a helper class to wrap fragment/vertex shader
-		// creation. The hierarchy is conceptually:
-		//   Shader ->
-		//     Program ->
-		//       ShaderProgram (vertex)
-		//       ShaderProgram (fragment)
-		struct ShaderProgram {
-			ShaderProgram(GLenum type, const std::string &filename, const std::string &defines)
-			{
-				RefCountedPtr<FileSystem::FileData> filecode = FileSystem::gameDataFiles.ReadFile(filename);
-
-				if (!filecode.Valid())
-					Error("Could not load %s", filename.c_str());
-
-				std::string strCode(filecode->AsStringRange().ToString());
-				size_t found = strCode.find("#include");
-				while (found != std::string::npos) {
-					// find the name of the file to include
-					const size_t begFilename = strCode.find_first_of("\"", found + 8) + 1;
-					const size_t endFilename = strCode.find_first_of("\"", begFilename + 1);
-
-					const std::string incFilename = strCode.substr(begFilename, endFilename - begFilename);
-
-					// check we haven't it already included it (avoids circular dependencies)
-					const std::set<std::string>::const_iterator foundIt = previousIncludes.find(incFilename);
-					if (foundIt != previousIncludes.end()) {
-						Error("Circular, or multiple, include of %s\n", incFilename.c_str());
-					} else {
-						previousIncludes.insert(incFilename);
-					}
-
-					// build path for include
-					const std::string incPathBuffer = stringf("shaders/opengl/%0", incFilename);
-
-					// read included file
-					RefCountedPtr<FileSystem::FileData> incCode = FileSystem::gameDataFiles.ReadFile(incPathBuffer);
-					assert(incCode.Valid());
-
-					if (incCode.Valid()) {
-						// replace the #include and filename with the included files text
-						strCode.replace(found, (endFilename + 1) - found, incCode->GetData(), incCode->GetSize());
-						found = strCode.find("#include");
-					} else {
-						Error("Could not load shader #include %s for shader %s\n", incPathBuffer.c_str(), filename.c_str());
-					}
+		// Reads a shader stage's source, resolving #includes, and builds the
+		// final text to be compiled
+		static std::string LoadShaderSource(GLenum type, const std::string &filename, const std::string &defines)
+		{
+			RefCountedPtr<FileSystem::FileData> filecode = FileSystem::gameDataFiles.ReadFile(filename);
+
+			if (!filecode.Valid())
+				Error("Could not load %s", filename.c_str());
+
+			std::set<std::string> previousIncludes;
+			std::string strCode(filecode->AsStringRange().ToString());
+			size_t found = strCode.find("#include");
+			while (found != std::string::npos) {
+				// find the name of the file to include
+				const size_t begFilename = strCode.find_first_of("\"", found + 8) + 1;
+				const size_t endFilename = strCode.find_first_of("\"", begFilename + 1);
+
+				const std::string incFilename = strCode.substr(begFilename, endFilename - begFilename);
+
+				// check we haven't it already included it (avoids circular dependencies)
+				const std::set<std::string>::const_iterator foundIt = previousIncludes.find(incFilename);
+				if (foundIt != previousIncludes.end()) {
+					Error("Circular, or multiple, include of %s\n", incFilename.c_str());
+				} else {
+					previousIncludes.insert(incFilename);
 				}
-				// Store the modified text with the included files (if any)
-				const StringRange code(strCode.c_str(), strCode.size());
-
-				// Build the final shader text to be compiled
-				AppendSource(s_glslVersion);
-				AppendSource(defines.c_str());
-				if (type == GL_VERTEX_SHADER) {
-					AppendSource("#define VERTEX_SHADER\n");
+
+				// build path for include
+				const std::string incPathBuffer = stringf("shaders/opengl/%0", incFilename);
+
+				// read included file
+				RefCountedPtr<FileSystem::FileData> incCode = FileSystem::gameDataFiles.ReadFile(incPathBuffer);
+				assert(incCode.Valid());
+
+				if (incCode.Valid()) {
+					// replace the #include and filename with the included files text
+					strCode.replace(found, (endFilename + 1) - found, incCode->GetData(), incCode->GetSize());
+					found = strCode.find("#include");
 				} else {
-					AppendSource("#define FRAGMENT_SHADER\n");
+					Error("Could not load shader #include %s for shader %s\n", incPathBuffer.c_str(), filename.c_str());
 				}
-				AppendSource(code.StripUTF8BOM());
+			}
+			// Store the modified text with the included files (if any)
+			const StringRange code(strCode.c_str(), strCode.size());
+
+			// Build the final shader text to be compiled
+			std::string source(s_glslVersion);
+			source += defines;
+			if (type == GL_VERTEX_SHADER) {
+				source += "#define VERTEX_SHADER\n";
+			} else {
+				source += "#define FRAGMENT_SHADER\n";
+			}
+			source += code.StripUTF8BOM().ToString();
 #if 0
 		static bool s_bDumpShaderSource = true;
 		if (s_bDumpShaderSource) {
@@ -147,24 +144,33 @@ namespace Graphics {
 			FILE *tmp = fopen(outFilename.c_str(), "wb");
 			if(tmp) {
 				Output("%s", filename);
-				for( Uint32 i=0; i<blocks.size(); i++ ) {
-					const char *block = blocks[i];
-					const GLint sizes = block_sizes[i];
-					if(block && sizes>0) {
-						fprintf(tmp, "%.*s", sizes, block);
-					}
-				}
+				fprintf(tmp, "%s", source.c_str());
 				fclose(tmp);
 			} else {
 				Output("Could not open file %s", outFilename.c_str());
 			}
 		}
 #endif
+			return source;
+		}
+
+		// ShaderProgram is a helper class to wrap fragment/vertex shader
+		// creation. The hierarchy is conceptually:
+		//   Shader ->
+		//     Program ->
+		//       ShaderProgram (vertex)
+		//       ShaderProgram (fragment)
+		struct ShaderProgram {
+			ShaderProgram(GLenum type, const std::string &filename, const std::string &source)
+			{
 				shader = glCreateShader(type);
 				if (glIsShader(shader) != GL_TRUE)
 					throw ShaderCompileException();
 
-				Compile(shader);
+				const char *block = source.c_str();
+				const GLint blockSize = GLint(source.size());
+				glShaderSource(shader, 1, &block, &blockSize);
+				glCompileShader(shader);
 
 				if (!check_glsl_errors(filename.c_str(), shader)) {
 					glDeleteShader(shader);
@@ -179,30 +185,6 @@ namespace Graphics {
 			}
 
 			GLuint shader = 0;
-
-		private:
-			void AppendSource(const char *str)
-			{
-				blocks.push_back(str);
-				block_sizes.push_back(std::strlen(str));
-			}
-
-			void AppendSource(StringRange str)
-			{
-				blocks.push_back(str.begin);
-				block_sizes.push_back(str.Size());
-			}
-
-			void Compile(GLuint shader_id)
-			{
-				assert(blocks.size() == block_sizes.size());
-				glShaderSource(shader_id, blocks.size(), &blocks[0], &block_sizes[0]);
-				glCompileShader(shader_id);
-			}
-
-			std::vector<const char *> blocks;
-			std::vector<GLint> block_sizes;
-			std::set<std::string> previousIncludes;
 		};
 
 		// ====================================================================
@@ -234,14 +216,35 @@ namespace Graphics {
 			}
 		}
 
+		static ProgramCache *s_programCache = nullptr;
+
+		void Program::SetCache(ProgramCache *cache)
+		{
+			s_programCache = cache;
+		}
+
 		//load, compile and link
 		GLuint Program::LoadShaders(const ProgramDef &def)
 		{
 			PROFILE_SCOPED()
 
-			//load, create and compile shaders
-			ShaderProgram vs(GL_VERTEX_SHADER, def.vertexShader, def.defines);
-			ShaderProgram fs(GL_FRAGMENT_SHADER, def.fragmentShader, def.defines);
+			const std::string vsSource = LoadShaderSource(GL_VERTEX_SHADER, def.vertexShader, def.defines);
+			const std::string fsSource = LoadShaderSource(GL_FRAGMENT_SHADER, def.fragmentShader, def.defines);
+
+			// a binary from an earlier session skips compiling and linking;
+			// attribute and output locations were baked in when it was linked
+			const bool useCache = s_programCache && s_programCache->IsEnabled();
+			const uint64_t cacheKey = useCache ? s_programCache->GetKey(vsSource, fsSource) : 0;
+			if (useCache) {
+				if (GLuint program = s_programCache->Load(cacheKey)) {
+					success = true;
+					return program;
+				}
+			}
+
+			//create and compile shaders
+			ShaderProgram vs(GL_VERTEX_SHADER, def.vertexShader, vsSource);
+			ShaderProgram fs(GL_FRAGMENT_SHADER, def.fragmentShader, fsSource);
 
 			if (!vs.shader || !fs.shader) {
 				Log::Warning("Error loading GLSL shaders for program {}\n", def.name);
@@ -271,6 +274,9 @@ namespace Graphics {
 			// TODO: setup fragment output locations from shaderdef attributes
 			glBindFragDataLocation(program, 0, "frag_color");
 
+			if (useCache)
+				glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
 			glLinkProgram(program);
 			success = check_glsl_errors(def.name.c_str(), program);
 
@@ -279,6 +285,9 @@ namespace Graphics {
 				return 0;
 			}
 
+			if (useCache)
+				s_programCache->Save(cacheKey, program);
+
 			//shaders may now be deleted by Shader destructor
 			return program;
 		}
@@ -16,6 +16,7 @@ namespace Graphics {
 		struct ProgramException {};
 
 		struct ProgramDef;
+		class ProgramCache;
 		class Shader;
 
 		/*
@@ -33,6 +34,9 @@ namespace Graphics {
 			GLuint GetConstantLocation(uint32_t index) const { return m_constants[index]; }
 			GLuint GetProgramID() const { return m_program; }
 
+			// Programs are looked up in and added to the cache while it's set
+			static void SetCache(ProgramCache *cache);
+
 		protected:
 			GLuint LoadShaders(const ProgramDef &def);
 			void InitUniforms(Shader *shader);
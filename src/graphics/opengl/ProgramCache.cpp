@@ -0,0 +1,222 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "ProgramCache.h"
+#include "FileSystem.h"
+#include "core/Log.h"
+#include "profiler/Profiler.h"
+#include "utils.h"
+
+#include <cstring>
+#include <sstream>
+
+namespace Graphics {
+
+	namespace OGL {
+
+		static const uint32_t BINARY_MAGIC = 0x42505350; // "PSPB"
+		static const uint32_t VARIANTS_VERSION = 1;
+
+		struct BinaryHeader {
+			uint32_t magic;
+			uint32_t format;
+			uint64_t key;
+			uint32_t length;
+			uint32_t _unused;
+		};
+
+		// FNV-1a, continued from a previous hash
+		static uint64_t hash_append(uint64_t hash, const char *data, size_t len)
+		{
+			for (size_t i = 0; i < len; ++i) {
+				hash ^= uint8_t(data[i]);
+				hash *= 0x100000001b3;
+			}
+			return hash;
+		}
+
+		static uint64_t hash_append(uint64_t hash, const std::string &str)
+		{
+			// the length keeps "ab"+"c" and "a"+"bc" apart
+			const uint64_t len = str.size();
+			hash = hash_append(hash, reinterpret_cast<const char *>(&len), sizeof(len));
+			return hash_append(hash, str.data(), str.size());
+		}
+
+		ProgramCache::ProgramCache() :
+			m_enabled(false),
+			m_driverHash(0),
+			m_numLoaded(0),
+			m_numSaved(0)
+		{
+			if (!glewIsSupported("GL_ARB_get_program_binary")) {
+				Log::Info("Shader program cache disabled: GL_ARB_get_program_binary not supported\n");
+				return;
+			}
+
+			// some drivers support the extension but offer no formats to use it with
+			GLint numFormats = 0;
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+			if (numFormats <= 0) {
+				Log::Info("Shader program cache disabled: the driver has no program binary formats\n");
+				return;
+			}
+
+			if (!FileSystem::userFiles.MakeDirectory(CACHE_DIR_NAME)) {
+				Log::Warning("Could not create the shader program cache directory, disabling it.\n");
+				return;
+			}
+
+			// binaries are only good for the driver that made them
+			uint64_t hash = 0xcbf29ce484222325; // FNV-1a offset basis
+			hash = hash_append(hash, glstr_to_str(glGetString(GL_VENDOR)));
+			hash = hash_append(hash, glstr_to_str(glGetString(GL_RENDERER)));
+			hash = hash_append(hash, glstr_to_str(glGetString(GL_VERSION)));
+			m_driverHash = hash;
+			m_enabled = true;
+		}
+
+		uint64_t ProgramCache::GetKey(const std::string &vertexSource, const std::string &fragmentSource) const
+		{
+			uint64_t hash = m_driverHash;
+			hash = hash_append(hash, vertexSource);
+			hash = hash_append(hash, fragmentSource);
+			return hash;
+		}
+
+		std::string ProgramCache::GetFileName(uint64_t key) const
+		{
+			char name[17];
+			snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+			return FileSystem::JoinPathBelow(CACHE_DIR_NAME, std::string(name) + ".bin");
+		}
+
+		GLuint ProgramCache::Load(uint64_t key)
+		{
+			if (!m_enabled)
+				return 0;
+
+			PROFILE_SCOPED()
+			RefCountedPtr<FileSystem::FileData> file = FileSystem::userFiles.ReadFile(GetFileName(key));
+			if (!file || file->GetSize() < sizeof(BinaryHeader))
+				return 0;
+
+			BinaryHeader header;
+			memcpy(&header, file->GetData(), sizeof(header));
+			// also rejects partly written files and (unlikely) hash collisions
+			if (header.magic != BINARY_MAGIC || header.key != key || file->GetSize() != sizeof(header) + header.length)
+				return 0;
+
+			GLuint program = glCreateProgram();
+			glProgramBinary(program, header.format, file->GetData() + sizeof(header), header.length);
+
+			GLint status = GL_FALSE;
+			glGetProgramiv(program, GL_LINK_STATUS, &status);
+			if (status != GL_TRUE) {
+				// the driver may refuse binaries for any reason; just build it again
+				glDeleteProgram(program);
+				return 0;
+			}
+
+			m_numLoaded++;
+			return program;
+		}
+
+		void ProgramCache::Save(uint64_t key, GLuint program)
+		{
+			if (!m_enabled)
+				return;
+
+			PROFILE_SCOPED()
+			GLint length = 0;
+			glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+			if (length <= 0)
+				return;
+
+			std::vector<char> data(sizeof(BinaryHeader) + length);
+			BinaryHeader header = { BINARY_MAGIC, 0, key, uint32_t(length), 0 };
+			GLsizei written = 0;
+			glGetProgramBinary(program, length, &written, &header.format, data.data() + sizeof(header));
+			if (written != length)
+				return;
+			memcpy(data.data(), &header, sizeof(header));
+
+			FILE *f = FileSystem::userFiles.OpenWriteStream(GetFileName(key));
+			if (!f)
+				return;
+			if (fwrite(data.data(), data.size(), 1, f) == 1)
+				m_numSaved++;
+			fclose(f);
+		}
+
+		std::vector<ProgramCache::Variant> ProgramCache::LoadVariants() const
+		{
+			std::vector<Variant> variants;
+			if (!m_enabled)
+				return variants;
+
+			RefCountedPtr<FileSystem::FileData> file = FileSystem::userFiles.ReadFile(VARIANTS_FILE_NAME);
+			if (!file)
+				return variants;
+
+			std::istringstream in(file->AsStringRange().ToString());
+			uint32_t version = 0;
+			in >> version;
+			if (version != VARIANTS_VERSION)
+				return variants;
+
+			// one variant per line:
+			// shader effect alphaTest glowMap ambientMap lighting normalMap specularMap
+			//     usePatterns vertexColors instanced textures dirLights quality
+			std::string line;
+			while (std::getline(in, line)) {
+				std::istringstream fields(line);
+				Variant v;
+				int effect = 0;
+				int flags[9];
+				fields >> v.first >> effect;
+				for (int &flag : flags)
+					fields >> flag;
+				fields >> v.second.textures >> v.second.dirLights >> v.second.quality;
+				if (fields.fail() || v.first.empty())
+					continue;
+
+				MaterialDescriptor &desc = v.second;
+				desc.effect = EffectType(effect);
+				desc.alphaTest = flags[0];
+				desc.glowMap = flags[1];
+				desc.ambientMap = flags[2];
+				desc.lighting = flags[3];
+				desc.normalMap = flags[4];
+				desc.specularMap = flags[5];
+				desc.usePatterns = flags[6];
+				desc.vertexColors = flags[7];
+				desc.instanced = flags[8];
+				variants.push_back(v);
+			}
+
+			return variants;
+		}
+
+		void ProgramCache::SaveVariants(const std::vector<Variant> &variants) const
+		{
+			if (!m_enabled)
+				return;
+
+			FILE *f = FileSystem::userFiles.OpenWriteStream(VARIANTS_FILE_NAME);
+			if (!f)
+				return;
+
+			fprintf(f, "%u\n", VARIANTS_VERSION);
+			for (const Variant &v : variants) {
+				const MaterialDescriptor &d = v.second;
+				fprintf(f, "%s %d %d %d %d %d %d %d %d %d %d %d %u %u\n", v.first.c_str(), int(d.effect),
+					d.alphaTest, d.glowMap, d.ambientMap, d.lighting, d.normalMap, d.specularMap,
+					d.usePatterns, d.vertexColors, d.instanced, d.textures, d.dirLights, d.quality);
+			}
+			fclose(f);
+		}
+
+	} // namespace OGL
+
+} // namespace Graphics
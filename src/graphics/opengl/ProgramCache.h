@@ -0,0 +1,67 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#pragma once
+
+#include "OpenGLLibs.h"
+#include "graphics/Material.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Graphics {
+
+	namespace OGL {
+
+		/*
+		* Keeps linked program binaries in the user directory, so a variant
+		* compiled in an earlier session can be loaded without compiling it again.
+		*
+		* Binaries are keyed by a hash of the complete source of both stages
+		* (defines included) and the driver's vendor, renderer and version
+		* strings; anything a driver update or a changed shader invalidates
+		* simply misses and is rebuilt.
+		*
+		* The cache also remembers which variants each shader was used with,
+		* so the renderer can build them ahead of time in the next session.
+		*/
+		class ProgramCache {
+		public:
+			using Variant = std::pair<std::string, MaterialDescriptor>;
+
+			static constexpr char CACHE_DIR_NAME[] = "shadercache";
+			static constexpr char VARIANTS_FILE_NAME[] = "shadercache/variants.txt";
+
+			ProgramCache();
+
+			// false if the driver can't hand out program binaries
+			bool IsEnabled() const { return m_enabled; }
+
+			uint64_t GetKey(const std::string &vertexSource, const std::string &fragmentSource) const;
+
+			// Creates and links a program from a stored binary; returns 0 if there
+			// is none or the driver rejected it
+			GLuint Load(uint64_t key);
+			// Stores the binary of a program linked with
+			// GL_PROGRAM_BINARY_RETRIEVABLE_HINT set
+			void Save(uint64_t key, GLuint program);
+
+			std::vector<Variant> LoadVariants() const;
+			void SaveVariants(const std::vector<Variant> &variants) const;
+
+			uint32_t GetNumLoaded() const { return m_numLoaded; }
+			uint32_t GetNumSaved() const { return m_numSaved; }
+
+		private:
+			std::string GetFileName(uint64_t key) const;
+
+			bool m_enabled;
+			uint64_t m_driverHash;
+			uint32_t m_numLoaded;
+			uint32_t m_numSaved;
+		};
+
+	} // namespace OGL
+
+} // namespace Graphics
@@ -45,6 +45,7 @@ namespace Graphics {
 
 		private:
 			friend class Graphics::RendererOGL;
+			friend class CommandList;
 			RenderStateCache() = default;
 
 			const RenderStateDesc &GetRenderState(size_t hash) const;
@@ -18,9 +18,11 @@
 #include "graphics/VertexBuffer.h"
 
 #include "CommandBufferGL.h"
+#include "DrawListGL.h"
 #include "GLDebug.h"
 #include "MaterialGL.h"
 #include "Program.h"
+#include "ProgramCache.h"
 #include "RenderStateCache.h"
 #include "RenderTargetGL.h"
 #include "Shader.h"
@@ -32,6 +34,7 @@
 
 #include <SDL.h>
 
+#include <algorithm>
 #include <cstddef> //for offsetof
 #include <iterator>
 #include <ostream>
@@ -139,6 +142,21 @@ namespace Graphics {
 	};
 	static_assert(sizeof(LightData) == 48, "LightData glsl struct has incorrect size/alignment in C++");
 
+	// the LightClusterData uniform block; the cluster and index arrays are
+	// read as uvec4s, the indices two 16-bit values to a component
+	struct LightClusterData {
+		float sliceScale;
+		float sliceBias;
+		uint32_t numLights;
+		uint32_t _pad;
+		PointLight lights[LightClusters::MAX_LIGHTS];
+		uint32_t clusters[LightClusters::NUM_CLUSTERS];
+		uint16_t indices[LightClusters::MAX_INDICES];
+	};
+	static_assert(sizeof(PointLight) == 32, "PointLight glsl struct has incorrect size/alignment in C++");
+	static_assert(sizeof(LightClusterData) <= 16384, "LightClusterData must fit the smallest uniform block size allowed");
+	static_assert(sizeof(LightClusterData) % 16 == 0, "LightClusterData arrays must be whole uvec4s");
+
 	// static method instantiations
 	void RendererOGL::RegisterRenderer()
 	{
@@ -148,6 +166,7 @@ namespace Graphics {
 	// static member instantiations
 	bool RendererOGL::initted = false;
 	RendererOGL::DynamicBufferMap RendererOGL::s_DynamicDrawBufferMap;
+	std::unordered_map<uint32_t, std::vector<uint32_t>> RendererOGL::s_DynamicDrawBufferIndex;
 
 	// typedefs
 	typedef std::vector<std::pair<MaterialDescriptor, OGL::Program *>>::const_iterator ProgramIterator;
@@ -221,6 +240,9 @@ namespace Graphics {
 				"Please check to see if your GPU driver vendor has an updated driver - or that drivers are installed correctly.");
 		}
 
+		// core from 3.3; only needed for timing GPU work
+		m_gpuTimerSupported = glewIsSupported("GL_ARB_timer_query");
+
 		const char *ver = reinterpret_cast<const char *>(glGetString(GL_VERSION));
 		if (vs.gl3ForwardCompatible && strstr(ver, "9.17.10.4229")) {
 			Warning("Driver needs GL3ForwardCompatible=0 in config.ini to display billboards (stars, navlights etc.)");
@@ -234,6 +256,8 @@ namespace Graphics {
 		const bool useAnisotropicFiltering = vs.useAnisotropicFiltering;
 		m_useAnisotropicFiltering = useAnisotropicFiltering;
 
+		m_sortDrawCommands = vs.sortDrawCommands;
+
 		//XXX bunch of fixed function states here!
 		glCullFace(GL_BACK);
 		glFrontFace(GL_CCW);
@@ -256,6 +280,12 @@ namespace Graphics {
 		// create the state cache immediately after establishing baseline state.
 		m_renderStateCache.reset(new OGL::RenderStateCache());
 
+		if (vs.useProgramCache) {
+			m_programCache.reset(new OGL::ProgramCache());
+			OGL::Program::SetCache(m_programCache.get());
+			m_pendingVariants = m_programCache->LoadVariants();
+		}
+
 		// check enum PrimitiveType matches OpenGL values
 		static_assert(POINTS == GL_POINTS);
 		static_assert(LINE_SINGLE == GL_LINES);
@@ -274,6 +304,8 @@ namespace Graphics {
 		GetDrawUniformBuffer(0);
 
 		m_lightUniformBuffer.Reset(new OGL::UniformBuffer(sizeof(LightData) * TOTAL_NUM_LIGHTS, BUFFER_USAGE_DYNAMIC));
+		m_lightClusterBuffer.Reset(new OGL::UniformBuffer(sizeof(LightClusterData), BUFFER_USAGE_DYNAMIC));
+		SetPointLights(0, nullptr, 1.0f, 2.0f);
 	}
 
 	RendererOGL::~RendererOGL()
@@ -283,8 +315,30 @@ namespace Graphics {
 		}
 
 		m_lightUniformBuffer.Reset();
+		m_lightClusterBuffer.Reset();
+
+		if (m_gpuTimerQueries[0])
+			glDeleteQueries(NUM_GPU_TIMERS * 2, m_gpuTimerQueries);
+		for (auto &frame : m_gpuZoneFrames) {
+			if (!frame.queries.empty())
+				glDeleteQueries(GLsizei(frame.queries.size()), frame.queries.data());
+		}
 
 		s_DynamicDrawBufferMap.clear();
+		s_DynamicDrawBufferIndex.clear();
+
+		if (m_programCache) {
+			// remember what was used this session (and what wasn't built yet)
+			std::vector<std::pair<std::string, MaterialDescriptor>> variants;
+			for (auto &pair : m_shaders)
+				for (auto &variant : pair.second->GetVariants())
+					variants.push_back({ pair.first, variant.first });
+			for (auto &variant : m_pendingVariants)
+				if (std::find(variants.begin(), variants.end(), variant) == variants.end())
+					variants.push_back(variant);
+			m_programCache->SaveVariants(variants);
+			OGL::Program::SetCache(nullptr);
+		}
 
 		// HACK ANDYC - this crashes when shutting down? They'll be released anyway right?
 		while (!m_shaders.empty()) {
@@ -473,9 +527,25 @@ namespace Graphics {
 	bool RendererOGL::BeginFrame()
 	{
 		PROFILE_SCOPED()
+		if (!m_pendingVariants.empty())
+			WarmProgramCache();
+
 		// clear the cached program state (program loading may have trashed it)
 		m_renderStateCache->SetProgram(nullptr);
 
+		if (m_gpuTimerSupported) {
+			ResolveGPUZones();
+
+			// the GPU is too far behind to reuse the next frame's queries yet;
+			// skip timing this frame
+			GPUZoneFrame &frame = m_gpuZoneFrames[m_gpuZoneFrameNext];
+			if (!frame.pending) {
+				frame.zones.clear();
+				m_gpuZoneStack.clear();
+				m_gpuZonesRecording = true;
+			}
+		}
+
 		m_frameNum++;
 		return true;
 	}
@@ -483,6 +553,19 @@ namespace Graphics {
 	bool RendererOGL::EndFrame()
 	{
 		PROFILE_SCOPED()
+		if (m_gpuZonesRecording) {
+			while (!m_gpuZoneStack.empty())
+				PopGPUZone();
+			m_gpuZonesRecording = false;
+
+			GPUZoneFrame &frame = m_gpuZoneFrames[m_gpuZoneFrameNext];
+			if (!frame.zones.empty()) {
+				FlushCommandBuffers();
+				frame.pending = true;
+				m_gpuZoneFrameNext = (m_gpuZoneFrameNext + 1) % NUM_GPU_ZONE_FRAMES;
+			}
+		}
+
 		uint32_t used_tex2d = 0;
 		uint32_t used_texCube = 0;
 		uint32_t used_texArray2d = 0;
@@ -776,6 +859,27 @@ namespace Graphics {
 		return true;
 	}
 
+	bool RendererOGL::SetPointLights(Uint32 numLights, const PointLight *lights, float znear, float zfar)
+	{
+		PROFILE_SCOPED()
+		m_lightClusters.Build(m_projectionMat, znear, zfar, lights, numLights);
+
+		auto data = m_lightClusterBuffer->Map<LightClusterData>(BufferMapMode::BUFFER_MAP_WRITE);
+		assert(data.isValid());
+
+		LightClusterData &block = *data.data();
+		const std::vector<PointLight> &clusterLights = m_lightClusters.GetLights();
+		const std::vector<uint16_t> &indices = m_lightClusters.GetIndices();
+		block.sliceScale = m_lightClusters.GetSliceScale();
+		block.sliceBias = m_lightClusters.GetSliceBias();
+		block.numLights = uint32_t(clusterLights.size());
+		std::copy(clusterLights.begin(), clusterLights.end(), block.lights);
+		std::copy(m_lightClusters.GetClusters().begin(), m_lightClusters.GetClusters().end(), block.clusters);
+		std::copy(indices.begin(), indices.end(), block.indices);
+
+		return true;
+	}
+
 	bool RendererOGL::SetAmbientColor(const Color &c)
 	{
 		m_ambient = c;
@@ -793,13 +897,15 @@ namespace Graphics {
 		const AttributeSet attrs = v->GetAttributeSet();
 
 		// Find a buffer matching our attributes with enough free space
-		auto iter = std::find_if(s_DynamicDrawBufferMap.begin(), s_DynamicDrawBufferMap.end(), [&](DynamicBufferData &a) {
-			uint32_t freeSize = a.vtxBuffer->GetCapacity() - a.vtxBuffer->GetSize();
-			return a.attrs == attrs && freeSize >= v->GetNumVerts();
+		std::vector<uint32_t> &buffers = s_DynamicDrawBufferIndex[attrs];
+		auto found = std::find_if(buffers.begin(), buffers.end(), [&](uint32_t index) {
+			OGL::CachedVertexBuffer *vb = s_DynamicDrawBufferMap[index].vtxBuffer;
+			return vb->GetCapacity() - vb->GetSize() >= v->GetNumVerts();
 		});
+		DynamicBufferData *data = found != buffers.end() ? &s_DynamicDrawBufferMap[*found] : nullptr;
 
 		// If we don't have one, make one
-		if (iter == s_DynamicDrawBufferMap.end()) {
+		if (!data) {
 			auto desc = VertexBufferDesc::FromAttribSet(v->GetAttributeSet());
 			desc.numVertices = DYNAMIC_DRAW_BUFFER_SIZE / desc.stride;
 			desc.usage = BUFFER_USAGE_DYNAMIC;
@@ -807,20 +913,21 @@ namespace Graphics {
 			size_t stateHash = m_renderStateCache->CacheVertexDesc(desc);
 			OGL::CachedVertexBuffer *vb = new OGL::CachedVertexBuffer(desc, stateHash);
 			MeshObject *meshObject = CreateMeshObject(vb, nullptr);
+			buffers.push_back(uint32_t(s_DynamicDrawBufferMap.size()));
 			s_DynamicDrawBufferMap.push_back(DynamicBufferData{ attrs, vb, RefCountedPtr<MeshObject>(meshObject) });
 
 			GetStats().AddToStatCount(Stats::STAT_CREATE_BUFFER, 1);
 			GetStats().AddToStatCount(Stats::STAT_DYNAMIC_DRAW_BUFFER_CREATED, 1);
-			iter = s_DynamicDrawBufferMap.end() - 1;
+			data = &s_DynamicDrawBufferMap.back();
 		}
 
 		// Write our data into the buffer
-		uint32_t offset = iter->vtxBuffer->GetOffset();
-		iter->vtxBuffer->Populate(*v);
+		uint32_t offset = data->vtxBuffer->GetOffset();
+		data->vtxBuffer->Populate(*v);
 		CheckRenderErrors(__FUNCTION__, __LINE__);
 
 		// Append a command to the command list
-		m_drawCommandList->AddDynamicDrawCmd({ iter->mesh->GetVertexBuffer(), offset, v->GetNumVerts() }, {}, m);
+		m_drawCommandList->AddDynamicDrawCmd({ data->mesh->GetVertexBuffer(), offset, v->GetNumVerts() }, {}, m);
 
 		return true;
 	}
@@ -851,6 +958,21 @@ namespace Graphics {
 		return true;
 	}
 
+	DrawList *RendererOGL::CreateDrawList()
+	{
+		return new OGL::DrawList(this);
+	}
+
+	void RendererOGL::BeginDrawList(DrawList *list)
+	{
+		static_cast<OGL::DrawList *>(list)->Begin();
+	}
+
+	void RendererOGL::SubmitDrawList(DrawList *list)
+	{
+		static_cast<OGL::DrawList *>(list)->Submit(m_drawCommandList.get());
+	}
+
 	bool RendererOGL::FlushCommandBuffers()
 	{
 		PROFILE_SCOPED()
@@ -863,6 +985,9 @@ namespace Graphics {
 		for (auto &buffer : s_DynamicDrawBufferMap)
 			buffer.vtxBuffer->Flush();
 
+		if (m_sortDrawCommands)
+			m_drawCommandList->SortDrawCmds();
+
 		m_drawCommandList->m_executing = true;
 
 		for (const auto &cmd : m_drawCommandList->GetDrawCmds()) {
@@ -874,6 +999,8 @@ namespace Graphics {
 				m_drawCommandList->ExecuteRenderPassCmd(*renderPassCmd);
 			else if (auto *blitRenderTargetCmd = std::get_if<OGL::CommandList::BlitRenderTargetCmd>(&cmd))
 				m_drawCommandList->ExecuteBlitRenderTargetCmd(*blitRenderTargetCmd);
+			else if (auto *timestampCmd = std::get_if<OGL::CommandList::TimestampCmd>(&cmd))
+				m_drawCommandList->ExecuteTimestampCmd(*timestampCmd);
 		}
 
 		// we don't manually reset the active vertex array after each drawcall for performance,
@@ -887,6 +1014,129 @@ namespace Graphics {
 		return true;
 	}
 
+	void RendererOGL::BeginGPUTimer()
+	{
+		if (!m_gpuTimerSupported)
+			return;
+		if (!m_gpuTimerQueries[0])
+			glGenQueries(NUM_GPU_TIMERS * 2, m_gpuTimerQueries);
+
+		// the GPU is too far behind to reuse the next pair yet; skip this frame
+		if (m_gpuTimerPending[m_gpuTimerNext])
+			return;
+
+		// the timestamp is taken when the GPU reaches it, so everything
+		// queued before must go first
+		FlushCommandBuffers();
+		glQueryCounter(m_gpuTimerQueries[m_gpuTimerNext * 2], GL_TIMESTAMP);
+		m_gpuTimerActive = true;
+	}
+
+	void RendererOGL::EndGPUTimer()
+	{
+		if (!m_gpuTimerActive)
+			return;
+
+		FlushCommandBuffers();
+		glQueryCounter(m_gpuTimerQueries[m_gpuTimerNext * 2 + 1], GL_TIMESTAMP);
+		m_gpuTimerPending[m_gpuTimerNext] = true;
+		m_gpuTimerNext = (m_gpuTimerNext + 1) % NUM_GPU_TIMERS;
+		m_gpuTimerActive = false;
+	}
+
+	bool RendererOGL::PollGPUTimer(float &milliseconds)
+	{
+		bool result = false;
+		// oldest first; queries complete in order
+		for (size_t n = 0; n < NUM_GPU_TIMERS; n++) {
+			const size_t i = (m_gpuTimerNext + n) % NUM_GPU_TIMERS;
+			if (!m_gpuTimerPending[i])
+				continue;
+
+			GLint available = 0;
+			glGetQueryObjectiv(m_gpuTimerQueries[i * 2 + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available)
+				break;
+
+			GLuint64 begin = 0, end = 0;
+			glGetQueryObjectui64v(m_gpuTimerQueries[i * 2], GL_QUERY_RESULT, &begin);
+			glGetQueryObjectui64v(m_gpuTimerQueries[i * 2 + 1], GL_QUERY_RESULT, &end);
+			m_gpuTimerPending[i] = false;
+			milliseconds = float(double(end - begin) * 1e-6);
+			result = true;
+		}
+		return result;
+	}
+
+	void RendererOGL::PushGPUZone(const char *name)
+	{
+		if (!m_gpuZonesRecording)
+			return;
+
+		GPUZoneFrame &frame = m_gpuZoneFrames[m_gpuZoneFrameNext];
+		const uint32_t index = uint32_t(frame.zones.size());
+		// zones past the limit aren't timed, but still have to be popped
+		if (index >= MAX_GPU_ZONES) {
+			m_gpuZoneStack.push_back(MAX_GPU_ZONES);
+			return;
+		}
+
+		if (frame.queries.size() < (index + 1) * 2) {
+			frame.queries.resize((index + 1) * 2);
+			glGenQueries(2, &frame.queries[index * 2]);
+		}
+
+		frame.zones.push_back({ name, 0.f, 0.f, uint32_t(m_gpuZoneStack.size()) });
+		m_gpuZoneStack.push_back(index);
+		m_drawCommandList->AddTimestampCmd(frame.queries[index * 2]);
+	}
+
+	void RendererOGL::PopGPUZone()
+	{
+		if (!m_gpuZonesRecording || m_gpuZoneStack.empty())
+			return;
+
+		const uint32_t index = m_gpuZoneStack.back();
+		m_gpuZoneStack.pop_back();
+		if (index >= MAX_GPU_ZONES)
+			return;
+
+		GPUZoneFrame &frame = m_gpuZoneFrames[m_gpuZoneFrameNext];
+		frame.lastQuery = frame.queries[index * 2 + 1];
+		m_drawCommandList->AddTimestampCmd(frame.lastQuery);
+	}
+
+	void RendererOGL::ResolveGPUZones()
+	{
+		PROFILE_SCOPED()
+		// oldest first; queries complete in order
+		for (size_t n = 0; n < NUM_GPU_ZONE_FRAMES; n++) {
+			GPUZoneFrame &frame = m_gpuZoneFrames[(m_gpuZoneFrameNext + n) % NUM_GPU_ZONE_FRAMES];
+			if (!frame.pending)
+				continue;
+
+			GLint available = 0;
+			glGetQueryObjectiv(frame.lastQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available)
+				break;
+
+			GLuint64 origin = 0;
+			for (size_t i = 0; i < frame.zones.size(); i++) {
+				GLuint64 begin = 0, end = 0;
+				glGetQueryObjectui64v(frame.queries[i * 2], GL_QUERY_RESULT, &begin);
+				glGetQueryObjectui64v(frame.queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+				if (i == 0)
+					origin = begin;
+
+				frame.zones[i].startMs = float(double(begin - origin) * 1e-6);
+				frame.zones[i].durationMs = float(double(end - begin) * 1e-6);
+			}
+
+			frame.pending = false;
+			m_gpuZoneTimes.swap(frame.zones);
+		}
+	}
+
 	static void stat_primitives(Stats &stats, PrimitiveType type, uint32_t count)
 	{
 		switch (type) {
@@ -991,23 +1241,50 @@ namespace Graphics {
 		mat->m_descriptor = desc;
 		mat->m_renderStateHash = m_renderStateCache->InternRenderState(stateDescriptor);
 
-		OGL::Shader *s = nullptr;
+		mat->SetShader(GetOrCreateShader(shader));
+		CheckRenderErrors(__FUNCTION__, __LINE__);
+		return mat;
+	}
+
+	OGL::Shader *RendererOGL::GetOrCreateShader(const std::string &name)
+	{
 		for (auto &pair : m_shaders) {
-			if (pair.first == shader)
-				s = pair.second;
+			if (pair.first == name)
+				return pair.second;
 		}
 
-		if (!s) {
-			s = new OGL::Shader(shader);
-			Log::Info("Created shader {} (address={})\n", shader, (void *)s);
-			CheckRenderErrors(__FUNCTION__, __LINE__);
+		OGL::Shader *s = new OGL::Shader(name);
+		Log::Info("Created shader {} (address={})\n", name, (void *)s);
+		CheckRenderErrors(__FUNCTION__, __LINE__);
+
+		m_shaders.push_back({ name, s });
+		return s;
+	}
 
-			m_shaders.push_back({ shader, s });
+	// Builds the variants used in earlier sessions a few at a time, so they
+	// come from the program cache (or are compiled) before anything draws them
+	// rather than in the middle of a frame. Programs can only be built on the
+	// thread owning the GL context, so this spreads the work over frames.
+	void RendererOGL::WarmProgramCache()
+	{
+		PROFILE_SCOPED()
+		const Uint64 start = SDL_GetPerformanceCounter();
+		const Uint64 budget = Uint64(PROGRAM_WARMUP_MS * 0.001 * SDL_GetPerformanceFrequency());
+
+		while (!m_pendingVariants.empty() && SDL_GetPerformanceCounter() - start < budget) {
+			const auto variant = m_pendingVariants.back();
+			m_pendingVariants.pop_back();
+
+			try {
+				GetOrCreateShader(variant.first)->GetProgramForDesc(variant.second);
+			} catch (OGL::ShaderException &) {
+				// the shader is gone since the variant was recorded
+				Log::Warning("Could not build recorded variant of shader {}\n", variant.first);
+			}
 		}
 
-		mat->SetShader(s);
-		CheckRenderErrors(__FUNCTION__, __LINE__);
-		return mat;
+		if (m_pendingVariants.empty())
+			Log::Info("Built recorded shader variants ({} from the program cache)\n", m_programCache->GetNumLoaded());
 	}
 
 	Material *RendererOGL::CloneMaterial(const Material *old, const MaterialDescriptor &descriptor, const RenderStateDesc &stateDescriptor)
@@ -1148,6 +1425,11 @@ namespace Graphics {
 		return m_lightUniformBuffer.Get();
 	}
 
+	OGL::UniformBuffer *RendererOGL::GetLightClusterBuffer()
+	{
+		return m_lightClusterBuffer.Get();
+	}
+
 	OGL::UniformLinearBuffer *RendererOGL::GetDrawUniformBuffer(Uint32 size)
 	{
 		for (auto &buffer : m_drawUniformBuffers)
@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include "graphics/LightClusters.h"
+#include "graphics/Material.h"
 #include "graphics/RenderState.h"
 #include "graphics/Renderer.h"
 #include "graphics/Types.h"
@@ -23,10 +25,12 @@ namespace Graphics {
 	namespace OGL {
 		class CachedVertexBuffer;
 		class CommandList;
+		class DrawList;
 		class InstanceBuffer;
 		class IndexBuffer;
 		class Material;
 		class MeshObject;
+		class ProgramCache;
 		class RenderState;
 		class RenderStateCache;
 		class RenderTarget;
@@ -87,16 +91,29 @@ namespace Graphics {
 
 		virtual bool SetLightIntensity(Uint32 numlights, const float *intensity) override final;
 		virtual bool SetLights(Uint32 numlights, const Light *l) override final;
+		virtual bool SetPointLights(Uint32 numLights, const PointLight *lights, float znear, float zfar) override final;
 		virtual Uint32 GetNumLights() const override final { return m_numLights; }
 		virtual bool SetAmbientColor(const Color &c) override final;
 
 		virtual bool FlushCommandBuffers() override final;
 
+		virtual void BeginGPUTimer() override final;
+		virtual void EndGPUTimer() override final;
+		virtual bool PollGPUTimer(float &milliseconds) override final;
+
+		virtual void PushGPUZone(const char *name) override final;
+		virtual void PopGPUZone() override final;
+		virtual const std::vector<GPUZoneTime> &GetGPUZoneTimes() const override final { return m_gpuZoneTimes; }
+
 		virtual bool DrawBuffer(const VertexArray *v, Material *m) override final;
 		virtual bool DrawBufferDynamic(VertexBuffer *v, uint32_t vtxOffset, IndexBuffer *i, uint32_t idxOffset, uint32_t numElems, Material *m) override final;
 		virtual bool DrawMesh(MeshObject *, Material *) override final;
 		virtual bool DrawMeshInstanced(MeshObject *, Material *, InstanceBuffer *) override final;
 
+		virtual DrawList *CreateDrawList() override final;
+		virtual void BeginDrawList(DrawList *list) override final;
+		virtual void SubmitDrawList(DrawList *list) override final;
+
 		virtual Material *CreateMaterial(const std::string &, const MaterialDescriptor &, const RenderStateDesc &) override final;
 		virtual Material *CloneMaterial(const Material *, const MaterialDescriptor &, const RenderStateDesc &) override final;
 		virtual Texture *CreateTexture(const TextureDescriptor &descriptor) override final;
@@ -111,6 +128,8 @@ namespace Graphics {
 		virtual const RenderStateDesc &GetMaterialRenderState(const Graphics::Material *m) override final;
 
 		OGL::UniformBuffer *GetLightUniformBuffer();
+		OGL::UniformBuffer *GetLightClusterBuffer();
+		uint32_t GetNumPointLights() const { return uint32_t(m_lightClusters.GetLights().size()); }
 		OGL::UniformLinearBuffer *GetDrawUniformBuffer(Uint32 size);
 		OGL::RenderStateCache *GetStateCache() { return m_renderStateCache.get(); }
 
@@ -122,7 +141,15 @@ namespace Graphics {
 		bool DrawMeshInstancedInternal(OGL::MeshObject *, OGL::InstanceBuffer *, PrimitiveType type);
 		bool DrawMeshDynamicInternal(BufferBinding<OGL::VertexBuffer> vtxBind, BufferBinding<OGL::IndexBuffer> idxBind, PrimitiveType type);
 
+		// Time spent each frame building the variants used in earlier sessions
+		static constexpr double PROGRAM_WARMUP_MS = 2.0;
+
 	protected:
+		OGL::Shader *GetOrCreateShader(const std::string &name);
+		void WarmProgramCache();
+		// reads back the GPU zones of finished frames
+		void ResolveGPUZones();
+
 		virtual void PushState() override final{};
 		virtual void PopState() override final{};
 
@@ -134,13 +161,47 @@ namespace Graphics {
 		float m_maxZFar;
 		bool m_useCompressedTextures;
 		bool m_useAnisotropicFiltering;
+		bool m_sortDrawCommands;
 
 		// TODO: iterate shaderdef files on startup and cache by Shader name directive rather than filename fragment
 		std::vector<std::pair<std::string, OGL::Shader *>> m_shaders;
+		std::unique_ptr<OGL::ProgramCache> m_programCache;
+		// variants recorded by the program cache still to be built
+		std::vector<std::pair<std::string, MaterialDescriptor>> m_pendingVariants;
 		std::vector<std::unique_ptr<OGL::UniformLinearBuffer>> m_drawUniformBuffers;
 		std::unique_ptr<OGL::RenderStateCache> m_renderStateCache;
 		RefCountedPtr<OGL::UniformBuffer> m_lightUniformBuffer;
+		RefCountedPtr<OGL::UniformBuffer> m_lightClusterBuffer;
+		LightClusters m_lightClusters;
 		bool m_useNVDepthRanged;
+
+		// timestamp query pairs, used round robin so reading one back never
+		// waits on the GPU
+		static constexpr size_t NUM_GPU_TIMERS = 4;
+		GLuint m_gpuTimerQueries[NUM_GPU_TIMERS * 2] = {};
+		bool m_gpuTimerPending[NUM_GPU_TIMERS] = {};
+		size_t m_gpuTimerNext = 0;
+		bool m_gpuTimerSupported = false;
+		bool m_gpuTimerActive = false;
+
+		// GPU zones of one frame; their timestamps are taken when the
+		// command list executes, so recording them never flushes it
+		struct GPUZoneFrame {
+			std::vector<GLuint> queries; // begin and end of each zone
+			std::vector<GPUZoneTime> zones;
+			GLuint lastQuery = 0; // the last timestamp of the frame
+			bool pending = false;
+		};
+
+		static constexpr size_t NUM_GPU_ZONE_FRAMES = 4;
+		static constexpr uint32_t MAX_GPU_ZONES = 64;
+		GPUZoneFrame m_gpuZoneFrames[NUM_GPU_ZONE_FRAMES];
+		size_t m_gpuZoneFrameNext = 0;
+		// indices of the open zones of the current frame
+		std::vector<uint32_t> m_gpuZoneStack;
+		std::vector<GPUZoneTime> m_gpuZoneTimes;
+		bool m_gpuZonesRecording = false;
+
 		OGL::RenderTarget *m_activeRenderTarget = nullptr;
 		std::unique_ptr<OGL::CommandList> m_drawCommandList;
 
@@ -159,6 +220,8 @@ namespace Graphics {
 
 		using DynamicBufferMap = std::vector<DynamicBufferData>;
 		static DynamicBufferMap s_DynamicDrawBufferMap;
+		// indices into s_DynamicDrawBufferMap of the buffers for each attribute set
+		static std::unordered_map<uint32_t, std::vector<uint32_t>> s_DynamicDrawBufferIndex;
 
 		SDL_GLContext m_glContext;
 	};
@@ -7,6 +7,7 @@
 #include "StringF.h"
 #include "StringRange.h"
 #include "graphics/Graphics.h"
+#include "graphics/LightClusters.h"
 #include "graphics/Material.h"
 #include "graphics/Renderer.h"
 #include "graphics/ShaderParser.h"
@@ -140,6 +141,14 @@ std::string Shader::GetProgramDefines(const MaterialDescriptor &desc)
 	ss << stringf("#define NUM_LIGHTS %0{u}\n", desc.dirLights);
 	if (desc.lighting && desc.dirLights > 0)
 		ss << stringf("#define INV_NUM_LIGHTS %0{f}\n", 1.0f / float(desc.dirLights));
+	if (desc.lighting) {
+		// layout of the LightClusterData block
+		ss << stringf("#define LIGHT_CLUSTERS_X %0{u}\n", LightClusters::GRID_X);
+		ss << stringf("#define LIGHT_CLUSTERS_Y %0{u}\n", LightClusters::GRID_Y);
+		ss << stringf("#define LIGHT_CLUSTERS_Z %0{u}\n", LightClusters::GRID_Z);
+		ss << stringf("#define MAX_CLUSTER_LIGHTS %0{u}\n", LightClusters::MAX_LIGHTS);
+		ss << stringf("#define MAX_CLUSTER_INDICES %0{u}\n", LightClusters::MAX_INDICES);
+	}
 
 	if (desc.effect == EFFECT_GEOSPHERE_TERRAIN_WITH_LAVA)
 		ss << "#define TERRAIN_WITH_LAVA\n";
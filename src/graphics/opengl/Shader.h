@@ -76,6 +76,7 @@ namespace Graphics {
 
 			Program *GetProgramForDesc(const MaterialDescriptor &desc);
 			uint32_t GetNumVariants() const { return m_variants.size(); }
+			const std::vector<std::pair<MaterialDescriptor, Program *>> &GetVariants() const { return m_variants; }
 
 			TextureBindingData GetTextureBindingInfo(size_t name) const;
 			size_t GetNumTextureBindings() const { return m_textureBindingInfo.size(); }
@@ -3,6 +3,7 @@
 
 #include "TextureGL.h"
 #include "RendererGL.h"
+#include "core/MemoryStats.h"
 #include "graphics/Renderer.h"
 #include "utils.h"
 #include <cassert>
@@ -85,9 +86,38 @@ namespace Graphics {
 		TextureGL::TextureGL(const TextureDescriptor &descriptor, const bool useCompressed, const bool useAnisoFiltering, const Uint16 numSamples) :
 			Texture(descriptor),
 			m_allocSize(0),
+			m_baseMip(0),
+			m_numSamples(numSamples),
+			m_useCompressed(useCompressed),
+			m_allowAnisoFiltering(useAnisoFiltering),
 			m_useAnisoFiltering(useAnisoFiltering && descriptor.useAnisotropicFiltering)
 		{
 			PROFILE_SCOPED()
+			Allocate();
+			MemoryStats::Add(MemoryStats::TAG_TEXTURES, m_allocSize);
+		}
+
+		void TextureGL::Respecify(const TextureDescriptor &descriptor)
+		{
+			PROFILE_SCOPED()
+			assert(!m_numSamples);
+			glDeleteTextures(1, &m_texture);
+			MemoryStats::Sub(MemoryStats::TAG_TEXTURES, m_allocSize);
+
+			SetDescriptor(descriptor);
+			m_allocSize = 0;
+			m_baseMip = 0;
+			m_useAnisoFiltering = m_allowAnisoFiltering && descriptor.useAnisotropicFiltering;
+			Allocate();
+			MemoryStats::Add(MemoryStats::TAG_TEXTURES, m_allocSize);
+		}
+
+		void TextureGL::Allocate()
+		{
+			const TextureDescriptor &descriptor = GetDescriptor();
+			const Uint16 numSamples = m_numSamples;
+			const bool useCompressed = m_useCompressed;
+
 			// this is kind of a hack, but it limits the amount of things that need to care about multisample textures.
 			m_target = numSamples ? GL_TEXTURE_2D_MULTISAMPLE : GLTextureType(descriptor.type);
 
@@ -299,6 +329,7 @@ namespace Graphics {
 		TextureGL::~TextureGL()
 		{
 			glDeleteTextures(1, &m_texture);
+			MemoryStats::Sub(MemoryStats::TAG_TEXTURES, m_allocSize);
 		}
 
 		void TextureGL::Update(const void *data, const vector2f &pos, const vector3f &dataSize, TextureFormat format, const unsigned int numMips)
@@ -465,6 +496,57 @@ namespace Graphics {
 			glBindTexture(m_target, 0);
 		}
 
+		void TextureGL::UpdateMips(const void *data, const vector3f &dataSize, TextureFormat format, uint32_t firstMip, uint32_t numMips)
+		{
+			PROFILE_SCOPED()
+			assert(m_target == GL_TEXTURE_2D && IsCompressed(format));
+			glBindTexture(m_target, m_texture);
+
+			const unsigned char *pData = static_cast<const unsigned char *>(data);
+			size_t Offset = 0;
+			for (uint32_t i = firstMip; i < firstMip + numMips; ++i) {
+				const size_t Width = std::max<size_t>(size_t(dataSize.x) >> i, 1ul);
+				const size_t Height = std::max<size_t>(size_t(dataSize.y) >> i, 1ul);
+				const size_t bufSize = ((Width + 3) / 4) * ((Height + 3) / 4) * GetMinSize(format);
+				if (i < m_baseMip) {
+					// the level's storage was released by SetBaseMip, specify it again
+					glCompressedTexImage2D(m_target, i, GLInternalFormat(format), Width, Height, 0, bufSize, &pData[Offset]);
+					m_allocSize += bufSize;
+					MemoryStats::Add(MemoryStats::TAG_TEXTURES, bufSize);
+				} else {
+					glCompressedTexSubImage2D(m_target, i, 0, 0, Width, Height, GLImageFormat(format), bufSize, &pData[Offset]);
+				}
+				Offset += bufSize;
+			}
+
+			glBindTexture(m_target, 0);
+			CHECKERRORS();
+		}
+
+		void TextureGL::SetBaseMip(uint32_t baseMip)
+		{
+			PROFILE_SCOPED()
+			assert(m_target == GL_TEXTURE_2D && IsCompressed(GetDescriptor().format));
+			const TextureDescriptor &descriptor = GetDescriptor();
+			glBindTexture(m_target, m_texture);
+
+			// levels above the base are never sampled; respecifying them empty
+			// hands their memory back to the driver
+			for (uint32_t i = m_baseMip; i < baseMip; ++i) {
+				const size_t Width = std::max<size_t>(size_t(descriptor.dataSize.x) >> i, 1ul);
+				const size_t Height = std::max<size_t>(size_t(descriptor.dataSize.y) >> i, 1ul);
+				const size_t bufSize = ((Width + 3) / 4) * ((Height + 3) / 4) * GetMinSize(descriptor.format);
+				m_allocSize -= bufSize;
+				MemoryStats::Sub(MemoryStats::TAG_TEXTURES, bufSize);
+				glCompressedTexImage2D(m_target, i, GLInternalFormat(descriptor.format), 0, 0, 0, 0, nullptr);
+			}
+			glTexParameteri(m_target, GL_TEXTURE_BASE_LEVEL, baseMip);
+			m_baseMip = baseMip;
+
+			glBindTexture(m_target, 0);
+			CHECKERRORS();
+		}
+
 		void TextureGL::Bind()
 		{
 			glBindTexture(m_target, m_texture);
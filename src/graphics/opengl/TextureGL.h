@@ -14,6 +14,9 @@ namespace Graphics {
 			virtual void Update(const void *data, const vector2f &pos, const vector3f &dataSize, TextureFormat format, const unsigned int numMips) override final;
 			virtual void Update(const TextureCubeData &data, const vector3f &dataSize, TextureFormat format, const unsigned int numMips) override final;
 			virtual void Update(const vecDataPtr &data, const vector3f &dataSize, const TextureFormat format, const unsigned int numMips) override final;
+			virtual void UpdateMips(const void *data, const vector3f &dataSize, TextureFormat format, uint32_t firstMip, uint32_t numMips) override final;
+			virtual void SetBaseMip(uint32_t baseMip) override final;
+			virtual void Respecify(const TextureDescriptor &descriptor) override final;
 
 			TextureGL(const TextureDescriptor &descriptor, const bool useCompressed, const bool useAnisoFiltering, const Uint16 numSamples = 0);
 			virtual ~TextureGL();
@@ -38,10 +41,16 @@ namespace Graphics {
 			uint32_t GetTextureMemSize() const final { return m_allocSize; }
 
 		private:
+			void Allocate();
+
 			GLenum m_target;
 			GLuint m_texture;
 			uint32_t m_allocSize;
-			const bool m_useAnisoFiltering;
+			uint32_t m_baseMip;
+			const Uint16 m_numSamples;
+			const bool m_useCompressed;
+			const bool m_allowAnisoFiltering;
+			bool m_useAnisoFiltering;
 		};
 	} // namespace OGL
 } // namespace Graphics
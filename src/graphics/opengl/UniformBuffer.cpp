@@ -73,10 +73,16 @@ UniformLinearBuffer::UniformLinearBuffer(uint32_t size) :
 {
 	glGenBuffers(1, &m_buffer);
 	glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
-	glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+	// allocations are written straight into persistently mapped storage
+	// where it's available, instead of being cached and uploaded at Flush()
+	if (BufferRing::IsSupported())
+		m_ring.Init(GL_UNIFORM_BUFFER, size);
+	else
+		glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
 	glBindBuffer(GL_UNIFORM_BUFFER, 0);
 	m_size = 0;
-	m_data.reset(new char[size]);
+	if (!m_ring.IsMapped())
+		m_data.reset(new char[size]);
 }
 
 UniformLinearBuffer::~UniformLinearBuffer()
@@ -92,6 +98,11 @@ void UniformLinearBuffer::Reset()
 	m_lastFlush = 0;
 	m_numAllocs = 0;
 
+	if (m_ring.IsMapped()) {
+		m_ring.Advance();
+		return;
+	}
+
 	glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
 	glBufferData(GL_UNIFORM_BUFFER, m_capacity, nullptr, GL_DYNAMIC_DRAW);
 }
@@ -105,6 +116,12 @@ void UniformLinearBuffer::Flush()
 	if (m_lastFlush == m_size)
 		return;
 
+	// coherently mapped, so the GPU already sees what was written
+	if (m_ring.IsMapped()) {
+		m_lastFlush = m_size;
+		return;
+	}
+
 	// Bind the buffer to the specified binding index as well as the GL_UNIFORM_BUFFER_TARGET
 	glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
 
@@ -131,13 +148,13 @@ BufferBinding<UniformBuffer> UniformLinearBuffer::Allocate(void *data, size_t si
 		assert(0 && "Attempt to allocate beyond UniformLinearBuffer free size!");
 
 	uint32_t offset = m_size;
-	memcpy(m_data.get() + offset, data, size);
+	memcpy(GetWriteData() + offset, data, size);
 
 	// Consume the buffer in increments of aligned size
 	m_size += (size + MIN_BUFFER_ALIGNMENT_MASK) & ~MIN_BUFFER_ALIGNMENT_MASK;
 	m_numAllocs++;
 
-	return { this, offset, uint32_t(size) };
+	return { this, m_ring.GetRegionOffset() + offset, uint32_t(size) };
 }
 
 void *UniformLinearBuffer::AllocInternal(size_t size, BufferBinding<UniformBuffer> &outBinding)
@@ -154,8 +171,8 @@ void *UniformLinearBuffer::AllocInternal(size_t size, BufferBinding<UniformBuffe
 	m_size += (size + MIN_BUFFER_ALIGNMENT_MASK) & ~MIN_BUFFER_ALIGNMENT_MASK;
 	m_numAllocs++;
 
-	outBinding = { this, offset, uint32_t(size) };
-	return m_data.get() + offset;
+	outBinding = { this, m_ring.GetRegionOffset() + offset, uint32_t(size) };
+	return GetWriteData() + offset;
 }
 
 void UniformLinearBuffer::Unmap()
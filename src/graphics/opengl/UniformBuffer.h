@@ -5,6 +5,7 @@
 
 #include "graphics/Types.h"
 #include "graphics/UniformBuffer.h"
+#include "graphics/opengl/BufferRing.h"
 #include "graphics/opengl/GLBufferBase.h"
 
 #include <memory>
@@ -75,10 +76,14 @@ namespace Graphics {
 			using UniformBuffer::Map;
 
 			void *AllocInternal(size_t size, BufferBinding<UniformBuffer> &outBinding);
+			char *GetWriteData() { return m_ring.IsMapped() ? reinterpret_cast<char *>(m_ring.GetRegionData()) : m_data.get(); }
 
 			// cache individual allocations into a single buffer and upload to
 			// the GPU in one large chunk.
 			std::unique_ptr<char[]> m_data;
+			// or, where supported, write them into this frame's region of
+			// persistently mapped storage
+			BufferRing m_ring;
 
 			// This tracks the end of the last section of flushed data so
 			// we can use the same allocator with multiple command lists
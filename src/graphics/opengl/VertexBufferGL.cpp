@@ -27,9 +27,15 @@ namespace Graphics {
 			}
 		}
 
-		static GLuint is_attr_normalized(VertexAttrib semantic)
+		static GLuint is_attr_normalized(VertexAttrib semantic, VertexAttribFormat fmt)
 		{
-			return semantic == ATTRIB_DIFFUSE ? GL_TRUE : GL_FALSE;
+			switch (fmt) {
+			case ATTRIB_FORMAT_SHORT4N:
+			case ATTRIB_FORMAT_BYTE4N:
+				return GL_TRUE;
+			default:
+				return semantic == ATTRIB_DIFFUSE ? GL_TRUE : GL_FALSE;
+			}
 		}
 
 		static GLint get_num_components(VertexAttribFormat fmt)
@@ -41,6 +47,8 @@ namespace Graphics {
 				return 3;
 			case ATTRIB_FORMAT_FLOAT4:
 			case ATTRIB_FORMAT_UBYTE4:
+			case ATTRIB_FORMAT_SHORT4N:
+			case ATTRIB_FORMAT_BYTE4N:
 				return 4;
 			default:
 				assert(false);
@@ -53,6 +61,10 @@ namespace Graphics {
 			switch (fmt) {
 			case ATTRIB_FORMAT_UBYTE4:
 				return GL_UNSIGNED_BYTE;
+			case ATTRIB_FORMAT_SHORT4N:
+				return GL_SHORT;
+			case ATTRIB_FORMAT_BYTE4N:
+				return GL_BYTE;
 			case ATTRIB_FORMAT_FLOAT2:
 			case ATTRIB_FORMAT_FLOAT3:
 			case ATTRIB_FORMAT_FLOAT4:
@@ -314,6 +326,20 @@ namespace Graphics {
 			}
 		}
 
+		void VertexBuffer::BufferSubData(const size_t offset, const size_t size, const void *data)
+		{
+			PROFILE_SCOPED()
+			assert(m_mapMode == BUFFER_MAP_NONE); //must not be currently mapped
+			assert(offset + size <= size_t(m_desc.numVertices) * m_desc.stride);
+			// keep the client copy of dynamic buffers in step
+			if (m_data)
+				memcpy(m_data + offset, data, size);
+			glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+			glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size), data);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			m_written = true;
+		}
+
 		void VertexBuffer::Bind()
 		{
 			assert(m_written);
@@ -332,6 +358,26 @@ namespace Graphics {
 			assert(desc.usage == BufferUsage::BUFFER_USAGE_DYNAMIC);
 			m_size = 0;
 			m_lastFlushed = 0;
+
+			// write vertices directly into persistently mapped storage instead of
+			// caching them client-side and uploading them at Flush()
+			if (BufferRing::IsSupported()) {
+				glDeleteBuffers(1, &m_buffer);
+				glGenBuffers(1, &m_buffer);
+				glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+				m_ring.Init(GL_ARRAY_BUFFER, m_capacity * m_desc.stride);
+				glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+				delete[] m_data;
+				m_data = m_ring.GetRegionData();
+			}
+		}
+
+		CachedVertexBuffer::~CachedVertexBuffer()
+		{
+			// m_data belongs to the mapping, not to us
+			if (m_ring.IsMapped())
+				m_data = nullptr;
 		}
 
 		bool CachedVertexBuffer::Populate(const VertexArray &va)
@@ -383,6 +429,13 @@ namespace Graphics {
 			if (m_lastFlushed >= dataSize)
 				return false;
 
+			// coherently mapped, so the GPU already sees what was written
+			if (m_ring.IsMapped()) {
+				m_lastFlushed = dataSize;
+				m_written = true;
+				return true;
+			}
+
 			glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
 			glBufferSubData(GL_ARRAY_BUFFER, m_lastFlushed, dataSize - m_lastFlushed, m_data + m_lastFlushed);
 			glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -394,6 +447,16 @@ namespace Graphics {
 		// Reset the cache and associated buffer for use in a new frame
 		void CachedVertexBuffer::Reset()
 		{
+			if (m_ring.IsMapped()) {
+				m_ring.Advance();
+				m_data = m_ring.GetRegionData();
+
+				m_size = 0;
+				m_lastFlushed = 0;
+				m_written = false;
+				return;
+			}
+
 			// respecify the buffer storage to orphan data that theoretically might still be in flight
 			glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
 			glBufferData(GL_ARRAY_BUFFER, m_capacity * m_desc.stride, nullptr, get_buffer_usage(m_desc.usage));
@@ -646,7 +709,7 @@ namespace Graphics {
 				// Enable the attribute at that location
 				glEnableVertexAttribArray(attrib);
 				// Tell OpenGL what the array contains
-				glVertexAttribFormat(attrib, get_num_components(attr.format), get_component_type(attr.format), is_attr_normalized(attr.semantic), attr.offset);
+				glVertexAttribFormat(attrib, get_num_components(attr.format), get_component_type(attr.format), is_attr_normalized(attr.semantic, attr.format), attr.offset);
 				// All vertex attribs will be sourced from the same buffer
 				glVertexAttribBinding(attrib, 0);
 			}
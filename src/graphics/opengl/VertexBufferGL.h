@@ -5,6 +5,7 @@
 
 #include "graphics/Types.h"
 #include "graphics/VertexBuffer.h"
+#include "graphics/opengl/BufferRing.h"
 #include "graphics/opengl/GLBufferBase.h"
 
 #include <memory>
@@ -26,6 +27,7 @@ namespace Graphics {
 
 			// change the buffer data without mapping
 			virtual void BufferData(const size_t, void *) override final;
+			virtual void BufferSubData(const size_t offset, const size_t size, const void *data) override final;
 
 			virtual void Bind() override final;
 			virtual void Release() override final;
@@ -41,9 +43,11 @@ namespace Graphics {
 		class CachedVertexBuffer : public VertexBuffer {
 		public:
 			CachedVertexBuffer(const VertexBufferDesc &, size_t stateHash);
+			~CachedVertexBuffer();
 
 			virtual bool Populate(const VertexArray &) override final;
-			uint32_t GetOffset() { return m_size * m_desc.stride; }
+			// byte offset in the GL buffer at which the next vertex is written
+			uint32_t GetOffset() { return m_ring.GetRegionOffset() + m_size * m_desc.stride; }
 
 			bool Flush();
 			void Reset();
@@ -55,6 +59,8 @@ namespace Graphics {
 
 		private:
 			uint32_t m_lastFlushed;
+			// when mapped, m_data points into this frame's region of it
+			BufferRing m_ring;
 		};
 
 		class IndexBuffer : public Graphics::IndexBuffer, public GLBufferBase {
@@ -26,6 +26,7 @@
 #include "LuaTimer.h"
 #include "LuaVector.h"
 #include "LuaVector2.h"
+#include "LuaWorker.h"
 
 #include "Body.h"
 #include "SectorView.h"
@@ -33,7 +34,9 @@
 #include "SpaceStation.h"
 #include "Star.h"
 #include "SystemView.h"
+#include "core/MemoryStats.h"
 
+#include "galaxy/CommodityMarket.h"
 #include "galaxy/StarSystem.h"
 #include "pigui/LuaPiGui.h"
 #include "scenegraph/Lua.h"
@@ -48,10 +51,15 @@ namespace Lua {
 	{
 		manager = new LuaManager();
 		InitMath();
+
+		MemoryStats::SetReporter(MemoryStats::TAG_LUA, []() -> size_t {
+			return manager ? manager->GetMemoryUsage() : 0;
+		});
 	}
 
 	void Uninit()
 	{
+		MemoryStats::SetReporter(MemoryStats::TAG_LUA, nullptr);
 		delete manager;
 		manager = 0;
 	}
@@ -96,6 +104,7 @@ namespace Lua {
 		LuaObject<SystemBody>::RegisterClass();
 		LuaObject<Faction>::RegisterClass();
 		LuaObject<Galaxy>::RegisterClass();
+		LuaObject<CommodityMarket>::RegisterClass();
 
 		Pi::luaSerializer = new LuaSerializer();
 		Pi::luaTimer = new LuaTimer();
@@ -120,6 +129,7 @@ namespace Lua {
 		LuaShipDef::Register();
 		LuaMusic::Register();
 		LuaDev::Register();
+		LuaWorker::Register();
 		// LuaConsole::Register();
 
 		// XXX sigh
@@ -141,6 +151,8 @@ namespace Lua {
 
 	void UninitModules()
 	{
+		LuaWorker::Uninit();
+		LuaJson::Uninit();
 		LuaEvent::Uninit();
 
 		delete Pi::luaNameGen;
@@ -0,0 +1,146 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "LuaAllocator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+
+LuaAllocator::~LuaAllocator()
+{
+	for (void *slab : m_slabs)
+		std::free(slab);
+}
+
+void *LuaAllocator::Alloc(void *ud, void *ptr, size_t osize, size_t nsize)
+{
+	return static_cast<LuaAllocator *>(ud)->Reallocate(ptr, osize, nsize);
+}
+
+void *LuaAllocator::AllocateBlock(size_t size)
+{
+	if (size > MAX_SMALL_SIZE) {
+		void *ptr = std::malloc(size);
+		if (ptr) {
+			m_stats.largeBytes += size;
+			m_stats.numLargeAllocs++;
+		}
+		return ptr;
+	}
+
+	SizeClass &sc = m_classes[GetSizeClass(size)];
+	const size_t blockSize = GetClassSize(GetSizeClass(size));
+
+	void *ptr;
+	if (sc.freeList) {
+		ptr = sc.freeList;
+		sc.freeList = sc.freeList->next;
+	} else {
+		if (sc.slabCursor + blockSize > sc.slabEnd) {
+			char *slab = static_cast<char *>(std::malloc(SLAB_SIZE));
+			if (!slab)
+				return nullptr;
+			m_slabs.push_back(slab);
+			m_stats.slabBytes += SLAB_SIZE;
+			sc.slabCursor = slab;
+			sc.slabEnd = slab + SLAB_SIZE;
+		}
+		ptr = sc.slabCursor;
+		sc.slabCursor += blockSize;
+	}
+
+	sc.numBlocks++;
+	m_stats.pooledBytes += blockSize;
+	return ptr;
+}
+
+void LuaAllocator::FreeBlockOf(void *ptr, size_t size)
+{
+	if (size > MAX_SMALL_SIZE) {
+		std::free(ptr);
+		m_stats.largeBytes -= size;
+		return;
+	}
+
+	SizeClass &sc = m_classes[GetSizeClass(size)];
+	assert(sc.numBlocks > 0);
+	FreeBlock *block = static_cast<FreeBlock *>(ptr);
+	block->next = sc.freeList;
+	sc.freeList = block;
+	sc.numBlocks--;
+	m_stats.pooledBytes -= GetClassSize(GetSizeClass(size));
+}
+
+void *LuaAllocator::Reallocate(void *ptr, size_t osize, size_t nsize)
+{
+	// for a new block osize holds the object type, not a size
+	if (ptr == nullptr)
+		osize = 0;
+
+	if (nsize == 0) {
+		if (ptr) {
+			FreeBlockOf(ptr, osize);
+			m_stats.bytesInUse -= osize;
+			m_stats.numFrees++;
+		}
+		return nullptr;
+	}
+
+	if (ptr == nullptr) {
+		void *block = AllocateBlock(nsize);
+		if (block) {
+			m_stats.bytesInUse += nsize;
+			m_stats.numAllocs++;
+		}
+		return block;
+	}
+
+	m_stats.numReallocs++;
+
+	// both sizes large: let realloc grow or shrink the block in place
+	if (osize > MAX_SMALL_SIZE && nsize > MAX_SMALL_SIZE) {
+		void *block = std::realloc(ptr, nsize);
+		if (block) {
+			m_stats.largeBytes += nsize;
+			m_stats.largeBytes -= osize;
+			m_stats.bytesInUse += nsize;
+			m_stats.bytesInUse -= osize;
+		}
+		return block;
+	}
+
+	// both sizes in the same class: the block already fits
+	if (osize <= MAX_SMALL_SIZE && nsize <= MAX_SMALL_SIZE && GetSizeClass(osize) == GetSizeClass(nsize)) {
+		m_stats.bytesInUse += nsize;
+		m_stats.bytesInUse -= osize;
+		return ptr;
+	}
+
+	void *block = AllocateBlock(nsize);
+	if (!block) {
+		if (nsize > osize)
+			return nullptr;
+
+		// Lua requires shrinking to succeed. The old block is big enough, so
+		// keep it and account for it as a block of the new size; it will be
+		// freed into that size class later, which only wastes its tail.
+		if (osize > MAX_SMALL_SIZE) {
+			m_stats.largeBytes -= osize;
+		} else {
+			m_classes[GetSizeClass(osize)].numBlocks--;
+			m_stats.pooledBytes -= GetClassSize(GetSizeClass(osize));
+		}
+		m_classes[GetSizeClass(nsize)].numBlocks++;
+		m_stats.pooledBytes += GetClassSize(GetSizeClass(nsize));
+		m_stats.bytesInUse -= osize - nsize;
+		return ptr;
+	}
+
+	std::memcpy(block, ptr, std::min(osize, nsize));
+	FreeBlockOf(ptr, osize);
+	m_stats.bytesInUse += nsize;
+	m_stats.bytesInUse -= osize;
+	return block;
+}
@@ -0,0 +1,82 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Size-class pool allocator for the Lua state.
+ *
+ * Requests up to MAX_SMALL_SIZE bytes are rounded up to a multiple of
+ * GRANULARITY and served from per-class free lists, which are refilled by
+ * carving SLAB_SIZE slabs. This covers nearly all of Lua's tables, strings,
+ * closures and upvalues. Larger requests go straight to malloc.
+ *
+ * Lua always passes the old size of a block back to the allocator, so blocks
+ * need no header. Slab memory is only returned to the system when the
+ * allocator is destroyed, after the state has been closed.
+ *
+ * Not thread-safe: a lua_State must only be used by one thread at a time,
+ * and so is its allocator.
+ */
+class LuaAllocator {
+public:
+	static constexpr size_t GRANULARITY = 16;
+	static constexpr size_t MAX_SMALL_SIZE = 512;
+	static constexpr size_t NUM_CLASSES = MAX_SMALL_SIZE / GRANULARITY;
+	static constexpr size_t SLAB_SIZE = 64 * 1024;
+
+	struct Stats {
+		size_t bytesInUse = 0;  // bytes requested by Lua and not yet freed
+		size_t slabBytes = 0;   // bytes held in slabs, used or free
+		size_t pooledBytes = 0; // bytes of pooled blocks handed out
+		size_t largeBytes = 0;  // bytes handed out by malloc
+		uint64_t numAllocs = 0;
+		uint64_t numFrees = 0;
+		uint64_t numReallocs = 0;
+		uint64_t numLargeAllocs = 0;
+	};
+
+	LuaAllocator() = default;
+	~LuaAllocator();
+
+	LuaAllocator(const LuaAllocator &) = delete;
+	LuaAllocator &operator=(const LuaAllocator &) = delete;
+
+	// lua_Alloc entry point, ud must point to a LuaAllocator
+	static void *Alloc(void *ud, void *ptr, size_t osize, size_t nsize);
+
+	void *Reallocate(void *ptr, size_t osize, size_t nsize);
+
+	const Stats &GetStats() const { return m_stats; }
+
+	// number of live blocks in each size class
+	size_t GetNumBlocks(size_t sizeClass) const { return m_classes[sizeClass].numBlocks; }
+
+private:
+	struct FreeBlock {
+		FreeBlock *next;
+	};
+
+	struct SizeClass {
+		FreeBlock *freeList = nullptr;
+		// unused tail of the slab this class is carving
+		char *slabCursor = nullptr;
+		char *slabEnd = nullptr;
+		size_t numBlocks = 0;
+	};
+
+	static size_t GetSizeClass(size_t size) { return (size - 1) / GRANULARITY; }
+	static size_t GetClassSize(size_t sizeClass) { return (sizeClass + 1) * GRANULARITY; }
+
+	void *AllocateBlock(size_t size);
+	void FreeBlockOf(void *ptr, size_t size);
+
+	std::array<SizeClass, NUM_CLASSES> m_classes;
+	std::vector<void *> m_slabs;
+	Stats m_stats;
+};
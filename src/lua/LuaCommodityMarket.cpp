@@ -0,0 +1,274 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "LuaObject.h"
+#include "LuaTable.h"
+#include "LuaUtils.h"
+#include "galaxy/CommodityMarket.h"
+
+/*
+ * Class: CommodityMarket
+ *
+ * The stock and prices of every commodity at a number of markets, stepped
+ * together. Markets are numbered from 1 in the order they're added;
+ * commodities are given by name or by id.
+ */
+
+static size_t check_market(lua_State *l, const CommodityMarket *market, int index)
+{
+	const lua_Integer idx = luaL_checkinteger(l, index);
+	if (idx < 1 || size_t(idx) > market->GetNumMarkets())
+		luaL_error(l, "market %d does not exist", int(idx));
+	return size_t(idx - 1);
+}
+
+static GalacticEconomy::CommodityId check_commodity(lua_State *l, int index)
+{
+	GalacticEconomy::CommodityId id;
+	if (lua_type(l, index) == LUA_TNUMBER)
+		id = GalacticEconomy::CommodityId(lua_tointeger(l, index));
+	else
+		id = GalacticEconomy::GetCommodityByName(luaL_checkstring(l, index));
+
+	if (GalacticEconomy::GetCommodityById(id).id == GalacticEconomy::InvalidCommodityId)
+		luaL_error(l, "no such commodity '%s'", luaL_tolstring(l, index, nullptr));
+	return id;
+}
+
+/*
+ * Function: New
+ *
+ * Creates a market with a column for each commodity in Economy.GetCommodities()
+ *
+ * > market = CommodityMarket.New()
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_commodity_market_new(lua_State *l)
+{
+	LuaObject<CommodityMarket>::PushToLua(new CommodityMarket(GalacticEconomy::Commodities().size()));
+	return 1;
+}
+
+/*
+ * Method: AddMarket
+ *
+ * Adds a market with nothing in stock, returning its number
+ *
+ * > index = market:AddMarket()
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_commodity_market_add_market(lua_State *l)
+{
+	CommodityMarket *market = LuaObject<CommodityMarket>::CheckFromLua(1);
+	lua_pushinteger(l, market->AddMarket() + 1);
+	return 1;
+}
+
+/*
+ * Method: Clear
+ *
+ * Removes every market
+ *
+ * > market:Clear()
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_commodity_market_clear(lua_State *l)
+{
+	LuaObject<CommodityMarket>::CheckFromLua(1)->Clear();
+	return 0;
+}
+
+/*
+ * Method: SetEquilibrium
+ *
+ * Sets the stock a market's commodity settles at, and its price there
+ *
+ * > market:SetEquilibrium(index, commodity, stock, price)
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_commodity_market_set_equilibrium(lua_State *l)
+{
+	CommodityMarket *market = LuaObject<CommodityMarket>::CheckFromLua(1);
+	const size_t index = check_market(l, market, 2);
+	const GalacticEconomy::CommodityId id = check_commodity(l, 3);
+	market->SetEquilibrium(index, id, luaL_checknumber(l, 4), luaL_checknumber(l, 5));
+	return 0;
+}
+
+/*
+ * Method: SetStock
+ *
+ * Sets how much of a commodity a market has, such as after trading or
+ * loading a game
+ *
+ * > market:SetStock(index, commodity, stock)
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_commodity_market_set_stock(lua_State *l)
+{
+	CommodityMarket *market = LuaObject<CommodityMarket>::CheckFromLua(1);
+	const size_t index = check_market(l, market, 2);
+	const GalacticEconomy::CommodityId id = check_commodity(l, 3);
+	market->SetStock(index, id, luaL_checknumber(l, 4));
+	return 0;
+}
+
+/*
+ * Method: GetStock
+ *
+ * > stock = market:GetStock(index, commodity)
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_commodity_market_get_stock(lua_State *l)
+{
+	CommodityMarket *market = LuaObject<CommodityMarket>::CheckFromLua(1);
+	const size_t index = check_market(l, market, 2);
+	lua_pushnumber(l, market->GetStock(index, check_commodity(l, 3)));
+	return 1;
+}
+
+/*
+ * Method: GetPrice
+ *
+ * > price = market:GetPrice(index, commodity)
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_commodity_market_get_price(lua_State *l)
+{
+	CommodityMarket *market = LuaObject<CommodityMarket>::CheckFromLua(1);
+	const size_t index = check_market(l, market, 2);
+	lua_pushnumber(l, market->GetPrice(index, check_commodity(l, 3)));
+	return 1;
+}
+
+/*
+ * Method: GetMarket
+ *
+ * Gets the stock and price of every commodity at a market
+ *
+ * > stock, prices = market:GetMarket(index)
+ *
+ * Return:
+ *
+ *   stock - a table of commodity name to stock
+ *
+ *   prices - a table of commodity name to price
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_commodity_market_get_market(lua_State *l)
+{
+	CommodityMarket *market = LuaObject<CommodityMarket>::CheckFromLua(1);
+	const size_t index = check_market(l, market, 2);
+
+	LuaTable stock(l, 0, int(market->GetNumCommodities()));
+	LuaTable prices(l, 0, int(market->GetNumCommodities()));
+	for (const GalacticEconomy::CommodityInfo &info : GalacticEconomy::Commodities()) {
+		if (!market->IsValid(index, info.id))
+			continue;
+		stock.Set(info.name, market->GetStock(index, info.id));
+		prices.Set(info.name, market->GetPrice(index, info.id));
+	}
+	return 2;
+}
+
+/*
+ * Method: SetRecoveryTime
+ *
+ * Sets how long in seconds stock takes to get two thirds of the way back to
+ * equilibrium
+ *
+ * > market:SetRecoveryTime(seconds)
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_commodity_market_set_recovery_time(lua_State *l)
+{
+	LuaObject<CommodityMarket>::CheckFromLua(1)->SetRecoveryTime(luaL_checknumber(l, 2));
+	return 0;
+}
+
+/*
+ * Method: SetPriceElasticity
+ *
+ * Sets the fraction a price rises by as its stock runs out, or falls by as
+ * its stock doubles
+ *
+ * > market:SetPriceElasticity(elasticity)
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_commodity_market_set_price_elasticity(lua_State *l)
+{
+	LuaObject<CommodityMarket>::CheckFromLua(1)->SetPriceElasticity(luaL_checknumber(l, 2));
+	return 0;
+}
+
+/*
+ * Method: Update
+ *
+ * Moves the stock of every commodity at every market towards its
+ * equilibrium and reprices them all
+ *
+ * > market:Update(dt)
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_commodity_market_update(lua_State *l)
+{
+	LuaObject<CommodityMarket>::CheckFromLua(1)->Update(luaL_checknumber(l, 2));
+	return 0;
+}
+
+template <>
+const char *LuaObject<CommodityMarket>::s_type = "CommodityMarket";
+
+template <>
+void LuaObject<CommodityMarket>::RegisterClass()
+{
+	static const luaL_Reg l_methods[] = {
+		{ "New", l_commodity_market_new },
+		{ "AddMarket", l_commodity_market_add_market },
+		{ "Clear", l_commodity_market_clear },
+		{ "SetEquilibrium", l_commodity_market_set_equilibrium },
+		{ "SetStock", l_commodity_market_set_stock },
+		{ "GetStock", l_commodity_market_get_stock },
+		{ "GetPrice", l_commodity_market_get_price },
+		{ "GetMarket", l_commodity_market_get_market },
+		{ "SetRecoveryTime", l_commodity_market_set_recovery_time },
+		{ "SetPriceElasticity", l_commodity_market_set_price_elasticity },
+		{ "Update", l_commodity_market_update },
+		{ 0, 0 }
+	};
+
+	LuaObjectBase::CreateClass(s_type, 0, l_methods, 0, 0);
+}
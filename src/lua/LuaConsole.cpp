@@ -42,6 +42,9 @@ static const char CONSOLE_CHUNK_NAME[] = "console";
 #endif
 
 static constexpr int EDIT_BUFFER_LENGTH = 1024;
+// the oldest output lines and statements are dropped past these
+static constexpr size_t MAX_OUTPUT_LINES = 4096;
+static constexpr size_t MAX_STATEMENT_HISTORY = 256;
 
 LuaConsole::LuaConsole() :
 	m_active(false),
@@ -180,7 +183,27 @@ void LuaConsole::RegisterAutoexec()
 void LuaConsole::LogCallback(Time::DateTime time, Log::Severity sev, std::string_view message)
 {
 	if (sev <= Log::Severity::Debug)
-		m_outputLines.push_back(std::string(message));
+		AppendOutputLines(message);
+}
+
+// Output is stored one line per entry so every entry is drawn at the same
+// height, which lets Draw() skip the lines that are scrolled out of view
+void LuaConsole::AppendOutputLines(std::string_view text)
+{
+	if (!text.empty() && text.back() == '\n')
+		text.remove_suffix(1);
+
+	size_t start = 0;
+	while (true) {
+		const size_t end = text.find('\n', start);
+		m_outputLines.emplace_back(text.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start));
+		if (end == std::string_view::npos)
+			break;
+		start = end + 1;
+	}
+
+	while (m_outputLines.size() > MAX_OUTPUT_LINES)
+		m_outputLines.pop_front();
 }
 
 static int callback(ImGuiInputTextCallbackData *data)
@@ -195,8 +218,13 @@ void LuaConsole::Draw()
 	ImGui::SetNextWindowSize({ float(Graphics::GetScreenWidth()), float(Graphics::GetScreenHeight()) });
 	if (ImGui::Begin("Lua Console", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoSavedSettings)) {
 		if (ImGui::BeginChild("##TextWindow", ImVec2(0.f, -ImGui::GetFrameHeightWithSpacing() - ImGui::GetStyle().ItemSpacing.y))) {
-			for (const auto &str : m_outputLines) {
-				ImGui::TextUnformatted(str.c_str());
+			ImGuiListClipper clipper;
+			clipper.Begin(int(m_outputLines.size()));
+			while (clipper.Step()) {
+				for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+					const std::string &str = m_outputLines[i];
+					ImGui::TextUnformatted(str.data(), str.data() + str.size());
+				}
 			}
 
 			if (ImGui::GetScrollY() >= ImGui::GetScrollMaxY())
@@ -365,7 +393,7 @@ void LuaConsole::UpdateCompletion(const std::string &statement)
 
 void LuaConsole::AddOutput(const std::string &line)
 {
-	m_outputLines.push_back(line);
+	AppendOutputLines(line);
 #ifdef REMOTE_LUA_REPL
 	BroadcastToDebuggers(line.back() == '\n' ? line : line + '\n');
 #endif
@@ -491,6 +519,8 @@ bool LuaConsole::ExecOrContinue(const std::string &stmt, bool repeatStatement)
 		// an exact repeat of the immediate last command
 		if (m_statementHistory.empty() || (stmt != m_statementHistory.back()))
 			m_statementHistory.push_back(stmt);
+		if (m_statementHistory.size() > MAX_STATEMENT_HISTORY)
+			m_statementHistory.pop_front();
 
 		// clear the entry box
 		m_activeStr.clear();
@@ -37,6 +37,7 @@ private:
 	bool OnCompletion(bool backward);
 	bool OnHistory(bool upArrow);
 	void LogCallback(Time::DateTime, Log::Severity, std::string_view);
+	void AppendOutputLines(std::string_view text);
 
 	bool ExecOrContinue(const std::string &stmt, bool repeatStatement = true);
 	void UpdateCompletion(const std::string &statement);
@@ -53,8 +54,8 @@ private:
 	InputBindings::Action *toggleLuaConsole;
 	ConnectionTicket m_logCallbackConn;
 
-	// Output log
-	std::vector<std::string> m_outputLines;
+	// Output log, bounded to the most recent lines
+	std::deque<std::string> m_outputLines;
 
 	// statement history
 	std::deque<std::string> m_statementHistory;
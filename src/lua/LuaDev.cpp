@@ -75,7 +75,7 @@ static int l_dev_galaxy_stats(lua_State *l)
 		void ProcessSystem(const Sector::System &system) override
 		{
 			// counting repeats of each name
-			names[system.GetName()]++;
+			names[std::string(system.GetName())]++;
 		}
 		std::string Report() override
 		{
@@ -108,7 +108,7 @@ static int l_dev_galaxy_stats(lua_State *l)
 		void ProcessSystem(const Sector::System &system) override
 		{
 			if (system.IsExplored()) explored++;
-			double current = galaxy->GetStarSystem(SystemPath(system.sx, system.sy, system.sz, system.idx))->GetTotalPop().ToDouble();
+			double current = galaxy->GetStarSystem(SystemPath(system.sx, system.sy, system.sz, system.idx), StarSystem::GENERATED_POPULATION)->GetTotalPop().ToDouble();
 			if (current > 0) {
 				inhabited++;
 				population += current;
@@ -145,7 +145,7 @@ static int l_dev_galaxy_stats(lua_State *l)
 					}) != children.cend())
 					// the radius and the mass of the planet is returned in the radii and the mass of the earth
 					// therefore the result is obtained in g
-					Planets.emplace_back(b->GetName(), system.GetName(), b->GetMassAsFixed().ToDouble() / b->GetRadiusAsFixed().ToDouble() / b->GetRadiusAsFixed().ToDouble(), b->GetPath());
+					Planets.emplace_back(b->GetName(), std::string(system.GetName()), b->GetMassAsFixed().ToDouble() / b->GetRadiusAsFixed().ToDouble() / b->GetRadiusAsFixed().ToDouble(), b->GetPath());
 			}
 		}
 		std::string Report() override
@@ -804,12 +804,15 @@ static int l_engine_get_intro_current_model_name(lua_State *l)
  *
  * Convert a direction Vector from world space to screen space
  *
- * > screen_space = Engine.WorldSpaceToShipSpace(world_space)
+ * > screen_space = Engine.WorldSpaceToShipSpace(world_space, out)
  *
  * Parameters:
  *
  *   camera_space - a Vector in camera space
  *
+ *   out - optional. A Vector to store the result in instead of returning
+ *         a new one
+ *
  * Availability:
  *
  *   2017-04
@@ -824,7 +827,7 @@ static int l_engine_world_space_to_ship_space(lua_State *l)
 	vector3d vec = LuaPull<vector3d>(l, 1);
 	auto res = vec * Pi::game->GetPlayer()->GetOrient();
 
-	LuaPush<vector3d>(l, res);
+	LuaVector::PushToLuaReuse(l, res, 2);
 	return 1;
 }
 
@@ -833,12 +836,15 @@ static int l_engine_world_space_to_ship_space(lua_State *l)
  *
  * Convert a direction Vector from ship space to screen space
  *
- * > screen_space = Engine.ShipSpaceToScreenSpace(ship_space)
+ * > screen_space = Engine.ShipSpaceToScreenSpace(ship_space, out)
  *
  * Parameters:
  *
  *   ship_space - a Vector in ship space
  *
+ *   out - optional. A Vector to store the result in instead of returning
+ *         a new one
+ *
  * Availability:
  *
  *   2017-04
@@ -852,7 +858,7 @@ static int l_engine_ship_space_to_screen_space(lua_State *l)
 {
 	vector3d pos = LuaPull<vector3d>(l, 1);
 	vector3d cam = Pi::game->GetWorldView()->WorldDirToScreenSpace(Pi::player->GetInterpOrient() * pos);
-	LuaPush<vector3d>(l, cam);
+	LuaVector::PushToLuaReuse(l, cam, 2);
 	return 1;
 }
 
@@ -861,12 +867,15 @@ static int l_engine_ship_space_to_screen_space(lua_State *l)
  *
  * Convert a direction Vector from camera space to screen space
  *
- * > screen_space = Engine.CameraSpaceToScreenSpace(camera_space)
+ * > screen_space = Engine.CameraSpaceToScreenSpace(camera_space, out)
  *
  * Parameters:
  *
  *   camera_space - a Vector in camera space
  *
+ *   out - optional. A Vector to store the result in instead of returning
+ *         a new one
+ *
  * Availability:
  *
  *   2017-04
@@ -880,7 +889,7 @@ static int l_engine_camera_space_to_screen_space(lua_State *l)
 {
 	vector3d pos = LuaPull<vector3d>(l, 1);
 	vector3d cam = Pi::game->GetWorldView()->CameraSpaceToScreenSpace(pos);
-	LuaPush(l, cam);
+	LuaVector::PushToLuaReuse(l, cam, 2);
 	return 1;
 }
 
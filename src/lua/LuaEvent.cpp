@@ -5,12 +5,59 @@
 #include "LuaManager.h"
 #include "LuaObject.h"
 #include "LuaUtils.h"
+#include "PerfStats.h"
 
 #include "core/Log.h"
+#include "profiler/Profiler.h"
+
+#include <map>
+#include <tuple>
 
 namespace LuaEvent {
 
+	struct EventInfo {
+		EventInfo(Perf::Stats &stats, const std::string &name) :
+			queued(stats.GetOrCreateCounter(name + " queued")),
+			dropped(stats.GetOrCreateCounter(name + " dropped")),
+			coalesced(stats.GetOrCreateCounter(name + " coalesced")),
+			dispatched(stats.GetOrCreateCounter(name + " dispatched")),
+			dispatchTime(stats.GetOrCreateCounter(name + " dispatch time (us)"))
+		{}
+
+		int listeners = 0;
+		Perf::Stats::CounterRef queued;
+		Perf::Stats::CounterRef dropped;
+		Perf::Stats::CounterRef coalesced;
+		Perf::Stats::CounterRef dispatched;
+		Perf::Stats::CounterRef dispatchTime;
+	};
+
+	// event name (owned by s_events), key objects
+	using CoalesceSlot = std::tuple<const std::string *, const void *, const void *>;
+
 	static LuaRef s_eventTable;
+	static Perf::Stats s_stats;
+	static std::map<std::string, EventInfo, std::less<>> s_events;
+
+	// set once the Lua side has reported a listener; before that nothing is dropped
+	static bool s_trackListeners = false;
+
+	// queue indices of coalesced events waiting to be dispatched
+	static std::map<CoalesceSlot, size_t> s_coalesced;
+	static bool s_emitting = false;
+
+	static std::pair<const std::string, EventInfo> &_get_event(std::string_view name)
+	{
+		auto iter = s_events.find(name);
+		if (iter == s_events.end()) {
+			std::string key(name);
+			iter = s_events.emplace(std::piecewise_construct,
+							  std::forward_as_tuple(key),
+							  std::forward_as_tuple(s_stats, key))
+					   .first;
+		}
+		return *iter;
+	}
 
 	static bool _get_method_onto_stack(lua_State *l, const char *method)
 	{
@@ -33,6 +80,33 @@ namespace LuaEvent {
 		return true;
 	}
 
+	// Event:_AddListener(name) / Event:_RemoveListener(name), called by the
+	// Lua Event library when a callback is (de)registered. Only registrations
+	// on the global queue are counted.
+	static int l_event_add_listener(lua_State *l)
+	{
+		s_eventTable.PushCopyToStack();
+		const bool global = lua_rawequal(l, 1, -1);
+		lua_pop(l, 1);
+		if (global) {
+			s_trackListeners = true;
+			_get_event(luaL_checkstring(l, 2)).second.listeners++;
+		}
+		return 0;
+	}
+
+	static int l_event_remove_listener(lua_State *l)
+	{
+		s_eventTable.PushCopyToStack();
+		const bool global = lua_rawequal(l, 1, -1);
+		lua_pop(l, 1);
+		if (global) {
+			EventInfo &info = _get_event(luaL_checkstring(l, 2)).second;
+			info.listeners = std::max(info.listeners - 1, 0);
+		}
+		return 0;
+	}
+
 	void Init()
 	{
 		lua_State *l = Lua::manager->GetLuaState();
@@ -44,17 +118,26 @@ namespace LuaEvent {
 
 		s_eventTable = LuaRef(l, -1);
 
+		lua_pushcfunction(l, l_event_add_listener);
+		lua_setfield(l, -2, "_AddListener");
+		lua_pushcfunction(l, l_event_remove_listener);
+		lua_setfield(l, -2, "_RemoveListener");
+
 		lua_pop(l, 1);
 	}
 
 	void Uninit()
 	{
 		s_eventTable.Unref();
+		s_events.clear();
+		s_coalesced.clear();
+		s_trackListeners = false;
 	}
 
 	void Clear()
 	{
 		lua_State *l = Lua::manager->GetLuaState();
+		s_coalesced.clear();
 
 		LUA_DEBUG_START(l);
 		if (!_get_method_onto_stack(l, "_Clear")) return;
@@ -62,14 +145,61 @@ namespace LuaEvent {
 		LUA_DEBUG_END(l, 0);
 	}
 
+	// dispatch the queue one event at a time through Event._Dispatch(ev),
+	// timing each event
+	static void _dispatch_queue(lua_State *l)
+	{
+		LUA_DEBUG_START(l);
+		s_eventTable.PushCopyToStack();
+		const int queue = lua_gettop(l);
+
+		// events queued by handlers are appended and dispatched in the same pass
+		for (size_t idx = 1; idx <= lua_rawlen(l, queue); idx++) {
+			lua_getfield(l, queue, "_Dispatch");
+			lua_rawgeti(l, queue, idx);
+			lua_getfield(l, -1, "name");
+			const char *name = lua_tostring(l, -1);
+			EventInfo &info = _get_event(name ? name : "").second;
+			lua_pop(l, 1);
+
+			Profiler::Clock clock{};
+			clock.Start();
+			pi_lua_protected_call(l, 1, 0);
+			clock.Stop();
+
+			s_stats.CounterAdd(info.dispatched);
+			s_stats.CounterAdd(info.dispatchTime, uint32_t(clock.milliseconds() * 1000.0));
+		}
+
+		for (size_t idx = lua_rawlen(l, queue); idx > 0; idx--) {
+			lua_pushnil(l);
+			lua_rawseti(l, queue, idx);
+		}
+
+		lua_pop(l, 1);
+		LUA_DEBUG_END(l, 0);
+	}
+
 	void Emit()
 	{
+		PROFILE_SCOPED()
 		lua_State *l = Lua::manager->GetLuaState();
 
+		// events queued while dispatching are never merged into the running queue
+		s_coalesced.clear();
+		s_emitting = true;
+
 		LUA_DEBUG_START(l);
-		if (!_get_method_onto_stack(l, "_Emit")) return;
-		pi_lua_protected_call(l, 0, 0);
+		if (_get_method_onto_stack(l, "_Dispatch")) {
+			lua_pop(l, 1);
+			_dispatch_queue(l);
+		} else if (_get_method_onto_stack(l, "_Emit")) {
+			// an Event library without per-event dispatch runs the whole queue
+			pi_lua_protected_call(l, 0, 0);
+		}
 		LUA_DEBUG_END(l, 0);
+
+		s_emitting = false;
 	}
 
 	LuaRef &GetEventQueue()
@@ -77,4 +207,48 @@ namespace LuaEvent {
 		return s_eventTable;
 	}
 
+	Perf::Stats &GetStats()
+	{
+		return s_stats;
+	}
+
+	bool ShouldQueue(std::string_view event)
+	{
+		EventInfo &info = _get_event(event).second;
+		if (s_trackListeners && info.listeners == 0) {
+			s_stats.CounterAdd(info.dropped);
+			return false;
+		}
+
+		s_stats.CounterAdd(info.queued);
+		return true;
+	}
+
+	void PushCoalesced(std::string_view event, CoalesceKey key, LuaTable &ev)
+	{
+		lua_State *l = ev.GetLua();
+		auto &entry = _get_event(event);
+
+		LUA_DEBUG_START(l);
+		s_eventTable.PushCopyToStack();
+		const int queue = lua_gettop(l);
+
+		const CoalesceSlot slot{ &entry.first, key.a, key.b };
+		auto iter = s_emitting ? s_coalesced.end() : s_coalesced.find(slot);
+		if (iter != s_coalesced.end()) {
+			s_stats.CounterAdd(entry.second.coalesced);
+			lua_pushvalue(l, ev.GetIndex());
+			lua_rawseti(l, queue, iter->second);
+		} else {
+			const size_t idx = lua_rawlen(l, queue) + 1;
+			lua_pushvalue(l, ev.GetIndex());
+			lua_rawseti(l, queue, idx);
+			if (!s_emitting)
+				s_coalesced.emplace(slot, idx);
+		}
+
+		lua_pop(l, 1);
+		LUA_DEBUG_END(l, 0);
+	}
+
 } // namespace LuaEvent
@@ -9,6 +9,10 @@
 #include "LuaPushPull.h"
 #include "LuaTable.h"
 
+namespace Perf {
+	class Stats;
+}
+
 namespace LuaEvent {
 
 	void Init();
@@ -19,6 +23,26 @@ namespace LuaEvent {
 
 	LuaRef &GetEventQueue();
 
+	// Per-event queue, drop, coalesce and dispatch counters for the global
+	// event queue, flushed once per frame
+	Perf::Stats &GetStats();
+
+	// Returns false if nothing is registered for the event on the global
+	// queue, in which case queueing it can be skipped. Until the Lua Event
+	// library reports its listeners every event is assumed to have some.
+	bool ShouldQueue(std::string_view event);
+
+	// Identifies the events that QueueCoalesced merges: usually the object
+	// the event is about, plus an optional second object.
+	struct CoalesceKey {
+		const void *a;
+		const void *b = nullptr;
+	};
+
+	// Appends ev to the global queue, or replaces a not yet dispatched event
+	// with the same name and key
+	void PushCoalesced(std::string_view event, CoalesceKey key, LuaTable &ev);
+
 	// Push an event to the specified event queue, passed as a LuaRef &
 	template <typename... TArgs>
 	inline void Queue(const LuaRef &queue, std::string_view event, TArgs... args)
@@ -39,17 +63,36 @@ namespace LuaEvent {
 		ScopedTable(queue).PushBack(ev);
 	}
 
-	// Push an event to the specified event queue, passed as a LuaRef &
+	// Push an event to the global event queue
 	template <typename... TArgs>
 	inline void Queue(std::string_view event, TArgs... args)
 	{
-		Queue(GetEventQueue(), event, args...);
+		if (ShouldQueue(event))
+			Queue(GetEventQueue(), event, args...);
 	}
 
-	// Push an event to the specified event queue, passed as a LuaRef &
+	// Push an event to the global event queue
 	inline void Queue(std::string_view event)
 	{
-		Queue(GetEventQueue(), event);
+		if (ShouldQueue(event))
+			Queue(GetEventQueue(), event);
+	}
+
+	// Push a high-frequency event to the global event queue. If an event with
+	// the same name and key is already waiting to be dispatched it is
+	// overwritten with these arguments instead, so handlers see it once per
+	// tick with the latest state.
+	template <typename... TArgs>
+	inline void QueueCoalesced(std::string_view event, CoalesceKey key, TArgs... args)
+	{
+		if (!ShouldQueue(event))
+			return;
+
+		ScopedTable ev(GetEventQueue().GetLua());
+		ev.Set("name", event);
+		ev.PushMultiple(args...);
+
+		PushCoalesced(event, key, ev);
 	}
 
 } // namespace LuaEvent
@@ -5,6 +5,8 @@
 #include "LuaTable.h"
 #include "galaxy/GalaxyGenerator.h"
 #include "galaxy/Galaxy.h"
+#include "galaxy/Sector.h"
+#include "profiler/Profiler.h"
 
 /*
  * Class: Galaxy
@@ -81,12 +83,177 @@ static int l_galaxy_get_star_system(lua_State *l)
 	return 1;
 }
 
+// the path's system, or a Lua error if it isn't one
+static const GalaxySpatialIndex::Entry &check_index_entry(lua_State *l, Galaxy *galaxy, const SystemPath *path)
+{
+	if (path->IsSectorPath())
+		luaL_error(l, "path argument does not refer to a system");
+	GalaxySpatialIndex &index = galaxy->GetSpatialIndex();
+	if (path->systemIndex >= index.GetSectorEntries(path->sectorX, path->sectorY, path->sectorZ).size())
+		luaL_error(l, "path argument refers to a system that doesn't exist");
+	return index.GetEntry(*path);
+}
+
+static GalaxySpatialIndex::Filter pull_index_filter(lua_State *l, Galaxy *galaxy, int idx)
+{
+	GalaxySpatialIndex::Filter filter;
+	if (lua_isnoneornil(l, idx))
+		return filter;
+	luaL_checktype(l, idx, LUA_TTABLE);
+
+	lua_getfield(l, idx, "inhabited");
+	filter.inhabitedOnly = lua_toboolean(l, -1);
+	lua_pop(l, 1);
+
+	lua_getfield(l, idx, "explored");
+	if (!lua_isnil(l, -1)) {
+		filter.exploredOnly = lua_toboolean(l, -1);
+		filter.unexploredOnly = !filter.exploredOnly;
+	}
+	lua_pop(l, 1);
+
+	lua_getfield(l, idx, "faction");
+	if (!lua_isnil(l, -1)) {
+		const Faction *faction = galaxy->GetFactions()->GetFaction(luaL_checkstring(l, -1));
+		if (!faction->IsValid())
+			luaL_error(l, "unknown faction '%s'", lua_tostring(l, -1));
+		filter.faction = faction->idx;
+	}
+	lua_pop(l, 1);
+	return filter;
+}
+
+/*
+ * Method: FindSystemsInRange
+ *
+ * Find the systems within a distance of a system, from the galaxy's
+ * spatial index rather than by generating each <StarSystem>
+ *
+ * > result = galaxy:FindSystemsInRange(path, range, filter)
+ *
+ * Parameters:
+ *
+ *   path - the <SystemPath> of the system to search around
+ *
+ *   range - distance from the system to search, in light years
+ *
+ *   filter - an optional table of criteria systems must meet:
+ *            inhabited - true for systems with a population only,
+ *            explored - true for explored systems only, false for
+ *                       unexplored systems only,
+ *            faction - the name of the faction systems must belong to
+ *
+ * Return:
+ *
+ *   result - a table of arrays, with one element per system found:
+ *            sectorX, sectorY, sectorZ, systemIndex - the system's path
+ *            distance - its distance from the system searched around
+ *            and count, the number of systems found. The system searched
+ *            around is included.
+ *
+ * Availability:
+ *
+ *   2024
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_galaxy_find_systems_in_range(lua_State *l)
+{
+	PROFILE_SCOPED()
+	auto galaxy = LuaObject<Galaxy>::CheckFromLua(1);
+	auto path = LuaObject<SystemPath>::CheckFromLua(2);
+	const float range = luaL_checknumber(l, 3);
+	const GalaxySpatialIndex::Filter filter = pull_index_filter(l, galaxy, 4);
+	const vector3f pos = check_index_entry(l, galaxy, path).pos;
+
+	std::vector<const GalaxySpatialIndex::Entry *> found;
+	std::vector<float> distances;
+	galaxy->GetSpatialIndex().FindInRadius(pos, range, filter, found, &distances);
+
+	const int count = int(found.size());
+	lua_createtable(l, 0, 6);
+	lua_pushinteger(l, count);
+	lua_setfield(l, -2, "count");
+
+	// arrays of numbers, so there's no garbage per system
+	const char *const fields[] = { "sectorX", "sectorY", "sectorZ", "systemIndex", "distance" };
+	for (int field = 0; field < int(COUNTOF(fields)); field++) {
+		lua_createtable(l, count, 0);
+		for (int i = 0; i < count; i++) {
+			const SystemPath &found_path = found[i]->path;
+			switch (field) {
+			case 0: lua_pushinteger(l, found_path.sectorX); break;
+			case 1: lua_pushinteger(l, found_path.sectorY); break;
+			case 2: lua_pushinteger(l, found_path.sectorZ); break;
+			case 3: lua_pushinteger(l, found_path.systemIndex); break;
+			default: lua_pushnumber(l, distances[i]); break;
+			}
+			lua_rawseti(l, -2, i + 1);
+		}
+		lua_setfield(l, -2, fields[field]);
+	}
+	return 1;
+}
+
+/*
+ * Method: FindNearestSystem
+ *
+ * Find the system nearest another that meets some criteria
+ *
+ * > nearest, distance = galaxy:FindNearestSystem(path, range, filter)
+ *
+ * Parameters:
+ *
+ *   path - the <SystemPath> of the system to search around
+ *
+ *   range - the furthest to search, in light years
+ *
+ *   filter - an optional table of criteria, as for <FindSystemsInRange>
+ *
+ * Return:
+ *
+ *   nearest - the <SystemPath> of the nearest matching system other than
+ *             path itself, or nil if there isn't one in range
+ *
+ *   distance - its distance from path, in light years
+ *
+ * Availability:
+ *
+ *   2024
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_galaxy_find_nearest_system(lua_State *l)
+{
+	PROFILE_SCOPED()
+	auto galaxy = LuaObject<Galaxy>::CheckFromLua(1);
+	auto path = LuaObject<SystemPath>::CheckFromLua(2);
+	const float range = luaL_checknumber(l, 3);
+	const GalaxySpatialIndex::Filter filter = pull_index_filter(l, galaxy, 4);
+	const vector3f pos = check_index_entry(l, galaxy, path).pos;
+
+	const GalaxySpatialIndex::Entry *nearest = galaxy->GetSpatialIndex().FindNearest(pos, range, filter, *path);
+	if (!nearest) {
+		lua_pushnil(l);
+		return 1;
+	}
+	LuaObject<SystemPath>::PushToLua(nearest->path);
+	lua_pushnumber(l, (nearest->pos - pos).Length());
+	return 2;
+}
+
 template <>
 void LuaObject<Galaxy>::RegisterClass()
 {
 	static const luaL_Reg l_methods[] = {
 		{ "GetSector", l_galaxy_get_sector },
 		{ "GetStarSystem", l_galaxy_get_star_system },
+		{ "FindSystemsInRange", l_galaxy_find_systems_in_range },
+		{ "FindNearestSystem", l_galaxy_find_nearest_system },
 		{ 0, 0 }
 	};
 
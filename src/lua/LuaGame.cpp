@@ -29,6 +29,23 @@
  * A global table that exposes a number of essential values relevant to the
  * current game.
  *
+ * Event: onGameSaved
+ *
+ * Triggered when a save started with Game.SaveGame(filename, true) has been
+ * written to disk.
+ *
+ * > local onGameSaved = function (filename, success) ... end
+ * > Event.Register("onGameSaved", onGameSaved)
+ *
+ * Parameters:
+ *
+ *   filename - the name the game was saved under
+ *
+ *   success - false if the save file could not be written
+ *
+ * Status:
+ *
+ *   experimental
  */
 
 /*
@@ -97,7 +114,10 @@ static int l_game_savegame_stats(lua_State *l)
 	const std::string filename = LuaPull<std::string>(l, 1);
 
 	try {
-		Json rootNode = Game::LoadGameToJson(filename);
+		// newer saves carry a header with everything needed here
+		Json rootNode = Game::LoadGameInfo(filename);
+		if (!rootNode.is_object())
+			rootNode = Game::LoadGameToJson(filename);
 
 		LuaTable t(l, 0, 3);
 
@@ -233,13 +253,21 @@ static int l_game_can_load_game(lua_State *l)
  *
  * Save the current game.
  *
- * > path = Game.SaveGame(filename)
+ * > path = Game.SaveGame(filename, async, delta)
  *
  * Parameters:
  *
  *   filename - Filename to save to. The file will be placed the 'savefiles'
  *              directory in the user's game directory.
  *
+ *   async - optional. If true, the game state is captured immediately but
+ *           the file is written in the background, and the onGameSaved
+ *           event is triggered once it is done. Defaults to false.
+ *
+ *   delta - optional. If true, only the parts of the game that changed since
+ *           the last full save under this name are written, which makes
+ *           frequent autosaves cheaper. Defaults to false.
+ *
  * Return:
  *
  *   path - the full path to the saved file (so it can be displayed)
@@ -259,11 +287,16 @@ static int l_game_save_game(lua_State *l)
 	}
 
 	const std::string filename(luaL_checkstring(l, 1));
+	const bool async = lua_toboolean(l, 2);
+	const bool delta = lua_toboolean(l, 3);
 	std::string path;
 
 	try {
 		path = FileSystem::JoinPathBelow(Pi::GetSaveDir(), filename);
-		Game::SaveGame(filename, Pi::game);
+		if (async)
+			Game::SaveGameAsync(filename, Pi::game, delta);
+		else
+			Game::SaveGame(filename, Pi::game, delta);
 		lua_pushlstring(l, path.c_str(), path.size());
 		return 1;
 	} catch (const CannotSaveInHyperspace &) {
@@ -3,10 +3,15 @@
 
 #include "LuaJson.h"
 #include "FileSystem.h"
+#include "JobQueue.h"
 #include "JsonUtils.h"
 #include "LuaObject.h"
 #include "LuaUtils.h"
 #include "Pi.h"
+#include "profiler/Profiler.h"
+
+#include <deque>
+#include <memory>
 
 /*
  * Interface: Json
@@ -55,6 +60,182 @@ static void _push_json_to_lua(lua_State *l, Json &obj)
 	}
 }
 
+// pushes a scalar value, or an empty table for an array or object
+static void _push_json_value(lua_State *l, const Json &obj)
+{
+	switch (obj.type()) {
+	case Json::value_t::string:
+		lua_pushstring(l, obj.get_ref<const std::string &>().c_str());
+		break;
+	case Json::value_t::boolean:
+		lua_pushboolean(l, obj.get<bool>());
+		break;
+	case Json::value_t::number_integer:
+	case Json::value_t::number_unsigned:
+		lua_pushinteger(l, obj);
+		break;
+	case Json::value_t::number_float:
+		lua_pushnumber(l, obj);
+		break;
+	case Json::value_t::array:
+	case Json::value_t::object:
+		lua_newtable(l);
+		break;
+	case Json::value_t::null:
+	default:
+		lua_pushnil(l);
+		break;
+	}
+}
+
+LuaJson::TableBuilder::TableBuilder(Json &&data) :
+	m_data(std::move(data)),
+	m_started(false)
+{
+}
+
+bool LuaJson::TableBuilder::Build(lua_State *l, size_t &budget)
+{
+	if (!m_started) {
+		m_started = true;
+		lua_checkstack(l, 1);
+		_push_json_value(l, m_data);
+		if (m_data.is_structured())
+			m_frames.push_back({ &m_data, m_data.cbegin(), 0 });
+	}
+
+	// the stack holds each unfinished table, with the key it will be stored
+	// under in its parent between them
+	while (!m_frames.empty() && budget > 0) {
+		Frame &frame = m_frames.back();
+		if (frame.it == frame.value->cend()) {
+			m_frames.pop_back();
+			if (!m_frames.empty())
+				lua_rawset(l, -3);
+			continue;
+		}
+
+		lua_checkstack(l, 3);
+		if (frame.value->is_array())
+			lua_pushinteger(l, ++frame.index);
+		else
+			lua_pushstring(l, frame.it.key().c_str());
+
+		const Json &child = *frame.it;
+		++frame.it;
+		_push_json_value(l, child);
+		if (child.is_structured())
+			m_frames.push_back({ &child, child.cbegin(), 0 });
+		else
+			lua_rawset(l, -3);
+		--budget;
+	}
+
+	return m_frames.empty();
+}
+
+namespace {
+	// values added to tables for asynchronous loads each frame, across all
+	// of them; small enough to stay well inside a frame
+	static constexpr size_t VALUES_PER_UPDATE = 20000;
+
+	// holds, by load id, the callback while the file is parsed and then the
+	// thread whose stack has the callback and the unfinished value
+	static const char PENDING_LOADS[] = "LuaJsonPendingLoads";
+
+	struct PendingTable {
+		int id;
+		lua_State *thread;
+		LuaJson::TableBuilder builder;
+	};
+
+	// main thread only
+	std::unique_ptr<JobSet> s_jobs;
+	std::deque<std::unique_ptr<PendingTable>> s_pendingTables;
+	int s_lastLoad = 0;
+
+	void PushPendingLoads(lua_State *l)
+	{
+		lua_getfield(l, LUA_REGISTRYINDEX, PENDING_LOADS);
+		if (lua_isnil(l, -1)) {
+			lua_pop(l, 1);
+			lua_newtable(l);
+			lua_pushvalue(l, -1);
+			lua_setfield(l, LUA_REGISTRYINDEX, PENDING_LOADS);
+		}
+	}
+
+	class LoadJob : public Job {
+	public:
+		LoadJob(int id, const std::string &filename, bool saveFile) :
+			m_id(id),
+			m_filename(filename),
+			m_saveFile(saveFile)
+		{}
+
+		void OnRun() override
+		{
+			PROFILE_SCOPED()
+			if (m_saveFile)
+				m_data = JsonUtils::LoadJsonSaveFile(FileSystem::JoinPathBelow(Pi::SAVE_DIR_NAME, m_filename), FileSystem::userFiles);
+			else
+				m_data = JsonUtils::LoadJsonDataFile(m_filename);
+		}
+
+		void OnFinish() override
+		{
+			lua_State *l = Lua::manager->GetLuaState();
+			LUA_DEBUG_START(l);
+
+			PushPendingLoads(l);
+			lua_rawgeti(l, -1, m_id);
+
+			if (m_data.is_null()) {
+				lua_pushnil(l);
+				lua_rawseti(l, -3, m_id);
+				lua_remove(l, -2);
+				lua_pushnil(l);
+				lua_pushfstring(l, "Error loading JSON file %s.", m_filename.c_str());
+				pi_lua_protected_call(l, 2, 0);
+			} else {
+				// the thread replaces the callback, which moves to its stack
+				lua_State *thread = lua_newthread(l);
+				lua_insert(l, -2);
+				lua_xmove(l, thread, 1);
+				lua_rawseti(l, -2, m_id);
+				lua_pop(l, 1);
+				s_pendingTables.emplace_back(new PendingTable{ m_id, thread, LuaJson::TableBuilder(std::move(m_data)) });
+			}
+
+			LUA_DEBUG_END(l, 0);
+		}
+
+	private:
+		int m_id;
+		std::string m_filename;
+		bool m_saveFile;
+		Json m_data;
+	};
+
+	int StartLoad(lua_State *l, bool saveFile)
+	{
+		const std::string filename = luaL_checkstring(l, 1);
+		luaL_checktype(l, 2, LUA_TFUNCTION);
+
+		PushPendingLoads(l);
+		const int id = ++s_lastLoad;
+		lua_pushvalue(l, 2);
+		lua_rawseti(l, -2, id);
+		lua_pop(l, 1);
+
+		if (!s_jobs)
+			s_jobs.reset(new JobSet(Pi::GetAsyncJobQueue()));
+		s_jobs->Order(new LoadJob(id, filename, saveFile));
+
+		return 0;
+	}
+} // namespace
+
 /*
  * Function: LoadJson
  *
@@ -110,6 +291,105 @@ static int l_load_save_file(lua_State *l)
 	return 1;
 }
 
+/*
+ * Function: LoadJsonAsync
+ *
+ * Load a JSON file from the game's data sources as <LoadJson> does, reading
+ * and parsing it on a worker thread. The table is built over as many frames
+ * as it needs, then passed to the callback.
+ *
+ * > Json.LoadJsonAsync(fileName, function (doc, err) ... end)
+ *
+ * Parameters:
+ *
+ *   fileName - string
+ *
+ *   callback - function, called with the document, or with nil and an error
+ *              message if the file could not be loaded
+ *
+ * Availability:
+ *
+ *   2024
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_load_json_async(lua_State *l)
+{
+	return StartLoad(l, false);
+}
+
+/*
+ * Function: LoadSaveFileAsync
+ *
+ * Load a saved game as <LoadSaveFile> does, reading and decoding it on a
+ * worker thread. The table is built over as many frames as it needs, then
+ * passed to the callback.
+ *
+ * > Json.LoadSaveFileAsync(fileName, function (gameDoc, err) ... end)
+ *
+ * Parameters:
+ *
+ *   fileName - string, File will be loaded from the 'savefiles' directory in the user's game directory.
+ *
+ *   callback - function, called with the document, or with nil and an error
+ *              message if the file could not be loaded
+ *
+ * Availability:
+ *
+ *   2024
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_load_save_file_async(lua_State *l)
+{
+	return StartLoad(l, true);
+}
+
+void LuaJson::Update()
+{
+	if (s_pendingTables.empty())
+		return;
+
+	PROFILE_SCOPED()
+	lua_State *l = Lua::manager->GetLuaState();
+	LUA_DEBUG_START(l);
+
+	size_t budget = VALUES_PER_UPDATE;
+	while (!s_pendingTables.empty() && budget > 0) {
+		PendingTable &pending = *s_pendingTables.front();
+		if (!pending.builder.Build(pending.thread, budget))
+			break;
+
+		// the thread's stack is now the callback and the finished value;
+		// they're moved off before the thread is released
+		lua_xmove(pending.thread, l, 2);
+		PushPendingLoads(l);
+		lua_pushnil(l);
+		lua_rawseti(l, -2, pending.id);
+		lua_pop(l, 1);
+		s_pendingTables.pop_front();
+
+		pi_lua_protected_call(l, 1, 0);
+	}
+
+	LUA_DEBUG_END(l, 0);
+}
+
+void LuaJson::Uninit()
+{
+	// destroying the handles cancels the jobs
+	s_jobs.reset();
+	s_pendingTables.clear();
+
+	lua_State *l = Lua::manager->GetLuaState();
+	lua_pushnil(l);
+	lua_setfield(l, LUA_REGISTRYINDEX, PENDING_LOADS);
+}
+
 void LuaJson::Register()
 {
 	lua_State *l = Lua::manager->GetLuaState();
@@ -119,6 +399,8 @@ void LuaJson::Register()
 	static const luaL_Reg l_methods[] = {
 		{ "LoadJson", l_load_json },
 		{ "LoadSaveFile", l_load_save_file },
+		{ "LoadJsonAsync", l_load_json_async },
+		{ "LoadSaveFileAsync", l_load_save_file_async },
 		{ NULL, NULL }
 	};
 
@@ -4,8 +4,46 @@
 #ifndef PI_LUA_JSON_H
 #define PI_LUA_JSON_H
 
+#include "Json.h"
+
+#include <vector>
+
+struct lua_State;
+
 namespace LuaJson {
 	void Register();
-}
+
+	// Continues building the tables for asynchronous loads; called once
+	// per frame
+	void Update();
+
+	// Cancels any loads still in progress, so their callbacks are never made
+	void Uninit();
+
+	// Converts a Json document to a Lua value a piece at a time, so a large
+	// document can be spread over several frames.
+	class TableBuilder {
+	public:
+		explicit TableBuilder(Json &&data);
+
+		// Adds up to budget values to the Lua value being built, reducing
+		// budget by the number added. The unfinished value is kept on l's
+		// stack, so every call must pass the same state with nothing pushed
+		// since the last one. Returns true once the value is complete and on
+		// top of the stack.
+		bool Build(lua_State *l, size_t &budget);
+
+	private:
+		struct Frame {
+			const Json *value;
+			Json::const_iterator it;
+			size_t index;
+		};
+
+		Json m_data;
+		std::vector<Frame> m_frames;
+		bool m_started;
+	};
+} // namespace LuaJson
 
 #endif
@@ -5,19 +5,26 @@
 #include "FileSystem.h"
 #include "utils.h"
 
+#include "profiler/Profiler.h"
+
+#include <algorithm>
 #include <cstdlib>
 
 bool instantiated = false;
 
 LuaManager::LuaManager() :
-	m_lua(0)
+	m_lua(0),
+	m_gcMode(GCMode::Incremental),
+	m_frameBudgetedGC(false),
+	m_gcMsPerKB(0.001),
+	m_gcLastHeapKB(0)
 {
 	if (instantiated) {
 		Output("Can't instantiate more than one LuaManager");
 		abort();
 	}
 
-	m_lua = luaL_newstate();
+	m_lua = lua_newstate(&LuaAllocator::Alloc, &m_allocator);
 	pi_lua_open_standard_base(m_lua);
 	lua_atpanic(m_lua, pi_lua_panic);
 
@@ -35,6 +42,7 @@ LuaManager::LuaManager() :
 
 LuaManager::~LuaManager()
 {
+	m_profiler.Stop();
 	lua_close(m_lua);
 
 	instantiated = false;
@@ -51,3 +59,86 @@ void LuaManager::CollectGarbage()
 {
 	lua_gc(m_lua, LUA_GCCOLLECT, 0);
 }
+
+void LuaManager::SetGCMode(GCMode mode)
+{
+	lua_gc(m_lua, mode == GCMode::Generational ? LUA_GCGEN : LUA_GCINC, 0);
+	m_gcMode = mode;
+}
+
+void LuaManager::SetGCTuning(int pause, int stepMul)
+{
+	lua_gc(m_lua, LUA_GCSETPAUSE, pause);
+	lua_gc(m_lua, LUA_GCSETSTEPMUL, stepMul);
+}
+
+void LuaManager::SetGCRunning(bool running)
+{
+	lua_gc(m_lua, running ? LUA_GCRESTART : LUA_GCSTOP, 0);
+}
+
+bool LuaManager::StepGarbageCollector(int stepKB)
+{
+	return lua_gc(m_lua, LUA_GCSTEP, stepKB) != 0;
+}
+
+void LuaManager::SetFrameBudgetedGC(bool enabled)
+{
+	m_frameBudgetedGC = enabled;
+	SetGCRunning(!enabled);
+
+	m_gcLastHeapKB = lua_gc(m_lua, LUA_GCCOUNT, 0);
+	m_gcFrameStats = {};
+	m_gcFrameStats.heapKB = m_gcLastHeapKB;
+	m_gcFrameStats.heapAfterCycleKB = m_gcLastHeapKB;
+}
+
+void LuaManager::StepGarbageCollectorForFrame(double budgetMs)
+{
+	PROFILE_SCOPED()
+
+	// extra growth tolerated above twice the live heap before forcing progress
+	static constexpr int HEADROOM_KB = 4096;
+	static constexpr int MAX_STEP_KB = 8192;
+
+	const int heapKB = lua_gc(m_lua, LUA_GCCOUNT, 0);
+	const int growthKB = std::max(heapKB - m_gcLastHeapKB, 0);
+
+	const bool overdue = heapKB > m_gcFrameStats.heapAfterCycleKB * 2 + HEADROOM_KB;
+	// to gain on the mutator the collector must traverse more than was allocated
+	const int requiredKB = overdue ? growthKB * 2 : 0;
+
+	// aim for about four steps within the budget
+	const int stepKB = std::clamp(int(budgetMs * 0.25 / m_gcMsPerKB), 1, MAX_STEP_KB);
+
+	Profiler::Clock clock{};
+	clock.Start();
+	int doneKB = 0;
+	double elapsedMs = 0.0;
+	while (true) {
+		const bool cycleFinished = lua_gc(m_lua, LUA_GCSTEP, stepKB) != 0;
+		doneKB += stepKB;
+		clock.SoftStop();
+		elapsedMs = clock.milliseconds();
+
+		if (cycleFinished) {
+			m_gcFrameStats.heapAfterCycleKB = lua_gc(m_lua, LUA_GCCOUNT, 0);
+			m_gcFrameStats.cycles++;
+			break;
+		}
+
+		if (elapsedMs >= budgetMs && doneKB >= requiredKB)
+			break;
+	}
+
+	// smooth the speed estimate so one slow step (e.g. a big table) doesn't
+	// shrink the next frames' steps too much
+	const double msPerKB = std::max(elapsedMs / doneKB, 1e-6);
+	m_gcMsPerKB = m_gcMsPerKB * 0.8 + msPerKB * 0.2;
+
+	m_gcLastHeapKB = lua_gc(m_lua, LUA_GCCOUNT, 0);
+	m_gcFrameStats.stepMs = elapsedMs;
+	m_gcFrameStats.stepKB = doneKB;
+	m_gcFrameStats.heapKB = m_gcLastHeapKB;
+	m_gcFrameStats.overdue = overdue;
+}
@@ -4,6 +4,8 @@
 #ifndef _LUAMANAGER_H
 #define _LUAMANAGER_H
 
+#include "LuaAllocator.h"
+#include "LuaProfiler.h"
 #include "LuaUtils.h"
 
 class LuaManager {
@@ -15,11 +17,66 @@ public:
 	size_t GetMemoryUsage() const;
 	void CollectGarbage();
 
+	enum class GCMode {
+		Incremental,
+		Generational
+	};
+
+	void SetGCMode(GCMode mode);
+	GCMode GetGCMode() const { return m_gcMode; }
+
+	// Incremental collector tuning, see the Lua manual for details.
+	// pause: heap growth (in percent) before a new cycle starts, 200 by default.
+	// stepMul: collector speed relative to allocation, 200 by default.
+	void SetGCTuning(int pause, int stepMul);
+
+	// Stop or restart automatic collection, for callers that drive the
+	// collector themselves with StepGarbageCollector
+	void SetGCRunning(bool running);
+
+	// Run one incremental step of about stepKB kilobytes of work, or a
+	// basic step if stepKB is 0. Returns true if the step finished a cycle.
+	bool StepGarbageCollector(int stepKB);
+
+	struct GCFrameStats {
+		double stepMs = 0.0;   // time spent collecting in the last frame
+		int stepKB = 0;        // work requested from the collector in the last frame
+		int heapKB = 0;        // heap size after the last frame's step
+		int heapAfterCycleKB = 0;
+		uint32_t cycles = 0;   // cycles completed by frame steps
+		bool overdue = false;  // the last step ran over budget to catch up
+	};
+
+	// In frame-budgeted mode automatic collection is stopped, and
+	// StepGarbageCollectorForFrame must be called once per frame instead.
+	void SetFrameBudgetedGC(bool enabled);
+	bool IsFrameBudgetedGC() const { return m_frameBudgetedGC; }
+
+	// Run the incremental collector for about budgetMs. Step sizes adapt to
+	// the measured collector speed. If the heap has grown well past its size
+	// after the last completed cycle, the step runs over budget until it has
+	// caught up with this frame's allocations.
+	void StepGarbageCollectorForFrame(double budgetMs);
+	const GCFrameStats &GetGCFrameStats() const { return m_gcFrameStats; }
+
+	const LuaAllocator::Stats &GetAllocatorStats() const { return m_allocator.GetStats(); }
+
+	LuaProfiler &GetProfiler() { return m_profiler; }
+
 private:
 	LuaManager(const LuaManager &);
 	LuaManager &operator=(const LuaManager &) = delete;
 
+	// declared before m_lua so it is destroyed after the state is closed
+	LuaAllocator m_allocator;
 	lua_State *m_lua;
+	LuaProfiler m_profiler;
+	GCMode m_gcMode;
+
+	bool m_frameBudgetedGC;
+	double m_gcMsPerKB;
+	int m_gcLastHeapKB;
+	GCFrameStats m_gcFrameStats;
 };
 
 #endif
@@ -112,16 +112,8 @@ static int l_index(lua_State *l)
 	// normal userdata object
 	// first check properties. we don't need to drill through lua if the
 	// property is already available
-	if (lua_isstring(l, 2)) {
-		PropertyMap *map = LuaObjectBase::GetPropertiesFromObject(l, 1);
-		if (map) {
-			auto &prop = map->Get(LuaPull<std::string_view>(l, 2));
-			if (!prop.is_null()) {
-				LuaPush(l, prop);
-				return 1;
-			}
-		}
-	}
+	if (lua_isstring(l, 2) && LuaObjectBase::PushPropertyFromObject(l, 1, 2))
+		return 1;
 
 	// push the metatype registry here for later
 	lua_getfield(l, LUA_REGISTRYINDEX, "LuaMetaTypes");
@@ -246,6 +246,72 @@ PropertyMap *LuaObjectBase::GetPropertiesFromObject(lua_State *l, int object)
 	return ret;
 }
 
+// addresses used as uservalue keys, which are cheaper than string keys and
+// skipped by component serialization
+static const char s_propertyCacheKey = 0;
+static const char s_propertyVersionKey = 0;
+
+bool LuaObjectBase::PushPropertyFromObject(lua_State *l, int object, int key)
+{
+	if (!lua_isuserdata(l, object))
+		return false;
+
+	object = lua_absindex(l, object);
+	key = lua_absindex(l, key);
+
+	lua_getuservalue(l, object); // uservalue
+	if (lua_isnil(l, -1)) {
+		lua_pop(l, 1);
+		return false;
+	}
+
+	lua_getfield(l, -1, "__properties");
+	if (!lua_islightuserdata(l, -1)) {
+		lua_pop(l, 2);
+		return false;
+	}
+	const PropertyMap *map = static_cast<PropertyMap *>(lua_touserdata(l, -1));
+	lua_pop(l, 1);
+
+	// start a new cache when the map has changed since the last one was made
+	lua_rawgetp(l, -1, &s_propertyVersionKey);
+	const bool current = lua_isnumber(l, -1) && lua_tounsigned(l, -1) == map->GetVersion();
+	lua_pop(l, 1);
+	lua_rawgetp(l, -1, &s_propertyCacheKey); // uservalue, cache
+	if (!current || !lua_istable(l, -1)) {
+		lua_pop(l, 1);
+		lua_newtable(l);
+		lua_pushvalue(l, -1);
+		lua_rawsetp(l, -3, &s_propertyCacheKey);
+		lua_pushunsigned(l, map->GetVersion());
+		lua_rawsetp(l, -3, &s_propertyVersionKey);
+	}
+
+	lua_pushvalue(l, key);
+	lua_rawget(l, -2); // uservalue, cache, value
+	if (lua_isnil(l, -1)) {
+		lua_pop(l, 1);
+
+		const Property &prop = map->Get(LuaPull<std::string_view>(l, key));
+		if (prop.is_null()) {
+			lua_pop(l, 2);
+			return false;
+		}
+
+		LuaPush(l, prop);
+		// vectors and colors are mutable userdata, so each read needs a copy
+		if (prop.is_bool() || prop.is_number() || prop.is_string() || prop.is_map()) {
+			lua_pushvalue(l, key);
+			lua_pushvalue(l, -2);
+			lua_rawset(l, -4);
+		}
+	}
+
+	lua_replace(l, -3); // value, cache
+	lua_pop(l, 1);
+	return true;
+}
+
 static void register_functions(lua_State *l, const luaL_Reg *methods, bool protect)
 {
 	for (const luaL_Reg *m = methods; m->name; m++) {
@@ -121,6 +121,12 @@ public:
 	// its PropertyMap. Returns nullptr on failure.
 	static PropertyMap *GetPropertiesFromObject(lua_State *l, int object);
 
+	// Pushes the named property of the object at the stack position, if it
+	// is a PropertiedObject and has the property; returns false otherwise,
+	// leaving the stack unchanged. Immutable values are cached in a table in
+	// the object's uservalue, which is dropped whenever the map changes.
+	static bool PushPropertyFromObject(lua_State *l, int object, int key);
+
 	// register a serializer pair for a given type
 	static void RegisterSerializer(const char *type, SerializerPair pair);
 
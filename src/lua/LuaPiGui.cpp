@@ -23,6 +23,7 @@
 #include "imgui/backends/imgui_impl_sdl2.h"
 #include "imgui/imgui.h"
 #include "imgui/imgui_internal.h"
+#include "pigui/CachedPanel.h"
 #include "pigui/LuaFlags.h"
 #include "pigui/LuaPiGui.h"
 #include "pigui/PiGui.h"
@@ -103,7 +104,7 @@ static Type parse_imgui_flags(lua_State *l, int index, LuaFlags<Type> &lookupTab
 }
 
 template <typename Type>
-static Type parse_imgui_enum(lua_State *l, int index, LuaFlags<Type> lookupTable)
+static Type parse_imgui_enum(lua_State *l, int index, LuaFlags<Type> &lookupTable)
 {
 	if (lua_isstring(l, index))
 		return lookupTable.LookupEnum(l, index);
@@ -1080,6 +1081,104 @@ static int l_pigui_add_circle_filled(lua_State *l)
 	return 0;
 }
 
+// Read n numbers starting at (1-based) position first of the flat number
+// array at index. Batched draw calls take their primitives this way so a
+// whole HUD layer costs one Lua call and no temporary userdata.
+static inline void read_flat_numbers(lua_State *l, int index, size_t first, float *out, int n)
+{
+	for (int i = 0; i < n; i++) {
+		lua_rawgeti(l, index, first + i);
+		out[i] = lua_tonumber(l, -1);
+		lua_pop(l, 1);
+	}
+}
+
+/*
+ * Function: AddLines
+ *
+ * Draw many lines of the same color and thickness in one call
+ *
+ * > ui.addLines(coords, color, thickness)
+ *
+ * Parameters:
+ *
+ *   coords - a flat array of numbers, four per line: { x1, y1, x2, y2, ... }
+ */
+static int l_pigui_add_lines(lua_State *l)
+{
+	PROFILE_SCOPED()
+	luaL_checktype(l, 1, LUA_TTABLE);
+	ImDrawList *draw_list = ImGui::GetWindowDrawList();
+	ImU32 color = ImGui::GetColorU32(LuaPull<ImColor>(l, 2).Value);
+	float thickness = LuaPull<double>(l, 3);
+
+	const size_t count = lua_rawlen(l, 1) / 4;
+	for (size_t i = 0; i < count; i++) {
+		float v[4];
+		read_flat_numbers(l, 1, i * 4 + 1, v, 4);
+		draw_list->AddLine(ImVec2(v[0], v[1]), ImVec2(v[2], v[3]), color, thickness);
+	}
+	return 0;
+}
+
+/*
+ * Function: AddCirclesFilled
+ *
+ * Draw many filled circles of the same size and color in one call
+ *
+ * > ui.addCirclesFilled(coords, radius, color, segments)
+ *
+ * Parameters:
+ *
+ *   coords - a flat array of numbers, two per circle center: { x1, y1, ... }
+ */
+static int l_pigui_add_circles_filled(lua_State *l)
+{
+	PROFILE_SCOPED()
+	luaL_checktype(l, 1, LUA_TTABLE);
+	ImDrawList *draw_list = ImGui::GetWindowDrawList();
+	float radius = LuaPull<double>(l, 2);
+	ImU32 color = ImGui::GetColorU32(LuaPull<ImColor>(l, 3).Value);
+	int segments = LuaPull<int>(l, 4);
+
+	const size_t count = lua_rawlen(l, 1) / 2;
+	for (size_t i = 0; i < count; i++) {
+		float v[2];
+		read_flat_numbers(l, 1, i * 2 + 1, v, 2);
+		draw_list->AddCircleFilled(ImVec2(v[0], v[1]), radius, color, segments);
+	}
+	return 0;
+}
+
+/*
+ * Function: AddRectsFilled
+ *
+ * Draw many filled rectangles of the same color in one call
+ *
+ * > ui.addRectsFilled(coords, color, rounding)
+ *
+ * Parameters:
+ *
+ *   coords - a flat array of numbers, four per rectangle giving the min and
+ *            max corners: { x1, y1, x2, y2, ... }
+ */
+static int l_pigui_add_rects_filled(lua_State *l)
+{
+	PROFILE_SCOPED()
+	luaL_checktype(l, 1, LUA_TTABLE);
+	ImDrawList *draw_list = ImGui::GetWindowDrawList();
+	ImU32 color = ImGui::GetColorU32(LuaPull<ImColor>(l, 2).Value);
+	float rounding = LuaPull<double>(l, 3);
+
+	const size_t count = lua_rawlen(l, 1) / 4;
+	for (size_t i = 0; i < count; i++) {
+		float v[4];
+		read_flat_numbers(l, 1, i * 4 + 1, v, 4);
+		draw_list->AddRectFilled(ImVec2(v[0], v[1]), ImVec2(v[2], v[3]), color, rounding);
+	}
+	return 0;
+}
+
 static int l_pigui_path_arc_to(lua_State *l)
 {
 	PROFILE_SCOPED()
@@ -1765,6 +1864,35 @@ static int l_pigui_end_child(lua_State *l)
 	return 0;
 }
 
+// Returns true if the caller must draw the child's contents this frame; call
+// EndCachedChild either way. See pigui/CachedPanel.h.
+static int l_pigui_begin_cached_child(lua_State *l)
+{
+	PROFILE_SCOPED()
+	std::string id = LuaPull<std::string>(l, 1);
+	const vector2d v1 = LuaPull<vector2d>(l, 2);
+
+	ImVec2 size(v1.x, v1.y);
+	ImGuiWindowFlags theflags = LuaPull<ImGuiWindowFlags_>(l, 3);
+	bool dirty = LuaPull<bool>(l, 4, false);
+
+	LuaPush(l, PiGui::BeginCachedChild(id.c_str(), size, theflags, dirty));
+	return 1;
+}
+
+static int l_pigui_end_cached_child(lua_State *l)
+{
+	PROFILE_SCOPED()
+	PiGui::EndCachedChild();
+	return 0;
+}
+
+static int l_pigui_clear_cached_children(lua_State *l)
+{
+	PiGui::ClearCachedChildren();
+	return 0;
+}
+
 static int l_pigui_is_item_hovered(lua_State *l)
 {
 	PROFILE_SCOPED()
@@ -3285,6 +3413,9 @@ void LuaObject<PiGui::Instance>::RegisterClass()
 		{ "AddCircle", l_pigui_add_circle },
 		{ "AddCircleFilled", l_pigui_add_circle_filled },
 		{ "AddLine", l_pigui_add_line },
+		{ "AddLines", l_pigui_add_lines },
+		{ "AddCirclesFilled", l_pigui_add_circles_filled },
+		{ "AddRectsFilled", l_pigui_add_rects_filled },
 		{ "AddText", l_pigui_add_text },
 		{ "AddTriangle", l_pigui_add_triangle },
 		{ "AddTriangleFilled", l_pigui_add_triangle_filled },
@@ -3340,6 +3471,9 @@ void LuaObject<PiGui::Instance>::RegisterClass()
 		{ "NewLine", l_pigui_newline },
 		{ "BeginChild", l_pigui_begin_child },
 		{ "EndChild", l_pigui_end_child },
+		{ "BeginCachedChild", l_pigui_begin_cached_child },
+		{ "EndCachedChild", l_pigui_end_cached_child },
+		{ "ClearCachedChildren", l_pigui_clear_cached_children },
 		{ "PushFont", l_pigui_push_font },
 		{ "PopFont", l_pigui_pop_font },
 		{ "CalcTextSize", l_pigui_calc_text_size },
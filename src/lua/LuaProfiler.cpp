@@ -0,0 +1,187 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "LuaProfiler.h"
+
+#include "FileSystem.h"
+#include "core/Log.h"
+
+#include <fmt/format.h>
+#include <lua.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <map>
+
+// lua_sethook takes no userdata, and there is only one Lua state
+static LuaProfiler *s_activeProfiler = nullptr;
+
+LuaProfiler::~LuaProfiler()
+{
+	Stop();
+}
+
+void LuaProfiler::Start(lua_State *l, int instructionInterval)
+{
+	if (IsRunning())
+		return;
+
+	assert(s_activeProfiler == nullptr);
+	s_activeProfiler = this;
+	m_lua = l;
+
+	m_origAlloc = lua_getallocf(l, &m_origAllocUd);
+	lua_setallocf(l, &LuaProfiler::Alloc, this);
+
+	m_lastSample = clock::now();
+	lua_sethook(l, &LuaProfiler::Hook, LUA_MASKCOUNT, std::max(instructionInterval, 1));
+}
+
+void LuaProfiler::Stop()
+{
+	if (!IsRunning())
+		return;
+
+	lua_sethook(m_lua, nullptr, 0, 0);
+	// blocks from either allocator can be freed by the other; ours only counts
+	lua_setallocf(m_lua, m_origAlloc, m_origAllocUd);
+
+	m_lua = nullptr;
+	s_activeProfiler = nullptr;
+}
+
+void LuaProfiler::Reset()
+{
+	m_functions.clear();
+	m_gc = {};
+	m_totalSamples = 0;
+	m_totalTimeMs = 0.0;
+	m_pendingAllocBytes = 0;
+	m_pendingAllocCount = 0;
+	m_lastSample = clock::now();
+}
+
+void LuaProfiler::Hook(lua_State *l, lua_Debug *ar)
+{
+	if (s_activeProfiler && ar->event == LUA_HOOKCOUNT)
+		s_activeProfiler->Sample(l, ar);
+}
+
+void LuaProfiler::Sample(lua_State *l, lua_Debug *ar)
+{
+	const clock::time_point now = clock::now();
+	const double gapMs = std::chrono::duration<double, std::milli>(now - m_lastSample).count();
+	m_lastSample = now;
+
+	if (!lua_getinfo(l, "nS", ar))
+		return;
+
+	std::string key = fmt::format("{}:{}", ar->short_src, ar->linedefined);
+	auto iter = m_functions.find(key);
+	if (iter == m_functions.end()) {
+		FunctionStats stats;
+		stats.name = ar->name ? ar->name : (ar->what && ar->what[0] == 'm' ? "(main chunk)" : "(anonymous)");
+		stats.source = ar->short_src;
+		stats.line = ar->linedefined;
+		iter = m_functions.emplace(std::move(key), std::move(stats)).first;
+	}
+
+	FunctionStats &stats = iter->second;
+	stats.samples++;
+	stats.allocBytes += m_pendingAllocBytes;
+	stats.allocCount += m_pendingAllocCount;
+	m_pendingAllocBytes = 0;
+	m_pendingAllocCount = 0;
+	m_totalSamples++;
+
+	if (gapMs <= MAX_SAMPLE_GAP_MS) {
+		stats.timeMs += gapMs;
+		m_totalTimeMs += gapMs;
+	}
+}
+
+void *LuaProfiler::Alloc(void *ud, void *ptr, size_t osize, size_t nsize)
+{
+	LuaProfiler *self = static_cast<LuaProfiler *>(ud);
+
+	// for a new block osize holds the object type, not a size
+	if (ptr == nullptr)
+		osize = 0;
+
+	if (nsize > osize) {
+		self->m_gc.allocBytes += nsize - osize;
+		self->m_gc.allocCount++;
+		self->m_pendingAllocBytes += nsize - osize;
+		self->m_pendingAllocCount++;
+	} else if (nsize < osize) {
+		self->m_gc.freeBytes += osize - nsize;
+		if (nsize == 0)
+			self->m_gc.freeCount++;
+	}
+
+	return self->m_origAlloc(self->m_origAllocUd, ptr, osize, nsize);
+}
+
+static bool sort_by_time(const LuaProfiler::FunctionStats &a, const LuaProfiler::FunctionStats &b)
+{
+	if (a.timeMs != b.timeMs)
+		return a.timeMs > b.timeMs;
+	return a.samples > b.samples;
+}
+
+std::vector<LuaProfiler::FunctionStats> LuaProfiler::GetFunctionStats() const
+{
+	std::vector<FunctionStats> out;
+	out.reserve(m_functions.size());
+	for (const auto &entry : m_functions)
+		out.push_back(entry.second);
+
+	std::sort(out.begin(), out.end(), sort_by_time);
+	return out;
+}
+
+std::vector<LuaProfiler::FunctionStats> LuaProfiler::GetFileStats() const
+{
+	std::map<std::string, FunctionStats> files;
+	for (const auto &entry : m_functions) {
+		const FunctionStats &fn = entry.second;
+		FunctionStats &file = files[fn.source];
+		file.source = fn.source;
+		file.samples += fn.samples;
+		file.timeMs += fn.timeMs;
+		file.allocBytes += fn.allocBytes;
+		file.allocCount += fn.allocCount;
+	}
+
+	std::vector<FunctionStats> out;
+	out.reserve(files.size());
+	for (auto &entry : files)
+		out.push_back(std::move(entry.second));
+
+	std::sort(out.begin(), out.end(), sort_by_time);
+	return out;
+}
+
+bool LuaProfiler::DumpToFile(const std::string &filename) const
+{
+	FILE *f = FileSystem::userFiles.OpenWriteStream(filename, FileSystem::FileSourceFS::WRITE_TEXT);
+	if (!f) {
+		Log::Warning("Could not open {} to write the Lua profile", filename);
+		return false;
+	}
+
+	fmt::print(f, "# {} samples, {:.3f} ms, {} bytes in {} allocations, {} bytes in {} frees\n",
+		m_totalSamples, m_totalTimeMs, m_gc.allocBytes, m_gc.allocCount, m_gc.freeBytes, m_gc.freeCount);
+
+	fmt::print(f, "\n# functions\nname\tsource\tline\tsamples\ttime_ms\talloc_bytes\talloc_count\n");
+	for (const FunctionStats &fn : GetFunctionStats())
+		fmt::print(f, "{}\t{}\t{}\t{}\t{:.3f}\t{}\t{}\n", fn.name, fn.source, fn.line, fn.samples, fn.timeMs, fn.allocBytes, fn.allocCount);
+
+	fmt::print(f, "\n# files\nsource\tsamples\ttime_ms\talloc_bytes\talloc_count\n");
+	for (const FunctionStats &file : GetFileStats())
+		fmt::print(f, "{}\t{}\t{:.3f}\t{}\t{}\n", file.source, file.samples, file.timeMs, file.allocBytes, file.allocCount);
+
+	fclose(f);
+	return true;
+}
@@ -0,0 +1,100 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct lua_State;
+struct lua_Debug;
+
+/*
+ * Sampling profiler for Lua code.
+ *
+ * While running, a count hook fires every N VM instructions and charges the
+ * function executing at that moment with one sample, the wall-clock time
+ * since the previous sample and the memory Lua allocated since then. Gaps
+ * longer than MAX_SAMPLE_GAP are assumed to have been spent outside of Lua
+ * and are not charged to anyone.
+ *
+ * The hook and the counting allocator are only installed while the profiler
+ * runs, so it costs nothing when stopped.
+ */
+class LuaProfiler {
+public:
+	static constexpr int DEFAULT_INTERVAL = 1000;
+	static constexpr double MAX_SAMPLE_GAP_MS = 1.0;
+
+	struct FunctionStats {
+		std::string name;
+		std::string source;
+		int line = 0;
+		uint64_t samples = 0;
+		double timeMs = 0.0;
+		uint64_t allocBytes = 0;
+		uint64_t allocCount = 0;
+	};
+
+	struct GCStats {
+		uint64_t allocBytes = 0;
+		uint64_t allocCount = 0;
+		uint64_t freeBytes = 0;
+		uint64_t freeCount = 0;
+	};
+
+	LuaProfiler() = default;
+	~LuaProfiler();
+
+	LuaProfiler(const LuaProfiler &) = delete;
+	LuaProfiler &operator=(const LuaProfiler &) = delete;
+
+	void Start(lua_State *l, int instructionInterval = DEFAULT_INTERVAL);
+	void Stop();
+	bool IsRunning() const { return m_lua != nullptr; }
+
+	// Forget everything recorded so far
+	void Reset();
+
+	// Per-function stats, sorted by descending time
+	std::vector<FunctionStats> GetFunctionStats() const;
+	// The same stats summed per source file (with an empty name), sorted by descending time
+	std::vector<FunctionStats> GetFileStats() const;
+
+	const GCStats &GetGCStats() const { return m_gc; }
+	uint64_t GetTotalSamples() const { return m_totalSamples; }
+	// Total time charged to Lua functions
+	double GetTotalTimeMs() const { return m_totalTimeMs; }
+
+	// Write a tab-separated report of the function and file stats to a
+	// file in the user directory
+	bool DumpToFile(const std::string &filename) const;
+
+private:
+	using clock = std::chrono::steady_clock;
+
+	static void Hook(lua_State *l, lua_Debug *ar);
+	static void *Alloc(void *ud, void *ptr, size_t osize, size_t nsize);
+
+	void Sample(lua_State *l, lua_Debug *ar);
+
+	lua_State *m_lua = nullptr;
+
+	// the allocator the profiler replaced while running
+	void *(*m_origAlloc)(void *, void *, size_t, size_t) = nullptr;
+	void *m_origAllocUd = nullptr;
+
+	clock::time_point m_lastSample;
+	uint64_t m_pendingAllocBytes = 0;
+	uint64_t m_pendingAllocCount = 0;
+
+	// keyed by "source:line"
+	std::unordered_map<std::string, FunctionStats> m_functions;
+	GCStats m_gc;
+	uint64_t m_totalSamples = 0;
+	double m_totalTimeMs = 0.0;
+};
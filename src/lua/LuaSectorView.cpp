@@ -70,19 +70,14 @@ void LuaObject<SectorView>::RegisterClass()
 			return 1;
 		})
 		.AddFunction("AutoRoute", [](lua_State *l, SectorView *sv) {
-			SystemPath current_path = sv->GetCurrent();
-			SystemPath target_path = sv->GetSelected();
-			std::vector<SystemPath> route;
-			const std::string result = sv->AutoRoute(current_path, target_path, route);
-			if (result == "OKAY") {
-				sv->ClearRoute();
-				for (auto it = route.begin(); it != route.end(); it++) {
-					sv->AddToRoute(*it);
-				}
-			}
+			const std::string result = sv->AutoRoute(sv->GetCurrent(), sv->GetSelected());
 			LuaPush<std::string>(l, result);
 			return 1;
 		})
+		.AddFunction("GetAutoRouteStatus", [](lua_State *l, SectorView *sv) {
+			LuaPush<std::string>(l, sv->GetAutoRouteStatus());
+			return 1;
+		})
 		.AddFunction("GetRoute", [](lua_State *l, SectorView *sv) {
 			std::vector<SystemPath> route = sv->GetRoute();
 			lua_newtable(l);
@@ -10,9 +10,13 @@
 #include "Body.h"
 #include "Space.h"
 
+#include "base64/base64.hpp"
 #include "core/Log.h"
 #include "profiler/Profiler.h"
 
+#include <algorithm>
+#include <cstring>
+
 // every module can save one object. that will usually be a table.  we call
 // each serializer in turn and capture its return value we build a table like
 // so:
@@ -56,6 +60,85 @@
 // on deserialize, the data after an "object" item will be passed to the
 // "Deserialize" function under that namespace. that data returned will be
 // given back to the module
+//
+// The per-module data is pickled with a compact binary encoding instead,
+// which avoids building a Json node for every Lua value. Each module's data
+// is stored as a base64 string under "lua_modules_bin", and the encoding
+// version under "lua_modules_bin_version". Every value starts with a tag byte:
+//   nil, false, true         - no payload
+//   number                   - 8-byte IEEE754 double
+//   string                   - varint length, bytes
+//   table                    - varint ref, key/value pairs, table-end tag
+//   table ref                - varint ref of a previously-pickled table
+//   lua class                - class name (as a string), then the table
+//                              returned by the class's Serialize function
+//   userdata                 - varint length, the CBOR-encoded Json of the
+//                              C++ object
+// Table refs are shared with the Json pickler through PiSerializerTableRefs,
+// so tables referenced from both Lua modules and LuaRefs or body components
+// keep their identity.
+
+namespace {
+	static const int BINARY_PICKLE_VERSION = 1;
+
+	enum PickleTag : uint8_t {
+		TAG_NIL,
+		TAG_FALSE,
+		TAG_TRUE,
+		TAG_NUMBER,
+		TAG_STRING,
+		TAG_TABLE,
+		TAG_TABLE_REF,
+		TAG_TABLE_END,
+		TAG_LUA_CLASS,
+		TAG_USERDATA,
+	};
+
+	inline void write_byte(std::string &out, uint8_t b) { out.push_back(char(b)); }
+
+	inline void write_varint(std::string &out, uint64_t v)
+	{
+		while (v >= 0x80) {
+			write_byte(out, uint8_t(v) | 0x80);
+			v >>= 7;
+		}
+		write_byte(out, uint8_t(v));
+	}
+
+	inline void write_string(std::string &out, const char *str, size_t len)
+	{
+		write_varint(out, len);
+		out.append(str, len);
+	}
+
+	inline uint8_t read_byte(const char *&pos, const char *end)
+	{
+		if (pos >= end)
+			throw SavedGameCorruptException();
+		return uint8_t(*pos++);
+	}
+
+	inline uint64_t read_varint(const char *&pos, const char *end)
+	{
+		uint64_t v = 0;
+		for (int shift = 0; shift < 64; shift += 7) {
+			const uint8_t b = read_byte(pos, end);
+			v |= uint64_t(b & 0x7f) << shift;
+			if (!(b & 0x80))
+				return v;
+		}
+		throw SavedGameCorruptException();
+	}
+
+	inline const char *read_bytes(const char *&pos, const char *end, size_t len)
+	{
+		if (size_t(end - pos) < len)
+			throw SavedGameCorruptException();
+		const char *data = pos;
+		pos += len;
+		return data;
+	}
+} // namespace
 
 void LuaSerializer::pickle_json(lua_State *l, int to_serialize, Json &out, const std::string &key)
 {
@@ -337,6 +420,280 @@ void LuaSerializer::unpickle_json(lua_State *l, const Json &value)
 	LUA_DEBUG_END(l, 1);
 }
 
+void LuaSerializer::pickle_binary(lua_State *l, int to_serialize, std::string &out, const char *module)
+{
+	LUA_DEBUG_START(l);
+
+	if (!lua_checkstack(l, 20))
+		luaL_error(l, "The Lua stack couldn't be extended (out of memory?)");
+
+	to_serialize = lua_absindex(l, to_serialize);
+	int idx = to_serialize;
+
+	if (lua_getmetatable(l, idx)) {
+		lua_getfield(l, -1, "class");
+		if (lua_isnil(l, -1))
+			lua_pop(l, 2);
+
+		else {
+			size_t len;
+			const char *cl = lua_tolstring(l, -1, &len);
+
+			lua_getfield(l, LUA_REGISTRYINDEX, "PiSerializerClasses");
+
+			lua_getfield(l, -1, cl);
+			if (lua_isnil(l, -1))
+				luaL_error(l, "Class '%s' not registered for serialization\n", cl);
+
+			lua_getfield(l, -1, "Serialize");
+			if (lua_isnil(l, -1))
+				luaL_error(l, "No Serialize method found for class '%s'\n", cl);
+
+			lua_pushvalue(l, idx);
+			pi_lua_protected_call(l, 1, 1);
+
+			idx = lua_gettop(l);
+
+			if (lua_isnil(l, idx)) {
+				write_byte(out, TAG_NIL);
+				lua_pop(l, 5);
+				LUA_DEBUG_END(l, 0);
+				return;
+			}
+
+			// only tables carry the class through a round trip
+			if (lua_istable(l, idx)) {
+				write_byte(out, TAG_LUA_CLASS);
+				write_string(out, cl, len);
+			}
+		}
+	}
+
+	switch (lua_type(l, idx)) {
+	case LUA_TNIL:
+		write_byte(out, TAG_NIL);
+		break;
+
+	case LUA_TBOOLEAN:
+		write_byte(out, lua_toboolean(l, idx) ? TAG_TRUE : TAG_FALSE);
+		break;
+
+	case LUA_TSTRING: {
+		size_t len;
+		const char *str = lua_tolstring(l, idx, &len);
+		write_byte(out, TAG_STRING);
+		write_string(out, str, len);
+		break;
+	}
+
+	case LUA_TNUMBER: {
+		const double num = lua_tonumber(l, idx);
+		char bytes[sizeof(double)];
+		memcpy(bytes, &num, sizeof(double));
+		write_byte(out, TAG_NUMBER);
+		out.append(bytes, sizeof(double));
+		break;
+	}
+
+	case LUA_TTABLE: {
+		lua_Integer ptr = lua_Integer(lua_topointer(l, to_serialize));
+
+		lua_getfield(l, LUA_REGISTRYINDEX, "PiSerializerTableRefs"); // reftable
+		lua_pushinteger(l, ptr);									 // reftable ptr
+		lua_rawget(l, -2);											 // reftable ???
+
+		if (!lua_isnil(l, -1)) {
+			lua_pop(l, 2);
+			write_byte(out, TAG_TABLE_REF);
+			write_varint(out, uint64_t(ptr));
+		} else {
+			lua_pop(l, 1);					// reftable
+			lua_pushinteger(l, ptr);		// reftable ptr
+			lua_pushvalue(l, to_serialize); // reftable ptr table
+			lua_rawset(l, -3);				// reftable
+			lua_pop(l, 1);					// [empty]
+
+			write_byte(out, TAG_TABLE);
+			write_varint(out, uint64_t(ptr));
+
+			lua_pushvalue(l, idx);
+			lua_pushnil(l);
+			while (lua_next(l, -2)) {
+				pickle_binary(l, -2, out, module);
+				pickle_binary(l, -1, out, module);
+				lua_pop(l, 1);
+			}
+			lua_pop(l, 1);
+
+			write_byte(out, TAG_TABLE_END);
+		}
+		break;
+	}
+
+	case LUA_TUSERDATA: {
+		lua_pushvalue(l, to_serialize);
+		Json obj = Json::object();
+		if (LuaObjectBase::SerializeToJson(l, obj)) {
+			const std::vector<uint8_t> cbor = Json::to_cbor(obj);
+			write_byte(out, TAG_USERDATA);
+			write_string(out, reinterpret_cast<const char *>(cbor.data()), cbor.size());
+		} else {
+			Log::Error("Lua serializer '{}' tried to serialize an invalid object\n"
+					   "The save file may be invalid.\n",
+				module);
+			write_byte(out, TAG_NIL);
+		}
+
+		lua_pop(l, 1);
+		break;
+	}
+
+	default:
+		Log::Error("Lua serializer '{}' tried to serialize {} value", module, lua_typename(l, lua_type(l, idx)));
+		write_byte(out, TAG_NIL);
+		break;
+	}
+
+	if (idx != to_serialize) // It means we called a transformation function on the data, so we clean it up.
+		lua_pop(l, 5);
+
+	LUA_DEBUG_END(l, 0);
+}
+
+void LuaSerializer::unpickle_binary(lua_State *l, const char *&pos, const char *end, lua_Integer *tableRef)
+{
+	LUA_DEBUG_START(l);
+
+	if (!lua_checkstack(l, 20))
+		luaL_error(l, "The Lua stack couldn't be extended (not enough memory?)");
+
+	switch (read_byte(pos, end)) {
+	case TAG_NIL:
+		lua_pushnil(l);
+		break;
+
+	case TAG_FALSE:
+	case TAG_TRUE:
+		lua_pushboolean(l, pos[-1] == TAG_TRUE);
+		break;
+
+	case TAG_NUMBER: {
+		double num;
+		memcpy(&num, read_bytes(pos, end, sizeof(double)), sizeof(double));
+		lua_pushnumber(l, num);
+		break;
+	}
+
+	case TAG_STRING: {
+		const size_t len = read_varint(pos, end);
+		lua_pushlstring(l, read_bytes(pos, end, len), len);
+		break;
+	}
+
+	case TAG_TABLE: {
+		const lua_Integer ptr = lua_Integer(read_varint(pos, end));
+		if (tableRef)
+			*tableRef = ptr;
+
+		lua_newtable(l);
+
+		lua_getfield(l, LUA_REGISTRYINDEX, "PiSerializerTableRefs"); // [t] [refs]
+		lua_pushinteger(l, ptr);									 // [t] [refs] [key]
+		lua_pushvalue(l, -3);										 // [t] [refs] [key] [t]
+		lua_rawset(l, -3);											 // [t] [refs]
+		lua_pop(l, 1);												 // [t]
+
+		while (true) {
+			if (pos >= end)
+				throw SavedGameCorruptException();
+			if (uint8_t(*pos) == TAG_TABLE_END) {
+				++pos;
+				break;
+			}
+			unpickle_binary(l, pos, end);
+			unpickle_binary(l, pos, end);
+			if (lua_isnil(l, -2))
+				throw SavedGameCorruptException();
+			lua_rawset(l, -3);
+		}
+		break;
+	}
+
+	case TAG_TABLE_REF: {
+		const lua_Integer ptr = lua_Integer(read_varint(pos, end));
+		lua_getfield(l, LUA_REGISTRYINDEX, "PiSerializerTableRefs"); // [refs]
+		lua_pushinteger(l, ptr);									 // [refs] [key]
+		lua_rawget(l, -2);											 // [refs] [out]
+
+		if (lua_isnil(l, -1))
+			throw SavedGameCorruptException();
+
+		lua_remove(l, -2); // [out]
+		break;
+	}
+
+	case TAG_LUA_CLASS: {
+		const size_t len = read_varint(pos, end);
+		const std::string cl(read_bytes(pos, end, len), len);
+
+		// only a full definition (not just a reference) is passed to the
+		// class's unserialiser function
+		lua_Integer ptr = 0;
+		const bool definition = pos < end && uint8_t(*pos) == TAG_TABLE;
+		unpickle_binary(l, pos, end, &ptr); // [t]
+		if (!definition)
+			break;
+
+		lua_getfield(l, LUA_REGISTRYINDEX, "PiSerializerClasses");
+		lua_getfield(l, -1, cl.c_str());
+		lua_remove(l, -2);
+
+		if (lua_isnil(l, -1)) {
+			lua_pop(l, 1);
+			break;
+		}
+
+		lua_getfield(l, -1, "Unserialize"); // [t] [klass] [klass.Unserialize]
+		if (lua_isnil(l, -1))
+			luaL_error(l, "No Unserialize method found for class '%s'\n", cl.c_str());
+
+		lua_insert(l, -3); // [klass.Unserialize] [t] [klass]
+		lua_pop(l, 1);	   // [klass.Unserialize] [t]
+
+		pi_lua_protected_call(l, 1, 1); // [t]
+		if (lua_isnil(l, -1))
+			luaL_error(l, "The Unserialize method for class '%s' didn't return a value\n", cl.c_str());
+
+		// Update the TableRefs cache with the new value, as unpickle_json does
+		lua_getfield(l, LUA_REGISTRYINDEX, "PiSerializerTableRefs"); // [t] [refs]
+		lua_pushinteger(l, ptr);									 // [t] [refs] [key]
+		lua_pushvalue(l, -3);										 // [t] [refs] [key] [t]
+		lua_rawset(l, -3);											 // [t] [refs]
+		lua_pop(l, 1);												 // [t]
+		break;
+	}
+
+	case TAG_USERDATA: {
+		const size_t len = read_varint(pos, end);
+		const uint8_t *data = reinterpret_cast<const uint8_t *>(read_bytes(pos, end, len));
+		Json value;
+		try {
+			value = Json::from_cbor(std::vector<uint8_t>(data, data + len));
+		} catch (Json::parse_error &) {
+			throw SavedGameCorruptException();
+		}
+		if (!LuaObjectBase::DeserializeFromJson(l, value.count("userdata") ? value["userdata"] : value))
+			throw SavedGameCorruptException();
+		break;
+	}
+
+	default:
+		throw SavedGameCorruptException();
+	}
+
+	LUA_DEBUG_END(l, 1);
+}
+
 void LuaSerializer::InitTableRefs()
 {
 	lua_State *l = Lua::manager->GetLuaState();
@@ -396,9 +753,32 @@ void LuaSerializer::ToJson(Json &jsonObj)
 
 	lua_pop(l, 1);
 
-	Json pickled;
-	pickle_json(l, savetable, pickled);
-	jsonObj["lua_modules_json"] = pickled;
+	// pickle the modules in a fixed order, so that table refs are defined
+	// before they are used when the modules are unpickled in the same order
+	std::vector<std::string> modules;
+	lua_pushnil(l);
+	while (lua_next(l, savetable) != 0) {
+		if (lua_type(l, -2) == LUA_TSTRING)
+			modules.emplace_back(lua_tostring(l, -2));
+		lua_pop(l, 1);
+	}
+	std::sort(modules.begin(), modules.end());
+
+	Json pickled = Json::object();
+	std::string buffer;
+	for (const std::string &module : modules) {
+		PROFILE_SCOPED_DESC("pickle module")
+		buffer.clear();
+		lua_getfield(l, savetable, module.c_str());
+		pickle_binary(l, -1, buffer, module.c_str());
+		lua_pop(l, 1);
+
+		std::string encoded;
+		Base64::Encode(buffer, &encoded);
+		pickled[module] = std::move(encoded);
+	}
+	jsonObj["lua_modules_bin"] = std::move(pickled);
+	jsonObj["lua_modules_bin_version"] = BINARY_PICKLE_VERSION;
 
 	lua_pop(l, 1);
 
@@ -412,7 +792,26 @@ void LuaSerializer::FromJson(const Json &jsonObj)
 
 	LUA_DEBUG_START(l);
 
-	if (jsonObj.count("lua_modules_json")) {
+	if (jsonObj.count("lua_modules_bin")) {
+		const Json &modules = jsonObj["lua_modules_bin"];
+		if (!modules.is_object() || jsonObj.value("lua_modules_bin_version", 0) != BINARY_PICKLE_VERSION)
+			throw SavedGameCorruptException();
+
+		lua_newtable(l);
+		std::string buffer;
+		// Json objects iterate in sorted key order, matching ToJson
+		for (auto it = modules.begin(); it != modules.end(); ++it) {
+			PROFILE_SCOPED_DESC("unpickle module")
+			if (!it.value().is_string() || !Base64::Decode(it.value().get_ref<const std::string &>(), &buffer))
+				throw SavedGameCorruptException();
+
+			const char *pos = buffer.data();
+			unpickle_binary(l, pos, pos + buffer.size());
+			if (pos != buffer.data() + buffer.size())
+				throw SavedGameCorruptException();
+			lua_setfield(l, -2, it.key().c_str());
+		}
+	} else if (jsonObj.count("lua_modules_json")) {
 		const Json &value = jsonObj["lua_modules_json"];
 		if (!value.is_object()) {
 			throw SavedGameCorruptException();
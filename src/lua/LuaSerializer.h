@@ -33,6 +33,10 @@ private:
 
 	static void pickle_json(lua_State *l, int idx, Json &out, const std::string &key = "");
 	static void unpickle_json(lua_State *l, const Json &value);
+
+	// compact binary encoding used for the per-module data, see LuaSerializer.cpp
+	static void pickle_binary(lua_State *l, int idx, std::string &out, const char *module);
+	static void unpickle_binary(lua_State *l, const char *&pos, const char *end, lua_Integer *tableRef = nullptr);
 };
 
 #endif
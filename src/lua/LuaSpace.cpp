@@ -11,6 +11,7 @@
 #include "LuaBody.h"
 #include "LuaManager.h"
 #include "LuaObject.h"
+#include "LuaTable.h"
 #include "LuaUtils.h"
 #include "LuaVector.h"
 #include "MathUtil.h"
@@ -1128,6 +1129,151 @@ static int l_space_get_bodies_near(lua_State *l)
 	return 1;
 }
 
+/*
+ * Function: QueryBodies
+ *
+ * Find the bodies around another body matching a set of criteria, sorted by
+ * distance. All the filtering is done natively, so only the matches are
+ * created as Lua objects.
+ *
+ * > bodies, distances = Space.QueryBodies(body, options)
+ *
+ * Parameters:
+ *
+ *   body - the reference body for distance
+ *
+ *   options - an optional table of query options:
+ *
+ *     type - a PhysicsObjectType enum value (one of Constants.PhysicsObjectType)
+ *            acting as a filter on the type of the returned bodies
+ *
+ *     radius - the maximum distance from the reference body, in meters.
+ *              Without a radius every body in the system is considered.
+ *
+ *     direction - a direction Vector relative to the reference body's
+ *                 orientation (as for a view from a ship's cockpit). Only
+ *                 bodies within maxAngle of it are returned.
+ *
+ *     maxAngle - the half-angle of the cone around direction, in radians
+ *
+ *     maxCount - return at most this many bodies, the nearest ones
+ *
+ *     sort - sort the results by distance, true by default
+ *
+ * Return:
+ *
+ *   bodies - an array containing zero or more <Body> objects that matched the
+ *            query, not including the reference body
+ *
+ *   distances - an array of the distance from the reference body to each of
+ *               the returned bodies
+ *
+ * Example:
+ *
+ * > -- the five nearest ships within 100km
+ * > local ships, dists = Space.QueryBodies(Game.player, { type = "SHIP", radius = 100000, maxCount = 5 })
+ *
+ * Availability:
+ *
+ *   2024-10
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_space_query_bodies(lua_State *l)
+{
+	PROFILE_SCOPED()
+
+	if (!Pi::game) {
+		luaL_error(l, "Game is not started");
+		return 0;
+	}
+
+	LUA_DEBUG_START(l);
+
+	Body *body = LuaPull<Body *>(l, 1);
+
+	ObjectType filterBodyType = ObjectType::BODY;
+	double radius = 0.0;
+	vector3d direction(0.0);
+	double maxAngle = 0.0;
+	size_t maxCount = 0;
+	bool sort = true;
+
+	if (lua_istable(l, 2)) {
+		LuaTable options(l, 2);
+		filterBodyType = options.Get<ObjectType>("type", ObjectType::BODY);
+		radius = options.Get<double>("radius", 0.0);
+		direction = options.Get<vector3d>("direction", vector3d(0.0));
+		maxAngle = options.Get<double>("maxAngle", M_PI);
+		maxCount = options.Get<int>("maxCount", 0);
+		sort = options.Get<bool>("sort", true);
+	} else if (!lua_isnoneornil(l, 2)) {
+		return luaL_argerror(l, 2, "expected a table of query options");
+	}
+
+	const bool filterType = filterBodyType != ObjectType::BODY;
+	const bool filterCone = direction.LengthSqr() > 0.0 && maxAngle < M_PI;
+	const double cosMaxAngle = cos(maxAngle);
+	const double radiusSqr = radius * radius;
+	if (filterCone)
+		direction = direction.Normalized();
+
+	Space *space = Pi::game->GetSpace();
+	std::vector<Space::BodyDist> matches;
+
+	auto consider = [&](Body *b) {
+		if (b == body || b->IsDead())
+			return;
+		if (filterType && !b->IsType(filterBodyType))
+			return;
+
+		const vector3d relPos = b->GetPositionRelTo(body);
+		const double distSqr = relPos.LengthSqr();
+		if (radius > 0.0 && distSqr > radiusSqr)
+			return;
+
+		const double dist = sqrt(distSqr);
+		if (filterCone && (relPos * body->GetOrient()).Dot(direction) < cosMaxAngle * dist)
+			return;
+
+		matches.emplace_back(b, dist);
+	};
+
+	if (radius > 0.0) {
+		for (Body *b : space->GetBodiesMaybeNear(body, radius))
+			consider(b);
+	} else {
+		for (Body *b : space->GetBodies())
+			consider(b);
+	}
+
+	if (maxCount > 0 && matches.size() > maxCount) {
+		// only the nearest maxCount need to be kept, and only those sorted
+		if (sort)
+			std::partial_sort(matches.begin(), matches.begin() + maxCount, matches.end());
+		else
+			std::nth_element(matches.begin(), matches.begin() + maxCount, matches.end());
+		matches.erase(matches.begin() + maxCount, matches.end());
+	} else if (sort) {
+		std::sort(matches.begin(), matches.end());
+	}
+
+	lua_createtable(l, matches.size(), 0);
+	lua_createtable(l, matches.size(), 0);
+	for (size_t idx = 0; idx < matches.size(); idx++) {
+		LuaObject<Body>::PushToLua(matches[idx].body);
+		lua_rawseti(l, -3, idx + 1);
+		lua_pushnumber(l, matches[idx].dist);
+		lua_rawseti(l, -2, idx + 1);
+	}
+
+	LUA_DEBUG_END(l, 2);
+
+	return 2;
+}
+
 static int l_space_dump_frames(lua_State *l)
 {
 	if (!Pi::game) {
@@ -1180,6 +1326,7 @@ void LuaSpace::Register()
 		{ "GetNumBodies", l_space_get_num_bodies },
 		{ "GetBodies", l_space_get_bodies },
 		{ "GetBodiesNear", l_space_get_bodies_near },
+		{ "QueryBodies", l_space_query_bodies },
 
 		{ "DbgDumpFrames", l_space_dump_frames },
 		{ 0, 0 }
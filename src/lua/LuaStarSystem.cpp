@@ -256,46 +256,31 @@ static int l_starsystem_get_nearby_systems(lua_State *l)
 	lua_newtable(l);
 
 	const SystemPath &here = s->GetPath();
+	GalaxySpatialIndex &index = s->m_galaxy->GetSpatialIndex();
 
-	const int here_x = here.sectorX;
-	const int here_y = here.sectorY;
-	const int here_z = here.sectorZ;
-	const Uint32 here_idx = here.systemIndex;
-	RefCountedPtr<const Sector> here_sec = s->m_galaxy->GetSector(here);
-
-	const int diff_sec = int(ceil(dist_ly / Sector::SIZE));
+	std::vector<const GalaxySpatialIndex::Entry *> candidates;
+	index.FindInRadius(index.GetEntry(here).pos, dist_ly, GalaxySpatialIndex::Filter(), candidates);
 
 	uint32_t numSystems = 0;
-	for (int x = here_x - diff_sec; x <= here_x + diff_sec; x++) {
-		for (int y = here_y - diff_sec; y <= here_y + diff_sec; y++) {
-			for (int z = here_z - diff_sec; z <= here_z + diff_sec; z++) {
-				RefCountedPtr<const Sector> sec = s->m_galaxy->GetSector(SystemPath(x, y, z));
-
-				for (unsigned int idx = 0; idx < sec->m_systems.size(); idx++) {
-					if (x == here_x && y == here_y && z == here_z && idx == here_idx)
-						continue;
-
-					if (Sector::DistanceBetween(here_sec, here_idx, sec, idx) > dist_ly)
-						continue;
-
-					RefCountedPtr<StarSystem> sys = s->m_galaxy->GetStarSystem(SystemPath(x, y, z, idx));
-					if (filter) {
-						lua_pushvalue(l, 3);
-						LuaObject<StarSystem>::PushToLua(sys.Get());
-						lua_call(l, 1, 1);
-						if (!lua_toboolean(l, -1)) {
-							lua_pop(l, 1);
-							continue;
-						}
-						lua_pop(l, 1);
-					}
-
-					lua_pushinteger(l, ++numSystems);
-					LuaObject<StarSystem>::PushToLua(sys.Get());
-					lua_rawset(l, -3);
-				}
+	for (const GalaxySpatialIndex::Entry *candidate : candidates) {
+		if (candidate->path.IsSameSystem(here))
+			continue;
+
+		RefCountedPtr<StarSystem> sys = s->m_galaxy->GetStarSystem(candidate->path);
+		if (filter) {
+			lua_pushvalue(l, 3);
+			LuaObject<StarSystem>::PushToLua(sys.Get());
+			lua_call(l, 1, 1);
+			if (!lua_toboolean(l, -1)) {
+				lua_pop(l, 1);
+				continue;
 			}
+			lua_pop(l, 1);
 		}
+
+		lua_pushinteger(l, ++numSystems);
+		LuaObject<StarSystem>::PushToLua(sys.Get());
+		lua_rawset(l, -3);
 	}
 
 	LUA_DEBUG_END(l, 1);
@@ -330,6 +315,131 @@ static int l_starsystem_get_jumpable(lua_State *l)
 	return 1;
 }
 
+/*
+ * Method: GetBodyAttributes
+ *
+ * Get attributes of every <SystemBody> in this system in one call, without
+ * creating a <SystemBody> object for each of them
+ *
+ * > columns = system:GetBodyAttributes({ "name", "type", "parent", "radius" })
+ * > for i = 1, system.numberOfBodies do
+ * >     print(columns.name[i], columns.type[i], columns.radius[i])
+ * > end
+ *
+ * Parameters:
+ *
+ *   names - an array of <SystemBody> attribute names. The scalar attributes
+ *           are supported: index, name, type, superType, seed, population,
+ *           radius, mass, gravity, escapeVelocity, meanDensity, periapsis,
+ *           apoapsis, orbitPeriod, rotationPeriod, semiMajorAxis,
+ *           eccentricity, axialTilt, averageTemp, metallicity, atmosDensity,
+ *           atmosOxidizing, surfacePressure, volatileLiquid, volatileIces,
+ *           volcanicity, life, agricultural, hasRings, hasAtmosphere,
+ *           isScoopable, astroDescription, isMoon, isStation,
+ *           isGroundStation and isSpaceStation. There is also parent, the
+ *           position of the body's parent in the arrays, or 0 for the root
+ *           body, from which the body tree can be rebuilt.
+ *
+ * Return:
+ *
+ *   columns - a table with an array for each of the names, each holding the
+ *             values of that attribute for every body in body index order
+ *             (so the body at position i has index i - 1)
+ *
+ * Availability:
+ *
+ *   2024
+ *
+ * Status:
+ *
+ *   experimental
+ */
+namespace {
+	struct BodyAttribute {
+		const char *name;
+		void (*push)(lua_State *l, const SystemBody *sbody);
+	};
+
+	// must give the same values as the SystemBody attributes of the same name
+	const BodyAttribute s_bodyAttributes[] = {
+		{ "index", [](lua_State *l, const SystemBody *sb) { lua_pushinteger(l, sb->GetPath().bodyIndex); } },
+		{ "name", [](lua_State *l, const SystemBody *sb) { lua_pushstring(l, sb->GetName().c_str()); } },
+		{ "type", [](lua_State *l, const SystemBody *sb) { lua_pushstring(l, EnumStrings::GetString("BodyType", sb->GetType())); } },
+		{ "superType", [](lua_State *l, const SystemBody *sb) { lua_pushstring(l, EnumStrings::GetString("BodySuperType", sb->GetSuperType())); } },
+		{ "seed", [](lua_State *l, const SystemBody *sb) { lua_pushinteger(l, sb->GetSeed()); } },
+		{ "parent", [](lua_State *l, const SystemBody *sb) { lua_pushinteger(l, sb->GetParent() ? sb->GetParent()->GetPath().bodyIndex + 1 : 0); } },
+		{ "population", [](lua_State *l, const SystemBody *sb) { lua_pushnumber(l, sb->GetPopulation()); } },
+		{ "radius", [](lua_State *l, const SystemBody *sb) { lua_pushnumber(l, sb->GetRadius()); } },
+		{ "mass", [](lua_State *l, const SystemBody *sb) { lua_pushnumber(l, sb->GetMass()); } },
+		{ "gravity", [](lua_State *l, const SystemBody *sb) { lua_pushnumber(l, sb->CalcSurfaceGravity()); } },
+		{ "escapeVelocity", [](lua_State *l, const SystemBody *sb) { lua_pushnumber(l, sb->CalcEscapeVelocity()); } },
+		{ "meanDensity", [](lua_State *l, const SystemBody *sb) { lua_pushnumber(l, sb->CalcMeanDensity()); } },
+		{ "periapsis", [](lua_State *l, const SystemBody *sb) { lua_pushnumber(l, sb->GetOrbMin() * AU); } },
+		{ "apoapsis", [](lua_State *l, const SystemBody *sb) { lua_pushnumber(l, sb->GetOrbMax() * AU); } },
+		{ "orbitPeriod", [](lua_State *l, const SystemBody *sb) { lua_pushnumber(l, sb->GetOrbit().Period() / float(60 * 60 * 24)); } },
+		{ "rotationPeriod", [](lua_State *l, const SystemBody *sb) { lua_pushnumber(l, sb->GetRotationPeriodInDays()); } },
+		{ "semiMajorAxis", [](lua_State *l, const SystemBody *sb) { lua_pushnumber(l, sb->GetSemiMajorAxis() * AU); } },
+		{ "eccentricity", [](lua_State *l, const SystemBody *sb) { lua_pushnumber(l, sb->GetEccentricity()); } },
+		{ "axialTilt", [](lua_State *l, const SystemBody *sb) { lua_pushnumber(l, sb->GetAxialTilt()); } },
+		{ "averageTemp", [](lua_State *l, const SystemBody *sb) { lua_pushinteger(l, sb->GetAverageTemp()); } },
+		{ "metallicity", [](lua_State *l, const SystemBody *sb) { lua_pushnumber(l, sb->GetMetallicity()); } },
+		{ "atmosDensity", [](lua_State *l, const SystemBody *sb) { lua_pushnumber(l, sb->GetAtmSurfaceDensity()); } },
+		{ "atmosOxidizing", [](lua_State *l, const SystemBody *sb) { lua_pushnumber(l, sb->GetAtmosOxidizing()); } },
+		{ "surfacePressure", [](lua_State *l, const SystemBody *sb) { lua_pushnumber(l, sb->GetAtmSurfacePressure()); } },
+		{ "volatileLiquid", [](lua_State *l, const SystemBody *sb) { lua_pushnumber(l, sb->GetVolatileLiquid()); } },
+		{ "volatileIces", [](lua_State *l, const SystemBody *sb) { lua_pushnumber(l, sb->GetVolatileIces()); } },
+		{ "volcanicity", [](lua_State *l, const SystemBody *sb) { lua_pushnumber(l, sb->GetVolcanicity()); } },
+		{ "life", [](lua_State *l, const SystemBody *sb) { lua_pushnumber(l, sb->GetLife()); } },
+		{ "agricultural", [](lua_State *l, const SystemBody *sb) { lua_pushnumber(l, sb->GetAgriculturalAsFixed().ToDouble()); } },
+		{ "hasRings", [](lua_State *l, const SystemBody *sb) { lua_pushboolean(l, sb->HasRings()); } },
+		{ "hasAtmosphere", [](lua_State *l, const SystemBody *sb) { lua_pushboolean(l, sb->HasAtmosphere()); } },
+		{ "isScoopable", [](lua_State *l, const SystemBody *sb) { lua_pushboolean(l, sb->IsScoopable()); } },
+		{ "astroDescription", [](lua_State *l, const SystemBody *sb) { LuaPush(l, sb->GetAstroDescription()); } },
+		{ "isMoon", [](lua_State *l, const SystemBody *sb) { lua_pushboolean(l, sb->IsMoon()); } },
+		{ "isStation", [](lua_State *l, const SystemBody *sb) { lua_pushboolean(l, sb->GetSuperType() == SystemBody::SUPERTYPE_STARPORT); } },
+		{ "isGroundStation", [](lua_State *l, const SystemBody *sb) { lua_pushboolean(l, sb->GetType() == SystemBody::TYPE_STARPORT_SURFACE); } },
+		{ "isSpaceStation", [](lua_State *l, const SystemBody *sb) { lua_pushboolean(l, sb->GetType() == SystemBody::TYPE_STARPORT_ORBITAL); } },
+	};
+} // namespace
+
+static int l_starsystem_get_body_attributes(lua_State *l)
+{
+	PROFILE_SCOPED()
+	LUA_DEBUG_START(l);
+
+	const StarSystem *s = LuaObject<StarSystem>::CheckFromLua(1);
+	luaL_checktype(l, 2, LUA_TTABLE);
+
+	lua_newtable(l);
+	const int numNames = lua_rawlen(l, 2);
+	for (int i = 1; i <= numNames; i++) {
+		lua_rawgeti(l, 2, i);
+		const char *name = luaL_checkstring(l, -1);
+
+		const BodyAttribute *attr = nullptr;
+		for (const BodyAttribute &a : s_bodyAttributes)
+			if (!strcmp(a.name, name)) {
+				attr = &a;
+				break;
+			}
+		if (!attr)
+			return luaL_error(l, "'%s' is not a SystemBody attribute GetBodyAttributes supports", name);
+
+		lua_createtable(l, s->GetNumBodies(), 0);
+		int index = 1;
+		for (const RefCountedPtr<SystemBody> &sb : s->GetBodies()) {
+			attr->push(l, sb.Get());
+			lua_rawseti(l, -2, index++);
+		}
+		// columns[name] = values, leaving columns on top
+		lua_rawset(l, -3);
+	}
+
+	LUA_DEBUG_END(l, 1);
+
+	return 1;
+}
+
 /*
  * Method: DistanceTo
  *
@@ -717,6 +827,7 @@ void LuaObject<StarSystem>::RegisterClass()
 		{ "GetBodyByPath", l_starsystem_get_body_by_path },
 		{ "GetStars", l_starsystem_get_stars },
 		{ "GetJumpable", l_starsystem_get_jumpable },
+		{ "GetBodyAttributes", l_starsystem_get_body_attributes },
 
 		{ "GetCommodityBasePriceAlterations", l_starsystem_get_commodity_base_price_alterations },
 		{ "IsCommodityLegal", l_starsystem_is_commodity_legal },
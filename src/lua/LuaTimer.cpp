@@ -9,9 +9,10 @@
 #include "Pi.h"
 #include "profiler/Profiler.h"
 
-#include <algorithm>
+#include <cfloat>
 
-LuaTimer::LuaTimer()
+LuaTimer::LuaTimer() :
+	m_nextSeq(0)
 {
 	m_called.reserve(8);
 }
@@ -22,15 +23,7 @@ LuaTimer::~LuaTimer()
 
 void LuaTimer::Insert(double at, int callbackId, bool repeats)
 {
-	CallInfo info { at, callbackId, repeats };
-
-	// Keep the queue sorted when inserting new elements.
-	// This is O(log N) + O(N/2) worst-case
-	auto iter = std::lower_bound(m_timeouts.cbegin(), m_timeouts.cend(), info, [](const CallInfo &timeout, const CallInfo &val) {
-		return timeout.at < val.at;
-	});
-
-	m_timeouts.insert(iter, std::move(info));
+	m_timeouts.push({ at, m_nextSeq++, callbackId, repeats });
 }
 
 void LuaTimer::RemoveAll()
@@ -42,6 +35,11 @@ void LuaTimer::RemoveAll()
 	m_timeouts.clear();
 }
 
+double LuaTimer::GetNextDeadline() const
+{
+	return m_timeouts.empty() ? DBL_MAX : m_timeouts.top().at;
+}
+
 void LuaTimer::Tick()
 {
 	PROFILE_SCOPED()
@@ -52,9 +50,9 @@ void LuaTimer::Tick()
 	double now = Pi::game->GetTime();
 
 	// Move called timeouts out of the list into our scratch buffer
-	while (!m_timeouts.empty() && m_timeouts.front().at <= now) {
-		m_called.push_back(m_timeouts.front());
-		m_timeouts.pop_front();
+	while (!m_timeouts.empty() && m_timeouts.top().at <= now) {
+		m_called.push_back(m_timeouts.top());
+		m_timeouts.pop();
 	}
 
 	if (m_called.empty())
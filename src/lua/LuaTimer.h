@@ -7,8 +7,9 @@
 #include "DeleteEmitter.h"
 #include "LuaManager.h"
 #include "JsonFwd.h"
+#include "core/DAryHeap.h"
 
-#include <deque>
+#include <vector>
 
 class LuaTimer : public DeleteEmitter {
 public:
@@ -20,6 +21,9 @@ public:
 	void Tick();
 	void RemoveAll();
 
+	// game time of the earliest pending timeout, DBL_MAX if there is none
+	double GetNextDeadline() const;
+
 	// For internal use only
 	void Insert(double at, int callbackId, bool repeats);
 
@@ -30,12 +34,19 @@ private:
 	 */
 	struct CallInfo {
 		double at;
+		uint64_t seq; // insertion order, so timeouts due at the same time fire in order
 		int callbackId;
 		bool repeats;
+
+		bool operator<(const CallInfo &other) const
+		{
+			return at < other.at || (at == other.at && seq < other.seq);
+		}
 	};
 
-	// Queue of tracked 'timeout' entries
-	std::deque<CallInfo> m_timeouts;
+	// Heap of tracked 'timeout' entries, earliest first
+	DAryHeap<CallInfo> m_timeouts;
+	uint64_t m_nextSeq;
 	// Scratch buffer for timeouts that elapsed this update
 	std::vector<CallInfo> m_called;
 };
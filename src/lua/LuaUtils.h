@@ -76,6 +76,9 @@ void pi_lua_import_recursive(lua_State *L, const std::string &importName);
 int pi_lua_panic(lua_State *l) __attribute((noreturn));
 void pi_lua_protected_call(lua_State *state, int nargs, int nresults);
 int pi_lua_loadfile(lua_State *l, const FileSystem::FileData &code);
+// Cache compiled chunks loaded by pi_lua_loadfile in the user directory, so
+// unchanged files are not compiled again on the next run
+void pi_lua_init_bytecode_cache(bool enabled);
 void pi_lua_dofile(lua_State *l, const std::string &path, int nret = 0);
 void pi_lua_dofile_recursive(lua_State *l, const std::string &basepath);
 
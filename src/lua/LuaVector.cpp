@@ -248,6 +248,18 @@ vector3d *LuaVector::PushNewToLua(lua_State *L)
 	return ptr;
 }
 
+void LuaVector::PushToLuaReuse(lua_State *L, const vector3d &v, int outIdx)
+{
+	outIdx = lua_absindex(L, outIdx);
+	vector3d *out = static_cast<vector3d *>(LuaMetaTypeBase::TestUserdata(L, outIdx, LuaVector::TypeName));
+	if (out) {
+		*out = v;
+		lua_pushvalue(L, outIdx);
+	} else {
+		PushToLua(L, v);
+	}
+}
+
 const vector3d *LuaVector::GetFromLua(lua_State *L, int idx)
 {
 	return static_cast<vector3d *>(LuaMetaTypeBase::TestUserdata(L, idx, LuaVector::TypeName));
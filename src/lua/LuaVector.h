@@ -15,6 +15,11 @@ namespace LuaVector {
 	void Register(lua_State *L);
 	vector3d *PushNewToLua(lua_State *L);
 	inline void PushToLua(lua_State *L, const vector3d &v) { *PushNewToLua(L) = v; }
+	// Like PushToLua, but if the value at outIdx is a Vector3 it is
+	// overwritten and pushed again instead of allocating a new one. Hot
+	// bindings use this for an optional "out" argument so per-frame Lua code
+	// can reuse a scratch vector rather than create garbage.
+	void PushToLuaReuse(lua_State *L, const vector3d &v, int outIdx);
 	const vector3d *GetFromLua(lua_State *L, int idx);
 	vector3d *CheckFromLua(lua_State *L, int idx);
 
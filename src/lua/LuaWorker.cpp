@@ -0,0 +1,439 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "LuaWorker.h"
+
+#include "FileSystem.h"
+#include "JobQueue.h"
+#include "LuaObject.h"
+#include "LuaUtils.h"
+#include "Pi.h"
+#include "core/CoreFwdDecl.h"
+#include "core/Log.h"
+#include "profiler/Profiler.h"
+
+#include <cassert>
+#include <cstring>
+#include <map>
+#include <memory>
+
+/*
+ * Interface: Worker
+ *
+ * Runs side-effect-free Lua functions in separate Lua states on worker
+ * threads, so that expensive pure computations (scoring routes, generating
+ * NPCs, filling bulletin boards) don't hold up the main thread.
+ *
+ * A worker script is a data file that returns a table of functions. It runs
+ * with only the sandboxed standard library (no game objects, no import, no
+ * print) and can't see the main Lua state. Each function takes one argument
+ * and returns one value; both may be nil, booleans, numbers, strings, or
+ * tables of those, and are copied between the states.
+ */
+
+namespace {
+	enum MessageTag : char {
+		MSG_NIL,
+		MSG_FALSE,
+		MSG_TRUE,
+		MSG_NUMBER,
+		MSG_STRING,
+		MSG_TABLE,
+		MSG_TABLE_END
+	};
+
+	// deep enough for any sensible data, and stops tables that refer to
+	// themselves
+	static constexpr int MAX_TABLE_DEPTH = 32;
+
+	static const char WORKER_MODULES[] = "LuaWorkerModules";
+	static const char WORKER_CALLBACKS[] = "LuaWorkerCallbacks";
+
+	bool PackValue(lua_State *l, int idx, std::string &out, std::string &error, int depth)
+	{
+		idx = lua_absindex(l, idx);
+		switch (lua_type(l, idx)) {
+		case LUA_TNIL:
+			out.push_back(MSG_NIL);
+			return true;
+
+		case LUA_TBOOLEAN:
+			out.push_back(lua_toboolean(l, idx) ? MSG_TRUE : MSG_FALSE);
+			return true;
+
+		case LUA_TNUMBER: {
+			const double num = lua_tonumber(l, idx);
+			out.push_back(MSG_NUMBER);
+			out.append(reinterpret_cast<const char *>(&num), sizeof(num));
+			return true;
+		}
+
+		case LUA_TSTRING: {
+			size_t len;
+			const char *str = lua_tolstring(l, idx, &len);
+			const uint32_t len32 = uint32_t(len);
+			out.push_back(MSG_STRING);
+			out.append(reinterpret_cast<const char *>(&len32), sizeof(len32));
+			out.append(str, len);
+			return true;
+		}
+
+		case LUA_TTABLE: {
+			if (depth >= MAX_TABLE_DEPTH || !lua_checkstack(l, 3)) {
+				error = "tables nested too deeply (or referring to themselves)";
+				return false;
+			}
+			out.push_back(MSG_TABLE);
+			lua_pushnil(l);
+			while (lua_next(l, idx)) {
+				if (!PackValue(l, -2, out, error, depth + 1) || !PackValue(l, -1, out, error, depth + 1)) {
+					lua_pop(l, 2);
+					return false;
+				}
+				lua_pop(l, 1);
+			}
+			out.push_back(MSG_TABLE_END);
+			return true;
+		}
+
+		default:
+			error = std::string(luaL_typename(l, idx)) + " values can't be passed to or from workers";
+			return false;
+		}
+	}
+
+	void UnpackValue(lua_State *l, const char *&pos)
+	{
+		luaL_checkstack(l, 3, "worker message nested too deeply");
+		switch (*pos++) {
+		case MSG_NIL:
+			lua_pushnil(l);
+			break;
+
+		case MSG_FALSE:
+		case MSG_TRUE:
+			lua_pushboolean(l, pos[-1] == MSG_TRUE);
+			break;
+
+		case MSG_NUMBER: {
+			double num;
+			memcpy(&num, pos, sizeof(num));
+			pos += sizeof(num);
+			lua_pushnumber(l, num);
+			break;
+		}
+
+		case MSG_STRING: {
+			uint32_t len;
+			memcpy(&len, pos, sizeof(len));
+			pos += sizeof(len);
+			lua_pushlstring(l, pos, len);
+			pos += len;
+			break;
+		}
+
+		case MSG_TABLE:
+			lua_newtable(l);
+			while (*pos != MSG_TABLE_END) {
+				UnpackValue(l, pos);
+				UnpackValue(l, pos);
+				lua_rawset(l, -3);
+			}
+			pos++;
+			break;
+
+		default:
+			assert(false && "bad worker message");
+			lua_pushnil(l);
+			break;
+		}
+	}
+
+	std::string ErrorString(lua_State *l, int idx)
+	{
+		const char *msg = lua_tostring(l, idx);
+		return msg ? msg : std::string("(error object is a ") + luaL_typename(l, idx) + " value)";
+	}
+
+	struct StateCloser {
+		void operator()(lua_State *l) const { lua_close(l); }
+	};
+
+	// each worker thread keeps its own state, so modules stay loaded
+	// between calls
+	lua_State *GetThreadState()
+	{
+		thread_local std::unique_ptr<lua_State, StateCloser> state(LuaWorker::NewState());
+		return state.get();
+	}
+
+	class WorkerJob : public Job {
+	public:
+		WorkerJob(int callback, const std::string &script, std::shared_ptr<const std::string> source, const std::string &func, std::string &&args) :
+			m_callback(callback),
+			m_script(script),
+			m_source(std::move(source)),
+			m_func(func),
+			m_args(std::move(args)),
+			m_ok(false)
+		{}
+
+		void OnRun() override
+		{
+			PROFILE_SCOPED()
+			m_ok = LuaWorker::Call(GetThreadState(), m_script, *m_source, m_func, m_args, m_result);
+		}
+
+		void OnFinish() override
+		{
+			lua_State *l = Lua::manager->GetLuaState();
+			LUA_DEBUG_START(l);
+
+			lua_getfield(l, LUA_REGISTRYINDEX, WORKER_CALLBACKS);
+			lua_rawgeti(l, -1, m_callback);
+			lua_pushnil(l);
+			lua_rawseti(l, -3, m_callback);
+			lua_remove(l, -2);
+
+			if (m_ok) {
+				LuaWorker::Unpack(l, m_result);
+				pi_lua_protected_call(l, 1, 0);
+			} else {
+				Log::Warning("Worker function {} from {} failed: {}\n", m_func, m_script, m_result);
+				lua_pushnil(l);
+				lua_pushlstring(l, m_result.data(), m_result.size());
+				pi_lua_protected_call(l, 2, 0);
+			}
+
+			LUA_DEBUG_END(l, 0);
+		}
+
+	private:
+		int m_callback;
+		std::string m_script;
+		std::shared_ptr<const std::string> m_source;
+		std::string m_func;
+		std::string m_args;
+
+		bool m_ok;
+		std::string m_result;
+	};
+
+	// main thread only
+	std::unique_ptr<JobSet> s_jobs;
+	std::map<std::string, std::shared_ptr<const std::string>> s_sources;
+	int s_lastCallback = 0;
+} // namespace
+
+bool LuaWorker::Pack(lua_State *l, int idx, std::string &out, std::string &error)
+{
+	LUA_DEBUG_START(l);
+	const bool ok = PackValue(l, idx, out, error, 0);
+	LUA_DEBUG_END(l, 0);
+	return ok;
+}
+
+void LuaWorker::Unpack(lua_State *l, const std::string &message)
+{
+	const char *pos = message.data();
+	UnpackValue(l, pos);
+	assert(pos == message.data() + message.size());
+}
+
+lua_State *LuaWorker::NewState()
+{
+	static const luaL_Reg libs[] = {
+		{ "_G", luaopen_base },
+		{ LUA_TABLIBNAME, luaopen_table },
+		{ LUA_STRLIBNAME, luaopen_string },
+		{ LUA_BITLIBNAME, luaopen_bit32 },
+		{ LUA_MATHLIBNAME, luaopen_math },
+		{ "util", luaopen_utils },
+		{ 0, 0 }
+	};
+
+	lua_State *l = luaL_newstate();
+	for (const luaL_Reg *lib = libs; lib->func; ++lib) {
+		luaL_requiref(l, lib->name, lib->func, 1);
+		lua_pop(l, 1);
+	}
+
+	// as in the main state nothing may load code, and as calls should
+	// depend only on their arguments there's no printing or C library RNG
+	for (const char *name : { "dofile", "loadfile", "load", "loadstring", "print" }) {
+		lua_pushnil(l);
+		lua_setglobal(l, name);
+	}
+	lua_getglobal(l, LUA_MATHLIBNAME);
+	lua_pushnil(l);
+	lua_setfield(l, -2, "random");
+	lua_pushnil(l);
+	lua_setfield(l, -2, "randomseed");
+	lua_pop(l, 1);
+
+	lua_newtable(l);
+	lua_setfield(l, LUA_REGISTRYINDEX, WORKER_MODULES);
+
+	return l;
+}
+
+bool LuaWorker::Call(lua_State *l, const std::string &script, const std::string &source, const std::string &func, const std::string &args, std::string &result)
+{
+	LUA_DEBUG_START(l);
+
+	lua_getfield(l, LUA_REGISTRYINDEX, WORKER_MODULES);
+	lua_getfield(l, -1, script.c_str());
+	if (lua_isnil(l, -1)) {
+		lua_pop(l, 1);
+		const std::string chunkName = "@" + script;
+		if (luaL_loadbuffer(l, source.data(), source.size(), chunkName.c_str()) != LUA_OK || lua_pcall(l, 0, 1, 0) != LUA_OK) {
+			result = ErrorString(l, -1);
+			lua_pop(l, 2);
+			LUA_DEBUG_END(l, 0);
+			return false;
+		}
+		if (!lua_istable(l, -1)) {
+			result = script + " doesn't return a table of functions";
+			lua_pop(l, 2);
+			LUA_DEBUG_END(l, 0);
+			return false;
+		}
+		lua_pushvalue(l, -1);
+		lua_setfield(l, -3, script.c_str());
+	}
+
+	lua_getfield(l, -1, func.c_str());
+	if (!lua_isfunction(l, -1)) {
+		result = script + " has no function " + func;
+		lua_pop(l, 3);
+		LUA_DEBUG_END(l, 0);
+		return false;
+	}
+
+	Unpack(l, args);
+	bool ok = lua_pcall(l, 1, 1, 0) == LUA_OK;
+	if (ok) {
+		result.clear();
+		std::string error;
+		ok = Pack(l, -1, result, error);
+		if (!ok)
+			result = "can't return value: " + error;
+	} else {
+		result = ErrorString(l, -1);
+	}
+	lua_pop(l, 3);
+
+	LUA_DEBUG_END(l, 0);
+	return ok;
+}
+
+/*
+ * Function: Run
+ *
+ * Call a function from a worker script on a worker thread
+ *
+ * > Worker.Run(script, func, args, callback)
+ *
+ * The script is loaded by each worker thread the first time it is used
+ * there, so it should hold no state of its own between calls.
+ *
+ * Example:
+ *
+ * > -- modules/Trade/RouteWorker.lua returns { Score = function (routes) ... end }
+ * > Worker.Run("modules/Trade/RouteWorker.lua", "Score", routes, function (scores, err)
+ * >     if scores then ShowRoutes(scores) end
+ * > end)
+ *
+ * Parameters:
+ *
+ *   script - path of the worker script in the game data
+ *
+ *   func - name of the function in the table the script returns
+ *
+ *   args - the value passed to the function, which is copied, so later
+ *          changes to it aren't seen by the worker
+ *
+ *   callback - called on the main thread, in a later frame, with the
+ *              function's return value, or with nil and an error message
+ *              if the function failed
+ *
+ * Availability:
+ *
+ *   2024
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_worker_run(lua_State *l)
+{
+	const std::string script = luaL_checkstring(l, 1);
+	const std::string func = luaL_checkstring(l, 2);
+	luaL_checktype(l, 4, LUA_TFUNCTION);
+
+	std::string args, error;
+	if (!LuaWorker::Pack(l, 3, args, error))
+		return luaL_error(l, "can't pass arguments to worker function %s: %s", func.c_str(), error.c_str());
+
+	std::shared_ptr<const std::string> &source = s_sources[script];
+	if (!source) {
+		RefCountedPtr<FileSystem::FileData> code = FileSystem::gameDataFiles.ReadFile(script);
+		if (!code) {
+			s_sources.erase(script);
+			return luaL_error(l, "can't load worker script %s", script.c_str());
+		}
+		source = std::make_shared<const std::string>(code->AsStringView());
+	}
+
+	lua_getfield(l, LUA_REGISTRYINDEX, WORKER_CALLBACKS);
+	if (lua_isnil(l, -1)) {
+		lua_pop(l, 1);
+		lua_newtable(l);
+		lua_pushvalue(l, -1);
+		lua_setfield(l, LUA_REGISTRYINDEX, WORKER_CALLBACKS);
+	}
+	const int callback = ++s_lastCallback;
+	lua_pushvalue(l, 4);
+	lua_rawseti(l, -2, callback);
+	lua_pop(l, 1);
+
+	if (!s_jobs)
+		s_jobs.reset(new JobSet(Pi::GetAsyncJobQueue()));
+	s_jobs->Order(new WorkerJob(callback, script, source, func, std::move(args)));
+
+	return 0;
+}
+
+void LuaWorker::Register()
+{
+	lua_State *l = Lua::manager->GetLuaState();
+
+	LUA_DEBUG_START(l);
+
+	static const luaL_Reg l_methods[] = {
+		{ "Run", l_worker_run },
+		{ NULL, NULL }
+	};
+
+	static const luaL_Reg l_attrs[] = {
+		{ NULL, NULL }
+	};
+
+	lua_getfield(l, LUA_REGISTRYINDEX, "CoreImports");
+	LuaObjectBase::CreateObject(l_methods, l_attrs, 0);
+	lua_setfield(l, -2, "Worker");
+	lua_pop(l, 1);
+
+	LUA_DEBUG_END(l, 0);
+}
+
+void LuaWorker::Uninit()
+{
+	// destroying the handles cancels the jobs
+	s_jobs.reset();
+	s_sources.clear();
+
+	lua_State *l = Lua::manager->GetLuaState();
+	lua_pushnil(l);
+	lua_setfield(l, LUA_REGISTRYINDEX, WORKER_CALLBACKS);
+}
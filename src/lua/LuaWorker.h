@@ -0,0 +1,42 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _LUAWORKER_H
+#define _LUAWORKER_H
+
+#include <string>
+
+struct lua_State;
+
+// Worker Lua runs side-effect-free script functions (scoring routes,
+// generating NPCs and the like) in separate Lua states on the job queue's
+// worker threads. A worker state has only the sandboxed standard library
+// and no game bindings, and exchanges plain data with the main state
+// through messages.
+namespace LuaWorker {
+	void Register();
+
+	// Cancels any calls still running, so their callbacks are never made
+	void Uninit();
+
+	// Appends a message holding the value at idx, which may be nil, a
+	// boolean, a number, a string or a table of those. Returns false with
+	// the reason in error for anything else, including functions, userdata
+	// and tables that nest too deeply (or refer to themselves).
+	bool Pack(lua_State *l, int idx, std::string &out, std::string &error);
+
+	// Pushes the value held in a message made by Pack
+	void Unpack(lua_State *l, const std::string &message);
+
+	// Creates a worker state; close it with lua_close
+	lua_State *NewState();
+
+	// Runs func from the module table returned by script (whose code is
+	// source) in a worker state, passing the value in the args message.
+	// The module is only loaded the first time a state sees the script.
+	// On success result is a message holding the function's return value;
+	// on failure it is the error and false is returned.
+	bool Call(lua_State *l, const std::string &script, const std::string &source, const std::string &func, const std::string &args, std::string &result);
+} // namespace LuaWorker
+
+#endif
@@ -4,10 +4,17 @@
 #include "CoreFwdDecl.h"
 #include "FileSystem.h"
 #include "LuaUtils.h"
+#include "core/FastHash.h"
 #include "core/Log.h"
 #include "utils.h"
 #include "FileSystem.h"
 #include "LuaFileSystem.h"
+#include "profiler/Profiler.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <thread>
 
 static int l_d_null_userdata(lua_State *L)
 {
@@ -294,6 +301,65 @@ void pi_lua_protected_call(lua_State *L, int nargs, int nresults)
 	}
 }
 
+namespace {
+	const char BYTECODE_CACHE_DIR_NAME[] = "lua_cache";
+	const uint32_t BYTECODE_CACHE_MAGIC = 0x43424C50; // "PLBC"
+	// bump whenever the way chunks are compiled or named changes
+	const uint32_t BYTECODE_CACHE_VERSION = 1;
+	std::atomic<bool> s_bytecodeCacheEnabled(false);
+
+	struct BytecodeCacheHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t luaVersion;
+		uint32_t pointerSize;
+		uint64_t sourceHash;
+		uint64_t sourceSize;
+	};
+
+	int bytecode_writer(lua_State *, const void *p, size_t sz, void *ud)
+	{
+		std::string *out = static_cast<std::string *>(ud);
+		out->append(static_cast<const char *>(p), sz);
+		return 0;
+	}
+
+	void save_bytecode(const std::string &cacheName, const BytecodeCacheHeader &header, const std::string &bytecode)
+	{
+		PROFILE_SCOPED()
+		// write to a file of this thread's own, then move it into place, so
+		// another thread never reads a partly written file
+		const std::string tempName = fmt::format("{}.{}.tmp", cacheName, std::hash<std::thread::id>()(std::this_thread::get_id()));
+		FILE *f = FileSystem::userFiles.OpenWriteStream(tempName);
+		if (!f)
+			return;
+		bool written = fwrite(&header, sizeof(header), 1, f) == 1;
+		written = written && fwrite(bytecode.data(), bytecode.size(), 1, f) == 1;
+		fclose(f);
+
+		const std::string root = FileSystem::userFiles.GetRoot();
+		const std::string tempPath = FileSystem::JoinPathBelow(root, tempName);
+		const std::string filePath = FileSystem::JoinPathBelow(root, cacheName);
+		bool moved = written && std::rename(tempPath.c_str(), filePath.c_str()) == 0;
+		if (written && !moved) {
+			// rename() doesn't replace an existing file everywhere
+			std::remove(filePath.c_str());
+			moved = std::rename(tempPath.c_str(), filePath.c_str()) == 0;
+		}
+		if (!moved)
+			std::remove(tempPath.c_str());
+	}
+} // namespace
+
+void pi_lua_init_bytecode_cache(bool enabled)
+{
+	s_bytecodeCacheEnabled = enabled;
+	if (enabled && !FileSystem::userFiles.MakeDirectory(BYTECODE_CACHE_DIR_NAME)) {
+		Output("Could not create the Lua bytecode cache directory, disabling it.\n");
+		s_bytecodeCacheEnabled = false;
+	}
+}
+
 int pi_lua_loadfile(lua_State *l, const FileSystem::FileData &code)
 {
 	assert(l);
@@ -303,7 +369,36 @@ int pi_lua_loadfile(lua_State *l, const FileSystem::FileData &code)
 	bool trusted = code.GetInfo().GetSource().IsTrusted();
 	const std::string chunkName = (trusted ? "@[T] " : "@") + path;
 
-	return luaL_loadbuffer(l, source.begin, source.Size(), chunkName.c_str());
+	if (!s_bytecodeCacheEnabled)
+		return luaL_loadbuffer(l, source.begin, source.Size(), chunkName.c_str());
+
+	PROFILE_SCOPED()
+	// one entry per chunk name, so an edited file replaces its old entry;
+	// the entry is only used if the source text still hashes the same
+	const uint64_t sourceHash = FastHash64(source.begin, source.Size());
+	const std::string cacheName = FileSystem::JoinPath(BYTECODE_CACHE_DIR_NAME,
+		fmt::format("{:016x}.luac", FastHash64(chunkName.data(), chunkName.size())));
+	const BytecodeCacheHeader header = { BYTECODE_CACHE_MAGIC, BYTECODE_CACHE_VERSION,
+		LUA_VERSION_NUM, uint32_t(sizeof(void *)), sourceHash, source.Size() };
+
+	RefCountedPtr<FileSystem::FileData> cached = FileSystem::userFiles.ReadFile(cacheName);
+	if (cached && cached->GetSize() > sizeof(BytecodeCacheHeader) &&
+		memcmp(cached->GetData(), &header, sizeof(header)) == 0) {
+		// binary mode only; Lua rejects bytecode from a build with a
+		// different number format or endianness, and we recompile below
+		const char *bytecode = cached->GetData() + sizeof(header);
+		if (luaL_loadbufferx(l, bytecode, cached->GetSize() - sizeof(header), chunkName.c_str(), "b") == LUA_OK)
+			return LUA_OK;
+		lua_pop(l, 1);
+	}
+
+	int ret = luaL_loadbuffer(l, source.begin, source.Size(), chunkName.c_str());
+	if (ret == LUA_OK) {
+		std::string bytecode;
+		if (lua_dump(l, &bytecode_writer, &bytecode) == 0)
+			save_bytecode(cacheName, header, bytecode);
+	}
+	return ret;
 }
 
 void pi_lua_dofile(lua_State *l, const FileSystem::FileData &code, int nret)
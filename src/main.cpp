@@ -1,8 +1,10 @@
 // Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
+#include "Benchmark.h"
 #include "Game.h"
 #include "Pi.h"
+#include "Simulation.h"
 #include "buildopts.h"
 #include "core/OS.h"
 #include "galaxy/Galaxy.h"
@@ -14,13 +16,17 @@
 #include "lua/LuaObject.h"
 
 #include <SDL.h>
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 
 enum RunMode {
 	MODE_GAME,
 	MODE_GALAXYDUMP,
 	MODE_START_AT,
+	MODE_BENCHMARK,
+	MODE_SIMULATE,
 	MODE_VERSION,
 	MODE_USAGE,
 	MODE_USAGE_ERROR
@@ -62,6 +68,16 @@ extern "C" int main(int argc, char **argv)
 			goto start;
 		}
 
+		if (modeopt == "benchmark" || modeopt == "bm") {
+			mode = MODE_BENCHMARK;
+			goto start;
+		}
+
+		if (modeopt == "simulate" || modeopt == "sim") {
+			mode = MODE_SIMULATE;
+			goto start;
+		}
+
 		if (modeopt == "version" || modeopt == "v") {
 			mode = MODE_VERSION;
 			goto start;
@@ -82,6 +98,8 @@ start:
 	long int sx = 0, sy = 0, sz = 0;
 	std::string filename;
 	SystemPath startPath(0, 0, 0, 0, 0);
+	Benchmark::Settings benchmark;
+	Simulation::Settings simulation;
 
 	switch (mode) {
 	case MODE_GALAXYDUMP: {
@@ -151,6 +169,94 @@ start:
 		}
 		// fallthrough
 	}
+	case MODE_BENCHMARK: {
+		// fallthrough protect
+		if (mode == MODE_BENCHMARK) {
+			// positional arguments end at the first key=value option
+			auto positional = [&]() { return argc > pos && !strchr(argv[pos], '='); };
+
+			if (positional())
+				benchmark.scenario = argv[pos++];
+
+			if (benchmark.scenario.empty() || benchmark.scenario == "list") {
+				Output("available benchmark scenarios:\n");
+				for (const Benchmark::ScenarioInfo &info : Benchmark::GetScenarios())
+					Output("    %-12s %s\n", info.name, info.description);
+				Output("    %-12s %s\n", "save:<name>", "run from a saved game");
+				break;
+			}
+
+			if (positional()) { // ticks (optional)
+				char *end = nullptr;
+				const long int ticks = std::strtol(argv[pos], &end, 0);
+				if (end == nullptr || *end != 0 || ticks < 1 || ticks > 10000000) {
+					Output("pioneer: invalid tick count: %s\n", argv[pos]);
+					break;
+				}
+				benchmark.ticks = uint32_t(ticks);
+				++pos;
+			}
+			if (positional()) { // seed (optional)
+				char *end = nullptr;
+				const unsigned long int seed = std::strtoul(argv[pos], &end, 0);
+				if (end == nullptr || *end != 0) {
+					Output("pioneer: invalid seed: %s\n", argv[pos]);
+					break;
+				}
+				benchmark.seed = uint32_t(seed);
+				++pos;
+			}
+			if (positional()) // output file (optional)
+				benchmark.outputFile = argv[pos++];
+			else {
+				benchmark.outputFile = "benchmark-" + benchmark.scenario + ".json";
+				std::replace(benchmark.outputFile.begin(), benchmark.outputFile.end(), ':', '-');
+			}
+		}
+		// fallthrough
+	}
+	case MODE_SIMULATE: {
+		// fallthrough protect
+		if (mode == MODE_SIMULATE) {
+			// positional arguments end at the first key=value option
+			auto positional = [&]() { return argc > pos && !strchr(argv[pos], '='); };
+
+			if (positional()) { // start (optional)
+				const std::string start = argv[pos++];
+				if (start.compare(0, 5, "save:") == 0) {
+					simulation.saveName = start.substr(5);
+				} else {
+					try {
+						simulation.start = SystemPath::Parse(start.c_str());
+					} catch (const SystemPath::ParseFailure &) {
+						Output("pioneer: invalid start: %s\n", start.c_str());
+						break;
+					}
+				}
+			}
+			if (positional()) { // ticks (optional)
+				char *end = nullptr;
+				const long int ticks = std::strtol(argv[pos], &end, 0);
+				if (end == nullptr || *end != 0 || ticks < 0) {
+					Output("pioneer: invalid tick count: %s\n", argv[pos]);
+					break;
+				}
+				simulation.ticks = uint32_t(ticks);
+				++pos;
+			}
+			if (positional()) { // seed (optional)
+				char *end = nullptr;
+				const unsigned long int seed = std::strtoul(argv[pos], &end, 0);
+				if (end == nullptr || *end != 0) {
+					Output("pioneer: invalid seed: %s\n", argv[pos]);
+					break;
+				}
+				simulation.seed = uint32_t(seed);
+				++pos;
+			}
+		}
+		// fallthrough
+	}
 	case MODE_GAME: {
 		std::map<std::string, std::string> options;
 
@@ -174,12 +280,48 @@ start:
 			}
 		}
 
-		Pi::Init(options, mode == MODE_GALAXYDUMP);
+		if (mode == MODE_SIMULATE) {
+			// these name the simulation's files, they aren't config options
+			auto take = [&](const char *key, std::string &value) {
+				auto it = options.find(key);
+				if (it != options.end()) {
+					value = it->second;
+					options.erase(it);
+				}
+			};
+			take("script", simulation.script);
+			take("report", simulation.reportFile);
+
+			// many simulations can share a machine: one worker thread each
+			// unless the command line says otherwise
+			options.emplace("WorkerThreads", "1");
+		}
+
+		if (mode == MODE_BENCHMARK || mode == MODE_SIMULATE) {
+			// run without a window or sound; the command line can still
+			// override these
+			options.emplace("RendererName", "Dummy");
+			options.emplace("DisableSound", "1");
+		}
+
+		// a benchmark or simulation must not write its overrides to config.ini
+		const bool headless = mode == MODE_BENCHMARK || mode == MODE_SIMULATE;
+		Pi::Init(options, mode == MODE_GALAXYDUMP || headless, !headless);
 
 		if (mode == MODE_GAME) {
 			if (startPath != SystemPath(0, 0, 0, 0, 0))
 				Pi::GetApp()->SetStartPath(startPath);
 
+			Pi::GetApp()->Run();
+		} else if (mode == MODE_BENCHMARK) {
+			if (!Benchmark::IsValidScenario(benchmark.scenario)) {
+				Output("pioneer: unknown benchmark scenario: %s\n", benchmark.scenario.c_str());
+			} else {
+				Pi::GetApp()->QueueLifecycle(RefCountedPtr<Benchmark>(new Benchmark(benchmark)));
+				Pi::GetApp()->Run();
+			}
+		} else if (mode == MODE_SIMULATE) {
+			Pi::GetApp()->QueueLifecycle(RefCountedPtr<Simulation>(new Simulation(simulation)));
 			Pi::GetApp()->Run();
 		} else if (mode == MODE_GALAXYDUMP) {
 			// TODO: don't initialize Pi when dumping the galaxy
@@ -226,6 +368,9 @@ start:
 			"    -galaxydump  [-gd]    galaxy dumper\n"
 			"    -startat     [-sa]    skip main menu and start at Mars\n"
 			"    -startat=sp  [-sa=sp]  skip main menu and start at systempath x,y,z,si,bi\n"
+			"    -benchmark   [-bm]    run a benchmark: <scenario|list> [ticks] [seed] [output file]\n"
+			"    -simulate    [-sim]   run a game without drawing anything: [x,y,z,si,bi|save:<name>] [ticks] [seed]\n"
+			"                          [script=<data file>] [report=<file>]\n"
 			"    -version     [-v]     show version\n"
 			"    -help        [-h,-?]  this help\n");
 		break;
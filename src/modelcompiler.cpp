@@ -12,10 +12,12 @@
 #include "FileSystem.h"
 #include "GameConfig.h"
 #include "GameSaveError.h"
-#include "JobQueue.h"
 #include "ModManager.h"
 #include "StringF.h"
+#include "core/FastHash.h"
 #include "core/OS.h"
+#include "core/StringUtils.h"
+#include "core/TaskGraph.h"
 #include "graphics/Drawables.h"
 #include "graphics/Graphics.h"
 #include "graphics/Light.h"
@@ -27,42 +29,22 @@
 #include "scenegraph/BinaryConverter.h"
 #include "scenegraph/DumpVisitor.h"
 #include "scenegraph/FindNodeVisitor.h"
+#include "scenegraph/LODGenerator.h"
+#include "scenegraph/MeshOptimizer.h"
+#include <algorithm>
+#include <atomic>
+#include <map>
 #include <sstream>
 #include <SDL.h>
 
 std::unique_ptr<GameConfig> s_config;
 std::unique_ptr<Graphics::Renderer> s_renderer;
-
-//#define USES_THREADS
-#ifdef USES_THREADS
-std::unique_ptr<AsyncJobQueue> asyncJobQueue;
-#endif
+std::unique_ptr<TaskGraph> s_taskGraph;
 
 static const std::string s_dummyPath("");
 
-// fwd decl'
-void RunCompiler(const std::string &modelName, const std::string &filepath, const bool bInPlace);
-
-// ********************************************************************************
-// Overloaded PureJob class to handle compiling each model
-// ********************************************************************************
-class CompileJob : public Job {
-public:
-	CompileJob(){};
-	CompileJob(const std::string &name, const std::string &path, const bool inPlace) :
-		m_name(name),
-		m_path(path),
-		m_inPlace(inPlace) {}
-
-	virtual void OnRun() override final { RunCompiler(m_name, m_path, m_inPlace); } // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
-	virtual void OnFinish() override final {}
-	virtual void OnCancel() override final {}
-
-protected:
-	std::string m_name;
-	std::string m_path;
-	bool m_inPlace;
-};
+// source hashes of the models compiled by earlier batches, kept in the user directory
+static const std::string s_hashCacheFile("modelcompiler.hashes");
 
 // ********************************************************************************
 // functions
@@ -99,19 +81,69 @@ void SetupRenderer()
 	videoSettings.title = "Model Compiler";
 	s_renderer.reset(Graphics::Init(videoSettings));
 
-#ifdef USES_THREADS
-	// get threads up
+	// this is a tool, we can use all of the cores for processing unlike Pioneer
 	Uint32 numThreads = s_config->Int("WorkerThreads");
-	const int numCores = OS::GetNumCores();
-	assert(numCores > 0);
 	if (numThreads == 0)
-		numThreads = std::max(Uint32(numCores), 1U); // this is a tool, we can use all of the cores for processing unlike Pioneer
-	asyncJobQueue.reset(new AsyncJobQueue(numThreads));
+		numThreads = std::max(Uint32(OS::GetNumCores()), 1U);
+	s_taskGraph.reset(new TaskGraph());
+	s_taskGraph->SetWorkerThreads(numThreads);
 	Output("started %d worker threads\n", numThreads);
-#endif
 }
 
-void RunCompiler(const std::string &modelName, const std::string &filepath, const bool bInPlace)
+// the .sgm is written to the same path as the .model, without its extension
+static std::string GetSavePath(const std::string &filepath)
+{
+	return FileSystem::NormalisePath(filepath.substr(0, filepath.size() - 6));
+}
+
+// Hashes every file in the model's directory, which holds the meshes and
+// anything else the .model refers to, along with the compiler's version.
+// dataFiles is sorted, so the directory's files are a single run of it.
+static uint64_t HashModelSources(const std::string &filepath, const std::vector<std::string> &dataFiles)
+{
+	const std::string version = std::string(PIONEER_VERSION) + PIONEER_EXTRAVERSION;
+	uint64_t hash = FastHash64(version.data(), version.size(), SceneGraph::SGM_VERSION);
+
+	const std::string dir = filepath.substr(0, filepath.rfind('/') + 1);
+	for (auto it = std::lower_bound(dataFiles.begin(), dataFiles.end(), dir); it != dataFiles.end() && starts_with(*it, dir); ++it) {
+		RefCountedPtr<FileSystem::FileData> data = FileSystem::gameDataFiles.ReadFile(*it);
+		if (!data)
+			continue;
+		hash = FastHash64(it->data(), it->size(), hash);
+		hash = FastHash64(data->GetData(), data->GetSize(), hash);
+	}
+	return hash;
+}
+
+static std::map<std::string, uint64_t> LoadHashCache()
+{
+	std::map<std::string, uint64_t> hashes;
+	RefCountedPtr<FileSystem::FileData> data = FileSystem::userFiles.ReadFile(s_hashCacheFile);
+	if (!data)
+		return hashes;
+
+	std::istringstream in(std::string(data->AsStringView()));
+	uint64_t hash;
+	std::string savepath;
+	while (in >> std::hex >> hash >> savepath)
+		hashes[savepath] = hash;
+	return hashes;
+}
+
+static void SaveHashCache(const std::map<std::string, uint64_t> &hashes)
+{
+	FILE *f = FileSystem::userFiles.OpenWriteStream(s_hashCacheFile, FileSystem::FileSourceFS::WRITE_TEXT);
+	if (!f) {
+		Output("Could not write %s\n", s_hashCacheFile.c_str());
+		return;
+	}
+	for (const auto &entry : hashes)
+		fprintf(f, "%016llx %s\n", static_cast<unsigned long long>(entry.second), entry.first.c_str());
+	fclose(f);
+}
+
+// Safe to run from several jobs at once, as long as each has its own renderer
+bool RunCompiler(const std::string &modelName, const std::string &filepath, const bool bInPlace, Graphics::Renderer *renderer)
 {
 	PROFILE_SCOPED()
 	Profiler::Timer timer;
@@ -122,7 +154,7 @@ void RunCompiler(const std::string &modelName, const std::string &filepath, cons
 	//and then save it into binary
 	std::unique_ptr<SceneGraph::Model> model;
 	try {
-		SceneGraph::Loader ld(s_renderer.get(), true, false);
+		SceneGraph::Loader ld(renderer, true, false);
 		model.reset(ld.LoadModel(modelName));
 		//dump warnings
 		for (std::vector<std::string>::const_iterator it = ld.GetLogMessages().begin();
@@ -131,19 +163,32 @@ void RunCompiler(const std::string &modelName, const std::string &filepath, cons
 		}
 	} catch (...) {
 		//minimal error handling, this is not expected to happen since we got this far.
-		return;
+		return false;
 	}
 
+	//models authored with a single detail level get simplified ones for the distance
+	SceneGraph::LODGenerator lodGenerator(renderer);
+	if (const unsigned int numLevels = lodGenerator.Generate(model.get()))
+		Output("Generated %u detail levels for (%s)\n", numLevels, modelName.c_str());
+
+	//triangle and vertex order for the GPU caches
+	SceneGraph::MeshOptimizerVisitor optimizer;
+	model->GetRoot()->Accept(optimizer);
+	Output("Vertex cache miss ratio for (%s): %.3f -> %.3f\n", modelName.c_str(),
+		optimizer.GetMissRatioBefore(), optimizer.GetMissRatioAfter());
+
 	try {
-		const std::string DataPath = FileSystem::NormalisePath(filepath.substr(0, filepath.size() - 6));
-		SceneGraph::BinaryConverter bc(s_renderer.get());
-		bc.Save(modelName, DataPath, model.get(), bInPlace);
+		SceneGraph::BinaryConverter bc(renderer);
+		bc.Save(modelName, GetSavePath(filepath), model.get(), bInPlace);
 	} catch (const CouldNotOpenFileException &) {
+		return false;
 	} catch (const CouldNotWriteToFileException &) {
+		return false;
 	}
 
 	timer.Stop();
 	Output("Compiling \"%s\" took: %lf\n", modelName.c_str(), timer.millicycles());
+	return true;
 }
 
 // ********************************************************************************
@@ -240,7 +285,7 @@ start:
 				}
 			}
 			SetupRenderer();
-			RunCompiler(modelName, filePath, isInPlace);
+			RunCompiler(modelName, filePath, isInPlace, s_renderer.get());
 		}
 		break;
 	}
@@ -259,8 +304,9 @@ start:
 			}
 		}
 
-		// find all of the models
+		// find all of the models, and the files they could be built from
 		std::vector<std::pair<std::string, std::string>> list_model;
+		std::vector<std::string> dataFiles;
 		FileSystem::FileSource &fileSource = FileSystem::gameDataFiles;
 		for (FileSystem::FileEnumerator files(fileSource, "models", FileSystem::FileEnumerator::Recurse); !files.Finished(); files.Next()) {
 			const FileSystem::FileInfo &info = files.Current();
@@ -271,31 +317,57 @@ start:
 				if (ends_with_ci(fpath, ".model")) { // store the path for ".model" files
 					list_model.push_back(std::make_pair(info.GetName().substr(0, info.GetName().size() - 6), fpath));
 				}
+				// in place outputs sit beside their sources
+				if (!ends_with_ci(fpath, ".sgm"))
+					dataFiles.push_back(fpath);
 			}
 		}
+		std::sort(dataFiles.begin(), dataFiles.end());
 
 		SetupRenderer();
 
-#ifndef USES_THREADS
-		for (auto &modelName : list_model) {
-			RunCompiler(modelName.first, modelName.second, isInPlace);
-		}
-#else
-		std::deque<Job::Handle> handles;
-		for (auto &modelName : list_model) {
-			handles.push_back(asyncJobQueue->Queue(new CompileJob(modelName.first, modelName.second, isInPlace)));
-		}
-
-		while (true) {
-			asyncJobQueue->FinishJobs();
-			bool hasJobs = false;
-			for (auto &handle : handles)
-				hasJobs |= handle.HasJob();
+		// models whose sources hash the same as when their output was
+		// written are skipped; the rest get a job each
+		const std::string outputPrefix = isInPlace ? "data:" : "user:";
+		std::map<std::string, uint64_t> hashes = LoadHashCache();
+		std::vector<uint64_t> newHashes(list_model.size());
+		std::vector<char> compiled(list_model.size(), false);
+		std::atomic<uint32_t> numSkipped(0);
+
+		s_taskGraph->ParallelFor(TaskRange{ 0, uint32_t(list_model.size()) }, 1, [&](TaskRange range) {
+			for (uint32_t i = range.begin; i < range.end; i++) {
+				const std::string &modelName = list_model[i].first;
+				const std::string &filePath = list_model[i].second;
+				newHashes[i] = HashModelSources(filePath, dataFiles);
+
+				// nothing writes to hashes until every job has finished
+				auto it = hashes.find(outputPrefix + GetSavePath(filePath));
+				if (it != hashes.end() && it->second == newHashes[i] && SceneGraph::BinaryConverter::SavedModelExists(GetSavePath(filePath), isInPlace)) {
+					compiled[i] = true;
+					numSkipped++;
+					continue;
+				}
 
-			if (!hasJobs)
-				break;
+				// renderers cache textures and materials, so each job needs its own
+				Graphics::RendererDummy renderer;
+				compiled[i] = RunCompiler(modelName, filePath, isInPlace, &renderer);
+			}
+		});
+
+		uint32_t numFailed = 0;
+		for (size_t i = 0; i < list_model.size(); i++) {
+			const std::string key = outputPrefix + GetSavePath(list_model[i].second);
+			if (compiled[i]) {
+				hashes[key] = newHashes[i];
+			} else {
+				hashes.erase(key);
+				numFailed++;
+			}
 		}
-#endif
+		SaveHashCache(hashes);
+
+		Output("\n---\nCompiled %u models, skipped %u unchanged, %u failed\n",
+			unsigned(list_model.size()) - numSkipped - numFailed, numSkipped.load(), numFailed);
 		break;
 	}
 
@@ -318,6 +390,8 @@ start:
 			"    -compile inplace  [-c ... inplace]  model compiler\n"
 			"    -batch            [-b]              batch mode output into users home/Pioneer directory\n"
 			"    -batch inplace    [-b inplace]      batch mode output into the source folder\n"
+			"                                        (batches skip models unchanged since the last one;\n"
+			"                                        delete modelcompiler.hashes to rebuild them all)\n"
 			"    -version          [-v]              show version\n"
 			"    -help             [-h,-?]           this help\n");
 		break;
@@ -327,12 +401,10 @@ start:
 	Profiler::dumphtml(FileSystem::JoinPathBelow(FileSystem::GetUserDir(), "profiler").c_str());
 #endif
 
+	s_taskGraph.reset();
 	Graphics::Uninit();
 	SDL_Quit();
 	FileSystem::Uninit();
-#ifdef USES_THREADS
-	asyncJobQueue.reset();
-#endif
 	//exit(0);
 
 	return 0;
@@ -2,8 +2,20 @@
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
 #include "perlin.h"
+#include <algorithm>
 #include <math.h>
 
+#if defined(__AVX__)
+#define PERLIN_AVX 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PERLIN_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define PERLIN_NEON 1
+#include <arm_neon.h>
+#endif
+
 /* Simplex.cpp
  *
  * Copyright 2007 Eliot Eshelman
@@ -202,6 +214,166 @@ double noise(const vector3d &p)
 	return 32.0 * (n0 + n1 + n2 + n3);
 }
 
+namespace {
+	// double vector of the widest selected instruction set
+	struct simd_double {
+#if defined(PERLIN_AVX)
+		static const int WIDTH = 4;
+		__m256d v;
+		static simd_double load(const double *p) { return { _mm256_loadu_pd(p) }; }
+		static simd_double set1(double d) { return { _mm256_set1_pd(d) }; }
+		void store(double *p) const { _mm256_storeu_pd(p, v); }
+		friend simd_double operator+(simd_double a, simd_double b) { return { _mm256_add_pd(a.v, b.v) }; }
+		friend simd_double operator-(simd_double a, simd_double b) { return { _mm256_sub_pd(a.v, b.v) }; }
+		friend simd_double operator*(simd_double a, simd_double b) { return { _mm256_mul_pd(a.v, b.v) }; }
+		friend simd_double max(simd_double a, simd_double b) { return { _mm256_max_pd(a.v, b.v) }; }
+		// lane l of the result is bit l, set where a >= b
+		friend int ge_bits(simd_double a, simd_double b) { return _mm256_movemask_pd(_mm256_cmp_pd(a.v, b.v, _CMP_GE_OQ)); }
+		// as fastfloor()
+		friend simd_double fastfloor(simd_double a)
+		{
+			const __m256d step = _mm256_and_pd(_mm256_cmp_pd(a.v, _mm256_setzero_pd(), _CMP_LE_OQ), _mm256_set1_pd(1.0));
+			return { _mm256_cvtepi32_pd(_mm256_cvttpd_epi32(_mm256_sub_pd(a.v, step))) };
+		}
+#elif defined(PERLIN_SSE2)
+		static const int WIDTH = 2;
+		__m128d v;
+		static simd_double load(const double *p) { return { _mm_loadu_pd(p) }; }
+		static simd_double set1(double d) { return { _mm_set1_pd(d) }; }
+		void store(double *p) const { _mm_storeu_pd(p, v); }
+		friend simd_double operator+(simd_double a, simd_double b) { return { _mm_add_pd(a.v, b.v) }; }
+		friend simd_double operator-(simd_double a, simd_double b) { return { _mm_sub_pd(a.v, b.v) }; }
+		friend simd_double operator*(simd_double a, simd_double b) { return { _mm_mul_pd(a.v, b.v) }; }
+		friend simd_double max(simd_double a, simd_double b) { return { _mm_max_pd(a.v, b.v) }; }
+		friend int ge_bits(simd_double a, simd_double b) { return _mm_movemask_pd(_mm_cmpge_pd(a.v, b.v)); }
+		friend simd_double fastfloor(simd_double a)
+		{
+			const __m128d step = _mm_and_pd(_mm_cmple_pd(a.v, _mm_setzero_pd()), _mm_set1_pd(1.0));
+			return { _mm_cvtepi32_pd(_mm_cvttpd_epi32(_mm_sub_pd(a.v, step))) };
+		}
+#elif defined(PERLIN_NEON)
+		static const int WIDTH = 2;
+		float64x2_t v;
+		static simd_double load(const double *p) { return { vld1q_f64(p) }; }
+		static simd_double set1(double d) { return { vdupq_n_f64(d) }; }
+		void store(double *p) const { vst1q_f64(p, v); }
+		friend simd_double operator+(simd_double a, simd_double b) { return { vaddq_f64(a.v, b.v) }; }
+		friend simd_double operator-(simd_double a, simd_double b) { return { vsubq_f64(a.v, b.v) }; }
+		friend simd_double operator*(simd_double a, simd_double b) { return { vmulq_f64(a.v, b.v) }; }
+		friend simd_double max(simd_double a, simd_double b) { return { vmaxq_f64(a.v, b.v) }; }
+		friend int ge_bits(simd_double a, simd_double b)
+		{
+			const uint64x2_t ge = vcgeq_f64(a.v, b.v);
+			return int(vgetq_lane_u64(ge, 0) & 1) | int(vgetq_lane_u64(ge, 1) & 2);
+		}
+		friend simd_double fastfloor(simd_double a)
+		{
+			const uint64x2_t le = vcleq_f64(a.v, vdupq_n_f64(0.0));
+			const float64x2_t step = vreinterpretq_f64_u64(vandq_u64(le, vreinterpretq_u64_f64(vdupq_n_f64(1.0))));
+			return { vcvtq_f64_s64(vcvtq_s64_f64(vsubq_f64(a.v, step))) };
+		}
+#else
+		static const int WIDTH = 1;
+		double v;
+		static simd_double load(const double *p) { return { *p }; }
+		static simd_double set1(double d) { return { d }; }
+		void store(double *p) const { *p = v; }
+		friend simd_double operator+(simd_double a, simd_double b) { return { a.v + b.v }; }
+		friend simd_double operator-(simd_double a, simd_double b) { return { a.v - b.v }; }
+		friend simd_double operator*(simd_double a, simd_double b) { return { a.v * b.v }; }
+		friend simd_double max(simd_double a, simd_double b) { return { std::max(a.v, b.v) }; }
+		friend int ge_bits(simd_double a, simd_double b) { return a.v >= b.v; }
+		friend simd_double fastfloor(simd_double a) { return { double(fastfloor(a.v)) }; }
+#endif
+	};
+
+	// contribution of one simplex corner at offset (x, y, z) with gradient g
+	inline simd_double corner(simd_double x, simd_double y, simd_double z, const double g[3][simd_double::WIDTH])
+	{
+		const simd_double dot = simd_double::load(g[0]) * x + simd_double::load(g[1]) * y + simd_double::load(g[2]) * z;
+		simd_double t = simd_double::set1(0.6) - x * x - y * y - z * z;
+		// a corner out of range contributes zero, as in the scalar version
+		t = max(t, simd_double::set1(0.0));
+		t = t * t;
+		return t * t * dot;
+	}
+} // namespace
+
+// The same steps as noise() above, a vector of points at a time. Only the
+// permutation table lookups are done per point.
+void noise(const vector3d *p, double *out, size_t count)
+{
+	const int W = simd_double::WIDTH;
+	const simd_double vF3 = simd_double::set1(F3), vG3 = simd_double::set1(G3);
+	const simd_double vG3mul2 = simd_double::set1(G3mul2), vG3mul3 = simd_double::set1(G3mul3);
+	const simd_double one = simd_double::set1(1.0);
+
+	size_t n = 0;
+	for (; n + W <= count; n += W) {
+		alignas(32) double px[W], py[W], pz[W];
+		for (int l = 0; l < W; l++)
+			px[l] = p[n + l].x, py[l] = p[n + l].y, pz[l] = p[n + l].z;
+		const simd_double x = simd_double::load(px), y = simd_double::load(py), z = simd_double::load(pz);
+
+		// skew to the simplex cell, and back to its origin
+		const simd_double s = (x + y + z) * vF3;
+		const simd_double i = fastfloor(x + s), j = fastfloor(y + s), k = fastfloor(z + s);
+		const simd_double t = (i + j + k) * vG3;
+		const simd_double x0 = x - (i - t), y0 = y - (j - t), z0 = z - (k - t);
+
+		alignas(32) double ci[W], cj[W], ck[W];
+		i.store(ci), j.store(cj), k.store(ck);
+		const int x_ge_y_bits = ge_bits(x0, y0);
+		const int y_ge_z_bits = ge_bits(y0, z0);
+		const int x_ge_z_bits = ge_bits(x0, z0);
+
+		// simplex corner offsets and hashed gradients
+		alignas(32) double o1[3][W], o2[3][W], g[4][3][W];
+		for (int l = 0; l < W; l++) {
+			const int x_ge_y = (x_ge_y_bits >> l) & 1;
+			const int y_ge_z = (y_ge_z_bits >> l) & 1;
+			const int x_ge_z = (x_ge_z_bits >> l) & 1;
+			const int i1 = x_ge_y & x_ge_z;
+			const int j1 = y_ge_z & (!x_ge_y);
+			const int k1 = (!x_ge_z) & (!y_ge_z);
+			const int i2 = x_ge_y | x_ge_z;
+			const int j2 = (!x_ge_y) | y_ge_z;
+			const int k2 = !(x_ge_z & y_ge_z);
+			o1[0][l] = i1, o1[1][l] = j1, o1[2][l] = k1;
+			o2[0][l] = i2, o2[1][l] = j2, o2[2][l] = k2;
+
+			const int ii = int(ci[l]) & 255;
+			const int jj = int(cj[l]) & 255;
+			const int kk = int(ck[l]) & 255;
+			const int gi[4] = {
+				mod12[perm[ii + perm[jj + perm[kk]]]],
+				mod12[perm[ii + i1 + perm[jj + j1 + perm[kk + k1]]]],
+				mod12[perm[ii + i2 + perm[jj + j2 + perm[kk + k2]]]],
+				mod12[perm[ii + 1 + perm[jj + 1 + perm[kk + 1]]]]
+			};
+			for (int c = 0; c < 4; c++)
+				g[c][0][l] = grad3[gi[c]][0], g[c][1][l] = grad3[gi[c]][1], g[c][2][l] = grad3[gi[c]][2];
+		}
+
+		const simd_double x1 = x0 - simd_double::load(o1[0]) + vG3;
+		const simd_double y1 = y0 - simd_double::load(o1[1]) + vG3;
+		const simd_double z1 = z0 - simd_double::load(o1[2]) + vG3;
+		const simd_double x2 = x0 - simd_double::load(o2[0]) + vG3mul2;
+		const simd_double y2 = y0 - simd_double::load(o2[1]) + vG3mul2;
+		const simd_double z2 = z0 - simd_double::load(o2[2]) + vG3mul2;
+		const simd_double x3 = x0 - one + vG3mul3;
+		const simd_double y3 = y0 - one + vG3mul3;
+		const simd_double z3 = z0 - one + vG3mul3;
+
+		const simd_double sum = corner(x0, y0, z0, g[0]) + corner(x1, y1, z1, g[1]) +
+			corner(x2, y2, z2, g[2]) + corner(x3, y3, z3, g[3]);
+		(simd_double::set1(32.0) * sum).store(&out[n]);
+	}
+
+	for (; n < count; n++)
+		out[n] = noise(p[n]);
+}
+
 #ifdef UNIT_TEST
 #include <stdio.h>
 #include <stdlib.h>
@@ -6,6 +6,10 @@
 
 #include "vector3.h"
 
+#include <cstddef>
+
 double noise(const vector3d &p);
+// noise() of count points, several at a time with SIMD
+void noise(const vector3d *p, double *out, size_t count);
 
 #endif /* _PERLIN_H */
@@ -0,0 +1,224 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "CachedPanel.h"
+
+#include "profiler/Profiler.h"
+
+#include "imgui/imgui_internal.h"
+
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+	// panels not drawn for this many frames are forgotten
+	static const int CACHED_PANEL_EXPIRY_FRAMES = 300;
+
+	struct CachedCmd {
+		ImTextureID texture;
+		ImVec4 clipRect; // relative to the window position
+		uint32_t vtxOffset;
+		uint32_t vtxCount;
+		uint32_t idxOffset;
+		uint32_t idxCount;
+	};
+
+	struct CachedPanel {
+		bool valid = false;
+		bool uncacheable = false;
+		int lastUsedFrame = 0;
+
+		// state the recorded geometry depends on
+		ImVec2 size;
+		ImVec2 scroll;
+		ImTextureID fontTexture = 0;
+
+		ImVec2 cursorMaxPos; // relative to the window position
+		std::vector<CachedCmd> cmds;
+		std::vector<ImDrawVert> vtx; // positions relative to the window position
+		std::vector<ImDrawIdx> idx;
+	};
+
+	struct ActivePanel {
+		ImGuiID id;
+		bool capturing;
+		int startIdx;
+	};
+
+	std::unordered_map<ImGuiID, CachedPanel> s_panels;
+	std::vector<ActivePanel> s_active;
+	int s_lastExpiryFrame = -1;
+
+	inline bool same_vec2(const ImVec2 &a, const ImVec2 &b)
+	{
+		return a.x == b.x && a.y == b.y;
+	}
+
+	void expire_panels(int frame)
+	{
+		if (frame == s_lastExpiryFrame)
+			return;
+		s_lastExpiryFrame = frame;
+
+		for (auto it = s_panels.begin(); it != s_panels.end();) {
+			if (frame - it->second.lastUsedFrame > CACHED_PANEL_EXPIRY_FRAMES)
+				it = s_panels.erase(it);
+			else
+				++it;
+		}
+	}
+
+	bool has_child_windows(const ImGuiContext &ctx, const ImGuiWindow *window)
+	{
+		for (const ImGuiWindow *w : ctx.Windows) {
+			if (w->ParentWindow == window && w->LastFrameActive == ctx.FrameCount)
+				return true;
+		}
+		return false;
+	}
+
+	void capture(CachedPanel &panel, ImGuiWindow *window, int startIdx)
+	{
+		PROFILE_SCOPED()
+		const ImDrawList *dl = window->DrawList;
+		const ImVec2 origin = window->Pos;
+
+		panel.cmds.clear();
+		panel.vtx.clear();
+		panel.idx.clear();
+		panel.uncacheable = has_child_windows(*ImGui::GetCurrentContext(), window);
+
+		for (const ImDrawCmd &cmd : dl->CmdBuffer) {
+			if (cmd.UserCallback) {
+				panel.uncacheable = true;
+				break;
+			}
+
+			// only keep what was submitted after BeginChild; the window
+			// background is redrawn by BeginChild on replay
+			const int begin = std::max(int(cmd.IdxOffset), startIdx);
+			const int end = int(cmd.IdxOffset + cmd.ElemCount);
+			if (begin >= end)
+				continue;
+
+			ImDrawIdx minIdx = dl->IdxBuffer[begin];
+			ImDrawIdx maxIdx = minIdx;
+			for (int i = begin; i < end; i++) {
+				minIdx = std::min(minIdx, dl->IdxBuffer[i]);
+				maxIdx = std::max(maxIdx, dl->IdxBuffer[i]);
+			}
+
+			CachedCmd cc;
+			cc.texture = cmd.TextureId;
+			cc.clipRect = ImVec4(cmd.ClipRect.x - origin.x, cmd.ClipRect.y - origin.y, cmd.ClipRect.z - origin.x, cmd.ClipRect.w - origin.y);
+			cc.vtxOffset = uint32_t(panel.vtx.size());
+			cc.vtxCount = uint32_t(maxIdx - minIdx) + 1;
+			cc.idxOffset = uint32_t(panel.idx.size());
+			cc.idxCount = uint32_t(end - begin);
+			panel.cmds.push_back(cc);
+
+			const ImDrawVert *src = dl->VtxBuffer.Data + cmd.VtxOffset + minIdx;
+			for (uint32_t i = 0; i < cc.vtxCount; i++) {
+				ImDrawVert v = src[i];
+				v.pos = v.pos - origin;
+				panel.vtx.push_back(v);
+			}
+			for (int i = begin; i < end; i++)
+				panel.idx.push_back(ImDrawIdx(dl->IdxBuffer[i] - minIdx));
+		}
+
+		panel.valid = !panel.uncacheable;
+		panel.size = window->Size;
+		panel.scroll = window->Scroll;
+		panel.fontTexture = ImGui::GetIO().Fonts->TexID;
+		panel.cursorMaxPos = window->DC.CursorMaxPos - origin;
+	}
+
+	void replay(const CachedPanel &panel, ImGuiWindow *window)
+	{
+		PROFILE_SCOPED()
+		ImDrawList *dl = window->DrawList;
+		const ImVec2 origin = window->Pos;
+
+		for (const CachedCmd &cc : panel.cmds) {
+			dl->PushClipRect(ImVec2(cc.clipRect.x, cc.clipRect.y) + origin, ImVec2(cc.clipRect.z, cc.clipRect.w) + origin, false);
+			dl->PushTextureID(cc.texture);
+
+			// PrimReserve may start a new vertex offset, so read the base index afterwards
+			dl->PrimReserve(int(cc.idxCount), int(cc.vtxCount));
+			const unsigned int base = dl->_VtxCurrentIdx;
+
+			const ImDrawVert *vtx = panel.vtx.data() + cc.vtxOffset;
+			for (uint32_t i = 0; i < cc.vtxCount; i++) {
+				ImDrawVert v = vtx[i];
+				v.pos = v.pos + origin;
+				*dl->_VtxWritePtr++ = v;
+			}
+			const ImDrawIdx *idx = panel.idx.data() + cc.idxOffset;
+			for (uint32_t i = 0; i < cc.idxCount; i++)
+				*dl->_IdxWritePtr++ = ImDrawIdx(base + idx[i]);
+			dl->_VtxCurrentIdx += cc.vtxCount;
+
+			dl->PopTextureID();
+			dl->PopClipRect();
+		}
+
+		// keep the content size so scrolling and auto-resize behave as if the
+		// contents had been submitted
+		window->DC.CursorMaxPos = ImMax(window->DC.CursorMaxPos, panel.cursorMaxPos + origin);
+	}
+
+} // namespace
+
+bool PiGui::BeginCachedChild(const char *id, const ImVec2 &size, ImGuiWindowFlags flags, bool dirty)
+{
+	PROFILE_SCOPED()
+	const ImGuiID key = ImGui::GetID(id);
+	ImGui::BeginChild(id, size, false, flags);
+
+	ImGuiContext &ctx = *ImGui::GetCurrentContext();
+	ImGuiWindow *window = ImGui::GetCurrentWindow();
+	CachedPanel &panel = s_panels[key];
+	panel.lastUsedFrame = ctx.FrameCount;
+
+	// anything the user is interacting with has to run its widget code
+	const bool hovered = ImGui::IsMouseHoveringRect(window->Pos, window->Pos + window->Size, false);
+	const bool active = ctx.ActiveId != 0 && ctx.ActiveIdWindow &&
+		(ctx.ActiveIdWindow == window || ctx.ActiveIdWindow->ParentWindow == window);
+
+	const bool canReplay = panel.valid && !dirty && !hovered && !active &&
+		same_vec2(panel.size, window->Size) &&
+		same_vec2(panel.scroll, window->Scroll) &&
+		panel.fontTexture == ImGui::GetIO().Fonts->TexID;
+
+	if (canReplay) {
+		replay(panel, window);
+		s_active.push_back({ key, false, 0 });
+		return false;
+	}
+
+	s_active.push_back({ key, true, window->DrawList->IdxBuffer.Size });
+	return true;
+}
+
+void PiGui::EndCachedChild()
+{
+	PROFILE_SCOPED()
+	assert(!s_active.empty());
+	const ActivePanel active = s_active.back();
+	s_active.pop_back();
+
+	if (active.capturing)
+		capture(s_panels[active.id], ImGui::GetCurrentWindow(), active.startIdx);
+
+	ImGui::EndChild();
+
+	if (s_active.empty())
+		expire_panels(ImGui::GetFrameCount());
+}
+
+void PiGui::ClearCachedChildren()
+{
+	s_panels.clear();
+}
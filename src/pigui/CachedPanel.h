@@ -0,0 +1,31 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#pragma once
+
+#include "imgui/imgui.h"
+
+namespace PiGui {
+
+	/*
+	 * Retained child windows for UI panels whose contents rarely change.
+	 *
+	 * BeginCachedChild opens a child window like ImGui::BeginChild. If it
+	 * returns true the caller must submit the contents as usual and then call
+	 * EndCachedChild, which records the geometry it produced. On later frames
+	 * it returns false and replays the recorded geometry instead, so the
+	 * (usually Lua) code building the panel does not run at all. EndCachedChild
+	 * must be called in both cases.
+	 *
+	 * A panel is redrawn when the caller passes dirty, when it is resized or
+	 * scrolled, while the mouse is over it, while one of its widgets is active
+	 * and after the font atlas is rebuilt. Panels containing nested child
+	 * windows or draw callbacks can't be replayed and are always redrawn.
+	 */
+	bool BeginCachedChild(const char *id, const ImVec2 &size, ImGuiWindowFlags flags, bool dirty);
+	void EndCachedChild();
+
+	// Drop all recorded panels, e.g. when the UI scale or theme changes
+	void ClearCachedChildren();
+
+} // namespace PiGui
@@ -3,10 +3,121 @@
 
 #include "Face.h"
 #include "FileSystem.h"
+#include "MathUtil.h"
 #include "SDLWrappers.h"
-#include "graphics/TextureBuilder.h"
+#include "core/TaskGraph.h"
+#include "graphics/Renderer.h"
 #include "profiler/Profiler.h"
 
+#include <array>
+#include <list>
+#include <map>
+
+namespace {
+	// portraits are kept by their resolved face parts, which is everything
+	// the image depends on
+	using FaceKey = std::array<int, 11>;
+	static const size_t FACE_CACHE_SIZE = 32;
+
+	// most recently used at the front
+	std::list<std::pair<FaceKey, RefCountedPtr<Graphics::Texture>>> s_faceCache;
+	std::map<FaceKey, decltype(s_faceCache)::iterator> s_faceCacheIndex;
+
+	FaceKey MakeFaceKey(const FaceParts::FaceDescriptor &face)
+	{
+		return { face.species, face.race, face.gender, face.head, face.eyes, face.nose,
+			face.mouth, face.hairstyle, face.accessories, face.clothes, face.armour };
+	}
+
+	Graphics::Texture *FindCachedFace(const FaceKey &key)
+	{
+		auto it = s_faceCacheIndex.find(key);
+		if (it == s_faceCacheIndex.end())
+			return nullptr;
+		s_faceCache.splice(s_faceCache.begin(), s_faceCache, it->second);
+		return it->second->second.Get();
+	}
+
+	void AddCachedFace(const FaceKey &key, Graphics::Texture *texture)
+	{
+		s_faceCache.emplace_front(key, RefCountedPtr<Graphics::Texture>(texture));
+		s_faceCacheIndex[key] = s_faceCache.begin();
+
+		// textures still shown by a Face stay alive through its own reference
+		while (s_faceCache.size() > FACE_CACHE_SIZE) {
+			s_faceCacheIndex.erase(s_faceCache.back().first);
+			s_faceCache.pop_back();
+		}
+	}
+
+	// Same layout TextureBuilder gives a face image: RGBA, extended to a power of two
+	Graphics::TextureDescriptor GetFaceTextureDescriptor()
+	{
+		const float width = ceil_pow2(FaceParts::FACE_WIDTH);
+		const float height = ceil_pow2(FaceParts::FACE_HEIGHT);
+		return Graphics::TextureDescriptor(Graphics::TEXTURE_RGBA_8888,
+			vector3f(width, height, 1.0f), vector2f(FaceParts::FACE_WIDTH / width, FaceParts::FACE_HEIGHT / height),
+			Graphics::LINEAR_CLAMP, true, true, true, 0, Graphics::TEXTURE_2D);
+	}
+
+	// Uploads a composited face on the main thread and releases the texture
+	// reference taken for the compositing task
+	class UploadFaceTask : public Task {
+	public:
+		UploadFaceTask(Graphics::Texture *texture, SDLSurfacePtr image) :
+			m_texture(texture),
+			m_image(image)
+		{
+		}
+
+		virtual void OnExecute(TaskRange range) override
+		{
+			PROFILE_SCOPED()
+			if (m_image)
+				m_texture->Update(m_image->pixels, m_texture->GetDescriptor().dataSize, Graphics::TEXTURE_RGBA_8888);
+			m_texture->DecRefCount();
+		}
+
+	private:
+		Graphics::Texture *m_texture;
+		SDLSurfacePtr m_image;
+	};
+
+	// Blits the face parts together on a worker thread
+	class ComposeFaceTask : public Task {
+	public:
+		ComposeFaceTask(Graphics::Texture *texture, const FaceParts::FaceDescriptor &face) :
+			m_texture(texture),
+			m_face(face)
+		{
+			// released on the main thread by UploadFaceTask
+			m_texture->IncRefCount();
+		}
+
+		virtual void OnExecute(TaskRange range) override
+		{
+			PROFILE_SCOPED()
+			const vector3f &dataSize = m_texture->GetDescriptor().dataSize;
+
+			SDLSurfacePtr faceim = SDLSurfacePtr::WrapNew(SDL_CreateRGBSurface(SDL_SWSURFACE, FaceParts::FACE_WIDTH, FaceParts::FACE_HEIGHT, 24, 0xff, 0xff00, 0xff0000, 0));
+			SDLSurfacePtr image = SDLSurfacePtr::WrapNew(SDL_CreateRGBSurface(SDL_SWSURFACE, int(dataSize.x), int(dataSize.y), 32, 0xff, 0xff00, 0xff0000, 0xff000000));
+			if (faceim && image) {
+				FaceParts::BuildFaceImage(faceim.Get(), m_face);
+				SDL_SetSurfaceBlendMode(faceim.Get(), SDL_BLENDMODE_NONE);
+				SDL_BlitSurface(faceim.Get(), 0, image.Get(), 0);
+			} else {
+				image.Reset();
+			}
+
+			Pi::GetApp()->GetTaskGraph()->QueueTaskPinned(new UploadFaceTask(m_texture, image));
+		}
+
+	private:
+		Graphics::Texture *m_texture;
+		FaceParts::FaceDescriptor m_face;
+	};
+} // namespace
+
 namespace PiGui {
 
 	Face::Face(FaceParts::FaceDescriptor &face, Uint32 seed)
@@ -16,12 +127,25 @@ namespace PiGui {
 
 		m_seed = seed;
 
-		SDLSurfacePtr faceim = SDLSurfacePtr::WrapNew(SDL_CreateRGBSurface(SDL_SWSURFACE, FaceParts::FACE_WIDTH, FaceParts::FACE_HEIGHT, 24, 0xff, 0xff00, 0xff0000, 0));
-
 		FaceParts::PickFaceParts(face, m_seed);
-		FaceParts::BuildFaceImage(faceim.Get(), face);
 
-		m_texture.Reset(Graphics::TextureBuilder(faceim, Graphics::LINEAR_CLAMP, true, true).GetOrCreateTexture(Pi::renderer, std::string("face")));
+		const FaceKey key = MakeFaceKey(face);
+		if (Graphics::Texture *cached = FindCachedFace(key)) {
+			m_texture.Reset(cached);
+			return;
+		}
+
+		// the texture is blank until the composited image is uploaded
+		m_texture.Reset(Pi::renderer->CreateTexture(GetFaceTextureDescriptor()));
+		AddCachedFace(key, m_texture.Get());
+
+		Pi::GetApp()->GetTaskGraph()->QueueTask(new ComposeFaceTask(m_texture.Get(), face));
+	}
+
+	void Face::ClearCache()
+	{
+		s_faceCacheIndex.clear();
+		s_faceCache.clear();
 	}
 
 	void *Face::GetImTextureID()
@@ -14,8 +14,13 @@ namespace PiGui {
 
 	class Face : public RefCounted {
 	public:
+		// The portrait is composited in the background and shown once
+		// uploaded; recently generated portraits are reused from a cache.
 		Face(FaceParts::FaceDescriptor &face, Uint32 seed = 0);
 
+		// Drops the cached portrait textures, before the renderer goes away
+		static void ClearCache();
+
 		void *GetImTextureID();
 		vector2f GetTextureSize();
 
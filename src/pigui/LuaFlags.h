@@ -5,6 +5,8 @@
 
 #include "enum_table.h"
 #include "utils.h"
+#include <cmath>
+#include <cstdint>
 #include <lua.hpp>
 #include <stdexcept>
 #include <string>
@@ -15,6 +17,8 @@ struct LuaFlags {
 	std::vector<std::pair<const char *, FlagType>> LUT;
 	std::string typeName;
 	int lookupTableRef = LUA_NOREF;
+	// weak-keyed table of flag tables already parsed, see LookupTable
+	int cacheTableRef = LUA_NOREF;
 
 	// directly emplace from an initializer_list
 	LuaFlags(std::initializer_list<std::pair<const char *, FlagType>> init) :
@@ -44,29 +48,56 @@ struct LuaFlags {
 
 		// luaL_ref pops the table off the stack.
 		lookupTableRef = luaL_ref(l, LUA_REGISTRYINDEX);
+
+		lua_newtable(l);
+		lua_newtable(l);
+		lua_pushstring(l, "k");
+		lua_setfield(l, -2, "__mode");
+		lua_setmetatable(l, -2);
+		cacheTableRef = luaL_ref(l, LUA_REGISTRYINDEX);
 	}
 
 	void Unregister(lua_State *l)
 	{
 		luaL_unref(l, LUA_REGISTRYINDEX, lookupTableRef);
+		luaL_unref(l, LUA_REGISTRYINDEX, cacheTableRef);
 		lookupTableRef = LUA_NOREF;
+		cacheTableRef = LUA_NOREF;
 	}
 
 	// Parse a table of string flags or single flag into a bitwise-or'd bitflag value
+	//
+	// UI code mostly passes the same constant flag tables every frame, so the
+	// result is cached per table object together with the table's length,
+	// and only recomputed if the length changes. Replacing a flag in place
+	// without changing the length is not picked up.
 	FlagType LookupTable(lua_State *l, int index)
 	{
 		FlagType flagAccum = FlagType(0);
 		index = lua_absindex(l, index);
 		if (!lua_istable(l, index) || lookupTableRef == LUA_NOREF) return flagAccum;
 
-		lua_checkstack(l, 2);
-		lua_pushinteger(l, lookupTableRef);
-		lua_gettable(l, LUA_REGISTRYINDEX);
+		const size_t length = lua_rawlen(l, index);
 
-		int table_idx = 1;
-		while (true) {
-			lua_pushinteger(l, table_idx++);
-			lua_gettable(l, index);
+		lua_checkstack(l, 3);
+		lua_rawgeti(l, LUA_REGISTRYINDEX, cacheTableRef);
+		lua_pushvalue(l, index);
+		lua_rawget(l, -2);
+		if (lua_isnumber(l, -1)) {
+			// cached as length * 2^32 + flags, exact in a double
+			const double cached = lua_tonumber(l, -1);
+			const double cachedLength = std::floor(cached / 4294967296.0);
+			if (size_t(cachedLength) == length) {
+				lua_pop(l, 2);
+				return static_cast<FlagType>(uint32_t(cached - cachedLength * 4294967296.0));
+			}
+		}
+		lua_pop(l, 1);
+
+		lua_rawgeti(l, LUA_REGISTRYINDEX, lookupTableRef);
+
+		for (size_t table_idx = 1; table_idx <= length; table_idx++) {
+			lua_rawgeti(l, index, table_idx);
 
 			if (!lua_isstring(l, -1)) {
 				lua_pop(l, 1);
@@ -77,6 +108,13 @@ struct LuaFlags {
 		}
 
 		lua_pop(l, 1);
+
+		// store in the cache table left on the stack
+		lua_pushvalue(l, index);
+		lua_pushnumber(l, double(length) * 4294967296.0 + double(uint32_t(flagAccum)));
+		lua_rawset(l, -3);
+		lua_pop(l, 1);
+
 		return flagAccum;
 	}
 
@@ -88,8 +126,7 @@ struct LuaFlags {
 		if (!lua_isstring(l, index) || lookupTableRef == LUA_NOREF) return flagAccum;
 
 		lua_checkstack(l, 2);
-		lua_pushinteger(l, lookupTableRef);
-		lua_gettable(l, LUA_REGISTRYINDEX);
+		lua_rawgeti(l, LUA_REGISTRYINDEX, lookupTableRef);
 
 		return checkFlag(l, index, -1);
 	}
@@ -99,7 +136,7 @@ private:
 	{
 		lookup_index = lua_absindex(l, lookup_index);
 		lua_pushvalue(l, index);
-		lua_gettable(l, lookup_index);
+		lua_rawget(l, lookup_index);
 		if (lua_isnumber(l, -1)) {
 			// bitwise operations implicitly convert to int, so we must explicitly convert back to FlagType.
 			FlagType fl_ret = static_cast<FlagType>(lua_tointeger(l, -1));
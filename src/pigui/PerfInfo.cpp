@@ -7,19 +7,33 @@
 #include "Input.h"
 #include "LuaPiGui.h"
 #include "Pi.h"
+#include "PiGui.h"
+#include "PiGuiRenderer.h"
 #include "Player.h"
 #include "SectorView.h"
 #include "Space.h"
+#include "core/FrameTimeline.h"
 #include "core/Log.h"
+#include "core/MemoryStats.h"
+#include "core/TaskGraph.h"
+#include "galaxy/Galaxy.h"
+#include "graphics/DynamicResolution.h"
+#include "graphics/Graphics.h"
 #include "graphics/Renderer.h"
 #include "graphics/Stats.h"
 #include "graphics/Texture.h"
+#include "graphics/TextureLoader.h"
+#include "graphics/TextureStreamer.h"
 #include "lua/Lua.h"
+#include "lua/LuaEvent.h"
 #include "lua/LuaManager.h"
 #include "scenegraph/Model.h"
+#include "ship/PathCheckCache.h"
+#include "sound/Sound.h"
 
 #include <fmt/core.h>
 #include <imgui/imgui.h>
+#include <imgui/imgui_internal.h>
 #include <algorithm>
 #include <cstddef>
 #include <fstream>
@@ -48,6 +62,8 @@ struct PerfInfo::ImGuiState {
 
 	bool hasSelectedTexture = false;
 	std::pair<std::string, std::string> selectedTexture;
+
+	float timelineScale = 40.f; // pixels per millisecond
 };
 
 PerfInfo::PerfInfo() :
@@ -226,6 +242,11 @@ void PerfInfo::DrawPerfWindow()
 		if (process_mem.currentMemSize)
 			ImGui::Text("%.1f MB process memory usage (%.1f MB peak)", (process_mem.currentMemSize * 1e-3), (process_mem.peakMemSize * 1e-3));
 		ImGui::Text("%.3f MB Lua memory usage", double(lua_mem) / scale_MB);
+
+		const Sound::Stats soundStats = Sound::GetStats();
+		ImGui::Text("%.3f MB audio memory, %u streams decoding (%.2f ms/s), %.1f ms decoding at load",
+			double(MemoryStats::Get(MemoryStats::TAG_AUDIO).current) / scale_MB,
+			soundStats.numStreams, soundStats.streamDecodeMs, soundStats.loadDecodeMs);
 		ImGui::Spacing();
 
 		if (ImGui::BeginTabBar("PerfInfoTabs")) {
@@ -235,6 +256,31 @@ void PerfInfo::DrawPerfWindow()
 				ImGui::EndTabItem();
 			}
 
+			if (ImGui::BeginTabItem("Jobs")) {
+				DrawJobStats();
+				ImGui::EndTabItem();
+			}
+
+			if (ImGui::BeginTabItem("Lua")) {
+				DrawLuaProfiler();
+				ImGui::EndTabItem();
+			}
+
+			if (ImGui::BeginTabItem("Memory")) {
+				DrawMemoryStats();
+				ImGui::EndTabItem();
+			}
+
+			if (ImGui::BeginTabItem("Timeline")) {
+				DrawFrameTimeline();
+				ImGui::EndTabItem();
+			}
+
+			if (ImGui::BeginTabItem("Events")) {
+				DrawStatList(LuaEvent::GetStats().GetFrameStats());
+				ImGui::EndTabItem();
+			}
+
 			if (false && ImGui::BeginTabItem("Input")) {
 				DrawInputDebug();
 				ImGui::EndTabItem();
@@ -245,6 +291,11 @@ void PerfInfo::DrawPerfWindow()
 					DrawWorldViewStats();
 					ImGui::EndTabItem();
 				}
+
+				if (ImGui::BeginTabItem("Galaxy")) {
+					DrawGalaxyCacheStats();
+					ImGui::EndTabItem();
+				}
 			}
 
 			PiGui::RunHandler(Pi::GetFrameTime(), "debug-tabs");
@@ -266,6 +317,8 @@ void PerfInfo::DrawRendererStats()
 	const Uint32 numLines = stats.m_stats[Graphics::Stats::STAT_NUM_LINES];
 	const Uint32 numPoints = stats.m_stats[Graphics::Stats::STAT_NUM_POINTS];
 	const Uint32 numCmdListFlushes = stats.m_stats[Graphics::Stats::STAT_NUM_CMDLIST_FLUSHES];
+	const Uint32 numProgramBindsSaved = stats.m_stats[Graphics::Stats::STAT_PROGRAM_BINDS_SAVED];
+	const Uint32 numTextureBindsSaved = stats.m_stats[Graphics::Stats::STAT_TEXTURE_BINDS_SAVED];
 	const Uint32 numBuffersCreated = stats.m_stats[Graphics::Stats::STAT_CREATE_BUFFER];
 	const Uint32 numBuffersInUse = stats.m_stats[Graphics::Stats::STAT_BUFFER_INUSE];
 	const Uint32 numDynamicBuffersCreated = stats.m_stats[Graphics::Stats::STAT_DYNAMIC_DRAW_BUFFER_CREATED];
@@ -303,9 +356,54 @@ void PerfInfo::DrawRendererStats()
 	ImGui::Text("%u points", numPoints);
 	ImGui::Text("%u lines", numLines);
 	ImGui::Text("%u tris (%.2fM tris/sec)", numTris, numTris * framesThisSecond * 1e-6);
+	if (numProgramBindsSaved || numTextureBindsSaved)
+		ImGui::Text("%u program and %u texture binds saved by sorting", numProgramBindsSaved, numTextureBindsSaved);
 	ImGui::Unindent();
 	ImGui::Spacing();
 
+	if (const Graphics::DynamicResolution *dynRes = Pi::GetApp()->GetDynamicResolution()) {
+		ImGui::Text("Scene resolution: %.1f%% (%dx%d)", dynRes->GetScale() * 100.0f,
+			dynRes->GetScaledSize(Graphics::GetScreenWidth()), dynRes->GetScaledSize(Graphics::GetScreenHeight()));
+		ImGui::Text("Scene GPU time: %.2f ms (%.2f ms smoothed, target %.2f ms)",
+			dynRes->GetGPUTime(), dynRes->GetSmoothedGPUTime(), dynRes->GetTargetTime());
+		ImGui::Spacing();
+	}
+
+	const auto &gpuZones = Pi::renderer->GetGPUZoneTimes();
+	if (!gpuZones.empty()) {
+		// zones drawn more than once (e.g. a GeoSphere per planet) are summed
+		std::vector<Graphics::Renderer::GPUZoneTime> passes;
+		std::vector<uint32_t> counts;
+		for (const auto &zone : gpuZones) {
+			auto iter = std::find_if(passes.begin(), passes.end(), [&](const auto &pass) {
+				return pass.depth == zone.depth && strcmp(pass.name, zone.name) == 0;
+			});
+			if (iter == passes.end()) {
+				passes.push_back(zone);
+				counts.push_back(1);
+			} else {
+				iter->durationMs += zone.durationMs;
+				counts[iter - passes.begin()]++;
+			}
+		}
+
+		ImGui::Text("GPU time by pass:");
+		ImGui::Indent();
+		for (size_t i = 0; i < passes.size(); i++) {
+			const float indent = ImGui::GetStyle().IndentSpacing * passes[i].depth;
+			if (indent > 0.f)
+				ImGui::Indent(indent);
+			if (counts[i] > 1)
+				ImGui::Text("%s: %.3f ms (%u)", passes[i].name, passes[i].durationMs, counts[i]);
+			else
+				ImGui::Text("%s: %.3f ms", passes[i].name, passes[i].durationMs);
+			if (indent > 0.f)
+				ImGui::Unindent(indent);
+		}
+		ImGui::Unindent();
+		ImGui::Spacing();
+	}
+
 	ImGui::Text("%u Buildings, %u Cities, %u Gd.Stations, %u Sp.Stations",
 		numDrawBuildings, numDrawCities, numDrawGroundStations, numDrawSpaceStations);
 	ImGui::Text("%u Atmospheres, %u Planets, %u Gas Giants, %u Stars, %u Ships",
@@ -370,6 +468,15 @@ void PerfInfo::DrawWorldViewStats()
 
 	ImGui::TextUnformatted(aibuf);
 
+	const PathCheckCache::Stats pathChecks = PathCheckCache::GetStats();
+	const uint64_t totalChecks = pathChecks.checks + pathChecks.saved;
+	tempStr = fmt::format("AI path checks: {} run, {} saved ({:.1f}%)",
+		pathChecks.checks, pathChecks.saved, totalChecks ? 100.0 * pathChecks.saved / totalChecks : 0.0);
+	ImGui::TextUnformatted(tempStr.c_str());
+	ImGui::SameLine();
+	if (ImGui::SmallButton("Reset##PathChecks"))
+		PathCheckCache::ResetStats();
+
 	ImGui::Spacing();
 	ImGui::TextUnformatted("Player Model ShowFlags:");
 
@@ -471,6 +578,45 @@ void PerfInfo::DrawImGuiStats()
 	ImGui::Text("%d active windows (%d visible)", io.MetricsActiveWindows, io.MetricsRenderWindows);
 	ImGui::Text("%d current allocations", io.MetricsActiveAllocations);
 
+	const PiGui::InstanceRenderer::Stats &stats = Pi::pigui->GetRenderer()->GetStats();
+	ImGui::Text("%u draw commands merged into %u draw calls", stats.numCommands, stats.numDraws);
+	ImGui::Text("%u verts, %u indices uploaded", stats.numVertices, stats.numIndices);
+
+	ImGui::NewLine();
+	ImGui::Text("Per-window draw lists (windows drawn later this frame show last frame's data):");
+
+	std::vector<ImGuiWindow *> windows;
+	for (ImGuiWindow *window : ImGui::GetCurrentContext()->Windows) {
+		if (window->WasActive && window->DrawList)
+			windows.push_back(window);
+	}
+	std::sort(windows.begin(), windows.end(), [](const ImGuiWindow *a, const ImGuiWindow *b) {
+		return a->DrawList->VtxBuffer.Size > b->DrawList->VtxBuffer.Size;
+	});
+
+	if (ImGui::BeginTable("##imgui_windows", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+		ImGui::TableSetupColumn("Window", ImGuiTableColumnFlags_WidthStretch);
+		ImGui::TableSetupColumn("Verts");
+		ImGui::TableSetupColumn("Tris");
+		ImGui::TableSetupColumn("Cmds");
+		ImGui::TableHeadersRow();
+
+		for (const ImGuiWindow *window : windows) {
+			const ImDrawList *list = window->DrawList;
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted(window->Name);
+			ImGui::TableNextColumn();
+			ImGui::Text("%d", list->VtxBuffer.Size);
+			ImGui::TableNextColumn();
+			ImGui::Text("%d", list->IdxBuffer.Size / 3);
+			ImGui::TableNextColumn();
+			ImGui::Text("%d", list->CmdBuffer.Size);
+		}
+
+		ImGui::EndTable();
+	}
+
 	if (ImGui::Button("Toggle Metrics Window")) {
 		m_state->metricsWindowOpen = !m_state->metricsWindowOpen;
 	}
@@ -480,6 +626,303 @@ void PerfInfo::DrawImGuiStats()
 	}
 }
 
+void PerfInfo::DrawJobStats()
+{
+	TaskGraph *graph = Pi::GetApp()->GetTaskGraph();
+	ImGui::Text("%u worker threads", graph->GetNumWorkerThreads());
+	for (uint32_t idx = 1; idx <= graph->GetNumWorkerThreads(); idx++) {
+		const float utilisation = graph->GetWorkerUtilisation(idx);
+		ImGui::ProgressBar(utilisation, { 200, 0 }, fmt::format("{:.1f}%", utilisation * 100.f).c_str());
+		ImGui::SameLine();
+		ImGui::Text("Thread %u", idx);
+	}
+	ImGui::Spacing();
+
+	DrawStatList(graph->GetStats().GetFrameStats());
+}
+
+// Texture sizes are what the driver was asked for, and models count only
+// the scenegraph nodes each instance owns.
+void PerfInfo::DrawMemoryStats()
+{
+	if (!ImGui::BeginTable("MemoryStats", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit))
+		return;
+
+	ImGui::TableSetupColumn("Subsystem", ImGuiTableColumnFlags_WidthStretch);
+	ImGui::TableSetupColumn("Current (MB)");
+	ImGui::TableSetupColumn("Peak (MB)");
+	ImGui::TableHeadersRow();
+
+	size_t total = 0;
+	for (int tag = 0; tag < MemoryStats::TAG_MAX; tag++) {
+		const MemoryStats::Usage usage = MemoryStats::Get(MemoryStats::Tag(tag));
+		total += usage.current;
+
+		ImGui::TableNextRow();
+		ImGui::TableNextColumn();
+		ImGui::TextUnformatted(MemoryStats::GetTagName(MemoryStats::Tag(tag)));
+		ImGui::TableNextColumn();
+		ImGui::Text("%.2f", double(usage.current) / scale_MB);
+		ImGui::TableNextColumn();
+		ImGui::Text("%.2f", double(usage.peak) / scale_MB);
+	}
+
+	ImGui::TableNextRow();
+	ImGui::TableNextColumn();
+	ImGui::TextUnformatted("total accounted");
+	ImGui::TableNextColumn();
+	ImGui::Text("%.2f", double(total) / scale_MB);
+	ImGui::EndTable();
+
+	if (ImGui::Button("Reset Peaks"))
+		MemoryStats::ResetPeaks();
+}
+
+static void DrawLuaProfileTable(const char *id, const std::vector<LuaProfiler::FunctionStats> &rows, double totalMs, bool showNames)
+{
+	if (!ImGui::BeginTable(id, showNames ? 6 : 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit | ImGuiTableFlags_ScrollY, { 0, 250 }))
+		return;
+
+	if (showNames)
+		ImGui::TableSetupColumn("Function", ImGuiTableColumnFlags_WidthStretch);
+	ImGui::TableSetupColumn("Source", showNames ? 0 : ImGuiTableColumnFlags_WidthStretch);
+	ImGui::TableSetupColumn("Samples");
+	ImGui::TableSetupColumn("Time (ms)");
+	ImGui::TableSetupColumn("Time %");
+	ImGui::TableSetupColumn("Alloc (KB)");
+	ImGui::TableSetupScrollFreeze(0, 1);
+	ImGui::TableHeadersRow();
+
+	for (const LuaProfiler::FunctionStats &row : rows) {
+		ImGui::TableNextRow();
+		if (showNames) {
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted(row.name.c_str());
+		}
+		ImGui::TableNextColumn();
+		if (showNames)
+			ImGui::Text("%s:%d", row.source.c_str(), row.line);
+		else
+			ImGui::TextUnformatted(row.source.c_str());
+		ImGui::TableNextColumn();
+		ImGui::Text("%llu", (unsigned long long)row.samples);
+		ImGui::TableNextColumn();
+		ImGui::Text("%.2f", row.timeMs);
+		ImGui::TableNextColumn();
+		ImGui::Text("%.1f", totalMs > 0.0 ? row.timeMs / totalMs * 100.0 : 0.0);
+		ImGui::TableNextColumn();
+		ImGui::Text("%.1f", row.allocBytes / 1024.0);
+	}
+
+	ImGui::EndTable();
+}
+
+void PerfInfo::DrawLuaProfiler()
+{
+	const LuaAllocator::Stats &alloc = ::Lua::manager->GetAllocatorStats();
+	ImGui::Text("Allocator: %.2f MB in use, %.2f MB pooled of %.2f MB in slabs, %.2f MB large blocks",
+		alloc.bytesInUse / scale_MB, alloc.pooledBytes / scale_MB, alloc.slabBytes / scale_MB, alloc.largeBytes / scale_MB);
+	ImGui::Text("%llu allocs, %llu frees, %llu reallocs, %llu large allocs",
+		(unsigned long long)alloc.numAllocs, (unsigned long long)alloc.numFrees,
+		(unsigned long long)alloc.numReallocs, (unsigned long long)alloc.numLargeAllocs);
+
+	if (::Lua::manager->IsFrameBudgetedGC()) {
+		const LuaManager::GCFrameStats &gc = ::Lua::manager->GetGCFrameStats();
+		ImGui::Text("GC: %.2f ms for %d KB last frame%s, heap %.2f MB (%.2f MB after last cycle), %u cycles",
+			gc.stepMs, gc.stepKB, gc.overdue ? " (catching up)" : "",
+			gc.heapKB / 1024.0, gc.heapAfterCycleKB / 1024.0, gc.cycles);
+	}
+	ImGui::Separator();
+
+	LuaProfiler &profiler = ::Lua::manager->GetProfiler();
+
+	if (ImGui::Button(profiler.IsRunning() ? "Stop" : "Start")) {
+		if (profiler.IsRunning())
+			profiler.Stop();
+		else
+			profiler.Start(::Lua::manager->GetLuaState());
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Reset"))
+		profiler.Reset();
+	ImGui::SameLine();
+	if (ImGui::Button("Dump to File")) {
+		const std::string filename = fmt::format("lua-profile-{}.tsv", SDL_GetTicks());
+		if (profiler.DumpToFile(filename))
+			Log::Info("Wrote Lua profile to {}", filename);
+	}
+
+	const LuaProfiler::GCStats &gc = profiler.GetGCStats();
+	ImGui::Text("%llu samples, %.1f ms in Lua", (unsigned long long)profiler.GetTotalSamples(), profiler.GetTotalTimeMs());
+	ImGui::Text("%.1f MB allocated in %llu allocations, %.1f MB freed in %llu frees",
+		gc.allocBytes / scale_MB, (unsigned long long)gc.allocCount, gc.freeBytes / scale_MB, (unsigned long long)gc.freeCount);
+	ImGui::Spacing();
+
+	ImGui::TextUnformatted("Functions");
+	DrawLuaProfileTable("##lua_functions", profiler.GetFunctionStats(), profiler.GetTotalTimeMs(), true);
+	ImGui::Spacing();
+
+	ImGui::TextUnformatted("Source files");
+	DrawLuaProfileTable("##lua_files", profiler.GetFileStats(), profiler.GetTotalTimeMs(), false);
+}
+
+static ImU32 TimelineZoneColor(const char *name)
+{
+	const float hue = float(ImHashStr(name) % 360) / 360.f;
+	return ImColor::HSV(hue, 0.5f, 0.7f);
+}
+
+// draws the lanes of a frame, one row per zone depth
+static void DrawTimelineLanes(const FrameTimeline::Frame &frame, float msToPixels)
+{
+	const float rowHeight = ImGui::GetTextLineHeight() + 2.f;
+	const float width = std::max(float(frame.durationMs) * msToPixels, ImGui::GetContentRegionAvail().x);
+	ImDrawList *dl = ImGui::GetWindowDrawList();
+	const ImVec2 clipMin = dl->GetClipRectMin();
+	const ImVec2 clipMax = dl->GetClipRectMax();
+	const FrameTimeline::Zone *hovered = nullptr;
+
+	for (const FrameTimeline::Lane &lane : frame.lanes) {
+		ImGui::TextUnformatted(lane.name);
+
+		uint32_t rows = 1;
+		for (const FrameTimeline::Zone &zone : lane.zones)
+			rows = std::max(rows, zone.depth + 1);
+
+		const ImVec2 origin = ImGui::GetCursorScreenPos();
+		ImGui::Dummy(ImVec2(width, rowHeight * rows));
+		if (!ImGui::IsItemVisible())
+			continue;
+
+		for (const FrameTimeline::Zone &zone : lane.zones) {
+			ImVec2 min(origin.x + float(zone.startMs) * msToPixels, origin.y + zone.depth * rowHeight);
+			ImVec2 max(origin.x + float(zone.endMs) * msToPixels, min.y + rowHeight - 1.f);
+			max.x = std::max(max.x, min.x + 1.f);
+			if (max.x < clipMin.x || min.x > clipMax.x)
+				continue;
+
+			dl->AddRectFilled(min, max, TimelineZoneColor(zone.name));
+			if (max.x - min.x > rowHeight) {
+				dl->PushClipRect(min, max, true);
+				dl->AddText(ImVec2(min.x + 2.f, min.y + 1.f), IM_COL32_WHITE, zone.name);
+				dl->PopClipRect();
+			}
+			if (ImGui::IsMouseHoveringRect(min, max))
+				hovered = &zone;
+		}
+	}
+
+	if (hovered)
+		ImGui::SetTooltip("%s\n%.3f ms (%.3f - %.3f ms)", hovered->name,
+			hovered->endMs - hovered->startMs, hovered->startMs, hovered->endMs);
+}
+
+void PerfInfo::DrawFrameTimeline()
+{
+	FrameTimeline *timeline = Pi::GetApp()->GetFrameTimeline();
+
+#ifndef PIONEER_PROFILER
+	ImGui::TextWrapped("This build has no profiler; build with PROFILER_ENABLED to record zones.");
+#endif
+
+	bool recording = timeline->IsEnabled();
+	if (ImGui::Checkbox("Record", &recording))
+		timeline->SetEnabled(recording);
+	ImGui::SameLine();
+	if (ImGui::Button("Clear"))
+		timeline->Clear();
+	ImGui::SameLine();
+	ImGui::SetNextItemWidth(120.f);
+	float autoPinMs = float(timeline->GetAutoPinThreshold());
+	if (ImGui::InputFloat("Pin frames slower than (ms)", &autoPinMs, 1.f, 10.f, "%.1f"))
+		timeline->SetAutoPinThreshold(std::max(autoPinMs, 0.f));
+
+	// the recorded frames; clicking one pins it
+	const size_t numFrames = timeline->GetNumFrames();
+	std::vector<float> durations(numFrames);
+	float maxDuration = 33.f;
+	for (size_t i = 0; i < numFrames; i++) {
+		durations[i] = float(timeline->GetFrame(i).durationMs);
+		maxDuration = std::max(maxDuration, durations[i]);
+	}
+	ImGui::PlotHistogram("##timeline_frames", durations.data(), int(numFrames), 0, nullptr, 0.f, maxDuration, { -1, 40 });
+	if (numFrames && ImGui::IsItemHovered()) {
+		const ImVec2 min = ImGui::GetItemRectMin(), max = ImGui::GetItemRectMax();
+		const float t = (ImGui::GetIO().MousePos.x - min.x) / std::max(max.x - min.x, 1.f);
+		const size_t index = std::min(size_t(std::max(t, 0.f) * numFrames), numFrames - 1);
+		if (ImGui::IsMouseClicked(ImGuiMouseButton_Left))
+			timeline->PinFrame(index);
+	}
+
+	const FrameTimeline::Frame *frame = timeline->GetPinnedFrame();
+	if (frame) {
+		ImGui::Text("Pinned frame %llu, %.2f ms", (unsigned long long)frame->number, frame->durationMs);
+		ImGui::SameLine();
+		if (ImGui::Button("Unpin")) {
+			timeline->Unpin();
+			frame = nullptr;
+		}
+	}
+	if (!frame && numFrames) {
+		frame = &timeline->GetFrame(numFrames - 1);
+		ImGui::Text("Latest frame %llu, %.2f ms", (unsigned long long)frame->number, frame->durationMs);
+	}
+	if (!frame)
+		return;
+
+	ImGui::SetNextItemWidth(200.f);
+	ImGui::SliderFloat("Zoom (px/ms)", &m_state->timelineScale, 5.f, 2000.f, "%.0f", ImGuiSliderFlags_Logarithmic);
+
+	if (ImGui::BeginChild("##timeline_lanes", { 0, 300 }, true, ImGuiWindowFlags_HorizontalScrollbar))
+		DrawTimelineLanes(*frame, m_state->timelineScale);
+	ImGui::EndChild();
+
+	if (!ImGui::BeginTable("##timeline_zones", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit | ImGuiTableFlags_ScrollY, { 0, 250 }))
+		return;
+
+	ImGui::TableSetupColumn("Zone", ImGuiTableColumnFlags_WidthStretch);
+	ImGui::TableSetupColumn("Calls");
+	ImGui::TableSetupColumn("Total (ms)");
+	ImGui::TableSetupColumn("Self (ms)");
+	ImGui::TableSetupScrollFreeze(0, 1);
+	ImGui::TableHeadersRow();
+
+	for (const FrameTimeline::ZoneTotal &total : FrameTimeline::Aggregate(*frame)) {
+		ImGui::TableNextRow();
+		ImGui::TableNextColumn();
+		ImGui::TextUnformatted(total.name);
+		ImGui::TableNextColumn();
+		ImGui::Text("%u", total.calls);
+		ImGui::TableNextColumn();
+		ImGui::Text("%.3f", total.totalMs);
+		ImGui::TableNextColumn();
+		ImGui::Text("%.3f", total.selfMs);
+	}
+
+	ImGui::EndTable();
+}
+
+template <typename CacheT>
+static void DrawCacheStats(const char *name, const CacheT &cache)
+{
+	const typename CacheT::Statistics stats = cache.GetStatistics();
+	ImGui::TextUnformatted(name);
+	ImGui::Indent();
+	ImGui::Text("%zu objects alive, %zu retained", stats.numObjects, stats.numRetained);
+	const float fill = stats.budgetBytes ? float(stats.retainedBytes) / float(stats.budgetBytes) : 1.f;
+	ImGui::ProgressBar(fill, { 200, 0 }, fmt::format("{:.1f} / {:.1f} MB", stats.retainedBytes / scale_MB, stats.budgetBytes / scale_MB).c_str());
+	ImGui::Text("%llu hits, %llu slave hits, %llu misses, %llu evictions", stats.hits, stats.slaveHits, stats.misses, stats.evictions);
+	ImGui::Unindent();
+}
+
+void PerfInfo::DrawGalaxyCacheStats()
+{
+	RefCountedPtr<Galaxy> galaxy = Pi::game->GetGalaxy();
+	DrawCacheStats("Sectors", galaxy->GetSectorCache());
+	ImGui::Spacing();
+	DrawCacheStats("Star systems", galaxy->GetStarSystemCache());
+}
+
 void PerfInfo::DrawStatList(const Perf::Stats::FrameInfo &fi)
 {
 	ImGui::BeginChild("FrameInfo");
@@ -536,6 +979,14 @@ void PerfInfo::DrawTextureCache()
 			m_state->indirectionMap[key.first].push_back(key.second);
 		}
 
+		if (const Graphics::TextureLoader *loader = Pi::renderer->GetTextureLoader())
+			ImGui::Text("%u textures loading in the background", loader->GetNumPending());
+		if (const Graphics::TextureStreamer *streamer = Pi::renderer->GetTextureStreamer()) {
+			ImGui::Text("Streamed mips: %.1f / %.1f MB, %u textures, %u loading, %u evictions",
+				double(streamer->GetStreamedSize()) / scale_MB, double(streamer->GetBudget()) / scale_MB,
+				streamer->GetNumTextures(), streamer->GetNumLoading(), streamer->GetNumEvicted());
+		}
+
 		if (ImGui::BeginTabBar("Texture List")) {
 			const int item_width = 128 + ImGui::GetStyle().ItemSpacing.x;
 			for (const auto &t : m_state->indirectionMap) {
@@ -592,6 +1043,9 @@ void PerfInfo::DrawTextureInspector()
 			ImGui::Text("Dimensions: %ux%u", uint32_t(descriptor.dataSize.x), uint32_t(descriptor.dataSize.y));
 			ImGui::Value("Mipmap Count", tex->GetDescriptor().numberOfMipMaps);
 			ImGui::Value("VRAM Size", tex->GetTextureMemSize());
+			const Graphics::TextureStreamer *streamer = Pi::renderer->GetTextureStreamer();
+			if (streamer && streamer->IsStreamed(tex))
+				ImGui::Value("Loaded Mip", streamer->GetLoadedMip(tex));
 			if (texUVs.x < 1.0 || texUVs.y < 1.0)
 				ImGui::Text("Original Size: %ux%u", int(texUVs.x * descriptor.dataSize.x), int(texUVs.y * descriptor.dataSize.y));
 
@@ -49,6 +49,11 @@ namespace PiGui {
 		void DrawWorldViewStats();
 		void DrawImGuiStats();
 		void DrawInputDebug();
+		void DrawJobStats();
+		void DrawMemoryStats();
+		void DrawLuaProfiler();
+		void DrawFrameTimeline();
+		void DrawGalaxyCacheStats();
 		void DrawStatList(const Perf::Stats::FrameInfo &fi);
 
 		static const int NUM_FRAMES = 60;
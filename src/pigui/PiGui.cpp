@@ -2,12 +2,14 @@
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
 #include "PiGui.h"
+#include "CachedPanel.h"
 #include "FileSystem.h"
 #include "Input.h"
 #include "JsonUtils.h"
 #include "Pi.h"
 #include "PiGuiRenderer.h"
 
+#include "core/FastHash.h"
 #include "core/TaskGraph.h"
 #include "graphics/Graphics.h"
 #include "graphics/Material.h"
@@ -18,9 +20,11 @@
 #include "imgui/imgui.h"
 #include "imgui/imgui_internal.h"
 
+#include <atomic>
 #include <float.h>
 #include <stdio.h>
 #include <string.h>
+#include <thread>
 
 #define NANOSVG_IMPLEMENTATION
 #include "nanosvg/nanosvg.h"
@@ -31,13 +35,96 @@ using namespace PiGui;
 
 namespace {
 	std::vector<Graphics::Texture *> m_svg_textures;
-}
+
+	static const char SVG_CACHE_DIR_NAME[] = "svg_cache";
+	static const uint32_t SVG_CACHE_MAGIC = 0x43535650; // "PVSC"
+	// bump whenever the way SVG images are rasterized changes
+	static const uint32_t SVG_CACHE_VERSION = 1;
+	std::atomic<bool> s_svgCacheEnabled(false);
+
+	struct SVGCacheHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint64_t fileHash;
+		int32_t width;
+		int32_t height;
+	};
+
+	std::string GetSVGCacheName(uint64_t fileHash, int width, int height)
+	{
+		return FileSystem::JoinPath(SVG_CACHE_DIR_NAME, fmt::format("{:016x}_{}x{}.rgba", fileHash, width, height));
+	}
+
+	// fills imageData (width * height RGBA32 pixels) from the cache, if there is a valid entry
+	bool LoadCachedSVG(uint64_t fileHash, int width, int height, uint8_t *imageData)
+	{
+		if (!s_svgCacheEnabled)
+			return false;
+
+		PROFILE_SCOPED()
+		const size_t size = size_t(width) * height * 4;
+		RefCountedPtr<FileSystem::FileData> cached = FileSystem::userFiles.ReadFile(GetSVGCacheName(fileHash, width, height));
+		// also rejects partly written files
+		if (!cached || cached->GetSize() != sizeof(SVGCacheHeader) + size)
+			return false;
+
+		SVGCacheHeader header;
+		memcpy(&header, cached->GetData(), sizeof(header));
+		if (header.magic != SVG_CACHE_MAGIC || header.version != SVG_CACHE_VERSION ||
+			header.fileHash != fileHash || header.width != width || header.height != height)
+			return false;
+
+		memcpy(imageData, cached->GetData() + sizeof(header), size);
+		return true;
+	}
+
+	void SaveCachedSVG(uint64_t fileHash, int width, int height, const uint8_t *imageData)
+	{
+		if (!s_svgCacheEnabled)
+			return;
+
+		PROFILE_SCOPED()
+		const std::string cacheName = GetSVGCacheName(fileHash, width, height);
+		const SVGCacheHeader header = { SVG_CACHE_MAGIC, SVG_CACHE_VERSION, fileHash, width, height };
+
+		// write to a file of this thread's own, then move it into place, so
+		// another thread never reads a partly written file
+		const std::string tempName = fmt::format("{}.{}.tmp", cacheName, std::hash<std::thread::id>()(std::this_thread::get_id()));
+		FILE *f = FileSystem::userFiles.OpenWriteStream(tempName);
+		if (!f)
+			return;
+		bool written = fwrite(&header, sizeof(header), 1, f) == 1;
+		written = written && fwrite(imageData, size_t(width) * height * 4, 1, f) == 1;
+		fclose(f);
+
+		const std::string root = FileSystem::userFiles.GetRoot();
+		const std::string tempPath = FileSystem::JoinPathBelow(root, tempName);
+		const std::string filePath = FileSystem::JoinPathBelow(root, cacheName);
+		bool moved = written && std::rename(tempPath.c_str(), filePath.c_str()) == 0;
+		if (written && !moved) {
+			// rename() doesn't replace an existing file everywhere
+			std::remove(filePath.c_str());
+			moved = std::rename(tempPath.c_str(), filePath.c_str()) == 0;
+		}
+		if (!moved)
+			std::remove(tempPath.c_str());
+	}
+} // namespace
 
 std::vector<Graphics::Texture *> &PiGui::GetSVGTextures()
 {
 	return m_svg_textures;
 }
 
+void PiGui::InitSVGCache(bool enabled)
+{
+	s_svgCacheEnabled = enabled;
+	if (enabled && !FileSystem::userFiles.MakeDirectory(SVG_CACHE_DIR_NAME)) {
+		Log::Warning("Could not create the SVG image cache directory, disabling it.\n");
+		s_svgCacheEnabled = false;
+	}
+}
+
 // Handle GPU upload of texture image data on the main application thread.
 class UpdateImageTask : public Task {
 public:
@@ -68,7 +155,9 @@ public:
 		filename(filename),
 		width(width),
 		height(height),
-		texture(outputTexture)
+		texture(outputTexture),
+		imageData(nullptr),
+		fontFace(nullptr)
 	{
 	}
 
@@ -78,6 +167,7 @@ public:
 		width(width),
 		height(height),
 		texture(nullptr),
+		imageData(nullptr),
 		fontFace(fontFace)
 	{
 		SetOwner(this);
@@ -87,44 +177,82 @@ public:
 	{
 		PROFILE_SCOPED();
 
-		image = nsvgParseFromFile(filename.c_str(), "px", 96.0f);
-		if (image == NULL) {
+		FILE *f = fopen(filename.c_str(), "rb");
+		if (!f) {
 			Log::Error("Could not open SVG image {}.\n", filename);
 			return false;
 		}
 
+		fseek(f, 0, SEEK_END);
+		const long size = ftell(f);
+		fseek(f, 0, SEEK_SET);
+
+		// nanosvg wants a null-terminated string
+		fileText.resize(size > 0 ? size + 1 : 1);
+		const bool read = size > 0 && fread(fileText.data(), size, 1, f) == 1;
+		fclose(f);
+
+		if (!read) {
+			Log::Error("Could not read SVG image {}.\n", filename);
+			return false;
+		}
+
+		fileText[size] = '\0';
 		return true;
 	}
 
-	virtual void OnExecute(TaskRange range) override
+	bool Rasterize()
 	{
 		PROFILE_SCOPED()
 
-		if (!LoadFile())
-			return;
-
-		size_t stride = width * 4;
-		imageData = new uint8_t[stride * height];
-
-		if (!imageData) {
-			Log::Error("Couldn't allocate memory for SVG image {}.\n", filename);
-			return;
+		// parsing modifies the text in place
+		NSVGimage *image = nsvgParse(fileText.data(), "px", 96.0f);
+		if (image == NULL) {
+			Log::Error("Could not parse SVG image {}.\n", filename);
+			return false;
 		}
 
-		memset(imageData, 0, stride * height);
-
 		NSVGrasterizer *rast = nsvgCreateRasterizer();
 		if (!rast) {
 			Log::Error("Couldn't create SVG rasterizer for SVG image {}.\n", filename);
-			delete[] imageData;
-			return;
+			nsvgDelete(image);
+			return false;
 		}
 
+		size_t stride = width * 4;
+		memset(imageData, 0, stride * height);
+
 		float scale = double(width) / int(image->width);
 		nsvgRasterize(rast, image, 0, 0, scale, imageData, width, height, stride);
 
 		nsvgDeleteRasterizer(rast);
 		nsvgDelete(image);
+		return true;
+	}
+
+	virtual void OnExecute(TaskRange range) override
+	{
+		PROFILE_SCOPED()
+
+		if (!LoadFile())
+			return;
+
+		imageData = new uint8_t[width * 4 * height];
+
+		// the rasterized image only depends on the file contents and the size,
+		// so look for it in the cache before parsing the file
+		const uint64_t fileHash = FastHash64(fileText.data(), fileText.size());
+		if (!LoadCachedSVG(fileHash, width, height, imageData)) {
+			if (!Rasterize()) {
+				delete[] imageData;
+				imageData = nullptr;
+				return;
+			}
+
+			SaveCachedSVG(fileHash, width, height, imageData);
+		}
+
+		std::vector<char>().swap(fileText);
 
 		if (texture) {
 			Pi::GetApp()->GetTaskGraph()->QueueTaskPinned(new UpdateImageTask(texture, imageData));
@@ -150,7 +278,89 @@ private:
 	Graphics::Texture *texture;
 	uint8_t *imageData;
 	PiFace *fontFace;
-	NSVGimage *image;
+	std::vector<char> fileText;
+};
+
+// Build a replacement font atlas on a worker thread. The glyph ranges and SVG
+// data are gathered on the main thread beforehand; the atlas in use keeps
+// rendering (with the fallback glyph for anything new) until it is swapped in.
+class PiGui::FontBakeTask : public Task, public CompleteNotifier {
+public:
+	struct FontEntry {
+		FontEntry(const std::pair<std::string, int> &key) :
+			key(key)
+		{
+		}
+
+		std::pair<std::string, int> key;
+		ImVector<ImWchar> ranges;
+		// faces in atlas order, with the raster data to use for SVG faces
+		std::vector<std::pair<PiFace *, RasterizeSVGResult *>> faces;
+		ImFont *font = nullptr;
+	};
+
+	FontBakeTask() :
+		atlas(IM_NEW(ImFontAtlas)())
+	{
+		SetOwner(this);
+	}
+
+	~FontBakeTask()
+	{
+		if (atlas)
+			IM_DELETE(atlas);
+	}
+
+	virtual void OnExecute(TaskRange range) override
+	{
+		PROFILE_SCOPED()
+
+		std::vector<std::pair<int, PiFont::CustomGlyphData>> customGlyphs;
+
+		for (FontEntry &entry : fonts) {
+			const int pixelSize = entry.key.second;
+
+			ImFontConfig config;
+
+			// Set the ImGui font name for debugging purposes
+			std::string name = fmt::format("{}:{}", entry.key.first, pixelSize);
+			strncpy(config.Name, name.c_str(), 39);
+
+			for (auto &face : entry.faces) {
+				config.MergeMode = entry.font != nullptr;
+
+				if (face.first->isSvgFont()) {
+					PiFont::CustomGlyphData data = {};
+					data.face = face.first;
+					data.svgData = face.second;
+					data.glyphRects.reset(new ImVector<int>);
+					data.font = face.first->addSVGFaceToAtlas(atlas, pixelSize, &config, &entry.ranges, data.svgData, data.glyphRects.get());
+
+					if (!data.glyphRects->empty())
+						customGlyphs.emplace_back(pixelSize, std::move(data));
+				} else {
+					ImFont *f = face.first->addTTFFaceToAtlas(atlas, pixelSize, &config, &entry.ranges);
+					if (entry.font != nullptr)
+						assert(f == entry.font);
+					entry.font = f;
+				}
+			}
+		}
+
+		atlas->Build();
+
+		for (auto &glyphs : customGlyphs) {
+			PiFont::CustomGlyphData &data = glyphs.second;
+			data.face->finishSVGFaceData(atlas, data.font, glyphs.first, data.svgData, data.glyphRects.get());
+		}
+
+		// convert to the texture format here rather than on the main thread
+		unsigned char *pixels;
+		atlas->GetTexDataAsRGBA32(&pixels, nullptr, nullptr);
+	}
+
+	std::vector<FontEntry> fonts;
+	ImFontAtlas *atlas;
 };
 
 static Graphics::Texture *makeSVGTexture(Graphics::Renderer *renderer, int width, int height)
@@ -228,6 +438,7 @@ void StyleColorsDarkPlus(ImGuiStyle &style)
 Instance::Instance(GuiApplication *app) :
 	m_app(app),
 	m_should_bake_fonts(true),
+	m_fontBakeTask(nullptr),
 	m_debugStyle(),
 	m_debugStyleActive(false)
 {
@@ -396,15 +607,9 @@ void Instance::Init(Graphics::Renderer *renderer)
 	// unused, but that is slated to change very soon.
 	// We will need to fill this with a valid pointer to the OpenGL context.
 	ImGui_ImplSDL2_InitForOpenGL(m_renderer->GetSDLWindow(), NULL);
-	switch (m_renderer->GetRendererType()) {
-	default:
-	case Graphics::RENDERER_DUMMY:
-		Error("RENDERER_DUMMY is not a valid renderer, aborting.");
-		return;
-	case Graphics::RENDERER_OPENGL_3x:
-		m_instanceRenderer->Initialize();
-		break;
-	}
+	// the instance renderer only goes through the renderer interface, so it
+	// works with the dummy renderer (used by benchmarks) too
+	m_instanceRenderer->Initialize();
 
 	ImGuiIO &io = ImGui::GetIO();
 	// Apply the base style
@@ -445,38 +650,49 @@ void Instance::NewFrame()
 		}
 	}
 
-	for (auto &task : m_svgFontTasks) {
-		if (task->IsComplete()) {
-			PiFace *face = task->GetFontFace();
-			m_svgFontRasterData[face->svgname()].emplace_back(task->GetImageData(), task->width, task->height);
+	if (m_fontBakeTask && m_fontBakeTask->IsComplete()) {
+		std::atomic_thread_fence(std::memory_order_acquire);
+		FinishBakeFonts(m_fontBakeTask);
+		m_fontBakeTask = nullptr;
+	}
 
-			delete task;
-			task = nullptr;
+	// An in-flight bake points into the SVG raster data, so only take new data in between bakes
+	if (!m_fontBakeTask) {
+		for (auto &task : m_svgFontTasks) {
+			if (task->IsComplete()) {
+				PiFace *face = task->GetFontFace();
+				// we have improved SVG data for a font, rebuild the atlas
+				if (task->GetImageData()) {
+					m_svgFontRasterData[face->svgname()].emplace_back(task->GetImageData(), task->width, task->height);
+					m_should_bake_fonts = true;
+				}
 
-			// we have improved SVG data for a font, rebuild the atlas
-			m_should_bake_fonts = true;
+				delete task;
+				task = nullptr;
+			}
 		}
-	}
 
-	m_svgFontTasks.erase(std::remove(m_svgFontTasks.begin(), m_svgFontTasks.end(), nullptr), m_svgFontTasks.end());
+		m_svgFontTasks.erase(std::remove(m_svgFontTasks.begin(), m_svgFontTasks.end(), nullptr), m_svgFontTasks.end());
+	}
 
-	// Bake fonts before a frame is begun.
-	// This avoids any dangling texture pointers from recreating the texture between
-	// issuing draw commands and rendering
-	if (m_should_bake_fonts) {
+	// Start baking fonts before a frame is begun. Glyphs requested while a
+	// bake is running are picked up by the next one.
+	// The new atlas is only swapped in here as well, which avoids any dangling
+	// texture pointers from recreating the texture between issuing draw
+	// commands and rendering
+	if (m_should_bake_fonts && !m_fontBakeTask) {
 		BakeFonts();
 	}
 
-	switch (m_renderer->GetRendererType()) {
-	default:
-	case Graphics::RENDERER_DUMMY:
-		Error("RENDERER_DUMMY is not a valid renderer, aborting.");
-		return;
-	case Graphics::RENDERER_OPENGL_3x:
-		m_instanceRenderer->NewFrame();
-		break;
+	m_instanceRenderer->NewFrame();
+	if (m_renderer->GetRendererType() == Graphics::RENDERER_DUMMY) {
+		// there's no window to take the size and input from
+		ImGuiIO &io = ImGui::GetIO();
+		io.DisplaySize = ImVec2(float(Graphics::GetScreenWidth()), float(Graphics::GetScreenHeight()));
+		io.DeltaTime = 1.0f / 60.0f;
+	} else {
+		ImGui_ImplSDL2_NewFrame(m_renderer->GetSDLWindow());
 	}
-	ImGui_ImplSDL2_NewFrame(m_renderer->GetSDLWindow());
 	ImGui::NewFrame();
 
 	m_renderer->CheckRenderErrors(__FUNCTION__, __LINE__);
@@ -497,6 +713,9 @@ void Instance::Render()
 	PROFILE_SCOPED()
 	EndFrame();
 
+	// the zone ends at the next flush, after the GL commands below
+	Graphics::Renderer::GPUZoneTicket zone(m_renderer, "PiGui");
+
 	// FIXME: renderer uses async command execution but imgui impl is still directly generating GL commands
 	m_renderer->FlushCommandBuffers();
 
@@ -512,16 +731,6 @@ void Instance::Render()
 	}
 }
 
-void Instance::ClearFonts()
-{
-	PROFILE_SCOPED()
-	ImGuiIO &io = ImGui::GetIO();
-	// TODO: should also release all glyph_ranges...
-	m_fonts.clear();
-	m_im_fonts.clear();
-	io.Fonts->Clear();
-}
-
 RasterizeSVGResult *Instance::RequestSVGFaceData(PiFace *face, int pixelsize)
 {
 	int width = face->m_svgcolumns * pixelsize;
@@ -548,12 +757,11 @@ RasterizeSVGResult *Instance::RequestSVGFaceData(PiFace *face, int pixelsize)
 	return bestResult;
 }
 
-// this function rasterizes a specific font
-void Instance::BakeFont(PiFont &font)
+// this function gathers what is needed to rasterize a specific font
+void Instance::BakeFont(FontBakeTask *task, PiFont &font)
 {
 	PROFILE_SCOPED()
 	ImGuiIO &io = ImGui::GetIO();
-	ImFont *imfont = nullptr;
 
 	// note that if there are no ranges at all in the font, it is ignored
 	if (font.used_ranges().empty()) {
@@ -575,16 +783,8 @@ void Instance::BakeFont(PiFont &font)
 		gb.AddRanges(gr);
 	}
 
-	ImVector<ImWchar> *font_char_ranges = new ImVector<ImWchar>;
-	m_glyphRanges.emplace_back(font_char_ranges);
-
-	gb.BuildRanges(font_char_ranges);
-
-	ImFontConfig config;
-
-	// Set the ImGui font name for debugging purposes
-	std::string name = fmt::format("{}:{}", font.name(), font.pixelsize());
-	strncpy(config.Name, name.c_str(), 39);
+	FontBakeTask::FontEntry &entry = task->fonts.emplace_back(std::make_pair(font.name(), font.pixelsize()));
+	gb.BuildRanges(&entry.ranges);
 
 	// The main face of the font should go first in the list, because:
 	//
@@ -597,37 +797,17 @@ void Instance::BakeFont(PiFont &font)
 	// the basic range
 	//
 	for (PiFace &face : font.faces()) {
-		config.MergeMode = imfont != nullptr;
+		RasterizeSVGResult *svgData = nullptr;
 
 		if (face.isSvgFont()) {
-			PiFont::CustomGlyphData data = {};
-			data.face = &face;
-
-			data.svgData = RequestSVGFaceData(&face, font.pixelsize());
-			if (!data.svgData) {
+			svgData = RequestSVGFaceData(&face, font.pixelsize());
+			if (!svgData) {
 				Log::Warning("No SVG data available to rasterize icon font {}", face.svgname());
 				continue;
 			}
-
-			data.glyphRects.reset(new ImVector<int>);
-			data.font = face.addSVGFaceToAtlas(font.pixelsize(), &config, font_char_ranges, data.svgData, data.glyphRects.get());
-
-			if (!data.glyphRects->empty())
-				font.custom_glyphs().emplace_back(std::move(data));
-		} else {
-			ImFont *f = face.addTTFFaceToAtlas(font.pixelsize(), &config, font_char_ranges);
-			if (imfont != nullptr)
-				assert(f == imfont);
-			imfont = f;
 		}
-	}
 
-	m_im_fonts[imfont] = std::make_pair(font.name(), font.pixelsize());
-	// 	Output("setting %s %i to %p\n", font.name(), font.pixelsize(), imfont);
-	m_fonts[std::make_pair(font.name(), font.pixelsize())] = imfont;
-	if (!imfont->MissingGlyphs.empty()) {
-		Log::Warning("PiGui: newly-built font {}:{} has glyphs missing", font.name(), font.pixelsize());
-		imfont->MissingGlyphs.clear();
+		entry.faces.emplace_back(&face, svgData);
 	}
 }
 
@@ -643,33 +823,53 @@ void Instance::BakeFonts()
 		return;
 	}
 
-	ClearFonts();
+	FontBakeTask *task = new FontBakeTask();
 
 	// first bake tooltip/default font
-	BakeFont(m_pi_fonts.at(std::make_pair("pionillium", 14)));
+	BakeFont(task, m_pi_fonts.at(std::make_pair("pionillium", 14)));
 
 	for (auto &iter : m_pi_fonts) {
 		// don't bake tooltip/default font again
 		if (!(iter.first.first == "pionillium" && iter.first.second == 14))
-			BakeFont(iter.second);
-		//		Output("Fonts registered: %i\n", io.Fonts->Fonts.Size);
+			BakeFont(task, iter.second);
 	}
 
-	ImGui::GetIO().Fonts->Build();
+	if (m_im_fonts.empty()) {
+		// there are no fonts to draw with in the meantime, so bake right away
+		task->OnExecute(TaskRange());
+		FinishBakeFonts(task);
+		return;
+	}
 
-	for (auto &iter : m_pi_fonts) {
-		for (auto &glyph_data : iter.second.custom_glyphs()) {
-			glyph_data.face->finishSVGFaceData(glyph_data.font, iter.second.pixelsize(), glyph_data.svgData, glyph_data.glyphRects.get());
-		}
+	m_app->GetTaskGraph()->QueueTask(task);
+	m_fontBakeTask = task;
+}
 
-		iter.second.custom_glyphs().clear();
-	}
+// swap a finished atlas in for the current one
+void Instance::FinishBakeFonts(FontBakeTask *task)
+{
+	PROFILE_SCOPED()
+	ImGuiIO &io = ImGui::GetIO();
+
+	IM_DELETE(io.Fonts);
+	io.Fonts = task->atlas;
+	task->atlas = nullptr;
+
+	// fonts added since the bake started stay pending until the next one
+	for (auto &iter : m_fonts)
+		iter.second = nullptr;
+	m_im_fonts.clear();
+
+	for (FontBakeTask::FontEntry &entry : task->fonts) {
+		if (!entry.font)
+			continue;
 
-	for (ImVector<ImWchar> *scratchVec : m_glyphRanges) {
-		delete scratchVec;
+		m_im_fonts[entry.font] = entry.key;
+		// 	Output("setting %s %i to %p\n", entry.key.first, entry.key.second, entry.font);
+		m_fonts[entry.key] = entry.font;
 	}
 
-	m_glyphRanges.clear();
+	delete task;
 
 	m_instanceRenderer->CreateFontsTexture();
 }
@@ -677,19 +877,21 @@ void Instance::BakeFonts()
 void Instance::Uninit()
 {
 	PROFILE_SCOPED()
+	if (m_fontBakeTask) {
+		while (!m_fontBakeTask->IsComplete())
+			std::this_thread::yield();
+
+		delete m_fontBakeTask;
+		m_fontBakeTask = nullptr;
+	}
+
 	for (auto tex : m_svg_textures) {
 		delete tex;
 	}
 
-	switch (m_renderer->GetRendererType()) {
-	default:
-	case Graphics::RENDERER_DUMMY:
-		return;
-	case Graphics::RENDERER_OPENGL_3x:
-		m_instanceRenderer->Shutdown();
-		break;
-	}
+	m_instanceRenderer->Shutdown();
 
+	ClearCachedChildren();
 	ImGui_ImplSDL2_Shutdown();
 	ImGui::DestroyContext();
 	delete[] m_ioIniFilename;
@@ -699,21 +901,20 @@ void Instance::Uninit()
 // PiGui::PiFace
 //
 
-ImFont *PiFace::addTTFFaceToAtlas(int pixelSize, ImFontConfig *config, ImVector<ImWchar> *ranges)
+ImFont *PiFace::addTTFFaceToAtlas(ImFontAtlas *atlas, int pixelSize, ImFontConfig *config, ImVector<ImWchar> *ranges)
 {
 	float size = pixelSize * sizefactor();
 	const std::string path = FileSystem::JoinPath(FileSystem::JoinPath(FileSystem::GetDataDir(), "fonts"), ttfname());
-	ImFont *f = ImGui::GetIO().Fonts->AddFontFromFileTTF(path.c_str(), size, config, ranges->Data);
+	ImFont *f = atlas->AddFontFromFileTTF(path.c_str(), size, config, ranges->Data);
 	assert(f);
 
 	return f;
 }
 
-ImFont *PiFace::addSVGFaceToAtlas(int pixelSize, ImFontConfig *config, ImVector<ImWchar> *ranges, RasterizeSVGResult *svgData, ImVector<int> *outGlyphRects)
+ImFont *PiFace::addSVGFaceToAtlas(ImFontAtlas *atlas, int pixelSize, ImFontConfig *config, ImVector<ImWchar> *ranges, RasterizeSVGResult *svgData, ImVector<int> *outGlyphRects)
 {
 	assert(config->MergeMode);
 
-	ImFontAtlas *atlas = ImGui::GetIO().Fonts;
 	ImFont *font = atlas->Fonts.back();
 
 	// we'll stretch the icon/character size if we're rendering with a lower-resolution fallback
@@ -742,10 +943,8 @@ int RGBA32TexOffsetFromCoords(int x, int y, int pitch)
 	return (pitch * y * 4) + (x * 4);
 }
 
-void PiFace::finishSVGFaceData(ImFont *font, int pixelSize, RasterizeSVGResult *svgData, ImVector<int> *glyphRects)
+void PiFace::finishSVGFaceData(ImFontAtlas *atlas, ImFont *font, int pixelSize, RasterizeSVGResult *svgData, ImVector<int> *glyphRects)
 {
-	ImFontAtlas *atlas = ImGui::GetIO().Fonts;
-
 	// Ensure texture data pointer is available and in RGBA32
 	uint8_t *texData;
 	int texWidth;
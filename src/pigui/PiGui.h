@@ -24,6 +24,7 @@ class GuiApplication;
 namespace PiGui {
 
 	class RasterizeSVGTask;
+	class FontBakeTask;
 
 	struct RasterizeSVGResult {
 		RasterizeSVGResult(uint8_t *data, int width, int height) :
@@ -63,13 +64,13 @@ namespace PiGui {
 		int svgRows() const { return m_svgrows; }
 		int svgCols() const { return m_svgcolumns; }
 
-		// Add this fontface at the specified size to the global font atlas
-		ImFont *addTTFFaceToAtlas(int pixelSize, ImFontConfig *config, ImVector<ImWchar> *ranges);
+		// Add this fontface at the specified size to the given font atlas
+		ImFont *addTTFFaceToAtlas(ImFontAtlas *atlas, int pixelSize, ImFontConfig *config, ImVector<ImWchar> *ranges);
 
-		// Add this SVG fontface at the specified size to the global font atlas
-		ImFont *addSVGFaceToAtlas(int pixelSize, ImFontConfig *config, ImVector<ImWchar> *ranges, RasterizeSVGResult *svgData, ImVector<int> *outGlyphRects);
-		// Copy the pixel data for this fontface into the global font atlas
-		void finishSVGFaceData(ImFont *font, int pixelSize, RasterizeSVGResult *svgData, ImVector<int> *glyphRects);
+		// Add this SVG fontface at the specified size to the given font atlas
+		ImFont *addSVGFaceToAtlas(ImFontAtlas *atlas, int pixelSize, ImFontConfig *config, ImVector<ImWchar> *ranges, RasterizeSVGResult *svgData, ImVector<int> *outGlyphRects);
+		// Copy the pixel data for this fontface into the given (built) font atlas
+		void finishSVGFaceData(ImFontAtlas *atlas, ImFont *font, int pixelSize, RasterizeSVGResult *svgData, ImVector<int> *glyphRects);
 
 	private:
 		friend class Instance; // need access to some private data
@@ -121,7 +122,6 @@ namespace PiGui {
 		int pixelsize() const { return m_pixelsize; }
 		const PiFontDefinition &definition() const { return m_fontDef; }
 
-		std::vector<CustomGlyphData> &custom_glyphs() { return m_custom_glyphs; }
 
 		void describe(bool withFaces = false) const;
 
@@ -131,7 +131,6 @@ namespace PiGui {
 		PiFontDefinition &m_fontDef;
 		int m_pixelsize;
 		std::vector<UsedRange> m_used_ranges;
-		std::vector<CustomGlyphData> m_custom_glyphs;
 	};
 
 	class InstanceRenderer;
@@ -184,7 +183,8 @@ namespace PiGui {
 
 		std::map<std::string, PiFontDefinition> m_font_definitions;
 
-		std::vector<ImVector<ImWchar> *> m_glyphRanges;
+		// the atlas being rebuilt in the background, if any
+		FontBakeTask *m_fontBakeTask;
 		std::vector<RasterizeSVGTask *> m_svgFontTasks;
 		std::map<std::string, std::vector<RasterizeSVGResult>> m_svgFontRasterData;
 
@@ -199,8 +199,8 @@ namespace PiGui {
 		void LoadFontDefinitionFromFile(const std::string &filePath);
 
 		void BakeFonts();
-		void BakeFont(PiFont &font);
-		void ClearFonts();
+		void BakeFont(FontBakeTask *task, PiFont &font);
+		void FinishBakeFonts(FontBakeTask *task);
 
 		RasterizeSVGResult *RequestSVGFaceData(PiFace *face, int pixelsize);
 	};
@@ -235,6 +235,8 @@ namespace PiGui {
 	}
 
 	std::vector<Graphics::Texture *> &GetSVGTextures();
+	// Enables the on-disk cache of rasterized SVG images in the user directory
+	void InitSVGCache(bool enabled);
 	ImTextureID RenderSVG(Graphics::Renderer *renderer, std::string svgFilename, int width, int height);
 
 } //namespace PiGui
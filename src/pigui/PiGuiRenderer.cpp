@@ -23,6 +23,14 @@ InstanceRenderer::InstanceRenderer(Graphics::Renderer *r) :
 	m_renderer(r)
 {}
 
+InstanceRenderer::~InstanceRenderer() = default;
+
+void InstanceRenderer::NewFrame()
+{
+	m_statsPrevious = m_stats;
+	m_stats = {};
+}
+
 void InstanceRenderer::Initialize()
 {
 	ImGuiIO &io = ImGui::GetIO();
@@ -95,10 +103,42 @@ void InstanceRenderer::RenderDrawData(ImDrawData *draw_data, Graphics::Material*
 	// we're going to throw all of the vertex and index data straight to the GPU
 	// in a single buffer for each, right before we begin executing commands.
 	// This should make optimal use of transfer resources.
-	std::vector<ImDrawVert> vtxStagingBuffer;
-	vtxStagingBuffer.reserve(1024);
-	std::vector<ImDrawIdx> idxStagingBuffer;
-	idxStagingBuffer.reserve(1024);
+	std::vector<ImDrawVert> &vtxStagingBuffer = m_vtxStaging;
+	vtxStagingBuffer.clear();
+	vtxStagingBuffer.reserve(draw_data->TotalVtxCount);
+	std::vector<ImDrawIdx> &idxStagingBuffer = m_idxStaging;
+	idxStagingBuffer.clear();
+	idxStagingBuffer.reserve(draw_data->TotalIdxCount);
+
+	m_stats.numVertices += draw_data->TotalVtxCount;
+	m_stats.numIndices += draw_data->TotalIdxCount;
+
+	// Consecutive commands drawing the same texture, clip rect and depth over
+	// adjacent index ranges are merged into a single draw call.
+	struct PendingDraw {
+		Graphics::Texture *texture = nullptr;
+		ImVec4 clipRect;
+		float depth = 0.f;
+		size_t vtxOffset = 0;
+		size_t idxOffset = 0;
+		uint32_t elemCount = 0;
+	} pending;
+
+	auto flush = [&]() {
+		if (!pending.elemCount)
+			return;
+
+		const ImVec4 &clip_rect = pending.clipRect;
+		Graphics::ViewportExtents vp(clip_rect.x, (fb_height - clip_rect.w), (clip_rect.z - clip_rect.x), (clip_rect.w - clip_rect.y));
+		m_renderer->SetScissor(vp);
+
+		material->SetTexture(s_textureName, pending.texture);
+		material->SetPushConstant(s_vertexDepthName, pending.depth);
+		m_renderer->DrawBufferDynamic(m_vtxBuffer.get(), pending.vtxOffset, m_idxBuffer.get(), pending.idxOffset, pending.elemCount, material);
+
+		m_stats.numDraws++;
+		pending.elemCount = 0;
+	};
 
 	for (int n = 0; n < draw_data->CmdListsCount; n++) {
 		const ImDrawList *cmd_list = draw_data->CmdLists[n];
@@ -106,11 +146,9 @@ void InstanceRenderer::RenderDrawData(ImDrawData *draw_data, Graphics::Material*
 		// coalesce vertex and index data into a single buffer upload
 		auto &imVtxBuffer = cmd_list->VtxBuffer;
 		const size_t vtxOffset = vtxStagingBuffer.size();
-		vtxStagingBuffer.reserve(vtxOffset + imVtxBuffer.Size);
 
 		auto &imIdxBuffer = cmd_list->IdxBuffer;
 		const size_t idxOffset = idxStagingBuffer.size();
-		idxStagingBuffer.reserve(idxOffset + imIdxBuffer.Size);
 
 		// write this command list's data to the tail of the staging array
 		vtxStagingBuffer.insert(vtxStagingBuffer.end(), imVtxBuffer.Data, imVtxBuffer.Data + imVtxBuffer.Size);
@@ -119,25 +157,47 @@ void InstanceRenderer::RenderDrawData(ImDrawData *draw_data, Graphics::Material*
 		// Generate renderer commands for each draw command in the command buffer list.
 		for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++) {
 			const ImDrawCmd *pcmd = &cmd_list->CmdBuffer[cmd_i];
-			if (pcmd->UserCallback)
+			m_stats.numCommands++;
+
+			if (pcmd->UserCallback) {
+				// the callback may change renderer state, so nothing merges across it
+				flush();
 				pcmd->UserCallback(cmd_list, pcmd);
-			else {
+			} else {
 				ImVec2 pos = draw_data->DisplayPos;
 				ImVec4 clip_rect = pcmd->ClipRect - ImVec4(pos.x, pos.y, pos.x, pos.y);
 
 				// do a simple screen bounds test
 				if (clip_rect.x < fb_width && clip_rect.y < fb_height && clip_rect.z >= 0.f && clip_rect.w >= 0.f) {
-					Graphics::ViewportExtents vp(clip_rect.x, (fb_height - clip_rect.w), (clip_rect.z - clip_rect.x), (clip_rect.w - clip_rect.y));
-					m_renderer->SetScissor(vp);
-
-					material->SetTexture(s_textureName, reinterpret_cast<Graphics::Texture *>(pcmd->GetTexID()));
-					material->SetPushConstant(s_vertexDepthName, pcmd->PrimDepth);
-					m_renderer->DrawBufferDynamic(m_vtxBuffer.get(), vtxOffset + pcmd->VtxOffset, m_idxBuffer.get(), idxOffset + pcmd->IdxOffset, pcmd->ElemCount, material);
+					Graphics::Texture *texture = reinterpret_cast<Graphics::Texture *>(pcmd->GetTexID());
+					const size_t cmdVtxOffset = vtxOffset + pcmd->VtxOffset;
+					const size_t cmdIdxOffset = idxOffset + pcmd->IdxOffset;
+
+					const bool canMerge = pending.elemCount &&
+						pending.texture == texture &&
+						pending.depth == pcmd->PrimDepth &&
+						pending.vtxOffset == cmdVtxOffset &&
+						pending.idxOffset + pending.elemCount == cmdIdxOffset &&
+						0 == memcmp(&pending.clipRect, &clip_rect, sizeof(ImVec4));
+
+					if (canMerge) {
+						pending.elemCount += pcmd->ElemCount;
+					} else {
+						flush();
+						pending.texture = texture;
+						pending.clipRect = clip_rect;
+						pending.depth = pcmd->PrimDepth;
+						pending.vtxOffset = cmdVtxOffset;
+						pending.idxOffset = cmdIdxOffset;
+						pending.elemCount = pcmd->ElemCount;
+					}
 				}
 			}
 		}
 	}
 
+	flush();
+
 	// so long as we haven't issued FlushCommandBuffers() yet, we're perfectly fine to do this upload out-of-order.
 	m_vtxBuffer->BufferData(vtxStagingBuffer.size() * sizeof(ImDrawVert), vtxStagingBuffer.data());
 	m_idxBuffer->BufferData(idxStagingBuffer.size() * sizeof(ImDrawIdx), idxStagingBuffer.data());
@@ -5,19 +5,32 @@
 
 #include "graphics/Renderer.h"
 #include <memory>
+#include <vector>
 
 struct ImDrawData;
+struct ImDrawVert;
 
 namespace PiGui {
 
 	class InstanceRenderer {
 	public:
 		InstanceRenderer(Graphics::Renderer *r);
+		~InstanceRenderer();
 
 		void Initialize();
 		void Shutdown();
 
-		void NewFrame() {}
+		struct Stats {
+			uint32_t numCommands = 0; // ImDrawCmds submitted by ImGui
+			uint32_t numDraws = 0;	  // draw calls issued after merging
+			uint32_t numVertices = 0;
+			uint32_t numIndices = 0;
+		};
+
+		void NewFrame();
+
+		// Totals across every RenderDrawData call in the previous frame
+		const Stats &GetStats() const { return m_statsPrevious; }
 
 		// Render a draw data to the screen using an orthographic projection
 		void RenderDrawData(ImDrawData *draw_data);
@@ -39,5 +52,13 @@ namespace PiGui {
 		std::unique_ptr<Graphics::VertexBuffer> m_vtxBuffer;
 		std::unique_ptr<Graphics::IndexBuffer> m_idxBuffer;
 		std::unique_ptr<Graphics::Texture> m_fontsTexture;
+
+		// Staging storage kept between frames so uploading the draw data does
+		// not reallocate once the UI has reached its steady-state size
+		std::vector<ImDrawVert> m_vtxStaging;
+		std::vector<uint16_t> m_idxStaging;
+
+		Stats m_stats;
+		Stats m_statsPrevious;
 	};
 } // namespace PiGui
@@ -13,6 +13,29 @@ ImVec2 circlePos(float a, ImVec2 center, ImVec2 radius, float scale = 1.0f)
 	return ImVec2(center.x + sin(a) * scale * radius.x, center.y + cos(a) * scale * radius.y);
 }
 
+// the full rings are redrawn every frame, so their unit circle is computed once
+static const ImVec2 *unitCircle()
+{
+	static ImVec2 s_points[RADAR_STEPS];
+	static bool s_init = false;
+	if (!s_init) {
+		for (int i = 0; i < RADAR_STEPS; i++) {
+			const float ang = float(2 * M_PI) * i / RADAR_STEPS;
+			s_points[i] = ImVec2(sin(ang), cos(ang));
+		}
+		s_init = true;
+	}
+	return s_points;
+}
+
+static void pathRing(ImDrawList *drawList, ImVec2 center, ImVec2 radius, float scale = 1.0f)
+{
+	const ImVec2 *points = unitCircle();
+	const ImVec2 r(radius.x * scale, radius.y * scale);
+	for (int i = 0; i < RADAR_STEPS; i++)
+		drawList->PathLineTo(ImVec2(center.x + points[i].x * r.x, center.y + points[i].y * r.y));
+}
+
 void RadarWidget::SetSize(ImVec2 size)
 {
 	m_size = size;
@@ -32,9 +55,7 @@ void RadarWidget::DrawPiGui()
 	static const float step = circle / RADAR_STEPS;
 
 	// circle
-	for (float ang = 0; ang < circle; ang += step) {
-		drawList->PathLineTo(circlePos(ang, m_center, m_radius));
-	}
+	pathRing(drawList, m_center, m_radius);
 	drawList->PathFillConvex(ImGui::GetColorU32(ImGuiCol_FrameBg));
 
 #if 0
@@ -56,16 +77,12 @@ void RadarWidget::DrawPiGui()
 		if (dist < 0.1f) continue;
 		if (dist > 1.0f) break;
 
-		for (float ang = 0; ang < circle; ang += step) {
-			drawList->PathLineTo(circlePos(ang, m_center, m_radius, dist));
-		}
+		pathRing(drawList, m_center, m_radius, dist);
 		drawList->PathStroke(ImGui::GetColorU32(ImGuiCol_FrameBgActive), true);
 	}
 
 	// outer ring
-	for (float ang = 0; ang < circle; ang += step) {
-		drawList->PathLineTo(circlePos(ang, m_center, m_radius));
-	}
+	pathRing(drawList, m_center, m_radius);
 	drawList->PathStroke(ImGui::GetColorU32(ImGuiCol_FrameBgActive), true);
 
 	// inner ring
@@ -5,6 +5,8 @@
 #include "buildopts.h"
 #include "utils.h"
 #include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -136,7 +138,8 @@ namespace FileSystem {
 	}
 
 	FileSourceFS::FileSourceFS(const std::string &root, bool trusted) :
-		FileSource(absolute_path(root), trusted) {}
+		FileSource(absolute_path(root), trusted),
+		m_mapThreshold(trusted ? MAP_READ_THRESHOLD : 0) {}
 
 	FileSourceFS::~FileSourceFS() {}
 
@@ -179,15 +182,52 @@ namespace FileSystem {
 		return MakeFileInfo(path, ty, mtime);
 	}
 
+	class FileDataMapped : public FileData {
+	public:
+		FileDataMapped(const FileInfo &info, size_t size, char *data) :
+			FileData(info, size, data) {}
+		virtual ~FileDataMapped() { munmap(m_data, m_size); }
+	};
+
+	// returns a read-only mapping of the whole file, or nullptr if it can't
+	// be mapped (empty files can't be)
+	static char *map_file(const char *fullpath, size_t &size)
+	{
+		const int fd = open(fullpath, O_RDONLY);
+		if (fd < 0)
+			return nullptr;
+
+		struct stat info;
+		void *data = MAP_FAILED;
+		if (fstat(fd, &info) == 0 && info.st_size > 0) {
+			size = size_t(info.st_size);
+			data = mmap(0, size, PROT_READ, MAP_SHARED, fd, 0);
+		}
+		// the mapping stays valid after the descriptor is closed
+		close(fd);
+
+		return data == MAP_FAILED ? nullptr : static_cast<char *>(data);
+	}
+
 	RefCountedPtr<FileData> FileSourceFS::ReadFile(const std::string &path)
 	{
 		const std::string fullpath = JoinPathBelow(GetRoot(), path);
 		Time::DateTime mtime;
 
-		FileInfo::FileType ty = stat_path(fullpath.c_str(), mtime);
+		struct stat info;
+		FileInfo::FileType ty = FileInfo::FT_NON_EXISTENT;
+		if (stat(fullpath.c_str(), &info) == 0)
+			ty = interpret_stat(info, mtime);
 
 		if (ty == FileInfo::FT_FILE) {
 
+			// large files are shared with the page cache rather than copied
+			if (m_mapThreshold > 0 && size_t(info.st_size) >= m_mapThreshold) {
+				size_t size;
+				if (char *data = map_file(fullpath.c_str(), size))
+					return RefCountedPtr<FileData>(new FileDataMapped(MakeFileInfo(path, ty, mtime), size, data));
+			}
+
 			FILE *fl = fopen(fullpath.c_str(), "rb");
 			if (fl) {
 				fseek(fl, 0, SEEK_END);
@@ -214,6 +254,21 @@ namespace FileSystem {
 		return RefCountedPtr<FileData>(0);
 	}
 
+	RefCountedPtr<FileData> FileSourceFS::MapFile(const std::string &path)
+	{
+		const std::string fullpath = JoinPathBelow(GetRoot(), path);
+		Time::DateTime mtime;
+
+		if (stat_path(fullpath.c_str(), mtime) != FileInfo::FT_FILE)
+			return RefCountedPtr<FileData>(0);
+
+		size_t size;
+		char *data = map_file(fullpath.c_str(), size);
+		if (!data)
+			return ReadFile(path);
+		return RefCountedPtr<FileData>(new FileDataMapped(MakeFileInfo(path, FileInfo::FT_FILE, mtime), size, data));
+	}
+
 	bool FileSourceFS::ReadDirectory(const std::string &dirpath, std::vector<FileInfo> &output)
 	{
 		const std::string fulldirpath = JoinPathBelow(GetRoot(), dirpath);
@@ -16,6 +16,10 @@
 #include <unistd.h>
 #endif
 #include <sys/utsname.h>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 namespace OS {
 
@@ -81,6 +85,20 @@ namespace OS {
 #endif
 	}
 
+	bool SetCurrentThreadAffinity(uint32_t core)
+	{
+#if defined(__linux__)
+		cpu_set_t cpuSet;
+		CPU_ZERO(&cpuSet);
+		CPU_SET(core % GetNumCores(), &cpuSet);
+		return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSet) == 0;
+#else
+		// macOS only exposes affinity hints via thread_policy_set, which the
+		// scheduler is free to ignore; don't pretend to pin threads there.
+		return false;
+#endif
+	}
+
 	const std::string GetOSInfoString()
 	{
 		int z;
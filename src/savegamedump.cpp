@@ -3,34 +3,112 @@
 
 #include "FileSystem.h"
 #include "Json.h"
+#include "JsonPathFilter.h"
+#include "JsonUtils.h"
 #include "core/GZipFormat.h"
+#include "core/LZ4Format.h"
 #include <SDL.h>
 
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+
 int info()
 {
 	printf(
 		"savegamedump - Dump saved games to JSON for easy inspection.\n"
 		"All paths are relative to the pioneer data folder.\n"
-		"USAGE: savegamedump [--pretty] <input> [output]\n");
+		"USAGE: savegamedump [--pretty] [--stats] [--extract <path>]... <input> [output]\n"
+		"  --pretty          indent the output\n"
+		"  --stats           print the size and decoding time of each section of the save\n"
+		"  --extract <path>  only output the values at a JSON path, such as\n"
+		"                    space.bodies[*].type or lua_modules.Missions, where * matches\n"
+		"                    any key or index. Sections of the save no path can be in are\n"
+		"                    skipped, and nothing else is kept in memory. May be repeated.\n"
+		"Extracted values are written to output, or printed if there is none; a full dump\n"
+		"is written to output, or to <input>.json.\n");
 	return 1;
 }
 
+namespace {
+	using Clock = std::chrono::steady_clock;
+
+	double MillisecondsSince(Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	struct SectionStats {
+		std::string key;
+		size_t compressedSize = 0;
+		size_t size = 0;
+		double decompressMs = 0.0;
+		double parseMs = 0.0;
+		size_t matches = 0;
+		bool skipped = false;
+	};
+
+	void PrintStats(const std::vector<SectionStats> &stats, bool extracting)
+	{
+		printf("%-24s %12s %12s %12s %10s%s\n", "section", "compressed", "size", "decompress", "parse", extracting ? "    matches" : "");
+		SectionStats total;
+		for (const SectionStats &s : stats) {
+			const std::string name = s.key.empty() ? "(small values)" : s.key;
+			if (s.skipped) {
+				printf("%-24s %12zu %12s\n", name.c_str(), s.compressedSize, "skipped");
+			} else if (extracting) {
+				printf("%-24s %12zu %12zu %10.2fms %8.2fms %10zu\n", name.c_str(), s.compressedSize, s.size, s.decompressMs, s.parseMs, s.matches);
+			} else {
+				printf("%-24s %12zu %12zu %10.2fms %8.2fms\n", name.c_str(), s.compressedSize, s.size, s.decompressMs, s.parseMs);
+			}
+			total.compressedSize += s.compressedSize;
+			total.size += s.size;
+			total.decompressMs += s.decompressMs;
+			total.parseMs += s.parseMs;
+			total.matches += s.matches;
+		}
+		if (extracting)
+			printf("%-24s %12zu %12zu %10.2fms %8.2fms %10zu\n", "total", total.compressedSize, total.size, total.decompressMs, total.parseMs, total.matches);
+		else
+			printf("%-24s %12zu %12zu %10.2fms %8.2fms\n", "total", total.compressedSize, total.size, total.decompressMs, total.parseMs);
+	}
+} // namespace
+
 extern "C" int main(int argc, char **argv)
 {
-	if (argc < 2) return info();
-
 	int indent = -1;
-	int shift = 0;
+	bool showStats = false;
+	std::vector<std::string> extractPaths;
+	std::vector<std::string> args;
 
-	std::string filename = argv[1];
-	if (filename == "--pretty") {
-		indent = 2;
-		shift = 1;
+	for (int i = 1; i < argc; i++) {
+		const std::string arg = argv[i];
+		if (arg == "--pretty") {
+			indent = 2;
+		} else if (arg == "--stats") {
+			showStats = true;
+		} else if (arg == "--extract") {
+			if (++i >= argc) return info();
+			extractPaths.push_back(argv[i]);
+		} else {
+			args.push_back(arg);
+		}
 	}
 
-	if (argc < shift+2 || argc > shift+3) return info();
-	filename = argv[shift+1];
-	std::string outname = argc > shift+2 ? argv[shift+2] : filename + ".json";
+	if (args.size() < 1 || args.size() > 2) return info();
+	const std::string filename = args[0];
+	const bool extracting = !extractPaths.empty();
+	std::string outname = args.size() > 1 ? args[1] : extracting ? std::string() : filename + ".json";
+
+	std::unique_ptr<JsonPathFilter> filter;
+	if (extracting) {
+		try {
+			filter.reset(new JsonPathFilter(extractPaths));
+		} catch (std::invalid_argument &e) {
+			printf("%s\n", e.what());
+			return 1;
+		}
+	}
 
 	auto fileinfo = FileSystem::userFiles.Lookup(filename);
 	if (!fileinfo.Exists()) {
@@ -45,43 +123,90 @@ extern "C" int main(int argc, char **argv)
 		return 1;
 	}
 
-	const auto compressed_data = file->AsByteRange();
-	Json rootNode;
-	try {
-		std::string plain_data;
-		if (gzip::IsGZipFormat(reinterpret_cast<const uint8_t *>(compressed_data.begin), compressed_data.Size()))
-			plain_data = gzip::DecompressDeflateOrGZip(reinterpret_cast<const uint8_t *>(compressed_data.begin), compressed_data.Size());
-		else
-			plain_data = std::string(compressed_data.begin, compressed_data.Size());
+	const auto file_data = file->AsByteRange();
+	// skip the metadata header, it duplicates parts of the main data
+	const size_t headerSize = JsonUtils::GetSaveFileHeaderSize(file_data.begin, file_data.Size());
 
+	// sections are decoded one at a time, so only the one being worked on
+	// (or, when extracting, just the matched values) is held in memory
+	Json rootNode = Json::object();
+	JsonPathFilter::Matches matches;
+	std::vector<SectionStats> stats;
+	try {
 		try {
-			// Allow loading files in JSON format as well as CBOR
-			if (plain_data[0] == '{')
-				rootNode = Json::parse(plain_data);
-			else
-				rootNode = Json::from_cbor(plain_data);
+			for (const auto &section : JsonUtils::GetSaveFileSections(file_data.begin + headerSize, file_data.Size() - headerSize)) {
+				SectionStats s;
+				s.key = section.key;
+				s.compressedSize = section.size;
+				if (extracting && !section.key.empty() && !filter->MatchesTopLevelKey(section.key)) {
+					s.skipped = true;
+					stats.push_back(s);
+					continue;
+				}
+
+				Clock::time_point start = Clock::now();
+				const std::string plain = JsonUtils::DecompressSaveFileSection(section);
+				s.decompressMs = MillisecondsSince(start);
+				s.size = plain.size();
+				if (plain.empty()) {
+					stats.push_back(s);
+					continue;
+				}
+
+				// as with loading, JSON text is accepted as well as CBOR
+				const Json::input_format_t format = plain[0] == '{' ? Json::input_format_t::json : Json::input_format_t::cbor;
+				start = Clock::now();
+				if (extracting) {
+					const size_t before = matches.size();
+					filter->Extract(plain, format, section.key, matches);
+					s.matches = matches.size() - before;
+				} else {
+					Json value = format == Json::input_format_t::json ? Json::parse(plain) : Json::from_cbor(plain);
+					if (!section.key.empty()) {
+						rootNode[section.key] = std::move(value);
+					} else if (value.is_object()) {
+						for (auto it = value.begin(); it != value.end(); ++it)
+							rootNode[it.key()] = std::move(it.value());
+					} else {
+						printf("Saved game's root is not a JSON object.\n");
+						return 2;
+					}
+				}
+				s.parseMs = MillisecondsSince(start);
+				stats.push_back(s);
+			}
 		} catch (Json::parse_error &e) {
 			printf("Saved game is not a valid JSON object: %s.\n", e.what());
 			return 2;
 		}
-
-		if (!rootNode.is_object()) {
-			printf("Saved game's root is not a JSON object.\n");
-			return 2;
-		}
 	} catch (gzip::DecompressionFailedException) {
 		printf("Decompressing saved data failed - saved game is corrupt.\n");
 		return 3;
+	} catch (const lz4::DecompressionFailedException &) {
+		printf("Decompressing saved data failed - saved game is corrupt.\n");
+		return 3;
 	}
 
-	auto outFile = FileSystem::userFiles.OpenWriteStream(outname);
-	if (!outFile) {
-		printf("Could not open output file %s.\n", outname.c_str());
-		return 1;
+	if (showStats)
+		PrintStats(stats, extracting);
+
+	FILE *outFile = stdout;
+	if (!outname.empty()) {
+		outFile = FileSystem::userFiles.OpenWriteStream(outname);
+		if (!outFile) {
+			printf("Could not open output file %s.\n", outname.c_str());
+			return 1;
+		}
 	}
 
-	fputs(rootNode.dump(indent).c_str(), outFile);
-	fclose(outFile);
+	if (extracting) {
+		for (const auto &match : matches)
+			fprintf(outFile, "%s: %s\n", match.first.c_str(), match.second.dump(indent).c_str());
+	} else {
+		fputs(rootNode.dump(indent).c_str(), outFile);
+	}
+	if (outFile != stdout)
+		fclose(outFile);
 
 	return 0;
 }
@@ -10,11 +10,11 @@
 namespace SceneGraph {
 
 	typedef std::vector<AnimationChannel> ChannelList;
-	typedef ChannelList::iterator ChannelIterator;
 
 	Animation::Animation(const std::string &name, double duration) :
 		m_duration(duration),
 		m_time(0.0),
+		m_interpolatedTime(-1.0),
 		m_name(name)
 	{
 	}
@@ -22,6 +22,7 @@ namespace SceneGraph {
 	Animation::Animation(const Animation &anim) :
 		m_duration(anim.m_duration),
 		m_time(0.0),
+		m_interpolatedTime(-1.0),
 		m_name(anim.m_name)
 	{
 		for (ChannelList::const_iterator chan = anim.m_channels.begin(); chan != anim.m_channels.end(); ++chan) {
@@ -39,23 +40,39 @@ namespace SceneGraph {
 		}
 	}
 
+	// Finds the last key at or before time, starting from the key found last
+	// time, and only going back to the start when the time went backwards
+	template <typename Key>
+	static unsigned int find_key(const std::vector<Key> &keys, double time, unsigned int &cursor)
+	{
+		unsigned int frame = cursor < keys.size() ? cursor : 0;
+		if (frame > 0 && time < keys[frame].time)
+			frame = 0;
+		while (frame + 1 < keys.size()) {
+			if (time < keys[frame + 1].time)
+				break;
+			frame++;
+		}
+		cursor = frame;
+		return frame;
+	}
+
 	void Animation::Interpolate()
 	{
 		PROFILE_SCOPED()
 		const double mtime = m_time;
+		m_interpolatedTime = m_time;
+		if (m_cursors.size() != m_channels.size())
+			m_cursors.assign(m_channels.size(), KeyCursor());
 
 		//go through channels and calculate transforms
-		for (ChannelIterator chan = m_channels.begin(); chan != m_channels.end(); ++chan) {
+		for (size_t c = 0; c < m_channels.size(); c++) {
+			AnimationChannel *chan = &m_channels[c];
+			KeyCursor &cursor = m_cursors[c];
 			matrix4x4f trans = chan->node->GetTransform();
 
 			if (!chan->rotationKeys.empty()) {
-				//find a frame. To optimize, should begin search from previous frame (when mTime > previous mTime)
-				unsigned int frame = 0;
-				while (frame + 1 < chan->rotationKeys.size()) {
-					if (mtime < chan->rotationKeys[frame + 1].time)
-						break;
-					frame++;
-				}
+				const unsigned int frame = find_key(chan->rotationKeys, mtime, cursor.rotation);
 
 				const RotationKey &a = chan->rotationKeys[frame];
 				vector3f saved_position = trans.GetTranslate();
@@ -75,13 +92,7 @@ namespace SceneGraph {
 			//continously scale the transform (would have to add originalTransform or
 			//something to MT)
 			if (!chan->scaleKeys.empty() && !chan->rotationKeys.empty()) {
-				//find a frame. To optimize, should begin search from previous frame (when mTime > previous mTime)
-				unsigned int frame = 0;
-				while (frame + 1 < chan->scaleKeys.size()) {
-					if (mtime < chan->scaleKeys[frame + 1].time)
-						break;
-					frame++;
-				}
+				const unsigned int frame = find_key(chan->scaleKeys, mtime, cursor.scale);
 
 				const ScaleKey &a = chan->scaleKeys[frame];
 				vector3f out;
@@ -98,13 +109,7 @@ namespace SceneGraph {
 			}
 
 			if (!chan->positionKeys.empty()) {
-				//find a frame. To optimize, should begin search from previous frame (when mTime > previous mTime)
-				unsigned int frame = 0;
-				while (frame + 1 < chan->positionKeys.size()) {
-					if (mtime < chan->positionKeys[frame + 1].time)
-						break;
-					frame++;
-				}
+				const unsigned int frame = find_key(chan->positionKeys, mtime, cursor.position);
 
 				const PositionKey &a = chan->positionKeys[frame];
 				vector3f out;
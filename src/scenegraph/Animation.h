@@ -14,6 +14,7 @@ namespace SceneGraph {
 
 	class Loader;
 	class BinaryConverter;
+	class LODGenerator;
 	class Node;
 
 	class Animation {
@@ -26,15 +27,28 @@ namespace SceneGraph {
 		double GetProgress();
 		void SetProgress(double); //0.0 -- 1.0, overrides m_time
 		void Interpolate(); //update transforms according to m_time;
+		// whether the time changed since the last Interpolate
+		bool NeedsInterpolate() const { return m_time != m_interpolatedTime; }
 		const std::vector<AnimationChannel> &GetChannels() const { return m_channels; }
 
 	private:
 		friend class Loader;
 		friend class BinaryConverter;
+		friend class LODGenerator;
+		// the keys each channel's last Interpolate used, where the next search
+		// starts so playback doesn't scan all the keys every frame
+		struct KeyCursor {
+			unsigned int position = 0;
+			unsigned int rotation = 0;
+			unsigned int scale = 0;
+		};
+
 		double m_duration;
 		double m_time;
+		double m_interpolatedTime;
 		std::string m_name;
 		std::vector<AnimationChannel> m_channels;
+		std::vector<KeyCursor> m_cursors;
 	};
 
 } // namespace SceneGraph
@@ -8,6 +8,8 @@
 #include "graphics/Types.h"
 #include "utils.h"
 
+#include <algorithm>
+
 using namespace SceneGraph;
 
 BaseLoader::BaseLoader(Graphics::Renderer *r) :
@@ -69,20 +71,30 @@ void BaseLoader::ConvertMaterialDefinition(const MaterialDefinition &mdef)
 	Graphics::Texture *texture2 = nullptr;
 	Graphics::Texture *texture3 = nullptr;
 	Graphics::Texture *texture6 = nullptr;
+	// loaded in the background, drawn meanwhile with placeholders that look like no map at all
 	if (!diffTex.empty())
-		texture0 = Graphics::TextureBuilder::Model(diffTex).GetOrCreateTexture(m_renderer, "model");
+		texture0 = Graphics::TextureBuilder::Model(diffTex).GetOrCreateTextureAsync(m_renderer, "model", Color::WHITE, true);
 	else
 		texture0 = Graphics::TextureBuilder::GetWhiteTexture(m_renderer);
 	if (!specTex.empty())
-		texture1 = Graphics::TextureBuilder::Model(specTex).GetOrCreateTexture(m_renderer, "model");
+		texture1 = Graphics::TextureBuilder::Model(specTex).GetOrCreateTextureAsync(m_renderer, "model", Color::BLACK, true);
 	if (!glowTex.empty())
-		texture2 = Graphics::TextureBuilder::Model(glowTex).GetOrCreateTexture(m_renderer, "model");
+		texture2 = Graphics::TextureBuilder::Model(glowTex).GetOrCreateTextureAsync(m_renderer, "model", Color::BLACK, true);
 	if (!ambiTex.empty())
-		texture3 = Graphics::TextureBuilder::Model(ambiTex).GetOrCreateTexture(m_renderer, "model");
+		texture3 = Graphics::TextureBuilder::Model(ambiTex).GetOrCreateTextureAsync(m_renderer, "model", Color::WHITE, true);
 	//texture4 is reserved for pattern
 	//texture5 is reserved for color gradient
 	if (!normTex.empty())
-		texture6 = Graphics::TextureBuilder::Normal(normTex).GetOrCreateTexture(m_renderer, "model");
+		texture6 = Graphics::TextureBuilder::Normal(normTex).GetOrCreateTextureAsync(m_renderer, "model", Color(128, 128, 255), true);
+
+	// the model tells the streamer how large its textures are drawn; those
+	// still loading may turn out to be streamed
+	if (m_renderer->GetTextureStreamer()) {
+		std::vector<Graphics::Texture *> &textures = m_model->m_materialTextures;
+		for (Graphics::Texture *texture : { texture0, texture1, texture2, texture3, texture6 })
+			if (texture && std::find(textures.begin(), textures.end(), texture) == textures.end())
+				textures.push_back(texture);
+	}
 
 	mat->SetTexture("texture0"_hash, texture0);
 	mat->SetTexture("texture1"_hash, texture1);
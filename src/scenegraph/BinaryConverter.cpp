@@ -25,16 +25,19 @@ union SGM_STRING_VALUE {
 	Uint32 value;
 };
 const SGM_STRING_VALUE SGM_STRING_ID = { { 's', 'g', 'm', SGM_VERSION } };
+// signature, version, compressed node data size, geometry offset and size
+const size_t SGM_HEADER_SIZE = 2 * sizeof(Uint32) + 3 * sizeof(Uint64);
 const std::string SGM_EXTENSION = ".sgm";
 const std::string SAVE_TARGET_DIR = "binarymodels";
 
 class SaveHelperVisitor : public NodeVisitor {
 public:
-	SaveHelperVisitor(Serializer::Writer *wr, Model *m)
+	SaveHelperVisitor(Serializer::Writer *wr, Serializer::Writer *geomWr, Model *m)
 	{
 		db.wr = wr;
 		db.rd = nullptr;
 		db.model = m;
+		db.geomWr = geomWr;
 	}
 
 	virtual void ApplyNode(Node &n) override
@@ -108,7 +111,22 @@ void BinaryConverter::Save(const std::string &filename, const std::string &savep
 		if (!f) throw CouldNotOpenFileException();
 	}
 
+	try {
+		const std::string data = Serialize(m);
+		fwrite(data.data(), data.size(), 1, f);
+		fclose(f);
+	} catch (std::runtime_error &e) {
+		fclose(f);
+		Log::Error("Error saving SGM model: {}\n", e.what());
+		throw CouldNotWriteToFileException();
+	}
+}
+
+std::string BinaryConverter::Serialize(Model *m)
+{
+	PROFILE_SCOPED()
 	Serializer::Writer wr;
+	Serializer::Writer geomWr;
 
 	wr.Int32(SGM_STRING_ID.value);
 
@@ -118,7 +136,7 @@ void BinaryConverter::Save(const std::string &filename, const std::string &savep
 
 	SaveMaterials(wr, m);
 
-	SaveHelperVisitor sv(&wr, m);
+	SaveHelperVisitor sv(&wr, &geomWr, m);
 	m->GetRoot()->Accept(sv);
 
 	m->GetCollisionMesh()->Save(wr);
@@ -131,19 +149,39 @@ void BinaryConverter::Save(const std::string &filename, const std::string &savep
 	for (unsigned int i = 0; i < m->GetNumTags(); i++)
 		wr.String(m->GetTagByIndex(i)->GetName().c_str());
 
-	// compress in memory, write to open file
-	size_t outSize = 0;
+	// compress the node data in memory
+	// header | compressed nodes | padding | geometry
 	const std::string &data = wr.GetData();
-	try {
-		std::string compressedData = lz4::CompressLZ4(data, 6);
-		outSize = compressedData.size();
-		Output("Compressed model (%s): %.2f KB -> %.2f KB\n", filename.c_str(), data.size() / 1024.f, outSize / 1024.f);
-		fwrite(compressedData.data(), outSize, 1, f);
-		fclose(f);
-	} catch (std::runtime_error &e) {
-		Log::Error("Error saving SGM model: {}\n", e.what());
-		throw CouldNotWriteToFileException();
-	}
+	const std::string &geometry = geomWr.GetData();
+	std::string compressedData = lz4::CompressLZ4(data, 6);
+	Output("Compressed model (%s): %.2f KB -> %.2f KB, %.2f KB geometry\n", m->GetName().c_str(),
+		data.size() / 1024.f, compressedData.size() / 1024.f, geometry.size() / 1024.f);
+
+	Serializer::Writer header;
+	header.Int32(SGM_STRING_ID.value);
+	header.Int32(SGM_VERSION);
+	header.Int64(compressedData.size());
+	const size_t nodesEnd = SGM_HEADER_SIZE + compressedData.size();
+	const size_t geomOffset = (nodesEnd + SGM_GEOMETRY_ALIGNMENT - 1) / SGM_GEOMETRY_ALIGNMENT * SGM_GEOMETRY_ALIGNMENT;
+	header.Int64(geomOffset);
+	header.Int64(geometry.size());
+	assert(header.Pos() == SGM_HEADER_SIZE);
+
+	std::string out;
+	out.reserve(geomOffset + geometry.size());
+	out.append(header.GetData().data(), header.Pos());
+	out += compressedData;
+	out.resize(geomOffset, '\0');
+	out += geometry;
+	return out;
+}
+
+//static
+bool BinaryConverter::SavedModelExists(const std::string &savepath, const bool bInPlace)
+{
+	if (bInPlace)
+		return FileSystem::FileSourceFS(FileSystem::GetDataDir()).Lookup(savepath + SGM_EXTENSION).IsFile();
+	return FileSystem::userFiles.Lookup(FileSystem::JoinPathBelow(SAVE_TARGET_DIR, savepath + SGM_EXTENSION)).IsFile();
 }
 
 Model *BinaryConverter::Load(const std::string &filename)
@@ -154,17 +192,64 @@ Model *BinaryConverter::Load(const std::string &filename)
 Model *BinaryConverter::Load(const std::string &name, RefCountedPtr<FileSystem::FileData> binfile)
 {
 	PROFILE_SCOPED()
+	PreparedModel prepared;
+	prepared.name = name;
+	prepared.path = m_curPath;
+	if (!Decompress(binfile, prepared))
+		return nullptr;
+	return Load(prepared);
+}
+
+Model *BinaryConverter::Load(const PreparedModel &prepared)
+{
+	PROFILE_SCOPED()
+	m_curPath = prepared.path;
 	Model *model(nullptr);
+	try {
+		Serializer::Reader rd(ByteRange(prepared.nodeData.data(), prepared.nodeData.size()));
+		model = CreateModel(prepared.name, rd, prepared.geometry);
+	} catch (std::runtime_error &e) {
+		Log::Error("Error loading SGM model: {}\n", e.what());
+	}
+	return model;
+}
+
+//static
+bool BinaryConverter::Decompress(RefCountedPtr<FileSystem::FileData> binfile, PreparedModel &out)
+{
+	PROFILE_SCOPED()
+	out.file = binfile;
 	// decompress the loaded ByteRange in memory
 	const ByteRange bin = binfile->AsByteRange();
-	if (lz4::IsLZ4Format(bin.begin, bin.Size())) {
+	Uint32 sig = 0;
+	if (bin.Size() >= SGM_HEADER_SIZE)
+		memcpy(&sig, bin.begin, sizeof(sig));
+	if (sig == SGM_STRING_ID.value) {
+		// only the node data is compressed, the geometry is used straight from the file
 		try {
-			std::string decompressedData = lz4::DecompressLZ4({ bin.begin, bin.Size() });
-			// Output("decompressed model file %s (%.2f KB) -> %.2f KB\n", name.c_str(), binfile->GetSize() / 1024.f, decompressedData.size() / 1024.f);
-			Serializer::Reader rd(ByteRange(decompressedData.data(), decompressedData.size()));
-			model = CreateModel(name, rd);
+			Serializer::Reader header(ByteRange(bin.begin, SGM_HEADER_SIZE));
+			header.Int32();
+			header.Int32();
+			const Uint64 nodesSize = header.Int64();
+			const Uint64 geomOffset = header.Int64();
+			const Uint64 geomSize = header.Int64();
+			if (SGM_HEADER_SIZE + nodesSize > geomOffset || geomOffset + geomSize > bin.Size())
+				throw std::runtime_error("truncated SGM file");
+
+			out.nodeData = lz4::DecompressLZ4({ bin.begin + SGM_HEADER_SIZE, size_t(nodesSize) });
+			if (geomSize)
+				out.geometry = ByteRange(bin.begin + geomOffset, size_t(geomSize));
 		} catch (std::runtime_error &e) {
 			Log::Error("Error loading SGM model: {}\n", e.what());
+			return false;
+		}
+	} else if (lz4::IsLZ4Format(bin.begin, bin.Size())) {
+		try {
+			out.nodeData = lz4::DecompressLZ4({ bin.begin, bin.Size() });
+			// Output("decompressed model file %s (%.2f KB) -> %.2f KB\n", out.name.c_str(), binfile->GetSize() / 1024.f, out.nodeData.size() / 1024.f);
+		} catch (std::runtime_error &e) {
+			Log::Error("Error loading SGM model: {}\n", e.what());
+			return false;
 		}
 	} else {
 		void *pDecompressedData;
@@ -173,21 +258,27 @@ Model *BinaryConverter::Load(const std::string &name, RefCountedPtr<FileSystem::
 			PROFILE_SCOPED_DESC("tinfl_decompress_mem_to_heap")
 			pDecompressedData = tinfl_decompress_mem_to_heap(&bin[0], bin.Size(), &outSize, 0);
 		}
-		// Output("decompressed model file %s (%.2f KB) -> %.2f KB\n", name.c_str(), binfile->GetSize() / 1024.f, outSize / 1024.f);
-		if (pDecompressedData) {
-			// now parse in-memory representation as new ByteRange.
-			Serializer::Reader rd(ByteRange(static_cast<char *>(pDecompressedData), outSize));
-			model = CreateModel(name, rd);
-			mz_free(pDecompressedData);
-		} else {
-			Log::Warning("BinaryConverter failed to load old-style SGM called: {}\n", name.c_str());
+		// Output("decompressed model file %s (%.2f KB) -> %.2f KB\n", out.name.c_str(), binfile->GetSize() / 1024.f, outSize / 1024.f);
+		if (!pDecompressedData) {
+			Log::Warning("BinaryConverter failed to load old-style SGM called: {}\n", out.name.c_str());
+			return false;
 		}
+		out.nodeData.assign(static_cast<char *>(pDecompressedData), outSize);
+		mz_free(pDecompressedData);
 	}
 
-	return model;
+	return true;
 }
 
 Model *BinaryConverter::Load(const std::string &shortname, const std::string &basepath)
+{
+	PROFILE_SCOPED()
+	std::unique_ptr<PreparedModel> prepared = Prepare(shortname, basepath);
+	return prepared ? Load(*prepared) : nullptr;
+}
+
+//static
+std::unique_ptr<BinaryConverter::PreparedModel> BinaryConverter::Prepare(const std::string &shortname, const std::string &basepath)
 {
 	PROFILE_SCOPED()
 	FileSystem::FileSource &fileSource = FileSystem::gameDataFiles;
@@ -201,15 +292,19 @@ Model *BinaryConverter::Load(const std::string &shortname, const std::string &ba
 			const std::string name = info.GetName();
 
 			if (shortname == name.substr(0, name.length() - SGM_EXTENSION.length())) {
-				//curPath is used to find textures, patterns,
+				std::unique_ptr<PreparedModel> prepared(new PreparedModel);
+				prepared->name = name;
+				//path is used to find textures, patterns,
 				//possibly other data files for this model.
 				//Strip trailing slash
-				m_curPath = info.GetDir();
-				if (m_curPath[m_curPath.length() - 1] == '/')
-					m_curPath = m_curPath.substr(0, m_curPath.length() - 1);
+				prepared->path = info.GetDir();
+				if (prepared->path[prepared->path.length() - 1] == '/')
+					prepared->path = prepared->path.substr(0, prepared->path.length() - 1);
 
 				RefCountedPtr<FileSystem::FileData> binfile = info.Read();
-				if (binfile.Valid()) return Load(name, binfile);
+				if (!binfile.Valid() || !Decompress(binfile, *prepared))
+					return nullptr;
+				return prepared;
 			}
 		}
 	}
@@ -218,7 +313,31 @@ Model *BinaryConverter::Load(const std::string &shortname, const std::string &ba
 	return nullptr;
 }
 
-Model *BinaryConverter::CreateModel(const std::string &filename, Serializer::Reader &rd)
+std::unique_ptr<BinaryConverter::PreparedModel> BinaryConverter::Prepare(Model *m)
+{
+	PROFILE_SCOPED()
+	std::string data;
+	try {
+		data = Serialize(m);
+	} catch (std::runtime_error &e) {
+		Log::Error("Error serializing SGM model: {}\n", e.what());
+		return nullptr;
+	}
+
+	char *buffer = static_cast<char *>(std::malloc(data.size()));
+	memcpy(buffer, data.data(), data.size());
+	RefCountedPtr<FileSystem::FileData> binfile(new FileSystem::FileDataMalloc(FileSystem::FileInfo(), data.size(), buffer));
+
+	std::unique_ptr<PreparedModel> prepared(new PreparedModel);
+	prepared->name = m->GetName();
+	// SaveMaterials found the .model file, and with it the model's directory
+	prepared->path = m_curPath;
+	if (!Decompress(binfile, *prepared))
+		return nullptr;
+	return prepared;
+}
+
+Model *BinaryConverter::CreateModel(const std::string &filename, Serializer::Reader &rd, ByteRange geometry)
 {
 	PROFILE_SCOPED()
 	//verify signature
@@ -241,7 +360,7 @@ Model *BinaryConverter::CreateModel(const std::string &filename, Serializer::Rea
 	m_patternsUsed = false;
 	LoadMaterials(rd);
 
-	Group *root = dynamic_cast<Group *>(LoadNode(rd));
+	Group *root = dynamic_cast<Group *>(LoadNode(rd, geometry));
 	if (!root) throw LoadingError("Expected root");
 	m_model->m_root.Reset(root);
 
@@ -421,7 +540,7 @@ ModelDefinition BinaryConverter::FindModelDefinition(const std::string &shortnam
 	throw(LoadingError("File not found"));
 }
 
-Node *BinaryConverter::LoadNode(Serializer::Reader &rd)
+Node *BinaryConverter::LoadNode(Serializer::Reader &rd, ByteRange geometry)
 {
 	PROFILE_START()
 	const std::string ntype = rd.String();
@@ -435,6 +554,7 @@ Node *BinaryConverter::LoadNode(Serializer::Reader &rd)
 	db.loader = this;
 	db.model = m_model;
 	db.rd = &rd;
+	db.geomData = geometry;
 
 	auto loadFuncIt = m_loaders.find(ntype);
 	if (loadFuncIt == m_loaders.end()) {
@@ -458,7 +578,7 @@ Node *BinaryConverter::LoadNode(Serializer::Reader &rd)
 	if (Group *grp = dynamic_cast<Group *>(node)) {
 		Uint32 numChildren = rd.Int32();
 		for (Uint32 i = 0; i < numChildren; i++)
-			grp->AddChild(LoadNode(rd));
+			grp->AddChild(LoadNode(rd, geometry));
 	}
 
 	return node;
@@ -19,6 +19,7 @@
 #include "StaticGeometry.h"
 #include "Thruster.h"
 #include <functional>
+#include <memory>
 
 namespace Serializer {
 	class Reader;
@@ -39,30 +40,62 @@ namespace SceneGraph {
 	// 6.1:	rewrote serialization, use lz4 compression instead of INFLATE/DEFLATE. Still compatible.
 	// 6.2: ignored StaticGeometry::m_blendMode in files. Still write blank value.
 	// 7:   Added discrete Tag node, tags are registered in the model hierarchy instead of at the root.
-	constexpr Uint32 SGM_VERSION = 7;
+	// 8:   Store the flattened four-wide triangle BVH with collision meshes
+	// 9:   Uncompressed header, vertex and index data moved to a page-aligned
+	//      uncompressed section after the lz4 compressed node data
+	constexpr Uint32 SGM_VERSION = 9;
+
+	// the geometry section starts on a page boundary so it can be mapped as-is
+	constexpr Uint32 SGM_GEOMETRY_ALIGNMENT = 4096;
 
 	class BinaryConverter : public BaseLoader {
 	public:
 		BinaryConverter(Graphics::Renderer *);
 		void Save(const std::string &filename, Model *m);
+		// Saving in place adds the file to the data directory without
+		// invalidating gameDataFiles' index, so saves can run from several
+		// jobs at once; invalidate it afterwards to load the new files.
 		void Save(const std::string &filename, const std::string &savepath, Model *m, const bool bInPlace);
+		// The contents of the .sgm file Save would write
+		std::string Serialize(Model *m);
+		// true if Save has written a file for savepath
+		static bool SavedModelExists(const std::string &savepath, const bool bInPlace);
 		Model *Load(const std::string &filename);
 		Model *Load(const std::string &filename, const std::string &path);
 		Model *Load(const std::string &filename, RefCountedPtr<FileSystem::FileData> binfile);
 
+		// The parts of loading that don't need the renderer: finding, reading
+		// and decompressing the file. Safe to call from a job; Load then
+		// creates the model on the main thread.
+		struct PreparedModel {
+			std::string name;
+			std::string path;
+			RefCountedPtr<FileSystem::FileData> file;
+			std::string nodeData;
+			ByteRange geometry; // points into file
+		};
+		// returns nullptr if the file couldn't be read, throws LoadingError if there's no such model
+		static std::unique_ptr<PreparedModel> Prepare(const std::string &shortname, const std::string &basepath = "models");
+		// Serializes a model loaded from its .model file with any renderer
+		// (such as a dummy one on a job) and prepares the result to Load,
+		// without a round trip through a file. Returns nullptr on failure.
+		std::unique_ptr<PreparedModel> Prepare(Model *m);
+		Model *Load(const PreparedModel &);
+
 		//if you implement any new node types, you must also register a loader function
 		//before calling Load.
 		void RegisterLoader(const std::string &typeName, std::function<Node *(NodeDatabase &)>);
 
 	private:
-		Model *CreateModel(const std::string &filename, Serializer::Reader &);
+		static bool Decompress(RefCountedPtr<FileSystem::FileData>, PreparedModel &out);
+		Model *CreateModel(const std::string &filename, Serializer::Reader &, ByteRange geometry = ByteRange());
 		void SaveMaterials(Serializer::Writer &, Model *m);
 		void LoadMaterials(Serializer::Reader &);
 		void SaveAnimations(Serializer::Writer &, Model *m);
 		void LoadAnimations(Serializer::Reader &);
 		ModelDefinition FindModelDefinition(const std::string &);
 
-		Node *LoadNode(Serializer::Reader &);
+		Node *LoadNode(Serializer::Reader &, ByteRange geometry);
 		//this is a very simple loader so it's implemented here
 		static Label3D *LoadLabel3D(NodeDatabase &);
 
@@ -11,7 +11,8 @@
 namespace SceneGraph {
 
 	Group::Group(Graphics::Renderer *r) :
-		Node(r, NODE_SOLID | NODE_TRANSPARENT)
+		Node(r, NODE_SOLID | NODE_TRANSPARENT),
+		m_shared(false)
 	{
 	}
 
@@ -23,7 +24,8 @@ namespace SceneGraph {
 	}
 
 	Group::Group(const Group &group, NodeCopyCache *cache) :
-		Node(group, cache)
+		Node(group, cache),
+		m_shared(false)
 	{
 		for (std::vector<Node *>::const_iterator itr = group.m_children.begin();
 			 itr != group.m_children.end();
@@ -35,6 +37,8 @@ namespace SceneGraph {
 
 	Node *Group::Clone(NodeCopyCache *cache)
 	{
+		if (m_shared)
+			return this;
 		return cache->Copy<Group>(this);
 	}
 
@@ -107,6 +111,11 @@ namespace SceneGraph {
 		return GetParent() ? GetParent()->CalcGlobalTransform() : matrix4x4fIdentity;
 	}
 
+	Uint32 Group::CalcTransformRevision() const
+	{
+		return GetParent() ? GetParent()->CalcTransformRevision() : 0;
+	}
+
 	void Group::Accept(NodeVisitor &nv)
 	{
 		nv.ApplyGroup(*this);
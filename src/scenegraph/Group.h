@@ -33,12 +33,23 @@ namespace SceneGraph {
 		// Walk the node hierarchy to the root of the model and compute the global transform of this node.
 		// The result of this *should* be cached if the model has not changed
 		virtual matrix4x4f CalcGlobalTransform() const;
+		// Sum of the transform revisions of all MatrixTransforms between this node
+		// and the root. Revisions only increase, so a changed sum means some
+		// transform in the chain was modified since the sum was last taken.
+		virtual Uint32 CalcTransformRevision() const;
+
+		// A shared group is returned as-is by Clone, so model instances reference
+		// the subtree instead of copying it. Only set on subtrees holding nothing
+		// that can differ between instances; see Model::MakeInstance.
+		void SetShared(bool shared) { m_shared = shared; }
+		bool IsShared() const { return m_shared; }
 
 	protected:
 		virtual ~Group();
 		virtual void RenderChildren(const matrix4x4f &trans, const RenderData *rd);
 		virtual void RenderChildren(const std::vector<matrix4x4f> &trans, const RenderData *rd);
 		std::vector<Node *> m_children;
+		bool m_shared;
 	};
 
 } // namespace SceneGraph
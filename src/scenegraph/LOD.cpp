@@ -26,6 +26,8 @@ namespace SceneGraph {
 
 	Node *LOD::Clone(NodeCopyCache *cache)
 	{
+		if (IsShared())
+			return this;
 		return cache->Copy<LOD>(this);
 	}
 
@@ -0,0 +1,246 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "LODGenerator.h"
+#include "Animation.h"
+#include "LOD.h"
+#include "MatrixTransform.h"
+#include "MeshSimplifier.h"
+#include "Model.h"
+#include "NodeCopyCache.h"
+#include "StaticGeometry.h"
+#include "StringF.h"
+#include "Tag.h"
+#include "core/Log.h"
+#include "graphics/Renderer.h"
+#include "graphics/VertexBuffer.h"
+#include "profiler/Profiler.h"
+
+#include <cstring>
+
+namespace SceneGraph {
+
+	const LODGenerator::Level LODGenerator::LEVELS[] = {
+		{ 40, 0.15f },
+		{ 150, 0.4f },
+	};
+	const unsigned int LODGenerator::NUM_LEVELS = COUNTOF(LEVELS);
+
+	// the triangles of all the geometry below a node
+	static Uint32 count_triangles(Node *node)
+	{
+		if (StaticGeometry *sg = dynamic_cast<StaticGeometry *>(node)) {
+			Uint32 count = 0;
+			for (Uint32 i = 0; i < sg->GetNumMeshes(); i++)
+				count += sg->GetMeshAt(i).indexBuffer->GetSize() / 3;
+			return count;
+		}
+		Uint32 count = 0;
+		if (Group *group = dynamic_cast<Group *>(node))
+			for (Uint32 i = 0; i < group->GetNumChildren(); i++)
+				count += count_triangles(group->GetChildAt(i));
+		return count;
+	}
+
+	static void copy_node_properties(const Node *from, Node *to, unsigned int level)
+	{
+		if (!from->GetName().empty())
+			to->SetName(stringf("%0_lod%1{u}", from->GetName(), level));
+		to->SetNodeMask(from->GetNodeMask());
+		to->SetNodeFlags(from->GetNodeFlags());
+	}
+
+	LODGenerator::LODGenerator(Graphics::Renderer *r) :
+		m_renderer(r)
+	{
+	}
+
+	unsigned int LODGenerator::Generate(Model *model)
+	{
+		PROFILE_SCOPED()
+		RefCountedPtr<Group> root = model->GetRoot();
+
+		// thrusters, nav lights and collision geometry stay where they are
+		std::vector<RefCountedPtr<Node>> detail;
+		Uint32 fullTriangles = 0;
+		for (Uint32 i = 0; i < root->GetNumChildren(); i++) {
+			Node *child = root->GetChildAt(i);
+			if (dynamic_cast<LOD *>(child))
+				return 0;
+			const Uint32 numTriangles = count_triangles(child);
+			if (numTriangles > 0) {
+				detail.emplace_back(child);
+				fullTriangles += numTriangles;
+			}
+		}
+		if (detail.empty())
+			return 0;
+
+		// from the most detailed level down, each simplifying the full detail
+		// geometry but compared with the one above
+		const float radius = model->GetDrawClipRadius();
+		Uint32 prevTriangles = fullTriangles;
+		std::vector<std::pair<unsigned int, RefCountedPtr<Node>>> levels;
+		std::multimap<MatrixTransform *, MatrixTransform *> copies;
+		for (unsigned int i = NUM_LEVELS; i > 0; i--) {
+			const Level &level = LEVELS[i - 1];
+			const float maxError = radius / float(level.pixelSize);
+			Uint32 numTriangles = 0;
+			m_copies.clear();
+
+			RefCountedPtr<Node> node;
+			if (detail.size() == 1)
+				node.Reset(CopyLevel(detail.front().Get(), i - 1, level.triangleRatio, maxError, numTriangles));
+			else {
+				Group *group = new Group(m_renderer);
+				node.Reset(group);
+				for (auto &child : detail)
+					if (Node *copy = CopyLevel(child.Get(), i - 1, level.triangleRatio, maxError, numTriangles))
+						group->AddChild(copy);
+			}
+			if (numTriangles == 0 || numTriangles > prevTriangles * MIN_REDUCTION)
+				continue;
+
+			Log::Verbose("{}: generated detail level for {} pixels, {} -> {} triangles\n",
+				model->GetName(), level.pixelSize, prevTriangles, numTriangles);
+			levels.emplace_back(level.pixelSize, node);
+			copies.insert(m_copies.begin(), m_copies.end());
+			prevTriangles = numTriangles;
+		}
+		m_copies.clear();
+		if (levels.empty())
+			return 0;
+
+		LOD *lod = new LOD(m_renderer);
+		for (auto it = levels.rbegin(); it != levels.rend(); ++it)
+			lod->AddLevel(it->first, it->second.Get());
+
+		for (auto &node : detail)
+			root->RemoveChild(node.Get());
+		if (detail.size() == 1)
+			lod->AddLevel(FULL_DETAIL_PIXELS, detail.front().Get());
+		else {
+			Group *group = new Group(m_renderer);
+			for (auto &node : detail)
+				group->AddChild(node.Get());
+			lod->AddLevel(FULL_DETAIL_PIXELS, group);
+		}
+		root->AddChild(lod);
+
+		// copied transforms move with the originals
+		for (Animation *anim : model->GetAnimations()) {
+			const size_t numChannels = anim->m_channels.size();
+			for (size_t c = 0; c < numChannels; c++) {
+				auto range = copies.equal_range(anim->m_channels[c].node);
+				for (auto it = range.first; it != range.second; ++it) {
+					AnimationChannel channel = anim->m_channels[c];
+					channel.node = it->second;
+					anim->m_channels.push_back(channel);
+				}
+			}
+		}
+
+		return Uint32(levels.size());
+	}
+
+	Node *LODGenerator::CopyLevel(Node *node, unsigned int level, float ratio, float maxError, Uint32 &numTriangles)
+	{
+		if (StaticGeometry *sg = dynamic_cast<StaticGeometry *>(node)) {
+			Node *copy = SimplifyGeometry(sg, ratio, maxError, numTriangles);
+			if (copy)
+				copy_node_properties(sg, copy, level);
+			return copy;
+		}
+
+		// tags mark the places of things on the ship, once is enough
+		if (dynamic_cast<Tag *>(node))
+			return nullptr;
+
+		Group *group = nullptr;
+		if (MatrixTransform *mt = dynamic_cast<MatrixTransform *>(node)) {
+			MatrixTransform *copy = new MatrixTransform(m_renderer, mt->GetTransform());
+			m_copies.emplace(mt, copy);
+			group = copy;
+		} else if (Group *g = dynamic_cast<Group *>(node)) {
+			if (dynamic_cast<LOD *>(g))
+				return nullptr;
+			group = new Group(m_renderer);
+		} else {
+			NodeCopyCache cache;
+			return node->Clone(&cache);
+		}
+
+		copy_node_properties(node, group, level);
+		Group *orig = static_cast<Group *>(node);
+		for (Uint32 i = 0; i < orig->GetNumChildren(); i++)
+			if (Node *child = CopyLevel(orig->GetChildAt(i), level, ratio, maxError, numTriangles))
+				group->AddChild(child);
+		return group;
+	}
+
+	StaticGeometry *LODGenerator::SimplifyGeometry(StaticGeometry *sg, float ratio, float maxError, Uint32 &numTriangles)
+	{
+		PROFILE_SCOPED()
+		StaticGeometry *copy = new StaticGeometry(m_renderer);
+		copy->m_boundingBox = sg->m_boundingBox;
+
+		std::vector<vector3f> positions;
+		std::vector<Uint32> indices;
+		for (Uint32 m = 0; m < sg->GetNumMeshes(); m++) {
+			StaticGeometry::Mesh &mesh = sg->GetMeshAt(m);
+			const Graphics::VertexBufferDesc &desc = mesh.vertexBuffer->GetDesc();
+			const Uint32 posOffset = desc.GetOffset(Graphics::ATTRIB_POSITION);
+			const Uint32 stride = desc.stride;
+
+			const Uint8 *vtxPtr = mesh.vertexBuffer->Map<Uint8>(Graphics::BUFFER_MAP_READ);
+			positions.resize(desc.numVertices);
+			for (Uint32 i = 0; i < desc.numVertices; i++)
+				positions[i] = *reinterpret_cast<const vector3f *>(vtxPtr + i * stride + posOffset);
+
+			const Uint32 *idxPtr = mesh.indexBuffer->Map(Graphics::BUFFER_MAP_READ);
+			indices.assign(idxPtr, idxPtr + mesh.indexBuffer->GetSize());
+			mesh.indexBuffer->Unmap();
+
+			const size_t target = size_t(float(indices.size() / 3) * ratio) * 3;
+			const std::vector<Uint32> simplified = SimplifyMesh(positions, indices, target, maxError);
+			if (simplified.empty()) {
+				mesh.vertexBuffer->Unmap();
+				continue;
+			}
+
+			// only the vertices still in use are kept
+			std::vector<Uint32> remap(desc.numVertices, ~0U);
+			Uint32 numUsed = 0;
+			for (Uint32 v : simplified)
+				if (remap[v] == ~0U)
+					remap[v] = numUsed++;
+
+			Graphics::VertexBufferDesc newDesc = desc;
+			newDesc.numVertices = numUsed;
+			newDesc.usage = Graphics::BUFFER_USAGE_STATIC;
+			RefCountedPtr<Graphics::VertexBuffer> vtxBuffer(m_renderer->CreateVertexBuffer(newDesc));
+			Uint8 *newVtxPtr = vtxBuffer->Map<Uint8>(Graphics::BUFFER_MAP_WRITE);
+			for (Uint32 v = 0; v < desc.numVertices; v++)
+				if (remap[v] != ~0U)
+					memcpy(newVtxPtr + remap[v] * stride, vtxPtr + v * stride, stride);
+			vtxBuffer->Unmap();
+			mesh.vertexBuffer->Unmap();
+
+			RefCountedPtr<Graphics::IndexBuffer> idxBuffer(m_renderer->CreateIndexBuffer(Uint32(simplified.size()), Graphics::BUFFER_USAGE_STATIC));
+			Uint32 *newIdxPtr = idxBuffer->Map(Graphics::BUFFER_MAP_WRITE);
+			for (size_t i = 0; i < simplified.size(); i++)
+				newIdxPtr[i] = remap[simplified[i]];
+			idxBuffer->Unmap();
+
+			copy->AddMesh(vtxBuffer, idxBuffer, mesh.material);
+			numTriangles += Uint32(simplified.size() / 3);
+		}
+
+		if (copy->GetNumMeshes() == 0) {
+			RefCountedPtr<Node> release(copy);
+			return nullptr;
+		}
+		return copy;
+	}
+
+} // namespace SceneGraph
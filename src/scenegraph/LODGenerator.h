@@ -0,0 +1,65 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _SCENEGRAPH_LODGENERATOR_H
+#define _SCENEGRAPH_LODGENERATOR_H
+/*
+ * Builds simplified detail levels for models authored with only one
+ */
+#include <SDL_stdinc.h>
+#include <map>
+#include <string>
+
+namespace Graphics {
+	class Renderer;
+} // namespace Graphics
+
+namespace SceneGraph {
+
+	class Model;
+	class Node;
+	class MatrixTransform;
+	class StaticGeometry;
+
+	// Puts the geometry of a model without an LOD node under a new one, next
+	// to simplified copies of it for the given pixel sizes. Each copy allows
+	// about a pixel of error at the size it's shown up to, and keeps at most
+	// a fraction of the triangles of the level above; levels that wouldn't
+	// save much are left out.
+	//
+	// The copies are renamed with a "_lodN" suffix so the names stay unique
+	// for node lookups, and animations get channels for the copied transforms.
+	// Tags are only kept in the full detail level.
+	class LODGenerator {
+	public:
+		struct Level {
+			unsigned int pixelSize;
+			float triangleRatio;
+		};
+
+		// the levels generated, least detailed first
+		static const Level LEVELS[];
+		static const unsigned int NUM_LEVELS;
+		// the pixel size given to the full detail level
+		static const unsigned int FULL_DETAIL_PIXELS = 1000;
+		// a level must have at most this much of the level above's triangles
+		static constexpr float MIN_REDUCTION = 0.8f;
+
+		LODGenerator(Graphics::Renderer *r);
+
+		// Returns the number of levels added, 0 if the model already has an
+		// LOD node or nothing could be simplified
+		unsigned int Generate(Model *model);
+
+	private:
+		Node *CopyLevel(Node *node, unsigned int level, float ratio, float maxError, Uint32 &numTriangles);
+		StaticGeometry *SimplifyGeometry(StaticGeometry *sg, float ratio, float maxError, Uint32 &numTriangles);
+
+		Graphics::Renderer *m_renderer;
+		// the copies of each transform, for the animation channels
+		std::multimap<MatrixTransform *, MatrixTransform *> m_copies;
+	};
+
+} // namespace SceneGraph
+
+#endif
@@ -27,7 +27,6 @@ namespace SceneGraph {
 		rsd.depthWrite = false;
 		rsd.blendMode = Graphics::BLEND_ALPHA;
 
-		m_geometry.reset(font->CreateVertexArray());
 		m_material.Reset(r->CreateMaterial("label", matdesc, rsd));
 		m_material->SetTexture("texture0"_hash, font->GetTexture());
 		m_material->diffuse = Color::WHITE;
@@ -38,9 +37,10 @@ namespace SceneGraph {
 	Label3D::Label3D(const Label3D &label, NodeCopyCache *cache) :
 		Node(label, cache),
 		m_material(label.m_material),
-		m_font(label.m_font)
+		m_textMesh(label.m_textMesh),
+		m_font(label.m_font),
+		m_text(label.m_text)
 	{
-		m_geometry.reset(m_font->CreateVertexArray());
 	}
 
 	Node *Label3D::Clone(NodeCopyCache *cache)
@@ -50,30 +50,34 @@ namespace SceneGraph {
 
 	void Label3D::SetText(const std::string &text)
 	{
+		// SetLabel is called on every model instance, usually with the text it already has
+		if (text == m_text && m_textMesh.Valid())
+			return;
+		m_text = text;
+
 		//regenerate geometry
-		m_geometry->Clear();
 		if (!text.empty()) {
-			m_font->GetGeometry(*m_geometry, text, vector2f(0.f));
+			const Graphics::VertexArray &geometry = m_font->GetGlyphRun(text);
 
 			// Happens if none of the characters in the string have glyphs in the SDF font.
 			// Most noticeably, this means text consisting of entirely Cyrillic
 			// or Chinese characters will vanish when rendered on a Label3D.
-			if (m_geometry->IsEmpty()) {
+			if (geometry.IsEmpty()) {
 				return;
 			}
 
 			//create buffer and upload data
-			m_textMesh.reset(m_renderer->CreateMeshObjectFromArray(m_geometry.get()));
+			m_textMesh.Reset(m_renderer->CreateMeshObjectFromArray(&geometry));
 		}
 	}
 
 	void Label3D::Render(const matrix4x4f &trans, const RenderData *rd)
 	{
 		PROFILE_SCOPED()
-		if (m_textMesh.get()) {
+		if (m_textMesh.Valid()) {
 			Graphics::Renderer *r = GetRenderer();
 			r->SetTransform(trans);
-			r->DrawMesh(m_textMesh.get(), m_material.Get());
+			r->DrawMesh(m_textMesh.Get(), m_material.Get());
 		}
 	}
 
@@ -11,7 +11,7 @@
 #include "graphics/VertexBuffer.h"
 #include "text/DistanceFieldFont.h"
 
-#include <memory>
+#include <string>
 
 namespace Graphics {
 	class Renderer;
@@ -32,9 +32,10 @@ namespace SceneGraph {
 
 	private:
 		RefCountedPtr<Graphics::Material> m_material;
-		std::unique_ptr<Graphics::VertexArray> m_geometry;
-		std::unique_ptr<Graphics::MeshObject> m_textMesh;
+		// shared between clones until one of them is given different text
+		RefCountedPtr<Graphics::MeshObject> m_textMesh;
 		RefCountedPtr<Text::DistanceFieldFont> m_font;
+		std::string m_text;
 	};
 
 } // namespace SceneGraph
@@ -21,6 +21,8 @@
 #include "scenegraph/LoaderDefinitions.h"
 #include "utils.h"
 
+#include <map>
+
 #include <assimp/material.h>
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
@@ -384,7 +386,7 @@ namespace SceneGraph {
 		// special features that are absolute-positioned (thrusters)
 		RefCountedPtr<Node> meshRoot(new Group(m_renderer));
 
-		ConvertNodes(scene->mRootNode, static_cast<Group *>(meshRoot.Get()), geoms, matrix4x4f::Identity());
+		ConvertNodes(scene, scene->mRootNode, static_cast<Group *>(meshRoot.Get()), geoms, matrix4x4f::Identity());
 		ConvertAnimations(scene, animDefs, static_cast<Group *>(meshRoot.Get()));
 
 		return meshRoot;
@@ -466,135 +468,153 @@ namespace SceneGraph {
 	void Loader::ConvertAiMeshes(std::vector<RefCountedPtr<StaticGeometry>> &geoms, const aiScene *scene)
 	{
 		PROFILE_SCOPED()
+		//turn meshes into static geometry nodes
+		for (unsigned int i = 0; i < scene->mNumMeshes; i++) {
+			RefCountedPtr<StaticGeometry> geom = CreateStaticGeometry(scene, { { scene->mMeshes[i], matrix4x4f::Identity() } });
+			geom->SetName(stringf("sgMesh%0{u}", i));
+			geoms.push_back(geom);
+		}
+	}
+
+	RefCountedPtr<StaticGeometry> Loader::CreateStaticGeometry(const aiScene *scene, const std::vector<MeshPart> &parts)
+	{
+		PROFILE_SCOPED()
+		assert(!parts.empty());
+		RefCountedPtr<StaticGeometry> geom(new StaticGeometry(m_renderer));
+
 		//XXX sigh, workaround for obj loader
 		int matIdxOffs = 0;
 		if (scene->mNumMaterials > scene->mNumMeshes)
 			matIdxOffs = 1;
 
-		//turn meshes into static geometry nodes
-		for (unsigned int i = 0; i < scene->mNumMeshes; i++) {
-			const aiMesh *mesh = scene->mMeshes[i];
-			assert(mesh->HasNormals());
+		// all parts share a material and vertex format
+		const aiMesh *first = parts.front().mesh;
+		const bool hasTangents = first->HasTangentsAndBitangents();
 
-			RefCountedPtr<StaticGeometry> geom(new StaticGeometry(m_renderer));
-			geom->SetName(stringf("sgMesh%0{u}", i));
+		unsigned int numVertices = 0;
+		for (const MeshPart &part : parts) {
+			const aiMesh *mesh = part.mesh;
+			assert(mesh->HasNormals());
+			assert(mesh->mMaterialIndex == first->mMaterialIndex && mesh->HasTangentsAndBitangents() == hasTangents);
 
-			const bool hasUVs = mesh->HasTextureCoords(0);
-			const bool hasTangents = mesh->HasTangentsAndBitangents();
-			if (!hasUVs)
+			if (!mesh->HasTextureCoords(0))
 				AddLog(stringf("%0: missing UV coordinates", m_curMeshDef));
 			if (!hasTangents)
 				AddLog(stringf("%0: missing Tangents and Bitangents coordinates", m_curMeshDef));
 			//sadly, aimesh name is usually empty so no help for logging
 
-			//Material names are not consistent throughout formats.
-			//try matching name first, if that fails use index
-			RefCountedPtr<Graphics::Material> mat;
-			const aiMaterial *amat = scene->mMaterials[mesh->mMaterialIndex];
-			aiString aiMatName;
-			if (AI_SUCCESS == amat->Get(AI_MATKEY_NAME, aiMatName))
-				mat = m_model->GetMaterialByName(std::string(aiMatName.C_Str()));
-
-			if (!mat.Valid()) {
-				const unsigned int matIdx = mesh->mMaterialIndex - matIdxOffs;
-				AddLog(stringf("%0: no material %1, using material %2{u} instead", m_curMeshDef, aiMatName.C_Str(), matIdx + 1));
-				mat = m_model->GetMaterialByIndex(matIdx);
-			}
-			assert(mat.Valid());
-
-			//turn on alpha blending and mark entire node as transparent
-			//(all importers split by material so far)
-			if (mat->diffuse.a < 255)
-				geom->SetNodeMask(NODE_TRANSPARENT);
-
-			Graphics::VertexBufferDesc vbd;
-			vbd.attrib[0].semantic = Graphics::ATTRIB_POSITION;
-			vbd.attrib[0].format = Graphics::ATTRIB_FORMAT_FLOAT3;
-			vbd.attrib[0].offset = hasTangents ? offsetof(ModelTangentVtx, pos) : offsetof(ModelVtx, pos);
-			vbd.attrib[1].semantic = Graphics::ATTRIB_NORMAL;
-			vbd.attrib[1].format = Graphics::ATTRIB_FORMAT_FLOAT3;
-			vbd.attrib[1].offset = hasTangents ? offsetof(ModelTangentVtx, nrm) : offsetof(ModelVtx, nrm);
-			vbd.attrib[2].semantic = Graphics::ATTRIB_UV0;
-			vbd.attrib[2].format = Graphics::ATTRIB_FORMAT_FLOAT2;
-			vbd.attrib[2].offset = hasTangents ? offsetof(ModelTangentVtx, uv0) : offsetof(ModelVtx, uv0);
-			if (hasTangents) {
-				vbd.attrib[3].semantic = Graphics::ATTRIB_TANGENT;
-				vbd.attrib[3].format = Graphics::ATTRIB_FORMAT_FLOAT3;
-				vbd.attrib[3].offset = offsetof(ModelTangentVtx, tangent);
-			}
-			vbd.stride = hasTangents ? sizeof(ModelTangentVtx) : sizeof(ModelVtx);
-			vbd.numVertices = mesh->mNumVertices;
-			vbd.usage = Graphics::BUFFER_USAGE_STATIC;
+			numVertices += mesh->mNumVertices;
+		}
+
+		//Material names are not consistent throughout formats.
+		//try matching name first, if that fails use index
+		RefCountedPtr<Graphics::Material> mat;
+		const aiMaterial *amat = scene->mMaterials[first->mMaterialIndex];
+		aiString aiMatName;
+		if (AI_SUCCESS == amat->Get(AI_MATKEY_NAME, aiMatName))
+			mat = m_model->GetMaterialByName(std::string(aiMatName.C_Str()));
+
+		if (!mat.Valid()) {
+			const unsigned int matIdx = first->mMaterialIndex - matIdxOffs;
+			AddLog(stringf("%0: no material %1, using material %2{u} instead", m_curMeshDef, aiMatName.C_Str(), matIdx + 1));
+			mat = m_model->GetMaterialByIndex(matIdx);
+		}
+		assert(mat.Valid());
+
+		//turn on alpha blending and mark entire node as transparent
+		//(all importers split by material so far)
+		if (mat->diffuse.a < 255)
+			geom->SetNodeMask(NODE_TRANSPARENT);
+
+		Graphics::VertexBufferDesc vbd;
+		vbd.attrib[0].semantic = Graphics::ATTRIB_POSITION;
+		vbd.attrib[0].format = Graphics::ATTRIB_FORMAT_FLOAT3;
+		vbd.attrib[0].offset = hasTangents ? offsetof(ModelTangentVtx, pos) : offsetof(ModelVtx, pos);
+		vbd.attrib[1].semantic = Graphics::ATTRIB_NORMAL;
+		vbd.attrib[1].format = Graphics::ATTRIB_FORMAT_FLOAT3;
+		vbd.attrib[1].offset = hasTangents ? offsetof(ModelTangentVtx, nrm) : offsetof(ModelVtx, nrm);
+		vbd.attrib[2].semantic = Graphics::ATTRIB_UV0;
+		vbd.attrib[2].format = Graphics::ATTRIB_FORMAT_FLOAT2;
+		vbd.attrib[2].offset = hasTangents ? offsetof(ModelTangentVtx, uv0) : offsetof(ModelVtx, uv0);
+		if (hasTangents) {
+			vbd.attrib[3].semantic = Graphics::ATTRIB_TANGENT;
+			vbd.attrib[3].format = Graphics::ATTRIB_FORMAT_FLOAT3;
+			vbd.attrib[3].offset = offsetof(ModelTangentVtx, tangent);
+		}
+		vbd.stride = hasTangents ? sizeof(ModelTangentVtx) : sizeof(ModelVtx);
+		vbd.numVertices = numVertices;
+		vbd.usage = Graphics::BUFFER_USAGE_STATIC;
 
-			RefCountedPtr<Graphics::VertexBuffer> vb(m_renderer->CreateVertexBuffer(vbd));
+		RefCountedPtr<Graphics::VertexBuffer> vb(m_renderer->CreateVertexBuffer(vbd));
 
-			// huge meshes are split by the importer so this should not exceed 65K indices
-			std::vector<Uint32> indices;
+		// huge meshes are split by the importer so this should not exceed 65K indices
+		std::vector<Uint32> indices;
+		Uint32 baseVertex = 0;
+		for (const MeshPart &part : parts) {
+			const aiMesh *mesh = part.mesh;
 			if (mesh->mNumFaces > 0) {
-				indices.reserve(mesh->mNumFaces * 3);
+				indices.reserve(indices.size() + mesh->mNumFaces * 3);
 				for (unsigned int f = 0; f < mesh->mNumFaces; f++) {
 					const aiFace *face = &mesh->mFaces[f];
 					for (unsigned int j = 0; j < face->mNumIndices; j++) {
-						indices.push_back(face->mIndices[j]);
+						indices.push_back(baseVertex + face->mIndices[j]);
 					}
 				}
 			} else {
 				//generate dummy indices
-				AddLog(stringf("Missing indices in mesh %0{u}", i));
-				indices.reserve(mesh->mNumVertices);
+				AddLog(stringf("Missing indices in mesh %0", m_curMeshDef));
+				indices.reserve(indices.size() + mesh->mNumVertices);
 				for (unsigned int v = 0; v < mesh->mNumVertices; v++)
-					indices.push_back(v);
+					indices.push_back(baseVertex + v);
 			}
+			baseVertex += mesh->mNumVertices;
+		}
 
-			assert(indices.size() > 0);
-
-			//create buffer & copy
-			RefCountedPtr<Graphics::IndexBuffer> ib(m_renderer->CreateIndexBuffer(indices.size(), Graphics::BUFFER_USAGE_STATIC));
-			Uint32 *idxPtr = ib->Map(Graphics::BUFFER_MAP_WRITE);
-			for (Uint32 j = 0; j < indices.size(); j++)
-				idxPtr[j] = indices[j];
-			ib->Unmap();
-
-			//copy vertices, always assume normals
-			//replace nonexistent UVs with zeros
-			if (!hasTangents) {
-				ModelVtx *vtxPtr = vb->Map<ModelVtx>(Graphics::BUFFER_MAP_WRITE);
-				for (unsigned int v = 0; v < mesh->mNumVertices; v++) {
-					const aiVector3D &vtx = mesh->mVertices[v];
-					const aiVector3D &norm = mesh->mNormals[v];
-					const aiVector3D &uv0 = hasUVs ? mesh->mTextureCoords[0][v] : aiVector3D(0.f);
-					vtxPtr[v].pos = vector3f(vtx.x, vtx.y, vtx.z);
-					vtxPtr[v].nrm = vector3f(norm.x, norm.y, norm.z);
-					vtxPtr[v].uv0 = vector2f(uv0.x, uv0.y);
-
-					//update bounding box
-					//untransformed points, collision visitor will transform
-					geom->m_boundingBox.Update(vtx.x, vtx.y, vtx.z);
-				}
-				vb->Unmap();
-			} else {
-				ModelTangentVtx *vtxPtr = vb->Map<ModelTangentVtx>(Graphics::BUFFER_MAP_WRITE);
-				for (unsigned int v = 0; v < mesh->mNumVertices; v++) {
-					const aiVector3D &vtx = mesh->mVertices[v];
-					const aiVector3D &norm = mesh->mNormals[v];
-					const aiVector3D &uv0 = hasUVs ? mesh->mTextureCoords[0][v] : aiVector3D(0.f);
+		assert(indices.size() > 0);
+
+		//create buffer & copy
+		RefCountedPtr<Graphics::IndexBuffer> ib(m_renderer->CreateIndexBuffer(indices.size(), Graphics::BUFFER_USAGE_STATIC));
+		Uint32 *idxPtr = ib->Map(Graphics::BUFFER_MAP_WRITE);
+		for (Uint32 j = 0; j < indices.size(); j++)
+			idxPtr[j] = indices[j];
+		ib->Unmap();
+
+		//copy vertices, always assume normals
+		//replace nonexistent UVs with zeros
+		Uint8 *vtxPtr = vb->Map<Uint8>(Graphics::BUFFER_MAP_WRITE);
+		for (const MeshPart &part : parts) {
+			const aiMesh *mesh = part.mesh;
+			const bool hasUVs = mesh->HasTextureCoords(0);
+			// normals go through the inverse transpose so non-uniform scale
+			// doesn't skew them; the part's transform is usually identity
+			const matrix4x4f &trans = part.transform;
+			const matrix3x3f normalTrans = trans.GetOrient().Inverse().Transpose();
+
+			for (unsigned int v = 0; v < mesh->mNumVertices; v++) {
+				const aiVector3D &vtx = mesh->mVertices[v];
+				const aiVector3D &norm = mesh->mNormals[v];
+				const aiVector3D &uv0 = hasUVs ? mesh->mTextureCoords[0][v] : aiVector3D(0.f);
+				const vector3f pos = trans * vector3f(vtx.x, vtx.y, vtx.z);
+
+				ModelVtx *vtxOut = reinterpret_cast<ModelVtx *>(vtxPtr);
+				vtxOut->pos = pos;
+				vtxOut->nrm = (normalTrans * vector3f(norm.x, norm.y, norm.z)).NormalizedSafe();
+				vtxOut->uv0 = vector2f(uv0.x, uv0.y);
+				if (hasTangents) {
 					const aiVector3D &tangents = mesh->mTangents[v];
-					vtxPtr[v].pos = vector3f(vtx.x, vtx.y, vtx.z);
-					vtxPtr[v].nrm = vector3f(norm.x, norm.y, norm.z);
-					vtxPtr[v].uv0 = vector2f(uv0.x, uv0.y);
-					vtxPtr[v].tangent = vector3f(tangents.x, tangents.y, tangents.z);
-
-					//update bounding box
-					//untransformed points, collision visitor will transform
-					geom->m_boundingBox.Update(vtx.x, vtx.y, vtx.z);
+					reinterpret_cast<ModelTangentVtx *>(vtxPtr)->tangent = trans.ApplyRotationOnly(vector3f(tangents.x, tangents.y, tangents.z)).NormalizedSafe();
 				}
-				vb->Unmap();
-			}
-
-			geom->AddMesh(vb, ib, mat);
+				vtxPtr += vbd.stride;
 
-			geoms.push_back(geom);
+				//update bounding box
+				//in the space of the node the geometry is attached to, collision visitor will transform
+				geom->m_boundingBox.Update(pos.x, pos.y, pos.z);
+			}
 		}
+		vb->Unmap();
+
+		geom->AddMesh(vb, ib, mat);
+		return geom;
 	}
 
 	void Loader::ConvertAnimations(const aiScene *scene, const std::vector<AnimDefinition> &animDefs, Node *meshRoot)
@@ -859,7 +879,7 @@ namespace SceneGraph {
 		return cgeom;
 	}
 
-	void Loader::ConvertNodes(aiNode *node, Group *_parent, std::vector<RefCountedPtr<StaticGeometry>> &geoms, const matrix4x4f &accum)
+	void Loader::ConvertNodes(const aiScene *scene, aiNode *node, Group *_parent, std::vector<RefCountedPtr<StaticGeometry>> &geoms, const matrix4x4f &accum)
 	{
 		PROFILE_SCOPED()
 		Group *parent = _parent;
@@ -940,10 +960,76 @@ namespace SceneGraph {
 			}
 		}
 
+		for (aiNode *child : MergeStaticChildren(scene, node, parent))
+			ConvertNodes(scene, child, parent, geoms, accum * m);
+	}
+
+	bool Loader::IsStaticMeshNode(const aiScene *scene, const aiNode *node) const
+	{
+		if (node->mNumChildren > 0 || node->mNumMeshes == 0)
+			return false;
+
+		const std::string nodename(node->mName.C_Str());
+		if (starts_with(nodename, "collision_") || starts_with(nodename, "decal_") || starts_with(nodename, "label_"))
+			return false;
+
+		for (unsigned int i = 0; i < scene->mNumAnimations; i++) {
+			const aiAnimation *anim = scene->mAnimations[i];
+			for (unsigned int j = 0; j < anim->mNumChannels; j++)
+				if (anim->mChannels[j]->mNodeName == node->mName)
+					return false;
+		}
+
+		return true;
+	}
+
+	// Big models such as stations and city buildings are mostly leaf nodes
+	// holding a mesh or two with a fixed transform, and drawing each of them
+	// separately costs a draw call and a transform change per node. Bake the
+	// transforms of a node's static children into their vertices instead and
+	// merge the meshes that share a material, so they draw with one call.
+	std::vector<aiNode *> Loader::MergeStaticChildren(const aiScene *scene, aiNode *node, Group *parent)
+	{
+		PROFILE_SCOPED()
+		std::vector<aiNode *> others;
+		std::vector<aiNode *> statics;
 		for (unsigned int i = 0; i < node->mNumChildren; i++) {
 			aiNode *child = node->mChildren[i];
-			ConvertNodes(child, parent, geoms, accum * m);
+			if (IsStaticMeshNode(scene, child))
+				statics.push_back(child);
+			else
+				others.push_back(child);
+		}
+
+		// nothing to gain from a single node; keep its geometry shared
+		if (statics.size() < 2) {
+			std::vector<aiNode *> children(node->mChildren, node->mChildren + node->mNumChildren);
+			return children;
+		}
+
+		// batches by material and vertex format, in the order first seen
+		std::map<std::pair<unsigned int, bool>, size_t> batchIndex;
+		std::vector<std::vector<MeshPart>> batches;
+		for (const aiNode *child : statics) {
+			const matrix4x4f trans = ConvertMatrix(child->mTransformation);
+			for (unsigned int i = 0; i < child->mNumMeshes; i++) {
+				const aiMesh *mesh = scene->mMeshes[child->mMeshes[i]];
+				const auto key = std::make_pair(mesh->mMaterialIndex, mesh->HasTangentsAndBitangents());
+				auto it = batchIndex.emplace(key, batches.size()).first;
+				if (it->second == batches.size())
+					batches.emplace_back();
+				batches[it->second].push_back({ mesh, trans });
+			}
 		}
+
+		for (size_t i = 0; i < batches.size(); i++) {
+			RefCountedPtr<StaticGeometry> geom = CreateStaticGeometry(scene, batches[i]);
+			geom->SetName(stringf("%0_static%1{u}", parent->GetName(), unsigned(i)));
+			parent->AddChild(geom.Get());
+		}
+
+		AddLog(stringf("%0: merged %1{u} static nodes into %2{u} geometries", m_curMeshDef, unsigned(statics.size()), unsigned(batches.size())));
+		return others;
 	}
 
 	void Loader::LoadCollision(const std::string &filename)
@@ -65,9 +65,21 @@ namespace SceneGraph {
 		RefCountedPtr<Node> LoadMesh(const std::string &filename, const std::vector<AnimDefinition> &animDefs); //load one mesh file so it can be added to the model scenegraph. Materials should be created before this!
 		void AddLog(const std::string &);
 		void CheckAnimationConflicts(const Animation *, const std::vector<Animation *> &); //detect animation overlap
+		// a mesh and the transform baked into its vertices
+		struct MeshPart {
+			const aiMesh *mesh;
+			matrix4x4f transform;
+		};
+
 		void ConvertAiMeshes(std::vector<RefCountedPtr<StaticGeometry>> &, const aiScene *); //model is only for material lookup
 		void ConvertAnimations(const aiScene *, const std::vector<AnimDefinition> &, Node *meshRoot);
-		void ConvertNodes(aiNode *node, Group *parent, std::vector<RefCountedPtr<StaticGeometry>> &meshes, const matrix4x4f &);
+		void ConvertNodes(const aiScene *, aiNode *node, Group *parent, std::vector<RefCountedPtr<StaticGeometry>> &meshes, const matrix4x4f &);
+		// one geometry drawing all the parts, which must share a material and vertex format
+		RefCountedPtr<StaticGeometry> CreateStaticGeometry(const aiScene *, const std::vector<MeshPart> &parts);
+		// a mesh-only leaf that isn't animated or special
+		bool IsStaticMeshNode(const aiScene *, const aiNode *node) const;
+		// adds merged geometry for the node's static children to parent, returning the other children
+		std::vector<aiNode *> MergeStaticChildren(const aiScene *, aiNode *node, Group *parent);
 		void CreateLabel(const std::string &name, Group *parent, const matrix4x4f &);
 		void CreateThruster(const std::string &name, const matrix4x4f &nodeTrans);
 		void CreateNavlight(const std::string &name, const matrix4x4f &nodeTrans);
@@ -13,18 +13,22 @@ namespace SceneGraph {
 
 	MatrixTransform::MatrixTransform(Graphics::Renderer *r, const matrix4x4f &m) :
 		Group(r),
-		m_transform(m)
+		m_transform(m),
+		m_revision(0)
 	{
 	}
 
 	MatrixTransform::MatrixTransform(const MatrixTransform &mt, NodeCopyCache *cache) :
 		Group(mt, cache),
-		m_transform(mt.m_transform)
+		m_transform(mt.m_transform),
+		m_revision(mt.m_revision)
 	{
 	}
 
 	Node *MatrixTransform::Clone(NodeCopyCache *cache)
 	{
+		if (IsShared())
+			return this;
 		return cache->Copy<MatrixTransform>(this);
 	}
 
@@ -33,11 +37,24 @@ namespace SceneGraph {
 		nv.ApplyMatrixTransform(*this);
 	}
 
+	void MatrixTransform::SetTransform(const matrix4x4f &m)
+	{
+		if (0 == memcmp(&m_transform, &m, sizeof(matrix4x4f)))
+			return;
+		m_transform = m;
+		++m_revision;
+	}
+
 	matrix4x4f MatrixTransform::CalcGlobalTransform() const
 	{
 		return GetParent() ? GetParent()->CalcGlobalTransform() * m_transform : m_transform;
 	}
 
+	Uint32 MatrixTransform::CalcTransformRevision() const
+	{
+		return GetParent() ? GetParent()->CalcTransformRevision() + m_revision : m_revision;
+	}
+
 	void MatrixTransform::Render(const matrix4x4f &trans, const RenderData *rd)
 	{
 		const matrix4x4f t = trans * m_transform;
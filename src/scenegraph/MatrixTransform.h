@@ -37,15 +37,18 @@ namespace SceneGraph {
 		virtual void Render(const std::vector<matrix4x4f> &trans, const RenderData *rd) override;
 
 		const matrix4x4f &GetTransform() const { return m_transform; }
-		void SetTransform(const matrix4x4f &m) { m_transform = m; }
+		void SetTransform(const matrix4x4f &m);
 
 		virtual matrix4x4f CalcGlobalTransform() const override;
+		virtual Uint32 CalcTransformRevision() const override;
 
 	protected:
 		virtual ~MatrixTransform() {}
 
 	private:
 		matrix4x4f m_transform;
+		// bumped whenever SetTransform actually changes m_transform
+		Uint32 m_revision;
 	};
 } // namespace SceneGraph
 #endif
@@ -0,0 +1,274 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "MeshOptimizer.h"
+#include "StaticGeometry.h"
+#include "graphics/VertexBuffer.h"
+#include "profiler/Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace SceneGraph {
+
+	// Forsyth's scoring: the three most recent vertices score the same, so
+	// consecutive triangles don't favour one edge, and vertices with few
+	// triangles left are finished off before they drop out of the cache
+	static float vertex_score(int cachePos, Uint32 remaining)
+	{
+		if (remaining == 0)
+			return -1.0f;
+		float score = 0.0f;
+		if (cachePos >= 0) {
+			if (cachePos < 3)
+				score = 0.75f;
+			else
+				score = std::pow(1.0f - float(cachePos - 3) / float(VERTEX_CACHE_SIZE - 3), 1.5f);
+		}
+		return score + 2.0f / std::sqrt(float(remaining));
+	}
+
+	void OptimizeVertexCache(std::vector<Uint32> &indices, Uint32 numVertices)
+	{
+		PROFILE_SCOPED()
+		const Uint32 numTris = Uint32(indices.size() / 3);
+		if (numTris == 0)
+			return;
+
+		// the triangles of each vertex, in one array
+		std::vector<Uint32> remaining(numVertices, 0);
+		for (Uint32 i = 0; i < numTris * 3; i++)
+			remaining[indices[i]]++;
+		std::vector<Uint32> offsets(numVertices + 1, 0);
+		for (Uint32 v = 0; v < numVertices; v++)
+			offsets[v + 1] = offsets[v] + remaining[v];
+		std::vector<Uint32> vertexTris(numTris * 3);
+		{
+			std::vector<Uint32> fill(offsets.begin(), offsets.end() - 1);
+			for (Uint32 i = 0; i < numTris * 3; i++)
+				vertexTris[fill[indices[i]]++] = i / 3;
+		}
+
+		std::vector<int> cachePos(numVertices, -1);
+		std::vector<float> vertexScores(numVertices);
+		for (Uint32 v = 0; v < numVertices; v++)
+			vertexScores[v] = vertex_score(-1, remaining[v]);
+		std::vector<float> triScores(numTris);
+		for (Uint32 t = 0; t < numTris; t++)
+			triScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+		std::vector<bool> emitted(numTris, false);
+
+		std::vector<Uint32> out;
+		out.reserve(numTris * 3);
+		std::vector<Uint32> cache, newCache;
+		cache.reserve(VERTEX_CACHE_SIZE + 3);
+		newCache.reserve(VERTEX_CACHE_SIZE + 3);
+		Uint32 best = Uint32(std::max_element(triScores.begin(), triScores.end()) - triScores.begin());
+		Uint32 cursor = 0;
+
+		while (out.size() < numTris * 3) {
+			if (best == ~0U) {
+				// nothing left around the cache, start somewhere new
+				while (emitted[cursor])
+					cursor++;
+				best = cursor;
+			}
+
+			const Uint32 *tri = &indices[best * 3];
+			out.insert(out.end(), tri, tri + 3);
+			emitted[best] = true;
+			for (Uint32 i = 0; i < 3; i++) {
+				const Uint32 v = tri[i];
+				Uint32 *begin = &vertexTris[offsets[v]];
+				Uint32 *end = begin + remaining[v];
+				*std::find(begin, end, best) = *(end - 1);
+				remaining[v]--;
+			}
+
+			// the triangle's vertices go to the front of the cache
+			newCache.assign(tri, tri + 3);
+			for (Uint32 v : cache)
+				if (v != tri[0] && v != tri[1] && v != tri[2])
+					newCache.push_back(v);
+			for (Uint32 i = 0; i < newCache.size(); i++) {
+				const Uint32 v = newCache[i];
+				cachePos[v] = i < VERTEX_CACHE_SIZE ? int(i) : -1;
+				vertexScores[v] = vertex_score(cachePos[v], remaining[v]);
+			}
+
+			// rescore the triangles around the cache and pick the best of them
+			best = ~0U;
+			float bestScore = -1.0f;
+			for (Uint32 v : newCache) {
+				for (Uint32 j = 0; j < remaining[v]; j++) {
+					const Uint32 t = vertexTris[offsets[v] + j];
+					const Uint32 *ti = &indices[t * 3];
+					triScores[t] = vertexScores[ti[0]] + vertexScores[ti[1]] + vertexScores[ti[2]];
+					if (triScores[t] > bestScore) {
+						bestScore = triScores[t];
+						best = t;
+					}
+				}
+			}
+
+			if (newCache.size() > VERTEX_CACHE_SIZE)
+				newCache.resize(VERTEX_CACHE_SIZE);
+			std::swap(cache, newCache);
+		}
+
+		indices.swap(out);
+	}
+
+	float CalcCacheMissRatio(const std::vector<Uint32> &indices, Uint32 cacheSize)
+	{
+		const size_t numTris = indices.size() / 3;
+		if (numTris == 0)
+			return 0.0f;
+
+		std::vector<Uint32> cache;
+		Uint32 misses = 0;
+		for (size_t i = 0; i < numTris * 3; i++) {
+			auto it = std::find(cache.begin(), cache.end(), indices[i]);
+			if (it == cache.end()) {
+				misses++;
+				if (cache.size() == cacheSize)
+					cache.pop_back();
+			} else
+				cache.erase(it);
+			cache.insert(cache.begin(), indices[i]);
+		}
+		return float(misses) / float(numTris);
+	}
+
+	void OptimizeOverdraw(std::vector<Uint32> &indices, const std::vector<vector3f> &positions)
+	{
+		PROFILE_SCOPED()
+		const Uint32 numTris = Uint32(indices.size() / 3);
+		if (numTris == 0)
+			return;
+
+		struct Cluster {
+			Uint32 first, count;
+			vector3f centroid, normal;
+			float area;
+			float sortKey;
+		};
+		std::vector<Cluster> clusters;
+
+		std::vector<Uint32> cache;
+		for (Uint32 t = 0; t < numTris; t++) {
+			Uint32 misses = 0;
+			for (Uint32 i = 0; i < 3; i++) {
+				const Uint32 v = indices[t * 3 + i];
+				auto it = std::find(cache.begin(), cache.end(), v);
+				if (it == cache.end()) {
+					misses++;
+					if (cache.size() == VERTEX_CACHE_SIZE)
+						cache.pop_back();
+				} else
+					cache.erase(it);
+				cache.insert(cache.begin(), v);
+			}
+			if (t == 0 || misses == 3)
+				clusters.push_back({ t, 0, vector3f(0.0f), vector3f(0.0f), 0.0f, 0.0f });
+
+			Cluster &c = clusters.back();
+			const vector3f &p0 = positions[indices[t * 3]];
+			const vector3f &p1 = positions[indices[t * 3 + 1]];
+			const vector3f &p2 = positions[indices[t * 3 + 2]];
+			const vector3f n = (p1 - p0).Cross(p2 - p0);
+			const float area = n.Length() * 0.5f;
+			c.count++;
+			c.centroid += (p0 + p1 + p2) * (area / 3.0f);
+			c.normal += n;
+			c.area += area;
+		}
+
+		vector3f meshCentroid(0.0f);
+		float meshArea = 0.0f;
+		for (Cluster &c : clusters) {
+			meshCentroid += c.centroid;
+			meshArea += c.area;
+		}
+		if (meshArea > 0.0f)
+			meshCentroid /= meshArea;
+
+		// clusters far out along their normal are the likeliest to cover others
+		for (Cluster &c : clusters) {
+			if (c.area <= 0.0f || c.normal.LengthSqr() <= 0.0f)
+				continue;
+			c.sortKey = (c.centroid / c.area - meshCentroid).Dot(c.normal.Normalized());
+		}
+		std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster &a, const Cluster &b) {
+			return a.sortKey > b.sortKey;
+		});
+
+		std::vector<Uint32> out;
+		out.reserve(indices.size());
+		for (const Cluster &c : clusters)
+			out.insert(out.end(), &indices[c.first * 3], &indices[(c.first + c.count) * 3]);
+		indices.swap(out);
+	}
+
+	std::vector<Uint32> OptimizeVertexFetch(std::vector<Uint32> &indices, Uint32 numVertices)
+	{
+		std::vector<Uint32> remap(numVertices, ~0U);
+		Uint32 next = 0;
+		for (Uint32 &i : indices) {
+			if (remap[i] == ~0U)
+				remap[i] = next++;
+			i = remap[i];
+		}
+		for (Uint32 &r : remap)
+			if (r == ~0U)
+				r = next++;
+		return remap;
+	}
+
+	void MeshOptimizerVisitor::ApplyStaticGeometry(StaticGeometry &sg)
+	{
+		PROFILE_SCOPED()
+		if (!m_done.insert(&sg).second)
+			return;
+
+		std::vector<Uint8> vertices;
+		std::vector<vector3f> positions;
+		std::vector<Uint32> indices;
+		for (Uint32 m = 0; m < sg.GetNumMeshes(); m++) {
+			StaticGeometry::Mesh &mesh = sg.GetMeshAt(m);
+			const Graphics::VertexBufferDesc &desc = mesh.vertexBuffer->GetDesc();
+			const Uint32 numVertices = desc.numVertices;
+			const Uint32 stride = desc.stride;
+			const Uint32 posOffset = desc.GetOffset(Graphics::ATTRIB_POSITION);
+
+			const Uint8 *vtxPtr = mesh.vertexBuffer->Map<Uint8>(Graphics::BUFFER_MAP_READ);
+			vertices.assign(vtxPtr, vtxPtr + numVertices * stride);
+			mesh.vertexBuffer->Unmap();
+			positions.resize(numVertices);
+			for (Uint32 v = 0; v < numVertices; v++)
+				memcpy(&positions[v], &vertices[v * stride + posOffset], sizeof(vector3f));
+
+			const Uint32 *idxPtr = mesh.indexBuffer->Map(Graphics::BUFFER_MAP_READ);
+			indices.assign(idxPtr, idxPtr + mesh.indexBuffer->GetSize());
+			mesh.indexBuffer->Unmap();
+
+			m_missesBefore += CalcCacheMissRatio(indices) * double(indices.size() / 3);
+			OptimizeVertexCache(indices, numVertices);
+			OptimizeOverdraw(indices, positions);
+			const std::vector<Uint32> remap = OptimizeVertexFetch(indices, numVertices);
+			m_missesAfter += CalcCacheMissRatio(indices) * double(indices.size() / 3);
+			m_numTriangles += Uint32(indices.size() / 3);
+
+			Uint8 *newVtxPtr = mesh.vertexBuffer->Map<Uint8>(Graphics::BUFFER_MAP_WRITE);
+			for (Uint32 v = 0; v < numVertices; v++)
+				memcpy(newVtxPtr + remap[v] * stride, &vertices[v * stride], stride);
+			mesh.vertexBuffer->Unmap();
+
+			Uint32 *newIdxPtr = mesh.indexBuffer->Map(Graphics::BUFFER_MAP_WRITE);
+			std::copy(indices.begin(), indices.end(), newIdxPtr);
+			mesh.indexBuffer->Unmap();
+		}
+	}
+
+} // namespace SceneGraph
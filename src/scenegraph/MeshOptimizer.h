@@ -0,0 +1,57 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _SCENEGRAPH_MESHOPTIMIZER_H
+#define _SCENEGRAPH_MESHOPTIMIZER_H
+/*
+ * Triangle and vertex reordering for faster drawing, done at compile time
+ */
+#include "NodeVisitor.h"
+#include "vector3.h"
+
+#include <SDL_stdinc.h>
+#include <set>
+#include <vector>
+
+namespace SceneGraph {
+
+	// the post-transform cache size the orderings are tuned for
+	static const Uint32 VERTEX_CACHE_SIZE = 32;
+
+	// Reorders triangles so vertices are reused while still in the GPU's
+	// post-transform cache (Forsyth, "Linear-Speed Vertex Cache Optimisation").
+	void OptimizeVertexCache(std::vector<Uint32> &indices, Uint32 numVertices);
+
+	// Reorders runs of triangles, as left by OptimizeVertexCache, so outward
+	// facing parts of the mesh come first and hide what's drawn after them.
+	// Runs break where a triangle misses the cache on all three vertices,
+	// so the cache efficiency barely changes.
+	void OptimizeOverdraw(std::vector<Uint32> &indices, const std::vector<vector3f> &positions);
+
+	// Returns the new place of each vertex, in the order the indices first
+	// use them (with unused vertices last), and updates the indices to match
+	std::vector<Uint32> OptimizeVertexFetch(std::vector<Uint32> &indices, Uint32 numVertices);
+
+	// Average vertex transforms per triangle with a cache of cacheSize last
+	// used vertices; 0.5 is about the best a regular mesh can do, 3 the worst
+	float CalcCacheMissRatio(const std::vector<Uint32> &indices, Uint32 cacheSize = VERTEX_CACHE_SIZE);
+
+	// Runs all of the above on the meshes of every StaticGeometry visited
+	class MeshOptimizerVisitor : public NodeVisitor {
+	public:
+		virtual void ApplyStaticGeometry(StaticGeometry &) override;
+
+		// cache miss ratios over all the triangles visited
+		float GetMissRatioBefore() const { return m_numTriangles ? m_missesBefore / float(m_numTriangles) : 0.0f; }
+		float GetMissRatioAfter() const { return m_numTriangles ? m_missesAfter / float(m_numTriangles) : 0.0f; }
+
+	private:
+		std::set<StaticGeometry *> m_done; // geometry may be shared between levels of detail
+		double m_missesBefore = 0.0;
+		double m_missesAfter = 0.0;
+		Uint32 m_numTriangles = 0;
+	};
+
+} // namespace SceneGraph
+
+#endif
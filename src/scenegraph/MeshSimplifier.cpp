@@ -0,0 +1,325 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "MeshSimplifier.h"
+#include "profiler/Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <queue>
+#include <tuple>
+
+namespace SceneGraph {
+
+	// border planes weigh this much more than the surface, per length squared
+	static const double BORDER_WEIGHT = 10.0;
+	// collapses may turn a triangle by up to about 75 degrees
+	static const double MIN_NORMAL_COS = 0.25;
+
+	// the sum of squared distances to a set of weighted planes
+	struct Quadric {
+		double xx = 0, xy = 0, xz = 0, xw = 0, yy = 0, yz = 0, yw = 0, zz = 0, zw = 0, ww = 0;
+		double weight = 0;
+
+		void AddPlane(const vector3d &n, double d, double w)
+		{
+			xx += w * n.x * n.x, xy += w * n.x * n.y, xz += w * n.x * n.z, xw += w * n.x * d;
+			yy += w * n.y * n.y, yz += w * n.y * n.z, yw += w * n.y * d;
+			zz += w * n.z * n.z, zw += w * n.z * d;
+			ww += w * d * d;
+			weight += w;
+		}
+
+		void Add(const Quadric &q)
+		{
+			xx += q.xx, xy += q.xy, xz += q.xz, xw += q.xw, yy += q.yy, yz += q.yz, yw += q.yw;
+			zz += q.zz, zw += q.zw, ww += q.ww, weight += q.weight;
+		}
+
+		// the mean squared distance of p to the planes
+		double Error(const vector3d &p) const
+		{
+			const double e = xx * p.x * p.x + 2.0 * xy * p.x * p.y + 2.0 * xz * p.x * p.z + 2.0 * xw * p.x +
+				yy * p.y * p.y + 2.0 * yz * p.y * p.z + 2.0 * yw * p.y +
+				zz * p.z * p.z + 2.0 * zw * p.z + ww;
+			return weight > 0.0 ? std::max(e, 0.0) / weight : 0.0;
+		}
+	};
+
+	struct Collapse {
+		double error;
+		Uint32 from, to;
+		Uint32 fromVersion, toVersion;
+		bool operator<(const Collapse &o) const { return error > o.error; } // cheapest on top
+	};
+
+	// works on groups of vertices sharing a position; a collapse moves every
+	// vertex of one group onto a vertex of another
+	class Simplifier {
+	public:
+		Simplifier(const std::vector<vector3f> &positions, const std::vector<Uint32> &indices);
+		void Run(size_t targetIndices, double maxError);
+		std::vector<Uint32> GetIndices() const;
+		double GetError() const { return m_error; }
+
+	private:
+		Uint32 Group(Uint32 v) const { return m_vertexGroup[v]; }
+		void PushCollapse(Uint32 from, Uint32 to);
+		void GetNeighbours(Uint32 g, std::vector<Uint32> &out) const;
+		bool CanCollapse(Uint32 from, Uint32 to, std::map<Uint32, Uint32> &remap) const;
+		void DoCollapse(Uint32 from, Uint32 to, const std::map<Uint32, Uint32> &remap);
+
+		std::vector<Uint32> m_vertexGroup;
+		std::vector<vector3d> m_groupPos;
+		std::vector<std::vector<Uint32>> m_groupTris;
+		std::vector<Quadric> m_quadrics;
+		std::vector<Uint32> m_versions;
+		std::vector<bool> m_groupAlive;
+
+		std::vector<Uint32> m_tris;
+		std::vector<bool> m_triAlive;
+		size_t m_numTris;
+
+		std::priority_queue<Collapse> m_queue;
+		double m_error;
+	};
+
+	Simplifier::Simplifier(const std::vector<vector3f> &positions, const std::vector<Uint32> &indices) :
+		m_tris(indices),
+		m_triAlive(indices.size() / 3, true),
+		m_numTris(indices.size() / 3),
+		m_error(0.0)
+	{
+		m_tris.resize(m_numTris * 3);
+
+		std::map<std::tuple<float, float, float>, Uint32> welded;
+		m_vertexGroup.resize(positions.size());
+		for (Uint32 v = 0; v < positions.size(); v++) {
+			const vector3f &p = positions[v];
+			auto it = welded.emplace(std::make_tuple(p.x, p.y, p.z), Uint32(m_groupPos.size())).first;
+			if (it->second == m_groupPos.size())
+				m_groupPos.push_back(vector3d(p));
+			m_vertexGroup[v] = it->second;
+		}
+
+		const size_t numGroups = m_groupPos.size();
+		m_groupTris.resize(numGroups);
+		m_quadrics.resize(numGroups);
+		m_versions.resize(numGroups, 0);
+		m_groupAlive.resize(numGroups, true);
+
+		// surface planes, and how many triangles use each edge
+		std::map<std::pair<Uint32, Uint32>, Uint32> edgeUse;
+		for (Uint32 t = 0; t < m_triAlive.size(); t++) {
+			const Uint32 g[3] = { Group(m_tris[t * 3]), Group(m_tris[t * 3 + 1]), Group(m_tris[t * 3 + 2]) };
+			if (g[0] == g[1] || g[1] == g[2] || g[0] == g[2]) {
+				m_triAlive[t] = false;
+				m_numTris--;
+				continue;
+			}
+			for (Uint32 i = 0; i < 3; i++) {
+				m_groupTris[g[i]].push_back(t);
+				edgeUse[std::minmax(g[i], g[(i + 1) % 3])]++;
+			}
+
+			const vector3d n = (m_groupPos[g[1]] - m_groupPos[g[0]]).Cross(m_groupPos[g[2]] - m_groupPos[g[0]]);
+			const double len = n.Length();
+			if (len <= 0.0)
+				continue;
+			const vector3d unit = n / len;
+			for (Uint32 i = 0; i < 3; i++)
+				m_quadrics[g[i]].AddPlane(unit, -unit.Dot(m_groupPos[g[0]]), len * 0.5);
+		}
+
+		// planes along open borders, at right angles to the surface
+		for (Uint32 t = 0; t < m_triAlive.size(); t++) {
+			if (!m_triAlive[t])
+				continue;
+			const Uint32 g[3] = { Group(m_tris[t * 3]), Group(m_tris[t * 3 + 1]), Group(m_tris[t * 3 + 2]) };
+			const vector3d n = (m_groupPos[g[1]] - m_groupPos[g[0]]).Cross(m_groupPos[g[2]] - m_groupPos[g[0]]);
+			for (Uint32 i = 0; i < 3; i++) {
+				const Uint32 a = g[i], b = g[(i + 1) % 3];
+				if (edgeUse[std::minmax(a, b)] != 1)
+					continue;
+				const vector3d edge = m_groupPos[b] - m_groupPos[a];
+				const vector3d across = edge.Cross(n);
+				const double len = across.Length();
+				if (len <= 0.0)
+					continue;
+				const vector3d unit = across / len;
+				const double w = edge.LengthSqr() * BORDER_WEIGHT;
+				m_quadrics[a].AddPlane(unit, -unit.Dot(m_groupPos[a]), w);
+				m_quadrics[b].AddPlane(unit, -unit.Dot(m_groupPos[a]), w);
+			}
+		}
+
+		for (const auto &edge : edgeUse) {
+			PushCollapse(edge.first.first, edge.first.second);
+			PushCollapse(edge.first.second, edge.first.first);
+		}
+	}
+
+	void Simplifier::PushCollapse(Uint32 from, Uint32 to)
+	{
+		Quadric q = m_quadrics[from];
+		q.Add(m_quadrics[to]);
+		m_queue.push({ q.Error(m_groupPos[to]), from, to, m_versions[from], m_versions[to] });
+	}
+
+	void Simplifier::GetNeighbours(Uint32 g, std::vector<Uint32> &out) const
+	{
+		out.clear();
+		for (Uint32 t : m_groupTris[g]) {
+			if (!m_triAlive[t])
+				continue;
+			for (Uint32 i = 0; i < 3; i++) {
+				const Uint32 n = Group(m_tris[t * 3 + i]);
+				if (n != g)
+					out.push_back(n);
+			}
+		}
+		std::sort(out.begin(), out.end());
+		out.erase(std::unique(out.begin(), out.end()), out.end());
+	}
+
+	bool Simplifier::CanCollapse(Uint32 from, Uint32 to, std::map<Uint32, Uint32> &remap) const
+	{
+		remap.clear();
+		Uint32 shared = 0;
+		for (Uint32 t : m_groupTris[from]) {
+			if (!m_triAlive[t])
+				continue;
+			const Uint32 *tri = &m_tris[t * 3];
+			const Uint32 g[3] = { Group(tri[0]), Group(tri[1]), Group(tri[2]) };
+
+			// a vertex moves onto the vertex it shares a triangle with, which
+			// keeps its attributes on the same side of a seam
+			Uint32 self = 3, other = 3;
+			for (Uint32 i = 0; i < 3; i++) {
+				if (g[i] == from)
+					self = i;
+				else if (g[i] == to)
+					other = i;
+			}
+			if (other < 3) {
+				shared++;
+				auto it = remap.find(tri[self]);
+				if (it == remap.end())
+					remap[tri[self]] = tri[other];
+				else if (it->second != tri[other])
+					return false; // the vertex has differing attributes on each side
+				continue;
+			}
+
+			// this triangle stays; it must not turn over
+			const vector3d &p1 = m_groupPos[g[(self + 1) % 3]];
+			const vector3d &p2 = m_groupPos[g[(self + 2) % 3]];
+			const vector3d before = (p1 - m_groupPos[from]).Cross(p2 - m_groupPos[from]);
+			const vector3d after = (p1 - m_groupPos[to]).Cross(p2 - m_groupPos[to]);
+			const double lengths = before.Length() * after.Length();
+			if (lengths <= 0.0 || before.Dot(after) < lengths * MIN_NORMAL_COS)
+				return false;
+		}
+
+		// every vertex in use needs somewhere to go
+		for (Uint32 t : m_groupTris[from]) {
+			if (!m_triAlive[t])
+				continue;
+			for (Uint32 i = 0; i < 3; i++) {
+				const Uint32 v = m_tris[t * 3 + i];
+				if (Group(v) == from && remap.find(v) == remap.end())
+					return false;
+			}
+		}
+
+		// the ends may only have the neighbours across the collapsing edge's
+		// triangles in common, or the surface folds up
+		std::vector<Uint32> a, b, common;
+		GetNeighbours(from, a);
+		GetNeighbours(to, b);
+		std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(common));
+		return shared > 0 && common.size() <= std::min(shared, 2U);
+	}
+
+	void Simplifier::DoCollapse(Uint32 from, Uint32 to, const std::map<Uint32, Uint32> &remap)
+	{
+		for (Uint32 t : m_groupTris[from]) {
+			if (!m_triAlive[t])
+				continue;
+			Uint32 *tri = &m_tris[t * 3];
+			bool degenerate = false;
+			for (Uint32 i = 0; i < 3; i++) {
+				if (Group(tri[i]) == from)
+					tri[i] = remap.at(tri[i]);
+				else if (Group(tri[i]) == to)
+					degenerate = true;
+			}
+			if (degenerate) {
+				m_triAlive[t] = false;
+				m_numTris--;
+			} else
+				m_groupTris[to].push_back(t);
+		}
+
+		m_groupTris[from].clear();
+		m_groupAlive[from] = false;
+		m_quadrics[to].Add(m_quadrics[from]);
+		m_versions[to]++;
+
+		// compact the list, it only grows otherwise
+		std::vector<Uint32> &tris = m_groupTris[to];
+		tris.erase(std::remove_if(tris.begin(), tris.end(), [&](Uint32 t) { return !m_triAlive[t]; }), tris.end());
+
+		std::vector<Uint32> neighbours;
+		GetNeighbours(to, neighbours);
+		for (Uint32 n : neighbours) {
+			PushCollapse(n, to);
+			PushCollapse(to, n);
+		}
+	}
+
+	void Simplifier::Run(size_t targetIndices, double maxError)
+	{
+		const double maxErrorSqr = maxError * maxError;
+		std::map<Uint32, Uint32> remap;
+		while (m_numTris * 3 > targetIndices && !m_queue.empty()) {
+			const Collapse c = m_queue.top();
+			if (c.error > maxErrorSqr)
+				break;
+			m_queue.pop();
+
+			// stale entries were pushed again when their ends changed
+			if (!m_groupAlive[c.from] || !m_groupAlive[c.to] ||
+				c.fromVersion != m_versions[c.from] || c.toVersion != m_versions[c.to])
+				continue;
+			if (!CanCollapse(c.from, c.to, remap))
+				continue;
+
+			DoCollapse(c.from, c.to, remap);
+			m_error = std::max(m_error, c.error);
+		}
+	}
+
+	std::vector<Uint32> Simplifier::GetIndices() const
+	{
+		std::vector<Uint32> out;
+		out.reserve(m_numTris * 3);
+		for (Uint32 t = 0; t < m_triAlive.size(); t++)
+			if (m_triAlive[t])
+				out.insert(out.end(), &m_tris[t * 3], &m_tris[t * 3] + 3);
+		return out;
+	}
+
+	std::vector<Uint32> SimplifyMesh(const std::vector<vector3f> &positions, const std::vector<Uint32> &indices,
+		size_t targetIndices, float maxError, float *resultError)
+	{
+		PROFILE_SCOPED()
+		Simplifier s(positions, indices);
+		s.Run(targetIndices, maxError);
+		if (resultError)
+			*resultError = float(std::sqrt(s.GetError()));
+		return s.GetIndices();
+	}
+
+} // namespace SceneGraph
@@ -0,0 +1,34 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _SCENEGRAPH_MESHSIMPLIFIER_H
+#define _SCENEGRAPH_MESHSIMPLIFIER_H
+/*
+ * Triangle reduction for generated levels of detail
+ */
+#include "vector3.h"
+
+#include <SDL_stdinc.h>
+#include <vector>
+
+namespace SceneGraph {
+
+	// Removes triangles from an indexed triangle list by collapsing edges,
+	// cheapest first by quadric error (Garland & Heckbert 1997).
+	//
+	// Edges collapse into one of their ends, so the result indexes the
+	// original vertices and can share their vertex data. Vertices with the
+	// same position (split for uv or normal seams) move together, and only
+	// along the seam, so seams don't tear. Open borders are held in place
+	// by extra planes across them, and collapses that would flip a triangle
+	// or fold the surface onto itself are skipped.
+	//
+	// Simplification stops once the triangle list is down to targetIndices,
+	// or before the first collapse moving the surface further than maxError.
+	// The largest error of the collapses made goes to resultError if given.
+	std::vector<Uint32> SimplifyMesh(const std::vector<vector3f> &positions, const std::vector<Uint32> &indices,
+		size_t targetIndices, float maxError, float *resultError = nullptr);
+
+} // namespace SceneGraph
+
+#endif
@@ -3,6 +3,7 @@
 
 #include "Model.h"
 
+#include "CollisionGeometry.h"
 #include "CollisionVisitor.h"
 #include "FindNodeVisitor.h"
 #include "GameSaveError.h"
@@ -11,10 +12,12 @@
 #include "NodeCopyCache.h"
 #include "StringF.h"
 #include "Thruster.h"
+#include "core/MemoryStats.h"
 #include "graphics/Material.h"
 #include "graphics/RenderState.h"
 #include "graphics/Renderer.h"
 #include "graphics/TextureBuilder.h"
+#include "graphics/TextureStreamer.h"
 #include "graphics/VertexArray.h"
 #include "matrix4x4.h"
 #include "scenegraph/Animation.h"
@@ -25,6 +28,8 @@
 #include "scenegraph/Tag.h"
 #include "utils.h"
 
+#include <set>
+
 namespace SceneGraph {
 
 	class LabelUpdateVisitor : public NodeVisitor {
@@ -37,14 +42,28 @@ namespace SceneGraph {
 		std::string label;
 	};
 
+	// finds the nodes instanced rendering doesn't draw
+	class InstancedRenderVisitor : public NodeVisitor {
+	public:
+		virtual void ApplyLabel(Label3D &) override { uninstanced = true; }
+		virtual void ApplyBillboard(Billboard &) override { uninstanced = true; }
+		virtual void ApplyThruster(Thruster &) override { uninstanced = true; }
+
+		bool uninstanced = false;
+	};
+
 	Model::Model(Graphics::Renderer *r, const std::string &name) :
 		m_boundingRadius(10.f),
 		m_renderer(r),
 		m_name(name),
 		m_activeAnimations(0),
+		m_pendingAnimations(0),
+		m_animationsAffectState(false),
 		m_curPatternIndex(0),
 		m_curPattern(0),
-		m_debugFlags(0)
+		m_debugFlags(0),
+		m_canRenderInstanced(false),
+		m_instanceBytes(0)
 	{
 		m_root.Reset(new Group(m_renderer));
 		m_root->SetName(name);
@@ -55,11 +74,14 @@ namespace SceneGraph {
 		DeleteEmitter(),
 		m_boundingRadius(model.m_boundingRadius),
 		m_materials(model.m_materials),
+		m_materialTextures(model.m_materialTextures),
 		m_patterns(model.m_patterns),
 		m_collMesh(model.m_collMesh), //might have to make this per-instance at some point
 		m_renderer(model.m_renderer),
 		m_name(model.m_name),
 		m_activeAnimations(0),
+		m_pendingAnimations(0),
+		m_animationsAffectState(model.m_animationsAffectState),
 		m_curPatternIndex(model.m_curPatternIndex),
 		m_curPattern(model.m_curPattern),
 		m_debugFlags(0)
@@ -67,6 +89,12 @@ namespace SceneGraph {
 		//selective copying of node structure
 		NodeCopyCache cache;
 		m_root.Reset(dynamic_cast<Group *>(model.m_root->Clone(&cache)));
+		m_instanceBytes = sizeof(Model) + cache.GetCopiedBytes();
+		MemoryStats::Add(MemoryStats::TAG_MODELS, m_instanceBytes);
+
+		InstancedRenderVisitor instancedVisitor;
+		m_root->Accept(instancedVisitor);
+		m_canRenderInstanced = !instancedVisitor.uninstanced;
 
 		//materials are shared by meshes
 		for (unsigned int i = 0; i < MAX_DECAL_MATERIALS; i++)
@@ -103,12 +131,44 @@ namespace SceneGraph {
 
 	Model::~Model()
 	{
+		MemoryStats::Sub(MemoryStats::TAG_MODELS, m_instanceBytes);
 		while (!m_animations.empty())
 			delete m_animations.back(), m_animations.pop_back();
 	}
 
+	// Marks the groups whose subtrees can be shared between instances:
+	// geometry, thrusters, static collision geometry and the groups holding
+	// them, as long as nothing animates them or attaches per-instance
+	// nodes to them (tags, labels, billboards, navlights).
+	static bool mark_shared_nodes(Node *node, const std::set<const Node *> &animated)
+	{
+		Group *grp = dynamic_cast<Group *>(node);
+		if (!grp) {
+			if (CollisionGeometry *cg = dynamic_cast<CollisionGeometry *>(node))
+				return !cg->IsDynamic();
+			return dynamic_cast<StaticGeometry *>(node) || dynamic_cast<Thruster *>(node);
+		}
+
+		bool shareable = !(node->GetNodeFlags() & NODE_TAG) &&
+			!animated.count(node) &&
+			!starts_with(node->GetName(), "navlight_");
+		for (unsigned int i = 0; i < grp->GetNumChildren(); i++)
+			shareable = mark_shared_nodes(grp->GetChildAt(i), animated) && shareable;
+		grp->SetShared(shareable);
+		return shareable;
+	}
+
 	Model *Model::MakeInstance() const
 	{
+		PROFILE_SCOPED()
+		std::set<const Node *> animated;
+		for (const Animation *anim : m_animations)
+			for (const AnimationChannel &chan : anim->GetChannels())
+				animated.insert(chan.node);
+		mark_shared_nodes(m_root.Get(), animated);
+		// every instance needs its own root to attach things to
+		m_root->SetShared(false);
+
 		Model *m = new Model(*this);
 		return m;
 	}
@@ -116,6 +176,8 @@ namespace SceneGraph {
 	void Model::Render(const matrix4x4f &trans, const RenderData *rd)
 	{
 		PROFILE_SCOPED()
+		UpdatePendingAnimations();
+
 		//update color parameters (materials are shared by model instances)
 		if (m_curPattern) {
 			for (auto &mat : m_materials) {
@@ -135,6 +197,7 @@ namespace SceneGraph {
 		RenderData params = (rd != 0) ? (*rd) : m_renderData;
 
 		m_renderer->SetTransform(trans);
+		RequestTextureDetail(trans);
 
 		//using the entire model bounding radius for all nodes at the moment.
 		//BR could also be a property of Node.
@@ -177,6 +240,8 @@ namespace SceneGraph {
 	void Model::Render(const std::vector<matrix4x4f> &trans, const RenderData *rd)
 	{
 		PROFILE_SCOPED();
+		UpdatePendingAnimations();
+
 
 		//update color parameters (materials are shared by model instances)
 		if (m_curPattern) {
@@ -196,6 +261,14 @@ namespace SceneGraph {
 		//Override renderdata if this model is called from ModelNode
 		RenderData params = (rd != 0) ? (*rd) : m_renderData;
 
+		//the nearest instance needs the most detail
+		if (!m_materialTextures.empty() && !trans.empty()) {
+			auto nearest = std::min_element(trans.begin(), trans.end(), [](const matrix4x4f &a, const matrix4x4f &b) {
+				return a.GetTranslate().LengthSqr() < b.GetTranslate().LengthSqr();
+			});
+			RequestTextureDetail(*nearest);
+		}
+
 		//using the entire model bounding radius for all nodes at the moment.
 		//BR could also be a property of Node.
 		params.boundingRadius = GetDrawClipRadius();
@@ -217,6 +290,46 @@ namespace SceneGraph {
 			m_renderer->SetWireFrameMode(false);
 	}
 
+	void Model::RequestTextureDetail(const matrix4x4f &trans)
+	{
+		Graphics::TextureStreamer *streamer = m_renderer->GetTextureStreamer();
+		if (!streamer || m_materialTextures.empty())
+			return;
+
+		// projected diameter of the bounding sphere, in pixels
+		const float distance = std::max(trans.GetTranslate().Length() - GetDrawClipRadius(), 1.0f);
+		const float pixelSize = GetDrawClipRadius() / distance * m_renderer->GetProjection()[5] * m_renderer->GetViewport().h;
+		for (const Graphics::Texture *texture : m_materialTextures)
+			streamer->RequestSize(texture, pixelSize);
+	}
+
+	bool Model::CanRenderInstancedWith(const Model &other) const
+	{
+		if (!m_canRenderInstanced || !other.m_canRenderInstanced)
+			return false;
+
+		// instances of the same model share their collision mesh
+		if (m_name != other.m_name || m_collMesh != other.m_collMesh)
+			return false;
+
+		// only the first model's state is used to draw them all
+		if (m_curPattern != other.m_curPattern || m_colors != other.m_colors)
+			return false;
+		if (m_debugFlags != other.m_debugFlags || m_renderData.nodemask != other.m_renderData.nodemask)
+			return false;
+
+		for (unsigned int i = 0; i < MAX_DECAL_MATERIALS; i++)
+			if (m_curDecals[i] != other.m_curDecals[i])
+				return false;
+
+		assert(m_animations.size() == other.m_animations.size());
+		for (size_t i = 0; i < m_animations.size(); i++)
+			if (m_animations[i]->GetProgress() != other.m_animations[i]->GetProgress())
+				return false;
+
+		return true;
+	}
+
 	RefCountedPtr<CollMesh> Model::CreateCollisionMesh()
 	{
 		CollisionVisitor cv;
@@ -276,6 +389,7 @@ namespace SceneGraph {
 		node->SetName(std::string(name));
 		node->SetNodeFlags(node->GetNodeFlags() | NODE_TAG);
 		parent->AddChild(node);
+		node->InvalidateGlobalTransform();
 		m_tags.push_back(node);
 	}
 
@@ -300,6 +414,7 @@ namespace SceneGraph {
 	void Model::SetColors(const std::vector<Color> &colors)
 	{
 		assert(colors.size() == 3); //primary, seconday, trim
+		m_colors = colors;
 		m_colorMap.Generate(GetRenderer(), colors.at(0), colors.at(1), colors.at(2));
 	}
 
@@ -364,20 +479,62 @@ namespace SceneGraph {
 	{
 		for (AnimationContainer::iterator anim = m_animations.begin(); anim != m_animations.end(); ++anim)
 			(*anim)->Interpolate();
+		m_pendingAnimations = 0;
+		m_animationsAffectState = CheckAnimationsAffectState();
+	}
+
+	bool Model::CheckAnimationsAffectState() const
+	{
+		for (const Animation *anim : m_animations) {
+			for (const AnimationChannel &chan : anim->GetChannels()) {
+				std::vector<Node *> stack = { chan.node };
+				while (!stack.empty()) {
+					Node *node = stack.back();
+					stack.pop_back();
+					if (node->GetNodeFlags() & NODE_TAG)
+						return true;
+					if (CollisionGeometry *cg = dynamic_cast<CollisionGeometry *>(node))
+						if (cg->IsDynamic())
+							return true;
+					if (Group *grp = dynamic_cast<Group *>(node))
+						for (unsigned int i = 0; i < grp->GetNumChildren(); i++)
+							stack.push_back(grp->GetChildAt(i));
+				}
+			}
+		}
+		return false;
 	}
 
 	void Model::UpdateAnimations()
 	{
+		// nothing to do until an active animation's time changes
+		uint64_t changed = 0;
+		for (size_t i = 0; i < m_animations.size(); i++) {
+			if ((m_activeAnimations & (1ULL << i)) && m_animations[i]->NeedsInterpolate())
+				changed = m_activeAnimations;
+		}
+		if (!changed)
+			return;
+
+		m_pendingAnimations |= changed;
+		if (m_animationsAffectState)
+			UpdatePendingAnimations();
+	}
+
+	void Model::UpdatePendingAnimations()
+	{
+		if (!m_pendingAnimations)
+			return;
+
+		PROFILE_SCOPED()
+		// all of them, in order, so overlapping channels end up as before
 		for (size_t i = 0; i < m_animations.size(); i++) {
-			if (m_activeAnimations & (1 << i))
+			if (m_pendingAnimations & (1ULL << i))
 				m_animations[i]->Interpolate();
 		}
+		m_pendingAnimations = 0;
 
-		// Assume if we're ticking an active animation, our tags most likely need to be updated.
-		// This can be optimized slightly by walking the node hierarchy and looking for a "dirty"
-		// flag to determine if the tag needs to be updated, but at current it's not a significant
-		// performance issue compared to animation interpolation.
-		if (m_activeAnimations)
+		if (m_animationsAffectState)
 			UpdateTagTransforms();
 	}
 
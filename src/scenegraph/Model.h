@@ -102,6 +102,11 @@ namespace SceneGraph {
 
 		void Render(const matrix4x4f &trans, const RenderData *rd = 0);				 //ModelNode can override RD
 		void Render(const std::vector<matrix4x4f> &trans, const RenderData *rd = 0); //ModelNode can override RD
+		// Whether other can be drawn as one of the instances of this model
+		// passed to Render(const std::vector<matrix4x4f> &): both are
+		// instances of the same model in the same state, and neither has
+		// nodes (labels, thrusters, billboards) that can't be drawn instanced.
+		bool CanRenderInstancedWith(const Model &other) const;
 
 		RefCountedPtr<CollMesh> CreateCollisionMesh();
 		RefCountedPtr<CollMesh> GetCollisionMesh() const { return m_collMesh; }
@@ -153,8 +158,13 @@ namespace SceneGraph {
 		// Mark an animation as actively updating. A maximum of 64 active animations are supported.
 		void SetAnimationActive(uint32_t index, bool active);
 		bool GetAnimationActive(uint32_t index) const;
-		// Update all active animations.
+		// Update all active animations. Models whose animations only move
+		// geometry (no tags or dynamic collision geometry) are left until they
+		// are rendered, or until UpdatePendingAnimations is called.
 		void UpdateAnimations();
+		// Interpolates the animations UpdateAnimations left for later. Instances
+		// don't share animated nodes, so different models can be updated in parallel.
+		void UpdatePendingAnimations();
 
 		Graphics::Renderer *GetRenderer() const { return m_renderer; }
 
@@ -185,10 +195,16 @@ namespace SceneGraph {
 	private:
 		Model(const Model &);
 
+		// asks the texture streamer for the detail the model's textures need at this distance
+		void RequestTextureDetail(const matrix4x4f &trans);
+		// whether animating moves anything other than geometry
+		bool CheckAnimationsAffectState() const;
+
 		static const unsigned int MAX_DECAL_MATERIALS = 4;
 		ColorMap m_colorMap;
 		float m_boundingRadius;
 		MaterialContainer m_materials; //materials are shared throughout the model graph
+		std::vector<Graphics::Texture *> m_materialTextures; //for requesting streamed mips, see RequestTextureDetail
 		PatternContainer m_patterns;
 		RefCountedPtr<CollMesh> m_collMesh;
 		RefCountedPtr<Graphics::Material> m_decalMaterials[MAX_DECAL_MATERIALS]; //spaceship insignia, advertising billboards
@@ -198,6 +214,8 @@ namespace SceneGraph {
 
 		std::vector<Animation *> m_animations;
 		uint64_t m_activeAnimations; // bitmask of actively ticking animations
+		uint64_t m_pendingAnimations; // bitmask of animations to interpolate before rendering
+		bool m_animationsAffectState;
 
 		std::vector<Tag *> m_tags;		 //named attachment points
 
@@ -210,6 +228,11 @@ namespace SceneGraph {
 
 		Uint32 m_debugFlags;
 		bool m_tagsDirty;
+		// only instances made with MakeInstance() are checked for instancing
+		bool m_canRenderInstanced;
+		// estimated size of this instance's own nodes, for MemoryStats
+		size_t m_instanceBytes;
+		std::vector<Color> m_colors;
 
 		std::unique_ptr<Graphics::MeshObject> m_debugMesh;
 		std::unique_ptr<Graphics::Material> m_debugLineMat;
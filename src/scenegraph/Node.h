@@ -6,6 +6,7 @@
 /*
  * Generic node for the model scenegraph
  */
+#include "ByteRange.h"
 #include "RefCounted.h"
 #include "graphics/Material.h"
 
@@ -70,6 +71,9 @@ namespace SceneGraph {
 		Model *model;
 		std::vector<std::pair<std::string, RefCountedPtr<Graphics::Material>>> *materials;
 		BaseLoader *loader;
+		// the uncompressed, aligned vertex and index data section of the file
+		Serializer::Writer *geomWr = nullptr;
+		ByteRange geomData;
 	};
 
 	class Node : public RefCounted {
@@ -13,6 +13,9 @@ namespace SceneGraph {
 
 	class NodeCopyCache {
 	public:
+		NodeCopyCache() :
+			m_copiedBytes(0) {}
+
 		template <typename T>
 		T *Copy(const T *origNode)
 		{
@@ -23,13 +26,18 @@ namespace SceneGraph {
 					return static_cast<T *>((*i).second);
 			}
 			T *newNode = new T(*origNode, this);
+			m_copiedBytes += sizeof(T);
 			if (doCache)
 				m_cache.insert(std::make_pair(origNode, newNode));
 			return newNode;
 		}
 
+		// size of the node objects copied so far, not counting what they own
+		size_t GetCopiedBytes() const { return m_copiedBytes; }
+
 	private:
 		std::map<const Node *, Node *> m_cache;
+		size_t m_copiedBytes;
 	};
 
 } // namespace SceneGraph
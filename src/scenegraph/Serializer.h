@@ -37,6 +37,15 @@ namespace Serializer {
 	public:
 		Writer() {}
 		const std::string &GetData() { return m_str; }
+		std::size_t Pos() const { return m_str.size(); }
+
+		// pad with zeroes until the next write starts at a multiple of alignment
+		void Align(std::size_t alignment)
+		{
+			const std::size_t rem = m_str.size() % alignment;
+			if (rem)
+				m_str.append(alignment - rem, '\0');
+		}
 
 		template <typename T>
 		void writeObject(const T &obj)
@@ -17,6 +17,17 @@
 
 namespace SceneGraph {
 
+	// the next size bytes of the geometry section, at the offset read from the node data
+	static ByteRange GeometryRange(NodeDatabase &db, size_t size)
+	{
+		const Uint64 offset = db.rd->Int64();
+		if (size == 0)
+			return ByteRange();
+		if (offset + size > db.geomData.Size())
+			throw LoadingError("Geometry out of range");
+		return ByteRange(db.geomData.begin + offset, size);
+	}
+
 	StaticGeometry::StaticGeometry(Graphics::Renderer *r) :
 		Node(r, NODE_SOLID)
 	{
@@ -131,38 +142,35 @@ namespace SceneGraph {
 
 			const bool hasTangents = (attribCombo & Graphics::ATTRIB_TANGENT);
 
-			//save positions, normals and uvs interleaved (only known format now)
+			//positions, normals, uvs and tangents go tightly interleaved into the
+			//geometry section, so a matching vertex buffer can be filled in one copy
 			const Uint32 posOffset = vbDesc.GetOffset(Graphics::ATTRIB_POSITION);
 			const Uint32 nrmOffset = vbDesc.GetOffset(Graphics::ATTRIB_NORMAL);
 			const Uint32 uv0Offset = vbDesc.GetOffset(Graphics::ATTRIB_UV0);
 			const Uint32 tanOffset = hasTangents ? vbDesc.GetOffset(Graphics::ATTRIB_TANGENT) : 0;
 			const Uint32 stride = vbDesc.stride;
+			Serializer::Writer &geom = *db.geomWr;
+			geom.Align(16);
 			db.wr->Int32(vbDesc.numVertices);
+			db.wr->Int64(geom.Pos());
 			Uint8 *vtxPtr = mesh.vertexBuffer->Map<Uint8>(Graphics::BUFFER_MAP_READ);
-			if (hasTangents) {
-				for (Uint32 i = 0; i < vbDesc.numVertices; i++) {
-					db.wr->Vector3f(*reinterpret_cast<vector3f *>(vtxPtr + i * stride + posOffset));
-					db.wr->Vector3f(*reinterpret_cast<vector3f *>(vtxPtr + i * stride + nrmOffset));
-					db.wr->Float(reinterpret_cast<vector2f *>(vtxPtr + i * stride + uv0Offset)->x);
-					db.wr->Float(reinterpret_cast<vector2f *>(vtxPtr + i * stride + uv0Offset)->y);
-					db.wr->Vector3f(*reinterpret_cast<vector3f *>(vtxPtr + i * stride + tanOffset));
-				}
-			} else {
-				for (Uint32 i = 0; i < vbDesc.numVertices; i++) {
-					db.wr->Vector3f(*reinterpret_cast<vector3f *>(vtxPtr + i * stride + posOffset));
-					db.wr->Vector3f(*reinterpret_cast<vector3f *>(vtxPtr + i * stride + nrmOffset));
-					db.wr->Float(reinterpret_cast<vector2f *>(vtxPtr + i * stride + uv0Offset)->x);
-					db.wr->Float(reinterpret_cast<vector2f *>(vtxPtr + i * stride + uv0Offset)->y);
-				}
+			for (Uint32 i = 0; i < vbDesc.numVertices; i++) {
+				geom.Vector3f(*reinterpret_cast<vector3f *>(vtxPtr + i * stride + posOffset));
+				geom.Vector3f(*reinterpret_cast<vector3f *>(vtxPtr + i * stride + nrmOffset));
+				geom.Vector2f(*reinterpret_cast<vector2f *>(vtxPtr + i * stride + uv0Offset));
+				if (hasTangents)
+					geom.Vector3f(*reinterpret_cast<vector3f *>(vtxPtr + i * stride + tanOffset));
 			}
 			mesh.vertexBuffer->Unmap();
 
 			//indices
 			const Uint32 *indexPtr = mesh.indexBuffer->Map(Graphics::BUFFER_MAP_READ);
 			const Uint32 numIndices = mesh.indexBuffer->GetSize();
+			geom.Align(16);
 			db.wr->Int32(numIndices);
+			db.wr->Int64(geom.Pos());
 			for (Uint32 i = 0; i < numIndices; i++)
-				db.wr->Int32(indexPtr[i]);
+				geom.Int32(indexPtr[i]);
 			mesh.indexBuffer->Unmap();
 		}
 	}
@@ -214,6 +222,10 @@ namespace SceneGraph {
 			vbDesc.usage = Graphics::BUFFER_USAGE_STATIC;
 			vbDesc.numVertices = db.rd->Int32();
 
+			//the file layout, see Save
+			const Uint32 fileStride = hasTangents ? 44 : 32;
+			const ByteRange vertices = GeometryRange(db, vbDesc.numVertices * size_t(fileStride));
+
 			RefCountedPtr<Graphics::VertexBuffer> vtxBuffer(db.loader->GetRenderer()->CreateVertexBuffer(vbDesc));
 			const Uint32 posOffset = vtxBuffer->GetDesc().GetOffset(Graphics::ATTRIB_POSITION);
 			const Uint32 nrmOffset = vtxBuffer->GetDesc().GetOffset(Graphics::ATTRIB_NORMAL);
@@ -221,32 +233,28 @@ namespace SceneGraph {
 			const Uint32 tanOffset = hasTangents ? vtxBuffer->GetDesc().GetOffset(Graphics::ATTRIB_TANGENT) : 0;
 			const Uint32 stride = vtxBuffer->GetDesc().stride;
 			Uint8 *vtxPtr = vtxBuffer->Map<Uint8>(BUFFER_MAP_WRITE);
-			if (hasTangents) {
-				for (Uint32 i = 0; i < vbDesc.numVertices; i++) {
-					*reinterpret_cast<vector3f *>(vtxPtr + i * stride + posOffset) = db.rd->Vector3f();
-					*reinterpret_cast<vector3f *>(vtxPtr + i * stride + nrmOffset) = db.rd->Vector3f();
-					const float uvx = db.rd->Float();
-					const float uvy = db.rd->Float();
-					*reinterpret_cast<vector2f *>(vtxPtr + i * stride + uv0Offset) = vector2f(uvx, uvy);
-					*reinterpret_cast<vector3f *>(vtxPtr + i * stride + tanOffset) = db.rd->Vector3f();
-				}
+			if (stride == fileStride && posOffset == 0 && nrmOffset == 12 && uv0Offset == 24 && (!hasTangents || tanOffset == 32)) {
+				if (!vertices.Empty())
+					memcpy(vtxPtr, vertices.begin, vertices.Size());
 			} else {
 				for (Uint32 i = 0; i < vbDesc.numVertices; i++) {
-					*reinterpret_cast<vector3f *>(vtxPtr + i * stride + posOffset) = db.rd->Vector3f();
-					*reinterpret_cast<vector3f *>(vtxPtr + i * stride + nrmOffset) = db.rd->Vector3f();
-					const float uvx = db.rd->Float();
-					const float uvy = db.rd->Float();
-					*reinterpret_cast<vector2f *>(vtxPtr + i * stride + uv0Offset) = vector2f(uvx, uvy);
+					const char *src = vertices.begin + i * fileStride;
+					memcpy(vtxPtr + i * stride + posOffset, src, sizeof(vector3f));
+					memcpy(vtxPtr + i * stride + nrmOffset, src + 12, sizeof(vector3f));
+					memcpy(vtxPtr + i * stride + uv0Offset, src + 24, sizeof(vector2f));
+					if (hasTangents)
+						memcpy(vtxPtr + i * stride + tanOffset, src + 32, sizeof(vector3f));
 				}
 			}
 			vtxBuffer->Unmap();
 
 			//index buffer
 			const Uint32 numIndices = db.rd->Int32();
+			const ByteRange indices = GeometryRange(db, numIndices * sizeof(Uint32));
 			RefCountedPtr<Graphics::IndexBuffer> idxBuffer(db.loader->GetRenderer()->CreateIndexBuffer(numIndices, Graphics::BUFFER_USAGE_STATIC));
 			Uint32 *idxPtr = idxBuffer->Map(BUFFER_MAP_WRITE);
-			for (Uint32 i = 0; i < numIndices; i++)
-				idxPtr[i] = db.rd->Int32();
+			if (!indices.Empty())
+				memcpy(idxPtr, indices.begin, indices.Size());
 			idxBuffer->Unmap();
 
 			sg->AddMesh(vtxBuffer, idxBuffer, material);
@@ -15,13 +15,15 @@ namespace SceneGraph {
 
 	Tag::Tag(Graphics::Renderer *r, const matrix4x4f &m) :
 		MatrixTransform(r, m),
-		m_globalTransform(matrix4x4f::Identity())
+		m_globalTransform(matrix4x4f::Identity()),
+		m_globalRevision(INVALID_REVISION)
 	{
 	}
 
 	Tag::Tag(const Tag &tag, NodeCopyCache *cache) :
 		MatrixTransform(tag, cache),
-		m_globalTransform(tag.m_globalTransform)
+		m_globalTransform(tag.m_globalTransform),
+		m_globalRevision(tag.m_globalRevision)
 	{
 	}
 
@@ -53,7 +55,11 @@ namespace SceneGraph {
 
 	void Tag::UpdateGlobalTransform()
 	{
+		const Uint32 revision = CalcTransformRevision();
+		if (revision == m_globalRevision)
+			return;
 		m_globalTransform = CalcGlobalTransform();
+		m_globalRevision = revision;
 	}
 
 } // namespace SceneGraph
@@ -29,13 +29,19 @@ namespace SceneGraph {
 
 		const matrix4x4f &GetGlobalTransform() const { return m_globalTransform; }
 		// Update the cached global transform so we see changes
-		// to the model transform hierarchy
+		// to the model transform hierarchy. Does nothing if no transform
+		// between the tag and the model root changed since the last update.
 		void UpdateGlobalTransform();
+		// Force the next UpdateGlobalTransform to recompute, e.g. after reparenting
+		void InvalidateGlobalTransform() { m_globalRevision = INVALID_REVISION; }
 
 	protected:
 		virtual ~Tag() {}
 
 	private:
+		static constexpr Uint32 INVALID_REVISION = ~0u;
+
 		matrix4x4f m_globalTransform;
+		Uint32 m_globalRevision;
 	};
 } // namespace SceneGraph
@@ -0,0 +1,62 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "PathCheckCache.h"
+
+#include <algorithm>
+#include <cmath>
+
+const double PathCheckCache::MOVE_FRACTION = 0.01;
+const double PathCheckCache::MIN_DIR_DOT = 0.9999;
+
+// a ship this close to the safe radius rechecks after moving this far anyway
+static const double MIN_CLEARANCE = 1000.0;
+
+static PathCheckCache::Stats s_stats = {};
+
+bool PathCheckCache::Lookup(const Body *obstructor, const vector3d &pos, const vector3d &pathdir, double pathdist, double safeRad, double now, int &result)
+{
+	// the safe radius drifts as fuel burns, and moving towards the target
+	// shortens the path by about as much as the ship moved
+	const bool hit = m_valid && obstructor == m_obstructor &&
+		std::abs(safeRad - m_safeRad) < m_maxMove &&
+		now >= m_checkTime && now < m_checkTime + m_maxAge &&
+		(pos - m_pos).LengthSqr() < m_maxMove * m_maxMove &&
+		pathdir.Dot(m_pathdir) > MIN_DIR_DOT &&
+		std::abs(pathdist - m_pathdist) < m_maxMove + MOVE_FRACTION * m_pathdist;
+
+	if (!hit) {
+		s_stats.checks++;
+		return false;
+	}
+
+	s_stats.saved++;
+	result = m_result;
+	return true;
+}
+
+void PathCheckCache::Store(const Body *obstructor, const vector3d &pos, const vector3d &pathdir, double pathdist, double safeRad, double now, double maxAge, int result)
+{
+	const double clearance = std::max(pos.Length() - safeRad, MIN_CLEARANCE);
+
+	m_valid = true;
+	m_obstructor = obstructor;
+	m_pos = pos;
+	m_pathdir = pathdir;
+	m_pathdist = pathdist;
+	m_safeRad = safeRad;
+	m_checkTime = now;
+	m_maxAge = maxAge;
+	m_maxMove = MOVE_FRACTION * clearance;
+	m_result = result;
+}
+
+PathCheckCache::Stats PathCheckCache::GetStats()
+{
+	return s_stats;
+}
+
+void PathCheckCache::ResetStats()
+{
+	s_stats = {};
+}
@@ -0,0 +1,54 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#pragma once
+
+#include "vector3.h"
+
+#include <cstdint>
+
+class Body;
+
+// The result of the autopilot's last obstruction check of its path.
+//
+// AICmdFlyTo checks its path against the body of the frame it flies in
+// every step, though from one step to the next the path and the body
+// barely change. The cache keeps the last checked path segment, obstructor
+// and safe radius, and hands the result back until the ship has moved a
+// fraction of its clearance from the obstructor, turned its path, or the
+// result has grown too old.
+class PathCheckCache {
+public:
+	struct Stats {
+		uint64_t checks; // checks that had to be run
+		uint64_t saved;	 // checks answered from a cache
+	};
+
+	// fraction of the clearance from the obstructor the ship may move
+	static const double MOVE_FRACTION;
+	// cosine of the largest change in path direction
+	static const double MIN_DIR_DOT;
+
+	// true, with the stored result, if the path segment from pos along
+	// pathdir still matches the one last checked; all in the obstructor's frame
+	bool Lookup(const Body *obstructor, const vector3d &pos, const vector3d &pathdir, double pathdist, double safeRad, double now, int &result);
+	// stores a fresh result, valid for at most maxAge game seconds
+	void Store(const Body *obstructor, const vector3d &pos, const vector3d &pathdir, double pathdist, double safeRad, double now, double maxAge, int result);
+	void Invalidate() { m_valid = false; }
+
+	// totals over all caches, for profiling
+	static Stats GetStats();
+	static void ResetStats();
+
+private:
+	bool m_valid = false;
+	const Body *m_obstructor = nullptr;
+	vector3d m_pos;
+	vector3d m_pathdir;
+	double m_pathdist = 0.0;
+	double m_safeRad = 0.0;
+	double m_checkTime = 0.0;
+	double m_maxAge = 0.0;
+	double m_maxMove = 0.0;
+	int m_result = 0;
+};
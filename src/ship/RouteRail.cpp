@@ -0,0 +1,105 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "RouteRail.h"
+
+#include "Frame.h"
+#include "Ship.h"
+#include "ShipType.h"
+
+#include <algorithm>
+
+const double RouteRail::END_DISTANCE = 5e8;
+
+// shorter flights are left to the autopilot
+static const double MIN_ROUTE_LENGTH = 2.0 * RouteRail::END_DISTANCE;
+
+extern int CheckCollision(DynamicBody *dBody, const vector3d &pathdir, double pathdist, double tlen, double endvel, double r);
+extern double MaxEffectRad(const Body *body, Propulsion *prop);
+
+static PrecalcPath MakePath(const Ship *ship, double length, double startVel)
+{
+	const ShipType *st = ship->GetShipType();
+	const shipstats_t &ss = ship->GetStats();
+	return PrecalcPath(
+		length,
+		startVel,
+		st->effectiveExhaustVelocity,
+		st->linThrust[THRUSTER_FORWARD],
+		st->linAccelerationCap[THRUSTER_FORWARD],
+		1000 * (ss.static_mass + ss.fuel_tank_mass_left),
+		1000 * ss.fuel_tank_mass_left * 0.8, // keep a fuel reserve, as the autopilot does
+		0.85);								 // braking margin
+}
+
+static double StartSpeed(const Ship *ship, const RouteRail::Target &target, const vector3d &dir)
+{
+	const vector3d relVel = ship->GetVelocity() - target.GetVelocityRelTo(ship->GetFrame());
+	return std::max(relVel.Dot(dir), 0.0);
+}
+
+vector3d RouteRail::Target::GetPositionRelTo(FrameId relTo) const
+{
+	if (body) return body->GetPositionRelTo(relTo);
+
+	const Frame *f = Frame::GetFrame(frame);
+	return f->GetOrientRelTo(relTo) * offset + f->GetPositionRelTo(relTo);
+}
+
+vector3d RouteRail::Target::GetVelocityRelTo(FrameId relTo) const
+{
+	if (body) return body->GetVelocityRelTo(relTo);
+
+	// a point in a rotating frame moves with it, as in the autopilot
+	const Frame *f = Frame::GetFrame(frame);
+	const vector3d vel = (frame != relTo && f->IsRotFrame()) ? -f->GetStasisVelocity(offset) : vector3d(0.0);
+	return f->GetOrientRelTo(relTo) * vel + f->GetVelocityRelTo(relTo);
+}
+
+bool RouteRail::CanStart(Ship *ship, const Target &target)
+{
+	const vector3d targpos = target.GetPositionRelTo(ship->GetFrame());
+	const vector3d route = targpos - ship->GetPosition();
+	const double length = route.Length();
+	if (length < MIN_ROUTE_LENGTH)
+		return false;
+
+	Body *body = Frame::GetFrame(ship->GetFrame())->GetBody();
+	const double erad = MaxEffectRad(body, ship->GetPropulsion());
+	return CheckCollision(ship, route / length, length, targpos.Length(), 0, erad) == 0;
+}
+
+RouteRail::RouteRail(const Ship *ship, const Target &target, double startTime) :
+	m_target(target),
+	m_startFrame(ship->GetFrame()),
+	m_dir((target.GetPositionRelTo(m_startFrame) - ship->GetPosition()).Normalized()),
+	m_length((target.GetPositionRelTo(m_startFrame) - ship->GetPosition()).Length()),
+	m_path(MakePath(ship, m_length, StartSpeed(ship, target, m_dir))),
+	m_startTime(startTime)
+{
+	// the rail ends END_DISTANCE short of the target
+	m_path.setDist(std::max(m_length - END_DISTANCE, 0.0));
+	m_endTime = m_startTime + m_path.getFullTime() - m_path.getEstimate();
+	m_path.setTime(0.0);
+
+	m_staticMass = ship->GetStats().static_mass;
+	m_fuelTankMass = ship->GetShipType()->fuelTankMass;
+}
+
+bool RouteRail::GetState(double time, FrameId frameId, vector3d &pos, vector3d &vel)
+{
+	m_path.setTime(time - m_startTime);
+	const double remaining = m_length - m_path.getDist();
+	if (remaining < END_DISTANCE)
+		return false;
+
+	const vector3d dir = Frame::GetFrame(m_startFrame)->GetOrientRelTo(frameId) * m_dir;
+	pos = m_target.GetPositionRelTo(frameId) - dir * remaining;
+	vel = m_target.GetVelocityRelTo(frameId) + dir * m_path.getVel();
+	return true;
+}
+
+double RouteRail::GetFuel() const
+{
+	return (0.001 * m_path.getMass() - m_staticMass) / m_fuelTankMass;
+}
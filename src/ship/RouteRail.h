@@ -0,0 +1,66 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#pragma once
+
+#include "FrameId.h"
+#include "ship/PrecalcPath.h"
+#include "vector3.h"
+
+class Body;
+class Ship;
+
+// Analytic flight of a distant autopiloted ship towards its target.
+//
+// While nobody is near enough to watch, a ship flying straight at its
+// target follows the PrecalcPath profile of the flight, as used by
+// Space.PutShipOnRoute, instead of being steered by its autopilot. The
+// path runs along the line to the target as it was when the rail started,
+// carried along with the target's motion, and the rail ends short of the
+// target so that the autopilot flies the approach itself.
+//
+// The target is either a body or a point fixed in a frame, such as the
+// approach to a ground station.
+class RouteRail {
+public:
+	struct Target {
+		const Body *body = nullptr; // or else a point in frame
+		FrameId frame;
+		vector3d offset = vector3d(0.0);
+
+		vector3d GetPositionRelTo(FrameId relTo) const;
+		vector3d GetVelocityRelTo(FrameId relTo) const;
+	};
+
+	// the rail stops this far from the target
+	static const double END_DISTANCE;
+
+	// true if the ship can fly to the target on a rail from where it is now
+	static bool CanStart(Ship *ship, const Target &target);
+
+	RouteRail(const Ship *ship, const Target &target, double startTime);
+
+	// the target body, null for a point in a frame
+	const Body *GetTarget() const { return m_target.body; }
+
+	// the ship's position and velocity in frame at time; false once the
+	// rail has ended
+	bool GetState(double time, FrameId frame, vector3d &pos, vector3d &vel);
+
+	// fuel left at the last GetState(), as a fraction of the ship's tank
+	double GetFuel() const;
+
+	// game time at which GetState() starts returning false
+	double GetEndTime() const { return m_endTime; }
+
+private:
+	Target m_target;
+	FrameId m_startFrame;
+	vector3d m_dir; // in the start frame
+	double m_length;
+	PrecalcPath m_path;
+	double m_startTime;
+	double m_endTime;
+	double m_staticMass;   // tonnes
+	double m_fuelTankMass; // tonnes
+};
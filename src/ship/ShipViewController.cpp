@@ -72,6 +72,7 @@ ShipViewController::ShipViewController(WorldView *v) :
 	m_camType(CAM_INTERNAL),
 	headtracker_input_priority(false),
 	m_mouseActive(false),
+	m_isActive(false),
 	InputBindings(Pi::input)
 {
 	InputBindings.RegisterBindings();
@@ -124,6 +125,7 @@ void ShipViewController::Init()
 
 void ShipViewController::Activated()
 {
+	m_isActive = true;
 	Pi::input->AddInputFrame(&InputBindings);
 
 	m_onMouseWheelCon =
@@ -135,6 +137,7 @@ void ShipViewController::Activated()
 
 void ShipViewController::Deactivated()
 {
+	m_isActive = false;
 	Pi::player->SetFlag(Body::FLAG_DRAW_EXCLUDE, false);
 	Pi::input->RemoveInputFrame(&InputBindings);
 
@@ -186,6 +189,11 @@ bool ShipViewController::IsExteriorView() const
 	return m_camType != CAM_INTERNAL;
 }
 
+bool ShipViewController::IsCockpitVisible() const
+{
+	return m_isActive && m_camType == CAM_INTERNAL && m_internalCameraController->GetMode() == InternalCameraController::MODE_FRONT;
+}
+
 void ShipViewController::ChangeInternalCameraMode(InternalCameraController::Mode m)
 {
 	if (m_internalCameraController->GetMode() != m)
@@ -298,7 +306,7 @@ void ShipViewController::Draw(Camera *camera)
 {
 	// Render cockpit
 	// XXX camera should rotate inside cockpit, not rotate the cockpit around in the world
-	if (!IsExteriorView() && Pi::player->GetCockpit() && m_internalCameraController->GetMode() == InternalCameraController::MODE_FRONT)
+	if (IsCockpitVisible() && Pi::player->GetCockpit())
 		Pi::player->GetCockpit()->RenderCockpit(Pi::renderer, camera, camera->GetContext()->GetTempFrame());
 }
 
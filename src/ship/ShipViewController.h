@@ -34,6 +34,9 @@ public:
 
 	// returns true if the active camera is an exterior view.
 	bool IsExteriorView() const;
+	// returns true if the cockpit is on screen, i.e. this controller is
+	// active and the internal camera looks forward.
+	bool IsCockpitVisible() const;
 
 	sigc::signal<void> onChangeCamType;
 
@@ -57,6 +60,7 @@ private:
 
 	bool headtracker_input_priority;
 	bool m_mouseActive;
+	bool m_isActive;
 
 	void MouseWheel(bool up);
 
@@ -0,0 +1,142 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _MIXKERNELS_H
+#define _MIXKERNELS_H
+
+#include <cstdint>
+
+// Mixing kernels for the audio callback, working on blocks of samples with a
+// linear volume ramp across each block.
+//
+// As with the ray kernels, SSE2 and NEON are selected at compile time and
+// other targets use a scalar fallback that does the same arithmetic per lane.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIXKERNELS_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define MIXKERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace MixKernels {
+
+	// Source samples for output frames j and j + 1 (j even), as L, R, L, R
+	template <int T_channels, int T_upsample>
+	inline void GatherFrames(const int16_t *in, uint32_t j, float *lanes)
+	{
+		if (T_upsample == 1) {
+			if (T_channels == 2) {
+				lanes[0] = in[2 * j], lanes[1] = in[2 * j + 1];
+				lanes[2] = in[2 * j + 2], lanes[3] = in[2 * j + 3];
+			} else {
+				lanes[0] = lanes[1] = in[j];
+				lanes[2] = lanes[3] = in[j + 1];
+			}
+		} else {
+			// both output frames come from source frame j / 2
+			if (T_channels == 2) {
+				lanes[0] = lanes[2] = in[j];
+				lanes[1] = lanes[3] = in[j + 1];
+			} else {
+				lanes[0] = lanes[1] = lanes[2] = lanes[3] = in[j / 2];
+			}
+		}
+	}
+
+	// Adds frames of mono or stereo 16-bit source, each written T_upsample
+	// times, to interleaved stereo out. The gains start at gainL/gainR and
+	// change by stepL/stepR per output frame.
+	template <int T_channels, int T_upsample>
+	inline void Mix(float *out, const int16_t *in, uint32_t frames, float gainL, float gainR, float stepL, float stepR)
+	{
+		const uint32_t outFrames = frames * T_upsample;
+		uint32_t j = 0;
+		alignas(16) float lanes[4];
+
+#if defined(MIXKERNELS_SSE2)
+		__m128 gain = _mm_setr_ps(gainL, gainR, gainL + stepL, gainR + stepR);
+		const __m128 gainStep = _mm_setr_ps(2.f * stepL, 2.f * stepR, 2.f * stepL, 2.f * stepR);
+		for (; j + 2 <= outFrames; j += 2) {
+			__m128 samples;
+			if (T_channels == 2 && T_upsample == 1) {
+				// sign extend four samples straight to float
+				__m128i s = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(in + 2 * j));
+				samples = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16));
+			} else {
+				GatherFrames<T_channels, T_upsample>(in, j, lanes);
+				samples = _mm_load_ps(lanes);
+			}
+			_mm_storeu_ps(out + 2 * j, _mm_add_ps(_mm_loadu_ps(out + 2 * j), _mm_mul_ps(samples, gain)));
+			gain = _mm_add_ps(gain, gainStep);
+		}
+		_mm_store_ps(lanes, gain);
+		gainL = lanes[0], gainR = lanes[1];
+#elif defined(MIXKERNELS_NEON)
+		float32x4_t gain = { gainL, gainR, gainL + stepL, gainR + stepR };
+		const float32x4_t gainStep = { 2.f * stepL, 2.f * stepR, 2.f * stepL, 2.f * stepR };
+		for (; j + 2 <= outFrames; j += 2) {
+			float32x4_t samples;
+			if (T_channels == 2 && T_upsample == 1) {
+				samples = vcvtq_f32_s32(vmovl_s16(vld1_s16(in + 2 * j)));
+			} else {
+				GatherFrames<T_channels, T_upsample>(in, j, lanes);
+				samples = vld1q_f32(lanes);
+			}
+			vst1q_f32(out + 2 * j, vmlaq_f32(vld1q_f32(out + 2 * j), samples, gain));
+			gain = vaddq_f32(gain, gainStep);
+		}
+		gainL = vgetq_lane_f32(gain, 0), gainR = vgetq_lane_f32(gain, 1);
+#else
+		float gain[4] = { gainL, gainR, gainL + stepL, gainR + stepR };
+		const float gainStep[4] = { 2.f * stepL, 2.f * stepR, 2.f * stepL, 2.f * stepR };
+		for (; j + 2 <= outFrames; j += 2) {
+			GatherFrames<T_channels, T_upsample>(in, j, lanes);
+			for (int lane = 0; lane < 4; lane++) {
+				out[2 * j + lane] += lanes[lane] * gain[lane];
+				gain[lane] += gainStep[lane];
+			}
+		}
+		gainL = gain[0], gainR = gain[1];
+#endif
+
+		// an odd frame left over, only possible without upsampling
+		if (j < outFrames) {
+			const float left = in[T_channels * j];
+			const float right = in[T_channels * j + T_channels - 1];
+			out[2 * j] += left * gainL;
+			out[2 * j + 1] += right * gainR;
+		}
+	}
+
+	// Scales count samples by gain and converts them to 16 bit, clamping to
+	// range and truncating towards zero
+	inline void ToS16(int16_t *out, const float *in, uint32_t count, float gain)
+	{
+		uint32_t i = 0;
+
+#if defined(MIXKERNELS_SSE2)
+		const __m128 g = _mm_set1_ps(gain);
+		const __m128 lo = _mm_set1_ps(-32768.f), hi = _mm_set1_ps(32767.f);
+		for (; i + 8 <= count; i += 8) {
+			const __m128 a = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(in + i), g), lo), hi);
+			const __m128 b = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(in + i + 4), g), lo), hi);
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_packs_epi32(_mm_cvttps_epi32(a), _mm_cvttps_epi32(b)));
+		}
+#elif defined(MIXKERNELS_NEON)
+		const float32x4_t lo = vdupq_n_f32(-32768.f), hi = vdupq_n_f32(32767.f);
+		for (; i + 4 <= count; i += 4) {
+			const float32x4_t a = vminq_f32(vmaxq_f32(vmulq_n_f32(vld1q_f32(in + i), gain), lo), hi);
+			vst1_s16(out + i, vqmovn_s32(vcvtq_s32_f32(a)));
+		}
+#endif
+
+		for (; i < count; i++) {
+			const float val = in[i] * gain;
+			out[i] = int16_t(val < -32768.f ? -32768.f : (val > 32767.f ? 32767.f : val));
+		}
+	}
+
+} // namespace MixKernels
+
+#endif
@@ -10,7 +10,9 @@
 #include "FileSystem.h"
 #include "JobQueue.h"
 #include "Pi.h"
+#include "MixKernels.h"
 #include "Player.h"
+#include "core/MemoryStats.h"
 #include "utils.h"
 
 #include "SDL_audio.h"
@@ -18,10 +20,17 @@
 #include <SDL.h>
 #include <vorbis/vorbisfile.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cerrno>
+#include <chrono>
+#include <condition_variable>
 #include <cstdio>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace Sound {
@@ -29,7 +38,14 @@ namespace Sound {
 	static const unsigned int FREQ = 44100;
 	static const unsigned int BUF_SIZE = 4096;
 	static const unsigned int MAX_WAVSTREAMS = 10; //first two are for music
+	// source frames mixed per volume ramp step
+	static const Uint32 MIX_BLOCK_FRAMES = 64;
 	static const double STREAM_IF_LONGER_THAN = 10.0;
+	// decoded samples buffered per stream, about 1.5s of 44.1kHz stereo
+	static const Uint32 STREAM_RING_SIZE = 1 << 17;
+	// the decoder tops streams up once they have this many samples free
+	static const Uint32 STREAM_DECODE_CHUNK = BUF_SIZE * 2;
+	static const std::chrono::milliseconds STREAM_DECODE_INTERVAL(20);
 
 	static SDL_AudioDeviceID m_audioDevice = 0;
 
@@ -126,6 +142,207 @@ namespace Sound {
 		&OggFileDataStream::ov_callback_tell
 	};
 
+	/*
+	 * Samples too long to keep decoded are streamed. The decoder thread opens
+	 * and decodes them ahead of the audio callback, which only copies from the
+	 * ring buffer, so neither file reads nor vorbis decoding happen while the
+	 * audio device is locked.
+	 */
+	class OggStream {
+	public:
+		explicit OggStream(const Sample *sample, bool repeat) :
+			repeat(repeat),
+			cancelled(false),
+			m_sample(sample),
+			m_ring(STREAM_RING_SIZE),
+			m_readPos(0),
+			m_writePos(0),
+			m_isOpen(false),
+			m_failed(false),
+			m_atEnd(false)
+		{
+			MemoryStats::Add(MemoryStats::TAG_AUDIO, m_ring.size() * sizeof(Sint16));
+		}
+
+		~OggStream()
+		{
+			if (m_isOpen)
+				ov_clear(&m_oggv);
+			MemoryStats::Sub(MemoryStats::TAG_AUDIO, m_ring.size() * sizeof(Sint16));
+		}
+
+		// Decoder thread: fills the ring buffer as far as it will go
+		void Decode()
+		{
+			if (!m_isOpen && (m_failed || !Open())) {
+				m_failed = true;
+				m_atEnd = true;
+				return;
+			}
+
+			bool rewound = false;
+			for (;;) {
+				const Uint32 writePos = m_writePos.load(std::memory_order_relaxed);
+				const Uint32 free = STREAM_RING_SIZE - (writePos - m_readPos.load(std::memory_order_acquire));
+				if (free < STREAM_DECODE_CHUNK)
+					return;
+
+				if (m_atEnd) {
+					// the event may have been set to repeat since we got here
+					if (!repeat.load(std::memory_order_relaxed) || rewound)
+						return;
+					ov_pcm_seek(&m_oggv, 0);
+					m_atEnd = false;
+					rewound = true;
+				}
+
+				// ov_read only returns whole frames, so the ring never splits one
+				const Uint32 idx = writePos & (STREAM_RING_SIZE - 1);
+				const Uint32 wanted = std::min(free, STREAM_RING_SIZE - idx);
+				int section;
+				const long amt = ov_read(&m_oggv, reinterpret_cast<char *>(&m_ring[idx]), wanted * sizeof(Sint16), 0, 2, 1, &section);
+				if (amt <= 0) {
+					m_atEnd = true;
+					continue;
+				}
+
+				rewound = false;
+				m_writePos.store(writePos + Uint32(amt / sizeof(Sint16)), std::memory_order_release);
+			}
+		}
+
+		// Audio thread: copies up to count decoded samples to out
+		Uint32 Read(Sint16 *out, Uint32 count)
+		{
+			const Uint32 readPos = m_readPos.load(std::memory_order_relaxed);
+			count = std::min(count, m_writePos.load(std::memory_order_acquire) - readPos);
+			for (Uint32 i = 0; i < count; i++)
+				out[i] = m_ring[(readPos + i) & (STREAM_RING_SIZE - 1)];
+			m_readPos.store(readPos + count, std::memory_order_release);
+			return count;
+		}
+
+		// true once everything has been decoded (or it couldn't be)
+		bool AtEnd() const { return m_atEnd.load(std::memory_order_acquire); }
+		// true if the file couldn't be opened, so it won't ever play
+		bool Failed() const { return m_failed.load(std::memory_order_acquire); }
+
+		std::atomic<bool> repeat;
+		std::atomic<bool> cancelled;
+
+	private:
+		bool Open()
+		{
+			RefCountedPtr<FileSystem::FileData> oggdata = FileSystem::gameDataFiles.ReadFile(m_sample->path);
+			if (!oggdata) {
+				Output("Could not open '%s'\n", m_sample->path.c_str());
+				return false;
+			}
+			m_dataStream.Reset(oggdata);
+			if (ov_open_callbacks(&m_dataStream, &m_oggv, 0, 0, OggFileDataStream::CALLBACKS) < 0) {
+				Output("Vorbis could not understand '%s'\n", m_sample->path.c_str());
+				m_dataStream.Reset();
+				return false;
+			}
+			m_isOpen = true;
+			return true;
+		}
+
+		const Sample *m_sample;
+		std::vector<Sint16> m_ring;
+		std::atomic<Uint32> m_readPos;
+		std::atomic<Uint32> m_writePos;
+
+		OggFileDataStream m_dataStream;
+		OggVorbis_File m_oggv;
+		bool m_isOpen;
+		std::atomic<bool> m_failed;
+		std::atomic<bool> m_atEnd;
+	};
+
+	namespace {
+		std::thread s_decoderThread;
+		std::mutex s_decoderLock;
+		std::condition_variable s_decoderWake;
+		bool s_decoderQuit = false;
+		std::vector<std::shared_ptr<OggStream>> s_streams;
+
+		std::atomic<Uint32> s_numStreams(0);
+		std::atomic<float> s_streamDecodeMs(0.f);
+		std::atomic<Uint64> s_loadDecodeTicks(0);
+
+		void RunDecoder()
+		{
+			Uint64 decodeTicks = 0;
+			Uint64 windowStart = SDL_GetPerformanceCounter();
+			std::vector<std::shared_ptr<OggStream>> streams;
+
+			std::unique_lock<std::mutex> lock(s_decoderLock);
+			while (!s_decoderQuit) {
+				// streams whose events have gone are freed here, not in the callback
+				s_streams.erase(std::remove_if(s_streams.begin(), s_streams.end(), [](const std::shared_ptr<OggStream> &stream) {
+					return stream->cancelled.load(std::memory_order_relaxed);
+				}),
+					s_streams.end());
+				streams = s_streams;
+				s_numStreams.store(Uint32(streams.size()), std::memory_order_relaxed);
+				lock.unlock();
+
+				const Uint64 startTicks = SDL_GetPerformanceCounter();
+				for (const std::shared_ptr<OggStream> &stream : streams) {
+					if (!stream->cancelled.load(std::memory_order_relaxed))
+						stream->Decode();
+				}
+				streams.clear();
+
+				const Uint64 endTicks = SDL_GetPerformanceCounter();
+				decodeTicks += endTicks - startTicks;
+				if (endTicks - windowStart >= SDL_GetPerformanceFrequency()) {
+					s_streamDecodeMs.store(float(decodeTicks * 1000.0 / double(endTicks - windowStart)), std::memory_order_relaxed);
+					decodeTicks = 0;
+					windowStart = endTicks;
+				}
+
+				lock.lock();
+				if (!s_decoderQuit)
+					s_decoderWake.wait_for(lock, STREAM_DECODE_INTERVAL);
+			}
+		}
+
+		void StartDecoder()
+		{
+			if (s_decoderThread.joinable())
+				return;
+			s_decoderQuit = false;
+			s_decoderThread = std::thread(&RunDecoder);
+		}
+
+		void StopDecoder()
+		{
+			if (!s_decoderThread.joinable())
+				return;
+			{
+				std::lock_guard<std::mutex> lock(s_decoderLock);
+				s_decoderQuit = true;
+			}
+			s_decoderWake.notify_one();
+			s_decoderThread.join();
+			s_streams.clear();
+			s_numStreams.store(0, std::memory_order_relaxed);
+		}
+
+		std::shared_ptr<OggStream> StartStream(const Sample *sample, bool repeat)
+		{
+			std::shared_ptr<OggStream> stream = std::make_shared<OggStream>(sample, repeat);
+			{
+				std::lock_guard<std::mutex> lock(s_decoderLock);
+				s_streams.push_back(stream);
+			}
+			s_decoderWake.notify_one();
+			return stream;
+		}
+	} // namespace
+
 	static float m_masterVol = 1.0f;
 	static float m_sfxVol = 1.0f;
 
@@ -181,8 +398,7 @@ namespace Sound {
 
 	struct SoundEvent {
 		const Sample *sample;
-		OggVorbis_File *oggv; // if sample->buf = 0 then stream this
-		OggFileDataStream ogg_data_stream;
+		std::shared_ptr<OggStream> stream; // if sample->buf = 0 then stream this
 		Uint32 buf_pos;
 		float volume[2]; // left and right channels
 		eventid identifier;
@@ -223,6 +439,8 @@ namespace Sound {
 		SoundEvent *se = GetEvent(id);
 		if (se) {
 			se->op = op;
+			if (se->stream)
+				se->stream->repeat = (op & OP_REPEAT);
 			ret = true;
 		}
 		SDL_UnlockAudioDevice(m_audioDevice);
@@ -231,12 +449,10 @@ namespace Sound {
 
 	static void DestroyEvent(SoundEvent *ev)
 	{
-		if (ev->oggv) {
-			// streaming ogg
-			ov_clear(ev->oggv);
-			delete ev->oggv;
-			ev->oggv = 0;
-			ev->ogg_data_stream.Reset();
+		if (ev->stream) {
+			// the decoder thread lets go of it
+			ev->stream->cancelled = true;
+			ev->stream.reset();
 		}
 		ev->sample = nullptr;
 	}
@@ -249,25 +465,31 @@ namespace Sound {
 	{
 		SDL_LockAudioDevice(m_audioDevice);
 		unsigned int idx;
-		Uint32 age;
 		/* find free wavstream (first two reserved for music) */
 		for (idx = 2; idx < MAX_WAVSTREAMS; idx++) {
 			if (!wavstream[idx].sample) break;
 		}
 		if (idx == MAX_WAVSTREAMS) {
-			/* otherwise overwrite oldest one */
-			age = 0;
+			/* otherwise steal the quietest voice, the oldest of equally quiet
+			   ones, or drop this sound if it would be quieter still */
+			float priority = std::max(volume_left, volume_right) * GetSfxVolume();
 			idx = 0;
 			for (unsigned int i = 2; i < MAX_WAVSTREAMS; i++) {
-				if ((i == 0) || (wavstream[i].buf_pos > age)) {
+				const float voicePriority = std::max(wavstream[i].targetVolume[0], wavstream[i].targetVolume[1]);
+				if (voicePriority < priority || (voicePriority == priority && (idx == 0 || wavstream[i].buf_pos > wavstream[idx].buf_pos))) {
 					idx = i;
-					age = wavstream[i].buf_pos;
+					priority = voicePriority;
 				}
 			}
+			if (idx == 0) {
+				SDL_UnlockAudioDevice(m_audioDevice);
+				return 0;
+			}
 			DestroyEvent(&wavstream[idx]);
 		}
 		wavstream[idx].sample = GetSample(fx);
-		wavstream[idx].oggv = 0;
+		if (wavstream[idx].sample && !wavstream[idx].sample->buf)
+			wavstream[idx].stream = StartStream(wavstream[idx].sample, op & OP_REPEAT);
 		wavstream[idx].buf_pos = 0;
 		wavstream[idx].volume[0] = volume_left * GetSfxVolume();
 		wavstream[idx].volume[1] = volume_right * GetSfxVolume();
@@ -291,7 +513,8 @@ namespace Sound {
 		if (wavstream[idx].sample)
 			DestroyEvent(&wavstream[idx]);
 		wavstream[idx].sample = GetSample(fx);
-		wavstream[idx].oggv = nullptr;
+		if (wavstream[idx].sample && !wavstream[idx].sample->buf)
+			wavstream[idx].stream = StartStream(wavstream[idx].sample, op & OP_REPEAT);
 		wavstream[idx].buf_pos = 0;
 		wavstream[idx].volume[0] = volume_left;
 		wavstream[idx].volume[1] = volume_right;
@@ -315,98 +538,68 @@ namespace Sound {
 		// hm pity to put this here ^^ since not used by ev.sample->buf case
 		SoundEvent &ev = wavstream[stream_num];
 		int inbuf_pos = 0;
+		int inbuf_len = 0;
 		int pos = 0;
 		while ((pos < len) && ev.sample) {
 			if (ev.sample->buf) {
 				// already decoded
 				inbuf = reinterpret_cast<Sint16 *>(ev.sample->buf);
 				inbuf_pos = ev.buf_pos;
+				inbuf_len = ev.sample->buf_len;
 			} else {
-				// stream ogg vorbis
-				// ogg vorbis streaming
-				if (!ev.oggv) {
-					// open file to start streaming
-					ev.oggv = new OggVorbis_File;
-					RefCountedPtr<FileSystem::FileData> oggdata = FileSystem::gameDataFiles.ReadFile(ev.sample->path);
-					if (!oggdata) {
-						Output("Could not open '%s'", ev.sample->path.c_str());
-						ev.sample = nullptr;
-						return;
-					}
-					ev.ogg_data_stream.Reset(oggdata);
-					oggdata.Reset();
-					if (ov_open_callbacks(&ev.ogg_data_stream, ev.oggv, 0, 0, OggFileDataStream::CALLBACKS) < 0) {
-						Output("Vorbis could not understand '%s'", ev.sample->path.c_str());
-						ev.sample = nullptr;
-						return;
-					}
-				}
-				int i = 0;
+				// streamed, take whatever the decoder thread has ready.
 				// (len-pos) = num floats the destination buffer wants.
-				// if we are stereo then to fill this we need (len-pos)*2 bytes
-				// if we are mono we want (len-pos) bytes
-				int wanted_bytes = (len - pos) * T_channels / T_upsample;
-				for (;;) {
-					int music_section;
-					if (wanted_bytes == 0) break;
-					int amt = ov_read(ev.oggv, reinterpret_cast<char *>(inbuf) + i,
-						wanted_bytes, 0, 2, 1, &music_section);
-					i += amt;
-					wanted_bytes -= amt;
-					if (amt == 0) break;
+				// if we are stereo then to fill this we need (len-pos) samples
+				// if we are mono we want (len-pos)/2 samples
+				const Uint32 wanted = (len - pos) * T_channels / (2 * T_upsample);
+				inbuf_pos = 0;
+				inbuf_len = ev.stream->Read(inbuf, wanted);
+				if (inbuf_len == 0) {
+					if (ev.stream->AtEnd() && (!(ev.op & OP_REPEAT) || ev.stream->Failed()))
+						DestroyEvent(&ev);
+					// otherwise the decoder is behind; play silence until it catches up
+					break;
 				}
 			}
 
-			while (pos < len) {
-				/* Volume animations */
+			while (pos < len && inbuf_pos < inbuf_len) {
+				// mix up to a block, stopping at the end of the input, the output or the sample
+				const Uint32 frames = std::min({ Uint32(inbuf_len - inbuf_pos) / T_channels,
+					Uint32(len - pos) / (2 * T_upsample),
+					(ev.sample->buf_len - ev.buf_pos) / T_channels,
+					MIX_BLOCK_FRAMES });
+				if (frames == 0)
+					break;
+
+				/* Volume animations, ramped linearly across the block */
+				float start[2], step[2];
 				for (int chan = 0; chan < 2; chan++) {
+					const float change = ev.rateOfChange[chan] * frames;
+					start[chan] = ev.volume[chan];
 					if (ev.ascend[chan]) {
-						ev.volume[chan] = std::min(ev.volume[chan] + ev.rateOfChange[chan], ev.targetVolume[chan]);
+						ev.volume[chan] = std::min(ev.volume[chan] + change, ev.targetVolume[chan]);
 					} else {
-						ev.volume[chan] = std::max(ev.volume[chan] - ev.rateOfChange[chan], ev.targetVolume[chan]);
+						ev.volume[chan] = std::max(ev.volume[chan] - change, ev.targetVolume[chan]);
 					}
+					step[chan] = (ev.volume[chan] - start[chan]) / float(frames * T_upsample);
 				}
 
-				float s0, s1;
-
-				if (T_channels == 1) {
-					s0 = float(inbuf[inbuf_pos++]);
-					s1 = ev.volume[1] * s0;
-					s0 = ev.volume[0] * s0;
-					ev.buf_pos += 1;
-				} else /* stereo */ {
-					s0 = ev.volume[0] * float(inbuf[inbuf_pos++]);
-					s1 = ev.volume[1] * float(inbuf[inbuf_pos++]);
-					ev.buf_pos += 2;
-				}
+				MixKernels::Mix<T_channels, T_upsample>(buffer + pos, inbuf + inbuf_pos, frames, start[0], start[1], step[0], step[1]);
 
-				if (T_upsample == 1) {
-					buffer[pos] += s0;
-					buffer[pos + 1] += s1;
-					pos += 2;
-				} else {
-					buffer[pos] += s0;
-					buffer[pos + 1] += s1;
-					buffer[pos + 2] += s0;
-					buffer[pos + 3] += s1;
-					pos += 4;
-				}
+				inbuf_pos += frames * T_channels;
+				ev.buf_pos += frames * T_channels;
+				pos += frames * 2 * T_upsample;
 
 				/* Repeat or end? */
 				if (ev.buf_pos >= ev.sample->buf_len) {
 					ev.buf_pos = 0;
-					inbuf_pos = 0;
 					if (!(ev.op & OP_REPEAT)) {
 						DestroyEvent(&ev);
 						break;
 					}
-					if (ev.oggv) {
-						// streaming ogg
-						ov_pcm_seek(ev.oggv, 0);
-						// repeat outer loop to decode some
-						// more vorbis from the start of the stream
-						break;
-					}
+					// streams carry on from the decoder's own rewind
+					if (!ev.stream)
+						inbuf_pos = 0;
 				}
 			}
 		}
@@ -456,10 +649,7 @@ namespace Sound {
 		}
 
 		/* Convert float sample buffer to Sint16 samples the hardware likes */
-		for (int pos = 0; pos < len_in_floats; pos++) {
-			const float val = m_masterVol * tmpbuf[pos];
-			(reinterpret_cast<Sint16 *>(dsp_buf))[pos] = Sint16(Clamp(val, -32768.0f, 32767.0f));
-		}
+		MixKernels::ToS16(reinterpret_cast<int16_t *>(dsp_buf), tmpbuf, len_in_floats, m_masterVol);
 	}
 
 	void DestroyAllEvents()
@@ -525,7 +715,9 @@ namespace Sound {
 
 		// immediately decode and store as raw sample if short enough
 		if (seconds < STREAM_IF_LONGER_THAN) {
+			const Uint64 startTicks = SDL_GetPerformanceCounter();
 			sample.buf = new Uint16[sample.buf_len];
+			MemoryStats::Add(MemoryStats::TAG_AUDIO, sample.buf_len * sizeof(Uint16));
 
 			int i = 0;
 			for (;;) {
@@ -535,6 +727,7 @@ namespace Sound {
 				i += amt;
 				if (amt == 0) break;
 			}
+			s_loadDecodeTicks.fetch_add(SDL_GetPerformanceCounter() - startTicks, std::memory_order_relaxed);
 		}
 
 		ov_clear(&oggv);
@@ -604,6 +797,7 @@ namespace Sound {
 		Pi::GetApp()->GetAsyncStartupQueue()->Order(new LoadSoundJob("music", true));
 
 		UpdateAudioDevices();
+		StartDecoder();
 
 		// If we're going to manually pick a device later, don't open a default one now.
 		if (!automaticallyOpenDevice) {
@@ -661,13 +855,19 @@ namespace Sound {
 
 	void Uninit()
 	{
-		if (!m_audioDevice)
+		if (!m_audioDevice) {
+			StopDecoder();
 			return;
+		}
 
 		DestroyAllEvents();
+		StopDecoder();
 		std::map<std::string, Sample>::iterator i;
-		for (i = sfx_samples.begin(); i != sfx_samples.end(); ++i)
+		for (i = sfx_samples.begin(); i != sfx_samples.end(); ++i) {
+			if ((*i).second.buf)
+				MemoryStats::Sub(MemoryStats::TAG_AUDIO, (*i).second.buf_len * sizeof(Uint16));
 			delete[](*i).second.buf;
+		}
 		SDL_CloseAudioDevice(m_audioDevice);
 		m_audioDevice = 0;
 	}
@@ -724,6 +924,8 @@ namespace Sound {
 		SoundEvent *se = GetEvent(eid);
 		if (se) {
 			se->op = op;
+			if (se->stream)
+				se->stream->repeat = (op & OP_REPEAT);
 			ret = true;
 		}
 		SDL_UnlockAudioDevice(m_audioDevice);
@@ -767,4 +969,13 @@ namespace Sound {
 		return sfx_samples;
 	}
 
+	Stats GetStats()
+	{
+		Stats stats;
+		stats.numStreams = s_numStreams.load(std::memory_order_relaxed);
+		stats.streamDecodeMs = s_streamDecodeMs.load(std::memory_order_relaxed);
+		stats.loadDecodeMs = float(s_loadDecodeTicks.load(std::memory_order_relaxed) * 1000.0 / double(SDL_GetPerformanceFrequency()));
+		return stats;
+	}
+
 } /* namespace Sound */
@@ -80,6 +80,13 @@ namespace Sound {
 	float GetSfxVolume();
 	const std::map<std::string, Sample> &GetSamples();
 
+	struct Stats {
+		Uint32 numStreams;	  // samples being decoded as they play
+		float streamDecodeMs; // decoder thread busy time per second
+		float loadDecodeMs;	  // total time spent decoding resident samples
+	};
+	Stats GetStats();
+
 } /* namespace Sound */
 
 #endif /* __OGGMIX_H */
@@ -0,0 +1,247 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "HeightMapTiles.h"
+
+#include "core/LZ4Format.h"
+#include "core/Log.h"
+#include "profiler/Profiler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace {
+	static const uint32_t TILES_MAGIC = 0x544d4850; // "PHMT"
+	static const uint32_t TILES_VERSION = 1;
+	// tiles are packed once and decompressed many times
+	static const int TILES_LZ4_PRESET = 9;
+
+	struct TilesHeader {
+		uint32_t magic;
+		uint32_t version;
+		int32_t width;
+		int32_t height;
+		int32_t tileSize;
+		int32_t bias;
+		double heightScaling;
+		double minHeight;
+	};
+
+	// followed by the tile table, row by row
+	struct TileEntry {
+		uint32_t offset;
+		uint32_t size;
+	};
+
+	int NumTiles(int size, int tileSize)
+	{
+		return (size + tileSize - 1) / tileSize;
+	}
+} // namespace
+
+bool HeightMapTiles::IsTiledFormat(const char *data, size_t length)
+{
+	TilesHeader header;
+	if (length < sizeof(header))
+		return false;
+	memcpy(&header, data, sizeof(header));
+	if (header.magic != TILES_MAGIC || header.version != TILES_VERSION ||
+		header.width <= 0 || header.height <= 0 || header.tileSize <= 0)
+		return false;
+
+	const size_t numTiles = size_t(NumTiles(header.width, header.tileSize)) * NumTiles(header.height, header.tileSize);
+	if (length < sizeof(header) + numTiles * sizeof(TileEntry))
+		return false;
+
+	const char *table = data + sizeof(header);
+	for (size_t i = 0; i < numTiles; i++) {
+		TileEntry entry;
+		memcpy(&entry, table + i * sizeof(TileEntry), sizeof(entry));
+		if (size_t(entry.offset) + entry.size > length)
+			return false;
+	}
+	return true;
+}
+
+std::string HeightMapTiles::Encode(const uint16_t *samples, int width, int height, int32_t bias,
+	double heightScaling, double minHeight, int tileSize)
+{
+	PROFILE_SCOPED()
+	assert(width > 0 && height > 0 && tileSize > 0);
+
+	TilesHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic = TILES_MAGIC;
+	header.version = TILES_VERSION;
+	header.width = width;
+	header.height = height;
+	header.tileSize = tileSize;
+	header.bias = bias;
+	header.heightScaling = heightScaling;
+	header.minHeight = minHeight;
+
+	const int tilesX = NumTiles(width, tileSize), tilesY = NumTiles(height, tileSize);
+	std::vector<TileEntry> table(size_t(tilesX) * tilesY);
+	std::string tiles;
+	std::vector<uint16_t> deltas;
+	for (int ty = 0; ty < tilesY; ty++) {
+		for (int tx = 0; tx < tilesX; tx++) {
+			const int x0 = tx * tileSize, y0 = ty * tileSize;
+			const int w = std::min(tileSize, width - x0), h = std::min(tileSize, height - y0);
+
+			// neighbouring heights are close, so their differences pack far
+			// better than the heights themselves
+			deltas.resize(size_t(w) * h);
+			for (int y = 0; y < h; y++) {
+				const uint16_t *row = samples + size_t(y0 + y) * width + x0;
+				uint16_t *out = &deltas[size_t(y) * w];
+				out[0] = row[0];
+				for (int x = 1; x < w; x++)
+					out[x] = uint16_t(row[x] - row[x - 1]);
+			}
+
+			const std::string packed = lz4::CompressLZ4({ reinterpret_cast<const char *>(deltas.data()), deltas.size() * sizeof(uint16_t) }, TILES_LZ4_PRESET);
+			TileEntry &entry = table[size_t(ty) * tilesX + tx];
+			entry.offset = uint32_t(sizeof(header) + table.size() * sizeof(TileEntry) + tiles.size());
+			entry.size = uint32_t(packed.size());
+			tiles += packed;
+		}
+	}
+
+	std::string data;
+	data.reserve(sizeof(header) + table.size() * sizeof(TileEntry) + tiles.size());
+	data.append(reinterpret_cast<const char *>(&header), sizeof(header));
+	data.append(reinterpret_cast<const char *>(table.data()), table.size() * sizeof(TileEntry));
+	data += tiles;
+	return data;
+}
+
+HeightMapTiles::HeightMapTiles(RefCountedPtr<FileSystem::FileData> file, size_t cacheTiles) :
+	m_file(file),
+	m_data(file->GetData()),
+	m_size(file->GetSize()),
+	m_cacheTiles(std::max<size_t>(cacheTiles, 1))
+{
+	ReadHeader();
+}
+
+HeightMapTiles::HeightMapTiles(std::string data, size_t cacheTiles) :
+	m_buffer(std::move(data)),
+	m_data(m_buffer.data()),
+	m_size(m_buffer.size()),
+	m_cacheTiles(std::max<size_t>(cacheTiles, 1))
+{
+	ReadHeader();
+}
+
+void HeightMapTiles::ReadHeader()
+{
+	assert(IsTiledFormat(m_data, m_size));
+	TilesHeader header;
+	memcpy(&header, m_data, sizeof(header));
+	m_width = header.width;
+	m_height = header.height;
+	m_tileSize = header.tileSize;
+	m_tilesX = NumTiles(m_width, m_tileSize);
+	m_tilesY = NumTiles(m_height, m_tileSize);
+	m_bias = header.bias;
+	m_heightScaling = header.heightScaling;
+	m_minHeight = header.minHeight;
+}
+
+void HeightMapTiles::GetBlock(int x0, int y0, int w, int h, double *out) const
+{
+	// a block nearly always lies in one tile, so only look up on a change
+	int tileIndex = -1;
+	std::shared_ptr<const Tile> tile;
+	int tileW = 0, tileX0 = 0, tileY0 = 0;
+
+	for (int y = 0; y < h; y++) {
+		const int sy = std::clamp(y0 + y, 0, m_height - 1);
+		for (int x = 0; x < w; x++) {
+			const int sx = std::clamp(x0 + x, 0, m_width - 1);
+			const int tx = sx / m_tileSize, ty = sy / m_tileSize;
+			const int index = ty * m_tilesX + tx;
+			if (index != tileIndex) {
+				tileIndex = index;
+				tile = GetTile(index);
+				tileX0 = tx * m_tileSize;
+				tileY0 = ty * m_tileSize;
+				tileW = std::min(m_tileSize, m_width - tileX0);
+			}
+			const uint16_t stored = (*tile)[size_t(sy - tileY0) * tileW + (sx - tileX0)];
+			out[y * w + x] = double(int32_t(stored) - m_bias);
+		}
+	}
+}
+
+size_t HeightMapTiles::GetResidentTiles() const
+{
+	std::lock_guard<std::mutex> lock(m_cacheLock);
+	return m_cache.size();
+}
+
+std::shared_ptr<const HeightMapTiles::Tile> HeightMapTiles::GetTile(int index) const
+{
+	{
+		std::lock_guard<std::mutex> lock(m_cacheLock);
+		auto it = m_cacheIndex.find(index);
+		if (it != m_cacheIndex.end()) {
+			m_cache.splice(m_cache.begin(), m_cache, it->second);
+			return it->second->second;
+		}
+	}
+
+	// decompress outside the lock so other jobs' lookups aren't held up
+	std::shared_ptr<const Tile> tile = DecodeTile(index);
+
+	std::lock_guard<std::mutex> lock(m_cacheLock);
+	auto it = m_cacheIndex.find(index);
+	if (it != m_cacheIndex.end()) {
+		// another job got there first
+		m_cache.splice(m_cache.begin(), m_cache, it->second);
+		return it->second->second;
+	}
+
+	m_cache.emplace_front(index, tile);
+	m_cacheIndex[index] = m_cache.begin();
+	// evicted tiles live on for any job still sampling them
+	while (m_cache.size() > m_cacheTiles) {
+		m_cacheIndex.erase(m_cache.back().first);
+		m_cache.pop_back();
+	}
+	return tile;
+}
+
+std::shared_ptr<const HeightMapTiles::Tile> HeightMapTiles::DecodeTile(int index) const
+{
+	PROFILE_SCOPED()
+	const int tx = index % m_tilesX, ty = index / m_tilesX;
+	const int w = std::min(m_tileSize, m_width - tx * m_tileSize);
+	const int h = std::min(m_tileSize, m_height - ty * m_tileSize);
+	auto tile = std::make_shared<Tile>(size_t(w) * h, uint16_t(m_bias));
+
+	TileEntry entry;
+	memcpy(&entry, m_data + sizeof(TilesHeader) + size_t(index) * sizeof(TileEntry), sizeof(entry));
+
+	std::string deltas;
+	try {
+		deltas = lz4::DecompressLZ4({ m_data + entry.offset, entry.size });
+	} catch (std::runtime_error &e) {
+		Log::Warning("Error decompressing heightmap tile {}: {}\n", index, e.what());
+		return tile;
+	}
+	if (deltas.size() != tile->size() * sizeof(uint16_t)) {
+		Log::Warning("Heightmap tile {} has the wrong size\n", index);
+		return tile;
+	}
+
+	memcpy(tile->data(), deltas.data(), deltas.size());
+	for (int y = 0; y < h; y++) {
+		uint16_t *row = &(*tile)[size_t(y) * w];
+		for (int x = 1; x < w; x++)
+			row[x] = uint16_t(row[x] + row[x - 1]);
+	}
+	return tile;
+}
@@ -0,0 +1,83 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _HEIGHTMAPTILES_H
+#define _HEIGHTMAPTILES_H
+
+#include "../FileSystem.h"
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Tiled, compressed 16-bit heightmap for the heightmapped terrains.
+//
+// The map is cut into square tiles, each stored as its own lz4 frame of
+// row-delta coded samples behind a table of tile offsets. A tile is only
+// decompressed once a sample in it is asked for, and decompressed tiles are
+// kept in a small LRU cache, so only the areas terrain is being generated
+// for are resident. Tiled files read through FileSystem are mapped rather
+// than copied, so the compressed data is paged in on demand as well.
+//
+// Stored samples are unsigned; the height of a sample is its stored value
+// minus the map's bias, which lets signed heightmaps share the format.
+//
+// GetBlock() is called from the patch jobs, so is thread safe.
+class HeightMapTiles {
+public:
+	static const int DEFAULT_TILE_SIZE = 256;
+	static const size_t DEFAULT_CACHE_TILES = 64;
+
+	// Checks for the tiled heightmap header and a tile table that fits in length
+	static bool IsTiledFormat(const char *data, size_t length);
+
+	// Packs a row-major width x height map of stored samples into the tiled
+	// format. heightScaling and minHeight are carried along for the scaled
+	// heightmap fractal.
+	static std::string Encode(const uint16_t *samples, int width, int height, int32_t bias,
+		double heightScaling, double minHeight, int tileSize = DEFAULT_TILE_SIZE);
+
+	// data must have passed IsTiledFormat()
+	explicit HeightMapTiles(RefCountedPtr<FileSystem::FileData> file, size_t cacheTiles = DEFAULT_CACHE_TILES);
+	explicit HeightMapTiles(std::string data, size_t cacheTiles = DEFAULT_CACHE_TILES);
+
+	int GetWidth() const { return m_width; }
+	int GetHeight() const { return m_height; }
+	double GetHeightScaling() const { return m_heightScaling; }
+	double GetMinHeight() const { return m_minHeight; }
+
+	// Fills the row-major w x h block out with the heights from x0, y0 on.
+	// Coordinates outside the map are clamped to its edges.
+	void GetBlock(int x0, int y0, int w, int h, double *out) const;
+
+	size_t GetResidentTiles() const;
+
+private:
+	typedef std::vector<uint16_t> Tile;
+
+	void ReadHeader();
+	std::shared_ptr<const Tile> GetTile(int index) const;
+	std::shared_ptr<const Tile> DecodeTile(int index) const;
+
+	RefCountedPtr<FileSystem::FileData> m_file;
+	std::string m_buffer;
+	const char *m_data;
+	size_t m_size;
+
+	int m_width, m_height;
+	int m_tileSize, m_tilesX, m_tilesY;
+	int32_t m_bias;
+	double m_heightScaling, m_minHeight;
+
+	// most recently used at the front
+	size_t m_cacheTiles;
+	mutable std::mutex m_cacheLock;
+	mutable std::list<std::pair<int, std::shared_ptr<const Tile>>> m_cache;
+	mutable std::unordered_map<int, decltype(m_cache)::iterator> m_cacheIndex;
+};
+
+#endif /* _HEIGHTMAPTILES_H */
@@ -6,12 +6,34 @@
 #include "FileSystem.h"
 #include "FloatComparison.h"
 #include "GameConfig.h"
+#include "HeightMapTiles.h"
 #include "MathUtil.h"
 #include "perlin.h"
 #include "core/macros.h"
+#include "core/FastHash.h"
 #include "core/Log.h"
+#include "profiler/Profiler.h"
 #include "../galaxy/SystemBody.h"
 
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+template <typename HeightFractal>
+void TerrainHeightFractal<HeightFractal>::GetHeights(const vector3d *p, double *heights, size_t count) const
+{
+	// qualified, so the fractal is called directly rather than through the vtable
+	for (size_t i = 0; i < count; i++)
+		heights[i] = TerrainHeightFractal::GetHeight(p[i]);
+}
+
+template <typename ColorFractal>
+void TerrainColorFractal<ColorFractal>::GetColors(const vector3d *p, const double *heights, const vector3d *norms, vector3d *colors, size_t count) const
+{
+	for (size_t i = 0; i < count; i++)
+		colors[i] = TerrainColorFractal::GetColor(p[i], heights[i], norms[i]);
+}
+
 // static instancer. selects the best height and color classes for the body
 Terrain *Terrain::InstanceTerrain(const SystemBody *body)
 {
@@ -371,101 +393,124 @@ static size_t bufread_or_die(void *ptr, size_t size, size_t nmemb, ByteRange &bu
 	return read_count;
 }
 
-// XXX this sucks, but there isn't a reliable cross-platform way to get them
-#ifndef INT16_MIN
-#define INT16_MIN (-32767 - 1)
-#endif
-#ifndef INT16_MAX
-#define INT16_MAX (32767)
-#endif
-#ifndef UINT16_MAX
-#define UINT16_MAX (65535)
-#endif
-
-Terrain::Terrain(const SystemBody *body) :
-	m_seed(body->GetSeed()),
-	m_rand(body->GetSeed()),
-	m_heightScaling(0),
-	m_minh(0),
-	m_minBody(body)
-{
-
-	// load the heightmap
-	if (!body->GetHeightMapFilename().empty()) {
-		RefCountedPtr<FileSystem::FileData> fdata = FileSystem::gameDataFiles.ReadFile(body->GetHeightMapFilename());
-		if (!fdata) {
-			Output("Error: could not open file '%s'\n", body->GetHeightMapFilename().c_str());
-			abort();
-		}
-
-		ByteRange databuf = fdata->AsByteRange();
+namespace {
+	static const char HEIGHTMAP_CACHE_DIR_NAME[] = "heightmap_cache";
 
-		Sint16 minHMap = INT16_MAX, maxHMap = INT16_MIN;
-		Uint16 minHMapScld = UINT16_MAX, maxHMapScld = 0;
+	// Reads a legacy heightmap, a small header followed by every sample, and
+	// packs it into the tiled format
+	std::string ConvertLegacyHeightMap(ByteRange databuf, int fractal)
+	{
+		PROFILE_SCOPED()
+		Uint16 v;
+		int sizeX = 0, sizeY = 0;
+		Sint32 bias = 0;
+		double heightScaling = 0.0, minh = 0.0;
 
 		// XXX unify heightmap types
-		switch (body->GetHeightMapFractal()) {
-		case 0: {
-			Uint16 v;
+		switch (fractal) {
+		case 0:
 			bufread_or_die(&v, 2, 1, databuf);
-			m_heightMapSizeX = v;
+			sizeX = v;
 			bufread_or_die(&v, 2, 1, databuf);
-			m_heightMapSizeY = v;
-			const Uint32 heightmapPixelArea = (m_heightMapSizeX * m_heightMapSizeY);
-
-			std::unique_ptr<Sint16[]> heightMap(new Sint16[heightmapPixelArea]);
-			bufread_or_die(heightMap.get(), sizeof(Sint16), heightmapPixelArea, databuf);
-			m_heightMap.reset(new double[heightmapPixelArea]);
-			double *pHeightMap = m_heightMap.get();
-			for (Uint32 i = 0; i < heightmapPixelArea; i++) {
-				const Sint16 val = heightMap.get()[i];
-				minHMap = std::min(minHMap, val);
-				maxHMap = std::max(maxHMap, val);
-				// store then increment pointer
-				(*pHeightMap) = val;
-				++pHeightMap;
-			}
-			assert(pHeightMap == &m_heightMap[heightmapPixelArea]);
-			//Output("minHMap = (%hd), maxHMap = (%hd)\n", minHMap, maxHMap);
+			sizeY = v;
+			// samples are signed
+			bias = 32768;
 			break;
-		}
 
-		case 1: {
-			Uint16 v;
+		case 1:
 			// XXX x and y reversed from above *sigh*
 			bufread_or_die(&v, 2, 1, databuf);
-			m_heightMapSizeY = v;
+			sizeY = v;
 			bufread_or_die(&v, 2, 1, databuf);
-			m_heightMapSizeX = v;
-			const Uint32 heightmapPixelArea = (m_heightMapSizeX * m_heightMapSizeY);
+			sizeX = v;
 
 			// read height scaling and min height which are doubles
-			double te;
-			bufread_or_die(&te, 8, 1, databuf);
-			m_heightScaling = te;
-			bufread_or_die(&te, 8, 1, databuf);
-			m_minh = te;
-
-			std::unique_ptr<Uint16[]> heightMapScaled(new Uint16[heightmapPixelArea]);
-			bufread_or_die(heightMapScaled.get(), sizeof(Uint16), heightmapPixelArea, databuf);
-			m_heightMap.reset(new double[heightmapPixelArea]);
-			double *pHeightMap = m_heightMap.get();
-			for (Uint32 i = 0; i < heightmapPixelArea; i++) {
-				const Uint16 val = heightMapScaled[i];
-				minHMapScld = std::min(minHMapScld, val);
-				maxHMapScld = std::max(maxHMapScld, val);
-				// store then increment pointer
-				(*pHeightMap) = val;
-				++pHeightMap;
-			}
-			assert(pHeightMap == &m_heightMap[heightmapPixelArea]);
-			//Output("minHMapScld = (%hu), maxHMapScld = (%hu)\n", minHMapScld, maxHMapScld);
+			bufread_or_die(&heightScaling, 8, 1, databuf);
+			bufread_or_die(&minh, 8, 1, databuf);
 			break;
-		}
 
 		default:
 			assert(0);
 		}
+
+		std::vector<Uint16> samples(size_t(sizeX) * sizeY);
+		bufread_or_die(samples.data(), sizeof(Uint16), samples.size(), databuf);
+		if (bias) {
+			for (Uint16 &sample : samples)
+				sample = Uint16(Sint16(sample) + bias);
+		}
+		return HeightMapTiles::Encode(samples.data(), sizeX, sizeY, bias, heightScaling, minh);
+	}
+
+	void SaveHeightMapCache(const std::string &fileName, const std::string &data)
+	{
+		if (!FileSystem::userFiles.MakeDirectory(HEIGHTMAP_CACHE_DIR_NAME))
+			return;
+
+		// write to a file of this thread's own, then move it into place, so
+		// nothing reads a partly written file
+		const std::string tempName = fmt::format("{}.{}.tmp", fileName, std::hash<std::thread::id>()(std::this_thread::get_id()));
+		FILE *f = FileSystem::userFiles.OpenWriteStream(tempName);
+		if (!f)
+			return;
+		const bool written = fwrite(data.data(), data.size(), 1, f) == 1;
+		fclose(f);
+
+		const std::string root = FileSystem::userFiles.GetRoot();
+		const std::string tempPath = FileSystem::JoinPathBelow(root, tempName);
+		const std::string filePath = FileSystem::JoinPathBelow(root, fileName);
+		bool moved = written && std::rename(tempPath.c_str(), filePath.c_str()) == 0;
+		if (written && !moved) {
+			// rename() doesn't replace an existing file everywhere
+			std::remove(filePath.c_str());
+			moved = std::rename(tempPath.c_str(), filePath.c_str()) == 0;
+		}
+		if (!moved)
+			std::remove(tempPath.c_str());
+	}
+
+	// Heightmaps are sampled in the tiled format. Data files already in it
+	// are used as they are; legacy ones are converted on first use and the
+	// result kept in the user directory, keyed by the original's contents.
+	std::unique_ptr<HeightMapTiles> LoadHeightMap(const std::string &fileName, int fractal)
+	{
+		RefCountedPtr<FileSystem::FileData> fdata = FileSystem::gameDataFiles.ReadFile(fileName);
+		if (!fdata) {
+			Output("Error: could not open file '%s'\n", fileName.c_str());
+			abort();
+		}
+
+		if (HeightMapTiles::IsTiledFormat(fdata->GetData(), fdata->GetSize()))
+			return std::make_unique<HeightMapTiles>(fdata);
+
+		const std::string cacheName = FileSystem::JoinPathBelow(HEIGHTMAP_CACHE_DIR_NAME,
+			fmt::format("{:016x}_{}.hmt", FastHash64(fdata->GetData(), fdata->GetSize()), fractal));
+		RefCountedPtr<FileSystem::FileData> cached = FileSystem::userFiles.ReadFile(cacheName);
+		if (cached && HeightMapTiles::IsTiledFormat(cached->GetData(), cached->GetSize()))
+			return std::make_unique<HeightMapTiles>(cached);
+
+		std::string tiles = ConvertLegacyHeightMap(fdata->AsByteRange(), fractal);
+		fdata.Reset();
+		SaveHeightMapCache(cacheName, tiles);
+		return std::make_unique<HeightMapTiles>(std::move(tiles));
+	}
+} // namespace
+
+Terrain::Terrain(const SystemBody *body) :
+	m_seed(body->GetSeed()),
+	m_rand(body->GetSeed()),
+	m_heightScaling(0),
+	m_minh(0),
+	m_minBody(body)
+{
+
+	// load the heightmap
+	if (!body->GetHeightMapFilename().empty()) {
+		m_heightMap = LoadHeightMap(body->GetHeightMapFilename(), body->GetHeightMapFractal());
+		m_heightMapSizeX = m_heightMap->GetWidth();
+		m_heightMapSizeY = m_heightMap->GetHeight();
+		m_heightScaling = m_heightMap->GetHeightScaling();
+		m_minh = m_heightMap->GetMinHeight();
 	}
 
 	m_sealevel = Clamp(body->GetVolatileLiquid(), 0.0, 1.0);
@@ -668,11 +713,12 @@ double Terrain::BiCubicInterpolation(const vector3d &p) const
 	// p0,2 p1,2 p2,2 p3,2
 	// p0,1 p1,1 p2,1 p3,1
 	// p0,0 p1,0 p2,0 p3,0
+	double block[4 * 4];
+	m_heightMap->GetBlock(ix - 1, iy - 1, 4, 4, block);
 	double map[4][4];
-	const double *pHMap = m_heightMap.get();
-	for (int x = -1; x < 3; x++) {
-		for (int y = -1; y < 3; y++) {
-			map[x + 1][y + 1] = pHMap[Clamp(iy + y, 0, m_heightMapSizeY - 1) * m_heightMapSizeX + Clamp(ix + x, 0, m_heightMapSizeX - 1)];
+	for (int x = 0; x < 4; x++) {
+		for (int y = 0; y < 4; y++) {
+			map[x][y] = block[y * 4 + x];
 		}
 	}
 
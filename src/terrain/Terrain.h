@@ -17,6 +17,7 @@
 #pragma warning(disable : 4250) // workaround for MSVC 2008 multiple inheritance bug
 #endif
 
+class HeightMapTiles;
 class SystemBody;
 
 template <typename, typename>
@@ -44,12 +45,17 @@ public:
 	}
 
 	virtual double GetHeight(const vector3d &p) const = 0;
+	// GetHeight() for count points at once
+	virtual void GetHeights(const vector3d *p, double *heights, size_t count) const = 0;
 	virtual vector3d GetColor(const vector3d &p, double height, const vector3d &norm) const = 0;
+	// GetColor() for count points at once
+	virtual void GetColors(const vector3d *p, const double *heights, const vector3d *norms, vector3d *colors, size_t count) const = 0;
 
 	virtual const char *GetHeightFractalName() const = 0;
 	virtual const char *GetColorFractalName() const = 0;
 
 	double GetMaxHeight() const { return m_maxHeight; }
+	Uint32 GetSeed() const { return m_seed; }
 
 	Uint32 GetSurfaceEffects() const { return m_surfaceEffects; }
 
@@ -77,7 +83,7 @@ protected:
 
 	// heightmap stuff
 	// XXX unify heightmap types
-	std::unique_ptr<double[]> m_heightMap;
+	std::unique_ptr<HeightMapTiles> m_heightMap;
 	double m_heightScaling, m_minh;
 
 	int m_heightMapSizeX;
@@ -125,6 +131,9 @@ class TerrainHeightFractal : virtual public Terrain {
 public:
 	TerrainHeightFractal() = delete;
 	virtual double GetHeight(const vector3d &p) const;
+	// defaults to GetHeight() per point; fractals may specialise it with the
+	// batched TerrainNoise functions
+	virtual void GetHeights(const vector3d *p, double *heights, size_t count) const;
 	virtual const char *GetHeightFractalName() const;
 
 protected:
@@ -138,6 +147,8 @@ class TerrainColorFractal : virtual public Terrain {
 public:
 	TerrainColorFractal() = delete;
 	virtual vector3d GetColor(const vector3d &p, double height, const vector3d &norm) const;
+	// GetColor() per point, called directly so it can be inlined for each fractal
+	virtual void GetColors(const vector3d *p, const double *heights, const vector3d *norms, vector3d *colors, size_t count) const;
 	virtual const char *GetColorFractalName() const;
 
 protected:
@@ -253,6 +264,10 @@ class TerrainColorTFGood;
 class TerrainColorTFPoor;
 class TerrainColorVolcanic;
 
+// fractals with a batched GetHeights()
+template <>
+void TerrainHeightFractal<TerrainHeightHillsNormal>::GetHeights(const vector3d *p, double *heights, size_t count) const;
+
 #ifdef _MSC_VER
 #pragma warning(default : 4250)
 #endif
@@ -50,3 +50,67 @@ double TerrainHeightFractal<TerrainHeightHillsNormal>::GetHeight(const vector3d
 	if (n > 0.0) return n * m_maxHeight;
 	return 0.0;
 }
+
+// GetHeight() above, over batches of points. Points under the sea drop out
+// after the continental noise, and the rest go through the remaining
+// octaves together.
+template <>
+void TerrainHeightFractal<TerrainHeightHillsNormal>::GetHeights(const vector3d *p, double *heights, size_t count) const
+{
+	double continents[NOISE_BATCH], distrib[NOISE_BATCH], m[NOISE_BATCH];
+	double persistence[NOISE_BATCH], octaves[NOISE_BATCH];
+	vector3d land[NOISE_BATCH];
+	size_t landIndex[NOISE_BATCH];
+
+	for (size_t start = 0; start < count; start += NOISE_BATCH) {
+		const size_t num = std::min(count - start, NOISE_BATCH);
+		octavenoise(GetFracDef(3), 0.65, &p[start], continents, num);
+
+		size_t numLand = 0;
+		for (size_t i = 0; i < num; i++) {
+			const double c = continents[i] * (1.0 - m_sealevel) - (m_sealevel * 0.1);
+			if (c < 0) {
+				heights[start + i] = 0;
+			} else {
+				land[numLand] = p[start + i];
+				continents[numLand] = c;
+				landIndex[numLand++] = start + i;
+			}
+		}
+		if (!numLand)
+			continue;
+
+		octavenoise(GetFracDef(4), 0.5, land, distrib, numLand);
+		for (size_t i = 0; i < numLand; i++) {
+			distrib[i] *= distrib[i];
+			persistence[i] = 0.55 * distrib[i];
+		}
+		octavenoise(GetFracDef(4), persistence, land, octaves, numLand);
+		for (size_t i = 0; i < numLand; i++)
+			m[i] = 0.5 * GetFracDef(3).amplitude * octaves[i] * GetFracDef(5).amplitude;
+		billow_octavenoise(GetFracDef(5), persistence, land, octaves, numLand);
+		for (size_t i = 0; i < numLand; i++) {
+			m[i] += 0.25 * octaves[i];
+			persistence[i] = 0.6 * (1.0 - distrib[i]);
+		}
+		//hill footings
+		octavenoise(GetFracDef(2), persistence, land, octaves, numLand);
+		for (size_t i = 0; i < numLand; i++) {
+			m[i] -= octaves[i] * Clamp(0.05 - m[i], 0.0, 0.05) * Clamp(0.05 - m[i], 0.0, 0.05);
+			persistence[i] = 0.765 * distrib[i];
+		}
+		//hill footings
+		voronoiscam_octavenoise(GetFracDef(6), persistence, land, octaves, numLand);
+		for (size_t i = 0; i < numLand; i++) {
+			m[i] += octaves[i] * Clamp(0.025 - m[i], 0.0, 0.025) * Clamp(0.025 - m[i], 0.0, 0.025);
+
+			// cliffs at shore
+			double n = continents[i];
+			if (continents[i] < 0.01)
+				n += m[i] * continents[i] * 100.0f;
+			else
+				n += m[i];
+			heights[landIndex[i]] = n > 0.0 ? n * m_maxHeight : 0.0;
+		}
+	}
+}
@@ -5,8 +5,11 @@
 #define _TERRAINNOISE_H
 
 #include "perlin.h"
+#include "FracDef.h"
 #include "MathUtil.h"
 
+#include <algorithm>
+
 namespace TerrainNoise {
 
 	// octavenoise functions return range [0,1] if persistence = 0.5
@@ -169,6 +172,90 @@ namespace TerrainNoise {
 		return sqrt(10.0 * fabs(n));
 	}
 
+	// Batched versions of the fracdef functions above, for Terrain::GetHeights().
+	// Each evaluates count points with the SIMD noise(), and takes either one
+	// persistence for all points or an array of them, one per point.
+
+	// points per noise() call, and the most a batched fractal should stack-allocate
+	static const size_t NOISE_BATCH = 64;
+
+	// sum of octaves, with the persistence of point i at persistence[i * persistenceStride]
+	inline void octave_sum(const fracdef_t &def, int octaves, const double *persistence, size_t persistenceStride,
+		const vector3d *p, double *n, size_t count, bool absolute)
+	{
+		vector3d fp[NOISE_BATCH];
+		double nv[NOISE_BATCH], amplitude[NOISE_BATCH];
+		for (size_t start = 0; start < count; start += NOISE_BATCH) {
+			const size_t num = std::min(count - start, NOISE_BATCH);
+			for (size_t i = 0; i < num; i++) {
+				n[start + i] = 0;
+				amplitude[i] = persistence[(start + i) * persistenceStride];
+			}
+			double frequency = def.frequency;
+			for (int o = 0; o < octaves; o++) {
+				for (size_t i = 0; i < num; i++)
+					fp[i] = frequency * p[start + i];
+				noise(fp, nv, num);
+				for (size_t i = 0; i < num; i++) {
+					n[start + i] += amplitude[i] * (absolute ? fabs(nv[i]) : nv[i]);
+					amplitude[i] *= persistence[(start + i) * persistenceStride];
+				}
+				frequency *= def.lacunarity;
+			}
+		}
+	}
+
+	inline void octavenoise(const fracdef_t &def, const double *persistence, const vector3d *p, double *out, size_t count)
+	{
+		octave_sum(def, def.octaves, persistence, 1, p, out, count, false);
+		for (size_t i = 0; i < count; i++)
+			out[i] = (out[i] + 1.0) * 0.5;
+	}
+
+	inline void river_octavenoise(const fracdef_t &def, const double *persistence, const vector3d *p, double *out, size_t count)
+	{
+		octave_sum(def, def.octaves, persistence, 1, p, out, count, true);
+		for (size_t i = 0; i < count; i++)
+			out[i] = fabs(out[i]);
+	}
+
+	inline void ridged_octavenoise(const fracdef_t &def, const double *persistence, const vector3d *p, double *out, size_t count)
+	{
+		octave_sum(def, def.octaves, persistence, 1, p, out, count, false);
+		for (size_t i = 0; i < count; i++) {
+			const double n = 1.0 - fabs(out[i]);
+			out[i] = n * n;
+		}
+	}
+
+	inline void billow_octavenoise(const fracdef_t &def, const double *persistence, const vector3d *p, double *out, size_t count)
+	{
+		octave_sum(def, def.octaves, persistence, 1, p, out, count, false);
+		for (size_t i = 0; i < count; i++)
+			out[i] = (2.0 * fabs(out[i]) - 1.0) + 1.0;
+	}
+
+	inline void voronoiscam_octavenoise(const fracdef_t &def, const double *persistence, const vector3d *p, double *out, size_t count)
+	{
+		octave_sum(def, def.octaves, persistence, 1, p, out, count, false);
+		for (size_t i = 0; i < count; i++)
+			out[i] = sqrt(10.0 * fabs(out[i]));
+	}
+
+	inline void dunes_octavenoise(const fracdef_t &def, const double *persistence, const vector3d *p, double *out, size_t count)
+	{
+		octave_sum(def, 3, persistence, 1, p, out, count, false);
+		for (size_t i = 0; i < count; i++)
+			out[i] = 1.0 - fabs(out[i]);
+	}
+
+	inline void octavenoise(const fracdef_t &def, const double persistence, const vector3d *p, double *out, size_t count)
+	{
+		octave_sum(def, def.octaves, &persistence, 0, p, out, count, false);
+		for (size_t i = 0; i < count; i++)
+			out[i] = (out[i] + 1.0) * 0.5;
+	}
+
 	// not really a noise function but no better place for it
 	inline vector3d interpolate_color(const double n, const vector3d &start, const vector3d &end)
 	{
@@ -0,0 +1,134 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "StringTable.h"
+
+#include <utility>
+
+StringTable::Data *StringTable::Find(uint32_t key)
+{
+	if (!key)
+		return nullptr;
+
+	uint8_t slot_dist = 0;
+	for (uint32_t idx = key;; idx++, slot_dist++) {
+		idx &= keys.size() - 1;
+
+		uint32_t probed_key = keys[idx];
+		if (probed_key == key)
+			return &values[idx];
+
+		if (!probed_key || dist[idx] < slot_dist)
+			return nullptr;
+	}
+}
+
+StringTable::Data *StringTable::Create(uint32_t key)
+{
+	if (entries > uint32_t(keys.size() * 0.9))
+		Grow();
+
+	uint8_t slot_dist = 0;
+	uint32_t ret = 0;
+	for (uint32_t idx = key;; idx++, slot_dist++) {
+		idx &= keys.size() - 1;
+
+		uint32_t probed_key = keys[idx];
+		if (probed_key == key)
+			return &values[idx];
+
+		if (!probed_key || dist[idx] < slot_dist) {
+			ret = idx;
+			break;
+		}
+	}
+
+	StringTable::Data cached_value = {};
+	for (uint32_t idx = ret;; idx++, slot_dist++) {
+		idx &= keys.size() - 1;
+
+		uint32_t probed_key = keys[idx];
+		if (!probed_key || dist[idx] < slot_dist) {
+			std::swap(keys[idx], key);
+			std::swap(dist[idx], slot_dist);
+			std::swap(values[idx], cached_value);
+			if (!probed_key)
+				break;
+		}
+	}
+
+	entries++;
+	return &values[ret];
+}
+
+void StringTable::Erase(uint32_t key)
+{
+	uint8_t slot_dist = 0;
+	for (uint32_t idx = key;; idx++, slot_dist++) {
+		idx &= keys.size() - 1;
+
+		uint32_t probed_key = keys[idx];
+		if (probed_key == key) {
+			entries--;
+
+			// backshift all following entries
+			for (uint32_t jdx = idx + 1;; idx++, jdx++) {
+				idx &= keys.size() - 1;
+				jdx &= keys.size() - 1;
+
+				// stopcode, no need to continue swapping
+				if (!keys[jdx] || !dist[jdx]) {
+					keys[idx] = 0;
+					dist[idx] = 0;
+					values[idx] = nullptr;
+					return;
+				} else {
+					keys[idx] = keys[jdx];
+					dist[idx] = dist[jdx] - 1;
+					values[idx] = values[jdx];
+				}
+			}
+		}
+
+		if (!probed_key || dist[idx] < slot_dist)
+			return;
+	}
+}
+
+void StringTable::Reclaim(bool force)
+{
+	m_reclaimClock.SoftStop();
+	if (m_reclaimClock.seconds() < 15.0 && !force)
+		return;
+
+	m_reclaimClock.SoftReset();
+	for (uint32_t idx = 0; idx < keys.size(); idx++) {
+		uint32_t probed_key = keys[idx];
+
+		// the refcount can be decremented to zero from another thread,
+		// and it can be incremented on another thread as long as it is >0
+		// but only this thread can increment it from zero
+		if (probed_key && !values[idx]->get_ref()) {
+			Erase(probed_key);
+		}
+	}
+}
+
+void StringTable::Grow()
+{
+	size_t new_size = keys.size() * 2;
+	dist = std::vector<uint8_t>(new_size);
+
+	std::vector<uint32_t> old_keys(new_size);
+	std::swap(keys, old_keys);
+
+	std::vector<Data> old_values(new_size);
+	std::swap(values, old_values);
+
+	for (uint32_t idx = 0; idx < old_keys.size(); idx++) {
+		uint32_t hash = old_keys[idx];
+
+		if (hash)
+			*Create(hash) = old_values[idx];
+	}
+}
@@ -0,0 +1,56 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#pragma once
+
+#include "core/StringName.h"
+#include "profiler/Profiler.h"
+
+#include <cstdint>
+#include <vector>
+
+/*
+ * Hash table of string data keyed by hash alone, from when each thread
+ * interned its own strings. StringPool replaced it behind StringName; it
+ * lives on here as the baseline for the StringName benchmarks.
+ * StringTable uses a power-of-two based robin-hood hash table to keep
+ * indexing overhead as small as possible.
+ */
+class StringTable {
+public:
+	using Data = StringPool::Data *;
+
+	StringTable(uint32_t size) :
+		keys(size),
+		dist(size),
+		values(size),
+		entries(0) {}
+
+	size_t Size() const { return entries; }
+	size_t Capacity() const { return keys.size(); }
+
+	Data *Find(uint32_t key);
+	Data *Create(uint32_t key);
+
+	Data &FindOrCreate(uint32_t key)
+	{
+		if (auto *ptr = Find(key))
+			return *ptr;
+
+		return *Create(key);
+	}
+
+	void Erase(uint32_t key);
+
+	// Erases entries whose strings are no longer referenced
+	void Reclaim(bool force = false);
+
+private:
+	void Grow();
+
+	std::vector<uint32_t> keys;
+	std::vector<uint8_t> dist;
+	std::vector<Data> values;
+	uint32_t entries;
+	Profiler::Clock m_reclaimClock;
+};
@@ -0,0 +1,58 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "doctest.h"
+#include "AtmosphereLUT.h"
+#include "galaxy/AtmosphereParameters.h"
+
+static AtmosphereParameters EarthLike()
+{
+	AtmosphereParameters ap{};
+	ap.atmosRadius = 1.0125f;
+	ap.atmosInvScaleHeight = 800.0f;
+	ap.atmosDensity = 1.225e-5f;
+	ap.planetRadius = 6.371e6f;
+	ap.atmosCol = Color(80, 130, 255, 255);
+	return ap;
+}
+
+TEST_CASE("Atmosphere LUT")
+{
+	const AtmosphereParameters ap = EarthLike();
+	const AtmosphereLUT lut(ap);
+
+	SUBCASE("Transmittance")
+	{
+		// nothing is in the way from the top of the atmosphere looking up
+		const vector3f top = lut.GetTransmittance(ap.atmosRadius, 1.0f);
+		CHECK(top.x == doctest::Approx(1.0f).epsilon(0.001));
+
+		// from the ground, mostly clear straight up, a lot less towards the horizon
+		const vector3f zenith = lut.GetTransmittance(1.0f, 1.0f);
+		const vector3f horizon = lut.GetTransmittance(1.0f, 0.05f);
+		CHECK(zenith.x > 0.5f);
+		CHECK(horizon.x < zenith.x);
+		// and blue is scattered more than red
+		CHECK(zenith.z < zenith.x);
+
+		// looking into the planet
+		CHECK(lut.GetTransmittance(1.0f, -1.0f).x == 0.0f);
+	}
+
+	SUBCASE("Scatter")
+	{
+		vector3f rayleigh, mie;
+		// some light from a daytime sky
+		lut.GetScatter(1.0f, 1.0f, 1.0f, rayleigh, mie);
+		CHECK(rayleigh.z > 0.0f);
+		CHECK(rayleigh.z > rayleigh.x);
+		CHECK(mie.x > 0.0f);
+		// and single scattering of unit light can't add up to more than it
+		CHECK(rayleigh.z < 1.0f);
+
+		// none with the sun far below the horizon
+		lut.GetScatter(1.0f, 1.0f, -1.0f, rayleigh, mie);
+		CHECK(rayleigh.z == 0.0f);
+		CHECK(lut.GetScatterData().size() == AtmosphereLUT::SCATTER_MU * AtmosphereLUT::SCATTER_MU_S * AtmosphereLUT::SCATTER_ALT);
+	}
+}
@@ -0,0 +1,65 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "core/BlockPool.h"
+#include "doctest.h"
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Block Pool")
+{
+	BlockPool pool(64, 4);
+	CHECK(pool.GetBlockSize() == 64);
+
+	SUBCASE("Freed blocks are reused")
+	{
+		bool reused = true;
+		void *a = pool.Allocate(&reused);
+		CHECK_FALSE(reused);
+		void *b = pool.Allocate();
+		CHECK(pool.GetNumAllocated() == 2);
+
+		pool.Free(a);
+		CHECK(pool.GetNumFree() == 1);
+		CHECK(pool.Allocate(&reused) == a);
+		CHECK(reused);
+
+		pool.Free(a);
+		pool.Free(b);
+		CHECK(pool.GetNumAllocated() == 0);
+		CHECK(pool.GetNumFree() == 2);
+	}
+
+	SUBCASE("Free list is bounded")
+	{
+		std::vector<void *> blocks;
+		for (int i = 0; i < 8; i++)
+			blocks.push_back(pool.Allocate());
+		for (void *block : blocks)
+			pool.Free(block);
+
+		CHECK(pool.GetNumFree() == 4);
+		pool.Clear();
+		CHECK(pool.GetNumFree() == 0);
+	}
+
+	SUBCASE("Concurrent allocation")
+	{
+		std::vector<std::thread> threads;
+		for (int t = 0; t < 4; t++) {
+			threads.emplace_back([&pool]() {
+				for (int i = 0; i < 1000; i++) {
+					void *block = pool.Allocate();
+					memset(block, 0xAB, pool.GetBlockSize());
+					pool.Free(block);
+				}
+			});
+		}
+		for (auto &thread : threads)
+			thread.join();
+
+		CHECK(pool.GetNumAllocated() == 0);
+	}
+}
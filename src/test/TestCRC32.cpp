@@ -0,0 +1,48 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "CRC32.h"
+#include "doctest.h"
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+TEST_CASE("CRC32")
+{
+	SUBCASE("Check value")
+	{
+		// the standard check value is the final register inverted
+		const char *check = "123456789";
+		CRC32 crc;
+		crc.AddData(check, strlen(check));
+		CHECK((crc.GetChecksum() ^ 0xffffffff) == 0xcbf43926);
+	}
+
+	SUBCASE("Matches bytewise")
+	{
+		MESSAGE("CRC32 implementation: " << CRC32::GetImplementationName());
+
+		std::mt19937 rng(3);
+		std::vector<char> data(4096 + 64);
+		for (char &c : data)
+			c = char(rng());
+
+		// every tail length of the folding and slicing loops, from unaligned starts
+		for (size_t length : { 0, 1, 7, 8, 15, 16, 63, 64, 65, 79, 80, 127, 128, 129, 1000, 4096 }) {
+			for (size_t offset = 0; offset < 4; offset++) {
+				CRC32 fast, reference;
+				fast.AddData(data.data() + offset, length);
+				reference.AddDataBytewise(data.data() + offset, length);
+				CHECK(fast.GetChecksum() == reference.GetChecksum());
+			}
+		}
+
+		// data added in pieces checksums the same as all at once
+		CRC32 whole, pieces;
+		whole.AddData(data.data(), data.size());
+		for (size_t pos = 0, step = 1; pos < data.size(); pos += step, step = step * 3 % 257 + 1)
+			pieces.AddData(data.data() + pos, std::min(step, data.size() - pos));
+		CHECK(whole.GetChecksum() == pieces.GetChecksum());
+	}
+}
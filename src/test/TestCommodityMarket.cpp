@@ -0,0 +1,67 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "doctest.h"
+#include "galaxy/CommodityMarket.h"
+#include "profiler/Profiler.h"
+
+#include <cmath>
+
+TEST_CASE("Commodity Market")
+{
+	CommodityMarket market(4);
+	const size_t a = market.AddMarket();
+	const size_t b = market.AddMarket();
+	REQUIRE(market.GetNumMarkets() == 2);
+
+	market.SetEquilibrium(a, 1, 100.0f, 10.0f);
+	market.SetEquilibrium(b, 1, 100.0f, 10.0f);
+	market.SetStock(a, 1, 100.0f);
+	market.SetStock(b, 1, 0.0f);
+	market.SetRecoveryTime(100.0);
+	market.SetPriceElasticity(0.5f);
+
+	SUBCASE("Prices follow the stock")
+	{
+		CHECK(market.GetPrice(a, 1) == doctest::Approx(10.0f));
+		CHECK(market.GetPrice(b, 1) == doctest::Approx(15.0f));
+		market.SetStock(a, 1, 200.0f);
+		CHECK(market.GetPrice(a, 1) == doctest::Approx(5.0f));
+		// never given away however much there is
+		market.SetStock(a, 1, 1e6f);
+		CHECK(market.GetPrice(a, 1) == doctest::Approx(1.0f));
+	}
+
+	SUBCASE("Stock recovers towards equilibrium")
+	{
+		market.Update(100.0);
+		CHECK(market.GetStock(a, 1) == doctest::Approx(100.0f));
+		CHECK(market.GetStock(b, 1) == doctest::Approx(100.0f * (1.0f - std::exp(-1.0f))));
+		CHECK(market.GetPrice(b, 1) < 15.0f);
+
+		// many small steps end up where one big one does
+		for (int i = 0; i < 100; i++)
+			market.Update(1.0);
+		CHECK(market.GetStock(b, 1) == doctest::Approx(100.0f * (1.0f - std::exp(-2.0f))));
+		// the other commodities and markets are untouched
+		CHECK(market.GetStock(b, 2) == 0.0f);
+	}
+
+	SUBCASE("Benchmark")
+	{
+		// every station of a busy system, stepped once a second for a day
+		CommodityMarket busy(64);
+		for (int i = 0; i < 100; i++) {
+			const size_t m = busy.AddMarket();
+			for (GalacticEconomy::CommodityId id = 1; id <= 64; id++)
+				busy.SetEquilibrium(m, id, float(id), 1.0f);
+		}
+		Profiler::Clock clock{};
+		clock.Start();
+		for (int i = 0; i < 24 * 60 * 60; i++)
+			busy.Update(1.0);
+		clock.Stop();
+		printf("CommodityMarket: %zu markets x %zu commodities, %.3f us per update\n",
+			busy.GetNumMarkets(), busy.GetNumCommodities(), clock.milliseconds() * 1000.0 / (24 * 60 * 60));
+	}
+}
@@ -0,0 +1,117 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "core/CompletionQueue.h"
+#include "doctest.h"
+#include "profiler/Profiler.h"
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+static constexpr uint32_t NUM_PRODUCERS = 32;
+static constexpr uint32_t ITEMS_PER_PRODUCER = 20000;
+
+// The mutex-protected container the completion ring replaces, kept here as
+// the baseline for the contention benchmark below.
+class MutexCompletionQueue {
+public:
+	void push(uint32_t item)
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_items.push_back(item);
+	}
+
+	bool try_pop(uint32_t &item)
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		if (m_items.empty())
+			return false;
+
+		item = m_items.front();
+		m_items.pop_front();
+		return true;
+	}
+
+private:
+	std::mutex m_lock;
+	std::deque<uint32_t> m_items;
+};
+
+// Run NUM_PRODUCERS threads pushing into the queue while the calling thread
+// consumes; returns the elapsed time in milliseconds.
+template <typename Queue>
+double RunProducers(Queue &queue, uint64_t &sum)
+{
+	std::atomic<bool> start = false;
+	std::vector<std::thread> producers;
+	for (uint32_t idx = 0; idx < NUM_PRODUCERS; idx++) {
+		producers.emplace_back([&]() {
+			while (!start.load())
+				std::this_thread::yield();
+
+			for (uint32_t item = 1; item <= ITEMS_PER_PRODUCER; item++)
+				queue.push(item);
+		});
+	}
+
+	Profiler::Clock clock{};
+	clock.Start();
+	start = true;
+
+	uint32_t numReceived = 0;
+	uint32_t item = 0;
+	while (numReceived < NUM_PRODUCERS * ITEMS_PER_PRODUCER) {
+		if (queue.try_pop(item)) {
+			sum += item;
+			numReceived++;
+		}
+	}
+
+	clock.Stop();
+	for (auto &thread : producers)
+		thread.join();
+
+	return clock.milliseconds();
+}
+
+TEST_CASE("CompletionQueue")
+{
+	SUBCASE("Overflow")
+	{
+		CompletionQueue<uint32_t, 8> queue;
+		for (uint32_t idx = 0; idx < 32; idx++)
+			queue.push(idx);
+
+		CHECK(queue.was_size() == 32);
+		CHECK(queue.num_overflowed() == 32 - 8);
+
+		uint32_t item = 0;
+		for (uint32_t idx = 0; idx < 32; idx++) {
+			REQUIRE(queue.try_pop(item));
+			CHECK(item == idx);
+		}
+
+		CHECK_FALSE(queue.try_pop(item));
+	}
+
+	SUBCASE("Contention Benchmark")
+	{
+		const uint64_t expected = uint64_t(NUM_PRODUCERS) * ITEMS_PER_PRODUCER * (ITEMS_PER_PRODUCER + 1) / 2;
+
+		uint64_t mutexSum = 0;
+		MutexCompletionQueue mutexQueue;
+		double mutexTime = RunProducers(mutexQueue, mutexSum);
+
+		uint64_t ringSum = 0;
+		CompletionQueue<uint32_t, 1024> ringQueue;
+		double ringTime = RunProducers(ringQueue, ringSum);
+
+		CHECK(mutexSum == expected);
+		CHECK(ringSum == expected);
+
+		printf("CompletionQueue: %u producers x %u items: mutex %.2f ms, ring %.2f ms (%zu overflowed)\n",
+			NUM_PRODUCERS, ITEMS_PER_PRODUCER, mutexTime, ringTime, ringQueue.num_overflowed());
+	}
+}
@@ -0,0 +1,60 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "core/GZipFormat.h"
+#include "core/LZ4Format.h"
+#include "core/TaskGraph.h"
+#include "doctest.h"
+
+#include <memory>
+#include <random>
+#include <string>
+
+// Several blocks' worth of text-like data, with an incompressible stretch
+// and a partial block at the end
+static std::string MakeTestData()
+{
+	std::mt19937 rng(8);
+	std::string data;
+	while (data.size() < 3 * 1024 * 1024)
+		data += "{\"body\": " + std::to_string(rng() % 1000) + ", \"pos\": [" + std::to_string(rng()) + ", 0.5]}\n";
+	for (int i = 0; i < 1200 * 1024; i++)
+		data.push_back(char(rng()));
+	data += "tail";
+	return data;
+}
+
+TEST_CASE("Parallel Compression")
+{
+	std::unique_ptr<TaskGraph> graph(new TaskGraph());
+	graph->SetWorkerThreads(3);
+
+	const std::string data = MakeTestData();
+
+	SUBCASE("GZip")
+	{
+		const std::string serial = gzip::CompressGZip(data, "test.json");
+		const std::string parallel = gzip::CompressGZip(data, "test.json", graph.get());
+		// the footer CRC of the joined blocks is checked on decompression
+		const unsigned char *bytes = reinterpret_cast<const unsigned char *>(parallel.data());
+		REQUIRE(gzip::IsGZipFormat(bytes, parallel.size()));
+		CHECK(gzip::DecompressGZip(bytes, parallel.size()) == data);
+		CHECK(parallel.size() < serial.size() * 21 / 20);
+
+		// small inputs take the single stream path
+		const std::string small = data.substr(0, 1000);
+		const std::string packed = gzip::CompressGZip(small, "small", graph.get());
+		CHECK(packed == gzip::CompressGZip(small, "small"));
+	}
+
+	SUBCASE("LZ4")
+	{
+		for (const int preset : { 0, 9 }) {
+			const std::string serial = lz4::CompressLZ4(data, preset);
+			const std::string parallel = lz4::CompressLZ4(data, preset, graph.get());
+			REQUIRE(lz4::IsLZ4Format(parallel.data(), parallel.size()));
+			CHECK(lz4::DecompressLZ4(parallel) == data);
+			CHECK(parallel.size() < serial.size() * 21 / 20);
+		}
+	}
+}
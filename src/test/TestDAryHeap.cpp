@@ -0,0 +1,106 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "core/DAryHeap.h"
+#include "doctest.h"
+#include "profiler/Profiler.h"
+
+#include <algorithm>
+#include <deque>
+#include <random>
+#include <vector>
+
+static constexpr uint32_t NUM_TIMERS = 100000;
+
+struct Timeout {
+	double at;
+	uint32_t id;
+
+	bool operator<(const Timeout &other) const { return at < other.at || (at == other.at && id < other.id); }
+};
+
+// The sorted deque LuaTimer used before, kept here as the baseline for the
+// benchmark below.
+class SortedDequeTimers {
+public:
+	void push(Timeout t)
+	{
+		auto iter = std::lower_bound(m_items.begin(), m_items.end(), t);
+		m_items.insert(iter, t);
+	}
+	bool empty() const { return m_items.empty(); }
+	const Timeout &top() const { return m_items.front(); }
+	void pop() { m_items.pop_front(); }
+
+private:
+	std::deque<Timeout> m_items;
+};
+
+// Simulates mission scripts: NUM_TIMERS timers scheduled at random times,
+// then the clock advancing in steps, with every fired timer rescheduled once.
+// Returns the elapsed time in milliseconds.
+template <typename Queue>
+double RunTimers(Queue &queue, uint64_t &numFired)
+{
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<double> delay(1.0, 10000.0);
+
+	Profiler::Clock clock{};
+	clock.Start();
+
+	for (uint32_t id = 0; id < NUM_TIMERS; id++)
+		queue.push({ delay(rng), id });
+
+	for (double now = 0.0; now < 20000.0; now += 10.0) {
+		while (!queue.empty() && queue.top().at <= now) {
+			Timeout t = queue.top();
+			queue.pop();
+			numFired++;
+			if (t.id < NUM_TIMERS)
+				queue.push({ now + delay(rng), t.id + NUM_TIMERS });
+		}
+	}
+
+	clock.Stop();
+	return clock.milliseconds();
+}
+
+TEST_CASE("DAryHeap")
+{
+	SUBCASE("Ordering")
+	{
+		std::mt19937 rng(42);
+		std::vector<int> values(1000);
+		for (int &v : values)
+			v = int(rng() % 200);
+
+		DAryHeap<int> heap;
+		for (int v : values)
+			heap.push(v);
+
+		std::sort(values.begin(), values.end());
+		for (int v : values) {
+			REQUIRE(!heap.empty());
+			CHECK(heap.top() == v);
+			heap.pop();
+		}
+		CHECK(heap.empty());
+	}
+
+	SUBCASE("Timer Benchmark")
+	{
+		uint64_t dequeFired = 0;
+		SortedDequeTimers dequeTimers;
+		double dequeTime = RunTimers(dequeTimers, dequeFired);
+
+		uint64_t heapFired = 0;
+		DAryHeap<Timeout> heapTimers;
+		double heapTime = RunTimers(heapTimers, heapFired);
+
+		CHECK(dequeFired == 2 * NUM_TIMERS);
+		CHECK(heapFired == 2 * NUM_TIMERS);
+
+		printf("Timers: %u timers: sorted deque %.2f ms, 4-ary heap %.2f ms\n",
+			NUM_TIMERS, dequeTime, heapTime);
+	}
+}
@@ -0,0 +1,54 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "doctest.h"
+#include "graphics/DynamicResolution.h"
+
+using Graphics::DynamicResolution;
+
+// a GPU whose time goes with the pixel count
+static void RunFrames(DynamicResolution &dr, float fullResMs, int frames)
+{
+	for (int i = 0; i < frames; i++)
+		dr.Update(fullResMs * dr.GetScale() * dr.GetScale());
+}
+
+TEST_CASE("Dynamic Resolution")
+{
+	SUBCASE("Stays at full resolution within budget")
+	{
+		DynamicResolution dr(16.0f, 0.5f);
+		RunFrames(dr, 10.0f, 200);
+		CHECK(dr.GetScale() == 1.0f);
+	}
+
+	SUBCASE("Scales down to meet the budget and stays there")
+	{
+		DynamicResolution dr(16.0f, 0.5f);
+		RunFrames(dr, 24.0f, 400);
+		CHECK(dr.GetScale() < 1.0f);
+		CHECK(dr.GetSmoothedGPUTime() <= 16.0f);
+
+		// no hunting once settled
+		const float settled = dr.GetScale();
+		RunFrames(dr, 24.0f, 200);
+		CHECK(dr.GetScale() == settled);
+	}
+
+	SUBCASE("Respects the minimum scale")
+	{
+		DynamicResolution dr(16.0f, 0.5f);
+		RunFrames(dr, 200.0f, 1000);
+		CHECK(dr.GetScale() == 0.5f);
+		CHECK(dr.GetScaledSize(1920) == 960);
+	}
+
+	SUBCASE("Recovers when the load drops")
+	{
+		DynamicResolution dr(16.0f, 0.5f);
+		RunFrames(dr, 40.0f, 400);
+		REQUIRE(dr.GetScale() < 0.8f);
+		RunFrames(dr, 8.0f, 400);
+		CHECK(dr.GetScale() == 1.0f);
+	}
+}
@@ -0,0 +1,165 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "FileSourceZip.h"
+#include "FileSystem.h"
+#include "doctest.h"
+
+extern "C" {
+#include "miniz/miniz.h"
+}
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+static void WriteFile(FileSystem::FileSourceFS &fs, const std::string &path, const std::string &contents)
+{
+	FILE *f = fs.OpenWriteStream(path);
+	REQUIRE(f);
+	fwrite(contents.data(), 1, contents.size(), f);
+	fclose(f);
+}
+
+TEST_CASE("FileSourceFS mapped reads")
+{
+	FileSystem::FileSourceFS tmp(std::filesystem::temp_directory_path().string());
+	REQUIRE(tmp.MakeDirectory("pioneer_test_fs"));
+	FileSystem::FileSourceFS fs(FileSystem::JoinPath(tmp.GetRoot(), "pioneer_test_fs"), true);
+
+	std::string big(FileSystem::FileSourceFS::MAP_READ_THRESHOLD + 100, 'a');
+	big[1234] = 'Z';
+	WriteFile(fs, "big.bin", big);
+	WriteFile(fs, "small.txt", "hello");
+	WriteFile(fs, "empty", "");
+
+	SUBCASE("Large and small files read the same with or without mapping")
+	{
+		for (size_t threshold : { size_t(0), size_t(FileSystem::FileSourceFS::MAP_READ_THRESHOLD), size_t(1) }) {
+			fs.SetMapThreshold(threshold);
+
+			RefCountedPtr<FileSystem::FileData> data = fs.ReadFile("big.bin");
+			REQUIRE(data);
+			REQUIRE(data->GetSize() == big.size());
+			CHECK(memcmp(data->GetData(), big.data(), big.size()) == 0);
+
+			data = fs.ReadFile("small.txt");
+			REQUIRE(data);
+			CHECK(data->AsStringView() == "hello");
+
+			data = fs.ReadFile("empty");
+			REQUIRE(data);
+			CHECK(data->GetSize() == 0);
+
+			CHECK(!fs.ReadFile("missing"));
+		}
+	}
+
+	SUBCASE("Untrusted sources don't map by default")
+	{
+		FileSystem::FileSourceFS untrusted(fs.GetRoot());
+		CHECK(untrusted.GetMapThreshold() == 0);
+		CHECK(fs.GetMapThreshold() == FileSystem::FileSourceFS::MAP_READ_THRESHOLD);
+	}
+
+	std::filesystem::remove_all(fs.GetRoot());
+}
+
+TEST_CASE("FileSourceUnion index")
+{
+	FileSystem::FileSourceFS tmp(std::filesystem::temp_directory_path().string());
+	for (const char *dir : { "pioneer_test_union", "pioneer_test_union/a", "pioneer_test_union/a/dir", "pioneer_test_union/b", "pioneer_test_union/b/dir" })
+		REQUIRE(tmp.MakeDirectory(dir));
+	FileSystem::FileSourceFS a(FileSystem::JoinPath(tmp.GetRoot(), "pioneer_test_union/a"));
+	FileSystem::FileSourceFS b(FileSystem::JoinPath(tmp.GetRoot(), "pioneer_test_union/b"));
+
+	WriteFile(a, "dir/shared.txt", "from a");
+	WriteFile(b, "dir/shared.txt", "from b");
+	WriteFile(b, "dir/only_b.txt", "only b");
+	// a directory in a shadows the path for Lookup, but ReadFile still finds b's file
+	REQUIRE(a.MakeDirectory("clash"));
+	WriteFile(b, "clash", "file in b");
+
+	FileSystem::FileSourceUnion files;
+	files.AppendSource(&a);
+	files.AppendSource(&b);
+
+	CHECK(files.ReadFile("dir/shared.txt")->AsStringView() == "from a");
+	CHECK(files.ReadFile("dir/only_b.txt")->AsStringView() == "only b");
+	CHECK(files.ReadFile("./dir//only_b.txt")->AsStringView() == "only b");
+	CHECK(!files.ReadFile("dir/missing.txt"));
+
+	CHECK(files.Lookup("dir").IsDir());
+	CHECK(&files.Lookup("dir/only_b.txt").GetSource() == &b);
+	CHECK(files.Lookup("./dir/only_b.txt").GetPath() == "./dir/only_b.txt");
+	CHECK(!files.Lookup("dir/missing.txt").Exists());
+	CHECK(files.Lookup("").IsDir());
+
+	CHECK(files.Lookup("clash").IsDir());
+	CHECK(files.ReadFile("clash")->AsStringView() == "file in b");
+
+	// changing the sources rebuilds the index
+	files.PrependSource(&b);
+	CHECK(files.ReadFile("dir/shared.txt")->AsStringView() == "from b");
+
+	// new files are only seen after invalidating
+	WriteFile(a, "new.txt", "new");
+	CHECK(!files.Lookup("new.txt").Exists());
+	files.InvalidateIndex();
+	CHECK(files.ReadFile("new.txt")->AsStringView() == "new");
+
+	std::filesystem::remove_all(FileSystem::JoinPath(tmp.GetRoot(), "pioneer_test_union"));
+}
+
+TEST_CASE("FileSourceZip concurrent reads")
+{
+	FileSystem::FileSourceFS tmp(std::filesystem::temp_directory_path().string());
+	REQUIRE(tmp.MakeDirectory("pioneer_test_zip"));
+	FileSystem::FileSourceFS dir(FileSystem::JoinPath(tmp.GetRoot(), "pioneer_test_zip"));
+	const std::string zipPath = FileSystem::JoinPath(dir.GetRoot(), "mod.zip");
+
+	std::vector<std::string> contents;
+	for (int i = 0; i < 8; i++) {
+		// big entries bypass the cache, small ones go through it
+		const size_t size = (i % 2) ? FileSystem::FileSourceZip::CACHE_MAX_ENTRY_SIZE * 2 : 1000;
+		std::string data(size, 'a' + i);
+		data[size / 2] = '!';
+		const std::string name = "files/" + std::to_string(i) + ".txt";
+		REQUIRE(mz_zip_add_mem_to_archive_file_in_place(zipPath.c_str(), name.c_str(), data.data(), data.size(), 0, 0, MZ_BEST_COMPRESSION));
+		contents.push_back(data);
+	}
+
+	FileSystem::FileSourceZip zip(dir, "mod.zip");
+	CHECK(zip.Lookup("files").IsDir());
+	CHECK(zip.Lookup("files/3.txt").IsFile());
+	CHECK(!zip.ReadFile("files"));
+	CHECK(!zip.ReadFile("files/missing.txt"));
+
+	std::atomic<int> failures(0);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; t++) {
+		threads.emplace_back([&, t]() {
+			for (int n = 0; n < 50; n++) {
+				const int i = (n + t) % 8;
+				RefCountedPtr<FileSystem::FileData> data = zip.ReadFile("files/" + std::to_string(i) + ".txt");
+				if (!data || data->AsStringView() != contents[i])
+					failures++;
+			}
+		});
+	}
+	for (std::thread &thread : threads)
+		thread.join();
+	CHECK(failures == 0);
+
+	// cached small entries are shared, large ones are inflated each time
+	CHECK(zip.ReadFile("files/0.txt") == zip.ReadFile("files/0.txt"));
+	CHECK(zip.ReadFile("files/1.txt") != zip.ReadFile("files/1.txt"));
+	zip.SetCacheBudget(0);
+	CHECK(zip.ReadFile("files/0.txt") != zip.ReadFile("files/0.txt"));
+
+	std::filesystem::remove_all(dir.GetRoot());
+}
@@ -0,0 +1,138 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "core/FlatHashMap.h"
+#include "doctest.h"
+#include "galaxy/SystemPath.h"
+#include "profiler/Profiler.h"
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+typedef FlatHashMap<SystemPath, int, SystemPath::HashSystemOnly, SystemPath::EqualSystemOnly> SystemMap;
+
+// the systems of a block of sectors, as a zoomed out sector map asks for
+static std::vector<SystemPath> MakeSystemPaths(int radius, int systemsPerSector)
+{
+	std::vector<SystemPath> paths;
+	for (int x = -radius; x <= radius; x++)
+		for (int y = -radius; y <= radius; y++)
+			for (int z = -radius; z <= radius; z++)
+				for (int i = 0; i < systemsPerSector; i++)
+					paths.emplace_back(x, y, z, i);
+	return paths;
+}
+
+TEST_CASE("Flat Hash Map")
+{
+	std::mt19937 rng(1234);
+	std::vector<SystemPath> paths = MakeSystemPaths(4, 3);
+	std::shuffle(paths.begin(), paths.end(), rng);
+
+	SystemMap map;
+	std::map<SystemPath, int, SystemPath::LessSystemOnly> reference;
+	for (size_t i = 0; i < paths.size(); i++) {
+		CHECK(map.insert(std::make_pair(paths[i], int(i))).second);
+		reference[paths[i]] = int(i);
+	}
+	REQUIRE(map.size() == paths.size());
+
+	SUBCASE("Lookups")
+	{
+		for (size_t i = 0; i < paths.size(); i++) {
+			auto it = map.find(paths[i]);
+			REQUIRE(it != map.end());
+			CHECK(it->second == int(i));
+		}
+		CHECK_FALSE(map.insert(std::make_pair(paths[0], -1)).second);
+		CHECK(map[paths[0]] == 0);
+		CHECK(map.find(SystemPath(100, 0, 0, 0)) == map.end());
+
+		// only the sector and system count
+		SystemPath body = paths[1];
+		body.bodyIndex = 7;
+		CHECK(map.count(body) == 1);
+	}
+
+	SUBCASE("Erasing while iterating")
+	{
+		// as SectorMap and Space prune their slave caches
+		for (auto it = map.begin(); it != map.end();) {
+			if (it->first.sectorX < 0)
+				map.erase(it++);
+			else
+				++it;
+		}
+		for (auto it = reference.begin(); it != reference.end();) {
+			if (it->first.sectorX < 0)
+				reference.erase(it++);
+			else
+				++it;
+		}
+
+		CHECK(map.size() == reference.size());
+		size_t visited = 0;
+		for (const auto &entry : map) {
+			CHECK(reference.count(entry.first) == 1);
+			visited++;
+		}
+		CHECK(visited == reference.size());
+	}
+
+	SUBCASE("Reinserting over tombstones")
+	{
+		// churn through many more insertions than the map ever holds
+		for (int round = 0; round < 20; round++) {
+			for (size_t i = 0; i < paths.size(); i += 2)
+				CHECK(map.erase(paths[i]) == 1);
+			for (size_t i = 0; i < paths.size(); i += 2)
+				map[paths[i]] = round;
+		}
+		CHECK(map.size() == paths.size());
+		CHECK(map.capacity() < paths.size() * 4);
+		for (size_t i = 0; i < paths.size(); i++)
+			CHECK(map.count(paths[i]) == 1);
+
+		map.clear();
+		CHECK(map.empty());
+		CHECK(map.begin() == map.end());
+	}
+
+	SUBCASE("Benchmark")
+	{
+		const std::vector<SystemPath> benchPaths = MakeSystemPaths(12, 4);
+		SystemMap hashed;
+		std::map<SystemPath, int, SystemPath::LessSystemOnly> ordered;
+		for (size_t i = 0; i < benchPaths.size(); i++) {
+			hashed[benchPaths[i]] = int(i);
+			ordered[benchPaths[i]] = int(i);
+		}
+
+		std::vector<SystemPath> lookups(benchPaths);
+		std::shuffle(lookups.begin(), lookups.end(), rng);
+		const int passes = 10;
+		Profiler::Clock clock{};
+
+		long long orderedSum = 0;
+		clock.Start();
+		for (int pass = 0; pass < passes; pass++)
+			for (const SystemPath &path : lookups)
+				orderedSum += ordered.find(path)->second;
+		clock.Stop();
+		const double orderedTime = clock.milliseconds();
+
+		long long hashedSum = 0;
+		clock.Reset();
+		clock.Start();
+		for (int pass = 0; pass < passes; pass++)
+			for (const SystemPath &path : lookups)
+				hashedSum += hashed.find(path)->second;
+		clock.Stop();
+		const double hashedTime = clock.milliseconds();
+
+		CHECK(hashedSum == orderedSum);
+		printf("system path lookups: %zu x %d: std::map %.2f ms, FlatHashMap %.2f ms\n", lookups.size(), passes, orderedTime, hashedTime);
+	}
+}
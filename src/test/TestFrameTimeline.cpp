@@ -0,0 +1,96 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "core/FrameTimeline.h"
+#include "doctest.h"
+
+#include <cstring>
+
+static FrameTimeline::Frame MakeFrame(double durationMs)
+{
+	FrameTimeline::Frame frame;
+	frame.durationMs = durationMs;
+	return frame;
+}
+
+static const FrameTimeline::ZoneTotal *FindTotal(const std::vector<FrameTimeline::ZoneTotal> &totals, const char *name)
+{
+	for (const FrameTimeline::ZoneTotal &total : totals) {
+		if (strcmp(total.name, name) == 0)
+			return &total;
+	}
+	return nullptr;
+}
+
+TEST_CASE("FrameTimeline history")
+{
+	FrameTimeline timeline(4);
+	for (int i = 0; i < 6; i++)
+		timeline.AddFrame(MakeFrame(10.0 + i));
+
+	REQUIRE(timeline.GetNumFrames() == 4);
+	CHECK(timeline.GetFrame(0).number == 2);
+	CHECK(timeline.GetFrame(3).number == 5);
+	CHECK(timeline.GetFrame(3).durationMs == 15.0);
+
+	SUBCASE("pinned frames outlive the history")
+	{
+		timeline.PinFrame(0);
+		for (int i = 0; i < 4; i++)
+			timeline.AddFrame(MakeFrame(1.0));
+
+		REQUIRE(timeline.GetPinnedFrame());
+		CHECK(timeline.GetPinnedFrame()->number == 2);
+		CHECK(timeline.GetFrame(0).number == 6);
+
+		timeline.Unpin();
+		CHECK(!timeline.GetPinnedFrame());
+	}
+
+	SUBCASE("the first slow frame is pinned")
+	{
+		timeline.SetAutoPinThreshold(30.0);
+		timeline.AddFrame(MakeFrame(20.0));
+		CHECK(!timeline.GetPinnedFrame());
+
+		timeline.AddFrame(MakeFrame(40.0));
+		timeline.AddFrame(MakeFrame(50.0));
+		REQUIRE(timeline.GetPinnedFrame());
+		CHECK(timeline.GetPinnedFrame()->durationMs == 40.0);
+	}
+}
+
+TEST_CASE("FrameTimeline aggregation")
+{
+	// two lanes calling "update", one of them with two nested zones
+	FrameTimeline::Frame frame = MakeFrame(10.0);
+	frame.lanes.push_back({ "main", {
+		{ "update", 0.0, 6.0, 0 },
+		{ "physics", 1.0, 3.0, 1 },
+		{ "collide", 1.5, 2.5, 2 },
+		{ "lua", 4.0, 5.0, 1 },
+		{ "render", 6.0, 9.0, 0 },
+	} });
+	frame.lanes.push_back({ "worker", {
+		{ "update", 2.0, 4.0, 0 },
+	} });
+
+	const std::vector<FrameTimeline::ZoneTotal> totals = FrameTimeline::Aggregate(frame);
+	REQUIRE(totals.size() == 5);
+	CHECK(strcmp(totals[0].name, "update") == 0);
+
+	const FrameTimeline::ZoneTotal *update = FindTotal(totals, "update");
+	REQUIRE(update);
+	CHECK(update->calls == 2);
+	CHECK(update->totalMs == doctest::Approx(8.0));
+	// 6 ms on main less 3 ms in its children, plus 2 ms on the worker
+	CHECK(update->selfMs == doctest::Approx(5.0));
+
+	const FrameTimeline::ZoneTotal *physics = FindTotal(totals, "physics");
+	REQUIRE(physics);
+	CHECK(physics->selfMs == doctest::Approx(1.0));
+
+	const FrameTimeline::ZoneTotal *render = FindTotal(totals, "render");
+	REQUIRE(render);
+	CHECK(render->selfMs == doctest::Approx(3.0));
+}
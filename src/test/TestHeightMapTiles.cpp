@@ -0,0 +1,49 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "doctest.h"
+#include "terrain/HeightMapTiles.h"
+
+#include <algorithm>
+#include <vector>
+
+static const int MAP_WIDTH = 300;
+static const int MAP_HEIGHT = 170;
+static const int TILE_SIZE = 64;
+
+TEST_CASE("HeightMapTiles round trip")
+{
+	// a smooth slope with some sharp steps, and partial tiles on both edges
+	std::vector<uint16_t> samples(MAP_WIDTH * MAP_HEIGHT);
+	for (int y = 0; y < MAP_HEIGHT; y++)
+		for (int x = 0; x < MAP_WIDTH; x++)
+			samples[y * MAP_WIDTH + x] = uint16_t(x * 37 + y * 211 + ((x * y) % 7 == 0 ? 5000 : 0));
+
+	const std::string data = HeightMapTiles::Encode(samples.data(), MAP_WIDTH, MAP_HEIGHT, 1000, 2.5, -3.0, TILE_SIZE);
+	REQUIRE(HeightMapTiles::IsTiledFormat(data.data(), data.size()));
+	CHECK(!HeightMapTiles::IsTiledFormat(data.data(), data.size() / 2));
+	CHECK(data.size() < samples.size() * sizeof(uint16_t));
+
+	HeightMapTiles tiles(data, 2);
+	CHECK(tiles.GetWidth() == MAP_WIDTH);
+	CHECK(tiles.GetHeight() == MAP_HEIGHT);
+	CHECK(tiles.GetHeightScaling() == 2.5);
+	CHECK(tiles.GetMinHeight() == -3.0);
+	CHECK(tiles.GetResidentTiles() == 0);
+
+	// blocks across tile boundaries and off every edge of the map
+	const int origins[][2] = { { 0, 0 }, { 62, 62 }, { -2, 100 }, { 297, 168 }, { 150, -3 }, { 299, 0 } };
+	for (const auto &origin : origins) {
+		double block[5 * 5];
+		tiles.GetBlock(origin[0], origin[1], 5, 5, block);
+		for (int y = 0; y < 5; y++) {
+			for (int x = 0; x < 5; x++) {
+				const int sx = std::clamp(origin[0] + x, 0, MAP_WIDTH - 1);
+				const int sy = std::clamp(origin[1] + y, 0, MAP_HEIGHT - 1);
+				CHECK(block[y * 5 + x] == double(samples[sy * MAP_WIDTH + sx]) - 1000.0);
+			}
+		}
+		// the cache never grows past its limit
+		CHECK(tiles.GetResidentTiles() <= 2);
+	}
+}
@@ -0,0 +1,71 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "Json.h"
+#include "core/HitchDetector.h"
+#include "doctest.h"
+
+TEST_CASE("HitchDetector reports")
+{
+	HitchDetector detector(8, 2);
+	detector.SetThreshold(50.0);
+	detector.SetReportInterval(100);
+
+	for (int i = 0; i < 10; i++) {
+		detector.AddPhaseTime(HitchDetector::PHASE_PHYSICS, 5.0);
+		CHECK(!detector.EndFrame(16.0));
+	}
+	REQUIRE(detector.GetHistory().size() == 8);
+	CHECK(detector.GetHistory().back().phaseMs[HitchDetector::PHASE_PHYSICS] == doctest::Approx(5.0));
+
+	// the hitch, then the frames after it complete the report
+	detector.AddPhysicsTicks(4);
+	detector.SetQueuedJobs(120);
+	CHECK(!detector.EndFrame(80.0));
+	CHECK(!detector.EndFrame(16.0));
+	CHECK(detector.EndFrame(16.0));
+
+	const Json report = detector.TakeReport();
+	CHECK(report["hitchFrame"] == 10);
+	REQUIRE(report["frames"].size() == 10);
+	CHECK(report["frames"][0]["frame"] == 3);
+
+	const Json &hitch = report["frames"][7];
+	CHECK(hitch["frame"] == 10);
+	CHECK(hitch["ticks"] == 4);
+	CHECK(hitch["queuedJobs"] == 120);
+	CHECK(hitch["otherMs"].get<double>() == doctest::Approx(80.0));
+
+	SUBCASE("hitches are rate limited")
+	{
+		CHECK(!detector.EndFrame(90.0));
+		CHECK(!detector.EndFrame(16.0));
+		CHECK(!detector.EndFrame(16.0));
+		CHECK(detector.TakeReport().is_null());
+	}
+
+	SUBCASE("no reports while disabled")
+	{
+		detector.SetThreshold(0.0);
+		detector.SetReportInterval(0);
+		for (int i = 0; i < 4; i++)
+			CHECK(!detector.EndFrame(500.0));
+	}
+}
+
+TEST_CASE("HitchDetector nested phases")
+{
+	HitchDetector detector;
+	{
+		HitchDetector::ScopedPhase physics(&detector, HitchDetector::PHASE_PHYSICS);
+		HitchDetector::ScopedPhase lua(&detector, HitchDetector::PHASE_LUA_EVENTS);
+		lua.End();
+	}
+	detector.EndFrame(1.0);
+
+	// both phases were timed, and the inner one paused the outer one
+	const HitchDetector::FrameRecord &frame = detector.GetHistory().back();
+	CHECK(frame.phaseMs[HitchDetector::PHASE_PHYSICS] >= 0.f);
+	CHECK(frame.phaseMs[HitchDetector::PHASE_LUA_EVENTS] >= 0.f);
+	CHECK(frame.phaseMs[HitchDetector::PHASE_RENDER] == 0.f);
+}
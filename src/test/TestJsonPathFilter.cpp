@@ -0,0 +1,78 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "JsonPathFilter.h"
+#include "doctest.h"
+
+#include <stdexcept>
+
+static Json MakeTestSave()
+{
+	return Json::parse(R"({
+		"space": { "bodies": [ { "type": 1, "name": "Sol" }, { "type": 3 }, { "name": "Earth" } ] },
+		"lua_modules": { "Missions": [ { "reward": 100 } ], "Events": {} },
+		"time": 12.5
+	})");
+}
+
+TEST_CASE("JsonPathFilter")
+{
+	const Json save = MakeTestSave();
+	const std::vector<uint8_t> cborBytes = Json::to_cbor(save);
+	const std::string cbor(cborBytes.begin(), cborBytes.end());
+
+	SUBCASE("Wildcards and whole containers")
+	{
+		JsonPathFilter filter({ "space.bodies[*].type", "lua_modules.Missions", "time" });
+		JsonPathFilter::Matches matches;
+		filter.Extract(cbor, Json::input_format_t::cbor, std::string(), matches);
+
+		// in document order, and Json objects keep their keys sorted
+		REQUIRE(matches.size() == 4);
+		CHECK(matches[0].first == "lua_modules.Missions");
+		CHECK(matches[0].second == save["lua_modules"]["Missions"]);
+		CHECK(matches[1].first == "space.bodies[0].type");
+		CHECK(matches[1].second == 1);
+		CHECK(matches[2].first == "space.bodies[1].type");
+		CHECK(matches[2].second == 3);
+		CHECK(matches[3].first == "time");
+		CHECK(matches[3].second == 12.5);
+	}
+
+	SUBCASE("JSON text and indices")
+	{
+		JsonPathFilter filter({ "space.bodies[2]", "*.Events" });
+		JsonPathFilter::Matches matches;
+		filter.Extract(save.dump(), Json::input_format_t::json, std::string(), matches);
+
+		REQUIRE(matches.size() == 2);
+		CHECK(matches[0].first == "lua_modules.Events");
+		CHECK(matches[0].second == Json::object());
+		CHECK(matches[1].first == "space.bodies[2]");
+		CHECK(matches[1].second == save["space"]["bodies"][2]);
+	}
+
+	SUBCASE("Sections of a chunked save")
+	{
+		JsonPathFilter filter({ "space.bodies[*].name" });
+		CHECK(filter.MatchesTopLevelKey("space"));
+		CHECK(!filter.MatchesTopLevelKey("lua_modules"));
+
+		const std::vector<uint8_t> spaceBytes = Json::to_cbor(save["space"]);
+		JsonPathFilter::Matches matches;
+		filter.Extract(std::string(spaceBytes.begin(), spaceBytes.end()), Json::input_format_t::cbor, "space", matches);
+
+		REQUIRE(matches.size() == 2);
+		CHECK(matches[0].first == "space.bodies[0].name");
+		CHECK(matches[1].first == "space.bodies[2].name");
+		CHECK(matches[1].second == "Earth");
+	}
+
+	SUBCASE("Bad paths")
+	{
+		CHECK_THROWS_AS(JsonPathFilter({ "" }), std::invalid_argument);
+		CHECK_THROWS_AS(JsonPathFilter({ "space.bodies[" }), std::invalid_argument);
+		CHECK_THROWS_AS(JsonPathFilter({ "space..bodies" }), std::invalid_argument);
+		CHECK_THROWS_AS(JsonPathFilter({ "space.bodies[x]" }), std::invalid_argument);
+	}
+}
@@ -0,0 +1,119 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "doctest.h"
+#include "graphics/LightClusters.h"
+#include "profiler/Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+using Graphics::LightClusters;
+
+// the cluster a shader would look up for a view-space point
+static uint32_t ClusterOf(const LightClusters &clusters, const matrix4x4f &proj, const vector3f &p)
+{
+	const float w = -p.z;
+	const float ndcX = (proj[0] * p.x + proj[8] * p.z) / w;
+	const float ndcY = (proj[5] * p.y + proj[9] * p.z) / w;
+	const auto tile = [](float ndc, uint32_t tiles) {
+		return std::min(uint32_t((ndc + 1.0f) * 0.5f * float(tiles)), tiles - 1);
+	};
+	const float slice = std::floor(std::log(w) * clusters.GetSliceScale() + clusters.GetSliceBias());
+	const uint32_t z = uint32_t(std::min(std::max(slice, 0.0f), float(LightClusters::GRID_Z - 1)));
+	return LightClusters::GetClusterIndex(tile(ndcX, LightClusters::GRID_X), tile(ndcY, LightClusters::GRID_Y), z);
+}
+
+static bool ClusterHasLight(const LightClusters &clusters, uint32_t cluster, uint16_t light)
+{
+	const uint32_t packed = clusters.GetClusters()[cluster];
+	const uint16_t *begin = clusters.GetIndices().data() + (packed & 0xffff);
+	const uint16_t *end = begin + (packed >> 16);
+	return std::find(begin, end, light) != end;
+}
+
+TEST_CASE("Light Clusters")
+{
+	const float znear = 1.0f, zfar = 10000.0f;
+	const matrix4x4f proj = matrix4x4f::PerspectiveMatrix(float(M_PI) * 0.5f, 16.0f / 9.0f, znear, zfar);
+	LightClusters clusters;
+
+	SUBCASE("Every lit point finds its light")
+	{
+		std::mt19937 rng(1);
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		std::vector<Graphics::PointLight> lights(100);
+		for (Graphics::PointLight &l : lights) {
+			const float depth = std::exp((unit(rng) + 1.0f) * 4.0f);
+			l.position = vector3f(unit(rng) * depth, unit(rng) * depth * 0.5f, -depth);
+			l.radius = depth * (unit(rng) + 1.2f) * 0.2f;
+			l.colour = Color4f(1.0f);
+		}
+		clusters.Build(proj, znear, zfar, lights.data(), uint32_t(lights.size()));
+		REQUIRE(clusters.GetLights().size() == lights.size());
+		REQUIRE(clusters.GetNumDropped() == 0);
+
+		// points within reach of a light must land in a cluster listing it
+		uint32_t tested = 0;
+		for (uint16_t i = 0; i < clusters.GetLights().size(); i++) {
+			const Graphics::PointLight &l = clusters.GetLights()[i];
+			for (int n = 0; n < 200; n++) {
+				const vector3f p = l.position + vector3f(unit(rng), unit(rng), unit(rng)) * (l.radius * 0.577f);
+				if (-p.z < znear || -p.z > zfar)
+					continue;
+				tested++;
+				CHECK(ClusterHasLight(clusters, ClusterOf(clusters, proj, p), i));
+			}
+		}
+		CHECK(tested > 10000);
+	}
+
+	SUBCASE("A small light stays in a few clusters")
+	{
+		const Graphics::PointLight light = { vector3f(0.0f, 0.0f, -100.0f), 1.0f, Color4f(1.0f) };
+		clusters.Build(proj, znear, zfar, &light, 1);
+		CHECK(clusters.GetIndices().size() <= 8);
+		CHECK(ClusterHasLight(clusters, ClusterOf(clusters, proj, light.position), 0));
+
+		// and lights out of view don't show up at all
+		const Graphics::PointLight behind = { vector3f(0.0f, 0.0f, 100.0f), 1.0f, Color4f(1.0f) };
+		const Graphics::PointLight beside = { vector3f(1000.0f, 0.0f, -100.0f), 1.0f, Color4f(1.0f) };
+		clusters.Build(proj, znear, zfar, &behind, 1);
+		CHECK(clusters.GetLights().empty());
+		clusters.Build(proj, znear, zfar, &beside, 1);
+		CHECK(clusters.GetIndices().empty());
+	}
+
+	SUBCASE("The nearest lights are kept")
+	{
+		std::vector<Graphics::PointLight> lights;
+		for (uint32_t i = 0; i < LightClusters::MAX_LIGHTS * 2; i++)
+			lights.push_back({ vector3f(0.0f, 0.0f, -10.0f - float(i)), 0.5f, Color4f(1.0f) });
+		std::reverse(lights.begin(), lights.end());
+		clusters.Build(proj, znear, zfar, lights.data(), uint32_t(lights.size()));
+		REQUIRE(clusters.GetLights().size() == LightClusters::MAX_LIGHTS);
+		CHECK(clusters.GetLights().front().position.z == -10.0f);
+		CHECK(clusters.GetLights().back().position.z > -10.0f - float(LightClusters::MAX_LIGHTS));
+	}
+
+	SUBCASE("Benchmark")
+	{
+		std::mt19937 rng(2);
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		std::vector<Graphics::PointLight> lights(LightClusters::MAX_LIGHTS);
+		for (Graphics::PointLight &l : lights) {
+			const float depth = std::exp((unit(rng) + 1.0f) * 3.0f);
+			l.position = vector3f(unit(rng) * depth, unit(rng) * depth * 0.5f, -depth);
+			l.radius = depth * 0.1f;
+			l.colour = Color4f(1.0f);
+		}
+		Profiler::Clock clock{};
+		clock.Start();
+		for (int i = 0; i < 1000; i++)
+			clusters.Build(proj, znear, zfar, lights.data(), uint32_t(lights.size()));
+		clock.Stop();
+		printf("LightClusters: %u lights, %zu indices, %.3f us per build\n",
+			LightClusters::MAX_LIGHTS, clusters.GetIndices().size(), clock.milliseconds());
+	}
+}
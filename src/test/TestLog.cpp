@@ -0,0 +1,50 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "core/Log.h"
+#include "doctest.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Async log callbacks")
+{
+	Log::Logger log;
+	// keep the test output quiet
+	log.SetSeverity(Log::Severity::Fatal);
+	log.SetMsgSeverity(Log::Severity::Fatal);
+
+	std::vector<std::string> received;
+	log.printCallback.connect([&](Time::DateTime, Log::Severity, std::string_view msg) {
+		received.emplace_back(msg);
+	});
+
+	log.SetAsync(true);
+	REQUIRE(log.IsAsync());
+
+	// messages from the main thread are delivered immediately
+	log.LogLevel(Log::Severity::Info, "main thread\n");
+	REQUIRE(received.size() == 1);
+	CHECK(received[0] == "main thread");
+
+	// others wait for the main thread to dispatch them
+	std::thread worker([&]() {
+		log.LogLevel(Log::Severity::Info, "worker one");
+		log.LogLevel(Log::Severity::Debug, "worker two");
+	});
+	worker.join();
+	CHECK(received.size() == 1);
+
+	log.DispatchCallbacks();
+	REQUIRE(received.size() == 3);
+	CHECK(received[1] == "worker one");
+	CHECK(received[2] == "worker two");
+
+	// pending callbacks are delivered when async mode ends
+	std::thread([&]() { log.LogLevel(Log::Severity::Info, "last"); }).join();
+	log.SetAsync(false);
+	CHECK(!log.IsAsync());
+	REQUIRE(received.size() == 4);
+	CHECK(received[3] == "last");
+}
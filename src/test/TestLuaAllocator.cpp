@@ -0,0 +1,104 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "lua/LuaAllocator.h"
+
+#include "doctest.h"
+#include "profiler/Profiler.h"
+
+#include <lua.hpp>
+
+#include <cstdlib>
+#include <cstring>
+
+static const char *s_churnScript = R"(
+	local keep = {}
+	for i = 1, 200000 do
+		local t = { x = i, y = i * 2, name = "item" .. i }
+		if i % 10 == 0 then keep[#keep + 1] = t end
+	end
+	local big = {}
+	for i = 1, 10000 do big[i] = i end
+	return #keep + #big
+)";
+
+static void *default_alloc(void *, void *ptr, size_t, size_t nsize)
+{
+	if (nsize == 0) {
+		std::free(ptr);
+		return nullptr;
+	}
+	return std::realloc(ptr, nsize);
+}
+
+static double run_churn(lua_State *l)
+{
+	luaL_openlibs(l);
+	Profiler::Clock clock{};
+	clock.Start();
+	REQUIRE(luaL_dostring(l, s_churnScript) == LUA_OK);
+	clock.Stop();
+	CHECK(lua_tointeger(l, -1) == 30000);
+	lua_close(l);
+	return clock.milliseconds();
+}
+
+TEST_CASE("Lua Allocator")
+{
+	SUBCASE("Reallocation keeps contents")
+	{
+		LuaAllocator alloc;
+
+		char *a = static_cast<char *>(alloc.Reallocate(nullptr, LUA_TTABLE, 10));
+		std::memcpy(a, "0123456789", 10);
+		CHECK(alloc.GetNumBlocks(0) == 1);
+
+		// same class, the block is kept
+		CHECK(alloc.Reallocate(a, 10, 16) == a);
+
+		// small class to small class
+		a = static_cast<char *>(alloc.Reallocate(a, 16, 100));
+		CHECK(std::memcmp(a, "0123456789", 10) == 0);
+		CHECK(alloc.GetNumBlocks(0) == 0);
+		CHECK(alloc.GetNumBlocks((100 - 1) / LuaAllocator::GRANULARITY) == 1);
+
+		// small to large and back again
+		a = static_cast<char *>(alloc.Reallocate(a, 100, 4096));
+		CHECK(std::memcmp(a, "0123456789", 10) == 0);
+		CHECK(alloc.GetStats().largeBytes == 4096);
+		a = static_cast<char *>(alloc.Reallocate(a, 4096, 12));
+		CHECK(std::memcmp(a, "0123456789", 10) == 0);
+		CHECK(alloc.GetStats().largeBytes == 0);
+
+		CHECK(alloc.GetStats().bytesInUse == 12);
+		alloc.Reallocate(a, 12, 0);
+		CHECK(alloc.GetStats().bytesInUse == 0);
+		CHECK(alloc.GetStats().pooledBytes == 0);
+	}
+
+	SUBCASE("Freed blocks are reused")
+	{
+		LuaAllocator alloc;
+		void *a = alloc.Reallocate(nullptr, 0, 40);
+		alloc.Reallocate(a, 40, 0);
+		CHECK(alloc.Reallocate(nullptr, 0, 33) == a);
+		CHECK(alloc.GetStats().slabBytes == LuaAllocator::SLAB_SIZE);
+	}
+
+	SUBCASE("Lua state churn")
+	{
+		LuaAllocator alloc;
+		const double pooled = run_churn(lua_newstate(&LuaAllocator::Alloc, &alloc));
+		const double system = run_churn(lua_newstate(&default_alloc, nullptr));
+
+		// everything is given back when the state is closed
+		const LuaAllocator::Stats &stats = alloc.GetStats();
+		CHECK(stats.bytesInUse == 0);
+		CHECK(stats.pooledBytes == 0);
+		CHECK(stats.largeBytes == 0);
+		CHECK(stats.numAllocs == stats.numFrees);
+
+		printf("Lua allocation churn: size-class pools %.2f ms, system allocator %.2f ms (%llu allocations)\n",
+			pooled, system, (unsigned long long)stats.numAllocs);
+	}
+}
@@ -0,0 +1,64 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "lua/LuaJson.h"
+#include "lua/LuaUtils.h"
+
+#include "doctest.h"
+
+TEST_CASE("LuaJson TableBuilder")
+{
+	lua_State *l = luaL_newstate();
+	luaL_openlibs(l);
+
+	const Json doc = Json::parse(R"({
+		"name": "Sol",
+		"bodies": [ { "name": "Earth", "radius": 1.0 }, { "name": "Mars", "moons": [ "Phobos", "Deimos" ] } ],
+		"empty": {},
+		"habitable": true,
+		"count": 9
+	})");
+
+	SUBCASE("A few values at a time")
+	{
+		LuaJson::TableBuilder builder{ Json(doc) };
+		int calls = 0;
+		size_t budget = 0;
+		do {
+			budget = 3;
+			++calls;
+		} while (!builder.Build(l, budget));
+
+		// 13 values below the root, the last of them added in the fifth call
+		CHECK(calls == 5);
+		CHECK(lua_gettop(l) == 1);
+		lua_setglobal(l, "doc");
+		luaL_dostring(l, "return doc.name == 'Sol' and doc.bodies[1].name == 'Earth' and doc.bodies[1].radius == 1.0 "
+						 "and doc.bodies[2].moons[2] == 'Deimos' and #doc.bodies == 2 and next(doc.empty) == nil "
+						 "and doc.habitable == true and doc.count == 9");
+		CHECK(lua_toboolean(l, -1));
+		lua_pop(l, 1);
+	}
+
+	SUBCASE("Budget is only spent on values")
+	{
+		LuaJson::TableBuilder builder{ Json(doc) };
+		size_t budget = 100;
+		CHECK(builder.Build(l, budget));
+		CHECK(budget == 100 - 13);
+		CHECK(lua_istable(l, -1));
+		lua_pop(l, 1);
+	}
+
+	SUBCASE("Scalar documents")
+	{
+		LuaJson::TableBuilder builder{ Json("text") };
+		size_t budget = 0;
+		CHECK(builder.Build(l, budget));
+		CHECK(std::string(lua_tostring(l, -1)) == "text");
+		lua_pop(l, 1);
+	}
+
+	CHECK(lua_gettop(l) == 0);
+	lua_close(l);
+}
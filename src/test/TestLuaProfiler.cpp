@@ -0,0 +1,75 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "lua/LuaProfiler.h"
+
+#include "doctest.h"
+
+#include <lua.hpp>
+
+static const char *s_profileScript = R"(
+	local function busy(n)
+		local t = 0
+		for i = 1, n do t = t + math.sin(i) end
+		return t
+	end
+
+	local function garbage(n)
+		local list = {}
+		for i = 1, n do list[i] = { i } end
+		return #list
+	end
+
+	busy(2000000)
+	garbage(100000)
+)";
+
+TEST_CASE("Lua Profiler")
+{
+	lua_State *l = luaL_newstate();
+	luaL_openlibs(l);
+
+	LuaProfiler profiler;
+	profiler.Start(l, 100);
+	CHECK(profiler.IsRunning());
+	REQUIRE(luaL_dostring(l, s_profileScript) == LUA_OK);
+	profiler.Stop();
+	CHECK(!profiler.IsRunning());
+
+	const std::vector<LuaProfiler::FunctionStats> functions = profiler.GetFunctionStats();
+	REQUIRE(functions.size() >= 2);
+
+	const LuaProfiler::FunctionStats *busy = nullptr;
+	const LuaProfiler::FunctionStats *garbage = nullptr;
+	for (const auto &fn : functions) {
+		if (fn.name == "busy")
+			busy = &fn;
+		else if (fn.name == "garbage")
+			garbage = &fn;
+	}
+
+	REQUIRE(busy);
+	REQUIRE(garbage);
+
+	// busy() runs far more instructions, garbage() allocates far more memory
+	CHECK(busy->samples > garbage->samples);
+	CHECK(garbage->allocBytes > busy->allocBytes);
+	CHECK(garbage->allocBytes > 100000 * 16);
+
+	CHECK(profiler.GetTotalSamples() > 0);
+	CHECK(profiler.GetGCStats().allocCount >= 100000);
+
+	// everything comes from the one chunk
+	const std::vector<LuaProfiler::FunctionStats> files = profiler.GetFileStats();
+	REQUIRE(files.size() == 1);
+	CHECK(files[0].samples == profiler.GetTotalSamples());
+
+	profiler.Reset();
+	CHECK(profiler.GetFunctionStats().empty());
+	CHECK(profiler.GetTotalSamples() == 0);
+
+	// the state keeps working on its original allocator
+	CHECK(luaL_dostring(l, "return #string.rep('x', 1000)") == LUA_OK);
+
+	lua_close(l);
+}
@@ -3,6 +3,8 @@
 
 #include "lua/Lua.h"
 #include "lua/LuaPushPull.h"
+#include "lua/LuaVector.h"
+#include "profiler/Profiler.h"
 
 #include <fmt/core.h>
 
@@ -89,3 +91,62 @@ TEST_CASE("Lua Push / Pull Basic Values")
 
 	lua_close(l);
 }
+
+// stands in for a binding like Body:GetPositionRelTo(other, out)
+static int l_test_position(lua_State *l)
+{
+	LuaVector::PushToLuaReuse(l, vector3d(1.0, 2.0, 3.0), 1);
+	return 1;
+}
+
+static const char *s_gcPressureScript = R"(
+	local out = ...
+	collectgarbage("collect")
+	collectgarbage("stop")
+	local before = collectgarbage("count")
+	for i = 1, 100000 do
+		local v = test_position(out)
+		assert(v.z == 3)
+	end
+	local used = collectgarbage("count") - before
+	collectgarbage("restart")
+	return used
+)";
+
+TEST_CASE("Lua Vector3 GC Pressure")
+{
+	lua_State *l = luaL_newstate();
+	luaL_openlibs(l);
+	LuaVector::Register(l);
+	lua_register(l, "test_position", l_test_position);
+
+	REQUIRE(luaL_loadstring(l, s_gcPressureScript) == LUA_OK);
+	const int script = lua_gettop(l);
+
+	auto run = [&](bool reuse) {
+		lua_pushvalue(l, script);
+		if (reuse)
+			LuaVector::PushToLua(l, vector3d(0.0));
+		else
+			lua_pushnil(l);
+
+		Profiler::Clock clock{};
+		clock.Start();
+		REQUIRE(lua_pcall(l, 1, 1, 0) == LUA_OK);
+		clock.Stop();
+
+		const double kb = lua_tonumber(l, -1);
+		lua_pop(l, 1);
+		printf("Vector3 GC pressure (%s): %.0f KB in %.2f ms\n", reuse ? "reused out vector" : "new vectors", kb, clock.milliseconds());
+		return kb;
+	};
+
+	const double allocating = run(false);
+	const double reusing = run(true);
+
+	// 100k userdata allocations vs. (almost) none at all
+	CHECK(allocating > 1000.0);
+	CHECK(reusing < allocating / 100.0);
+
+	lua_close(l);
+}
@@ -0,0 +1,81 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "lua/LuaUtils.h"
+#include "lua/LuaWorker.h"
+
+#include "doctest.h"
+
+#include <string>
+
+static const std::string WORKER_SCRIPT = R"(
+	local calls = 0
+	return {
+		Sum = function (args)
+			calls = calls + 1
+			local total = 0
+			for _, v in ipairs(args.values) do total = total + v end
+			return { name = args.name, total = total, calls = calls }
+		end,
+		Fail = function () error("bad input") end,
+		Leak = function () return print end,
+	}
+)";
+
+TEST_CASE("LuaWorker")
+{
+	lua_State *l = LuaWorker::NewState();
+
+	SUBCASE("Messages")
+	{
+		luaL_dostring(l, "return { 1, 2.5, 'three', nested = { flag = true, none = false } }");
+		std::string message, error;
+		REQUIRE(LuaWorker::Pack(l, -1, message, error));
+		lua_pop(l, 1);
+
+		lua_State *other = LuaWorker::NewState();
+		LuaWorker::Unpack(other, message);
+		lua_setglobal(other, "t");
+		luaL_dostring(other, "return t[1] == 1 and t[2] == 2.5 and t[3] == 'three' and t.nested.flag == true and t.nested.none == false");
+		CHECK(lua_toboolean(other, -1));
+		lua_close(other);
+
+		luaL_dostring(l, "local t = {} t.self = t return t");
+		CHECK(!LuaWorker::Pack(l, -1, message, error));
+		lua_pop(l, 1);
+
+		lua_pushcfunction(l, [](lua_State *) { return 0; });
+		CHECK(!LuaWorker::Pack(l, -1, message, error));
+		lua_pop(l, 1);
+	}
+
+	SUBCASE("Calls")
+	{
+		std::string args, error, result;
+		luaL_dostring(l, "return { name = 'cargo', values = { 1, 2, 3 } }");
+		REQUIRE(LuaWorker::Pack(l, -1, args, error));
+		lua_pop(l, 1);
+
+		REQUIRE(LuaWorker::Call(l, "test.lua", WORKER_SCRIPT, "Sum", args, result));
+		// the module is only loaded once per state
+		REQUIRE(LuaWorker::Call(l, "test.lua", WORKER_SCRIPT, "Sum", args, result));
+		LuaWorker::Unpack(l, result);
+		lua_getfield(l, -1, "name");
+		CHECK(std::string(lua_tostring(l, -1)) == "cargo");
+		lua_getfield(l, -2, "total");
+		CHECK(lua_tonumber(l, -1) == 6.0);
+		lua_getfield(l, -3, "calls");
+		CHECK(lua_tonumber(l, -1) == 2.0);
+		lua_pop(l, 4);
+
+		CHECK(!LuaWorker::Call(l, "test.lua", WORKER_SCRIPT, "Fail", args, result));
+		CHECK(result.find("bad input") != std::string::npos);
+		CHECK(!LuaWorker::Call(l, "test.lua", WORKER_SCRIPT, "Missing", args, result));
+		// print is removed from worker states
+		CHECK(LuaWorker::Call(l, "test.lua", WORKER_SCRIPT, "Leak", args, result));
+		CHECK(!LuaWorker::Call(l, "broken.lua", "return 1 +", "Sum", args, result));
+		CHECK(lua_gettop(l) == 0);
+	}
+
+	lua_close(l);
+}
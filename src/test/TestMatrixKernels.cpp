@@ -0,0 +1,75 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "MatrixKernels.h"
+#include "doctest.h"
+#include "matrix4x4.h"
+
+#include <random>
+#include <vector>
+
+template <typename T>
+static void CheckMul()
+{
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<T> dist(-100, 100);
+	T a[16], b[16], expected[16], out[16];
+	for (int i = 0; i < 16; i++)
+		a[i] = dist(rng), b[i] = dist(rng);
+
+	MatrixKernels::MulScalar(a, b, expected);
+	MatrixKernels::Mul(a, b, out);
+	for (int i = 0; i < 16; i++)
+		CHECK(out[i] == doctest::Approx(expected[i]).epsilon(1e-6));
+}
+
+template <typename T>
+static void CheckTransformPoints(size_t count)
+{
+	std::mt19937 rng(11);
+	std::uniform_real_distribution<T> dist(-1000, 1000);
+	matrix4x4<T> m = matrix4x4<T>::RotateMatrix(T(0.7), T(0.2), T(-0.5), T(0.8));
+	m.SetTranslate(vector3<T>(dist(rng), dist(rng), dist(rng)));
+
+	std::vector<vector3<T>> points(count);
+	for (auto &p : points)
+		p = vector3<T>(dist(rng), dist(rng), dist(rng));
+
+	std::vector<vector3<T>> out(count);
+	m.TransformPoints(points.data(), out.data(), count);
+	for (size_t i = 0; i < count; i++) {
+		const vector3<T> expected = m * points[i];
+		CHECK(out[i].x == doctest::Approx(expected.x).epsilon(1e-6));
+		CHECK(out[i].y == doctest::Approx(expected.y).epsilon(1e-6));
+		CHECK(out[i].z == doctest::Approx(expected.z).epsilon(1e-6));
+	}
+
+	// in place
+	m.TransformPoints(points.data(), points.data(), count);
+	for (size_t i = 0; i < count; i++)
+		CHECK(points[i] == out[i]);
+}
+
+TEST_CASE("MatrixKernels multiply")
+{
+	CheckMul<float>();
+	CheckMul<double>();
+
+	// the operator goes through the kernels and keeps the column-major order
+	const matrix4x4d rotate = matrix4x4d::RotateZMatrix(0.5);
+	const matrix4x4d translate = matrix4x4d::Translation(1.0, 2.0, 3.0);
+	const vector3d p(4.0, 5.0, 6.0);
+	const vector3d a = (translate * rotate) * p, b = translate * (rotate * p);
+	CHECK(a.x == doctest::Approx(b.x));
+	CHECK(a.y == doctest::Approx(b.y));
+	CHECK(a.z == doctest::Approx(b.z));
+}
+
+TEST_CASE("MatrixKernels point transforms")
+{
+	// including counts that leave a point for the scalar tail
+	for (size_t count : { 0, 1, 2, 7, 64 }) {
+		CheckTransformPoints<float>(count);
+		CheckTransformPoints<double>(count);
+	}
+}
@@ -0,0 +1,59 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "Json.h"
+#include "core/MemoryStats.h"
+#include "doctest.h"
+
+TEST_CASE("MemoryStats counters")
+{
+	// the counters are global, so only look at changes
+	const MemoryStats::Usage before = MemoryStats::Get(MemoryStats::TAG_MODELS);
+	MemoryStats::ResetPeaks();
+
+	MemoryStats::Add(MemoryStats::TAG_MODELS, 1000);
+	MemoryStats::Add(MemoryStats::TAG_MODELS, 500);
+	MemoryStats::Sub(MemoryStats::TAG_MODELS, 1200);
+
+	MemoryStats::Usage usage = MemoryStats::Get(MemoryStats::TAG_MODELS);
+	CHECK(usage.current == before.current + 300);
+	CHECK(usage.peak == before.current + 1500);
+
+	MemoryStats::ResetPeaks();
+	usage = MemoryStats::Get(MemoryStats::TAG_MODELS);
+	CHECK(usage.peak == usage.current);
+
+	MemoryStats::Sub(MemoryStats::TAG_MODELS, 300);
+	CHECK(MemoryStats::Get(MemoryStats::TAG_MODELS).current == before.current);
+}
+
+TEST_CASE("MemoryStats reporters")
+{
+	size_t reported = 4096;
+	MemoryStats::SetReporter(MemoryStats::TAG_LUA, [&]() { return reported; });
+	MemoryStats::ResetPeaks();
+
+	CHECK(MemoryStats::Get(MemoryStats::TAG_LUA).current == 4096);
+	reported = 8192;
+	CHECK(MemoryStats::Get(MemoryStats::TAG_LUA).peak == 8192);
+	reported = 1024;
+
+	const Json json = MemoryStats::ToJson();
+	CHECK(json["lua"]["currentBytes"] == 1024);
+	CHECK(json["lua"]["peakBytes"] == 8192);
+	CHECK(json.size() == MemoryStats::TAG_MAX);
+
+	MemoryStats::SetReporter(MemoryStats::TAG_LUA, nullptr);
+}
+
+TEST_CASE("MemoryStats JSON estimate")
+{
+	const Json empty = Json::object();
+	Json tree = Json::object();
+	tree["name"] = std::string(1000, 'x');
+	tree["values"] = Json::array({ 1, 2, 3 });
+
+	const size_t bytes = MemoryStats::EstimateJsonBytes(tree);
+	CHECK(bytes > MemoryStats::EstimateJsonBytes(empty) + 1000);
+	CHECK(bytes < 2000);
+}
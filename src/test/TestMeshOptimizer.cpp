@@ -0,0 +1,93 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "doctest.h"
+#include "scenegraph/MeshOptimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <random>
+
+using namespace SceneGraph;
+
+// a grid with its triangles in random order
+static void MakeShuffledGrid(Uint32 size, std::vector<vector3f> &positions, std::vector<Uint32> &indices)
+{
+	for (Uint32 y = 0; y <= size; y++)
+		for (Uint32 x = 0; x <= size; x++)
+			positions.push_back(vector3f(float(x), float(y), 0.0f));
+
+	std::vector<std::array<Uint32, 3>> tris;
+	for (Uint32 y = 0; y < size; y++)
+		for (Uint32 x = 0; x < size; x++) {
+			const Uint32 a = y * (size + 1) + x, b = a + size + 1;
+			tris.push_back({ a, a + 1, b + 1 });
+			tris.push_back({ a, b + 1, b });
+		}
+	std::mt19937 rng(1234);
+	std::shuffle(tris.begin(), tris.end(), rng);
+	for (auto &t : tris)
+		indices.insert(indices.end(), t.begin(), t.end());
+}
+
+// the triangles as rotation independent keys, to compare orderings
+static std::vector<std::array<Uint32, 3>> SortedTriangles(const std::vector<Uint32> &indices)
+{
+	std::vector<std::array<Uint32, 3>> tris;
+	for (size_t i = 0; i < indices.size(); i += 3) {
+		std::array<Uint32, 3> t = { indices[i], indices[i + 1], indices[i + 2] };
+		std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+		tris.push_back(t);
+	}
+	std::sort(tris.begin(), tris.end());
+	return tris;
+}
+
+TEST_CASE("Mesh Optimizer")
+{
+	const Uint32 size = 30;
+	std::vector<vector3f> positions;
+	std::vector<Uint32> indices;
+	MakeShuffledGrid(size, positions, indices);
+	const Uint32 numVertices = Uint32(positions.size());
+	const std::vector<Uint32> original = indices;
+
+	SUBCASE("Vertex cache order reuses vertices")
+	{
+		const float before = CalcCacheMissRatio(indices);
+		OptimizeVertexCache(indices, numVertices);
+		const float after = CalcCacheMissRatio(indices);
+		CHECK(before > 2.0f);
+		CHECK(after < 1.0f);
+		CHECK(SortedTriangles(indices) == SortedTriangles(original));
+	}
+
+	SUBCASE("Overdraw order keeps the triangles and most of the cache order")
+	{
+		OptimizeVertexCache(indices, numVertices);
+		const float cacheOnly = CalcCacheMissRatio(indices);
+		OptimizeOverdraw(indices, positions);
+		CHECK(SortedTriangles(indices) == SortedTriangles(original));
+		CHECK(CalcCacheMissRatio(indices) < cacheOnly * 1.1f);
+	}
+
+	SUBCASE("Vertex fetch order follows first use")
+	{
+		std::vector<Uint32> remapped = indices;
+		const std::vector<Uint32> remap = OptimizeVertexFetch(remapped, numVertices + 1);
+		REQUIRE(remap.size() == numVertices + 1);
+		CHECK(remapped[0] == 0);
+		Uint32 highest = 0;
+		for (size_t i = 0; i < remapped.size(); i++) {
+			CHECK(remapped[i] == remap[indices[i]]);
+			CHECK(remapped[i] <= highest + 1);
+			highest = std::max(highest, remapped[i]);
+		}
+		// the unused vertex goes last
+		CHECK(remap[numVertices] == numVertices);
+		std::vector<Uint32> sorted = remap;
+		std::sort(sorted.begin(), sorted.end());
+		for (Uint32 i = 0; i < sorted.size(); i++)
+			CHECK(sorted[i] == i);
+	}
+}
@@ -0,0 +1,110 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "doctest.h"
+#include "scenegraph/MeshSimplifier.h"
+
+#include <cmath>
+
+using SceneGraph::SimplifyMesh;
+
+// a sphere split along one meridian, the way a uv mapped one is
+static void MakeSphere(Uint32 rings, Uint32 segments, std::vector<vector3f> &positions, std::vector<Uint32> &indices)
+{
+	for (Uint32 r = 0; r <= rings; r++)
+		for (Uint32 s = 0; s <= segments; s++) {
+			const float lat = float(M_PI) * float(r) / float(rings);
+			const float lon = 2.0f * float(M_PI) * float(s % segments) / float(segments);
+			const float ringRadius = (r == 0 || r == rings) ? 0.0f : std::sin(lat);
+			positions.push_back(vector3f(ringRadius * std::cos(lon), std::cos(lat), ringRadius * std::sin(lon)));
+		}
+	for (Uint32 r = 0; r < rings; r++)
+		for (Uint32 s = 0; s < segments; s++) {
+			const Uint32 a = r * (segments + 1) + s, b = a + segments + 1;
+			indices.insert(indices.end(), { a, a + 1, b, a + 1, b + 1, b });
+		}
+}
+
+static vector3f Normal(const std::vector<vector3f> &positions, const Uint32 *tri)
+{
+	return (positions[tri[1]] - positions[tri[0]]).Cross(positions[tri[2]] - positions[tri[0]]);
+}
+
+TEST_CASE("Mesh Simplifier")
+{
+	SUBCASE("A flat grid keeps its outline")
+	{
+		const Uint32 size = 20;
+		std::vector<vector3f> positions;
+		std::vector<Uint32> indices;
+		for (Uint32 y = 0; y <= size; y++)
+			for (Uint32 x = 0; x <= size; x++)
+				positions.push_back(vector3f(float(x), float(y), 0.0f));
+		for (Uint32 y = 0; y < size; y++)
+			for (Uint32 x = 0; x < size; x++) {
+				const Uint32 a = y * (size + 1) + x, b = a + size + 1;
+				indices.insert(indices.end(), { a, a + 1, b + 1, a, b + 1, b });
+			}
+
+		float error = -1.0f;
+		const std::vector<Uint32> result = SimplifyMesh(positions, indices, 0, 0.01f, &error);
+		CHECK(result.size() < indices.size() / 10);
+		CHECK(error >= 0.0f);
+		CHECK(error <= 0.01f);
+
+		// no holes and no overlaps: the triangles still cover the square once
+		float area = 0.0f, absArea = 0.0f;
+		for (size_t i = 0; i < result.size(); i += 3) {
+			const float z = Normal(positions, &result[i]).z * 0.5f;
+			area += z;
+			absArea += std::abs(z);
+		}
+		CHECK(area == doctest::Approx(float(size * size)));
+		CHECK(absArea == doctest::Approx(float(size * size)));
+	}
+
+	SUBCASE("Curved surfaces stay within the error")
+	{
+		std::vector<vector3f> positions;
+		std::vector<Uint32> indices;
+		MakeSphere(32, 64, positions, indices);
+
+		// which way the triangles face
+		const vector3f mid = positions[indices[indices.size() / 2]];
+		const float outward = Normal(positions, &indices[indices.size() / 2 - indices.size() / 2 % 3]).Dot(mid) > 0.0f ? 1.0f : -1.0f;
+
+		const float maxError = 0.01f;
+		float error = 0.0f;
+		const std::vector<Uint32> result = SimplifyMesh(positions, indices, 0, maxError, &error);
+		CHECK(result.size() < indices.size() / 2);
+		CHECK(error <= maxError);
+
+		for (size_t i = 0; i < result.size(); i += 3) {
+			const vector3f *p[3] = { &positions[result[i]], &positions[result[i + 1]], &positions[result[i + 2]] };
+			// not degenerate, even across the seam
+			CHECK_FALSE(*p[0] == *p[1]);
+			CHECK_FALSE(*p[1] == *p[2]);
+			CHECK_FALSE(*p[0] == *p[2]);
+			// still facing out
+			const vector3f centre = (*p[0] + *p[1] + *p[2]) / 3.0f;
+			CHECK(Normal(positions, &result[i]).Dot(centre) * outward > 0.0f);
+			// and close to the sphere
+			CHECK(centre.Length() > 1.0f - maxError * 4.0f);
+		}
+	}
+
+	SUBCASE("The target triangle count is met")
+	{
+		std::vector<vector3f> positions;
+		std::vector<Uint32> indices;
+		MakeSphere(16, 32, positions, indices);
+
+		const std::vector<Uint32> result = SimplifyMesh(positions, indices, indices.size() / 4, 1.0f);
+		CHECK(result.size() <= indices.size() / 4);
+		CHECK(result.size() > indices.size() / 8);
+
+		// and nothing happens without any error allowed on a curved surface
+		const std::vector<Uint32> same = SimplifyMesh(positions, indices, 0, 0.0f);
+		CHECK(same.size() > indices.size() * 3 / 4);
+	}
+}
@@ -0,0 +1,57 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "doctest.h"
+#include "sound/MixKernels.h"
+
+#include <cstddef>
+#include <vector>
+
+// Straightforward per-frame version of MixKernels::Mix
+template <int T_channels, int T_upsample>
+static void ReferenceMix(float *out, const int16_t *in, uint32_t frames, float gainL, float gainR, float stepL, float stepR)
+{
+	for (uint32_t j = 0; j < frames * T_upsample; j++) {
+		const uint32_t src = (j / T_upsample) * T_channels;
+		out[2 * j] += in[src] * (gainL + stepL * j);
+		out[2 * j + 1] += in[src + T_channels - 1] * (gainR + stepR * j);
+	}
+}
+
+template <int T_channels, int T_upsample>
+static void CheckMix(uint32_t frames)
+{
+	std::vector<int16_t> in(frames * T_channels);
+	for (size_t i = 0; i < in.size(); i++)
+		in[i] = int16_t((i * 7919) % 65536 - 32768);
+
+	std::vector<float> expected(frames * T_upsample * 2, 1.f);
+	std::vector<float> mixed(expected);
+	ReferenceMix<T_channels, T_upsample>(expected.data(), in.data(), frames, 0.5f, 0.25f, 0.001f, -0.002f);
+	MixKernels::Mix<T_channels, T_upsample>(mixed.data(), in.data(), frames, 0.5f, 0.25f, 0.001f, -0.002f);
+
+	for (size_t i = 0; i < mixed.size(); i++)
+		CHECK(mixed[i] == doctest::Approx(expected[i]).epsilon(1e-4));
+}
+
+TEST_CASE("MixKernels mixing")
+{
+	// odd frame counts leave a frame for the scalar tail
+	CheckMix<1, 1>(64);
+	CheckMix<1, 1>(63);
+	CheckMix<2, 1>(64);
+	CheckMix<2, 1>(63);
+	CheckMix<1, 2>(33);
+	CheckMix<2, 2>(33);
+}
+
+TEST_CASE("MixKernels conversion")
+{
+	const std::vector<float> in = { 0.f, 1.9f, -1.9f, 100.f, -100.f, 40000.f, -40000.f, 16383.5f, -16383.5f, 3e9f, -3e9f };
+	std::vector<int16_t> out(in.size());
+	MixKernels::ToS16(out.data(), in.data(), uint32_t(in.size()), 2.f);
+
+	// scaled, truncated towards zero and clamped
+	const std::vector<int16_t> expected = { 0, 3, -3, 200, -200, 32767, -32768, 32767, -32767, 32767, -32768 };
+	CHECK(out == expected);
+}
@@ -0,0 +1,47 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "galaxy/NameGenerator.h"
+#include "doctest.h"
+
+#include <string>
+#include <vector>
+
+template <typename Generator>
+static std::vector<std::string> GetNames(Generator generator, Uint32 seed, size_t count)
+{
+	Random rng(seed);
+	std::vector<std::string> names;
+	for (size_t i = 0; i < count; i++) {
+		names.emplace_back();
+		generator(names.back(), rng);
+	}
+	return names;
+}
+
+TEST_CASE("NameGenerator")
+{
+	// system names are part of the galaxy, so a seed must always give the same ones
+	SUBCASE("Names are stable")
+	{
+		using Names = std::vector<std::string>;
+		CHECK(GetNames(FrontierNames::GetName, 42, 4) == Names{ "Edtize", "Olar", "Neandack", "Cequ" });
+		CHECK(GetNames(HybridNames::GetName, 42, 4) == Names{ "Hirtarla", "Ashbur", "Olwaya", "Ukshir" });
+		CHECK(GetNames(Doomdark::GetName, 42, 4) == Names{ "Duelun", "Ulformesh", "Hagildrand", "Thisarg" });
+		CHECK(GetNames(Katakana::GetName, 42, 4) == Names{ "Zurekaya", "Moyoma", "Nemi", "Daryu" });
+		CHECK(GetNames(NameGenerator::GetSystemName, 7, 4) == Names{ "Thigrne", "Zarangreon", "Udreskiz", "Soar" });
+	}
+
+	SUBCASE("Batches match single names")
+	{
+		const std::vector<std::string> single = GetNames(NameGenerator::GetSystemName, 1234, 1000);
+
+		Random rng(1234);
+		std::vector<std::string> batch = { "existing" };
+		NameGenerator::GetSystemNames(batch, 1000, rng);
+
+		REQUIRE(batch.size() == 1001);
+		CHECK(batch.front() == "existing");
+		CHECK(std::vector<std::string>(batch.begin() + 1, batch.end()) == single);
+	}
+}
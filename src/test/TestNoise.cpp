@@ -0,0 +1,100 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "doctest.h"
+#include "perlin.h"
+#include "profiler/Profiler.h"
+#include "terrain/TerrainNoise.h"
+
+#include <random>
+#include <vector>
+
+using namespace TerrainNoise;
+
+// points on a planet-sized sphere at terrain frequencies, and a few on the
+// integer lattice where the scalar floor steps down
+static std::vector<vector3d> MakeNoisePoints(std::mt19937 &rng, size_t count)
+{
+	std::uniform_real_distribution<double> coord(-1.0, 1.0);
+	std::vector<vector3d> points;
+	for (size_t i = 0; i < count; i++)
+		points.push_back(vector3d(coord(rng), coord(rng), coord(rng)).NormalizedSafe() * 1e5);
+	points.push_back(vector3d(0.0));
+	points.push_back(vector3d(-3.0, 2.0, -1.0));
+	points.push_back(vector3d(0.5, -0.5, 1e-9));
+	return points;
+}
+
+TEST_CASE("Batched noise")
+{
+	std::mt19937 rng(1357);
+	const std::vector<vector3d> points = MakeNoisePoints(rng, 1001);
+
+	SUBCASE("Matches scalar noise")
+	{
+		std::vector<double> batch(points.size());
+		noise(points.data(), batch.data(), points.size());
+		for (size_t i = 0; i < points.size(); i++)
+			CHECK(batch[i] == doctest::Approx(noise(points[i])).epsilon(1e-12));
+	}
+
+	SUBCASE("Matches scalar octave noise")
+	{
+		fracdef_t def;
+		def.amplitude = 1.0;
+		def.frequency = 1e-3;
+		def.lacunarity = 2.0;
+		def.octaves = 12;
+
+		std::uniform_real_distribution<double> unit(0.0, 1.0);
+		std::vector<double> persistence(points.size());
+		for (double &pers : persistence)
+			pers = 0.3 + 0.4 * unit(rng);
+
+		std::vector<double> out(points.size());
+		octavenoise(def, persistence.data(), points.data(), out.data(), points.size());
+		for (size_t i = 0; i < points.size(); i++)
+			CHECK(out[i] == doctest::Approx(octavenoise(def, persistence[i], points[i])).epsilon(1e-12));
+
+		octavenoise(def, 0.5, points.data(), out.data(), points.size());
+		for (size_t i = 0; i < points.size(); i++)
+			CHECK(out[i] == doctest::Approx(octavenoise(def, 0.5, points[i])).epsilon(1e-12));
+
+		ridged_octavenoise(def, persistence.data(), points.data(), out.data(), points.size());
+		for (size_t i = 0; i < points.size(); i++)
+			CHECK(out[i] == doctest::Approx(ridged_octavenoise(def, persistence[i], points[i])).epsilon(1e-12));
+
+		river_octavenoise(def, persistence.data(), points.data(), out.data(), points.size());
+		for (size_t i = 0; i < points.size(); i++)
+			CHECK(out[i] == doctest::Approx(river_octavenoise(def, persistence[i], points[i])).epsilon(1e-12));
+
+		dunes_octavenoise(def, persistence.data(), points.data(), out.data(), points.size());
+		for (size_t i = 0; i < points.size(); i++)
+			CHECK(out[i] == doctest::Approx(dunes_octavenoise(def, persistence[i], points[i])).epsilon(1e-12));
+	}
+
+	SUBCASE("Benchmark")
+	{
+		const std::vector<vector3d> benchPoints = MakeNoisePoints(rng, 200000);
+		std::vector<double> out(benchPoints.size());
+		Profiler::Clock clock{};
+
+		double sum = 0.0;
+		clock.Start();
+		for (const vector3d &p : benchPoints)
+			sum += noise(p);
+		clock.Stop();
+		const double scalarTime = clock.milliseconds();
+
+		clock.Reset();
+		clock.Start();
+		noise(benchPoints.data(), out.data(), benchPoints.size());
+		clock.Stop();
+		const double batchTime = clock.milliseconds();
+
+		for (double n : out)
+			sum -= n;
+		CHECK(fabs(sum) < 1e-6);
+		printf("noise: %zu points: scalar %.2f ms, batch %.2f ms\n", benchPoints.size(), scalarTime, batchTime);
+	}
+}
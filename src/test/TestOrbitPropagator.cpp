@@ -0,0 +1,156 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "OrbitPropagator.h"
+#include "doctest.h"
+#include "profiler/Profiler.h"
+
+#include <random>
+#include <vector>
+
+static const double SOLAR_MASS = 1.98892e30;
+static const double EARTH_MASS = 5.9742e24;
+static const double AU = 149598000000.0;
+
+// Planets with moons, then a belt of small bodies on eccentric orbits,
+// about the size of the Sol system's frame tree
+static std::vector<Orbit> MakeSystemOrbits(std::mt19937 &rng, int numPlanets, int numMoons, int numBelt)
+{
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+	auto randomOrbit = [&](double a, double centralMass, double e) {
+		Orbit orbit;
+		orbit.SetShapeAroundPrimary(a, centralMass, e);
+		orbit.SetPlane(matrix3x3d::RotateY(unit(rng) * 2.0 * M_PI) * matrix3x3d::RotateX(unit(rng) * 0.2 - 0.1));
+		orbit.SetPhase(unit(rng) * 2.0 * M_PI);
+		return orbit;
+	};
+
+	std::vector<Orbit> orbits;
+	for (int planet = 0; planet < numPlanets; planet++) {
+		orbits.push_back(randomOrbit(AU * (0.4 + planet * 0.7), SOLAR_MASS, unit(rng) * 0.2));
+		for (int moon = 0; moon < numMoons; moon++)
+			orbits.push_back(randomOrbit(1e8 * (1.0 + moon), EARTH_MASS * 50.0, unit(rng) * 0.3));
+	}
+	for (int i = 0; i < numBelt; i++)
+		orbits.push_back(randomOrbit(AU * (2.0 + unit(rng)), SOLAR_MASS, unit(rng) * 0.9));
+	return orbits;
+}
+
+TEST_CASE("Orbit Propagator")
+{
+	std::mt19937 rng(2468);
+	std::vector<Orbit> orbits = MakeSystemOrbits(rng, 10, 30, 40);
+	orbits.push_back(Orbit::ForStaticBody(vector3d(1e9, 2e9, 3e9)));
+	Orbit hyperbolic;
+	hyperbolic.SetShapeAroundPrimary(1e9, SOLAR_MASS, 1.5);
+	orbits.push_back(hyperbolic);
+
+	OrbitPropagator propagator;
+	for (const Orbit &orbit : orbits)
+		propagator.Add(orbit);
+	REQUIRE(propagator.GetNumOrbits() == orbits.size());
+
+	// the full solver stops at a tolerance of 1e-4 in E, so it is only
+	// accurate to around 1e-8 of the orbit's size
+	auto checkPositions = [&](double t, const std::vector<vector3d> &positions) {
+		for (size_t i = 0; i < orbits.size(); i++) {
+			const double tolerance = std::max(orbits[i].GetSemiMajorAxis(), 1.0) * 1e-7;
+			CHECK((positions[i] - orbits[i].OrbitalPosAtTime(t)).Length() < tolerance);
+		}
+	};
+
+	SUBCASE("Matches Orbit at 10000x time acceleration")
+	{
+		const double timestep = 10000.0 / 60.0;
+		double t = 1e9;
+		std::vector<vector3d> positions, velocities;
+		for (int step = 0; step < 200; step++) {
+			propagator.PropagateStep(t, timestep, positions, velocities);
+			if (step > 0)
+				CHECK(propagator.GetNumColdSolves() == 0);
+			if (step % 20 == 0) {
+				checkPositions(t, positions);
+				for (size_t i = 0; i < orbits.size(); i++) {
+					const vector3d vel = (orbits[i].OrbitalPosAtTime(t + timestep) - orbits[i].OrbitalPosAtTime(t)) / timestep;
+					CHECK((velocities[i] - vel).Length() < std::max(vel.Length(), 1.0) * 1e-5);
+				}
+			}
+			t += timestep;
+		}
+	}
+
+	SUBCASE("Time jumps fall back to the full solver")
+	{
+		std::vector<vector3d> positions;
+		propagator.Propagate(0.0, positions);
+		propagator.Propagate(1.0, positions);
+		CHECK(propagator.GetNumColdSolves() == 0);
+
+		propagator.Propagate(3.5e7, positions);
+		CHECK(propagator.GetNumColdSolves() > 0);
+		checkPositions(3.5e7, positions);
+	}
+
+	SUBCASE("Benchmark")
+	{
+		std::vector<Orbit> benchOrbits = MakeSystemOrbits(rng, 10, 30, 200);
+		OrbitPropagator benchPropagator;
+		for (const Orbit &orbit : benchOrbits)
+			benchPropagator.Add(orbit);
+
+		const int numSteps = 1000;
+		const double timestep = 10000.0 / 60.0;
+		Profiler::Clock clock{};
+
+		// as Frame::UpdateOrbitRails did before
+		std::vector<vector3d> positions(benchOrbits.size()), velocities(benchOrbits.size());
+		double t = 1e9;
+		clock.Start();
+		for (int step = 0; step < numSteps; step++, t += timestep) {
+			for (size_t i = 0; i < benchOrbits.size(); i++) {
+				positions[i] = benchOrbits[i].OrbitalPosAtTime(t);
+				velocities[i] = (benchOrbits[i].OrbitalPosAtTime(t + timestep) - positions[i]) / timestep;
+			}
+		}
+		clock.Stop();
+		const double orbitTime = clock.milliseconds();
+
+		t = 1e9;
+		clock.Reset();
+		clock.Start();
+		for (int step = 0; step < numSteps; step++, t += timestep)
+			benchPropagator.PropagateStep(t, timestep, positions, velocities);
+		clock.Stop();
+		const double propagatorTime = clock.milliseconds();
+
+		CHECK(benchPropagator.GetNumColdSolves() == 0);
+		printf("OrbitPropagator: %zu orbits x %d steps: Orbit::OrbitalPosAtTime %.2f ms, batch %.2f ms\n",
+			benchOrbits.size(), numSteps, orbitTime, propagatorTime);
+	}
+}
+
+TEST_CASE("Orbit positions at many times")
+{
+	std::mt19937 rng(1357);
+	std::vector<Orbit> orbits = MakeSystemOrbits(rng, 4, 2, 10);
+	orbits.push_back(Orbit::ForStaticBody(vector3d(1e9, 2e9, 3e9)));
+	Orbit hyperbolic;
+	hyperbolic.SetShapeAroundPrimary(1e9, SOLAR_MASS, 1.5);
+	orbits.push_back(hyperbolic);
+
+	// a trajectory preview, then times out of order
+	std::vector<double> times;
+	for (int i = 0; i < 100; i++)
+		times.push_back(1e9 + i * 3600.0);
+	times.push_back(0.0);
+	times.push_back(5e7);
+	times.push_back(-2e6);
+
+	std::vector<vector3d> positions(times.size());
+	for (const Orbit &orbit : orbits) {
+		orbit.OrbitalPosAtTimes(times.data(), times.size(), positions.data());
+		const double tolerance = std::max(orbit.GetSemiMajorAxis(), 1.0) * 1e-7;
+		for (size_t i = 0; i < times.size(); i++)
+			CHECK((positions[i] - orbit.OrbitalPosAtTime(times[i])).Length() < tolerance);
+	}
+}
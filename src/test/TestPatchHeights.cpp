@@ -0,0 +1,53 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "GeoPatchHeights.h"
+#include "doctest.h"
+#include "terrain/TerrainNoise.h"
+
+#include <vector>
+
+using namespace TerrainNoise;
+
+static const double EARTH_RADIUS = 6371000.0;
+static const double MAX_FEATURE_HEIGHT = 10000.0;
+static const int EDGE_LEN = 33;
+
+// Compares stored patch heights against the double heights they were
+// generated from, for patches from a whole cube face down to a few metres
+// across on an Earth-sized terrain, and prints the worst error per depth.
+TEST_CASE("Patch height precision")
+{
+	fracdef_t def;
+	def.amplitude = MAX_FEATURE_HEIGHT / EARTH_RADIUS;
+	def.frequency = EARTH_RADIUS / 1e5;
+	def.lacunarity = 2.0;
+	def.octaves = 13;
+
+	std::vector<double> heights(EDGE_LEN * EDGE_LEN);
+	double worstError = 0.0;
+	for (int depth = 0; depth <= 20; depth += 2) {
+		// patch on the +z face, offset so it isn't aligned with the noise lattice
+		const double size = 2.0 / double(1 << depth);
+		const double x0 = 0.1234 - size * 0.5, y0 = -0.4321 - size * 0.5;
+		for (int y = 0; y < EDGE_LEN; y++) {
+			for (int x = 0; x < EDGE_LEN; x++) {
+				const vector3d p = vector3d(x0 + size * x / (EDGE_LEN - 1), y0 + size * y / (EDGE_LEN - 1), 1.0).Normalized();
+				heights[x + y * EDGE_LEN] = def.amplitude * octavenoise(def, 0.5, p);
+			}
+		}
+
+		const double base = PatchHeights::GetBase(heights.data(), heights.size());
+		double maxError = 0.0, maxPlainFloatError = 0.0;
+		for (double h : heights) {
+			maxError = std::max(maxError, fabs(PatchHeights::Decode(PatchHeights::Encode(h, base), base) - h));
+			maxPlainFloatError = std::max(maxPlainFloatError, fabs(double(float(h)) - h));
+		}
+		printf("patch heights: depth %2d, %10.3f m patch: max error %.3g mm (plain float %.3g mm)\n",
+			depth, size * EARTH_RADIUS, maxError * EARTH_RADIUS * 1e3, maxPlainFloatError * EARTH_RADIUS * 1e3);
+		worstError = std::max(worstError, maxError);
+	}
+
+	// well inside the precision of the float vertex positions drawn from them
+	CHECK(worstError * EARTH_RADIUS < 1e-3);
+}
@@ -0,0 +1,42 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "doctest.h"
+#include "ship/PathCheckCache.h"
+
+TEST_CASE("PathCheckCache")
+{
+	// stands in for the obstructing body, which is only compared
+	const Body *planet = reinterpret_cast<const Body *>(&planet);
+	const vector3d pos(1e8, 0, 0);
+	const vector3d dir(-1, 0, 0);
+	const double dist = 5e7;
+	const double safeRad = 1e7;
+
+	PathCheckCache cache;
+	PathCheckCache::ResetStats();
+
+	int result = -1;
+	CHECK(!cache.Lookup(planet, pos, dir, dist, safeRad, 0.0, result));
+	cache.Store(planet, pos, dir, dist, safeRad, 0.0, 0.5, 3);
+
+	// a little further along the same path
+	CHECK(cache.Lookup(planet, pos + dir * 1000.0, dir, dist - 1000.0, safeRad, 0.1, result));
+	CHECK(result == 3);
+
+	// too old
+	CHECK(!cache.Lookup(planet, pos, dir, dist, safeRad, 0.6, result));
+	// moved too far for its clearance of 9e7
+	CHECK(!cache.Lookup(planet, pos + vector3d(0, 1e6, 0), dir, dist, safeRad, 0.1, result));
+	// turned
+	CHECK(!cache.Lookup(planet, pos, vector3d(-1, 0.1, 0).Normalized(), dist, safeRad, 0.1, result));
+	// different obstructor
+	CHECK(!cache.Lookup(nullptr, pos, dir, dist, safeRad, 0.1, result));
+
+	cache.Invalidate();
+	CHECK(!cache.Lookup(planet, pos, dir, dist, safeRad, 0.1, result));
+
+	const PathCheckCache::Stats stats = PathCheckCache::GetStats();
+	CHECK(stats.saved == 1);
+	CHECK(stats.checks == 6);
+}
@@ -0,0 +1,70 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "PerfStats.h"
+#include "core/StringHash.h"
+#include "doctest.h"
+
+#include <thread>
+#include <vector>
+
+TEST_CASE("Perf::Stats counters")
+{
+	Perf::Stats stats;
+	Perf::Stats::CounterRef frameCounter = stats.GetOrCreateCounter("Per Frame");
+	Perf::Stats::CounterRef gauge = stats.GetOrCreateCounter("Gauge", false);
+
+	CHECK(frameCounter.id == "Per Frame"_hash);
+	CHECK(stats.FindCounter("Gauge"_hash).id == gauge.id);
+	CHECK(stats.FindCounter("Missing"_hash).id == 0);
+	CHECK(stats.GetOrCreateCounter("Per Frame").id == frameCounter.id);
+
+	stats.CounterAdd(frameCounter, 5);
+	stats.CounterDec(frameCounter, 2);
+	stats.CounterSet(gauge, 10);
+	stats.CounterAdd(gauge);
+	stats.FlushFrame();
+
+	CHECK(stats.GetFrameValue(frameCounter) == 3);
+	CHECK(stats.GetFrameStats().at("Per Frame") == 3);
+	CHECK(stats.GetFrameValue(gauge) == 11);
+
+	SUBCASE("per-frame counters reset, others carry over")
+	{
+		stats.CounterAdd(frameCounter);
+		stats.CounterDec(gauge);
+		stats.FlushFrame();
+		CHECK(stats.GetFrameValue(frameCounter) == 1);
+		CHECK(stats.GetFrameValue(gauge) == 10);
+
+		stats.CounterReset(gauge);
+		stats.FlushFrame();
+		CHECK(stats.GetFrameValue(frameCounter) == 0);
+		CHECK(stats.GetFrameValue(gauge) == 0);
+	}
+
+	SUBCASE("counts from several threads are summed")
+	{
+		const int numThreads = 8;
+		const int numAdds = 10000;
+		std::vector<std::thread> threads;
+		for (int i = 0; i < numThreads; i++) {
+			threads.emplace_back([&]() {
+				for (int n = 0; n < numAdds; n++)
+					stats.CounterAdd(frameCounter);
+				stats.CounterAdd(gauge, 2);
+			});
+		}
+		for (auto &thread : threads)
+			thread.join();
+
+		stats.FlushFrame();
+		CHECK(stats.GetFrameValue(frameCounter) == numThreads * numAdds);
+		CHECK(stats.GetFrameValue(gauge) == 11 + numThreads * 2);
+
+		// a value set on one thread replaces what other threads counted
+		stats.CounterSet(gauge, 4);
+		stats.FlushFrame();
+		CHECK(stats.GetFrameValue(gauge) == 4);
+	}
+}
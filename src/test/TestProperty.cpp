@@ -303,6 +303,51 @@ TEST_CASE("PropertyMap")
 		CHECK(values.size() == 0);
 	}
 
+	SUBCASE("Change Versions")
+	{
+		const uint32_t version = map->GetVersion();
+		map->Set("test", 1);
+		CHECK(map->GetVersion() == version + 1);
+
+		// setting the same value again is not a change
+		map->Set("test", 1);
+		map->Set("absent", nullptr);
+		CHECK(map->GetVersion() == version + 1);
+		CHECK(map->Size() == 1);
+
+		map->Set("test", 1.5);
+		CHECK(map->GetVersion() == version + 2);
+
+		map->Clear();
+		CHECK(map->GetVersion() == version + 3);
+		map->Clear();
+		CHECK(map->GetVersion() == version + 3);
+	}
+
+	SUBCASE("Batched Changes")
+	{
+		const uint32_t version = map->GetVersion();
+		{
+			PropertyMap::Batch batch(*map.get());
+			map->Set("test1", 1);
+			map->Set("test2", 2);
+			{
+				PropertyMap::Batch inner(*map.get());
+				map->Set("test1", 3);
+			}
+			CHECK(map->GetVersion() == version);
+			CHECK(map->Get("test1").get_integer() == 3);
+		}
+		CHECK(map->GetVersion() == version + 1);
+
+		// a batch without changes leaves the version alone
+		{
+			PropertyMap::Batch batch(*map.get());
+			map->Set("test2", 2);
+		}
+		CHECK(map->GetVersion() == version + 1);
+	}
+
 	SUBCASE("Stress Test")
 	{
 		for (uint32_t idx = 0; idx < 3; idx++) {
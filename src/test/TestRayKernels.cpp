@@ -0,0 +1,235 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "collider/BVHTree.h"
+#include "collider/GeomTree.h"
+#include "collider/RayKernels.h"
+#include "doctest.h"
+#include "profiler/Profiler.h"
+#include "scenegraph/Serializer.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+// Dense triangulated sphere, roughly the triangle count of the largest
+// station collision meshes
+struct TestMesh {
+	std::vector<vector3f> vertices;
+	std::vector<Uint32> indices;
+	std::vector<Uint32> triFlags;
+
+	TestMesh(float radius, int rings, int segments)
+	{
+		for (int ring = 0; ring <= rings; ring++) {
+			const float theta = float(M_PI) * ring / rings;
+			for (int seg = 0; seg <= segments; seg++) {
+				const float phi = 2.f * float(M_PI) * seg / segments;
+				vertices.push_back(vector3f(sin(theta) * cos(phi), cos(theta), sin(theta) * sin(phi)) * radius);
+			}
+		}
+
+		for (int ring = 0; ring < rings; ring++) {
+			for (int seg = 0; seg < segments; seg++) {
+				const Uint32 i0 = ring * (segments + 1) + seg;
+				const Uint32 i1 = i0 + segments + 1;
+				indices.insert(indices.end(), { i0, i1, i0 + 1, i0 + 1, i1, i1 + 1 });
+				triFlags.insert(triFlags.end(), { 0, 0 });
+			}
+		}
+	}
+
+	int NumTris() const { return int(indices.size() / 3); }
+};
+
+// Scalar reference for RayKernels::RayTri4, same as GeomTree::RayTriIntersect
+static bool RayTriReference(const vector3f &origin, const vector3f &dir, const vector3f &a, const vector3f &b, const vector3f &c, float &dist)
+{
+	const vector3f n = (c - a).Cross(b - a);
+	const float nominator = n.Dot(a - origin);
+	const float v0d = (c - origin).Cross(b - origin).Dot(dir);
+	const float v1d = (b - origin).Cross(a - origin).Dot(dir);
+	const float v2d = (a - origin).Cross(c - origin).Dot(dir);
+
+	if (((v0d > 0) && (v1d > 0) && (v2d > 0)) || ((v0d < 0) && (v1d < 0) && (v2d < 0))) {
+		const float t = nominator / dir.Dot(n);
+		if (t > 0 && t < dist) {
+			dist = t;
+			return true;
+		}
+	}
+	return false;
+}
+
+static void RandomRay(std::mt19937 &rng, float radius, vector3f &origin, vector3f &dir)
+{
+	std::uniform_real_distribution<float> dist(-1.f, 1.f);
+	origin = vector3f(dist(rng), dist(rng), dist(rng)).Normalized() * (radius * 2.f);
+	const vector3f target = vector3f(dist(rng), dist(rng), dist(rng)) * (radius * 0.5f);
+	dir = (target - origin).Normalized();
+}
+
+TEST_CASE("Ray Kernels")
+{
+	const float radius = 500.f;
+	TestMesh mesh(radius, 128, 256);
+	std::mt19937 rng(1234);
+
+	// pack all triangles four at a time for the brute-force comparisons
+	std::vector<TriSoA4> packed((mesh.NumTris() + 3) / 4);
+	for (int tri = 0; tri < mesh.NumTris(); tri++) {
+		TriSoA4 &soa = packed[tri / 4];
+		const int lane = tri % 4;
+		const vector3f &a = mesh.vertices[mesh.indices[tri * 3 + 0]];
+		const vector3f &b = mesh.vertices[mesh.indices[tri * 3 + 1]];
+		const vector3f &c = mesh.vertices[mesh.indices[tri * 3 + 2]];
+		soa.ax[lane] = a.x, soa.ay[lane] = a.y, soa.az[lane] = a.z;
+		soa.bx[lane] = b.x, soa.by[lane] = b.y, soa.bz[lane] = b.z;
+		soa.cx[lane] = c.x, soa.cy[lane] = c.y, soa.cz[lane] = c.z;
+	}
+
+	SUBCASE("Ray-AABB")
+	{
+		AabbSoA4 boxes;
+		for (int lane = 0; lane < 4; lane++) {
+			boxes.minX[lane] = boxes.minY[lane] = boxes.minZ[lane] = float(lane * 10);
+			boxes.maxX[lane] = boxes.maxY[lane] = boxes.maxZ[lane] = float(lane * 10 + 5);
+		}
+
+		// diagonal ray through all four boxes, but only long enough to reach the first three
+		const vector3f dir = vector3f(1.f, 1.f, 1.f).Normalized();
+		const vector3f invDir(1.f / dir.x, 1.f / dir.y, 1.f / dir.z);
+		alignas(16) float tNear[4];
+		CHECK(RayKernels::RayAabb4(vector3f(-1.f), invDir, boxes, 40.f, tNear) == 0x7);
+		CHECK(tNear[1] == doctest::Approx((10.f + 1.f) * std::sqrt(3.f)));
+
+		// pointing away from every box
+		CHECK(RayKernels::RayAabb4(vector3f(-1.f), -invDir, boxes, 1000.f) == 0);
+	}
+
+	SUBCASE("Ray-Triangle matches scalar")
+	{
+		for (int ray = 0; ray < 64; ray++) {
+			vector3f origin, dir;
+			RandomRay(rng, radius, origin, dir);
+
+			float refDist = FLT_MAX;
+			int refTri = -1;
+			float simdDist = FLT_MAX;
+			int simdTri = -1;
+			for (int tri = 0; tri < mesh.NumTris(); tri++) {
+				const vector3f &a = mesh.vertices[mesh.indices[tri * 3 + 0]];
+				const vector3f &b = mesh.vertices[mesh.indices[tri * 3 + 1]];
+				const vector3f &c = mesh.vertices[mesh.indices[tri * 3 + 2]];
+				if (RayTriReference(origin, dir, a, b, c, refDist))
+					refTri = tri;
+			}
+			for (size_t idx = 0; idx < packed.size(); idx++) {
+				const int numTris = std::min(mesh.NumTris() - int(idx * 4), 4);
+				const int lane = RayKernels::RayTri4(origin, dir, packed[idx], numTris, simdDist);
+				if (lane >= 0)
+					simdTri = int(idx * 4) + lane;
+			}
+
+			REQUIRE(refTri >= 0);
+			CHECK(simdDist == doctest::Approx(refDist).epsilon(1e-4));
+			CHECK(simdTri == refTri);
+		}
+	}
+
+	SUBCASE("Wide BVH round trip")
+	{
+		GeomTree tree(int(mesh.vertices.size()), mesh.NumTris(), mesh.vertices, mesh.indices, mesh.triFlags);
+		Serializer::Writer wr;
+		tree.Save(wr);
+
+		Serializer::Reader rd(ByteRange(wr.GetData().data(), wr.GetData().size()));
+		GeomTree loaded(rd);
+		REQUIRE(loaded.GetWideTriTree()->GetNumNodes() == tree.GetWideTriTree()->GetNumNodes());
+
+		for (int ray = 0; ray < 256; ray++) {
+			vector3f origin, dir;
+			RandomRay(rng, radius, origin, dir);
+			isect_t a = { -1, radius * 4.f }, b = { -1, radius * 4.f };
+			tree.TraceRay(origin, dir, &a);
+			loaded.TraceRay(origin, dir, &b);
+			CHECK(a.triIdx == b.triIdx);
+			CHECK(a.dist == b.dist);
+		}
+	}
+
+	SUBCASE("Benchmark")
+	{
+		// brute force over a cache-sized slice of the mesh, so that this
+		// measures the kernels rather than memory bandwidth
+		const int numBruteForceTris = 1024;
+		const int numBruteForceRays = 2048;
+		std::vector<vector3f> origins(numBruteForceRays), dirs(numBruteForceRays);
+		for (int ray = 0; ray < numBruteForceRays; ray++)
+			RandomRay(rng, radius, origins[ray], dirs[ray]);
+
+		Profiler::Clock clock{};
+		std::vector<float> scalarDists(numBruteForceRays), simdDists(numBruteForceRays);
+
+		clock.Start();
+		for (int ray = 0; ray < numBruteForceRays; ray++) {
+			float dist = radius * 4.f;
+			for (int tri = 0; tri < numBruteForceTris; tri++)
+				RayTriReference(origins[ray], dirs[ray], mesh.vertices[mesh.indices[tri * 3 + 0]],
+					mesh.vertices[mesh.indices[tri * 3 + 1]], mesh.vertices[mesh.indices[tri * 3 + 2]], dist);
+			scalarDists[ray] = dist;
+		}
+		clock.Stop();
+		const double scalarTime = clock.milliseconds();
+
+		clock.Reset();
+		clock.Start();
+		for (int ray = 0; ray < numBruteForceRays; ray++) {
+			float dist = radius * 4.f;
+			for (int idx = 0; idx < numBruteForceTris / 4; idx++)
+				RayKernels::RayTri4(origins[ray], dirs[ray], packed[idx], 4, dist);
+			simdDists[ray] = dist;
+		}
+		clock.Stop();
+		const double simdTime = clock.milliseconds();
+
+		for (int ray = 0; ray < numBruteForceRays; ray++)
+			CHECK(simdDists[ray] == doctest::Approx(scalarDists[ray]).epsilon(1e-4));
+
+		// full traversal of the binary and wide collision BVHs
+		GeomTree tree(int(mesh.vertices.size()), mesh.NumTris(), mesh.vertices, mesh.indices, mesh.triFlags);
+		const int numTreeRays = 100000;
+		std::vector<vector3f> treeOrigins(numTreeRays), treeDirs(numTreeRays);
+		for (int ray = 0; ray < numTreeRays; ray++)
+			RandomRay(rng, radius, treeOrigins[ray], treeDirs[ray]);
+		std::vector<isect_t> binaryHits(numTreeRays, { -1, radius * 4.f });
+		std::vector<isect_t> wideHits(numTreeRays, { -1, radius * 4.f });
+
+		clock.Reset();
+		clock.Start();
+		for (int ray = 0; ray < numTreeRays; ray++)
+			tree.TraceRay(tree.GetTriTree()->GetRoot(), treeOrigins[ray], treeDirs[ray], &binaryHits[ray]);
+		clock.Stop();
+		const double binaryTime = clock.milliseconds();
+
+		clock.Reset();
+		clock.Start();
+		for (int ray = 0; ray < numTreeRays; ray++)
+			tree.TraceRay(treeOrigins[ray], treeDirs[ray], &wideHits[ray]);
+		clock.Stop();
+		const double wideTime = clock.milliseconds();
+
+		int numMismatched = 0;
+		for (int ray = 0; ray < numTreeRays; ray++) {
+			REQUIRE(binaryHits[ray].triIdx >= 0);
+			numMismatched += wideHits[ray].triIdx != binaryHits[ray].triIdx || wideHits[ray].dist != binaryHits[ray].dist;
+		}
+		CHECK(numMismatched == 0);
+
+		printf("RayKernels (%s): %d tris x %d rays brute force: scalar %.2f ms, 4-wide %.2f ms\n",
+			RayKernels::GetImplementationName(), numBruteForceTris, numBruteForceRays, scalarTime, simdTime);
+		printf("GeomTree::TraceRay %d tris, %d rays: binary BVH (%zu nodes) %.2f ms, wide BVH (%zu nodes) %.2f ms\n",
+			mesh.NumTris(), numTreeRays, tree.GetTriTree()->GetNumNodes(), binaryTime,
+			tree.GetWideTriTree()->GetNumNodes(), wideTime);
+	}
+}
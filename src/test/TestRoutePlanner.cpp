@@ -0,0 +1,202 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "JobQueue.h"
+#include "MathUtil.h"
+#include "doctest.h"
+#include "galaxy/RoutePlanner.h"
+#include "galaxy/Sector.h"
+#include "profiler/Profiler.h"
+
+#include <random>
+#include <vector>
+
+// A few systems in each of a row of sectors along x
+static std::vector<RoutePlanner::Node> MakeSystems(std::mt19937 &rng, int length, int systemsPerSector)
+{
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::vector<RoutePlanner::Node> systems;
+	for (int sx = 0; sx < length; sx++)
+		for (int sy = -1; sy <= 1; sy++)
+			for (int sz = -1; sz <= 1; sz++)
+				for (int i = 0; i < systemsPerSector; i++) {
+					const vector3f offset(unit(rng), unit(rng), unit(rng));
+					systems.push_back({ SystemPath(sx, sy, sz, i), Sector::SIZE * (vector3f(float(sx), float(sy), float(sz)) + offset) });
+				}
+	return systems;
+}
+
+static void AddSectors(RoutePlanner &planner, const std::vector<RoutePlanner::Node> &systems)
+{
+	for (const RoutePlanner::Node &node : systems) {
+		const SystemPath sectorPath = node.path.SectorOnly();
+		if (planner.HasSector(sectorPath))
+			continue;
+		std::vector<RoutePlanner::Node> sector;
+		for (const RoutePlanner::Node &other : systems)
+			if (other.path.IsSameSector(sectorPath))
+				sector.push_back(other);
+		planner.AddSector(sectorPath, sector);
+	}
+}
+
+// a fixed time to spool up and then one unit per light year, as hyperdrives do
+static RoutePlanner::JumpCost MakeCost(float range)
+{
+	RoutePlanner::JumpCost cost;
+	cost.range = range;
+	for (int i = 0; i < 16; i++)
+		cost.durations.push_back(2.0f + range * i / 15.0f);
+	return cost;
+}
+
+// O(n^2) Dijkstra over the same systems, as SectorView used to do
+static float BruteForceDuration(const std::vector<RoutePlanner::Node> &systems, size_t start, size_t target, const RoutePlanner::JumpCost &cost, float maxDistFromLine)
+{
+	const vector3f &a = systems[start].pos, &b = systems[target].pos;
+	const float limitSqr = (b - a).LengthSqr() * 1.10f;
+	std::vector<float> dist(systems.size(), INFINITY);
+	std::vector<bool> done(systems.size(), false);
+	for (size_t i = 0; i < systems.size(); i++) {
+		const vector3f &pos = systems[i].pos;
+		if ((pos - a).LengthSqr() > limitSqr || (pos - b).LengthSqr() > limitSqr || MathUtil::DistanceFromLine(a, b, pos) >= maxDistFromLine)
+			done[i] = true;
+	}
+	done[start] = false;
+	dist[start] = 0.0f;
+
+	for (;;) {
+		size_t closest = systems.size();
+		for (size_t i = 0; i < systems.size(); i++)
+			if (!done[i] && (closest == systems.size() || dist[i] < dist[closest]))
+				closest = i;
+		if (closest == systems.size() || dist[closest] == INFINITY)
+			return INFINITY;
+		if (closest == target)
+			return dist[target];
+		done[closest] = true;
+		for (size_t i = 0; i < systems.size(); i++) {
+			if (done[i])
+				continue;
+			const float jump = (systems[i].pos - systems[closest].pos).Length();
+			if (jump <= cost.range)
+				dist[i] = std::min(dist[i], dist[closest] + cost.GetDuration(jump));
+		}
+	}
+}
+
+static float RouteDuration(const std::vector<RoutePlanner::Node> &systems, size_t start, const std::vector<SystemPath> &route, const RoutePlanner::JumpCost &cost)
+{
+	float duration = 0.0f;
+	vector3f pos = systems[start].pos;
+	for (const SystemPath &path : route) {
+		for (const RoutePlanner::Node &node : systems)
+			if (node.path.IsSameSystem(path)) {
+				duration += cost.GetDuration((node.pos - pos).Length());
+				pos = node.pos;
+			}
+	}
+	return duration;
+}
+
+TEST_CASE("Route Planner")
+{
+	std::mt19937 rng(1234);
+	std::vector<RoutePlanner::Node> systems = MakeSystems(rng, 12, 4);
+	const float maxDistFromLine = Sector::SIZE * 3;
+
+	SyncJobQueue queue;
+	RoutePlanner planner(&queue);
+	AddSectors(planner, systems);
+
+	RoutePlanner::Status finished = RoutePlanner::ROUTE_NONE;
+	planner.onRouteFinished.connect([&](RoutePlanner::Status status) { finished = status; });
+
+	auto plan = [&](size_t start, size_t target, const RoutePlanner::JumpCost &cost) {
+		finished = RoutePlanner::ROUTE_NONE;
+		planner.RequestRoute(systems[start], systems[target], cost, maxDistFromLine);
+		CHECK(planner.GetStatus() == RoutePlanner::ROUTE_PENDING);
+		queue.RunJobs(1);
+		queue.FinishJobs();
+		CHECK(finished == planner.GetStatus());
+		return planner.GetStatus();
+	};
+
+	SUBCASE("Routes are as quick as brute force")
+	{
+		// shrinking the range reuses the jumps, growing it finds them again
+		for (float range : { 15.0f, 9.0f, 20.0f }) {
+			const RoutePlanner::JumpCost cost = MakeCost(range);
+			for (size_t start = 0; start < systems.size(); start += 37) {
+				const size_t target = systems.size() - 1 - start;
+				const float expected = BruteForceDuration(systems, start, target, cost, maxDistFromLine);
+				if (expected == INFINITY) {
+					CHECK(plan(start, target, cost) == RoutePlanner::ROUTE_NO_VALID_ROUTE);
+					continue;
+				}
+				REQUIRE(plan(start, target, cost) == RoutePlanner::ROUTE_OKAY);
+				REQUIRE(!planner.GetRoute().empty());
+				CHECK(planner.GetRoute().back() == systems[target].path);
+				CHECK(RouteDuration(systems, start, planner.GetRoute(), cost) == doctest::Approx(expected).epsilon(0.001));
+			}
+		}
+	}
+
+	SUBCASE("Routes use sectors added later")
+	{
+		std::vector<RoutePlanner::Node> bridge;
+		for (int sx = 12; sx < 18; sx++)
+			bridge.push_back({ SystemPath(sx, 0, 0, 0), Sector::SIZE * vector3f(sx + 0.5f, 0.5f, 0.5f) });
+		const RoutePlanner::Node far = { SystemPath(18, 0, 0, 0), Sector::SIZE * vector3f(18.5f, 0.5f, 0.5f) };
+		planner.AddSector(far.path.SectorOnly(), { far });
+		systems.push_back(far);
+
+		const RoutePlanner::JumpCost cost = MakeCost(12.0f);
+		CHECK(plan(0, systems.size() - 1, cost) == RoutePlanner::ROUTE_NO_VALID_ROUTE);
+
+		for (const RoutePlanner::Node &node : bridge)
+			planner.AddSector(node.path.SectorOnly(), { node });
+		REQUIRE(plan(0, systems.size() - 1, cost) == RoutePlanner::ROUTE_OKAY);
+		CHECK(planner.GetRoute().back() == far.path);
+	}
+
+	SUBCASE("Cancelled routes don't finish")
+	{
+		planner.RequestRoute(systems[0], systems.back(), MakeCost(15.0f), maxDistFromLine);
+		planner.CancelRoute();
+		queue.RunJobs(1);
+		queue.FinishJobs();
+		CHECK(finished == RoutePlanner::ROUTE_NONE);
+		CHECK(planner.GetStatus() == RoutePlanner::ROUTE_NONE);
+	}
+
+	SUBCASE("Benchmark")
+	{
+		std::vector<RoutePlanner::Node> longRow = MakeSystems(rng, 60, 6);
+		SyncJobQueue benchQueue;
+		RoutePlanner benchPlanner(&benchQueue);
+		AddSectors(benchPlanner, longRow);
+		const RoutePlanner::JumpCost cost = MakeCost(15.0f);
+
+		Profiler::Clock clock{};
+		clock.Start();
+		const float expected = BruteForceDuration(longRow, 0, longRow.size() - 1, cost, maxDistFromLine);
+		clock.Stop();
+		const double bruteTime = clock.milliseconds();
+
+		double times[2];
+		for (double &time : times) {
+			clock.Reset();
+			clock.Start();
+			benchPlanner.RequestRoute(longRow[0], longRow.back(), cost, maxDistFromLine);
+			benchQueue.RunJobs(1);
+			benchQueue.FinishJobs();
+			clock.Stop();
+			time = clock.milliseconds();
+		}
+		REQUIRE(benchPlanner.GetStatus() == RoutePlanner::ROUTE_OKAY);
+		CHECK(RouteDuration(longRow, 0, benchPlanner.GetRoute(), cost) == doctest::Approx(expected).epsilon(0.001));
+		printf("RoutePlanner: %zu systems, brute force %.2f ms, A* %.2f ms first, %.2f ms with the graph built\n",
+			longRow.size(), bruteTime, times[0], times[1]);
+	}
+}
@@ -0,0 +1,66 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "Json.h"
+#include "SaveDelta.h"
+#include "doctest.h"
+
+static Json MakeSave()
+{
+	Json root = Json::object();
+	root["version"] = 93;
+	root["time"] = 1000.0;
+	root["space"] = Json::object();
+	root["space"]["bodies"] = Json::array({ 1, 2, 3 });
+	root["space"]["frame"] = Json::object({ { "label", "root" } });
+	root["lua_modules_json"] = Json::object({ { "Missions", "a" }, { "News/Feed", "b" } });
+	return root;
+}
+
+TEST_CASE("SaveDelta")
+{
+	const Json base = MakeSave();
+	SaveDelta::SectionHashes hashes;
+	SaveDelta::HashSections(base, hashes);
+
+	SUBCASE("Unchanged save has an empty delta")
+	{
+		Json delta = SaveDelta::MakeDelta(base, hashes);
+		CHECK(delta["sections"].empty());
+		CHECK(delta["removed"].empty());
+	}
+
+	SUBCASE("Only changed sections are stored")
+	{
+		Json current = MakeSave();
+		current["time"] = 2000.0;
+		current["space"]["bodies"].push_back(4);
+		current["lua_modules_json"]["News/Feed"] = "c";
+
+		Json delta = SaveDelta::MakeDelta(current, hashes);
+		CHECK(delta["sections"].size() == 3);
+		CHECK(delta["sections"].count("/space/bodies") == 1);
+		CHECK(delta["sections"].count("/space/frame") == 0);
+		CHECK(delta["sections"].count("/lua_modules_json/News~1Feed") == 1);
+
+		Json loaded = base;
+		SaveDelta::ApplyDelta(loaded, delta);
+		CHECK(loaded == current);
+	}
+
+	SUBCASE("Removed and added sections")
+	{
+		Json current = MakeSave();
+		current["lua_modules_json"].erase("News/Feed");
+		current["lua_modules_json"]["Assassination"] = "d";
+		current.erase("time");
+		current["game_info"] = Json::object({ { "ship", "kanara" } });
+
+		Json delta = SaveDelta::MakeDelta(current, hashes);
+		CHECK(delta["removed"].size() == 2);
+
+		Json loaded = base;
+		SaveDelta::ApplyDelta(loaded, delta);
+		CHECK(loaded == current);
+	}
+}
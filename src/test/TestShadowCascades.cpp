@@ -0,0 +1,117 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "doctest.h"
+#include "MathUtil.h"
+#include "graphics/ShadowCascades.h"
+
+#include <cmath>
+
+using Graphics::ShadowCascades;
+
+static void DrawAll(ShadowCascades &shadows)
+{
+	for (uint32_t i = 0; i < shadows.GetNumCascades(); i++)
+		if (shadows.NeedsRedraw(i))
+			shadows.MarkDrawn(i, matrix4x4f::Identity());
+}
+
+TEST_CASE("Shadow Cascades")
+{
+	ShadowCascades::Settings settings;
+	settings.numCascades = 4;
+	settings.maxDistance = 1000.0f;
+	settings.firstStaticCascade = 2;
+	settings.staticRedrawBudget = 1;
+	ShadowCascades shadows(settings);
+	REQUIRE(shadows.GetNumCascades() == 4);
+
+	const double fovY = DEG2RAD(60.0), aspect = 16.0 / 9.0, znear = 1.0;
+	const vector3d sun = vector3d(1.0, 2.0, 0.5).Normalized();
+
+	SUBCASE("Cascades cover the view")
+	{
+		const matrix3x3d orient = matrix3x3d::RotateY(0.3) * matrix3x3d::RotateX(-0.2);
+		const vector3d camPos(500.0, -20.0, 300.0);
+		for (int frame = 0; frame < 4; frame++) {
+			shadows.Update(camPos, orient, fovY, aspect, znear, sun);
+			DrawAll(shadows);
+		}
+
+		CHECK(shadows.GetCascade(0).splitNear == doctest::Approx(znear));
+		CHECK(shadows.GetCascade(3).splitFar == doctest::Approx(settings.maxDistance));
+		const double tanY = std::tan(fovY * 0.5);
+		for (uint32_t i = 0; i < shadows.GetNumCascades(); i++) {
+			const ShadowCascades::Cascade &c = shadows.GetCascade(i);
+			if (i > 0)
+				CHECK(c.splitNear == doctest::Approx(shadows.GetCascade(i - 1).splitFar));
+			CHECK(c.splitFar > c.splitNear);
+
+			// every corner of the slice is inside the light's view volume,
+			// allowing a texel for the snapping
+			const double slack = 2.0 * c.radius / settings.mapSize * 1.5;
+			for (const double d : { c.splitNear, c.splitFar })
+				for (const double sx : { -1.0, 1.0 })
+					for (const double sy : { -1.0, 1.0 }) {
+						const vector3d corner = camPos + orient * vector3d(sx * d * tanY * aspect, sy * d * tanY, -d);
+						const vector3d p = c.lightView * corner;
+						CHECK(std::abs(p.x) <= c.radius + slack);
+						CHECK(std::abs(p.y) <= c.radius + slack);
+						CHECK(-p.z >= c.depthNear);
+						CHECK(-p.z <= c.depthFar);
+					}
+		}
+	}
+
+	SUBCASE("Turning doesn't change the cascades' size")
+	{
+		shadows.Update(vector3d(0.0), matrix3x3d::Identity(), fovY, aspect, znear, sun);
+		const double radius = shadows.GetCascade(1).radius;
+		shadows.Update(vector3d(0.0), matrix3x3d::RotateY(1.0), fovY, aspect, znear, sun);
+		CHECK(shadows.GetCascade(1).radius == radius);
+	}
+
+	SUBCASE("Static cascades are cached")
+	{
+		// both static cascades need drawing, but only one fits each frame
+		shadows.Update(vector3d(0.0), matrix3x3d::Identity(), fovY, aspect, znear, sun);
+		CHECK(shadows.NeedsRedraw(0));
+		CHECK(shadows.NeedsRedraw(1));
+		CHECK(shadows.NeedsRedraw(2) != shadows.NeedsRedraw(3));
+		DrawAll(shadows);
+		CHECK(shadows.GetNumStaticRedraws() == 1);
+		shadows.Update(vector3d(0.0), matrix3x3d::Identity(), fovY, aspect, znear, sun);
+		CHECK(shadows.NeedsRedraw(2) != shadows.NeedsRedraw(3));
+		DrawAll(shadows);
+
+		// small moves keep them
+		shadows.Update(vector3d(1.0, 0.0, -2.0), matrix3x3d::Identity(), fovY, aspect, znear, sun);
+		CHECK(shadows.NeedsRedraw(0));
+		CHECK_FALSE(shadows.NeedsRedraw(2));
+		CHECK_FALSE(shadows.NeedsRedraw(3));
+		DrawAll(shadows);
+
+		// a turn of the sun doesn't
+		const vector3d turned = matrix3x3d::RotateY(DEG2RAD(2.0)) * sun;
+		shadows.Update(vector3d(1.0, 0.0, -2.0), matrix3x3d::Identity(), fovY, aspect, znear, turned);
+		CHECK(shadows.NeedsRedraw(2) != shadows.NeedsRedraw(3));
+		DrawAll(shadows);
+
+		// nor does leaving the cached area
+		shadows.Update(vector3d(0.0, 0.0, -1000.0), matrix3x3d::Identity(), fovY, aspect, znear, turned);
+		CHECK(shadows.NeedsRedraw(2) != shadows.NeedsRedraw(3));
+
+		// and everything is drawn again after invalidating
+		shadows.Invalidate();
+		shadows.Update(vector3d(0.0, 0.0, -1000.0), matrix3x3d::Identity(), fovY, aspect, znear, turned);
+		CHECK((shadows.NeedsRedraw(2) || shadows.NeedsRedraw(3)));
+	}
+
+	SUBCASE("No cascades")
+	{
+		settings.numCascades = 0;
+		ShadowCascades none(settings);
+		none.Update(vector3d(0.0), matrix3x3d::Identity(), fovY, aspect, znear, sun);
+		CHECK(none.GetNumCascades() == 0);
+	}
+}
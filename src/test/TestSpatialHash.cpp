@@ -0,0 +1,184 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "core/SpatialHash.h"
+#include "doctest.h"
+#include "profiler/Profiler.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+// Ships around a few planets: half crowded around the orbital stations,
+// the rest spread through local space
+static std::vector<vector3d> MakeShipPositions(std::mt19937 &rng, int numShips, int numPlanets)
+{
+	std::uniform_real_distribution<double> unit(-1.0, 1.0);
+	std::vector<vector3d> planets(numPlanets);
+	for (vector3d &planet : planets)
+		planet = vector3d(unit(rng), unit(rng), unit(rng) * 0.1) * 1e11;
+
+	std::vector<vector3d> positions(numShips);
+	for (int i = 0; i < numShips; i++) {
+		const vector3d &planet = planets[i % numPlanets];
+		const vector3d station = planet + vector3d(1e7, 0.0, 0.0) * double((i / numPlanets) % 4 - 2);
+		if (i % 2)
+			positions[i] = station + vector3d(unit(rng), unit(rng), unit(rng)) * 50000.0;
+		else
+			positions[i] = planet + vector3d(unit(rng), unit(rng), unit(rng)) * 3e7;
+	}
+	return positions;
+}
+
+static std::vector<int> BruteForceNear(const std::vector<vector3d> &positions, const vector3d &pos, double dist)
+{
+	std::vector<int> result;
+	for (size_t i = 0; i < positions.size(); i++)
+		if ((positions[i] - pos).LengthSqr() <= dist * dist)
+			result.push_back(int(i));
+	return result;
+}
+
+static bool Contains(const std::vector<int> &items, int item)
+{
+	return std::find(items.begin(), items.end(), item) != items.end();
+}
+
+TEST_CASE("Spatial Hash")
+{
+	std::mt19937 rng(4321);
+	const int numShips = 2500;
+	std::vector<vector3d> positions = MakeShipPositions(rng, numShips, 5);
+
+	SpatialHash<int> hash(100000.0, SpatialHash<int>::MAX_LEVELS);
+	hash.BeginUpdate();
+	for (int i = 0; i < numShips; i++)
+		hash.Update(i, positions[i]);
+	hash.EndUpdate();
+
+	REQUIRE(hash.GetNumItems() == numShips);
+
+	SUBCASE("Queries match brute force")
+	{
+		std::vector<int> result;
+		for (int i = 0; i < numShips; i += 7) {
+			for (double dist : { 4000.0, 100000.0, 1e7, 1e12 }) {
+				result.clear();
+				hash.Query(positions[i], dist, result);
+				std::sort(result.begin(), result.end());
+				CHECK(result == BruteForceNear(positions, positions[i], dist));
+			}
+		}
+	}
+
+	SUBCASE("Incremental updates")
+	{
+		// move half the ships to another cluster and drop every tenth one
+		std::uniform_real_distribution<double> unit(-1.0, 1.0);
+		hash.BeginUpdate();
+		for (int i = 0; i < numShips; i++) {
+			if (i % 10 == 0)
+				continue;
+			if (i % 2 == 0)
+				positions[i] = positions[1] + vector3d(unit(rng), unit(rng), unit(rng)) * 20000.0;
+			hash.Update(i, positions[i]);
+		}
+		hash.EndUpdate();
+
+		CHECK(hash.GetNumItems() == numShips - numShips / 10);
+
+		std::vector<int> result;
+		for (int i = 1; i < numShips; i += 10) {
+			result.clear();
+			hash.Query(positions[i], 100000.0, result);
+			std::sort(result.begin(), result.end());
+			std::vector<int> expected = BruteForceNear(positions, positions[i], 100000.0);
+			expected.erase(std::remove_if(expected.begin(), expected.end(), [](int item) { return item % 10 == 0; }), expected.end());
+			CHECK(result == expected);
+		}
+
+		hash.Remove(1);
+		result.clear();
+		hash.Query(positions[1], 1000.0, result);
+		CHECK(!Contains(result, 1));
+	}
+
+	SUBCASE("Benchmark")
+	{
+		const int numBenchShips = 5000;
+		std::vector<vector3d> benchPositions = MakeShipPositions(rng, numBenchShips, 5);
+
+		Profiler::Clock clock{};
+		std::vector<int> result;
+
+		// distance-from-origin shell, as used by BodyNearFinder before
+		std::vector<std::pair<double, int>> shell;
+		for (int i = 0; i < numBenchShips; i++)
+			shell.emplace_back(benchPositions[i].Length(), i);
+		std::sort(shell.begin(), shell.end());
+
+		SpatialHash<int> benchHash(100000.0, SpatialHash<int>::MAX_LEVELS);
+		clock.Start();
+		benchHash.BeginUpdate();
+		for (int i = 0; i < numBenchShips; i++)
+			benchHash.Update(i, benchPositions[i]);
+		benchHash.EndUpdate();
+		clock.Stop();
+		const double insertTime = clock.milliseconds();
+
+		// typical per-step update, where few ships change cells
+		std::uniform_real_distribution<double> unit(-1.0, 1.0);
+		for (vector3d &pos : benchPositions)
+			pos += vector3d(unit(rng), unit(rng), unit(rng)) * 100.0;
+		for (auto &entry : shell)
+			entry.first = benchPositions[entry.second].Length();
+		std::sort(shell.begin(), shell.end());
+
+		clock.Reset();
+		clock.Start();
+		benchHash.BeginUpdate();
+		for (int i = 0; i < numBenchShips; i++)
+			benchHash.Update(i, benchPositions[i]);
+		benchHash.EndUpdate();
+		clock.Stop();
+		printf("SpatialHash: %d ships in %zu cells, insert %.3f ms, update %.3f ms\n", numBenchShips, benchHash.GetNumCells(),
+			insertTime, clock.milliseconds());
+
+		// ECM, sensor and radar ranges
+		for (double queryDist : { 4000.0, 100000.0, 1e7 }) {
+			size_t numShellCandidates = 0, numShellResults = 0, numHashResults = 0;
+
+			clock.Reset();
+			clock.Start();
+			for (int i = 0; i < numBenchShips; i++) {
+				const double len = benchPositions[i].Length();
+				auto min = std::lower_bound(shell.begin(), shell.end(), std::make_pair(len - queryDist, -1));
+				auto max = std::upper_bound(min, shell.end(), std::make_pair(len + queryDist, numBenchShips));
+				// callers then filter the shell by distance
+				result.clear();
+				std::for_each(min, max, [&](const std::pair<double, int> &entry) {
+					if ((benchPositions[entry.second] - benchPositions[i]).LengthSqr() <= queryDist * queryDist)
+						result.push_back(entry.second);
+				});
+				numShellCandidates += max - min;
+				numShellResults += result.size();
+			}
+			clock.Stop();
+			const double shellTime = clock.milliseconds();
+
+			clock.Reset();
+			clock.Start();
+			for (int i = 0; i < numBenchShips; i++) {
+				result.clear();
+				benchHash.Query(benchPositions[i], queryDist, result);
+				numHashResults += result.size();
+			}
+			clock.Stop();
+			const double hashTime = clock.milliseconds();
+
+			CHECK(numHashResults == numShellResults);
+			printf("SpatialHash: %.0f m queries, %zu results: shell and filter %.2f ms (%zu candidates), hash %.2f ms\n",
+				queryDist, numHashResults, shellTime, numShellCandidates, hashTime);
+		}
+	}
+}
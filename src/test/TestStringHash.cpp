@@ -1,6 +1,7 @@
 // Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
+#include "core/FastHash.h"
 #include "core/StringHash.h"
 #include "doctest.h"
 
@@ -22,3 +23,12 @@ TEST_CASE("Hashed Strings")
 	CHECK(hash_str(TEST_STR) == baseline_hash);
 	CHECK(hash_cstr(TEST_STR) == baseline_hash);
 }
+
+TEST_CASE("Fast Hash")
+{
+	// cache file names are built from these, so they must never change
+	CHECK(FastHash64("", 0) == 0xef46db3751d8e999);
+	CHECK(FastHash64(TEST_STR, strlen(TEST_STR)) == FastHash64(TEST_STR, strlen(TEST_STR), 0));
+	CHECK(FastHash64(TEST_STR, strlen(TEST_STR)) != FastHash64(TEST_STR, strlen(TEST_STR), 1));
+	CHECK(FastHash64(TEST_STR, strlen(TEST_STR)) != FastHash64(TEST_STR, strlen(TEST_STR) - 1));
+}
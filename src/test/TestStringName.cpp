@@ -5,8 +5,12 @@
 #include "core/Log.h"
 #include "core/StringName.h"
 #include "profiler/Profiler.h"
+#include "StringTable.h"
 
+#include <atomic>
 #include <iostream>
+#include <string>
+#include <thread>
 #include "doctest.h"
 
 static constexpr uint32_t ITERATIONS = 10000;
@@ -114,16 +118,201 @@ TEST_CASE("String Table")
 	delete st;
 }
 
+// Interns long strings through the pool against the per-thread table it
+// replaced, which matched on the hash alone
+void intern_benchmark(uint32_t test_num)
+{
+	std::vector<std::string> strings;
+	std::vector<uint32_t> hashes;
+	for (uint32_t idx = 0; idx < ITERATIONS; idx++) {
+		strings.emplace_back(fmt::format("this is benchmark string {}", idx));
+		hashes.push_back(hash_32_fnv1a(strings.back().data(), strings.back().size()));
+	}
+
+	StringTable table(1 << 14);
+	StringPool pool(1 << 14);
+	std::vector<StringPool::Data *> interned(ITERATIONS);
+
+	Profiler::Clock clock{};
+	clock.Start();
+	for (uint32_t idx = 0; idx < ITERATIONS; idx++)
+		table.FindOrCreate(hashes[idx]);
+	clock.Stop();
+	const double tableInsert = clock.milliseconds();
+
+	clock.Reset();
+	clock.Start();
+	for (uint32_t idx = 0; idx < ITERATIONS; idx++)
+		interned[idx] = pool.Intern(strings[idx], hashes[idx]);
+	clock.Stop();
+	const double poolInsert = clock.milliseconds();
+
+	clock.Reset();
+	clock.Start();
+	for (uint32_t idx = 0; idx < LOOKUP_ITERATIONS; idx++)
+		table.Find(hashes[idx % ITERATIONS]);
+	clock.Stop();
+	const double tableLookup = clock.milliseconds();
+
+	clock.Reset();
+	clock.Start();
+	for (uint32_t idx = 0; idx < LOOKUP_ITERATIONS; idx++)
+		pool.Intern(strings[idx % ITERATIONS], hashes[idx % ITERATIONS])->unref();
+	clock.Stop();
+	const double poolLookup = clock.milliseconds();
+
+	// lookups from several threads at once never take the pool's lock
+	clock.Reset();
+	clock.Start();
+	std::vector<std::thread> threads;
+	for (uint32_t thread = 0; thread < 4; thread++) {
+		threads.emplace_back([&]() {
+			for (uint32_t idx = 0; idx < LOOKUP_ITERATIONS; idx++)
+				pool.Intern(strings[idx % ITERATIONS], hashes[idx % ITERATIONS])->unref();
+		});
+	}
+	for (auto &thread : threads)
+		thread.join();
+	clock.Stop();
+	const double poolThreaded = clock.milliseconds();
+
+	for (auto *data : interned)
+		data->unref();
+
+	Log::Info("StringPool[run {}]: Insertion of {} strings took {}ms (StringTable {}ms)\n", test_num, ITERATIONS, poolInsert, tableInsert);
+	Log::Info("StringPool[run {}]: Lookup of {} strings took {}ms (StringTable {}ms), {}ms with 4 threads at once\n",
+		test_num, LOOKUP_ITERATIONS, poolLookup, tableLookup, poolThreaded);
+}
+
+TEST_CASE("String Pool")
+{
+	StringPool pool(1 << 4);
+	const std::string_view text = "testing one two three";
+	const uint32_t hash = hash_32_fnv1a(text.data(), text.size());
+
+	SUBCASE("Interning")
+	{
+		StringPool::Data *a = pool.Intern(text, hash);
+		StringPool::Data *b = pool.Intern(std::string(text), hash);
+		CHECK(a == b);
+		CHECK(a->get_ref() == 2);
+		CHECK(std::string_view(a->get(), a->size) == text);
+		CHECK(pool.Size() == 1);
+
+		// strings with the same hash are still kept apart
+		StringPool::Data *c = pool.Intern("a different string", hash);
+		CHECK(c != a);
+		CHECK(std::string_view(c->get(), c->size) == "a different string");
+		CHECK(pool.Size() == 2);
+
+		a->unref();
+		b->unref();
+		c->unref();
+		pool.Reclaim(true);
+		CHECK(pool.Size() == 0);
+
+		// reclaimed strings are interned afresh
+		StringPool::Data *d = pool.Intern(text, hash);
+		CHECK(d->get_ref() == 1);
+		d->unref();
+	}
+
+	SUBCASE("Growth")
+	{
+		std::vector<StringPool::Data *> interned;
+		for (uint32_t idx = 0; idx < 1000; idx++) {
+			const std::string str = fmt::format("this is some test {}", idx);
+			interned.push_back(pool.Intern(str, hash_32_fnv1a(str.data(), str.size())));
+		}
+		CHECK(pool.Size() == 1000);
+		CHECK(pool.Capacity() >= 1024);
+
+		for (uint32_t idx = 0; idx < 1000; idx++) {
+			const std::string str = fmt::format("this is some test {}", idx);
+			StringPool::Data *data = pool.Intern(str, hash_32_fnv1a(str.data(), str.size()));
+			CHECK(data == interned[idx]);
+			data->unref();
+			interned[idx]->unref();
+		}
+
+		pool.Reclaim(true);
+		CHECK(pool.Size() == 0);
+	}
+
+	SUBCASE("Threads")
+	{
+		// every thread gets the same copy of each string
+		std::vector<std::vector<StringPool::Data *>> interned(4);
+		std::vector<std::thread> threads;
+		for (uint32_t thread = 0; thread < 4; thread++) {
+			threads.emplace_back([&, thread]() {
+				for (uint32_t idx = 0; idx < 500; idx++) {
+					const std::string str = fmt::format("this is some test {}", idx);
+					interned[thread].push_back(pool.Intern(str, hash_32_fnv1a(str.data(), str.size())));
+				}
+			});
+		}
+		for (auto &thread : threads)
+			thread.join();
+
+		CHECK(pool.Size() == 500);
+		for (uint32_t idx = 0; idx < 500; idx++) {
+			CHECK(interned[1][idx] == interned[0][idx]);
+			CHECK(interned[2][idx] == interned[0][idx]);
+			CHECK(interned[3][idx] == interned[0][idx]);
+			CHECK(interned[0][idx]->get_ref() == 4);
+		}
+
+		for (auto &list : interned)
+			for (auto *data : list)
+				data->unref();
+	}
+
+	SUBCASE("Reclaiming during lookups")
+	{
+		// strings are dropped and reclaimed while other threads keep looking
+		// them up; lookups must never reach freed memory
+		std::atomic<bool> done(false);
+		std::vector<std::thread> threads;
+		for (uint32_t thread = 0; thread < 4; thread++) {
+			threads.emplace_back([&]() {
+				while (!done.load()) {
+					for (uint32_t idx = 0; idx < 64; idx++) {
+						const std::string str = fmt::format("this is some test {}", idx);
+						StringPool::Data *data = pool.Intern(str, hash_32_fnv1a(str.data(), str.size()));
+						CHECK(std::string_view(data->get(), data->size) == str);
+						data->unref();
+					}
+				}
+			});
+		}
+		for (uint32_t pass = 0; pass < 200; pass++)
+			pool.Reclaim(true);
+		done.store(true);
+		for (auto &thread : threads)
+			thread.join();
+
+		pool.Reclaim(true);
+		CHECK(pool.Size() == 0);
+	}
+
+	SUBCASE("Performance")
+	{
+		for (uint32_t idx = 0; idx < 3; idx++)
+			intern_benchmark(idx);
+	}
+}
+
 TEST_CASE("StringName")
 {
 
 	SUBCASE("Creation")
 	{
-		CHECK(StringTable::Get()->Size() == 0);
+		CHECK(StringPool::Get()->Size() == 0);
 
 		auto name = StringName("testing one two three");
 		auto name2 = StringName(std::string_view("testing one two three"));
-		CHECK(StringTable::Get()->Size() == 1);
+		CHECK(StringPool::Get()->Size() == 1);
 
 		CHECK(name.size() == 21);
 		CHECK(name.hash() != 0);
@@ -133,12 +322,12 @@ TEST_CASE("StringName")
 		CHECK(name.hash() == name2.hash());
 
 		name = {};
-		StringTable::Get()->Reclaim(true);
-		CHECK(StringTable::Get()->Size() == 1);
+		StringPool::Get()->Reclaim(true);
+		CHECK(StringPool::Get()->Size() == 1);
 
 		name2 = {};
-		StringTable::Get()->Reclaim(true);
-		CHECK(StringTable::Get()->Size() == 0);
+		StringPool::Get()->Reclaim(true);
+		CHECK(StringPool::Get()->Size() == 0);
 	}
 
 	SUBCASE("Copy Construction")
@@ -155,35 +344,39 @@ TEST_CASE("StringName")
 		StringName b = a;
 		CHECK(a.hash() == "this is a test"_hash32);
 		CHECK(b.hash() == "this is a test"_hash32);
+
+		StringName c = STRING_NAME("this is a test");
+		CHECK(c.hash() == "this is a test"_hash32);
+		CHECK(c == a);
 	}
 
 	SUBCASE("Occupancy")
 	{
 		static constexpr uint32_t PERSISTENT_SIZE = 256;
-		StringTable::Get()->Reclaim(true);
-		CHECK(StringTable::Get()->Size() == 0);
+		StringPool::Get()->Reclaim(true);
+		CHECK(StringPool::Get()->Size() == 0);
 
 		std::vector<StringName> persistent_names;
 		for (uint32_t idx = 0; idx < PERSISTENT_SIZE; idx++) {
 			persistent_names.emplace_back(fmt::format("this is some test {}", idx));
 		}
 
-		CHECK(StringTable::Get()->Size() == PERSISTENT_SIZE);
+		CHECK(StringPool::Get()->Size() == PERSISTENT_SIZE);
 
 		std::vector<StringName> temporary_names;
 		for (uint32_t idx = 0; idx < 1024; idx++) {
 			temporary_names.emplace_back("this is some test 1");
 		}
 
-		CHECK(StringTable::Get()->Size() == PERSISTENT_SIZE);
+		CHECK(StringPool::Get()->Size() == PERSISTENT_SIZE);
 
 		temporary_names.clear();
-		CHECK(StringTable::Get()->Size() == PERSISTENT_SIZE);
+		CHECK(StringPool::Get()->Size() == PERSISTENT_SIZE);
 
 		persistent_names.clear();
-		CHECK(StringTable::Get()->Size() == PERSISTENT_SIZE);
+		CHECK(StringPool::Get()->Size() == PERSISTENT_SIZE);
 
-		StringTable::Get()->Reclaim(true);
-		CHECK(StringTable::Get()->Size() == 0);
+		StringPool::Get()->Reclaim(true);
+		CHECK(StringPool::Get()->Size() == 0);
 	}
 }
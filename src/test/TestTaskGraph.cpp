@@ -163,6 +163,38 @@ TEST_CASE("Task Graph")
 		// Profiler::dumpzones(path.c_str());
 	}
 
+	SUBCASE("Parallel For")
+	{
+		std::vector<uint32_t> values(10000, 0);
+		std::atomic<uint32_t> numCalls = 0;
+
+		graph->ParallelFor({ 0, uint32_t(values.size()) }, 64, [&](TaskRange r) {
+			CHECK(r.end - r.begin <= 64);
+			for (uint32_t idx = r.begin; idx < r.end; idx++)
+				values[idx] += idx;
+			numCalls.fetch_add(1);
+		});
+
+		bool allVisited = true;
+		for (uint32_t idx = 0; idx < values.size(); idx++)
+			allVisited &= values[idx] == idx;
+
+		CHECK(allVisited);
+		CHECK(numCalls.load() >= values.size() / 64);
+	}
+
+	SUBCASE("Nested Parallel For")
+	{
+		graph->ParallelFor({ 0, 8 }, 1, [&](TaskRange outer) {
+			graph->ParallelFor({ 0, 16 }, 4, [&](TaskRange inner) {
+				for (uint32_t idx = inner.begin; idx < inner.end; idx++)
+					s_numExec.fetch_add(1);
+			});
+		});
+
+		CHECK(s_numExec.load() == 8 * 16);
+	}
+
 	SUBCASE("Add Pinned Tasks from Other Threads")
 	{
 		Profiler::reset();
@@ -216,3 +248,274 @@ TEST_CASE("Task Graph")
 
 	delete graph;
 }
+
+TEST_CASE("Task Graph (Work Stealing)")
+{
+	TaskGraph *graph = new TaskGraph();
+	CHECK(graph->SetSchedulerMode(TaskGraph::SCHEDULER_WORK_STEALING));
+	graph->SetWorkerThreads(3);
+	s_numExec = 0;
+
+	// the scheduler cannot be changed once workers are running
+	CHECK_FALSE(graph->SetSchedulerMode(TaskGraph::SCHEDULER_SHARED_QUEUE));
+
+	SUBCASE("Wait for Task Set")
+	{
+		TaskSet *set = new TaskSet();
+		for (uint32_t idx = 0; idx < 256; idx++) {
+			set->AddTask(new TestTask());
+		}
+
+		TaskSet::Handle handle = graph->QueueTaskSet(set);
+		graph->WaitForTaskSet(handle);
+
+		CHECK(s_numExec.load() == 256);
+	}
+
+	SUBCASE("Wait on Other Threads")
+	{
+		TaskSet *set1 = new TaskSet();
+
+		// tasks queued from a worker land on that worker's queue and
+		// must be stolen by the others to complete in a timely fashion
+		for (uint32_t idx = 0; idx < 4; idx++) {
+			set1->AddTaskLambda({ 0, 32 }, [=](TaskRange r) {
+				TaskSet *setN = new TaskSet();
+				for (uint32_t idx = r.begin; idx < r.end; idx++)
+					setN->AddTask(new TestTask());
+
+				auto handle = graph->QueueTaskSet(setN);
+				graph->WaitForTaskSet(handle);
+			});
+		}
+
+		auto handle = graph->QueueTaskSet(set1);
+		graph->WaitForTaskSet(handle);
+		CHECK(s_numExec.load() == 128);
+	}
+
+	SUBCASE("JobQueue Replacement")
+	{
+		Job::Handle h1 = graph->GetJobQueue()->Queue(new TestJob());
+		Job::Handle h2 = graph->GetJobQueue()->Queue(new TestJob());
+
+		while (h1.HasJob() || h2.HasJob())
+			graph->GetJobQueue()->FinishJobs();
+	}
+
+	delete graph;
+}
+
+std::atomic<bool> s_blockerRunning = false;
+std::atomic<bool> s_releaseJobs = false;
+std::atomic<uint32_t> s_jobOrder = 0;
+
+class OrderedJob : public Job {
+public:
+	OrderedJob(Priority priority, bool block = false) :
+		Job(priority),
+		m_block(block) {}
+
+	void OnRun() override
+	{
+		s_blockerRunning = s_blockerRunning || m_block;
+		while (m_block && !s_releaseJobs.load())
+			atomic_queue::spin_loop_pause();
+
+		m_order = s_jobOrder.fetch_add(1);
+	}
+
+	void OnFinish() override { s_finishOrder[GetPriority()] = m_order; }
+
+	static uint32_t s_finishOrder[PRIORITY_MAX];
+
+private:
+	bool m_block;
+	uint32_t m_order = 0;
+};
+
+uint32_t OrderedJob::s_finishOrder[Job::PRIORITY_MAX] = {};
+
+TEST_CASE("Task Graph Job Priorities")
+{
+	TaskGraph *graph = new TaskGraph();
+	graph->SetWorkerThreads(1);
+	s_blockerRunning = false;
+	s_releaseJobs = false;
+	s_jobOrder = 0;
+
+	// occupy the only worker so the remaining jobs are dispatched in priority order
+	Job::Handle blocker = graph->GetJobQueue()->Queue(new OrderedJob(Job::PRIORITY_NORMAL, true));
+	while (!s_blockerRunning.load())
+		atomic_queue::spin_loop_pause();
+
+	Job::Handle low = graph->GetJobQueue()->Queue(new OrderedJob(Job::PRIORITY_LOW));
+	Job::Handle normal = graph->GetJobQueue()->Queue(new OrderedJob(Job::PRIORITY_NORMAL));
+	Job::Handle high = graph->GetJobQueue()->Queue(new OrderedJob(Job::PRIORITY_HIGH));
+
+	s_releaseJobs = true;
+	while (blocker.HasJob() || low.HasJob() || normal.HasJob() || high.HasJob())
+		graph->GetJobQueue()->FinishJobs();
+
+	CHECK(OrderedJob::s_finishOrder[Job::PRIORITY_HIGH] == 1);
+	CHECK(OrderedJob::s_finishOrder[Job::PRIORITY_NORMAL] == 2);
+	CHECK(OrderedJob::s_finishOrder[Job::PRIORITY_LOW] == 3);
+
+	delete graph;
+}
+
+class StagedJob : public Job {
+public:
+	void OnRun() override
+	{
+		m_stagesRun.push_back(GetStage());
+		if (GetStage() < 2)
+			ContinueWithNextStage();
+	}
+
+	void OnFinish() override { s_stagesFinished = m_stagesRun; }
+
+	static std::vector<uint32_t> s_stagesFinished;
+
+private:
+	std::vector<uint32_t> m_stagesRun;
+};
+
+std::vector<uint32_t> StagedJob::s_stagesFinished;
+
+TEST_CASE("Multi-stage Jobs")
+{
+	StagedJob::s_stagesFinished.clear();
+
+	SUBCASE("TaskGraph")
+	{
+		TaskGraph *graph = new TaskGraph();
+		graph->SetWorkerThreads(2);
+
+		Job::Handle handle = graph->GetJobQueue()->Queue(new StagedJob());
+		while (handle.HasJob())
+			graph->GetJobQueue()->FinishJobs();
+
+		delete graph;
+	}
+
+	SUBCASE("SyncJobQueue")
+	{
+		SyncJobQueue queue;
+		Job::Handle handle = queue.Queue(new StagedJob());
+		while (handle.HasJob()) {
+			queue.RunJobs();
+			queue.FinishJobs();
+		}
+	}
+
+	CHECK(StagedJob::s_stagesFinished == std::vector<uint32_t>{ 0, 1, 2 });
+}
+
+class SlowFinishJob : public Job {
+public:
+	void OnRun() override { s_numExec.fetch_add(1); }
+	void OnFinish() override { busy_wait(1000); }
+};
+
+TEST_CASE("Budgeted FinishJobs")
+{
+	TaskGraph *graph = new TaskGraph();
+	graph->SetWorkerThreads(2);
+	s_numExec = 0;
+
+	std::vector<Job::Handle> handles;
+	for (uint32_t idx = 0; idx < 8; idx++)
+		handles.push_back(graph->GetJobQueue()->Queue(new SlowFinishJob()));
+
+	while (s_numExec.load() < 8)
+		atomic_queue::spin_loop_pause();
+	// allow the last job to be handed to the finished queue
+	SDL_Delay(10);
+
+	// the budget is only an upper bound, but at least one job must be processed
+	uint32_t numFinished = graph->GetJobQueue()->FinishJobs(100);
+	CHECK(numFinished == 1);
+
+	while (numFinished < 8)
+		numFinished += graph->GetJobQueue()->FinishJobs(100);
+
+	for (auto &handle : handles)
+		CHECK_FALSE(handle.HasJob());
+
+	delete graph;
+}
+
+std::atomic<bool> s_cancellableRunning = false;
+
+class CancellableJob : public Job {
+public:
+	void OnRun() override
+	{
+		s_cancellableRunning = true;
+		while (!IsCancelled())
+			atomic_queue::spin_loop_pause();
+	}
+
+	void OnFinish() override { FAIL("cancelled job should not finish"); }
+};
+
+TEST_CASE("Cooperative Job Cancellation")
+{
+	TaskGraph *graph = new TaskGraph();
+	graph->SetWorkerThreads(1);
+	s_cancellableRunning = false;
+
+	Job::Handle running = graph->GetJobQueue()->Queue(new CancellableJob());
+	while (!s_cancellableRunning.load())
+		atomic_queue::spin_loop_pause();
+
+	// queued behind the running job, so it is skipped without running
+	Job::Handle queued = graph->GetJobQueue()->Queue(new CancellableJob());
+
+	queued = Job::Handle();
+	running = Job::Handle();
+	CHECK_FALSE(running.HasJob());
+
+	// stats are updated by the worker once each job has been dequeued
+	uint32_t numSkipped = 0;
+	uint32_t numAborted = 0;
+	for (int tries = 0; tries < 1000 && (numSkipped + numAborted) < 2; tries++) {
+		SDL_Delay(1);
+		graph->GetStats().FlushFrame();
+		numSkipped += graph->GetStats().GetFrameStats().at("Jobs Skipped (Cancelled)");
+		numAborted += graph->GetStats().GetFrameStats().at("Jobs Aborted Early");
+	}
+
+	CHECK(numSkipped == 1);
+	CHECK(numAborted == 1);
+
+	delete graph;
+}
+
+TEST_CASE("Worker Affinity and Utilisation")
+{
+	TaskGraph *graph = new TaskGraph();
+	// pin all workers to the first core; work must still complete
+	graph->SetWorkerAffinity(0, 1);
+	graph->SetWorkerThreads(2);
+	s_numExec = 0;
+
+	graph->UpdateUtilisation();
+
+	TaskSet *set = new TaskSet();
+	for (uint32_t idx = 0; idx < 64; idx++)
+		set->AddTask(new TestTask());
+
+	TaskSet::Handle handle = graph->QueueTaskSet(set);
+	graph->WaitForTaskSet(handle);
+	CHECK(s_numExec.load() == 64);
+
+	SDL_Delay(600);
+	graph->UpdateUtilisation();
+	CHECK(graph->GetWorkerUtilisation(1) >= 0.f);
+	CHECK(graph->GetWorkerUtilisation(1) <= 1.f);
+	CHECK(graph->GetWorkerUtilisation(3) == 0.f);
+
+	delete graph;
+}
@@ -0,0 +1,90 @@
+// Copyright © 2008-2024 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "doctest.h"
+#include "graphics/TextureCompress.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+static Color DecodeBC1Texel(const Uint8 *block, int texel)
+{
+	auto unpack = [](Uint16 c) {
+		const int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+		return Color((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2), 255);
+	};
+	const Uint16 c0 = block[0] | (block[1] << 8);
+	const Uint16 c1 = block[2] | (block[3] << 8);
+	const Uint32 indices = block[4] | (block[5] << 8) | (block[6] << 16) | (Uint32(block[7]) << 24);
+	const Color p0 = unpack(c0), p1 = unpack(c1);
+	switch ((indices >> (texel * 2)) & 3) {
+	case 0: return p0;
+	case 1: return p1;
+	case 2:
+		if (c0 > c1)
+			return Color((2 * p0.r + p1.r) / 3, (2 * p0.g + p1.g) / 3, (2 * p0.b + p1.b) / 3, 255);
+		return Color((p0.r + p1.r) / 2, (p0.g + p1.g) / 2, (p0.b + p1.b) / 2, 255);
+	default:
+		return c0 > c1 ? Color((p0.r + 2 * p1.r) / 3, (p0.g + 2 * p1.g) / 3, (p0.b + 2 * p1.b) / 3, 255) : Color(0, 0, 0, 255);
+	}
+}
+
+// largest per-channel error of the image after a BC1 round trip
+static int GetMaxError(const std::vector<Color> &pixels, int width, int height)
+{
+	std::vector<Uint8> compressed(Graphics::GetBC1Size(width, height));
+	Graphics::CompressBC1(pixels.data(), width, height, compressed.data());
+
+	const int blocksWide = (width + 3) / 4;
+	int maxError = 0;
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			const Uint8 *block = &compressed[((y / 4) * blocksWide + x / 4) * 8];
+			const Color decoded = DecodeBC1Texel(block, (y % 4) * 4 + x % 4);
+			const Color &c = pixels[y * width + x];
+			maxError = std::max({ maxError, abs(decoded.r - c.r), abs(decoded.g - c.g), abs(decoded.b - c.b) });
+		}
+	}
+	return maxError;
+}
+
+TEST_CASE("BC1 compression")
+{
+	CHECK(Graphics::GetBC1Size(1, 1) == 8);
+	CHECK(Graphics::GetBC1Size(4, 4) == 8);
+	CHECK(Graphics::GetBC1Size(6, 9) == 2 * 3 * 8);
+
+	SUBCASE("Solid colours")
+	{
+		std::vector<Color> pixels(16, Color(200, 100, 50, 255));
+		// within the rounding of 5:6:5 colour
+		CHECK(GetMaxError(pixels, 4, 4) <= 4);
+	}
+
+	SUBCASE("Gradients")
+	{
+		// bands either way across the block, as on a gas giant
+		const int size = 64;
+		std::vector<Color> pixels(size * size);
+		for (int y = 0; y < size; y++)
+			for (int x = 0; x < size; x++)
+				pixels[y * size + x] = Color(x * 4, 255 - y * 4, (x + y) * 2, 255);
+		CHECK(GetMaxError(pixels, size, size) <= 12);
+	}
+
+	SUBCASE("Partial blocks")
+	{
+		std::vector<Color> pixels(2 * 2);
+		pixels[0] = Color(255, 0, 0, 255);
+		pixels[1] = Color(0, 255, 0, 255);
+		pixels[2] = Color(0, 0, 255, 255);
+		pixels[3] = Color(255, 255, 255, 255);
+		// four disparate colours can't fit one line, but must still come out
+		// closer to themselves than to black
+		std::vector<Uint8> compressed(Graphics::GetBC1Size(2, 2));
+		Graphics::CompressBC1(pixels.data(), 2, 2, compressed.data());
+		const Color white = DecodeBC1Texel(compressed.data(), 5);
+		CHECK(white.r + white.g + white.b > 255);
+	}
+}
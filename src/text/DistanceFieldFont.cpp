@@ -72,6 +72,25 @@ namespace Text {
 		}
 	}
 
+	static const size_t MAX_CACHED_RUNS = 256;
+
+	const Graphics::VertexArray &DistanceFieldFont::GetGlyphRun(const std::string &text)
+	{
+		auto it = m_glyphRuns.find(text);
+		if (it != m_glyphRuns.end())
+			return *it->second;
+
+		// labels are mostly ship registrations and cargo names, so the working
+		// set is small; just start over rather than tracking usage
+		if (m_glyphRuns.size() >= MAX_CACHED_RUNS)
+			m_glyphRuns.clear();
+
+		std::unique_ptr<Graphics::VertexArray> va(CreateVertexArray());
+		if (!text.empty())
+			GetGeometry(*va, text, vector2f(0.f));
+		return *m_glyphRuns.emplace(text, std::move(va)).first->second;
+	}
+
 	// create a preferred format vertex array
 	Graphics::VertexArray *DistanceFieldFont::CreateVertexArray() const
 	{
@@ -26,8 +26,9 @@
 #include "RefCounted.h"
 #include "vector2.h"
 
-#include <string>
 #include <map>
+#include <memory>
+#include <string>
 
 namespace Graphics {
 	class Texture;
@@ -42,6 +43,9 @@ namespace Text {
 		void GetGeometry(Graphics::VertexArray &, const std::string &, const vector2f &offset);
 		Graphics::Texture *GetTexture() const { return m_texture; }
 		Graphics::VertexArray *CreateVertexArray() const;
+		// Returns the centered geometry for a single string, shaping it only the
+		// first time it is requested. The returned array is owned by the font.
+		const Graphics::VertexArray &GetGlyphRun(const std::string &);
 
 	private:
 		struct Glyph {
@@ -56,6 +60,8 @@ namespace Text {
 		vector2f m_sheetSize;
 		float m_lineHeight;
 		float m_fontSize; //32 etc. Glyph size/advance will be scaled to 1/fontSize.
+		// shaped strings, flushed when it grows past MAX_CACHED_RUNS
+		std::map<std::string, std::unique_ptr<Graphics::VertexArray>> m_glyphRuns;
 
 		void AddGlyph(Graphics::VertexArray &va, const vector2f &pos, const Glyph &, vector2f &bounds);
 		void ParseChar(std::string_view line);
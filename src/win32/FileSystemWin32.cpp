@@ -111,7 +111,8 @@ namespace FileSystem {
 	}
 
 	FileSourceFS::FileSourceFS(const std::string &root, bool trusted) :
-		FileSource((root == "/") ? "" : absolute_path(root), trusted) {}
+		FileSource((root == "/") ? "" : absolute_path(root), trusted),
+		m_mapThreshold(trusted ? MAP_READ_THRESHOLD : 0) {}
 
 	FileSourceFS::~FileSourceFS() {}
 
@@ -176,6 +177,27 @@ namespace FileSystem {
 		return MakeFileInfo(path, ty, modtime);
 	}
 
+	class FileDataMapped : public FileData {
+	public:
+		FileDataMapped(const FileInfo &info, size_t size, char *data) :
+			FileData(info, size, data) {}
+		virtual ~FileDataMapped() { UnmapViewOfFile(m_data); }
+	};
+
+	// returns a read-only view of the whole (non-empty) open file, or
+	// nullptr if it can't be mapped
+	static char *map_file(HANDLE filehandle)
+	{
+		void *data = 0;
+		HANDLE mapping = CreateFileMappingW(filehandle, 0, PAGE_READONLY, 0, 0, 0);
+		if (mapping) {
+			data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			// the view keeps the mapping and the file open
+			CloseHandle(mapping);
+		}
+		return static_cast<char *>(data);
+	}
+
 	RefCountedPtr<FileData> FileSourceFS::ReadFile(const std::string &path)
 	{
 		const std::string fullpath = JoinPathBelow(GetRoot(), path);
@@ -194,6 +216,14 @@ namespace FileSystem {
 			}
 			size_t size = size_t(large_size.QuadPart);
 
+			// large files are shared with the page cache rather than copied
+			if (m_mapThreshold > 0 && size >= m_mapThreshold) {
+				if (char *data = map_file(filehandle)) {
+					CloseHandle(filehandle);
+					return RefCountedPtr<FileData>(new FileDataMapped(MakeFileInfo(path, FileInfo::FT_FILE, modtime), size, data));
+				}
+			}
+
 			char *data = static_cast<char *>(std::malloc(size));
 			if (!data) {
 				// XXX handling memory allocation failure gracefully is too hard right now
@@ -226,6 +256,30 @@ namespace FileSystem {
 		}
 	}
 
+	RefCountedPtr<FileData> FileSourceFS::MapFile(const std::string &path)
+	{
+		const std::string fullpath = JoinPathBelow(GetRoot(), path);
+		const std::wstring wfullpath = transcode_utf8_to_utf16(fullpath);
+		HANDLE filehandle = CreateFileW(wfullpath.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+		if (filehandle == INVALID_HANDLE_VALUE)
+			return RefCountedPtr<FileData>(0);
+
+		const Time::DateTime modtime = file_modtime_for_handle(filehandle);
+		LARGE_INTEGER large_size;
+		if (!GetFileSizeEx(filehandle, &large_size) || large_size.QuadPart == 0) {
+			// empty files can't be mapped
+			CloseHandle(filehandle);
+			return ReadFile(path);
+		}
+
+		char *data = map_file(filehandle);
+		CloseHandle(filehandle);
+
+		if (!data)
+			return ReadFile(path);
+		return RefCountedPtr<FileData>(new FileDataMapped(MakeFileInfo(path, FileInfo::FT_FILE, modtime), size_t(large_size.QuadPart), data));
+	}
+
 	bool FileSourceFS::ReadDirectory(const std::string &dirpath, std::vector<FileInfo> &output)
 	{
 		size_t output_head_size = output.size();
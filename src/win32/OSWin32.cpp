@@ -110,6 +110,12 @@ namespace OS {
 		return sysinfo.dwNumberOfProcessors;
 	}
 
+	bool SetCurrentThreadAffinity(uint32_t core)
+	{
+		const DWORD_PTR mask = DWORD_PTR(1) << (core % (sizeof(DWORD_PTR) * 8));
+		return SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+	}
+
 	// get hardware information
 	const std::string GetHardwareInfo()
 	{